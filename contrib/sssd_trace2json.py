@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+#
+# Convert SSSD request trace files (debug_trace = true) to the Chrome trace
+# event format, which can be loaded into chrome://tracing or Perfetto.
+#
+#   sssd_trace2json.py /var/log/sssd/*.trace > trace.json
+#
+# The record format is described in src/util/sss_trace.h.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import argparse
+import errno
+import json
+import struct
+import sys
+
+MAGIC = b'SSSTRACE'
+RECORD_PROCESS = 1
+RECORD_SPAN = 2
+
+HEADER = struct.Struct('=II')
+PROCESS = struct.Struct('=I')
+SPAN = struct.Struct('=IQQQQQi')
+STRLEN = struct.Struct('=H')
+
+
+def read_string(data, offset):
+    (length,) = STRLEN.unpack_from(data, offset)
+    offset += STRLEN.size
+    value = data[offset:offset + length].decode('utf-8', 'replace')
+    return value, offset + length
+
+
+def outcome_str(outcome):
+    if outcome == 0:
+        return 'EOK'
+    return errno.errorcode.get(outcome, str(outcome))
+
+
+def read_trace(path, processes, spans):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if not data.startswith(MAGIC):
+        raise ValueError('%s is not a SSSD trace file' % path)
+
+    offset = len(MAGIC)
+    while offset + HEADER.size <= len(data):
+        length, rtype = HEADER.unpack_from(data, offset)
+        if length < HEADER.size or offset + length > len(data):
+            # The last record was not written completely.
+            break
+
+        body = offset + HEADER.size
+        if rtype == RECORD_PROCESS:
+            (pid,) = PROCESS.unpack_from(data, body)
+            name, _ = read_string(data, body + PROCESS.size)
+            processes[pid] = name
+        elif rtype == RECORD_SPAN:
+            fields = SPAN.unpack_from(data, body)
+            name, pos = read_string(data, body + SPAN.size)
+            domain, _ = read_string(data, pos)
+            spans.append(fields + (name, domain))
+
+        offset += length
+
+
+def convert(spans, processes):
+    events = []
+    by_id = {}
+
+    for pid, name in processes.items():
+        events.append({'name': 'process_name', 'ph': 'M', 'pid': pid,
+                       'args': {'name': name}})
+
+    for (pid, trace_id, span_id, parent_id, start, end, outcome,
+         name, domain) in spans:
+        by_id[span_id] = pid
+        args = {'trace': '%#x' % trace_id,
+                'span': '%#x' % span_id,
+                'outcome': outcome_str(outcome)}
+        if parent_id != 0:
+            args['parent'] = '%#x' % parent_id
+        if domain:
+            args['domain'] = domain
+
+        events.append({'name': name, 'cat': 'sssd', 'ph': 'X',
+                       'pid': pid, 'tid': pid, 'ts': start,
+                       'dur': max(end - start, 0), 'args': args})
+
+    # Connect the spans that continue in another process.
+    for (pid, trace_id, span_id, parent_id, start, end, outcome,
+         name, domain) in spans:
+        parent_pid = by_id.get(parent_id)
+        if parent_pid is None or parent_pid == pid:
+            continue
+
+        events.append({'name': 'request', 'cat': 'sssd', 'ph': 's',
+                       'id': span_id, 'pid': parent_pid, 'tid': parent_pid,
+                       'ts': start})
+        events.append({'name': 'request', 'cat': 'sssd', 'ph': 'f',
+                       'bp': 'e', 'id': span_id, 'pid': pid, 'tid': pid,
+                       'ts': start})
+
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert SSSD trace files to the Chrome trace format')
+    parser.add_argument('files', nargs='+', metavar='FILE',
+                        help='trace file written by a SSSD process')
+    parser.add_argument('-o', '--output', default='-',
+                        help='output file, standard output by default')
+    args = parser.parse_args()
+
+    processes = {}
+    spans = []
+    for path in args.files:
+        try:
+            read_trace(path, processes, spans)
+        except (IOError, ValueError) as e:
+            sys.stderr.write('%s\n' % e)
+            return 1
+
+    result = convert(spans, processes)
+    if args.output == '-':
+        json.dump(result, sys.stdout)
+        sys.stdout.write('\n')
+    else:
+        with open(args.output, 'w') as f:
+            json.dump(result, f)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -15,6 +15,20 @@ AC_DEFUN([WITH_DB_PATH],
     AC_DEFINE_UNQUOTED(DB_PATH, "$config_dbpath", [Path to the SSSD databases])
   ])
 
+AC_DEFUN([WITH_VOLATILE_DB_PATH],
+  [ AC_ARG_WITH([volatile-db-path],
+                [AC_HELP_STRING([--with-volatile-db-path=PATH],
+                                [Path to the SSSD databases that are not kept across reboots [/var/run/sss/db]]
+                               )
+                ]
+               )
+    config_volatiledbpath="\"VARDIR\"/run/sss/db"
+    if test x"$with_volatile_db_path" != x; then
+        config_volatiledbpath=$with_volatile_db_path
+    fi
+    AC_DEFINE_UNQUOTED(VOLATILE_DB_PATH, "$config_volatiledbpath", [Path to the SSSD databases that are not kept across reboots])
+  ])
+
 AC_DEFUN([WITH_PLUGIN_PATH],
   [ AC_ARG_WITH([plugin-path],
                 [AC_HELP_STRING([--with-plugin-path=PATH],
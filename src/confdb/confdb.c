@@ -26,6 +26,7 @@
 #include "confdb/confdb.h"
 #include "confdb/confdb_private.h"
 #include "util/strtonum.h"
+#include "util/sss_ptr_hash.h"
 #include "db/sysdb.h"
 
 #define CONFDB_ZERO_CHECK_OR_JUMP(var, ret, err, label) do { \
@@ -226,6 +227,136 @@ done:
     return ret;
 }
 
+/* All sections of the configuration, loaded with a single search and
+ * valid until the sequence number of the database changes. */
+struct confdb_snapshot {
+    uint64_t seqnum;
+    hash_table_t *sections;
+};
+
+static errno_t confdb_snapshot_load(struct confdb_ctx *cdb, uint64_t seqnum)
+{
+    struct confdb_snapshot *snapshot;
+    struct ldb_result *res;
+    struct ldb_dn *base;
+    const char *key;
+    unsigned int i;
+    errno_t ret;
+
+    snapshot = talloc_zero(cdb, struct confdb_snapshot);
+    if (snapshot == NULL) {
+        return ENOMEM;
+    }
+    snapshot->seqnum = seqnum;
+
+    snapshot->sections = sss_ptr_hash_create(snapshot, NULL, NULL);
+    if (snapshot->sections == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    base = ldb_dn_new(snapshot, cdb->ldb, "cn=config");
+    if (base == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_search(cdb->ldb, snapshot, &res, base, LDB_SCOPE_SUBTREE,
+                     NULL, NULL);
+    if (ret != LDB_SUCCESS) {
+        ret = sss_ldb_error_to_errno(ret);
+        goto done;
+    }
+
+    for (i = 0; i < res->count; i++) {
+        key = ldb_dn_get_casefold(res->msgs[i]->dn);
+        if (key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sss_ptr_hash_add(snapshot->sections, key, res->msgs[i],
+                               struct ldb_message);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Loaded %u configuration sections\n",
+          res->count);
+
+    talloc_free(cdb->snapshot);
+    cdb->snapshot = snapshot;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(snapshot);
+    }
+    return ret;
+}
+
+/* Returns true if the section was looked up in the snapshot, _msg is set to
+ * NULL if there is no such section. The snapshot is reloaded if the database
+ * was modified since it was loaded, by this or any other process. */
+static bool confdb_snapshot_lookup(struct confdb_ctx *cdb,
+                                   struct ldb_dn *dn,
+                                   struct ldb_message **_msg)
+{
+    uint64_t seqnum;
+    const char *key;
+    errno_t ret;
+
+    if (!cdb->use_snapshot) {
+        return false;
+    }
+
+    ret = ldb_sequence_number(cdb->ldb, LDB_SEQ_HIGHEST_SEQ, &seqnum);
+    if (ret != LDB_SUCCESS) {
+        return false;
+    }
+
+    if (cdb->snapshot == NULL || cdb->snapshot->seqnum != seqnum) {
+        ret = confdb_snapshot_load(cdb, seqnum);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to load configuration snapshot [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            return false;
+        }
+    }
+
+    key = ldb_dn_get_casefold(dn);
+    if (key == NULL) {
+        return false;
+    }
+
+    *_msg = sss_ptr_hash_lookup(cdb->snapshot->sections, key,
+                                struct ldb_message);
+    return true;
+}
+
+int confdb_enable_snapshot(struct confdb_ctx *cdb)
+{
+    uint64_t seqnum;
+    int ret;
+
+    ret = ldb_sequence_number(cdb->ldb, LDB_SEQ_HIGHEST_SEQ, &seqnum);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "The configuration database does not "
+              "provide a sequence number, snapshot is not used\n");
+        return sss_ldb_error_to_errno(ret);
+    }
+
+    ret = confdb_snapshot_load(cdb, seqnum);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    cdb->use_snapshot = true;
+    return EOK;
+}
+
 int confdb_get_param(struct confdb_ctx *cdb,
                      TALLOC_CTX *mem_ctx,
                      const char *section,
@@ -234,6 +365,7 @@ int confdb_get_param(struct confdb_ctx *cdb,
 {
     TALLOC_CTX *tmp_ctx;
     struct ldb_result *res;
+    struct ldb_message *msg = NULL;
     struct ldb_dn *dn;
     char *secdn;
     const char *attrs[] = { attribute, NULL };
@@ -256,22 +388,25 @@ int confdb_get_param(struct confdb_ctx *cdb,
         goto done;
     }
 
-    ret = ldb_search(cdb->ldb, tmp_ctx, &res,
-                     dn, LDB_SCOPE_BASE, attrs, NULL);
-    if (ret != LDB_SUCCESS) {
-        ret = EIO;
-        goto done;
-    }
-    if (res->count > 1) {
-        ret = EIO;
-        goto done;
+    if (!confdb_snapshot_lookup(cdb, dn, &msg)) {
+        ret = ldb_search(cdb->ldb, tmp_ctx, &res,
+                         dn, LDB_SCOPE_BASE, attrs, NULL);
+        if (ret != LDB_SUCCESS) {
+            ret = EIO;
+            goto done;
+        }
+        if (res->count > 1) {
+            ret = EIO;
+            goto done;
+        }
+        msg = res->count > 0 ? res->msgs[0] : NULL;
     }
 
     vals = talloc_zero(mem_ctx, char *);
     ret = EOK;
 
-    if (res->count > 0) {
-        el = ldb_msg_find_element(res->msgs[0], attribute);
+    if (msg != NULL) {
+        el = ldb_msg_find_element(msg, attribute);
         if (el && el->num_values > 0) {
             vals = talloc_realloc(mem_ctx, vals, char *, el->num_values +1);
             if (!vals) {
@@ -1096,6 +1231,24 @@ static int confdb_get_domain_internal(struct confdb_ctx *cdb,
         goto done;
     }
 
+    ret = get_entry_as_uint32(res->msgs[0],
+                              &domain->ignore_group_members_above,
+                              CONFDB_DOMAIN_IGNORE_GROUP_MEMBERS_ABOVE, 0);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for %s\n",
+              CONFDB_DOMAIN_IGNORE_GROUP_MEMBERS_ABOVE);
+        goto done;
+    }
+
+    ret = get_entry_as_uint32(res->msgs[0], &domain->id_negative_timeout,
+                              CONFDB_DOMAIN_ID_NEGATIVE_TIMEOUT, 0);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for %s\n", CONFDB_DOMAIN_ID_NEGATIVE_TIMEOUT);
+        goto done;
+    }
+
     ret = get_entry_as_uint32(res->msgs[0], &domain->id_min,
                               CONFDB_DOMAIN_MINID,
                               confdb_get_min_id(domain));
@@ -1273,6 +1426,42 @@ static int confdb_get_domain_internal(struct confdb_ctx *cdb,
         goto done;
     }
 
+    ret = get_entry_as_uint32(res->msgs[0], &domain->cache_checkpoint_interval,
+                              CONFDB_DOMAIN_CACHE_CHECKPOINT_INTERVAL, 0);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for [%s]\n",
+               CONFDB_DOMAIN_CACHE_CHECKPOINT_INTERVAL);
+        goto done;
+    }
+
+    ret = get_entry_as_uint32(res->msgs[0], &domain->cache_compress_threshold,
+                              CONFDB_DOMAIN_CACHE_COMPRESS_THRESHOLD, 0);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Invalid value for [%s]\n",
+               CONFDB_DOMAIN_CACHE_COMPRESS_THRESHOLD);
+        goto done;
+    }
+
+    domain->cache_engine = SSS_CACHE_ENGINE_TDB;
+    tmp = ldb_msg_find_attr_as_string(res->msgs[0],
+                                      CONFDB_DOMAIN_CACHE_ENGINE,
+                                      CONFDB_DOMAIN_CACHE_ENGINE_TDB);
+    if (tmp != NULL) {
+        if (strcasecmp(tmp, CONFDB_DOMAIN_CACHE_ENGINE_TDB) == 0) {
+            domain->cache_engine = SSS_CACHE_ENGINE_TDB;
+        } else if (strcasecmp(tmp, CONFDB_DOMAIN_CACHE_ENGINE_LMDB) == 0) {
+            domain->cache_engine = SSS_CACHE_ENGINE_LMDB;
+        } else {
+            DEBUG(SSSDBG_FATAL_FAILURE,
+                  "Invalid value %s for [%s]\n", tmp,
+                  CONFDB_DOMAIN_CACHE_ENGINE);
+            ret = EINVAL;
+            goto done;
+        }
+    }
+
     /* detect and fix misconfiguration */
     if (domain->refresh_expired_interval > entry_cache_timeout) {
         DEBUG(SSSDBG_CONF_SETTINGS,
@@ -62,6 +62,10 @@
 #define CONFDB_SERVICE_DEBUG_TIMESTAMPS "debug_timestamps"
 #define CONFDB_SERVICE_DEBUG_MICROSECONDS "debug_microseconds"
 #define CONFDB_SERVICE_DEBUG_TO_FILES "debug_to_files"
+#define CONFDB_SERVICE_DEBUG_ASYNC "debug_async"
+#define CONFDB_SERVICE_DEBUG_BACKTRACE_ENABLED "debug_backtrace_enabled"
+#define CONFDB_SERVICE_DEBUG_TRACE "debug_trace"
+#define CONFDB_SERVICE_DEBUG_EVENT_LOOP "debug_event_loop"
 #define CONFDB_SERVICE_RECON_RETRIES "reconnection_retries"
 #define CONFDB_SERVICE_FD_LIMIT "fd_limit"
 #define CONFDB_SERVICE_ALLOWED_UIDS "allowed_uids"
@@ -81,6 +85,8 @@
 #define CONFDB_MONITOR_DISABLE_NETLINK "disable_netlink"
 #define CONFDB_MONITOR_ENABLE_FILES_DOM "enable_files_domain"
 #define CONFDB_MONITOR_DOMAIN_RESOLUTION_ORDER "domain_resolution_order"
+#define CONFDB_MONITOR_METRICS_SOCKET "metrics_socket"
+#define CONFDB_MONITOR_PARALLEL_STARTUP "parallel_startup"
 
 /* Both monitor and domains */
 #define CONFDB_NAME_REGEX   "re_expression"
@@ -92,11 +98,19 @@
 #define CONFDB_RESPONDER_GET_DOMAINS_TIMEOUT "get_domains_timeout"
 #define CONFDB_RESPONDER_CLI_IDLE_TIMEOUT "client_idle_timeout"
 #define CONFDB_RESPONDER_CLI_IDLE_DEFAULT_TIMEOUT 60
+#define CONFDB_RESPONDER_CLI_MAX_REQUESTS "client_max_requests_per_uid"
+#define CONFDB_RESPONDER_CLI_MAX_REQUESTS_DEFAULT 0
+#define CONFDB_RESPONDER_PROVIDER_BATCH_SIZE "provider_batch_size"
+#define CONFDB_RESPONDER_PROVIDER_BATCH_SIZE_DEFAULT 1
+#define CONFDB_RESPONDER_PROVIDER_COALESCING_EXCLUDE "provider_coalescing_exclude"
+#define CONFDB_RESPONDER_WARM_RESTART "warm_restart"
 #define CONFDB_RESPONDER_LOCAL_NEG_TIMEOUT "local_negative_timeout"
 #define CONFDB_RESPONDER_LOCAL_NEG_TIMEOUT_DEFAULT 14400
 #define CONFDB_RESPONDER_IDLE_TIMEOUT "responder_idle_timeout"
 #define CONFDB_RESPONDER_IDLE_DEFAULT_TIMEOUT 300
+#define CONFDB_RESPONDER_IDLE_HIBERNATE "responder_idle_hibernate"
 #define CONFDB_RESPONDER_CACHE_FIRST "cache_first"
+#define CONFDB_RESPONDER_PARALLEL_DOMAIN_LOOKUPS "parallel_domain_lookups"
 
 /* NSS */
 #define CONFDB_NSS_CONF_ENTRY "config/nss"
@@ -115,6 +129,22 @@
 #define CONFDB_NSS_SHELL_FALLBACK "shell_fallback"
 #define CONFDB_NSS_DEFAULT_SHELL "default_shell"
 #define CONFDB_MEMCACHE_TIMEOUT "memcache_timeout"
+#define CONFDB_MEMCACHE_HASH_LAYOUT "memcache_hash_layout"
+#define CONFDB_MEMCACHE_HASH_FUNCTION "memcache_hash_function"
+#define CONFDB_MEMCACHE_SIZE_PASSWD "memcache_size_passwd"
+#define CONFDB_MEMCACHE_SIZE_GROUP "memcache_size_group"
+#define CONFDB_MEMCACHE_SIZE_INITGROUPS "memcache_size_initgroups"
+#define CONFDB_MEMCACHE_SIZE_SID "memcache_size_sid"
+#define CONFDB_MEMCACHE_SIZE_SERVICES "memcache_size_services"
+#define CONFDB_MEMCACHE_SIZE_HOSTS "memcache_size_hosts"
+#define CONFDB_MEMCACHE_AUTO_RESIZE "memcache_auto_resize"
+#define CONFDB_MEMCACHE_HUGE_PAGES "memcache_huge_pages"
+#define CONFDB_MEMCACHE_NEG_TIMEOUT "memcache_negative_timeout"
+#define CONFDB_NSS_WORKER_PROCESSES "worker_processes"
+#define CONFDB_NSS_RESULT_CACHE_SIZE "result_cache_size"
+#define CONFDB_NSS_PREFETCH_HOT_ENTRIES "prefetch_hot_entries"
+#define CONFDB_NSS_INITGR_CACHE_SIZE "initgroups_cache_size"
+#define CONFDB_NSS_HOSTS_INDEX "hosts_index"
 #define CONFDB_NSS_HOMEDIR_SUBSTRING "homedir_substring"
 #define CONFDB_DEFAULT_HOMEDIR_SUBSTRING "/home"
 
@@ -140,6 +170,8 @@
 #define CONFDB_PAM_APP_SERVICES "pam_app_services"
 #define CONFDB_PAM_P11_ALLOWED_SERVICES "pam_p11_allowed_services"
 #define CONFDB_PAM_P11_URI "p11_uri"
+#define CONFDB_PAM_P11_CHILD_STANDBY "p11_child_standby"
+#define CONFDB_PAM_CERT_USER_CACHE_TIMEOUT "pam_cert_user_cache_timeout"
 #define CONFDB_PAM_INITGROUPS_SCHEME "pam_initgroups_scheme"
 
 /* SUDO */
@@ -152,6 +184,8 @@
 #define CONFDB_DEFAULT_SUDO_INVERSE_ORDER false
 #define CONFDB_SUDO_THRESHOLD "sudo_threshold"
 #define CONFDB_DEFAULT_SUDO_THRESHOLD 50
+#define CONFDB_SUDO_RULES_CACHE_SIZE "sudo_rules_cache_size"
+#define CONFDB_DEFAULT_SUDO_RULES_CACHE_SIZE 100
 
 /* autofs */
 #define CONFDB_AUTOFS_CONF_ENTRY "config/autofs"
@@ -172,6 +206,8 @@
 #define CONFDB_SSH_USE_CERT_KEYS "ssh_use_certificate_keys"
 #define CONFDB_DEFAULT_SSH_USE_CERT_KEYS true
 #define CONFDB_SSH_USE_CERT_RULES "ssh_use_certificate_matching_rules"
+#define CONFDB_SSH_CERT_KEYS_CACHE_TIMEOUT "ssh_certificate_keys_cache_timeout"
+#define CONFDB_DEFAULT_SSH_CERT_KEYS_CACHE_TIMEOUT 60
 
 /* PAC */
 #define CONFDB_PAC_CONF_ENTRY "config/pac"
@@ -181,6 +217,7 @@
 #define CONFDB_IFP_CONF_ENTRY "config/ifp"
 #define CONFDB_IFP_USER_ATTR_LIST "user_attributes"
 #define CONFDB_IFP_WILDCARD_LIMIT "wildcard_limit"
+#define CONFDB_IFP_RESULT_CACHE_TIMEOUT "result_cache_timeout"
 
 /* Session Recording */
 #define CONFDB_SESSION_RECORDING_CONF_ENTRY "config/session_recording"
@@ -224,6 +261,8 @@
 #define CONFDB_DOMAIN_SUBDOMAIN_HOMEDIR "subdomain_homedir"
 #define CONFDB_DOMAIN_DEFAULT_SUBDOMAIN_HOMEDIR "/home/%d/%u"
 #define CONFDB_DOMAIN_IGNORE_GROUP_MEMBERS "ignore_group_members"
+#define CONFDB_DOMAIN_IGNORE_GROUP_MEMBERS_ABOVE "ignore_group_members_above"
+#define CONFDB_DOMAIN_ID_NEGATIVE_TIMEOUT "id_negative_timeout"
 #define CONFDB_DOMAIN_SUBDOMAIN_REFRESH "subdomain_refresh_interval"
 #define CONFDB_DOMAIN_SUBDOMAIN_REFRESH_DEFAULT_VALUE 14400
 
@@ -238,9 +277,21 @@
 #define CONFDB_DOMAIN_RESOLVER_CACHE_TIMEOUT "entry_cache_resolver_timeout"
 #define CONFDB_DOMAIN_PWD_EXPIRATION_WARNING "pwd_expiration_warning"
 #define CONFDB_DOMAIN_REFRESH_EXPIRED_INTERVAL "refresh_expired_interval"
+#define CONFDB_DOMAIN_REFRESH_EXPIRED_CONCURRENCY "refresh_expired_concurrency"
 #define CONFDB_DOMAIN_OFFLINE_TIMEOUT "offline_timeout"
+#define CONFDB_DOMAIN_CACHE_WRITE_BATCH "cache_write_batch_size"
+#define CONFDB_DOMAIN_PROVIDER_MAX_REQUESTS "provider_max_requests"
+#define CONFDB_DOMAIN_FAILOVER_PROBE_SERVERS "failover_probe_servers"
+#define CONFDB_DOMAIN_FAILOVER_SLOW_SERVER "failover_slow_server_threshold"
+#define CONFDB_DOMAIN_CACHE_CHECKPOINT_INTERVAL "cache_checkpoint_interval"
+#define CONFDB_DOMAIN_CACHE_ENGINE "cache_engine"
+#define CONFDB_DOMAIN_PERIODIC_TASK_SPREAD "periodic_task_spread"
+#define CONFDB_DOMAIN_CACHE_COMPRESS_THRESHOLD "cache_compress_threshold"
+#define CONFDB_DOMAIN_CACHE_ENGINE_TDB "tdb"
+#define CONFDB_DOMAIN_CACHE_ENGINE_LMDB "lmdb"
 #define CONFDB_DOMAIN_SUBDOMAIN_INHERIT "subdomain_inherit"
 #define CONFDB_DOMAIN_CACHED_AUTH_TIMEOUT "cached_auth_timeout"
+#define CONFDB_DOMAIN_ACCESS_CACHE_TIMEOUT "access_cache_timeout"
 #define CONFDB_DOMAIN_TYPE "domain_type"
 #define CONFDB_DOMAIN_TYPE_POSIX "posix"
 #define CONFDB_DOMAIN_TYPE_APP "application"
@@ -262,6 +313,7 @@
 #define CONFDB_PROXY_PAM_TARGET "proxy_pam_target"
 #define CONFDB_PROXY_FAST_ALIAS "proxy_fast_alias"
 #define CONFDB_PROXY_MAX_CHILDREN "proxy_max_children"
+#define CONFDB_PROXY_NSS_WORKERS "proxy_nss_workers"
 
 /* Files Provider */
 #define CONFDB_FILES_PASSWD "passwd_files"
@@ -340,6 +392,14 @@ enum sss_domain_mpg_mode {
     MPG_HYBRID,
 };
 
+/** Storage engine of the domain cache files */
+enum sss_cache_engine {
+    /** This is the default engine. Writers lock the whole database. */
+    SSS_CACHE_ENGINE_TDB,
+    /** Readers work on snapshots and are not blocked by writers */
+    SSS_CACHE_ENGINE_LMDB,
+};
+
 /**
  * Data structure storing all of the basic features
  * of a domain.
@@ -356,6 +416,8 @@ struct sss_domain_info {
     bool fqnames;
     enum sss_domain_mpg_mode mpg_mode;
     bool ignore_group_members;
+    uint32_t ignore_group_members_above;
+    uint32_t id_negative_timeout;
     uint32_t id_min;
     uint32_t id_max;
     const char *pwfield;
@@ -384,6 +446,9 @@ struct sss_domain_info {
     uint32_t resolver_timeout;
 
     uint32_t refresh_expired_interval;
+    uint32_t cache_checkpoint_interval;
+    enum sss_cache_engine cache_engine;
+    uint32_t cache_compress_threshold;
     uint32_t subdomain_refresh_interval;
     uint32_t cached_auth_timeout;
 
@@ -409,6 +474,11 @@ struct sss_domain_info {
     enum sss_domain_state state;
     char **sd_inherit;
 
+    /* Entries checked by the running or last cache cleanup of the backend
+     * and the number of candidates it found. */
+    uint32_t cleanup_processed;
+    uint32_t cleanup_total;
+
     /* Do not use the forest pointer directly in new code, but rather the
      * forest_root pointer. sss_domain_info will be more opaque in the future
      */
@@ -440,6 +510,21 @@ int confdb_init(TALLOC_CTX *mem_ctx,
                 struct confdb_ctx **cdb_ctx,
                 const char *confdb_location);
 
+/**
+ * Serve all further reads of the ConfDB from an in-memory snapshot
+ *
+ * The whole configuration is loaded with a single search instead of one
+ * search per option. The snapshot is loaded again whenever the sequence
+ * number of the ConfDB changes, so changes done by any process are seen.
+ *
+ * @param[in] cdb The connection object retrieved from confdb_init
+ *
+ * @return 0 - The snapshot was loaded
+ * @return ENOMEM - There was insufficient memory to load the snapshot
+ * @return EIO - The ConfDB could not be read
+ */
+int confdb_enable_snapshot(struct confdb_ctx *cdb);
+
 /**
  * Get a domain object for the named domain
  *
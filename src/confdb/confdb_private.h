@@ -22,11 +22,16 @@
 #ifndef CONFDB_PRIVATE_H_
 #define CONFDB_PRIVATE_H_
 
+struct confdb_snapshot;
+
 struct confdb_ctx {
     struct tevent_context *pev;
     struct ldb_context *ldb;
 
     struct sss_domain_info *doms;
+
+    bool use_snapshot;
+    struct confdb_snapshot *snapshot;
 };
 
 int parse_section(TALLOC_CTX *mem_ctx, const char *section,
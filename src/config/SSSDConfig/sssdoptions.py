@@ -22,13 +22,23 @@ class SSSDOptions(object):
         'debug_timestamps': _('Include timestamps in debug logs'),
         'debug_microseconds': _('Include microseconds in timestamps in debug logs'),
         'debug_to_files': _('Write debug messages to logfiles'),
+        'debug_async': _('Write debug messages to logfiles from a separate thread'),
+        'debug_backtrace_enabled': _('Keep recent debug messages in memory and log them on failures'),
+        'debug_trace': _('Write timing records of requests to a trace file'),
+        'debug_event_loop': _('Collect statistics of the event loop handlers'),
         'timeout': _('Watchdog timeout before restarting service'),
         'command': _('Command to start service'),
         'reconnection_retries': _('Number of times to attempt connection to Data Providers'),
         'fd_limit': _('The number of file descriptors that may be opened by this responder'),
         'client_idle_timeout': _('Idle time before automatic disconnection of a client'),
+        'client_max_requests_per_uid': _('Number of requests the clients of one user may run at the same time'),
+        'provider_batch_size': _('Maximum number of lookups sent to the Data Provider in one request'),
+        'provider_coalescing_exclude': _('Data Provider methods whose identical requests are not merged'),
+        'warm_restart': _('Keep the content of the in-memory caches when the responder restarts'),
         'responder_idle_timeout': _('Idle time before automatic shutdown of the responder'),
+        'responder_idle_hibernate': _('Keep the idle responder running with its caches instead of shutting it down'),
         'cache_first': _('Always query all the caches before querying the Data Providers'),
+        'parallel_domain_lookups': _('Search all domains at once for names and IDs without a domain'),
         'offline_timeout': _('When SSSD switches to offline mode the amount of time before it tries to go back online '
                              'will increase based upon the time spent disconnected. This value is in seconds and '
                              'calculated by the following: offline_timeout + random_offset.'),
@@ -54,6 +64,8 @@ class SSSDOptions(object):
         'try_inotify': _('SSSD monitors the state of resolv.conf to identify when it needs to update its internal DNS '
                          'resolver. By default, we will attempt to use inotify for this, and will fall back to '
                          'polling resolv.conf every five seconds if inotify cannot be used.'),
+        'metrics_socket': _('Path of the socket where the monitor serves the metrics of all SSSD processes'),
+        'parallel_startup': _('Start the responders together with the providers'),
 
         # [nss]
         'enum_cache_timeout': _('Enumeration cache timeout length (seconds)'),
@@ -72,6 +84,22 @@ class SSSDOptions(object):
         'shell_fallback': _('If a shell stored in central directory is allowed but not available, use this fallback'),
         'default_shell': _('Shell to use if the provider does not list one'),
         'memcache_timeout': _('How long will be in-memory cache records valid'),
+        'memcache_hash_layout': _('Hash table layout of the in-memory cache'),
+        'memcache_hash_function': _('Hash function of the in-memory cache'),
+        'memcache_size_passwd': _('Number of entries the in-memory passwd cache is sized for'),
+        'memcache_size_group': _('Number of entries the in-memory group cache is sized for'),
+        'memcache_size_initgroups': _('Number of entries the in-memory initgroups cache is sized for'),
+        'memcache_size_sid': _('Number of entries the in-memory SID cache is sized for'),
+        'memcache_size_services': _('Number of entries the in-memory services cache is sized for'),
+        'memcache_size_hosts': _('Number of entries the in-memory hosts cache is sized for'),
+        'memcache_auto_resize': _('Whether the in-memory caches grow when they are too small'),
+        'memcache_huge_pages': _('Whether the in-memory cache files are mapped with huge pages'),
+        'memcache_negative_timeout': _('How long client applications remember users and groups that were not found'),
+        'worker_processes': _('Number of processes that answer NSS requests'),
+        'result_cache_size': _('Number of lookup results the NSS responder keeps in memory'),
+        'prefetch_hot_entries': _('Number of frequently requested users and groups refreshed before they expire'),
+        'initgroups_cache_size': _('Number of users whose encoded group lists the NSS responder keeps in memory'),
+        'hosts_index': _('Whether the NSS responder indexes all cached hosts and networks in memory'),
         'homedir_substring': _('The value of this option will be used in the expansion of the override_homedir option '
                                'if the template contains the format string %H.'),
         'get_domains_timeout': _('Specifies time in seconds for which the list of subdomains will be considered '
@@ -100,6 +128,8 @@ class SSSDOptions(object):
         'pam_p11_allowed_services': _('Allowed services for using smartcards'),
         'p11_wait_for_card_timeout': _('Additional timeout to wait for a card if requested'),
         'p11_uri': _('PKCS#11 URI to restrict the selection of devices for Smartcard authentication'),
+        'p11_child_standby': _('Keep a p11_child with loaded PKCS#11 modules ready for the next request'),
+        'pam_cert_user_cache_timeout': _('How many seconds to keep the users found by certificate in memory'),
         'pam_initgroups_scheme' : _('When shall the PAM responder force an initgroups request'),
 
         # [sudo]
@@ -107,6 +137,7 @@ class SSSDOptions(object):
         'sudo_inverse_order': _('If true, SSSD will switch back to lower-wins ordering logic'),
         'sudo_threshold': _('Maximum number of rules that can be refreshed at once. If this is exceeded, full refresh '
                             'is performed.'),
+        'sudo_rules_cache_size': _('Number of sorted rule sets the sudo responder keeps in memory'),
 
         # [autofs]
         'autofs_negative_timeout': _('Negative cache timeout length (seconds)'),
@@ -119,6 +150,7 @@ class SSSDOptions(object):
         'ssh_use_certificate_keys': _('Allow to generate ssh-keys from certificates'),
         'ssh_use_certificate_matching_rules': _('Use the following matching rules to filter the certificates for '
                                                 'ssh-key generation'),
+        'ssh_certificate_keys_cache_timeout': _('How many seconds to keep ssh-keys generated from certificates in memory'),
 
         # [pac]
         'allowed_uids': _('List of UIDs or user names allowed to access the PAC responder'),
@@ -126,6 +158,7 @@ class SSSDOptions(object):
 
         # [ifp]
         'user_attributes': _('List of user attributes the InfoPipe is allowed to publish'),
+        'result_cache_timeout': _('How long the InfoPipe keeps user attribute and group lookup results'),
 
         # [secrets]
         'provider': _('The provider where the secrets will be stored in'),
@@ -180,6 +213,8 @@ class SSSDOptions(object):
         'cache_credentials': _('Cache credentials for offline login'),
         'use_fully_qualified_names': _('Display users/groups in fully-qualified form'),
         'ignore_group_members': _('Don\'t include group members in group lookups'),
+        'ignore_group_members_above': _('Don\'t include group members in lookups of groups with more members than this'),
+        'id_negative_timeout': _('How long the backend remembers SIDs and IDs that were not found'),
         'entry_cache_timeout': _('Entry cache timeout length (seconds)'),
         'lookup_family_order': _('Restrict or prefer a specific address family when performing DNS lookups'),
         'account_cache_expiration': _('How long to keep cached entries after last successful login (days)'),
@@ -188,6 +223,9 @@ class SSSDOptions(object):
         'dns_resolver_op_timeout': _('How long should keep trying to resolve single DNS query (seconds)'),
         'dns_resolver_timeout': _('How long to wait for replies from DNS when resolving servers (seconds)'),
         'dns_discovery_domain': _('The domain part of service discovery DNS query'),
+        'dns_resolver_cache_timeout': _('How long DNS answers are cached at most (seconds)'),
+        'failover_probe_servers': _('How many servers are probed at the same time when looking for a working one'),
+        'failover_slow_server_threshold': _('Average latency of LDAP operations above which other servers are preferred (milliseconds)'),
         'override_gid': _('Override GID value from the identity provider with this value'),
         'case_sensitive': _('Treat usernames as case sensitive'),
         'entry_cache_user_timeout': _('Entry cache timeout length (seconds)'),
@@ -198,6 +236,13 @@ class SSSDOptions(object):
         'entry_cache_sudo_timeout': _('Entry cache timeout length (seconds)'),
         'entry_cache_resolver_timeout' : _('Entry cache timeout length (seconds)'),
         'refresh_expired_interval': _('How often should expired entries be refreshed in background'),
+        'refresh_expired_concurrency': _('How many object types and domains are refreshed in background at once'),
+        'cache_write_batch_size': _('Maximum number of cache transactions committed together'),
+        'provider_max_requests': _('Maximum number of requests of a provider target running at the same time'),
+        'cache_checkpoint_interval': _('How often should the cache be copied to the disk if it is kept in memory'),
+        'cache_engine': _('Storage engine of the cache database'),
+        'periodic_task_spread': _('Window over which periodic tasks of many hosts are spread (seconds)'),
+        'cache_compress_threshold': _('Minimum number of values of an attribute that are stored packed in the cache'),
         'dyndns_update': _("Whether to automatically update the client's DNS entry"),
         'dyndns_ttl': _("The TTL to apply to the client's DNS entry after updating it"),
         'dyndns_iface': _("The interface whose IP should be used for dynamic DNS updates"),
@@ -206,11 +251,13 @@ class SSSDOptions(object):
         'dyndns_force_tcp': _("Whether the nsupdate utility should default to using TCP"),
         'dyndns_auth': _("What kind of authentication should be used to perform the DNS update"),
         'dyndns_server': _("Override the DNS server used to perform the DNS update"),
+        'dyndns_unchanged_refresh_interval': _("How long the DNS entry is not refreshed if the addresses did not change"),
         'subdomain_enumerate': _('Control enumeration of trusted domains'),
         'subdomain_refresh_interval': _('How often should subdomains list be refreshed'),
         'subdomain_inherit': _('List of options that should be inherited into a subdomain'),
         'subdomain_homedir': _('Default subdomain homedir value'),
         'cached_auth_timeout': _('How long can cached credentials be used for cached authentication'),
+        'access_cache_timeout': _('How long is an allowed access remembered by the back end'),
         'auto_private_groups': _('Whether to automatically create private groups for users'),
         'pwd_expiration_warning': _('Display a warning N days before the password expires.'),
         'realmd_tags': _('Various tags stored by the realmd configuration service for this domain.'),
@@ -315,6 +362,7 @@ class SSSDOptions(object):
         'ad_update_samba_machine_account_password': _('Whether to update the machine account password in the Samba '
                                                       'database'),
         'ad_use_ldaps': _('Use LDAPS port for LDAP and Global Catalog requests'),
+        'ad_race_gc_ldap': _('Query the Global Catalog and LDAP at the same time'),
 
         # [provider/krb5]
         'krb5_kdcip': _('Kerberos server address'),
@@ -339,6 +387,7 @@ class SSSDOptions(object):
         'krb5_canonicalize': _("Enables principal canonicalization"),
         'krb5_use_enterprise_principal': _("Enables enterprise principals"),
         'krb5_map_user': _('A mapping from user names to Kerberos principal names'),
+        'krb5_child_pool_size': _('Number of krb5_child processes started in advance'),
 
         # [provider/krb5/chpass]
         'krb5_kpasswd': _('Server where the change password service is running if not on the KDC'),
@@ -355,6 +404,8 @@ class SSSDOptions(object):
         'ldap_default_authtok': _('The authentication token of the default bind DN'),
         'ldap_network_timeout': _('Length of time to attempt connection'),
         'ldap_opt_timeout': _('Length of time to attempt synchronous LDAP operations'),
+        'ldap_connection_pool_size': _('Maximum number of connections used for identity lookups'),
+        'ldap_connection_spare': _('Open a spare connection before the current one expires'),
         'ldap_offline_timeout': _('Length of time between attempts to reconnect while offline'),
         'ldap_force_upper_case_realm': _('Use only the upper case for realm names'),
         'ldap_tls_cacert': _('File that contains CA certificates'),
@@ -394,6 +445,7 @@ class SSSDOptions(object):
         'ldap_search_timeout': _('Length of time to wait for a search request'),
         'ldap_enumeration_search_timeout': _('Length of time to wait for a enumeration request'),
         'ldap_enumeration_refresh_timeout': _('Length of time between enumeration updates'),
+        'ldap_enumeration_sync': _('Use LDAP Content Synchronization to update enumerated users'),
         'ldap_purge_cache_timeout': _('Length of time between cache cleanups'),
         'ldap_id_use_start_tls': _('Require TLS for ID lookups'),
         'ldap_id_mapping': _('Use ID-mapping of objectSID instead of pre-set IDs'),
@@ -451,6 +503,8 @@ class SSSDOptions(object):
         'ldap_group_type': _('Type of the group and other flags'),
         'ldap_group_external_member': _('The LDAP group external member attribute'),
         'ldap_group_nesting_level': _('Maximum nesting level SSSD will follow'),
+        'ldap_group_nesting_parallel_lookups': _('Maximum number of nested group member lookups sent in parallel'),
+        'ldap_group_nesting_batch_size': _('Maximum number of nested group members looked up with one search'),
         'ldap_group_search_filter': _('Filter for group lookups'),
         'ldap_group_search_scope': _('Scope of group lookups'),
 
@@ -564,6 +618,7 @@ class SSSDOptions(object):
         'proxy_lib_name': _('The name of the NSS library to use'),
         'proxy_resolver_lib_name' : _('The name of the NSS library to use for hosts and networks lookups'),
         'proxy_fast_alias': _('Whether to look up canonical group name from cache if possible'),
+        'proxy_nss_workers': _('The number of processes that run the lookups in the NSS library'),
 
         # [provider/proxy/auth]
         'proxy_pam_target': _('PAM stack to use'),
@@ -378,12 +378,21 @@ class SSSDConfigTestSSSDService(unittest.TestCase):
             'debug_timestamps',
             'debug_microseconds',
             'debug_to_files',
+            'debug_async',
+            'debug_backtrace_enabled',
+            'debug_trace',
+            'debug_event_loop',
             'command',
             'reconnection_retries',
             'fd_limit',
             'client_idle_timeout',
+            'client_max_requests_per_uid',
+            'provider_batch_size',
+            'warm_restart',
             'responder_idle_timeout',
+            'responder_idle_hibernate',
             'cache_first',
+            'parallel_domain_lookups',
             'description',
             'certificate_verification',
             'override_space',
@@ -392,6 +401,8 @@ class SSSDConfigTestSSSDService(unittest.TestCase):
             'domain_resolution_order',
             'try_inotify',
             'monitor_resolv_conf',
+            'metrics_socket',
+            'parallel_startup',
         ]
 
         self.assertTrue(type(options) == dict,
@@ -594,6 +605,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'cache_credentials_minimal_first_factor_length',
             'use_fully_qualified_names',
             'ignore_group_members',
+            'ignore_group_members_above',
+            'id_negative_timeout',
             'filter_users',
             'filter_groups',
             'entry_cache_timeout',
@@ -606,12 +619,22 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'entry_cache_ssh_host_timeout',
             'entry_cache_resolver_timeout',
             'refresh_expired_interval',
+            'refresh_expired_concurrency',
+            'cache_write_batch_size',
+            'provider_max_requests',
+            'cache_checkpoint_interval',
+            'cache_engine',
+            'periodic_task_spread',
+            'cache_compress_threshold',
             'lookup_family_order',
             'account_cache_expiration',
             'dns_resolver_server_timeout',
             'dns_resolver_op_timeout',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'dns_resolver_cache_timeout',
+            'failover_probe_servers',
+            'failover_slow_server_threshold',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
@@ -620,6 +643,7 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'dyndns_force_tcp',
             'dyndns_auth',
             'dyndns_server',
+            'dyndns_unchanged_refresh_interval',
             'subdomain_enumerate',
             'override_gid',
             'case_sensitive',
@@ -647,6 +671,7 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'full_name_format',
             're_expression',
             'cached_auth_timeout',
+            'access_cache_timeout',
             'auto_private_groups']
 
         self.assertTrue(type(options) == dict,
@@ -731,7 +756,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
              'krb5_canonicalize',
              'krb5_use_enterprise_principal',
              'krb5_use_kdcinfo',
-             'krb5_map_user'])
+             'krb5_map_user',
+             'krb5_child_pool_size'])
 
         options = domain.list_options()
 
@@ -894,7 +920,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'krb5_canonicalize',
             'krb5_use_enterprise_principal',
             'krb5_use_kdcinfo',
-            'krb5_map_user']
+            'krb5_map_user',
+            'krb5_child_pool_size']
 
         self.assertTrue(type(options) == dict,
                         "Options should be a dictionary")
@@ -969,6 +996,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'cache_credentials_minimal_first_factor_length',
             'use_fully_qualified_names',
             'ignore_group_members',
+            'ignore_group_members_above',
+            'id_negative_timeout',
             'filter_users',
             'filter_groups',
             'entry_cache_timeout',
@@ -981,12 +1010,22 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'entry_cache_ssh_host_timeout',
             'entry_cache_resolver_timeout',
             'refresh_expired_interval',
+            'refresh_expired_concurrency',
+            'cache_write_batch_size',
+            'provider_max_requests',
+            'cache_checkpoint_interval',
+            'cache_engine',
+            'periodic_task_spread',
+            'cache_compress_threshold',
             'account_cache_expiration',
             'lookup_family_order',
             'dns_resolver_server_timeout',
             'dns_resolver_op_timeout',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'dns_resolver_cache_timeout',
+            'failover_probe_servers',
+            'failover_slow_server_threshold',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
@@ -995,6 +1034,7 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'dyndns_force_tcp',
             'dyndns_auth',
             'dyndns_server',
+            'dyndns_unchanged_refresh_interval',
             'subdomain_enumerate',
             'override_gid',
             'case_sensitive',
@@ -1022,6 +1062,7 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'full_name_format',
             're_expression',
             'cached_auth_timeout',
+            'access_cache_timeout',
             'auto_private_groups']
 
         self.assertTrue(type(options) == dict,
@@ -1107,7 +1148,8 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
              'krb5_canonicalize',
              'krb5_use_enterprise_principal',
              'krb5_use_kdcinfo',
-             'krb5_map_user'])
+             'krb5_map_user',
+             'krb5_child_pool_size'])
 
         options = domain.list_options()
 
@@ -27,6 +27,7 @@
 #include "db/sysdb_private.h"
 #include "confdb/confdb.h"
 #include "util/probes.h"
+#include "util/sss_loop_stats.h"
 #include <time.h>
 
 errno_t sysdb_dn_sanitize(TALLOC_CTX *mem_ctx, const char *input,
@@ -539,6 +540,59 @@ int sysdb_attrs_add_val_safe(struct sysdb_attrs *attrs,
     return sysdb_attrs_add_val_int(attrs, name, true, val);
 }
 
+int sysdb_attrs_add_vals(struct sysdb_attrs *attrs, const char *name,
+                         const struct ldb_val *vals, size_t num_vals)
+{
+    struct ldb_message_element *el = NULL;
+    struct ldb_val *new_vals;
+    uint8_t *buf;
+    size_t size = 0;
+    size_t c;
+    int ret;
+
+    if (num_vals == 0) {
+        return EOK;
+    }
+
+    for (c = 0; c < num_vals; c++) {
+        if (vals[c].length >= SIZE_MAX - size) {
+            return EINVAL;
+        }
+        /* values are NULL terminated like with ldb_val_dup() */
+        size += vals[c].length + 1;
+    }
+
+    ret = sysdb_attrs_get_el(attrs, name, &el);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    new_vals = talloc_realloc(attrs->a, el->values,
+                              struct ldb_val, el->num_values + num_vals);
+    if (new_vals == NULL) {
+        return ENOMEM;
+    }
+    el->values = new_vals;
+
+    buf = talloc_size(new_vals, size);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    for (c = 0; c < num_vals; c++) {
+        memcpy(buf, vals[c].data, vals[c].length);
+        buf[vals[c].length] = '\0';
+
+        new_vals[el->num_values].data = buf;
+        new_vals[el->num_values].length = vals[c].length;
+        el->num_values++;
+
+        buf += vals[c].length + 1;
+    }
+
+    return EOK;
+}
+
 int sysdb_attrs_add_string_safe(struct sysdb_attrs *attrs,
                                 const char *name, const char *str)
 {
@@ -873,10 +927,159 @@ char *sysdb_group_strdn(TALLOC_CTX *mem_ctx,
 
 /* =Transactions========================================================== */
 
+static void sysdb_batch_timeout(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval tv,
+                                void *pvt);
+
+/* The batch is an ldb transaction that encloses the top-level sysdb
+ * transactions, ldb only writes the changes when the outermost one is
+ * committed. */
+static errno_t sysdb_batch_open(struct sysdb_ctx *sysdb)
+{
+    struct timeval tv;
+    int ret;
+
+    ret = ldb_transaction_start(sysdb->ldb);
+    if (ret != LDB_SUCCESS) {
+        return sysdb_error_to_errno(ret);
+    }
+
+    tv = tevent_timeval_current_ofs(0, SYSDB_WRITE_BATCH_MSEC * 1000);
+    sysdb->batch_timer = tevent_add_timer(sysdb->ev, sysdb, tv,
+                                          sysdb_batch_timeout, sysdb);
+    if (sysdb->batch_timer == NULL) {
+        ldb_transaction_cancel(sysdb->ldb);
+        return ENOMEM;
+    }
+
+    sysdb->batch_open = true;
+    sysdb->batch_count = 0;
+
+    return EOK;
+}
+
+static errno_t sysdb_batch_close(struct sysdb_ctx *sysdb, bool commit)
+{
+    unsigned int count = sysdb->batch_count;
+    int ret;
+
+    sysdb->batch_open = false;
+    sysdb->batch_count = 0;
+    talloc_zfree(sysdb->batch_timer);
+
+    if (commit) {
+        ret = ldb_transaction_commit(sysdb->ldb);
+        if (ret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to commit %u batched transactions! (%d)\n",
+                  count, ret);
+        } else {
+            DEBUG(SSSDBG_TRACE_INTERNAL,
+                  "Committed %u batched transactions\n", count);
+        }
+    } else {
+        ret = ldb_transaction_cancel(sysdb->ldb);
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "A transaction was cancelled, %u batched transactions were "
+              "rolled back\n", count);
+    }
+
+    return sysdb_error_to_errno(ret);
+}
+
+static void sysdb_batch_timeout(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval tv,
+                                void *pvt)
+{
+    struct sysdb_ctx *sysdb = talloc_get_type(pvt, struct sysdb_ctx);
+
+    sysdb->batch_timer = NULL;
+
+    if (sysdb->transaction_nesting > 0) {
+        /* a transaction waits for an asynchronous operation, commit the
+         * batch once it is finished */
+        tv = tevent_timeval_current_ofs(0, SYSDB_WRITE_BATCH_MSEC * 1000);
+        sysdb->batch_timer = tevent_add_timer(ev, sysdb, tv,
+                                              sysdb_batch_timeout, sysdb);
+        if (sysdb->batch_timer != NULL) {
+            return;
+        }
+
+        /* the next top-level commit flushes the batch */
+        sysdb->batch_count = sysdb->batch_size;
+        return;
+    }
+
+    sysdb_batch_close(sysdb, true);
+}
+
+static int sysdb_batch_destructor(struct sysdb_ctx *sysdb)
+{
+    if (sysdb->batch_open && sysdb->transaction_nesting == 0) {
+        sysdb_batch_close(sysdb, true);
+    }
+
+    return 0;
+}
+
+errno_t sysdb_set_write_batch(struct sysdb_ctx *sysdb,
+                              struct tevent_context *ev,
+                              unsigned int batch_size)
+{
+    if (sysdb->batch_open) {
+        return EBUSY;
+    }
+
+    if (batch_size <= 1) {
+        sysdb->batch_size = 0;
+        talloc_set_destructor(sysdb, NULL);
+        return EOK;
+    }
+
+    sysdb->ev = ev;
+    sysdb->batch_size = batch_size;
+    talloc_set_destructor(sysdb, sysdb_batch_destructor);
+
+    return EOK;
+}
+
+errno_t sysdb_transaction_flush(struct sysdb_ctx *sysdb)
+{
+    if (sysdb == NULL || !sysdb->batch_open) {
+        return EOK;
+    }
+
+    if (sysdb->transaction_nesting > 0) {
+        return EBUSY;
+    }
+
+    return sysdb_batch_close(sysdb, true);
+}
+
+void sysdb_set_expire_notify(struct sysdb_ctx *sysdb,
+                             sysdb_expire_notify_fn fn,
+                             void *pvt)
+{
+    sysdb->expire_notify = fn;
+    sysdb->expire_notify_pvt = pvt;
+}
+
 int sysdb_transaction_start(struct sysdb_ctx *sysdb)
 {
     int ret;
 
+    if (sysdb->batch_size > 1 && !sysdb->batch_open
+            && sysdb->transaction_nesting == 0) {
+        ret = sysdb_batch_open(sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to start a batch, committing the transaction on "
+                  "its own [%d]: %s\n", ret, sss_strerror(ret));
+        }
+    }
+
     ret = ldb_transaction_start(sysdb->ldb);
     if (ret == LDB_SUCCESS) {
         PROBE(SYSDB_TRANSACTION_START, sysdb->transaction_nesting);
@@ -896,15 +1099,26 @@ int sysdb_transaction_commit(struct sysdb_ctx *sysdb)
 #endif
 
     PROBE(SYSDB_TRANSACTION_COMMIT_BEFORE, commit_nesting);
+    SSS_LOOP_STATS_ENTER();
     ret = ldb_transaction_commit(sysdb->ldb);
+    sss_loop_stats_leave();
     if (ret == LDB_SUCCESS) {
         sysdb->transaction_nesting--;
         PROBE(SYSDB_TRANSACTION_COMMIT_AFTER, sysdb->transaction_nesting);
     } else {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Failed to commit ldb transaction! (%d)\n", ret);
+        return sysdb_error_to_errno(ret);
     }
-    return sysdb_error_to_errno(ret);
+
+    if (sysdb->batch_open && sysdb->transaction_nesting == 0) {
+        sysdb->batch_count++;
+        if (sysdb->batch_count >= sysdb->batch_size) {
+            return sysdb_batch_close(sysdb, true);
+        }
+    }
+
+    return EOK;
 }
 
 int sysdb_transaction_cancel(struct sysdb_ctx *sysdb)
@@ -918,8 +1132,15 @@ int sysdb_transaction_cancel(struct sysdb_ctx *sysdb)
     } else {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Failed to cancel ldb transaction! (%d)\n", ret);
+        return sysdb_error_to_errno(ret);
     }
-    return sysdb_error_to_errno(ret);
+
+    /* ldb does not roll back nested transactions */
+    if (sysdb->batch_open && sysdb->transaction_nesting == 0) {
+        return sysdb_batch_close(sysdb, false);
+    }
+
+    return EOK;
 }
 
 int compare_ldb_dn_comp_num(const void *m1, const void *m2)
@@ -966,6 +1187,263 @@ int sysdb_attrs_replace_name(struct sysdb_attrs *attrs, const char *oldname,
     return EOK;
 }
 
+/* Packed values are stored as a single value: a version byte, the number
+ * of values and, for every value, the length of the prefix it shares with
+ * the previous value, the length of the rest of it and the rest itself.
+ * Numbers are stored with seven bits per byte, the highest bit tells if
+ * another byte follows. */
+#define SYSDB_PACKED_VERSION 1
+
+static size_t sysdb_pack_number(uint8_t *buf, size_t number)
+{
+    size_t len = 0;
+
+    do {
+        buf[len] = number & 0x7f;
+        number >>= 7;
+        if (number != 0) {
+            buf[len] |= 0x80;
+        }
+        len++;
+    } while (number != 0);
+
+    return len;
+}
+
+static errno_t sysdb_unpack_number(const struct ldb_val *packed,
+                                   size_t *_pos,
+                                   size_t *_number)
+{
+    size_t number = 0;
+    size_t pos = *_pos;
+    unsigned int shift;
+
+    for (shift = 0; shift < 32; shift += 7) {
+        if (pos >= packed->length) {
+            return EINVAL;
+        }
+
+        number |= (size_t)(packed->data[pos] & 0x7f) << shift;
+        if ((packed->data[pos++] & 0x80) == 0) {
+            *_pos = pos;
+            *_number = number;
+            return EOK;
+        }
+    }
+
+    return EINVAL;
+}
+
+int sysdb_attrs_pack_values(struct sysdb_attrs *attrs,
+                            const char *name,
+                            const char *packed_name,
+                            unsigned int threshold)
+{
+    struct ldb_message_element *el;
+    struct ldb_val *prev;
+    struct ldb_val *val;
+    const char *new_name;
+    uint8_t *buf;
+    size_t max_len;
+    size_t shared;
+    size_t len;
+    unsigned int i;
+    int ret;
+
+    if (threshold == 0) {
+        return EOK;
+    }
+
+    ret = sysdb_attrs_get_el_ext(attrs, name, false, &el);
+    if (ret == ENOENT || (ret == EOK && el->num_values < threshold)) {
+        return EOK;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    /* two numbers of at most 10 bytes for every value */
+    max_len = 11;
+    for (i = 0; i < el->num_values; i++) {
+        max_len += 20 + el->values[i].length;
+    }
+
+    buf = talloc_size(attrs, max_len);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    buf[0] = SYSDB_PACKED_VERSION;
+    len = 1;
+    len += sysdb_pack_number(buf + len, el->num_values);
+
+    prev = NULL;
+    for (i = 0; i < el->num_values; i++) {
+        val = &el->values[i];
+
+        shared = 0;
+        if (prev != NULL) {
+            while (shared < prev->length && shared < val->length
+                    && prev->data[shared] == val->data[shared]) {
+                shared++;
+            }
+        }
+
+        len += sysdb_pack_number(buf + len, shared);
+        len += sysdb_pack_number(buf + len, val->length - shared);
+        memcpy(buf + len, val->data + shared, val->length - shared);
+        len += val->length - shared;
+
+        prev = val;
+    }
+
+    new_name = talloc_strdup(attrs, packed_name);
+    if (new_name == NULL) {
+        talloc_free(buf);
+        return ENOMEM;
+    }
+
+    val = talloc(attrs, struct ldb_val);
+    if (val == NULL) {
+        talloc_free(buf);
+        talloc_free(discard_const(new_name));
+        return ENOMEM;
+    }
+
+    val->data = talloc_realloc(val, buf, uint8_t, len);
+    if (val->data == NULL) {
+        talloc_free(buf);
+        talloc_free(discard_const(new_name));
+        talloc_free(val);
+        return ENOMEM;
+    }
+    val->length = len;
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Packed %u values of %s into %zu bytes\n",
+          el->num_values, name, len);
+
+    talloc_free(discard_const(el->name));
+    talloc_free(el->values);
+    el->name = new_name;
+    el->values = val;
+    el->num_values = 1;
+
+    return EOK;
+}
+
+errno_t sysdb_msg_unpack_values(struct ldb_message *msg,
+                                const char *packed_name,
+                                const char *name)
+{
+    struct ldb_message_element *el;
+    const struct ldb_val *packed;
+    struct ldb_val *values = NULL;
+    struct ldb_val *prev;
+    const char *new_name;
+    size_t pos;
+    size_t count;
+    size_t shared;
+    size_t rest;
+    size_t i;
+    errno_t ret;
+
+    el = ldb_msg_find_element(msg, packed_name);
+    if (el == NULL) {
+        return EOK;
+    }
+
+    if (el->num_values != 1) {
+        ret = EINVAL;
+        goto done;
+    }
+    packed = &el->values[0];
+
+    if (packed->length < 1 || packed->data[0] != SYSDB_PACKED_VERSION) {
+        ret = EINVAL;
+        goto done;
+    }
+    pos = 1;
+
+    ret = sysdb_unpack_number(packed, &pos, &count);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* every value takes at least two bytes */
+    if (count == 0 || count > (packed->length - pos) / 2) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    values = talloc_zero_array(msg->elements, struct ldb_val, count);
+    if (values == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    prev = NULL;
+    for (i = 0; i < count; i++) {
+        ret = sysdb_unpack_number(packed, &pos, &shared);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = sysdb_unpack_number(packed, &pos, &rest);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        if ((prev == NULL && shared != 0)
+                || (prev != NULL && shared > prev->length)
+                || rest > packed->length - pos) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        values[i].data = talloc_size(values, shared + rest + 1);
+        if (values[i].data == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        if (shared > 0) {
+            memcpy(values[i].data, prev->data, shared);
+        }
+        memcpy(values[i].data + shared, packed->data + pos, rest);
+        values[i].data[shared + rest] = '\0';
+        values[i].length = shared + rest;
+        pos += rest;
+
+        prev = &values[i];
+    }
+
+    if (pos != packed->length) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    new_name = talloc_strdup(msg->elements, name);
+    if (new_name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    el->name = new_name;
+    el->values = values;
+    el->num_values = count;
+    values = NULL;
+
+    ret = EOK;
+
+done:
+    if (ret == EINVAL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed value of %s in %s\n",
+              packed_name, ldb_dn_get_linearized(msg->dn));
+    }
+
+    talloc_free(values);
+    return ret;
+}
+
 /* Search for all incidences of attr_name in a list of
  * sysdb_attrs and add their value to a list
  *
@@ -1398,6 +1876,261 @@ done:
     return ret;
 }
 
+errno_t sysdb_get_cache_generation(struct sss_domain_info *domain,
+                                   uint32_t *_generation)
+{
+    errno_t ret;
+    struct ldb_dn *dn;
+    uint32_t generation = 0;
+
+    dn = sysdb_domain_dn(NULL, domain);
+    if (dn == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_get_uint(domain->sysdb, dn, SYSDB_CACHE_GENERATION,
+                         &generation);
+    talloc_free(dn);
+    if (ret == ENOENT) {
+        generation = 0;
+        ret = EOK;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    *_generation = generation;
+    return EOK;
+}
+
+errno_t sysdb_bump_cache_generation(struct sss_domain_info *domain,
+                                    uint32_t *_generation)
+{
+    errno_t ret;
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *dn;
+    uint32_t generation;
+    bool in_transaction = false;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dn = sysdb_domain_dn(tmp_ctx, domain);
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_transaction_start(domain->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sysdb_get_cache_generation(domain, &generation);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* 0 means "never bumped", skip it when wrapping around */
+    generation++;
+    if (generation == 0) {
+        generation = 1;
+    }
+
+    ret = sysdb_set_uint(domain->sysdb, dn, domain->name,
+                         SYSDB_CACHE_GENERATION, generation);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_transaction_commit(domain->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Cache generation of [%s] is now %u\n",
+          domain->name, generation);
+
+    if (_generation != NULL) {
+        *_generation = generation;
+    }
+
+done:
+    if (in_transaction) {
+        sysdb_transaction_cancel(domain->sysdb);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+bool sysdb_cache_generation_is_stale(struct ldb_message *msg,
+                                     const char *expire_attr,
+                                     uint32_t generation)
+{
+    const char *attr;
+    uint32_t entry_generation;
+
+    if (generation == 0) {
+        return false;
+    }
+
+    if (strcmp(expire_attr, SYSDB_INITGR_EXPIRE) == 0) {
+        attr = SYSDB_INITGR_GENERATION;
+    } else {
+        attr = SYSDB_CACHE_GENERATION;
+    }
+
+    entry_generation = ldb_msg_find_attr_as_uint(msg, attr, 0);
+    return entry_generation != generation;
+}
+
+errno_t sysdb_get_sync_cookie(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domain,
+                              const char *attr_name,
+                              uint8_t **_cookie,
+                              size_t *_cookie_len)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    const struct ldb_val *val;
+    const char *attrs[2] = {attr_name, NULL};
+    uint8_t *cookie;
+    errno_t ret;
+    int lret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dn = sysdb_domain_dn(tmp_ctx, domain);
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    lret = ldb_search(domain->sysdb->ldb, tmp_ctx, &res, dn, LDB_SCOPE_BASE,
+                      attrs, NULL);
+    if (lret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(lret);
+        goto done;
+    }
+
+    if (res->count == 0) {
+        ret = ENOENT;
+        goto done;
+    } else if (res->count != 1) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Got more than one reply for base search!\n");
+        ret = EIO;
+        goto done;
+    }
+
+    val = ldb_msg_find_ldb_val(res->msgs[0], attr_name);
+    if (val == NULL || val->length == 0) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    cookie = talloc_memdup(mem_ctx, val->data, val->length);
+    if (cookie == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    *_cookie = cookie;
+    *_cookie_len = val->length;
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sysdb_set_sync_cookie(struct sss_domain_info *domain,
+                              const char *attr_name,
+                              const uint8_t *cookie,
+                              size_t cookie_len)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message *msg;
+    struct ldb_result *res;
+    struct ldb_val val;
+    errno_t ret;
+    int lret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    msg = ldb_msg_new(tmp_ctx);
+    if (msg == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    msg->dn = sysdb_domain_dn(msg, domain);
+    if (msg->dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    lret = ldb_search(domain->sysdb->ldb, tmp_ctx, &res, msg->dn,
+                      LDB_SCOPE_BASE, NULL, NULL);
+    if (lret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(lret);
+        goto done;
+    }
+
+    if (res->count == 0) {
+        if (cookie == NULL) {
+            ret = EOK;
+            goto done;
+        }
+
+        lret = ldb_msg_add_string(msg, "cn", domain->name);
+    } else {
+        lret = ldb_msg_add_empty(msg, attr_name, LDB_FLAG_MOD_REPLACE, NULL);
+    }
+    if (lret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(lret);
+        goto done;
+    }
+
+    if (cookie != NULL) {
+        val.data = discard_const(cookie);
+        val.length = cookie_len;
+
+        lret = ldb_msg_add_value(msg, attr_name, &val, NULL);
+        if (lret != LDB_SUCCESS) {
+            ret = sysdb_error_to_errno(lret);
+            goto done;
+        }
+    }
+
+    if (res->count) {
+        lret = ldb_modify(domain->sysdb->ldb, msg);
+    } else {
+        lret = ldb_add(domain->sysdb->ldb, msg);
+    }
+
+    if (lret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "ldb operation failed: [%s](%d)[%s]\n",
+              ldb_strerror(lret), lret, ldb_errstring(domain->sysdb->ldb));
+    }
+    ret = sysdb_error_to_errno(lret);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t sysdb_attrs_primary_name(struct sysdb_ctx *sysdb,
                                  struct sysdb_attrs *attrs,
                                  const char *ldap_attr,
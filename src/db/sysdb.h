@@ -98,6 +98,7 @@
 #define SYSDB_LAST_UPDATE "lastUpdate"
 #define SYSDB_CACHE_EXPIRE "dataExpireTimestamp"
 #define SYSDB_INITGR_EXPIRE "initgrExpireTimestamp"
+#define SYSDB_INITGR_INDEX "initgrGidIndex"
 #define SYSDB_ENUM_EXPIRE "enumerationExpireTimestamp"
 #define SYSDB_IFP_CACHED "ifpCached"
 
@@ -120,6 +121,7 @@
 #define SYSDB_CACHEDPWD_FA2_LEN "cachedPasswordSecondFactorLen"
 
 #define SYSDB_UUID "uniqueID"
+#define SYSDB_SYNC_UUID "syncUUID"
 #define SYSDB_SID "objectSID"
 #define SYSDB_PRIMARY_GROUP "ADPrimaryGroupID"
 #define SYSDB_PRIMARY_GROUP_GIDNUM "origPrimaryGroupGidNumber"
@@ -156,6 +158,7 @@
 #define SYSDB_SUBDOMAIN_TRUST_DIRECTION "trustDirection"
 #define SYSDB_UPN_SUFFIXES "upnSuffixes"
 #define SYSDB_SITE "site"
+#define SYSDB_MEMCACHE_STAMP "memcacheStamp"
 #define SYSDB_ENABLED "enabled"
 
 #define SYSDB_BASE_ID "baseID"
@@ -230,9 +233,16 @@
 #define SYSDB_HAS_ENUMERATED_ID       0x00000001
 #define SYSDB_HAS_ENUMERATED_RESOLVER 0x00000002
 
+#define SYSDB_USER_SYNC_COOKIE "userSyncCookie"
+
+#define SYSDB_CACHE_GENERATION "cacheGeneration"
+#define SYSDB_INITGR_GENERATION "initgrGeneration"
+
 #define SYSDB_DEFAULT_ATTRS SYSDB_LAST_UPDATE, \
                             SYSDB_CACHE_EXPIRE, \
                             SYSDB_INITGR_EXPIRE, \
+                            SYSDB_CACHE_GENERATION, \
+                            SYSDB_INITGR_GENERATION, \
                             SYSDB_OBJECTCLASS, \
                             SYSDB_OBJECTCATEGORY
 
@@ -267,6 +277,11 @@
                            ORIGINALAD_PREFIX SYSDB_GIDNUM, \
                            NULL}
 
+/* Attributes read by sysdb_enumpwent_names() and sysdb_enumgrent_names() */
+#define SYSDB_ENUM_NAME_ATTRS {SYSDB_NAME, \
+                               SYSDB_OBJECTCATEGORY, \
+                               NULL}
+
 #define SYSDB_NETGR_ATTRS {SYSDB_NAME, SYSDB_NETGROUP_TRIPLE, \
                            SYSDB_NETGROUP_MEMBER, \
                            SYSDB_DEFAULT_ATTRS, \
@@ -370,6 +385,10 @@ int sysdb_attrs_add_val(struct sysdb_attrs *attrs,
                         const char *name, const struct ldb_val *val);
 int sysdb_attrs_add_val_safe(struct sysdb_attrs *attrs,
                              const char *name, const struct ldb_val *val);
+/* All values are copied with two allocations, the data of the values share
+ * one buffer and cannot be freed or moved one by one. */
+int sysdb_attrs_add_vals(struct sysdb_attrs *attrs, const char *name,
+                         const struct ldb_val *vals, size_t num_vals);
 int sysdb_attrs_add_string_safe(struct sysdb_attrs *attrs,
                                 const char *name, const char *str);
 int sysdb_attrs_add_string(struct sysdb_attrs *attrs,
@@ -420,6 +439,22 @@ int sysdb_attrs_get_uint32_t(struct sysdb_attrs *attrs, const char *name,
 int sysdb_attrs_replace_name(struct sysdb_attrs *attrs, const char *oldname,
                                  const char *newname);
 
+/* Replace the values of @name with a single value of @packed_name holding
+ * all of them if there are at least @threshold of them, 0 disables it.
+ * The order of the values is kept and values sharing a prefix with the
+ * preceding value take less space, so the values should be sorted if the
+ * order is not important. Use sysdb_msg_unpack_values() to read them. */
+int sysdb_attrs_pack_values(struct sysdb_attrs *attrs,
+                            const char *name,
+                            const char *packed_name,
+                            unsigned int threshold);
+
+/* Replace @packed_name in @msg with the values of @name it holds. Nothing
+ * is done if @msg does not contain @packed_name. */
+errno_t sysdb_msg_unpack_values(struct ldb_message *msg,
+                                const char *packed_name,
+                                const char *name);
+
 int sysdb_attrs_users_from_str_list(struct sysdb_attrs *attrs,
                                     const char *attr_name,
                                     const char *domain,
@@ -504,6 +539,31 @@ int sysdb_transaction_start(struct sysdb_ctx *sysdb);
 int sysdb_transaction_commit(struct sysdb_ctx *sysdb);
 int sysdb_transaction_cancel(struct sysdb_ctx *sysdb);
 
+/* Commit up to batch_size top-level transactions together, the batch is
+ * committed at the latest SYSDB_WRITE_BATCH_MSEC milliseconds after its
+ * first transaction. Other processes do not see the changes until then,
+ * call sysdb_transaction_flush() before telling them about the changes.
+ * If a transaction of the batch is cancelled, the whole batch is rolled
+ * back. A batch_size of 0 or 1 commits every transaction on its own. */
+#define SYSDB_WRITE_BATCH_MSEC 50
+errno_t sysdb_set_write_batch(struct sysdb_ctx *sysdb,
+                              struct tevent_context *ev,
+                              unsigned int batch_size);
+errno_t sysdb_transaction_flush(struct sysdb_ctx *sysdb);
+
+/* Called after the SYSDB_CACHE_EXPIRE or SYSDB_INITGR_EXPIRE attribute of
+ * an entry was written with the new value in expire, and with attr set to
+ * NULL after the entry was deleted. The change may still be rolled back if
+ * the transaction is cancelled. */
+typedef void (*sysdb_expire_notify_fn)(struct ldb_dn *dn,
+                                       const char *attr,
+                                       time_t expire,
+                                       void *pvt);
+
+void sysdb_set_expire_notify(struct sysdb_ctx *sysdb,
+                             sysdb_expire_notify_fn fn,
+                             void *pvt);
+
 /* functions related to subdomains */
 errno_t sysdb_domain_create(struct sysdb_ctx *sysdb, const char *domain_name);
 
@@ -527,6 +587,17 @@ errno_t
 sysdb_set_site(struct sss_domain_info *dom,
                const char *site);
 
+/* Stamp of the memory cache files that were filled from this cache, see
+ * the warm_restart option. */
+errno_t
+sysdb_get_memcache_stamp(TALLOC_CTX *mem_ctx,
+                         struct sss_domain_info *dom,
+                         const char **_stamp);
+
+errno_t
+sysdb_set_memcache_stamp(struct sss_domain_info *dom,
+                         const char *stamp);
+
 errno_t
 sysdb_domain_set_enabled(struct sysdb_ctx *sysdb,
                          const char *name,
@@ -773,6 +844,12 @@ int sysdb_domain_init(TALLOC_CTX *mem_ctx,
                       const char *db_path,
                       struct sysdb_ctx **_ctx);
 
+/* If the domain has cache_checkpoint_interval set, the cache is kept in
+ * VOLATILE_DB_PATH without syncing it to the disk. sysdb_checkpoint()
+ * copies a consistent snapshot of it to DB_PATH, it is restored from there
+ * after a reboot. Does nothing for other domains. */
+errno_t sysdb_checkpoint(struct sysdb_ctx *sysdb);
+
 /* functions to retrieve information from sysdb
  * These functions automatically starts an operation
  * therefore they cannot be called within a transaction */
@@ -848,6 +925,30 @@ int sysdb_enumgrent_filter_with_views(TALLOC_CTX *mem_ctx,
                                       const char *addtl_filter,
                                       struct ldb_result **res);
 
+/* Enumerate only the DNs and names of all users or groups. The complete
+ * entries, with views applied, are read in smaller chunks with
+ * sysdb_enum_load_users() and sysdb_enum_load_groups(). Entries removed in
+ * the meantime are skipped. */
+int sysdb_enumpwent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **res);
+
+int sysdb_enumgrent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **res);
+
+errno_t sysdb_enum_load_users(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domain,
+                              struct ldb_message **names,
+                              size_t count,
+                              struct ldb_result **res);
+
+errno_t sysdb_enum_load_groups(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               struct ldb_message **names,
+                               size_t count,
+                               struct ldb_result **res);
+
 struct sysdb_netgroup_ctx {
     enum {SYSDB_NETGROUP_TRIPLE_VAL, SYSDB_NETGROUP_GROUP_VAL} type;
     union {
@@ -880,6 +981,23 @@ int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
                                 const char *name,
                                 struct ldb_result **res);
 
+/* Store the group IDs of the result of sysdb_initgroups() with the user, so
+ * that sysdb_initgroups_gids() can return them without loading the groups.
+ * The index holds one "<gid>:<group DN>" value for every memberof value of
+ * the user. */
+errno_t sysdb_set_initgr_index(struct sss_domain_info *domain,
+                               struct ldb_result *res);
+
+/* Same as sysdb_initgroups() but the group messages contain only the DN and
+ * SYSDB_GIDNUM and non-POSIX groups are left out. Returns ENOENT if the user
+ * has no up to date initgroups index, the caller is expected to fall back
+ * to sysdb_initgroups_with_views() then. Domains with views are not
+ * supported. */
+errno_t sysdb_initgroups_gids(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domain,
+                              const char *name,
+                              struct ldb_result **_res);
+
 int sysdb_get_user_attr(TALLOC_CTX *mem_ctx,
                         struct sss_domain_info *domain,
                         const char *name,
@@ -1033,6 +1151,31 @@ int sysdb_invalidate_cache_entry(struct sss_domain_info *domain,
                                  const char *name,
                                  bool is_user);
 
+/* Replace attrs, typically the expiration timestamps, of all entries in
+ * msgs in both the persistent and the timestamp cache, using a single
+ * transaction per cache instead of one per entry. Entries without a
+ * timestamp cache record are only changed in the persistent cache.
+ */
+errno_t sysdb_invalidate_cache_entries(struct sss_domain_info *domain,
+                                       struct ldb_message **msgs,
+                                       size_t count,
+                                       struct sysdb_attrs *attrs);
+
+/* Write all cached users and groups of domain, and its sudo rules if
+ * with_sudo is set, to out as LDIF. Authentication data such as cached
+ * passwords and the expiration times are not exported. */
+errno_t sysdb_export_domain(struct sss_domain_info *domain,
+                            bool with_sudo,
+                            FILE *out,
+                            size_t *_count);
+
+/* Store the entries written by sysdb_export_domain() in one transaction.
+ * They expire as if they were just downloaded. ERR_DOMAIN_NOT_FOUND is
+ * returned if the entries were exported from another domain. */
+errno_t sysdb_import_domain(struct sss_domain_info *domain,
+                            FILE *in,
+                            size_t *_count);
+
 /* Replace user attrs */
 int sysdb_set_user_attr(struct sss_domain_info *domain,
                         const char *name,
@@ -1343,6 +1486,37 @@ errno_t sysdb_set_enumerated(struct sss_domain_info *domain,
                              uint32_t provider,
                              bool has_enumerated);
 
+/* The cache generation of a domain is stored in the domain entry and starts
+ * at 0. Whenever SYSDB_CACHE_EXPIRE or SYSDB_INITGR_EXPIRE of a user or group
+ * is written while it is non-zero, the entry is stamped with it in
+ * SYSDB_CACHE_GENERATION or SYSDB_INITGR_GENERATION. Bumping it makes all
+ * older entries expired without touching them. */
+errno_t sysdb_get_cache_generation(struct sss_domain_info *domain,
+                                   uint32_t *_generation);
+
+errno_t sysdb_bump_cache_generation(struct sss_domain_info *domain,
+                                    uint32_t *_generation);
+
+/* True if expire_attr of msg was written before the cache generation was
+ * bumped to generation. */
+bool sysdb_cache_generation_is_stale(struct ldb_message *msg,
+                                     const char *expire_attr,
+                                     uint32_t generation);
+
+/* Content synchronization cookie stored in the domain entry. Returns ENOENT
+ * if there is none. */
+errno_t sysdb_get_sync_cookie(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domain,
+                              const char *attr_name,
+                              uint8_t **_cookie,
+                              size_t *_cookie_len);
+
+/* Replaces the cookie, or removes it if cookie is NULL. */
+errno_t sysdb_set_sync_cookie(struct sss_domain_info *domain,
+                              const char *attr_name,
+                              const uint8_t *cookie,
+                              size_t cookie_len);
+
 errno_t sysdb_remove_attrs(struct sss_domain_info *domain,
                            const char *name,
                            enum sysdb_member_type type,
@@ -1444,6 +1618,20 @@ errno_t sysdb_remove_cert(struct sss_domain_info *domain,
 errno_t sysdb_remove_mapped_data(struct sss_domain_info *domain,
                                  struct sysdb_attrs *mapped_attr);
 
+/* === Functions related to the negative cache of the backend === */
+
+#define SYSDB_NEGCACHE_CONTAINER "negcache"
+#define SYSDB_NEGCACHE_OC "negcacheEntry"
+
+/* Remember that @key was not found for @timeout seconds. */
+errno_t sysdb_negcache_set(struct sss_domain_info *domain,
+                           const char *key,
+                           uint32_t timeout);
+
+/* Returns EEXIST if @key has a valid entry, ENOENT otherwise. */
+errno_t sysdb_negcache_check(struct sss_domain_info *domain,
+                             const char *key);
+
 /* === Functions related to GPOs === */
 
 #define SYSDB_GPO_CONTAINER "cn=gpos,cn=ad,cn=custom"
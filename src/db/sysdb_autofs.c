@@ -483,6 +483,7 @@ sysdb_autofs_entries_by_map(TALLOC_CTX *mem_ctx,
     char *filter;
     const char *attrs[] = { SYSDB_AUTOFS_ENTRY_KEY,
                             SYSDB_AUTOFS_ENTRY_VALUE,
+                            SYSDB_CACHE_EXPIRE,
                             NULL };
     size_t count;
     struct ldb_message **msgs;
@@ -0,0 +1,618 @@
+/*
+    SSSD
+
+    System Database - export and import of cached users and groups
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+
+#include "util/util.h"
+#include "db/sysdb.h"
+#include "db/sysdb_private.h"
+#include "db/sysdb_sudo.h"
+
+/* Attributes that are not exported. They are either maintained by sysdb
+ * itself, set again on import, or must not leave the host they were
+ * cached on. */
+static const char *sysdb_export_skip_attrs[] = {
+    SYSDB_MEMBEROF,
+    SYSDB_MEMBERUID,
+    SYSDB_CREATE_TIME,
+    SYSDB_LAST_UPDATE,
+    SYSDB_CACHE_EXPIRE,
+    SYSDB_INITGR_EXPIRE,
+    SYSDB_CACHE_GENERATION,
+    SYSDB_INITGR_GENERATION,
+    SYSDB_PWD,
+    SYSDB_CACHEDPWD,
+    SYSDB_CACHEDPWD_TYPE,
+    SYSDB_CACHEDPWD_FA2_LEN,
+    SYSDB_LAST_LOGIN,
+    SYSDB_LAST_ONLINE_AUTH,
+    SYSDB_LAST_FAILED_LOGIN,
+    SYSDB_FAILED_LOGIN_ATTEMPTS,
+    SYSDB_LAST_ONLINE_AUTH_WITH_CURR_TOKEN,
+    SYSDB_CCACHE_FILE,
+    SYSDB_OVERRIDE_DN,
+    SYSDB_IFP_CACHED,
+    NULL
+};
+
+/* Attributes of users and groups that are passed to sysdb_store_user() and
+ * sysdb_store_group() as arguments or are set by them. */
+static const char *sysdb_import_user_args[] = {
+    SYSDB_OBJECTCLASS,
+    SYSDB_OBJECTCATEGORY,
+    SYSDB_NAME,
+    SYSDB_UIDNUM,
+    SYSDB_GIDNUM,
+    SYSDB_GECOS,
+    SYSDB_HOMEDIR,
+    SYSDB_SHELL,
+    SYSDB_ORIG_DN,
+    NULL
+};
+
+static const char *sysdb_import_group_args[] = {
+    SYSDB_OBJECTCLASS,
+    SYSDB_OBJECTCATEGORY,
+    SYSDB_NAME,
+    SYSDB_GIDNUM,
+    SYSDB_MEMBER,
+    NULL
+};
+
+static const char *sysdb_import_sudo_args[] = {
+    SYSDB_OBJECTCLASS,
+    SYSDB_NAME,
+    SYSDB_SUDO_CACHE_AT_USER_INDEX,
+    NULL
+};
+
+static errno_t sysdb_export_msgs(struct sysdb_ctx *sysdb,
+                                 FILE *out,
+                                 struct ldb_message **msgs,
+                                 size_t count)
+{
+    struct ldb_ldif ldif = { 0 };
+    size_t i;
+    int c;
+    int lret;
+
+    for (i = 0; i < count; i++) {
+        for (c = 0; sysdb_export_skip_attrs[c] != NULL; c++) {
+            ldb_msg_remove_attr(msgs[i], sysdb_export_skip_attrs[c]);
+        }
+
+        ldif.changetype = LDB_CHANGETYPE_NONE;
+        ldif.msg = msgs[i];
+        lret = ldb_ldif_write_file(sysdb->ldb, out, &ldif);
+        if (lret < 0) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to write %s\n",
+                  ldb_dn_get_linearized(msgs[i]->dn));
+            return EIO;
+        }
+    }
+
+    return EOK;
+}
+
+errno_t sysdb_export_domain(struct sss_domain_info *domain,
+                            bool with_sudo,
+                            FILE *out,
+                            size_t *_count)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message **msgs;
+    size_t count;
+    size_t total = 0;
+    const char *filter = "("SYSDB_NAME"=*)";
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    fprintf(out, "# SSSD cache of domain %s\n\n", domain->name);
+
+    ret = sysdb_search_users(tmp_ctx, domain, filter, NULL, &count, &msgs);
+    if (ret == EOK) {
+        ret = sysdb_export_msgs(domain->sysdb, out, msgs, count);
+        total += count;
+    } else if (ret == ENOENT) {
+        ret = EOK;
+    }
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_search_groups(tmp_ctx, domain, filter, NULL, &count, &msgs);
+    if (ret == EOK) {
+        ret = sysdb_export_msgs(domain->sysdb, out, msgs, count);
+        total += count;
+    } else if (ret == ENOENT) {
+        ret = EOK;
+    }
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (with_sudo) {
+#ifdef BUILD_SUDO
+        ret = sysdb_search_sudo_rules(tmp_ctx, domain, NULL, NULL,
+                                      &count, &msgs);
+        if (ret == EOK && count > 0) {
+            ret = sysdb_export_msgs(domain->sysdb, out, msgs, count);
+            total += count;
+        }
+        if (ret != EOK) {
+            goto done;
+        }
+#else
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Built without sudo support, sudo rules are not exported\n");
+#endif
+    }
+
+    if (fflush(out) != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Exported %zu entries of domain %s\n",
+          total, domain->name);
+
+    if (_count != NULL) {
+        *_count = total;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Copy all attributes of msg except those in skip to new sysdb_attrs */
+static struct sysdb_attrs *sysdb_import_attrs(TALLOC_CTX *mem_ctx,
+                                              struct ldb_message *msg,
+                                              const char **skip)
+{
+    struct sysdb_attrs *attrs;
+    struct ldb_message_element *el;
+    unsigned int i;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(mem_ctx);
+    if (attrs == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < msg->num_elements; i++) {
+        el = &msg->elements[i];
+        if (string_in_list(el->name, discard_const(sysdb_export_skip_attrs),
+                           false)
+                || string_in_list(el->name, discard_const(skip), false)) {
+            continue;
+        }
+
+        ret = sysdb_attrs_add_vals(attrs, el->name, el->values,
+                                   el->num_values);
+        if (ret != EOK) {
+            talloc_free(attrs);
+            return NULL;
+        }
+    }
+
+    return attrs;
+}
+
+static errno_t sysdb_import_user(struct sss_domain_info *domain,
+                                 struct ldb_message *msg,
+                                 time_t now)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs *attrs;
+    const char *name;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    attrs = sysdb_import_attrs(tmp_ctx, msg, sysdb_import_user_args);
+    if (attrs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* The group memberships are part of the export as well */
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_INITGR_EXPIRE,
+                                 domain->user_timeout
+                                    ? now + domain->user_timeout : 0);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_store_user(domain, name, NULL,
+                           ldb_msg_find_attr_as_uint(msg, SYSDB_UIDNUM, 0),
+                           ldb_msg_find_attr_as_uint(msg, SYSDB_GIDNUM, 0),
+                           ldb_msg_find_attr_as_string(msg, SYSDB_GECOS, NULL),
+                           ldb_msg_find_attr_as_string(msg, SYSDB_HOMEDIR,
+                                                       NULL),
+                           ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, NULL),
+                           ldb_msg_find_attr_as_string(msg, SYSDB_ORIG_DN,
+                                                       NULL),
+                           attrs, NULL, domain->user_timeout, now);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sysdb_import_group(struct sss_domain_info *domain,
+                                  struct ldb_message *msg,
+                                  time_t now)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs *attrs;
+    const char *name;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    attrs = sysdb_import_attrs(tmp_ctx, msg, sysdb_import_group_args);
+    if (attrs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_store_group(domain, name,
+                            ldb_msg_find_attr_as_uint(msg, SYSDB_GIDNUM, 0),
+                            attrs, domain->group_timeout, now);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Members are set once all groups exist so that nested groups can be
+ * linked regardless of their order. Members that are not in the cache,
+ * e.g. from a domain that was not imported, are dropped. */
+static errno_t sysdb_import_group_members(struct sss_domain_info *domain,
+                                          struct ldb_message *msg)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message_element *el;
+    struct sysdb_attrs *attrs;
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    const char *no_attrs[] = { NULL };
+    const char *name;
+    unsigned int i;
+    errno_t ret;
+    int lret;
+
+    el = ldb_msg_find_element(msg, SYSDB_MEMBER);
+    if (el == NULL || el->num_values == 0) {
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    attrs = sysdb_new_attrs(tmp_ctx);
+    if (attrs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < el->num_values; i++) {
+        dn = ldb_dn_from_ldb_val(tmp_ctx, domain->sysdb->ldb, &el->values[i]);
+        if (dn == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        lret = ldb_search(domain->sysdb->ldb, tmp_ctx, &res, dn,
+                          LDB_SCOPE_BASE, no_attrs, NULL);
+        if (lret == LDB_ERR_NO_SUCH_OBJECT
+                || (lret == LDB_SUCCESS && res->count == 0)) {
+            DEBUG(SSSDBG_TRACE_ALL, "Skipping unknown member %s of %s\n",
+                  ldb_dn_get_linearized(dn), name);
+            continue;
+        } else if (lret != LDB_SUCCESS) {
+            ret = sysdb_error_to_errno(lret);
+            goto done;
+        }
+
+        ret = sysdb_attrs_add_val(attrs, SYSDB_MEMBER, &el->values[i]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    if (attrs->num == 0) {
+        ret = EOK;
+        goto done;
+    }
+
+    ret = sysdb_set_group_attr(domain, name, attrs, SYSDB_MOD_REP);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sysdb_import_sudo_rules(struct sss_domain_info *domain,
+                                       struct ldb_message **msgs,
+                                       size_t count)
+{
+#ifdef BUILD_SUDO
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs **rules;
+    size_t i;
+    errno_t ret;
+
+    if (count == 0) {
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    rules = talloc_array(tmp_ctx, struct sysdb_attrs *, count);
+    if (rules == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        rules[i] = sysdb_import_attrs(rules, msgs[i], sysdb_import_sudo_args);
+        if (rules[i] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    ret = sysdb_sudo_store(domain, rules, count);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+#else
+    if (count > 0) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Built without sudo support, skipping %zu sudo rules\n", count);
+    }
+    return EOK;
+#endif
+}
+
+/* Entries are kept by type so that all users exist before the groups and
+ * all groups before their members are linked. */
+struct sysdb_import_entries {
+    struct ldb_message **msgs;
+    size_t count;
+};
+
+static errno_t sysdb_import_entries_add(TALLOC_CTX *mem_ctx,
+                                        struct sysdb_import_entries *entries,
+                                        struct ldb_message *msg)
+{
+    struct ldb_message **msgs;
+
+    msgs = talloc_realloc(mem_ctx, entries->msgs, struct ldb_message *,
+                          entries->count + 1);
+    if (msgs == NULL) {
+        return ENOMEM;
+    }
+
+    msgs[entries->count] = talloc_steal(msgs, msg);
+    entries->msgs = msgs;
+    entries->count++;
+
+    return EOK;
+}
+
+errno_t sysdb_import_domain(struct sss_domain_info *domain,
+                            FILE *in,
+                            size_t *_count)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_ctx *sysdb = domain->sysdb;
+    struct sysdb_import_entries users = { 0 };
+    struct sysdb_import_entries groups = { 0 };
+    struct sysdb_import_entries rules = { 0 };
+    struct ldb_ldif *ldif;
+    struct ldb_dn *base_dn;
+    const char *category;
+    bool in_transaction = false;
+    bool in_ts_transaction = false;
+    time_t now;
+    size_t i;
+    errno_t ret;
+    errno_t sret;
+    int lret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    base_dn = sysdb_domain_dn(tmp_ctx, domain);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    while ((ldif = ldb_ldif_read_file(sysdb->ldb, in)) != NULL) {
+        if (ldb_dn_compare_base(base_dn, ldif->msg->dn) != 0) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Entry %s does not belong to domain %s\n",
+                  ldb_dn_get_linearized(ldif->msg->dn), domain->name);
+            ldb_ldif_read_free(sysdb->ldb, ldif);
+            ret = ERR_DOMAIN_NOT_FOUND;
+            goto done;
+        }
+
+        category = ldb_msg_find_attr_as_string(ldif->msg,
+                                               SYSDB_OBJECTCATEGORY, NULL);
+        if (category != NULL && strcmp(category, SYSDB_USER_CLASS) == 0) {
+            ret = sysdb_import_entries_add(tmp_ctx, &users, ldif->msg);
+        } else if (category != NULL
+                       && strcmp(category, SYSDB_GROUP_CLASS) == 0) {
+            ret = sysdb_import_entries_add(tmp_ctx, &groups, ldif->msg);
+        } else if (ldb_msg_check_string_attribute(ldif->msg,
+                                                  SYSDB_OBJECTCLASS,
+                                                  SYSDB_SUDO_CACHE_OC)) {
+            ret = sysdb_import_entries_add(tmp_ctx, &rules, ldif->msg);
+        } else {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Skipping unknown entry %s\n",
+                  ldb_dn_get_linearized(ldif->msg->dn));
+            ret = EOK;
+        }
+        ldb_ldif_read_free(sysdb->ldb, ldif);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    if (ferror(in)) {
+        ret = EIO;
+        goto done;
+    }
+
+    ret = sysdb_transaction_start(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    /* Without this every entry of the timestamp cache would be committed,
+     * and synced to disk, on its own. */
+    if (sysdb->ldb_ts != NULL) {
+        lret = ldb_transaction_start(sysdb->ldb_ts);
+        if (lret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to start the timestamp cache transaction\n");
+            ret = sysdb_error_to_errno(lret);
+            goto done;
+        }
+        in_ts_transaction = true;
+    }
+
+    now = time(NULL);
+
+    for (i = 0; i < users.count; i++) {
+        ret = sysdb_import_user(domain, users.msgs[i], now);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to import %s [%d]: %s\n",
+                  ldb_dn_get_linearized(users.msgs[i]->dn),
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    for (i = 0; i < groups.count; i++) {
+        ret = sysdb_import_group(domain, groups.msgs[i], now);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to import %s [%d]: %s\n",
+                  ldb_dn_get_linearized(groups.msgs[i]->dn),
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    for (i = 0; i < groups.count; i++) {
+        ret = sysdb_import_group_members(domain, groups.msgs[i]);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to import members of %s "
+                  "[%d]: %s\n", ldb_dn_get_linearized(groups.msgs[i]->dn),
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    ret = sysdb_import_sudo_rules(domain, rules.msgs, rules.count);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (in_ts_transaction) {
+        lret = ldb_transaction_commit(sysdb->ldb_ts);
+        in_ts_transaction = false;
+        if (lret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to commit the timestamp cache transaction\n");
+            ret = sysdb_error_to_errno(lret);
+            goto done;
+        }
+    }
+
+    ret = sysdb_transaction_commit(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Imported %zu users, %zu groups and %zu sudo "
+          "rules into domain %s\n", users.count, groups.count, rules.count,
+          domain->name);
+
+    if (_count != NULL) {
+        *_count = users.count + groups.count + rules.count;
+    }
+
+    ret = EOK;
+
+done:
+    if (in_ts_transaction) {
+        ldb_transaction_cancel(sysdb->ldb_ts);
+    }
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
@@ -27,6 +27,7 @@
 #include "confdb/confdb.h"
 #include "util/probes.h"
 #include <time.h>
+#include <fcntl.h>
 
 #define LDB_MODULES_PATH "LDB_MODULES_PATH"
 
@@ -42,10 +43,17 @@ const char *sysdb_ts_cache_attrs[] = {
     SYSDB_ORIG_MODSTAMP,
     SYSDB_INITGR_EXPIRE,
     SYSDB_USN,
+    SYSDB_CACHE_GENERATION,
+    SYSDB_INITGR_GENERATION,
 
     NULL,
 };
 
+#define SYSDB_LMDB_URL_PREFIX "mdb://"
+
+/* Start of the header of tdb files */
+#define SYSDB_TDB_MAGIC "TDB file"
+
 errno_t sysdb_ldb_connect(TALLOC_CTX *mem_ctx,
                           const char *filename,
                           int flags,
@@ -85,6 +93,21 @@ errno_t sysdb_ldb_connect(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+char *sysdb_engine_url(TALLOC_CTX *mem_ctx,
+                       enum sss_cache_engine engine,
+                       const char *ldb_file)
+{
+    switch (engine) {
+    case SSS_CACHE_ENGINE_TDB:
+        /* ldb defaults to tdb */
+        return talloc_strdup(mem_ctx, ldb_file);
+    case SSS_CACHE_ENGINE_LMDB:
+        return talloc_asprintf(mem_ctx, SYSDB_LMDB_URL_PREFIX"%s", ldb_file);
+    }
+
+    return NULL;
+}
+
 static errno_t sysdb_ldb_reconnect(TALLOC_CTX *mem_ctx,
                                    const char *ldb_file,
                                    int flags,
@@ -101,6 +124,32 @@ static errno_t sysdb_ldb_reconnect(TALLOC_CTX *mem_ctx,
     return ret;
 }
 
+/* The backend has to be able to register itself as a reader as well. */
+static errno_t sysdb_chown_lmdb_lock(const char *ldb_file,
+                                     uid_t uid, gid_t gid)
+{
+    char *lock_file;
+    errno_t ret;
+
+    lock_file = talloc_asprintf(NULL, "%s"SYSDB_LMDB_LOCK_SUFFIX, ldb_file);
+    if (lock_file == NULL) {
+        return ENOMEM;
+    }
+
+    ret = chown(lock_file, uid, gid);
+    if (ret != 0 && errno != ENOENT) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot set sysdb ownership of %s to %"SPRIuid":%"SPRIgid"\n",
+              lock_file, uid, gid);
+        talloc_free(lock_file);
+        return ret;
+    }
+
+    talloc_free(lock_file);
+    return EOK;
+}
+
 static errno_t sysdb_chown_db_files(struct sysdb_ctx *sysdb,
                                     uid_t uid, gid_t gid)
 {
@@ -126,9 +175,199 @@ static errno_t sysdb_chown_db_files(struct sysdb_ctx *sysdb,
         }
     }
 
+    if (sysdb->engine == SSS_CACHE_ENGINE_LMDB) {
+        ret = sysdb_chown_lmdb_lock(sysdb->ldb_file, uid, gid);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        if (sysdb->ldb_ts_file != NULL) {
+            ret = sysdb_chown_lmdb_lock(sysdb->ldb_ts_file, uid, gid);
+            if (ret != EOK) {
+                return ret;
+            }
+        }
+    }
+
+    if (sysdb->ldb_checkpoint_file != NULL) {
+        /* The directory was created by us and the backend has to be able
+         * to write there as well. */
+        ret = chown(VOLATILE_DB_PATH, uid, gid);
+        if (ret != 0) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot set sysdb ownership of %s to %"SPRIuid":%"SPRIgid"\n",
+                  VOLATILE_DB_PATH, uid, gid);
+            return ret;
+        }
+
+        ret = chown(sysdb->ldb_checkpoint_file, uid, gid);
+        if (ret != 0 && errno != ENOENT) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot set sysdb ownership of %s to %"SPRIuid":%"SPRIgid"\n",
+                  sysdb->ldb_checkpoint_file, uid, gid);
+            return ret;
+        }
+    }
+
     return EOK;
 }
 
+/* Copy src to dst through a temporary file so dst is always complete. */
+static errno_t sysdb_copy_file(const char *src, const char *dst, bool sync)
+{
+    TALLOC_CTX *tmp_ctx;
+    char *tmp_path;
+    uint8_t buf[64 * 1024];
+    ssize_t nread;
+    ssize_t written;
+    int ifd = -1;
+    int ofd = -1;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    tmp_path = talloc_asprintf(tmp_ctx, "%s.XXXXXX", dst);
+    if (tmp_path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ifd = open(src, O_RDONLY | O_CLOEXEC);
+    if (ifd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    ofd = sss_unique_file(NULL, tmp_path, &ret);
+    if (ofd == -1) {
+        goto done;
+    }
+
+    while (1) {
+        errno = 0;
+        nread = sss_atomic_read_s(ifd, buf, sizeof(buf));
+        if (nread == -1) {
+            ret = errno;
+            goto done;
+        } else if (nread == 0) {
+            break;
+        }
+
+        errno = 0;
+        written = sss_atomic_write_s(ofd, buf, nread);
+        if (written == -1) {
+            ret = errno;
+            goto done;
+        } else if (written != nread) {
+            ret = EIO;
+            goto done;
+        }
+    }
+
+    if (sync && fsync(ofd) == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    ret = rename(tmp_path, dst);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ofd != -1) {
+        close(ofd);
+        if (ret != EOK) {
+            unlink(tmp_path);
+        }
+    }
+
+    if (ifd != -1) {
+        close(ifd);
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to copy %s to %s [%d]: %s\n",
+              src, dst, ret, sss_strerror(ret));
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sysdb_volatile_file_init(struct sysdb_ctx *sysdb,
+                                        const char *volatile_db_path)
+{
+    const char *name;
+    errno_t ret;
+
+    ret = mkdir(volatile_db_path, 0700);
+    if (ret != 0 && errno != EEXIST) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create %s [%d]: %s\n",
+              volatile_db_path, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    name = strrchr(sysdb->ldb_file, '/');
+    name = name == NULL ? sysdb->ldb_file : name + 1;
+
+    sysdb->ldb_checkpoint_file = sysdb->ldb_file;
+    sysdb->ldb_file = talloc_asprintf(sysdb, "%s/%s", volatile_db_path, name);
+    if (sysdb->ldb_file == NULL) {
+        return ENOMEM;
+    }
+
+    if (access(sysdb->ldb_file, F_OK) == 0
+            || access(sysdb->ldb_checkpoint_file, F_OK) != 0) {
+        /* Either SSSD was only restarted or there is nothing to restore. */
+        return EOK;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Restoring cache from checkpoint %s\n",
+          sysdb->ldb_checkpoint_file);
+
+    return sysdb_copy_file(sysdb->ldb_checkpoint_file, sysdb->ldb_file, false);
+}
+
+errno_t sysdb_checkpoint(struct sysdb_ctx *sysdb)
+{
+    errno_t ret;
+
+    if (sysdb == NULL || sysdb->ldb_checkpoint_file == NULL) {
+        return EOK;
+    }
+
+    /* The transaction holds off writers of all processes so the copy is
+     * consistent. If a batch of our own is open, the copy simply does not
+     * contain it yet. */
+    ret = ldb_transaction_start(sysdb->ldb);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start ldb transaction! (%d)\n",
+              ret);
+        return sysdb_error_to_errno(ret);
+    }
+
+    ret = sysdb_copy_file(sysdb->ldb_file, sysdb->ldb_checkpoint_file, true);
+
+    ldb_transaction_cancel(sysdb->ldb);
+
+    if (ret == EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Cache checkpoint written to %s\n",
+              sysdb->ldb_checkpoint_file);
+    }
+
+    return ret;
+}
+
 int sysdb_get_db_file(TALLOC_CTX *mem_ctx,
                       const char *provider,
                       const char *name,
@@ -573,6 +812,13 @@ static errno_t sysdb_domain_cache_upgrade(TALLOC_CTX *mem_ctx,
         }
     }
 
+    if (strcmp(version, SYSDB_VERSION_0_22) == 0) {
+        ret = sysdb_upgrade_22(sysdb, &version);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     ret = EOK;
 done:
     sysdb->ldb = save_ldb;
@@ -583,6 +829,7 @@ done:
 
 static errno_t remove_ts_cache(struct sysdb_ctx *sysdb)
 {
+    char *lock_file;
     errno_t ret;
 
     if (sysdb->ldb_ts_file == NULL) {
@@ -594,6 +841,113 @@ static errno_t remove_ts_cache(struct sysdb_ctx *sysdb)
         return errno;
     }
 
+    lock_file = talloc_asprintf(NULL, "%s"SYSDB_LMDB_LOCK_SUFFIX,
+                                sysdb->ldb_ts_file);
+    if (lock_file == NULL) {
+        return ENOMEM;
+    }
+
+    ret = unlink(lock_file);
+    talloc_free(lock_file);
+    if (ret != EOK && errno != ENOENT) {
+        return errno;
+    }
+
+    return EOK;
+}
+
+static errno_t sysdb_file_engine(const char *ldb_file,
+                                 enum sss_cache_engine *_engine)
+{
+    char magic[sizeof(SYSDB_TDB_MAGIC) - 1];
+    ssize_t len;
+    errno_t ret;
+    int fd;
+
+    fd = open(ldb_file, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return errno;
+    }
+
+    errno = 0;
+    len = sss_atomic_read_s(fd, magic, sizeof(magic));
+    ret = errno;
+    close(fd);
+    if (len == -1) {
+        return ret;
+    } else if (len == 0) {
+        /* Nothing was stored yet */
+        return ENOENT;
+    }
+
+    if (len == sizeof(magic)
+            && memcmp(magic, SYSDB_TDB_MAGIC, sizeof(magic)) == 0) {
+        *_engine = SSS_CACHE_ENGINE_TDB;
+    } else {
+        *_engine = SSS_CACHE_ENGINE_LMDB;
+    }
+
+    return EOK;
+}
+
+/* Existing caches of another engine are only converted when upgrades are
+ * allowed, i.e. by the monitor before any other process opens them. */
+static errno_t sysdb_engine_init(struct sysdb_ctx *sysdb,
+                                 struct sss_domain_info *domain,
+                                 bool convert)
+{
+    enum sss_cache_engine engine;
+    errno_t ret;
+
+    sysdb->engine = domain->cache_engine;
+
+    sysdb->ldb_url = sysdb_engine_url(sysdb, sysdb->engine, sysdb->ldb_file);
+    if (sysdb->ldb_url == NULL) {
+        return ENOMEM;
+    }
+
+    if (sysdb->ldb_ts_file != NULL) {
+        sysdb->ldb_ts_url = sysdb_engine_url(sysdb, sysdb->engine,
+                                             sysdb->ldb_ts_file);
+        if (sysdb->ldb_ts_url == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    ret = sysdb_file_engine(sysdb->ldb_file, &engine);
+    if (ret == ENOENT) {
+        return EOK;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read %s [%d]: %s\n",
+              sysdb->ldb_file, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (engine == sysdb->engine) {
+        return EOK;
+    }
+
+    if (!convert) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "The cache of domain %s uses another storage engine than "
+              "configured, it is converted when SSSD starts\n", domain->name);
+        return EINVAL;
+    }
+
+    ret = sysdb_convert_engine(sysdb->ldb_file, engine, sysdb->engine);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* The timestamps are written again by the next lookups */
+    ret = remove_ts_cache(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Could not delete the timestamp ldb file (%d) (%s)\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
     return EOK;
 }
 
@@ -711,6 +1065,12 @@ done:
     return ret;
 }
 
+/* There is no point in syncing a file that does not survive a reboot. */
+static int sysdb_cache_flags(struct sysdb_ctx *sysdb)
+{
+    return sysdb->ldb_checkpoint_file != NULL ? LDB_FLG_NOSYNC : 0;
+}
+
 static errno_t sysdb_cache_connect(TALLOC_CTX *mem_ctx,
                                    struct sysdb_ctx *sysdb,
                                    struct sss_domain_info *domain,
@@ -723,8 +1083,9 @@ static errno_t sysdb_cache_connect(TALLOC_CTX *mem_ctx,
 
     ldb_file_exists = !(access(sysdb->ldb_file, F_OK) == -1 && errno == ENOENT);
 
-    ret = sysdb_cache_connect_helper(mem_ctx, domain, sysdb->ldb_file,
-                                      0, SYSDB_VERSION, SYSDB_BASE_LDIF,
+    ret = sysdb_cache_connect_helper(mem_ctx, domain, sysdb->ldb_url,
+                                      sysdb_cache_flags(sysdb),
+                                      SYSDB_VERSION, SYSDB_BASE_LDIF,
                                       &newly_created, ldb, version);
 
     /* The cache has been newly created. */
@@ -746,7 +1107,7 @@ static errno_t sysdb_ts_cache_connect(TALLOC_CTX *mem_ctx,
                                       struct ldb_context **ldb,
                                       const char **version)
 {
-    return sysdb_cache_connect_helper(mem_ctx, domain, sysdb->ldb_ts_file,
+    return sysdb_cache_connect_helper(mem_ctx, domain, sysdb->ldb_ts_url,
                                       LDB_FLG_NOSYNC, SYSDB_TS_VERSION,
                                       SYSDB_TS_BASE_LDIF, NULL,
                                       ldb, version);
@@ -806,7 +1167,8 @@ static int sysdb_domain_cache_connect(struct sysdb_ctx *sysdb,
              * We need to reopen the LDB to ensure that
              * any changes made above take effect.
              */
-            ret = sysdb_ldb_reconnect(tmp_ctx, sysdb->ldb_file, 0, &ldb);
+            ret = sysdb_ldb_reconnect(tmp_ctx, sysdb->ldb_url,
+                                      sysdb_cache_flags(sysdb), &ldb);
             goto done;
         }
         break;
@@ -878,7 +1240,7 @@ static int sysdb_timestamp_cache_connect(struct sysdb_ctx *sysdb,
              * any changes made above take effect.
              */
             ret = sysdb_ldb_reconnect(tmp_ctx,
-                                      sysdb->ldb_ts_file,
+                                      sysdb->ldb_ts_url,
                                       LDB_FLG_NOSYNC,
                                       &ldb);
             if (ret != EOK) {
@@ -931,6 +1293,7 @@ static int sysdb_timestamp_cache_connect(struct sysdb_ctx *sysdb,
 int sysdb_domain_init_internal(TALLOC_CTX *mem_ctx,
                                struct sss_domain_info *domain,
                                const char *db_path,
+                               const char *volatile_db_path,
                                struct sysdb_dom_upgrade_ctx *upgrade_ctx,
                                struct sysdb_ctx **_ctx)
 {
@@ -954,8 +1317,21 @@ int sysdb_domain_init_internal(TALLOC_CTX *mem_ctx,
     if (ret != EOK) {
         goto done;
     }
+
+    if (volatile_db_path != NULL) {
+        ret = sysdb_volatile_file_init(sysdb, volatile_db_path);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = sysdb_engine_init(sysdb, domain, upgrade_ctx != NULL);
+    if (ret != EOK) {
+        goto done;
+    }
+
     DEBUG(SSSDBG_FUNC_DATA,
-          "DB File for %s: %s\n", domain->name, sysdb->ldb_file);
+          "DB File for %s: %s\n", domain->name, sysdb->ldb_url);
     if (sysdb->ldb_ts_file) {
         DEBUG(SSSDBG_FUNC_DATA,
              "Timestamp file for %s: %s\n", domain->name, sysdb->ldb_ts_file);
@@ -985,6 +1361,11 @@ done:
     return ret;
 }
 
+static const char *sysdb_volatile_db_path(struct sss_domain_info *domain)
+{
+    return domain->cache_checkpoint_interval > 0 ? VOLATILE_DB_PATH : NULL;
+}
+
 int sysdb_init(TALLOC_CTX *mem_ctx,
                struct sss_domain_info *domains)
 {
@@ -1035,6 +1416,7 @@ int sysdb_init_ext(TALLOC_CTX *mem_ctx,
         }
 
         ret = sysdb_domain_init_internal(tmp_ctx, dom, DB_PATH,
+                                         sysdb_volatile_db_path(dom),
                                          dom_upgrade_ctx, &sysdb);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE,
@@ -1067,6 +1449,7 @@ int sysdb_domain_init(TALLOC_CTX *mem_ctx,
                       const char *db_path,
                       struct sysdb_ctx **_ctx)
 {
-    return sysdb_domain_init_internal(mem_ctx, domain,
-                                      db_path, false, _ctx);
+    return sysdb_domain_init_internal(mem_ctx, domain, db_path,
+                                      sysdb_volatile_db_path(domain),
+                                      false, _ctx);
 }
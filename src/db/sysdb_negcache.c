@@ -0,0 +1,113 @@
+/*
+   SSSD
+
+   System Database - persistent negative cache of the backend
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "util/util.h"
+#include "db/sysdb_private.h"
+
+/* Entries are kept as custom objects of the domain so that they survive
+ * restarts of SSSD together with the rest of the cache. */
+
+errno_t sysdb_negcache_set(struct sss_domain_info *domain,
+                           const char *key,
+                           uint32_t timeout)
+{
+    struct sysdb_attrs *attrs;
+    errno_t ret;
+
+    if (key == NULL || timeout == 0) {
+        return EINVAL;
+    }
+
+    attrs = sysdb_new_attrs(NULL);
+    if (attrs == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_OBJECTCLASS, SYSDB_NEGCACHE_OC);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_CACHE_EXPIRE,
+                                 time(NULL) + timeout);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_store_custom(domain, key, SYSDB_NEGCACHE_CONTAINER, attrs);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Unable to store negative cache entry [%s] [%d]: %s\n",
+              key, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Negative cache entry [%s] stored for %"PRIu32
+          " seconds\n", key, timeout);
+
+done:
+    talloc_free(attrs);
+    return ret;
+}
+
+errno_t sysdb_negcache_check(struct sss_domain_info *domain,
+                             const char *key)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_CACHE_EXPIRE, NULL };
+    struct ldb_message **msgs;
+    size_t count;
+    uint64_t expire;
+    errno_t ret;
+
+    if (key == NULL) {
+        return EINVAL;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_search_custom_by_name(tmp_ctx, domain, key,
+                                      SYSDB_NEGCACHE_CONTAINER, attrs,
+                                      &count, &msgs);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    expire = ldb_msg_find_attr_as_uint64(msgs[0], SYSDB_CACHE_EXPIRE, 0);
+    if (expire <= time(NULL)) {
+        /* Expired entries are removed when they are found. */
+        ret = sysdb_delete_custom(domain, key, SYSDB_NEGCACHE_CONTAINER);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to remove expired negative cache entry [%s] "
+                  "[%d]: %s\n", key, ret, sss_strerror(ret));
+        }
+        ret = ENOENT;
+        goto done;
+    }
+
+    ret = EEXIST;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
@@ -173,6 +173,44 @@ static int sysdb_delete_ts_entry(struct sysdb_ctx *sysdb,
     return sysdb_delete_cache_entry(sysdb->ldb_ts, dn, true);
 }
 
+static void sysdb_notify_expire(struct sysdb_ctx *sysdb,
+                                struct ldb_dn *dn,
+                                struct sysdb_attrs *attrs)
+{
+    const char *expire_attrs[] = { SYSDB_CACHE_EXPIRE,
+                                   SYSDB_INITGR_EXPIRE,
+                                   NULL };
+    const char *value;
+    long long expire;
+    errno_t ret;
+    int i;
+
+    if (sysdb->expire_notify == NULL) {
+        return;
+    }
+
+    if (attrs == NULL) {
+        sysdb->expire_notify(dn, NULL, 0, sysdb->expire_notify_pvt);
+        return;
+    }
+
+    for (i = 0; expire_attrs[i] != NULL; i++) {
+        ret = sysdb_attrs_get_string(attrs, expire_attrs[i], &value);
+        if (ret != EOK) {
+            continue;
+        }
+
+        errno = 0;
+        expire = strtoll(value, NULL, 10);
+        if (errno != 0) {
+            continue;
+        }
+
+        sysdb->expire_notify(dn, expire_attrs[i], expire,
+                             sysdb->expire_notify_pvt);
+    }
+}
+
 int sysdb_delete_entry(struct sysdb_ctx *sysdb,
                        struct ldb_dn *dn,
                        bool ignore_not_found)
@@ -188,6 +226,7 @@ int sysdb_delete_entry(struct sysdb_ctx *sysdb,
                   "sysdb_delete_ts_entry failed: %d\n", tret);
             /* Not fatal */
         }
+        sysdb_notify_expire(sysdb, dn, NULL);
     } else {
         DEBUG(SSSDBG_OP_FAILURE,
               "sysdb_delete_cache_entry failed: %d\n", ret);
@@ -1059,6 +1098,54 @@ static struct sysdb_attrs *ts_obj_attrs(TALLOC_CTX *mem_ctx,
     return attrs;
 }
 
+/* Stamp the expiration times in attrs with the current cache generation of
+ * the domain. Nothing is added until the generation was bumped for the
+ * first time. */
+static errno_t sysdb_add_cache_generation(struct sss_domain_info *domain,
+                                          struct sysdb_attrs *attrs)
+{
+    static const char *stamps[][2] = {
+        { SYSDB_CACHE_EXPIRE, SYSDB_CACHE_GENERATION },
+        { SYSDB_INITGR_EXPIRE, SYSDB_INITGR_GENERATION },
+    };
+    struct ldb_message_element *el;
+    uint32_t generation;
+    uint32_t present;
+    size_t i;
+    errno_t ret;
+
+    ret = sysdb_get_cache_generation(domain, &generation);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot read the cache generation [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (generation == 0) {
+        return EOK;
+    }
+
+    for (i = 0; i < sizeof(stamps) / sizeof(stamps[0]); i++) {
+        ret = sysdb_attrs_get_el_ext(attrs, stamps[i][0], false, &el);
+        if (ret != EOK) {
+            continue;
+        }
+
+        ret = sysdb_attrs_get_uint32_t(attrs, stamps[i][1], &present);
+        if (ret == EOK) {
+            /* Already stamped by the caller */
+            continue;
+        }
+
+        ret = sysdb_attrs_add_uint32(attrs, stamps[i][1], generation);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
 static errno_t sysdb_update_ts_cache(struct sss_domain_info *domain,
                                      struct ldb_dn *entry_dn,
                                      struct sysdb_attrs *entry_attrs,
@@ -1105,6 +1192,13 @@ static errno_t sysdb_update_ts_cache(struct sss_domain_info *domain,
         goto done;
     }
 
+    ret = sysdb_add_cache_generation(domain, ts_attrs);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Failed to add %s to tsdb\n", SYSDB_CACHE_GENERATION);
+        goto done;
+    }
+
     if (entry_attrs != NULL) {
         ret = sysdb_attrs_get_string(entry_attrs, SYSDB_ORIG_MODSTAMP,
                                      &modstamp);
@@ -1126,6 +1220,8 @@ static errno_t sysdb_update_ts_cache(struct sss_domain_info *domain,
               "Cannot set ts attrs for group %s\n",
               ldb_dn_get_linearized(entry_dn));
         /* Not fatal */
+    } else {
+        sysdb_notify_expire(domain->sysdb, entry_dn, ts_attrs);
     }
 
     ret = EOK;
@@ -1400,6 +1496,10 @@ int sysdb_set_entry_attr(struct sysdb_ctx *sysdb,
               get_attr_storage(state_mask));
     }
 
+    if (ret == EOK && mod_op != SYSDB_MOD_DEL) {
+        sysdb_notify_expire(sysdb, entry_dn, attrs);
+    }
+
     return ret;
 }
 
@@ -1810,16 +1910,14 @@ done:
 
 static errno_t
 sysdb_remove_ghost_from_group(struct sss_domain_info *dom,
-                              struct ldb_message *group,
+                              struct ldb_dn *group_dn,
+                              bool add_member,
                               struct ldb_message_element *alias_el,
                               const char *name,
-                              const char *orig_dn,
                               const char *userdn)
 {
     TALLOC_CTX *tmp_ctx;
     struct ldb_message *msg;
-    struct ldb_message_element *orig_members;
-    bool add_member = false;
     errno_t ret = EOK;
     int i;
 
@@ -1833,30 +1931,7 @@ sysdb_remove_ghost_from_group(struct sss_domain_info *dom,
         ERROR_OUT(ret, ENOMEM, done);
     }
 
-    msg->dn = group->dn;
-
-    if (orig_dn == NULL) {
-        /* We have no way of telling which groups this user belongs to.
-         * Add it to all that reference it in the ghost attribute */
-        add_member = true;
-    } else {
-        add_member = false;
-        orig_members = ldb_msg_find_element(group, SYSDB_ORIG_MEMBER);
-        if (orig_members) {
-            for (i = 0; i < orig_members->num_values; i++) {
-                if (strcmp((const char *) orig_members->values[i].data,
-                            orig_dn) == 0) {
-                    /* This is a direct member. Add the member attribute */
-                    add_member = true;
-                }
-            }
-        } else {
-            /* Nothing to compare the originalDN with. Let's rely on the
-             * memberof plugin to do the right thing during initgroups..
-             */
-            add_member = true;
-        }
-    }
+    msg->dn = group_dn;
 
     if (add_member) {
         ret = sysdb_add_string(msg, SYSDB_MEMBER, userdn);
@@ -1899,6 +1974,51 @@ done:
     return ret;
 }
 
+static errno_t
+sysdb_remove_ghost_from_groups_filter(struct sss_domain_info *domain,
+                                      struct ldb_dn *base_dn,
+                                      const char *filter,
+                                      bool add_member,
+                                      struct ldb_message_element *alias_el,
+                                      const char *name,
+                                      const char *userdn)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message **groups;
+    /* Only the DNs are needed, the ghost and original member attributes of
+     * large groups can have many thousands of values. */
+    const char *group_attrs[] = { SYSDB_NAME, NULL };
+    size_t group_count = 0;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (!tmp_ctx) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_search_entry(tmp_ctx, domain->sysdb, base_dn,
+                             LDB_SCOPE_SUBTREE, filter, group_attrs,
+                             &group_count, &groups);
+    if (ret == ENOENT) {
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    for (i = 0; i < group_count; i++) {
+        sysdb_remove_ghost_from_group(domain, groups[i]->dn, add_member,
+                                      alias_el, name, userdn);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 static errno_t
 sysdb_remove_ghostattr_from_groups(struct sss_domain_info *domain,
                                    const char *orig_dn,
@@ -1906,15 +2026,15 @@ sysdb_remove_ghostattr_from_groups(struct sss_domain_info *domain,
                                    const char *name)
 {
     TALLOC_CTX *tmp_ctx;
-    struct ldb_message **groups;
     struct ldb_message_element *alias_el;
     struct ldb_dn *tmpdn;
-    const char *group_attrs[] = {SYSDB_NAME, SYSDB_GHOST, SYSDB_ORIG_MEMBER, NULL};
     const char *userdn;
     char *sanitized_name;
+    char *sanitized_dn;
+    char *ghost_filter;
+    char *member_filter;
     char *filter;
     errno_t ret = EOK;
-    size_t group_count = 0;
     int i;
 
     tmp_ctx = talloc_new(NULL);
@@ -1927,9 +2047,9 @@ sysdb_remove_ghostattr_from_groups(struct sss_domain_info *domain,
         goto done;
     }
 
-    filter = talloc_asprintf(tmp_ctx, "(|(%s=%s)",
-                                      SYSDB_GHOST, sanitized_name);
-    if (!filter) {
+    ghost_filter = talloc_asprintf(tmp_ctx, "(|(%s=%s)",
+                                   SYSDB_GHOST, sanitized_name);
+    if (!ghost_filter) {
         ret = ENOMEM;
         goto done;
     }
@@ -1942,16 +2062,24 @@ sysdb_remove_ghostattr_from_groups(struct sss_domain_info *domain,
         if (strcmp((const char *)alias_el->values[i].data, name) == 0) {
             continue;
         }
-        filter = talloc_asprintf_append(filter, "(%s=%s)",
-                                        SYSDB_GHOST, alias_el->values[i].data);
-        if (filter == NULL) {
+
+        ret = sss_filter_sanitize(tmp_ctx,
+                                  (const char *)alias_el->values[i].data,
+                                  &sanitized_name);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ghost_filter = talloc_asprintf_append(ghost_filter, "(%s=%s)",
+                                              SYSDB_GHOST, sanitized_name);
+        if (ghost_filter == NULL) {
             ret = ENOMEM;
             goto done;
         }
     }
 
-    filter = talloc_asprintf_append(filter, ")");
-    if (filter == NULL) {
+    ghost_filter = talloc_asprintf_append(ghost_filter, ")");
+    if (ghost_filter == NULL) {
         ret = ENOMEM;
         goto done;
     }
@@ -1979,18 +2107,48 @@ sysdb_remove_ghostattr_from_groups(struct sss_domain_info *domain,
      * Note that this object can be referred to either by its name or any
      * of its aliases
      */
-    ret = sysdb_search_entry(tmp_ctx, domain->sysdb, tmpdn, LDB_SCOPE_SUBTREE,
-                             filter, group_attrs, &group_count, &groups);
-    if (ret != EOK && ret != ENOENT) {
+    if (orig_dn == NULL) {
+        /* We have no way of telling which groups this user belongs to.
+         * Add it to all that reference it in the ghost attribute */
+        ret = sysdb_remove_ghost_from_groups_filter(domain, tmpdn,
+                                                    ghost_filter, true,
+                                                    alias_el, name, userdn);
         goto done;
     }
 
-    for (i = 0; i < group_count; i++) {
-        sysdb_remove_ghost_from_group(domain, groups[i], alias_el, name,
-                                      orig_dn, userdn);
+    ret = sss_filter_sanitize(tmp_ctx, orig_dn, &sanitized_dn);
+    if (ret != EOK) {
+        goto done;
     }
 
-    ret = EOK;
+    /* The user is a direct member of groups which list its originalDN. If a
+     * group has no original members at all, rely on the memberof plugin to
+     * do the right thing during initgroups. The comparison is done by ldb
+     * so that the member lists of large groups are never loaded. */
+    member_filter = talloc_asprintf(tmp_ctx, "(|(%s=%s)(!(%s=*)))",
+                                    SYSDB_ORIG_MEMBER, sanitized_dn,
+                                    SYSDB_ORIG_MEMBER);
+    if (member_filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    filter = talloc_asprintf(tmp_ctx, "(&%s%s)", ghost_filter, member_filter);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_remove_ghost_from_groups_filter(domain, tmpdn, filter, true,
+                                                alias_el, name, userdn);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* The direct parents do not have the ghost values anymore, the ones
+     * still found were inherited from nested groups and are only removed. */
+    ret = sysdb_remove_ghost_from_groups_filter(domain, tmpdn, ghost_filter,
+                                                false, alias_el, name, userdn);
 
 done:
     talloc_free(tmp_ctx);
@@ -2161,6 +2319,9 @@ int sysdb_add_user(struct sss_domain_info *domain,
                                   (now + cache_timeout) : 0));
     if (ret) goto done;
 
+    ret = sysdb_add_cache_generation(domain, attrs);
+    if (ret) goto done;
+
     ret = sysdb_set_user_attr(domain, name, attrs, SYSDB_MOD_REP);
     if (ret) goto done;
 
@@ -2398,6 +2559,12 @@ int sysdb_add_group(struct sss_domain_info *domain,
         goto done;
     }
 
+    ret = sysdb_add_cache_generation(domain, attrs);
+    if (ret) {
+        DEBUG(SSSDBG_TRACE_LIBS, "Failed to add the cache generation.\n");
+        goto done;
+    }
+
     ret = sysdb_set_group_attr(domain, name, attrs, SYSDB_MOD_REP);
     if (ret) {
         DEBUG(SSSDBG_TRACE_LIBS, "sysdb_set_group_attr failed.\n");
@@ -2918,6 +3085,9 @@ static errno_t sysdb_store_user_attrs(struct sss_domain_info *domain,
                                   (now + cache_timeout) : 0));
     if (ret) return ret;
 
+    ret = sysdb_add_cache_generation(domain, attrs);
+    if (ret) return ret;
+
     ret = sysdb_set_user_attr(domain, name, attrs, SYSDB_MOD_REP);
     if (ret) return ret;
 
@@ -3128,6 +3298,12 @@ static errno_t sysdb_store_group_attrs(struct sss_domain_info *domain,
         return ret;
     }
 
+    ret = sysdb_add_cache_generation(domain, attrs);
+    if (ret) {
+        DEBUG(SSSDBG_TRACE_LIBS, "Failed to add the cache generation.\n");
+        return ret;
+    }
+
     ret = sysdb_set_group_attr(domain, name, attrs, SYSDB_MOD_REP);
     if (ret) {
         DEBUG(SSSDBG_TRACE_LIBS, "sysdb_set_group_attr failed.\n");
@@ -3332,6 +3508,12 @@ static errno_t set_initgroups_expire_attribute(struct sss_domain_info *domain,
         goto done;
     }
 
+    ret = sysdb_add_cache_generation(domain, attrs);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not set up attrs\n");
+        goto done;
+    }
+
     ret = sysdb_set_user_attr(domain, name, attrs, SYSDB_MOD_REP);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -4693,6 +4875,7 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
                             "accountExpires", SYSDB_FAILED_LOGIN_ATTEMPTS,
                             SYSDB_LAST_FAILED_LOGIN, SYSDB_CACHEDPWD_TYPE,
                             SYSDB_CACHEDPWD_FA2_LEN, NULL };
+    const char *fa_attrs[] = { SYSDB_FAILED_LOGIN_ATTEMPTS, NULL };
     struct ldb_message *ldb_msg;
     const char *userhash;
     char *comphash;
@@ -4701,6 +4884,7 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
     uint32_t failed_login_attempts = 0;
     struct sysdb_attrs *update_attrs;
     bool authentication_successful = false;
+    bool in_transaction = false;
     time_t expire_date = -1;
     time_t delayed_until = -1;
     int ret;
@@ -4730,13 +4914,9 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
-    if (ret) {
-        talloc_zfree(tmp_ctx);
-        ret = sysdb_error_to_errno(ret);
-        return ret;
-    }
-
+    /* The password hash is computed outside of a transaction, so that the
+     * cache is not locked for the backend and the other responders while
+     * the CPU is busy with it. */
     ret = sysdb_search_user_by_name(tmp_ctx, domain, name, attrs, &ldb_msg);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -4796,13 +4976,6 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         goto done;
     }
 
-    update_attrs = sysdb_new_attrs(tmp_ctx);
-    if (update_attrs == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_new_attrs failed.\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
     if (strcmp(userhash, comphash) == 0
             || check_for_combined_2fa_password(domain, ldb_msg,
                                                password, userhash) == EOK) {
@@ -4814,7 +4987,26 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
             ret = EOK;
             goto done;
         }
+    } else {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Authentication failed.\n");
+        authentication_successful = false;
+    }
 
+    update_attrs = sysdb_new_attrs(tmp_ctx);
+    if (update_attrs == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_new_attrs failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_transaction_start(domain->sysdb->ldb);
+    if (ret) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+    in_transaction = true;
+
+    if (authentication_successful) {
         ret = sysdb_attrs_add_time_t(update_attrs,
                                      SYSDB_LAST_LOGIN, time(NULL));
         if (ret != EOK) {
@@ -4834,8 +5026,18 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         }
 
     } else {
-        DEBUG(SSSDBG_CONF_SETTINGS, "Authentication failed.\n");
-        authentication_successful = false;
+        /* Other logins might have failed while the hash was computed. */
+        ret = sysdb_search_user_by_name(tmp_ctx, domain, name, fa_attrs,
+                                        &ldb_msg);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "sysdb_search_user_by_name failed [%d][%s].\n",
+                  ret, strerror(ret));
+            goto done;
+        }
+        failed_login_attempts = ldb_msg_find_attr_as_uint(ldb_msg,
+                                                SYSDB_FAILED_LOGIN_ATTEMPTS,
+                                                failed_login_attempts);
 
         ret = sysdb_attrs_add_time_t(update_attrs,
                                      SYSDB_LAST_FAILED_LOGIN,
@@ -4868,13 +5070,15 @@ done:
     if (_delayed_until != NULL) {
         *_delayed_until = delayed_until;
     }
-    if (ret) {
-        ldb_transaction_cancel(domain->sysdb->ldb);
-    } else {
-        ret = ldb_transaction_commit(domain->sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+    if (in_transaction) {
         if (ret) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to commit transaction!\n");
+            ldb_transaction_cancel(domain->sysdb->ldb);
+        } else {
+            ret = ldb_transaction_commit(domain->sysdb->ldb);
+            ret = sysdb_error_to_errno(ret);
+            if (ret) {
+                DEBUG(SSSDBG_OP_FAILURE, "Failed to commit transaction!\n");
+            }
         }
     }
     if (authentication_successful) {
@@ -5794,3 +5998,212 @@ done:
     talloc_zfree(tmp_ctx);
     return ret;
 }
+
+errno_t sysdb_invalidate_cache_entries(struct sss_domain_info *domain,
+                                       struct ldb_message **msgs,
+                                       size_t count,
+                                       struct sysdb_attrs *attrs)
+{
+    struct sysdb_ctx *sysdb = domain->sysdb;
+    bool in_transaction = false;
+    bool in_ts_transaction = false;
+    errno_t ret;
+    errno_t sret;
+    int lret;
+    size_t i;
+
+    if (count == 0) {
+        return EOK;
+    }
+
+    ret = sysdb_transaction_start(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    /* Without this every modification of the timestamp cache would be
+     * committed, and synced to disk, on its own. */
+    if (sysdb->ldb_ts != NULL) {
+        lret = ldb_transaction_start(sysdb->ldb_ts);
+        if (lret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to start the timestamp cache transaction\n");
+            ret = sysdb_error_to_errno(lret);
+            goto done;
+        }
+        in_ts_transaction = true;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = sysdb_set_cache_entry_attr(sysdb->ldb, msgs[i]->dn,
+                                         attrs, SYSDB_MOD_REP);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot set attrs for %s, %d [%s]\n",
+                  ldb_dn_get_linearized(msgs[i]->dn), ret, sss_strerror(ret));
+            goto done;
+        }
+
+        if (in_ts_transaction) {
+            ret = sysdb_set_cache_entry_attr(sysdb->ldb_ts, msgs[i]->dn,
+                                             attrs, SYSDB_MOD_REP);
+            if (ret != EOK && ret != ENOENT) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Cannot set attrs in the timestamp cache for %s, "
+                      "%d [%s]\n", ldb_dn_get_linearized(msgs[i]->dn),
+                      ret, sss_strerror(ret));
+                goto done;
+            }
+        }
+    }
+
+    if (in_ts_transaction) {
+        lret = ldb_transaction_commit(sysdb->ldb_ts);
+        in_ts_transaction = false;
+        if (lret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to commit the timestamp cache transaction\n");
+            ret = sysdb_error_to_errno(lret);
+            goto done;
+        }
+    }
+
+    ret = sysdb_transaction_commit(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_FUNC_DATA, "%zu cache entries have been invalidated.\n",
+          count);
+
+done:
+    if (in_ts_transaction) {
+        ldb_transaction_cancel(sysdb->ldb_ts);
+    }
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+    return ret;
+}
+
+/* =Initgroups-Index====================================================== */
+
+errno_t sysdb_set_initgr_index(struct sss_domain_info *domain,
+                               struct ldb_result *res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = { SYSDB_MEMBEROF, NULL };
+    struct ldb_message **msgs;
+    struct ldb_message_element *el;
+    struct sysdb_attrs *index;
+    struct ldb_dn *dn;
+    hash_table_t *gids;
+    hash_key_t key;
+    hash_value_t value;
+    size_t count;
+    unsigned int i;
+    char *str;
+    errno_t ret;
+
+    if (res == NULL || res->count == 0) {
+        return EINVAL;
+    }
+
+    if (DOM_HAS_VIEWS(domain)) {
+        /* The index is not used with views. */
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_cache_search_entry(tmp_ctx, domain->sysdb->ldb,
+                                   res->msgs[0]->dn, LDB_SCOPE_BASE, NULL,
+                                   attrs, &count, &msgs);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    el = ldb_msg_find_element(msgs[0], SYSDB_MEMBEROF);
+    if (el == NULL || el->num_values == 0) {
+        /* A left over index does not match the empty memberof. */
+        ret = EOK;
+        goto done;
+    }
+
+    ret = sss_hash_create(tmp_ctx, res->count, &gids);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* The first message is the user. */
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_UINT;
+    for (i = 1; i < res->count; i++) {
+        key.str = discard_const(ldb_dn_get_casefold(res->msgs[i]->dn));
+        if (key.str == NULL) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        value.ui = ldb_msg_find_attr_as_uint(res->msgs[i], SYSDB_GIDNUM, 0);
+        ret = hash_enter(gids, &key, &value);
+        if (ret != HASH_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    index = sysdb_new_attrs(tmp_ctx);
+    if (index == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Keep the memberof values verbatim, the index is valid only as long as
+     * it covers exactly the same set of groups. Entries that did not match
+     * SYSDB_INITGR_FILTER are stored with 0. */
+    for (i = 0; i < el->num_values; i++) {
+        dn = ldb_dn_from_ldb_val(tmp_ctx, domain->sysdb->ldb, &el->values[i]);
+        if (dn == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        key.str = discard_const(ldb_dn_get_casefold(dn));
+        if (key.str == NULL || hash_lookup(gids, &key, &value) != HASH_SUCCESS) {
+            value.ui = 0;
+        }
+
+        str = talloc_asprintf(tmp_ctx, "%u:%.*s", value.ui,
+                              (int)el->values[i].length,
+                              (const char *)el->values[i].data);
+        if (str == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sysdb_attrs_add_string(index, SYSDB_INITGR_INDEX, str);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        talloc_free(dn);
+    }
+
+    ret = sysdb_set_entry_attr(domain->sysdb, res->msgs[0]->dn, index,
+                               SYSDB_MOD_REP);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
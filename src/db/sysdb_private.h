@@ -23,6 +23,7 @@
 #ifndef __INT_SYS_DB_H__
 #define __INT_SYS_DB_H__
 
+#define SYSDB_VERSION_0_23 "0.23"
 #define SYSDB_VERSION_0_22 "0.22"
 #define SYSDB_VERSION_0_21 "0.21"
 #define SYSDB_VERSION_0_20 "0.20"
@@ -46,7 +47,7 @@
 #define SYSDB_VERSION_0_2 "0.2"
 #define SYSDB_VERSION_0_1 "0.1"
 
-#define SYSDB_VERSION SYSDB_VERSION_0_22
+#define SYSDB_VERSION SYSDB_VERSION_0_23
 
 #define SYSDB_BASE_LDIF \
      "dn: @ATTRIBUTES\n" \
@@ -75,6 +76,7 @@
      "@IDXATTR: servicePort\n" \
      "@IDXATTR: serviceProtocol\n" \
      "@IDXATTR: sudoUser\n" \
+     "@IDXATTR: sudoUserIndex\n" \
      "@IDXATTR: sshKnownHostsExpire\n" \
      "@IDXATTR: objectSIDString\n" \
      "@IDXATTR: ghost\n" \
@@ -121,14 +123,41 @@
 
 #include "db/sysdb.h"
 
+/* lmdb keeps the reader table in a file next to the database */
+#define SYSDB_LMDB_LOCK_SUFFIX "-lock"
+
 struct sysdb_ctx {
     struct ldb_context *ldb;
     char *ldb_file;
 
+    /* ldb_file and ldb_ts_file with the prefix of the storage engine */
+    enum sss_cache_engine engine;
+    char *ldb_url;
+    char *ldb_ts_url;
+
+    /* if set, ldb_file is not kept across reboots and is copied here
+     * by sysdb_checkpoint() */
+    char *ldb_checkpoint_file;
+
     struct ldb_context *ldb_ts;
     char *ldb_ts_file;
 
     int transaction_nesting;
+
+    /* top-level transactions are committed together, see
+     * sysdb_set_write_batch() */
+    struct tevent_context *ev;
+    unsigned int batch_size;
+    unsigned int batch_count;
+    bool batch_open;
+    struct tevent_timer *batch_timer;
+
+    /* see sysdb_set_expire_notify() */
+    sysdb_expire_notify_fn expire_notify;
+    void *expire_notify_pvt;
+
+    /* override objects read by sysdb_add_overrides_to_object() */
+    struct sysdb_override_cache *override_cache;
 };
 
 /* Internal utility functions */
@@ -142,6 +171,9 @@ errno_t sysdb_ldb_connect(TALLOC_CTX *mem_ctx,
                           const char *filename,
                           int flags,
                           struct ldb_context **_ldb);
+char *sysdb_engine_url(TALLOC_CTX *mem_ctx,
+                       enum sss_cache_engine engine,
+                       const char *ldb_file);
 
 struct sysdb_dom_upgrade_ctx {
     struct sss_names_ctx *names; /* upgrade to 0.18 needs to parse names */
@@ -150,6 +182,7 @@ struct sysdb_dom_upgrade_ctx {
 int sysdb_domain_init_internal(TALLOC_CTX *mem_ctx,
                                struct sss_domain_info *domain,
                                const char *db_path,
+                               const char *volatile_db_path,
                                struct sysdb_dom_upgrade_ctx *upgrade_ctx,
                                struct sysdb_ctx **_ctx);
 
@@ -180,9 +213,19 @@ int sysdb_upgrade_18(struct sysdb_ctx *sysdb, const char **ver);
 int sysdb_upgrade_19(struct sysdb_ctx *sysdb, const char **ver);
 int sysdb_upgrade_20(struct sysdb_ctx *sysdb, const char **ver);
 int sysdb_upgrade_21(struct sysdb_ctx *sysdb, const char **ver);
+int sysdb_upgrade_22(struct sysdb_ctx *sysdb, const char **ver);
 
 int sysdb_ts_upgrade_01(struct sysdb_ctx *sysdb, const char **ver);
 
+errno_t sysdb_convert_engine(const char *ldb_file,
+                             enum sss_cache_engine from,
+                             enum sss_cache_engine to);
+
+/* Values of the sudoUserIndex attribute for the given sudoUser values. */
+errno_t sysdb_sudo_user_index_values(TALLOC_CTX *mem_ctx,
+                                     struct ldb_message_element *users,
+                                     const char ***_values);
+
 int sysdb_add_string(struct ldb_message *msg,
                      const char *attr, const char *value);
 int sysdb_replace_string(struct ldb_message *msg,
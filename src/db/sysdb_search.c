@@ -20,30 +20,59 @@
 */
 
 #include "util/util.h"
+#include "util/strtonum.h"
 #include "db/sysdb_private.h"
 #include "confdb/confdb.h"
 #include <time.h>
 #include <ctype.h>
 
+/* Number of DNs looked up in the timestamp cache with one search */
+#define SYSDB_TS_MERGE_CHUNK 100
+
 /* helpers */
+
+/* Return the timestamp cache attributes that are to be merged into results
+ * of a search for attrs, the list is empty if there is nothing to merge. */
+static const char **ts_merge_attrs(TALLOC_CTX *mem_ctx,
+                                   const char *attrs[])
+{
+    const char **ts_attrs;
+    size_t count;
+    size_t c;
+    size_t n;
+
+    for (count = 0; sysdb_ts_cache_attrs[count] != NULL; count++);
+
+    ts_attrs = talloc_zero_array(mem_ctx, const char *, count + 1);
+    if (ts_attrs == NULL) {
+        return NULL;
+    }
+
+    /* Deliberately start from 2 in order to not merge
+     * objectclass/objectcategory and avoid breaking MPGs where the OC might
+     * be made up
+     */
+    for (c = 2, n = 0; sysdb_ts_cache_attrs[c] != NULL; c++) {
+        /* Without attrs all ts attrs are merged */
+        if (attrs == NULL
+                || string_in_list(sysdb_ts_cache_attrs[c],
+                                  discard_const(attrs), true)) {
+            ts_attrs[n] = sysdb_ts_cache_attrs[c];
+            n++;
+        }
+    }
+
+    return ts_attrs;
+}
+
 static errno_t merge_ts_attr(struct ldb_message *ts_msg,
                              struct ldb_message *sysdb_msg,
-                             const char *ts_attr,
-                             const char *want_attrs[])
+                             const char *ts_attr)
 {
     errno_t ret;
-    bool include = true;
     struct ldb_message_element *ts_el;
     struct ldb_message_element *sysdb_el;
 
-    if (want_attrs != NULL) {
-        /* Otherwise merge all ts attrs */
-        include = string_in_list(ts_attr, discard_const(want_attrs), true);
-    }
-    if (include == false) {
-        return EOK;
-    }
-
     ts_el = ldb_msg_find_element(ts_msg, ts_attr);
     if (ts_el == NULL || ts_el->num_values == 0) {
         return EOK;
@@ -68,22 +97,18 @@ static errno_t merge_ts_attr(struct ldb_message *ts_msg,
     return EOK;
 }
 
+/* ts_attrs is a list returned by ts_merge_attrs() */
 static errno_t merge_all_ts_attrs(struct ldb_message *ts_msg,
                                   struct ldb_message *sysdb_msg,
-                                  const char *want_attrs[])
+                                  const char *ts_attrs[])
 {
     int ret;
 
-    /* Deliberately start from 2 in order to not merge
-     * objectclass/objectcategory and avoid breaking MPGs where the OC might
-     * be made up
-     */
-    for (size_t c = 2; sysdb_ts_cache_attrs[c]; c++) {
-        ret = merge_ts_attr(ts_msg, sysdb_msg,
-                            sysdb_ts_cache_attrs[c], want_attrs);
+    for (size_t c = 0; ts_attrs[c]; c++) {
+        ret = merge_ts_attr(ts_msg, sysdb_msg, ts_attrs[c]);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
-                  "Cannot merge ts attr %s\n", sysdb_ts_cache_attrs[c]);
+                  "Cannot merge ts attr %s\n", ts_attrs[c]);
             return ret;
         }
     }
@@ -93,7 +118,7 @@ static errno_t merge_all_ts_attrs(struct ldb_message *ts_msg,
 
 static errno_t merge_msg_ts_attrs(struct sysdb_ctx *sysdb,
                                   struct ldb_message *sysdb_msg,
-                                  const char *attrs[])
+                                  const char *ts_attrs[])
 {
     errno_t ret;
     TALLOC_CTX *tmp_ctx;
@@ -114,7 +139,7 @@ static errno_t merge_msg_ts_attrs(struct sysdb_ctx *sysdb,
     ret = sysdb_search_ts_entry(tmp_ctx, sysdb, sysdb_msg->dn,
                                 LDB_SCOPE_BASE,
                                 NULL,
-                                sysdb_ts_cache_attrs,
+                                ts_attrs,
                                 &msgs_count,
                                 &ts_msgs);
     if (ret == ENOENT) {
@@ -137,17 +162,158 @@ static errno_t merge_msg_ts_attrs(struct sysdb_ctx *sysdb,
         return EIO;
     }
 
-    ret = merge_all_ts_attrs(ts_msgs[0], sysdb_msg, attrs);
+    ret = merge_all_ts_attrs(ts_msgs[0], sysdb_msg, ts_attrs);
 done:
     talloc_zfree(tmp_ctx);
     return ret;
 }
 
+/* Look up the timestamp cache entries of up to SYSDB_TS_MERGE_CHUNK messages
+ * with a single search for their DNs. */
+static errno_t merge_msgs_ts_attrs_chunk(struct sysdb_ctx *sysdb,
+                                         size_t count,
+                                         struct ldb_message **msgs,
+                                         const char *ts_attrs[])
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message **ts_msgs;
+    hash_table_t *ts_idx;
+    hash_key_t key;
+    hash_value_t value;
+    size_t ts_count;
+    size_t num_dns = 0;
+    char *clean_dn;
+    char *filter;
+    size_t c;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    filter = talloc_strdup(tmp_ctx, "(|");
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (c = 0; c < count; c++) {
+        if (!is_ts_ldb_dn(msgs[c]->dn)) {
+            continue;
+        }
+
+        ret = sss_filter_sanitize(tmp_ctx, ldb_dn_get_linearized(msgs[c]->dn),
+                                  &clean_dn);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        filter = talloc_asprintf_append(filter, "(%s=%s)", SYSDB_DN, clean_dn);
+        if (filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        talloc_free(clean_dn);
+        num_dns++;
+    }
+
+    if (num_dns == 0) {
+        ret = EOK;
+        goto done;
+    }
+
+    filter = talloc_asprintf_append(filter, ")");
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_search_ts_entry(tmp_ctx, sysdb, NULL, LDB_SCOPE_SUBTREE,
+                                filter, ts_attrs, &ts_count, &ts_msgs);
+    if (ret == ENOENT) {
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_hash_create(tmp_ctx, ts_count, &ts_idx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_ULONG;
+    for (c = 0; c < ts_count; c++) {
+        key.str = discard_const(ldb_dn_get_casefold(ts_msgs[c]->dn));
+        if (key.str == NULL) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        value.ul = c;
+        ret = hash_enter(ts_idx, &key, &value);
+        if (ret != HASH_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    for (c = 0; c < count; c++) {
+        key.str = discard_const(ldb_dn_get_casefold(msgs[c]->dn));
+        if (key.str == NULL
+                || hash_lookup(ts_idx, &key, &value) != HASH_SUCCESS) {
+            /* Not handled by or missing in the timestamp cache */
+            continue;
+        }
+
+        ret = merge_all_ts_attrs(ts_msgs[value.ul], msgs[c], ts_attrs);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot merge timestamp cache values for %s\n",
+                  ldb_dn_get_linearized(msgs[c]->dn));
+            /* non-fatal */
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Merge the timestamps of many messages with a few searches instead of one
+ * base search per message. Errors are not fatal, the messages just keep the
+ * timestamps of the persistent cache. */
+static void merge_msgs_ts_attrs(struct sysdb_ctx *sysdb,
+                                size_t count,
+                                struct ldb_message **msgs,
+                                const char *ts_attrs[])
+{
+    size_t chunk;
+    size_t c;
+    errno_t ret;
+
+    for (c = 0; c < count; c += chunk) {
+        chunk = MIN(count - c, SYSDB_TS_MERGE_CHUNK);
+
+        ret = merge_msgs_ts_attrs_chunk(sysdb, chunk, &msgs[c], ts_attrs);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot merge timestamp cache values [%d]: %s\n",
+                  ret, sss_strerror(ret));
+        }
+    }
+}
+
 static errno_t merge_msg_sysdb_attrs(TALLOC_CTX *mem_ctx,
                                      struct sysdb_ctx *sysdb,
                                      struct ldb_message *ts_msg,
                                      struct ldb_message **_sysdb_msg,
-                                     const char *attrs[])
+                                     const char *attrs[],
+                                     const char *ts_attrs[])
 {
     errno_t ret;
     TALLOC_CTX *tmp_ctx;
@@ -171,7 +337,7 @@ static errno_t merge_msg_sysdb_attrs(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = merge_all_ts_attrs(ts_msg, sysdb_msgs[0], attrs);
+    ret = merge_all_ts_attrs(ts_msg, sysdb_msgs[0], ts_attrs);
     if (ret != EOK) {
         goto done;
     }
@@ -186,14 +352,32 @@ errno_t sysdb_merge_res_ts_attrs(struct sysdb_ctx *ctx,
                                  struct ldb_result *res,
                                  const char *attrs[])
 {
+    const char **ts_attrs;
     errno_t ret;
 
-    if (res == NULL || ctx->ldb_ts == NULL) {
+    if (res == NULL || res->count == 0 || ctx->ldb_ts == NULL) {
+        return EOK;
+    }
+
+    ts_attrs = ts_merge_attrs(NULL, attrs);
+    if (ts_attrs == NULL) {
+        return ENOMEM;
+    }
+
+    if (ts_attrs[0] == NULL) {
+        /* No timestamp was requested, skip the lookups. */
+        talloc_free(ts_attrs);
+        return EOK;
+    }
+
+    if (res->count > 1) {
+        merge_msgs_ts_attrs(ctx, res->count, res->msgs, ts_attrs);
+        talloc_free(ts_attrs);
         return EOK;
     }
 
     for (size_t c = 0; c < res->count; c++) {
-        ret = merge_msg_ts_attrs(ctx, res->msgs[c], attrs);
+        ret = merge_msg_ts_attrs(ctx, res->msgs[c], ts_attrs);
         if (ret == ERR_NO_TS) {
             DEBUG(SSSDBG_TRACE_INTERNAL,
                   "TS cache doesn't handle this DN type, skipping\n");
@@ -211,6 +395,7 @@ errno_t sysdb_merge_res_ts_attrs(struct sysdb_ctx *ctx,
         }
     }
 
+    talloc_free(ts_attrs);
     return EOK;
 }
 
@@ -222,6 +407,7 @@ static errno_t merge_res_sysdb_attrs(TALLOC_CTX *mem_ctx,
 {
     errno_t ret;
     struct ldb_result *ts_cache_res = NULL;
+    const char **ts_attrs;
 
     if (ts_res == NULL || ctx->ldb_ts == NULL) {
         return EOK;
@@ -231,6 +417,13 @@ static errno_t merge_res_sysdb_attrs(TALLOC_CTX *mem_ctx,
     if (ts_cache_res == NULL) {
         return ENOMEM;
     }
+
+    ts_attrs = ts_merge_attrs(ts_cache_res, attrs);
+    if (ts_attrs == NULL) {
+        talloc_free(ts_cache_res);
+        return ENOMEM;
+    }
+
     ts_cache_res->count = ts_res->count;
     ts_cache_res->msgs = talloc_zero_array(ts_cache_res,
                                            struct ldb_message *,
@@ -244,7 +437,7 @@ static errno_t merge_res_sysdb_attrs(TALLOC_CTX *mem_ctx,
         ret = merge_msg_sysdb_attrs(ts_cache_res->msgs,
                                     ctx,
                                     ts_res->msgs[c],
-                                    &ts_cache_res->msgs[c], attrs);
+                                    &ts_cache_res->msgs[c], attrs, ts_attrs);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
                   "Cannot merge sysdb cache values for %s\n",
@@ -635,6 +828,133 @@ done:
     return ret;
 }
 
+/* Merge the results of the same search in the timestamp cache and in the
+ * persistent cache in one pass. Entries found in both caches take the
+ * timestamps from ts_msgs, the others are completed with a lookup in the
+ * other cache. */
+static errno_t merge_search_ts_results(struct sysdb_ctx *sysdb,
+                                       struct ldb_result *res,
+                                       size_t ts_count,
+                                       struct ldb_message **ts_msgs,
+                                       const char *attrs[],
+                                       const char *ts_attrs[])
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_message **msgs;
+    struct ldb_message **unmatched;
+    struct ldb_message *msg;
+    hash_table_t *ts_idx;
+    hash_key_t key;
+    hash_value_t value;
+    bool *merged;
+    size_t num_unmatched;
+    size_t count;
+    size_t c;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    merged = talloc_zero_array(tmp_ctx, bool, ts_count);
+    if (merged == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_hash_create(tmp_ctx, ts_count, &ts_idx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_ULONG;
+    for (c = 0; c < ts_count; c++) {
+        key.str = discard_const(ldb_dn_get_casefold(ts_msgs[c]->dn));
+        if (key.str == NULL) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        value.ul = c;
+        ret = hash_enter(ts_idx, &key, &value);
+        if (ret != HASH_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    unmatched = talloc_array(tmp_ctx, struct ldb_message *, res->count);
+    if (unmatched == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    num_unmatched = 0;
+    for (c = 0; c < res->count; c++) {
+        key.str = discard_const(ldb_dn_get_casefold(res->msgs[c]->dn));
+        if (key.str == NULL
+                || hash_lookup(ts_idx, &key, &value) != HASH_SUCCESS) {
+            unmatched[num_unmatched] = res->msgs[c];
+            num_unmatched++;
+            continue;
+        }
+
+        merged[value.ul] = true;
+        ret = merge_all_ts_attrs(ts_msgs[value.ul], res->msgs[c], ts_attrs);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot merge timestamp cache values for %s\n",
+                  ldb_dn_get_linearized(res->msgs[c]->dn));
+            /* non-fatal */
+        }
+    }
+
+    /* Persistent cache matches whose timestamps do not match the filter */
+    if (num_unmatched > 0 && ts_attrs[0] != NULL) {
+        merge_msgs_ts_attrs(sysdb, num_unmatched, unmatched, ts_attrs);
+    }
+
+    msgs = talloc_realloc(res, res->msgs, struct ldb_message *,
+                          res->count + ts_count);
+    if (msgs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    res->msgs = msgs;
+
+    /* Entries whose timestamps match the filter but the persistent
+     * attributes do not. */
+    count = res->count;
+    for (c = 0; c < ts_count; c++) {
+        if (merged[c]) {
+            continue;
+        }
+
+        msg = NULL;
+        ret = merge_msg_sysdb_attrs(res->msgs, sysdb, ts_msgs[c], &msg,
+                                    attrs, ts_attrs);
+        if (ret != EOK || msg == NULL) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot merge sysdb cache values for %s\n",
+                  ldb_dn_get_linearized(ts_msgs[c]->dn));
+            /* non-fatal */
+            continue;
+        }
+
+        res->msgs[count] = msg;
+        count++;
+    }
+    res->count = count;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t sysdb_search_with_ts_attr(TALLOC_CTX *mem_ctx,
                                   struct sss_domain_info *domain,
                                   struct ldb_dn *base_dn,
@@ -649,7 +969,9 @@ errno_t sysdb_search_with_ts_attr(TALLOC_CTX *mem_ctx,
     errno_t ret;
     struct ldb_message **ts_msgs = NULL;
     struct ldb_result *ts_cache_res = NULL;
-    size_t ts_count;
+    const char **ts_attrs;
+    size_t ts_count = 0;
+    size_t count;
 
     if (filter == NULL) {
         return EINVAL;
@@ -667,33 +989,25 @@ errno_t sysdb_search_with_ts_attr(TALLOC_CTX *mem_ctx,
     }
 
     switch (search_cache) {
-    case SYSDB_CACHE_TYPE_PERSISTENT: {
+    case SYSDB_CACHE_TYPE_PERSISTENT:
         /* We only care about searching the persistent db */
-        ts_cache_res = talloc_zero(tmp_ctx, struct ldb_result);
-        if (ts_cache_res == NULL) {
-            ret = ENOMEM;
+        ret = sysdb_search_entry(res, domain->sysdb, base_dn, scope,
+                                 filter, attrs, &count, &res->msgs);
+        if (ret == ENOENT) {
+            count = 0;
+        } else if (ret != EOK) {
             goto done;
         }
-        ts_cache_res->count = 0;
-        ts_cache_res->msgs = NULL;
+        res->count = count; /* Just to cleanly assign size_t to unsigned */
 
         break;
-    }
 
-    case SYSDB_CACHE_TYPE_TIMESTAMP:
-        /* FALLTHOUGH*/
-        SSS_ATTRIBUTE_FALLTHROUGH;
-    default: {
-        /* Because the timestamp database does not contain all the
-         * attributes, we need to search the persistent db for each
-         * of the entries found and merge the results
+    case SYSDB_CACHE_TYPE_TIMESTAMP: {
+        /* The filter only contains timestamp attrs, no need to search the
+         * persistent db
          */
         struct ldb_result ts_res;
 
-        /* We assume that some of the attributes are more up-to-date in
-         * timestamps db and we're supposed to search by them, so let's
-         * first search the timestamp db
-         */
         ret = sysdb_search_ts_entry(tmp_ctx, domain->sysdb, base_dn,
                                     scope, filter, attrs,
                                     &ts_count, &ts_msgs);
@@ -717,15 +1031,6 @@ errno_t sysdb_search_with_ts_attr(TALLOC_CTX *mem_ctx,
             goto done;
         }
 
-        break;
-    }
-    }
-
-    switch (search_cache) {
-    case SYSDB_CACHE_TYPE_TIMESTAMP: {
-        /* The filter only contains timestamp attrs, no need to search the
-         * persistent db
-         */
         if (ts_cache_res) {
             res->count = ts_cache_res->count;
             res->msgs = talloc_steal(res, ts_cache_res->msgs);
@@ -734,33 +1039,47 @@ errno_t sysdb_search_with_ts_attr(TALLOC_CTX *mem_ctx,
         break;
     }
 
-    case SYSDB_CACHE_TYPE_PERSISTENT:
-        /* FALLTHOUGH*/
-        SSS_ATTRIBUTE_FALLTHROUGH;
-    default: {
-        /* Because some of the attributes being searched might exist in the persistent
-         * database only, we also search the persistent db
+    default:
+        /* Some of the attributes being searched might be more up-to-date
+         * in the timestamps db and some might exist in the persistent db
+         * only, so both are searched. Only the requested timestamp
+         * attributes are read and the results are merged in one pass.
          */
-        size_t count;
+        ts_attrs = ts_merge_attrs(tmp_ctx, attrs);
+        if (ts_attrs == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
 
-        ret = sysdb_search_entry(res, domain->sysdb, base_dn, scope,
-                                 filter, attrs, &count, &res->msgs);
+        ret = sysdb_search_ts_entry(tmp_ctx, domain->sysdb, base_dn,
+                                    scope, filter, ts_attrs,
+                                    &ts_count, &ts_msgs);
         if (ret == ENOENT) {
-            res->count = 0;
+            ts_count = 0;
         } else if (ret != EOK) {
             goto done;
         }
-        res->count = count; /* Just to cleanly assign size_t to unsigned */
 
-        res = sss_merge_ldb_results(res, ts_cache_res);
-        if (res == NULL) {
-            ret = ENOMEM;
+        ret = sysdb_cache_search_entry(res, domain->sysdb->ldb, base_dn,
+                                       scope, filter, attrs,
+                                       &count, &res->msgs);
+        if (ret == ENOENT) {
+            count = 0;
+        } else if (ret != EOK) {
             goto done;
         }
+        res->count = count; /* Just to cleanly assign size_t to unsigned */
+
+        if (domain->sysdb->ldb_ts != NULL) {
+            ret = merge_search_ts_results(domain->sysdb, res, ts_count,
+                                          ts_msgs, attrs, ts_attrs);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
 
         break;
     }
-    }
 
     *_res = talloc_steal(mem_ctx, res);
     ret = EOK;
@@ -823,14 +1142,14 @@ done:
     return ret;
 }
 
-int sysdb_enumpwent_filter(TALLOC_CTX *mem_ctx,
-                           struct sss_domain_info *domain,
-                           const char *name_filter,
-                           const char *addtl_filter,
-                           struct ldb_result **_res)
+static int sysdb_enumpwent_filter_attrs(TALLOC_CTX *mem_ctx,
+                                        struct sss_domain_info *domain,
+                                        const char **attrs,
+                                        const char *name_filter,
+                                        const char *addtl_filter,
+                                        struct ldb_result **_res)
 {
     TALLOC_CTX *tmp_ctx;
-    static const char *attrs[] = SYSDB_PW_ATTRS;
     char *filter = NULL;
     char *dn_filter = NULL;
     const char *ts_filter = NULL;
@@ -917,6 +1236,18 @@ done:
     return ret;
 }
 
+int sysdb_enumpwent_filter(TALLOC_CTX *mem_ctx,
+                           struct sss_domain_info *domain,
+                           const char *name_filter,
+                           const char *addtl_filter,
+                           struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_PW_ATTRS;
+
+    return sysdb_enumpwent_filter_attrs(mem_ctx, domain, attrs, name_filter,
+                                        addtl_filter, _res);
+}
+
 int sysdb_enumpwent(TALLOC_CTX *mem_ctx,
                     struct sss_domain_info *domain,
                     struct ldb_result **_res)
@@ -1415,14 +1746,14 @@ int sysdb_getgrgid(TALLOC_CTX *mem_ctx,
     return sysdb_getgrgid_attrs(mem_ctx, domain, gid, NULL, _res);
 }
 
-int sysdb_enumgrent_filter(TALLOC_CTX *mem_ctx,
-                           struct sss_domain_info *domain,
-                           const char *name_filter,
-                           const char *addtl_filter,
-                           struct ldb_result **_res)
+static int sysdb_enumgrent_filter_attrs(TALLOC_CTX *mem_ctx,
+                                        struct sss_domain_info *domain,
+                                        const char **attrs,
+                                        const char *name_filter,
+                                        const char *addtl_filter,
+                                        struct ldb_result **_res)
 {
     TALLOC_CTX *tmp_ctx;
-    static const char *attrs[] = SYSDB_GRSRC_ATTRS;
     const char *filter = NULL;
     const char *ts_filter = NULL;
     const char *base_filter;
@@ -1526,6 +1857,18 @@ done:
     return ret;
 }
 
+int sysdb_enumgrent_filter(TALLOC_CTX *mem_ctx,
+                           struct sss_domain_info *domain,
+                           const char *name_filter,
+                           const char *addtl_filter,
+                           struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_GRSRC_ATTRS;
+
+    return sysdb_enumgrent_filter_attrs(mem_ctx, domain, attrs, name_filter,
+                                        addtl_filter, _res);
+}
+
 int sysdb_enumgrent(TALLOC_CTX *mem_ctx,
                     struct sss_domain_info *domain,
                     struct ldb_result **_res)
@@ -1592,6 +1935,140 @@ int sysdb_enumgrent_with_views(TALLOC_CTX *mem_ctx,
     return sysdb_enumgrent_filter_with_views(mem_ctx, domain, NULL, NULL, _res);
 }
 
+int sysdb_enumpwent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_ENUM_NAME_ATTRS;
+
+    return sysdb_enumpwent_filter_attrs(mem_ctx, domain, attrs, NULL, NULL,
+                                        _res);
+}
+
+int sysdb_enumgrent_names(TALLOC_CTX *mem_ctx,
+                          struct sss_domain_info *domain,
+                          struct ldb_result **_res)
+{
+    static const char *attrs[] = SYSDB_ENUM_NAME_ATTRS;
+
+    return sysdb_enumgrent_filter_attrs(mem_ctx, domain, attrs, NULL, NULL,
+                                        _res);
+}
+
+static errno_t sysdb_enum_load(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               bool groups,
+                               struct ldb_message **names,
+                               size_t count,
+                               struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *pw_attrs[] = SYSDB_PW_ATTRS;
+    static const char *gr_attrs[] = SYSDB_GRSRC_ATTRS;
+    const char **attrs;
+    struct ldb_message **msgs;
+    struct ldb_result *res;
+    size_t msgs_count;
+    size_t c;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    attrs = groups ? gr_attrs : pw_attrs;
+
+    res = talloc_zero(tmp_ctx, struct ldb_result);
+    if (res == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    res->msgs = talloc_zero_array(res, struct ldb_message *, count + 1);
+    if (res->msgs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (c = 0; c < count; c++) {
+        ret = sysdb_search_entry(tmp_ctx, domain->sysdb, names[c]->dn,
+                                 LDB_SCOPE_BASE, NULL, attrs,
+                                 &msgs_count, &msgs);
+        if (ret == ENOENT) {
+            /* The entry was removed since the names were read. */
+            continue;
+        } else if (ret != EOK) {
+            goto done;
+        }
+
+        res->msgs[res->count] = talloc_steal(res->msgs, msgs[0]);
+        res->count++;
+        talloc_free(msgs);
+    }
+
+    if (groups) {
+        ret = mpg_res_convert(res);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    /* Merge in the timestamps from the fast ts db */
+    ret = sysdb_merge_res_ts_attrs(domain->sysdb, res, attrs);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cannot merge timestamp cache values\n");
+        /* non-fatal */
+    }
+
+    for (c = 0; c < res->count; c++) {
+        if (DOM_HAS_VIEWS(domain)) {
+            ret = sysdb_add_overrides_to_object(domain, res->msgs[c], NULL,
+                                                NULL);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE,
+                      "sysdb_add_overrides_to_object failed.\n");
+                goto done;
+            }
+        }
+
+        if (groups) {
+            ret = sysdb_add_group_member_overrides(domain, res->msgs[c],
+                                                   DOM_HAS_VIEWS(domain));
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE,
+                      "sysdb_add_group_member_overrides failed.\n");
+                goto done;
+            }
+        }
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sysdb_enum_load_users(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domain,
+                              struct ldb_message **names,
+                              size_t count,
+                              struct ldb_result **_res)
+{
+    return sysdb_enum_load(mem_ctx, domain, false, names, count, _res);
+}
+
+errno_t sysdb_enum_load_groups(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               struct ldb_message **names,
+                               size_t count,
+                               struct ldb_result **_res)
+{
+    return sysdb_enum_load(mem_ctx, domain, true, names, count, _res);
+}
+
 int sysdb_initgroups(TALLOC_CTX *mem_ctx,
                      struct sss_domain_info *domain,
                      const char *name,
@@ -1870,6 +2347,148 @@ done:
     return ret;
 }
 
+errno_t sysdb_initgroups_gids(TALLOC_CTX *mem_ctx,
+                              struct sss_domain_info *domain,
+                              const char *name,
+                              struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = { SYSDB_MEMBEROF, SYSDB_INITGR_INDEX, NULL };
+    struct ldb_result *res;
+    struct ldb_message **msgs;
+    struct ldb_message **groups;
+    struct ldb_message_element *memberof;
+    struct ldb_message_element *index;
+    struct ldb_message *msg;
+    hash_table_t *dns;
+    hash_key_t key;
+    hash_value_t value;
+    const char *str;
+    char *endptr;
+    uint32_t gid;
+    size_t count;
+    unsigned int num;
+    unsigned int i;
+    errno_t ret;
+
+    if (DOM_HAS_VIEWS(domain)) {
+        return ENOENT;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_getpwnam(tmp_ctx, domain, name, &res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (res->count != 1) {
+        /* Let sysdb_initgroups() deal with it. */
+        ret = ENOENT;
+        goto done;
+    }
+
+    ret = sysdb_cache_search_entry(tmp_ctx, domain->sysdb->ldb,
+                                   res->msgs[0]->dn, LDB_SCOPE_BASE, NULL,
+                                   attrs, &count, &msgs);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    memberof = ldb_msg_find_element(msgs[0], SYSDB_MEMBEROF);
+    index = ldb_msg_find_element(msgs[0], SYSDB_INITGR_INDEX);
+    if (memberof == NULL || index == NULL
+            || memberof->num_values != index->num_values) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    ret = sss_hash_create(tmp_ctx, memberof->num_values, &dns);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_UNDEF;
+    for (i = 0; i < memberof->num_values; i++) {
+        key.str = (char *)memberof->values[i].data;
+        ret = hash_enter(dns, &key, &value);
+        if (ret != HASH_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    groups = talloc_array(res, struct ldb_message *, index->num_values + 1);
+    if (groups == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    groups[0] = talloc_steal(groups, res->msgs[0]);
+    num = 1;
+
+    for (i = 0; i < index->num_values; i++) {
+        str = (const char *)index->values[i].data;
+
+        errno = 0;
+        gid = strtouint32(str, &endptr, 10);
+        if (errno != 0 || endptr == str || *endptr != ':') {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Malformed initgroups index value "
+                  "[%s] of [%s]\n", str, name);
+            ret = ENOENT;
+            goto done;
+        }
+
+        /* Every group must still be in memberof exactly once, otherwise
+         * the memberships changed since the index was stored. */
+        key.str = endptr + 1;
+        if (hash_delete(dns, &key) != HASH_SUCCESS) {
+            ret = ENOENT;
+            goto done;
+        }
+
+        if (gid == 0) {
+            continue;
+        }
+
+        msg = ldb_msg_new(groups);
+        if (msg == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        msg->dn = ldb_dn_new(msg, domain->sysdb->ldb, endptr + 1);
+        if (msg->dn == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = ldb_msg_add_fmt(msg, SYSDB_GIDNUM, "%"PRIu32, gid);
+        if (ret != LDB_SUCCESS) {
+            ret = sysdb_error_to_errno(ret);
+            goto done;
+        }
+
+        groups[num] = msg;
+        num++;
+    }
+
+    talloc_free(res->msgs);
+    res->msgs = groups;
+    res->count = num;
+
+    *_res = talloc_steal(mem_ctx, res);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 int sysdb_get_user_attr(TALLOC_CTX *mem_ctx,
                         struct sss_domain_info *domain,
                         const char *name,
@@ -2616,7 +3235,10 @@ done:
 struct ldb_result *sss_merge_ldb_results(struct ldb_result *sysdb_res,
                                          struct ldb_result *ts_res)
 {
-    size_t i, ii, count, total;
+    size_t i, count, total;
+    hash_table_t *idx;
+    hash_key_t key;
+    hash_value_t value;
     int ret;
 
     if (ts_res == NULL || ts_res->count == 0) {
@@ -2631,26 +3253,42 @@ struct ldb_result *sss_merge_ldb_results(struct ldb_result *sysdb_res,
         return NULL;
     }
 
-    /* FIXME - this is O(2), so inefficient for large sets! */
+    ret = sss_hash_create(NULL, sysdb_res->count, &idx);
+    if (ret != EOK) {
+        return NULL;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_ULONG;
+    for (i = 0; i < sysdb_res->count; i++) {
+        key.str = discard_const(ldb_dn_get_casefold(sysdb_res->msgs[i]->dn));
+        value.ul = i;
+        if (key.str == NULL || hash_enter(idx, &key, &value) != HASH_SUCCESS) {
+            talloc_free(idx);
+            return NULL;
+        }
+    }
+
     count = sysdb_res->count;
     for (i = 0; i < ts_res->count; i++) {
-        for (ii = 0; ii < sysdb_res->count; ii++) {
-            ret = ldb_dn_compare(ts_res->msgs[i]->dn, sysdb_res->msgs[ii]->dn);
-            if (ret == 0) {
-                break;
-            }
+        key.str = discard_const(ldb_dn_get_casefold(ts_res->msgs[i]->dn));
+        if (key.str == NULL) {
+            talloc_free(idx);
+            return NULL;
         }
 
-        if (ii < sysdb_res->count) {
+        if (hash_lookup(idx, &key, &value) == HASH_SUCCESS) {
             /* We already have this DN but ts_res might be more up-to-date
              * wrt timestamps  */
-            sysdb_res->msgs[ii] = talloc_steal(sysdb_res, ts_res->msgs[i]);
+            sysdb_res->msgs[value.ul] = talloc_steal(sysdb_res,
+                                                     ts_res->msgs[i]);
             continue;
         }
         /* new DN, merge */
         sysdb_res->msgs[count] = talloc_steal(sysdb_res, ts_res->msgs[i]);
         count++;
     }
+    talloc_free(idx);
 
     if (count < total) {
         sysdb_res->msgs = talloc_realloc(sysdb_res, sysdb_res->msgs,
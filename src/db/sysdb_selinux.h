@@ -36,6 +36,10 @@
 #define SYSDB_SELINUX_DEFAULT_ORDER "order"
 #define SYSDB_SELINUX_HOST_PRIORITY "hostPriority"
 
+/* SELinux user and MLS range last written to the login mappings of the host
+ * for a user, stored in the user entry. */
+#define SYSDB_SELINUX_LOGIN_LABEL "selinuxLoginLabel"
+
 errno_t sysdb_store_selinux_usermap(struct sss_domain_info *domain,
                                     struct sysdb_attrs *attrs);
 
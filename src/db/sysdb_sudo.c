@@ -26,6 +26,7 @@
 #include "db/sysdb.h"
 #include "db/sysdb_private.h"
 #include "db/sysdb_sudo.h"
+#include "shared/murmurhash3.h"
 
 #define SUDO_ALL_FILTER "(" SYSDB_OBJECTCLASS "=" SYSDB_SUDO_CACHE_OC ")"
 
@@ -237,7 +238,7 @@ sysdb_sudo_filter_userinfo(TALLOC_CTX *mem_ctx,
                            char **groupnames,
                            uid_t uid)
 {
-    const char *attr = SYSDB_SUDO_CACHE_AT_USER;
+    const char *attr = SYSDB_SUDO_CACHE_AT_USER_INDEX;
     TALLOC_CTX *tmp_ctx;
     char *sanitized_name;
     char *filter;
@@ -319,12 +320,13 @@ sysdb_sudo_filter_expired(TALLOC_CTX *mem_ctx,
 
     now = time(NULL);
     filter = talloc_asprintf(mem_ctx,
-                             "(&(%s=%s)(%s<=%lld)(|(%s=defaults)%s(%s=+*)))",
+                             "(&(%s=%s)(%s<=%lld)(|(%s=defaults)%s(%s=%s)))",
                              SYSDB_OBJECTCLASS, SYSDB_SUDO_CACHE_OC,
                              SYSDB_CACHE_EXPIRE, (long long)now,
                              SYSDB_NAME,
                              userfilter,
-                             SYSDB_SUDO_CACHE_AT_USER);
+                             SYSDB_SUDO_CACHE_AT_USER_INDEX,
+                             SYSDB_SUDO_USER_INDEX_NETGROUP);
     talloc_free(userfilter);
 
     return filter;
@@ -374,9 +376,10 @@ sysdb_sudo_filter_netgroups(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    filter = talloc_asprintf(mem_ctx, "(&(%s=%s)(%s=+*)(!(|%s)))",
+    filter = talloc_asprintf(mem_ctx, "(&(%s=%s)(%s=%s)(!(|%s)))",
                              SYSDB_OBJECTCLASS, SYSDB_SUDO_CACHE_OC,
-                             SYSDB_SUDO_CACHE_AT_USER,
+                             SYSDB_SUDO_CACHE_AT_USER_INDEX,
+                             SYSDB_SUDO_USER_INDEX_NETGROUP,
                              userfilter);
     talloc_free(userfilter);
 
@@ -961,13 +964,151 @@ done:
     return ret;
 }
 
+errno_t sysdb_sudo_user_index_values(TALLOC_CTX *mem_ctx,
+                                     struct ldb_message_element *users,
+                                     const char ***_values)
+{
+    const char **values;
+    bool netgroup = false;
+    const char *user;
+    unsigned int num_values = 0;
+    unsigned int i;
+
+    values = talloc_zero_array(mem_ctx, const char *, users->num_values + 1);
+    if (values == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < users->num_values; i++) {
+        user = (const char *)users->values[i].data;
+
+        if (user[0] == '+') {
+            if (!netgroup) {
+                values[num_values++] = SYSDB_SUDO_USER_INDEX_NETGROUP;
+                netgroup = true;
+            }
+            continue;
+        }
+
+        values[num_values++] = user;
+    }
+
+    *_values = values;
+
+    return EOK;
+}
+
+static errno_t sysdb_sudo_add_user_index(struct sysdb_attrs *rule)
+{
+    struct ldb_message_element *el;
+    const char **values;
+    errno_t ret;
+    int i;
+
+    ret = sysdb_attrs_get_el_ext(rule, SYSDB_SUDO_CACHE_AT_USER, false, &el);
+    if (ret == ENOENT) {
+        /* "defaults" */
+        return EOK;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sysdb_sudo_user_index_values(rule, el, &values);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; values[i] != NULL; i++) {
+        ret = sysdb_attrs_add_string(rule, SYSDB_SUDO_CACHE_AT_USER_INDEX,
+                                     values[i]);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to add %s attribute [%d]: %s\n",
+                  SYSDB_SUDO_CACHE_AT_USER_INDEX, ret, sss_strerror(ret));
+            break;
+        }
+    }
+
+    talloc_free(values);
+    return ret;
+}
+
+/* Two differently seeded 32-bit hashes, so that a changed rule is not
+ * mistaken for an unchanged one. Attributes maintained by sysdb itself are
+ * skipped, but the settings that change how a rule is stored are included. */
+static errno_t sysdb_sudo_rule_hash(TALLOC_CTX *mem_ctx,
+                                    struct sss_domain_info *domain,
+                                    struct sysdb_attrs *rule,
+                                    char **_hash)
+{
+    struct ldb_message_element *el;
+    uint32_t h1 = domain->case_sensitive ? 1 : 0;
+    uint32_t h2 = 0xdeadbeef;
+    char *hash;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < rule->num; i++) {
+        el = &rule->a[i];
+
+        if (strcasecmp(el->name, SYSDB_SUDO_CACHE_AT_HASH) == 0
+                || strcasecmp(el->name, SYSDB_SUDO_CACHE_AT_USER_INDEX) == 0
+                || strcasecmp(el->name, SYSDB_CACHE_EXPIRE) == 0) {
+            continue;
+        }
+
+        h1 = murmurhash3(el->name, strlen(el->name), h1);
+        h2 = murmurhash3(el->name, strlen(el->name), h2);
+
+        for (j = 0; j < el->num_values; j++) {
+            h1 = murmurhash3((const char *)el->values[j].data,
+                             el->values[j].length, h1);
+            h2 = murmurhash3((const char *)el->values[j].data,
+                             el->values[j].length, h2);
+        }
+    }
+
+    hash = talloc_asprintf(mem_ctx, "%08x%08x", h1, h2);
+    if (hash == NULL) {
+        return ENOMEM;
+    }
+
+    *_hash = hash;
+
+    return EOK;
+}
+
+static errno_t sysdb_sudo_add_hash(struct sysdb_attrs *rule,
+                                   const char *hash)
+{
+    struct ldb_message_element *el;
+    errno_t ret;
+
+    /* Replace the hash of an exported rule */
+    ret = sysdb_attrs_get_el_ext(rule, SYSDB_SUDO_CACHE_AT_HASH, false, &el);
+    if (ret == EOK) {
+        el->num_values = 0;
+    }
+
+    ret = sysdb_attrs_add_string(rule, SYSDB_SUDO_CACHE_AT_HASH, hash);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to add %s attribute [%d]: %s\n",
+              SYSDB_SUDO_CACHE_AT_HASH, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return EOK;
+}
+
+/* The hash is computed if it is NULL. */
 static errno_t
 sysdb_sudo_store_rule(struct sss_domain_info *domain,
                       struct sysdb_attrs *rule,
                       int cache_timeout,
-                      time_t now)
+                      time_t now,
+                      const char *hash)
 {
     const char *name;
+    char *computed = NULL;
     errno_t ret;
 
     name = sysdb_sudo_get_rule_name(rule);
@@ -977,16 +1118,46 @@ sysdb_sudo_store_rule(struct sss_domain_info *domain,
 
     DEBUG(SSSDBG_TRACE_FUNC, "Adding sudo rule %s\n", name);
 
+    if (hash == NULL) {
+        ret = sysdb_sudo_rule_hash(rule, domain, rule, &computed);
+        if (ret != EOK) {
+            return ret;
+        }
+        hash = computed;
+    }
+
+    ret = sysdb_sudo_add_hash(rule, hash);
+    talloc_free(computed);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sysdb_sudo_add_lowered_users(domain, rule, name);
     if (ret != EOK) {
         return ret;
     }
 
+    ret = sysdb_sudo_add_user_index(rule);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sysdb_sudo_add_sss_attrs(rule, name, cache_timeout, now);
     if (ret != EOK) {
         return ret;
     }
 
+    /* Sudo evaluates the commands in the order they are returned, so they
+     * are not sorted before packing. */
+    ret = sysdb_attrs_pack_values(rule, SYSDB_SUDO_CACHE_AT_COMMAND,
+                                  SYSDB_SUDO_CACHE_AT_COMMAND_PACKED,
+                                  domain->cache_compress_threshold);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to pack commands of rule %s "
+              "[%d]: %s\n", name, ret, sss_strerror(ret));
+        return ret;
+    }
+
     /* Always delete the old rule and add a new one */
     ret = sysdb_delete_custom(domain, name, SUDORULE_SUBDIR);
     if (ret != EOK) {
@@ -1030,7 +1201,7 @@ sysdb_sudo_store(struct sss_domain_info *domain,
     now = time(NULL);
     for (i = 0; i < num_rules; i++) {
         ret = sysdb_sudo_store_rule(domain, rules[i],
-                                    domain->sudo_timeout, now);
+                                    domain->sudo_timeout, now, NULL);
         if (ret == EINVAL) {
             /* Multiple CNs are error on server side, we can just ignore this
              * rule and save the others. Loud debug message is in logs. */
@@ -1067,6 +1238,379 @@ done:
     return ret;
 }
 
+/* Number of rules written in one transaction by sysdb_sudo_update() */
+#define SYSDB_SUDO_UPDATE_BATCH 100
+
+/* Returns a table of rule name -> content hash of the cached rules that
+ * match filter. */
+static errno_t sysdb_sudo_cached_hashes(TALLOC_CTX *mem_ctx,
+                                        struct sss_domain_info *domain,
+                                        const char *filter,
+                                        hash_table_t **_table)
+{
+    const char *attrs[] = { SYSDB_SUDO_CACHE_AT_CN,
+                            SYSDB_SUDO_CACHE_AT_HASH,
+                            NULL };
+    struct ldb_message **msgs = NULL;
+    hash_table_t *table;
+    hash_key_t key;
+    hash_value_t value;
+    const char *name;
+    const char *hash;
+    size_t count = 0;
+    size_t i;
+    errno_t ret;
+    int hret;
+
+    ret = sysdb_search_custom(mem_ctx, domain, filter, SUDORULE_SUBDIR, attrs,
+                              &count, &msgs);
+    if (ret == ENOENT) {
+        count = 0;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Error looking up SUDO rules\n");
+        return ret;
+    }
+
+    ret = sss_hash_create(mem_ctx, count, &table);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; i < count; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_SUDO_CACHE_AT_CN,
+                                           NULL);
+        if (name == NULL) {
+            continue;
+        }
+
+        /* Rules cached by an older version have no hash */
+        hash = ldb_msg_find_attr_as_string(msgs[i], SYSDB_SUDO_CACHE_AT_HASH,
+                                           "");
+
+        key.type = HASH_KEY_STRING;
+        key.str = discard_const(name);
+        value.type = HASH_VALUE_PTR;
+        value.ptr = discard_const(hash);
+
+        hret = hash_enter(table, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            talloc_free(table);
+            return ENOMEM;
+        }
+    }
+
+    *_table = table;
+
+    return EOK;
+}
+
+/* Returns the content hash of a cached rule, "" if the rule is cached
+ * without one or NULL if it is not cached. The rule is removed from the
+ * table, so that only the stale rules remain in it. */
+static const char *sysdb_sudo_cached_hash(TALLOC_CTX *mem_ctx,
+                                          struct sss_domain_info *domain,
+                                          hash_table_t *table,
+                                          const char *name)
+{
+    const char *attrs[] = { SYSDB_SUDO_CACHE_AT_HASH, NULL };
+    struct ldb_message **msgs;
+    hash_key_t key;
+    hash_value_t value;
+    size_t count;
+    errno_t ret;
+    int hret;
+
+    if (table != NULL) {
+        key.type = HASH_KEY_STRING;
+        key.str = discard_const(name);
+
+        hret = hash_lookup(table, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            return NULL;
+        }
+
+        hash_delete(table, &key);
+        return value.ptr;
+    }
+
+    ret = sysdb_search_custom_by_name(mem_ctx, domain, name, SUDORULE_SUBDIR,
+                                      attrs, &count, &msgs);
+    if (ret != EOK || count != 1) {
+        return NULL;
+    }
+
+    return ldb_msg_find_attr_as_string(msgs[0], SYSDB_SUDO_CACHE_AT_HASH, "");
+}
+
+static errno_t sysdb_sudo_set_rule_expire(struct sss_domain_info *domain,
+                                          const char *name,
+                                          int cache_timeout,
+                                          time_t now)
+{
+    struct sysdb_attrs *attrs;
+    time_t expire;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(NULL);
+    if (attrs == NULL) {
+        return ENOMEM;
+    }
+
+    expire = cache_timeout > 0 ? now + cache_timeout : 0;
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_CACHE_EXPIRE, expire);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_set_sudo_rule_attr(domain, name, attrs, SYSDB_MOD_REP);
+
+done:
+    talloc_free(attrs);
+    return ret;
+}
+
+static errno_t sysdb_sudo_update_batch(struct sss_domain_info *domain,
+                                       hash_table_t *cached,
+                                       struct sysdb_attrs **rules,
+                                       size_t num_rules,
+                                       time_t now,
+                                       size_t *_num_unchanged)
+{
+    TALLOC_CTX *tmp_ctx;
+    bool in_transaction = false;
+    const char *name;
+    const char *old_hash;
+    char *hash;
+    errno_t sret;
+    errno_t ret;
+    size_t i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_transaction_start(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    for (i = 0; i < num_rules; i++) {
+        name = sysdb_sudo_get_rule_name(rules[i]);
+        if (name == NULL) {
+            /* Loud debug message is in logs. */
+            continue;
+        }
+
+        ret = sysdb_sudo_rule_hash(tmp_ctx, domain, rules[i], &hash);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        old_hash = sysdb_sudo_cached_hash(tmp_ctx, domain, cached, name);
+        if (old_hash != NULL && strcmp(old_hash, hash) == 0) {
+            DEBUG(SSSDBG_TRACE_INTERNAL, "Sudo rule %s is unchanged\n", name);
+            ret = sysdb_sudo_set_rule_expire(domain, name,
+                                             domain->sudo_timeout, now);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "Unable to update rule %s [%d]: %s\n",
+                      name, ret, sss_strerror(ret));
+                goto done;
+            }
+            (*_num_unchanged)++;
+            continue;
+        }
+
+        ret = sysdb_sudo_store_rule(domain, rules[i],
+                                    domain->sudo_timeout, now, hash);
+        if (ret == EINVAL || ret == ERR_MALFORMED_ENTRY) {
+            /* See sysdb_sudo_store() */
+            continue;
+        } else if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = sysdb_transaction_commit(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(domain->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sysdb_sudo_purge_stale(struct sss_domain_info *domain,
+                                      hash_table_t *stale)
+{
+    bool in_transaction = false;
+    hash_key_t *keys = NULL;
+    unsigned long count;
+    unsigned long i;
+    errno_t sret;
+    errno_t ret = EOK;
+    int hret;
+
+    hret = hash_keys(stale, &count, &keys);
+    if (hret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Removing %lu stale sudo rules\n", count);
+
+    for (i = 0; i < count; i++) {
+        if (i % SYSDB_SUDO_UPDATE_BATCH == 0) {
+            if (in_transaction) {
+                ret = sysdb_transaction_commit(domain->sysdb);
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+                    goto done;
+                }
+                in_transaction = false;
+            }
+
+            ret = sysdb_transaction_start(domain->sysdb);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+                goto done;
+            }
+            in_transaction = true;
+        }
+
+        ret = sysdb_sudo_purge_byname(domain, keys[i].str);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Failed to delete rule "
+                  "%s [%d]: %s\n", keys[i].str, ret, sss_strerror(ret));
+            continue;
+        }
+    }
+
+    if (in_transaction) {
+        ret = sysdb_transaction_commit(domain->sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+            goto done;
+        }
+        in_transaction = false;
+    }
+
+    ret = EOK;
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(domain->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+
+    talloc_free(keys);
+    return ret;
+}
+
+errno_t
+sysdb_sudo_update(struct sss_domain_info *domain,
+                  const char *delete_filter,
+                  struct sysdb_attrs **rules,
+                  size_t num_rules)
+{
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *cached = NULL;
+    size_t num_unchanged = 0;
+    size_t batch;
+    time_t now;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* Without a filter only the received rules are replaced, they are
+     * compared with the cache one by one. */
+    if (delete_filter != NULL) {
+        ret = sysdb_sudo_cached_hashes(tmp_ctx, domain, delete_filter,
+                                       &cached);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    now = time(NULL);
+    for (i = 0; i < num_rules; i += batch) {
+        batch = MIN(num_rules - i, SYSDB_SUDO_UPDATE_BATCH);
+
+        ret = sysdb_sudo_update_batch(domain, cached, rules + i, batch, now,
+                                      &num_unchanged);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%zu of %zu sudo rules are unchanged\n",
+          num_unchanged, num_rules);
+
+    /* Cached rules that were not received any more */
+    if (cached != NULL && hash_count(cached) > 0) {
+        ret = sysdb_sudo_purge_stale(domain, cached);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to update sudo rules [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Add SYSDB_SUDO_CACHE_AT_COMMAND_PACKED to @attrs if the commands were
+ * requested. */
+static errno_t sysdb_sudo_search_attrs(TALLOC_CTX *mem_ctx,
+                                       const char **attrs,
+                                       const char ***_attrs)
+{
+    const char *packed[] = { SYSDB_SUDO_CACHE_AT_COMMAND_PACKED, NULL };
+    char **new_attrs;
+    errno_t ret;
+
+    if (attrs == NULL
+            || !string_in_list(SYSDB_SUDO_CACHE_AT_COMMAND,
+                               discard_const(attrs), false)
+            || string_in_list(SYSDB_SUDO_CACHE_AT_COMMAND_PACKED,
+                              discard_const(attrs), false)) {
+        *_attrs = attrs;
+        return EOK;
+    }
+
+    ret = add_strings_lists(mem_ctx, attrs, packed, false, &new_attrs);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    *_attrs = discard_const(new_attrs);
+    return EOK;
+}
+
 errno_t sysdb_search_sudo_rules(TALLOC_CTX *mem_ctx,
                                 struct sss_domain_info *domain,
                                 const char *sub_filter,
@@ -1078,12 +1622,19 @@ errno_t sysdb_search_sudo_rules(TALLOC_CTX *mem_ctx,
     size_t msgs_count;
     struct ldb_message **msgs;
     struct ldb_dn *dn;
+    const char **search_attrs;
     char *filter;
+    size_t i;
     int ret;
 
     tmp_ctx = talloc_new(NULL);
     NULL_CHECK(tmp_ctx, ret, done);
 
+    ret = sysdb_sudo_search_attrs(tmp_ctx, attrs, &search_attrs);
+    if (ret != EOK) {
+        goto done;
+    }
+
     dn = ldb_dn_new_fmt(tmp_ctx, domain->sysdb->ldb, SYSDB_TMPL_CUSTOM_SUBTREE,
                         SUDORULE_SUBDIR, domain->name);
     if (dn == NULL) {
@@ -1108,7 +1659,7 @@ errno_t sysdb_search_sudo_rules(TALLOC_CTX *mem_ctx,
           "Search sudo rules with filter: %s\n", filter);
 
     ret = sysdb_search_entry(tmp_ctx, domain->sysdb, dn,
-                             LDB_SCOPE_SUBTREE, filter, attrs,
+                             LDB_SCOPE_SUBTREE, filter, search_attrs,
                              &msgs_count, &msgs);
 
     if (ret == ENOENT) {
@@ -1121,6 +1672,15 @@ errno_t sysdb_search_sudo_rules(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    for (i = 0; i < msgs_count; i++) {
+        ret = sysdb_msg_unpack_values(msgs[i],
+                                      SYSDB_SUDO_CACHE_AT_COMMAND_PACKED,
+                                      SYSDB_SUDO_CACHE_AT_COMMAND);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     *_msgs_count = msgs_count;
     *_msgs = talloc_steal(mem_ctx, msgs);
 
@@ -46,6 +46,22 @@
 #define SYSDB_SUDO_CACHE_AT_NOTAFTER   "sudoNotAfter"
 #define SYSDB_SUDO_CACHE_AT_ORDER      "sudoOrder"
 
+/* Indexed copy of sudoUser maintained by sysdb_sudo_store(). All netgroup
+ * values are replaced by a single SYSDB_SUDO_USER_INDEX_NETGROUP value so
+ * that rules with netgroups can be found without a substring search. */
+#define SYSDB_SUDO_CACHE_AT_USER_INDEX "sudoUserIndex"
+#define SYSDB_SUDO_USER_INDEX_NETGROUP "+"
+
+/* Hash of the rule content as it was received, maintained by
+ * sysdb_sudo_store() and used by sysdb_sudo_update() to detect rules that
+ * were not changed. */
+#define SYSDB_SUDO_CACHE_AT_HASH       "sudoRuleHash"
+
+/* sudoCommand values packed by sysdb_sudo_store() if the domain has
+ * cache_compress_threshold set, see sysdb_attrs_pack_values(). They are
+ * unpacked again by sysdb_search_sudo_rules(). */
+#define SYSDB_SUDO_CACHE_AT_COMMAND_PACKED "sudoCommandPacked"
+
 /* sysdb ipa attributes */
 #define SYSDB_IPA_SUDORULE_OC                 "ipasudorule"
 #define SYSDB_IPA_SUDORULE_ENABLED            "ipaEnabledFlag"
@@ -140,6 +156,16 @@ sysdb_sudo_store(struct sss_domain_info *domain,
                  struct sysdb_attrs **rules,
                  size_t num_rules);
 
+/* Has the same result as sysdb_sudo_purge() followed by sysdb_sudo_store(),
+ * but rules whose content did not change only get their expiration updated
+ * and the changes are committed in several smaller transactions, so readers
+ * are not blocked for the whole update. */
+errno_t
+sysdb_sudo_update(struct sss_domain_info *domain,
+                  const char *delete_filter,
+                  struct sysdb_attrs **rules,
+                  size_t num_rules);
+
 errno_t
 sysdb_search_sudo_rules(TALLOC_CTX *mem_ctx,
                         struct sss_domain_info *domain,
@@ -414,7 +414,7 @@ int sysdb_check_upgrade_02(struct sss_domain_info *domains,
 
         /* create new dom db */
         ret = sysdb_domain_init_internal(tmp_ctx, dom,
-                                         db_path, false, &sysdb);
+                                         db_path, NULL, false, &sysdb);
         if (ret != EOK) {
             goto done;
         }
@@ -2667,6 +2667,131 @@ done:
     return ret;
 }
 
+int sysdb_upgrade_22(struct sysdb_ctx *sysdb, const char **ver)
+{
+    TALLOC_CTX *tmp_ctx;
+    int ret;
+    struct ldb_message *msg;
+    struct ldb_result *res;
+    struct ldb_message_element *el;
+    struct ldb_dn *base_dn;
+    struct upgrade_ctx *ctx;
+    const char **values;
+    const char *attrs[] = { "sudoUser", NULL };
+    unsigned int i;
+    unsigned int j;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_23, &ctx);
+    if (ret) {
+        return ret;
+    }
+
+    /* Add index for sudoUserIndex */
+    msg = ldb_msg_new(tmp_ctx);
+    if (msg == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    msg->dn = ldb_dn_new(tmp_ctx, sysdb->ldb, "@INDEXLIST");
+    if (msg->dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_msg_add_empty(msg, "@IDXATTR", LDB_FLAG_MOD_ADD, NULL);
+    if (ret != LDB_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_msg_add_string(msg, "@IDXATTR", "sudoUserIndex");
+    if (ret != LDB_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_modify(sysdb->ldb, msg);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    talloc_zfree(msg);
+
+    /* The cached rules are searched by sudoUserIndex from now on */
+    base_dn = ldb_dn_new(tmp_ctx, sysdb->ldb, SYSDB_BASE);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_search(sysdb->ldb, tmp_ctx, &res, base_dn, LDB_SCOPE_SUBTREE,
+                     attrs, "(&(objectclass=sudoRule)(sudoUser=*))");
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    for (i = 0; i < res->count; i++) {
+        el = ldb_msg_find_element(res->msgs[i], "sudoUser");
+        if (el == NULL) {
+            continue;
+        }
+
+        ret = sysdb_sudo_user_index_values(tmp_ctx, el, &values);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        msg = ldb_msg_new(tmp_ctx);
+        if (msg == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        msg->dn = res->msgs[i]->dn;
+
+        ret = ldb_msg_add_empty(msg, "sudoUserIndex", LDB_FLAG_MOD_REPLACE,
+                                NULL);
+        if (ret != LDB_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (j = 0; values[j] != NULL; j++) {
+            ret = ldb_msg_add_string(msg, "sudoUserIndex", values[j]);
+            if (ret != LDB_SUCCESS) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+
+        ret = ldb_modify(sysdb->ldb, msg);
+        if (ret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to index sudo rule %s\n",
+                  ldb_dn_get_linearized(msg->dn));
+            ret = sysdb_error_to_errno(ret);
+            goto done;
+        }
+
+        talloc_zfree(msg);
+        talloc_zfree(values);
+    }
+
+    /* conversion done, update version number */
+    ret = update_version(ctx);
+
+done:
+    ret = finish_upgrade(ret, &ctx, ver);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 int sysdb_ts_upgrade_01(struct sysdb_ctx *sysdb, const char **ver)
 {
     struct upgrade_ctx *ctx;
@@ -2712,6 +2837,194 @@ done:
     return ret;
 }
 
+/* The special records that configure the database. @BASEINFO is maintained
+ * by ldb itself. */
+static const char *sysdb_engine_special_dns[] = {
+    "@ATTRIBUTES",
+    "@INDEXLIST",
+    "@MODULES",
+    NULL
+};
+
+static errno_t sysdb_copy_special_records(TALLOC_CTX *mem_ctx,
+                                          struct ldb_context *src,
+                                          struct ldb_context *dst)
+{
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    errno_t ret;
+    int i;
+
+    for (i = 0; sysdb_engine_special_dns[i] != NULL; i++) {
+        dn = ldb_dn_new(mem_ctx, src, sysdb_engine_special_dns[i]);
+        if (dn == NULL) {
+            return ENOMEM;
+        }
+
+        ret = ldb_search(src, mem_ctx, &res, dn, LDB_SCOPE_BASE, NULL, NULL);
+        if (ret != LDB_SUCCESS) {
+            return sysdb_error_to_errno(ret);
+        }
+
+        if (res->count != 1) {
+            continue;
+        }
+
+        ret = ldb_add(dst, res->msgs[0]);
+        if (ret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to copy %s [%d]: %s\n",
+                  sysdb_engine_special_dns[i], ret, ldb_errstring(dst));
+            return sysdb_error_to_errno(ret);
+        }
+    }
+
+    return EOK;
+}
+
+static void sysdb_unlink_lmdb_lock(TALLOC_CTX *mem_ctx, const char *file)
+{
+    char *lock_file;
+
+    lock_file = talloc_asprintf(mem_ctx, "%s"SYSDB_LMDB_LOCK_SUFFIX, file);
+    if (lock_file != NULL) {
+        unlink(lock_file);
+    }
+}
+
+/*
+ * Converting between storage engines is not a version upgrade, the
+ * entries are copied as they are into a new file which then replaces the
+ * old one. The special records are copied first, so the entries are
+ * indexed, but the modules are only loaded when the new file is opened,
+ * so memberOf values are not recomputed.
+ */
+errno_t sysdb_convert_engine(const char *ldb_file,
+                             enum sss_cache_engine from,
+                             enum sss_cache_engine to)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_context *src = NULL;
+    struct ldb_context *dst = NULL;
+    struct ldb_result *res;
+    char *src_url;
+    char *dst_url;
+    char *tmp_file;
+    bool in_transaction = false;
+    errno_t ret;
+    unsigned int i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Converting %s to a new storage engine\n",
+          ldb_file);
+
+    tmp_file = talloc_asprintf(tmp_ctx, "%s.convert", ldb_file);
+    src_url = sysdb_engine_url(tmp_ctx, from, ldb_file);
+    if (tmp_file == NULL || src_url == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    dst_url = sysdb_engine_url(tmp_ctx, to, tmp_file);
+    if (dst_url == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Left over by an interrupted conversion */
+    if (unlink(tmp_file) != 0 && errno != ENOENT) {
+        ret = errno;
+        goto done;
+    }
+    sysdb_unlink_lmdb_lock(tmp_ctx, tmp_file);
+
+    ret = sysdb_ldb_connect(tmp_ctx, src_url, 0, &src);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to open %s\n", src_url);
+        goto done;
+    }
+
+    ret = sysdb_ldb_connect(tmp_ctx, dst_url, 0, &dst);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to open %s, is the storage "
+              "engine supported by ldb?\n", dst_url);
+        goto done;
+    }
+
+    ret = ldb_transaction_start(dst);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sysdb_copy_special_records(tmp_ctx, src, dst);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = ldb_search(src, tmp_ctx, &res, NULL, LDB_SCOPE_SUBTREE, NULL, NULL);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    for (i = 0; i < res->count; i++) {
+        ret = ldb_add(dst, res->msgs[i]);
+        if (ret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to copy %s [%d]: %s\n",
+                  ldb_dn_get_linearized(res->msgs[i]->dn), ret,
+                  ldb_errstring(dst));
+            ret = sysdb_error_to_errno(ret);
+            goto done;
+        }
+    }
+
+    ret = ldb_transaction_commit(dst);
+    in_transaction = false;
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    talloc_zfree(src);
+    talloc_zfree(dst);
+
+    ret = rename(tmp_file, ldb_file);
+    if (ret != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    sysdb_unlink_lmdb_lock(tmp_ctx, tmp_file);
+    sysdb_unlink_lmdb_lock(tmp_ctx, ldb_file);
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Converted %u entries of %s\n",
+          res->count, ldb_file);
+
+    ret = EOK;
+
+done:
+    if (in_transaction) {
+        ldb_transaction_cancel(dst);
+    }
+
+    if (ret != EOK) {
+        talloc_zfree(src);
+        talloc_zfree(dst);
+        unlink(tmp_file);
+        sysdb_unlink_lmdb_lock(tmp_ctx, tmp_file);
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to convert %s [%d]: %s\n",
+              ldb_file, ret, sss_strerror(ret));
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 /*
  * Example template for future upgrades.
  * Copy and change version numbers as appropriate.
@@ -21,11 +21,188 @@
 
 #include "util/util.h"
 #include "util/cert.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
 #include "db/sysdb_private.h"
 #include "db/sysdb_domain_resolution_order.h"
 
 #define SYSDB_VIEWS_BASE "cn=views,cn=sysdb"
 
+/* Maximal number of override objects kept in memory */
+#define SYSDB_OVERRIDE_CACHE_SIZE 4096
+
+/* Override objects are always stored together with the original object,
+ * so a cached override object is valid as long as the original object has
+ * the same SYSDB_LAST_UPDATE value. This works across processes, unlike
+ * invalidating the entries when an override is written. */
+struct sysdb_override_cache_entry {
+    struct sysdb_override_cache_entry *prev;
+    struct sysdb_override_cache_entry *next;
+
+    struct sysdb_override_cache *cache;
+    uint64_t last_update;
+    struct ldb_message *override;
+};
+
+struct sysdb_override_cache {
+    hash_table_t *table;
+
+    /* Most recently used entry first. */
+    struct sysdb_override_cache_entry *entries;
+    struct sysdb_override_cache_entry *last;
+    unsigned int num_entries;
+};
+
+static int
+sysdb_override_cache_entry_destructor(struct sysdb_override_cache_entry *entry)
+{
+    struct sysdb_override_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+/* Returns the SYSDB_LAST_UPDATE value the override object of obj can be
+ * cached with or 0 if it must not be cached. */
+static uint64_t sysdb_override_cache_stamp(struct sss_domain_info *domain,
+                                           struct ldb_message *obj)
+{
+    uint64_t last_update;
+
+    /* Overrides of the LOCAL view are written by sss_override without
+     * touching the original object. */
+    if (is_local_view(domain->view_name)) {
+        return 0;
+    }
+
+    /* The object might be updated again within the same second. */
+    last_update = ldb_msg_find_attr_as_uint64(obj, SYSDB_LAST_UPDATE, 0);
+    if (last_update >= (uint64_t)time(NULL)) {
+        return 0;
+    }
+
+    return last_update;
+}
+
+static struct ldb_message *
+sysdb_override_cache_get(TALLOC_CTX *mem_ctx,
+                         struct sysdb_ctx *sysdb,
+                         const char *override_dn,
+                         uint64_t stamp)
+{
+    struct sysdb_override_cache *cache = sysdb->override_cache;
+    struct sysdb_override_cache_entry *entry;
+
+    if (cache == NULL || stamp == 0) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, override_dn,
+                                struct sysdb_override_cache_entry);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    if (entry->last_update != stamp) {
+        talloc_free(entry);
+        return NULL;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    /* The values are stolen by the caller. */
+    return ldb_msg_copy(mem_ctx, entry->override);
+}
+
+static void sysdb_override_cache_add(struct sysdb_ctx *sysdb,
+                                     const char *override_dn,
+                                     uint64_t stamp,
+                                     struct ldb_message *override)
+{
+    struct sysdb_override_cache *cache;
+    struct sysdb_override_cache_entry *entry;
+    errno_t ret;
+
+    if (stamp == 0) {
+        return;
+    }
+
+    if (sysdb->override_cache == NULL) {
+        cache = talloc_zero(sysdb, struct sysdb_override_cache);
+        if (cache == NULL) {
+            return;
+        }
+
+        cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+        if (cache->table == NULL) {
+            talloc_free(cache);
+            return;
+        }
+
+        sysdb->override_cache = cache;
+    }
+    cache = sysdb->override_cache;
+
+    entry = sss_ptr_hash_lookup(cache->table, override_dn,
+                                struct sysdb_override_cache_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= SYSDB_OVERRIDE_CACHE_SIZE) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct sysdb_override_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->override = ldb_msg_copy(entry, override);
+    if (entry->override == NULL) {
+        talloc_free(entry);
+        return;
+    }
+
+    ret = sss_ptr_hash_add(cache->table, override_dn, entry,
+                           struct sysdb_override_cache_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        return;
+    }
+
+    entry->cache = cache;
+    entry->last_update = stamp;
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    talloc_set_destructor(entry, sysdb_override_cache_entry_destructor);
+}
+
+static void sysdb_override_cache_flush(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_override_cache *cache = sysdb->override_cache;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    while (cache->last != NULL) {
+        talloc_free(cache->last);
+    }
+}
+
 /* In general is should not be possible that there is a view container without
  * a view name set. But to be on the safe side we return both information
  * separately. */
@@ -265,6 +442,8 @@ errno_t sysdb_delete_view_tree(struct sysdb_ctx *sysdb, const char *view_name)
         goto done;
     }
 
+    sysdb_override_cache_flush(sysdb);
+
     ret = sysdb_delete_recursive(sysdb, dn, true);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "sysdb_delete_recursive failed.\n");
@@ -337,6 +516,8 @@ errno_t sysdb_invalidate_overrides(struct sysdb_ctx *sysdb)
               "the cache file if there are issues after a view name change.\n");
     }
 
+    sysdb_override_cache_flush(sysdb);
+
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
@@ -1418,7 +1599,15 @@ errno_t sysdb_add_overrides_to_object(struct sss_domain_info *domain,
     uint64_t uid;
     static const char *user_attrs[] = SYSDB_PW_ATTRS;
     static const char *group_attrs[] = SYSDB_GRSRC_ATTRS;
-    const char **attrs;
+    /* All attributes of attr_map, the cached objects must contain all
+     * of them independent of the requested attributes. */
+    static const char *cache_attrs[] = { SYSDB_UIDNUM, SYSDB_GIDNUM,
+                                         SYSDB_GECOS, SYSDB_HOMEDIR,
+                                         SYSDB_SHELL, SYSDB_NAME,
+                                         SYSDB_SSH_PUBKEY, SYSDB_USER_CERT,
+                                         NULL };
+    const char **attrs = NULL;
+    uint64_t stamp;
     struct attr_map {
         const char *attr;
         const char *new_attr;
@@ -1486,32 +1675,49 @@ errno_t sysdb_add_overrides_to_object(struct sss_domain_info *domain,
             }
         }
 
-        ret = ldb_search(domain->sysdb->ldb, tmp_ctx, &res, override_dn,
-                         LDB_SCOPE_BASE, attrs, NULL);
-        if (ret != LDB_SUCCESS) {
-            ret = sysdb_error_to_errno(ret);
-            goto done;
-        }
+        stamp = sysdb_override_cache_stamp(domain, obj);
+        override = sysdb_override_cache_get(tmp_ctx, domain->sysdb,
+                                            override_dn_str, stamp);
+        if (override == NULL) {
+            ret = ldb_search(domain->sysdb->ldb, tmp_ctx, &res, override_dn,
+                             LDB_SCOPE_BASE, cache_attrs, NULL);
+            if (ret != LDB_SUCCESS) {
+                ret = sysdb_error_to_errno(ret);
+                goto done;
+            }
 
-        if (res->count == 1) {
-            override = res->msgs[0];
-        } else if (res->count == 0) {
-            DEBUG(SSSDBG_TRACE_FUNC, "Override object [%s] does not exists.\n",
-                                     override_dn_str);
-            ret = ENOENT;
-            goto done;
-        } else {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Base search for override object returned [%d] results.\n",
-                  res->count);
-            ret = EINVAL;
-            goto done;
+            if (res->count == 1) {
+                override = res->msgs[0];
+            } else if (res->count == 0) {
+                DEBUG(SSSDBG_TRACE_FUNC,
+                      "Override object [%s] does not exists.\n",
+                      override_dn_str);
+                ret = ENOENT;
+                goto done;
+            } else {
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                      "Base search for override object returned [%d] "
+                      "results.\n", res->count);
+                ret = EINVAL;
+                goto done;
+            }
+
+            sysdb_override_cache_add(domain->sysdb, override_dn_str, stamp,
+                                     override);
         }
     } else {
         override = override_obj;
     }
 
     for (c = 0; attr_map[c].attr != NULL; c++) {
+        if (attrs != NULL
+                && !string_in_list(attr_map[c].attr, discard_const(attrs),
+                                   false)
+                && !string_in_list("*", discard_const(attrs), true)) {
+            /* Not requested */
+            continue;
+        }
+
         tmp_el = ldb_msg_find_element(override, attr_map[c].attr);
         if (tmp_el != NULL) {
             for (d = 0; d < tmp_el->num_values; d++) {
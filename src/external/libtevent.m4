@@ -13,3 +13,10 @@ AS_IF([test x"$found_tevent" != xyes],
                       [-L$sss_extra_libdir -ltalloc])],
         [AC_MSG_ERROR([tevent header files are not installed])])]
 )
+
+dnl TEVENT_TRACE_BEFORE_LOOP_ONCE and AFTER_LOOP_ONCE are in tevent >= 0.10.0
+SAVE_CFLAGS=$CFLAGS
+CFLAGS="$CFLAGS $TEVENT_CFLAGS"
+AC_CHECK_DECLS([TEVENT_TRACE_BEFORE_LOOP_ONCE], [], [],
+               [[#include <tevent.h>]])
+CFLAGS=$SAVE_CFLAGS
@@ -24,6 +24,8 @@
 #include <string.h>
 #include <strings.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <time.h>
 
 #include <krb5/localauth_plugin.h>
 
@@ -32,136 +34,246 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
 
 #define DEFAULT_BUFSIZE 4096
 
-static krb5_error_code sss_userok(krb5_context context,
-                                  krb5_localauth_moddata data,
-                                  krb5_const_principal aname,
-                                  const char *lname)
+/* sshd and other GSSAPI services map the same principal several times per
+ * connection, so successful lookups are remembered for a few seconds. The
+ * lookups themselves are answered from the memory cache when possible. */
+#define SSS_LOCALAUTH_CACHE_SIZE 16
+#define SSS_LOCALAUTH_CACHE_TTL 5
+
+struct sss_localauth_entry {
+    char *name;
+    char *pw_name;
+    uid_t uid;
+    time_t expire;
+};
+
+struct krb5_localauth_moddata_st {
+    struct sss_localauth_entry entries[SSS_LOCALAUTH_CACHE_SIZE];
+    size_t next;
+};
+
+static void sss_localauth_entry_free(struct sss_localauth_entry *entry)
 {
-    krb5_error_code kerr;
-    char *princ_str;
+    free(entry->name);
+    free(entry->pw_name);
+    memset(entry, 0, sizeof(struct sss_localauth_entry));
+}
+
+static struct sss_localauth_entry *
+sss_localauth_cache_get(krb5_localauth_moddata data, const char *name)
+{
+    struct sss_localauth_entry *entry;
+    time_t now;
+    size_t c;
+
+    if (data == NULL) {
+        return NULL;
+    }
+
+    now = time(NULL);
+    for (c = 0; c < SSS_LOCALAUTH_CACHE_SIZE; c++) {
+        entry = &data->entries[c];
+        if (entry->name == NULL || strcmp(entry->name, name) != 0) {
+            continue;
+        }
+
+        if (entry->expire < now) {
+            sss_localauth_entry_free(entry);
+            return NULL;
+        }
+
+        return entry;
+    }
+
+    return NULL;
+}
+
+static void sss_localauth_cache_set(krb5_localauth_moddata data,
+                                    const char *name, const char *pw_name,
+                                    uid_t uid)
+{
+    struct sss_localauth_entry *entry;
+
+    if (data == NULL) {
+        return;
+    }
+
+    entry = &data->entries[data->next];
+    data->next = (data->next + 1) % SSS_LOCALAUTH_CACHE_SIZE;
+    sss_localauth_entry_free(entry);
+
+    entry->name = strdup(name);
+    entry->pw_name = strdup(pw_name);
+    if (entry->name == NULL || entry->pw_name == NULL) {
+        /* Not caching is not an error */
+        sss_localauth_entry_free(entry);
+        return;
+    }
+
+    entry->uid = uid;
+    entry->expire = time(NULL) + SSS_LOCALAUTH_CACHE_TTL;
+}
+
+/* Returns 0 on success, ENOENT if the user does not exist or an other error
+ * code. If _pw_name is not NULL it is set to a copy of the user name which
+ * must be freed by the caller. */
+static int sss_localauth_getpwnam(krb5_localauth_moddata data,
+                                  const char *name,
+                                  char **_pw_name, uid_t *_uid)
+{
+    struct sss_localauth_entry *entry;
     struct passwd pwd = { 0 };
     char *buffer = NULL;
-    size_t buflen;
     enum nss_status nss_status;
     int nss_errno;
-    uid_t princ_uid;
     int ret;
 
-    kerr = krb5_unparse_name(context, aname, &princ_str);
-    if (kerr != 0) {
-        ret = kerr;
-        goto done;
-    }
-
-    if (strcasecmp(princ_str, lname) == 0) {
-        ret = 0;
-        goto done;
+    entry = sss_localauth_cache_get(data, name);
+    if (entry != NULL) {
+        if (_pw_name != NULL) {
+            *_pw_name = strdup(entry->pw_name);
+            if (*_pw_name == NULL) {
+                return ENOMEM;
+            }
+        }
+        *_uid = entry->uid;
+        return 0;
     }
 
-    buflen = DEFAULT_BUFSIZE;
-    buffer = malloc(buflen);
+    buffer = malloc(DEFAULT_BUFSIZE);
     if (buffer == NULL) {
-        ret = ENOMEM;
-        goto done;
+        return ENOMEM;
     }
 
-    nss_status = _nss_sss_getpwnam_r(princ_str, &pwd, buffer, buflen,
+    nss_status = _nss_sss_getpwnam_r(name, &pwd, buffer, DEFAULT_BUFSIZE,
                                      &nss_errno);
     if (nss_status != NSS_STATUS_SUCCESS) {
         if (nss_status == NSS_STATUS_NOTFOUND) {
-            ret = KRB5_PLUGIN_NO_HANDLE;
+            ret = ENOENT;
         } else {
             ret = EIO;
         }
         goto done;
     }
 
-    princ_uid = pwd.pw_uid;
-
-    nss_status = _nss_sss_getpwnam_r(lname, &pwd, buffer, buflen, &nss_errno);
-    if (nss_status != NSS_STATUS_SUCCESS) {
-        if (nss_status == NSS_STATUS_NOTFOUND) {
-            ret = KRB5_PLUGIN_NO_HANDLE;
-        } else {
-            ret = EIO;
-        }
+    if (pwd.pw_name == NULL) {
+        ret = EINVAL;
         goto done;
     }
 
-    if (princ_uid != pwd.pw_uid) {
-        ret = EPERM;
-        goto done;
+    if (_pw_name != NULL) {
+        *_pw_name = strdup(pwd.pw_name);
+        if (*_pw_name == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
     }
+    *_uid = pwd.pw_uid;
 
+    sss_localauth_cache_set(data, name, pwd.pw_name, pwd.pw_uid);
     ret = 0;
 
 done:
-    krb5_free_unparsed_name(context, princ_str);
     free(buffer);
 
-    if (ret != 0) {
-        return KRB5_PLUGIN_NO_HANDLE;
+    return ret;
+}
+
+static krb5_error_code sss_init(krb5_context context,
+                                krb5_localauth_moddata *data)
+{
+    /* Without the cache every lookup goes to NSS, so failing here would only
+     * make the plugin unusable */
+    *data = calloc(1, sizeof(struct krb5_localauth_moddata_st));
+
+    return 0;
+}
+
+static void sss_fini(krb5_context context, krb5_localauth_moddata data)
+{
+    size_t c;
+
+    if (data == NULL) {
+        return;
     }
 
-    return ret;
+    for (c = 0; c < SSS_LOCALAUTH_CACHE_SIZE; c++) {
+        sss_localauth_entry_free(&data->entries[c]);
+    }
+
+    free(data);
 }
 
-static krb5_error_code sss_an2ln(krb5_context context,
-                                 krb5_localauth_moddata data,
-                                 const char *type, const char *residual,
-                                 krb5_const_principal aname, char **lname_out)
+static krb5_error_code sss_userok(krb5_context context,
+                                  krb5_localauth_moddata data,
+                                  krb5_const_principal aname,
+                                  const char *lname)
 {
     krb5_error_code kerr;
     char *princ_str;
-    struct passwd pwd = { 0 };
-    char *buffer = NULL;
-    size_t buflen;
-    enum nss_status nss_status;
-    int nss_errno;
+    uid_t princ_uid;
+    uid_t uid;
     int ret;
-    char *str;
 
     kerr = krb5_unparse_name(context, aname, &princ_str);
     if (kerr != 0) {
-        return kerr;
+        ret = kerr;
+        goto done;
     }
 
-    buflen = DEFAULT_BUFSIZE;
-    buffer = malloc(buflen);
-    if (buffer == NULL) {
-        ret = ENOMEM;
+    if (strcasecmp(princ_str, lname) == 0) {
+        ret = 0;
         goto done;
     }
 
-    nss_status = _nss_sss_getpwnam_r(princ_str, &pwd, buffer, buflen,
-                                     &nss_errno);
-    if (nss_status != NSS_STATUS_SUCCESS) {
-        if (nss_status == NSS_STATUS_NOTFOUND) {
-            ret = KRB5_LNAME_NOTRANS;
-        } else {
-            ret = EIO;
-        }
+    ret = sss_localauth_getpwnam(data, princ_str, NULL, &princ_uid);
+    if (ret != 0) {
         goto done;
     }
 
-    if (pwd.pw_name == NULL) {
-        ret = EINVAL;
+    ret = sss_localauth_getpwnam(data, lname, NULL, &uid);
+    if (ret != 0) {
         goto done;
     }
 
-    str = strdup(pwd.pw_name);
-    if (str == NULL) {
-        ret = ENOMEM;
+    if (princ_uid != uid) {
+        ret = EPERM;
         goto done;
     }
 
-    *lname_out = str;
-
     ret = 0;
 
 done:
     krb5_free_unparsed_name(context, princ_str);
-    free(buffer);
+
+    if (ret != 0) {
+        return KRB5_PLUGIN_NO_HANDLE;
+    }
+
+    return ret;
+}
+
+static krb5_error_code sss_an2ln(krb5_context context,
+                                 krb5_localauth_moddata data,
+                                 const char *type, const char *residual,
+                                 krb5_const_principal aname, char **lname_out)
+{
+    krb5_error_code kerr;
+    char *princ_str;
+    uid_t uid;
+    int ret;
+
+    kerr = krb5_unparse_name(context, aname, &princ_str);
+    if (kerr != 0) {
+        return kerr;
+    }
+
+    ret = sss_localauth_getpwnam(data, princ_str, lname_out, &uid);
+    if (ret == ENOENT) {
+        ret = KRB5_LNAME_NOTRANS;
+    }
+
+    krb5_free_unparsed_name(context, princ_str);
 
     return ret;
 }
@@ -183,8 +295,8 @@ localauth_sssd_initvt(krb5_context context, int maj_ver, int min_ver,
 
     krb5_localauth_vtable vt = (krb5_localauth_vtable)vtable;
 
-    vt->init = NULL;
-    vt->fini = NULL;
+    vt->init = sss_init;
+    vt->fini = sss_fini;
     vt->name = "sssd";
     vt->an2ln = sss_an2ln;
     vt->userok = sss_userok;
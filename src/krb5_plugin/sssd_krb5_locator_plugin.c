@@ -302,6 +302,81 @@ done:
     return ret;
 }
 
+/* Put the KDC krb5_child got from the back end in front of the KDCs from
+ * the kdcinfo file, duplicates of it are removed from the list. */
+static int add_preferred_kdc(struct sssd_ctx *ctx, const char *realm)
+{
+    const char *pref_realm;
+    const char *pref_kdc;
+    char *buf;
+    struct addr_port *pref = NULL;
+    struct addr_port *l;
+    size_t n = 0;
+    size_t c;
+    size_t i;
+    int ret;
+
+    pref_realm = getenv(SSSD_KRB5_LOCATOR_PREFERRED_REALM);
+    pref_kdc = getenv(SSSD_KRB5_LOCATOR_PREFERRED_KDC);
+    if (pref_realm == NULL || pref_kdc == NULL || *pref_kdc == '\0'
+            || strcmp(pref_realm, realm) != 0) {
+        return ENOENT;
+    }
+
+    buf = strdup(pref_kdc);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    ret = buf_to_addr_port_list(ctx, (uint8_t *) buf, strlen(buf), &pref);
+    free(buf);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (pref[0].addr == NULL) {
+        free_addr_port_list(&pref);
+        return EINVAL;
+    }
+
+    if (ctx->kdc_addr != NULL) {
+        for (n = 0; ctx->kdc_addr[n].addr != NULL; n++);
+    }
+
+    l = calloc(n + 2, sizeof(struct addr_port));
+    if (l == NULL) {
+        free_addr_port_list(&pref);
+        return ENOMEM;
+    }
+
+    l[0].addr = strdup(pref[0].addr);
+    l[0].port = pref[0].port;
+    free_addr_port_list(&pref);
+    if (l[0].addr == NULL) {
+        free(l);
+        return ENOMEM;
+    }
+
+    c = 1;
+    for (i = 0; i < n; i++) {
+        if (strcmp(ctx->kdc_addr[i].addr, l[0].addr) == 0
+                && (ctx->kdc_addr[i].port == l[0].port
+                    || ctx->kdc_addr[i].port == 0 || l[0].port == 0)) {
+            free(ctx->kdc_addr[i].addr);
+            continue;
+        }
+        l[c++] = ctx->kdc_addr[i];
+    }
+
+    free(ctx->kdc_addr);
+    ctx->kdc_addr = l;
+
+    PLUGIN_DEBUG("Using preferred KDC [%s][%d] first.\n",
+                 l[0].addr, l[0].port);
+
+    return EOK;
+}
+
 static int get_krb5info(const char *realm, struct sssd_ctx *ctx,
                         enum locate_service_type svc)
 {
@@ -490,7 +565,11 @@ krb5_error_code sssd_krb5_locator_lookup(void *private_data,
             return KRB5_PLUGIN_NO_HANDLE;
         }
 
+        free_addr_port_list(&(ctx->kdc_addr));
         ret = get_krb5info(realm, ctx, locate_service_kdc);
+        if (add_preferred_kdc(ctx, realm) == EOK) {
+            ret = EOK;
+        }
         if (ret != EOK) {
             PLUGIN_DEBUG("get_krb5info failed.\n");
             return KRB5_PLUGIN_NO_HANDLE;
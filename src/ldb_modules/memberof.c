@@ -32,6 +32,9 @@
 #define DB_GROUP_CLASS "group"
 #define DB_CACHE_EXPIRE "dataExpireTimestamp"
 #define DB_OC "objectCategory"
+#define DB_GIDNUM "gidNumber"
+#define DB_POSIX "isPosix"
+#define DB_INITGR_INDEX "initgrGidIndex"
 
 #ifndef MAX
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
@@ -73,14 +76,23 @@ struct mbof_add_operation {
 struct mbof_memberuid_op {
     struct ldb_dn *dn;
     struct ldb_message_element *el;
+
+    /* values of el, to filter duplicates quickly */
+    hash_table_t *values_idx;
+    unsigned int num_alloc;
 };
 
 struct mbof_add_ctx {
     struct mbof_ctx *ctx;
 
     struct mbof_add_operation *add_list;
+    struct mbof_add_operation *add_last;
     struct mbof_add_operation *current_op;
 
+    /* casefolded entry DN -> operation, a nested group can be reached
+     * through many paths but is processed only once */
+    hash_table_t *add_idx;
+
     struct ldb_message *msg;
     struct ldb_dn *msg_dn;
     bool terminate;
@@ -163,6 +175,14 @@ struct mbof_mod_ctx {
     struct mbof_val_array *gh_remove;
     struct mbof_mod_del_op *igh;
 
+    /* entries whose initgroups index must be dropped because the group id
+     * of the modified group changes */
+    const struct ldb_message_element *gidel;
+    const struct ldb_message_element *posixel;
+    struct ldb_dn **idx_dns;
+    int num_idx_dns;
+    int cur_idx_dn;
+
     struct ldb_message *msg;
     bool terminate;
 };
@@ -237,6 +257,9 @@ static int mbof_append_muop(TALLOC_CTX *memctx,
     int num_muops = *_num_muops;
     struct mbof_memberuid_op *op;
     struct ldb_val *val;
+    hash_value_t value;
+    hash_key_t key;
+    int ret;
     int i;
 
     op = NULL;
@@ -262,6 +285,8 @@ static int mbof_append_muop(TALLOC_CTX *memctx,
 
         op->dn = parent;
         op->el = NULL;
+        op->values_idx = NULL;
+        op->num_alloc = 0;
     }
 
     if (!op->el) {
@@ -274,27 +299,46 @@ static int mbof_append_muop(TALLOC_CTX *memctx,
             return LDB_ERR_OPERATIONS_ERROR;
         }
         op->el->flags = flags;
+
+        ret = hash_create_ex(0, &op->values_idx, 0, 0, 0, 0,
+                             hash_alloc, hash_free, op->el, NULL, NULL);
+        if (ret != HASH_SUCCESS) {
+            return LDB_ERR_OPERATIONS_ERROR;
+        }
     }
 
-    for (i = 0; i < op->el->num_values; i++) {
-        if (strcmp((char *)op->el->values[i].data, name) == 0) {
-            /* we already have this value, get out*/
-            return LDB_SUCCESS;
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(name);
+    if (hash_has_key(op->values_idx, &key)) {
+        /* we already have this value, get out*/
+        return LDB_SUCCESS;
+    }
+
+    if (op->el->num_values == op->num_alloc) {
+        /* groups can have many thousands of members, do not reallocate
+         * for every one of them */
+        val = talloc_realloc(op->el, op->el->values, struct ldb_val,
+                             MAX(16, op->num_alloc * 2));
+        if (!val) {
+            return LDB_ERR_OPERATIONS_ERROR;
         }
+        op->el->values = val;
+        op->num_alloc = talloc_array_length(val);
     }
 
-    val = talloc_realloc(op->el, op->el->values,
-                         struct ldb_val, op->el->num_values + 1);
-    if (!val) {
+    val = &op->el->values[op->el->num_values];
+    val->data = (uint8_t *)talloc_strdup(op->el->values, name);
+    if (!val->data) {
         return LDB_ERR_OPERATIONS_ERROR;
     }
-    val[op->el->num_values].data = (uint8_t *)talloc_strdup(val, name);
-    if (!val[op->el->num_values].data) {
+    val->length = strlen(name);
+
+    value.type = HASH_VALUE_UNDEF;
+    ret = hash_enter(op->values_idx, &key, &value);
+    if (ret != HASH_SUCCESS) {
         return LDB_ERR_OPERATIONS_ERROR;
     }
-    val[op->el->num_values].length = strlen(name);
 
-    op->el->values = val;
     op->el->num_values++;
 
     return LDB_SUCCESS;
@@ -346,25 +390,33 @@ static int mbof_append_addop(struct mbof_add_ctx *add_ctx,
                              struct mbof_dn_array *parents,
                              struct ldb_dn *entry_dn)
 {
-    struct mbof_add_operation *lastop = NULL;
     struct mbof_add_operation *addop;
+    hash_value_t value;
+    hash_key_t key;
+    const char *casefold;
+    int ret;
 
-    /* test if this is a duplicate */
-    /* FIXME: this is not efficient */
-    if (add_ctx->add_list) {
-        do {
-            if (lastop) {
-                lastop = lastop->next;
-            } else {
-                lastop = add_ctx->add_list;
-            }
+    if (add_ctx->add_idx == NULL) {
+        ret = hash_create_ex(0, &add_ctx->add_idx, 0, 0, 0, 0,
+                             hash_alloc, hash_free, add_ctx, NULL, NULL);
+        if (ret != HASH_SUCCESS) {
+            return LDB_ERR_OPERATIONS_ERROR;
+        }
+    }
 
-            /* FIXME: check if this is right, might have to compare parents */
-            if (ldb_dn_compare(lastop->entry_dn, entry_dn) == 0) {
-                /* duplicate found */
-                return LDB_SUCCESS;
-            }
-        } while (lastop->next);
+    /* same as ldb_dn_compare() */
+    casefold = ldb_dn_get_casefold(entry_dn);
+    if (casefold == NULL) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    /* test if this is a duplicate */
+    /* FIXME: check if this is right, might have to compare parents */
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(casefold);
+    if (hash_has_key(add_ctx->add_idx, &key)) {
+        /* duplicate found */
+        return LDB_SUCCESS;
     }
 
     addop = talloc_zero(add_ctx, struct mbof_add_operation);
@@ -376,11 +428,20 @@ static int mbof_append_addop(struct mbof_add_ctx *add_ctx,
     addop->parents = parents;
     addop->entry_dn = entry_dn;
 
+    value.type = HASH_VALUE_PTR;
+    value.ptr = addop;
+    ret = hash_enter(add_ctx->add_idx, &key, &value);
+    if (ret != HASH_SUCCESS) {
+        talloc_free(addop);
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
     if (add_ctx->add_list) {
-        lastop->next = addop;
+        add_ctx->add_last->next = addop;
     } else {
         add_ctx->add_list = addop;
     }
+    add_ctx->add_last = addop;
 
     return LDB_SUCCESS;
 }
@@ -2821,6 +2882,14 @@ static void free_delop_contents(struct mbof_del_operation *delop)
 
 static int mbof_mod_callback(struct ldb_request *req,
                              struct ldb_reply *ares);
+static int mbof_mod_check_gid(struct mbof_mod_ctx *mod_ctx);
+static int mbof_mod_search_index(struct mbof_mod_ctx *mod_ctx);
+static int mbof_mod_search_index_callback(struct ldb_request *req,
+                                          struct ldb_reply *ares);
+static int mbof_mod_drop_index(struct mbof_mod_ctx *mod_ctx);
+static int mbof_mod_drop_index_callback(struct ldb_request *req,
+                                        struct ldb_reply *ares);
+static int mbof_mod_members(struct mbof_mod_ctx *mod_ctx);
 static int mbof_collect_child_ghosts(struct mbof_mod_ctx *mod_ctx);
 static int mbof_get_ghost_from_parent(struct mbof_mod_del_op *igh);
 static int mbof_get_ghost_from_parent_cb(struct ldb_request *req,
@@ -2864,7 +2933,8 @@ static int memberof_mod(struct ldb_module *module, struct ldb_request *req)
     struct mbof_mod_ctx *mod_ctx;
     struct mbof_ctx *ctx;
     static const char *attrs[] = { DB_OC, DB_GHOST,
-                                   DB_MEMBER, DB_MEMBEROF, NULL};
+                                   DB_MEMBER, DB_MEMBEROF,
+                                   DB_GIDNUM, DB_POSIX, NULL};
     struct ldb_context *ldb = ldb_module_get_ctx(module);
     struct ldb_request *search;
     int ret;
@@ -2914,9 +2984,13 @@ static int memberof_mod(struct ldb_module *module, struct ldb_request *req)
 
     mod_ctx->membel = ldb_msg_find_element(mod_ctx->msg, DB_MEMBER);
     mod_ctx->ghel = ldb_msg_find_element(mod_ctx->msg, DB_GHOST);
+    mod_ctx->gidel = ldb_msg_find_element(mod_ctx->msg, DB_GIDNUM);
+    mod_ctx->posixel = ldb_msg_find_element(mod_ctx->msg, DB_POSIX);
 
-    /* continue with normal ops if there are no members and no ghosts */
-    if (mod_ctx->membel == NULL && mod_ctx->ghel == NULL) {
+    /* continue with normal ops if there are no members, no ghosts and
+     * the group id is not touched */
+    if (mod_ctx->membel == NULL && mod_ctx->ghel == NULL
+            && mod_ctx->gidel == NULL && mod_ctx->posixel == NULL) {
         mod_ctx->terminate = true;
         return mbof_orig_mod(mod_ctx);
     }
@@ -2990,17 +3064,255 @@ static int mbof_mod_callback(struct ldb_request *req,
                                    LDB_ERR_NO_SUCH_OBJECT);
         }
 
-        ret = mbof_collect_child_ghosts(mod_ctx);
+        ret = mbof_mod_check_gid(mod_ctx);
+        if (ret != LDB_SUCCESS) {
+            talloc_zfree(ares);
+            return ldb_module_done(ctx->req, NULL, NULL, ret);
+        }
+    }
+
+    talloc_zfree(ares);
+    return LDB_SUCCESS;
+}
+
+static bool mbof_el_changed(struct ldb_message *entry,
+                            const struct ldb_message_element *el)
+{
+    struct ldb_message_element *cur;
+    unsigned int i;
+
+    if (el == NULL) {
+        return false;
+    }
+
+    cur = ldb_msg_find_element(entry, el->name);
+
+    switch (el->flags & LDB_FLAG_MOD_MASK) {
+    case LDB_FLAG_MOD_REPLACE:
+        if (cur == NULL) {
+            return el->num_values != 0;
+        }
+        if (cur->num_values != el->num_values) {
+            return true;
+        }
+        for (i = 0; i < el->num_values; i++) {
+            if (ldb_msg_find_val(cur, &el->values[i]) == NULL) {
+                return true;
+            }
+        }
+        return false;
+    case LDB_FLAG_MOD_DELETE:
+        return cur != NULL;
+    default:
+        return true;
+    }
+}
+
+/* The initgroups index of the members of a group stores the group id, it
+ * must be dropped when the group id changes. Group stores usually replace
+ * the group id with the same value, so the current one is checked first. */
+static int mbof_mod_check_gid(struct mbof_mod_ctx *mod_ctx)
+{
+    const char *oc;
+
+    oc = ldb_msg_find_attr_as_string(mod_ctx->entry, DB_OC, NULL);
+    if (oc != NULL && strcmp(oc, DB_GROUP_CLASS) == 0
+            && (mbof_el_changed(mod_ctx->entry, mod_ctx->gidel)
+                || mbof_el_changed(mod_ctx->entry, mod_ctx->posixel))) {
+        return mbof_mod_search_index(mod_ctx);
+    }
+
+    return mbof_mod_members(mod_ctx);
+}
+
+static int mbof_mod_search_index(struct mbof_mod_ctx *mod_ctx)
+{
+    struct ldb_request *search;
+    struct ldb_context *ldb;
+    struct mbof_ctx *ctx;
+    static const char *attrs[] = { DB_NAME, NULL };
+    char *expression;
+    char *clean_dn;
+    const char *dn;
+    int ret;
+
+    ctx = mod_ctx->ctx;
+    ldb = ldb_module_get_ctx(ctx->module);
+
+    dn = ldb_dn_get_linearized(mod_ctx->entry->dn);
+    if (!dn) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    ret = sss_filter_sanitize(mod_ctx, dn, &clean_dn);
+    if (ret != 0) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    expression = talloc_asprintf(mod_ctx, "(&(%s=%s)(%s=*))",
+                                 DB_MEMBEROF, clean_dn, DB_INITGR_INDEX);
+    talloc_zfree(clean_dn);
+    if (!expression) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    ret = ldb_build_search_req(&search, ldb, mod_ctx,
+                               NULL, LDB_SCOPE_SUBTREE,
+                               expression, attrs, NULL,
+                               mod_ctx, mbof_mod_search_index_callback,
+                               ctx->req);
+    if (ret != LDB_SUCCESS) {
+        return ret;
+    }
+
+    return ldb_request(ldb, search);
+}
+
+static int mbof_mod_search_index_callback(struct ldb_request *req,
+                                          struct ldb_reply *ares)
+{
+    struct mbof_mod_ctx *mod_ctx;
+    struct mbof_ctx *ctx;
+    struct ldb_dn **dns;
+    int ret;
+
+    mod_ctx = talloc_get_type(req->context, struct mbof_mod_ctx);
+    ctx = mod_ctx->ctx;
+
+    if (!ares) {
+        return ldb_module_done(ctx->req, NULL, NULL,
+                               LDB_ERR_OPERATIONS_ERROR);
+    }
+    if (ares->error != LDB_SUCCESS) {
+        return ldb_module_done(ctx->req,
+                               ares->controls,
+                               ares->response,
+                               ares->error);
+    }
+
+    switch (ares->type) {
+    case LDB_REPLY_ENTRY:
+        dns = talloc_realloc(mod_ctx, mod_ctx->idx_dns, struct ldb_dn *,
+                             mod_ctx->num_idx_dns + 1);
+        if (!dns) {
+            talloc_zfree(ares);
+            return ldb_module_done(ctx->req, NULL, NULL,
+                                   LDB_ERR_OPERATIONS_ERROR);
+        }
+        mod_ctx->idx_dns = dns;
+        mod_ctx->idx_dns[mod_ctx->num_idx_dns] =
+                                talloc_steal(dns, ares->message->dn);
+        mod_ctx->num_idx_dns++;
+        break;
+
+    case LDB_REPLY_REFERRAL:
+        /* ignore */
+        break;
+
+    case LDB_REPLY_DONE:
+        ret = mbof_mod_drop_index(mod_ctx);
         if (ret != LDB_SUCCESS) {
             talloc_zfree(ares);
             return ldb_module_done(ctx->req, NULL, NULL, ret);
         }
+        break;
+    }
+
+    talloc_zfree(ares);
+    return LDB_SUCCESS;
+}
+
+static int mbof_mod_drop_index(struct mbof_mod_ctx *mod_ctx)
+{
+    struct ldb_request *mod_req;
+    struct ldb_context *ldb;
+    struct ldb_message *msg;
+    struct mbof_ctx *ctx;
+    int ret;
+
+    if (mod_ctx->cur_idx_dn >= mod_ctx->num_idx_dns) {
+        talloc_zfree(mod_ctx->idx_dns);
+        return mbof_mod_members(mod_ctx);
+    }
+
+    ctx = mod_ctx->ctx;
+    ldb = ldb_module_get_ctx(ctx->module);
+
+    msg = ldb_msg_new(mod_ctx);
+    if (!msg) return LDB_ERR_OPERATIONS_ERROR;
+
+    msg->dn = mod_ctx->idx_dns[mod_ctx->cur_idx_dn];
+
+    ret = ldb_msg_add_empty(msg, DB_INITGR_INDEX, LDB_FLAG_MOD_DELETE, NULL);
+    if (ret != LDB_SUCCESS) {
+        return ret;
+    }
+
+    ret = ldb_build_mod_req(&mod_req, ldb, mod_ctx,
+                            msg, NULL,
+                            mod_ctx, mbof_mod_drop_index_callback,
+                            ctx->req);
+    if (ret != LDB_SUCCESS) {
+        return ret;
+    }
+    talloc_steal(mod_req, msg);
+
+    return ldb_next_request(ctx->module, mod_req);
+}
+
+static int mbof_mod_drop_index_callback(struct ldb_request *req,
+                                        struct ldb_reply *ares)
+{
+    struct ldb_context *ldb;
+    struct mbof_mod_ctx *mod_ctx;
+    struct mbof_ctx *ctx;
+    int ret;
+
+    mod_ctx = talloc_get_type(req->context, struct mbof_mod_ctx);
+    ctx = mod_ctx->ctx;
+    ldb = ldb_module_get_ctx(ctx->module);
+
+    if (!ares) {
+        return ldb_module_done(ctx->req, NULL, NULL,
+                               LDB_ERR_OPERATIONS_ERROR);
+    }
+    if (ares->error != LDB_SUCCESS) {
+        return ldb_module_done(ctx->req,
+                               ares->controls,
+                               ares->response,
+                               ares->error);
+    }
+
+    if (ares->type != LDB_REPLY_DONE) {
+        talloc_zfree(ares);
+        ldb_debug(ldb, LDB_DEBUG_TRACE, "Invalid reply type!");
+        ldb_set_errstring(ldb, "Invalid reply type!");
+        return ldb_module_done(ctx->req, NULL, NULL,
+                               LDB_ERR_OPERATIONS_ERROR);
+    }
+
+    mod_ctx->cur_idx_dn++;
+    ret = mbof_mod_drop_index(mod_ctx);
+    if (ret != LDB_SUCCESS) {
+        talloc_zfree(ares);
+        return ldb_module_done(ctx->req, NULL, NULL, ret);
     }
 
     talloc_zfree(ares);
     return LDB_SUCCESS;
 }
 
+static int mbof_mod_members(struct mbof_mod_ctx *mod_ctx)
+{
+    /* continue with normal ops if there are no members and no ghosts */
+    if (mod_ctx->membel == NULL && mod_ctx->ghel == NULL) {
+        mod_ctx->terminate = true;
+        return mbof_orig_mod(mod_ctx);
+    }
+
+    return mbof_collect_child_ghosts(mod_ctx);
+}
+
 static int mbof_collect_child_ghosts(struct mbof_mod_ctx *mod_ctx)
 {
     int ret;
@@ -3416,6 +3728,208 @@ static int mbof_mod_process(struct mbof_mod_ctx *mod_ctx, bool *done)
     return LDB_SUCCESS;
 }
 
+/* Mark the keys that are both added and removed. Every removed key can
+ * cancel out one added key, as the nested loops this replaces did, but
+ * the keys are looked up in a hash table so replacing a member list of
+ * thousands of values does not take quadratic time. */
+static int mbof_find_unchanged(TALLOC_CTX *mem_ctx,
+                               const char **added, int num_added,
+                               const char **removed, int num_removed,
+                               bool **_added_unchanged,
+                               bool **_removed_unchanged)
+{
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *idx;
+    hash_value_t value;
+    hash_key_t key;
+    bool *added_unchanged;
+    bool *removed_unchanged;
+    int ret;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    added_unchanged = talloc_zero_array(tmp_ctx, bool, num_added);
+    removed_unchanged = talloc_zero_array(tmp_ctx, bool, num_removed);
+    if (added_unchanged == NULL || removed_unchanged == NULL) {
+        ret = LDB_ERR_OPERATIONS_ERROR;
+        goto done;
+    }
+
+    ret = hash_create_ex(num_removed, &idx, 0, 0, 0, 0,
+                         hash_alloc, hash_free, tmp_ctx, NULL, NULL);
+    if (ret != HASH_SUCCESS) {
+        ret = LDB_ERR_OPERATIONS_ERROR;
+        goto done;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_INT;
+    for (i = 0; i < num_removed; i++) {
+        key.str = discard_const(removed[i]);
+        if (hash_has_key(idx, &key)) {
+            continue;
+        }
+
+        value.i = i;
+        ret = hash_enter(idx, &key, &value);
+        if (ret != HASH_SUCCESS) {
+            ret = LDB_ERR_OPERATIONS_ERROR;
+            goto done;
+        }
+    }
+
+    for (i = 0; i < num_added; i++) {
+        key.str = discard_const(added[i]);
+        ret = hash_lookup(idx, &key, &value);
+        if (ret != HASH_SUCCESS || removed_unchanged[value.i]) {
+            continue;
+        }
+
+        removed_unchanged[value.i] = true;
+        added_unchanged[i] = true;
+    }
+
+    *_added_unchanged = talloc_steal(mem_ctx, added_unchanged);
+    *_removed_unchanged = talloc_steal(mem_ctx, removed_unchanged);
+    ret = LDB_SUCCESS;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* remove from arrays values that ended up unchanged */
+static int mbof_dn_array_drop_unchanged(struct mbof_dn_array *added,
+                                        struct mbof_dn_array *removed)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char **added_keys;
+    const char **removed_keys;
+    bool *added_unchanged;
+    bool *removed_unchanged;
+    int ret;
+    int i, j;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    added_keys = talloc_array(tmp_ctx, const char *, added->num);
+    removed_keys = talloc_array(tmp_ctx, const char *, removed->num);
+    if (added_keys == NULL || removed_keys == NULL) {
+        ret = LDB_ERR_OPERATIONS_ERROR;
+        goto done;
+    }
+
+    /* same as ldb_dn_compare() */
+    for (i = 0; i < added->num; i++) {
+        added_keys[i] = ldb_dn_get_casefold(added->dns[i]);
+        if (added_keys[i] == NULL) {
+            ret = LDB_ERR_OPERATIONS_ERROR;
+            goto done;
+        }
+    }
+
+    for (i = 0; i < removed->num; i++) {
+        removed_keys[i] = ldb_dn_get_casefold(removed->dns[i]);
+        if (removed_keys[i] == NULL) {
+            ret = LDB_ERR_OPERATIONS_ERROR;
+            goto done;
+        }
+    }
+
+    ret = mbof_find_unchanged(tmp_ctx, added_keys, added->num,
+                              removed_keys, removed->num,
+                              &added_unchanged, &removed_unchanged);
+    if (ret != LDB_SUCCESS) {
+        goto done;
+    }
+
+    for (i = 0, j = 0; i < added->num; i++) {
+        if (!added_unchanged[i]) {
+            added->dns[j++] = added->dns[i];
+        }
+    }
+    added->num = j;
+
+    for (i = 0, j = 0; i < removed->num; i++) {
+        if (!removed_unchanged[i]) {
+            removed->dns[j++] = removed->dns[i];
+        }
+    }
+    removed->num = j;
+
+    ret = LDB_SUCCESS;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static int mbof_val_array_drop_unchanged(struct mbof_val_array *added,
+                                         struct mbof_val_array *removed)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char **added_keys;
+    const char **removed_keys;
+    bool *added_unchanged;
+    bool *removed_unchanged;
+    int ret;
+    int i, j;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return LDB_ERR_OPERATIONS_ERROR;
+    }
+
+    added_keys = talloc_array(tmp_ctx, const char *, added->num);
+    removed_keys = talloc_array(tmp_ctx, const char *, removed->num);
+    if (added_keys == NULL || removed_keys == NULL) {
+        ret = LDB_ERR_OPERATIONS_ERROR;
+        goto done;
+    }
+
+    for (i = 0; i < added->num; i++) {
+        added_keys[i] = (const char *) added->vals[i].data;
+    }
+
+    for (i = 0; i < removed->num; i++) {
+        removed_keys[i] = (const char *) removed->vals[i].data;
+    }
+
+    ret = mbof_find_unchanged(tmp_ctx, added_keys, added->num,
+                              removed_keys, removed->num,
+                              &added_unchanged, &removed_unchanged);
+    if (ret != LDB_SUCCESS) {
+        goto done;
+    }
+
+    for (i = 0, j = 0; i < added->num; i++) {
+        if (!added_unchanged[i]) {
+            added->vals[j++] = added->vals[i];
+        }
+    }
+    added->num = j;
+
+    for (i = 0, j = 0; i < removed->num; i++) {
+        if (!removed_unchanged[i]) {
+            removed->vals[j++] = removed->vals[i];
+        }
+    }
+    removed->num = j;
+
+    ret = LDB_SUCCESS;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 static int mbof_mod_process_membel(TALLOC_CTX *mem_ctx,
                                    struct ldb_context *ldb,
                                    struct ldb_message *entry,
@@ -3426,7 +3940,7 @@ static int mbof_mod_process_membel(TALLOC_CTX *mem_ctx,
     const struct ldb_message_element *el;
     struct mbof_dn_array *removed = NULL;
     struct mbof_dn_array *added = NULL;
-    int i, j, ret;
+    int ret;
 
     if (!membel) {
         /* Nothing to do.. */
@@ -3484,24 +3998,11 @@ static int mbof_mod_process_membel(TALLOC_CTX *mem_ctx,
 
         /* remove from arrays values that ended up unchanged */
         if (removed && removed->num && added && added->num) {
-            for (i = 0; i < added->num; i++) {
-                for (j = 0; j < removed->num; j++) {
-                    if (ldb_dn_compare(added->dns[i], removed->dns[j]) == 0) {
-                        break;
-                    }
-                }
-                if (j < removed->num) {
-                    /* preexisting one, not removed, nor added */
-                    for (; j+1 < removed->num; j++) {
-                        removed->dns[j] = removed->dns[j+1];
-                    }
-                    removed->num--;
-                    for (j = i; j+1 < added->num; j++) {
-                        added->dns[j] = added->dns[j+1];
-                    }
-                    added->num--;
-                    i--;
-                }
+            ret = mbof_dn_array_drop_unchanged(added, removed);
+            if (ret != LDB_SUCCESS) {
+                talloc_free(added);
+                talloc_free(removed);
+                return ret;
             }
         }
         break;
@@ -3525,7 +4026,7 @@ static int mbof_mod_process_ghel(TALLOC_CTX *mem_ctx,
     const struct ldb_message_element *el;
     struct mbof_val_array *removed = NULL;
     struct mbof_val_array *added = NULL;
-    int i, j, ret;
+    int ret;
 
     if (!ghel) {
         /* Nothing to do.. */
@@ -3593,25 +4094,11 @@ static int mbof_mod_process_ghel(TALLOC_CTX *mem_ctx,
 
         /* remove from arrays values that ended up unchanged */
         if (removed && removed->num && added && added->num) {
-            for (i = 0; i < added->num; i++) {
-                for (j = 0; j < removed->num; j++) {
-                    if (strcmp((const char *) added->vals[i].data,
-                               (const char *) removed->vals[j].data) == 0) {
-                        break;
-                    }
-                }
-                if (j < removed->num) {
-                    /* preexisting one, not removed, nor added */
-                    for (; j+1 < removed->num; j++) {
-                        removed->vals[j] = removed->vals[j+1];
-                    }
-                    removed->num--;
-                    for (j = i; j+1 < added->num; j++) {
-                        added->vals[j] = added->vals[j+1];
-                    }
-                    added->num--;
-                    i--;
-                }
+            ret = mbof_val_array_drop_unchanged(added, removed);
+            if (ret != LDB_SUCCESS) {
+                talloc_free(added);
+                talloc_free(removed);
+                return ret;
             }
         }
         break;
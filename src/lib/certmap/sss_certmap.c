@@ -33,6 +33,7 @@
 #include "lib/certmap/sss_certmap_int.h"
 
 int debug_level;
+bool debug_backtrace_enabled;
 void sss_debug_fn(const char *file,
                   long line,
                   const char *function,
@@ -147,6 +148,42 @@ done:
     return ret;
 }
 
+static int add_issuer_patterns(struct sss_certmap_ctx *ctx,
+                               struct krb5_match_rule *parsed_match_rule)
+{
+    struct component_list *comp;
+    char **patterns;
+    size_t c;
+
+    for (comp = parsed_match_rule->issuer; comp != NULL; comp = comp->next) {
+        for (c = 0; c < ctx->num_issuer_patterns; c++) {
+            if (strcmp(ctx->issuer_patterns[c], comp->val) == 0) {
+                break;
+            }
+        }
+
+        if (c == ctx->num_issuer_patterns) {
+            patterns = talloc_realloc(ctx, ctx->issuer_patterns, char *,
+                                      ctx->num_issuer_patterns + 1);
+            if (patterns == NULL) {
+                return ENOMEM;
+            }
+            ctx->issuer_patterns = patterns;
+
+            ctx->issuer_patterns[c] = talloc_strdup(ctx->issuer_patterns,
+                                                    comp->val);
+            if (ctx->issuer_patterns[c] == NULL) {
+                return ENOMEM;
+            }
+            ctx->num_issuer_patterns++;
+        }
+
+        comp->pattern_idx = c;
+    }
+
+    return 0;
+}
+
 int sss_certmap_add_rule(struct sss_certmap_ctx *ctx,
                          uint32_t priority, const char *match_rule,
                          const char *map_rule, const char **domains)
@@ -225,6 +262,11 @@ int sss_certmap_add_rule(struct sss_certmap_ctx *ctx,
         }
     }
 
+    ret = add_issuer_patterns(ctx, rule->parsed_match_rule);
+    if (ret != 0) {
+        goto done;
+    }
+
     if (ctx->prio_list == NULL) {
         ctx->prio_list = talloc_zero(ctx, struct priority_list);
         if (ctx->prio_list == NULL) {
@@ -662,9 +704,41 @@ static bool do_san_match(struct sss_certmap_ctx *ctx,
     }
 }
 
+enum issuer_result {
+    ISSUER_UNKNOWN = 0,
+    ISSUER_MATCH,
+    ISSUER_NO_MATCH
+};
+
+static bool do_issuer_match(struct component_list *comp,
+                            struct sss_cert_content *cert_content,
+                            uint8_t *issuer_results)
+{
+    bool match;
+
+    if (issuer_results != NULL
+            && issuer_results[comp->pattern_idx] != ISSUER_UNKNOWN) {
+        return issuer_results[comp->pattern_idx] == ISSUER_MATCH;
+    }
+
+    match = (cert_content->issuer_str != NULL
+                && regexec(&(comp->regexp), cert_content->issuer_str,
+                           0, NULL, 0) == 0);
+
+    if (issuer_results != NULL) {
+        issuer_results[comp->pattern_idx] = match ? ISSUER_MATCH
+                                                  : ISSUER_NO_MATCH;
+    }
+
+    return match;
+}
+
+/* issuer_results caches the result of the issuer patterns of the context
+ * for the given certificate, it might be NULL. */
 static int do_match(struct sss_certmap_ctx *ctx,
                     struct krb5_match_rule *parsed_match_rule,
-                    struct sss_cert_content *cert_content)
+                    struct sss_cert_content *cert_content,
+                    uint8_t *issuer_results)
 {
     struct component_list *comp;
     bool match = false;
@@ -676,9 +750,7 @@ static int do_match(struct sss_certmap_ctx *ctx,
 
     /* Issuer */
     for (comp = parsed_match_rule->issuer; comp != NULL; comp = comp->next) {
-        match = (cert_content->issuer_str != NULL
-                    && regexec(&(comp->regexp), cert_content->issuer_str,
-                               0, NULL, 0) == 0);
+        match = do_issuer_match(comp, cert_content, issuer_results);
         if (match && parsed_match_rule->r == relation_or) {
             /* match */
             return 0;
@@ -754,29 +826,55 @@ static int do_match(struct sss_certmap_ctx *ctx,
     return ENOENT;
 }
 
-int sss_certmap_match_cert(struct sss_certmap_ctx *ctx,
-                           const uint8_t *der_cert, size_t der_size)
+static uint8_t *new_issuer_results(struct sss_certmap_ctx *ctx)
+{
+    if (ctx->num_issuer_patterns == 0) {
+        return NULL;
+    }
+
+    /* Without the cache every rule is still evaluated correctly. */
+    return talloc_zero_array(ctx, uint8_t, ctx->num_issuer_patterns);
+}
+
+int sss_certmap_parse_cert(TALLOC_CTX *mem_ctx,
+                           const uint8_t *der_cert, size_t der_size,
+                           struct sss_cert_content **content)
+{
+    if (der_cert == NULL || der_size == 0 || content == NULL) {
+        return EINVAL;
+    }
+
+    return sss_cert_get_content(mem_ctx, der_cert, der_size, content);
+}
+
+void sss_certmap_free_cert_content(struct sss_cert_content *content)
+{
+    talloc_free(content);
+}
+
+int sss_certmap_match_cert_content(struct sss_certmap_ctx *ctx,
+                                   struct sss_cert_content *cert_content)
 {
     int ret;
     struct match_map_rule *r;
     struct priority_list *p;
-    struct sss_cert_content *cert_content = NULL;
+    uint8_t *issuer_results;
 
-    ret = sss_cert_get_content(ctx, der_cert, der_size, &cert_content);
-    if (ret != 0) {
-        CM_DEBUG(ctx, "Failed to get certificate content.");
-        return ret;
+    if (ctx == NULL || cert_content == NULL) {
+        return EINVAL;
     }
 
     if (ctx->prio_list == NULL) {
         /* Match all certificates if there are no rules applied */
-        ret = 0;
-        goto done;
+        return 0;
     }
 
+    issuer_results = new_issuer_results(ctx);
+
     for (p = ctx->prio_list; p != NULL; p = p->next) {
         for (r = p->rule_list; r != NULL; r = r->next) {
-            ret = do_match(ctx, r->parsed_match_rule, cert_content);
+            ret = do_match(ctx, r->parsed_match_rule, cert_content,
+                           issuer_results);
             if (ret == 0) {
                 /* match */
                 goto done;
@@ -786,33 +884,46 @@ int sss_certmap_match_cert(struct sss_certmap_ctx *ctx,
 
     ret = ENOENT;
 done:
+    talloc_free(issuer_results);
+
+    return ret;
+}
+
+int sss_certmap_match_cert(struct sss_certmap_ctx *ctx,
+                           const uint8_t *der_cert, size_t der_size)
+{
+    int ret;
+    struct sss_cert_content *cert_content = NULL;
+
+    ret = sss_cert_get_content(ctx, der_cert, der_size, &cert_content);
+    if (ret != 0) {
+        CM_DEBUG(ctx, "Failed to get certificate content.");
+        return ret;
+    }
+
+    ret = sss_certmap_match_cert_content(ctx, cert_content);
     talloc_free(cert_content);
 
     return ret;
 }
 
-int sss_certmap_get_search_filter(struct sss_certmap_ctx *ctx,
-                                  const uint8_t *der_cert, size_t der_size,
-                                  char **_filter, char ***_domains)
+int sss_certmap_get_search_filter_content(struct sss_certmap_ctx *ctx,
+                                          struct sss_cert_content *cert_content,
+                                          char **_filter, char ***_domains)
 {
     int ret;
     struct match_map_rule *r;
     struct priority_list *p;
-    struct sss_cert_content *cert_content = NULL;
+    uint8_t *issuer_results = NULL;
     char *filter = NULL;
     char **domains = NULL;
     size_t c;
 
-    if (_filter == NULL || _domains == NULL) {
+    if (ctx == NULL || cert_content == NULL
+            || _filter == NULL || _domains == NULL) {
         return EINVAL;
     }
 
-    ret = sss_cert_get_content(ctx, der_cert, der_size, &cert_content);
-    if (ret != 0) {
-        CM_DEBUG(ctx, "Failed to get certificate content [%d].", ret);
-        return ret;
-    }
-
     if (ctx->prio_list == NULL) {
         if (ctx->default_mapping_rule == NULL) {
             CM_DEBUG(ctx, "No matching or mapping rules available.");
@@ -823,9 +934,12 @@ int sss_certmap_get_search_filter(struct sss_certmap_ctx *ctx,
         goto done;
     }
 
+    issuer_results = new_issuer_results(ctx);
+
     for (p = ctx->prio_list; p != NULL; p = p->next) {
         for (r = p->rule_list; r != NULL; r = r->next) {
-            ret = do_match(ctx, r->parsed_match_rule, cert_content);
+            ret = do_match(ctx, r->parsed_match_rule, cert_content,
+                           issuer_results);
             if (ret == 0) {
                 /* match */
                 ret = get_filter(ctx, r->parsed_mapping_rule, cert_content,
@@ -861,7 +975,7 @@ int sss_certmap_get_search_filter(struct sss_certmap_ctx *ctx,
     ret = ENOENT;
 
 done:
-    talloc_free(cert_content);
+    talloc_free(issuer_results);
     if (ret == 0) {
         *_filter = filter;
         *_domains = domains;
@@ -873,6 +987,30 @@ done:
     return ret;
 }
 
+int sss_certmap_get_search_filter(struct sss_certmap_ctx *ctx,
+                                  const uint8_t *der_cert, size_t der_size,
+                                  char **_filter, char ***_domains)
+{
+    int ret;
+    struct sss_cert_content *cert_content = NULL;
+
+    if (_filter == NULL || _domains == NULL) {
+        return EINVAL;
+    }
+
+    ret = sss_cert_get_content(ctx, der_cert, der_size, &cert_content);
+    if (ret != 0) {
+        CM_DEBUG(ctx, "Failed to get certificate content [%d].", ret);
+        return ret;
+    }
+
+    ret = sss_certmap_get_search_filter_content(ctx, cert_content,
+                                                _filter, _domains);
+    talloc_free(cert_content);
+
+    return ret;
+}
+
 int sss_certmap_init(TALLOC_CTX *mem_ctx,
                      sss_certmap_ext_debug *debug, void *debug_priv,
                      struct sss_certmap_ctx **ctx)
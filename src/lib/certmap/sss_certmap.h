@@ -41,6 +41,11 @@
  */
 struct sss_certmap_ctx;
 
+/**
+ * Opaque type for a parsed certificate
+ */
+struct sss_cert_content;
+
 /**
  * Lowest priority of a rule
  */
@@ -136,6 +141,71 @@ int sss_certmap_get_search_filter(struct sss_certmap_ctx *ctx,
                                   const uint8_t *der_cert, size_t der_size,
                                   char **filter, char ***domains);
 
+/**
+ * @brief Parse a certificate for repeated use
+ *
+ * Matching a certificate against the rules or getting the filter for it
+ * requires the parsed content of the certificate. If the same certificate is
+ * used more than once it can be parsed only once with this call.
+ *
+ * @param[in]  mem_ctx  Talloc memory context, may be NULL
+ * @param[in]  der_cert binary blog with the DER encoded certificate
+ * @param[in]  der_size size of the certificate blob
+ * @param[out] content  Parsed certificate, caller should free the data by
+ *                      calling sss_certmap_free_cert_content
+ *
+ * @return
+ *  - 0:      success
+ *  - EINVAL: certificate cannot be parsed
+ *  - ENOMEM: memory allocation failure
+ */
+int sss_certmap_parse_cert(TALLOC_CTX *mem_ctx,
+                           const uint8_t *der_cert, size_t der_size,
+                           struct sss_cert_content **content);
+
+/**
+ * @brief Free a certificate returned by @ref sss_certmap_parse_cert
+ *
+ * @param[in] content Parsed certificate, may be NULL
+ */
+void sss_certmap_free_cert_content(struct sss_cert_content *content);
+
+/**
+ * @brief Same as @ref sss_certmap_match_cert for a parsed certificate
+ *
+ * @param[in] ctx     certmap context previously initialized with
+ *                    @ref sss_certmap_init
+ * @param[in] content certificate parsed with @ref sss_certmap_parse_cert
+ *
+ * @return
+ *  - 0:      certificate matches a rule
+ *  - ENOENT: certificate does not match
+ *  - EINVAL: internal error
+ */
+int sss_certmap_match_cert_content(struct sss_certmap_ctx *ctx,
+                                   struct sss_cert_content *content);
+
+/**
+ * @brief Same as @ref sss_certmap_get_search_filter for a parsed certificate
+ *
+ * @param[in] ctx      certmap context previously initialized with
+ *                     @ref sss_certmap_init
+ * @param[in] content  certificate parsed with @ref sss_certmap_parse_cert
+ * @param[out] filter  LDAP filter string, caller should free the data by
+ *                     calling sss_certmap_free_filter_and_domains
+ * @param[out] domains NULL-terminated array of strings with the domains the
+ *                     rule applies, caller should free the data by calling
+ *                     sss_certmap_free_filter_and_domains
+ *
+ * @return
+ *  - 0:      certificate matches a rule
+ *  - ENOENT: certificate does not match
+ *  - EINVAL: internal error
+ */
+int sss_certmap_get_search_filter_content(struct sss_certmap_ctx *ctx,
+                                          struct sss_cert_content *content,
+                                          char **filter, char ***domains);
+
 /**
  * @brief Free data returned by @ref sss_certmap_get_search_filter
  *
@@ -81,6 +81,8 @@ struct component_list {
     char *str_other_name_oid;
     uint8_t *bin_val;
     size_t bin_val_len;
+    /* index of the value in issuer_patterns of the context, issuer only */
+    size_t pattern_idx;
     struct component_list *prev;
     struct component_list *next;
 };
@@ -141,6 +143,11 @@ struct sss_certmap_ctx {
     sss_certmap_ext_debug *debug;
     void *debug_priv;
     struct ldap_mapping_rule *default_mapping_rule;
+
+    /* Distinct issuer patterns of all rules. Many rules usually share the
+     * same issuer, every pattern is only evaluated once per certificate. */
+    char **issuer_patterns;
+    size_t num_issuer_patterns;
 };
 
 struct san_list {
@@ -24,6 +24,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <inttypes.h>
 
@@ -60,6 +61,38 @@ struct idmap_domain_info {
     void *pvt;
 };
 
+/* All slices of a domain SID. */
+struct idmap_sid_group {
+    const char *sid;
+    size_t sid_len;
+
+    /* in list order, i.e. the most recently added slice first */
+    struct idmap_domain_info **doms;
+    /* sorted by first_rid for a binary search if the RID ranges do not
+     * overlap */
+    struct idmap_domain_info **by_rid;
+    size_t num_doms;
+    bool rid_overlap;
+
+    /* sub-authorities after S-1-5-21 if sid is in canonical form, used to
+     * look up binary SIDs directly */
+    uint32_t bin_key[3];
+    bool has_bin_key;
+
+    struct idmap_sid_group *next;
+    struct idmap_sid_group *bin_next;
+};
+
+/* Hash table of the domain SIDs in idmap_domain_info. It is rebuilt
+ * whenever a domain is added, domains are never removed individually. */
+struct idmap_sid_index {
+    struct idmap_sid_group **buckets;
+    struct idmap_sid_group **bin_buckets;
+    uint32_t num_buckets;
+    struct idmap_sid_group *groups;
+    struct idmap_domain_info **doms;
+};
+
 static void *default_alloc(size_t size, void *pvt)
 {
     return malloc(size);
@@ -305,6 +338,237 @@ get_helper_by_id(struct idmap_range_params *helpers, const char *id)
     return NULL;
 }
 
+static void sid_index_free(struct sss_idmap_ctx *ctx,
+                           struct idmap_sid_index *index)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    ctx->free_func(index->buckets, ctx->alloc_pvt);
+    ctx->free_func(index->bin_buckets, ctx->alloc_pvt);
+    ctx->free_func(index->groups, ctx->alloc_pvt);
+    ctx->free_func(index->doms, ctx->alloc_pvt);
+    ctx->free_func(index, ctx->alloc_pvt);
+}
+
+static struct idmap_sid_group *sid_index_find(struct idmap_sid_index *index,
+                                              const char *sid, size_t sid_len)
+{
+    struct idmap_sid_group *group;
+    uint32_t hash;
+
+    hash = murmurhash3(sid, sid_len, 0xdeadbeef);
+
+    for (group = index->buckets[hash & (index->num_buckets - 1)];
+         group != NULL;
+         group = group->next) {
+        if (group->sid_len == sid_len
+                && strncmp(group->sid, sid, sid_len) == 0) {
+            return group;
+        }
+    }
+
+    return NULL;
+}
+
+static struct idmap_sid_group *
+sid_index_find_bin(struct idmap_sid_index *index, const uint32_t key[3])
+{
+    struct idmap_sid_group *group;
+    uint32_t hash;
+
+    hash = murmurhash3((const char *) key, 3 * sizeof(uint32_t), 0xdeadbeef);
+
+    for (group = index->bin_buckets[hash & (index->num_buckets - 1)];
+         group != NULL;
+         group = group->bin_next) {
+        if (memcmp(group->bin_key, key, 3 * sizeof(uint32_t)) == 0) {
+            return group;
+        }
+    }
+
+    return NULL;
+}
+
+/* Only a domain SID which is written exactly like the string generated from
+ * a binary SID can match a binary SID. */
+static bool sid_bin_key(const char *sid, uint32_t key[3])
+{
+    char buf[DOM_SID_PREFIX_LEN + 3 * 11 + 1];
+    unsigned long val[3];
+    int ret;
+
+    ret = sscanf(sid, DOM_SID_PREFIX"%lu-%lu-%lu", &val[0], &val[1], &val[2]);
+    if (ret != 3 || val[0] > UINT32_MAX || val[1] > UINT32_MAX
+            || val[2] > UINT32_MAX) {
+        return false;
+    }
+
+    ret = snprintf(buf, sizeof(buf), DOM_SID_PREFIX"%lu-%lu-%lu",
+                   val[0], val[1], val[2]);
+    if (ret < 0 || (size_t) ret >= sizeof(buf) || strcmp(buf, sid) != 0) {
+        return false;
+    }
+
+    key[0] = val[0];
+    key[1] = val[1];
+    key[2] = val[2];
+    return true;
+}
+
+static int by_rid_cmp(const void *a, const void *b)
+{
+    const struct idmap_domain_info *da = *(struct idmap_domain_info * const *)a;
+    const struct idmap_domain_info *db = *(struct idmap_domain_info * const *)b;
+
+    if (da->range_params.first_rid < db->range_params.first_rid) {
+        return -1;
+    }
+
+    return da->range_params.first_rid > db->range_params.first_rid ? 1 : 0;
+}
+
+static void sid_group_sort(struct idmap_sid_group *group)
+{
+    struct idmap_domain_info *dom;
+    uint64_t last_rid = 0;
+    size_t c;
+
+    memcpy(group->by_rid, group->doms,
+           group->num_doms * sizeof(struct idmap_domain_info *));
+    qsort(group->by_rid, group->num_doms, sizeof(struct idmap_domain_info *),
+          by_rid_cmp);
+
+    group->rid_overlap = false;
+    for (c = 0; c < group->num_doms; c++) {
+        dom = group->by_rid[c];
+
+        if (c > 0 && dom->range_params.first_rid <= last_rid) {
+            group->rid_overlap = true;
+        }
+
+        if (c == 0 || dom->range_params.first_rid
+                            + (uint64_t) (dom->range_params.max_id
+                                          - dom->range_params.min_id)
+                        > last_rid) {
+            last_rid = dom->range_params.first_rid
+                            + (uint64_t) (dom->range_params.max_id
+                                          - dom->range_params.min_id);
+        }
+    }
+}
+
+static void sid_index_rebuild(struct sss_idmap_ctx *ctx)
+{
+    struct idmap_sid_index *index;
+    struct idmap_sid_group *group;
+    struct idmap_domain_info *dom;
+    size_t num_doms = 0;
+    size_t num_groups = 0;
+    size_t offset;
+    size_t len;
+    uint32_t hash;
+    size_t c;
+
+    sid_index_free(ctx, ctx->sid_index);
+    ctx->sid_index = NULL;
+
+    for (dom = ctx->idmap_domain_info; dom != NULL; dom = dom->next) {
+        if (dom->sid != NULL) {
+            num_doms++;
+        }
+    }
+
+    if (num_doms == 0) {
+        return;
+    }
+
+    index = ctx->alloc_func(sizeof(struct idmap_sid_index), ctx->alloc_pvt);
+    if (index == NULL) {
+        return;
+    }
+    memset(index, 0, sizeof(struct idmap_sid_index));
+
+    for (index->num_buckets = 16;
+         index->num_buckets < 2 * num_doms;
+         index->num_buckets *= 2);
+
+    index->buckets = ctx->alloc_func(index->num_buckets
+                                            * sizeof(struct idmap_sid_group *),
+                                     ctx->alloc_pvt);
+    index->bin_buckets = ctx->alloc_func(index->num_buckets
+                                            * sizeof(struct idmap_sid_group *),
+                                         ctx->alloc_pvt);
+    index->groups = ctx->alloc_func(num_doms * sizeof(struct idmap_sid_group),
+                                    ctx->alloc_pvt);
+    index->doms = ctx->alloc_func(2 * num_doms
+                                        * sizeof(struct idmap_domain_info *),
+                                  ctx->alloc_pvt);
+    if (index->buckets == NULL || index->bin_buckets == NULL
+            || index->groups == NULL || index->doms == NULL) {
+        /* sss_idmap_sid_to_unix() falls back to the list */
+        sid_index_free(ctx, index);
+        return;
+    }
+    memset(index->buckets, 0,
+           index->num_buckets * sizeof(struct idmap_sid_group *));
+    memset(index->bin_buckets, 0,
+           index->num_buckets * sizeof(struct idmap_sid_group *));
+
+    /* Count the slices of each domain SID ... */
+    for (dom = ctx->idmap_domain_info; dom != NULL; dom = dom->next) {
+        if (dom->sid == NULL) {
+            continue;
+        }
+
+        len = strlen(dom->sid);
+        group = sid_index_find(index, dom->sid, len);
+        if (group == NULL) {
+            group = &index->groups[num_groups++];
+            memset(group, 0, sizeof(struct idmap_sid_group));
+            group->sid = dom->sid;
+            group->sid_len = len;
+
+            hash = murmurhash3(dom->sid, len, 0xdeadbeef);
+            group->next = index->buckets[hash & (index->num_buckets - 1)];
+            index->buckets[hash & (index->num_buckets - 1)] = group;
+
+            group->has_bin_key = sid_bin_key(dom->sid, group->bin_key);
+            if (group->has_bin_key) {
+                hash = murmurhash3((const char *) group->bin_key,
+                                   3 * sizeof(uint32_t), 0xdeadbeef);
+                group->bin_next =
+                            index->bin_buckets[hash & (index->num_buckets - 1)];
+                index->bin_buckets[hash & (index->num_buckets - 1)] = group;
+            }
+        }
+        group->num_doms++;
+    }
+
+    offset = 0;
+    for (c = 0; c < num_groups; c++) {
+        index->groups[c].doms = &index->doms[offset];
+        index->groups[c].by_rid = &index->doms[num_doms + offset];
+        offset += index->groups[c].num_doms;
+        index->groups[c].num_doms = 0;
+    }
+
+    /* ... and add them in list order. */
+    for (dom = ctx->idmap_domain_info; dom != NULL; dom = dom->next) {
+        if (dom->sid != NULL) {
+            group = sid_index_find(index, dom->sid, strlen(dom->sid));
+            group->doms[group->num_doms++] = dom;
+        }
+    }
+
+    for (c = 0; c < num_groups; c++) {
+        sid_group_sort(&index->groups[c]);
+    }
+
+    ctx->sid_index = index;
+}
+
 static void sss_idmap_free_domain(struct sss_idmap_ctx *ctx,
                                   struct idmap_domain_info *dom)
 {
@@ -335,6 +599,7 @@ enum idmap_error_code sss_idmap_free(struct sss_idmap_ctx *ctx)
         sss_idmap_free_domain(ctx, dom);
     }
 
+    sid_index_free(ctx, ctx->sid_index);
     ctx->free_func(ctx, ctx->alloc_pvt);
 
     return IDMAP_SUCCESS;
@@ -796,6 +1061,8 @@ enum idmap_error_code sss_idmap_add_domain_ex(struct sss_idmap_ctx *ctx,
     dom->next = ctx->idmap_domain_info;
     ctx->idmap_domain_info = dom;
 
+    sid_index_rebuild(ctx);
+
     return IDMAP_SUCCESS;
 
 fail:
@@ -1041,18 +1308,12 @@ spawn_dom(struct sss_idmap_ctx *ctx,
 static enum idmap_error_code
 add_dom_for_sid(struct sss_idmap_ctx *ctx,
                 struct idmap_domain_info *matched_dom,
-                const char *sid,
+                long long rid,
                 uint32_t *_id)
 {
     enum idmap_error_code err;
-    long long rid;
     struct idmap_range_params *range = NULL;
 
-    if (parse_rid(sid, strlen(matched_dom->sid), &rid) == false) {
-        err = IDMAP_SID_INVALID;
-        goto done;
-    }
-
     err = get_range(ctx, matched_dom->helpers, matched_dom->sid, rid, &range);
     if (err != IDMAP_SUCCESS) {
         goto done;
@@ -1078,6 +1339,174 @@ done:
     return err;
 }
 
+/* The caller has to check external mapping of the group before rid is
+ * parsed, like the list walk does. */
+static enum idmap_error_code
+sid_group_to_unix(struct sss_idmap_ctx *ctx,
+                  struct idmap_sid_group *group,
+                  long long rid,
+                  uint32_t *_id)
+{
+    struct idmap_domain_info *dom;
+    size_t first;
+    size_t last;
+    size_t mid;
+    size_t c;
+
+    if (group->rid_overlap) {
+        /* The first matching slice in list order wins. */
+        for (c = 0; c < group->num_doms; c++) {
+            if (group->doms[c]->external_mapping == true) {
+                return IDMAP_EXTERNAL;
+            }
+
+            if (comp_id(&group->doms[c]->range_params, rid, _id)) {
+                return IDMAP_SUCCESS;
+            }
+        }
+    } else {
+        /* Only the slice with the largest first_rid not above rid can
+         * contain rid. */
+        first = 0;
+        last = group->num_doms;
+        while (first < last) {
+            mid = first + (last - first) / 2;
+            if (group->by_rid[mid]->range_params.first_rid <= rid) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+
+        if (first > 0
+                && comp_id(&group->by_rid[first - 1]->range_params, rid, _id)) {
+            return IDMAP_SUCCESS;
+        }
+    }
+
+    /* The oldest slice is the primary one which owns the helpers. */
+    dom = group->doms[group->num_doms - 1];
+    if (dom->auto_add_ranges) {
+        return add_dom_for_sid(ctx, dom, rid, _id);
+    }
+
+    return IDMAP_NO_RANGE;
+}
+
+/* Domain SIDs are looked up by the part of sid before the RID. A SID which
+ * only matches in a shorter prefix has additional sub-authorities and is
+ * not a valid SID of that domain. */
+static enum idmap_error_code
+sid_index_to_unix(struct sss_idmap_ctx *ctx,
+                  const char *sid,
+                  uint32_t *_id)
+{
+    struct idmap_sid_group *group;
+    const char *p;
+    long long rid;
+
+    p = strrchr(sid, '-');
+    if (p == NULL) {
+        return IDMAP_NO_DOMAIN;
+    }
+
+    group = sid_index_find(ctx->sid_index, sid, p - sid);
+    if (group != NULL) {
+        if (group->doms[0]->external_mapping == true) {
+            return IDMAP_EXTERNAL;
+        }
+
+        if (parse_rid(sid, group->sid_len, &rid) == false) {
+            return IDMAP_SID_INVALID;
+        }
+
+        return sid_group_to_unix(ctx, group, rid, _id);
+    }
+
+    for (p = strchr(sid, '-'); p != NULL; p = strchr(p + 1, '-')) {
+        group = sid_index_find(ctx->sid_index, sid, p - sid);
+        if (group != NULL) {
+            return group->doms[0]->external_mapping ? IDMAP_EXTERNAL
+                                                    : IDMAP_SID_INVALID;
+        }
+    }
+
+    return IDMAP_NO_DOMAIN;
+}
+
+/* Binary SIDs are read directly, see sss_idmap_bin_sid_to_dom_sid() for the
+ * layout. Only the sub-authorities of S-1-5-21 domain SIDs are compared so
+ * the string representation is never needed. */
+#define BIN_SID_HEADER_LEN 8
+#define BIN_SID_MAX_SUB_AUTHS 15
+
+static uint32_t bin_sid_sub_auth(const uint8_t *bin_sid, size_t c)
+{
+    const uint8_t *p = bin_sid + BIN_SID_HEADER_LEN + 4 * c;
+
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static enum idmap_error_code
+sid_index_bin_to_unix(struct sss_idmap_ctx *ctx,
+                      const uint8_t *bin_sid,
+                      size_t length,
+                      uint32_t *_id)
+{
+    struct idmap_sid_group *group;
+    uint32_t key[3];
+    uint32_t id_auth;
+    size_t num_auths;
+    size_t c;
+
+    if (bin_sid == NULL || length < BIN_SID_HEADER_LEN) {
+        return IDMAP_SID_INVALID;
+    }
+
+    num_auths = bin_sid[1];
+    if (num_auths > BIN_SID_MAX_SUB_AUTHS
+            || length < BIN_SID_HEADER_LEN + 4 * num_auths
+            || length > BIN_SID_HEADER_LEN + 4 * BIN_SID_MAX_SUB_AUTHS) {
+        return IDMAP_SID_INVALID;
+    }
+
+    /* Only 32bits are used for the string representation */
+    id_auth = ((uint32_t) bin_sid[4] << 24) | (bin_sid[5] << 16)
+                    | (bin_sid[6] << 8) | bin_sid[7];
+    if (bin_sid[0] != 1 || id_auth != 5 || num_auths < 2) {
+        return IDMAP_NO_DOMAIN;
+    }
+
+    /* S-1-5-32-... */
+    if (bin_sid_sub_auth(bin_sid, 0) == 32) {
+        return IDMAP_BUILTIN_SID;
+    }
+
+    /* S-1-5-21-a-b-c-rid */
+    if (bin_sid_sub_auth(bin_sid, 0) != 21 || num_auths < 5) {
+        return IDMAP_NO_DOMAIN;
+    }
+
+    for (c = 0; c < 3; c++) {
+        key[c] = bin_sid_sub_auth(bin_sid, c + 1);
+    }
+
+    group = sid_index_find_bin(ctx->sid_index, key);
+    if (group == NULL) {
+        return IDMAP_NO_DOMAIN;
+    }
+
+    if (group->doms[0]->external_mapping == true) {
+        return IDMAP_EXTERNAL;
+    }
+
+    if (num_auths != 5) {
+        return IDMAP_SID_INVALID;
+    }
+
+    return sid_group_to_unix(ctx, group, bin_sid_sub_auth(bin_sid, 4), _id);
+}
+
 enum idmap_error_code sss_idmap_sid_to_unix(struct sss_idmap_ctx *ctx,
                                             const char *sid,
                                             uint32_t *_id)
@@ -1099,6 +1528,10 @@ enum idmap_error_code sss_idmap_sid_to_unix(struct sss_idmap_ctx *ctx,
         return IDMAP_BUILTIN_SID;
     }
 
+    if (ctx->sid_index != NULL) {
+        return sid_index_to_unix(ctx, sid, _id);
+    }
+
     /* Try primary slices */
     while (idmap_domain_info != NULL) {
 
@@ -1123,7 +1556,7 @@ enum idmap_error_code sss_idmap_sid_to_unix(struct sss_idmap_ctx *ctx,
     }
 
     if (matched_dom != NULL && matched_dom->auto_add_ranges) {
-        return add_dom_for_sid(ctx, matched_dom, sid, _id);
+        return add_dom_for_sid(ctx, matched_dom, rid, _id);
     }
 
     return matched_dom ? IDMAP_NO_RANGE : IDMAP_NO_DOMAIN;
@@ -1292,10 +1725,18 @@ enum idmap_error_code sss_idmap_bin_sid_to_unix(struct sss_idmap_ctx *ctx,
                                                 uint32_t *id)
 {
     enum idmap_error_code err;
-    char *sid;
+    char *sid = NULL;
 
     CHECK_IDMAP_CTX(ctx, IDMAP_CONTEXT_INVALID);
 
+    if (id == NULL) {
+        return IDMAP_ERROR;
+    }
+
+    if (ctx->sid_index != NULL) {
+        return sid_index_bin_to_unix(ctx, bin_sid, length, id);
+    }
+
     err = sss_idmap_bin_sid_to_sid(ctx, bin_sid, length, &sid);
     if (err != IDMAP_SUCCESS) {
         goto done;
@@ -1309,6 +1750,30 @@ done:
     return err;
 }
 
+enum idmap_error_code sss_idmap_bin_sids_to_unix(struct sss_idmap_ctx *ctx,
+                                                 uint8_t **bin_sids,
+                                                 size_t *lengths,
+                                                 size_t count,
+                                                 uint32_t *ids,
+                                                 enum idmap_error_code *errs)
+{
+    size_t c;
+
+    CHECK_IDMAP_CTX(ctx, IDMAP_CONTEXT_INVALID);
+
+    if ((bin_sids == NULL || lengths == NULL || ids == NULL || errs == NULL)
+            && count != 0) {
+        return IDMAP_ERROR;
+    }
+
+    for (c = 0; c < count; c++) {
+        errs[c] = sss_idmap_bin_sid_to_unix(ctx, bin_sids[c], lengths[c],
+                                            &ids[c]);
+    }
+
+    return IDMAP_SUCCESS;
+}
+
 enum idmap_error_code sss_idmap_smb_sid_to_unix(struct sss_idmap_ctx *ctx,
                                                 struct dom_sid *smb_sid,
                                                 uint32_t *id)
@@ -479,6 +479,32 @@ enum idmap_error_code sss_idmap_bin_sid_to_unix(struct sss_idmap_ctx *ctx,
                                                 size_t length,
                                                 uint32_t *id);
 
+/**
+ * @brief Translate a list of binary SIDs to unix UIDs or GIDs
+ *
+ * The SIDs are not converted to strings, the domain part of each binary SID
+ * is looked up directly.
+ *
+ * @param[in] ctx      Idmap context
+ * @param[in] bin_sids Array of binary SIDs
+ * @param[in] lengths  Sizes of the binary SIDs
+ * @param[in] count    Number of binary SIDs
+ * @param[out] ids     Returned unix UIDs or GIDs, must hold count elements
+ * @param[out] errs    Result of each translation as returned by
+ *                     sss_idmap_bin_sid_to_unix(), must hold count elements
+ *
+ * @return
+ *  - #IDMAP_SUCCESS:           All SIDs were processed, see errs
+ *  - #IDMAP_ERROR:             Invalid parameters
+ *  - #IDMAP_CONTEXT_INVALID:   Provided context is invalid
+ */
+enum idmap_error_code sss_idmap_bin_sids_to_unix(struct sss_idmap_ctx *ctx,
+                                                 uint8_t **bin_sids,
+                                                 size_t *lengths,
+                                                 size_t count,
+                                                 uint32_t *ids,
+                                                 enum idmap_error_code *errs);
+
 /**
  * @brief Translate a Samba dom_sid stucture to a unix UID or GID
  *
@@ -87,6 +87,50 @@ enum hbac_eval_result_int {
     HBAC_EVAL_UNMATCHED
 };
 
+/* Rule and request elements in the order they are evaluated */
+enum hbac_element_type {
+    HBAC_ELEMENT_USERS,
+    HBAC_ELEMENT_SERVICES,
+    HBAC_ELEMENT_TARGETHOSTS,
+    HBAC_ELEMENT_SRCHOSTS,
+
+    HBAC_ELEMENT_NUM
+};
+
+#define HBAC_ELEMENTS_ALL ((1 << HBAC_ELEMENT_NUM) - 1)
+
+#define HBAC_INDEX_END UINT32_MAX
+
+/* A name or group of one rule element, nodes with the same hash bucket
+ * are chained through their index in the node array. */
+struct hbac_index_node {
+    const char *name;
+    uint32_t hash;
+    uint32_t rule;
+    uint32_t next;
+};
+
+struct hbac_index {
+    uint32_t *buckets;
+    uint32_t num_buckets;
+    struct hbac_index_node *nodes;
+    uint32_t num_nodes;
+};
+
+struct hbac_compiled_rules {
+    struct hbac_rule **rules;
+    uint32_t num_rules;
+
+    /* Bitmask of the elements of each rule that match any request. Rules
+     * that cannot be indexed have all bits set, so they are always
+     * evaluated in full. */
+    uint8_t *matched;
+
+    /* Names and groups of each element type */
+    struct hbac_index names[HBAC_ELEMENT_NUM];
+    struct hbac_index groups[HBAC_ELEMENT_NUM];
+};
+
 static bool hbac_rule_element_is_complete(struct hbac_rule_element *el)
 {
     if (el == NULL) return false;
@@ -142,9 +186,12 @@ enum hbac_eval_result_int hbac_evaluate_rule(struct hbac_rule *rule,
                                              struct hbac_eval_req *hbac_req,
                                              enum hbac_error_code *error);
 
-enum hbac_eval_result hbac_evaluate(struct hbac_rule **rules,
-                                    struct hbac_eval_req *hbac_req,
-                                    struct hbac_info **info)
+/* Evaluate the rules in order, if matched is set, only the rules whose
+ * every element may match are evaluated. */
+static enum hbac_eval_result hbac_evaluate_rule_list(struct hbac_rule **rules,
+                                                     const uint8_t *matched,
+                                                     struct hbac_eval_req *hbac_req,
+                                                     struct hbac_info **info)
 {
     uint32_t i;
 
@@ -152,9 +199,6 @@ enum hbac_eval_result hbac_evaluate(struct hbac_rule **rules,
     enum hbac_eval_result result = HBAC_EVAL_DENY;
     enum hbac_eval_result_int intermediate_result;
 
-    HBAC_DEBUG(HBAC_DBG_INFO, "[< hbac_evaluate()\n");
-    hbac_req_debug_print(hbac_req);
-
     if (info) {
         *info = malloc(sizeof(struct hbac_info));
         if (!*info) {
@@ -166,6 +210,11 @@ enum hbac_eval_result hbac_evaluate(struct hbac_rule **rules,
     }
 
     for (i = 0; rules[i]; i++) {
+        if (matched != NULL && matched[i] != HBAC_ELEMENTS_ALL) {
+            /* Some element of this rule cannot match the request */
+            continue;
+        }
+
         hbac_rule_debug_print(rules[i]);
         intermediate_result = hbac_evaluate_rule(rules[i], hbac_req, &ret);
         if (intermediate_result == HBAC_EVAL_UNMATCHED) {
@@ -207,8 +256,27 @@ enum hbac_eval_result hbac_evaluate(struct hbac_rule **rules,
      * result to ALLOW explicitly or we'll stick with the default DENY.
      */
 done:
+    return result;
+}
 
-    HBAC_DEBUG(HBAC_DBG_INFO, "hbac_evaluate() >]\n");
+enum hbac_eval_result hbac_evaluate(struct hbac_rule **rules,
+                                    struct hbac_eval_req *hbac_req,
+                                    struct hbac_info **info)
+{
+    struct hbac_compiled_rules *compiled;
+    enum hbac_error_code ret;
+    enum hbac_eval_result result;
+
+    ret = hbac_compile_rules(rules, &compiled);
+    if (ret == HBAC_ERROR_OUT_OF_MEMORY) {
+        return HBAC_EVAL_OOM;
+    } else if (ret != HBAC_SUCCESS) {
+        return HBAC_EVAL_ERROR;
+    }
+
+    result = hbac_evaluate_compiled(compiled, hbac_req, info);
+
+    hbac_free_compiled_rules(compiled);
     return result;
 }
 
@@ -356,6 +424,407 @@ static errno_t hbac_evaluate_element(struct hbac_rule_element *rule_el,
     return EOK;
 }
 
+static struct hbac_rule_element *
+hbac_rule_get_element(struct hbac_rule *rule, enum hbac_element_type type)
+{
+    switch (type) {
+    case HBAC_ELEMENT_USERS:
+        return rule->users;
+    case HBAC_ELEMENT_SERVICES:
+        return rule->services;
+    case HBAC_ELEMENT_TARGETHOSTS:
+        return rule->targethosts;
+    case HBAC_ELEMENT_SRCHOSTS:
+        return rule->srchosts;
+    case HBAC_ELEMENT_NUM:
+        break;
+    }
+
+    return NULL;
+}
+
+static struct hbac_request_element *
+hbac_req_get_element(struct hbac_eval_req *req, enum hbac_element_type type)
+{
+    switch (type) {
+    case HBAC_ELEMENT_USERS:
+        return req->user;
+    case HBAC_ELEMENT_SERVICES:
+        return req->service;
+    case HBAC_ELEMENT_TARGETHOSTS:
+        return req->targethost;
+    case HBAC_ELEMENT_SRCHOSTS:
+        return req->srchost;
+    case HBAC_ELEMENT_NUM:
+        break;
+    }
+
+    return NULL;
+}
+
+static bool hbac_name_is_ascii(const char *name)
+{
+    return sss_utf8_is_ascii((const uint8_t *) name, strlen(name));
+}
+
+static bool hbac_names_are_ascii(const char **names)
+{
+    size_t i;
+
+    if (names == NULL) {
+        return true;
+    }
+
+    for (i = 0; names[i]; i++) {
+        if (!hbac_name_is_ascii(names[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Names are compared case-insensitively, the ASCII only names that are
+ * indexed are hashed as lower case. */
+static uint32_t hbac_name_hash(const char *name)
+{
+    const unsigned char *p;
+    unsigned char c;
+    uint32_t hash = 2166136261U;
+
+    for (p = (const unsigned char *) name; *p != '\0'; p++) {
+        c = *p;
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+
+        hash ^= c;
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/* Non-ASCII names may match ASCII names after case folding, so rules
+ * that contain them are not indexed. Neither are incomplete rules, they
+ * must fail in the same order as before. */
+static bool hbac_rule_is_indexable(struct hbac_rule *rule)
+{
+    struct hbac_rule_element *el;
+    int type;
+
+    for (type = 0; type < HBAC_ELEMENT_NUM; type++) {
+        el = hbac_rule_get_element(rule, type);
+        if (el == NULL) {
+            return false;
+        }
+
+        if (el->category & HBAC_CATEGORY_ALL) {
+            continue;
+        }
+
+        if (!hbac_names_are_ascii(el->names)
+                || !hbac_names_are_ascii(el->groups)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool hbac_req_is_ascii(struct hbac_eval_req *req)
+{
+    struct hbac_request_element *el;
+    int type;
+
+    for (type = 0; type < HBAC_ELEMENT_NUM; type++) {
+        el = hbac_req_get_element(req, type);
+        if (el == NULL) {
+            continue;
+        }
+
+        if (el->name != NULL && !hbac_name_is_ascii(el->name)) {
+            return false;
+        }
+
+        if (!hbac_names_are_ascii(el->groups)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void hbac_index_count(struct hbac_index *index, const char **names)
+{
+    size_t i;
+
+    if (names == NULL) {
+        return;
+    }
+
+    for (i = 0; names[i]; i++) {
+        index->num_nodes++;
+    }
+}
+
+static errno_t hbac_index_alloc(struct hbac_index *index)
+{
+    uint32_t i;
+
+    if (index->num_nodes == 0) {
+        return EOK;
+    }
+
+    index->num_buckets = 1;
+    while (index->num_buckets < index->num_nodes) {
+        index->num_buckets <<= 1;
+    }
+
+    index->buckets = malloc(index->num_buckets * sizeof(uint32_t));
+    index->nodes = malloc(index->num_nodes * sizeof(struct hbac_index_node));
+    if (index->buckets == NULL || index->nodes == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < index->num_buckets; i++) {
+        index->buckets[i] = HBAC_INDEX_END;
+    }
+
+    /* Counts the nodes again while they are added */
+    index->num_nodes = 0;
+
+    return EOK;
+}
+
+static void hbac_index_add(struct hbac_index *index,
+                           const char **names,
+                           uint32_t rule)
+{
+    struct hbac_index_node *node;
+    uint32_t bucket;
+    size_t i;
+
+    if (names == NULL) {
+        return;
+    }
+
+    for (i = 0; names[i]; i++) {
+        node = &index->nodes[index->num_nodes];
+        node->name = names[i];
+        node->hash = hbac_name_hash(names[i]);
+        node->rule = rule;
+
+        bucket = node->hash & (index->num_buckets - 1);
+        node->next = index->buckets[bucket];
+        index->buckets[bucket] = index->num_nodes;
+        index->num_nodes++;
+    }
+}
+
+static void hbac_index_match(struct hbac_index *index,
+                             const char *name,
+                             uint8_t *matched,
+                             uint8_t element)
+{
+    struct hbac_index_node *node;
+    uint32_t hash;
+    uint32_t i;
+
+    if (index->num_nodes == 0 || name == NULL) {
+        return;
+    }
+
+    hash = hbac_name_hash(name);
+
+    for (i = index->buckets[hash & (index->num_buckets - 1)];
+         i != HBAC_INDEX_END;
+         i = node->next) {
+        node = &index->nodes[i];
+        if (node->hash != hash) {
+            continue;
+        }
+
+        /* Both names are ASCII, the comparison cannot fail. */
+        if (sss_utf8_case_eq((const uint8_t *) node->name,
+                             (const uint8_t *) name) == EOK) {
+            matched[node->rule] |= element;
+        }
+    }
+}
+
+enum hbac_error_code hbac_compile_rules(struct hbac_rule **rules,
+                                        struct hbac_compiled_rules **_compiled)
+{
+    struct hbac_compiled_rules *compiled;
+    struct hbac_rule_element *el;
+    uint32_t num_rules;
+    uint32_t i;
+    int type;
+    errno_t ret;
+
+    if (rules == NULL || _compiled == NULL) {
+        return HBAC_ERROR_UNKNOWN;
+    }
+
+    for (num_rules = 0; rules[num_rules]; num_rules++);
+
+    compiled = calloc(1, sizeof(struct hbac_compiled_rules));
+    if (compiled == NULL) {
+        return HBAC_ERROR_OUT_OF_MEMORY;
+    }
+
+    compiled->rules = rules;
+    compiled->num_rules = num_rules;
+
+    compiled->matched = calloc(num_rules + 1, sizeof(uint8_t));
+    if (compiled->matched == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* First count the names and groups to size the indexes */
+    for (i = 0; i < num_rules; i++) {
+        if (!rules[i]->enabled) {
+            continue;
+        }
+
+        if (!hbac_rule_is_indexable(rules[i])) {
+            compiled->matched[i] = HBAC_ELEMENTS_ALL;
+            continue;
+        }
+
+        for (type = 0; type < HBAC_ELEMENT_NUM; type++) {
+            el = hbac_rule_get_element(rules[i], type);
+            if (el->category & HBAC_CATEGORY_ALL) {
+                compiled->matched[i] |= 1 << type;
+                continue;
+            }
+
+            hbac_index_count(&compiled->names[type], el->names);
+            hbac_index_count(&compiled->groups[type], el->groups);
+        }
+    }
+
+    for (type = 0; type < HBAC_ELEMENT_NUM; type++) {
+        ret = hbac_index_alloc(&compiled->names[type]);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = hbac_index_alloc(&compiled->groups[type]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    for (i = 0; i < num_rules; i++) {
+        if (!rules[i]->enabled
+                || compiled->matched[i] == HBAC_ELEMENTS_ALL) {
+            continue;
+        }
+
+        for (type = 0; type < HBAC_ELEMENT_NUM; type++) {
+            el = hbac_rule_get_element(rules[i], type);
+            if (el->category & HBAC_CATEGORY_ALL) {
+                continue;
+            }
+
+            hbac_index_add(&compiled->names[type], el->names, i);
+            hbac_index_add(&compiled->groups[type], el->groups, i);
+        }
+    }
+
+    HBAC_DEBUG(HBAC_DBG_TRACE, "Compiled %u rules\n", num_rules);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        HBAC_DEBUG(HBAC_DBG_ERROR, "Out of memory.\n");
+        hbac_free_compiled_rules(compiled);
+        return HBAC_ERROR_OUT_OF_MEMORY;
+    }
+
+    *_compiled = compiled;
+    return HBAC_SUCCESS;
+}
+
+enum hbac_eval_result
+hbac_evaluate_compiled(struct hbac_compiled_rules *compiled,
+                       struct hbac_eval_req *hbac_req,
+                       struct hbac_info **info)
+{
+    struct hbac_request_element *req_el;
+    enum hbac_eval_result result;
+    uint8_t *matched = NULL;
+    uint8_t element;
+    size_t j;
+    int type;
+
+    HBAC_DEBUG(HBAC_DBG_INFO, "[< hbac_evaluate()\n");
+    hbac_req_debug_print(hbac_req);
+
+    if (!hbac_req_is_ascii(hbac_req)) {
+        /* The indexes can only be used for ASCII names */
+        HBAC_DEBUG(HBAC_DBG_TRACE, "Evaluating all rules\n");
+        result = hbac_evaluate_rule_list(compiled->rules, NULL,
+                                         hbac_req, info);
+        goto done;
+    }
+
+    matched = malloc(compiled->num_rules + 1);
+    if (matched == NULL) {
+        HBAC_DEBUG(HBAC_DBG_ERROR, "Out of memory.\n");
+        result = HBAC_EVAL_OOM;
+        goto done;
+    }
+    memcpy(matched, compiled->matched, compiled->num_rules + 1);
+
+    for (type = 0; type < HBAC_ELEMENT_NUM; type++) {
+        req_el = hbac_req_get_element(hbac_req, type);
+        if (req_el == NULL) {
+            continue;
+        }
+
+        element = 1 << type;
+
+        hbac_index_match(&compiled->names[type], req_el->name,
+                         matched, element);
+
+        if (req_el->groups != NULL) {
+            for (j = 0; req_el->groups[j]; j++) {
+                hbac_index_match(&compiled->groups[type], req_el->groups[j],
+                                 matched, element);
+            }
+        }
+    }
+
+    result = hbac_evaluate_rule_list(compiled->rules, matched, hbac_req, info);
+
+done:
+    free(matched);
+    HBAC_DEBUG(HBAC_DBG_INFO, "hbac_evaluate() >]\n");
+    return result;
+}
+
+void hbac_free_compiled_rules(struct hbac_compiled_rules *compiled)
+{
+    int type;
+
+    if (compiled == NULL) return;
+
+    for (type = 0; type < HBAC_ELEMENT_NUM; type++) {
+        free(compiled->names[type].buckets);
+        free(compiled->names[type].nodes);
+        free(compiled->groups[type].buckets);
+        free(compiled->groups[type].nodes);
+    }
+
+    free(compiled->matched);
+    free(compiled);
+}
+
 const char *hbac_result_string(enum hbac_eval_result result)
 {
     switch (result) {
@@ -289,6 +289,56 @@ enum hbac_eval_result hbac_evaluate(struct hbac_rule **rules,
                                     struct hbac_eval_req *hbac_req,
                                     struct hbac_info **info);
 
+/**
+ * Opaque type for rules prepared by #hbac_compile_rules
+ */
+struct hbac_compiled_rules;
+
+/**
+ * @brief Prepare a set of HBAC rules for repeated evaluation
+ *
+ * Indexes the names and groups of the rules so that the evaluation only
+ * needs to look up the names and groups of the request. The rules are not
+ * copied, they must not be modified or freed while the compiled rules are
+ * in use.
+ *
+ * @param[in] rules      A NULL-terminated list of rules to evaluate against
+ * @param[out] compiled  The compiled rules, free them with
+ *                       #hbac_free_compiled_rules
+ * @return
+ *  - #HBAC_SUCCESS:             The rules were compiled
+ *  - #HBAC_ERROR_OUT_OF_MEMORY: Insufficient memory to compile the rules
+ */
+enum hbac_error_code hbac_compile_rules(struct hbac_rule **rules,
+                                        struct hbac_compiled_rules **compiled);
+
+/**
+ * @brief Evaluate an authorization request against compiled HBAC rules
+ *
+ * The result is the same as the result of #hbac_evaluate with the rules
+ * that were compiled.
+ *
+ * @param[in] compiled Rules returned by #hbac_compile_rules
+ * @param[in] hbac_req A user authorization request
+ * @param[out] info    Extended information (including the name of the
+ *                     rule that allowed access (or caused a parse error)
+ * @return
+ *  - #HBAC_EVAL_ERROR: An error occurred
+ *  - #HBAC_EVAL_ALLOW: Access is granted
+ *  - #HBAC_EVAL_DENY:  Access is denied
+ *  - #HBAC_EVAL_OOM:   Insufficient memory to complete the evaluation
+ */
+enum hbac_eval_result
+hbac_evaluate_compiled(struct hbac_compiled_rules *compiled,
+                       struct hbac_eval_req *hbac_req,
+                       struct hbac_info **info);
+
+/**
+ * @brief Free rules returned by #hbac_compile_rules
+ * @param compiled Compiled rules, may be NULL
+ */
+void hbac_free_compiled_rules(struct hbac_compiled_rules *compiled);
+
 /**
  * @brief Display result of hbac evaluation in human-readable form
  * @param[in] result Return value of #hbac_evaluate
@@ -74,6 +74,7 @@ sss_sifp_init_ex(void *alloc_pvt,
     }
 
     ctx->conn = NULL;
+    ctx->requests = NULL;
     ctx->alloc_fn = alloc_func;
     ctx->free_fn = free_func;
     ctx->alloc_pvt = alloc_pvt;
@@ -87,6 +88,13 @@ sss_sifp_init_ex(void *alloc_pvt,
 
     dbus_error_init(ctx->io_error);
 
+    /* The bus connection is shared by all contexts of the process and
+     * they may be used from different threads. */
+    if (!dbus_threads_init_default()) {
+        ret = SSS_SIFP_OUT_OF_MEMORY;
+        goto done;
+    }
+
     conn = dbus_bus_get(DBUS_BUS_SYSTEM, &dbus_error);
     if (dbus_error_is_set(&dbus_error)) {
         sss_sifp_set_io_error(ctx, &dbus_error);
@@ -343,6 +351,8 @@ sss_sifp_free(sss_sifp_ctx **_ctx)
 
     ctx = *_ctx;
 
+    sss_sifp_cancel_requests(ctx);
+
     if (ctx->conn != NULL) {
         dbus_connection_unref(ctx->conn);
     }
@@ -437,6 +447,28 @@ sss_sifp_free_object(sss_sifp_ctx *ctx,
     *_object = NULL;
 }
 
+void
+sss_sifp_free_objects(sss_sifp_ctx *ctx,
+                      sss_sifp_object ***_objects)
+{
+    sss_sifp_object **objects = NULL;
+    unsigned int i;
+
+    if (_objects == NULL || *_objects == NULL) {
+        return;
+    }
+
+    objects = *_objects;
+
+    for (i = 0; objects[i] != NULL; i++) {
+        sss_sifp_free_object(ctx, &objects[i]);
+    }
+
+    _free(ctx, objects);
+
+    *_objects = NULL;
+}
+
 void
 sss_sifp_free_string(sss_sifp_ctx *ctx,
                      char **_str)
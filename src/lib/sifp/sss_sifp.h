@@ -29,7 +29,8 @@
 /**
  * @defgroup sss_simpleifp Simple interface to SSSD InfoPipe responder.
  * Libsss_simpleifp provides a synchronous interface to simplify basic
- * communication with SSSD InfoPipe responder.
+ * communication with SSSD InfoPipe responder. Batched user lookups can
+ * also be sent asynchronously and finished with sss_sifp_dispatch().
  *
  * This interface is not a full replacement for the complete D-Bus API and it
  * provides only access to the most common tasks like fetching attributes
@@ -69,7 +70,9 @@
 
 /**
  * Opaque libsss_sifp context. One context shall not be used by multiple
- * threads. Each thread needs to create and use its own context.
+ * threads. Each thread needs to create and use its own context. All
+ * contexts of a process share one system bus connection, so creating
+ * a context per thread is cheap.
  *
  * @see sss_sifp_init
  * @see sss_sifp_init_ex
@@ -136,6 +139,16 @@ typedef struct sss_sifp_object {
     sss_sifp_attr **attrs;
 } sss_sifp_object;
 
+/**
+ * Typedef for the callback of an asynchronous request that returns a list
+ * of objects. The objects are NULL unless @error is SSS_SIFP_OK, they are
+ * owned by the callback and shall be freed with sss_sifp_free_objects().
+ */
+typedef void (sss_sifp_objects_fn)(sss_sifp_ctx *ctx,
+                                   sss_sifp_error error,
+                                   sss_sifp_object **objects,
+                                   void *pvt);
+
 /**
  * @brief Initialize sss_sifp context using default allocator (malloc)
  *
@@ -482,6 +495,16 @@ void
 sss_sifp_free_object(sss_sifp_ctx *ctx,
                      sss_sifp_object **_object);
 
+/**
+ * @brief Free NULL terminated array of sss_sifp objects and set it to NULL.
+ *
+ * @param[in] ctx sss_sifp context
+ * @param[in,out] _objects Objects
+ */
+void
+sss_sifp_free_objects(sss_sifp_ctx *ctx,
+                      sss_sifp_object ***_objects);
+
 /**
  * @brief Free string and set it to NULL.
  *
@@ -557,6 +580,66 @@ sss_sifp_fetch_user_by_name(sss_sifp_ctx *ctx,
                             const char *name,
                             sss_sifp_object **_user);
 
+/**
+ * @brief Fetch selected attributes of many users with a single call.
+ *
+ * All attribute values are returned as strings. The objects are stored
+ * in the same order as @object_paths. A user that does not exist is
+ * returned as an object with no attributes.
+ *
+ * @param[in] ctx          sss_sifp context
+ * @param[in] object_paths NULL terminated list of user object paths
+ * @param[in] attrs        NULL terminated list of attribute names
+ * @param[out] _users      NULL terminated list of user objects
+ */
+sss_sifp_error
+sss_sifp_fetch_users_attrs(sss_sifp_ctx *ctx,
+                           const char **object_paths,
+                           const char **attrs,
+                           sss_sifp_object ***_users);
+
+/**
+ * @brief Asynchronous variant of sss_sifp_fetch_users_attrs().
+ *
+ * The request is sent immediately and the callback is called from
+ * sss_sifp_dispatch() with the user objects. Many requests may be in
+ * flight at the same time.
+ *
+ * @param[in] ctx          sss_sifp context
+ * @param[in] object_paths NULL terminated list of user object paths
+ * @param[in] attrs        NULL terminated list of attribute names
+ * @param[in] fn           Callback
+ * @param[in] pvt          Private data passed to the callback
+ */
+sss_sifp_error
+sss_sifp_fetch_users_attrs_send(sss_sifp_ctx *ctx,
+                                const char **object_paths,
+                                const char **attrs,
+                                sss_sifp_objects_fn *fn,
+                                void *pvt);
+
+/**
+ * @brief Process replies of asynchronous requests.
+ *
+ * Waits at most @timeout milliseconds (-1 means no limit) for incoming
+ * data unless some request of this context is already finished, then
+ * calls the callbacks of all finished requests. Callbacks may send new
+ * requests but they shall not call sss_sifp_dispatch() or sss_sifp_free().
+ * Requests that are still pending when the context is freed are
+ * cancelled without calling their callbacks.
+ *
+ * When the connection is shared with other threads, use a finite timeout,
+ * the replies may be read by another thread.
+ *
+ * @param[in] ctx           sss_sifp context
+ * @param[in] timeout       Timeout in milliseconds
+ * @param[out] _num_pending Number of unfinished requests, may be NULL
+ */
+sss_sifp_error
+sss_sifp_dispatch(sss_sifp_ctx *ctx,
+                  int timeout,
+                  unsigned int *_num_pending);
+
 /**
  * @}
  */
@@ -181,3 +181,109 @@ sss_sifp_fetch_user_by_name(sss_sifp_ctx *ctx,
                                          "org.freedesktop.sssd.infopipe.Users.User", "ByName",
                                          name, _user);
 }
+
+static sss_sifp_error
+sss_sifp_users_attrs_message(const char **object_paths,
+                             const char **attrs,
+                             DBusMessage **_msg)
+{
+    DBusMessage *msg = NULL;
+    int num_paths;
+    int num_attrs;
+    dbus_bool_t bret;
+
+    for (num_paths = 0; object_paths[num_paths] != NULL; num_paths++);
+    for (num_attrs = 0; attrs[num_attrs] != NULL; num_attrs++);
+
+    msg = sss_sifp_create_message(IFP_PATH_USERS,
+                                  "org.freedesktop.sssd.infopipe.Users",
+                                  "GetUsersAttrs");
+    if (msg == NULL) {
+        return SSS_SIFP_OUT_OF_MEMORY;
+    }
+
+    bret = dbus_message_append_args(msg,
+                                    DBUS_TYPE_ARRAY, DBUS_TYPE_OBJECT_PATH,
+                                    &object_paths, num_paths,
+                                    DBUS_TYPE_ARRAY, DBUS_TYPE_STRING,
+                                    &attrs, num_attrs,
+                                    DBUS_TYPE_INVALID);
+    if (!bret) {
+        dbus_message_unref(msg);
+        return SSS_SIFP_OUT_OF_MEMORY;
+    }
+
+    *_msg = msg;
+
+    return SSS_SIFP_OK;
+}
+
+sss_sifp_error
+sss_sifp_fetch_users_attrs(sss_sifp_ctx *ctx,
+                           const char **object_paths,
+                           const char **attrs,
+                           sss_sifp_object ***_users)
+{
+    DBusMessage *msg = NULL;
+    DBusMessage *reply = NULL;
+    sss_sifp_error ret;
+
+    if (ctx == NULL || object_paths == NULL || attrs == NULL
+            || _users == NULL) {
+        return SSS_SIFP_INVALID_ARGUMENT;
+    }
+
+    ret = sss_sifp_users_attrs_message(object_paths, attrs, &msg);
+    if (ret != SSS_SIFP_OK) {
+        goto done;
+    }
+
+    ret = sss_sifp_send_message(ctx, msg, &reply);
+    if (ret != SSS_SIFP_OK) {
+        goto done;
+    }
+
+    ret = sss_sifp_parse_object_list(ctx, reply, object_paths,
+                                     "org.freedesktop.sssd.infopipe.Users.User",
+                                     _users);
+
+done:
+    if (msg != NULL) {
+        dbus_message_unref(msg);
+    }
+
+    if (reply != NULL) {
+        dbus_message_unref(reply);
+    }
+
+    return ret;
+}
+
+sss_sifp_error
+sss_sifp_fetch_users_attrs_send(sss_sifp_ctx *ctx,
+                                const char **object_paths,
+                                const char **attrs,
+                                sss_sifp_objects_fn *fn,
+                                void *pvt)
+{
+    DBusMessage *msg = NULL;
+    sss_sifp_error ret;
+
+    if (ctx == NULL || object_paths == NULL || attrs == NULL || fn == NULL) {
+        return SSS_SIFP_INVALID_ARGUMENT;
+    }
+
+    ret = sss_sifp_users_attrs_message(object_paths, attrs, &msg);
+    if (ret != SSS_SIFP_OK) {
+        return ret;
+    }
+
+    ret = sss_sifp_send_request(ctx, msg, SSS_SIFP_DEFAULT_TIMEOUT,
+                                NULL, fn,
+                                "org.freedesktop.sssd.infopipe.Users.User",
+                                pvt);
+
+    dbus_message_unref(msg);
+
+    return ret;
+}
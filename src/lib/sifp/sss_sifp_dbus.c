@@ -80,7 +80,8 @@ sss_sifp_send_message(sss_sifp_ctx *ctx,
                       DBusMessage *msg,
                       DBusMessage **_reply)
 {
-    return sss_sifp_send_message_ex(ctx, msg, 5000, _reply);
+    return sss_sifp_send_message_ex(ctx, msg, SSS_SIFP_DEFAULT_TIMEOUT,
+                                    _reply);
 }
 
 sss_sifp_error
@@ -120,6 +121,254 @@ done:
     return ret;
 }
 
+struct sss_sifp_request {
+    struct sss_sifp_request *prev;
+    struct sss_sifp_request *next;
+
+    DBusPendingCall *pending;
+    DBusMessage *msg;
+
+    sss_sifp_message_fn *message_fn;
+    sss_sifp_objects_fn *objects_fn;
+    const char *interface;
+    void *pvt;
+};
+
+static void
+sss_sifp_request_unlink(sss_sifp_ctx *ctx,
+                        struct sss_sifp_request *req)
+{
+    if (req->prev != NULL) {
+        req->prev->next = req->next;
+    } else {
+        ctx->requests = req->next;
+    }
+
+    if (req->next != NULL) {
+        req->next->prev = req->prev;
+    }
+
+    req->prev = NULL;
+    req->next = NULL;
+}
+
+static void
+sss_sifp_request_free(sss_sifp_ctx *ctx,
+                      struct sss_sifp_request *req)
+{
+    if (req->pending != NULL) {
+        dbus_pending_call_unref(req->pending);
+    }
+
+    if (req->msg != NULL) {
+        dbus_message_unref(req->msg);
+    }
+
+    _free(ctx, req);
+}
+
+sss_sifp_error
+sss_sifp_send_request(sss_sifp_ctx *ctx,
+                      DBusMessage *msg,
+                      int timeout,
+                      sss_sifp_message_fn *message_fn,
+                      sss_sifp_objects_fn *objects_fn,
+                      const char *interface,
+                      void *pvt)
+{
+    struct sss_sifp_request *req = NULL;
+    dbus_bool_t bret;
+
+    req = _alloc_zero(ctx, struct sss_sifp_request, 1);
+    if (req == NULL) {
+        return SSS_SIFP_OUT_OF_MEMORY;
+    }
+
+    bret = dbus_connection_send_with_reply(ctx->conn, msg, &req->pending,
+                                           timeout);
+    if (!bret) {
+        sss_sifp_request_free(ctx, req);
+        return SSS_SIFP_OUT_OF_MEMORY;
+    }
+
+    if (req->pending == NULL) {
+        /* the connection is closed */
+        sss_sifp_request_free(ctx, req);
+        return SSS_SIFP_IO_ERROR;
+    }
+
+    req->msg = dbus_message_ref(msg);
+    req->message_fn = message_fn;
+    req->objects_fn = objects_fn;
+    req->interface = interface;
+    req->pvt = pvt;
+
+    req->next = ctx->requests;
+    if (ctx->requests != NULL) {
+        ctx->requests->prev = req;
+    }
+    ctx->requests = req;
+
+    return SSS_SIFP_OK;
+}
+
+void
+sss_sifp_cancel_requests(sss_sifp_ctx *ctx)
+{
+    struct sss_sifp_request *req;
+
+    while (ctx->requests != NULL) {
+        req = ctx->requests;
+        sss_sifp_request_unlink(ctx, req);
+
+        dbus_pending_call_cancel(req->pending);
+        sss_sifp_request_free(ctx, req);
+    }
+}
+
+static void
+sss_sifp_request_done(sss_sifp_ctx *ctx,
+                      struct sss_sifp_request *req)
+{
+    DBusMessage *reply = NULL;
+    DBusError dbus_error;
+    sss_sifp_object **objects = NULL;
+    char **object_paths = NULL;
+    int num_paths;
+    dbus_bool_t bret;
+    sss_sifp_error ret;
+
+    dbus_error_init(&dbus_error);
+
+    reply = dbus_pending_call_steal_reply(req->pending);
+    if (reply == NULL) {
+        ret = SSS_SIFP_INTERNAL_ERROR;
+        goto done;
+    }
+
+    /* timeouts and disconnects are reported as error replies as well */
+    if (dbus_set_error_from_message(&dbus_error, reply)) {
+        sss_sifp_set_io_error(ctx, &dbus_error);
+        ret = SSS_SIFP_IO_ERROR;
+        goto done;
+    }
+
+    if (req->objects_fn == NULL) {
+        ret = SSS_SIFP_OK;
+        goto done;
+    }
+
+    bret = dbus_message_get_args(req->msg, NULL,
+                                 DBUS_TYPE_ARRAY, DBUS_TYPE_OBJECT_PATH,
+                                 &object_paths, &num_paths,
+                                 DBUS_TYPE_INVALID);
+    if (!bret) {
+        ret = SSS_SIFP_INTERNAL_ERROR;
+        goto done;
+    }
+
+    ret = sss_sifp_parse_object_list(ctx, reply,
+                                     (const char **)object_paths,
+                                     req->interface, &objects);
+
+done:
+    if (req->message_fn != NULL) {
+        req->message_fn(ctx, ret, ret == SSS_SIFP_OK ? reply : NULL,
+                        req->pvt);
+    } else {
+        req->objects_fn(ctx, ret, objects, req->pvt);
+    }
+
+    dbus_free_string_array(object_paths);
+    dbus_error_free(&dbus_error);
+
+    if (reply != NULL) {
+        dbus_message_unref(reply);
+    }
+}
+
+static bool
+sss_sifp_has_completed_requests(sss_sifp_ctx *ctx)
+{
+    struct sss_sifp_request *req;
+
+    for (req = ctx->requests; req != NULL; req = req->next) {
+        if (dbus_pending_call_get_completed(req->pending)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+sss_sifp_error
+sss_sifp_send_message_async(sss_sifp_ctx *ctx,
+                            DBusMessage *msg,
+                            int timeout,
+                            sss_sifp_message_fn *fn,
+                            void *pvt)
+{
+    if (ctx == NULL || msg == NULL || fn == NULL) {
+        return SSS_SIFP_INVALID_ARGUMENT;
+    }
+
+    return sss_sifp_send_request(ctx, msg, timeout, fn, NULL, NULL, pvt);
+}
+
+sss_sifp_error
+sss_sifp_dispatch(sss_sifp_ctx *ctx,
+                  int timeout,
+                  unsigned int *_num_pending)
+{
+    struct sss_sifp_request *req;
+    struct sss_sifp_request *next;
+    DBusError dbus_error;
+    unsigned int num_pending;
+    sss_sifp_error ret = SSS_SIFP_OK;
+
+    if (ctx == NULL) {
+        return SSS_SIFP_INVALID_ARGUMENT;
+    }
+
+    /* Other contexts may share the connection and dispatch our replies
+     * from their thread, so there is no need to wait when a request
+     * was finished in the meantime. */
+    if (ctx->requests != NULL && !sss_sifp_has_completed_requests(ctx)) {
+        if (!dbus_connection_read_write_dispatch(ctx->conn, timeout)) {
+            dbus_error_init(&dbus_error);
+            dbus_set_error_const(&dbus_error, DBUS_ERROR_DISCONNECTED,
+                                 "Connection is closed");
+            sss_sifp_set_io_error(ctx, &dbus_error);
+            dbus_error_free(&dbus_error);
+            ret = SSS_SIFP_IO_ERROR;
+        }
+    }
+
+    /* Callbacks may send new requests, those are added to the head of the
+     * list and are not visited in this pass. */
+    for (req = ctx->requests; req != NULL; req = next) {
+        next = req->next;
+
+        if (!dbus_pending_call_get_completed(req->pending)) {
+            continue;
+        }
+
+        sss_sifp_request_unlink(ctx, req);
+        sss_sifp_request_done(ctx, req);
+        sss_sifp_request_free(ctx, req);
+    }
+
+    if (_num_pending != NULL) {
+        num_pending = 0;
+        for (req = ctx->requests; req != NULL; req = req->next) {
+            num_pending++;
+        }
+        *_num_pending = num_pending;
+    }
+
+    return ret;
+}
+
 static sss_sifp_error
 sss_sifp_invoke_list_va(sss_sifp_ctx *ctx,
                         const char *object_path,
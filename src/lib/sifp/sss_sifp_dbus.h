@@ -84,6 +84,36 @@ sss_sifp_send_message_ex(sss_sifp_ctx *ctx,
                          int timeout,
                          DBusMessage **_reply);
 
+/**
+ * Typedef for the callback of an asynchronous method call. The reply is
+ * NULL unless @error is SSS_SIFP_OK and it is released when the callback
+ * returns, use dbus_message_ref() to keep it.
+ */
+typedef void (sss_sifp_message_fn)(sss_sifp_ctx *ctx,
+                                   sss_sifp_error error,
+                                   DBusMessage *reply,
+                                   void *pvt);
+
+/**
+ * @brief Send D-Bus message to SSSD InfoPipe bus without waiting for
+ * the reply. The callback is called from sss_sifp_dispatch() once
+ * the reply arrived or the call timed out.
+ *
+ * @param[in] ctx     sss_sifp context
+ * @param[in] msg     D-Bus message
+ * @param[in] timeout Timeout in milliseconds
+ * @param[in] fn      Callback
+ * @param[in] pvt     Private data passed to the callback
+ *
+ * @see sss_sifp_dispatch
+ */
+sss_sifp_error
+sss_sifp_send_message_async(sss_sifp_ctx *ctx,
+                            DBusMessage *msg,
+                            int timeout,
+                            sss_sifp_message_fn *fn,
+                            void *pvt);
+
 /**
  * @brief List objects that satisfies given conditions. This routine will
  * invoke List<method> D-Bus method on given interface and object path. If
@@ -721,3 +721,210 @@ done:
 
     return ret;
 }
+
+/**
+ * DBusMessageIter format:
+ * array of dict_entry(string:attr_name, array of string:values)
+ */
+static sss_sifp_error
+sss_sifp_parse_string_attrs(sss_sifp_ctx *ctx,
+                            DBusMessageIter *iter,
+                            sss_sifp_attr ***_attrs)
+{
+    DBusMessageIter array_iter;
+    DBusMessageIter dict_iter;
+    DBusMessageIter values_iter;
+    sss_sifp_attr **attrs = NULL;
+    sss_sifp_attr *attr;
+    const char *name = NULL;
+    const char *value = NULL;
+    unsigned int num_attrs;
+    sss_sifp_error ret;
+    unsigned int i;
+    unsigned int j;
+
+    check_dbus_arg(iter, DBUS_TYPE_ARRAY, ret, done);
+
+    if (dbus_message_iter_get_element_type(iter) != DBUS_TYPE_DICT_ENTRY) {
+        ret = SSS_SIFP_INTERNAL_ERROR;
+        goto done;
+    }
+
+    num_attrs = sss_sifp_get_array_length(iter);
+    attrs = _alloc_zero(ctx, sss_sifp_attr *, num_attrs + 1);
+    if (attrs == NULL) {
+        ret = SSS_SIFP_OUT_OF_MEMORY;
+        goto done;
+    }
+
+    dbus_message_iter_recurse(iter, &array_iter);
+
+    for (i = 0; i < num_attrs; i++) {
+        dbus_message_iter_recurse(&array_iter, &dict_iter);
+
+        /* get the key */
+        check_dbus_arg(&dict_iter, DBUS_TYPE_STRING, ret, done);
+        dbus_message_iter_get_basic(&dict_iter, &name);
+
+        if (!dbus_message_iter_next(&dict_iter)) {
+            ret = SSS_SIFP_INTERNAL_ERROR;
+            goto done;
+        }
+
+        /* now read the values */
+        check_dbus_arg(&dict_iter, DBUS_TYPE_ARRAY, ret, done);
+        if (dbus_message_iter_get_element_type(&dict_iter)
+                != DBUS_TYPE_STRING) {
+            ret = SSS_SIFP_INTERNAL_ERROR;
+            goto done;
+        }
+
+        attr = _alloc_zero(ctx, sss_sifp_attr, 1);
+        if (attr == NULL) {
+            ret = SSS_SIFP_OUT_OF_MEMORY;
+            goto done;
+        }
+        attrs[i] = attr;
+
+        attr->type = SSS_SIFP_ATTR_TYPE_STRING;
+        attr->name = sss_sifp_strdup(ctx, name);
+        if (attr->name == NULL) {
+            ret = SSS_SIFP_OUT_OF_MEMORY;
+            goto done;
+        }
+
+        attr->num_values = sss_sifp_get_array_length(&dict_iter);
+        if (attr->num_values > 0) {
+            attr->data.str = _alloc_zero(ctx, char *, attr->num_values);
+            if (attr->data.str == NULL) {
+                attr->num_values = 0;
+                ret = SSS_SIFP_OUT_OF_MEMORY;
+                goto done;
+            }
+        }
+
+        dbus_message_iter_recurse(&dict_iter, &values_iter);
+        for (j = 0; j < attr->num_values; j++) {
+            dbus_message_iter_get_basic(&values_iter, &value);
+
+            attr->data.str[j] = sss_sifp_strdup(ctx, value);
+            if (attr->data.str[j] == NULL) {
+                ret = SSS_SIFP_OUT_OF_MEMORY;
+                goto done;
+            }
+
+            dbus_message_iter_next(&values_iter);
+        }
+
+        dbus_message_iter_next(&array_iter);
+    }
+
+    *_attrs = attrs;
+    ret = SSS_SIFP_OK;
+
+done:
+    if (ret != SSS_SIFP_OK) {
+        sss_sifp_free_attrs(ctx, &attrs);
+    }
+
+    return ret;
+}
+
+/**
+ * DBusMessage format:
+ * array of array of dict_entry(string:attr_name, array of string:values)
+ *
+ * One object is created for each object path, in the same order.
+ */
+sss_sifp_error
+sss_sifp_parse_object_list(sss_sifp_ctx *ctx,
+                           DBusMessage *msg,
+                           const char **object_paths,
+                           const char *interface,
+                           sss_sifp_object ***_objects)
+{
+    DBusMessageIter iter;
+    DBusMessageIter array_iter;
+    sss_sifp_object **objects = NULL;
+    sss_sifp_object *object;
+    const char *name;
+    unsigned int num_objects;
+    unsigned int num_paths;
+    sss_sifp_error ret;
+    unsigned int i;
+
+    for (num_paths = 0; object_paths[num_paths] != NULL; num_paths++) {
+        /* count */
+    }
+
+    dbus_message_iter_init(msg, &iter);
+
+    check_dbus_arg(&iter, DBUS_TYPE_ARRAY, ret, done);
+
+    if (dbus_message_iter_get_element_type(&iter) != DBUS_TYPE_ARRAY) {
+        ret = SSS_SIFP_INTERNAL_ERROR;
+        goto done;
+    }
+
+    num_objects = sss_sifp_get_array_length(&iter);
+    if (num_objects != num_paths) {
+        ret = SSS_SIFP_INTERNAL_ERROR;
+        goto done;
+    }
+
+    objects = _alloc_zero(ctx, sss_sifp_object *, num_objects + 1);
+    if (objects == NULL) {
+        ret = SSS_SIFP_OUT_OF_MEMORY;
+        goto done;
+    }
+
+    dbus_message_iter_recurse(&iter, &array_iter);
+
+    for (i = 0; i < num_objects; i++) {
+        object = _alloc_zero(ctx, sss_sifp_object, 1);
+        if (object == NULL) {
+            ret = SSS_SIFP_OUT_OF_MEMORY;
+            goto done;
+        }
+        objects[i] = object;
+
+        ret = sss_sifp_parse_string_attrs(ctx, &array_iter, &object->attrs);
+        if (ret != SSS_SIFP_OK) {
+            goto done;
+        }
+
+        object->object_path = sss_sifp_strdup(ctx, object_paths[i]);
+        if (object->object_path == NULL) {
+            ret = SSS_SIFP_OUT_OF_MEMORY;
+            goto done;
+        }
+
+        object->interface = sss_sifp_strdup(ctx, interface);
+        if (object->interface == NULL) {
+            ret = SSS_SIFP_OUT_OF_MEMORY;
+            goto done;
+        }
+
+        /* The name is available only if it was requested. */
+        ret = sss_sifp_find_attr_as_string(object->attrs, "name", &name);
+        if (ret == SSS_SIFP_OK) {
+            object->name = sss_sifp_strdup(ctx, name);
+            if (object->name == NULL) {
+                ret = SSS_SIFP_OUT_OF_MEMORY;
+                goto done;
+            }
+        }
+
+        dbus_message_iter_next(&array_iter);
+    }
+
+    *_objects = objects;
+    ret = SSS_SIFP_OK;
+
+done:
+    if (ret != SSS_SIFP_OK) {
+        sss_sifp_free_objects(ctx, &objects);
+    }
+
+    return ret;
+}
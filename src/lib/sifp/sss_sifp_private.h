@@ -23,6 +23,9 @@
 
 #include <dbus/dbus.h>
 #include "lib/sifp/sss_sifp.h"
+#include "lib/sifp/sss_sifp_dbus.h"
+
+#define SSS_SIFP_DEFAULT_TIMEOUT 5000
 
 void *sss_sifp_alloc_zero(sss_sifp_ctx *ctx, size_t size, size_t num);
 
@@ -34,6 +37,8 @@ void *sss_sifp_alloc_zero(sss_sifp_ctx *ctx, size_t size, size_t num);
         (var) = NULL; \
     } while (0)
 
+struct sss_sifp_request;
+
 struct sss_sifp_ctx {
     DBusConnection *conn;
     sss_sifp_alloc_func *alloc_fn;
@@ -41,6 +46,9 @@ struct sss_sifp_ctx {
     void *alloc_pvt;
 
     DBusError *io_error;
+
+    /* asynchronous requests that were not finished yet */
+    struct sss_sifp_request *requests;
 };
 
 enum sss_sifp_attr_type {
@@ -109,4 +117,28 @@ sss_sifp_parse_object_path_list(sss_sifp_ctx *ctx,
                                 DBusMessage *msg,
                                 char ***_object_paths);
 
+sss_sifp_error
+sss_sifp_parse_object_list(sss_sifp_ctx *ctx,
+                           DBusMessage *msg,
+                           const char **object_paths,
+                           const char *interface,
+                           sss_sifp_object ***_objects);
+
+/* Send @msg without waiting for the reply. Exactly one of @message_fn and
+ * @objects_fn is set, the latter parses the reply into a list of objects
+ * of @interface that belong to the object paths of the first argument
+ * of @msg. */
+sss_sifp_error
+sss_sifp_send_request(sss_sifp_ctx *ctx,
+                      DBusMessage *msg,
+                      int timeout,
+                      sss_sifp_message_fn *message_fn,
+                      sss_sifp_objects_fn *objects_fn,
+                      const char *interface,
+                      void *pvt);
+
+/* Cancel all unfinished requests, their callbacks are not called. */
+void
+sss_sifp_cancel_requests(sss_sifp_ctx *ctx);
+
 #endif /* SSS_SIFP_PRIVATE_H_ */
@@ -22,6 +22,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
@@ -68,9 +69,14 @@ static NTSTATUS idmap_sss_unixids_to_sids(struct idmap_domain *dom,
                                           struct id_map **map)
 {
     size_t c;
+    size_t num;
     int ret;
-    char *sid_str;
-    enum sss_id_type id_type;
+    TALLOC_CTX *tmp_ctx;
+    uint32_t *ids;
+    enum sss_id_type *id_types;
+    char **sid_strs;
+    enum sss_id_type *sid_types;
+    int *errs;
     struct dom_sid *sid;
     enum idmap_error_code err;
     struct idmap_sss_ctx *ctx;
@@ -84,29 +90,61 @@ static NTSTATUS idmap_sss_unixids_to_sids(struct idmap_domain *dom,
         return ERROR_INVALID_PARAMETER;
     }
 
-    for (c = 0; map[c]; c++) {
-        map[c]->status = ID_UNKNOWN;
+    for (num = 0; map[num]; num++) {
+        map[num]->status = ID_UNKNOWN;
     }
 
-    for (c = 0; map[c]; c++) {
+    if (num == 0) {
+        return NT_STATUS_OK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return NT_STATUS_NO_MEMORY;
+    }
+
+    ids = talloc_array(tmp_ctx, uint32_t, num);
+    id_types = talloc_array(tmp_ctx, enum sss_id_type, num);
+    sid_strs = talloc_zero_array(tmp_ctx, char *, num);
+    sid_types = talloc_array(tmp_ctx, enum sss_id_type, num);
+    errs = talloc_array(tmp_ctx, int, num);
+    if (ids == NULL || id_types == NULL || sid_strs == NULL
+            || sid_types == NULL || errs == NULL) {
+        talloc_free(tmp_ctx);
+        return NT_STATUS_NO_MEMORY;
+    }
+
+    for (c = 0; c < num; c++) {
+        ids[c] = map[c]->xid.id;
+
         switch (map[c]->xid.type) {
         case ID_TYPE_UID:
-            ret = sss_nss_getsidbyuid(map[c]->xid.id, &sid_str, &id_type);
+            id_types[c] = SSS_ID_TYPE_UID;
             break;
         case ID_TYPE_GID:
-            ret = sss_nss_getsidbygid(map[c]->xid.id, &sid_str, &id_type);
+            id_types[c] = SSS_ID_TYPE_GID;
             break;
         default:
-            ret = sss_nss_getsidbyid(map[c]->xid.id, &sid_str, &id_type);
+            id_types[c] = SSS_ID_TYPE_NOT_SPECIFIED;
         }
-        if (ret != 0) {
-            if (ret == ENOENT) {
+    }
+
+    /* All IDs are looked up with as few requests as possible */
+    ret = sss_nss_getsidsbyids(ids, id_types, num, sid_strs, sid_types, errs);
+    if (ret != 0) {
+        talloc_free(tmp_ctx);
+        return ret == ENOMEM ? NT_STATUS_NO_MEMORY : NT_STATUS_OK;
+    }
+
+    for (c = 0; c < num; c++) {
+        if (errs[c] != 0) {
+            if (errs[c] == ENOENT) {
                 map[c]->status = ID_UNMAPPED;
             }
             continue;
         }
 
-        switch (id_type) {
+        switch (sid_types[c]) {
         case SSS_ID_TYPE_UID:
             map[c]->xid.type = ID_TYPE_UID;
             break;
@@ -117,12 +155,12 @@ static NTSTATUS idmap_sss_unixids_to_sids(struct idmap_domain *dom,
             map[c]->xid.type = ID_TYPE_BOTH;
             break;
         default:
-            free(sid_str);
+            free(sid_strs[c]);
             continue;
         }
 
-        err = sss_idmap_sid_to_smb_sid(ctx->idmap_ctx, sid_str, &sid);
-        free(sid_str);
+        err = sss_idmap_sid_to_smb_sid(ctx->idmap_ctx, sid_strs[c], &sid);
+        free(sid_strs[c]);
         if (err != IDMAP_SUCCESS) {
             continue;
         }
@@ -133,6 +171,8 @@ static NTSTATUS idmap_sss_unixids_to_sids(struct idmap_domain *dom,
         map[c]->status = ID_MAPPED;
     }
 
+    talloc_free(tmp_ctx);
+
     return NT_STATUS_OK;
 }
 
@@ -140,12 +180,18 @@ static NTSTATUS idmap_sss_sids_to_unixids(struct idmap_domain *dom,
                                           struct id_map **map)
 {
     size_t c;
+    size_t i;
+    size_t num;
+    size_t num_sids = 0;
     int ret;
-    char *sid_str;
-    enum sss_id_type id_type;
+    TALLOC_CTX *tmp_ctx;
+    char **sid_strs;
+    size_t *pos;
+    uint32_t *ids;
+    enum sss_id_type *id_types;
+    int *errs;
     enum idmap_error_code err;
     struct idmap_sss_ctx *ctx;
-    uint32_t id;
 
     if (dom == NULL) {
         return ERROR_INVALID_PARAMETER;
@@ -156,26 +202,67 @@ static NTSTATUS idmap_sss_sids_to_unixids(struct idmap_domain *dom,
         return ERROR_INVALID_PARAMETER;
     }
 
-    for (c = 0; map[c]; c++) {
-        map[c]->status = ID_UNKNOWN;
+    for (num = 0; map[num]; num++) {
+        map[num]->status = ID_UNKNOWN;
+    }
+
+    if (num == 0) {
+        return NT_STATUS_OK;
     }
 
-    for (c = 0; map[c]; c++) {
-        err = sss_idmap_smb_sid_to_sid(ctx->idmap_ctx, map[c]->sid, &sid_str);
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return NT_STATUS_NO_MEMORY;
+    }
+
+    sid_strs = talloc_zero_array(tmp_ctx, char *, num);
+    pos = talloc_array(tmp_ctx, size_t, num);
+    ids = talloc_array(tmp_ctx, uint32_t, num);
+    id_types = talloc_array(tmp_ctx, enum sss_id_type, num);
+    errs = talloc_array(tmp_ctx, int, num);
+    if (sid_strs == NULL || pos == NULL || ids == NULL || id_types == NULL
+            || errs == NULL) {
+        talloc_free(tmp_ctx);
+        return NT_STATUS_NO_MEMORY;
+    }
+
+    for (c = 0; c < num; c++) {
+        err = sss_idmap_smb_sid_to_sid(ctx->idmap_ctx, map[c]->sid,
+                                       &sid_strs[num_sids]);
         if (err != IDMAP_SUCCESS) {
             continue;
         }
+        pos[num_sids++] = c;
+    }
 
-        ret = sss_nss_getidbysid(sid_str, &id, &id_type);
-        sss_idmap_free_sid(ctx->idmap_ctx, sid_str);
-        if (ret != 0) {
-            if (ret == ENOENT) {
+    /* All SIDs are looked up with as few requests as possible */
+    if (num_sids > 0) {
+        ret = sss_nss_getidsbysids((const char **) sid_strs, num_sids, ids,
+                                   id_types, errs);
+    } else {
+        ret = 0;
+    }
+
+    for (i = 0; i < num_sids; i++) {
+        sss_idmap_free_sid(ctx->idmap_ctx, sid_strs[i]);
+    }
+
+    if (ret != 0) {
+        talloc_free(tmp_ctx);
+        return ret == ENOMEM ? NT_STATUS_NO_MEMORY : NT_STATUS_OK;
+    }
+
+    for (i = 0; i < num_sids; i++) {
+        c = pos[i];
+
+        if (errs[i] != 0) {
+            if (errs[i] == ENOENT) {
                 map[c]->status = ID_UNMAPPED;
             }
             continue;
         }
 
-        switch (id_type) {
+        switch (id_types[i]) {
         case SSS_ID_TYPE_UID:
             map[c]->xid.type = ID_TYPE_UID;
             break;
@@ -189,11 +276,13 @@ static NTSTATUS idmap_sss_sids_to_unixids(struct idmap_domain *dom,
             continue;
         }
 
-        map[c]->xid.id = id;
+        map[c]->xid.id = ids[i];
 
         map[c]->status = ID_MAPPED;
     }
 
+    talloc_free(tmp_ctx);
+
     return NT_STATUS_OK;
 }
 
@@ -25,6 +25,8 @@
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <time.h>
 #include <string.h>
 #include <signal.h>
@@ -47,6 +49,7 @@
 #include "db/sysdb.h"
 #include "monitor/monitor.h"
 #include "util/inotify.h"
+#include "util/sss_metrics.h"
 #include "sss_iface/sss_iface_async.h"
 
 #ifdef USE_KEYRING
@@ -76,6 +79,13 @@
  */
 #define MONITOR_MAX_RESTART_DELAY   4
 
+/* Network status changes usually come in bursts, e.g. when a VPN connects
+ * or an interface flaps. The providers are signaled once the changes settle
+ * for MONITOR_NETLINK_SETTLE_MSEC, but at most MONITOR_NETLINK_MAX_DELAY_MSEC
+ * after the first change of the burst. */
+#define MONITOR_NETLINK_SETTLE_MSEC     200
+#define MONITOR_NETLINK_MAX_DELAY_MSEC  1000
+
 /* Special value to leave the Kerberos Replay Cache set to use
  * the libkrb5 defaults
  */
@@ -161,7 +171,11 @@ struct mt_ctx {
     int service_id_timeout;
     bool check_children;
     bool services_started;
+    bool parallel_startup;
     struct netlink_ctx *nlctx;
+    struct tevent_timer *netlink_te;
+    struct timeval netlink_first;
+    unsigned int netlink_events;
     const char *conf_path;
     struct sss_sigchild_ctx *sigchld_ctx;
     bool pid_file_created;
@@ -171,6 +185,9 @@ struct mt_ctx {
     struct sbus_server *sbus_server;
     struct sbus_connection *sbus_conn;
 
+    /* listening socket of metrics_socket */
+    int metrics_fd;
+
     /* For running unprivileged services */
     uid_t uid;
     gid_t gid;
@@ -199,13 +216,15 @@ static int mark_service_as_started(struct mt_svc *svc);
 
 static int monitor_cleanup(void);
 
-static void network_status_change_cb(void *cb_data)
+static void network_status_signal_providers(struct mt_ctx *ctx)
 {
     struct mt_svc *iter;
-    struct mt_ctx *ctx = (struct mt_ctx *) cb_data;
 
-    DEBUG(SSSDBG_TRACE_INTERNAL, "A networking status change detected "
-          "signaling providers to reset offline status\n");
+    DEBUG(SSSDBG_TRACE_INTERNAL, "%u networking status changes detected "
+          "signaling providers to reset offline status\n",
+          ctx->netlink_events);
+    ctx->netlink_events = 0;
+
     for (iter = ctx->svc_list; iter; iter = iter->next) {
         /* Don't signal services, only providers */
         if (iter->provider) {
@@ -214,6 +233,51 @@ static void network_status_change_cb(void *cb_data)
     }
 }
 
+static void network_status_settled(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval current_time,
+                                   void *pvt)
+{
+    struct mt_ctx *ctx = talloc_get_type(pvt, struct mt_ctx);
+
+    ctx->netlink_te = NULL;
+    network_status_signal_providers(ctx);
+}
+
+static void network_status_change_cb(void *cb_data)
+{
+    struct mt_ctx *ctx = (struct mt_ctx *) cb_data;
+    struct timeval now;
+    struct timeval tv;
+    uint64_t elapsed_msec;
+
+    now = tevent_timeval_current();
+    ctx->netlink_events++;
+
+    if (ctx->netlink_te == NULL) {
+        ctx->netlink_first = now;
+    } else {
+        tv = tevent_timeval_until(&ctx->netlink_first, &now);
+        elapsed_msec = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+        if (elapsed_msec + MONITOR_NETLINK_SETTLE_MSEC
+                >= MONITOR_NETLINK_MAX_DELAY_MSEC) {
+            /* Do not postpone the reset any more, the timer fires soon. */
+            return;
+        }
+
+        talloc_zfree(ctx->netlink_te);
+    }
+
+    tv = tevent_timeval_add(&now, 0, MONITOR_NETLINK_SETTLE_MSEC * 1000);
+    ctx->netlink_te = tevent_add_timer(ctx->ev, ctx, tv,
+                                       network_status_settled, ctx);
+    if (ctx->netlink_te == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cannot delay the network status "
+              "change, signaling providers now\n");
+        network_status_signal_providers(ctx);
+    }
+}
+
 static int add_svc_conn_spy(struct mt_svc *svc);
 
 static int service_not_found(const char *svc_name,
@@ -933,6 +997,14 @@ static int get_monitor_config(struct mt_ctx *ctx)
 
     ctx->service_id_timeout = timeout_seconds * 1000; /* service_id_timeout is in ms */
 
+    ret = confdb_get_bool(ctx->cdb,
+                          CONFDB_MONITOR_CONF_ENTRY,
+                          CONFDB_MONITOR_PARALLEL_STARTUP,
+                          false, &ctx->parallel_startup);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = confdb_get_string_as_list(ctx->cdb, ctx,
                                     CONFDB_MONITOR_CONF_ENTRY,
                                     CONFDB_MONITOR_ACTIVE_SERVICES,
@@ -1903,6 +1975,412 @@ static int monitor_config_files(struct mt_ctx *ctx)
     return EOK;
 }
 
+/* Services that do not answer in time are left out of the metrics. */
+#define MONITOR_METRICS_TIMEOUT 5
+
+struct monitor_metrics_state {
+    struct tevent_context *ev;
+    int fd;
+
+    /* pending sbus calls, freed when all metrics are collected */
+    TALLOC_CTX *calls;
+    size_t num_calls;
+    struct tevent_timer *timeout;
+
+    struct sss_metrics_source *sources;
+    size_t num_sources;
+};
+
+struct monitor_metrics_call {
+    struct tevent_req *req;
+    const char *component;
+};
+
+static int monitor_metrics_state_destructor(struct monitor_metrics_state *state)
+{
+    if (state->fd != -1) {
+        close(state->fd);
+        state->fd = -1;
+    }
+
+    return 0;
+}
+
+static void monitor_metrics_collected(struct tevent_req *subreq);
+static void monitor_metrics_timeout(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv,
+                                    void *pvt);
+static void monitor_metrics_write(struct tevent_req *req);
+static void monitor_metrics_written(struct tevent_req *subreq);
+
+static struct tevent_req *monitor_metrics_send(TALLOC_CTX *mem_ctx,
+                                               struct mt_ctx *ctx,
+                                               int fd)
+{
+    struct monitor_metrics_state *state;
+    struct monitor_metrics_call *call;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    struct mt_svc *svc;
+    struct timeval tv;
+    size_t num_svcs;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct monitor_metrics_state);
+    if (req == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    state->ev = ctx->ev;
+    state->fd = fd;
+    talloc_set_destructor(state, monitor_metrics_state_destructor);
+
+    num_svcs = 0;
+    for (svc = ctx->svc_list; svc != NULL; svc = svc->next) {
+        num_svcs++;
+    }
+
+    state->sources = talloc_zero_array(state, struct sss_metrics_source,
+                                       num_svcs + 1);
+    state->calls = talloc_new(state);
+    if (state->sources == NULL || state->calls == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->sources[0].component = "monitor";
+    ret = sss_metrics_export(state->sources, &state->sources[0].samples,
+                             &state->sources[0].num_samples);
+    if (ret != EOK) {
+        goto done;
+    }
+    state->num_sources = 1;
+
+    for (svc = ctx->svc_list; svc != NULL; svc = svc->next) {
+        if (svc->conn == NULL) {
+            /* not running or not connected yet */
+            continue;
+        }
+
+        subreq = sbus_call_metrics_GetMetrics_send(state->calls,
+                                                   ctx->sbus_conn,
+                                                   svc->busname,
+                                                   SSS_BUS_PATH);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        call = talloc_zero(subreq, struct monitor_metrics_call);
+        if (call == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        call->req = req;
+        call->component = talloc_strdup(call, svc->name);
+        if (call->component == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, monitor_metrics_collected, call);
+        state->num_calls++;
+    }
+
+    if (state->num_calls == 0) {
+        monitor_metrics_write(req);
+        return req;
+    }
+
+    tv = tevent_timeval_current_ofs(MONITOR_METRICS_TIMEOUT, 0);
+    state->timeout = tevent_add_timer(state->ev, state, tv,
+                                      monitor_metrics_timeout, req);
+    if (state->timeout == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, state->ev);
+    }
+
+    return req;
+}
+
+static void monitor_metrics_collected(struct tevent_req *subreq)
+{
+    struct monitor_metrics_state *state;
+    struct monitor_metrics_call *call;
+    struct sss_metrics_source *source;
+    struct tevent_req *req;
+    uint32_t *metrics;
+    const char **suffixes;
+    const char **labels;
+    const char **values;
+    size_t num;
+    size_t i;
+    errno_t ret;
+
+    call = tevent_req_callback_data(subreq, struct monitor_metrics_call);
+    req = call->req;
+    state = tevent_req_data(req, struct monitor_metrics_state);
+
+    ret = sbus_call_metrics_GetMetrics_recv(state, subreq, &metrics,
+                                            &suffixes, &labels, &values);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to get metrics of %s [%d]: %s\n",
+              call->component, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    num = talloc_array_length(metrics);
+    for (i = 0; i < num; i++) {
+        if (suffixes[i] == NULL || labels[i] == NULL || values[i] == NULL) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Malformed metrics of %s\n",
+                  call->component);
+            goto done;
+        }
+    }
+
+    source = &state->sources[state->num_sources];
+    source->component = talloc_steal(state->sources, call->component);
+    source->samples = talloc_zero_array(state->sources,
+                                        struct sss_metrics_sample, num);
+    if (source->samples == NULL) {
+        goto done;
+    }
+
+    for (i = 0; i < num; i++) {
+        source->samples[i].metric = metrics[i];
+        source->samples[i].suffix = suffixes[i];
+        source->samples[i].labels = labels[i];
+        source->samples[i].value = values[i];
+    }
+    source->num_samples = num;
+    state->num_sources++;
+
+done:
+    talloc_zfree(subreq);
+
+    state->num_calls--;
+    if (state->num_calls == 0) {
+        monitor_metrics_write(req);
+    }
+}
+
+static void monitor_metrics_timeout(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv,
+                                    void *pvt)
+{
+    struct monitor_metrics_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct monitor_metrics_state);
+
+    DEBUG(SSSDBG_MINOR_FAILURE, "%zu services did not send their metrics "
+          "in time\n", state->num_calls);
+
+    state->timeout = NULL;
+    monitor_metrics_write(req);
+}
+
+static void monitor_metrics_write(struct tevent_req *req)
+{
+    struct monitor_metrics_state *state;
+    struct tevent_req *subreq;
+    char *text;
+
+    state = tevent_req_data(req, struct monitor_metrics_state);
+
+    /* Cancel the calls that are still pending. */
+    talloc_zfree(state->calls);
+    state->num_calls = 0;
+    talloc_zfree(state->timeout);
+
+    text = sss_metrics_format(state, state->sources, state->num_sources);
+    if (text == NULL) {
+        tevent_req_error(req, ENOMEM);
+        tevent_req_post(req, state->ev);
+        return;
+    }
+
+    subreq = write_pipe_send(state, state->ev, (uint8_t *)text,
+                             strlen(text), state->fd);
+    if (subreq == NULL) {
+        tevent_req_error(req, ENOMEM);
+        tevent_req_post(req, state->ev);
+        return;
+    }
+
+    tevent_req_set_callback(subreq, monitor_metrics_written, req);
+}
+
+static void monitor_metrics_written(struct tevent_req *subreq)
+{
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+
+    ret = write_pipe_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t monitor_metrics_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+static void monitor_metrics_done(struct tevent_req *req)
+{
+    errno_t ret;
+
+    ret = monitor_metrics_recv(req);
+    talloc_zfree(req);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to serve metrics [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
+
+static void monitor_metrics_accept(struct tevent_context *ev,
+                                   struct tevent_fd *fde,
+                                   uint16_t flags,
+                                   void *pvt)
+{
+    struct mt_ctx *ctx;
+    struct tevent_req *req;
+    int fd;
+    errno_t ret;
+
+    ctx = talloc_get_type(pvt, struct mt_ctx);
+
+    fd = accept4(ctx->metrics_fd, NULL, NULL,
+                 SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_MINOR_FAILURE, "accept failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return;
+    }
+
+    req = monitor_metrics_send(ctx, ctx, fd);
+    if (req == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Out of memory!\n");
+        return;
+    }
+
+    tevent_req_set_callback(req, monitor_metrics_done, NULL);
+}
+
+static errno_t monitor_setup_metrics(struct mt_ctx *ctx)
+{
+    struct sockaddr_un addr;
+    struct tevent_fd *fde;
+    char *path;
+    mode_t old_umask;
+    int fd = -1;
+    errno_t ret;
+
+    ret = confdb_get_string(ctx->cdb, ctx, CONFDB_MONITOR_CONF_ENTRY,
+                            CONFDB_MONITOR_METRICS_SOCKET, NULL, &path);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Failed to read metrics_socket from confdb: [%d] %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (path == NULL) {
+        return EOK;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Metrics socket path is too long\n");
+        ret = EINVAL;
+        goto done;
+    }
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    /* remove a socket left over by a previous run */
+    if (unlink(path) != 0 && errno != ENOENT) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to remove %s [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    old_umask = umask(0177);
+    ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old_umask);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to bind %s [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (chown(path, ctx->uid, ctx->gid) != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to chown %s [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (listen(fd, 10) == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to listen on %s [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    fde = tevent_add_fd(ctx->ev, ctx, fd, TEVENT_FD_READ,
+                        monitor_metrics_accept, ctx);
+    if (fde == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    tevent_fd_set_auto_close(fde);
+    ctx->metrics_fd = fd;
+    fd = -1;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Serving metrics on %s\n", path);
+
+    ret = EOK;
+
+done:
+    if (fd != -1) {
+        close(fd);
+    }
+    talloc_free(path);
+    return ret;
+}
+
 static void monitor_sbus_connected(struct tevent_req *req);
 
 static int monitor_process_init(struct mt_ctx *ctx,
@@ -2085,6 +2563,11 @@ static void monitor_sbus_connected(struct tevent_req *req)
         }
     }
 
+    ret = monitor_setup_metrics(ctx);
+    if (ret != EOK) {
+        goto done;
+    }
+
     /* start providers */
     num_providers = 0;
     for (dom = ctx->domains; dom; dom = get_next_domain(dom, 0)) {
@@ -2097,7 +2580,7 @@ static void monitor_sbus_connected(struct tevent_req *req)
         }
     }
 
-    if (num_providers > 0) {
+    if (num_providers > 0 && !ctx->parallel_startup) {
         /* now set the services startup timeout *
          * (responders will be started automatically when all
          *  providers are up and running or when the timeout
@@ -2111,8 +2594,8 @@ static void monitor_sbus_connected(struct tevent_req *req)
 
         ctx->services_started = true;
 
-        /* No providers start services immediately
-         * Normally this means only LOCAL is configured */
+        /* No providers or parallel startup, start services immediately.
+         * The responders use the cache until the providers connect. */
         for (i = 0; ctx->services[i]; i++) {
             ret = add_new_service(ctx, ctx->services[i], 0);
             if (ret != EOK) {
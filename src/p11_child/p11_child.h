@@ -43,6 +43,8 @@ struct cert_verify_opts {
     char *ocsp_default_responder;
     char *ocsp_default_responder_signing_cert;
     char *crl_file;
+    /* directory with OCSP responses kept until their nextUpdate time */
+    char *ocsp_cache_dir;
     CK_MECHANISM_TYPE ocsp_dgst;
     bool soft_ocsp;
     bool soft_crl;
@@ -64,6 +66,11 @@ enum pin_mode {
 errno_t init_p11_ctx(TALLOC_CTX *mem_ctx, const char *nss_db,
                      bool wait_for_card, struct p11_ctx **p11_ctx);
 
+/* Loads the PKCS#11 modules before the request is known. */
+errno_t preload_p11_ctx(struct p11_ctx *p11_ctx);
+
+void set_wait_for_card(struct p11_ctx *p11_ctx, bool wait_for_card);
+
 errno_t init_verification(struct p11_ctx *p11_ctx,
                           struct cert_verify_opts *cert_verify_opts);
 
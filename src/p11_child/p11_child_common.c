@@ -55,12 +55,9 @@ static const char *op_mode_str(enum op_mode mode)
     }
 }
 
-static int do_work(TALLOC_CTX *mem_ctx, enum op_mode mode, const char *ca_db,
-                   struct cert_verify_opts *cert_verify_opts,
-                   bool wait_for_card,
-                   const char *cert_b64, const char *pin,
-                   const char *module_name, const char *token_name,
-                   const char *key_id, const char *uri, char **multi)
+static int init_work(TALLOC_CTX *mem_ctx, const char *ca_db,
+                     struct cert_verify_opts *cert_verify_opts,
+                     bool wait_for_card, struct p11_ctx **_p11_ctx)
 {
     int ret;
     struct p11_ctx *p11_ctx;
@@ -75,10 +72,25 @@ static int do_work(TALLOC_CTX *mem_ctx, enum op_mode mode, const char *ca_db,
         ret = init_verification(p11_ctx, cert_verify_opts);
         if (ret != 0) {
             DEBUG(SSSDBG_OP_FAILURE, "init_verification failed.\n");
-            goto done;
+            talloc_free(p11_ctx);
+            return ret;
         }
     }
 
+    *_p11_ctx = p11_ctx;
+
+    return EOK;
+}
+
+/* Runs the operation and frees p11_ctx. */
+static int do_work(TALLOC_CTX *mem_ctx, struct p11_ctx *p11_ctx,
+                   enum op_mode mode,
+                   struct cert_verify_opts *cert_verify_opts,
+                   const char *cert_b64, const char *pin,
+                   const char *module_name, const char *token_name,
+                   const char *key_id, const char *uri, char **multi)
+{
+    int ret;
 
     if (mode == OP_VERIFIY) {
         if (!cert_verify_opts->do_verification
@@ -94,18 +106,44 @@ static int do_work(TALLOC_CTX *mem_ctx, enum op_mode mode, const char *ca_db,
                       module_name, token_name, key_id, uri, multi);
     }
 
-done:
     talloc_free(p11_ctx);
 
     return ret;
 }
 
+static errno_t p11c_parse_pin(TALLOC_CTX *mem_ctx, const uint8_t *buf,
+                              size_t len, char **pin)
+{
+    char *str;
+
+    if (len == 0 || *buf == '\0') {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Missing PIN.\n");
+        return EINVAL;
+    }
+
+    str = talloc_strndup(mem_ctx, (char *) buf, len);
+    if (str == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_strndup failed.\n");
+        return ENOMEM;
+    }
+
+    if (strlen(str) != len) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Input contains additional data, only PIN expected.\n");
+        talloc_free(str);
+        return EINVAL;
+    }
+
+    *pin = str;
+
+    return EOK;
+}
+
 static errno_t p11c_recv_data(TALLOC_CTX *mem_ctx, int fd, char **pin)
 {
     uint8_t buf[IN_BUF_SIZE];
     ssize_t len;
     errno_t ret;
-    char *str;
 
     errno = 0;
     len = sss_atomic_read_s(fd, buf, IN_BUF_SIZE);
@@ -117,32 +155,175 @@ static errno_t p11c_recv_data(TALLOC_CTX *mem_ctx, int fd, char **pin)
         return ret;
     }
 
-    if (len == 0 || *buf == '\0') {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Missing PIN.\n");
-        return EINVAL;
-    }
+    return p11c_parse_pin(mem_ctx, buf, len, pin);
+}
 
-    str = talloc_strndup(mem_ctx, (char *) buf, len);
-    if (str == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "talloc_strndup failed.\n");
+/* In standby mode the options of the request are sent on stdin as a list of
+ * NUL terminated strings which ends with an empty string. The input which is
+ * usually sent on stdin, e.g. the PIN, follows the list. Returns ENOENT if
+ * the input was closed without a request. */
+static errno_t p11c_recv_request(TALLOC_CTX *mem_ctx, int fd,
+                                 int *_argc, const char ***_argv,
+                                 uint8_t **_data, size_t *_data_len)
+{
+    uint8_t *buf;
+    ssize_t len;
+    size_t c;
+    size_t start;
+    int argc;
+    const char **argv;
+    errno_t ret;
+
+    buf = talloc_size(mem_ctx, P11_CHILD_IN_BUF_SIZE);
+    if (buf == NULL) {
         return ENOMEM;
     }
 
-    if (strlen(str) != len) {
+    errno = 0;
+    len = sss_atomic_read_s(fd, buf, P11_CHILD_IN_BUF_SIZE);
+    if (len == -1) {
+        ret = errno;
+        ret = (ret == 0) ? EINVAL: ret;
         DEBUG(SSSDBG_CRIT_FAILURE,
-              "Input contains additional data, only PIN expected.\n");
-        talloc_free(str);
+              "read failed [%d][%s].\n", ret, strerror(ret));
+        return ret;
+    }
+
+    if (len == 0) {
+        return ENOENT;
+    }
+
+    /* program name */
+    argc = 1;
+    c = 0;
+    while (c < len && buf[c] != '\0') {
+        for (; c < len && buf[c] != '\0'; c++);
+        if (c == len) {
+            break;
+        }
+        argc++;
+        c++;
+    }
+
+    if (c >= len) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Request is not terminated.\n");
         return EINVAL;
     }
 
-    *pin = str;
+    argv = talloc_zero_array(mem_ctx, const char *, argc + 1);
+    if (argv == NULL) {
+        return ENOMEM;
+    }
+
+    argv[0] = "p11_child";
+    argc = 1;
+    start = 0;
+    while (buf[start] != '\0') {
+        argv[argc] = (const char *) buf + start;
+        DEBUG(SSSDBG_TRACE_ALL, "Request option [%s].\n", argv[argc]);
+        start += strlen(argv[argc]) + 1;
+        argc++;
+    }
+
+    *_argc = argc;
+    *_argv = argv;
+    *_data = buf + start + 1;
+    *_data_len = len - (start + 1);
 
     return EOK;
 }
 
-int main(int argc, const char *argv[])
+static void parse_op_args(poptContext pc, enum op_mode *mode,
+                          enum pin_mode *pin_mode, bool *wait_for_card)
 {
     int opt;
+
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        case 'a':
+            if (*mode != OP_NONE) {
+                fprintf(stderr,
+                        "\n--verify, --auth and --pre are mutually " \
+                        "exclusive and should be only used once.\n\n");
+                poptPrintUsage(pc, stderr, 0);
+                _exit(-1);
+            }
+            *mode = OP_AUTH;
+            break;
+        case 'p':
+            if (*mode != OP_NONE) {
+                fprintf(stderr,
+                        "\n--verify, --auth and --pre are mutually " \
+                        "exclusive and should be only used once.\n\n");
+                poptPrintUsage(pc, stderr, 0);
+                _exit(-1);
+            }
+            *mode = OP_PREAUTH;
+            break;
+        case 'v':
+            if (*mode != OP_NONE) {
+                fprintf(stderr,
+                        "\n--verify, --auth and --pre are mutually " \
+                        "exclusive and should be only used once.\n\n");
+                poptPrintUsage(pc, stderr, 0);
+                _exit(-1);
+            }
+            *mode = OP_VERIFIY;
+            break;
+        case 'i':
+            if (*pin_mode != PIN_NONE) {
+                fprintf(stderr, "\n--pin and --keypad are mutually exclusive " \
+                                "and should be only used once.\n\n");
+                poptPrintUsage(pc, stderr, 0);
+                _exit(-1);
+            }
+            *pin_mode = PIN_STDIN;
+            break;
+        case 'k':
+            if (*pin_mode != PIN_NONE) {
+                fprintf(stderr, "\n--pin and --keypad are mutually exclusive " \
+                                "and should be only used once.\n\n");
+                poptPrintUsage(pc, stderr, 0);
+                _exit(-1);
+            }
+            *pin_mode = PIN_KEYPAD;
+            break;
+        case 'w':
+            *wait_for_card = true;
+            break;
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                  poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            _exit(-1);
+        }
+    }
+}
+
+static void check_op_args(poptContext pc, enum op_mode mode,
+                          enum pin_mode pin_mode, const char *cert_b64)
+{
+    if (mode == OP_NONE) {
+        fprintf(stderr, "\nMissing operation mode, either " \
+                        "--verify, --auth or --pre must be specified.\n\n");
+        poptPrintUsage(pc, stderr, 0);
+        _exit(-1);
+    } else if (mode == OP_AUTH && pin_mode == PIN_NONE) {
+        fprintf(stderr, "\nMissing PIN mode for authentication, " \
+                        "either --pin or --keypad must be specified.\n");
+        poptPrintUsage(pc, stderr, 0);
+        _exit(-1);
+    } else if (mode == OP_VERIFIY && cert_b64 == NULL) {
+        fprintf(stderr, "\nMissing certificate for verify operation, " \
+                        "--certificate base64_encoded_certificate " \
+                        "must be added.\n");
+        poptPrintUsage(pc, stderr, 0);
+        _exit(-1);
+    }
+}
+
+int main(int argc, const char *argv[])
+{
     poptContext pc;
     int debug_fd = -1;
     const char *opt_logger = NULL;
@@ -161,6 +342,12 @@ int main(int argc, const char *argv[])
     char *cert_b64 = NULL;
     bool wait_for_card = false;
     char *uri = NULL;
+    int standby = 0;
+    struct p11_ctx *p11_ctx = NULL;
+    int req_argc;
+    const char **req_argv;
+    uint8_t *req_data;
+    size_t req_data_len;
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
@@ -198,6 +385,9 @@ int main(int argc, const char *argv[])
          _("certificate to verify, base64 encoded"), NULL},
         {"uri", 0, POPT_ARG_STRING, &uri, 0,
          _("PKCS#11 URI to restrict selection"), NULL},
+        {"standby", 0, POPT_ARG_NONE, &standby, 0,
+         _("Prepare the PKCS#11 modules and read the request from stdin"),
+         NULL},
         POPT_TABLEEND
     };
 
@@ -215,66 +405,7 @@ int main(int argc, const char *argv[])
     umask(SSS_DFL_UMASK);
 
     pc = poptGetContext(argv[0], argc, argv, long_options, 0);
-    while ((opt = poptGetNextOpt(pc)) != -1) {
-        switch(opt) {
-        case 'a':
-            if (mode != OP_NONE) {
-                fprintf(stderr,
-                        "\n--verify, --auth and --pre are mutually " \
-                        "exclusive and should be only used once.\n\n");
-                poptPrintUsage(pc, stderr, 0);
-                _exit(-1);
-            }
-            mode = OP_AUTH;
-            break;
-        case 'p':
-            if (mode != OP_NONE) {
-                fprintf(stderr,
-                        "\n--verify, --auth and --pre are mutually " \
-                        "exclusive and should be only used once.\n\n");
-                poptPrintUsage(pc, stderr, 0);
-                _exit(-1);
-            }
-            mode = OP_PREAUTH;
-            break;
-        case 'v':
-            if (mode != OP_NONE) {
-                fprintf(stderr,
-                        "\n--verify, --auth and --pre are mutually " \
-                        "exclusive and should be only used once.\n\n");
-                poptPrintUsage(pc, stderr, 0);
-                _exit(-1);
-            }
-            mode = OP_VERIFIY;
-            break;
-        case 'i':
-            if (pin_mode != PIN_NONE) {
-                fprintf(stderr, "\n--pin and --keypad are mutually exclusive " \
-                                "and should be only used once.\n\n");
-                poptPrintUsage(pc, stderr, 0);
-                _exit(-1);
-            }
-            pin_mode = PIN_STDIN;
-            break;
-        case 'k':
-            if (pin_mode != PIN_NONE) {
-                fprintf(stderr, "\n--pin and --keypad are mutually exclusive " \
-                                "and should be only used once.\n\n");
-                poptPrintUsage(pc, stderr, 0);
-                _exit(-1);
-            }
-            pin_mode = PIN_KEYPAD;
-            break;
-        case 'w':
-            wait_for_card = true;
-            break;
-        default:
-            fprintf(stderr, "\nInvalid option %s: %s\n\n",
-                  poptBadOption(pc, 0), poptStrerror(opt));
-            poptPrintUsage(pc, stderr, 0);
-            _exit(-1);
-        }
-    }
+    parse_op_args(pc, &mode, &pin_mode, &wait_for_card);
 
     if (nss_db == NULL) {
         fprintf(stderr, "\nMissing NSS DB --nssdb must be specified.\n\n");
@@ -282,22 +413,15 @@ int main(int argc, const char *argv[])
         _exit(-1);
     }
 
-    if (mode == OP_NONE) {
-        fprintf(stderr, "\nMissing operation mode, either " \
-                        "--verify, --auth or --pre must be specified.\n\n");
-        poptPrintUsage(pc, stderr, 0);
-        _exit(-1);
-    } else if (mode == OP_AUTH && pin_mode == PIN_NONE) {
-        fprintf(stderr, "\nMissing PIN mode for authentication, " \
-                        "either --pin or --keypad must be specified.\n");
-        poptPrintUsage(pc, stderr, 0);
-        _exit(-1);
-    } else if (mode == OP_VERIFIY && cert_b64 == NULL) {
-        fprintf(stderr, "\nMissing certificate for verify operation, " \
-                        "--certificate base64_encoded_certificate " \
-                        "must be added.\n");
-        poptPrintUsage(pc, stderr, 0);
-        _exit(-1);
+    if (standby) {
+        if (mode != OP_NONE) {
+            fprintf(stderr, "\nThe operation mode of --standby is read " \
+                            "from stdin.\n\n");
+            poptPrintUsage(pc, stderr, 0);
+            _exit(-1);
+        }
+    } else {
+        check_op_args(pc, mode, pin_mode, cert_b64);
     }
 
     poptFreeContext(pc);
@@ -322,8 +446,6 @@ int main(int argc, const char *argv[])
 
     DEBUG(SSSDBG_TRACE_FUNC, "p11_child started.\n");
 
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Running in [%s] mode.\n", op_mode_str(mode));
-
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "Running with effective IDs: [%"SPRIuid"][%"SPRIgid"].\n",
           geteuid(), getegid());
@@ -340,6 +462,49 @@ int main(int argc, const char *argv[])
     }
     talloc_steal(main_ctx, debug_prg_name);
 
+    ret = parse_cert_verify_opts(main_ctx, verify_opts, &cert_verify_opts);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Failed to parse verify option.\n");
+        goto fail;
+    }
+
+    if (standby) {
+        /* Do the expensive setup while the responder has no request for
+         * us yet. */
+        ret = init_work(main_ctx, nss_db, cert_verify_opts, false, &p11_ctx);
+        if (ret != EOK) {
+            goto fail;
+        }
+
+        ret = preload_p11_ctx(p11_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "preload_p11_ctx failed.\n");
+            goto fail;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Waiting for the request.\n");
+
+        ret = p11c_recv_request(main_ctx, STDIN_FILENO, &req_argc, &req_argv,
+                                &req_data, &req_data_len);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_TRACE_FUNC, "No request received.\n");
+            talloc_free(main_ctx);
+            return EXIT_SUCCESS;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Failed to read the request.\n");
+            goto fail;
+        }
+
+        pc = poptGetContext(argv[0], req_argc, req_argv, long_options, 0);
+        parse_op_args(pc, &mode, &pin_mode, &wait_for_card);
+        check_op_args(pc, mode, pin_mode, cert_b64);
+        poptFreeContext(pc);
+
+        set_wait_for_card(p11_ctx, wait_for_card);
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Running in [%s] mode.\n", op_mode_str(mode));
+
     if (mode == OP_AUTH && (module_name == NULL || token_name == NULL
                                 || key_id == NULL)) {
         DEBUG(SSSDBG_FATAL_FAILURE,
@@ -349,12 +514,6 @@ int main(int argc, const char *argv[])
         goto fail;
     }
 
-    ret = parse_cert_verify_opts(main_ctx, verify_opts, &cert_verify_opts);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_FATAL_FAILURE, "Failed to parse verify option.\n");
-        goto fail;
-    }
-
     if (mode == OP_VERIFIY && !cert_verify_opts->do_verification) {
         fprintf(stderr,
                 "Called verification with option 'no_verification', "
@@ -362,14 +521,26 @@ int main(int argc, const char *argv[])
     }
 
     if (mode == OP_AUTH && pin_mode == PIN_STDIN) {
-        ret = p11c_recv_data(main_ctx, STDIN_FILENO, &pin);
+        if (standby) {
+            ret = p11c_parse_pin(main_ctx, req_data, req_data_len, &pin);
+        } else {
+            ret = p11c_recv_data(main_ctx, STDIN_FILENO, &pin);
+        }
         if (ret != EOK) {
             DEBUG(SSSDBG_FATAL_FAILURE, "Failed to read PIN.\n");
             goto fail;
         }
     }
 
-    ret = do_work(main_ctx, mode, nss_db, cert_verify_opts, wait_for_card,
+    if (p11_ctx == NULL) {
+        ret = init_work(main_ctx, nss_db, cert_verify_opts, wait_for_card,
+                        &p11_ctx);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
+    ret = do_work(main_ctx, p11_ctx, mode, cert_verify_opts,
                   cert_b64, pin, module_name, token_name, key_id, uri, &multi);
     if (ret != 0) {
         DEBUG(SSSDBG_OP_FAILURE, "do_work failed.\n");
@@ -43,6 +43,7 @@ static struct cert_verify_opts *init_cert_verify_opts(TALLOC_CTX *mem_ctx)
     cert_verify_opts->ocsp_default_responder = NULL;
     cert_verify_opts->ocsp_default_responder_signing_cert = NULL;
     cert_verify_opts->crl_file = NULL;
+    cert_verify_opts->ocsp_cache_dir = NULL;
     cert_verify_opts->ocsp_dgst = CKM_SHA256;
     cert_verify_opts->soft_ocsp = false;
     cert_verify_opts->soft_crl = false;
@@ -63,6 +64,9 @@ static struct cert_verify_opts *init_cert_verify_opts(TALLOC_CTX *mem_ctx)
 #define OCSP_DGST "ocsp_dgst="
 #define OCSP_DGST_LEN (sizeof(OCSP_DGST) -1)
 
+#define OCSP_CACHE_DIR "ocsp_cache_dir="
+#define OCSP_CACHE_DIR_LEN (sizeof(OCSP_CACHE_DIR) -1)
+
 errno_t parse_cert_verify_opts(TALLOC_CTX *mem_ctx, const char *verify_opts,
                                struct cert_verify_opts **_cert_verify_opts)
 {
@@ -153,6 +157,28 @@ errno_t parse_cert_verify_opts(TALLOC_CTX *mem_ctx, const char *verify_opts,
                 ret = EINVAL;
                 goto done;
             }
+        } else if (strncasecmp(opts[c], OCSP_CACHE_DIR,
+                               OCSP_CACHE_DIR_LEN) == 0) {
+#ifdef HAVE_NSS
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Option [%s] is not supported in NSS build, ignored.\n",
+                  OCSP_CACHE_DIR);
+#else
+            cert_verify_opts->ocsp_cache_dir =
+                       talloc_strdup(cert_verify_opts,
+                                     &opts[c][OCSP_CACHE_DIR_LEN]);
+            if (cert_verify_opts->ocsp_cache_dir == NULL
+                    || *cert_verify_opts->ocsp_cache_dir == '\0') {
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                      "Failed to parse ocsp_cache_dir option [%s].\n",
+                      opts[c]);
+                ret = EINVAL;
+                goto done;
+            }
+
+            DEBUG(SSSDBG_TRACE_ALL, "Caching OCSP responses in [%s]\n",
+                                    cert_verify_opts->ocsp_cache_dir);
+#endif
         } else if (strncasecmp(opts[c], OCSP_DGST, OCSP_DGST_LEN) == 0) {
 #ifdef HAVE_NSS
             DEBUG(SSSDBG_CRIT_FAILURE,
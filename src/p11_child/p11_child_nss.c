@@ -1005,3 +1005,14 @@ errno_t init_p11_ctx(TALLOC_CTX *mem_ctx, const char *nss_db,
 
     return EOK;
 }
+
+errno_t preload_p11_ctx(struct p11_ctx *p11_ctx)
+{
+    /* The modules of the NSS database are loaded by init_p11_ctx(). */
+    return EOK;
+}
+
+void set_wait_for_card(struct p11_ctx *p11_ctx, bool wait_for_card)
+{
+    p11_ctx->wait_for_card = wait_for_card;
+}
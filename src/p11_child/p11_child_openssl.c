@@ -23,6 +23,8 @@
 */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <openssl/ssl.h>
 #include <openssl/crypto.h>
 #include <openssl/x509.h>
@@ -37,6 +39,7 @@
 #include "util/util.h"
 #include "util/crypto/sss_crypto.h"
 #include "util/child_common.h"
+#include "util/atomic_io.h"
 #include "p11_child/p11_child.h"
 
 struct p11_ctx {
@@ -44,6 +47,8 @@ struct p11_ctx {
     const char *ca_db;
     bool wait_for_card;
     struct cert_verify_opts *cert_verify_opts;
+    /* modules loaded by preload_p11_ctx() */
+    CK_FUNCTION_LIST **modules;
 };
 
 static OCSP_RESPONSE *query_responder(BIO *cbio, const char *host,
@@ -278,6 +283,211 @@ done:
     return str;
 }
 
+/* OCSP responses are kept in ocsp_cache_dir until their nextUpdate time so
+ * that other p11_child runs do not have to contact the responder again. The
+ * file name is derived from the certificate ID, i.e. the hashes of the
+ * issuer name and key and the serial number. A cached response is verified
+ * against the CA certificates like a fresh one before it is used. */
+#define OCSP_CACHE_MAX_SIZE (64 * 1024)
+
+static char *ocsp_cache_file(TALLOC_CTX *mem_ctx, const char *cache_dir,
+                             OCSP_CERTID *cid)
+{
+    unsigned char *der = NULL;
+    char *path;
+    int der_len;
+    int c;
+
+    der_len = i2d_OCSP_CERTID(cid, &der);
+    if (der_len <= 0) {
+        DEBUG(SSSDBG_OP_FAILURE, "i2d_OCSP_CERTID failed.\n");
+        return NULL;
+    }
+
+    path = talloc_asprintf(mem_ctx, "%s/", cache_dir);
+    for (c = 0; path != NULL && c < der_len; c++) {
+        path = talloc_asprintf_append(path, "%02x", der[c]);
+    }
+    OPENSSL_free(der);
+
+    if (path == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_asprintf failed.\n");
+    }
+
+    return path;
+}
+
+static errno_t ocsp_cache_get(struct p11_ctx *p11_ctx, OCSP_CERTID *cid,
+                              int *_status, int *_reason)
+{
+    char *path;
+    int fd = -1;
+    struct stat st;
+    uint8_t *buf = NULL;
+    const unsigned char *p;
+    ssize_t len;
+    OCSP_RESPONSE *ocsp_resp = NULL;
+    OCSP_BASICRESP *ocsp_basic = NULL;
+    ASN1_GENERALIZEDTIME *revtime;
+    ASN1_GENERALIZEDTIME *thisupd;
+    ASN1_GENERALIZEDTIME *nextupd;
+    int status;
+    int reason;
+    errno_t ret;
+
+    path = ocsp_cache_file(NULL, p11_ctx->cert_verify_opts->ocsp_cache_dir,
+                           cid);
+    if (path == NULL) {
+        return ENOMEM;
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        ret = errno;
+        if (ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "Failed to open [%s] [%d][%s].\n",
+                                     path, ret, sss_strerror(ret));
+        }
+        ret = ENOENT;
+        goto done;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0
+            || st.st_size > OCSP_CACHE_MAX_SIZE) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    buf = talloc_size(path, st.st_size);
+    if (buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    len = sss_atomic_read_s(fd, buf, st.st_size);
+    if (len != st.st_size) {
+        ret = EIO;
+        goto done;
+    }
+
+    p = buf;
+    ocsp_resp = d2i_OCSP_RESPONSE(NULL, &p, len);
+    if (ocsp_resp == NULL
+            || OCSP_response_status(ocsp_resp)
+                                        != OCSP_RESPONSE_STATUS_SUCCESSFUL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    ocsp_basic = OCSP_response_get1_basic(ocsp_resp);
+    if (ocsp_basic == NULL
+            || OCSP_basic_verify(ocsp_basic, NULL, p11_ctx->x509_store, 0) != 1
+            || OCSP_resp_find_status(ocsp_basic, cid, &status, &reason,
+                                     &revtime, &thisupd, &nextupd) != 1) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    /* Without nextUpdate newer information is always available, no grace
+     * time is allowed for the end of the validity. */
+    if (nextupd == NULL || status == V_OCSP_CERTSTATUS_UNKNOWN
+            || OCSP_check_validity(thisupd, nextupd, 5 * 60, -1) != 1
+            || X509_cmp_current_time(nextupd) <= 0) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_ALL, "Using cached OCSP response [%s].\n", path);
+    *_status = status;
+    *_reason = reason;
+    ret = EOK;
+
+done:
+    if (fd != -1) {
+        close(fd);
+    }
+    if (ret == EINVAL) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Cached OCSP response [%s] is not valid anymore.\n", path);
+        unlink(path);
+        ret = ENOENT;
+    }
+    OCSP_BASICRESP_free(ocsp_basic);
+    OCSP_RESPONSE_free(ocsp_resp);
+    talloc_free(path);
+
+    return ret;
+}
+
+static void ocsp_cache_add(struct p11_ctx *p11_ctx, OCSP_CERTID *cid,
+                           OCSP_RESPONSE *ocsp_resp)
+{
+    char *path;
+    char *tmp_path = NULL;
+    unsigned char *der = NULL;
+    int der_len;
+    int fd = -1;
+    ssize_t written;
+    errno_t ret;
+
+    path = ocsp_cache_file(NULL, p11_ctx->cert_verify_opts->ocsp_cache_dir,
+                           cid);
+    if (path == NULL) {
+        return;
+    }
+
+    der_len = i2d_OCSP_RESPONSE(ocsp_resp, &der);
+    if (der_len <= 0 || der_len > OCSP_CACHE_MAX_SIZE) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot cache OCSP response.\n");
+        goto done;
+    }
+
+    tmp_path = talloc_asprintf(path, "%s.XXXXXX", path);
+    if (tmp_path == NULL) {
+        goto done;
+    }
+
+    fd = sss_unique_file(NULL, tmp_path, &ret);
+    if (fd == -1) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to create [%s] [%d][%s].\n",
+                                 tmp_path, ret, sss_strerror(ret));
+        tmp_path = NULL;
+        goto done;
+    }
+
+    written = sss_atomic_write_s(fd, der, der_len);
+    if (written != der_len) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to write [%s].\n", tmp_path);
+        goto done;
+    }
+
+    if (close(fd) != 0) {
+        fd = -1;
+        goto done;
+    }
+    fd = -1;
+
+    if (rename(tmp_path, path) != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to rename [%s] [%d][%s].\n",
+                                 tmp_path, ret, sss_strerror(ret));
+        goto done;
+    }
+    tmp_path = NULL;
+
+    DEBUG(SSSDBG_TRACE_ALL, "OCSP response cached in [%s].\n", path);
+
+done:
+    if (fd != -1) {
+        close(fd);
+    }
+    if (tmp_path != NULL) {
+        unlink(tmp_path);
+    }
+    OPENSSL_free(der);
+    talloc_free(path);
+}
+
 static errno_t do_ocsp(struct p11_ctx *p11_ctx, X509 *cert)
 {
     OCSP_REQUEST *ocsp_req = NULL;
@@ -388,6 +598,23 @@ static errno_t do_ocsp(struct p11_ctx *p11_ctx, X509 *cert)
         goto done;
     }
 
+    if (p11_ctx->cert_verify_opts->ocsp_cache_dir != NULL) {
+        ret = ocsp_cache_get(p11_ctx, cid, &status, &reason);
+        if (ret == EOK) {
+            if (status != V_OCSP_CERTSTATUS_GOOD) {
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                      "Cached OCSP status is [%d][%s], reason [%d][%s].\n",
+                      status, OCSP_cert_status_str(status),
+                      reason, OCSP_crl_reason_str(reason));
+                ret = EIO;
+                goto done;
+            }
+
+            DEBUG(SSSDBG_TRACE_ALL, "Cached OCSP status is good.\n");
+            goto done;
+        }
+    }
+
     OCSP_request_add1_nonce(ocsp_req, NULL, -1);
 
     ocsp_resp = process_responder(ocsp_req, host, path, port, use_ssl,
@@ -472,6 +699,12 @@ static errno_t do_ocsp(struct p11_ctx *p11_ctx, X509 *cert)
         goto done;
     }
 
+    if (p11_ctx->cert_verify_opts->ocsp_cache_dir != NULL
+            && nextupd != NULL && status != V_OCSP_CERTSTATUS_UNKNOWN
+            && OCSP_check_validity(thisupd, nextupd, grace_time, -1) == 1) {
+        ocsp_cache_add(p11_ctx, cid, ocsp_resp);
+    }
+
     if (status != V_OCSP_CERTSTATUS_GOOD) {
         DEBUG(SSSDBG_CRIT_FAILURE, "OCSP check failed with [%d][%s].\n",
                                    status, OCSP_cert_status_str(status));
@@ -572,6 +805,10 @@ done:
 
 static int talloc_cleanup_openssl(struct p11_ctx *p11_ctx)
 {
+    if (p11_ctx->modules != NULL) {
+        p11_kit_modules_finalize_and_release(p11_ctx->modules);
+    }
+
     CRYPTO_cleanup_all_ex_data();
 
     return 0;
@@ -610,6 +847,27 @@ errno_t init_p11_ctx(TALLOC_CTX *mem_ctx, const char *ca_db,
     return EOK;
 }
 
+errno_t preload_p11_ctx(struct p11_ctx *p11_ctx)
+{
+    if (p11_ctx->modules != NULL) {
+        return EOK;
+    }
+
+    p11_ctx->modules = p11_kit_modules_load_and_initialize(0);
+    if (p11_ctx->modules == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "p11_kit_modules_load_and_initialize failed.\n");
+        return EIO;
+    }
+
+    return EOK;
+}
+
+void set_wait_for_card(struct p11_ctx *p11_ctx, bool wait_for_card)
+{
+    p11_ctx->wait_for_card = wait_for_card;
+}
+
 static int talloc_free_x509_store(struct p11_ctx *p11_ctx)
 {
     X509_STORE_free(p11_ctx->x509_store);
@@ -1630,12 +1888,17 @@ errno_t do_card(TALLOC_CTX *mem_ctx, struct p11_ctx *p11_ctx,
     }
 
 
-    /* Maybe use P11_KIT_MODULE_TRUSTED ? */
-    modules = p11_kit_modules_load_and_initialize(0);
-    if (modules == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "p11_kit_modules_load_and_initialize failed.\n");
-        return EIO;
+    if (p11_ctx->modules != NULL) {
+        modules = p11_ctx->modules;
+        p11_ctx->modules = NULL;
+    } else {
+        /* Maybe use P11_KIT_MODULE_TRUSTED ? */
+        modules = p11_kit_modules_load_and_initialize(0);
+        if (modules == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "p11_kit_modules_load_and_initialize failed.\n");
+            return EIO;
+        }
     }
 
     for (;;) {
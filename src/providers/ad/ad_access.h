@@ -49,6 +49,10 @@ struct ad_access_ctx {
     } gpo_map_type;
     hash_table_t *gpo_map_options_table;
     enum gpo_map_type gpo_default_right;
+    /* recent GPO access decisions, see ad_gpo_decision_cache_lookup() */
+    hash_table_t *gpo_decision_cache;
+    /* persistent gpo_child, see ad_gpo_child_start() */
+    struct ad_gpo_child *gpo_child;
 };
 
 struct tevent_req *
@@ -874,6 +874,9 @@ ad_failover_init(TALLOC_CTX *mem_ctx, struct be_ctx *bectx,
         goto done;
     }
 
+    be_fo_set_probe_port(bectx, ad_service, service->port);
+    be_fo_set_probe_port(bectx, ad_gc_service, service->gc_port);
+
     service->sdap->kinit_service_name = service->krb5_service->name;
     service->gc->kinit_service_name = service->krb5_service->name;
 
@@ -1536,7 +1539,7 @@ ad_get_dom_ldap_conn(struct ad_id_ctx *ad_ctx, struct sss_domain_info *dom)
     struct ad_id_ctx *subdom_id_ctx;
 
     sdom = sdap_domain_get(ad_ctx->sdap_id_ctx->opts, dom);
-    if (sdom == NULL || sdom->pvt == NULL) {
+    if (sdom == NULL || sdap_domain_get_pvt(sdom) == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "No ID ctx available for [%s].\n",
                                     dom->name);
         return NULL;
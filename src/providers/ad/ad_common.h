@@ -70,6 +70,7 @@ enum ad_basic_opt {
     AD_MACHINE_ACCOUNT_PASSWORD_RENEWAL_OPTS,
     AD_UPDATE_SAMBA_MACHINE_ACCOUNT_PASSWORD,
     AD_USE_LDAPS,
+    AD_RACE_GC_LDAP,
 
     AD_OPTS_BASIC /* opts counter */
 };
@@ -235,9 +235,8 @@ static void ad_dyndns_update_connect_done(struct tevent_req *subreq)
 
     subreq = sdap_dyndns_update_send(state, sdap_ctx->be->ev,
                                      sdap_ctx->be,
-                                     ctx->dyndns_ctx->opts,
+                                     ctx->dyndns_ctx,
                                      sdap_ctx,
-                                     ctx->dyndns_ctx->auth_type,
                                      dp_opt_get_string(ctx->dyndns_ctx->opts,
                                                        DP_OPT_DYNDNS_IFACE),
                                      dp_opt_get_string(ctx->basic,
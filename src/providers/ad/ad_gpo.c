@@ -38,6 +38,7 @@
 #include "util/util.h"
 #include "util/strtonum.h"
 #include "util/child_common.h"
+#include "util/sss_ptr_hash.h"
 #include "providers/data_provider.h"
 #include "providers/backend.h"
 #include "providers/ad/ad_access.h"
@@ -101,6 +102,14 @@
 
 #define GPO_CHILD_LOG_FILE "gpo_child"
 
+/* SOM and GPO objects are searched with up to this many parallel LDAP
+ * requests. */
+#define GPO_MAX_PARALLEL_SEARCHES 8
+
+/* The persistent gpo_child is stopped after being idle for this many
+ * seconds. */
+#define GPO_CHILD_IDLE_TIMEOUT 60
+
 /* If INI_PARSE_IGNORE_NON_KVP is not defined, use 0 (no effect) */
 #ifndef INI_PARSE_IGNORE_NON_KVP
 #define INI_PARSE_IGNORE_NON_KVP 0
@@ -172,6 +181,7 @@ int ad_gpo_process_gpo_recv(struct tevent_req *req,
 
 struct tevent_req *ad_gpo_process_cse_send(TALLOC_CTX *mem_ctx,
                                            struct tevent_context *ev,
+                                           struct ad_access_ctx *access_ctx,
                                            bool send_to_child,
                                            struct sss_domain_info *domain,
                                            const char *gpo_guid,
@@ -1772,6 +1782,8 @@ struct ad_gpo_access_state {
     struct gp_gpo **cse_filtered_gpos;
     int num_cse_filtered_gpos;
     int cse_gpo_index;
+    char *decision_key;
+    char *decision_sids;
 };
 
 static void ad_gpo_connect_done(struct tevent_req *subreq);
@@ -1783,6 +1795,228 @@ static errno_t ad_gpo_cse_step(struct tevent_req *req);
 static void ad_gpo_cse_done(struct tevent_req *subreq);
 static void ad_gpo_get_host_sid_retrieval_done(struct tevent_req *subreq);
 
+/* == GPO decision cache ==================================================== */
+
+/*
+ * The outcome of a GPO evaluation only depends on the SIDs of the user, the
+ * applicable GPOs and their policy files. Within ad_gpo_cache_timeout the
+ * policy files are not looked up again anyway, so the decision for the same
+ * user, SID set and logon right is reused, without any LDAP or SMB traffic,
+ * as long as none of the GPOs it was based on was updated in the cache
+ * meanwhile.
+ */
+struct ad_gpo_decision {
+    char *sids;
+    const char **gpo_guids;
+    int *gpo_versions;
+    int num_gpos;
+    errno_t result;
+};
+
+static int ad_gpo_sid_cmp(const void *a, const void *b)
+{
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+static errno_t
+ad_gpo_decision_sids(TALLOC_CTX *mem_ctx,
+                     const char *user,
+                     struct sss_domain_info *domain,
+                     char **_sids)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *user_sid = NULL;
+    const char **group_sids = NULL;
+    int group_size = 0;
+    char *sids;
+    int i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = ad_gpo_get_sids(tmp_ctx, user, domain, &user_sid, &group_sids,
+                          &group_size);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    qsort(group_sids, group_size, sizeof(const char *), ad_gpo_sid_cmp);
+
+    sids = talloc_strdup(tmp_ctx, user_sid == NULL ? "" : user_sid);
+    for (i = 0; sids != NULL && i < group_size; i++) {
+        sids = talloc_asprintf_append(sids, ",%s", group_sids[i]);
+    }
+    if (sids == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    *_sids = talloc_steal(mem_ctx, sids);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t
+ad_gpo_cached_gpo_version(struct sss_domain_info *host_domain,
+                          const char *gpo_guid,
+                          int *_version)
+{
+    struct ldb_result *res;
+    errno_t ret;
+
+    ret = sysdb_gpo_get_gpo_by_guid(NULL, host_domain, gpo_guid, &res);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    *_version = ldb_msg_find_attr_as_int(res->msgs[0], SYSDB_GPO_VERSION_ATTR,
+                                         -1);
+    talloc_free(res);
+
+    return EOK;
+}
+
+static void ad_gpo_decision_expire(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval current_time,
+                                   void *pvt)
+{
+    /* sss_ptr_hash removes the entry from the table */
+    talloc_free(pvt);
+}
+
+/* Returns EOK and the cached result if a valid decision is available */
+static errno_t
+ad_gpo_decision_cache_lookup(struct ad_gpo_access_state *state,
+                             errno_t *_result)
+{
+    struct ad_gpo_decision *decision;
+    int version;
+    int i;
+    errno_t ret;
+
+    if (state->access_ctx->gpo_decision_cache == NULL
+            || state->decision_key == NULL) {
+        return ENOENT;
+    }
+
+    decision = sss_ptr_hash_lookup(state->access_ctx->gpo_decision_cache,
+                                   state->decision_key,
+                                   struct ad_gpo_decision);
+    if (decision == NULL) {
+        return ENOENT;
+    }
+
+    if (strcmp(decision->sids, state->decision_sids) != 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Group memberships of %s changed\n",
+              state->user);
+        talloc_free(decision);
+        return ENOENT;
+    }
+
+    for (i = 0; i < decision->num_gpos; i++) {
+        ret = ad_gpo_cached_gpo_version(state->host_domain,
+                                        decision->gpo_guids[i], &version);
+        if (ret != EOK || version != decision->gpo_versions[i]) {
+            DEBUG(SSSDBG_TRACE_FUNC, "GPO %s was updated\n",
+                  decision->gpo_guids[i]);
+            talloc_free(decision);
+            return ENOENT;
+        }
+    }
+
+    *_result = decision->result;
+    return EOK;
+}
+
+static void
+ad_gpo_decision_cache_store(struct ad_gpo_access_state *state,
+                            errno_t result)
+{
+    struct ad_access_ctx *ctx = state->access_ctx;
+    struct ad_gpo_decision *decision;
+    struct tevent_timer *te;
+    int i;
+    errno_t ret;
+
+    if (state->decision_key == NULL
+            || (result != EOK && result != ERR_ACCESS_DENIED)) {
+        return;
+    }
+
+    if (ctx->gpo_decision_cache == NULL) {
+        ctx->gpo_decision_cache = sss_ptr_hash_create(ctx, NULL, NULL);
+        if (ctx->gpo_decision_cache == NULL) {
+            return;
+        }
+    }
+
+    decision = sss_ptr_hash_lookup(ctx->gpo_decision_cache,
+                                   state->decision_key,
+                                   struct ad_gpo_decision);
+    talloc_free(decision);
+
+    decision = talloc_zero(ctx->gpo_decision_cache, struct ad_gpo_decision);
+    if (decision == NULL) {
+        return;
+    }
+
+    decision->result = result;
+    decision->sids = talloc_steal(decision, state->decision_sids);
+    state->decision_sids = NULL;
+
+    decision->num_gpos = state->num_cse_filtered_gpos;
+    decision->gpo_guids = talloc_zero_array(decision, const char *,
+                                            decision->num_gpos + 1);
+    decision->gpo_versions = talloc_zero_array(decision, int,
+                                               decision->num_gpos + 1);
+    if (decision->gpo_guids == NULL || decision->gpo_versions == NULL) {
+        goto fail;
+    }
+
+    for (i = 0; i < decision->num_gpos; i++) {
+        decision->gpo_guids[i] = talloc_strdup(decision->gpo_guids,
+                                         state->cse_filtered_gpos[i]->gpo_guid);
+        if (decision->gpo_guids[i] == NULL) {
+            goto fail;
+        }
+
+        ret = ad_gpo_cached_gpo_version(state->host_domain,
+                                        decision->gpo_guids[i],
+                                        &decision->gpo_versions[i]);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
+    te = tevent_add_timer(state->ev, decision,
+                          tevent_timeval_current_ofs(state->gpo_timeout_option,
+                                                     0),
+                          ad_gpo_decision_expire, decision);
+    if (te == NULL) {
+        goto fail;
+    }
+
+    ret = sss_ptr_hash_add(ctx->gpo_decision_cache, state->decision_key,
+                           decision, struct ad_gpo_decision);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "GPO decision for %s is cached for %d "
+          "seconds\n", state->user, state->gpo_timeout_option);
+    return;
+
+fail:
+    talloc_free(decision);
+}
+
 struct tevent_req *
 ad_gpo_access_send(TALLOC_CTX *mem_ctx,
                    struct tevent_context *ev,
@@ -1884,6 +2118,23 @@ ad_gpo_access_send(TALLOC_CTX *mem_ctx,
     state->access_ctx = ctx;
     state->opts = ctx->sdap_access_ctx->id_ctx->opts;
     state->timeout = dp_opt_get_int(state->opts->basic, SDAP_SEARCH_TIMEOUT);
+
+    if (state->gpo_timeout_option > 0) {
+        ret = ad_gpo_decision_sids(state, user, domain, &state->decision_sids);
+        if (ret == EOK) {
+            state->decision_key = talloc_asprintf(state, "%d:%s:%s",
+                                                  gpo_map_type, domain->name,
+                                                  user);
+        }
+
+        if (state->decision_key != NULL
+                && ad_gpo_decision_cache_lookup(state, &ret) == EOK) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Using cached GPO decision for %s: "
+                  "[%d](%s)\n", user, ret, sss_strerror(ret));
+            goto immediately;
+        }
+    }
+
     state->conn = ad_get_dom_ldap_conn(ctx->ad_id_ctx, state->host_domain);
     state->sdap_op = sdap_id_op_create(state, state->conn->conn_cache);
     if (state->sdap_op == NULL) {
@@ -2591,6 +2842,10 @@ ad_gpo_process_gpo_done(struct tevent_req *subreq)
 
  done:
 
+    if (ret != EAGAIN) {
+        ad_gpo_decision_cache_store(state, ret);
+    }
+
     if (ret == EOK) {
         tevent_req_done(req);
     } else if (ret != EAGAIN) {
@@ -2685,6 +2940,7 @@ ad_gpo_cse_step(struct tevent_req *req)
 
     subreq = ad_gpo_process_cse_send(state,
                                      state->ev,
+                                     state->access_ctx,
                                      send_to_child,
                                      state->host_domain,
                                      cse_filtered_gpo->gpo_guid,
@@ -2769,6 +3025,10 @@ ad_gpo_cse_done(struct tevent_req *subreq)
 
  done:
 
+    if (ret != EAGAIN) {
+        ad_gpo_decision_cache_store(state, ret);
+    }
+
     if (ret == EOK) {
         tevent_req_done(req);
     } else if (ret != EAGAIN) {
@@ -3085,12 +3345,25 @@ struct ad_gpo_process_som_state {
     struct gp_som **som_list;
     int som_index;
     int num_soms;
+
+    /* SOM attributes are searched in parallel, in the order of som_list */
+    TALLOC_CTX *search_ctx;
+    struct sysdb_attrs **som_attrs;
+    int num_searches;
+    int num_pending;
+};
+
+/* callback data of a single SOM or GPO search */
+struct ad_gpo_search {
+    struct tevent_req *req;
+    int index;
 };
 
 static void ad_gpo_site_name_retrieval_done(struct tevent_req *subreq);
 static void ad_gpo_site_dn_retrieval_done(struct tevent_req *subreq);
 static errno_t ad_gpo_get_som_attrs_step(struct tevent_req *req);
 static void ad_gpo_get_som_attrs_done(struct tevent_req *subreq);
+static errno_t ad_gpo_process_som_attrs(struct tevent_req *req);
 
 /*
  * This function uses the input target_dn and input domain_name to populate
@@ -3346,57 +3619,85 @@ ad_gpo_site_dn_retrieval_done(struct tevent_req *subreq)
     }
 
 }
+/*
+ * Keeps up to GPO_MAX_PARALLEL_SEARCHES searches for SOM attributes running.
+ * Once all of them have finished, the results are processed in the order of
+ * the som_list, since a SOM that blocks inheritance affects the processing
+ * of its parents.
+ */
 static errno_t
 ad_gpo_get_som_attrs_step(struct tevent_req *req)
 {
     const char *attrs[] = {AD_AT_GPLINK, AD_AT_GPOPTIONS, NULL};
     struct tevent_req *subreq;
     struct ad_gpo_process_som_state *state;
+    struct ad_gpo_search *search;
+    const char *som_dn;
 
     state = tevent_req_data(req, struct ad_gpo_process_som_state);
 
-    struct gp_som *gp_som = state->som_list[state->som_index];
+    if (state->search_ctx == NULL) {
+        state->search_ctx = talloc_new(state);
+        state->som_attrs = talloc_zero_array(state, struct sysdb_attrs *,
+                                             state->num_soms);
+        if (state->search_ctx == NULL || state->som_attrs == NULL) {
+            return ENOMEM;
+        }
+    }
 
-    /* gp_som is NULL only after all SOMs have been processed */
-    if (gp_som == NULL) return EOK;
+    while (state->num_pending < GPO_MAX_PARALLEL_SEARCHES
+            && state->num_searches < state->num_soms) {
+        search = talloc_zero(state->search_ctx, struct ad_gpo_search);
+        if (search == NULL) {
+            return ENOMEM;
+        }
+        search->req = req;
+        search->index = state->num_searches;
 
-    const char *som_dn = gp_som->som_dn;
-    subreq = sdap_get_generic_send(state, state->ev,  state->opts,
-                                   sdap_id_op_handle(state->sdap_op),
-                                   som_dn, LDAP_SCOPE_BASE,
-                                   "(objectclass=*)", attrs, NULL, 0,
-                                   state->timeout,
-                                   false);
+        som_dn = state->som_list[search->index]->som_dn;
+        subreq = sdap_get_generic_send(search, state->ev,  state->opts,
+                                       sdap_id_op_handle(state->sdap_op),
+                                       som_dn, LDAP_SCOPE_BASE,
+                                       "(objectclass=*)", attrs, NULL, 0,
+                                       state->timeout,
+                                       false);
 
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send failed.\n");
-        return ENOMEM;
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send failed.\n");
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, ad_gpo_get_som_attrs_done, search);
+        state->num_searches++;
+        state->num_pending++;
     }
 
-    tevent_req_set_callback(subreq, ad_gpo_get_som_attrs_done, req);
-    return EAGAIN;
+    if (state->num_pending > 0) {
+        return EAGAIN;
+    }
+
+    talloc_zfree(state->search_ctx);
+    return ad_gpo_process_som_attrs(req);
 }
 
 static void
 ad_gpo_get_som_attrs_done(struct tevent_req *subreq)
 {
+    struct ad_gpo_search *search;
     struct tevent_req *req;
     struct ad_gpo_process_som_state *state;
     int ret;
     int dp_error;
     size_t num_results;
     struct sysdb_attrs **results;
-    struct ldb_message_element *el = NULL;
-    uint8_t *raw_gplink_value;
-    uint8_t *raw_gpoptions_value;
-    uint32_t allow_enforced_only = 0;
-    struct gp_som *gp_som;
 
-    req = tevent_req_callback_data(subreq, struct tevent_req);
+    search = tevent_req_callback_data(subreq, struct ad_gpo_search);
+    req = search->req;
     state = tevent_req_data(req, struct ad_gpo_process_som_state);
     ret = sdap_get_generic_recv(subreq, state,
                                 &num_results, &results);
     talloc_zfree(subreq);
+    state->num_pending--;
 
     if (ret != EOK) {
         ret = sdap_id_op_done(state->sdap_op, ret, &dp_error);
@@ -3409,83 +3710,109 @@ ad_gpo_get_som_attrs_done(struct tevent_req *subreq)
     }
     if ((num_results < 1) || (results == NULL)) {
         DEBUG(SSSDBG_OP_FAILURE, "no attrs found for SOM; try next SOM.\n");
-        state->som_index++;
-        ret = ad_gpo_get_som_attrs_step(req);
-        goto done;
     } else if (num_results > 1) {
         DEBUG(SSSDBG_OP_FAILURE, "Received multiple replies\n");
         ret = ERR_INTERNAL;
         goto done;
+    } else {
+        state->som_attrs[search->index] = results[0];
     }
 
-    /* Get the gplink value, if available */
-    ret = sysdb_attrs_get_el(results[0], AD_AT_GPLINK, &el);
+    talloc_free(search);
+    ret = ad_gpo_get_som_attrs_step(req);
 
-    if (ret != EOK && ret != ENOENT) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "sysdb_attrs_get_el() failed: [%d](%s)\n",
-              ret, sss_strerror(ret));
-        goto done;
-    }
+ done:
 
-    if ((ret == ENOENT) || (el->num_values == 0)) {
-        DEBUG(SSSDBG_OP_FAILURE, "no attrs found for SOM; try next SOM\n");
-        state->som_index++;
-        ret = ad_gpo_get_som_attrs_step(req);
-        goto done;
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        /* cancel the remaining searches */
+        talloc_zfree(state->search_ctx);
+        tevent_req_error(req, ret);
     }
+}
 
-    raw_gplink_value = el[0].values[0].data;
+static errno_t
+ad_gpo_process_som_attrs(struct tevent_req *req)
+{
+    struct ad_gpo_process_som_state *state;
+    int ret;
+    struct ldb_message_element *el = NULL;
+    uint8_t *raw_gplink_value;
+    uint8_t *raw_gpoptions_value;
+    uint32_t allow_enforced_only = 0;
+    struct gp_som *gp_som;
+    struct sysdb_attrs *attrs;
 
-    ret = sysdb_attrs_get_el(results[0], AD_AT_GPOPTIONS, &el);
+    state = tevent_req_data(req, struct ad_gpo_process_som_state);
 
-    if (ret != EOK && ret != ENOENT) {
-        DEBUG(SSSDBG_OP_FAILURE, "sysdb_attrs_get_el() failed\n");
-        goto done;
-    }
+    for (state->som_index = 0;
+         state->som_list[state->som_index] != NULL;
+         state->som_index++) {
+        gp_som = state->som_list[state->som_index];
+        attrs = state->som_attrs[state->som_index];
+        if (attrs == NULL) {
+            continue;
+        }
 
-    if ((ret == ENOENT) || (el->num_values == 0)) {
-        DEBUG(SSSDBG_TRACE_ALL,
-              "gpoptions attr not found or has no value; defaults to 0\n");
-        allow_enforced_only = 0;
-    }  else {
-        raw_gpoptions_value = el[0].values[0].data;
-        allow_enforced_only = strtouint32((char *)raw_gpoptions_value, NULL, 10);
-        if (errno != 0) {
-            ret = errno;
+        /* Get the gplink value, if available */
+        ret = sysdb_attrs_get_el(attrs, AD_AT_GPLINK, &el);
+
+        if (ret != EOK && ret != ENOENT) {
             DEBUG(SSSDBG_OP_FAILURE,
-                  "strtouint32 failed: [%d](%s)\n", ret, sss_strerror(ret));
-            goto done;
+                  "sysdb_attrs_get_el() failed: [%d](%s)\n",
+                  ret, sss_strerror(ret));
+            return ret;
         }
-    }
 
-    gp_som = state->som_list[state->som_index];
-    ret = ad_gpo_populate_gplink_list(gp_som,
-                                      gp_som->som_dn,
-                                      (char *)raw_gplink_value,
-                                      &gp_som->gplink_list,
-                                      state->allow_enforced_only);
+        if ((ret == ENOENT) || (el->num_values == 0)) {
+            DEBUG(SSSDBG_OP_FAILURE, "no attrs found for SOM; try next SOM\n");
+            continue;
+        }
 
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "ad_gpo_populate_gplink_list() failed\n");
-        goto done;
-    }
+        raw_gplink_value = el[0].values[0].data;
 
-    if (allow_enforced_only) {
-        state->allow_enforced_only = 1;
-    }
+        ret = sysdb_attrs_get_el(attrs, AD_AT_GPOPTIONS, &el);
 
-    state->som_index++;
-    ret = ad_gpo_get_som_attrs_step(req);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_attrs_get_el() failed\n");
+            return ret;
+        }
 
- done:
+        if ((ret == ENOENT) || (el->num_values == 0)) {
+            DEBUG(SSSDBG_TRACE_ALL,
+                  "gpoptions attr not found or has no value; defaults to 0\n");
+            allow_enforced_only = 0;
+        }  else {
+            raw_gpoptions_value = el[0].values[0].data;
+            allow_enforced_only = strtouint32((char *)raw_gpoptions_value,
+                                              NULL, 10);
+            if (errno != 0) {
+                ret = errno;
+                DEBUG(SSSDBG_OP_FAILURE,
+                      "strtouint32 failed: [%d](%s)\n", ret, sss_strerror(ret));
+                return ret;
+            }
+        }
 
-    if (ret == EOK) {
-        tevent_req_done(req);
-    } else if (ret != EAGAIN) {
-        tevent_req_error(req, ret);
+        ret = ad_gpo_populate_gplink_list(gp_som,
+                                          gp_som->som_dn,
+                                          (char *)raw_gplink_value,
+                                          &gp_som->gplink_list,
+                                          state->allow_enforced_only);
+
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "ad_gpo_populate_gplink_list() failed\n");
+            return ret;
+        }
+
+        if (allow_enforced_only) {
+            state->allow_enforced_only = 1;
+        }
     }
+
+    return EOK;
 }
 
 int
@@ -3970,10 +4297,19 @@ struct ad_gpo_process_gpo_state {
     struct gp_gpo **candidate_gpos;
     int num_candidate_gpos;
     int gpo_index;
+
+    /* GPO objects are searched in parallel, then processed in order. Each
+     * search yields either the attributes or a single referral. */
+    TALLOC_CTX *search_ctx;
+    struct sysdb_attrs **gpo_attrs;
+    char **gpo_refs;
+    int num_searches;
+    int num_pending;
 };
 
+static errno_t ad_gpo_search_gpo_attrs(struct tevent_req *req);
+static void ad_gpo_search_gpo_attrs_done(struct tevent_req *subreq);
 static errno_t ad_gpo_get_gpo_attrs_step(struct tevent_req *req);
-static void ad_gpo_get_gpo_attrs_done(struct tevent_req *subreq);
 
 /*
  * This function uses the input som_list to populate a prioritized list of
@@ -4035,7 +4371,18 @@ ad_gpo_process_gpo_send(TALLOC_CTX *mem_ctx,
         goto immediately;
     }
 
-    ret = ad_gpo_get_gpo_attrs_step(req);
+    state->search_ctx = talloc_new(state);
+    state->gpo_attrs = talloc_zero_array(state, struct sysdb_attrs *,
+                                         state->num_candidate_gpos);
+    state->gpo_refs = talloc_zero_array(state, char *,
+                                        state->num_candidate_gpos);
+    if (state->search_ctx == NULL || state->gpo_attrs == NULL
+            || state->gpo_refs == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    ret = ad_gpo_search_gpo_attrs(req);
 
 immediately:
 
@@ -4051,40 +4398,11 @@ immediately:
 }
 
 static errno_t
-ad_gpo_get_gpo_attrs_step(struct tevent_req *req)
-{
-    const char *attrs[] = AD_GPO_ATTRS;
-    struct tevent_req *subreq;
-    struct ad_gpo_process_gpo_state *state;
-
-    state = tevent_req_data(req, struct ad_gpo_process_gpo_state);
-
-    struct gp_gpo *gp_gpo = state->candidate_gpos[state->gpo_index];
-
-    /* gp_gpo is NULL only after all GPOs have been processed */
-    if (gp_gpo == NULL) return EOK;
-
-    const char *gpo_dn = gp_gpo->gpo_dn;
-
-    subreq = sdap_sd_search_send(state, state->ev,
-                                 state->opts, sdap_id_op_handle(state->sdap_op),
-                                 gpo_dn, SECINFO_DACL, attrs, state->timeout);
-
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_sd_search_send failed.\n");
-        return ENOMEM;
-    }
-
-    tevent_req_set_callback(subreq, ad_gpo_get_gpo_attrs_done, req);
-    return EAGAIN;
-}
-
-static errno_t
-ad_gpo_sd_process_attrs(struct tevent_req *req,
-                        char *smb_host,
-                        struct sysdb_attrs *result);
-void
-ad_gpo_get_sd_referral_done(struct tevent_req *subreq);
+ad_gpo_sd_process_attrs(struct tevent_req *req,
+                        char *smb_host,
+                        struct sysdb_attrs *result);
+void
+ad_gpo_get_sd_referral_done(struct tevent_req *subreq);
 
 static struct tevent_req *
 ad_gpo_get_sd_referral_send(TALLOC_CTX *mem_ctx,
@@ -4100,9 +4418,60 @@ ad_gpo_get_sd_referral_recv(struct tevent_req *req,
                             char **_smb_host,
                             struct sysdb_attrs **_reply);
 
+/*
+ * Keeps up to GPO_MAX_PARALLEL_SEARCHES searches for GPO objects running.
+ * Once all of them have finished, the GPOs are processed one after another
+ * by ad_gpo_get_gpo_attrs_step().
+ */
+static errno_t
+ad_gpo_search_gpo_attrs(struct tevent_req *req)
+{
+    const char *attrs[] = AD_GPO_ATTRS;
+    struct tevent_req *subreq;
+    struct ad_gpo_process_gpo_state *state;
+    struct ad_gpo_search *search;
+    const char *gpo_dn;
+
+    state = tevent_req_data(req, struct ad_gpo_process_gpo_state);
+
+    while (state->num_pending < GPO_MAX_PARALLEL_SEARCHES
+            && state->num_searches < state->num_candidate_gpos) {
+        search = talloc_zero(state->search_ctx, struct ad_gpo_search);
+        if (search == NULL) {
+            return ENOMEM;
+        }
+        search->req = req;
+        search->index = state->num_searches;
+
+        gpo_dn = state->candidate_gpos[search->index]->gpo_dn;
+        subreq = sdap_sd_search_send(search, state->ev,
+                                     state->opts,
+                                     sdap_id_op_handle(state->sdap_op),
+                                     gpo_dn, SECINFO_DACL, attrs,
+                                     state->timeout);
+
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "sdap_sd_search_send failed.\n");
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, ad_gpo_search_gpo_attrs_done, search);
+        state->num_searches++;
+        state->num_pending++;
+    }
+
+    if (state->num_pending > 0) {
+        return EAGAIN;
+    }
+
+    talloc_zfree(state->search_ctx);
+    return ad_gpo_get_gpo_attrs_step(req);
+}
+
 static void
-ad_gpo_get_gpo_attrs_done(struct tevent_req *subreq)
+ad_gpo_search_gpo_attrs_done(struct tevent_req *subreq)
 {
+    struct ad_gpo_search *search;
     struct tevent_req *req;
     struct ad_gpo_process_gpo_state *state;
     int ret;
@@ -4111,13 +4480,15 @@ ad_gpo_get_gpo_attrs_done(struct tevent_req *subreq)
     struct sysdb_attrs **results;
     char **refs;
 
-    req = tevent_req_callback_data(subreq, struct tevent_req);
+    search = tevent_req_callback_data(subreq, struct ad_gpo_search);
+    req = search->req;
     state = tevent_req_data(req, struct ad_gpo_process_gpo_state);
 
     ret = sdap_sd_search_recv(subreq, state,
                               &num_results, &results,
                               &refcount, &refs);
     talloc_zfree(subreq);
+    state->num_pending--;
 
     if (ret != EOK) {
         ret = sdap_id_op_done(state->sdap_op, ret, &dp_error);
@@ -4131,28 +4502,13 @@ ad_gpo_get_gpo_attrs_done(struct tevent_req *subreq)
 
     if ((num_results < 1) || (results == NULL)) {
         if (refcount == 1) {
-            /* If we were redirected to a referral, process it.
+            /* If we were redirected to a referral, it is processed later.
              * There must be a single referral result here; if we get
              * more than one (or zero) it's a bug.
              */
-
-            subreq = ad_gpo_get_sd_referral_send(state, state->ev,
-                                                 state->access_ctx,
-                                                 state->opts,
-                                                 refs[0],
-                                                 state->host_domain,
-                                                 state->timeout);
-            if (!subreq) {
-                ret = ENOMEM;
-                goto done;
-            }
-
-            tevent_req_set_callback(subreq, ad_gpo_get_sd_referral_done, req);
-            ret = EAGAIN;
-            goto done;
-
+            state->gpo_refs[search->index] = talloc_steal(state, refs[0]);
         } else {
-            const char *gpo_dn = state->candidate_gpos[state->gpo_index]->gpo_dn;
+            const char *gpo_dn = state->candidate_gpos[search->index]->gpo_dn;
 
             DEBUG(SSSDBG_OP_FAILURE,
                   "No attrs found for GPO [%s].\n", gpo_dn);
@@ -4163,19 +4519,56 @@ ad_gpo_get_gpo_attrs_done(struct tevent_req *subreq)
         DEBUG(SSSDBG_OP_FAILURE, "Received multiple replies\n");
         ret = ERR_INTERNAL;
         goto done;
+    } else {
+        state->gpo_attrs[search->index] = results[0];
     }
 
-    ret = ad_gpo_sd_process_attrs(req, state->server_hostname, results[0]);
+    talloc_free(search);
+    ret = ad_gpo_search_gpo_attrs(req);
 
 done:
 
    if (ret == EOK) {
        tevent_req_done(req);
    } else if (ret != EAGAIN) {
+       /* cancel the remaining searches */
+       talloc_zfree(state->search_ctx);
        tevent_req_error(req, ret);
    }
 }
 
+static errno_t
+ad_gpo_get_gpo_attrs_step(struct tevent_req *req)
+{
+    struct tevent_req *subreq;
+    struct ad_gpo_process_gpo_state *state;
+
+    state = tevent_req_data(req, struct ad_gpo_process_gpo_state);
+
+    struct gp_gpo *gp_gpo = state->candidate_gpos[state->gpo_index];
+
+    /* gp_gpo is NULL only after all GPOs have been processed */
+    if (gp_gpo == NULL) return EOK;
+
+    if (state->gpo_attrs[state->gpo_index] != NULL) {
+        return ad_gpo_sd_process_attrs(req, state->server_hostname,
+                                       state->gpo_attrs[state->gpo_index]);
+    }
+
+    subreq = ad_gpo_get_sd_referral_send(state, state->ev,
+                                         state->access_ctx,
+                                         state->opts,
+                                         state->gpo_refs[state->gpo_index],
+                                         state->host_domain,
+                                         state->timeout);
+    if (subreq == NULL) {
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(subreq, ad_gpo_get_sd_referral_done, req);
+    return EAGAIN;
+}
+
 void
 ad_gpo_get_sd_referral_done(struct tevent_req *subreq)
 {
@@ -4551,25 +4944,357 @@ ad_gpo_parse_gpo_child_response(uint8_t *buf,
     return ret;
 }
 
+/* == persistent gpo_child ================================================= */
+
+/*
+ * Instead of forking a new gpo_child for every policy file, a single child
+ * is started with --persistent and serves one request after another, so
+ * that its SMB connection to the domain controller is reused. Requests are
+ * serialized by a tevent queue. The child is stopped when it was idle for
+ * GPO_CHILD_IDLE_TIMEOUT seconds, when the Kerberos ccache it was started
+ * with changes, or when a request was not answered properly; it is started
+ * again by the next request.
+ */
+struct ad_gpo_child {
+    struct tevent_context *ev;
+    struct tevent_queue *queue;
+
+    pid_t pid;
+    struct sss_child_ctx_old *child_ctx;
+    struct child_io_fds *io;
+    char *ccname;
+    struct tevent_timer *idle_timer;
+};
+
+static void ad_gpo_child_stop(struct ad_gpo_child *child)
+{
+    talloc_zfree(child->idle_timer);
+
+    if (child->child_ctx != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Stopping gpo_child [%d]\n", child->pid);
+        child_handler_destroy(child->child_ctx);
+        child->child_ctx = NULL;
+    }
+
+    talloc_zfree(child->io);
+    talloc_zfree(child->ccname);
+    child->pid = 0;
+}
+
+static int ad_gpo_child_destructor(struct ad_gpo_child *child)
+{
+    ad_gpo_child_stop(child);
+    return 0;
+}
+
+static void ad_gpo_child_exited(int child_status,
+                                struct tevent_signal *sige,
+                                void *pvt)
+{
+    struct ad_gpo_child *child;
+
+    child = talloc_get_type(pvt, struct ad_gpo_child);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "gpo_child [%d] exited with status [%d]\n",
+          child->pid, child_status);
+
+    /* The signal handler context is freed by the caller. */
+    child->child_ctx = NULL;
+    ad_gpo_child_stop(child);
+}
+
+static void ad_gpo_child_idle_handler(struct tevent_context *ev,
+                                      struct tevent_timer *te,
+                                      struct timeval tv,
+                                      void *pvt)
+{
+    struct ad_gpo_child *child;
+
+    child = talloc_get_type(pvt, struct ad_gpo_child);
+    child->idle_timer = NULL;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "gpo_child is idle\n");
+    ad_gpo_child_stop(child);
+}
+
+static void ad_gpo_child_set_idle(struct ad_gpo_child *child)
+{
+    struct timeval tv;
+
+    talloc_zfree(child->idle_timer);
+    if (child->io == NULL) {
+        return;
+    }
+
+    tv = tevent_timeval_current_ofs(GPO_CHILD_IDLE_TIMEOUT, 0);
+    child->idle_timer = tevent_add_timer(child->ev, child, tv,
+                                         ad_gpo_child_idle_handler, child);
+    if (child->idle_timer == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to set up idle timer, "
+              "stopping gpo_child\n");
+        ad_gpo_child_stop(child);
+    }
+}
+
+static struct ad_gpo_child *
+ad_gpo_child_get(struct ad_access_ctx *access_ctx,
+                 struct tevent_context *ev)
+{
+    struct ad_gpo_child *child;
+
+    if (access_ctx->gpo_child != NULL) {
+        return access_ctx->gpo_child;
+    }
+
+    child = talloc_zero(access_ctx, struct ad_gpo_child);
+    if (child == NULL) {
+        return NULL;
+    }
+
+    child->ev = ev;
+    child->queue = tevent_queue_create(child, "gpo_child");
+    if (child->queue == NULL) {
+        talloc_free(child);
+        return NULL;
+    }
+
+    talloc_set_destructor(child, ad_gpo_child_destructor);
+    access_ctx->gpo_child = child;
+
+    return child;
+}
+
+static errno_t ad_gpo_child_start(struct ad_gpo_child *child)
+{
+    int pipefd_to_child[2] = PIPE_INIT;
+    int pipefd_from_child[2] = PIPE_INIT;
+    const char *extra_argv[] = { "--persistent", NULL };
+    const char *ccname;
+    pid_t pid;
+    errno_t ret;
+
+    child->io = talloc(child, struct child_io_fds);
+    if (child->io == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc failed.\n");
+        return ENOMEM;
+    }
+
+    child->io->write_to_child_fd = -1;
+    child->io->read_from_child_fd = -1;
+    talloc_set_destructor((void *) child->io, child_io_destructor);
+
+    ccname = getenv("KRB5CCNAME");
+    if (ccname != NULL) {
+        child->ccname = talloc_strdup(child, ccname);
+        if (child->ccname == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+    }
+
+    ret = pipe(pipefd_from_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", errno, strerror(errno));
+        goto fail;
+    }
+    ret = pipe(pipefd_to_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", errno, strerror(errno));
+        goto fail;
+    }
+
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child,
+                          GPO_CHILD, GPO_CHILD_LOG_FILE, extra_argv, false,
+                          STDIN_FILENO, AD_GPO_CHILD_OUT_FILENO, &pid);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    child->pid = pid;
+    child->io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    child->io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(child->io->read_from_child_fd);
+    sss_fd_nonblocking(child->io->write_to_child_fd);
+
+    ret = child_handler_setup(child->ev, pid, ad_gpo_child_exited, child,
+                              &child->child_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Could not set up child signal handler\n");
+        kill(pid, SIGKILL);
+        ad_gpo_child_stop(child);
+        return ret;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Started gpo_child [%d]\n", pid);
+
+    return EOK;
+
+fail:
+    PIPE_CLOSE(pipefd_from_child);
+    PIPE_CLOSE(pipefd_to_child);
+    ad_gpo_child_stop(child);
+    return ret;
+}
+
+/* Reads exactly size bytes of a gpo_child response. */
+struct ad_gpo_child_read_state {
+    int fd;
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+};
+
+static void ad_gpo_child_read_handler(struct tevent_context *ev,
+                                      struct tevent_fd *fde,
+                                      uint16_t flags, void *pvt);
+
+static struct tevent_req *
+ad_gpo_child_read_send(TALLOC_CTX *mem_ctx,
+                       struct tevent_context *ev,
+                       int fd,
+                       size_t size)
+{
+    struct tevent_req *req;
+    struct ad_gpo_child_read_state *state;
+    struct tevent_fd *fde;
+
+    req = tevent_req_create(mem_ctx, &state, struct ad_gpo_child_read_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->fd = fd;
+    state->size = size;
+    state->len = 0;
+    state->buf = talloc_array(state, uint8_t, size);
+    if (state->buf == NULL) {
+        goto fail;
+    }
+
+    fde = tevent_add_fd(ev, state, fd, TEVENT_FD_READ,
+                        ad_gpo_child_read_handler, req);
+    if (fde == NULL) {
+        goto fail;
+    }
+
+    return req;
+
+fail:
+    talloc_free(req);
+    return NULL;
+}
+
+static void ad_gpo_child_read_handler(struct tevent_context *ev,
+                                      struct tevent_fd *fde,
+                                      uint16_t flags, void *pvt)
+{
+    struct tevent_req *req;
+    struct ad_gpo_child_read_state *state;
+    ssize_t size;
+    errno_t ret;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct ad_gpo_child_read_state);
+
+    if (flags & TEVENT_FD_WRITE) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ad_gpo_child_read_handler called with "
+              "TEVENT_FD_WRITE, this should not happen.\n");
+        tevent_req_error(req, EINVAL);
+        return;
+    }
+
+    errno = 0;
+    size = read(state->fd, state->buf + state->len, state->size - state->len);
+    if (size == -1) {
+        ret = errno;
+        if (ret == EAGAIN || ret == EINTR) {
+            return;
+        }
+
+        DEBUG(SSSDBG_CRIT_FAILURE, "read failed [%d][%s].\n",
+              ret, strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    } else if (size == 0) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "gpo_child closed the pipe\n");
+        tevent_req_error(req, EPIPE);
+        return;
+    }
+
+    state->len += size;
+    if (state->len == state->size) {
+        tevent_req_done(req);
+    }
+}
+
+static errno_t ad_gpo_child_read_recv(struct tevent_req *req,
+                                      TALLOC_CTX *mem_ctx,
+                                      uint8_t **_buf,
+                                      ssize_t *_len)
+{
+    struct ad_gpo_child_read_state *state;
+
+    state = tevent_req_data(req, struct ad_gpo_child_read_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_buf = talloc_steal(mem_ctx, state->buf);
+    *_len = state->len;
+
+    return EOK;
+}
+
 /* == ad_gpo_process_cse_send/recv implementation ========================== */
 
 struct ad_gpo_process_cse_state {
     struct tevent_context *ev;
+    struct ad_gpo_child *child;
     struct sss_domain_info *domain;
     int gpo_timeout_option;
     const char *gpo_guid;
     const char *smb_path;
     const char *smb_cse_suffix;
-    pid_t child_pid;
+    struct io_buffer *send_buf;
+    bool in_progress;
     uint8_t *buf;
     ssize_t len;
-    struct child_io_fds *io;
 };
 
-static errno_t gpo_fork_child(struct tevent_req *req);
+static void ad_gpo_process_cse_trigger(struct tevent_req *req, void *pvt);
 static void gpo_cse_step(struct tevent_req *subreq);
 static void gpo_cse_done(struct tevent_req *subreq);
 
+static int ad_gpo_process_cse_state_destructor(
+                                        struct ad_gpo_process_cse_state *state)
+{
+    if (state->in_progress) {
+        /* The response of the child would be read by the next request. */
+        DEBUG(SSSDBG_TRACE_FUNC, "Request was cancelled, stopping gpo_child\n");
+        ad_gpo_child_stop(state->child);
+    }
+
+    return 0;
+}
+
+static void ad_gpo_process_cse_finish(struct ad_gpo_process_cse_state *state,
+                                      errno_t ret)
+{
+    state->in_progress = false;
+
+    if (ret == EOK) {
+        ad_gpo_child_set_idle(state->child);
+    } else {
+        ad_gpo_child_stop(state->child);
+    }
+}
+
 /*
  * This cse-specific function (GP_EXT_GUID_SECURITY) sends the input smb uri
  * components and cached_gpt_version to the gpo child, which, in turn,
@@ -4580,6 +5305,7 @@ static void gpo_cse_done(struct tevent_req *subreq);
 struct tevent_req *
 ad_gpo_process_cse_send(TALLOC_CTX *mem_ctx,
                         struct tevent_context *ev,
+                        struct ad_access_ctx *access_ctx,
                         bool send_to_child,
                         struct sss_domain_info *domain,
                         const char *gpo_guid,
@@ -4591,9 +5317,7 @@ ad_gpo_process_cse_send(TALLOC_CTX *mem_ctx,
                         int gpo_timeout_option)
 {
     struct tevent_req *req;
-    struct tevent_req *subreq;
     struct ad_gpo_process_cse_state *state;
-    struct io_buffer *buf = NULL;
     errno_t ret;
 
     req = tevent_req_create(mem_ctx, &state, struct ad_gpo_process_cse_state);
@@ -4619,38 +5343,29 @@ ad_gpo_process_cse_send(TALLOC_CTX *mem_ctx,
     state->gpo_guid = gpo_guid;
     state->smb_path = smb_path;
     state->smb_cse_suffix = smb_cse_suffix;
-    state->io = talloc(state, struct child_io_fds);
-    if (state->io == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "talloc failed.\n");
+
+    state->child = ad_gpo_child_get(access_ctx, ev);
+    if (state->child == NULL) {
         ret = ENOMEM;
         goto immediately;
     }
 
-    state->io->write_to_child_fd = -1;
-    state->io->read_from_child_fd = -1;
-    talloc_set_destructor((void *) state->io, child_io_destructor);
-
     /* prepare the data to pass to child */
     ret = create_cse_send_buffer(state, smb_server, smb_share, smb_path,
-                                 smb_cse_suffix, cached_gpt_version, &buf);
+                                 smb_cse_suffix, cached_gpt_version,
+                                 &state->send_buf);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "create_cse_send_buffer failed.\n");
         goto immediately;
     }
 
-    ret = gpo_fork_child(req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "gpo_fork_child failed.\n");
-        goto immediately;
-    }
+    talloc_set_destructor(state, ad_gpo_process_cse_state_destructor);
 
-    subreq = write_pipe_send(state, ev, buf->data, buf->size,
-                             state->io->write_to_child_fd);
-    if (subreq == NULL) {
+    if (tevent_queue_add(state->child->queue, ev, req,
+                         ad_gpo_process_cse_trigger, NULL) == false) {
         ret = ENOMEM;
         goto immediately;
     }
-    tevent_req_set_callback(subreq, gpo_cse_step, req);
 
     return req;
 
@@ -4667,6 +5382,63 @@ immediately:
     return req;
 }
 
+static void ad_gpo_process_cse_trigger(struct tevent_req *req, void *pvt)
+{
+    struct ad_gpo_process_cse_state *state;
+    struct ad_gpo_child *child;
+    struct tevent_req *subreq;
+    const char *ccname;
+    uint8_t *frame;
+    size_t frame_len;
+    size_t p = 0;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct ad_gpo_process_cse_state);
+    child = state->child;
+
+    talloc_zfree(child->idle_timer);
+
+    ccname = getenv("KRB5CCNAME");
+    if (child->io != NULL && (ccname == NULL) != (child->ccname == NULL)) {
+        ad_gpo_child_stop(child);
+    } else if (child->io != NULL && ccname != NULL
+                   && strcmp(ccname, child->ccname) != 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Kerberos ccache changed, "
+              "restarting gpo_child\n");
+        ad_gpo_child_stop(child);
+    }
+
+    if (child->io == NULL) {
+        ret = ad_gpo_child_start(child);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "ad_gpo_child_start failed.\n");
+            tevent_req_error(req, ret);
+            return;
+        }
+    }
+
+    /* every request is prefixed with its length */
+    frame_len = sizeof(uint32_t) + state->send_buf->size;
+    frame = talloc_array(state, uint8_t, frame_len);
+    if (frame == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+    SAFEALIGN_SET_UINT32(frame, state->send_buf->size, &p);
+    memcpy(frame + p, state->send_buf->data, state->send_buf->size);
+
+    state->in_progress = true;
+
+    subreq = write_pipe_send(state, state->ev, frame, frame_len,
+                             child->io->write_to_child_fd);
+    if (subreq == NULL) {
+        ad_gpo_process_cse_finish(state, ENOMEM);
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+    tevent_req_set_callback(subreq, gpo_cse_step, req);
+}
+
 static void gpo_cse_step(struct tevent_req *subreq)
 {
     struct tevent_req *req;
@@ -4679,15 +5451,17 @@ static void gpo_cse_step(struct tevent_req *subreq)
     ret = write_pipe_recv(subreq);
     talloc_zfree(subreq);
     if (ret != EOK) {
+        ad_gpo_process_cse_finish(state, ret);
         tevent_req_error(req, ret);
         return;
     }
 
-    PIPE_FD_CLOSE(state->io->write_to_child_fd);
-
-    subreq = read_pipe_send(state, state->ev, state->io->read_from_child_fd);
-
+    /* sysvol_gpt_version and result */
+    subreq = ad_gpo_child_read_send(state, state->ev,
+                                    state->child->io->read_from_child_fd,
+                                    2 * sizeof(uint32_t));
     if (subreq == NULL) {
+        ad_gpo_process_cse_finish(state, ENOMEM);
         tevent_req_error(req, ENOMEM);
         return;
     }
@@ -4706,15 +5480,14 @@ static void gpo_cse_done(struct tevent_req *subreq)
     state = tevent_req_data(req, struct ad_gpo_process_cse_state);
     int ret;
 
-    ret = read_pipe_recv(subreq, state, &state->buf, &state->len);
+    ret = ad_gpo_child_read_recv(subreq, state, &state->buf, &state->len);
     talloc_zfree(subreq);
+    ad_gpo_process_cse_finish(state, ret);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
-    PIPE_FD_CLOSE(state->io->read_from_child_fd);
-
     ret = ad_gpo_parse_gpo_child_response(state->buf, state->len,
                                           &sysvol_gpt_version, &child_result);
     if (ret != EOK) {
@@ -4752,72 +5525,6 @@ int ad_gpo_process_cse_recv(struct tevent_req *req)
     return EOK;
 }
 
-static errno_t
-gpo_fork_child(struct tevent_req *req)
-{
-    int pipefd_to_child[2] = PIPE_INIT;
-    int pipefd_from_child[2] = PIPE_INIT;
-    pid_t pid;
-    errno_t ret;
-    struct ad_gpo_process_cse_state *state;
-
-    state = tevent_req_data(req, struct ad_gpo_process_cse_state);
-
-    ret = pipe(pipefd_from_child);
-    if (ret == -1) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "pipe failed [%d][%s].\n", errno, strerror(errno));
-        goto fail;
-    }
-    ret = pipe(pipefd_to_child);
-    if (ret == -1) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "pipe failed [%d][%s].\n", errno, strerror(errno));
-        goto fail;
-    }
-
-    pid = fork();
-
-    if (pid == 0) { /* child */
-        exec_child_ex(state,
-                      pipefd_to_child, pipefd_from_child,
-                      GPO_CHILD, GPO_CHILD_LOG_FILE, NULL, false,
-                      STDIN_FILENO, AD_GPO_CHILD_OUT_FILENO);
-
-        /* We should never get here */
-        DEBUG(SSSDBG_CRIT_FAILURE, "BUG: Could not exec gpo_child:\n");
-    } else if (pid > 0) { /* parent */
-        state->child_pid = pid;
-        state->io->read_from_child_fd = pipefd_from_child[0];
-        PIPE_FD_CLOSE(pipefd_from_child[1]);
-        state->io->write_to_child_fd = pipefd_to_child[1];
-        PIPE_FD_CLOSE(pipefd_to_child[0]);
-        sss_fd_nonblocking(state->io->read_from_child_fd);
-        sss_fd_nonblocking(state->io->write_to_child_fd);
-
-        ret = child_handler_setup(state->ev, pid, NULL, NULL, NULL);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Could not set up child signal handler\n");
-            goto fail;
-        }
-    } else { /* error */
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "fork failed [%d][%s].\n", errno, strerror(errno));
-        goto fail;
-    }
-
-    return EOK;
-
-fail:
-    PIPE_CLOSE(pipefd_from_child);
-    PIPE_CLOSE(pipefd_to_child);
-    return ret;
-}
-
 struct ad_gpo_get_sd_referral_state {
     struct tevent_context *ev;
     struct ad_access_ctx *access_ctx;
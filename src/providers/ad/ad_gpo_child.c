@@ -651,35 +651,17 @@ copy_smb_file_to_gpo_cache(SMBCCTX *smbc_ctx,
  * - backend will read the policy file from the GPO_CACHE
  */
 static errno_t
-perform_smb_operations(int cached_gpt_version,
+perform_smb_operations(SMBCCTX *smbc_ctx,
+                       int cached_gpt_version,
                        const char *smb_server,
                        const char *smb_share,
                        const char *smb_path,
                        const char *smb_cse_suffix,
                        int *_sysvol_gpt_version)
 {
-    SMBCCTX *smbc_ctx;
     int ret;
     int sysvol_gpt_version;
 
-    smbc_ctx = smbc_new_context();
-    if (smbc_ctx == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Could not allocate new smbc context\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    smbc_setOptionDebugToStderr(smbc_ctx, 1);
-    smbc_setFunctionAuthData(smbc_ctx, sssd_krb_get_auth_data_fn);
-    smbc_setOptionUseKerberos(smbc_ctx, 1);
-
-    /* Initialize the context using the previously specified options */
-    if (smbc_init_context(smbc_ctx) == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Could not initialize smbc context\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
     /* download ini file */
     ret = copy_smb_file_to_gpo_cache(smbc_ctx, smb_server, smb_share, smb_path,
                                      GPT_INI);
@@ -714,7 +696,177 @@ perform_smb_operations(int cached_gpt_version,
     *_sysvol_gpt_version = sysvol_gpt_version;
 
  done:
-    smbc_free_context(smbc_ctx, 0);
+    return ret;
+}
+
+static SMBCCTX *
+gpo_child_smbc_context(void)
+{
+    SMBCCTX *smbc_ctx;
+
+    smbc_ctx = smbc_new_context();
+    if (smbc_ctx == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not allocate new smbc context\n");
+        return NULL;
+    }
+
+    smbc_setOptionDebugToStderr(smbc_ctx, 1);
+    smbc_setFunctionAuthData(smbc_ctx, sssd_krb_get_auth_data_fn);
+    smbc_setOptionUseKerberos(smbc_ctx, 1);
+
+    /* Initialize the context using the previously specified options */
+    if (smbc_init_context(smbc_ctx) == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not initialize smbc context\n");
+        smbc_free_context(smbc_ctx, 0);
+        return NULL;
+    }
+
+    return smbc_ctx;
+}
+
+static errno_t
+gpo_child_send_response(TALLOC_CTX *mem_ctx,
+                        int sysvol_gpt_version,
+                        int result)
+{
+    struct response *resp = NULL;
+    ssize_t written;
+    errno_t ret;
+
+    ret = prepare_response(mem_ctx, sysvol_gpt_version, result, &resp);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "prepare_response failed. [%d][%s].\n",
+                    ret, strerror(ret));
+        return ret;
+    }
+
+    errno = 0;
+
+    written = sss_atomic_write_s(AD_GPO_CHILD_OUT_FILENO, resp->buf, resp->size);
+    if (written == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "write failed [%d][%s].\n", ret,
+                    strerror(ret));
+        goto done;
+    }
+
+    if (written != resp->size) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Expected to write %zu bytes, wrote %zu\n",
+              resp->size, written);
+        ret = EIO;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(resp);
+    return ret;
+}
+
+/*
+ * In persistent mode the backend keeps the child running and sends one
+ * request after another, each prefixed with its uint32_t length. Every
+ * request gets a response, failures are reported in its result field. The
+ * smbc context, and thus the SMB connection to the domain controller, is
+ * reused until a request fails. The child exits when stdin is closed.
+ */
+static errno_t
+gpo_child_serve(TALLOC_CTX *main_ctx, uint8_t *buf)
+{
+    TALLOC_CTX *tmp_ctx;
+    SMBCCTX *smbc_ctx = NULL;
+    struct input_buffer *ibuf;
+    uint8_t lenbuf[sizeof(uint32_t)];
+    uint32_t len;
+    ssize_t nread;
+    int sysvol_gpt_version;
+    int result;
+    errno_t ret;
+
+    while (1) {
+        errno = 0;
+        nread = sss_atomic_read_s(STDIN_FILENO, lenbuf, sizeof(lenbuf));
+        if (nread == 0) {
+            DEBUG(SSSDBG_TRACE_FUNC, "stdin was closed, exiting\n");
+            ret = EOK;
+            break;
+        } else if (nread != sizeof(lenbuf)) {
+            ret = nread == -1 ? errno : EIO;
+            DEBUG(SSSDBG_CRIT_FAILURE, "read failed [%d][%s].\n",
+                  ret, strerror(ret));
+            break;
+        }
+
+        SAFEALIGN_COPY_UINT32(&len, lenbuf, NULL);
+        if (len == 0 || len > IN_BUF_SIZE) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Invalid request length %u\n", len);
+            ret = EINVAL;
+            break;
+        }
+
+        errno = 0;
+        nread = sss_atomic_read_s(STDIN_FILENO, buf, len);
+        if (nread != len) {
+            ret = nread == -1 ? errno : EIO;
+            DEBUG(SSSDBG_CRIT_FAILURE, "read failed [%d][%s].\n",
+                  ret, strerror(ret));
+            break;
+        }
+
+        tmp_ctx = talloc_new(main_ctx);
+        if (tmp_ctx == NULL) {
+            ret = ENOMEM;
+            break;
+        }
+
+        sysvol_gpt_version = 0;
+        ibuf = talloc_zero(tmp_ctx, struct input_buffer);
+        if (ibuf == NULL) {
+            result = ENOMEM;
+        } else {
+            result = unpack_buffer(buf, len, ibuf);
+        }
+
+        if (result == EOK && smbc_ctx == NULL) {
+            smbc_ctx = gpo_child_smbc_context();
+            if (smbc_ctx == NULL) {
+                result = ENOMEM;
+            }
+        }
+
+        if (result == EOK) {
+            DEBUG(SSSDBG_TRACE_FUNC, "performing smb operations\n");
+            result = perform_smb_operations(smbc_ctx,
+                                            ibuf->cached_gpt_version,
+                                            ibuf->smb_server,
+                                            ibuf->smb_share,
+                                            ibuf->smb_path,
+                                            ibuf->smb_cse_suffix,
+                                            &sysvol_gpt_version);
+        }
+
+        if (result != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Request failed [%d][%s].\n",
+                  result, strerror(result));
+            /* Do not reuse a connection that might be broken. */
+            if (smbc_ctx != NULL) {
+                smbc_free_context(smbc_ctx, 1);
+                smbc_ctx = NULL;
+            }
+        }
+
+        ret = gpo_child_send_response(tmp_ctx, sysvol_gpt_version, result);
+        talloc_free(tmp_ctx);
+        if (ret != EOK) {
+            break;
+        }
+    }
+
+    if (smbc_ctx != NULL) {
+        smbc_free_context(smbc_ctx, 1);
+    }
+
     return ret;
 }
 
@@ -728,12 +880,12 @@ main(int argc, const char *argv[])
     errno_t ret;
     int sysvol_gpt_version;
     int result;
+    int persistent = 0;
     TALLOC_CTX *main_ctx = NULL;
     uint8_t *buf = NULL;
     ssize_t len = 0;
     struct input_buffer *ibuf = NULL;
-    struct response *resp = NULL;
-    ssize_t written;
+    SMBCCTX *smbc_ctx;
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
@@ -748,6 +900,8 @@ main(int argc, const char *argv[])
         {"debug-to-stderr", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN,
          &debug_to_stderr, 0,
          _("Send the debug output to stderr directly."), NULL },
+        {"persistent", 0, POPT_ARG_NONE, &persistent, 0,
+         _("Serve requests until stdin is closed"), NULL},
         SSSD_LOGGER_OPTS
         POPT_TABLEEND
     };
@@ -810,6 +964,14 @@ main(int argc, const char *argv[])
 
     DEBUG(SSSDBG_TRACE_FUNC, "context initialized\n");
 
+    if (persistent) {
+        ret = gpo_child_serve(main_ctx, buf);
+        if (ret != EOK) {
+            goto fail;
+        }
+        goto done;
+    }
+
     errno = 0;
     len = sss_atomic_read_s(STDIN_FILENO, buf, IN_BUF_SIZE);
     if (len == -1) {
@@ -829,12 +991,19 @@ main(int argc, const char *argv[])
 
     DEBUG(SSSDBG_TRACE_FUNC, "performing smb operations\n");
 
-    result = perform_smb_operations(ibuf->cached_gpt_version,
+    smbc_ctx = gpo_child_smbc_context();
+    if (smbc_ctx == NULL) {
+        goto fail;
+    }
+
+    result = perform_smb_operations(smbc_ctx,
+                                    ibuf->cached_gpt_version,
                                     ibuf->smb_server,
                                     ibuf->smb_share,
                                     ibuf->smb_path,
                                     ibuf->smb_cse_suffix,
                                     &sysvol_gpt_version);
+    smbc_free_context(smbc_ctx, 0);
     if (result != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "perform_smb_operations failed.[%d][%s].\n",
@@ -842,29 +1011,12 @@ main(int argc, const char *argv[])
         goto fail;
     }
 
-    ret = prepare_response(main_ctx, sysvol_gpt_version, result, &resp);
+    ret = gpo_child_send_response(main_ctx, sysvol_gpt_version, result);
     if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "prepare_response failed. [%d][%s].\n",
-                    ret, strerror(ret));
-        goto fail;
-    }
-
-    errno = 0;
-
-    written = sss_atomic_write_s(AD_GPO_CHILD_OUT_FILENO, resp->buf, resp->size);
-    if (written == -1) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE, "write failed [%d][%s].\n", ret,
-                    strerror(ret));
-        goto fail;
-    }
-
-    if (written != resp->size) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Expected to write %zu bytes, wrote %zu\n",
-              resp->size, written);
         goto fail;
     }
 
+done:
     DEBUG(SSSDBG_TRACE_FUNC, "gpo_child completed successfully\n");
     close(AD_GPO_CHILD_OUT_FILENO);
     talloc_free(main_ctx);
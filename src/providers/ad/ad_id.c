@@ -111,12 +111,25 @@ struct ad_handle_acct_info_state {
     struct ad_options *ad_options;
     bool using_pac;
 
+    /* Lookups sent to the Global Catalog and LDAP at the same time */
+    struct tevent_req *race[2];
+    struct {
+        errno_t ret;
+        int dp_error;
+        const char *err;
+        int sdap_err;
+    } race_result[2];
+
     int dp_error;
     const char *err;
 };
 
 static errno_t ad_handle_acct_info_step(struct tevent_req *req);
 static void ad_handle_acct_info_done(struct tevent_req *subreq);
+static bool ad_handle_acct_info_can_race(struct ad_handle_acct_info_state *state);
+static errno_t ad_handle_acct_info_race(struct tevent_req *req);
+static void ad_handle_acct_info_race_done(struct tevent_req *subreq);
+static void ad_handle_acct_info_error(struct tevent_req *req, errno_t ret);
 
 struct tevent_req *
 ad_handle_acct_info_send(TALLOC_CTX *mem_ctx,
@@ -160,7 +173,11 @@ ad_handle_acct_info_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = ad_handle_acct_info_step(req);
+    if (ad_handle_acct_info_can_race(state)) {
+        ret = ad_handle_acct_info_race(req);
+    } else {
+        ret = ad_handle_acct_info_step(req);
+    }
     if (ret != EAGAIN) {
         goto immediate;
     }
@@ -302,6 +319,125 @@ ad_handle_acct_info_done(struct tevent_req *subreq)
     return;
 
 fail:
+    ad_handle_acct_info_error(req, ret);
+}
+
+static bool
+ad_handle_acct_info_can_race(struct ad_handle_acct_info_state *state)
+{
+    if (state->ad_options == NULL
+            || !dp_opt_get_bool(state->ad_options->basic, AD_RACE_GC_LDAP)) {
+        return false;
+    }
+
+    /* Only a Global Catalog lookup with a fallback to LDAP qualifies. */
+    if (state->conn[0] == NULL || state->conn[1] == NULL
+            || state->conn[2] != NULL
+            || !state->conn[0]->ignore_mark_offline) {
+        return false;
+    }
+
+    switch (state->ar->entry_type & BE_REQ_TYPE_MASK) {
+    case BE_REQ_USER:
+    case BE_REQ_GROUP:
+    case BE_REQ_BY_SECID:
+    case BE_REQ_USER_AND_GROUP:
+        return true;
+    default:
+        /* Initgroups can be answered from the PAC and stores many objects,
+         * it keeps using one connection after the other. */
+        return false;
+    }
+}
+
+static errno_t
+ad_handle_acct_info_race(struct tevent_req *req)
+{
+    struct ad_handle_acct_info_state *state = tevent_req_data(req,
+                                            struct ad_handle_acct_info_state);
+    struct tevent_req *subreq;
+    size_t i;
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Querying the Global Catalog and LDAP at the same time\n");
+
+    for (i = 0; i < 2; i++) {
+        /* As with one lookup after the other only the LDAP lookup removes
+         * the object from the cache if it does not exist. If the Global
+         * Catalog finds it later it is stored again. */
+        subreq = sdap_handle_acct_req_send(state, state->ctx->be,
+                                           state->ar, state->ctx,
+                                           state->sdom,
+                                           state->conn[i],
+                                           i == 1);
+        if (subreq == NULL) {
+            talloc_zfree(state->race[0]);
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, ad_handle_acct_info_race_done, req);
+        state->race[i] = subreq;
+    }
+
+    return EAGAIN;
+}
+
+static void
+ad_handle_acct_info_race_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct ad_handle_acct_info_state *state = tevent_req_data(req,
+                                            struct ad_handle_acct_info_state);
+    size_t i = subreq == state->race[0] ? 0 : 1;
+    errno_t ret;
+
+    ret = sdap_handle_acct_req_recv(subreq,
+                                    &state->race_result[i].dp_error,
+                                    &state->race_result[i].err,
+                                    &state->race_result[i].sdap_err);
+    state->race_result[i].ret = ret;
+    talloc_zfree(subreq);
+    state->race[i] = NULL;
+
+    if (ret == EOK && state->race_result[i].sdap_err == EOK) {
+        /* The first complete answer wins, cancel the other lookup. */
+        DEBUG(SSSDBG_TRACE_FUNC, "%s answered first\n",
+              i == 0 ? "Global Catalog" : "LDAP");
+        talloc_zfree(state->race[1 - i]);
+        tevent_req_done(req);
+        return;
+    }
+
+    if (state->race[1 - i] != NULL) {
+        /* Wait for the other lookup. */
+        return;
+    }
+
+    /* Neither lookup found the object. LDAP has the final word, the same
+     * as when it is asked after the Global Catalog. */
+    ret = state->race_result[1].ret;
+    state->dp_error = state->race_result[1].dp_error;
+    state->err = state->race_result[1].err;
+    if (ret != EOK) {
+        ad_handle_acct_info_error(req, ret);
+        return;
+    }
+
+    if (state->race_result[1].sdap_err != ENOENT) {
+        ad_handle_acct_info_error(req, EIO);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void
+ad_handle_acct_info_error(struct tevent_req *req, errno_t ret)
+{
+    struct ad_handle_acct_info_state *state = tevent_req_data(req,
+                                            struct ad_handle_acct_info_state);
+
     if (IS_SUBDOMAIN(state->sdom->dom)) {
         /* Deactivate subdomain on lookup errors instead of going
          * offline completely.
@@ -779,7 +915,8 @@ ad_enumeration_done(struct tevent_req *subreq)
              state->sditer->dom->enumerate == false);
 
     if (state->sditer != NULL) {
-        ret = ad_enum_sdom(req, state->sditer, state->sditer->pvt);
+        ret = ad_enum_sdom(req, state->sditer,
+                           sdap_domain_get_pvt(state->sditer));
         if (ret != EOK) {
             DEBUG(SSSDBG_OP_FAILURE, "Could not enumerate domain %s\n",
                   state->sditer->dom->name);
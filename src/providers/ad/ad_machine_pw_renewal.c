@@ -182,63 +182,54 @@ ad_machine_account_password_renewal_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    child_pid = fork();
-    if (child_pid == 0) { /* child */
-        exec_child_ex(state, pipefd_to_child, pipefd_from_child,
-                      renewal_data->prog_path, NULL,
-                      extra_args, true,
-                      STDIN_FILENO, STDERR_FILENO);
-
-        /* We should never get here */
-        DEBUG(SSSDBG_CRIT_FAILURE, "Could not exec renewal child\n");
-    } else if (child_pid > 0) { /* parent */
-
-        state->io->read_from_child_fd = pipefd_from_child[0];
-        PIPE_FD_CLOSE(pipefd_from_child[1]);
-        sss_fd_nonblocking(state->io->read_from_child_fd);
-
-        state->io->write_to_child_fd = pipefd_to_child[1];
-        PIPE_FD_CLOSE(pipefd_to_child[0]);
-        sss_fd_nonblocking(state->io->write_to_child_fd);
-
-        /* Set up SIGCHLD handler */
-        ret = child_handler_setup(ev, child_pid, NULL, NULL, &state->child_ctx);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "Could not set up child handlers [%d]: %s\n",
-                ret, sss_strerror(ret));
-            ret = ERR_RENEWAL_CHILD;
-            goto done;
-        }
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child,
+                          renewal_data->prog_path, NULL,
+                          extra_args, true,
+                          STDIN_FILENO, STDERR_FILENO, &child_pid);
+    if (ret != EOK) {
+        goto done;
+    }
 
-        /* Set up timeout handler */
-        tv = tevent_timeval_current_ofs(be_ptask_get_timeout(be_ptask), 0);
-        state->timeout_handler = tevent_add_timer(ev, req, tv,
-                                    ad_machine_account_password_renewal_timeout,
-                                    req);
-        if(state->timeout_handler == NULL) {
-            ret = ERR_RENEWAL_CHILD;
-            goto done;
-        }
+    state->io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    sss_fd_nonblocking(state->io->read_from_child_fd);
 
-        subreq = read_pipe_send(state, ev, state->io->read_from_child_fd);
-        if (subreq == NULL) {
-            DEBUG(SSSDBG_OP_FAILURE, "read_pipe_send failed.\n");
-            ret = ERR_RENEWAL_CHILD;
-            goto done;
-        }
-        tevent_req_set_callback(subreq,
-                                ad_machine_account_password_renewal_done, req);
+    state->io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(state->io->write_to_child_fd);
 
-        /* Now either wait for the timeout to fire or the child
-         * to finish
-         */
-    } else { /* error */
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE, "fork failed [%d][%s].\n",
-                                   ret, sss_strerror(ret));
+    /* Set up SIGCHLD handler */
+    ret = child_handler_setup(ev, child_pid, NULL, NULL, &state->child_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not set up child handlers [%d]: %s\n",
+            ret, sss_strerror(ret));
+        ret = ERR_RENEWAL_CHILD;
         goto done;
     }
 
+    /* Set up timeout handler */
+    tv = tevent_timeval_current_ofs(be_ptask_get_timeout(be_ptask), 0);
+    state->timeout_handler = tevent_add_timer(ev, req, tv,
+                                ad_machine_account_password_renewal_timeout,
+                                req);
+    if(state->timeout_handler == NULL) {
+        ret = ERR_RENEWAL_CHILD;
+        goto done;
+    }
+
+    subreq = read_pipe_send(state, ev, state->io->read_from_child_fd);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "read_pipe_send failed.\n");
+        ret = ERR_RENEWAL_CHILD;
+        goto done;
+    }
+    tevent_req_set_callback(subreq,
+                            ad_machine_account_password_renewal_done, req);
+
+    /* Now either wait for the timeout to fire or the child
+     * to finish
+     */
+
     ret = EOK;
 
 done:
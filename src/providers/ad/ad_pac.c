@@ -513,6 +513,53 @@ done:
     return ret;
 }
 
+/* Splits the SIDs into the ones that belong to a domain with algorithmic
+ * id-mapping, which can be stored without any LDAP lookup, and the others. */
+static errno_t ad_pac_split_mapped_sids(TALLOC_CTX *mem_ctx,
+                                        struct sdap_idmap_ctx *idmap_ctx,
+                                        struct sss_domain_info *user_dom,
+                                        size_t num_sids,
+                                        char **sids,
+                                        size_t *_num_mapped,
+                                        char ***_mapped,
+                                        size_t *_num_other,
+                                        char ***_other)
+{
+    struct sss_domain_info *sid_dom;
+    char **mapped;
+    char **other;
+    size_t num_mapped = 0;
+    size_t num_other = 0;
+    size_t i;
+
+    mapped = talloc_zero_array(mem_ctx, char *, num_sids + 1);
+    other = talloc_zero_array(mem_ctx, char *, num_sids + 1);
+    if (mapped == NULL || other == NULL) {
+        talloc_free(mapped);
+        talloc_free(other);
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num_sids; i++) {
+        sid_dom = find_domain_by_sid(get_domains_head(user_dom), sids[i]);
+        if (sid_dom != NULL
+                && sdap_idmap_domain_has_algorithmic_mapping(idmap_ctx,
+                                                             sid_dom->name,
+                                                        sid_dom->domain_id)) {
+            mapped[num_mapped++] = sids[i];
+        } else {
+            other[num_other++] = sids[i];
+        }
+    }
+
+    *_num_mapped = num_mapped;
+    *_mapped = mapped;
+    *_num_other = num_other;
+    *_other = other;
+
+    return EOK;
+}
+
 struct ad_handle_pac_initgr_state {
     struct dp_id_data *ar;
     const char *err;
@@ -547,6 +594,10 @@ struct tevent_req *ad_handle_pac_initgr_send(TALLOC_CTX *mem_ctx,
     char *primary_group_sid;
     size_t num_sids;
     char **group_sids;
+    size_t num_mapped_sids;
+    char **mapped_sids;
+    size_t num_mapped_groups = 0;
+    char **mapped_groups = NULL;
     bool use_id_mapping;
 
     req = tevent_req_create(mem_ctx, &state,
@@ -616,6 +667,37 @@ struct tevent_req *ad_handle_pac_initgr_send(TALLOC_CTX *mem_ctx,
 
         DEBUG(SSSDBG_TRACE_ALL, "Running PAC processing with external IDs.\n");
 
+        if (!use_id_mapping && sdom->dom->ignore_group_members == false) {
+            /* Groups of trusted domains with id-mapping do not have to be
+             * looked up, only the remaining SIDs are handled as POSIX
+             * groups. */
+            ret = ad_pac_split_mapped_sids(state, id_ctx->opts->idmap_ctx,
+                                           sdom->dom, num_sids, group_sids,
+                                           &num_mapped_sids, &mapped_sids,
+                                           &num_sids, &group_sids);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "ad_pac_split_mapped_sids failed.\n");
+                goto done;
+            }
+
+            if (num_mapped_sids > 0) {
+                DEBUG(SSSDBG_TRACE_ALL, "%zu SIDs can be mapped without "
+                      "lookup.\n", num_mapped_sids);
+
+                ret = sdap_ad_get_group_dns_with_idmapping(state, sdom->dom,
+                                                    id_ctx->opts->idmap_ctx,
+                                                    num_mapped_sids,
+                                                    mapped_sids,
+                                                    &num_mapped_groups,
+                                                    &mapped_groups);
+                if (ret != EOK) {
+                    DEBUG(SSSDBG_OP_FAILURE,
+                          "sdap_ad_get_group_dns_with_idmapping failed.\n");
+                    goto done;
+                }
+            }
+        }
+
         ret = sdap_ad_tokengroups_get_posix_members(state, sdom->dom,
                                                     num_sids, group_sids,
                                                     &state->num_missing_sids,
@@ -628,6 +710,19 @@ struct tevent_req *ad_handle_pac_initgr_send(TALLOC_CTX *mem_ctx,
             goto done;
         }
 
+        if (num_mapped_groups > 0) {
+            state->cached_groups = concatenate_string_array(state,
+                                                    state->cached_groups,
+                                                    state->num_cached_groups,
+                                                    mapped_groups,
+                                                    num_mapped_groups);
+            if (state->cached_groups == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+            state->num_cached_groups += num_mapped_groups;
+        }
+
         /* download missing SIDs */
         subreq = sdap_ad_resolve_sids_send(state, be_ctx->ev, id_ctx,
                                            conn,
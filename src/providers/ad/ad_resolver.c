@@ -439,7 +439,8 @@ ad_resolver_enum_sdom_done(struct tevent_req *subreq)
     if (state->sditer != NULL) {
         struct ad_id_ctx *ad_id_ctx;
 
-        ad_id_ctx = talloc_get_type(state->sditer->pvt, struct ad_id_ctx);
+        ad_id_ctx = talloc_get_type(sdap_domain_get_pvt(state->sditer),
+                                    struct ad_id_ctx);
         if (ad_id_ctx == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Cannot retrieve ad_id_ctx!\n");
             tevent_req_error(req, EINVAL);
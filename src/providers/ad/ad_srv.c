@@ -26,6 +26,7 @@
 
 #include "util/util.h"
 #include "util/sss_ldap.h"
+#include "util/sss_ptr_hash.h"
 #include "resolv/async_resolv.h"
 #include "providers/backend.h"
 #include "providers/ad/ad_srv.h"
@@ -38,6 +39,22 @@
 
 #define AD_SITE_DOMAIN_FMT "%s._sites.%s"
 
+/* At most this many primary servers are pinged to measure their round trip
+ * time, all of them at once and for at most AD_SRV_PING_TIMEOUT seconds. */
+#define AD_SRV_MAX_PINGS 8
+#define AD_SRV_PING_TIMEOUT 3
+
+/* A new round trip time sample contributes 1/AD_SRV_RTT_WEIGHT to the
+ * moving average. */
+#define AD_SRV_RTT_WEIGHT 4
+
+#define AD_SRV_RTT_UNKNOWN UINT64_MAX
+
+static void ad_srv_rtt_update(struct ad_srv_plugin_ctx *ctx,
+                              const char *host,
+                              errno_t ping_ret,
+                              uint64_t usec);
+
 char *ad_site_dns_discovery_domain(TALLOC_CTX *mem_ctx,
                                    const char *site,
                                    const char *domain)
@@ -238,6 +255,206 @@ static int ad_get_dc_servers_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+struct ad_cldap_ping_state {
+    struct tevent_context *ev;
+    struct sdap_options *opts;
+    struct ad_srv_plugin_ctx *srv_ctx;
+    const char *ad_domain;
+    const char *host;
+    int port;
+    struct timeval start;
+
+    struct sdap_handle *sh;
+    struct sysdb_attrs *reply;
+};
+
+static void ad_cldap_ping_connect_done(struct tevent_req *subreq);
+static void ad_cldap_ping_done(struct tevent_req *subreq);
+
+/* Connect to the domain controller and read its netlogon information. The
+ * round trip time of the search is recorded in @srv_ctx if it is set. */
+static struct tevent_req *ad_cldap_ping_send(TALLOC_CTX *mem_ctx,
+                                             struct tevent_context *ev,
+                                             struct be_resolv_ctx *be_res,
+                                             enum host_database *host_db,
+                                             struct sdap_options *opts,
+                                             const char *ad_domain,
+                                             bool ad_use_ldaps,
+                                             const char *host,
+                                             int port,
+                                             struct ad_srv_plugin_ctx *srv_ctx)
+{
+    struct ad_cldap_ping_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct tevent_req *subreq = NULL;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct ad_cldap_ping_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->opts = opts;
+    state->srv_ctx = srv_ctx;
+    state->ad_domain = ad_domain;
+    state->port = ad_use_ldaps ? 636 : port;
+
+    state->host = talloc_strdup(state, host);
+    if (state->host == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    subreq = sdap_connect_host_send(state, ev, opts,
+                                    be_res->resolv,
+                                    be_res->family_order,
+                                    host_db,
+                                    ad_use_ldaps ? "ldaps" : "ldap",
+                                    state->host, state->port,
+                                    false);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    tevent_req_set_callback(subreq, ad_cldap_ping_connect_done, req);
+
+    return req;
+
+immediately:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void ad_cldap_ping_connect_done(struct tevent_req *subreq)
+{
+    struct ad_cldap_ping_state *state = NULL;
+    struct tevent_req *req = NULL;
+    static const char *attrs[] = {AD_AT_NETLOGON, NULL};
+    char *filter = NULL;
+    char *ntver = NULL;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ad_cldap_ping_state);
+
+    ret = sdap_connect_host_recv(state, subreq, &state->sh);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to connect to domain controller "
+              "[%s:%d]\n", state->host, state->port);
+        ad_srv_rtt_update(state->srv_ctx, state->host, ret, 0);
+        goto done;
+    }
+
+    ntver = sss_ldap_encode_ndr_uint32(state, NETLOGON_NT_VERSION_5EX |
+                                       NETLOGON_NT_VERSION_WITH_CLOSEST_SITE);
+    if (ntver == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    filter = talloc_asprintf(state, "(&(%s=%s)(%s=%s))",
+                             AD_AT_DNS_DOMAIN, state->ad_domain,
+                             AD_AT_NT_VERSION, ntver);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->start = tevent_timeval_current();
+
+    subreq = sdap_get_generic_send(state, state->ev, state->opts, state->sh,
+                                   "", LDAP_SCOPE_BASE, filter,
+                                   attrs, NULL, 0,
+                                   dp_opt_get_int(state->opts->basic,
+                                                  SDAP_SEARCH_TIMEOUT),
+                                   false);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, ad_cldap_ping_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+
+    return;
+}
+
+static void ad_cldap_ping_done(struct tevent_req *subreq)
+{
+    struct ad_cldap_ping_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct sysdb_attrs **reply = NULL;
+    struct timeval now;
+    size_t reply_count;
+    uint64_t usec;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ad_cldap_ping_state);
+
+    ret = sdap_get_generic_recv(subreq, state, &reply_count, &reply);
+    talloc_zfree(subreq);
+
+    now = tevent_timeval_current();
+    usec = (now.tv_sec - state->start.tv_sec) * 1000000ULL
+           + now.tv_usec - state->start.tv_usec;
+
+    /* we're done with this LDAP, close connection */
+    talloc_zfree(state->sh);
+
+    ad_srv_rtt_update(state->srv_ctx, state->host, ret, usec);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to get netlogon information\n");
+        goto done;
+    }
+
+    if (reply_count == 0) {
+        DEBUG(SSSDBG_OP_FAILURE, "No netlogon information retrieved\n");
+        ret = ENOENT;
+        goto done;
+    }
+
+    state->reply = reply[0];
+
+done:
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t ad_cldap_ping_recv(TALLOC_CTX *mem_ctx,
+                                  struct tevent_req *req,
+                                  struct sysdb_attrs **_reply)
+{
+    struct ad_cldap_ping_state *state = NULL;
+    state = tevent_req_data(req, struct ad_cldap_ping_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (_reply != NULL) {
+        *_reply = talloc_steal(mem_ctx, state->reply);
+    }
+
+    return EOK;
+}
+
 struct ad_get_client_site_state {
     struct tevent_context *ev;
     struct be_resolv_ctx *be_res;
@@ -249,14 +466,13 @@ struct ad_get_client_site_state {
     size_t num_dcs;
     size_t dc_index;
     struct fo_server_info dc;
+    struct ad_srv_plugin_ctx *srv_ctx;
 
-    struct sdap_handle *sh;
     char *site;
     char *forest;
 };
 
 static errno_t ad_get_client_site_next_dc(struct tevent_req *req);
-static void ad_get_client_site_connect_done(struct tevent_req *subreq);
 static void ad_get_client_site_done(struct tevent_req *subreq);
 
 struct tevent_req *ad_get_client_site_send(TALLOC_CTX *mem_ctx,
@@ -267,7 +483,8 @@ struct tevent_req *ad_get_client_site_send(TALLOC_CTX *mem_ctx,
                                            const char *ad_domain,
                                            bool ad_use_ldaps,
                                            struct fo_server_info *dcs,
-                                           size_t num_dcs)
+                                           size_t num_dcs,
+                                           struct ad_srv_plugin_ctx *srv_ctx)
 {
     struct ad_get_client_site_state *state = NULL;
     struct tevent_req *req = NULL;
@@ -293,6 +510,7 @@ struct tevent_req *ad_get_client_site_send(TALLOC_CTX *mem_ctx,
     state->ad_use_ldaps = ad_use_ldaps;
     state->dcs = dcs;
     state->num_dcs = num_dcs;
+    state->srv_ctx = srv_ctx;
 
     state->dc_index = 0;
     ret = ad_get_client_site_next_dc(req);
@@ -331,20 +549,17 @@ static errno_t ad_get_client_site_next_dc(struct tevent_req *req)
 
     state->dc = state->dcs[state->dc_index];
 
-    subreq = sdap_connect_host_send(state, state->ev, state->opts,
-                                    state->be_res->resolv,
-                                    state->be_res->family_order,
-                                    state->host_db,
-                                    state->ad_use_ldaps ? "ldaps" : "ldap",
-                                    state->dc.host,
-                                    state->ad_use_ldaps ? 636 : state->dc.port,
-                                    false);
+    subreq = ad_cldap_ping_send(state, state->ev, state->be_res,
+                                state->host_db, state->opts,
+                                state->ad_domain, state->ad_use_ldaps,
+                                state->dc.host, state->dc.port,
+                                state->srv_ctx);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto done;
     }
 
-    tevent_req_set_callback(subreq, ad_get_client_site_connect_done, req);
+    tevent_req_set_callback(subreq, ad_get_client_site_done, req);
 
     state->dc_index++;
     ret = EAGAIN;
@@ -353,105 +568,30 @@ done:
     return ret;
 }
 
-static void ad_get_client_site_connect_done(struct tevent_req *subreq)
-{
-    struct ad_get_client_site_state *state = NULL;
-    struct tevent_req *req = NULL;
-    static const char *attrs[] = {AD_AT_NETLOGON, NULL};
-    char *filter = NULL;
-    char *ntver = NULL;
-    errno_t ret;
-
-    req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct ad_get_client_site_state);
-
-    ret = sdap_connect_host_recv(state, subreq, &state->sh);
-    talloc_zfree(subreq);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to connect to domain controller "
-              "[%s:%d]\n", state->dc.host, state->dc.port);
-
-        ret = ad_get_client_site_next_dc(req);
-        if (ret == EOK) {
-            ret = ENOENT;
-        }
-
-        goto done;
-    }
-
-    ntver = sss_ldap_encode_ndr_uint32(state, NETLOGON_NT_VERSION_5EX |
-                                       NETLOGON_NT_VERSION_WITH_CLOSEST_SITE);
-    if (ntver == NULL) {
-        ret = ENOMEM;
-        goto done;
-    }
-
-    filter = talloc_asprintf(state, "(&(%s=%s)(%s=%s))",
-                             AD_AT_DNS_DOMAIN, state->ad_domain,
-                             AD_AT_NT_VERSION, ntver);
-    if (filter == NULL) {
-        ret = ENOMEM;
-        goto done;
-    }
-
-    subreq = sdap_get_generic_send(state, state->ev, state->opts, state->sh,
-                                   "", LDAP_SCOPE_BASE, filter,
-                                   attrs, NULL, 0,
-                                   dp_opt_get_int(state->opts->basic,
-                                                  SDAP_SEARCH_TIMEOUT),
-                                   false);
-    if (subreq == NULL) {
-        ret = ENOMEM;
-        goto done;
-    }
-
-    tevent_req_set_callback(subreq, ad_get_client_site_done, req);
-
-    ret = EAGAIN;
-
-done:
-    if (ret == EOK) {
-        tevent_req_done(req);
-    } else if (ret != EAGAIN) {
-        tevent_req_error(req, ret);
-    }
-
-    return;
-}
-
 static void ad_get_client_site_done(struct tevent_req *subreq)
 {
     struct ad_get_client_site_state *state = NULL;
     struct tevent_req *req = NULL;
-    struct sysdb_attrs **reply = NULL;
-    size_t reply_count;
+    struct sysdb_attrs *reply = NULL;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
     state = tevent_req_data(req, struct ad_get_client_site_state);
 
-    ret = sdap_get_generic_recv(subreq, state, &reply_count, &reply);
+    ret = ad_cldap_ping_recv(state, subreq, &reply);
     talloc_zfree(subreq);
-
-    /* we're done with this LDAP, close connection */
-    talloc_zfree(state->sh);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Unable to get netlogon information\n");
-
         ret = ad_get_client_site_next_dc(req);
         if (ret == EOK) {
             ret = ENOENT;
+        } else if (ret == EAGAIN) {
+            return;
         }
-        goto done;
-    }
 
-    if (reply_count == 0) {
-        DEBUG(SSSDBG_OP_FAILURE, "No netlogon information retrieved\n");
-        ret = ENOENT;
         goto done;
     }
 
-    ret = netlogon_get_domain_info(state, reply[0], true, NULL, &state->site,
+    ret = netlogon_get_domain_info(state, reply, true, NULL, &state->site,
                                    &state->forest);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Unable to retrieve site name [%d]: %s\n",
@@ -498,8 +638,113 @@ struct ad_srv_plugin_ctx {
     const char *ad_site_override;
     const char *current_site;
     bool ad_use_ldaps;
+
+    /* Moving average of the netlogon round trip time of each domain
+     * controller, kept across server rediscoveries. */
+    hash_table_t *rtt_table;
+};
+
+struct ad_srv_rtt {
+    uint64_t usec;
+    time_t updated;
 };
 
+static struct ad_srv_rtt *ad_srv_rtt_lookup(struct ad_srv_plugin_ctx *ctx,
+                                            const char *host)
+{
+    if (ctx == NULL || ctx->rtt_table == NULL || host == NULL) {
+        return NULL;
+    }
+
+    return sss_ptr_hash_lookup(ctx->rtt_table, host, struct ad_srv_rtt);
+}
+
+static void ad_srv_rtt_update(struct ad_srv_plugin_ctx *ctx,
+                              const char *host,
+                              errno_t ping_ret,
+                              uint64_t usec)
+{
+    struct ad_srv_rtt *rtt;
+    errno_t ret;
+
+    if (ctx == NULL || ctx->rtt_table == NULL || host == NULL) {
+        return;
+    }
+
+    rtt = ad_srv_rtt_lookup(ctx, host);
+
+    if (ping_ret != EOK) {
+        /* Do not prefer this server until it answers again. The entry is
+         * removed from the table by sss_ptr_hash. */
+        talloc_free(rtt);
+        return;
+    }
+
+    if (rtt == NULL) {
+        rtt = talloc_zero(ctx, struct ad_srv_rtt);
+        if (rtt == NULL) {
+            return;
+        }
+
+        ret = sss_ptr_hash_add(ctx->rtt_table, host, rtt, struct ad_srv_rtt);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to store round trip time "
+                  "of %s [%d]: %s\n", host, ret, sss_strerror(ret));
+            talloc_free(rtt);
+            return;
+        }
+
+        rtt->usec = usec;
+    } else {
+        rtt->usec = rtt->usec - rtt->usec / AD_SRV_RTT_WEIGHT
+                    + usec / AD_SRV_RTT_WEIGHT;
+    }
+
+    rtt->updated = time(NULL);
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Round trip time of %s is %"PRIu64" us, "
+          "average %"PRIu64" us\n", host, usec, rtt->usec);
+}
+
+/* Order servers of the same priority by their average round trip time,
+ * servers that were not measured keep their relative order and follow
+ * the measured ones. */
+static void ad_sort_servers_by_rtt(struct ad_srv_plugin_ctx *ctx,
+                                   struct fo_server_info *srv,
+                                   size_t num)
+{
+    struct fo_server_info tmp;
+    struct ad_srv_rtt *rtt;
+    uint64_t usec[num];
+    uint64_t tmp_usec;
+    size_t i, j;
+
+    if (srv == NULL || num <= 1) {
+        return;
+    }
+
+    for (i = 0; i < num; i++) {
+        rtt = ad_srv_rtt_lookup(ctx, srv[i].host);
+        usec[i] = rtt == NULL ? AD_SRV_RTT_UNKNOWN : rtt->usec;
+    }
+
+    /* The servers are already sorted by priority and there are only few of
+     * them, a stable insertion sort within each priority is sufficient. */
+    for (i = 1; i < num; i++) {
+        tmp = srv[i];
+        tmp_usec = usec[i];
+
+        for (j = i; j > 0 && srv[j - 1].priority == tmp.priority
+                        && usec[j - 1] > tmp_usec; j--) {
+            srv[j] = srv[j - 1];
+            usec[j] = usec[j - 1];
+        }
+
+        srv[j] = tmp;
+        usec[j] = tmp_usec;
+    }
+}
+
 struct ad_srv_plugin_ctx *
 ad_srv_plugin_ctx_init(TALLOC_CTX *mem_ctx,
                        struct be_ctx *be_ctx,
@@ -530,6 +775,11 @@ ad_srv_plugin_ctx_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    ctx->rtt_table = sss_ptr_hash_create(ctx, NULL, NULL);
+    if (ctx->rtt_table == NULL) {
+        goto fail;
+    }
+
     ctx->ad_domain = talloc_strdup(ctx, ad_domain);
     if (ctx->ad_domain == NULL) {
         goto fail;
@@ -611,11 +861,23 @@ struct ad_srv_plugin_state {
     size_t num_primary_servers;
     struct fo_server_info *backup_servers;
     size_t num_backup_servers;
+
+    TALLOC_CTX *ping_ctx;
+    size_t num_pings;
+    time_t ping_start;
+    bool pinged[AD_SRV_MAX_PINGS];
 };
 
 static void ad_srv_plugin_dcs_done(struct tevent_req *subreq);
 static void ad_srv_plugin_site_done(struct tevent_req *subreq);
 static void ad_srv_plugin_servers_done(struct tevent_req *subreq);
+static errno_t ad_srv_plugin_ping_servers(struct tevent_req *req);
+static void ad_srv_plugin_ping_done(struct tevent_req *subreq);
+static void ad_srv_plugin_ping_timeout(struct tevent_context *ev,
+                                       struct tevent_timer *te,
+                                       struct timeval tv,
+                                       void *pvt);
+static void ad_srv_plugin_finish(struct tevent_req *req);
 
 /* 1. Do a DNS lookup to find any DC in domain
  *    _ldap._tcp.domain.name
@@ -626,6 +888,9 @@ static void ad_srv_plugin_servers_done(struct tevent_req *subreq);
  *    _service._protocol.domain.name
  * 5. If the site is found, use (a) as primary and (b) as backup servers,
  *    otherwise use (b) as primary servers
+ * 6. Send a CLDAP ping to the first primary servers whose round trip time
+ *    was not measured within the TTL of the SRV records and prefer the
+ *    fastest servers of each priority
  */
 struct tevent_req *ad_srv_plugin_send(TALLOC_CTX *mem_ctx,
                                        struct tevent_context *ev,
@@ -724,7 +989,7 @@ static void ad_srv_plugin_dcs_done(struct tevent_req *subreq)
                                      state->ctx->opts,
                                      state->discovery_domain,
                                      state->ctx->ad_use_ldaps,
-                                     dcs, num_dcs);
+                                     dcs, num_dcs, state->ctx);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto done;
@@ -893,6 +1158,154 @@ static void ad_srv_plugin_servers_done(struct tevent_req *subreq)
         /* continue */
     }
 
+    ret = ad_srv_plugin_ping_servers(req);
+    if (ret == EAGAIN) {
+        return;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to measure round trip time of "
+              "servers [%d]: %s\n", ret, sss_strerror(ret));
+        /* continue */
+    }
+
+    ad_srv_plugin_finish(req);
+}
+
+static errno_t ad_srv_plugin_ping_servers(struct tevent_req *req)
+{
+    struct ad_srv_plugin_state *state = NULL;
+    struct tevent_req *subreq = NULL;
+    struct tevent_timer *te = NULL;
+    struct fo_server_info *srv = NULL;
+    struct ad_srv_rtt *rtt = NULL;
+    time_t now;
+    int port;
+    size_t i;
+
+    state = tevent_req_data(req, struct ad_srv_plugin_state);
+
+    state->ping_ctx = talloc_new(state);
+    if (state->ping_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    now = time(NULL);
+    state->ping_start = now;
+
+    for (i = 0; i < state->num_primary_servers && i < AD_SRV_MAX_PINGS; i++) {
+        srv = &state->primary_servers[i];
+
+        rtt = ad_srv_rtt_lookup(state->ctx, srv->host);
+        if (rtt != NULL && now - rtt->updated < (time_t)state->ttl) {
+            continue;
+        }
+
+        /* Servers of other services are reached through LDAP as well. */
+        port = strcmp(state->service, "ldap") == 0 ? srv->port : LDAP_PORT;
+
+        subreq = ad_cldap_ping_send(state->ping_ctx, state->ev,
+                                    state->ctx->be_res,
+                                    state->ctx->host_dbs,
+                                    state->ctx->opts,
+                                    state->discovery_domain,
+                                    state->ctx->ad_use_ldaps,
+                                    srv->host, port, state->ctx);
+        if (subreq == NULL) {
+            talloc_zfree(state->ping_ctx);
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, ad_srv_plugin_ping_done, req);
+        state->pinged[i] = true;
+        state->num_pings++;
+    }
+
+    if (state->num_pings == 0) {
+        talloc_zfree(state->ping_ctx);
+        return EOK;
+    }
+
+    te = tevent_add_timer(state->ev, state->ping_ctx,
+                          tevent_timeval_current_ofs(AD_SRV_PING_TIMEOUT, 0),
+                          ad_srv_plugin_ping_timeout, req);
+    if (te == NULL) {
+        talloc_zfree(state->ping_ctx);
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Measuring round trip time of %zu servers\n",
+          state->num_pings);
+
+    return EAGAIN;
+}
+
+static void ad_srv_plugin_ping_done(struct tevent_req *subreq)
+{
+    struct ad_srv_plugin_state *state = NULL;
+    struct tevent_req *req = NULL;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ad_srv_plugin_state);
+
+    /* The round trip time was already recorded, failures only mean that
+     * the server will not be preferred. */
+    ad_cldap_ping_recv(state, subreq, NULL);
+    talloc_zfree(subreq);
+
+    state->num_pings--;
+    if (state->num_pings > 0) {
+        return;
+    }
+
+    ad_srv_plugin_finish(req);
+}
+
+static void ad_srv_plugin_ping_timeout(struct tevent_context *ev,
+                                       struct tevent_timer *te,
+                                       struct timeval tv,
+                                       void *pvt)
+{
+    struct tevent_req *req = NULL;
+    struct ad_srv_plugin_state *state = NULL;
+    struct ad_srv_rtt *rtt = NULL;
+    size_t i;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct ad_srv_plugin_state);
+
+    DEBUG(SSSDBG_MINOR_FAILURE, "%zu servers did not answer within %d "
+          "seconds\n", state->num_pings, AD_SRV_PING_TIMEOUT);
+
+    /* Forget the previous round trip time of servers that are too slow
+     * to answer now. */
+    for (i = 0; i < state->num_primary_servers && i < AD_SRV_MAX_PINGS; i++) {
+        if (!state->pinged[i]) {
+            continue;
+        }
+
+        rtt = ad_srv_rtt_lookup(state->ctx, state->primary_servers[i].host);
+        if (rtt != NULL && rtt->updated < state->ping_start) {
+            talloc_free(rtt);
+        }
+    }
+
+    ad_srv_plugin_finish(req);
+}
+
+static void ad_srv_plugin_finish(struct tevent_req *req)
+{
+    struct ad_srv_plugin_state *state = NULL;
+
+    state = tevent_req_data(req, struct ad_srv_plugin_state);
+
+    /* Cancels the remaining pings. */
+    talloc_zfree(state->ping_ctx);
+    state->num_pings = 0;
+
+    ad_sort_servers_by_rtt(state->ctx, state->primary_servers,
+                           state->num_primary_servers);
+    ad_sort_servers_by_rtt(state->ctx, state->backup_servers,
+                           state->num_backup_servers);
+
     tevent_req_done(req);
 }
 
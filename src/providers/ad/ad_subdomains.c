@@ -903,13 +903,40 @@ fail:
     return ret;
 }
 
+static errno_t ad_subdom_pvt_init(struct sdap_domain *sdom,
+                                  void *pvt_init_data,
+                                  void **_pvt)
+{
+    struct ad_subdomains_ctx *ctx;
+    struct ad_id_ctx *subdom_id_ctx;
+    errno_t ret;
+
+    ctx = talloc_get_type(pvt_init_data, struct ad_subdomains_ctx);
+
+    ret = ad_subdom_ad_ctx_new(ctx->be_ctx, ctx->ad_id_ctx, sdom->dom,
+                               &subdom_id_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "ad_subdom_ad_ctx_new failed.\n");
+        return ret;
+    }
+
+    *_pvt = subdom_id_ctx;
+    return EOK;
+}
+
+/*
+ * The ID context, failover service and connections of a trusted domain are
+ * only set up by ad_subdom_pvt_init() when the domain is used for the first
+ * time, so that forests with many trusted domains do not have to pay for
+ * the domains that are never looked up. Unused connections are closed when
+ * they expire, as for any other domain.
+ */
 static errno_t
 ads_store_sdap_subdom(struct ad_subdomains_ctx *ctx,
                       struct sss_domain_info *parent)
 {
     int ret;
     struct sdap_domain *sditer;
-    struct ad_id_ctx *subdom_id_ctx;
 
     ret = sdap_domain_subdom_add(ctx->sdap_id_ctx, ctx->sdom, parent);
     if (ret != EOK) {
@@ -926,13 +953,8 @@ ads_store_sdap_subdom(struct ad_subdomains_ctx *ctx,
 
     DLIST_FOR_EACH(sditer, ctx->sdom) {
         if (IS_SUBDOMAIN(sditer->dom) && sditer->pvt == NULL) {
-            ret = ad_subdom_ad_ctx_new(ctx->be_ctx, ctx->ad_id_ctx,
-                                       sditer->dom, &subdom_id_ctx);
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE, "ad_subdom_ad_ctx_new failed.\n");
-            } else {
-                sditer->pvt = subdom_id_ctx;
-            }
+            sditer->pvt_init = ad_subdom_pvt_init;
+            sditer->pvt_init_data = ctx;
         }
     }
 
@@ -1243,7 +1265,7 @@ ads_get_dom_id_ctx(struct be_ctx *be_ctx,
         return NULL;
     }
 
-    if (sdom->pvt == NULL) {
+    if (sdap_domain_get_pvt(sdom) == NULL) {
         ret = ad_subdom_ad_ctx_new(be_ctx, ad_id_ctx, domain,
                                    &dom_id_ctx);
         if (ret != EOK) {
@@ -111,6 +111,11 @@ struct be_ctx {
     size_t check_online_ref_count;
     int check_online_retry_delay;
 
+    /* Window over which periodic tasks of many hosts are spread and the
+     * hash of the machine ID that places this host in it. */
+    time_t ptask_spread;
+    uint32_t ptask_host_seed;
+
     struct data_provider *provider;
 
     /* Indicates whether the last state of the DP that has been logged is
@@ -213,6 +218,13 @@ void _be_fo_set_port_status(struct be_ctx *ctx,
  */
 void be_fo_try_next_server(struct be_ctx *ctx, const char *service_name);
 
+/*
+ * Set the port servers of the service without an explicit port are probed
+ * on when failover_probe_servers is enabled.
+ */
+void be_fo_set_probe_port(struct be_ctx *ctx, const char *service_name,
+                          int port);
+
 int be_fo_run_callbacks_at_next_request(struct be_ctx *ctx,
                                         const char *service_name);
 
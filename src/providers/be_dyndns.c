@@ -152,7 +152,7 @@ sss_iface_addr_list_as_str_list(TALLOC_CTX *mem_ctx,
         ai++;
     }
 
-    straddrs[count] = NULL;
+    straddrs[ai] = NULL;
     *_straddrs = straddrs;
     return EOK;
 
@@ -1218,6 +1218,7 @@ static struct dp_option default_dyndns_opts[] = {
     { "dyndns_force_tcp", DP_OPT_BOOL, BOOL_FALSE, BOOL_FALSE },
     { "dyndns_auth", DP_OPT_STRING, { "gss-tsig" }, NULL_STRING },
     { "dyndns_server", DP_OPT_STRING, NULL_STRING, NULL_STRING },
+    { "dyndns_unchanged_refresh_interval", DP_OPT_NUMBER, { .number = 604800 }, NULL_NUMBER },
 
     DP_OPTION_TERMINATOR
 };
@@ -1258,6 +1259,87 @@ be_nsupdate_init(TALLOC_CTX *mem_ctx, struct be_ctx *be_ctx,
     return ERR_OK;
 }
 
+bool
+be_nsupdate_addrs_unchanged(struct be_nsupdate_ctx *ctx,
+                            const char *hostname,
+                            struct sss_iface_addr *addresses)
+{
+    TALLOC_CTX *tmp_ctx;
+    char **straddrs;
+    char **last_only = NULL;
+    char **current_only = NULL;
+    int interval;
+    bool unchanged = false;
+    errno_t ret;
+
+    interval = dp_opt_get_int(ctx->opts,
+                              DP_OPT_DYNDNS_UNCHANGED_REFRESH_INTERVAL);
+    if (interval <= 0 || ctx->last_addrs == NULL
+            || ctx->last_update + interval <= time(NULL)
+            || hostname == NULL || ctx->last_hostname == NULL
+            || strcasecmp(hostname, ctx->last_hostname) != 0) {
+        return false;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return false;
+    }
+
+    ret = sss_iface_addr_list_as_str_list(tmp_ctx, addresses, &straddrs);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = diff_string_lists(tmp_ctx, ctx->last_addrs, straddrs,
+                            &last_only, &current_only, NULL);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    unchanged = (last_only == NULL || last_only[0] == NULL)
+                    && (current_only == NULL || current_only[0] == NULL);
+
+done:
+    talloc_free(tmp_ctx);
+    return unchanged;
+}
+
+errno_t
+be_nsupdate_set_last_update(struct be_nsupdate_ctx *ctx,
+                            const char *hostname,
+                            struct sss_iface_addr *addresses)
+{
+    char **straddrs;
+    char *name;
+    errno_t ret;
+
+    talloc_zfree(ctx->last_addrs);
+    talloc_zfree(ctx->last_hostname);
+    ctx->last_update = 0;
+
+    if (addresses == NULL || hostname == NULL) {
+        return EOK;
+    }
+
+    ret = sss_iface_addr_list_as_str_list(ctx, addresses, &straddrs);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    name = talloc_strdup(ctx, hostname);
+    if (name == NULL) {
+        talloc_free(straddrs);
+        return ENOMEM;
+    }
+
+    ctx->last_addrs = straddrs;
+    ctx->last_hostname = name;
+    ctx->last_update = time(NULL);
+
+    return EOK;
+}
+
 static bool match_ip(const struct sockaddr *sa,
                      const struct sockaddr *sb)
 {
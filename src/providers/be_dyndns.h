@@ -45,6 +45,11 @@ struct be_nsupdate_ctx {
     struct tevent_timer *refresh_timer;
     nsupdate_timer_fn_t timer_callback;
     void *timer_pvt;
+
+    /* Host name and addresses of the last successful update */
+    char *last_hostname;
+    char **last_addrs;
+    time_t last_update;
 };
 
 enum dp_dyndns_opts {
@@ -57,6 +62,7 @@ enum dp_dyndns_opts {
     DP_OPT_DYNDNS_FORCE_TCP,
     DP_OPT_DYNDNS_AUTH,
     DP_OPT_DYNDNS_SERVER,
+    DP_OPT_DYNDNS_UNCHANGED_REFRESH_INTERVAL,
 
     DP_OPT_DYNDNS /* attrs counter */
 };
@@ -80,6 +86,21 @@ sss_iface_addr_list_as_str_list(TALLOC_CTX *mem_ctx,
                                 struct sss_iface_addr *ifaddr_list,
                                 char ***_straddrs);
 
+/* Returns true if the addresses of the host were already sent to the DNS
+ * server by the last successful update and the records do not have to be
+ * refreshed yet. */
+bool
+be_nsupdate_addrs_unchanged(struct be_nsupdate_ctx *ctx,
+                            const char *hostname,
+                            struct sss_iface_addr *addresses);
+
+/* Remembers the addresses of a successful update, NULL addresses forget the
+ * last update, so that the next one is not skipped. */
+errno_t
+be_nsupdate_set_last_update(struct be_nsupdate_ctx *ctx,
+                            const char *hostname,
+                            struct sss_iface_addr *addresses);
+
 errno_t
 be_nsupdate_create_fwd_msg(TALLOC_CTX *mem_ctx, const char *realm,
                            const char *servername,
@@ -25,11 +25,17 @@
 
 #include "util/util.h"
 #include "util/crypto/sss_crypto.h"
+#include "util/sss_loop_stats.h"
+#include "shared/murmurhash3.h"
 #include "providers/backend.h"
 #include "providers/be_ptask_private.h"
 #include "providers/be_ptask.h"
 
 #define backoff_allowed(ptask) (ptask->max_backoff != 0)
+#define spread_allowed(ptask) (ptask->be_ctx->ptask_spread != 0)
+
+/* How many periods at most a task waits while the server is busy. */
+#define BE_PTASK_BUSY_MAX_FACTOR 16
 
 enum be_ptask_delay {
     BE_PTASK_FIRST_DELAY,
@@ -41,6 +47,40 @@ static void be_ptask_schedule(struct be_ptask *task,
                               enum be_ptask_delay delay_type,
                               uint32_t from);
 
+/* The server could not handle the request, wait longer before next run. */
+static void be_ptask_busy(struct be_ptask *task)
+{
+    if (!spread_allowed(task)) {
+        return;
+    }
+
+    if (task->busy_factor < BE_PTASK_BUSY_MAX_FACTOR) {
+        task->busy_factor = task->busy_factor == 0 ? 2 : task->busy_factor * 2;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Task [%s]: server is busy, next run is delayed "
+          "%u periods\n", task->name, task->busy_factor);
+}
+
+/* Stable offset of this host within the spread window, so that hosts which
+ * start at the same time do not run the same task at the same time. */
+static time_t be_ptask_host_offset(struct be_ptask *task)
+{
+    time_t window;
+
+    window = task->be_ctx->ptask_spread;
+    if (task->orig_period != 0 && task->orig_period < window) {
+        window = task->orig_period;
+    }
+
+    if (window <= 0) {
+        return 0;
+    }
+
+    return murmurhash3(task->name, strlen(task->name),
+                       task->be_ctx->ptask_host_seed) % window;
+}
+
 static int be_ptask_destructor(void *pvt)
 {
     struct be_ptask *task;
@@ -90,6 +130,7 @@ static void be_ptask_timeout(struct tevent_context *ev,
     DEBUG(SSSDBG_OP_FAILURE, "Task [%s]: timed out\n", task->name);
 
     talloc_zfree(task->req);
+    be_ptask_busy(task);
     be_ptask_schedule(task, BE_PTASK_PERIOD, BE_PTASK_SCHEDULE_FROM_NOW);
 }
 
@@ -103,6 +144,8 @@ static void be_ptask_execute(struct tevent_context *ev,
     struct be_ptask *task = NULL;
     struct tevent_timer *timeout = NULL;
 
+    SSS_LOOP_STATS_MARK();
+
     task = talloc_get_type(pvt, struct be_ptask);
     task->timer = NULL; /* timer is freed by tevent */
 
@@ -177,12 +220,17 @@ static void be_ptask_done(struct tevent_req *req)
         DEBUG(SSSDBG_TRACE_FUNC, "Task [%s]: finished successfully\n",
                                   task->name);
 
+        task->busy_factor = 0;
         be_ptask_schedule(task, BE_PTASK_PERIOD, task->flags);
         break;
     default:
         DEBUG(SSSDBG_OP_FAILURE, "Task [%s]: failed with [%d]: %s\n",
                                   task->name, ret, sss_strerror(ret));
 
+        if (ret == ERR_SERVER_BUSY || ret == ETIMEDOUT) {
+            be_ptask_busy(task);
+        }
+
         be_ptask_schedule(task, BE_PTASK_PERIOD, BE_PTASK_SCHEDULE_FROM_NOW);
         break;
     }
@@ -216,6 +264,10 @@ static void be_ptask_schedule(struct be_ptask *task,
 
         delay = task->period;
 
+        if (task->busy_factor > 1) {
+            delay *= task->busy_factor;
+        }
+
         if (backoff_allowed(task) && task->period * 2 <= task->max_backoff) {
             /* double the period for the next execution */
             task->period *= 2;
@@ -228,6 +280,13 @@ static void be_ptask_schedule(struct be_ptask *task,
         delay = delay + (sss_rand() % task->random_offset);
     }
 
+    /* Runs which many hosts may start at the same moment, after a start,
+     * going online or a busy server, are moved by the host offset. */
+    if (spread_allowed(task)
+            && (delay_type != BE_PTASK_PERIOD || task->busy_factor > 1)) {
+        delay = delay + be_ptask_host_offset(task);
+    }
+
     if(from & BE_PTASK_SCHEDULE_FROM_NOW) {
         tv = tevent_timeval_current_ofs(delay, 0);
 
@@ -414,6 +473,7 @@ void be_ptask_disable(struct be_ptask *task)
         talloc_zfree(task->timer);
         task->enabled = false;
         task->period = task->orig_period;
+        task->busy_factor = 0;
     }
 }
 
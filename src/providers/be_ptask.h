@@ -109,6 +109,11 @@ typedef errno_t
  * original value when the task is disabled. With max_backoff
  * set to zero, this feature is disabled.
  *
+ * If periodic_task_spread is set for the domain, the first run and the
+ * run after the task is reenabled are delayed by an offset derived from
+ * the machine ID and the task name, and the period is doubled, up to 16
+ * times, after every run that timed out or failed with ERR_SERVER_BUSY.
+ *
  * If an internal error occurred, the task is automatically disabled.
  */
 errno_t be_ptask_create(TALLOC_CTX *mem_ctx,
@@ -42,6 +42,7 @@ struct be_ptask {
     struct tevent_timer *timer; /* active tevent timer */
     uint32_t flags;
     bool enabled;
+    unsigned int busy_factor; /* period multiplier while the server is busy */
 };
 
 #endif /* DP_PTASK_PRIVATE_H_ */
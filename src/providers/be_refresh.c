@@ -27,81 +27,209 @@
 #include "providers/be_ptask.h"
 #include "providers/be_refresh.h"
 #include "util/util_errors.h"
+#include "util/sss_ptr_hash.h"
 #include "db/sysdb.h"
 
-static errno_t be_refresh_get_values_ex(TALLOC_CTX *mem_ctx,
-                                        struct sss_domain_info *domain,
-                                        time_t period,
-                                        struct ldb_dn *base_dn,
-                                        const char *key_attr,
-                                        const char *value_attr,
-                                        enum sysdb_cache_type search_cache,
-                                        char ***_values)
+/* The expiration times of the cached entries are kept in a min-heap per
+ * domain and refresh type. It is filled by one search of the cache when
+ * the domain is refreshed for the first time and kept up to date by sysdb
+ * whenever an expiration time is written, so a refresh only looks at the
+ * entries that are due. Users and groups stamped with an older cache
+ * generation than the domain are due as well, the queue is reloaded when
+ * the generation changes. */
+struct be_refresh_node {
+    struct be_refresh_queue *queue;
+    char *dn;
+    time_t expire;
+    size_t index;
+};
+
+struct be_refresh_queue {
+    hash_table_t *table;
+    struct be_refresh_node **heap;
+    size_t count;
+    size_t size;
+    bool loaded;
+    uint32_t generation;
+};
+
+struct be_refresh_domain {
+    struct be_refresh_queue queues[BE_REFRESH_TYPE_SENTINEL];
+};
+
+static void be_refresh_heap_swap(struct be_refresh_queue *queue,
+                                 size_t i, size_t j)
 {
-    TALLOC_CTX *tmp_ctx = NULL;
-    const char *attrs[] = {value_attr, NULL};
-    const char *filter = NULL;
-    char **values = NULL;
-    struct sysdb_attrs **records = NULL;
-    struct ldb_result *res;
-    time_t now = time(NULL);
+    struct be_refresh_node *node = queue->heap[i];
+
+    queue->heap[i] = queue->heap[j];
+    queue->heap[i]->index = i;
+    queue->heap[j] = node;
+    queue->heap[j]->index = j;
+}
+
+static void be_refresh_heap_fix(struct be_refresh_queue *queue, size_t i)
+{
+    size_t parent;
+    size_t child;
+
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (queue->heap[parent]->expire <= queue->heap[i]->expire) {
+            break;
+        }
+        be_refresh_heap_swap(queue, i, parent);
+        i = parent;
+    }
+
+    while ((child = 2 * i + 1) < queue->count) {
+        if (child + 1 < queue->count
+                && queue->heap[child + 1]->expire < queue->heap[child]->expire) {
+            child++;
+        }
+        if (queue->heap[i]->expire <= queue->heap[child]->expire) {
+            break;
+        }
+        be_refresh_heap_swap(queue, i, child);
+        i = child;
+    }
+}
+
+static int be_refresh_node_destructor(struct be_refresh_node *node)
+{
+    struct be_refresh_queue *queue = node->queue;
+    size_t i = node->index;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    queue->count--;
+    if (i != queue->count) {
+        queue->heap[i] = queue->heap[queue->count];
+        queue->heap[i]->index = i;
+        be_refresh_heap_fix(queue, i);
+    }
+
+    return 0;
+}
+
+static int be_refresh_domain_destructor(struct be_refresh_domain *rdom)
+{
+    struct be_refresh_queue *queue;
+    int i;
+
+    /* Free the nodes while the heaps still exist. */
+    for (i = 0; i < BE_REFRESH_TYPE_SENTINEL; i++) {
+        queue = &rdom->queues[i];
+        while (queue->count > 0) {
+            talloc_free(queue->heap[queue->count - 1]);
+        }
+    }
+
+    return 0;
+}
+
+static errno_t be_refresh_queue_set(struct be_refresh_queue *queue,
+                                    struct ldb_dn *dn,
+                                    time_t expire)
+{
+    struct be_refresh_node **heap;
+    struct be_refresh_node *node;
+    const char *key;
     errno_t ret;
 
-    if (key_attr == NULL || domain == NULL || base_dn == NULL) {
+    key = ldb_dn_get_casefold(dn);
+    if (key == NULL) {
         return EINVAL;
     }
 
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
-        return ENOMEM;
+    node = sss_ptr_hash_lookup(queue->table, key, struct be_refresh_node);
+    if (node != NULL) {
+        node->expire = expire;
+        be_refresh_heap_fix(queue, node->index);
+        return EOK;
     }
 
-    filter = talloc_asprintf(tmp_ctx, "(&(%s<=%lld))",
-                             key_attr, (long long) now + period);
-    if (filter == NULL) {
-        ret = ENOMEM;
-        goto done;
+    if (queue->count == queue->size) {
+        heap = talloc_realloc(queue->table, queue->heap,
+                              struct be_refresh_node *,
+                              queue->size == 0 ? 64 : queue->size * 2);
+        if (heap == NULL) {
+            return ENOMEM;
+        }
+        queue->heap = heap;
+        queue->size = talloc_array_length(heap);
     }
 
-    ret = sysdb_search_with_ts_attr(tmp_ctx, domain, base_dn,
-                                    LDB_SCOPE_SUBTREE,
-                                    search_cache,
-                                    filter, attrs,
-                                    &res);
-    if (ret != EOK) {
-        goto done;
+    node = talloc_zero(queue->table, struct be_refresh_node);
+    if (node == NULL) {
+        return ENOMEM;
     }
 
-    ret = sysdb_msg2attrs(tmp_ctx, res->count, res->msgs, &records);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Could not convert ldb message to sysdb_attrs\n");
-        goto done;
+    node->dn = talloc_strdup(node, ldb_dn_get_linearized(dn));
+    if (node->dn == NULL) {
+        talloc_free(node);
+        return ENOMEM;
     }
 
-    ret = sysdb_attrs_to_list(tmp_ctx, records, res->count, value_attr, &values);
+    ret = sss_ptr_hash_add(queue->table, key, node, struct be_refresh_node);
     if (ret != EOK) {
-        goto done;
+        talloc_free(node);
+        return ret;
     }
 
-    *_values = talloc_steal(mem_ctx, values);
-    ret = EOK;
+    node->queue = queue;
+    node->expire = expire;
+    node->index = queue->count;
+    queue->heap[queue->count] = node;
+    queue->count++;
+    talloc_set_destructor(node, be_refresh_node_destructor);
 
-done:
-    talloc_free(tmp_ctx);
+    be_refresh_heap_fix(queue, node->index);
 
-    return ret;
+    return EOK;
 }
 
-static errno_t be_refresh_get_values(TALLOC_CTX *mem_ctx,
-                                     enum be_refresh_type type,
-                                     const char *attr_name,
-                                     struct sss_domain_info *domain,
-                                     time_t period,
-                                     char ***_values)
+static void be_refresh_queue_remove(struct be_refresh_queue *queue,
+                                    struct ldb_dn *dn)
+{
+    struct be_refresh_node *node;
+    const char *key;
+
+    key = ldb_dn_get_casefold(dn);
+    if (key == NULL) {
+        return;
+    }
+
+    node = sss_ptr_hash_lookup(queue->table, key, struct be_refresh_node);
+    talloc_free(node);
+}
+
+/* Collect all nodes that expire before the limit, the heap is only walked
+ * as deep as such nodes are found. */
+static void be_refresh_queue_due(struct be_refresh_queue *queue,
+                                 size_t i,
+                                 time_t limit,
+                                 struct be_refresh_node **due,
+                                 size_t *_num_due)
+{
+    if (i >= queue->count || queue->heap[i]->expire > limit) {
+        return;
+    }
+
+    due[*_num_due] = queue->heap[i];
+    (*_num_due)++;
+
+    be_refresh_queue_due(queue, 2 * i + 1, limit, due, _num_due);
+    be_refresh_queue_due(queue, 2 * i + 2, limit, due, _num_due);
+}
+
+static errno_t be_refresh_get_type(enum be_refresh_type type,
+                                   TALLOC_CTX *mem_ctx,
+                                   struct sss_domain_info *domain,
+                                   const char **_key_attr,
+                                   struct ldb_dn **_base_dn,
+                                   enum sysdb_cache_type *_search_cache)
 {
     struct ldb_dn *base_dn = NULL;
-    errno_t ret;
     const char *key_attr;
     enum sysdb_cache_type search_cache = SYSDB_CACHE_TYPE_TIMESTAMP;
 
@@ -134,11 +262,230 @@ static errno_t be_refresh_get_values(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
-    ret = be_refresh_get_values_ex(mem_ctx, domain, period,
-                                   base_dn, key_attr,
-                                   attr_name, search_cache, _values);
+    *_key_attr = key_attr;
+    *_base_dn = base_dn;
+    *_search_cache = search_cache;
+
+    return EOK;
+}
+
+static bool be_refresh_uses_generation(enum be_refresh_type type)
+{
+    /* Netgroups are not stamped with the cache generation */
+    return type != BE_REFRESH_TYPE_NETGROUPS;
+}
+
+static errno_t be_refresh_queue_load(struct be_refresh_queue *queue,
+                                     enum be_refresh_type type,
+                                     struct sss_domain_info *domain,
+                                     uint32_t generation)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = {NULL, NULL, NULL};
+    const char *key_attr;
+    const char *filter;
+    struct ldb_dn *base_dn;
+    enum sysdb_cache_type search_cache;
+    struct ldb_result *res;
+    time_t expire;
+    unsigned int i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = be_refresh_get_type(type, tmp_ctx, domain, &key_attr, &base_dn,
+                              &search_cache);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    attrs[0] = key_attr;
+    if (be_refresh_uses_generation(type)) {
+        attrs[1] = (type == BE_REFRESH_TYPE_INITGROUPS)
+                        ? SYSDB_INITGR_GENERATION : SYSDB_CACHE_GENERATION;
+    }
+
+    filter = talloc_asprintf(tmp_ctx, "(%s=*)", key_attr);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_search_with_ts_attr(tmp_ctx, domain, base_dn,
+                                    LDB_SCOPE_SUBTREE, search_cache,
+                                    filter, attrs, &res);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    for (i = 0; i < res->count; i++) {
+        expire = ldb_msg_find_attr_as_int64(res->msgs[i], key_attr, 0);
+        if (be_refresh_uses_generation(type)
+                && sysdb_cache_generation_is_stale(res->msgs[i], key_attr,
+                                                   generation)) {
+            expire = 0;
+        }
+
+        ret = be_refresh_queue_set(queue, res->msgs[i]->dn, expire);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Loaded %u expiration times of %s into the "
+          "refresh queue of domain %s\n", res->count, key_attr, domain->name);
+
+    queue->loaded = true;
+    queue->generation = generation;
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+static errno_t be_refresh_get_values(TALLOC_CTX *mem_ctx,
+                                     struct be_refresh_queue *queue,
+                                     enum be_refresh_type type,
+                                     const char *attr_name,
+                                     struct sss_domain_info *domain,
+                                     time_t period,
+                                     char ***_values)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = {attr_name, NULL, NULL, NULL};
+    const char *key_attr;
+    const char *filter;
+    const char *value;
+    struct ldb_dn *base_dn;
+    struct ldb_dn *dn;
+    enum sysdb_cache_type search_cache;
+    struct be_refresh_node **due;
+    struct ldb_result *res;
+    size_t num_due = 0;
+    size_t num_values = 0;
+    char **values;
+    time_t now = time(NULL);
+    time_t expire;
+    uint32_t generation = 0;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = be_refresh_get_type(type, tmp_ctx, domain, &key_attr, &base_dn,
+                              &search_cache);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (be_refresh_uses_generation(type)) {
+        ret = sysdb_get_cache_generation(domain, &generation);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        if (queue->loaded && queue->generation != generation) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Cache generation of domain %s changed "
+                  "to %u, reloading the refresh queue\n",
+                  domain->name, generation);
+            queue->loaded = false;
+        }
+    }
+
+    if (!queue->loaded) {
+        ret = be_refresh_queue_load(queue, type, domain, generation);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    due = talloc_array(tmp_ctx, struct be_refresh_node *, queue->count);
+    if (due == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    be_refresh_queue_due(queue, 0, now + period, due, &num_due);
+
+    values = talloc_zero_array(tmp_ctx, char *, num_due + 1);
+    if (values == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    attrs[1] = key_attr;
+    if (be_refresh_uses_generation(type)) {
+        attrs[2] = (type == BE_REFRESH_TYPE_INITGROUPS)
+                        ? SYSDB_INITGR_GENERATION : SYSDB_CACHE_GENERATION;
+    }
+
+    filter = talloc_asprintf(tmp_ctx, "(%s=*)", key_attr);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* The queue may be out of date if a transaction was cancelled, read the
+     * current expiration time of every due entry. */
+    for (i = 0; i < num_due; i++) {
+        dn = ldb_dn_new(tmp_ctx, sysdb_ctx_get_ldb(domain->sysdb),
+                        due[i]->dn);
+        if (dn == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sysdb_search_with_ts_attr(tmp_ctx, domain, dn, LDB_SCOPE_BASE,
+                                        search_cache, filter, attrs, &res);
+        if (ret == ENOENT || (ret == EOK && res->count != 1)) {
+            /* the entry was removed */
+            talloc_free(due[i]);
+            continue;
+        } else if (ret != EOK) {
+            goto done;
+        }
+
+        expire = ldb_msg_find_attr_as_int64(res->msgs[0], key_attr, 0);
+        if (expire > now + period
+                && (!be_refresh_uses_generation(type)
+                    || !sysdb_cache_generation_is_stale(res->msgs[0], key_attr,
+                                                        generation))) {
+            due[i]->expire = expire;
+            be_refresh_heap_fix(queue, due[i]->index);
+            continue;
+        }
+
+        /* If the refresh fails the entry is tried again next time. */
+        due[i]->expire = now + period;
+        be_refresh_heap_fix(queue, due[i]->index);
+
+        value = ldb_msg_find_attr_as_string(res->msgs[0], attr_name, NULL);
+        if (value == NULL) {
+            continue;
+        }
+
+        values[num_values] = talloc_strdup(values, value);
+        if (values[num_values] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        num_values++;
+    }
+
+    *_values = talloc_steal(mem_ctx, values);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
 
-    talloc_free(base_dn);
     return ret;
 }
 
@@ -151,8 +498,153 @@ struct be_refresh_cb_ctx {
 
 struct be_refresh_ctx {
     struct be_refresh_cb_ctx callbacks[BE_REFRESH_TYPE_SENTINEL];
+
+    /* how many refresh types and domains are refreshed at once */
+    int concurrency;
+
+    /* domain name -> struct be_refresh_domain */
+    hash_table_t *domains;
+    struct sysdb_ctx *sysdb;
 };
 
+static struct be_refresh_domain *
+be_refresh_get_domain(struct be_refresh_ctx *ctx,
+                      const char *name,
+                      bool create)
+{
+    struct be_refresh_domain *rdom;
+    errno_t ret;
+    int i;
+
+    rdom = sss_ptr_hash_lookup(ctx->domains, name, struct be_refresh_domain);
+    if (rdom != NULL || !create) {
+        return rdom;
+    }
+
+    rdom = talloc_zero(ctx->domains, struct be_refresh_domain);
+    if (rdom == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < BE_REFRESH_TYPE_SENTINEL; i++) {
+        rdom->queues[i].table = sss_ptr_hash_create(rdom, NULL, NULL);
+        if (rdom->queues[i].table == NULL) {
+            talloc_free(rdom);
+            return NULL;
+        }
+    }
+
+    ret = sss_ptr_hash_add(ctx->domains, name, rdom,
+                           struct be_refresh_domain);
+    if (ret != EOK) {
+        talloc_free(rdom);
+        return NULL;
+    }
+
+    talloc_set_destructor(rdom, be_refresh_domain_destructor);
+
+    return rdom;
+}
+
+static bool be_refresh_dn_val_equal(const struct ldb_val *val,
+                                    const char *str)
+{
+    return val != NULL && val->length == strlen(str)
+           && strncasecmp((const char *)val->data, str, val->length) == 0;
+}
+
+/* Cached users, groups and netgroups are stored as
+ * name=<name>,cn=<container>,cn=<domain>,cn=sysdb */
+static void be_refresh_expire_notify(struct ldb_dn *dn,
+                                     const char *attr,
+                                     time_t expire,
+                                     void *pvt)
+{
+    struct be_refresh_ctx *ctx;
+    struct be_refresh_domain *rdom;
+    const struct ldb_val *container;
+    const struct ldb_val *domain;
+    enum be_refresh_type types[2];
+    size_t num_types = 0;
+    char *name;
+    errno_t ret;
+    size_t i;
+
+    ctx = talloc_get_type(pvt, struct be_refresh_ctx);
+    if (ctx == NULL || ldb_dn_get_comp_num(dn) != 4) {
+        return;
+    }
+
+    container = ldb_dn_get_component_val(dn, 1);
+    if (be_refresh_dn_val_equal(container, "users")) {
+        if (attr == NULL || strcmp(attr, SYSDB_INITGR_EXPIRE) == 0) {
+            types[num_types++] = BE_REFRESH_TYPE_INITGROUPS;
+        }
+        if (attr == NULL || strcmp(attr, SYSDB_CACHE_EXPIRE) == 0) {
+            types[num_types++] = BE_REFRESH_TYPE_USERS;
+        }
+    } else if (be_refresh_dn_val_equal(container, "groups")) {
+        if (attr == NULL || strcmp(attr, SYSDB_CACHE_EXPIRE) == 0) {
+            types[num_types++] = BE_REFRESH_TYPE_GROUPS;
+        }
+    } else if (be_refresh_dn_val_equal(container, "Netgroups")) {
+        if (attr == NULL || strcmp(attr, SYSDB_CACHE_EXPIRE) == 0) {
+            types[num_types++] = BE_REFRESH_TYPE_NETGROUPS;
+        }
+    }
+
+    if (num_types == 0) {
+        return;
+    }
+
+    domain = ldb_dn_get_component_val(dn, 2);
+    if (domain == NULL) {
+        return;
+    }
+
+    name = talloc_strndup(NULL, (const char *)domain->data, domain->length);
+    if (name == NULL) {
+        return;
+    }
+
+    /* The queues are filled when the domain is refreshed for the first
+     * time. */
+    rdom = be_refresh_get_domain(ctx, name, false);
+    talloc_free(name);
+    if (rdom == NULL) {
+        return;
+    }
+
+    for (i = 0; i < num_types; i++) {
+        if (!rdom->queues[types[i]].loaded) {
+            continue;
+        }
+
+        if (attr == NULL) {
+            be_refresh_queue_remove(&rdom->queues[types[i]], dn);
+            continue;
+        }
+
+        ret = be_refresh_queue_set(&rdom->queues[types[i]], dn, expire);
+        if (ret != EOK) {
+            /* Load the queue again during the next refresh. */
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to queue %s for refresh "
+                  "[%d]: %s\n", ldb_dn_get_linearized(dn),
+                  ret, sss_strerror(ret));
+            rdom->queues[types[i]].loaded = false;
+        }
+    }
+}
+
+static int be_refresh_ctx_destructor(struct be_refresh_ctx *ctx)
+{
+    if (ctx->sysdb != NULL) {
+        sysdb_set_expire_notify(ctx->sysdb, NULL, NULL);
+    }
+
+    return 0;
+}
+
 static errno_t be_refresh_ctx_init(struct be_ctx *be_ctx,
                                    const char *attr_name)
 {
@@ -165,6 +657,28 @@ static errno_t be_refresh_ctx_init(struct be_ctx *be_ctx,
         return ENOMEM;
     }
 
+    ctx->domains = sss_ptr_hash_create(ctx, NULL, NULL);
+    if (ctx->domains == NULL) {
+        talloc_free(ctx);
+        return ENOMEM;
+    }
+
+    ret = confdb_get_int(be_ctx->cdb, be_ctx->conf_path,
+                         CONFDB_DOMAIN_REFRESH_EXPIRED_CONCURRENCY, 1,
+                         &ctx->concurrency);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to get the value of %s\n",
+              CONFDB_DOMAIN_REFRESH_EXPIRED_CONCURRENCY);
+        talloc_free(ctx);
+        return ret;
+    }
+
+    if (ctx->concurrency < 1) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "%s must be at least 1, using 1\n",
+              CONFDB_DOMAIN_REFRESH_EXPIRED_CONCURRENCY);
+        ctx->concurrency = 1;
+    }
+
     ctx->callbacks[BE_REFRESH_TYPE_INITGROUPS].name = "initgroups";
     ctx->callbacks[BE_REFRESH_TYPE_INITGROUPS].attr_name = SYSDB_NAME;
     ctx->callbacks[BE_REFRESH_TYPE_USERS].name = "users";
@@ -192,6 +706,10 @@ static errno_t be_refresh_ctx_init(struct be_ctx *be_ctx,
         }
     }
 
+    ctx->sysdb = be_ctx->domain->sysdb;
+    sysdb_set_expire_notify(ctx->sysdb, be_refresh_expire_notify, ctx);
+    talloc_set_destructor(ctx, be_refresh_ctx_destructor);
+
     be_ctx->refresh_ctx = ctx;
     return EOK;
 }
@@ -286,31 +804,41 @@ errno_t be_refresh_ctx_init_with_callbacks(struct be_ctx *be_ctx,
     return EOK;
 }
 
-struct be_refresh_state {
-    struct tevent_context *ev;
-    struct be_ctx *be_ctx;
-    struct be_refresh_ctx *ctx;
+/* Refresh of one type of entries in one domain. */
+struct be_refresh_job {
+    struct tevent_req *req;
     struct be_refresh_cb_ctx *cb_ctx;
-
     struct sss_domain_info *domain;
-    enum be_refresh_type index;
-    time_t period;
+    enum be_refresh_type type;
 
     char **refresh_values;
     size_t refresh_val_size;
     size_t refresh_index;
 
-    size_t batch_size;
     char **refresh_batch;
 };
 
-static errno_t be_refresh_batch_step(struct tevent_req *req,
+struct be_refresh_state {
+    struct tevent_context *ev;
+    struct be_ctx *be_ctx;
+    struct be_refresh_ctx *ctx;
+    time_t period;
+    size_t batch_size;
+
+    struct be_refresh_job *jobs;
+    size_t num_jobs;
+    size_t next_job;
+    size_t active_jobs;
+};
+
+static errno_t be_refresh_add_jobs(struct be_refresh_state *state);
+static errno_t be_refresh_dispatch(struct tevent_req *req);
+static errno_t be_refresh_batch_step(struct be_refresh_job *job,
                                      uint32_t msec_delay);
 static void be_refresh_batch_step_wakeup(struct tevent_context *ev,
                                          struct tevent_timer *tt,
                                          struct timeval tv,
                                          void *pvt);
-static errno_t be_refresh_step(struct tevent_req *req);
 static void be_refresh_done(struct tevent_req *subreq);
 
 struct tevent_req *be_refresh_send(TALLOC_CTX *mem_ctx,
@@ -332,7 +860,6 @@ struct tevent_req *be_refresh_send(TALLOC_CTX *mem_ctx,
 
     state->ev = ev;
     state->be_ctx = be_ctx;
-    state->domain = be_ctx->domain;
     state->period = be_ptask_get_period(be_ptask);
     state->ctx = talloc_get_type(pvt, struct be_refresh_ctx);
     if (state->ctx == NULL) {
@@ -341,17 +868,17 @@ struct tevent_req *be_refresh_send(TALLOC_CTX *mem_ctx,
     }
 
     state->batch_size = 200;
-    state->refresh_batch = talloc_zero_array(state, char *, state->batch_size+1);
-    if (state->refresh_batch == NULL) {
-        ret = ENOMEM;
+
+    ret = be_refresh_add_jobs(state);
+    if (ret != EOK) {
         goto immediately;
     }
 
-    ret = be_refresh_step(req);
+    ret = be_refresh_dispatch(req);
     if (ret == EOK) {
         goto immediately;
     } else if (ret != EAGAIN) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "be_refresh_step() failed [%d]: %s\n",
+        DEBUG(SSSDBG_CRIT_FAILURE, "be_refresh_dispatch() failed [%d]: %s\n",
                                     ret, sss_strerror(ret));
         goto immediately;
     }
@@ -369,112 +896,172 @@ immediately:
     return req;
 }
 
-static errno_t be_refresh_step(struct tevent_req *req)
+/* The domain of the backend and its subdomains are refreshed. */
+static struct sss_domain_info *
+be_refresh_next_domain(struct sss_domain_info *domain)
+{
+    domain = get_next_domain(domain, SSS_GND_DESCEND);
+    if (domain != NULL && !IS_SUBDOMAIN(domain)) {
+        return NULL;
+    }
+
+    return domain;
+}
+
+static errno_t be_refresh_add_jobs(struct be_refresh_state *state)
+{
+    struct sss_domain_info *domain;
+    struct be_refresh_job *job;
+    size_t num_domains = 0;
+    int i;
+
+    for (domain = state->be_ctx->domain; domain != NULL;
+         domain = be_refresh_next_domain(domain)) {
+        num_domains++;
+    }
+
+    state->jobs = talloc_zero_array(state, struct be_refresh_job,
+                                    num_domains * BE_REFRESH_TYPE_SENTINEL);
+    if (state->jobs == NULL) {
+        return ENOMEM;
+    }
+
+    for (domain = state->be_ctx->domain; domain != NULL;
+         domain = be_refresh_next_domain(domain)) {
+        for (i = 0; i < BE_REFRESH_TYPE_SENTINEL; i++) {
+            if (!state->ctx->callbacks[i].enabled) {
+                continue;
+            }
+
+            if (state->ctx->callbacks[i].cb.send_fn == NULL
+                    || state->ctx->callbacks[i].cb.recv_fn == NULL) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Invalid parameters!\n");
+                return ERR_INTERNAL;
+            }
+
+            job = &state->jobs[state->num_jobs];
+            job->cb_ctx = &state->ctx->callbacks[i];
+            job->domain = domain;
+            job->type = i;
+            state->num_jobs++;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t be_refresh_start_job(struct tevent_req *req,
+                                    struct be_refresh_job *job)
 {
     struct be_refresh_state *state = NULL;
+    struct be_refresh_domain *rdom;
     errno_t ret;
 
     state = tevent_req_data(req, struct be_refresh_state);
 
-    while (state->domain != NULL) {
-        /* find first enabled callback */
-        state->cb_ctx = &state->ctx->callbacks[state->index];
-        while (state->index != BE_REFRESH_TYPE_SENTINEL
-                && !state->cb_ctx->enabled) {
-            state->index++;
-            state->cb_ctx = &state->ctx->callbacks[state->index];
-        }
+    job->req = req;
 
-        /* if not found than continue with next domain */
-        if (state->index == BE_REFRESH_TYPE_SENTINEL) {
-            state->domain = get_next_domain(state->domain,
-                                            SSS_GND_DESCEND);
-            /* we can update just subdomains */
-            if (state->domain != NULL && !IS_SUBDOMAIN(state->domain)) {
-                break;
-            }
-            state->index = 0;
-            continue;
-        }
+    rdom = be_refresh_get_domain(state->ctx, job->domain->name, true);
+    if (rdom == NULL) {
+        return ENOMEM;
+    }
 
-        if (state->cb_ctx->cb.send_fn == NULL
-                || state->cb_ctx->cb.recv_fn == NULL) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Invalid parameters!\n");
-            ret = ERR_INTERNAL;
-            goto done;
-        }
+    ret = be_refresh_get_values(state->jobs, &rdom->queues[job->type],
+                                job->type,
+                                job->cb_ctx->attr_name,
+                                job->domain, state->period,
+                                &job->refresh_values);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to obtain DN list [%d]: %s\n",
+                                    ret, sss_strerror(ret));
+        return ret;
+    }
 
-        talloc_zfree(state->refresh_values);
-        ret = be_refresh_get_values(state, state->index,
-                                    state->cb_ctx->attr_name,
-                                    state->domain, state->period,
-                                    &state->refresh_values);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to obtain DN list [%d]: %s\n",
-                                        ret, sss_strerror(ret));
-            goto done;
-        }
+    for (job->refresh_val_size = 0;
+         job->refresh_values[job->refresh_val_size] != NULL;
+         job->refresh_val_size++);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Refreshing %zu %s in domain %s\n",
+          job->refresh_val_size,
+          job->cb_ctx->name,
+          job->domain->name);
 
-        for (state->refresh_val_size = 0;
-             state->refresh_values[state->refresh_val_size] != NULL;
-             state->refresh_val_size++);
+    if (job->refresh_val_size == 0) {
+        talloc_zfree(job->refresh_values);
+        return EOK;
+    }
+
+    job->refresh_batch = talloc_zero_array(job->refresh_values, char *,
+                                           state->batch_size + 1);
+    if (job->refresh_batch == NULL) {
+        return ENOMEM;
+    }
 
-        DEBUG(SSSDBG_TRACE_FUNC, "Refreshing %zu %s in domain %s\n",
-              state->refresh_val_size,
-              state->cb_ctx->name,
-              state->domain->name);
+    return be_refresh_batch_step(job, 0);
+}
 
-        ret = be_refresh_batch_step(req, 0);
-        if (ret == EOK) {
-            state->index++;
+/* Start jobs until refresh_expired_concurrency of them are in progress.
+ * Returns EOK when all jobs are finished. */
+static errno_t be_refresh_dispatch(struct tevent_req *req)
+{
+    struct be_refresh_state *state = NULL;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct be_refresh_state);
+
+    while (state->active_jobs < state->ctx->concurrency
+            && state->next_job < state->num_jobs) {
+        ret = be_refresh_start_job(req, &state->jobs[state->next_job]);
+        state->next_job++;
+        if (ret == EAGAIN) {
+            state->active_jobs++;
             continue;
-        } else if (ret != EAGAIN) {
-            goto done;
+        } else if (ret != EOK) {
+            return ret;
         }
-        /* EAGAIN only, refreshing something.. */
-
-        state->index++;
-        goto done;
     }
 
-    ret = EOK;
+    if (state->active_jobs > 0) {
+        return EAGAIN;
+    }
 
-done:
-    return ret;
+    return EOK;
 }
 
-static errno_t be_refresh_batch_step(struct tevent_req *req,
+static errno_t be_refresh_batch_step(struct be_refresh_job *job,
                                      uint32_t msec_delay)
 {
-    struct be_refresh_state *state = tevent_req_data(req, struct be_refresh_state);
+    struct be_refresh_state *state = tevent_req_data(job->req,
+                                                     struct be_refresh_state);
     struct timeval tv;
     struct tevent_timer *timeout = NULL;
 
     size_t remaining;
     size_t batch_size;
 
-    memset(state->refresh_batch, 0, sizeof(char *) * state->batch_size);
+    memset(job->refresh_batch, 0, sizeof(char *) * state->batch_size);
 
-    if (state->refresh_index >= state->refresh_val_size) {
+    if (job->refresh_index >= job->refresh_val_size) {
         DEBUG(SSSDBG_FUNC_DATA, "The batch is done\n");
-        state->refresh_index = 0;
+        talloc_zfree(job->refresh_values);
+        job->refresh_batch = NULL;
         return EOK;
     }
 
-    remaining = state->refresh_val_size - state->refresh_index;
+    remaining = job->refresh_val_size - job->refresh_index;
     batch_size = MIN(remaining, state->batch_size);
     DEBUG(SSSDBG_FUNC_DATA,
           "This batch will refresh %zu entries (so far %zu/%zu)\n",
-          batch_size, state->refresh_index, state->refresh_val_size);
+          batch_size, job->refresh_index, job->refresh_val_size);
 
     for (size_t i = 0; i < batch_size; i++) {
-        state->refresh_batch[i] = state->refresh_values[state->refresh_index];
-        state->refresh_index++;
+        job->refresh_batch[i] = job->refresh_values[job->refresh_index];
+        job->refresh_index++;
     }
 
     tv = tevent_timeval_current_ofs(0, msec_delay * 1000);
-    timeout = tevent_add_timer(state->be_ctx->ev, req, tv,
-                               be_refresh_batch_step_wakeup, req);
+    timeout = tevent_add_timer(state->be_ctx->ev, job->refresh_values, tv,
+                               be_refresh_batch_step_wakeup, job);
     if (timeout == NULL) {
         return ENOMEM;
     }
@@ -487,41 +1074,76 @@ static void be_refresh_batch_step_wakeup(struct tevent_context *ev,
                                          struct timeval tv,
                                          void *pvt)
 {
-    struct tevent_req *req;
+    struct be_refresh_job *job;
     struct tevent_req *subreq = NULL;
     struct be_refresh_state *state = NULL;
 
-    req = talloc_get_type(pvt, struct tevent_req);
-    state = tevent_req_data(req, struct be_refresh_state);
+    job = (struct be_refresh_job *)pvt;
+    state = tevent_req_data(job->req, struct be_refresh_state);
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Issuing refresh\n");
-    subreq = state->cb_ctx->cb.send_fn(state, state->ev, state->be_ctx,
-                                       state->domain,
-                                       state->refresh_batch,
-                                       state->cb_ctx->cb.pvt);
+    subreq = job->cb_ctx->cb.send_fn(job->refresh_values, state->ev,
+                                     state->be_ctx,
+                                     job->domain,
+                                     job->refresh_batch,
+                                     job->cb_ctx->cb.pvt);
     if (subreq == NULL) {
-        tevent_req_error(req, ENOMEM);
+        tevent_req_error(job->req, ENOMEM);
         return;
     }
-    tevent_req_set_callback(subreq, be_refresh_done, req);
+    tevent_req_set_callback(subreq, be_refresh_done, job);
+}
+
+/* Records in the NSS memory cache are not updated by the refresh, let the
+ * responder drop the whole batch at once instead of serving the old data
+ * until the records expire. */
+static void be_refresh_invalidate_memcache(struct be_refresh_state *state,
+                                           struct be_refresh_job *job)
+{
+    const char **users = NULL;
+    const char **groups = NULL;
+
+    if (strcmp(job->cb_ctx->attr_name, SYSDB_NAME) != 0) {
+        /* the values are not names, e.g. SIDs */
+        return;
+    }
+
+    switch (job->type) {
+    case BE_REFRESH_TYPE_INITGROUPS:
+    case BE_REFRESH_TYPE_USERS:
+        users = discard_const(job->refresh_batch);
+        break;
+    case BE_REFRESH_TYPE_GROUPS:
+        groups = discard_const(job->refresh_batch);
+        break;
+    default:
+        return;
+    }
+
+    dp_sbus_invalidate_memcache_batch(state->be_ctx->provider, job->domain,
+                                      users, groups);
 }
 
 static void be_refresh_done(struct tevent_req *subreq)
 {
     struct be_refresh_state *state = NULL;
+    struct be_refresh_job *job;
     struct tevent_req *req = NULL;
     errno_t ret;
 
-    req = tevent_req_callback_data(subreq, struct tevent_req);
+    job = tevent_req_callback_data(subreq, struct be_refresh_job);
+    req = job->req;
     state = tevent_req_data(req, struct be_refresh_state);
 
-    ret = state->cb_ctx->cb.recv_fn(subreq);
+    ret = job->cb_ctx->cb.recv_fn(subreq);
     talloc_zfree(subreq);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = be_refresh_batch_step(req, 500);
+    be_refresh_invalidate_memcache(state, job);
+
+    ret = be_refresh_batch_step(job, 500);
     if (ret == EAGAIN) {
         DEBUG(SSSDBG_TRACE_INTERNAL,
               "Another batch in this step in progress\n");
@@ -533,10 +1155,12 @@ static void be_refresh_done(struct tevent_req *subreq)
         goto done;
     }
 
-    DEBUG(SSSDBG_TRACE_INTERNAL, "All batches in this step refreshed\n");
+    DEBUG(SSSDBG_TRACE_INTERNAL, "All batches of %s in domain %s refreshed\n",
+          job->cb_ctx->name, job->domain->name);
 
-    /* Proceed to the next step */
-    ret = be_refresh_step(req);
+    /* Proceed to the next job */
+    state->active_jobs--;
+    ret = be_refresh_dispatch(req);
     if (ret == EAGAIN) {
         DEBUG(SSSDBG_TRACE_INTERNAL, "Another step in progress\n");
         return;
@@ -138,6 +138,9 @@
 #define DP_WILDCARD "wildcard"
 #define DP_WILDCARD_LEN (sizeof(DP_WILDCARD) - 1)
 
+/* Maximum number of filters in one getAccountInfoBatch request. */
+#define DP_ACCOUNT_BATCH_MAX 256
+
 #define EXTRA_NAME_IS_UPN "U"
 #define EXTRA_INPUT_MAYBE_WITH_VIEW "V"
 
@@ -150,6 +153,7 @@
 
 #define SSS_KRB5_INFO_TGT_LIFETIME (SSS_SERVER_INFO|SSS_KRB5_INFO|0x01)
 #define SSS_KRB5_INFO_UPN (SSS_SERVER_INFO|SSS_KRB5_INFO|0x02)
+#define SSS_KRB5_INFO_KDC_TIME (SSS_SERVER_INFO|SSS_KRB5_INFO|0x03)
 
 bool dp_pack_pam_request(DBusMessage *msg, struct pam_data *pd);
 bool dp_unpack_pam_request(DBusMessage *msg, TALLOC_CTX *mem_ctx,
@@ -268,6 +272,7 @@ enum dp_res_opts {
     DP_RES_OPT_RESOLVER_OP_TIMEOUT,
     DP_RES_OPT_RESOLVER_SERVER_TIMEOUT,
     DP_RES_OPT_DNS_DOMAIN,
+    DP_RES_OPT_CACHE_TIMEOUT,
 
     DP_RES_OPTS /* attrs counter */
 };
@@ -45,7 +45,8 @@ dp_init_interface(struct data_provider *provider)
     SBUS_INTERFACE(iface_dp_backend,
         sssd_DataProvider_Backend,
         SBUS_METHODS(
-            SBUS_SYNC(METHOD, sssd_DataProvider_Backend, IsOnline, dp_backend_is_online, provider->be_ctx)
+            SBUS_SYNC(METHOD, sssd_DataProvider_Backend, IsOnline, dp_backend_is_online, provider->be_ctx),
+            SBUS_SYNC(METHOD, sssd_DataProvider_Backend, CleanupProgress, dp_backend_cleanup_progress, provider->be_ctx)
         ),
         SBUS_SIGNALS(SBUS_NO_SIGNALS),
         SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
@@ -91,6 +92,7 @@ dp_init_interface(struct data_provider *provider)
             SBUS_ASYNC(METHOD, sssd_dataprovider, resolverHandler, dp_resolver_handler_send, dp_resolver_handler_recv, provider),
             SBUS_ASYNC(METHOD, sssd_dataprovider, getDomains, dp_subdomains_handler_send, dp_subdomains_handler_recv, provider),
             SBUS_ASYNC(METHOD, sssd_dataprovider, getAccountInfo, dp_get_account_info_send, dp_get_account_info_recv, provider),
+            SBUS_ASYNC(METHOD, sssd_dataprovider, getAccountInfoBatch, dp_get_account_info_batch_send, dp_get_account_info_batch_recv, provider),
             SBUS_ASYNC(METHOD, sssd_dataprovider, getAccountDomain, dp_get_account_domain_send, dp_get_account_domain_recv, provider)
         ),
         SBUS_SIGNALS(SBUS_NO_SIGNALS),
@@ -177,6 +179,15 @@ dp_init_send(TALLOC_CTX *mem_ctx,
     state->provider->gid = gid;
     state->provider->be_ctx = be_ctx;
 
+    ret = confdb_get_int(be_ctx->cdb, be_ctx->conf_path,
+                         CONFDB_DOMAIN_ACCESS_CACHE_TIMEOUT, 0,
+                         &state->provider->access_cache.timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read %s [%d]: %s\n",
+              CONFDB_DOMAIN_ACCESS_CACHE_TIMEOUT, ret, sss_strerror(ret));
+        goto done;
+    }
+
     state->sbus_name = sss_iface_domain_bus(state, be_ctx->domain);
     if (state->sbus_name == NULL) {
         DEBUG(SSSDBG_FATAL_FAILURE, "Could not get sbus backend name.\n");
@@ -238,6 +249,19 @@ static void dp_init_done(struct tevent_req *subreq)
     sbus_server_set_on_connection(state->provider->sbus_server,
                                   dp_client_init, state->provider);
 
+    /* Authentication is interactive, do not let it wait behind lookups. */
+    ret = sbus_server_set_priority(state->provider->sbus_server,
+                                   "sssd.dataprovider", "pamHandler");
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_connection_set_priority(state->provider->sbus_conn,
+                                       "sssd.dataprovider", "pamHandler");
+    if (ret != EOK) {
+        goto done;
+    }
+
     /* be_ctx->provider must be accessible from modules and targets */
     state->be_ctx->provider = talloc_steal(state->be_ctx, state->provider);
 
@@ -182,6 +182,14 @@ bool dp_method_enabled(struct data_provider *provider,
 void dp_terminate_domain_requests(struct data_provider *provider,
                                   const char *domain);
 
+/* Access providers whose decision depends on state that changes between
+ * two logins, such as account lockout, call this during initialization so
+ * that allowed access is never remembered. */
+void dp_access_cache_bypass(struct data_provider *provider);
+
+/* Forget all remembered access decisions. */
+void dp_access_cache_flush(struct data_provider *provider);
+
 void dp_sbus_domain_active(struct data_provider *provider,
                            struct sss_domain_info *dom);
 void dp_sbus_domain_inconsistent(struct data_provider *provider,
@@ -196,7 +204,12 @@ void dp_sbus_reset_users_memcache(struct data_provider *provider);
 void dp_sbus_reset_groups_memcache(struct data_provider *provider);
 void dp_sbus_reset_initgr_memcache(struct data_provider *provider);
 void dp_sbus_invalidate_group_memcache(struct data_provider *provider,
+                                       struct sss_domain_info *dom,
                                        gid_t gid);
+void dp_sbus_invalidate_memcache_batch(struct data_provider *provider,
+                                       struct sss_domain_info *dom,
+                                       const char **users,
+                                       const char **groups);
 
 /*
  * A dummy handler for DPM_ACCT_DOMAIN_HANDLER.
@@ -34,7 +34,9 @@ dp_get_account_info_send(TALLOC_CTX *mem_ctx,
                          uint32_t entry_type,
                          const char *filter,
                          const char *domain,
-                         const char *extra);
+                         const char *extra,
+                         uint64_t trace_id,
+                         uint64_t parent_span_id);
 
 errno_t
 dp_get_account_info_recv(TALLOC_CTX *mem_ctx,
@@ -43,6 +45,24 @@ dp_get_account_info_recv(TALLOC_CTX *mem_ctx,
                          uint32_t *_error,
                          const char **_err_msg);
 
+struct tevent_req *
+dp_get_account_info_batch_send(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               struct sbus_request *sbus_req,
+                               struct data_provider *provider,
+                               uint32_t dp_flags,
+                               uint32_t entry_type,
+                               const char **filters,
+                               const char *domain,
+                               const char *extra);
+
+errno_t
+dp_get_account_info_batch_recv(TALLOC_CTX *mem_ctx,
+                               struct tevent_req *req,
+                               uint16_t **_dp_errors,
+                               uint32_t **_errors,
+                               const char ***_err_msgs);
+
 struct tevent_req *
 dp_pam_handler_send(TALLOC_CTX *mem_ctx,
                     struct tevent_context *ev,
@@ -203,6 +223,13 @@ errno_t dp_backend_is_online(TALLOC_CTX *mem_ctx,
                              const char *domname,
                              bool *_is_online);
 
+errno_t dp_backend_cleanup_progress(TALLOC_CTX *mem_ctx,
+                                    struct sbus_request *sbus_req,
+                                    struct be_ctx *be_ctx,
+                                    const char *domname,
+                                    uint32_t *_processed,
+                                    uint32_t *_total);
+
 /* sssd.DataProvider.Failover */
 errno_t
 dp_failover_list_services(TALLOC_CTX *mem_ctx,
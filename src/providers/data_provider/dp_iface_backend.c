@@ -57,3 +57,28 @@ dp_backend_is_online(TALLOC_CTX *mem_ctx,
 
     return EOK;
 }
+
+errno_t
+dp_backend_cleanup_progress(TALLOC_CTX *mem_ctx,
+                            struct sbus_request *sbus_req,
+                            struct be_ctx *be_ctx,
+                            const char *domname,
+                            uint32_t *_processed,
+                            uint32_t *_total)
+{
+    struct sss_domain_info *domain;
+
+    if (SBUS_REQ_STRING_IS_EMPTY(domname)) {
+        domain = be_ctx->domain;
+    } else {
+        domain = find_domain_by_name(be_ctx->domain, domname, false);
+        if (domain == NULL) {
+            return ERR_DOMAIN_NOT_FOUND;
+        }
+    }
+
+    *_processed = domain->cleanup_processed;
+    *_total = domain->cleanup_total;
+
+    return EOK;
+}
@@ -43,6 +43,8 @@ enum dp_clients {
 };
 
 struct dp_req;
+struct dp_req_queued;
+struct dp_gid_queue;
 struct dp_client;
 
 struct dp_module {
@@ -61,6 +63,13 @@ struct dp_target {
     enum dp_targets target;
     struct dp_module *module;
     struct dp_method *methods;
+
+    /* Requests of this target that may run at the same time, 0 means no
+     * limit. Other requests wait in the queue in order of arrival. */
+    uint32_t max_requests;
+    uint32_t num_running;
+    struct dp_req_queued *queue;
+    struct tevent_timer *queue_te;
 };
 
 struct dp_method {
@@ -90,10 +99,29 @@ struct data_provider {
         /* List of all ongoing requests. */
         uint32_t num_active;
         struct dp_req *active;
+
+        /* Requests whose result is shared with other callers, indexed by
+         * the key provided by the caller. */
+        hash_table_t *shared;
+
+        /* Number of callers that joined another request instead of
+         * starting their own. */
+        uint32_t num_joined;
     } requests;
 
     struct dp_module **modules;
     struct dp_target **targets;
+
+    /* Groups to invalidate in memory cache, sent in one batch per domain. */
+    struct dp_gid_queue *gid_queue;
+    struct tevent_timer *gid_queue_te;
+
+    /* Recently allowed PAM account requests, see dp_target_auth.c. */
+    struct {
+        hash_table_t *table;
+        int timeout;
+        bool bypass;
+    } access_cache;
 };
 
 errno_t dp_find_method(struct data_provider *provider,
@@ -25,6 +25,9 @@
 #include "providers/data_provider/dp_private.h"
 #include "providers/backend.h"
 #include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "util/sss_trace.h"
+#include "util/sss_metrics.h"
 #include "util/util.h"
 #include "util/probes.h"
 
@@ -43,12 +46,27 @@ struct dp_req {
     struct tevent_req *req;
     struct tevent_req *handler_req;
     void *request_data;
+    struct dp_req_params *params;
+
+    /* Set while the handler holds a slot of the target. */
+    bool running;
+
+    /* Set while the request waits until the target has a free slot. */
+    struct dp_req_queued *queued;
 
     /* Active request list. */
     struct dp_req *prev;
     struct dp_req *next;
 };
 
+struct dp_req_queued {
+    struct dp_target *target;
+    struct dp_req *dp_req;
+
+    struct dp_req_queued *prev;
+    struct dp_req_queued *next;
+};
+
 static bool check_data_type(const char *expected,
                             const char *description,
                             void *ptr)
@@ -81,8 +99,108 @@ static bool check_method_data(struct dp_method *method,
     return true;
 }
 
+static struct dp_target *dp_req_target(struct dp_req *dp_req)
+{
+    return dp_req->provider->targets[dp_req->target];
+}
+
+static void dp_req_queue_handler(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval tv,
+                                 void *pvt);
+
+/* Give the slot of a finished handler to the next queued request. */
+static void dp_req_release(struct dp_req *dp_req)
+{
+    struct dp_target *target;
+    struct timeval tv;
+
+    if (!dp_req->running) {
+        return;
+    }
+
+    target = dp_req_target(dp_req);
+    dp_req->running = false;
+    target->num_running--;
+
+    if (target->queue == NULL || target->queue_te != NULL) {
+        return;
+    }
+
+    /* The next handler is not started from the context of this one since
+     * we may be in a destructor. */
+    tv = tevent_timeval_current();
+    target->queue_te = tevent_add_timer(dp_req->provider->ev, target, tv,
+                                        dp_req_queue_handler, target);
+    if (target->queue_te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule queued requests of "
+              "target [%s]!\n", target->name);
+    }
+}
+
+static int dp_req_queued_destructor(struct dp_req_queued *item)
+{
+    DLIST_REMOVE(item->target->queue, item);
+    item->dp_req->queued = NULL;
+
+    return 0;
+}
+
+static void dp_req_done(struct tevent_req *subreq);
+
+static errno_t dp_req_run(struct dp_req *dp_req)
+{
+    struct dp_target *target;
+    dp_req_send_fn send_fn;
+
+    send_fn = dp_req->execute->send_fn;
+    dp_req->handler_req = send_fn(dp_req, dp_req->execute->method_data,
+                                  dp_req->request_data, dp_req->params);
+    if (dp_req->handler_req == NULL) {
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(dp_req->handler_req, dp_req_done, dp_req->req);
+
+    target = dp_req_target(dp_req);
+    dp_req->running = true;
+    target->num_running++;
+
+    return EOK;
+}
+
+static errno_t dp_req_enqueue(struct dp_req *dp_req)
+{
+    struct dp_req_queued *item;
+    struct dp_target *target;
+
+    target = dp_req_target(dp_req);
+
+    item = talloc_zero(dp_req, struct dp_req_queued);
+    if (item == NULL) {
+        return ENOMEM;
+    }
+
+    item->target = target;
+    item->dp_req = dp_req;
+    dp_req->queued = item;
+
+    DLIST_ADD_END(target->queue, item, struct dp_req_queued *);
+    talloc_set_destructor(item, dp_req_queued_destructor);
+
+    DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, dp_req->name, "Target [%s] already "
+                 "runs %u requests, request is queued.", target->name,
+                 target->num_running);
+
+    return EOK;
+}
+
 static int dp_req_destructor(struct dp_req *dp_req)
 {
+    /* The handler is freed together with the request. */
+    dp_req_release(dp_req);
+    talloc_zfree(dp_req->queued);
+
     DLIST_REMOVE(dp_req->provider->requests.active, dp_req);
 
     if (dp_req->provider->requests.num_active == 0) {
@@ -200,7 +318,7 @@ file_dp_request(TALLOC_CTX *mem_ctx,
                 struct dp_req **_dp_req)
 {
     struct dp_req_params *dp_params;
-    dp_req_send_fn send_fn;
+    struct dp_target *dp_target;
     struct dp_req *dp_req;
     struct be_ctx *be_ctx;
     errno_t ret;
@@ -245,18 +363,17 @@ file_dp_request(TALLOC_CTX *mem_ctx,
     dp_params->domain = dp_req->domain;
     dp_params->target = dp_req->target;
     dp_params->method = dp_req->method;
+    dp_req->params = dp_params;
 
-    send_fn = dp_req->execute->send_fn;
-    dp_req->handler_req = send_fn(dp_req, dp_req->execute->method_data,
-                                  dp_req->request_data, dp_params);
-    if (dp_req->handler_req == NULL) {
-        ret = ENOMEM;
+    dp_target = dp_req_target(dp_req);
+    if (dp_target->max_requests != 0
+            && (dp_target->num_running >= dp_target->max_requests
+                || dp_target->queue != NULL)) {
+        ret = dp_req_enqueue(dp_req);
         goto done;
     }
 
-    *_dp_req = dp_req;
-
-    ret = EOK;
+    ret = dp_req_run(dp_req);
 
 done:
     return ret;
@@ -266,9 +383,163 @@ struct dp_req_state {
     struct dp_req *dp_req;
     dp_req_recv_fn recv_fn;
     void *output_data;
+
+    struct data_provider *provider;
+    struct tevent_req *req;
+
+    /* Set if other callers may join this request. */
+    char *shared_key;
+    struct dp_req_state *joined;
+    uint32_t num_joined;
+
+    /* Set if this caller joined another request. */
+    struct dp_req_state *shared;
+    const char *shared_name;
+    const char *output_dtype;
+    size_t output_size;
+    struct dp_req_state *prev;
+    struct dp_req_state *next;
+
+    struct sss_trace_span *span;
+    struct timeval start;
 };
 
-static void dp_req_done(struct tevent_req *subreq);
+static void dp_req_shared_finish(struct dp_req_state *state, errno_t ret)
+{
+    struct dp_req_state *joined;
+    errno_t jret;
+
+    if (state->shared_key == NULL) {
+        return;
+    }
+
+    /* Nobody can join from now on. */
+    sss_ptr_hash_delete(state->provider->requests.shared, state->shared_key,
+                        false);
+    talloc_zfree(state->shared_key);
+
+    while ((joined = state->joined) != NULL) {
+        DLIST_REMOVE(state->joined, joined);
+        joined->shared = NULL;
+        talloc_set_destructor(joined, NULL);
+
+        jret = ret;
+        if (jret == EOK) {
+            joined->output_data = talloc_memdup(joined, state->output_data,
+                                                joined->output_size);
+            if (joined->output_data == NULL) {
+                jret = ENOMEM;
+            } else {
+                talloc_set_name_const(joined->output_data,
+                                      joined->output_dtype);
+            }
+        }
+
+        if (jret != EOK) {
+            tevent_req_error(joined->req, jret);
+            continue;
+        }
+
+        tevent_req_done(joined->req);
+    }
+}
+
+static int dp_req_shared_destructor(struct dp_req_state *state)
+{
+    /* The request was freed before it finished. */
+    dp_req_shared_finish(state, ERR_TERMINATED);
+
+    return 0;
+}
+
+static int dp_req_joined_destructor(struct dp_req_state *state)
+{
+    if (state->shared != NULL) {
+        DLIST_REMOVE(state->shared->joined, state);
+    }
+
+    return 0;
+}
+
+static bool dp_req_join(struct tevent_req *req,
+                        struct dp_req_state *state,
+                        struct data_provider *provider,
+                        const char *shared_key,
+                        uint32_t dp_flags,
+                        void *request_data)
+{
+    struct dp_req_state *shared;
+
+    if (provider->requests.shared == NULL) {
+        return false;
+    }
+
+    shared = sss_ptr_hash_lookup(provider->requests.shared, shared_key,
+                                 struct dp_req_state);
+    if (shared == NULL) {
+        return false;
+    }
+
+    /* This caller does not want to wait for the server. */
+    if (dp_flags & DP_FAST_REPLY && be_is_offline(provider->be_ctx)) {
+        return false;
+    }
+
+    state->shared_name = talloc_strdup(state, shared->dp_req->name);
+    if (state->shared_name == NULL) {
+        return false;
+    }
+
+    state->provider = provider;
+    state->req = req;
+    state->shared = shared;
+    state->output_dtype = shared->dp_req->execute->output_dtype;
+    state->output_size = shared->dp_req->execute->output_size;
+    talloc_steal(state, request_data);
+
+    DLIST_ADD_END(shared->joined, state, struct dp_req_state *);
+    talloc_set_destructor(state, dp_req_joined_destructor);
+    shared->num_joined++;
+    provider->requests.num_joined++;
+
+    DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->shared_name,
+                 "Sharing result with a new caller [%u in total].",
+                 shared->num_joined);
+
+    return true;
+}
+
+static void dp_req_share(struct dp_req_state *state,
+                         struct data_provider *provider,
+                         const char *shared_key)
+{
+    errno_t ret;
+
+    if (provider->requests.shared == NULL) {
+        provider->requests.shared = sss_ptr_hash_create(provider, NULL, NULL);
+        if (provider->requests.shared == NULL) {
+            return;
+        }
+    }
+
+    state->shared_key = talloc_strdup(state, shared_key);
+    if (state->shared_key == NULL) {
+        return;
+    }
+
+    ret = sss_ptr_hash_add(provider->requests.shared, shared_key, state,
+                           struct dp_req_state);
+    if (ret != EOK) {
+        /* The request will just not be shared. */
+        DP_REQ_DEBUG(SSSDBG_MINOR_FAILURE, state->dp_req->name,
+                     "Unable to share request [%d]: %s",
+                     ret, sss_strerror(ret));
+        talloc_zfree(state->shared_key);
+        return;
+    }
+
+    talloc_set_destructor(state, dp_req_shared_destructor);
+}
 
 struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
                                struct data_provider *provider,
@@ -279,6 +550,22 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
                                uint32_t dp_flags,
                                void *request_data,
                                const char **_request_name)
+{
+    return dp_req_shared_send(mem_ctx, provider, domain, name, target,
+                              method, dp_flags, request_data, NULL,
+                              _request_name);
+}
+
+struct tevent_req *dp_req_shared_send(TALLOC_CTX *mem_ctx,
+                                      struct data_provider *provider,
+                                      const char *domain,
+                                      const char *name,
+                                      enum dp_targets target,
+                                      enum dp_methods method,
+                                      uint32_t dp_flags,
+                                      void *request_data,
+                                      const char *shared_key,
+                                      const char **_request_name)
 {
     struct dp_req_state *state;
     const char *request_name;
@@ -292,6 +579,28 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    /* Callers that join a shared request wait in their own span. */
+    state->span = sss_trace_span_start_child(state, name, domain);
+    state->start = tevent_timeval_current();
+
+    if (shared_key != NULL
+            && dp_req_join(req, state, provider, shared_key, dp_flags,
+                           request_data)) {
+        if (_request_name != NULL) {
+            request_name = talloc_strdup(mem_ctx, state->shared_name);
+            if (request_name == NULL) {
+                talloc_free(req);
+                return NULL;
+            }
+            *_request_name = request_name;
+        }
+
+        return req;
+    }
+
+    state->provider = provider;
+    state->req = req;
+
     ret = file_dp_request(state, provider, domain, name, target,
                           method, dp_flags, request_data, req, &dp_req);
 
@@ -329,7 +638,9 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
 
     talloc_set_name_const(state->output_data, dp_req->execute->output_dtype);
 
-    tevent_req_set_callback(dp_req->handler_req, dp_req_done, req);
+    if (shared_key != NULL) {
+        dp_req_share(state, provider, shared_key);
+    }
 
     return req;
 
@@ -344,6 +655,41 @@ immediately:
     return req;
 }
 
+static void dp_req_account_metrics(struct dp_req_state *state, errno_t ret)
+{
+    struct timeval now;
+    struct timeval diff;
+    const char *domain;
+    const char *target;
+    const char *result;
+
+    now = tevent_timeval_current();
+    diff = tevent_timeval_until(&state->start, &now);
+
+    domain = state->dp_req->domain->name;
+    target = dp_target_to_string(state->dp_req->target);
+
+    switch (ret) {
+    case EOK:
+        result = "success";
+        break;
+    case ENOENT:
+        result = "not_found";
+        break;
+    case ERR_OFFLINE:
+        result = "offline";
+        break;
+    default:
+        result = "error";
+        break;
+    }
+
+    sss_metrics_inc(SSS_METRIC_DP_REQUESTS, 1, domain, target, result);
+    sss_metrics_observe(SSS_METRIC_DP_REQUEST_DURATION,
+                        (uint64_t)diff.tv_sec * 1000000 + diff.tv_usec,
+                        domain, target);
+}
+
 static void dp_req_done(struct tevent_req *subreq)
 {
     struct dp_req_state *state;
@@ -358,12 +704,23 @@ static void dp_req_done(struct tevent_req *subreq)
     /* subreq is the same as dp_req->handler_req */
     talloc_zfree(subreq);
     state->dp_req->handler_req = NULL;
+    dp_req_release(state->dp_req);
 
     PROBE(DP_REQ_DONE, state->dp_req->name, state->dp_req->target,
-          state->dp_req->method, ret, sss_strerror(ret));
+          state->dp_req->method, ret, sss_strerror(ret), state->num_joined,
+          state->provider->requests.num_joined);
 
     DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->dp_req->name,
                  "Request handler finished [%d]: %s", ret, sss_strerror(ret));
+    dp_req_account_metrics(state, ret);
+
+    /* The responders read the result from the cache once they get the
+     * reply. Transactions that still wait for the batch to be committed
+     * are committed now. */
+    sysdb_transaction_flush(state->dp_req->domain->sysdb);
+
+    /* Callers that joined this request get the same result. */
+    dp_req_shared_finish(state, ret);
 
     if (ret != EOK) {
         tevent_req_error(req, ret);
@@ -382,9 +739,14 @@ errno_t _dp_req_recv(TALLOC_CTX *mem_ctx,
 
     state = tevent_req_data(req, struct dp_req_state);
 
+    sss_trace_span_end_req(state->span, req, EOK);
+
     if (state->dp_req != NULL) {
         DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->dp_req->name,
                      "Receiving request data.");
+    } else if (state->shared_name != NULL) {
+        DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->shared_name,
+                     "Receiving shared request data.");
     } else {
         /* dp_req may be NULL in case we error when filing request */
         DEBUG(SSSDBG_TRACE_FUNC,
@@ -404,8 +766,52 @@ errno_t _dp_req_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static void dp_req_queue_handler(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval tv,
+                                 void *pvt)
+{
+    struct dp_req_state *state;
+    struct dp_target *target;
+    struct dp_req *dp_req;
+    errno_t ret;
+
+    target = talloc_get_type(pvt, struct dp_target);
+    target->queue_te = NULL;
+
+    while (target->queue != NULL
+            && (target->max_requests == 0
+                || target->num_running < target->max_requests)) {
+        dp_req = target->queue->dp_req;
+        talloc_zfree(dp_req->queued);
+
+        DP_REQ_DEBUG(SSSDBG_TRACE_FUNC, dp_req->name,
+                     "Starting queued request.");
+
+        ret = dp_req_run(dp_req);
+        if (ret != EOK) {
+            state = tevent_req_data(dp_req->req, struct dp_req_state);
+            dp_req_shared_finish(state, ret);
+            tevent_req_error(dp_req->req, ret);
+        }
+    }
+}
+
 static void dp_terminate_request(struct dp_req *dp_req)
 {
+    struct dp_req_state *state;
+
+    if (dp_req->queued != NULL) {
+        /* The request did not start yet. */
+        DP_REQ_DEBUG(SSSDBG_TRACE_ALL, dp_req->name, "Terminating.");
+
+        talloc_zfree(dp_req->queued);
+        state = tevent_req_data(dp_req->req, struct dp_req_state);
+        dp_req_shared_finish(state, ERR_TERMINATED);
+        tevent_req_error(dp_req->req, ERR_TERMINATED);
+        return;
+    }
+
     if (dp_req->handler_req == NULL) {
         /* This may occur when the handler already finished but the caller
          * of dp request did not yet received data/free dp_req. We just
@@ -418,6 +824,11 @@ static void dp_terminate_request(struct dp_req *dp_req)
     DP_REQ_DEBUG(SSSDBG_TRACE_ALL, dp_req->name, "Terminating.");
 
     talloc_zfree(dp_req->handler_req);
+    dp_req_release(dp_req);
+
+    state = tevent_req_data(dp_req->req, struct dp_req_state);
+    dp_req_shared_finish(state, ERR_TERMINATED);
+
     tevent_req_error(dp_req->req, ERR_TERMINATED);
 }
 
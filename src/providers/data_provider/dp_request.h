@@ -39,6 +39,23 @@ struct tevent_req *dp_req_send(TALLOC_CTX *mem_ctx,
                                void *request_data,
                                const char **_request_name);
 
+/**
+ * Same as dp_req_send() but if a request with the same @shared_key is
+ * already running, no new request is started and the caller receives a copy
+ * of its output data once it finishes. The output data type must therefore
+ * be safe to copy.
+ */
+struct tevent_req *dp_req_shared_send(TALLOC_CTX *mem_ctx,
+                                      struct data_provider *provider,
+                                      const char *domain,
+                                      const char *name,
+                                      enum dp_targets target,
+                                      enum dp_methods method,
+                                      uint32_t dp_flags,
+                                      void *request_data,
+                                      const char *shared_key,
+                                      const char **_request_name);
+
 errno_t _dp_req_recv(TALLOC_CTX *mem_ctx,
                      struct tevent_req *req,
                      const char *data_type,
@@ -22,6 +22,7 @@
 #include <tevent.h>
 
 #include "confdb/confdb.h"
+#include "util/dlinklist.h"
 #include "providers/data_provider.h"
 #include "providers/data_provider/dp_private.h"
 #include "sss_iface/sss_iface_async.h"
@@ -42,6 +43,13 @@ static const char *user_clients[] = {
     NULL
 };
 
+/* List of DP clients that keep users or groups in memory */
+static const char *memcache_clients[] = {
+    SSS_BUS_NSS,
+    SSS_BUS_IFP,
+    NULL
+};
+
 static const char *all_clients[] = {
     SSS_BUS_NSS,
     SSS_BUS_PAM,
@@ -178,6 +186,7 @@ void dp_sbus_reset_groups_ncache(struct data_provider *provider,
 void dp_sbus_reset_users_memcache(struct data_provider *provider)
 {
     struct tevent_req *subreq;
+    int i;
 
     if (provider == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
@@ -185,16 +194,18 @@ void dp_sbus_reset_users_memcache(struct data_provider *provider)
     }
 
     DEBUG(SSSDBG_TRACE_FUNC,
-          "Ordering NSS responder to invalidate the users\n");
+          "Ordering responders to invalidate the users\n");
 
-    subreq = sbus_call_nss_memcache_InvalidateAllUsers_send(provider,
-                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH);
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
-        return;
-    }
+    for (i = 0; memcache_clients[i] != NULL; i++) {
+        subreq = sbus_call_nss_memcache_InvalidateAllUsers_send(provider,
+                     provider->sbus_conn, memcache_clients[i], SSS_BUS_PATH);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            return;
+        }
 
-    tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+        tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+    }
 
     return;
 }
@@ -202,6 +213,7 @@ void dp_sbus_reset_users_memcache(struct data_provider *provider)
 void dp_sbus_reset_groups_memcache(struct data_provider *provider)
 {
     struct tevent_req *subreq;
+    int i;
 
     if (provider == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
@@ -209,16 +221,18 @@ void dp_sbus_reset_groups_memcache(struct data_provider *provider)
     }
 
     DEBUG(SSSDBG_TRACE_FUNC,
-          "Ordering NSS responder to invalidate the groups\n");
+          "Ordering responders to invalidate the groups\n");
 
-    subreq = sbus_call_nss_memcache_InvalidateAllGroups_send(provider,
-                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH);
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
-        return;
-    }
+    for (i = 0; memcache_clients[i] != NULL; i++) {
+        subreq = sbus_call_nss_memcache_InvalidateAllGroups_send(provider,
+                     provider->sbus_conn, memcache_clients[i], SSS_BUS_PATH);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            return;
+        }
 
-    tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+        tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+    }
 
     return;
 }
@@ -226,6 +240,7 @@ void dp_sbus_reset_groups_memcache(struct data_provider *provider)
 void dp_sbus_reset_initgr_memcache(struct data_provider *provider)
 {
     struct tevent_req *subreq;
+    int i;
 
     if (provider == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
@@ -233,24 +248,170 @@ void dp_sbus_reset_initgr_memcache(struct data_provider *provider)
     }
 
     DEBUG(SSSDBG_TRACE_FUNC,
-          "Ordering NSS responder to invalidate the initgroups\n");
+          "Ordering responders to invalidate the initgroups\n");
+
+    for (i = 0; memcache_clients[i] != NULL; i++) {
+        subreq = sbus_call_nss_memcache_InvalidateAllInitgroups_send(provider,
+                     provider->sbus_conn, memcache_clients[i], SSS_BUS_PATH);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            return;
+        }
+
+        tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+    }
+
+    return;
+}
+
+static void dp_sbus_invalidate_memcache_batch_done(struct tevent_req *subreq)
+{
+    uint32_t num_users;
+    uint32_t num_groups;
+    errno_t ret;
+
+    ret = sbus_call_nss_memcache_InvalidateBatch_recv(subreq, &num_users,
+                                                      &num_groups);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to invalidate memory cache records [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "NSS responder invalidated %"PRIu32" users "
+          "and %"PRIu32" groups in memory cache\n", num_users, num_groups);
+}
+
+static void dp_sbus_send_memcache_batch(struct data_provider *provider,
+                                        const char *domain,
+                                        const char **users,
+                                        const char **groups,
+                                        uint32_t *gids)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct tevent_req *subreq;
+    struct sss_iface_payload *records;
+    const char **string_lists[] = { users, groups };
+    uint32_t *id_lists[] = { NULL, gids };
+    uint8_t *data;
+    size_t length;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory!\n");
+        return;
+    }
+
+    ret = sss_iface_payload_pack_lists(tmp_ctx, string_lists, 2,
+                                       id_lists, 2, &data, &length);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to pack records [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* Large batches are written once into a memory file that is passed
+     * to both responders. */
+    records = sss_iface_payload_new(tmp_ctx, data, length,
+                            sbus_connection_can_pass_fd(provider->sbus_conn));
+    if (records == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory!\n");
+        goto done;
+    }
 
-    subreq = sbus_call_nss_memcache_InvalidateAllInitgroups_send(provider,
-                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH);
+    subreq = sbus_call_nss_memcache_InvalidateBatch_send(provider,
+                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH,
+                 domain, records);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
-        return;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, dp_sbus_invalidate_memcache_batch_done,
+                            NULL);
+
+    /* InfoPipe only drops its cached results, the counts are not needed. */
+    subreq = sbus_call_nss_memcache_InvalidateBatch_send(provider,
+                 provider->sbus_conn, SSS_BUS_IFP, SSS_BUS_PATH,
+                 domain, records);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        goto done;
     }
 
     tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
 
-    return;
+done:
+    talloc_free(tmp_ctx);
+}
+
+void dp_sbus_invalidate_memcache_batch(struct data_provider *provider,
+                                       struct sss_domain_info *dom,
+                                       const char **users,
+                                       const char **groups)
+{
+    if (provider == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Ordering NSS responder to invalidate a batch of records\n");
+
+    dp_sbus_send_memcache_batch(provider, dom->name, users, groups, NULL);
 }
 
+struct dp_gid_queue {
+    struct dp_gid_queue *prev;
+    struct dp_gid_queue *next;
+
+    const char *domain;
+    uint32_t *gids;
+    size_t num_gids;
+};
+
+static void dp_sbus_gid_queue_flush(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv,
+                                    void *pvt)
+{
+    struct data_provider *provider;
+    struct dp_gid_queue *queue;
+
+    provider = talloc_get_type(pvt, struct data_provider);
+    provider->gid_queue_te = NULL;
+
+    while ((queue = provider->gid_queue) != NULL) {
+        DLIST_REMOVE(provider->gid_queue, queue);
+
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Ordering responders to invalidate %zu groups of %s\n",
+              queue->num_gids, queue->domain);
+
+        /* The array length is the number of gids sent. */
+        queue->gids = talloc_realloc(queue, queue->gids, uint32_t,
+                                     queue->num_gids);
+        if (queue->gids != NULL) {
+            dp_sbus_send_memcache_batch(provider, queue->domain,
+                                        NULL, NULL, queue->gids);
+        }
+
+        talloc_free(queue);
+    }
+}
+
+/* Groups are usually invalidated one by one while a lookup processes many
+ * of them. They are collected and sent in one message per domain once the
+ * current tevent loop iteration is finished. */
 void dp_sbus_invalidate_group_memcache(struct data_provider *provider,
+                                       struct sss_domain_info *dom,
                                        gid_t gid)
 {
-    struct tevent_req *subreq;
+    struct dp_gid_queue *queue;
+    size_t size;
 
     if (provider == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "No provider pointer\n");
@@ -258,18 +419,55 @@ void dp_sbus_invalidate_group_memcache(struct data_provider *provider,
     }
 
     DEBUG(SSSDBG_TRACE_FUNC,
-          "Ordering NSS responder to invalidate the group %"PRIu32" \n",
-          gid);
+          "Queueing invalidation of the group %"PRIu32"\n", gid);
 
-    subreq = sbus_call_nss_memcache_InvalidateGroupById_send(provider,
-                 provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH,
-                 (uint32_t)gid);
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
-        return;
+    DLIST_FOR_EACH(queue, provider->gid_queue) {
+        if (strcmp(queue->domain, dom->name) == 0) {
+            break;
+        }
     }
 
-    tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+    if (queue == NULL) {
+        queue = talloc_zero(provider, struct dp_gid_queue);
+        if (queue == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory!\n");
+            return;
+        }
 
-    return;
+        queue->domain = talloc_strdup(queue, dom->name);
+        if (queue->domain == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory!\n");
+            talloc_free(queue);
+            return;
+        }
+
+        DLIST_ADD_END(provider->gid_queue, queue, struct dp_gid_queue *);
+    }
+
+    size = talloc_array_length(queue->gids);
+    if (queue->num_gids == size) {
+        size = size == 0 ? 16 : size * 2;
+        queue->gids = talloc_realloc(queue, queue->gids, uint32_t, size);
+        if (queue->gids == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory!\n");
+            DLIST_REMOVE(provider->gid_queue, queue);
+            talloc_free(queue);
+            return;
+        }
+    }
+
+    queue->gids[queue->num_gids] = gid;
+    queue->num_gids++;
+
+    if (provider->gid_queue_te != NULL) {
+        return;
+    }
+
+    provider->gid_queue_te = tevent_add_timer(provider->ev, provider,
+                                              tevent_timeval_current(),
+                                              dp_sbus_gid_queue_flush,
+                                              provider);
+    if (provider->gid_queue_te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule group invalidation\n");
+    }
 }
@@ -127,11 +127,151 @@ static bool should_invoke_selinux(struct data_provider *provider,
     return false;
 }
 
+/* Upper limit of remembered decisions, the table is flushed when reached. */
+#define DP_ACCESS_CACHE_MAX 4096
+
+static void dp_access_cache_online_cb(void *pvt)
+{
+    struct data_provider *provider;
+
+    provider = talloc_get_type(pvt, struct data_provider);
+
+    /* Decisions made offline were based on cached data only. */
+    dp_access_cache_flush(provider);
+}
+
+void dp_access_cache_bypass(struct data_provider *provider)
+{
+    DEBUG(SSSDBG_CONF_SETTINGS, "Access decisions will not be cached\n");
+
+    provider->access_cache.bypass = true;
+    dp_access_cache_flush(provider);
+}
+
+void dp_access_cache_flush(struct data_provider *provider)
+{
+    if (provider->access_cache.table == NULL) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing access decision cache\n");
+    talloc_zfree(provider->access_cache.table);
+}
+
+static char *dp_access_cache_key(TALLOC_CTX *mem_ctx, struct pam_data *pd)
+{
+    return talloc_asprintf(mem_ctx, "%s\x1f%s\x1f%s\x1f%s",
+                           pd->domain == NULL ? "" : pd->domain,
+                           pd->user == NULL ? "" : pd->user,
+                           pd->service == NULL ? "" : pd->service,
+                           pd->rhost == NULL ? "" : pd->rhost);
+}
+
+static bool dp_access_cache_enabled(struct data_provider *provider)
+{
+    return provider->access_cache.timeout > 0
+               && !provider->access_cache.bypass;
+}
+
+static bool dp_access_cache_lookup(struct data_provider *provider,
+                                   struct pam_data *pd)
+{
+    hash_key_t key;
+    hash_value_t value;
+    bool found = false;
+    int hret;
+
+    if (!dp_access_cache_enabled(provider)
+            || provider->access_cache.table == NULL) {
+        return false;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = dp_access_cache_key(NULL, pd);
+    if (key.str == NULL) {
+        return false;
+    }
+
+    hret = hash_lookup(provider->access_cache.table, &key, &value);
+    if (hret == HASH_SUCCESS) {
+        if ((time_t)value.ul > time(NULL)) {
+            found = true;
+        } else {
+            hash_delete(provider->access_cache.table, &key);
+        }
+    }
+
+    talloc_free(key.str);
+
+    if (found) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Access of [%s] to [%s] is cached\n",
+              pd->user, pd->service);
+    }
+
+    return found;
+}
+
+/* Only allowed access is remembered. Denials are always returned by the
+ * access provider itself so that they do not outlive the request that
+ * produced them. Results carrying messages for the user, like a password
+ * expiration warning, are not remembered either. */
+static void dp_access_cache_store(struct data_provider *provider,
+                                  struct pam_data *pd)
+{
+    hash_key_t key;
+    hash_value_t value;
+    errno_t ret;
+    int hret;
+
+    if (!dp_access_cache_enabled(provider)
+            || pd->pam_status != PAM_SUCCESS || pd->resp_list != NULL) {
+        return;
+    }
+
+    if (provider->access_cache.table != NULL
+            && hash_count(provider->access_cache.table)
+                   >= DP_ACCESS_CACHE_MAX) {
+        dp_access_cache_flush(provider);
+    }
+
+    if (provider->access_cache.table == NULL) {
+        ret = sss_hash_create(provider, 0, &provider->access_cache.table);
+        if (ret != EOK) {
+            return;
+        }
+
+        ret = be_add_online_cb(provider->access_cache.table, provider->be_ctx,
+                               dp_access_cache_online_cb, provider, NULL);
+        if (ret != EOK) {
+            talloc_zfree(provider->access_cache.table);
+            return;
+        }
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = dp_access_cache_key(NULL, pd);
+    if (key.str == NULL) {
+        return;
+    }
+
+    value.type = HASH_VALUE_ULONG;
+    value.ul = time(NULL) + provider->access_cache.timeout;
+
+    hret = hash_enter(provider->access_cache.table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to cache access decision\n");
+    }
+
+    talloc_free(key.str);
+}
+
 struct dp_pam_handler_state {
     struct data_provider *provider;
     struct pam_data *pd;
+    enum dp_targets target;
 };
 
+static errno_t dp_pam_handler_selinux(struct tevent_req *req);
 static void dp_pam_handler_auth_done(struct tevent_req *subreq);
 static void dp_pam_handler_done(struct tevent_req *subreq);
 
@@ -177,6 +317,13 @@ dp_pam_handler_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    state->target = target;
+    if (target == DPT_ACCESS && dp_access_cache_lookup(provider, pd)) {
+        pd->pam_status = PAM_SUCCESS;
+        ret = dp_pam_handler_selinux(req);
+        goto done;
+    }
+
     subreq = dp_req_send(state, provider, pd->domain, req_name, target,
                          method, 0, pd, NULL);
     if (subreq == NULL) {
@@ -217,9 +364,27 @@ static void dp_pam_handler_auth_done(struct tevent_req *subreq)
         return;
     }
 
-    if (!should_invoke_selinux(state->provider, state->pd)) {
+    if (state->target == DPT_ACCESS) {
+        dp_access_cache_store(state->provider, state->pd);
+    }
+
+    ret = dp_pam_handler_selinux(req);
+    if (ret == EOK) {
         tevent_req_done(req);
-        return;
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static errno_t dp_pam_handler_selinux(struct tevent_req *req)
+{
+    struct dp_pam_handler_state *state;
+    struct tevent_req *subreq;
+
+    state = tevent_req_data(req, struct dp_pam_handler_state);
+
+    if (!should_invoke_selinux(state->provider, state->pd)) {
+        return EOK;
     }
 
     subreq = dp_req_send(state, state->provider, state->pd->domain,
@@ -227,11 +392,12 @@ static void dp_pam_handler_auth_done(struct tevent_req *subreq)
                          0, state->pd, NULL);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
-        tevent_req_error(req, ENOMEM);
-        return;
+        return ENOMEM;
     }
 
     tevent_req_set_callback(subreq, dp_pam_handler_done, req);
+
+    return EAGAIN;
 }
 
 static void dp_pam_handler_done(struct tevent_req *subreq)
@@ -269,6 +435,7 @@ dp_pam_handler_recv(TALLOC_CTX *mem_ctx,
 }
 
 struct dp_access_control_refresh_rules_state {
+    struct data_provider *provider;
     void *reply;
 };
 
@@ -291,6 +458,8 @@ dp_access_control_refresh_rules_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    state->provider = provider;
+
     subreq = dp_req_send(state, provider, NULL, "Refresh Access Control Rules",
                          DPT_ACCESS, DPM_REFRESH_ACCESS_RULES, 0, NULL, NULL);
     if (subreq == NULL) {
@@ -328,6 +497,9 @@ static void dp_access_control_refresh_rules_done(struct tevent_req *subreq)
         return;
     }
 
+    /* Remembered decisions may be based on the old rules. */
+    dp_access_cache_flush(state->provider);
+
     tevent_req_done(req);
     return;
 }
@@ -27,6 +27,8 @@
 #include "providers/data_provider/dp_iface.h"
 #include "providers/backend.h"
 #include "util/util.h"
+#include "util/strtonum.h"
+#include "util/sss_trace.h"
 
 #define FILTER_TYPE(str, type) {str "=", sizeof(str "=") - 1, type}
 
@@ -175,8 +177,6 @@ static void dp_req_initgr_pp_sr_overlay(struct data_provider *provider,
     struct ldb_message *msg;
     const char *name;
     char *output_name;
-    char **conf_user;
-    char **conf_group;
     size_t i;
     TALLOC_CTX *tmp_ctx = NULL;
     errno_t ret;
@@ -230,21 +230,11 @@ static void dp_req_initgr_pp_sr_overlay(struct data_provider *provider,
         goto done;
     }
 
-    /* For each user name in session recording config */
-    conf_user = be->sr_conf.users;
-    if (conf_user != NULL) {
-        for (; *conf_user != NULL && !enabled; conf_user++) {
-            /* If it matches the requested user name */
-            if (strcmp(*conf_user, output_name) == 0) {
-                enabled = true;
-            }
-        }
-    }
+    /* If the user is listed in session recording config */
+    enabled = session_recording_conf_has_user(&be->sr_conf, output_name);
 
     /* If we have groups in config and are not yet enabled */
-    if (be->sr_conf.groups != NULL &&
-        be->sr_conf.groups[0] != NULL &&
-        !enabled) {
+    if (be->sr_conf.group_set != NULL && !enabled) {
         /* For each group in response */
         for (i = 0; i < res->count && !enabled; i++) {
             /* Get the group msg */
@@ -289,14 +279,9 @@ static void dp_req_initgr_pp_sr_overlay(struct data_provider *provider,
                       name, sss_strerror(ret));
                 goto done;
             }
-            /* For each group in configuration */
-            for (conf_group = be->sr_conf.groups;
-                 *conf_group != NULL && !enabled;
-                 conf_group++) {
-                if (strcmp(*conf_group, output_name) == 0) {
-                    enabled = true;
-                }
-            }
+            /* If the group is listed in configuration */
+            enabled = session_recording_conf_has_group(&be->sr_conf,
+                                                       output_name);
         }
     }
 
@@ -409,6 +394,217 @@ static void dp_req_initgr_pp_set_initgr_timestamp(struct dp_initgr_ctx *ctx,
     }
 }
 
+static void dp_req_initgr_pp_set_initgr_index(struct dp_initgr_ctx *ctx,
+                                              struct dp_reply_std *reply)
+{
+    struct ldb_result *res;
+    errno_t ret;
+
+    if (reply->dp_error != DP_ERR_OK || reply->error != EOK
+            || DOM_HAS_VIEWS(ctx->domain_info)) {
+        return;
+    }
+
+    ret = sysdb_initgroups(ctx, ctx->domain_info, ctx->filter_value, &res);
+    if (ret != EOK) {
+        return;
+    }
+
+    if (res->count > 0) {
+        ret = sysdb_set_initgr_index(ctx->domain_info, res);
+        if (ret != EOK) {
+            /* Not fatal, the responders will load the groups. */
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Failed to store initgroups index for [%s]\n",
+                  ctx->filter_value);
+        }
+    }
+
+    talloc_free(res);
+}
+
+/* Requests from different responders for the same object share one
+ * provider run. The data provider flags do not change the result. */
+static const char *dp_id_data_shared_key(TALLOC_CTX *mem_ctx,
+                                         struct be_ctx *be_ctx,
+                                         struct dp_id_data *data)
+{
+    struct sss_domain_info *dom;
+    const char *value;
+
+    dom = be_ctx->domain;
+    if (data->domain != NULL) {
+        dom = find_domain_by_name(be_ctx->domain, data->domain, true);
+        if (dom == NULL) {
+            return NULL;
+        }
+    }
+
+    value = data->filter_value;
+    if (value != NULL
+            && ((data->filter_type == BE_FILTER_NAME && !dom->case_sensitive)
+                || data->filter_type == BE_FILTER_SECID
+                || data->filter_type == BE_FILTER_UUID)) {
+        value = sss_tc_utf8_str_tolower(mem_ctx, value);
+        if (value == NULL) {
+            return NULL;
+        }
+    }
+
+    return talloc_asprintf(mem_ctx, "%s:%#"PRIx32":%"PRIu32":%s:%s",
+                           dom->name, data->entry_type, data->filter_type,
+                           value == NULL ? "-" : value,
+                           data->extra_value == NULL ? "-" : data->extra_value);
+}
+
+/* SIDs and IDs that the provider could not resolve are remembered in the
+ * cache of the domain for id_negative_timeout seconds, also over restarts,
+ * so that e.g. unknown SIDs in file ACLs do not hit the server every time. */
+static const char *dp_id_negcache_key(TALLOC_CTX *mem_ctx,
+                                      struct be_ctx *be_ctx,
+                                      struct dp_id_data *data,
+                                      struct sss_domain_info **_dom)
+{
+    struct sss_domain_info *dom;
+    const char *value;
+
+    if (data->filter_value == NULL
+            || (data->filter_type != BE_FILTER_SECID
+                && data->filter_type != BE_FILTER_IDNUM)) {
+        return NULL;
+    }
+
+    switch (data->entry_type & BE_REQ_TYPE_MASK) {
+    case BE_REQ_USER:
+    case BE_REQ_GROUP:
+    case BE_REQ_BY_SECID:
+    case BE_REQ_USER_AND_GROUP:
+        break;
+    default:
+        return NULL;
+    }
+
+    dom = be_ctx->domain;
+    if (data->domain != NULL) {
+        dom = find_domain_by_name(be_ctx->domain, data->domain, true);
+        if (dom == NULL) {
+            return NULL;
+        }
+    }
+
+    if (dom->id_negative_timeout == 0) {
+        return NULL;
+    }
+
+    value = data->filter_value;
+    if (data->filter_type == BE_FILTER_SECID) {
+        value = sss_tc_utf8_str_tolower(mem_ctx, value);
+        if (value == NULL) {
+            return NULL;
+        }
+    }
+
+    *_dom = dom;
+    return talloc_asprintf(mem_ctx, "%#"PRIx32":%"PRIu32":%s",
+                           data->entry_type & BE_REQ_TYPE_MASK,
+                           data->filter_type, value);
+}
+
+static bool dp_id_negcache_check(struct be_ctx *be_ctx,
+                                 struct dp_id_data *data)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *dom;
+    const char *key;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return false;
+    }
+
+    key = dp_id_negcache_key(tmp_ctx, be_ctx, data, &dom);
+    if (key == NULL) {
+        talloc_free(tmp_ctx);
+        return false;
+    }
+
+    ret = sysdb_negcache_check(dom, key);
+    if (ret == EEXIST) {
+        DEBUG(SSSDBG_TRACE_FUNC, "[%s] was not found recently, "
+              "skipping the lookup\n", key);
+    } else if (ret != ENOENT) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to check negative cache entry [%s] [%d]: %s\n",
+              key, ret, sss_strerror(ret));
+    }
+
+    talloc_free(tmp_ctx);
+    return ret == EEXIST;
+}
+
+/* The providers remove objects that were not found from the cache, so a
+ * successful lookup that left nothing behind means there is no such SID
+ * or ID. The object may be stored in any domain of the backend. */
+static void dp_id_negcache_update(struct be_ctx *be_ctx,
+                                  struct dp_id_data *data,
+                                  struct dp_reply_std *reply)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *dom;
+    struct sss_domain_info *iter;
+    struct ldb_result *res;
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    const char *key;
+    uint32_t id = 0;
+    errno_t ret;
+
+    if (reply->dp_error != DP_ERR_OK || reply->error != EOK) {
+        return;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return;
+    }
+
+    key = dp_id_negcache_key(tmp_ctx, be_ctx, data, &dom);
+    if (key == NULL) {
+        goto done;
+    }
+
+    if (data->filter_type == BE_FILTER_IDNUM) {
+        id = strtouint32(data->filter_value, NULL, 10);
+        if (errno != 0) {
+            goto done;
+        }
+    }
+
+    for (iter = be_ctx->domain; iter != NULL;
+            iter = get_next_domain(iter, SSS_GND_DESCEND)) {
+        if (data->filter_type == BE_FILTER_SECID) {
+            ret = sysdb_search_object_by_sid(tmp_ctx, iter, data->filter_value,
+                                             attrs, &res);
+        } else {
+            ret = sysdb_search_object_by_id(tmp_ctx, iter, id, attrs, &res);
+        }
+        if (ret != ENOENT) {
+            /* Found, or the cache can not tell. */
+            goto done;
+        }
+    }
+
+    ret = sysdb_negcache_set(dom, key, dom->id_negative_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to store negative cache entry [%s] [%d]: %s\n",
+              key, ret, sss_strerror(ret));
+    }
+
+done:
+    talloc_free(tmp_ctx);
+}
+
 struct dp_get_account_info_state {
     const char *request_name;
     bool initgroups;
@@ -417,6 +613,8 @@ struct dp_get_account_info_state {
     struct dp_id_data *data;
     struct dp_reply_std reply;
     struct dp_initgr_ctx *initgr_ctx;
+
+    struct sss_trace_span *span;
 };
 
 static void dp_get_account_info_request_done(struct tevent_req *subreq);
@@ -432,9 +630,12 @@ dp_get_account_info_send(TALLOC_CTX *mem_ctx,
                          uint32_t entry_type,
                          const char *filter,
                          const char *domain,
-                         const char *extra)
+                         const char *extra,
+                         uint64_t trace_id,
+                         uint64_t parent_span_id)
 {
     struct dp_get_account_info_state *state;
+    const char *shared_key;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
@@ -478,9 +679,23 @@ dp_get_account_info_send(TALLOC_CTX *mem_ctx,
         }
     }
 
-    subreq = dp_req_send(state, provider, domain, state->request_name, DPT_ID,
-                         DPM_ACCOUNT_HANDLER, dp_flags, state->data,
-                         &state->request_name);
+    /* The parent span is the request of the responder. */
+    state->span = sss_trace_span_start(state, trace_id, parent_span_id,
+                                       state->request_name, domain);
+
+    if (dp_id_negcache_check(provider->be_ctx, state->data)) {
+        dp_reply_std_set(&state->reply, DP_ERR_OK, EOK, NULL);
+        ret = EOK;
+        goto done;
+    }
+
+    /* The request is not shared if the key can not be created. */
+    shared_key = dp_id_data_shared_key(state, provider->be_ctx, state->data);
+
+    subreq = dp_req_shared_send(state, provider, domain, state->request_name,
+                                DPT_ID, DPM_ACCOUNT_HANDLER, dp_flags,
+                                state->data, shared_key,
+                                &state->request_name);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
         ret = ENOMEM;
@@ -519,6 +734,8 @@ static void dp_get_account_info_request_done(struct tevent_req *subreq)
         return;
     }
 
+    dp_id_negcache_update(state->provider->be_ctx, state->data, &state->reply);
+
     ret = dp_get_account_info_initgroups_step(req);
     if (ret == EOK) {
         tevent_req_done(req);
@@ -545,6 +762,18 @@ static errno_t dp_get_account_info_initgroups_step(struct tevent_req *req)
         DEBUG(SSSDBG_TRACE_FUNC,
               "Ordering NSS responder to update memory cache\n");
 
+        /* InfoPipe keeps group lookup results as well. */
+        subreq = sbus_call_nss_memcache_UpdateInitgroups_send(state->provider,
+                     state->provider->sbus_conn, SSS_BUS_IFP, SSS_BUS_PATH,
+                     state->initgr_ctx->username, state->initgr_ctx->domain,
+                     state->initgr_ctx->groups);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, sbus_unwanted_reply, NULL);
+
         subreq = sbus_call_nss_memcache_UpdateInitgroups_send(state,
                      state->provider->sbus_conn, SSS_BUS_NSS, SSS_BUS_PATH,
                      state->initgr_ctx->username, state->initgr_ctx->domain,
@@ -561,6 +790,7 @@ static errno_t dp_get_account_info_initgroups_step(struct tevent_req *req)
     }
 
     dp_req_initgr_pp_set_initgr_timestamp(state->initgr_ctx, &state->reply);
+    dp_req_initgr_pp_set_initgr_index(state->initgr_ctx, &state->reply);
     dp_req_initgr_pp_sr_overlay(state->provider, state->initgr_ctx);
 
     return ret;
@@ -593,8 +823,11 @@ dp_get_account_info_recv(TALLOC_CTX *mem_ctx,
                          const char **_err_msg)
 {
     struct dp_get_account_info_state *state;
+
     state = tevent_req_data(req, struct dp_get_account_info_state);
 
+    sss_trace_span_end_req(state->span, req, state->reply.error);
+
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
     dp_req_reply_std(state->request_name, &state->reply,
@@ -603,6 +836,166 @@ dp_get_account_info_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+struct dp_get_account_info_batch_state {
+    uint16_t *dp_errors;
+    uint32_t *errors;
+    const char **err_msgs;
+    size_t num_pending;
+};
+
+struct dp_get_account_info_batch_item {
+    struct tevent_req *req;
+    size_t index;
+};
+
+static void dp_get_account_info_batch_done(struct tevent_req *subreq);
+
+struct tevent_req *
+dp_get_account_info_batch_send(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               struct sbus_request *sbus_req,
+                               struct data_provider *provider,
+                               uint32_t dp_flags,
+                               uint32_t entry_type,
+                               const char **filters,
+                               const char *domain,
+                               const char *extra)
+{
+    struct dp_get_account_info_batch_state *state;
+    struct dp_get_account_info_batch_item *item;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    size_t num;
+    size_t i;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct dp_get_account_info_batch_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    for (num = 0; filters != NULL && filters[num] != NULL; num++) {
+        /* count */
+    }
+
+    if (num > DP_ACCOUNT_BATCH_MAX) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Too many filters in one request [%zu]\n",
+              num);
+        ret = EINVAL;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_FUNC_DATA,
+          "Got batch of %zu requests for [%#"PRIx32"][%s]\n",
+          num, entry_type, be_req2str(entry_type));
+
+    state->dp_errors = talloc_zero_array(state, uint16_t, num);
+    state->errors = talloc_zero_array(state, uint32_t, num);
+    state->err_msgs = talloc_zero_array(state, const char *, num + 1);
+    if (state->dp_errors == NULL || state->errors == NULL
+            || state->err_msgs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* Each filter is a request of its own so identical requests from
+     * other responders are still chained by dp_req_send(). */
+    for (i = 0; i < num; i++) {
+        item = talloc_zero(state, struct dp_get_account_info_batch_item);
+        if (item == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        item->req = req;
+        item->index = i;
+
+        subreq = dp_get_account_info_send(item, ev, sbus_req, provider,
+                                          dp_flags, entry_type, filters[i],
+                                          domain, extra, 0, 0);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, dp_get_account_info_batch_done, item);
+        state->num_pending++;
+    }
+
+    ret = num == 0 ? EOK : EAGAIN;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void dp_get_account_info_batch_done(struct tevent_req *subreq)
+{
+    struct dp_get_account_info_batch_state *state;
+    struct dp_get_account_info_batch_item *item;
+    struct tevent_req *req;
+    const char *err_msg = NULL;
+    size_t i;
+    errno_t ret;
+
+    item = tevent_req_callback_data(subreq,
+                                    struct dp_get_account_info_batch_item);
+    req = item->req;
+    i = item->index;
+    state = tevent_req_data(req, struct dp_get_account_info_batch_state);
+
+    ret = dp_get_account_info_recv(state, subreq, &state->dp_errors[i],
+                                   &state->errors[i], &err_msg);
+    if (ret != EOK) {
+        /* Fail only this filter, not the whole batch. */
+        state->dp_errors[i] = DP_ERR_FATAL;
+        state->errors[i] = ret;
+        err_msg = sss_strerror(ret);
+    }
+
+    /* The message may belong to the subrequest. */
+    state->err_msgs[i] = talloc_strdup(state->err_msgs,
+                                       err_msg == NULL ? "" : err_msg);
+    talloc_free(item);
+    if (state->err_msgs[i] == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+
+    state->num_pending--;
+    if (state->num_pending == 0) {
+        tevent_req_done(req);
+    }
+}
+
+errno_t
+dp_get_account_info_batch_recv(TALLOC_CTX *mem_ctx,
+                               struct tevent_req *req,
+                               uint16_t **_dp_errors,
+                               uint32_t **_errors,
+                               const char ***_err_msgs)
+{
+    struct dp_get_account_info_batch_state *state;
+    state = tevent_req_data(req, struct dp_get_account_info_batch_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_dp_errors = talloc_steal(mem_ctx, state->dp_errors);
+    *_errors = talloc_steal(mem_ctx, state->errors);
+    *_err_msgs = talloc_steal(mem_ctx, state->err_msgs);
+
+    return EOK;
+}
+
 static bool
 check_and_parse_acct_domain_filter(struct dp_get_acct_domain_data *data,
                                    const char *filter)
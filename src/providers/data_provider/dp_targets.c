@@ -27,6 +27,7 @@
 #include "providers/data_provider/dp_builtin.h"
 #include "providers/backend.h"
 #include "util/util.h"
+#include "util/strtonum.h"
 
 #define DP_TARGET_INIT_FN "sssm_%s_%s_init"
 
@@ -356,6 +357,109 @@ static char *dp_get_module_name(TALLOC_CTX *mem_ctx,
     return talloc_strdup(mem_ctx, default_module);
 }
 
+static errno_t dp_parse_max_requests(const char *str, uint32_t *_value)
+{
+    uint32_t value;
+    char *endptr;
+
+    errno = 0;
+    value = strtouint32(str, &endptr, 10);
+    if (errno != 0 || *str == '\0' || *endptr != '\0') {
+        return EINVAL;
+    }
+
+    *_value = value;
+    return EOK;
+}
+
+static errno_t dp_load_request_limits(struct confdb_ctx *cdb,
+                                      const char *conf_path,
+                                      struct dp_target **targets)
+{
+    enum dp_targets type;
+    const char *name;
+    uint32_t value;
+    char **limits;
+    char *sep;
+    errno_t ret;
+    int i;
+
+    ret = confdb_get_string_as_list(cdb, NULL, conf_path,
+                                    CONFDB_DOMAIN_PROVIDER_MAX_REQUESTS,
+                                    &limits);
+    if (ret == ENOENT) {
+        return EOK;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read %s [%d]: %s\n",
+              CONFDB_DOMAIN_PROVIDER_MAX_REQUESTS, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    /* A plain number applies to all targets that are not listed. */
+    for (i = 0; limits[i] != NULL; i++) {
+        if (strchr(limits[i], ':') != NULL) {
+            continue;
+        }
+
+        ret = dp_parse_max_requests(limits[i], &value);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        for (type = 0; type < DP_TARGET_SENTINEL; type++) {
+            targets[type]->max_requests = value;
+        }
+    }
+
+    for (i = 0; limits[i] != NULL; i++) {
+        sep = strchr(limits[i], ':');
+        if (sep == NULL) {
+            continue;
+        }
+
+        *sep = '\0';
+        ret = dp_parse_max_requests(sep + 1, &value);
+        if (ret != EOK) {
+            *sep = ':';
+            goto done;
+        }
+
+        for (type = 0; type < DP_TARGET_SENTINEL; type++) {
+            name = dp_target_to_string(type);
+            if (name != NULL && strcmp(name, limits[i]) == 0) {
+                break;
+            }
+        }
+
+        if (type == DP_TARGET_SENTINEL) {
+            *sep = ':';
+            ret = EINVAL;
+            goto done;
+        }
+
+        targets[type]->max_requests = value;
+    }
+
+    for (type = 0; type < DP_TARGET_SENTINEL; type++) {
+        if (targets[type]->max_requests != 0) {
+            DEBUG(SSSDBG_CONF_SETTINGS, "At most %u [%s] requests run at "
+                  "the same time\n", targets[type]->max_requests,
+                  dp_target_to_string(type));
+        }
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Invalid value [%s] of %s\n",
+              limits[i], CONFDB_DOMAIN_PROVIDER_MAX_REQUESTS);
+    }
+
+    talloc_free(limits);
+    return ret;
+}
+
 static errno_t dp_load_configuration(struct confdb_ctx *cdb,
                                      const char *conf_path,
                                      struct dp_target **targets)
@@ -390,7 +494,7 @@ static errno_t dp_load_configuration(struct confdb_ctx *cdb,
         targets[type]->module_name = talloc_steal(targets[type], module);
     }
 
-    ret = EOK;
+    ret = dp_load_request_limits(cdb, conf_path, targets);
 
 done:
     return ret;
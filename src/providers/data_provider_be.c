@@ -38,6 +38,7 @@
 
 #include "util/util.h"
 #include "util/sss_utf8.h"
+#include "shared/murmurhash3.h"
 #include "confdb/confdb.h"
 #include "db/sysdb.h"
 #include "providers/backend.h"
@@ -51,6 +52,8 @@
 #define ONLINE_CB_RETRY 3
 #define ONLINE_CB_RETRY_MAX_DELAY 4
 
+#define MACHINE_ID_PATH "/etc/machine-id"
+
 /* sssd.service */
 static errno_t
 data_provider_res_init(TALLOC_CTX *mem_ctx,
@@ -92,6 +95,16 @@ try_to_go_online(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static errno_t
+be_cache_checkpoint(TALLOC_CTX *mem_ctx,
+                    struct tevent_context *ev,
+                    struct be_ctx *be_ctx,
+                    struct be_ptask *be_ptask,
+                    void *pvt)
+{
+    return sysdb_checkpoint(be_ctx->domain->sysdb);
+}
+
 static int get_offline_timeout(struct be_ctx *ctx)
 {
     errno_t ret;
@@ -441,8 +454,64 @@ be_register_monitor_iface(struct sbus_connection *conn, struct be_ctx *be_ctx)
         {SSS_BUS_PATH, &iface_service},
         {NULL, NULL}
     };
+    errno_t ret;
 
-    return sbus_connection_add_path_map(be_ctx->mon_conn, paths);
+    ret = sbus_connection_add_path_map(be_ctx->mon_conn, paths);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sss_iface_register_metrics(be_ctx->mon_conn);
+}
+
+static errno_t be_init_ptask_spread(struct be_ctx *be_ctx)
+{
+    char id[HOST_NAME_MAX + 1] = { '\0' };
+    int spread;
+    FILE *f;
+    errno_t ret;
+
+    ret = confdb_get_int(be_ctx->cdb, be_ctx->conf_path,
+                         CONFDB_DOMAIN_PERIODIC_TASK_SPREAD, 0, &spread);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to get the value of %s\n",
+              CONFDB_DOMAIN_PERIODIC_TASK_SPREAD);
+        return ret;
+    }
+
+    if (spread <= 0) {
+        return EOK;
+    }
+
+    /* The machine ID is unique and does not change, the host name is the
+     * best replacement if it is not available. */
+    f = fopen(MACHINE_ID_PATH, "r");
+    if (f != NULL) {
+        if (fgets(id, sizeof(id), f) == NULL) {
+            id[0] = '\0';
+        }
+        fclose(f);
+    }
+
+    if (id[0] == '\0' || id[0] == '\n') {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to read %s, using host name "
+              "to spread periodic tasks\n", MACHINE_ID_PATH);
+        ret = gethostname(id, sizeof(id) - 1);
+        if (ret != 0) {
+            ret = errno;
+            DEBUG(SSSDBG_OP_FAILURE, "gethostname failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            return ret;
+        }
+    }
+
+    be_ctx->ptask_spread = spread;
+    be_ctx->ptask_host_seed = murmurhash3(id, strlen(id), 0xdeadbeef);
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Periodic tasks are spread over %d "
+          "seconds\n", spread);
+
+    return EOK;
 }
 
 static void dp_initialized(struct tevent_req *req);
@@ -457,6 +526,7 @@ errno_t be_process_init(TALLOC_CTX *mem_ctx,
     struct tevent_req *req;
     struct be_ctx *be_ctx;
     char *str = NULL;
+    int batch_size;
     errno_t ret;
 
     be_ctx = talloc_zero(mem_ctx, struct be_ctx);
@@ -496,6 +566,46 @@ errno_t be_process_init(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    ret = confdb_get_int(cdb, be_ctx->conf_path,
+                         CONFDB_DOMAIN_CACHE_WRITE_BATCH, 1, &batch_size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to get the value of %s\n",
+              CONFDB_DOMAIN_CACHE_WRITE_BATCH);
+        goto done;
+    }
+
+    if (batch_size > 1) {
+        ret = sysdb_set_write_batch(be_ctx->domain->sysdb, ev, batch_size);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Unable to set up cache write "
+                  "batches [%d]: %s\n", ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
+    ret = be_init_ptask_spread(be_ctx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (be_ctx->domain->cache_checkpoint_interval > 0) {
+        ret = be_ptask_create_sync(be_ctx, be_ctx,
+                                   be_ctx->domain->cache_checkpoint_interval,
+                                   be_ctx->domain->cache_checkpoint_interval,
+                                   0, 0, 0, 0,
+                                   be_cache_checkpoint, NULL,
+                                   "Cache checkpoint",
+                                   BE_PTASK_OFFLINE_EXECUTE |
+                                   BE_PTASK_SCHEDULE_FROM_NOW,
+                                   NULL);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Unable to initialize cache "
+                  "checkpoint periodic task [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+    }
+
     /* We need this for subdomains support, as they have to store fully
      * qualified user and group names for now. */
     ret = sss_names_init(be_ctx->domain, cdb, be_ctx->domain->name,
@@ -772,7 +882,8 @@ data_provider_reset_offline(TALLOC_CTX *mem_ctx,
                             struct sbus_request *sbus_req,
                             struct be_ctx *be_ctx)
 {
-    check_if_online(be_ctx, 1);
+    /* The monitor already waits until the network status settles. */
+    check_if_online(be_ctx, 0);
 
     return EOK;
 }
@@ -44,12 +44,36 @@ int be_fo_is_srv_identifier(const char *server)
 static int be_fo_get_options(struct be_ctx *ctx,
                              struct fo_options *opts)
 {
+    int probe_servers;
+    int slow_server;
+    errno_t ret;
+
     opts->service_resolv_timeout = dp_opt_get_int(ctx->be_res->opts,
                                                   DP_RES_OPT_RESOLVER_TIMEOUT);
     opts->retry_timeout = 30;
     opts->srv_retry_neg_timeout = 15;
     opts->family_order = ctx->be_res->family_order;
 
+    ret = confdb_get_int(ctx->cdb, ctx->conf_path,
+                         CONFDB_DOMAIN_FAILOVER_PROBE_SERVERS, 0,
+                         &probe_servers);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read %s [%d]: %s\n",
+              CONFDB_DOMAIN_FAILOVER_PROBE_SERVERS, ret, sss_strerror(ret));
+        return ret;
+    }
+    opts->probe_servers = probe_servers > 0 ? probe_servers : 0;
+
+    ret = confdb_get_int(ctx->cdb, ctx->conf_path,
+                         CONFDB_DOMAIN_FAILOVER_SLOW_SERVER, 0,
+                         &slow_server);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read %s [%d]: %s\n",
+              CONFDB_DOMAIN_FAILOVER_SLOW_SERVER, ret, sss_strerror(ret));
+        return ret;
+    }
+    opts->slow_server_msec = slow_server > 0 ? slow_server : 0;
+
     return EOK;
 }
 
@@ -721,6 +745,17 @@ void be_fo_try_next_server(struct be_ctx *ctx, const char *service_name)
     }
 }
 
+void be_fo_set_probe_port(struct be_ctx *ctx, const char *service_name,
+                          int port)
+{
+    struct be_svc_data *svc;
+
+    svc = be_fo_find_svc_data(ctx, service_name);
+    if (svc) {
+        fo_set_service_probe_port(svc->fo_service, port);
+    }
+}
+
 const char *be_fo_get_active_server_name(struct be_ctx *ctx,
                                          const char *service_name)
 {
@@ -837,6 +872,7 @@ static struct dp_option dp_res_default_opts[] = {
     { "dns_resolver_op_timeout", DP_OPT_NUMBER, { .number = 3 }, NULL_NUMBER },
     { "dns_resolver_server_timeout", DP_OPT_NUMBER, { .number = 1000 }, NULL_NUMBER },
     { "dns_discovery_domain", DP_OPT_STRING, NULL_STRING, NULL_STRING },
+    { "dns_resolver_cache_timeout", DP_OPT_NUMBER, { .number = 30 }, NULL_NUMBER },
     DP_OPTION_TERMINATOR
 };
 
@@ -905,5 +941,13 @@ errno_t be_res_init(struct be_ctx *ctx)
         return ret;
     }
 
+    ret = resolv_cache_init(ctx->be_res->resolv,
+                            dp_opt_get_int(ctx->be_res->opts,
+                                           DP_RES_OPT_CACHE_TIMEOUT));
+    if (ret != EOK) {
+        talloc_zfree(ctx->be_res);
+        return ret;
+    }
+
     return EOK;
 }
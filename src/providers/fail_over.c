@@ -24,6 +24,7 @@
 */
 
 #include <sys/time.h>
+#include <netinet/in.h>
 
 #include <errno.h>
 #include <stdbool.h>
@@ -33,6 +34,8 @@
 #include "util/dlinklist.h"
 #include "util/refcount.h"
 #include "util/util.h"
+#include "util/sss_sockets.h"
+#include "util/sss_metrics.h"
 #include "providers/fail_over.h"
 #include "resolv/async_resolv.h"
 
@@ -71,6 +74,9 @@ struct fo_service {
     struct fo_server *last_tried_server;
     struct fo_server *server_list;
 
+    /* Port to probe servers without a port on */
+    int probe_port;
+
     /* Function pointed by user_data_cmp returns 0 if user_data is equal
      * or nonzero value if not. Set to NULL if no user data comparison
      * is needed in fail over duplicate servers detection.
@@ -78,6 +84,16 @@ struct fo_service {
     datacmp_fn user_data_cmp;
 };
 
+/* Observed behaviour of a server, see fo_server_report_op() */
+struct fo_health {
+    /* moving averages, the error rate is in 1/1000 */
+    uint64_t latency_usec;
+    unsigned int error_rate;
+    unsigned int samples;
+    bool degraded;
+    struct timeval last_update;
+};
+
 struct fo_server {
     REFCOUNT_COMMON;
 
@@ -86,12 +102,14 @@ struct fo_server {
 
     bool primary;
     void *user_data;
+    void *tls_session;
     int port;
     enum port_status port_status;
     struct srv_data *srv_data;
     struct fo_service *service;
     struct timeval last_status_change;
     struct server_common *common;
+    struct fo_health health;
 
     TALLOC_CTX *fo_internal_owner;
 };
@@ -159,6 +177,8 @@ fo_context_init(TALLOC_CTX *mem_ctx, struct fo_options *opts)
     ctx->opts->retry_timeout = opts->retry_timeout;
     ctx->opts->family_order  = opts->family_order;
     ctx->opts->service_resolv_timeout = opts->service_resolv_timeout;
+    ctx->opts->probe_servers = opts->probe_servers;
+    ctx->opts->slow_server_msec = opts->slow_server_msec;
 
     DEBUG(SSSDBG_TRACE_FUNC,
           "Created new fail over context, retry timeout is %ld\n",
@@ -417,6 +437,37 @@ service_works(struct fo_server *server)
     return 1;
 }
 
+/* Samples needed before a server is judged. */
+#define FO_HEALTH_MIN_SAMPLES 8
+/* Weight of a new sample in the moving averages is 1/2^FO_HEALTH_SHIFT. */
+#define FO_HEALTH_SHIFT 3
+/* A server with more failed operations is degraded, in 1/1000. */
+#define FO_HEALTH_MAX_ERROR_RATE 250
+
+static bool
+server_degraded(struct fo_server *server)
+{
+    struct fo_health *health = &server->health;
+    struct timeval tv;
+
+    if (!health->degraded) {
+        return false;
+    }
+
+    /* A server that is not used is not measured either. Give it another
+     * chance after the retry timeout, as with a port that did not work. */
+    gettimeofday(&tv, NULL);
+    if (tv.tv_sec - health->last_update.tv_sec
+            > server->service->ctx->opts->retry_timeout) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Forgetting health of server '%s'\n",
+              SERVER_NAME(server));
+        memset(health, 0, sizeof(struct fo_health));
+        return false;
+    }
+
+    return true;
+}
+
 static int
 service_destructor(struct fo_service *service)
 {
@@ -573,6 +624,7 @@ fo_server_alloc(struct fo_service *service, int port,
 
     server->port = port;
     server->user_data = user_data;
+    server->tls_session = NULL;
     server->service = service;
     server->port_status = DEFAULT_PORT_STATUS;
     server->primary = primary;
@@ -870,14 +922,16 @@ void fo_ref_server(TALLOC_CTX *ref_ctx,
 }
 
 static int
-get_first_server_entity(struct fo_service *service, struct fo_server **_server)
+get_first_server_entity_ex(struct fo_service *service, bool use_degraded,
+                           struct fo_server **_server)
 {
     struct fo_server *server;
 
     /* If we already have a working server, use that one. */
     server = service->active_server;
     if (server != NULL) {
-        if (service_works(server) && fo_is_server_primary(server)) {
+        if (service_works(server) && fo_is_server_primary(server)
+                && (use_degraded || !server_degraded(server))) {
             goto done;
         }
         service->active_server = NULL;
@@ -893,7 +947,8 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
     if (service->last_tried_server != NULL &&
         service->last_tried_server->primary) {
         if (service->last_tried_server->port_status == PORT_NEUTRAL &&
-            server_works(service->last_tried_server)) {
+            server_works(service->last_tried_server) &&
+            (use_degraded || !server_degraded(service->last_tried_server))) {
             server = service->last_tried_server;
             goto done;
         }
@@ -902,7 +957,8 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
             /* Go only through primary servers */
             if (!server->primary) continue;
 
-            if (service_works(server)) {
+            if (service_works(server)
+                    && (use_degraded || !server_degraded(server))) {
                 goto done;
             }
         }
@@ -913,7 +969,8 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
         /* First iterate only over primary servers */
         if (!server->primary) continue;
 
-        if (service_works(server)) {
+        if (service_works(server)
+                && (use_degraded || !server_degraded(server))) {
             goto done;
         }
         if (server == service->last_tried_server) {
@@ -925,7 +982,8 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
         /* Now iterate only over backup servers */
         if (server->primary) continue;
 
-        if (service_works(server)) {
+        if (service_works(server)
+                && (use_degraded || !server_degraded(server))) {
             goto done;
         }
     }
@@ -939,6 +997,24 @@ done:
     return EOK;
 }
 
+static int
+get_first_server_entity(struct fo_service *service, struct fo_server **_server)
+{
+    struct fo_server *active = service->active_server;
+    struct fo_server *last_tried = service->last_tried_server;
+    int ret;
+
+    /* Slow or failing servers are only used if there is no other one. */
+    ret = get_first_server_entity_ex(service, false, _server);
+    if (ret == ENOENT) {
+        service->active_server = active;
+        service->last_tried_server = last_tried;
+        ret = get_first_server_entity_ex(service, true, _server);
+    }
+
+    return ret;
+}
+
 static int
 resolve_service_request_destructor(struct resolve_service_request *request)
 {
@@ -986,6 +1062,11 @@ struct resolve_service_state {
     struct tevent_context *ev;
     struct tevent_timer *timeout_handler;
     struct fo_ctx *fo_ctx;
+
+    /* servers probed at once */
+    struct fo_probe *probes;
+    size_t num_probes;
+    struct tevent_timer *probe_te;
 };
 
 static errno_t fo_resolve_service_activate_timeout(struct tevent_req *req,
@@ -993,6 +1074,7 @@ static errno_t fo_resolve_service_activate_timeout(struct tevent_req *req,
 static void fo_resolve_service_cont(struct tevent_req *subreq);
 static void fo_resolve_service_done(struct tevent_req *subreq);
 static bool fo_resolve_service_server(struct tevent_req *req);
+static bool fo_resolve_service_probe(struct tevent_req *req);
 
 /* Forward declarations for SRV resolving */
 static struct tevent_req *
@@ -1055,6 +1137,10 @@ fo_resolve_service_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
 
     /* This is a regular server, just do hostname lookup */
     state->server = server;
+    if (fo_resolve_service_probe(req)) {
+        return req;
+    }
+
     if (fo_resolve_service_server(req)) {
         tevent_req_post(req, ev);
     }
@@ -1125,6 +1211,10 @@ fo_resolve_service_cont(struct tevent_req *subreq)
         return;
     }
 
+    if (fo_resolve_service_probe(req)) {
+        return;
+    }
+
     fo_resolve_service_server(req);
 }
 
@@ -1243,6 +1333,367 @@ fo_resolve_service_recv(struct tevent_req *req,
     return EOK;
 }
 
+/*******************************************************************
+ * Probe several servers at once.                                  *
+ *******************************************************************/
+
+/* How long a working server waits for servers earlier in the list. */
+#define FO_PROBE_GRACE_MSEC 100
+
+struct fo_probe {
+    struct fo_server *server;
+    struct tevent_req *subreq;
+    bool finished;
+    errno_t ret;
+};
+
+static int fo_probe_port(struct fo_server *server)
+{
+    return server->port != 0 ? server->port : server->service->probe_port;
+}
+
+void fo_set_service_probe_port(struct fo_service *service, int port)
+{
+    service->probe_port = port;
+}
+
+static struct tevent_req *
+fo_resolve_server_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                       struct resolv_ctx *resolv, struct fo_ctx *ctx,
+                       struct fo_server *server)
+{
+    struct resolve_service_state *state;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct resolve_service_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->resolv = resolv;
+    state->ev = ev;
+    state->fo_ctx = ctx;
+    state->server = server;
+
+    if (fo_resolve_service_server(req)) {
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static int fo_resolve_server_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+struct fo_probe_server_state {
+    struct tevent_context *ev;
+    struct fo_server *server;
+    int timeout;
+};
+
+static void fo_probe_server_resolved(struct tevent_req *subreq);
+static void fo_probe_server_connected(struct tevent_req *subreq);
+
+static struct tevent_req *
+fo_probe_server_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                     struct resolv_ctx *resolv, struct fo_ctx *ctx,
+                     struct fo_server *server)
+{
+    struct fo_probe_server_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct fo_probe_server_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->server = server;
+    state->timeout = ctx->opts->service_resolv_timeout;
+
+    subreq = fo_resolve_server_send(state, ev, resolv, ctx, server);
+    if (subreq == NULL) {
+        talloc_zfree(req);
+        return NULL;
+    }
+    tevent_req_set_callback(subreq, fo_probe_server_resolved, req);
+
+    return req;
+}
+
+static void fo_probe_server_resolved(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct fo_probe_server_state *state = tevent_req_data(req,
+                                            struct fo_probe_server_state);
+    struct sockaddr_storage *addr;
+    socklen_t addr_len;
+    errno_t ret;
+
+    ret = fo_resolve_server_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    addr = resolv_get_sockaddr_address(state,
+                                       state->server->common->rhostent,
+                                       fo_probe_port(state->server));
+    if (addr == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot get the address of server '%s'\n",
+              SERVER_NAME(state->server));
+        tevent_req_error(req, EIO);
+        return;
+    }
+
+    addr_len = addr->ss_family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                           : sizeof(struct sockaddr_in);
+
+    subreq = sssd_async_socket_init_send(state, state->ev, addr, addr_len,
+                                         state->timeout);
+    if (subreq == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+    tevent_req_set_callback(subreq, fo_probe_server_connected, req);
+}
+
+static void fo_probe_server_connected(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct fo_probe_server_state *state = tevent_req_data(req,
+                                            struct fo_probe_server_state);
+    errno_t ret;
+    int sd;
+
+    ret = sssd_async_socket_init_recv(subreq, &sd);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Server '%s' port %d does not accept "
+              "connections [%d]: %s\n", SERVER_NAME(state->server),
+              fo_probe_port(state->server), ret, sss_strerror(ret));
+        fo_set_port_status(state->server, PORT_NOT_WORKING);
+        tevent_req_error(req, EAGAIN);
+        return;
+    }
+
+    /* The caller opens its own connection. */
+    close(sd);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Server '%s' accepts connections\n",
+          SERVER_NAME(state->server));
+
+    tevent_req_done(req);
+}
+
+static int fo_probe_server_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+static void fo_resolve_service_probe_done(struct tevent_req *subreq);
+
+/* Returns false and leaves the request to the plain name resolution if
+ * there are not enough servers to probe. */
+static bool
+fo_resolve_service_probe(struct tevent_req *req)
+{
+    struct resolve_service_state *state = tevent_req_data(req,
+                                        struct resolve_service_state);
+    unsigned int max_probes = state->fo_ctx->opts->probe_servers;
+    struct fo_server *first = state->server;
+    struct fo_server *server;
+    struct fo_probe *probe;
+    size_t i;
+
+    if (max_probes < 2 || first->port_status != PORT_NEUTRAL
+            || fo_probe_port(first) == 0) {
+        return false;
+    }
+
+    state->probes = talloc_zero_array(state, struct fo_probe, max_probes);
+    if (state->probes == NULL) {
+        return false;
+    }
+
+    /* The list is ordered by priority and weight already. */
+    state->probes[0].server = first;
+    state->num_probes = 1;
+    DLIST_FOR_EACH(server, first->next) {
+        if (state->num_probes == max_probes) {
+            break;
+        }
+
+        if (server->primary != first->primary
+                || fo_is_srv_lookup(server)
+                || fo_probe_port(server) == 0
+                || !service_works(server)
+                || server->port_status != PORT_NEUTRAL) {
+            continue;
+        }
+
+        state->probes[state->num_probes].server = server;
+        state->num_probes++;
+    }
+
+    if (state->num_probes < 2) {
+        talloc_zfree(state->probes);
+        state->num_probes = 0;
+        return false;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Probing %zu servers of service '%s'\n",
+          state->num_probes, first->service->name);
+
+    for (i = 0; i < state->num_probes; i++) {
+        probe = &state->probes[i];
+
+        probe->subreq = fo_probe_server_send(state, state->ev, state->resolv,
+                                             state->fo_ctx, probe->server);
+        if (probe->subreq == NULL) {
+            while (i > 0) {
+                i--;
+                talloc_zfree(state->probes[i].subreq);
+            }
+            talloc_zfree(state->probes);
+            state->num_probes = 0;
+            return false;
+        }
+        tevent_req_set_callback(probe->subreq, fo_resolve_service_probe_done,
+                                req);
+    }
+
+    /* Every probe has its own timeout. */
+    talloc_zfree(state->timeout_handler);
+
+    return true;
+}
+
+static void
+fo_resolve_service_probe_finish(struct tevent_req *req, struct fo_probe *best)
+{
+    struct resolve_service_state *state = tevent_req_data(req,
+                                        struct resolve_service_state);
+    size_t i;
+
+    talloc_zfree(state->probe_te);
+    for (i = 0; i < state->num_probes; i++) {
+        talloc_zfree(state->probes[i].subreq);
+    }
+
+    if (best == NULL) {
+        /* All probed servers were marked as not working, the caller
+         * will ask for the next ones. */
+        state->server = state->probes[0].server;
+        tevent_req_error(req, EAGAIN);
+        return;
+    }
+
+    state->server = best->server;
+    state->server->service->last_tried_server = best->server;
+    tevent_req_done(req);
+}
+
+/* Returns the first working server in the list order. Tells whether some
+ * of the servers before it were not probed yet. */
+static struct fo_probe *
+fo_resolve_service_probe_best(struct resolve_service_state *state,
+                              bool *_pending)
+{
+    size_t i;
+
+    *_pending = false;
+    for (i = 0; i < state->num_probes; i++) {
+        if (!state->probes[i].finished) {
+            *_pending = true;
+            continue;
+        }
+
+        if (state->probes[i].ret == EOK) {
+            return &state->probes[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void
+fo_resolve_service_probe_grace(struct tevent_context *ev,
+                               struct tevent_timer *te,
+                               struct timeval tv,
+                               void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct resolve_service_state *state = tevent_req_data(req,
+                                        struct resolve_service_state);
+    bool pending;
+
+    state->probe_te = NULL;
+
+    fo_resolve_service_probe_finish(req,
+                            fo_resolve_service_probe_best(state, &pending));
+}
+
+static void
+fo_resolve_service_probe_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct resolve_service_state *state = tevent_req_data(req,
+                                        struct resolve_service_state);
+    struct fo_probe *probe = NULL;
+    struct fo_probe *best;
+    struct timeval tv;
+    bool pending;
+    size_t i;
+
+    for (i = 0; i < state->num_probes; i++) {
+        if (state->probes[i].subreq == subreq) {
+            probe = &state->probes[i];
+            break;
+        }
+    }
+
+    if (probe == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "BUG: Unknown probe finished\n");
+        talloc_free(subreq);
+        return;
+    }
+
+    probe->ret = fo_probe_server_recv(subreq);
+    probe->finished = true;
+    talloc_zfree(probe->subreq);
+
+    best = fo_resolve_service_probe_best(state, &pending);
+    if (!pending) {
+        fo_resolve_service_probe_finish(req, best);
+        return;
+    }
+
+    if (best == NULL || state->probe_te != NULL) {
+        return;
+    }
+
+    /* Give the servers with a higher priority a chance to answer. */
+
+    tv = tevent_timeval_current_ofs(0, FO_PROBE_GRACE_MSEC * 1000);
+    state->probe_te = tevent_add_timer(state->ev, state, tv,
+                                       fo_resolve_service_probe_grace, req);
+    if (state->probe_te == NULL) {
+        fo_resolve_service_probe_finish(req, best);
+    }
+}
+
 /*******************************************************************
  * Resolve the server to connect to using a SRV query.             *
  *******************************************************************/
@@ -1531,7 +1982,14 @@ fo_set_port_status(struct fo_server *server, enum port_status status)
     gettimeofday(&server->last_status_change, NULL);
     if (status == PORT_WORKING) {
         fo_set_server_status(server, SERVER_WORKING);
+        if (server->service->active_server != server) {
+            sss_metrics_inc(SSS_METRIC_FAILOVER_SWITCHES, 1,
+                            server->service->name);
+        }
         server->service->active_server = server;
+    } else if (status == PORT_NOT_WORKING) {
+        sss_metrics_inc(SSS_METRIC_FAILOVER_FAILURES, 1,
+                        server->service->name);
     }
 
     if (!server->common || !server->common->name) return;
@@ -1551,6 +2009,94 @@ fo_set_port_status(struct fo_server *server, enum port_status status)
     }
 }
 
+static bool fo_service_has_healthy_server(struct fo_service *service,
+                                          struct fo_server *server)
+{
+    struct fo_server *siter;
+
+    DLIST_FOR_EACH(siter, service->server_list) {
+        if (siter == server || fo_is_srv_lookup(siter)
+                || siter->primary != server->primary) {
+            continue;
+        }
+
+        if (service_works(siter) && !server_degraded(siter)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool fo_server_report_op(struct fo_server *server,
+                         uint64_t latency_usec,
+                         bool failed)
+{
+    struct fo_health *health;
+    uint64_t threshold;
+    unsigned int error;
+    bool degraded;
+
+    if (server == NULL || server->service->ctx->opts->slow_server_msec == 0) {
+        return false;
+    }
+
+    health = &server->health;
+    threshold = (uint64_t)server->service->ctx->opts->slow_server_msec * 1000;
+    error = failed ? 1000 : 0;
+
+    if (health->samples == 0) {
+        health->latency_usec = latency_usec;
+        health->error_rate = error;
+    } else {
+        health->latency_usec += ((int64_t)latency_usec
+                                 - (int64_t)health->latency_usec)
+                                >> FO_HEALTH_SHIFT;
+        health->error_rate += ((int)error - (int)health->error_rate)
+                              >> FO_HEALTH_SHIFT;
+    }
+    if (health->samples < FO_HEALTH_MIN_SAMPLES) {
+        health->samples++;
+    }
+    gettimeofday(&health->last_update, NULL);
+
+    if (health->samples < FO_HEALTH_MIN_SAMPLES) {
+        return false;
+    }
+
+    /* A degraded server has to get clearly better to be used again. */
+    if (health->degraded) {
+        degraded = health->latency_usec > threshold * 3 / 4
+                   || health->error_rate > FO_HEALTH_MAX_ERROR_RATE / 2;
+    } else {
+        degraded = health->latency_usec > threshold
+                   || health->error_rate > FO_HEALTH_MAX_ERROR_RATE;
+    }
+
+    if (degraded == health->degraded) {
+        return false;
+    }
+
+    health->degraded = degraded;
+    DEBUG(degraded ? SSSDBG_MINOR_FAILURE : SSSDBG_TRACE_FUNC,
+          "Server '%s' is %s, average latency %"PRIu64" ms, "
+          "%u.%u%% operations failed\n", SERVER_NAME(server),
+          degraded ? "degraded" : "healthy again",
+          health->latency_usec / 1000,
+          health->error_rate / 10, health->error_rate % 10);
+
+    if (!degraded || !fo_service_has_healthy_server(server->service, server)) {
+        return false;
+    }
+
+    /* Look for a better server on the next connection. */
+    if (server->service->active_server == server) {
+        server->service->active_server = NULL;
+    }
+
+    return true;
+}
+
 struct fo_server *fo_get_active_server(struct fo_service *service)
 {
     return service->active_server;
@@ -1583,6 +2129,23 @@ fo_get_server_user_data(struct fo_server *server)
     return server->user_data;
 }
 
+void *
+fo_get_server_tls_session(struct fo_server *server)
+{
+    return server->tls_session;
+}
+
+void
+fo_set_server_tls_session(struct fo_server *server, void *tls_session)
+{
+    if (server->tls_session == tls_session) {
+        return;
+    }
+
+    talloc_free(server->tls_session);
+    server->tls_session = talloc_steal(server, tls_session);
+}
+
 int
 fo_get_server_port(struct fo_server *server)
 {
@@ -76,12 +76,23 @@ struct fo_server;
  *
  * The family_order member specifies the order of address families to
  * try when looking up the service.
+ *
+ * The 'probe_servers' member specifies how many servers that were not tried
+ * yet are resolved and probed with a TCP connection at the same time. The
+ * first one that accepts the connection is returned. Servers are tried one
+ * by one if it is less than 2.
+ *
+ * The 'slow_server_msec' member specifies the average latency of operations
+ * above which a server is considered degraded, see fo_server_report_op().
+ * The health of servers is not tracked if it is 0.
  */
 struct fo_options {
     time_t srv_retry_neg_timeout;
     time_t retry_timeout;
     int service_resolv_timeout;
     enum restrict_family family_order;
+    unsigned int probe_servers;
+    unsigned int slow_server_msec;
 };
 
 /*
@@ -135,6 +146,12 @@ int fo_add_srv_server(struct fo_service *service,
                       const char *proto,
                       void *user_data);
 
+/*
+ * Sets the port servers of the 'service' without an explicit port are probed
+ * on. Such servers are never probed if it is 0, which is the default.
+ */
+void fo_set_service_probe_port(struct fo_service *service, int port);
+
 /*
  * Request the first server from the service's list of servers. It is only
  * considered if it is not marked as not working (or the retry interval already
@@ -188,6 +205,15 @@ void fo_try_next_server(struct fo_service *service);
 
 void *fo_get_server_user_data(struct fo_server *server);
 
+/*
+ * TLS session data the client keeps for the server, e.g. to resume TLS
+ * sessions on reconnect. The data is a talloc pointer, it is stolen by
+ * the server and freed together with it or when it is replaced.
+ */
+void *fo_get_server_tls_session(struct fo_server *server);
+
+void fo_set_server_tls_session(struct fo_server *server, void *tls_session);
+
 int fo_get_server_port(struct fo_server *server);
 
 const char *fo_get_server_name(struct fo_server *server);
@@ -210,6 +236,19 @@ void fo_reset_servers(struct fo_service *svc);
 
 struct fo_server *fo_get_active_server(struct fo_service *service);
 
+/*
+ * Report how long an operation on the server took and whether the server
+ * failed it. A server whose average latency or error rate gets too high is
+ * degraded; other servers are preferred over it until it recovers or the
+ * retry timeout passes without new reports.
+ *
+ * Returns true if the server just became degraded and a better server is
+ * available, so that the caller may reconnect.
+ */
+bool fo_server_report_op(struct fo_server *server,
+                         uint64_t latency_usec,
+                         bool failed);
+
 bool fo_svc_has_server(struct fo_service *service, struct fo_server *server);
 
 const char **fo_svc_server_list(TALLOC_CTX *mem_ctx,
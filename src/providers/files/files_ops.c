@@ -19,6 +19,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #include "config.h"
 
@@ -26,12 +28,15 @@
 #include "db/sysdb.h"
 #include "util/inotify.h"
 #include "util/util.h"
+#include "util/atomic_io.h"
+#include "util/strtonum.h"
+#include "util/sss_budget.h"
+#include "util/sss_ptr_hash.h"
 #include "providers/data_provider/dp_iface.h"
 
-/* When changing this constant, make sure to also adjust the files integration
- * test for reallocation branch
- */
-#define FILES_REALLOC_CHUNK 64
+/* The files are read at once, the buffer only grows if they are appended to
+ * while being read. */
+#define FILES_READ_CHUNK    4096
 
 #define PWD_MAXSIZE         1024
 #define GRP_MAXSIZE         2048
@@ -44,82 +49,292 @@ struct files_ctx {
     struct files_ops_ctx *ops;
 };
 
-static errno_t enum_files_users(TALLOC_CTX *mem_ctx,
-                                const char *passwd_file,
-                                struct passwd ***_users)
+/* Reads the whole file into one buffer, the entries are parsed in place. The
+ * file is not mapped into memory, because it might be truncated while it is
+ * parsed. */
+static errno_t sf_read_file(TALLOC_CTX *mem_ctx,
+                            const char *filename,
+                            char **_buf,
+                            size_t *_num_lines)
 {
-    errno_t ret, close_ret;
-    struct passwd *pwd_iter = NULL;
-    struct passwd *pwd = NULL;
-    struct passwd **users = NULL;
-    FILE *pwd_handle = NULL;
-    size_t n_users = 0;
+    errno_t ret;
+    struct stat st;
+    char *buf = NULL;
+    size_t size;
+    size_t len = 0;
+    size_t num_lines = 1;
+    ssize_t n;
+    int fd;
+
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot open file %s [%d]\n", filename, ret);
+        return ret;
+    }
 
-    pwd_handle = fopen(passwd_file, "r");
-    if (pwd_handle == NULL) {
+    ret = fstat(fd, &st);
+    if (ret == -1) {
         ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE,
-              "Cannot open passwd file %s [%d]\n",
-              passwd_file, ret);
+              "Cannot stat file %s [%d]\n", filename, ret);
         goto done;
     }
 
-    users = talloc_zero_array(mem_ctx, struct passwd *,
-                              FILES_REALLOC_CHUNK);
-    if (users == NULL) {
+    size = st.st_size + 1;
+    buf = talloc_size(mem_ctx, size);
+    if (buf == NULL) {
         ret = ENOMEM;
         goto done;
     }
 
-    while ((pwd_iter = fgetpwent(pwd_handle)) != NULL) {
-        /* FIXME - we might want to support paging of sorts to avoid allocating
-         * all users atop a memory context or only return users that differ from
-         * the local storage as a diff to minimize memory spikes
-         */
-        DEBUG(SSSDBG_TRACE_LIBS,
-              "User found (%s, %s, %"SPRIuid", %"SPRIgid", %s, %s, %s)\n",
-              pwd_iter->pw_name, pwd_iter->pw_passwd,
-              pwd_iter->pw_uid, pwd_iter->pw_gid,
-              pwd_iter->pw_gecos, pwd_iter->pw_dir,
-              pwd_iter->pw_shell);
+    while (1) {
+        if (len + 1 >= size) {
+            /* the file grew since it was stat-ed */
+            size += FILES_READ_CHUNK;
+            buf = talloc_realloc_size(mem_ctx, buf, size);
+            if (buf == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
 
-        pwd = talloc_zero(users, struct passwd);
-        if (pwd == NULL) {
-            ret = ENOMEM;
+        n = sss_atomic_read_s(fd, buf + len, size - len - 1);
+        if (n == -1) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot read file %s [%d]\n", filename, ret);
             goto done;
+        } else if (n == 0) {
+            break;
         }
+        len += n;
+    }
+    buf[len] = '\0';
 
-        pwd->pw_uid = pwd_iter->pw_uid;
-        pwd->pw_gid = pwd_iter->pw_gid;
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == '\n') {
+            num_lines++;
+        }
+    }
 
-        pwd->pw_name = talloc_strdup(pwd, pwd_iter->pw_name);
-        if (pwd->pw_name == NULL) {
-            /* We only check pw_name here on purpose to allow broken
-             * records to be optionally rejected when saving them
-             * or fallback values to be used.
-             */
-            ret = ENOMEM;
-            goto done;
+    *_buf = buf;
+    *_num_lines = num_lines;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(buf);
+    }
+    close(fd);
+    return ret;
+}
+
+/* Returns the next line which is not empty, a comment or a NIS compat
+ * entry, or NULL at the end of the buffer. */
+static char *sf_next_line(char **_pos)
+{
+    char *line;
+    char *end;
+
+    while (*_pos != NULL) {
+        line = *_pos;
+        end = strchr(line, '\n');
+        if (end != NULL) {
+            *end = '\0';
+            *_pos = end + 1;
+        } else {
+            *_pos = NULL;
         }
 
-        pwd->pw_dir = talloc_strdup(pwd, pwd_iter->pw_dir);
-        pwd->pw_gecos = talloc_strdup(pwd, pwd_iter->pw_gecos);
-        pwd->pw_shell = talloc_strdup(pwd, pwd_iter->pw_shell);
-        pwd->pw_passwd = talloc_strdup(pwd, pwd_iter->pw_passwd);
+        while (isspace((unsigned char)*line)) {
+            line++;
+        }
 
-        users[n_users] = pwd;
-        n_users++;
-        if (n_users % FILES_REALLOC_CHUNK == 0) {
-            users = talloc_realloc(mem_ctx,
-                                   users,
-                                   struct passwd *,
-                                   talloc_array_length(users) + FILES_REALLOC_CHUNK);
-            if (users == NULL) {
+        if (*line == '\0' || *line == '#' || *line == '+' || *line == '-') {
+            continue;
+        }
+
+        return line;
+    }
+
+    return NULL;
+}
+
+/* Cuts the next field off the line. The last field ends with the line, if
+ * the line has no more fields NULL is returned. */
+static char *sf_next_field(char **_pos, char sep)
+{
+    char *field = *_pos;
+    char *end;
+
+    if (field == NULL) {
+        return NULL;
+    }
+
+    end = strchr(field, sep);
+    if (end != NULL) {
+        *end = '\0';
+        *_pos = end + 1;
+    } else {
+        *_pos = NULL;
+    }
+
+    return field;
+}
+
+static errno_t sf_parse_id(const char *str, uint32_t *_id)
+{
+    char *endptr;
+    uint32_t id;
+
+    if (*str == '\0') {
+        return EINVAL;
+    }
+
+    errno = 0;
+    id = strtouint32(str, &endptr, 10);
+    if (errno != 0 || *endptr != '\0') {
+        return EINVAL;
+    }
+
+    *_id = id;
+    return EOK;
+}
+
+static errno_t sf_parse_passwd_line(char *line, struct passwd *pwd)
+{
+    char *pos = line;
+    char *uid;
+    char *gid;
+    errno_t ret;
+
+    pwd->pw_name = sf_next_field(&pos, ':');
+    pwd->pw_passwd = sf_next_field(&pos, ':');
+    uid = sf_next_field(&pos, ':');
+    gid = sf_next_field(&pos, ':');
+    pwd->pw_gecos = sf_next_field(&pos, ':');
+    pwd->pw_dir = sf_next_field(&pos, ':');
+    /* the shell is the rest of the line */
+    pwd->pw_shell = pos;
+
+    if (pwd->pw_dir == NULL || *pwd->pw_name == '\0') {
+        return EINVAL;
+    }
+
+    ret = sf_parse_id(uid, &pwd->pw_uid);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sf_parse_id(gid, &pwd->pw_gid);
+}
+
+static errno_t sf_parse_group_line(TALLOC_CTX *mem_ctx,
+                                   char *line,
+                                   struct group *grp)
+{
+    char *pos = line;
+    char *gid;
+    char *member;
+    size_t nmem = 0;
+    errno_t ret;
+
+    grp->gr_name = sf_next_field(&pos, ':');
+    grp->gr_passwd = sf_next_field(&pos, ':');
+    gid = sf_next_field(&pos, ':');
+    if (gid == NULL || *grp->gr_name == '\0') {
+        return EINVAL;
+    }
+
+    ret = sf_parse_id(gid, &grp->gr_gid);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (pos != NULL) {
+        for (char *c = pos; *c != '\0'; c++) {
+            if (*c == ',') {
+                nmem++;
+            }
+        }
+        nmem++;
+    }
+
+    grp->gr_mem = talloc_zero_array(mem_ctx, char *, nmem + 1);
+    if (grp->gr_mem == NULL) {
+        return ENOMEM;
+    }
+
+    nmem = 0;
+    while ((member = sf_next_field(&pos, ',')) != NULL) {
+        if (*member != '\0') {
+            grp->gr_mem[nmem] = member;
+            nmem++;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t enum_files_users(TALLOC_CTX *mem_ctx,
+                                const char *passwd_file,
+                                struct passwd ***_users)
+{
+    errno_t ret;
+    struct passwd *pwd = NULL;
+    struct passwd **users = NULL;
+    size_t n_users = 0;
+    size_t num_lines;
+    char *buf;
+    char *pos;
+    char *line;
+
+    ret = sf_read_file(mem_ctx, passwd_file, &buf, &num_lines);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    users = talloc_zero_array(mem_ctx, struct passwd *, num_lines + 1);
+    if (users == NULL) {
+        talloc_free(buf);
+        return ENOMEM;
+    }
+    /* The entries point into the buffer. */
+    talloc_steal(users, buf);
+
+    pos = buf;
+    while ((line = sf_next_line(&pos)) != NULL) {
+        if (pwd == NULL) {
+            pwd = talloc_zero(users, struct passwd);
+            if (pwd == NULL) {
                 ret = ENOMEM;
                 goto done;
             }
         }
+
+        ret = sf_parse_passwd_line(line, pwd);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Skipping malformed entry in %s\n", passwd_file);
+            /* the structure is reused for the next line */
+            memset(pwd, 0, sizeof(struct passwd));
+            continue;
+        }
+
+        DEBUG(SSSDBG_TRACE_LIBS,
+              "User found (%s, %s, %"SPRIuid", %"SPRIgid", %s, %s, %s)\n",
+              pwd->pw_name, pwd->pw_passwd,
+              pwd->pw_uid, pwd->pw_gid,
+              pwd->pw_gecos, pwd->pw_dir,
+              pwd->pw_shell);
+
+        users[n_users] = pwd;
+        n_users++;
+        pwd = NULL;
     }
+    talloc_free(pwd);
 
     ret = EOK;
     users[n_users] = NULL;
@@ -128,16 +343,6 @@ done:
     if (ret != EOK) {
         talloc_free(users);
     }
-
-    if (pwd_handle) {
-        close_ret = fclose(pwd_handle);
-        if (close_ret != 0) {
-            close_ret = errno;
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Cannot close passwd file %s [%d]\n",
-                  passwd_file, close_ret);
-        }
-    }
     return ret;
 }
 
@@ -145,84 +350,52 @@ static errno_t enum_files_groups(TALLOC_CTX *mem_ctx,
                                  const char *group_file,
                                  struct group ***_groups)
 {
-    errno_t ret, close_ret;
-    struct group *grp_iter = NULL;
+    errno_t ret;
     struct group *grp = NULL;
     struct group **groups = NULL;
     size_t n_groups = 0;
-    FILE *grp_handle = NULL;
+    size_t num_lines;
+    char *buf;
+    char *pos;
+    char *line;
 
-    grp_handle = fopen(group_file, "r");
-    if (grp_handle == NULL) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Cannot open group file %s [%d]\n",
-              group_file, ret);
-        goto done;
+    ret = sf_read_file(mem_ctx, group_file, &buf, &num_lines);
+    if (ret != EOK) {
+        return ret;
     }
 
-    groups = talloc_zero_array(mem_ctx, struct group *,
-                               FILES_REALLOC_CHUNK);
+    groups = talloc_zero_array(mem_ctx, struct group *, num_lines + 1);
     if (groups == NULL) {
-        ret = ENOMEM;
-        goto done;
+        talloc_free(buf);
+        return ENOMEM;
     }
+    /* The entries point into the buffer. */
+    talloc_steal(groups, buf);
 
-    while ((grp_iter = fgetgrent(grp_handle)) != NULL) {
-        DEBUG(SSSDBG_TRACE_LIBS,
-              "Group found (%s, %"SPRIgid")\n",
-              grp_iter->gr_name, grp_iter->gr_gid);
-
+    pos = buf;
+    while ((line = sf_next_line(&pos)) != NULL) {
         grp = talloc_zero(groups, struct group);
         if (grp == NULL) {
             ret = ENOMEM;
             goto done;
         }
 
-        grp->gr_gid = grp_iter->gr_gid;
-        grp->gr_name = talloc_strdup(grp, grp_iter->gr_name);
-        if (grp->gr_name == NULL) {
-            /* We only check gr_name here on purpose to allow broken
-             * records to be optionally rejected when saving them
-             * or fallback values to be used.
-             */
-            ret = ENOMEM;
+        ret = sf_parse_group_line(grp, line, grp);
+        if (ret == ENOMEM) {
             goto done;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Skipping malformed entry in %s\n", group_file);
+            talloc_free(grp);
+            continue;
         }
-        grp->gr_passwd = talloc_strdup(grp, grp_iter->gr_passwd);
-
-        if (grp_iter->gr_mem != NULL) {
-            size_t nmem;
-
-            for (nmem = 0; grp_iter->gr_mem[nmem] != NULL; nmem++);
 
-            grp->gr_mem = talloc_zero_array(grp, char *, nmem + 1);
-            if (grp->gr_mem == NULL) {
-                ret = ENOMEM;
-                goto done;
-            }
-
-            for (nmem = 0; grp_iter->gr_mem[nmem] != NULL; nmem++) {
-                grp->gr_mem[nmem] = talloc_strdup(grp, grp_iter->gr_mem[nmem]);
-                if (grp->gr_mem[nmem] == NULL) {
-                    ret = ENOMEM;
-                    goto done;
-                }
-            }
-        }
+        DEBUG(SSSDBG_TRACE_LIBS,
+              "Group found (%s, %"SPRIgid")\n",
+              grp->gr_name, grp->gr_gid);
 
         groups[n_groups] = grp;
         n_groups++;
-        if (n_groups % FILES_REALLOC_CHUNK == 0) {
-            groups = talloc_realloc(mem_ctx,
-                                    groups,
-                                    struct group *,
-                                    talloc_array_length(groups) + FILES_REALLOC_CHUNK);
-            if (groups == NULL) {
-                ret = ENOMEM;
-                goto done;
-            }
-        }
     }
 
     ret = EOK;
@@ -232,82 +405,128 @@ done:
     if (ret != EOK) {
         talloc_free(groups);
     }
-
-    if (grp_handle) {
-        close_ret = fclose(grp_handle);
-        if (close_ret != 0) {
-            close_ret = errno;
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Cannot close group file %s [%d]\n",
-                  group_file, close_ret);
-        }
-    }
     return ret;
 }
 
-static errno_t delete_all_users(struct sss_domain_info *dom)
+/* An entry of the files, keyed by its internal name. */
+struct sf_entry {
+    char *fqname;
+    struct passwd *pw;
+    struct group *grp;
+};
+
+/* What was changed in the cache by an update of the files. */
+struct sf_changes {
+    char **users;
+    char **groups;
+    bool users_added;
+    bool groups_added;
+};
+
+static errno_t sf_add_entry(hash_table_t *table,
+                            struct sss_domain_info *dom,
+                            const char *name,
+                            struct passwd *pw,
+                            struct group *grp)
 {
-    TALLOC_CTX *tmp_ctx;
-    struct ldb_dn *base_dn;
+    struct sf_entry *entry;
+    struct sf_entry *old;
     errno_t ret;
 
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
-        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+    entry = talloc_zero(table, struct sf_entry);
+    if (entry == NULL) {
         return ENOMEM;
     }
 
-    base_dn = sysdb_user_base_dn(tmp_ctx, dom);
-    if (base_dn == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory!\n");
-        ret = ENOMEM;
-        goto done;
+    entry->fqname = sss_create_internal_fqname(entry, name, dom->name);
+    if (entry->fqname == NULL) {
+        talloc_free(entry);
+        return ENOMEM;
     }
 
-    ret = sysdb_delete_recursive(dom->sysdb, base_dn, true);
+    entry->pw = talloc_steal(entry, pw);
+    entry->grp = talloc_steal(entry, grp);
+
+    /* Entries of later files replace the earlier ones, the freed entry is
+     * removed from the table. */
+    old = sss_ptr_hash_lookup(table, entry->fqname, struct sf_entry);
+    talloc_free(old);
+
+    ret = sss_ptr_hash_add(table, entry->fqname, entry, struct sf_entry);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Unable to delete users subtree [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto done;
+        talloc_free(entry);
+        return ret;
     }
 
-    ret = EOK;
+    return EOK;
+}
 
-done:
-    talloc_free(tmp_ctx);
+static errno_t sf_remaining_entries(TALLOC_CTX *mem_ctx,
+                                    hash_table_t *table,
+                                    struct sf_entry ***_entries,
+                                    unsigned long *_count)
+{
+    struct sf_entry **entries;
+    hash_value_t *values;
+    unsigned long count;
+    unsigned long i;
+    int hret;
+
+    hret = hash_values(table, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        return ENOMEM;
+    }
 
-    return ret;
+    entries = talloc_zero_array(mem_ctx, struct sf_entry *, count + 1);
+    if (entries == NULL) {
+        free(values);
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        entries[i] = sss_ptr_get_value(&values[i], struct sf_entry);
+    }
+    free(values);
+
+    *_entries = entries;
+    *_count = count;
+    return EOK;
+}
+
+static bool sf_str_equal(const char *a, const char *b)
+{
+    /* Empty values are not stored */
+    if (a == NULL || *a == '\0') {
+        return b == NULL || *b == '\0';
+    }
+
+    return b != NULL && strcmp(a, b) == 0;
+}
+
+static bool sf_skip_user(struct passwd *pw)
+{
+    return strcmp(pw->pw_name, "root") == 0
+            || pw->pw_uid == 0
+            || pw->pw_gid == 0;
 }
 
 static errno_t save_file_user(struct files_id_ctx *id_ctx,
+                              const char *fqname,
                               struct passwd *pw)
 {
     errno_t ret;
-    char *fqname;
     TALLOC_CTX *tmp_ctx = NULL;
     const char *shell;
     const char *gecos;
     struct sysdb_attrs *attrs = NULL;
-
-    if (strcmp(pw->pw_name, "root") == 0
-            || pw->pw_uid == 0
-            || pw->pw_gid == 0) {
-        DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", pw->pw_name);
-        return EOK;
-    }
+    char *remove_attrs[4] = { NULL };
+    int num_remove = 0;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    fqname = sss_create_internal_fqname(tmp_ctx, pw->pw_name,
-                                        id_ctx->domain->name);
-    if (fqname == NULL) {
-        ret = ENOMEM;
-        goto done;
-    }
-
     attrs = sysdb_new_attrs(tmp_ctx);
     if (attrs == NULL) {
         ret = ENOMEM;
@@ -318,15 +537,23 @@ static errno_t save_file_user(struct files_id_ctx *id_ctx,
         shell = pw->pw_shell;
     } else {
         shell = NULL;
+        remove_attrs[num_remove++] = discard_const(SYSDB_SHELL);
     }
 
     if (pw->pw_gecos && pw->pw_gecos[0] != '\0') {
         gecos = pw->pw_gecos;
     } else {
         gecos = NULL;
+        remove_attrs[num_remove++] = discard_const(SYSDB_GECOS);
+    }
+
+    /* Only an empty password is stored. */
+    if (pw->pw_passwd == NULL || pw->pw_passwd[0] != '\0') {
+        remove_attrs[num_remove++] = discard_const(SYSDB_PWD);
     }
 
-    /* FIXME - optimize later */
+    /* An existing user is updated in place, so attributes which are not
+     * in the file any more are removed. */
     ret = sysdb_store_user(id_ctx->domain,
                            fqname,
                            pw->pw_passwd,
@@ -336,7 +563,7 @@ static errno_t save_file_user(struct files_id_ctx *id_ctx,
                            pw->pw_dir,
                            shell,
                            NULL, attrs,
-                           NULL, 0, 0);
+                           num_remove > 0 ? remove_attrs : NULL, 0, 0);
     if (ret != EOK) {
         goto done;
     }
@@ -347,6 +574,23 @@ done:
     return ret;
 }
 
+static bool sf_user_changed(struct passwd *pw, struct ldb_message *msg)
+{
+    const char *pwd;
+
+    pwd = ldb_msg_find_attr_as_string(msg, SYSDB_PWD, NULL);
+
+    return ldb_msg_find_attr_as_uint64(msg, SYSDB_UIDNUM, 0) != pw->pw_uid
+        || ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0) != pw->pw_gid
+        || !sf_str_equal(pw->pw_gecos,
+                         ldb_msg_find_attr_as_string(msg, SYSDB_GECOS, NULL))
+        || !sf_str_equal(pw->pw_dir,
+                         ldb_msg_find_attr_as_string(msg, SYSDB_HOMEDIR, NULL))
+        || !sf_str_equal(pw->pw_shell,
+                         ldb_msg_find_attr_as_string(msg, SYSDB_SHELL, NULL))
+        || (pw->pw_passwd != NULL && pw->pw_passwd[0] == '\0') != (pwd != NULL);
+}
+
 static errno_t refresh_override_attrs(struct files_id_ctx *id_ctx,
                                       enum sysdb_member_type type)
 {
@@ -418,7 +662,7 @@ static errno_t refresh_override_attrs(struct files_id_ctx *id_ctx,
             continue;
         }
 
-        ret = ldb_msg_add_empty(msg, SYSDB_OVERRIDE_DN, LDB_FLAG_MOD_ADD, NULL);
+        ret = ldb_msg_add_empty(msg, SYSDB_OVERRIDE_DN, LDB_FLAG_MOD_REPLACE, NULL);
         if (ret != LDB_SUCCESS) {
             DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_empty failed.\n");
             continue;
@@ -448,43 +692,232 @@ done:
     return ret;
 }
 
-static errno_t sf_enum_groups(struct files_id_ctx *id_ctx,
-                              const char *group_file);
+static int sf_strcmp_ptr(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static int sf_strcasecmp_ptr(const void *a, const void *b)
+{
+    return strcasecmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Compares the values of a cached attribute with the expected ones, ignoring
+ * their order and duplicates. */
+static bool sf_values_equal(TALLOC_CTX *mem_ctx,
+                            const char **expected,
+                            struct ldb_message_element *el,
+                            bool case_sensitive)
+{
+    int (*cmp)(const void *, const void *);
+    const char **cached = NULL;
+    const char **values = NULL;
+    size_t num_expected = 0;
+    size_t num_cached;
+    size_t i;
+    size_t j;
+    bool equal = false;
+
+    cmp = case_sensitive ? sf_strcmp_ptr : sf_strcasecmp_ptr;
+
+    if (expected != NULL) {
+        for (num_expected = 0; expected[num_expected] != NULL; num_expected++);
+    }
+    num_cached = el != NULL ? el->num_values : 0;
+
+    if (num_expected == 0 || num_cached == 0) {
+        return num_expected == num_cached;
+    }
+
+    values = talloc_memdup(mem_ctx, expected, num_expected * sizeof(char *));
+    cached = talloc_array(mem_ctx, const char *, num_cached);
+    if (values == NULL || cached == NULL) {
+        goto done;
+    }
+
+    for (i = 0; i < num_cached; i++) {
+        cached[i] = (const char *)el->values[i].data;
+    }
+
+    qsort(values, num_expected, sizeof(char *), cmp);
+    qsort(cached, num_cached, sizeof(char *), cmp);
+
+    i = 0;
+    j = 0;
+    while (i < num_expected && j < num_cached) {
+        if (cmp(&values[i], &cached[j]) != 0) {
+            goto done;
+        }
+
+        /* skip duplicates */
+        i++;
+        while (i < num_expected && cmp(&values[i], &values[i - 1]) == 0) {
+            i++;
+        }
+        j++;
+        while (j < num_cached && cmp(&cached[j], &cached[j - 1]) == 0) {
+            j++;
+        }
+    }
+
+    equal = (i == num_expected && j == num_cached);
+
+done:
+    talloc_free(values);
+    talloc_free(cached);
+    return equal;
+}
 
-errno_t sf_enum_users(struct files_id_ctx *id_ctx,
-                      const char *passwd_file)
+static errno_t sf_update_users(struct files_id_ctx *id_ctx,
+                               struct sf_changes *changes)
 {
+    const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM, SYSDB_GIDNUM,
+                            SYSDB_GECOS, SYSDB_HOMEDIR, SYSDB_SHELL,
+                            SYSDB_PWD, NULL };
+    struct sss_domain_info *dom = id_ctx->domain;
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *table;
+    struct passwd **users;
+    struct ldb_message **msgs = NULL;
+    struct sf_entry **entries;
+    struct sf_entry *entry;
+    unsigned long num_entries;
+    size_t count = 0;
+    const char *name;
+    bool saved = false;
     errno_t ret;
-    TALLOC_CTX *tmp_ctx = NULL;
-    struct passwd **users = NULL;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = enum_files_users(tmp_ctx, passwd_file, &users);
+    table = sss_ptr_hash_create(tmp_ctx, NULL, NULL);
+    if (table == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (size_t i = 0; id_ctx->passwd_files[i] != NULL; i++) {
+        ret = enum_files_users(tmp_ctx, id_ctx->passwd_files[i], &users);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "The file %s does not exist (yet), skipping\n",
+                  id_ctx->passwd_files[i]);
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot enumerate users from %s, aborting\n",
+                  id_ctx->passwd_files[i]);
+            goto done;
+        }
+
+        for (size_t j = 0; users[j] != NULL; j++) {
+            if (sf_skip_user(users[j])) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", users[j]->pw_name);
+                continue;
+            }
+
+            ret = sf_add_entry(table, dom, users[j]->pw_name, users[j], NULL);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+    }
+
+    ret = sysdb_search_users(tmp_ctx, dom, "("SYSDB_NAME"=*)", attrs,
+                             &count, &msgs);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to search cached users [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* Remove users which are not in the files any more first, their IDs
+     * might be reused by the new or changed ones. */
+    for (size_t i = 0; i < count; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        if (name == NULL
+                || sss_ptr_hash_has_key(table, name)) {
+            continue;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Removing user %s\n", name);
+        ret = sysdb_delete_user(dom, name, 0);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot remove user %s [%d]: %s\n",
+                  name, ret, sss_strerror(ret));
+            goto done;
+        }
+
+        ret = add_string_to_list(changes, name, &changes->users);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        if (name == NULL) {
+            continue;
+        }
+
+        entry = sss_ptr_hash_lookup(table, name, struct sf_entry);
+        if (entry == NULL) {
+            continue;
+        }
+
+        if (sf_user_changed(entry->pw, msgs[i])) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Updating user %s\n", name);
+            ret = save_file_user(id_ctx, entry->fqname, entry->pw);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Cannot save user %s: [%d]: %s\n",
+                      name, ret, sss_strerror(ret));
+            } else {
+                ret = add_string_to_list(changes, name,
+                                         &changes->users);
+                if (ret != EOK) {
+                    goto done;
+                }
+                saved = true;
+            }
+        }
+
+        talloc_free(entry);
+    }
+
+    /* What is left are users which are not cached yet. */
+    ret = sf_remaining_entries(tmp_ctx, table, &entries, &num_entries);
     if (ret != EOK) {
         goto done;
     }
 
-    for (size_t i = 0; users[i]; i++) {
-        ret = save_file_user(id_ctx, users[i]);
+    for (unsigned long i = 0; i < num_entries; i++) {
+        ret = save_file_user(id_ctx, entries[i]->fqname, entries[i]->pw);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
                   "Cannot save user %s: [%d]: %s\n",
-                  users[i]->pw_name, ret, sss_strerror(ret));
+                  entries[i]->pw->pw_name, ret, sss_strerror(ret));
             continue;
         }
+        changes->users_added = true;
+        saved = true;
     }
 
-    ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_USER);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_MINOR_FAILURE,
-              "Failed to refresh override attributes, "
-              "override values might not be available.\n");
+    if (saved) {
+        ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_USER);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Failed to refresh override attributes, "
+                  "override values might not be available.\n");
+        }
     }
 
+    DEBUG(SSSDBG_TRACE_FUNC, "%lu users added, %zu users changed or "
+          "removed\n", num_entries,
+          changes->users == NULL ? 0 : talloc_array_length(changes->users) - 1);
+
     ret = EOK;
 done:
     talloc_free(tmp_ctx);
@@ -524,131 +957,123 @@ done:
     return user_names;
 }
 
-static errno_t delete_all_groups(struct sss_domain_info *dom)
+static bool sf_skip_group(struct group *grp)
 {
-    TALLOC_CTX *tmp_ctx;
-    struct ldb_dn *base_dn;
-    errno_t ret;
+    return strcmp(grp->gr_name, "root") == 0
+            || grp->gr_gid == 0;
+}
 
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
-        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
-        return ENOMEM;
+/* Splits the members of a group into the cached users, which become real
+ * members, and the others, which become ghosts. */
+static errno_t sf_group_members(TALLOC_CTX *mem_ctx,
+                                struct files_id_ctx *id_ctx,
+                                struct group *grp,
+                                const char **cached_users,
+                                const char ***_members,
+                                const char ***_ghosts)
+{
+    char **fq_gr_files_mem;
+    const char **fq_gr_mem = NULL;
+    const char **ghosts = NULL;
+    unsigned mi = 0;
+    unsigned gi = 0;
+
+    if (grp->gr_mem == NULL || grp->gr_mem[0] == NULL) {
+        *_members = NULL;
+        *_ghosts = NULL;
+        return EOK;
     }
 
-    base_dn = sysdb_group_base_dn(tmp_ctx, dom);
-    if (base_dn == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory!\n");
-        ret = ENOMEM;
-        goto done;
+    fq_gr_files_mem = sss_create_internal_fqname_list(
+                                        mem_ctx,
+                                        (const char *const*) grp->gr_mem,
+                                        id_ctx->domain->name);
+    if (fq_gr_files_mem == NULL) {
+        return ENOMEM;
     }
 
-    ret = sysdb_delete_recursive(dom->sysdb, base_dn, true);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Unable to delete groups subtree [%d]: %s\n",
-              ret, sss_strerror(ret));
-        goto done;
+    fq_gr_mem = talloc_zero_array(mem_ctx, const char *,
+                                  talloc_array_length(fq_gr_files_mem));
+    ghosts = talloc_zero_array(mem_ctx, const char *,
+                               talloc_array_length(fq_gr_files_mem));
+    if (fq_gr_mem == NULL || ghosts == NULL) {
+        talloc_free(fq_gr_files_mem);
+        talloc_free(fq_gr_mem);
+        talloc_free(ghosts);
+        return ENOMEM;
     }
 
-    ret = EOK;
+    for (unsigned i=0; fq_gr_files_mem[i] != NULL; i++) {
+        if (string_in_list(fq_gr_files_mem[i],
+                           discard_const(cached_users),
+                           true)) {
+            fq_gr_mem[mi] = fq_gr_files_mem[i];
+            mi++;
 
-done:
-    talloc_free(tmp_ctx);
+            DEBUG(SSSDBG_TRACE_LIBS,
+                  "User %s is cached, will become a member of %s\n",
+                  fq_gr_files_mem[i], grp->gr_name);
+        } else {
+            ghosts[gi] = fq_gr_files_mem[i];
+            gi++;
 
-    return ret;
+            DEBUG(SSSDBG_TRACE_LIBS,
+                  "User %s is not cached, will become a ghost of %s\n",
+                  fq_gr_files_mem[i], grp->gr_name);
+        }
+    }
+
+    *_members = fq_gr_mem;
+    *_ghosts = ghosts;
+    return EOK;
 }
 
 static errno_t save_file_group(struct files_id_ctx *id_ctx,
+                               const char *fqname,
                                struct group *grp,
                                const char **cached_users)
 {
     errno_t ret;
-    char *fqname;
     struct sysdb_attrs *attrs = NULL;
     TALLOC_CTX *tmp_ctx = NULL;
-    char **fq_gr_files_mem;
     const char **fq_gr_mem;
-    unsigned mi = 0;
-
-    if (strcmp(grp->gr_name, "root") == 0
-            || grp->gr_gid == 0) {
-        DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", grp->gr_name);
-        return EOK;
-    }
+    const char **ghosts;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    fqname = sss_create_internal_fqname(tmp_ctx, grp->gr_name,
-                                        id_ctx->domain->name);
-    if (fqname == NULL) {
+    attrs = sysdb_new_attrs(tmp_ctx);
+    if (attrs == NULL) {
         ret = ENOMEM;
         goto done;
-
     }
 
-    attrs = sysdb_new_attrs(tmp_ctx);
-    if (attrs == NULL) {
-        ret = ENOMEM;
+    ret = sf_group_members(tmp_ctx, id_ctx, grp, cached_users,
+                           &fq_gr_mem, &ghosts);
+    if (ret != EOK) {
         goto done;
     }
 
-    if (grp->gr_mem && grp->gr_mem[0]) {
-        fq_gr_files_mem = sss_create_internal_fqname_list(
-                                            tmp_ctx,
-                                            (const char *const*) grp->gr_mem,
-                                            id_ctx->domain->name);
-        if (fq_gr_files_mem == NULL) {
-            ret = ENOMEM;
-            goto done;
+    for (unsigned i = 0; ghosts != NULL && ghosts[i] != NULL; i++) {
+        ret = sysdb_attrs_add_string(attrs, SYSDB_GHOST, ghosts[i]);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot add ghost %s for group %s\n",
+                  ghosts[i], fqname);
+            continue;
         }
+    }
 
-        fq_gr_mem = talloc_zero_array(tmp_ctx, const char *,
-                                      talloc_array_length(fq_gr_files_mem));
-        if (fq_gr_mem == NULL) {
-            ret = ENOMEM;
+    if (fq_gr_mem != NULL && fq_gr_mem[0] != NULL) {
+        ret = sysdb_attrs_users_from_str_list(
+                attrs, SYSDB_MEMBER, id_ctx->domain->name,
+                (const char *const *) fq_gr_mem);
+        if (ret) {
+            DEBUG(SSSDBG_OP_FAILURE, "Could not add group members\n");
             goto done;
         }
-
-        for (unsigned i=0; fq_gr_files_mem[i] != NULL; i++) {
-            if (string_in_list(fq_gr_files_mem[i],
-                               discard_const(cached_users),
-                               true)) {
-                fq_gr_mem[mi] = fq_gr_files_mem[i];
-                mi++;
-
-                DEBUG(SSSDBG_TRACE_LIBS,
-                      "User %s is cached, will become a member of %s\n",
-                      fq_gr_files_mem[i], grp->gr_name);
-            } else {
-                ret = sysdb_attrs_add_string(attrs,
-                                             SYSDB_GHOST,
-                                             fq_gr_files_mem[i]);
-                if (ret != EOK) {
-                    DEBUG(SSSDBG_MINOR_FAILURE,
-                          "Cannot add ghost %s for group %s\n",
-                          fq_gr_files_mem[i], fqname);
-                    continue;
-                }
-
-                DEBUG(SSSDBG_TRACE_LIBS,
-                      "User %s is not cached, will become a ghost of %s\n",
-                      fq_gr_files_mem[i], grp->gr_name);
-            }
-        }
-
-        if (fq_gr_mem != NULL && fq_gr_mem[0] != NULL) {
-            ret = sysdb_attrs_users_from_str_list(
-                    attrs, SYSDB_MEMBER, id_ctx->domain->name,
-                    (const char *const *) fq_gr_mem);
-            if (ret) {
-                DEBUG(SSSDBG_OP_FAILURE, "Could not add group members\n");
-                goto done;
-            }
-        }
-
     }
 
     ret = sysdb_store_group(id_ctx->domain, fqname, grp->gr_gid,
@@ -664,58 +1089,265 @@ done:
     return ret;
 }
 
-static errno_t sf_enum_groups(struct files_id_ctx *id_ctx,
-                              const char *group_file)
+static errno_t sf_group_changed(struct files_id_ctx *id_ctx,
+                                struct group *grp,
+                                const char **cached_users,
+                                struct ldb_message *msg,
+                                bool *_changed)
 {
+    TALLOC_CTX *tmp_ctx;
+    const char **members;
+    const char **ghosts;
+    const char **member_dns = NULL;
+    size_t num_members = 0;
     errno_t ret;
-    TALLOC_CTX *tmp_ctx = NULL;
-    struct group **groups = NULL;
-    const char **cached_users = NULL;
+
+    if (ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0) != grp->gr_gid) {
+        *_changed = true;
+        return EOK;
+    }
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = enum_files_groups(tmp_ctx, group_file, &groups);
+    ret = sf_group_members(tmp_ctx, id_ctx, grp, cached_users,
+                           &members, &ghosts);
     if (ret != EOK) {
         goto done;
     }
 
-    cached_users = get_cached_user_names(tmp_ctx, id_ctx->domain);
+    if (members != NULL) {
+        for (num_members = 0; members[num_members] != NULL; num_members++);
+    }
+
+    member_dns = talloc_zero_array(tmp_ctx, const char *, num_members + 1);
+    if (member_dns == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (size_t i = 0; i < num_members; i++) {
+        member_dns[i] = sysdb_user_strdn(member_dns, id_ctx->domain->name,
+                                         members[i]);
+        if (member_dns[i] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    *_changed = !sf_values_equal(tmp_ctx, member_dns,
+                                 ldb_msg_find_element(msg, SYSDB_MEMBER),
+                                 false)
+                || !sf_values_equal(tmp_ctx, ghosts,
+                                    ldb_msg_find_element(msg, SYSDB_GHOST),
+                                    true);
+
+    ret = EOK;
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sf_update_groups(struct files_id_ctx *id_ctx,
+                                struct sf_changes *changes)
+{
+    const char *attrs[] = { SYSDB_NAME, SYSDB_GIDNUM, SYSDB_MEMBER,
+                            SYSDB_GHOST, NULL };
+    struct sss_domain_info *dom = id_ctx->domain;
+    TALLOC_CTX *tmp_ctx;
+    hash_table_t *table;
+    struct group **groups;
+    const char **cached_users = NULL;
+    struct ldb_message **msgs = NULL;
+    struct sf_entry **entries;
+    struct sf_entry *entry;
+    unsigned long num_entries;
+    size_t count = 0;
+    const char *name;
+    bool saved = false;
+    bool changed;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    table = sss_ptr_hash_create(tmp_ctx, NULL, NULL);
+    if (table == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (size_t i = 0; id_ctx->group_files[i] != NULL; i++) {
+        ret = enum_files_groups(tmp_ctx, id_ctx->group_files[i], &groups);
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "The file %s does not exist (yet), skipping\n",
+                  id_ctx->group_files[i]);
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot enumerate groups from %s, aborting\n",
+                  id_ctx->group_files[i]);
+            goto done;
+        }
+
+        for (size_t j = 0; groups[j] != NULL; j++) {
+            if (sf_skip_group(groups[j])) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Skipping %s\n", groups[j]->gr_name);
+                continue;
+            }
+
+            ret = sf_add_entry(table, dom, groups[j]->gr_name, NULL,
+                               groups[j]);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+    }
+
+    cached_users = get_cached_user_names(tmp_ctx, dom);
     if (cached_users == NULL) {
+        ret = EOK;
+        goto done;
+    }
+
+    ret = sysdb_search_groups(tmp_ctx, dom, "("SYSDB_NAME"=*)", attrs,
+                              &count, &msgs);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to search cached groups [%d]: %s\n",
+              ret, sss_strerror(ret));
         goto done;
     }
 
-    for (size_t i = 0; groups[i]; i++) {
-        ret = save_file_group(id_ctx, groups[i], cached_users);
+    for (size_t i = 0; i < count; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        if (name == NULL
+                || sss_ptr_hash_has_key(table, name)) {
+            continue;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Removing group %s\n", name);
+        ret = sysdb_delete_group(dom, name, 0);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "Cannot remove group %s [%d]: %s\n",
+                  name, ret, sss_strerror(ret));
+            goto done;
+        }
+
+        ret = add_string_to_list(changes, name, &changes->groups);
         if (ret != EOK) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "Cannot save group %s\n", groups[i]->gr_name);
+            goto done;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        if (name == NULL) {
+            continue;
+        }
+
+        entry = sss_ptr_hash_lookup(table, name, struct sf_entry);
+        if (entry == NULL) {
             continue;
         }
+
+        ret = sf_group_changed(id_ctx, entry->grp, cached_users, msgs[i],
+                               &changed);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        if (changed) {
+            /* The group is stored again, so that no stale member or ghost
+             * values are kept. */
+            DEBUG(SSSDBG_TRACE_FUNC, "Updating group %s\n", name);
+            ret = sysdb_delete_group(dom, name, 0);
+            if (ret != EOK && ret != ENOENT) {
+                DEBUG(SSSDBG_OP_FAILURE, "Cannot remove group %s [%d]: %s\n",
+                      name, ret, sss_strerror(ret));
+                goto done;
+            }
+
+            ret = save_file_group(id_ctx, entry->fqname, entry->grp,
+                                  cached_users);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Cannot save group %s\n", entry->grp->gr_name);
+            } else {
+                saved = true;
+            }
+
+            ret = add_string_to_list(changes, name, &changes->groups);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        talloc_free(entry);
     }
 
-    ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_GROUP);
+    ret = sf_remaining_entries(tmp_ctx, table, &entries, &num_entries);
     if (ret != EOK) {
-        DEBUG(SSSDBG_MINOR_FAILURE,
-              "Failed to refresh override attributes, "
-              "override values might not be available.\n");
+        goto done;
     }
 
+    for (unsigned long i = 0; i < num_entries; i++) {
+        ret = save_file_group(id_ctx, entries[i]->fqname, entries[i]->grp,
+                              cached_users);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot save group %s\n", entries[i]->grp->gr_name);
+            continue;
+        }
+        changes->groups_added = true;
+        saved = true;
+    }
+
+    if (saved) {
+        ret = refresh_override_attrs(id_ctx, SYSDB_MEMBER_GROUP);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Failed to refresh override attributes, "
+                  "override values might not be available.\n");
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%lu groups added, %zu groups changed or "
+          "removed\n", num_entries,
+          changes->groups == NULL ? 0 : talloc_array_length(changes->groups) - 1);
+
     ret = EOK;
 done:
     talloc_free(tmp_ctx);
     return ret;
 }
 
+/* Only the users and groups which differ from the cache are written, the
+ * responders are told to drop just these records. */
 static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
-                             uint8_t flags)
+                             uint8_t flags,
+                             bool notify)
 {
+    struct sss_budget *budget;
+    struct sf_changes *changes;
+    struct data_provider *provider;
     errno_t ret;
     errno_t tret;
     bool in_transaction = false;
 
+    changes = talloc_zero(NULL, struct sf_changes);
+    if (changes == NULL) {
+        return ENOMEM;
+    }
+
+    /* The files are read in one transaction, only measure how long the
+     * event loop is blocked. */
+    budget = sss_budget_create(changes, "files enumeration", 0);
+
     ret = sysdb_transaction_start(id_ctx->domain->sysdb);
     if (ret != EOK) {
         goto done;
@@ -723,49 +1355,17 @@ static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
     in_transaction = true;
 
     if (flags & SF_UPDATE_PASSWD) {
-        ret = delete_all_users(id_ctx->domain);
+        ret = sf_update_users(id_ctx, changes);
         if (ret != EOK) {
             goto done;
         }
-
-        /* All users were deleted, therefore we need to enumerate each file again */
-        for (size_t i = 0; id_ctx->passwd_files[i] != NULL; i++) {
-            ret = sf_enum_users(id_ctx, id_ctx->passwd_files[i]);
-            if (ret == ENOENT) {
-                DEBUG(SSSDBG_MINOR_FAILURE,
-                      "The file %s does not exist (yet), skipping\n",
-                      id_ctx->passwd_files[i]);
-                continue;
-            } else if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "Cannot enumerate users from %s, aborting\n",
-                      id_ctx->passwd_files[i]);
-                goto done;
-            }
-        }
     }
 
     if (flags & SF_UPDATE_GROUP) {
-        ret = delete_all_groups(id_ctx->domain);
+        ret = sf_update_groups(id_ctx, changes);
         if (ret != EOK) {
             goto done;
         }
-
-        /* All groups were deleted, therefore we need to enumerate each file again */
-        for (size_t i = 0; id_ctx->group_files[i] != NULL; i++) {
-            ret = sf_enum_groups(id_ctx, id_ctx->group_files[i]);
-            if (ret == ENOENT) {
-                DEBUG(SSSDBG_MINOR_FAILURE,
-                      "The file %s does not exist (yet), skipping\n",
-                      id_ctx->group_files[i]);
-                continue;
-            } else if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "Cannot enumerate groups from %s, aborting\n",
-                      id_ctx->group_files[i]);
-                goto done;
-            }
-        }
     }
 
     ret = dp_add_sr_attribute(id_ctx->be);
@@ -780,6 +1380,29 @@ static errno_t sf_enum_files(struct files_id_ctx *id_ctx,
     }
     in_transaction = false;
 
+    provider = id_ctx->be->provider;
+    if (notify && provider != NULL) {
+        if (changes->users_added || changes->users != NULL) {
+            dp_sbus_reset_users_ncache(provider, id_ctx->domain);
+        }
+
+        if (changes->groups_added || changes->groups != NULL) {
+            dp_sbus_reset_groups_ncache(provider, id_ctx->domain);
+        }
+
+        if (changes->users != NULL || changes->groups != NULL) {
+            dp_sbus_invalidate_memcache_batch(provider, id_ctx->domain,
+                                        discard_const(changes->users),
+                                        discard_const(changes->groups));
+        }
+
+        /* Group memberships of any user might have changed. */
+        if (changes->users != NULL || changes->groups != NULL
+                || changes->groups_added) {
+            dp_sbus_reset_initgr_memcache(provider);
+        }
+    }
+
     ret = EOK;
 done:
     if (in_transaction) {
@@ -790,6 +1413,8 @@ done:
         }
     }
 
+    talloc_free(budget);
+    talloc_free(changes);
     return ret;
 }
 
@@ -818,15 +1443,11 @@ static int sf_passwd_cb(const char *filename, uint32_t flags, void *pvt)
     id_ctx->updating_passwd = true;
     dp_sbus_domain_inconsistent(id_ctx->be->provider, id_ctx->domain);
 
-    dp_sbus_reset_users_ncache(id_ctx->be->provider, id_ctx->domain);
-    dp_sbus_reset_users_memcache(id_ctx->be->provider);
-    dp_sbus_reset_initgr_memcache(id_ctx->be->provider);
-
     /* Using SF_UDPATE_BOTH here the case when someone edits /etc/group, adds a group member and
      * only then edits passwd and adds the user. The reverse is not needed,
      * because member/memberof links are established when groups are saved.
      */
-    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH);
+    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH, true);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Could not update files: [%d]: %s\n",
@@ -857,11 +1478,7 @@ static int sf_group_cb(const char *filename, uint32_t flags, void *pvt)
     id_ctx->updating_groups = true;
     dp_sbus_domain_inconsistent(id_ctx->be->provider, id_ctx->domain);
 
-    dp_sbus_reset_groups_ncache(id_ctx->be->provider, id_ctx->domain);
-    dp_sbus_reset_groups_memcache(id_ctx->be->provider);
-    dp_sbus_reset_initgr_memcache(id_ctx->be->provider);
-
-    ret = sf_enum_files(id_ctx, SF_UPDATE_GROUP);
+    ret = sf_enum_files(id_ctx, SF_UPDATE_GROUP, true);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Could not update files: [%d]: %s\n",
@@ -886,7 +1503,7 @@ static void startup_enum_files(struct tevent_context *ev,
 
     talloc_zfree(imm);
 
-    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH);
+    ret = sf_enum_files(id_ctx, SF_UPDATE_BOTH, false);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Could not update files after startup: [%d]: %s\n",
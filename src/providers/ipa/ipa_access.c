@@ -25,6 +25,7 @@
 #include <security/pam_modules.h>
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 #include "providers/ldap/sdap_async.h"
 #include "providers/ldap/sdap_access.h"
 #include "providers/ipa/ipa_common.h"
@@ -84,6 +85,15 @@ enum check_result {
     RULE_ERROR
 };
 
+/* If more rules than this were modified since the last refresh, all rules
+ * are downloaded again instead of asking for each of them. */
+#define IPA_HBAC_MAX_CHANGED_RULES 50
+
+struct ipa_hbac_cached_rule {
+    char *stamp;
+    bool seen;
+};
+
 struct ipa_fetch_hbac_state {
     struct tevent_context *ev;
     struct be_ctx *be_ctx;
@@ -110,7 +120,10 @@ static void ipa_fetch_hbac_connect_done(struct tevent_req *subreq);
 static errno_t ipa_fetch_hbac_hostinfo(struct tevent_req *req);
 static void ipa_fetch_hbac_hostinfo_done(struct tevent_req *subreq);
 static void ipa_fetch_hbac_services_done(struct tevent_req *subreq);
+static void ipa_fetch_hbac_stamps_done(struct tevent_req *subreq);
+static void ipa_fetch_hbac_changed_done(struct tevent_req *subreq);
 static void ipa_fetch_hbac_rules_done(struct tevent_req *subreq);
+static errno_t ipa_fetch_hbac_save(struct tevent_req *req, bool found);
 
 static struct tevent_req *
 ipa_fetch_hbac_send(TALLOC_CTX *mem_ctx,
@@ -173,7 +186,8 @@ ipa_fetch_hbac_send(TALLOC_CTX *mem_ctx,
     refresh_interval = dp_opt_get_int(state->ipa_options, IPA_HBAC_REFRESH);
     now = time(NULL);
 
-    if (offline || now < access_ctx->last_update + refresh_interval) {
+    if (offline || now < access_ctx->last_update + refresh_interval
+                                                 + access_ctx->refresh_jitter) {
         DEBUG(SSSDBG_TRACE_FUNC, "Performing cached HBAC evaluation\n");
         ret = EOK;
         goto immediately;
@@ -381,17 +395,18 @@ static void ipa_fetch_hbac_services_done(struct tevent_req *subreq)
         goto done;
     }
 
-    subreq = ipa_hbac_rule_info_send(state, state->ev,
-                                     sdap_id_op_handle(state->sdap_op),
-                                     state->sdap_ctx->opts,
-                                     state->search_bases,
-                                     state->ipa_host);
+    /* Find out which rules changed since they were cached first. */
+    subreq = ipa_hbac_rule_stamps_send(state, state->ev,
+                                       sdap_id_op_handle(state->sdap_op),
+                                       state->sdap_ctx->opts,
+                                       state->search_bases,
+                                       state->ipa_host);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto done;
     }
 
-    tevent_req_set_callback(subreq, ipa_fetch_hbac_rules_done, req);
+    tevent_req_set_callback(subreq, ipa_fetch_hbac_stamps_done, req);
 
     return;
 
@@ -404,11 +419,275 @@ done:
     tevent_req_done(req);
 }
 
+static errno_t
+ipa_fetch_hbac_changed_rules(struct ipa_fetch_hbac_state *state,
+                             size_t stamp_count,
+                             struct sysdb_attrs **stamps,
+                             const char ***_changed)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sdap_options *opts = state->sdap_ctx->opts;
+    const char *attrs[] = { IPA_UNIQUE_ID, IPA_MODIFY_TIMESTAMP, NULL, NULL };
+    struct sysdb_attrs **cached;
+    size_t cached_count;
+    hash_table_t *table;
+    struct ipa_hbac_cached_rule *entry;
+    const char **changed = NULL;
+    const char **removed = NULL;
+    size_t num_changed = 0;
+    size_t num_removed = 0;
+    const char *id;
+    char *stamp;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    attrs[2] = opts->gen_map[SDAP_AT_ENTRY_USN].name;
+
+    ret = ipa_common_get_cached_rules(tmp_ctx, state->be_ctx->domain,
+                                      IPA_HBAC_RULE, HBAC_RULES_SUBDIR, attrs,
+                                      &cached_count, &cached);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (cached_count == 0) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    table = sss_ptr_hash_create(tmp_ctx, NULL, NULL);
+    if (table == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < cached_count; i++) {
+        ret = sysdb_attrs_get_string(cached[i], IPA_UNIQUE_ID, &id);
+        if (ret != EOK) {
+            /* Rules without a unique ID cannot be updated. */
+            goto done;
+        }
+
+        entry = talloc_zero(table, struct ipa_hbac_cached_rule);
+        if (entry == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        entry->stamp = ipa_hbac_rule_stamp(entry, opts, cached[i]);
+
+        ret = sss_ptr_hash_add(table, id, entry, struct ipa_hbac_cached_rule);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    changed = talloc_zero_array(state, const char *, stamp_count + 1);
+    removed = talloc_zero_array(state->rules, const char *,
+                                stamp_count + cached_count + 1);
+    if (changed == NULL || removed == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < stamp_count; i++) {
+        ret = sysdb_attrs_get_string(stamps[i], IPA_UNIQUE_ID, &id);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "HBAC rule without %s\n", IPA_UNIQUE_ID);
+            goto done;
+        }
+
+        stamp = ipa_hbac_rule_stamp(tmp_ctx, opts, stamps[i]);
+
+        entry = sss_ptr_hash_lookup(table, id, struct ipa_hbac_cached_rule);
+        if (entry != NULL) {
+            entry->seen = true;
+            if (stamp != NULL && entry->stamp != NULL
+                    && strcmp(stamp, entry->stamp) == 0) {
+                continue;
+            }
+
+            /* The modified rule replaces the cached one. */
+            removed[num_removed] = talloc_strdup(removed, id);
+            if (removed[num_removed] == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+            num_removed++;
+        }
+
+        if (num_changed == IPA_HBAC_MAX_CHANGED_RULES) {
+            DEBUG(SSSDBG_TRACE_FUNC, "More than %d HBAC rules changed\n",
+                  IPA_HBAC_MAX_CHANGED_RULES);
+            ret = ENOENT;
+            goto done;
+        }
+
+        changed[num_changed] = talloc_strdup(changed, id);
+        if (changed[num_changed] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        num_changed++;
+    }
+
+    /* Rules that were deleted, disabled or do not apply to this host
+     * anymore. */
+    for (i = 0; i < cached_count; i++) {
+        ret = sysdb_attrs_get_string(cached[i], IPA_UNIQUE_ID, &id);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        entry = sss_ptr_hash_lookup(table, id, struct ipa_hbac_cached_rule);
+        if (entry == NULL || entry->seen) {
+            continue;
+        }
+
+        removed[num_removed] = talloc_strdup(removed, id);
+        if (removed[num_removed] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        num_removed++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%zu HBAC rules changed, %zu cached rules "
+          "are outdated\n", num_changed, num_removed);
+
+    state->rules->entry_subdir = HBAC_RULES_SUBDIR;
+    state->rules->partial = true;
+    state->rules->removed_entries = removed;
+    *_changed = changed;
+    removed = NULL;
+    changed = NULL;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(changed);
+        talloc_free(removed);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static void ipa_fetch_hbac_stamps_done(struct tevent_req *subreq)
+{
+    struct ipa_fetch_hbac_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct sysdb_attrs **stamps;
+    size_t stamp_count;
+    const char **changed;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ipa_fetch_hbac_state);
+
+    ret = ipa_hbac_rule_info_recv(subreq, state, &stamp_count, &stamps);
+    talloc_zfree(subreq);
+    if (ret == ENOENT) {
+        ret = ipa_fetch_hbac_save(req, false);
+        goto done;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    ret = ipa_fetch_hbac_changed_rules(state, stamp_count, stamps, &changed);
+    talloc_free(stamps);
+    if (ret == ENOENT) {
+        /* Nothing is cached yet or too many rules changed. */
+        subreq = ipa_hbac_rule_info_send(state, state->ev,
+                                         sdap_id_op_handle(state->sdap_op),
+                                         state->sdap_ctx->opts,
+                                         state->search_bases,
+                                         state->ipa_host);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, ipa_fetch_hbac_rules_done, req);
+        return;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to compare HBAC rules with the "
+              "cache [%d]: %s\n", ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (changed[0] == NULL) {
+        ret = ipa_fetch_hbac_save(req, true);
+        goto done;
+    }
+
+    subreq = ipa_hbac_rule_info_by_id_send(state, state->ev,
+                                           sdap_id_op_handle(state->sdap_op),
+                                           state->sdap_ctx->opts,
+                                           state->search_bases,
+                                           state->ipa_host,
+                                           changed);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, ipa_fetch_hbac_changed_done, req);
+    return;
+
+done:
+    if (ret == EAGAIN) {
+        return;
+    } else if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void ipa_fetch_hbac_changed_done(struct tevent_req *subreq)
+{
+    struct ipa_fetch_hbac_state *state = NULL;
+    struct tevent_req *req = NULL;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ipa_fetch_hbac_state);
+
+    ret = ipa_hbac_rule_info_recv(subreq, state,
+                                  &state->rules->entry_count,
+                                  &state->rules->entries);
+    talloc_zfree(subreq);
+    if (ret == ENOENT) {
+        /* The rules were removed in the meantime. */
+        state->rules->entry_count = 0;
+        state->rules->entries = NULL;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    ret = ipa_fetch_hbac_save(req, true);
+
+done:
+    if (ret == EAGAIN) {
+        return;
+    } else if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
 static void ipa_fetch_hbac_rules_done(struct tevent_req *subreq)
 {
     struct ipa_fetch_hbac_state *state = NULL;
     struct tevent_req *req = NULL;
-    int dp_error;
     errno_t ret;
     bool found;
 
@@ -419,61 +698,73 @@ static void ipa_fetch_hbac_rules_done(struct tevent_req *subreq)
                                   &state->rules->entry_count,
                                   &state->rules->entries);
     state->rules->entry_subdir = HBAC_RULES_SUBDIR;
+    state->rules->partial = false;
     talloc_zfree(subreq);
     if (ret == ENOENT) {
-        /* Set ret to EOK so we can safely call sdap_id_op_done. */
         found = false;
-        ret = EOK;
     } else if (ret == EOK) {
         found = true;
     } else {
         goto done;
     }
 
-    ret = sdap_id_op_done(state->sdap_op, ret, &dp_error);
-    if (dp_error == DP_ERR_OK && ret != EOK) {
-        /* retry */
-        ret = ipa_fetch_hbac_retry(req);
-        if (ret != EAGAIN) {
-            tevent_req_error(req, ret);
-        }
+    ret = ipa_fetch_hbac_save(req, found);
+
+done:
+    if (ret == EAGAIN) {
         return;
     } else if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
+    tevent_req_done(req);
+}
+
+static errno_t ipa_fetch_hbac_save(struct tevent_req *req, bool found)
+{
+    struct ipa_fetch_hbac_state *state = NULL;
+    time_t refresh_interval;
+    int dp_error;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct ipa_fetch_hbac_state);
+
+    ret = sdap_id_op_done(state->sdap_op, EOK, &dp_error);
+    if (dp_error == DP_ERR_OK && ret != EOK) {
+        /* retry */
+        return ipa_fetch_hbac_retry(req);
+    } else if (ret != EOK) {
+        return ret;
+    }
+
     if (found == false) {
         /* No rules were found that apply to this host. */
         ret = ipa_common_purge_rules(state->be_ctx->domain,
                                      HBAC_RULES_SUBDIR);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to remove HBAC rules\n");
-            goto done;
+            return ret;
         }
 
-        ret = ENOENT;
-        goto done;
+        return ENOENT;
     }
 
     ret = ipa_common_save_rules(state->be_ctx->domain,
                                 state->hosts, state->services, state->rules,
                                 &state->access_ctx->last_update);
-
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save HBAC rules\n");
-        goto done;
+        return ret;
     }
 
-    ret = EOK;
-
-done:
-    if (ret != EOK) {
-        tevent_req_error(req, ret);
-        return;
-    }
+    /* Up to a quarter of the refresh interval. */
+    refresh_interval = dp_opt_get_int(state->ipa_options, IPA_HBAC_REFRESH);
+    state->access_ctx->refresh_jitter = refresh_interval >= 4
+                                        ? sss_rand() % (refresh_interval / 4 + 1)
+                                        : 0;
 
-    tevent_req_done(req);
+    return EOK;
 }
 
 static errno_t ipa_fetch_hbac_recv(struct tevent_req *req)
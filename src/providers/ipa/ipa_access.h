@@ -36,6 +36,9 @@ struct ipa_access_ctx {
     struct sdap_id_ctx *sdap_ctx;
     struct dp_option *ipa_options;
     time_t last_update;
+    /* Random delay added to the refresh interval so that clients do not
+     * refresh the rules at the same time. */
+    time_t refresh_jitter;
     struct sdap_access_ctx *sdap_access_ctx;
 
     struct sdap_attr_map *host_map;
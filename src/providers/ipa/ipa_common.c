@@ -1048,6 +1048,7 @@ int ipa_service_init(TALLOC_CTX *memctx, struct be_ctx *ctx,
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to create failover service!\n");
         goto done;
     }
+    be_fo_set_probe_port(ctx, "IPA", LDAP_PORT);
 
     service->sdap->name = talloc_strdup(service, "IPA");
     if (!service->sdap->name) {
@@ -43,6 +43,7 @@
 #define IPA_SOURCE_HOST_CATEGORY "sourceHostCategory"
 #define IPA_MEMBER_SERVICE "memberService"
 #define IPA_SERVICE_CATEGORY "serviceCategory"
+#define IPA_MODIFY_TIMESTAMP "modifyTimestamp"
 
 #define IPA_HBAC_BASE_TMPL "cn=hbac,%s"
 #define IPA_SERVICES_BASE_TMPL "cn=hbacservices,cn=accounts,%s"
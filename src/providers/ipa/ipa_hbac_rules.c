@@ -48,16 +48,19 @@ ipa_hbac_rule_info_next(struct tevent_req *req,
 static void
 ipa_hbac_rule_info_done(struct tevent_req *subreq);
 
-struct tevent_req *
-ipa_hbac_rule_info_send(TALLOC_CTX *mem_ctx,
-                        struct tevent_context *ev,
-                        struct sdap_handle *sh,
-                        struct sdap_options *opts,
-                        struct sdap_search_base **search_bases,
-                        struct sysdb_attrs *ipa_host)
+static struct tevent_req *
+ipa_hbac_rule_search_send(TALLOC_CTX *mem_ctx,
+                          struct tevent_context *ev,
+                          struct sdap_handle *sh,
+                          struct sdap_options *opts,
+                          struct sdap_search_base **search_bases,
+                          struct sysdb_attrs *ipa_host,
+                          const char **ids,
+                          bool stamps_only)
 {
     errno_t ret;
     size_t i;
+    char *id_clean;
     struct tevent_req *req = NULL;
     struct ipa_hbac_rule_state *state;
     const char *host_dn;
@@ -92,26 +95,38 @@ ipa_hbac_rule_info_send(TALLOC_CTX *mem_ctx,
     state->opts = opts;
     state->search_bases = search_bases;
     state->search_base_iter = 0;
-    state->attrs = talloc_zero_array(state, const char *, 15);
+    state->attrs = talloc_zero_array(state, const char *, 17);
     if (state->attrs == NULL) {
         ret = ENOMEM;
         goto immediate;
     }
-    state->attrs[0] = OBJECTCLASS;
-    state->attrs[1] = IPA_CN;
-    state->attrs[2] = IPA_UNIQUE_ID;
-    state->attrs[3] = IPA_ENABLED_FLAG;
-    state->attrs[4] = IPA_ACCESS_RULE_TYPE;
-    state->attrs[5] = IPA_MEMBER_USER;
-    state->attrs[6] = IPA_USER_CATEGORY;
-    state->attrs[7] = IPA_MEMBER_SERVICE;
-    state->attrs[8] = IPA_SERVICE_CATEGORY;
-    state->attrs[9] = IPA_SOURCE_HOST;
-    state->attrs[10] = IPA_SOURCE_HOST_CATEGORY;
-    state->attrs[11] = IPA_EXTERNAL_HOST;
-    state->attrs[12] = IPA_MEMBER_HOST;
-    state->attrs[13] = IPA_HOST_CATEGORY;
-    state->attrs[14] = NULL;
+
+    if (stamps_only) {
+        state->attrs[0] = IPA_UNIQUE_ID;
+        state->attrs[1] = IPA_MODIFY_TIMESTAMP;
+        state->attrs[2] = opts->gen_map[SDAP_AT_ENTRY_USN].name;
+        state->attrs[3] = NULL;
+    } else {
+        state->attrs[0] = OBJECTCLASS;
+        state->attrs[1] = IPA_CN;
+        state->attrs[2] = IPA_UNIQUE_ID;
+        state->attrs[3] = IPA_ENABLED_FLAG;
+        state->attrs[4] = IPA_ACCESS_RULE_TYPE;
+        state->attrs[5] = IPA_MEMBER_USER;
+        state->attrs[6] = IPA_USER_CATEGORY;
+        state->attrs[7] = IPA_MEMBER_SERVICE;
+        state->attrs[8] = IPA_SERVICE_CATEGORY;
+        state->attrs[9] = IPA_SOURCE_HOST;
+        state->attrs[10] = IPA_SOURCE_HOST_CATEGORY;
+        state->attrs[11] = IPA_EXTERNAL_HOST;
+        state->attrs[12] = IPA_MEMBER_HOST;
+        state->attrs[13] = IPA_HOST_CATEGORY;
+        /* The change stamps are kept in the cache so that the next refresh
+         * can tell which rules were modified. */
+        state->attrs[14] = IPA_MODIFY_TIMESTAMP;
+        state->attrs[15] = opts->gen_map[SDAP_AT_ENTRY_USN].name;
+        state->attrs[16] = NULL;
+    }
 
     rule_filter = talloc_asprintf(state,
                                   "(&(objectclass=%s)"
@@ -157,7 +172,40 @@ ipa_hbac_rule_info_send(TALLOC_CTX *mem_ctx,
         }
     }
 
-    rule_filter = talloc_asprintf_append(rule_filter, "))");
+    rule_filter = talloc_asprintf_append(rule_filter, ")");
+    if (rule_filter == NULL) {
+        ret = ENOMEM;
+        goto immediate;
+    }
+
+    /* Only the given rules */
+    if (ids != NULL) {
+        rule_filter = talloc_asprintf_append(rule_filter, "(|");
+        if (rule_filter == NULL) {
+            ret = ENOMEM;
+            goto immediate;
+        }
+
+        for (i = 0; ids[i] != NULL; i++) {
+            ret = sss_filter_sanitize(state, ids[i], &id_clean);
+            if (ret != EOK) goto immediate;
+
+            rule_filter = talloc_asprintf_append(rule_filter, "(%s=%s)",
+                                                 IPA_UNIQUE_ID, id_clean);
+            if (rule_filter == NULL) {
+                ret = ENOMEM;
+                goto immediate;
+            }
+        }
+
+        rule_filter = talloc_asprintf_append(rule_filter, ")");
+        if (rule_filter == NULL) {
+            ret = ENOMEM;
+            goto immediate;
+        }
+    }
+
+    rule_filter = talloc_asprintf_append(rule_filter, ")");
     if (rule_filter == NULL) {
         ret = ENOMEM;
         goto immediate;
@@ -193,6 +241,48 @@ immediate:
     return req;
 }
 
+struct tevent_req *
+ipa_hbac_rule_info_send(TALLOC_CTX *mem_ctx,
+                        struct tevent_context *ev,
+                        struct sdap_handle *sh,
+                        struct sdap_options *opts,
+                        struct sdap_search_base **search_bases,
+                        struct sysdb_attrs *ipa_host)
+{
+    return ipa_hbac_rule_search_send(mem_ctx, ev, sh, opts, search_bases,
+                                     ipa_host, NULL, false);
+}
+
+struct tevent_req *
+ipa_hbac_rule_stamps_send(TALLOC_CTX *mem_ctx,
+                          struct tevent_context *ev,
+                          struct sdap_handle *sh,
+                          struct sdap_options *opts,
+                          struct sdap_search_base **search_bases,
+                          struct sysdb_attrs *ipa_host)
+{
+    return ipa_hbac_rule_search_send(mem_ctx, ev, sh, opts, search_bases,
+                                     ipa_host, NULL, true);
+}
+
+struct tevent_req *
+ipa_hbac_rule_info_by_id_send(TALLOC_CTX *mem_ctx,
+                              struct tevent_context *ev,
+                              struct sdap_handle *sh,
+                              struct sdap_options *opts,
+                              struct sdap_search_base **search_bases,
+                              struct sysdb_attrs *ipa_host,
+                              const char **ids)
+{
+    if (ids == NULL || ids[0] == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "No rule to search for\n");
+        return NULL;
+    }
+
+    return ipa_hbac_rule_search_send(mem_ctx, ev, sh, opts, search_bases,
+                                     ipa_host, ids, false);
+}
+
 static errno_t
 ipa_hbac_rule_info_next(struct tevent_req *req,
                         struct ipa_hbac_rule_state *state)
@@ -311,3 +401,32 @@ ipa_hbac_rule_info_recv(struct tevent_req *req,
 
     return EOK;
 }
+
+char *ipa_hbac_rule_stamp(TALLOC_CTX *mem_ctx,
+                          struct sdap_options *opts,
+                          struct sysdb_attrs *rule)
+{
+    const char *usn = NULL;
+    const char *modstamp = NULL;
+    errno_t ret;
+
+    if (opts->gen_map[SDAP_AT_ENTRY_USN].name != NULL) {
+        ret = sysdb_attrs_get_string(rule, opts->gen_map[SDAP_AT_ENTRY_USN].name,
+                                     &usn);
+        if (ret != EOK && ret != ENOENT) {
+            return NULL;
+        }
+    }
+
+    ret = sysdb_attrs_get_string(rule, IPA_MODIFY_TIMESTAMP, &modstamp);
+    if (ret != EOK && ret != ENOENT) {
+        return NULL;
+    }
+
+    if (usn == NULL && modstamp == NULL) {
+        return NULL;
+    }
+
+    return talloc_asprintf(mem_ctx, "%s/%s", usn == NULL ? "" : usn,
+                           modstamp == NULL ? "" : modstamp);
+}
@@ -32,10 +32,38 @@ ipa_hbac_rule_info_send(TALLOC_CTX *mem_ctx,
                         struct sdap_search_base **search_bases,
                         struct sysdb_attrs *ipa_host);
 
+/* Same search as ipa_hbac_rule_info_send() but only the unique ID and the
+ * change stamps of the rules are returned. */
+struct tevent_req *
+ipa_hbac_rule_stamps_send(TALLOC_CTX *mem_ctx,
+                          struct tevent_context *ev,
+                          struct sdap_handle *sh,
+                          struct sdap_options *opts,
+                          struct sdap_search_base **search_bases,
+                          struct sysdb_attrs *ipa_host);
+
+/* Same search as ipa_hbac_rule_info_send() restricted to the rules with the
+ * given NULL-terminated list of unique IDs. */
+struct tevent_req *
+ipa_hbac_rule_info_by_id_send(TALLOC_CTX *mem_ctx,
+                              struct tevent_context *ev,
+                              struct sdap_handle *sh,
+                              struct sdap_options *opts,
+                              struct sdap_search_base **search_bases,
+                              struct sysdb_attrs *ipa_host,
+                              const char **ids);
+
+/* Used for all of the requests above, returns ENOENT if no rule was found. */
 errno_t
 ipa_hbac_rule_info_recv(struct tevent_req *req,
                         TALLOC_CTX *mem_ctx,
                         size_t *_rule_count,
                         struct sysdb_attrs ***_rules);
 
+/* Returns a string that changes whenever the rule is modified on the
+ * server or NULL if the rule does not carry any change stamp. */
+char *ipa_hbac_rule_stamp(TALLOC_CTX *mem_ctx,
+                          struct sdap_options *opts,
+                          struct sysdb_attrs *rule);
+
 #endif /* IPA_HBAC_RULES_H_ */
@@ -91,6 +91,33 @@ done:
     return ret;
 }
 
+static errno_t
+ipa_common_update_list(struct sss_domain_info *domain,
+                       const char *subdir,
+                       const char *naming_attribute,
+                       const char **removed,
+                       size_t count,
+                       struct sysdb_attrs **list)
+{
+    size_t c;
+    errno_t ret;
+
+    for (c = 0; removed != NULL && removed[c] != NULL; c++) {
+        DEBUG(SSSDBG_TRACE_ALL, "Removing object [%s].\n", removed[c]);
+
+        /* sysdb_store_custom() merges the attributes, modified entries must
+         * be removed first so that deleted values do not remain. */
+        ret = sysdb_delete_custom(domain, removed[c], subdir);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_delete_custom failed.\n");
+            return ret;
+        }
+    }
+
+    return ipa_common_save_list(domain, false, subdir, naming_attribute,
+                                count, list);
+}
+
 errno_t
 ipa_common_entries_and_groups_sysdb_save(struct sss_domain_info *domain,
                                          const char *primary_subdir,
@@ -309,7 +336,16 @@ errno_t ipa_common_save_rules(struct sss_domain_info *domain,
     }
 
     /* Save the rules */
-    if (rules != NULL) {
+    if (rules != NULL && rules->partial) {
+        ret = ipa_common_update_list(domain, rules->entry_subdir,
+                                     IPA_UNIQUE_ID, rules->removed_entries,
+                                     rules->entry_count, rules->entries);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Error updating rules [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+    } else if (rules != NULL) {
         ret = ipa_common_entries_and_groups_sysdb_save(domain,
                                                        rules->entry_subdir,
                                                        IPA_UNIQUE_ID,
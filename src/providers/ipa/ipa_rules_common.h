@@ -47,6 +47,12 @@ struct ipa_common_entries {
     const char *group_subdir;
     size_t group_count;
     struct sysdb_attrs **groups;
+
+    /* If set, the cached entries named in the NULL-terminated list
+     * removed_entries are deleted and the entries are stored, the other
+     * cached entries are kept. Groups are not supported in this mode. */
+    bool partial;
+    const char **removed_entries;
 };
 
 errno_t
@@ -1170,6 +1170,13 @@ static const char *ipa_s2n_reqinp2str(TALLOC_CTX *mem_ctx,
     return str;
 }
 
+/* Maximal number of extdom requests of a list lookup which are sent to the
+ * server at the same time. */
+#define IPA_S2N_LIST_WINDOW 8
+
+/* A list is looked up by up to IPA_S2N_LIST_WINDOW chains, each of them
+ * resolves one object after another and takes the next object of the list
+ * which was not processed yet when it is done with the current one. */
 struct ipa_s2n_get_list_state {
     struct tevent_context *ev;
     struct ipa_id_ctx *ipa_ctx;
@@ -1178,6 +1185,8 @@ struct ipa_s2n_get_list_state {
     enum extdom_protocol protocol;
     struct req_input req_input;
     char **list;
+    size_t list_count;
+    size_t *next_idx;
     size_t list_idx;
     int exop_timeout;
     int entry_type;
@@ -1194,17 +1203,20 @@ static void ipa_s2n_get_list_next(struct tevent_req *subreq);
 static void ipa_s2n_get_list_ipa_next(struct tevent_req *subreq);
 static errno_t ipa_s2n_get_list_save_step(struct tevent_req *req);
 
-static struct tevent_req *ipa_s2n_get_list_send(TALLOC_CTX *mem_ctx,
-                                                struct tevent_context *ev,
-                                                struct ipa_id_ctx *ipa_ctx,
-                                                struct sss_domain_info *dom,
-                                                struct sdap_handle *sh,
-                                                int exop_timeout,
-                                                int entry_type,
-                                                enum request_types request_type,
-                                                enum req_input_type list_type,
-                                                char **list,
-                                                struct sysdb_attrs *mapped_attrs)
+static struct tevent_req *
+ipa_s2n_get_list_chain_send(TALLOC_CTX *mem_ctx,
+                            struct tevent_context *ev,
+                            struct ipa_id_ctx *ipa_ctx,
+                            struct sss_domain_info *dom,
+                            struct sdap_handle *sh,
+                            int exop_timeout,
+                            int entry_type,
+                            enum request_types request_type,
+                            enum req_input_type list_type,
+                            char **list,
+                            size_t list_count,
+                            size_t *next_idx,
+                            struct sysdb_attrs *mapped_attrs)
 {
     int ret;
     struct ipa_s2n_get_list_state *state;
@@ -1215,21 +1227,15 @@ static struct tevent_req *ipa_s2n_get_list_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    if ((entry_type == BE_REQ_BY_SECID && list_type != REQ_INP_SECID)
-           || (entry_type != BE_REQ_BY_SECID && list_type == REQ_INP_SECID)) {
-        DEBUG(SSSDBG_OP_FAILURE, "Invalid parameter combination [%d][%d].\n",
-                                 request_type, list_type);
-        ret = EINVAL;
-        goto done;
-    }
-
     state->ev = ev;
     state->ipa_ctx = ipa_ctx;
     state->dom = dom;
     state->sh = sh;
     state->protocol = extdom_preferred_protocol(sh);
     state->list = list;
-    state->list_idx = 0;
+    state->list_count = list_count;
+    state->next_idx = next_idx;
+    state->list_idx = (*next_idx)++;
     state->req_input.type = list_type;
     state->req_input.inp.name = NULL;
     state->exop_timeout = exop_timeout;
@@ -1482,8 +1488,8 @@ static void ipa_s2n_get_list_ipa_next(struct tevent_req *subreq)
         goto done;
     }
 
-    state->list_idx++;
-    if (state->list[state->list_idx] == NULL) {
+    state->list_idx = (*state->next_idx)++;
+    if (state->list_idx >= state->list_count) {
         tevent_req_done(req);
         return;
     }
@@ -1546,8 +1552,8 @@ static errno_t ipa_s2n_get_list_save_step(struct tevent_req *req)
         return ret;
     }
 
-    state->list_idx++;
-    if (state->list[state->list_idx] == NULL) {
+    state->list_idx = (*state->next_idx)++;
+    if (state->list_idx >= state->list_count) {
         return EOK;
     }
 
@@ -1560,6 +1566,112 @@ static errno_t ipa_s2n_get_list_save_step(struct tevent_req *req)
     return EAGAIN;
 }
 
+static int ipa_s2n_get_list_chain_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+struct ipa_s2n_get_list_window_state {
+    size_t next_idx;
+    size_t num_chains;
+};
+
+static void ipa_s2n_get_list_chain_done(struct tevent_req *subreq);
+
+static struct tevent_req *ipa_s2n_get_list_send(TALLOC_CTX *mem_ctx,
+                                                struct tevent_context *ev,
+                                                struct ipa_id_ctx *ipa_ctx,
+                                                struct sss_domain_info *dom,
+                                                struct sdap_handle *sh,
+                                                int exop_timeout,
+                                                int entry_type,
+                                                enum request_types request_type,
+                                                enum req_input_type list_type,
+                                                char **list,
+                                                struct sysdb_attrs *mapped_attrs)
+{
+    int ret;
+    struct ipa_s2n_get_list_window_state *state;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    size_t list_count;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct ipa_s2n_get_list_window_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    if ((entry_type == BE_REQ_BY_SECID && list_type != REQ_INP_SECID)
+           || (entry_type != BE_REQ_BY_SECID && list_type == REQ_INP_SECID)) {
+        DEBUG(SSSDBG_OP_FAILURE, "Invalid parameter combination [%d][%d].\n",
+                                 request_type, list_type);
+        ret = EINVAL;
+        goto done;
+    }
+
+    for (list_count = 0; list[list_count] != NULL; list_count++);
+
+    state->next_idx = 0;
+    state->num_chains = 0;
+
+    /* Every chain takes the next object of the list when it starts. */
+    while (state->next_idx < list_count
+                && state->num_chains < IPA_S2N_LIST_WINDOW) {
+        subreq = ipa_s2n_get_list_chain_send(state, ev, ipa_ctx, dom, sh,
+                                             exop_timeout, entry_type,
+                                             request_type, list_type,
+                                             list, list_count,
+                                             &state->next_idx, mapped_attrs);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        tevent_req_set_callback(subreq, ipa_s2n_get_list_chain_done, req);
+        state->num_chains++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Looking up %zu objects with %zu parallel "
+          "requests.\n", list_count, state->num_chains);
+
+    ret = state->num_chains == 0 ? EOK : EAGAIN;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void ipa_s2n_get_list_chain_done(struct tevent_req *subreq)
+{
+    int ret;
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct ipa_s2n_get_list_window_state *state = tevent_req_data(req,
+                                        struct ipa_s2n_get_list_window_state);
+
+    ret = ipa_s2n_get_list_chain_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        /* The remaining chains are freed together with the request. */
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    state->num_chains--;
+    if (state->num_chains == 0) {
+        tevent_req_done(req);
+    }
+}
+
 static int ipa_s2n_get_list_recv(struct tevent_req *req)
 {
     TEVENT_REQ_RETURN_ON_ERROR(req);
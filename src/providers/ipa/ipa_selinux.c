@@ -556,7 +556,9 @@ done:
 }
 
 struct selinux_child_state {
-    struct selinux_child_input *sci;
+    struct selinux_child_input **sci;
+    uint32_t num_sci;
+    uint32_t *results;
     struct tevent_context *ev;
     struct io_buffer *buf;
     struct child_io_fds *io;
@@ -567,11 +569,14 @@ static errno_t selinux_fork_child(struct selinux_child_state *state);
 static void selinux_child_step(struct tevent_req *subreq);
 static void selinux_child_done(struct tevent_req *subreq);
 static errno_t selinux_child_parse_response(uint8_t *buf, ssize_t len,
-                                            uint32_t *_child_result);
+                                            uint32_t num_sci,
+                                            uint32_t *_child_results);
 
+/* Sets the login mappings of all users in sci in one selinux_child run. */
 static struct tevent_req *selinux_child_send(TALLOC_CTX *mem_ctx,
                                              struct tevent_context *ev,
-                                             struct selinux_child_input *sci)
+                                             struct selinux_child_input **sci,
+                                             uint32_t num_sci)
 {
     struct tevent_req *req;
     struct tevent_req *subreq;
@@ -585,10 +590,12 @@ static struct tevent_req *selinux_child_send(TALLOC_CTX *mem_ctx,
     }
 
     state->sci = sci;
+    state->num_sci = num_sci;
     state->ev = ev;
     state->io = talloc(state, struct child_io_fds);
     state->buf = talloc(state, struct io_buffer);
-    if (state->io == NULL || state->buf == NULL) {
+    state->results = talloc_zero_array(state, uint32_t, num_sci);
+    if (state->io == NULL || state->buf == NULL || state->results == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "talloc failed.\n");
         ret = ENOMEM;
         goto immediately;
@@ -628,19 +635,24 @@ immediately:
     return req;
 }
 
+static size_t selinux_child_input_size(struct selinux_child_input *sci)
+{
+    return 3 * sizeof(uint32_t) + strlen(sci->seuser)
+           + strlen(sci->mls_range) + strlen(sci->username);
+}
+
 static errno_t selinux_child_create_buffer(struct selinux_child_state *state)
 {
     size_t rp;
     size_t seuser_len;
     size_t mls_range_len;
     size_t username_len;
+    uint32_t i;
 
-    seuser_len = strlen(state->sci->seuser);
-    mls_range_len = strlen(state->sci->mls_range);
-    username_len = strlen(state->sci->username);
-
-    state->buf->size = 3 * sizeof(uint32_t);
-    state->buf->size += seuser_len + mls_range_len + username_len;
+    state->buf->size = sizeof(uint32_t);
+    for (i = 0; i < state->num_sci; i++) {
+        state->buf->size += selinux_child_input_size(state->sci[i]);
+    }
 
     DEBUG(SSSDBG_TRACE_ALL, "buffer size: %zu\n", state->buf->size);
 
@@ -652,20 +664,29 @@ static errno_t selinux_child_create_buffer(struct selinux_child_state *state)
 
     rp = 0;
 
-    /* seuser */
-    SAFEALIGN_SET_UINT32(&state->buf->data[rp], seuser_len, &rp);
-    safealign_memcpy(&state->buf->data[rp], state->sci->seuser,
-                     seuser_len, &rp);
+    /* number of entries */
+    SAFEALIGN_SET_UINT32(&state->buf->data[rp], state->num_sci, &rp);
+
+    for (i = 0; i < state->num_sci; i++) {
+        seuser_len = strlen(state->sci[i]->seuser);
+        mls_range_len = strlen(state->sci[i]->mls_range);
+        username_len = strlen(state->sci[i]->username);
 
-    /* mls_range */
-    SAFEALIGN_SET_UINT32(&state->buf->data[rp], mls_range_len, &rp);
-    safealign_memcpy(&state->buf->data[rp], state->sci->mls_range,
-                     mls_range_len, &rp);
+        /* seuser */
+        SAFEALIGN_SET_UINT32(&state->buf->data[rp], seuser_len, &rp);
+        safealign_memcpy(&state->buf->data[rp], state->sci[i]->seuser,
+                         seuser_len, &rp);
 
-    /* username */
-    SAFEALIGN_SET_UINT32(&state->buf->data[rp], username_len, &rp);
-    safealign_memcpy(&state->buf->data[rp], state->sci->username,
-                     username_len, &rp);
+        /* mls_range */
+        SAFEALIGN_SET_UINT32(&state->buf->data[rp], mls_range_len, &rp);
+        safealign_memcpy(&state->buf->data[rp], state->sci[i]->mls_range,
+                         mls_range_len, &rp);
+
+        /* username */
+        SAFEALIGN_SET_UINT32(&state->buf->data[rp], username_len, &rp);
+        safealign_memcpy(&state->buf->data[rp], state->sci[i]->username,
+                         username_len, &rp);
+    }
 
     return EOK;
 }
@@ -693,32 +714,24 @@ static errno_t selinux_fork_child(struct selinux_child_state *state)
         return ret;
     }
 
-    pid = fork();
-
-    if (pid == 0) { /* child */
-        exec_child(state, pipefd_to_child, pipefd_from_child,
-                   SELINUX_CHILD, SELINUX_CHILD_LOG_FILE);
-        DEBUG(SSSDBG_CRIT_FAILURE, "Could not exec selinux_child: [%d][%s].\n",
-              ret, sss_strerror(ret));
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child,
+                          SELINUX_CHILD, SELINUX_CHILD_LOG_FILE, NULL, false,
+                          STDIN_FILENO, STDOUT_FILENO, &pid);
+    if (ret != EOK) {
         return ret;
-    } else if (pid > 0) { /* parent */
-        state->io->read_from_child_fd = pipefd_from_child[0];
-        close(pipefd_from_child[1]);
-        state->io->write_to_child_fd = pipefd_to_child[1];
-        close(pipefd_to_child[0]);
-        sss_fd_nonblocking(state->io->read_from_child_fd);
-        sss_fd_nonblocking(state->io->write_to_child_fd);
-
-        ret = child_handler_setup(state->ev, pid, NULL, NULL, NULL);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Could not set up child signal handler\n");
-            return ret;
-        }
-    } else { /* error */
-        ret = errno;
+    }
+
+    state->io->read_from_child_fd = pipefd_from_child[0];
+    close(pipefd_from_child[1]);
+    state->io->write_to_child_fd = pipefd_to_child[1];
+    close(pipefd_to_child[0]);
+    sss_fd_nonblocking(state->io->read_from_child_fd);
+    sss_fd_nonblocking(state->io->write_to_child_fd);
+
+    ret = child_handler_setup(state->ev, pid, NULL, NULL, NULL);
+    if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
-              "fork failed [%d][%s].\n", errno, sss_strerror(errno));
+              "Could not set up child signal handler\n");
         return ret;
     }
 
@@ -757,7 +770,6 @@ static void selinux_child_done(struct tevent_req *subreq)
 {
     struct tevent_req *req;
     struct selinux_child_state *state;
-    uint32_t child_result;
     errno_t ret;
     ssize_t len;
     uint8_t *buf;
@@ -775,19 +787,14 @@ static void selinux_child_done(struct tevent_req *subreq)
     close(state->io->read_from_child_fd);
     state->io->read_from_child_fd = -1;
 
-    ret = selinux_child_parse_response(buf, len, &child_result);
+    ret = selinux_child_parse_response(buf, len, state->num_sci,
+                                       state->results);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "selinux_child_parse_response failed: [%d][%s]\n",
               ret, strerror(ret));
         tevent_req_error(req, ret);
         return;
-    } else if (child_result != 0){
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Error in selinux_child: [%d][%s]\n",
-              child_result, strerror(child_result));
-        tevent_req_error(req, ERR_SELINUX_CONTEXT);
-        return;
     }
 
     tevent_req_done(req);
@@ -796,19 +803,296 @@ static void selinux_child_done(struct tevent_req *subreq)
 
 static errno_t selinux_child_parse_response(uint8_t *buf,
                                             ssize_t len,
-                                            uint32_t *_child_result)
+                                            uint32_t num_sci,
+                                            uint32_t *_child_results)
 {
     size_t p = 0;
-    uint32_t child_result;
+    uint32_t count;
+    uint32_t i;
 
-    /* semanage retval */
-    SAFEALIGN_COPY_UINT32_CHECK(&child_result, buf + p, len, &p);
+    SAFEALIGN_COPY_UINT32_CHECK(&count, buf + p, len, &p);
+    if (count != num_sci) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "selinux_child returned %u results, "
+              "expected %u\n", count, num_sci);
+        return EINVAL;
+    }
+
+    for (i = 0; i < count; i++) {
+        /* semanage retval */
+        SAFEALIGN_COPY_UINT32_CHECK(&_child_results[i], buf + p, len, &p);
+    }
+
+    return EOK;
+}
+
+static errno_t selinux_child_recv(struct tevent_req *req,
+                                  uint32_t **_results)
+{
+    struct selinux_child_state *state;
+
+    state = tevent_req_data(req, struct selinux_child_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_results = state->results;
 
-    *_child_result = child_result;
     return EOK;
 }
 
-static errno_t selinux_child_recv(struct tevent_req *req)
+/* Logins are serialized on the lock of the policy store, so login mappings
+ * that are requested while selinux_child is running, or within
+ * SELINUX_CHILD_BATCH_DELAY_MS of each other, are set by one selinux_child
+ * in a single semanage transaction. */
+#define SELINUX_CHILD_BATCH_DELAY_MS 20
+
+struct selinux_child_queue_state;
+
+struct selinux_child_queue {
+    struct tevent_context *ev;
+    struct tevent_timer *timer;
+    bool running;
+
+    /* List of waiting requests in the order of arrival. */
+    struct selinux_child_queue_state *waiting;
+};
+
+struct selinux_child_batch {
+    struct selinux_child_queue *queue;
+
+    /* Members are set to NULL when their request is freed. */
+    struct selinux_child_queue_state **members;
+    struct selinux_child_input **sci;
+    uint32_t num_members;
+};
+
+struct selinux_child_queue_state {
+    struct selinux_child_queue_state *prev;
+    struct selinux_child_queue_state *next;
+
+    struct selinux_child_queue *queue;
+    struct selinux_child_batch *batch;
+    uint32_t batch_idx;
+
+    struct tevent_req *req;
+    struct selinux_child_input *sci;
+};
+
+static void selinux_child_queue_schedule(struct selinux_child_queue *queue,
+                                         uint32_t delay_ms);
+
+static int
+selinux_child_queue_state_destructor(struct selinux_child_queue_state *state)
+{
+    if (state->batch != NULL) {
+        state->batch->members[state->batch_idx] = NULL;
+    } else {
+        DLIST_REMOVE(state->queue->waiting, state);
+    }
+
+    return 0;
+}
+
+static struct selinux_child_queue *
+selinux_child_queue_get(struct ipa_selinux_ctx *selinux_ctx,
+                        struct tevent_context *ev)
+{
+    if (selinux_ctx->child_queue == NULL) {
+        selinux_ctx->child_queue = talloc_zero(selinux_ctx,
+                                               struct selinux_child_queue);
+        if (selinux_ctx->child_queue == NULL) {
+            return NULL;
+        }
+
+        selinux_ctx->child_queue->ev = ev;
+    }
+
+    return selinux_ctx->child_queue;
+}
+
+static struct tevent_req *
+selinux_child_queue_send(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         struct ipa_selinux_ctx *selinux_ctx,
+                         struct selinux_child_input *sci)
+{
+    struct selinux_child_queue_state *state;
+    struct selinux_child_queue *queue;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct selinux_child_queue_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    queue = selinux_child_queue_get(selinux_ctx, ev);
+    if (queue == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    state->queue = queue;
+    state->req = req;
+    state->sci = talloc_steal(state, sci);
+
+    DLIST_ADD_END(queue->waiting, state, struct selinux_child_queue_state *);
+    talloc_set_destructor(state, selinux_child_queue_state_destructor);
+
+    if (!queue->running) {
+        selinux_child_queue_schedule(queue, SELINUX_CHILD_BATCH_DELAY_MS);
+    }
+
+    return req;
+
+immediately:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void selinux_child_queue_run(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv,
+                                    void *pvt);
+static void selinux_child_queue_done(struct tevent_req *subreq);
+
+static void selinux_child_queue_schedule(struct selinux_child_queue *queue,
+                                         uint32_t delay_ms)
+{
+    struct timeval tv;
+
+    if (queue->timer != NULL || queue->waiting == NULL) {
+        return;
+    }
+
+    tv = tevent_timeval_current_ofs(0, delay_ms * 1000);
+    queue->timer = tevent_add_timer(queue->ev, queue, tv,
+                                    selinux_child_queue_run, queue);
+    if (queue->timer == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule selinux_child\n");
+    }
+}
+
+static void selinux_child_batch_finish(struct selinux_child_batch *batch,
+                                       uint32_t *results,
+                                       errno_t ret)
+{
+    struct selinux_child_queue_state *state;
+    uint32_t i;
+
+    for (i = 0; i < batch->num_members; i++) {
+        state = batch->members[i];
+        if (state == NULL) {
+            continue;
+        }
+
+        batch->members[i] = NULL;
+        state->batch = NULL;
+        talloc_set_destructor(state, NULL);
+
+        if (ret != EOK) {
+            tevent_req_error(state->req, ret);
+        } else if (results[i] != 0) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Error in selinux_child: [%d][%s]\n",
+                  results[i], strerror(results[i]));
+            tevent_req_error(state->req, ERR_SELINUX_CONTEXT);
+        } else {
+            tevent_req_done(state->req);
+        }
+    }
+}
+
+static void selinux_child_queue_run(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv,
+                                    void *pvt)
+{
+    struct selinux_child_queue *queue;
+    struct selinux_child_queue_state *state;
+    struct selinux_child_batch *batch;
+    struct tevent_req *subreq;
+    size_t size = sizeof(uint32_t);
+
+    queue = talloc_get_type(pvt, struct selinux_child_queue);
+    queue->timer = NULL;
+
+    batch = talloc_zero(queue, struct selinux_child_batch);
+    if (batch == NULL) {
+        goto fail;
+    }
+    batch->queue = queue;
+
+    batch->members = talloc_zero_array(batch,
+                                       struct selinux_child_queue_state *,
+                                       SELINUX_CHILD_MAX_BATCH);
+    batch->sci = talloc_zero_array(batch, struct selinux_child_input *,
+                                   SELINUX_CHILD_MAX_BATCH);
+    if (batch->members == NULL || batch->sci == NULL) {
+        goto fail;
+    }
+
+    while ((state = queue->waiting) != NULL
+            && batch->num_members < SELINUX_CHILD_MAX_BATCH) {
+        size += selinux_child_input_size(state->sci);
+        if (batch->num_members > 0 && size > SELINUX_CHILD_IN_BUF_SIZE) {
+            break;
+        }
+
+        DLIST_REMOVE(queue->waiting, state);
+        state->batch = batch;
+        state->batch_idx = batch->num_members;
+
+        /* The input must outlive a request that is freed meanwhile. */
+        batch->members[batch->num_members] = state;
+        batch->sci[batch->num_members] = talloc_steal(batch, state->sci);
+        batch->num_members++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Setting SELinux login mappings of %u users\n",
+          batch->num_members);
+
+    subreq = selinux_child_send(batch, ev, batch->sci, batch->num_members);
+    if (subreq == NULL) {
+        selinux_child_batch_finish(batch, NULL, ENOMEM);
+        talloc_free(batch);
+        selinux_child_queue_schedule(queue, 0);
+        return;
+    }
+
+    queue->running = true;
+    tevent_req_set_callback(subreq, selinux_child_queue_done, batch);
+    return;
+
+fail:
+    talloc_free(batch);
+    while ((state = queue->waiting) != NULL) {
+        DLIST_REMOVE(queue->waiting, state);
+        talloc_set_destructor(state, NULL);
+        tevent_req_error(state->req, ENOMEM);
+    }
+}
+
+static void selinux_child_queue_done(struct tevent_req *subreq)
+{
+    struct selinux_child_queue *queue;
+    struct selinux_child_batch *batch;
+    uint32_t *results = NULL;
+    errno_t ret;
+
+    batch = tevent_req_callback_data(subreq, struct selinux_child_batch);
+    queue = batch->queue;
+
+    ret = selinux_child_recv(subreq, &results);
+    selinux_child_batch_finish(batch, results, ret);
+
+    queue->running = false;
+    talloc_free(batch);
+    selinux_child_queue_schedule(queue, 0);
+}
+
+static errno_t selinux_child_queue_recv(struct tevent_req *req)
 {
     TEVENT_REQ_RETURN_ON_ERROR(req);
     return EOK;
@@ -1502,6 +1786,72 @@ done:
     return ret;
 }
 
+static char *
+ipa_selinux_login_label(TALLOC_CTX *mem_ctx,
+                        struct selinux_child_input *sci)
+{
+    /* An empty SELinux user means that the mapping is removed. */
+    return talloc_asprintf(mem_ctx, "%s:%s", sci->seuser, sci->mls_range);
+}
+
+/* Returns true if selinux_child already wrote the same label for the user,
+ * in that case it would find out that there is nothing to update. */
+static bool
+ipa_selinux_login_label_unchanged(struct sss_domain_info *domain,
+                                  const char *username,
+                                  const char *label)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_SELINUX_LOGIN_LABEL, NULL };
+    struct ldb_result *res;
+    const char *stored;
+    bool unchanged = false;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return false;
+    }
+
+    ret = sysdb_get_user_attr(tmp_ctx, domain, username, attrs, &res);
+    if (ret != EOK || res->count != 1) {
+        goto done;
+    }
+
+    stored = ldb_msg_find_attr_as_string(res->msgs[0],
+                                         SYSDB_SELINUX_LOGIN_LABEL, NULL);
+    unchanged = stored != NULL && strcmp(stored, label) == 0;
+
+done:
+    talloc_free(tmp_ctx);
+    return unchanged;
+}
+
+static errno_t
+ipa_selinux_store_login_label(struct sss_domain_info *domain,
+                              const char *username,
+                              const char *label)
+{
+    struct sysdb_attrs *attrs;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(NULL);
+    if (attrs == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_SELINUX_LOGIN_LABEL, label);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_set_user_attr(domain, username, attrs, SYSDB_MOD_REP);
+
+done:
+    talloc_free(attrs);
+    return ret;
+}
+
 struct ipa_selinux_handler_state {
     struct be_ctx *be_ctx;
     struct tevent_context *ev;
@@ -1513,6 +1863,7 @@ struct ipa_selinux_handler_state {
 
     struct sysdb_attrs *user;
     struct sysdb_attrs *host;
+    char *login_label;
 };
 
 static void ipa_selinux_handler_get_done(struct tevent_req *subreq);
@@ -1623,10 +1974,28 @@ static void ipa_selinux_handler_get_done(struct tevent_req *subreq)
         goto done;
     }
 
+    state->login_label = ipa_selinux_login_label(state, sci);
+    if (state->login_label == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (ipa_selinux_login_label_unchanged(state->user_domain, state->pd->user,
+                                          state->login_label)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "SELinux label of %s is unchanged, "
+              "selinux_child is not needed\n", state->pd->user);
+        if (!be_is_offline(state->be_ctx)) {
+            state->selinux_ctx->last_update = time(NULL);
+        }
+        state->pd->pam_status = PAM_SUCCESS;
+        goto done;
+    }
+
     /* Update the SELinux context in a privileged child as the back end is
      * running unprivileged
      */
-    subreq = selinux_child_send(state, state->ev, sci);
+    subreq = selinux_child_queue_send(state, state->ev, state->selinux_ctx,
+                                      sci);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto done;
@@ -1648,13 +2017,21 @@ static void ipa_selinux_handler_done(struct tevent_req *subreq)
     req = tevent_req_callback_data(subreq, struct tevent_req);
     state = tevent_req_data(req, struct ipa_selinux_handler_state);
 
-    ret = selinux_child_recv(subreq);
+    ret = selinux_child_queue_recv(subreq);
     talloc_free(subreq);
     if (ret != EOK) {
         state->pd->pam_status = PAM_SYSTEM_ERR;
         goto done;
     }
 
+    ret = ipa_selinux_store_login_label(state->user_domain, state->pd->user,
+                                        state->login_label);
+    if (ret != EOK) {
+        /* selinux_child will be run again on the next login. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to store SELinux label of %s "
+              "[%d]: %s\n", state->pd->user, ret, sss_strerror(ret));
+    }
+
     if (!be_is_offline(state->be_ctx)) {
         state->selinux_ctx->last_update = time(NULL);
     }
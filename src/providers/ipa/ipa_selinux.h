@@ -27,9 +27,12 @@
 
 #include "providers/ldap/ldap_common.h"
 
+struct selinux_child_queue;
+
 struct ipa_selinux_ctx {
     struct ipa_id_ctx *id_ctx;
     time_t last_update;
+    struct selinux_child_queue *child_queue;
 
     struct sdap_search_base **selinux_search_bases;
     struct sdap_search_base **host_search_bases;
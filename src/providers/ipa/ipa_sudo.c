@@ -24,6 +24,7 @@
 #include "providers/ldap/ldap_opts.h"
 #include "providers/ipa/ipa_sudo.h"
 #include "db/sysdb_sudo.h"
+#include "util/sss_ptr_hash.h"
 
 struct ipa_sudo_handler_state {
     uint32_t type;
@@ -219,6 +220,12 @@ ipa_sudo_init_ipa_schema(TALLOC_CTX *mem_ctx,
     sudo_ctx->ipa_opts = id_ctx->ipa_options;
     sudo_ctx->sdap_opts = id_ctx->sdap_id_ctx->opts;
 
+    sudo_ctx->conv_cache = sss_ptr_hash_create(sudo_ctx, NULL, NULL);
+    if (sudo_ctx->conv_cache == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     ret = sdap_get_map(sudo_ctx, be_ctx->cdb, be_ctx->conf_path,
                        ipa_sudorule_map, IPA_OPTS_SUDORULE,
                        &sudo_ctx->sudorule_map);
@@ -34,6 +34,9 @@ struct ipa_sudo_ctx {
     struct sdap_attr_map *sudocmd_map;
     struct sdap_search_base **sudo_sb;
     int sudocmd_threshold;
+
+    /* rule name -> converted attributes, see ipa_sudo_conv_init() */
+    hash_table_t *conv_cache;
 };
 
 errno_t
@@ -75,6 +78,9 @@ ipa_sudo_refresh_recv(struct tevent_req *req,
 
 struct ipa_sudo_conv;
 
+/* If conv_cache is set, the attributes that are converted from the rule
+ * itself are kept there together with the rule entryUSN and are not
+ * converted again while the rule does not change. */
 struct ipa_sudo_conv *
 ipa_sudo_conv_init(TALLOC_CTX *mem_ctx,
                    struct sss_domain_info *dom,
@@ -84,7 +90,8 @@ ipa_sudo_conv_init(TALLOC_CTX *mem_ctx,
                    struct sdap_attr_map *map_user,
                    struct sdap_attr_map *map_group,
                    struct sdap_attr_map *map_host,
-                   struct sdap_attr_map *map_hostgroup);
+                   struct sdap_attr_map *map_hostgroup,
+                   hash_table_t *conv_cache);
 
 errno_t
 ipa_sudo_conv_rules(struct ipa_sudo_conv *conv,
@@ -123,9 +130,12 @@ ipa_sudo_conv_cmd_filter(TALLOC_CTX *mem_ctx,
                          struct ipa_sudo_conv *conv,
                          int cmd_threshold);
 
+/* If all_rules is true, conv contains all rules that apply to the host
+ * and the other rules are removed from the conversion cache. */
 errno_t
 ipa_sudo_conv_result(TALLOC_CTX *mem_ctx,
                      struct ipa_sudo_conv *conv,
+                     bool all_rules,
                      struct sysdb_attrs ***_rules,
                      size_t *_num_rules);
 
@@ -371,6 +371,7 @@ struct ipa_sudo_fetch_state {
     struct sdap_handle *sh;
     const char *search_filter;
     const char *cmdgroups_filter;
+    bool all_rules;
 
     struct sdap_attr_map *map_cmdgroup;
     struct sdap_attr_map *map_rule;
@@ -427,6 +428,8 @@ ipa_sudo_fetch_send(TALLOC_CTX *mem_ctx,
     state->sh = sh;
     state->search_filter = search_filter == NULL ? "" : search_filter;
     state->cmdgroups_filter = cmdgroups_filter;
+    state->all_rules = state->search_filter[0] == '\0'
+                       && cmdgroups_filter == NULL;
 
     state->map_cmdgroup = sudo_ctx->sudocmdgroup_map;
     state->map_rule = sudo_ctx->sudorule_map;
@@ -437,7 +440,7 @@ ipa_sudo_fetch_send(TALLOC_CTX *mem_ctx,
     state->conv = ipa_sudo_conv_init(state, domain, state->map_rule,
                                      state->map_cmdgroup, state->map_cmd,
                                      map_user, map_group, map_host,
-                                     map_hostgroup);
+                                     map_hostgroup, sudo_ctx->conv_cache);
     if (state->conv == NULL) {
         ret = ENOMEM;
         goto immediately;
@@ -798,7 +801,7 @@ ipa_sudo_fetch_done(struct tevent_req *req)
 
     DEBUG(SSSDBG_TRACE_FUNC, "About to convert rules\n");
 
-    ret = ipa_sudo_conv_result(state, state->conv,
+    ret = ipa_sudo_conv_result(state, state->conv, state->all_rules,
                                &state->rules, &state->num_rules);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to convert rules [%d]: %s\n",
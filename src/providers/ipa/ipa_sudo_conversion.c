@@ -28,6 +28,7 @@
 #include "db/sysdb_sudo.h"
 #include "db/sysdb.h"
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 
 #define SUDO_DN_CMDGROUPS "sudocmdgroups"
 #define SUDO_DN_CMDS      "sudocmds"
@@ -60,6 +61,16 @@ struct ipa_sudo_conv {
     hash_table_t *rules;
     hash_table_t *cmdgroups;
     hash_table_t *cmds;
+
+    hash_table_t *cache;
+};
+
+/* Result of convert_attributes(), which depends only on the rule. The
+ * commands are always built again since command groups and commands may
+ * change without changing the rule. */
+struct ipa_sudo_conv_cache_entry {
+    char *usn;
+    struct sysdb_attrs *attrs;
 };
 
 struct ipa_sudo_dn_list {
@@ -349,7 +360,8 @@ ipa_sudo_conv_init(TALLOC_CTX *mem_ctx,
                    struct sdap_attr_map *map_user,
                    struct sdap_attr_map *map_group,
                    struct sdap_attr_map *map_host,
-                   struct sdap_attr_map *map_hostgroup)
+                   struct sdap_attr_map *map_hostgroup,
+                   hash_table_t *conv_cache)
 {
     struct ipa_sudo_conv *conv;
     errno_t ret;
@@ -367,6 +379,7 @@ ipa_sudo_conv_init(TALLOC_CTX *mem_ctx,
     conv->map_group = map_group;
     conv->map_host = map_host;
     conv->map_hostgroup = map_hostgroup;
+    conv->cache = conv_cache;
 
     ret = sss_hash_create(conv, 20, &conv->rules);
     if (ret != EOK) {
@@ -769,6 +782,7 @@ struct ipa_sudo_conv_result_ctx {
     struct ipa_sudo_conv *conv;
     struct sysdb_attrs **rules;
     size_t num_rules;
+    size_t num_cached;
     errno_t ret;
 };
 
@@ -1210,6 +1224,92 @@ done:
     return ret;
 }
 
+static errno_t
+convert_attributes_cached(struct ipa_sudo_conv *conv,
+                          const char *name,
+                          struct ipa_sudo_rule *rule,
+                          struct sysdb_attrs *attrs,
+                          size_t *_num_cached)
+{
+    struct ipa_sudo_conv_cache_entry *entry;
+    const char *usn;
+    errno_t ret;
+
+    if (conv->cache == NULL) {
+        return convert_attributes(conv, rule, attrs);
+    }
+
+    ret = sysdb_attrs_get_string(rule->attrs, SYSDB_USN, &usn);
+    if (ret != EOK) {
+        /* Rules without entryUSN are converted every time. */
+        sss_ptr_hash_delete(conv->cache, name, true);
+        return convert_attributes(conv, rule, attrs);
+    }
+
+    entry = sss_ptr_hash_lookup(conv->cache, name,
+                                struct ipa_sudo_conv_cache_entry);
+    if (entry != NULL && strcmp(entry->usn, usn) == 0) {
+        (*_num_cached)++;
+        return sysdb_attrs_copy(entry->attrs, attrs);
+    }
+
+    ret = convert_attributes(conv, rule, attrs);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    sss_ptr_hash_delete(conv->cache, name, true);
+
+    /* A failure to cache the result is not fatal. */
+    entry = talloc_zero(conv->cache, struct ipa_sudo_conv_cache_entry);
+    if (entry == NULL) {
+        return EOK;
+    }
+
+    entry->usn = talloc_strdup(entry, usn);
+    entry->attrs = sysdb_new_attrs(entry);
+    if (entry->usn == NULL || entry->attrs == NULL
+            || sysdb_attrs_copy(attrs, entry->attrs) != EOK
+            || sss_ptr_hash_add(conv->cache, name, entry,
+                                struct ipa_sudo_conv_cache_entry) != EOK) {
+        talloc_free(entry);
+    }
+
+    return EOK;
+}
+
+static errno_t
+prune_conv_cache(struct ipa_sudo_conv *conv)
+{
+    TALLOC_CTX *tmp_ctx;
+    hash_key_t *keys;
+    unsigned long count;
+    unsigned long i;
+    int hret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    hret = hash_keys(conv->cache, &count, &keys);
+    if (hret != HASH_SUCCESS) {
+        talloc_free(tmp_ctx);
+        return EIO;
+    }
+    talloc_steal(tmp_ctx, keys);
+
+    for (i = 0; i < count; i++) {
+        if (ipa_sudo_conv_lookup(conv->rules, keys[i].str) == NULL) {
+            /* The rule was deleted or it does not apply anymore. */
+            sss_ptr_hash_delete(conv->cache, keys[i].str, true);
+        }
+    }
+
+    talloc_free(tmp_ctx);
+    return EOK;
+}
+
 static bool
 rules_iterator(hash_entry_t *item,
                void *user_data)
@@ -1235,7 +1335,8 @@ rules_iterator(hash_entry_t *item,
         return false;
     }
 
-    ctx->ret = convert_attributes(ctx->conv, rule, attrs);
+    ctx->ret = convert_attributes_cached(ctx->conv, item->key.str, rule,
+                                         attrs, &ctx->num_cached);
     if (ctx->ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Unable to convert attributes [%d]: %s\n",
               ctx->ret, sss_strerror(ctx->ret));
@@ -1292,14 +1393,24 @@ cmdgroups_iterator(hash_entry_t *item,
 errno_t
 ipa_sudo_conv_result(TALLOC_CTX *mem_ctx,
                      struct ipa_sudo_conv *conv,
+                     bool all_rules,
                      struct sysdb_attrs ***_rules,
                      size_t *_num_rules)
 {
     struct ipa_sudo_conv_result_ctx ctx;
     struct sysdb_attrs **rules;
     unsigned long num_rules;
+    errno_t ret;
     int hret;
 
+    if (all_rules && conv->cache != NULL) {
+        ret = prune_conv_cache(conv);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Unable to prune conversion cache "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+        }
+    }
+
     num_rules = hash_count(conv->rules);
     if (num_rules == 0) {
         *_rules = NULL;
@@ -1310,6 +1421,7 @@ ipa_sudo_conv_result(TALLOC_CTX *mem_ctx,
     ctx.conv = conv;
     ctx.rules = NULL;
     ctx.num_rules = 0;
+    ctx.num_cached = 0;
 
     /* If there are no cmdgroups the iterator is not called and ctx.ret is
      * uninitialized. Since it is ok that there are no cmdgroups initializing
@@ -1352,6 +1464,9 @@ ipa_sudo_conv_result(TALLOC_CTX *mem_ctx,
         return ctx.ret;
     }
 
+    DEBUG(SSSDBG_TRACE_FUNC, "Converted %zu sudo rules, %zu of them were "
+          "unchanged\n", ctx.num_rules, ctx.num_cached);
+
     *_rules = ctx.rules;
     *_num_rules = ctx.num_rules;
 
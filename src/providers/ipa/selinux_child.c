@@ -38,11 +38,12 @@ struct input_buffer {
     const char *username;
 };
 
-static errno_t unpack_buffer(uint8_t *buf,
-                             size_t size,
-                             struct input_buffer *ibuf)
+static errno_t unpack_entry(uint8_t *buf,
+                            size_t size,
+                            size_t *_p,
+                            struct input_buffer *ibuf)
 {
-    size_t p = 0;
+    size_t p = *_p;
     uint32_t len;
 
     /* seuser */
@@ -90,33 +91,86 @@ static errno_t unpack_buffer(uint8_t *buf,
         p += len;
     }
 
+    *_p = p;
     return EOK;
 }
 
-static errno_t pack_buffer(struct response *r, int result)
+static errno_t unpack_buffer(TALLOC_CTX *mem_ctx,
+                             uint8_t *buf,
+                             size_t size,
+                             struct input_buffer ***_ibufs,
+                             uint32_t *_count)
 {
+    struct input_buffer **ibufs;
     size_t p = 0;
+    uint32_t count;
+    uint32_t i;
+    errno_t ret;
+
+    /* number of entries */
+    SAFEALIGN_COPY_UINT32_CHECK(&count, buf + p, size, &p);
+    DEBUG(SSSDBG_TRACE_INTERNAL, "number of entries: %u\n", count);
+    if (count == 0 || count > SELINUX_CHILD_MAX_BATCH) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid number of entries: %u\n", count);
+        return EINVAL;
+    }
+
+    ibufs = talloc_zero_array(mem_ctx, struct input_buffer *, count);
+    if (ibufs == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        ibufs[i] = talloc_zero(ibufs, struct input_buffer);
+        if (ibufs[i] == NULL) {
+            return ENOMEM;
+        }
+
+        ret = unpack_entry(buf, size, &p, ibufs[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    *_ibufs = ibufs;
+    *_count = count;
+
+    return EOK;
+}
+
+static errno_t pack_buffer(struct response *r,
+                           uint32_t *results,
+                           uint32_t count)
+{
+    size_t p = 0;
+    uint32_t i;
 
     /* A buffer with the following structure must be created:
-     *   uint32_t status of the request (required)
+     *   uint32_t number of entries (required)
+     *   uint32_t status of each entry (required)
      */
-    r->size =  sizeof(uint32_t);
+    r->size = (count + 1) * sizeof(uint32_t);
 
     r->buf = talloc_array(r, uint8_t, r->size);
     if(r->buf == NULL) {
         return ENOMEM;
     }
 
-    DEBUG(SSSDBG_TRACE_FUNC, "result [%d]\n", result);
+    SAFEALIGN_SET_UINT32(&r->buf[p], count, &p);
+
+    for (i = 0; i < count; i++) {
+        DEBUG(SSSDBG_TRACE_FUNC, "result of entry %u [%d]\n", i, results[i]);
 
-    /* result */
-    SAFEALIGN_SET_UINT32(&r->buf[p], result, &p);
+        /* result */
+        SAFEALIGN_SET_UINT32(&r->buf[p], results[i], &p);
+    }
 
     return EOK;
 }
 
 static errno_t prepare_response(TALLOC_CTX *mem_ctx,
-                                int result,
+                                uint32_t *results,
+                                uint32_t count,
                                 struct response **rsp)
 {
     int ret;
@@ -130,7 +184,7 @@ static errno_t prepare_response(TALLOC_CTX *mem_ctx,
     r->buf = NULL;
     r->size = 0;
 
-    ret = pack_buffer(r, result);
+    ret = pack_buffer(r, results, count);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "pack_buffer failed\n");
         return ret;
@@ -141,8 +195,7 @@ static errno_t prepare_response(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
-static int sc_set_seuser(const char *login_name, const char *seuser_name,
-                         const char *mls)
+static int sc_set_seusers(struct sss_seuser_change *changes, size_t count)
 {
     int ret;
     mode_t old_mask;
@@ -153,15 +206,7 @@ static int sc_set_seuser(const char *login_name, const char *seuser_name,
      * libsemanage behaviour.
      */
     old_mask = umask(0);
-    if (strcmp(seuser_name, "") == 0) {
-        /* An empty SELinux user should cause SSSD to use the system
-         * default. We need to remove the SELinux user from the DB
-         * in that case
-         */
-        ret = sss_del_seuser(login_name);
-    } else {
-        ret = sss_set_seuser(login_name, seuser_name, mls);
-    }
+    ret = sss_set_seusers(changes, count);
     umask(old_mask);
     return ret;
 }
@@ -210,13 +255,19 @@ int main(int argc, const char *argv[])
     TALLOC_CTX *main_ctx = NULL;
     uint8_t *buf = NULL;
     ssize_t len = 0;
-    struct input_buffer *ibuf = NULL;
+    struct input_buffer **ibufs = NULL;
+    uint32_t count = 0;
+    struct sss_seuser_change *changes = NULL;
+    uint32_t *change_idx = NULL;
+    size_t num_changes = 0;
+    uint32_t *results = NULL;
     struct response *resp = NULL;
     struct passwd *passwd = NULL;
     ssize_t written;
     bool needs_update;
     const char *username;
     const char *opt_logger = NULL;
+    uint32_t i;
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
@@ -323,22 +374,16 @@ int main(int argc, const char *argv[])
     }
     talloc_steal(main_ctx, debug_prg_name);
 
-    buf = talloc_size(main_ctx, sizeof(uint8_t)*IN_BUF_SIZE);
+    buf = talloc_size(main_ctx, sizeof(uint8_t)*SELINUX_CHILD_IN_BUF_SIZE);
     if (buf == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "talloc_size failed.\n");
         goto fail;
     }
 
-    ibuf = talloc_zero(main_ctx, struct input_buffer);
-    if (ibuf == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero failed.\n");
-        goto fail;
-    }
-
     DEBUG(SSSDBG_TRACE_FUNC, "context initialized\n");
 
     errno = 0;
-    len = sss_atomic_read_s(STDIN_FILENO, buf, IN_BUF_SIZE);
+    len = sss_atomic_read_s(STDIN_FILENO, buf, SELINUX_CHILD_IN_BUF_SIZE);
     if (len == -1) {
         ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE, "read failed [%d][%s].\n", ret, strerror(ret));
@@ -347,44 +392,78 @@ int main(int argc, const char *argv[])
 
     close(STDIN_FILENO);
 
-    ret = unpack_buffer(buf, len, ibuf);
+    ret = unpack_buffer(main_ctx, buf, len, &ibufs, &count);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "unpack_buffer failed.[%d][%s].\n", ret, strerror(ret));
         goto fail;
     }
 
+    changes = talloc_zero_array(main_ctx, struct sss_seuser_change, count);
+    change_idx = talloc_zero_array(main_ctx, uint32_t, count);
+    results = talloc_zero_array(main_ctx, uint32_t, count);
+    if (changes == NULL || change_idx == NULL || results == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero_array failed.\n");
+        goto fail;
+    }
+
     DEBUG(SSSDBG_TRACE_FUNC, "performing selinux operations\n");
 
-    /* When using domain_resolution_order the username will always be
-     * fully-qualified, what has been causing some SELinux issues as mappings
-     * for user 'admin' are not applied for 'admin@ipa.example'.
-     *
-     * In order to work this around we can take advantage that selinux_child
-     * queries SSSD since commit 92addd7ba and call getpwnam() in order to get
-     * the username in the correct format. */
-    passwd = getpwnam(ibuf->username);
-    if (passwd == NULL) {
-        username = ibuf->username;
-        DEBUG(SSSDBG_MINOR_FAILURE,
-              "getpwnam() failed to get info for the user \"%s\". SELinux label "
-              "setting might fail as well!\n",
-              ibuf->username);
-    } else {
-        username = passwd->pw_name;
+    for (i = 0; i < count; i++) {
+        /* When using domain_resolution_order the username will always be
+         * fully-qualified, what has been causing some SELinux issues as
+         * mappings for user 'admin' are not applied for 'admin@ipa.example'.
+         *
+         * In order to work this around we can take advantage that
+         * selinux_child queries SSSD since commit 92addd7ba and call
+         * getpwnam() in order to get the username in the correct format. */
+        passwd = getpwnam(ibufs[i]->username);
+        if (passwd == NULL) {
+            username = ibufs[i]->username;
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "getpwnam() failed to get info for the user \"%s\". SELinux "
+                  "label setting might fail as well!\n",
+                  ibufs[i]->username);
+        } else {
+            username = talloc_strdup(ibufs[i], passwd->pw_name);
+            if (username == NULL) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "talloc_strdup failed.\n");
+                goto fail;
+            }
+        }
+
+        needs_update = seuser_needs_update(username, ibufs[i]->seuser,
+                                           ibufs[i]->mls_range);
+        if (needs_update == false) {
+            continue;
+        }
+
+        changes[num_changes].login_name = username;
+        /* An empty SELinux user should cause SSSD to use the system
+         * default. We need to remove the SELinux user from the DB
+         * in that case
+         */
+        if (strcmp(ibufs[i]->seuser, "") != 0) {
+            changes[num_changes].seuser_name = ibufs[i]->seuser;
+            changes[num_changes].mls = ibufs[i]->mls_range;
+        }
+        change_idx[num_changes] = i;
+        num_changes++;
     }
 
-    needs_update = seuser_needs_update(username, ibuf->seuser,
-                                       ibuf->mls_range);
-    if (needs_update == true) {
-        ret = sc_set_seuser(username, ibuf->seuser, ibuf->mls_range);
+    if (num_changes > 0) {
+        /* The per-entry results are set even if the commit failed. */
+        ret = sc_set_seusers(changes, num_changes);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Cannot set SELinux login context.\n");
-            goto fail;
+        }
+
+        for (i = 0; i < num_changes; i++) {
+            results[change_idx[i]] = changes[i].ret;
         }
     }
 
-    ret = prepare_response(main_ctx, ret, &resp);
+    ret = prepare_response(main_ctx, results, count, &resp);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to prepare response buffer.\n");
         goto fail;
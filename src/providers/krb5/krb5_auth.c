@@ -808,6 +808,27 @@ done:
     }
 }
 
+static void krb5_auth_check_kdc_time(struct krb5_ctx *krb5_ctx,
+                                     struct fo_server *srv,
+                                     uint32_t kdc_msec)
+{
+    int timeout;
+
+    if (srv == NULL || kdc_msec == 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "KDC [%s] answered in [%"PRIu32"] ms.\n",
+          fo_get_server_name(srv), kdc_msec);
+
+    timeout = dp_opt_get_int(krb5_ctx->opts, KRB5_AUTH_TIMEOUT);
+    if (timeout > 0 && kdc_msec > (uint32_t) timeout * 500) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "KDC [%s] needed [%"PRIu32"] ms, more than half of "
+              "krb5_auth_timeout.\n", fo_get_server_name(srv), kdc_msec);
+    }
+}
+
 static void krb5_auth_done(struct tevent_req *subreq)
 {
     struct tevent_req *req = tevent_req_callback_data(subreq, struct tevent_req);
@@ -893,6 +914,8 @@ static void krb5_auth_done(struct tevent_req *subreq)
         goto done;
     }
 
+    krb5_auth_check_kdc_time(kr->krb5_ctx, kr->srv, res->kdc_msec);
+
     if (res->ccname) {
         kr->ccname = talloc_strdup(kr, res->ccname);
         if (!kr->ccname) {
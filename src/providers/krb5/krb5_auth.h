@@ -112,6 +112,8 @@ struct krb5_child_response {
     char *ccname;
     char *correct_upn;
     bool otp;
+    /* Milliseconds the child spent waiting for the KDC, 0 if unknown. */
+    uint32_t kdc_msec;
 };
 
 errno_t
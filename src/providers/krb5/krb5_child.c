@@ -28,6 +28,7 @@
 #include <fcntl.h>
 #include <ctype.h>
 #include <popt.h>
+#include <time.h>
 
 #include <security/pam_modules.h>
 
@@ -96,6 +97,7 @@ struct krb5_req {
     bool send_pac;
     bool use_enterprise_princ;
     char *fast_ccname;
+    char *preferred_kdc;
 
     const char *upn;
     uid_t uid;
@@ -953,6 +955,57 @@ static errno_t handle_randomized(char *in)
     return EOK;
 }
 
+/* Checks if the ccache already holds a ticket for the same client and server
+ * as creds which is valid at least as long as creds. Rewriting the ccache in
+ * this case would not give the user anything new, but it can be expensive,
+ * e.g. with FILE ccaches on network file systems. */
+static bool ccache_has_current_cred(krb5_context kctx, krb5_ccache kcc,
+                                    krb5_creds *creds)
+{
+    krb5_principal ccprinc = NULL;
+    krb5_creds mcred;
+    krb5_creds cred;
+    krb5_error_code kerr;
+    bool current = false;
+
+    if (creds->server == NULL || creds->times.endtime == 0) {
+        /* Empty credentials used for offline authentication */
+        return false;
+    }
+
+    kerr = krb5_cc_get_principal(kctx, kcc, &ccprinc);
+    if (kerr != 0) {
+        /* Not initialized yet */
+        return false;
+    }
+
+    if (krb5_principal_compare(kctx, ccprinc, creds->client) == FALSE) {
+        goto done;
+    }
+
+    memset(&mcred, 0, sizeof(mcred));
+    memset(&cred, 0, sizeof(cred));
+    mcred.client = creds->client;
+    mcred.server = creds->server;
+
+    kerr = krb5_cc_retrieve_cred(kctx, kcc, 0, &mcred, &cred);
+    if (kerr != 0) {
+        goto done;
+    }
+
+    if (cred.times.endtime > time(NULL)
+            && cred.times.endtime >= creds->times.endtime
+            && cred.times.renew_till >= creds->times.renew_till) {
+        current = true;
+    }
+
+    krb5_free_cred_contents(kctx, &cred);
+
+done:
+    krb5_free_principal(kctx, ccprinc);
+    return current;
+}
+
 /* NOTE: callers rely on 'name' being *changed* if it needs to be randomized,
  * as they will then send the name back to the new name via the return call
  * k5c_attach_ccname_msg(). Callers will send in a copy of the name if they
@@ -1021,6 +1074,13 @@ static krb5_error_code create_ccache(char *ccname, krb5_creds *creds)
     }
 #endif
 
+    if (ccache_has_current_cred(kctx, kcc, creds)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "ccache already contains a current TGT, not rewriting it\n");
+        kerr = 0;
+        goto switch_cc;
+    }
+
     kerr = krb5_cc_initialize(kctx, kcc, creds->client);
     if (kerr) {
         DEBUG(SSSDBG_TRACE_ALL, "krb5_cc_initialize failed\n");
@@ -1035,6 +1095,7 @@ static krb5_error_code create_ccache(char *ccname, krb5_creds *creds)
         goto done;
     }
 
+switch_cc:
 #ifdef HAVE_KRB5_CC_COLLECTION
     if (switch_to_cc) {
         DEBUG(SSSDBG_TRACE_ALL, "switch_to_cc\n");
@@ -1177,6 +1238,34 @@ static errno_t k5c_attach_ccname_msg(struct krb5_req *kr)
     return ret;
 }
 
+/* Time the request spent talking to the KDC, the back end uses it to tell
+ * if the KDC selected by fail over is slow. */
+static void k5c_add_kdc_time(struct krb5_req *kr, struct timespec *start,
+                             errno_t error)
+{
+    struct timespec now;
+    uint32_t msec;
+    errno_t ret;
+
+    if (error == ERR_NETWORK_IO) {
+        /* The KDC did not answer at all. */
+        return;
+    }
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+        return;
+    }
+
+    msec = (now.tv_sec - start->tv_sec) * 1000
+           + (now.tv_nsec - start->tv_nsec) / 1000000;
+
+    ret = pam_add_response(kr->pd, SSS_KRB5_INFO_KDC_TIME, sizeof(uint32_t),
+                           (uint8_t *) &msec);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "pam_add_response failed.\n");
+    }
+}
+
 static errno_t k5c_send_data(struct krb5_req *kr, int fd, errno_t error)
 {
     ssize_t written;
@@ -2470,16 +2559,25 @@ static errno_t unpack_buffer(uint8_t *buf, size_t size,
         if (kr->keytab == NULL) return ENOMEM;
         p += len;
 
+        SAFEALIGN_COPY_UINT32_CHECK(&len, buf + p, size, &p);
+        if (len > size - p) return EINVAL;
+        if (len > 0) {
+            kr->preferred_kdc = talloc_strndup(pd, (char *)(buf + p), len);
+            if (kr->preferred_kdc == NULL) return ENOMEM;
+            p += len;
+        }
+
         ret = unpack_authtok(pd->authtok, buf, size, &p);
         if (ret) {
             return ret;
         }
 
         DEBUG(SSSDBG_CONF_SETTINGS,
-              "ccname: [%s] old_ccname: [%s] keytab: [%s]\n",
+              "ccname: [%s] old_ccname: [%s] keytab: [%s] KDC: [%s]\n",
               kr->ccname,
               kr->old_ccname ? kr->old_ccname : "not set",
-              kr->keytab);
+              kr->keytab,
+              kr->preferred_kdc ? kr->preferred_kdc : "not set");
     } else {
         kr->ccname = NULL;
         kr->old_ccname = NULL;
@@ -2779,6 +2877,9 @@ static errno_t k5c_recv_data(struct krb5_req *kr, int fd, uint32_t *offline)
         DEBUG(SSSDBG_CRIT_FAILURE,
               "read failed [%d][%s].\n", ret, strerror(ret));
         return ret;
+    } else if (len == 0) {
+        /* A spare child that was not needed. */
+        return ENODATA;
     }
 
     ret = unpack_buffer(buf, len, kr, offline);
@@ -3127,18 +3228,17 @@ static krb5_error_code privileged_krb5_setup(struct krb5_req *kr,
     kr->realm = kr->cli_opts->realm;
     if (kr->realm == NULL) {
         DEBUG(SSSDBG_MINOR_FAILURE, "Realm not available.\n");
-    }
-
-    kerr = krb5_init_context(&kr->ctx);
-    if (kerr != 0) {
-        KRB5_CHILD_DEBUG(SSSDBG_CRIT_FAILURE, kerr);
-        return kerr;
-    }
-
-    kerr = sss_krb5_get_init_creds_opt_alloc(kr->ctx, &kr->options);
-    if (kerr != 0) {
-        KRB5_CHILD_DEBUG(SSSDBG_CRIT_FAILURE, kerr);
-        return kerr;
+    } else if (kr->preferred_kdc != NULL) {
+        /* The locator plugin reads them when libkrb5 looks up the KDC
+         * for the first time. */
+        if (setenv(SSSD_KRB5_LOCATOR_PREFERRED_REALM, kr->realm, 1) != 0
+                || setenv(SSSD_KRB5_LOCATOR_PREFERRED_KDC,
+                          kr->preferred_kdc, 1) != 0) {
+            ret = errno;
+            DEBUG(SSSDBG_MINOR_FAILURE, "setenv failed [%d][%s], the KDC "
+                  "is looked up by the locator plugin.\n",
+                  ret, sss_strerror(ret));
+        }
     }
 
     ret = check_use_fast(kr->cli_opts->use_fast_str, &kr->fast_val);
@@ -3226,6 +3326,7 @@ int main(int argc, const char *argv[])
     gid_t fast_gid = 0;
     struct cli_opts cli_opts = { 0 };
     int sss_creds_password = 0;
+    struct timespec kdc_start;
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
@@ -3323,8 +3424,29 @@ int main(int argc, const char *argv[])
         kr->krb5_get_init_creds_password = krb5_get_init_creds_password;
     }
 
+    /* The back end may start krb5_child before there is a request for it,
+     * so everything that does not depend on the request is done before
+     * reading it. */
+    kerr = krb5_init_context(&kr->ctx);
+    if (kerr != 0) {
+        KRB5_CHILD_DEBUG(SSSDBG_CRIT_FAILURE, kerr);
+        ret = EFAULT;
+        goto done;
+    }
+
+    kerr = sss_krb5_get_init_creds_opt_alloc(kr->ctx, &kr->options);
+    if (kerr != 0) {
+        KRB5_CHILD_DEBUG(SSSDBG_CRIT_FAILURE, kerr);
+        ret = EFAULT;
+        goto done;
+    }
+
     ret = k5c_recv_data(kr, STDIN_FILENO, &offline);
-    if (ret != EOK) {
+    if (ret == ENODATA) {
+        DEBUG(SSSDBG_TRACE_FUNC, "No request was received.\n");
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
         goto done;
     }
 
@@ -3370,6 +3492,8 @@ int main(int argc, const char *argv[])
         goto done;
     }
 
+    clock_gettime(CLOCK_MONOTONIC, &kdc_start);
+
     switch(kr->pd->cmd) {
     case SSS_PAM_AUTHENTICATE:
         /* If we are offline, we need to create an empty ccache file */
@@ -3413,6 +3537,10 @@ int main(int argc, const char *argv[])
         goto done;
     }
 
+    if (!offline && kr->pd->cmd != SSS_PAM_ACCT_MGMT) {
+        k5c_add_kdc_time(kr, &kdc_start, ret);
+    }
+
     ret = k5c_send_data(kr, STDOUT_FILENO, ret);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to send reply\n");
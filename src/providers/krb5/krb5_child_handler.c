@@ -23,6 +23,7 @@
 */
 
 #include <signal.h>
+#include <fcntl.h>
 
 #include "util/util.h"
 #include "util/child_common.h"
@@ -115,6 +116,8 @@ static errno_t create_send_buffer(struct krb5child_req *kr,
     uint32_t use_enterprise_principal;
     uint32_t posix_domain;
     size_t username_len = 0;
+    char *kdc = NULL;
+    size_t kdc_len = 0;
     errno_t ret;
 
     keytab = dp_opt_get_cstring(kr->krb5_ctx->opts, KRB5_KEYTAB);
@@ -157,6 +160,17 @@ static errno_t create_send_buffer(struct krb5child_req *kr,
                                          KRB5_USE_ENTERPRISE_PRINCIPAL) ? 1 : 0;
     }
 
+    /* Let the child use the KDC selected by fail over instead of starting
+     * with whatever the locator plugin finds first. */
+    if (!kr->is_offline && kr->srv != NULL
+            && kr->krb5_ctx->service != NULL
+            && kr->krb5_ctx->service->write_kdcinfo) {
+        kdc = krb5_fo_server_address_port(kr, kr->srv);
+        if (kdc != NULL) {
+            kdc_len = strlen(kdc);
+        }
+    }
+
     buf = talloc(kr, struct io_buffer);
     if (buf == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "talloc failed.\n");
@@ -170,8 +184,8 @@ static errno_t create_send_buffer(struct krb5child_req *kr,
         kr->pd->cmd == SSS_CMD_RENEW ||
         kr->pd->cmd == SSS_PAM_CHAUTHTOK_PRELIM ||
         kr->pd->cmd == SSS_PAM_CHAUTHTOK) {
-        buf->size += 4*sizeof(uint32_t) + strlen(kr->ccname) + strlen(keytab) +
-                     sss_authtok_get_size(kr->pd->authtok);
+        buf->size += 5*sizeof(uint32_t) + strlen(kr->ccname) + strlen(keytab) +
+                     kdc_len + sss_authtok_get_size(kr->pd->authtok);
 
         buf->size += sizeof(uint32_t);
         if (kr->old_ccname) {
@@ -228,6 +242,11 @@ static errno_t create_send_buffer(struct krb5child_req *kr,
         SAFEALIGN_SET_UINT32(&buf->data[rp], strlen(keytab), &rp);
         safealign_memcpy(&buf->data[rp], keytab, strlen(keytab), &rp);
 
+        SAFEALIGN_SET_UINT32(&buf->data[rp], kdc_len, &rp);
+        if (kdc_len > 0) {
+            safealign_memcpy(&buf->data[rp], kdc, kdc_len, &rp);
+        }
+
         ret = pack_authtok(buf, &rp, kr->pd->authtok);
         if (ret) {
             return ret;
@@ -429,17 +448,19 @@ done:
     return ret;
 }
 
-static errno_t fork_child(struct tevent_req *req)
+static errno_t spawn_child(TALLOC_CTX *mem_ctx,
+                           struct tevent_context *ev,
+                           struct krb5_ctx *krb5_ctx,
+                           struct child_io_fds *io,
+                           pid_t *_pid)
 {
     int pipefd_to_child[2] = PIPE_INIT;
     int pipefd_from_child[2] = PIPE_INIT;
     pid_t pid;
     errno_t ret;
     const char **krb5_child_extra_args;
-    struct handle_child_state *state = tevent_req_data(req,
-                                                     struct handle_child_state);
 
-    ret = set_extra_args(state, state->kr->krb5_ctx, &krb5_child_extra_args);
+    ret = set_extra_args(mem_ctx, krb5_ctx, &krb5_child_extra_args);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "set_extra_args failed.\n");
         goto fail;
@@ -460,47 +481,37 @@ static errno_t fork_child(struct tevent_req *req)
         goto fail;
     }
 
-    pid = fork();
-
-    if (pid == 0) { /* child */
-        exec_child_ex(state,
-                      pipefd_to_child, pipefd_from_child,
-                      KRB5_CHILD, KRB5_CHILD_LOG_FILE,
-                      krb5_child_extra_args, false,
-                      STDIN_FILENO, STDOUT_FILENO);
-
-        /* We should never get here */
-        DEBUG(SSSDBG_CRIT_FAILURE, "BUG: Could not exec KRB5 child\n");
-    } else if (pid > 0) { /* parent */
-        state->child_pid = pid;
-        state->io->read_from_child_fd = pipefd_from_child[0];
-        PIPE_FD_CLOSE(pipefd_from_child[1]);
-        state->io->write_to_child_fd = pipefd_to_child[1];
-        PIPE_FD_CLOSE(pipefd_to_child[0]);
-        sss_fd_nonblocking(state->io->read_from_child_fd);
-        sss_fd_nonblocking(state->io->write_to_child_fd);
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child,
+                          KRB5_CHILD, KRB5_CHILD_LOG_FILE,
+                          krb5_child_extra_args, false,
+                          STDIN_FILENO, STDOUT_FILENO, &pid);
+    if (ret != EOK) {
+        goto fail;
+    }
 
-        ret = child_handler_setup(state->ev, pid, NULL, NULL, NULL);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Could not set up child signal handler\n");
-            goto fail;
-        }
+    io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(io->read_from_child_fd);
+    sss_fd_nonblocking(io->write_to_child_fd);
 
-        ret = activate_child_timeout_handler(req, state->ev,
-                  dp_opt_get_int(state->kr->krb5_ctx->opts, KRB5_AUTH_TIMEOUT));
-        if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "activate_child_timeout_handler failed.\n");
-        }
+    /* Spare children keep their pipes open for a long time, children
+     * started later must not inherit them or the spare would never see
+     * the end of its input. */
+    (void)fcntl(io->read_from_child_fd, F_SETFD, FD_CLOEXEC);
+    (void)fcntl(io->write_to_child_fd, F_SETFD, FD_CLOEXEC);
 
-    } else { /* error */
-        ret = errno;
+    ret = child_handler_setup(ev, pid, NULL, NULL, NULL);
+    if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
-              "fork failed [%d][%s].\n", errno, strerror(ret));
+              "Could not set up child signal handler\n");
         goto fail;
     }
 
+    talloc_free(krb5_child_extra_args);
+    *_pid = pid;
+
     return EOK;
 
 fail:
@@ -509,6 +520,195 @@ fail:
     return ret;
 }
 
+/* Spare krb5_child processes are started in advance and wait for their
+ * request on stdin after the initialization that does not depend on the
+ * request. Each of them still handles only one request since it drops its
+ * privileges to the user it authenticates. Spares older than
+ * KRB5_CHILD_SPARE_MAX_AGE are replaced to pick up changes of krb5.conf. */
+#define KRB5_CHILD_SPARE_MAX_AGE 60
+
+struct krb5_child_spare {
+    struct krb5_child_spare *prev;
+    struct krb5_child_spare *next;
+
+    struct krb5_child_pool *pool;
+    struct child_io_fds *io;
+    pid_t pid;
+    time_t started;
+};
+
+struct krb5_child_pool {
+    struct tevent_context *ev;
+    struct krb5_ctx *krb5_ctx;
+    struct tevent_timer *refill_timer;
+
+    struct krb5_child_spare *spares;
+    unsigned int num_spares;
+    unsigned int size;
+};
+
+static int krb5_child_spare_destructor(struct krb5_child_spare *spare)
+{
+    /* Closing the pipes makes an unused child exit. */
+    DLIST_REMOVE(spare->pool->spares, spare);
+    spare->pool->num_spares--;
+
+    return 0;
+}
+
+static void krb5_child_pool_refill(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval tv,
+                                   void *pvt)
+{
+    struct krb5_child_pool *pool;
+    struct krb5_child_spare *spare;
+    errno_t ret;
+
+    pool = talloc_get_type(pvt, struct krb5_child_pool);
+    pool->refill_timer = NULL;
+
+    while (pool->num_spares < pool->size) {
+        spare = talloc_zero(pool, struct krb5_child_spare);
+        if (spare == NULL) {
+            return;
+        }
+
+        spare->io = talloc(spare, struct child_io_fds);
+        if (spare->io == NULL) {
+            talloc_free(spare);
+            return;
+        }
+        spare->io->write_to_child_fd = -1;
+        spare->io->read_from_child_fd = -1;
+        talloc_set_destructor((void *) spare->io, child_io_destructor);
+
+        ret = spawn_child(spare, ev, pool->krb5_ctx, spare->io, &spare->pid);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to start spare krb5_child "
+                  "[%d]: %s\n", ret, sss_strerror(ret));
+            talloc_free(spare);
+            return;
+        }
+
+        spare->pool = pool;
+        spare->started = time(NULL);
+        DLIST_ADD_END(pool->spares, spare, struct krb5_child_spare *);
+        pool->num_spares++;
+        talloc_set_destructor(spare, krb5_child_spare_destructor);
+    }
+}
+
+static void krb5_child_pool_schedule_refill(struct krb5_child_pool *pool)
+{
+    struct timeval tv;
+
+    if (pool->refill_timer != NULL || pool->num_spares >= pool->size) {
+        return;
+    }
+
+    /* Start the replacements after the current request is sent. */
+    tv = tevent_timeval_current_ofs(0, 0);
+    pool->refill_timer = tevent_add_timer(pool->ev, pool, tv,
+                                          krb5_child_pool_refill, pool);
+    if (pool->refill_timer == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to schedule spare krb5_child\n");
+    }
+}
+
+static struct krb5_child_pool *
+krb5_child_pool_get(struct tevent_context *ev, struct krb5_ctx *krb5_ctx)
+{
+    int size;
+
+    if (krb5_ctx->child_pool != NULL) {
+        return krb5_ctx->child_pool;
+    }
+
+    size = dp_opt_get_int(krb5_ctx->opts, KRB5_CHILD_POOL_SIZE);
+    if (size <= 0) {
+        return NULL;
+    }
+
+    krb5_ctx->child_pool = talloc_zero(krb5_ctx, struct krb5_child_pool);
+    if (krb5_ctx->child_pool == NULL) {
+        return NULL;
+    }
+
+    krb5_ctx->child_pool->ev = ev;
+    krb5_ctx->child_pool->krb5_ctx = krb5_ctx;
+    krb5_ctx->child_pool->size = size;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Keeping %d spare krb5_child processes\n",
+          size);
+
+    return krb5_ctx->child_pool;
+}
+
+/* Moves the pipes of a spare child to io and returns its pid, or -1 if
+ * there is no usable spare child. */
+static pid_t krb5_child_pool_take(struct krb5_child_pool *pool,
+                                  struct child_io_fds *io)
+{
+    struct krb5_child_spare *spare;
+    time_t now;
+    pid_t pid = -1;
+
+    if (pool == NULL) {
+        return -1;
+    }
+
+    now = time(NULL);
+    while ((spare = pool->spares) != NULL) {
+        if (now - spare->started > KRB5_CHILD_SPARE_MAX_AGE) {
+            talloc_free(spare);
+            continue;
+        }
+
+        pid = spare->pid;
+        *io = *spare->io;
+        spare->io->read_from_child_fd = -1;
+        spare->io->write_to_child_fd = -1;
+        talloc_free(spare);
+        break;
+    }
+
+    krb5_child_pool_schedule_refill(pool);
+
+    return pid;
+}
+
+static errno_t fork_child(struct tevent_req *req)
+{
+    struct krb5_child_pool *pool;
+    errno_t ret;
+    struct handle_child_state *state = tevent_req_data(req,
+                                                     struct handle_child_state);
+
+    pool = krb5_child_pool_get(state->ev, state->kr->krb5_ctx);
+
+    state->child_pid = krb5_child_pool_take(pool, state->io);
+    if (state->child_pid == -1) {
+        ret = spawn_child(state, state->ev, state->kr->krb5_ctx, state->io,
+                          &state->child_pid);
+        if (ret != EOK) {
+            return ret;
+        }
+    } else {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Using spare krb5_child [%d]\n",
+              state->child_pid);
+    }
+
+    ret = activate_child_timeout_handler(req, state->ev,
+              dp_opt_get_int(state->kr->krb5_ctx->opts, KRB5_AUTH_TIMEOUT));
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "activate_child_timeout_handler failed.\n");
+    }
+
+    return EOK;
+}
+
 static void handle_child_step(struct tevent_req *subreq);
 static void handle_child_done(struct tevent_req *subreq);
 
@@ -655,6 +855,7 @@ parse_krb5_child_response(TALLOC_CTX *mem_ctx, uint8_t *buf, ssize_t len,
     const char *upn = NULL;
     size_t upn_len = 0;
     bool otp = false;
+    uint32_t kdc_msec = 0;
 
     if ((size_t) len < sizeof(int32_t)) {
         DEBUG(SSSDBG_CRIT_FAILURE, "message too short.\n");
@@ -742,6 +943,13 @@ parse_krb5_child_response(TALLOC_CTX *mem_ctx, uint8_t *buf, ssize_t len,
             skip = true;
         }
 
+        if (msg_type == SSS_KRB5_INFO_KDC_TIME) {
+            if (msg_len == sizeof(uint32_t)) {
+                SAFEALIGN_COPY_UINT32(&kdc_msec, buf + p, NULL);
+            }
+            skip = true;
+        }
+
         if (!skip) {
             ret = pam_add_response(pd, msg_type, msg_len, &buf[p]);
             if (ret != EOK) {
@@ -763,6 +971,7 @@ parse_krb5_child_response(TALLOC_CTX *mem_ctx, uint8_t *buf, ssize_t len,
     if (!res) return ENOMEM;
 
     res->otp = otp;
+    res->kdc_msec = kdc_msec;
     res->msg_status = msg_status;
     memcpy(&res->tgtt, &tgtt, sizeof(tgtt));
 
@@ -688,6 +688,38 @@ static const char* fo_server_address_or_name(TALLOC_CTX *tmp_ctx, struct fo_serv
     return fo_get_server_name(server);
 }
 
+/* Address of the server in the format used in the kdcinfo files, including
+ * the port if it is known. */
+char *krb5_fo_server_address_port(TALLOC_CTX *mem_ctx,
+                                  struct fo_server *server)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *address;
+    char *address_port = NULL;
+    int port;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return NULL;
+    }
+
+    address = fo_server_address_or_name(tmp_ctx, server);
+    if (address == NULL) {
+        goto done;
+    }
+
+    port = fo_get_server_port(server);
+    if (port > 0) {
+        address_port = talloc_asprintf(mem_ctx, "%s:%d", address, port);
+    } else {
+        address_port = talloc_strdup(mem_ctx, address);
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return address_port;
+}
+
 errno_t write_krb5info_file_from_fo_server(struct krb5_service *krb5_service,
                                            struct fo_server *server,
                                            const char *service,
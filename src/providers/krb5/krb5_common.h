@@ -36,6 +36,11 @@
 #define KDCINFO_TMPL PUBCONF_PATH"/kdcinfo.%s"
 #define KPASSWDINFO_TMPL PUBCONF_PATH"/kpasswdinfo.%s"
 
+/* Set by krb5_child to make the locator plugin try the KDC the back end
+ * selected for the request first. */
+#define SSSD_KRB5_LOCATOR_PREFERRED_KDC "SSSD_KRB5_LOCATOR_PREFERRED_KDC"
+#define SSSD_KRB5_LOCATOR_PREFERRED_REALM "SSSD_KRB5_LOCATOR_PREFERRED_REALM"
+
 #define SSS_KRB5KDC_FO_SRV "KERBEROS"
 #define SSS_KRB5KPASSWD_FO_SRV "KPASSWD"
 #define SSS_KRB5_LOOKAHEAD_PRIMARY_DEFAULT 3
@@ -63,6 +68,7 @@ enum krb5_opts {
     KRB5_USE_KDCINFO,
     KRB5_KDCINFO_LOOKAHEAD,
     KRB5_MAP_USER,
+    KRB5_CHILD_POOL_SIZE,
 
     KRB5_OPTS
 };
@@ -144,6 +150,8 @@ struct krb5_ctx {
     const char *fast_principal;
 
     bool canonicalize;
+
+    struct krb5_child_pool *child_pool;
 };
 
 struct remove_info_files_ctx {
@@ -175,6 +183,9 @@ errno_t write_krb5info_file_from_fo_server(struct krb5_service *krb5_service,
                                            const char *service,
                                            bool (*filter)(struct fo_server *));
 
+char *krb5_fo_server_address_port(TALLOC_CTX *mem_ctx,
+                                  struct fo_server *server);
+
 struct krb5_service *krb5_service_new(TALLOC_CTX *mem_ctx,
                                       struct be_ctx *be_ctx,
                                       const char *service_name,
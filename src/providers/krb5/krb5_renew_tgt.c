@@ -31,6 +31,10 @@
 
 #define INITIAL_TGT_TABLE_SIZE 10
 
+/* Maximal number of renewals running at the same time, the remaining due
+ * tickets are renewed when one of them finishes. */
+#define RENEW_TGT_MAX_RUNNING 10
+
 struct renew_tgt_ctx {
     hash_table_t *tgt_table;
     struct be_ctx *be_ctx;
@@ -38,6 +42,12 @@ struct renew_tgt_ctx {
     struct krb5_ctx *krb5_ctx;
     time_t timer_interval;
     struct tevent_timer *te;
+
+    size_t num_running;
+    bool more_due;
+    /* Incremented by each run of the renewal timer, a ticket is tried only
+     * once per run. */
+    unsigned int round;
 };
 
 struct renew_data {
@@ -46,9 +56,11 @@ struct renew_data {
     time_t lifetime;
     time_t start_renew_at;
     struct pam_data *pd;
+    unsigned int round;
 };
 
 struct auth_data {
+    struct renew_tgt_ctx *renew_tgt_ctx;
     struct be_ctx *be_ctx;
     struct krb5_ctx *krb5_ctx;
     struct pam_data *pd;
@@ -58,12 +70,33 @@ struct auth_data {
 };
 
 
+static errno_t renew_all_tgts(struct renew_tgt_ctx *renew_tgt_ctx);
+
+static void renew_tgt_finished(struct renew_tgt_ctx *renew_tgt_ctx)
+{
+    errno_t ret;
+
+    renew_tgt_ctx->num_running--;
+
+    if (!renew_tgt_ctx->more_due || be_is_offline(renew_tgt_ctx->be_ctx)) {
+        return;
+    }
+
+    renew_tgt_ctx->more_due = false;
+    ret = renew_all_tgts(renew_tgt_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to start the next renewals, "
+              "they are started by the renewal timer.\n");
+    }
+}
+
 static void renew_tgt_done(struct tevent_req *req);
 static void renew_tgt(struct tevent_context *ev, struct tevent_timer *te,
                       struct timeval current_time, void *private_data)
 {
     struct auth_data *auth_data = talloc_get_type(private_data,
                                                   struct auth_data);
+    struct renew_tgt_ctx *renew_tgt_ctx = auth_data->renew_tgt_ctx;
     struct tevent_req *req;
 
     req = krb5_auth_queue_send(auth_data, ev, auth_data->be_ctx, auth_data->pd,
@@ -75,6 +108,7 @@ static void renew_tgt(struct tevent_context *ev, struct tevent_timer *te,
         auth_data->renew_data->pd = talloc_steal(auth_data->renew_data,
                                                  auth_data->pd);
         talloc_free(auth_data);
+        renew_tgt_finished(renew_tgt_ctx);
         return;
     }
 
@@ -85,6 +119,7 @@ static void renew_tgt_done(struct tevent_req *req)
 {
     struct auth_data *auth_data = tevent_req_callback_data(req,
                                                            struct auth_data);
+    struct renew_tgt_ctx *renew_tgt_ctx = auth_data->renew_tgt_ctx;
     int ret;
     int pam_status = PAM_SYSTEM_ERR;
     int dp_err;
@@ -151,6 +186,8 @@ static void renew_tgt_done(struct tevent_req *req)
     }
 
     talloc_zfree(auth_data);
+
+    renew_tgt_finished(renew_tgt_ctx);
 }
 
 static errno_t renew_all_tgts(struct renew_tgt_ctx *renew_tgt_ctx)
@@ -179,7 +216,14 @@ static errno_t renew_all_tgts(struct renew_tgt_ctx *renew_tgt_ctx)
                   ctime(&renew_data->start_renew_at));
         /* If renew_data->pd == NULL a renewal request for this data is
          * currently running so we skip it. */
-        if (renew_data->start_renew_at < now && renew_data->pd != NULL) {
+        if (renew_data->start_renew_at < now && renew_data->pd != NULL
+                && renew_data->round != renew_tgt_ctx->round) {
+            if (renew_tgt_ctx->num_running >= RENEW_TGT_MAX_RUNNING) {
+                renew_tgt_ctx->more_due = true;
+                continue;
+            }
+
+            te = NULL;
             auth_data = talloc_zero(renew_tgt_ctx, struct auth_data);
             if (auth_data == NULL) {
                 DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero failed.\n");
@@ -194,6 +238,7 @@ static errno_t renew_all_tgts(struct renew_tgt_ctx *renew_tgt_ctx)
  * might want to steal the pam_data back to renew_data before freeing
  * auth_data to allow a new renewal attempt. */
                 auth_data->pd = talloc_move(auth_data, &renew_data->pd);
+                auth_data->renew_tgt_ctx = renew_tgt_ctx;
                 auth_data->krb5_ctx = renew_tgt_ctx->krb5_ctx;
                 auth_data->be_ctx = renew_tgt_ctx->be_ctx;
                 auth_data->table = renew_tgt_ctx->tgt_table;
@@ -210,6 +255,9 @@ static errno_t renew_all_tgts(struct renew_tgt_ctx *renew_tgt_ctx)
                     if (te == NULL) {
                         DEBUG(SSSDBG_CRIT_FAILURE,
                               "tevent_add_timer failed.\n");
+                    } else {
+                        renew_data->round = renew_tgt_ctx->round;
+                        renew_tgt_ctx->num_running++;
                     }
                 }
             }
@@ -271,6 +319,9 @@ static void renew_handler(struct renew_tgt_ctx *renew_tgt_ctx)
         return;
     }
 
+    renew_tgt_ctx->round++;
+    renew_tgt_ctx->more_due = false;
+
     ret = renew_all_tgts(renew_tgt_ctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "renew_all_tgts failed. "
@@ -549,6 +600,7 @@ errno_t add_tgt_to_renew_table(struct krb5_ctx *krb5_ctx, const char *ccfile,
     hash_key_t key;
     hash_value_t value;
     struct renew_data *renew_data = NULL;
+    time_t jitter;
 
     if (krb5_ctx->renew_tgt_ctx == NULL) {
         DEBUG(SSSDBG_TRACE_LIBS ,"Renew context not initialized, "
@@ -592,8 +644,16 @@ errno_t add_tgt_to_renew_table(struct krb5_ctx *krb5_ctx, const char *ccfile,
 
     renew_data->start_time = tgtt->starttime;
     renew_data->lifetime = tgtt->endtime;
+    /* Renew somewhere between the half and three quarters of the lifetime,
+     * so that the tickets of users who logged in at the same time are not
+     * all renewed at once. */
+    jitter = (tgtt->endtime - tgtt->starttime) / 4;
     renew_data->start_renew_at = (time_t) (tgtt->starttime +
                                         0.5 *(tgtt->endtime - tgtt->starttime));
+    if (jitter > 0) {
+        renew_data->start_renew_at += sss_rand() % (jitter + 1);
+    }
+    renew_data->round = krb5_ctx->renew_tgt_ctx->round;
 
     ret = copy_pam_data(renew_data, pd, &renew_data->pd);
     if (ret != EOK) {
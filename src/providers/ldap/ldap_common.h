@@ -283,6 +283,14 @@ errno_t ldap_id_setup_cleanup(struct sdap_id_ctx *id_ctx,
 errno_t ldap_id_cleanup(struct sdap_id_ctx *id_ctx,
                         struct sdap_domain *sdom);
 
+/* Same as ldap_id_cleanup() but yields to the event loop between chunks of
+ * removed entries. */
+struct tevent_req *ldap_id_cleanup_send(TALLOC_CTX *mem_ctx,
+                                        struct tevent_context *ev,
+                                        struct sdap_id_ctx *id_ctx,
+                                        struct sdap_domain *sdom);
+errno_t ldap_id_cleanup_recv(struct tevent_req *req);
+
 struct tevent_req *groups_get_send(TALLOC_CTX *memctx,
                                    struct tevent_context *ev,
                                    struct sdap_id_ctx *ctx,
@@ -294,6 +302,17 @@ struct tevent_req *groups_get_send(TALLOC_CTX *memctx,
                                    bool no_members);
 int groups_get_recv(struct tevent_req *req, int *dp_error_out, int *sdap_ret);
 
+struct tevent_req *groups_by_sids_get_send(TALLOC_CTX *memctx,
+                                           struct tevent_context *ev,
+                                           struct sdap_id_ctx *ctx,
+                                           struct sdap_domain *sdom,
+                                           struct sdap_id_conn_ctx *conn,
+                                           const char **sids,
+                                           size_t num_sids,
+                                           bool no_members);
+int groups_by_sids_get_recv(struct tevent_req *req,
+                            int *dp_error_out, int *sdap_ret);
+
 struct tevent_req *ldap_netgroup_get_send(TALLOC_CTX *memctx,
                                           struct tevent_context *ev,
                                           struct sdap_id_ctx *ctx,
@@ -394,6 +413,10 @@ struct sdap_domain *sdap_domain_get(struct sdap_options *opts,
 struct sdap_domain *sdap_domain_get_by_dn(struct sdap_options *opts,
                                           const char *dn);
 
+/* Returns the private data of the domain, running its pvt_init callback
+ * first if the data was not created yet. */
+void *sdap_domain_get_pvt(struct sdap_domain *sdom);
+
 errno_t sdap_parse_search_base(TALLOC_CTX *mem_ctx,
                                struct dp_option *opts, int class,
                                struct sdap_search_base ***_search_bases);
@@ -649,6 +649,8 @@ struct groups_get_state {
     int sdap_ret;
     bool noexist_delete;
     bool no_members;
+    /* Several SIDs are looked up at once */
+    bool batch;
 };
 
 static int groups_get_retry(struct tevent_req *req);
@@ -977,6 +979,7 @@ static void groups_get_done(struct tevent_req *subreq)
     }
 
     if (ret == ENOENT
+            && !state->batch
             && sss_domain_is_mpg(state->domain) == true
             && !state->conn->no_mpg_user_fallback) {
         /* The requested filter did not find a group. Before giving up, we must
@@ -1124,6 +1127,132 @@ int groups_get_recv(struct tevent_req *req, int *dp_error_out, int *sdap_ret)
     return EOK;
 }
 
+/* Looks up the groups of a list of SIDs with a single search, the caller is
+ * responsible for looking up SIDs that were not found one by one if it
+ * wants the user private group fallback of groups_get_send(). */
+struct tevent_req *groups_by_sids_get_send(TALLOC_CTX *memctx,
+                                           struct tevent_context *ev,
+                                           struct sdap_id_ctx *ctx,
+                                           struct sdap_domain *sdom,
+                                           struct sdap_id_conn_ctx *conn,
+                                           const char **sids,
+                                           size_t num_sids,
+                                           bool no_members)
+{
+    struct tevent_req *req;
+    struct groups_get_state *state;
+    const char *attr_name;
+    const char *member_filter[2];
+    char *sid_filter;
+    char *clean_value;
+    char *oc_list;
+    size_t i;
+    int ret;
+
+    req = tevent_req_create(memctx, &state, struct groups_get_state);
+    if (!req) return NULL;
+
+    state->ev = ev;
+    state->ctx = ctx;
+    state->sdom = sdom;
+    state->conn = conn;
+    state->dp_error = DP_ERR_FATAL;
+    state->noexist_delete = false;
+    state->no_members = no_members;
+    state->batch = true;
+
+    state->op = sdap_id_op_create(state, state->conn->conn_cache);
+    if (!state->op) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_create failed\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->domain = sdom->dom;
+    state->sysdb = sdom->dom->sysdb;
+    state->filter_type = BE_FILTER_SECID;
+
+    if (num_sids == 0) {
+        ret = EINVAL;
+        goto done;
+    }
+    state->filter_value = sids[0];
+
+    attr_name = ctx->opts->group_map[SDAP_AT_GROUP_OBJECTSID].name;
+    if (attr_name == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Missing search attribute name.\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    sid_filter = talloc_strdup(state, "");
+    if (sid_filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num_sids; i++) {
+        ret = sss_filter_sanitize(state, sids[i], &clean_value);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        sid_filter = talloc_asprintf_append_buffer(sid_filter, "(%s=%s)",
+                                                   attr_name, clean_value);
+        talloc_free(clean_value);
+        if (sid_filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    oc_list = sdap_make_oc_list(state, ctx->opts->group_map);
+    if (oc_list == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to create objectClass list.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->filter = talloc_asprintf(state, "(&(|%s)(%s)(%s=*))",
+                                    sid_filter, oc_list,
+                                    ctx->opts->group_map[SDAP_AT_GROUP_NAME].name);
+    talloc_free(sid_filter);
+    if (!state->filter) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to build filter\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    member_filter[0] = (const char *)ctx->opts->group_map[SDAP_AT_GROUP_MEMBER].name;
+    member_filter[1] = NULL;
+
+    ret = build_attrs_from_map(state, ctx->opts->group_map, SDAP_OPTS_GROUP,
+                               (state->domain->ignore_group_members
+                                    || state->no_members) ?
+                                   (const char **)member_filter : NULL,
+                               &state->attrs, NULL);
+    if (ret != EOK) goto done;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Looking up %zu SIDs in domain %s\n",
+          num_sids, state->domain->name);
+
+    ret = groups_get_retry(req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    return req;
+
+done:
+    tevent_req_error(req, ret);
+    return tevent_req_post(req, ev);
+}
+
+int groups_by_sids_get_recv(struct tevent_req *req,
+                            int *dp_error_out, int *sdap_ret)
+{
+    return groups_get_recv(req, dp_error_out, sdap_ret);
+}
 
 /* =Get-Groups-for-User================================================== */
 
@@ -28,6 +28,7 @@
 
 #include "util/util.h"
 #include "util/find_uid.h"
+#include "util/sss_budget.h"
 #include "db/sysdb.h"
 #include "providers/ldap/ldap_common.h"
 #include "providers/ldap/sdap_async.h"
@@ -38,16 +39,23 @@ struct ldap_id_cleanup_ctx {
     struct sdap_domain *sdom;
 };
 
-static errno_t ldap_cleanup_task(TALLOC_CTX *mem_ctx,
-                                 struct tevent_context *ev,
-                                 struct be_ctx *be_ctx,
-                                 struct be_ptask *be_ptask,
-                                 void *pvt)
+static struct tevent_req *
+ldap_cleanup_task_send(TALLOC_CTX *mem_ctx,
+                       struct tevent_context *ev,
+                       struct be_ctx *be_ctx,
+                       struct be_ptask *be_ptask,
+                       void *pvt)
 {
     struct ldap_id_cleanup_ctx *cleanup_ctx = NULL;
 
     cleanup_ctx = talloc_get_type(pvt, struct ldap_id_cleanup_ctx);
-    return ldap_id_cleanup(cleanup_ctx->ctx, cleanup_ctx->sdom);
+    return ldap_id_cleanup_send(mem_ctx, ev, cleanup_ctx->ctx,
+                                cleanup_ctx->sdom);
+}
+
+static errno_t ldap_cleanup_task_recv(struct tevent_req *req)
+{
+    return ldap_id_cleanup_recv(req);
 }
 
 errno_t ldap_id_setup_cleanup(struct sdap_id_ctx *id_ctx,
@@ -85,12 +93,13 @@ errno_t ldap_id_setup_cleanup(struct sdap_id_ctx *id_ctx,
         return ENOMEM;
     }
 
-    ret = be_ptask_create_sync(id_ctx, id_ctx->be, period, first_delay,
-                               5 /* enabled delay */, 0 /* random offset */,
-                               period /* timeout */, 0,
-                               ldap_cleanup_task, cleanup_ctx, name,
-                               BE_PTASK_OFFLINE_SKIP,
-                               &id_ctx->task);
+    ret = be_ptask_create(id_ctx, id_ctx->be, period, first_delay,
+                          5 /* enabled delay */, 0 /* random offset */,
+                          period /* timeout */, 0,
+                          ldap_cleanup_task_send, ldap_cleanup_task_recv,
+                          cleanup_ctx, name,
+                          BE_PTASK_OFFLINE_SKIP,
+                          &id_ctx->task);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "Unable to initialize cleanup periodic "
                                      "task for %s\n", sdom->dom->name);
@@ -108,61 +117,376 @@ done:
     return ret;
 }
 
-static int cleanup_users(struct sdap_options *opts,
-                         struct sss_domain_info *dom);
-static int cleanup_groups(TALLOC_CTX *memctx,
-                          struct sysdb_ctx *sysdb,
-                          struct sss_domain_info *domain);
+/* ==Cleanup-Run========================================================== */
 
-errno_t ldap_id_cleanup(struct sdap_id_ctx *ctx,
-                        struct sdap_domain *sdom)
+/* Number of entries removed in one transaction, the backend serves other
+ * requests once the chunks used up their time budget. */
+#define LDAP_ID_CLEANUP_CHUNK 100
+
+enum ldap_id_cleanup_phase {
+    LDAP_ID_CLEANUP_USERS,
+    LDAP_ID_CLEANUP_GROUPS,
+    LDAP_ID_CLEANUP_DONE,
+};
+
+struct ldap_id_cleanup_run {
+    struct sdap_id_ctx *ctx;
+    struct sss_domain_info *dom;
+    time_t now;
+    hash_table_t *uid_table;
+
+    enum ldap_id_cleanup_phase phase;
+    struct ldb_message **msgs;
+    size_t count;
+    size_t next;
+};
+
+static errno_t find_expired_users(TALLOC_CTX *mem_ctx,
+                                  struct sdap_options *opts,
+                                  struct sss_domain_info *dom,
+                                  time_t now,
+                                  struct ldb_message ***_msgs,
+                                  size_t *_count);
+static errno_t cleanup_user(struct ldap_id_cleanup_run *run,
+                            struct ldb_message *msg);
+static errno_t find_expired_groups(TALLOC_CTX *mem_ctx,
+                                   struct sss_domain_info *domain,
+                                   time_t now,
+                                   struct ldb_message ***_msgs,
+                                   size_t *_count);
+static errno_t cleanup_group(struct ldap_id_cleanup_run *run,
+                             struct ldb_message *msg);
+
+static errno_t ldap_id_cleanup_run_init(TALLOC_CTX *mem_ctx,
+                                        struct sdap_id_ctx *ctx,
+                                        struct sdap_domain *sdom,
+                                        struct ldap_id_cleanup_run **_run)
 {
-    int ret, tret;
-    bool in_transaction = false;
-    TALLOC_CTX *tmp_ctx;
+    struct ldap_id_cleanup_run *run;
+    errno_t ret;
 
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
+    run = talloc_zero(mem_ctx, struct ldap_id_cleanup_run);
+    if (run == NULL) {
         return ENOMEM;
     }
 
-    ret = sysdb_transaction_start(sdom->dom->sysdb);
+    run->ctx = ctx;
+    run->dom = sdom->dom;
+    run->now = time(NULL);
+    run->phase = LDAP_ID_CLEANUP_USERS;
+
+    ret = find_expired_users(run, ctx->opts, run->dom, run->now,
+                             &run->msgs, &run->count);
     if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
         goto done;
     }
-    in_transaction = true;
 
-    ret = cleanup_users(ctx->opts, sdom->dom);
-    if (ret && ret != ENOENT) {
-        goto done;
+    if (run->count > 0) {
+        ret = get_uid_table(run, &run->uid_table);
+        /* get_uid_table returns ENOSYS on non-Linux platforms. We proceed
+         * with the cleanup in that case
+         */
+        if (ret != EOK && ret != ENOSYS) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "get_uid_table failed: %d\n", ret);
+            goto done;
+        }
     }
 
-    ret = cleanup_groups(tmp_ctx, sdom->dom->sysdb, sdom->dom);
-    if (ret) {
+    run->dom->cleanup_processed = 0;
+    run->dom->cleanup_total = run->count;
+
+    ret = EOK;
+
+done:
+    if (ret == EOK) {
+        *_run = run;
+    } else {
+        talloc_free(run);
+    }
+
+    return ret;
+}
+
+static errno_t ldap_id_cleanup_next_phase(struct ldap_id_cleanup_run *run)
+{
+    errno_t ret;
+
+    talloc_zfree(run->msgs);
+    run->count = 0;
+    run->next = 0;
+
+    switch (run->phase) {
+    case LDAP_ID_CLEANUP_USERS:
+        run->phase = LDAP_ID_CLEANUP_GROUPS;
+
+        ret = find_expired_groups(run, run->dom, run->now,
+                                  &run->msgs, &run->count);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        run->dom->cleanup_total += run->count;
+        break;
+    case LDAP_ID_CLEANUP_GROUPS:
+    case LDAP_ID_CLEANUP_DONE:
+        run->phase = LDAP_ID_CLEANUP_DONE;
+        run->ctx->last_purge = tevent_timeval_current();
+        break;
+    }
+
+    return EOK;
+}
+
+/* Removes the next chunk of expired entries and sets _done once there is
+ * nothing left. */
+static errno_t ldap_id_cleanup_run_step(struct ldap_id_cleanup_run *run,
+                                        bool *_done)
+{
+    struct sysdb_ctx *sysdb = run->dom->sysdb;
+    bool in_transaction = false;
+    size_t end;
+    size_t i;
+    errno_t ret, tret;
+
+    while (run->phase != LDAP_ID_CLEANUP_DONE && run->next == run->count) {
+        ret = ldap_id_cleanup_next_phase(run);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    if (run->phase == LDAP_ID_CLEANUP_DONE) {
+        *_done = true;
+        return EOK;
+    }
+
+    end = MIN(run->count, run->next + LDAP_ID_CLEANUP_CHUNK);
+
+    ret = sysdb_transaction_start(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
         goto done;
     }
+    in_transaction = true;
 
-    ret = sysdb_transaction_commit(sdom->dom->sysdb);
+    for (i = run->next; i < end; i++) {
+        if (run->phase == LDAP_ID_CLEANUP_USERS) {
+            ret = cleanup_user(run, run->msgs[i]);
+        } else {
+            ret = cleanup_group(run, run->msgs[i]);
+        }
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = sysdb_transaction_commit(sysdb);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
         goto done;
     }
     in_transaction = false;
 
-    ctx->last_purge = tevent_timeval_current();
+    run->dom->cleanup_processed += end - run->next;
+    run->next = end;
+
+    *_done = false;
     ret = EOK;
+
 done:
     if (in_transaction) {
-        tret = sysdb_transaction_cancel(sdom->dom->sysdb);
+        tret = sysdb_transaction_cancel(sysdb);
         if (tret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
         }
     }
-    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+errno_t ldap_id_cleanup(struct sdap_id_ctx *ctx,
+                        struct sdap_domain *sdom)
+{
+    struct ldap_id_cleanup_run *run;
+    bool done = false;
+    errno_t ret;
+
+    ret = ldap_id_cleanup_run_init(NULL, ctx, sdom, &run);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    while (!done) {
+        ret = ldap_id_cleanup_run_step(run, &done);
+        if (ret != EOK) {
+            break;
+        }
+    }
+
+    talloc_free(run);
     return ret;
 }
 
+struct ldap_id_cleanup_state {
+    struct tevent_context *ev;
+    struct tevent_immediate *imm;
+    struct sss_budget *budget;
+    struct ldap_id_cleanup_run *run;
+};
+
+static void ldap_id_cleanup_start(struct tevent_context *ev,
+                                  struct tevent_immediate *imm,
+                                  void *pvt);
+static void ldap_id_cleanup_step(struct tevent_req *req);
+static void ldap_id_cleanup_resume(struct tevent_req *subreq);
+
+struct tevent_req *ldap_id_cleanup_send(TALLOC_CTX *mem_ctx,
+                                        struct tevent_context *ev,
+                                        struct sdap_id_ctx *ctx,
+                                        struct sdap_domain *sdom)
+{
+    struct ldap_id_cleanup_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct ldap_id_cleanup_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+
+    state->imm = tevent_create_immediate(state);
+    if (state->imm == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    ret = ldap_id_cleanup_run_init(state, ctx, sdom, &state->run);
+    if (ret != EOK) {
+        goto immediately;
+    }
+
+    tevent_schedule_immediate(state->imm, ev, ldap_id_cleanup_start, req);
+
+    return req;
+
+immediately:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void ldap_id_cleanup_start(struct tevent_context *ev,
+                                  struct tevent_immediate *imm,
+                                  void *pvt)
+{
+    struct ldap_id_cleanup_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct ldap_id_cleanup_state);
+
+    state->budget = sss_budget_create(state, "LDAP cleanup",
+                                      SSS_BUDGET_DEFAULT_MSEC);
+    if (state->budget == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+
+    ldap_id_cleanup_step(req);
+}
+
+static void ldap_id_cleanup_step(struct tevent_req *req)
+{
+    struct ldap_id_cleanup_state *state;
+    struct tevent_req *subreq;
+    bool done;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct ldap_id_cleanup_state);
+
+    do {
+        ret = ldap_id_cleanup_run_step(state->run, &done);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+    } while (!done && !sss_budget_exhausted(state->budget));
+
+    if (done) {
+        DEBUG(SSSDBG_FUNC_DATA, "Cleanup of %s checked %u entries\n",
+              state->run->dom->name, state->run->dom->cleanup_processed);
+        tevent_req_done(req);
+        return;
+    }
+
+    /* Let other requests in before the next chunk */
+    subreq = sss_budget_yield_send(state, state->ev, state->budget);
+    if (subreq == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+    tevent_req_set_callback(subreq, ldap_id_cleanup_resume, req);
+}
+
+static void ldap_id_cleanup_resume(struct tevent_req *subreq)
+{
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+
+    ret = sss_budget_yield_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ldap_id_cleanup_step(req);
+}
+
+errno_t ldap_id_cleanup_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+/* Entries can be refreshed while the cleanup yields to other requests. */
+static bool cleanup_still_expired(struct sss_domain_info *dom,
+                                  struct ldb_message *msg,
+                                  bool is_user,
+                                  time_t now)
+{
+    const char *attrs[] = { SYSDB_CACHE_EXPIRE, NULL };
+    struct ldb_message *cur;
+    const char *name;
+    uint64_t expire;
+    errno_t ret;
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        /* Reported by the caller */
+        return true;
+    }
+
+    if (is_user) {
+        ret = sysdb_search_user_by_name(NULL, dom, name, attrs, &cur);
+    } else {
+        ret = sysdb_search_group_by_name(NULL, dom, name, attrs, &cur);
+    }
+    if (ret != EOK) {
+        /* Removed meanwhile or checked again by the next cleanup */
+        return false;
+    }
+
+    expire = ldb_msg_find_attr_as_uint64(cur, SYSDB_CACHE_EXPIRE, 0);
+    talloc_free(cur);
+
+    return expire != 0 && expire <= now;
+}
 
 /* ==User-Cleanup-Process================================================= */
 
@@ -172,21 +496,21 @@ static int cleanup_users_logged_in(hash_table_t *table,
 static errno_t expire_memberof_target_groups(struct sss_domain_info *dom,
                                              struct ldb_message *user);
 
-static int cleanup_users(struct sdap_options *opts,
-                         struct sss_domain_info *dom)
+static errno_t find_expired_users(TALLOC_CTX *mem_ctx,
+                                  struct sdap_options *opts,
+                                  struct sss_domain_info *dom,
+                                  time_t now,
+                                  struct ldb_message ***_msgs,
+                                  size_t *_count)
 {
     TALLOC_CTX *tmpctx;
     const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM, SYSDB_MEMBEROF, NULL };
-    time_t now = time(NULL);
     char *subfilter = NULL;
     char *ts_subfilter = NULL;
     int account_cache_expiration;
-    hash_table_t *uid_table;
-    struct ldb_message **msgs;
+    struct ldb_message **msgs = NULL;
     size_t count;
-    const char *name;
     int ret;
-    int i;
 
     tmpctx = talloc_new(NULL);
     if (!tmpctx) {
@@ -242,68 +566,70 @@ static int cleanup_users(struct sdap_options *opts,
     }
     DEBUG(SSSDBG_FUNC_DATA, "Found %zu expired user entries!\n", count);
 
-    if (count == 0) {
-        ret = EOK;
-        goto done;
+    *_msgs = talloc_steal(mem_ctx, msgs);
+    *_count = count;
+    ret = EOK;
+
+done:
+    talloc_zfree(tmpctx);
+    return ret;
+}
+
+static errno_t cleanup_user(struct ldap_id_cleanup_run *run,
+                            struct ldb_message *msg)
+{
+    const char *name;
+    int ret;
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (!name) {
+        DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n",
+                   ldb_dn_get_linearized(msg->dn));
+        return EFAULT;
     }
+    DEBUG(SSSDBG_TRACE_ALL, "Processing user %s\n", name);
 
-    ret = get_uid_table(tmpctx, &uid_table);
-    /* get_uid_table returns ENOSYS on non-Linux platforms. We proceed with
-     * the cleanup in that case
-     */
-    if (ret != EOK && ret != ENOSYS) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "get_uid_table failed: %d\n", ret);
-        goto done;
+    if (!cleanup_still_expired(run->dom, msg, true, run->now)) {
+        DEBUG(SSSDBG_TRACE_ALL, "User %s was refreshed, keeping data\n",
+              name);
+        return EOK;
     }
 
-    for (i = 0; i < count; i++) {
-        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
-        if (!name) {
-            DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n",
-                       ldb_dn_get_linearized(msgs[i]->dn));
-            ret = EFAULT;
-            goto done;
-        }
-        DEBUG(SSSDBG_TRACE_ALL, "Processing user %s\n", name);
-
-        if (uid_table) {
-            ret = cleanup_users_logged_in(uid_table, msgs[i]);
-            if (ret == EOK) {
-                /* If the user is logged in, proceed to the next one */
-                DEBUG(SSSDBG_FUNC_DATA,
-                      "User %s is still logged in or a dummy entry, "
-                          "keeping data\n", name);
-                continue;
-            } else if (ret != ENOENT) {
-                DEBUG(SSSDBG_CRIT_FAILURE,
-                      "Cannot check if user is logged in: %d\n", ret);
-                goto done;
-            }
+    if (run->uid_table) {
+        ret = cleanup_users_logged_in(run->uid_table, msg);
+        if (ret == EOK) {
+            /* If the user is logged in, proceed to the next one */
+            DEBUG(SSSDBG_FUNC_DATA,
+                  "User %s is still logged in or a dummy entry, "
+                      "keeping data\n", name);
+            return EOK;
+        } else if (ret != ENOENT) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot check if user is logged in: %d\n", ret);
+            return ret;
         }
+    }
 
-        /* If not logged in or cannot check the table, delete him */
-        DEBUG(SSSDBG_TRACE_ALL, "About to delete user %s\n", name);
-        ret = sysdb_delete_user(dom, name, 0);
-        if (ret) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_delete_user failed: %d\n", ret);
-            goto done;
-        }
+    /* If not logged in or cannot check the table, delete him */
+    DEBUG(SSSDBG_TRACE_ALL, "About to delete user %s\n", name);
+    ret = sysdb_delete_user(run->dom, name, 0);
+    if (ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_delete_user failed: %d\n", ret);
+        return ret;
+    }
 
-        /* Mark all groups of which user was a member as expired in cache,
-         * so that its ghost/member attributes are refreshed on next
-         * request. */
-        ret = expire_memberof_target_groups(dom, msgs[i]);
-        if (ret != EOK && ret != ENOENT) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "expire_memberof_target_groups failed: [%d]:%s\n",
-                  ret, sss_strerror(ret));
-            goto done;
-        }
+    /* Mark all groups of which user was a member as expired in cache,
+     * so that its ghost/member attributes are refreshed on next
+     * request. */
+    ret = expire_memberof_target_groups(run->dom, msg);
+    if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "expire_memberof_target_groups failed: [%d]:%s\n",
+              ret, sss_strerror(ret));
+        return ret;
     }
 
-done:
-    talloc_zfree(tmpctx);
-    return ret;
+    return EOK;
 }
 
 static errno_t expire_memberof_target_groups(struct sss_domain_info *dom,
@@ -375,27 +701,21 @@ static int cleanup_users_logged_in(hash_table_t *table,
 
 /* ==Group-Cleanup-Process================================================ */
 
-static int cleanup_groups(TALLOC_CTX *memctx,
-                          struct sysdb_ctx *sysdb,
-                          struct sss_domain_info *domain)
+static errno_t find_expired_groups(TALLOC_CTX *mem_ctx,
+                                   struct sss_domain_info *domain,
+                                   time_t now,
+                                   struct ldb_message ***_msgs,
+                                   size_t *_count)
 {
     TALLOC_CTX *tmpctx;
     const char *attrs[] = { SYSDB_NAME, SYSDB_GIDNUM, NULL };
-    time_t now = time(NULL);
     char *subfilter;
     char *ts_subfilter;
-    const char *dn;
-    gid_t gid;
-    struct ldb_message **msgs;
+    struct ldb_message **msgs = NULL;
     size_t count;
-    struct ldb_message **u_msgs;
-    size_t u_count;
     int ret;
-    int i;
-    const char *posix;
-    struct ldb_dn *base_dn;
 
-    tmpctx = talloc_new(memctx);
+    tmpctx = talloc_new(NULL);
     if (!tmpctx) {
         return ENOMEM;
     }
@@ -427,92 +747,118 @@ static int cleanup_groups(TALLOC_CTX *memctx,
 
     DEBUG(SSSDBG_FUNC_DATA, "Found %zu expired group entries!\n", count);
 
-    if (count == 0) {
-        ret = EOK;
+    *_msgs = talloc_steal(mem_ctx, msgs);
+    *_count = count;
+    ret = EOK;
+
+done:
+    talloc_zfree(tmpctx);
+    return ret;
+}
+
+static errno_t cleanup_group(struct ldap_id_cleanup_run *run,
+                             struct ldb_message *msg)
+{
+    TALLOC_CTX *tmpctx;
+    struct sysdb_ctx *sysdb = run->dom->sysdb;
+    char *subfilter;
+    char *sanitized_dn;
+    const char *dn;
+    const char *name;
+    gid_t gid;
+    struct ldb_message **u_msgs;
+    size_t u_count;
+    int ret;
+    const char *posix;
+    struct ldb_dn *base_dn;
+
+    tmpctx = talloc_new(NULL);
+    if (!tmpctx) {
+        return ENOMEM;
+    }
+
+    dn = ldb_dn_get_linearized(msg->dn);
+    if (!dn) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot linearize DN!\n");
+        ret = EFAULT;
         goto done;
     }
 
-    for (i = 0; i < count; i++) {
-        char *sanitized_dn;
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (!name) {
+        DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n", dn);
+        ret = EFAULT;
+        goto done;
+    }
 
-        dn = ldb_dn_get_linearized(msgs[i]->dn);
-        if (!dn) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Cannot linearize DN!\n");
-            ret = EFAULT;
-            goto done;
-        }
+    if (!cleanup_still_expired(run->dom, msg, false, run->now)) {
+        DEBUG(SSSDBG_TRACE_ALL, "Group %s was refreshed, keeping data\n",
+              name);
+        ret = EOK;
+        goto done;
+    }
 
-        /* sanitize dn */
-        ret = sss_filter_sanitize(tmpctx, dn, &sanitized_dn);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "sss_filter_sanitize failed: %s:[%d]\n",
-                  sss_strerror(ret), ret);
-            goto done;
-        }
+    /* sanitize dn */
+    ret = sss_filter_sanitize(tmpctx, dn, &sanitized_dn);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "sss_filter_sanitize failed: %s:[%d]\n",
+              sss_strerror(ret), ret);
+        goto done;
+    }
 
-        posix = ldb_msg_find_attr_as_string(msgs[i], SYSDB_POSIX, NULL);
-        if (!posix || strcmp(posix, "TRUE") == 0) {
-            /* Search for users that are members of this group, or
-             * that have this group as their primary GID.
-             * Include subdomain users as well.
-             */
-            gid = (gid_t) ldb_msg_find_attr_as_uint(msgs[i], SYSDB_GIDNUM, 0);
-            subfilter = talloc_asprintf(tmpctx, "(&(%s=%s)(|(%s=%s)(%s=%lu)))",
-                                        SYSDB_OBJECTCATEGORY, SYSDB_USER_CLASS,
-                                        SYSDB_MEMBEROF, sanitized_dn,
-                                        SYSDB_GIDNUM, (long unsigned) gid);
-        } else {
-            subfilter = talloc_asprintf(tmpctx, "(%s=%s)", SYSDB_MEMBEROF,
-                                        sanitized_dn);
-        }
-        talloc_zfree(sanitized_dn);
+    posix = ldb_msg_find_attr_as_string(msg, SYSDB_POSIX, NULL);
+    if (!posix || strcmp(posix, "TRUE") == 0) {
+        /* Search for users that are members of this group, or
+         * that have this group as their primary GID.
+         * Include subdomain users as well.
+         */
+        gid = (gid_t) ldb_msg_find_attr_as_uint(msg, SYSDB_GIDNUM, 0);
+        subfilter = talloc_asprintf(tmpctx, "(&(%s=%s)(|(%s=%s)(%s=%lu)))",
+                                    SYSDB_OBJECTCATEGORY, SYSDB_USER_CLASS,
+                                    SYSDB_MEMBEROF, sanitized_dn,
+                                    SYSDB_GIDNUM, (long unsigned) gid);
+    } else {
+        subfilter = talloc_asprintf(tmpctx, "(%s=%s)", SYSDB_MEMBEROF,
+                                    sanitized_dn);
+    }
+    talloc_zfree(sanitized_dn);
 
-        if (!subfilter) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to build filter\n");
-            ret = ENOMEM;
-            goto done;
-        }
+    if (!subfilter) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to build filter\n");
+        ret = ENOMEM;
+        goto done;
+    }
 
-        base_dn = sysdb_base_dn(sysdb, tmpctx);
-        if (base_dn == NULL) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to build base dn\n");
-            ret = ENOMEM;
-            goto done;
-        }
+    base_dn = sysdb_base_dn(sysdb, tmpctx);
+    if (base_dn == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to build base dn\n");
+        ret = ENOMEM;
+        goto done;
+    }
 
-        DEBUG(SSSDBG_TRACE_LIBS, "Searching with: %s\n", subfilter);
-
-        ret = sysdb_search_entry(tmpctx, sysdb, base_dn,
-                                 LDB_SCOPE_SUBTREE, subfilter, NULL,
-                                 &u_count, &u_msgs);
-        if (ret == ENOENT) {
-            const char *name;
-
-            name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
-            if (!name) {
-                DEBUG(SSSDBG_OP_FAILURE, "Entry %s has no Name Attribute ?!?\n",
-                          ldb_dn_get_linearized(msgs[i]->dn));
-                ret = EFAULT;
-                goto done;
-            }
-
-            DEBUG(SSSDBG_TRACE_INTERNAL, "About to delete group %s\n", name);
-            ret = sysdb_delete_group(domain, name, 0);
-            if (ret) {
-                DEBUG(SSSDBG_OP_FAILURE, "Group delete returned %d (%s)\n",
-                          ret, strerror(ret));
-                goto done;
-            }
-        } else if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Failed to search sysdb using %s: [%d] %s\n",
-                  subfilter, ret, sss_strerror(ret));
+    DEBUG(SSSDBG_TRACE_LIBS, "Searching with: %s\n", subfilter);
+
+    ret = sysdb_search_entry(tmpctx, sysdb, base_dn,
+                             LDB_SCOPE_SUBTREE, subfilter, NULL,
+                             &u_count, &u_msgs);
+    if (ret == ENOENT) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "About to delete group %s\n", name);
+        ret = sysdb_delete_group(run->dom, name, 0);
+        if (ret) {
+            DEBUG(SSSDBG_OP_FAILURE, "Group delete returned %d (%s)\n",
+                      ret, strerror(ret));
             goto done;
         }
-        talloc_zfree(u_msgs);
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Failed to search sysdb using %s: [%d] %s\n",
+              subfilter, ret, sss_strerror(ret));
+        goto done;
     }
 
+    ret = EOK;
+
 done:
     talloc_zfree(tmpctx);
     return ret;
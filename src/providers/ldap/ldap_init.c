@@ -604,6 +604,7 @@ errno_t sssm_ldap_access_init(TALLOC_CTX *mem_ctx,
 {
     struct ldap_init_ctx *init_ctx;
     struct sdap_access_ctx *access_ctx;
+    size_t c;
     errno_t ret;
 
     init_ctx = talloc_get_type(module_data, struct ldap_init_ctx);
@@ -624,6 +625,15 @@ errno_t sssm_ldap_access_init(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* Lockout and password policy must be checked on every login. */
+    for (c = 0; access_ctx->access_rule[c] != LDAP_ACCESS_EMPTY; c++) {
+        if (access_ctx->access_rule[c] == LDAP_ACCESS_LOCKOUT
+                || access_ctx->access_rule[c] == LDAP_ACCESS_PPOLICY) {
+            dp_access_cache_bypass(be_ctx->provider);
+            break;
+        }
+    }
+
     dp_set_method(dp_methods, DPM_ACCESS_HANDLER,
                   sdap_pam_access_handler_send, sdap_pam_access_handler_recv, access_ctx,
                   struct sdap_access_ctx, struct pam_data, struct pam_data *);
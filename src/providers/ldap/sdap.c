@@ -19,6 +19,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <ctype.h>
+
 #include "util/util.h"
 #include "util/crypto/sss_crypto.h"
 #include "confdb/confdb.h"
@@ -387,6 +389,158 @@ int sdap_get_map(TALLOC_CTX *memctx,
 
 /* =Parse-msg============================================================= */
 
+/* Case insensitive lookup table of the LDAP attribute names of a map, so
+ * that every attribute of an entry is matched in constant time instead of
+ * scanning the whole map. Entries that share an LDAP name are chained. */
+struct sdap_attr_map_index {
+    struct sdap_attr_map *map;
+    int attrs_num;
+
+    unsigned int mask;
+    int *slots;
+    int *next;
+};
+
+static unsigned int sdap_attr_map_index_hash(const char *name)
+{
+    unsigned int hash = 2166136261U;
+
+    for (; *name != '\0'; name++) {
+        hash ^= (unsigned char)tolower((unsigned char)*name);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+errno_t sdap_attr_map_index_create(TALLOC_CTX *mem_ctx,
+                                   struct sdap_attr_map *map,
+                                   int attrs_num,
+                                   struct sdap_attr_map_index **_index)
+{
+    struct sdap_attr_map_index *index;
+    unsigned int size;
+    unsigned int slot;
+    int *last;
+    int i;
+
+    index = talloc_zero(mem_ctx, struct sdap_attr_map_index);
+    if (index == NULL) {
+        return ENOMEM;
+    }
+
+    index->map = map;
+    index->attrs_num = attrs_num;
+
+    /* Keep the table at most half full. */
+    for (size = 16; size < 2 * (unsigned int)attrs_num; size <<= 1);
+    index->mask = size - 1;
+
+    /* Slot value 0 is empty, the objectClass entry is never indexed. */
+    index->slots = talloc_zero_array(index, int, size);
+    index->next = talloc_zero_array(index, int, attrs_num);
+    last = talloc_zero_array(index, int, size);
+    if (index->slots == NULL || index->next == NULL || last == NULL) {
+        talloc_free(index);
+        return ENOMEM;
+    }
+
+    for (i = 1; i < attrs_num; i++) {
+        if (map[i].name == NULL) continue;
+
+        slot = sdap_attr_map_index_hash(map[i].name) & index->mask;
+        while (index->slots[slot] != 0
+                && strcasecmp(map[index->slots[slot]].name, map[i].name) != 0) {
+            slot = (slot + 1) & index->mask;
+        }
+
+        if (index->slots[slot] == 0) {
+            index->slots[slot] = i;
+        } else {
+            index->next[last[slot]] = i;
+        }
+        last[slot] = i;
+    }
+
+    talloc_free(last);
+    *_index = index;
+    return EOK;
+}
+
+errno_t sdap_attr_map_info_index_create(TALLOC_CTX *mem_ctx,
+                                        struct sdap_attr_map_info *minfo,
+                                        size_t num_maps,
+                                        struct sdap_attr_map_index ***_indexes)
+{
+    struct sdap_attr_map_index **indexes;
+    errno_t ret;
+    size_t i;
+
+    indexes = talloc_zero_array(mem_ctx, struct sdap_attr_map_index *,
+                                num_maps + 1);
+    if (indexes == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num_maps; i++) {
+        ret = sdap_attr_map_index_create(indexes, minfo[i].map,
+                                         minfo[i].num_attrs, &indexes[i]);
+        if (ret != EOK) {
+            talloc_free(indexes);
+            return ret;
+        }
+    }
+
+    *_indexes = indexes;
+    return EOK;
+}
+
+/* Returns the first map entry of the given LDAP attribute or 0. */
+static int sdap_attr_map_lookup(struct sdap_attr_map_index *index,
+                                struct sdap_attr_map *map, int attrs_num,
+                                const char *name)
+{
+    unsigned int slot;
+    int i;
+
+    if (index == NULL || index->map != map) {
+        for (i = 1; i < attrs_num; i++) {
+            /* check if this attr is valid with the chosen schema */
+            if (!map[i].name) continue;
+            /* check if it is an attr we are interested in */
+            if (strcasecmp(name, map[i].name) == 0) return i;
+        }
+        return 0;
+    }
+
+    slot = sdap_attr_map_index_hash(name) & index->mask;
+    while (index->slots[slot] != 0) {
+        if (strcasecmp(map[index->slots[slot]].name, name) == 0) {
+            return index->slots[slot];
+        }
+        slot = (slot + 1) & index->mask;
+    }
+
+    return 0;
+}
+
+/* Returns the next map entry with the same LDAP attribute or 0. */
+static int sdap_attr_map_lookup_next(struct sdap_attr_map_index *index,
+                                     struct sdap_attr_map *map, int attrs_num,
+                                     int i, const char *name)
+{
+    if (index != NULL && index->map == map) {
+        return index->next[i];
+    }
+
+    for (i++; i < attrs_num; i++) {
+        if (!map[i].name) continue;
+        if (strcasecmp(name, map[i].name) == 0) return i;
+    }
+
+    return 0;
+}
+
 static bool objectclass_matched(struct sdap_attr_map *map,
                                 const char *objcl, int len);
 int sdap_parse_entry(TALLOC_CTX *memctx,
@@ -394,28 +548,42 @@ int sdap_parse_entry(TALLOC_CTX *memctx,
                      struct sdap_attr_map *map, int attrs_num,
                      struct sysdb_attrs **_attrs,
                      bool disable_range_retrieval)
+{
+    return sdap_parse_entry_ex(memctx, sh, sm, map, attrs_num, NULL,
+                               _attrs, disable_range_retrieval);
+}
+
+int sdap_parse_entry_ex(TALLOC_CTX *memctx,
+                        struct sdap_handle *sh, struct sdap_msg *sm,
+                        struct sdap_attr_map *map, int attrs_num,
+                        struct sdap_attr_map_index *index,
+                        struct sysdb_attrs **_attrs,
+                        bool disable_range_retrieval)
 {
     struct sysdb_attrs *attrs;
     BerElement *ber = NULL;
-    struct berval **vals;
+    struct berval dn;
+    struct berval attr;
+    BerVarray vals = NULL;
     struct ldb_val v;
+    struct ldb_val *parsed = NULL;
+    size_t parsed_size = 0;
+    size_t num_parsed;
     char *str;
-    int lerrno;
+    int lret;
     int i, ret, ai;
-    int base_attr_idx = 0;
-    const char *name;
     bool store;
     bool base64;
+    bool has_oc = false;
+    bool oc_matched = false;
     char *base_attr;
     uint32_t range_offset;
+    bool ranged;
     TALLOC_CTX *tmp_ctx = talloc_new(NULL);
     if (!tmp_ctx) return ENOMEM;
 
-    lerrno = 0;
-    ret = ldap_set_option(sh->ldap, LDAP_OPT_RESULT_CODE, &lerrno);
-    if (ret != LDAP_OPT_SUCCESS) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "ldap_set_option failed [%s], ignored.\n",
-              sss_ldap_err2string(ret));
+    if (index != NULL && index->map != map) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Attribute map index of another map\n");
     }
 
     attrs = sysdb_new_attrs(tmp_ctx);
@@ -424,72 +592,59 @@ int sdap_parse_entry(TALLOC_CTX *memctx,
         goto done;
     }
 
-    str = ldap_get_dn(sh->ldap, sm->msg);
-    if (!str) {
-        ldap_get_option(sh->ldap, LDAP_OPT_RESULT_CODE, &lerrno);
-        DEBUG(SSSDBG_CRIT_FAILURE, "ldap_get_dn failed: %d(%s)\n",
-              lerrno, sss_ldap_err2string(lerrno));
+    /* The values are decoded in place, they point into the message and
+     * are only copied when they are stored. */
+    lret = ldap_get_dn_ber(sh->ldap, sm->msg, &ber, &dn);
+    if (lret != LDAP_SUCCESS || dn.bv_val == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ldap_get_dn_ber failed: %d(%s)\n",
+              lret, sss_ldap_err2string(lret));
         ret = EIO;
         goto done;
     }
 
-    DEBUG(SSSDBG_TRACE_LIBS, "OriginalDN: [%s].\n", str);
-    PROBE(SDAP_PARSE_ENTRY, "OriginalDN", str, strlen(str));
-    ret = sysdb_attrs_add_string(attrs, SYSDB_ORIG_DN, str);
-    ldap_memfree(str);
+    DEBUG(SSSDBG_TRACE_LIBS, "OriginalDN: [%.*s].\n",
+          (int)dn.bv_len, dn.bv_val);
+    PROBE(SDAP_PARSE_ENTRY, "OriginalDN", dn.bv_val, dn.bv_len);
+    ret = sysdb_attrs_add_mem(attrs, SYSDB_ORIG_DN, dn.bv_val, dn.bv_len);
     if (ret) goto done;
 
-    if (map) {
-        vals = ldap_get_values_len(sh->ldap, sm->msg, "objectClass");
-        if (!vals) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Unknown entry type, no objectClasses found!\n");
-            ret = EINVAL;
-            goto done;
-        }
-
-        for (i = 0; vals[i]; i++) {
-            if (objectclass_matched(map, vals[i]->bv_val, vals[i]->bv_len)) {
-                /* ok it's an entry of the right type */
-                break;
+    for (lret = ldap_get_attribute_ber(sh->ldap, sm->msg, ber, &attr, &vals);
+         lret == LDAP_SUCCESS && attr.bv_val != NULL;
+         lret = ldap_get_attribute_ber(sh->ldap, sm->msg, ber, &attr, &vals)) {
+        /* The attribute name is NUL terminated by liblber. */
+        str = attr.bv_val;
+        base64 = false;
+        ai = 0;
+
+        if (map && strcasecmp(str, "objectClass") == 0) {
+            has_oc = true;
+            for (i = 0; vals != NULL && vals[i].bv_val != NULL; i++) {
+                if (objectclass_matched(map, vals[i].bv_val, vals[i].bv_len)) {
+                    /* ok it's an entry of the right type */
+                    oc_matched = true;
+                    break;
+                }
             }
         }
-        if (!vals[i]) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "objectClass not matching: %s\n",
-                  map[0].name);
-            ldap_value_free_len(vals);
-            ret = EINVAL;
-            goto done;
-        }
-        ldap_value_free_len(vals);
-    }
 
-    str = ldap_first_attribute(sh->ldap, sm->msg, &ber);
-    if (!str) {
-        ldap_get_option(sh->ldap, LDAP_OPT_RESULT_CODE, &lerrno);
-        DEBUG(lerrno == LDAP_SUCCESS
-              ? SSSDBG_TRACE_LIBS
-              : SSSDBG_MINOR_FAILURE,
-              "Entry has no attributes [%d(%s)]!?\n",
-               lerrno, sss_ldap_err2string(lerrno));
-        if (map) {
-            ret = EINVAL;
-            goto done;
+        /* The rest of the entry is still iterated over when the
+         * objectClass did not match, only nothing gets stored. */
+        if (has_oc && !oc_matched) {
+            ber_memfree(vals);
+            vals = NULL;
+            continue;
         }
-    }
-    while (str) {
-        base64 = false;
 
+        ranged = false;
         ret = sdap_parse_range(tmp_ctx, str, &base_attr, &range_offset,
                                disable_range_retrieval);
         switch(ret) {
         case EAGAIN:
             /* This attribute contained range values and needs more to
-             * be retrieved
-             */
-            /* TODO: return the set of attributes that need additional retrieval
-             * For now, we'll continue below and treat it as regular values.
+             * be retrieved. The values are stored below and the offset of
+             * the next range is remembered for the caller.
              */
+            ranged = true;
             /* FALLTHROUGH */
         case ECANCELED:
             /* FALLTHROUGH */
@@ -502,26 +657,13 @@ int sdap_parse_entry(TALLOC_CTX *memctx,
         }
 
         if (map) {
-            for (i = 1; i < attrs_num; i++) {
-                /* check if this attr is valid with the chosen schema */
-                if (!map[i].name) continue;
-                /* check if it is an attr we are interested in */
-                if (strcasecmp(base_attr, map[i].name) == 0) break;
-            }
+            ai = sdap_attr_map_lookup(index, map, attrs_num, base_attr);
             /* interesting attr */
-            if (i < attrs_num) {
-                store = true;
-                name = map[i].sys_name;
-                base_attr_idx = i;
-                if (strcmp(name, SYSDB_SSH_PUBKEY) == 0) {
-                    base64 = true;
-                }
-            } else {
-                store = false;
-                name = NULL;
+            store = (ai != 0);
+            if (store && strcmp(map[ai].sys_name, SYSDB_SSH_PUBKEY) == 0) {
+                base64 = true;
             }
         } else {
-            name = base_attr;
             store = true;
         }
 
@@ -530,103 +672,113 @@ int sdap_parse_entry(TALLOC_CTX *memctx,
             store = false;
         }
 
+        if (store && (vals == NULL || vals[0].bv_val == NULL)) {
+            DEBUG(SSSDBG_TRACE_LIBS,
+                  "Attribute [%s] has no values, skipping.\n", str);
+            store = false;
+        }
+
         if (store) {
-            vals = ldap_get_values_len(sh->ldap, sm->msg, str);
-            if (!vals) {
-                ldap_get_option(sh->ldap, LDAP_OPT_RESULT_CODE, &lerrno);
-                if (lerrno != LDAP_SUCCESS) {
-                    DEBUG(SSSDBG_CRIT_FAILURE, "LDAP Library error: %d(%s)\n",
-                          lerrno, sss_ldap_err2string(lerrno));
-                    ret = EIO;
+            for (i = 0; vals[i].bv_val; i++);
+
+            /* Collect the values first so they can be copied all at
+             * once, large groups have thousands of members. */
+            if (parsed_size < (size_t)i) {
+                talloc_free(parsed);
+                parsed = talloc_array(tmp_ctx, struct ldb_val, i);
+                if (parsed == NULL) {
+                    ret = ENOMEM;
                     goto done;
                 }
-
-                DEBUG(SSSDBG_TRACE_LIBS,
-                      "Attribute [%s] has no values, skipping.\n", str);
-
-            } else {
-                if (!vals[0]) {
-                    DEBUG(SSSDBG_CRIT_FAILURE,
-                          "Missing value after ldap_get_values() ??\n");
-                    ldap_value_free_len(vals);
-                    ret = EINVAL;
-                    goto done;
+                parsed_size = i;
+            }
+            num_parsed = 0;
+
+            for (i = 0; vals[i].bv_val; i++) {
+                if (vals[i].bv_len == 0) {
+                    DEBUG(SSSDBG_TRACE_LIBS,
+                          "Value of attribute [%s] is empty. "
+                           "Skipping this value.\n", str);
+                    continue;
                 }
-                for (i = 0; vals[i]; i++) {
-                    if (vals[i]->bv_len == 0) {
-                        DEBUG(SSSDBG_TRACE_LIBS,
-                              "Value of attribute [%s] is empty. "
-                               "Skipping this value.\n", str);
-                        continue;
-                    }
-                    if (base64) {
-                        v.data = (uint8_t *) sss_base64_encode(attrs,
-                                 (uint8_t *) vals[i]->bv_val, vals[i]->bv_len);
-                        if (!v.data) {
-                            ldap_value_free_len(vals);
-                            ret = ENOMEM;
-                            goto done;
-                        }
-                        v.length = strlen((const char *)v.data);
-                    } else {
-                        v.data = (uint8_t *)vals[i]->bv_val;
-                        v.length = vals[i]->bv_len;
-                    }
-                    PROBE(SDAP_PARSE_ENTRY, str, v.data, v.length);
-
-                    if (map) {
-                        /* The same LDAP attr might be used for more sysdb
-                         * attrs in case there is a map. Find all that match
-                         * and copy the value
-                         */
-                        for (ai = base_attr_idx; ai < attrs_num; ai++) {
-                            /* check if this attr is valid with the chosen
-                             * schema */
-                            if (!map[ai].name) continue;
-
-                            /* check if it is an attr we are interested in */
-                            if (strcasecmp(base_attr, map[ai].name) == 0) {
-                                ret = sysdb_attrs_add_val(attrs,
-                                                          map[ai].sys_name,
-                                                          &v);
-                                if (ret) {
-                                    ldap_value_free_len(vals);
-                                    goto done;
-                                }
-                            }
-                        }
-                    } else {
-                        /* No map, just store the attribute */
-                        ret = sysdb_attrs_add_val(attrs, name, &v);
-                        if (ret) {
-                            ldap_value_free_len(vals);
-                            goto done;
-                        }
+                if (base64) {
+                    v.data = (uint8_t *) sss_base64_encode(tmp_ctx,
+                             (uint8_t *) vals[i].bv_val, vals[i].bv_len);
+                    if (!v.data) {
+                        ret = ENOMEM;
+                        goto done;
                     }
+                    v.length = strlen((const char *)v.data);
+                } else {
+                    v.data = (uint8_t *)vals[i].bv_val;
+                    v.length = vals[i].bv_len;
+                }
+                PROBE(SDAP_PARSE_ENTRY, str, v.data, v.length);
+
+                parsed[num_parsed] = v;
+                num_parsed++;
+            }
+
+            if (map) {
+                /* The same LDAP attr might be used for more sysdb
+                 * attrs in case there is a map. Find all that match
+                 * and copy the values
+                 */
+                for (; ai != 0;
+                     ai = sdap_attr_map_lookup_next(index, map, attrs_num,
+                                                    ai, base_attr)) {
+                    ret = sysdb_attrs_add_vals(attrs, map[ai].sys_name,
+                                               parsed, num_parsed);
+                    if (ret) goto done;
                 }
-                ldap_value_free_len(vals);
+            } else {
+                /* No map, just store the attribute */
+                ret = sysdb_attrs_add_vals(attrs, base_attr,
+                                           parsed, num_parsed);
+                if (ret) goto done;
+            }
+
+            if (ranged) {
+                ret = sdap_range_set_next(attrs, base_attr, range_offset);
+                if (ret) goto done;
             }
         }
 
-        ldap_memfree(str);
-        str = ldap_next_attribute(sh->ldap, sm->msg, ber);
+        ber_memfree(vals);
+        vals = NULL;
     }
-    ber_free(ber, 0);
-    ber = NULL;
 
-    ldap_get_option(sh->ldap, LDAP_OPT_RESULT_CODE, &lerrno);
-    if (lerrno) {
+    if (lret != LDAP_SUCCESS) {
         DEBUG(SSSDBG_CRIT_FAILURE, "LDAP Library error: %d(%s)\n",
-              lerrno, sss_ldap_err2string(lerrno));
+              lret, sss_ldap_err2string(lret));
         ret = EIO;
         goto done;
     }
 
+    if (map && !has_oc) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unknown entry type, no objectClasses found!\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (map && !oc_matched) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "objectClass not matching: %s\n",
+              map[0].name);
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (attrs->num == 1) {
+        DEBUG(SSSDBG_TRACE_LIBS, "Entry has no attributes\n");
+    }
+
     PROBE(SDAP_PARSE_ENTRY_DONE);
     *_attrs = talloc_steal(memctx, attrs);
     ret = EOK;
 
 done:
+    if (vals) ber_memfree(vals);
     if (ber) ber_free(ber, 0);
     talloc_free(tmp_ctx);
     return ret;
@@ -657,12 +809,24 @@ errno_t sdap_parse_deref(TALLOC_CTX *mem_ctx,
                          size_t num_maps,
                          LDAPDerefRes *dref,
                          struct sdap_deref_attrs ***_deref_res)
+{
+    return sdap_parse_deref_ex(mem_ctx, minfo, NULL, num_maps,
+                               dref, _deref_res);
+}
+
+errno_t sdap_parse_deref_ex(TALLOC_CTX *mem_ctx,
+                            struct sdap_attr_map_info *minfo,
+                            struct sdap_attr_map_index **indexes,
+                            size_t num_maps,
+                            LDAPDerefRes *dref,
+                            struct sdap_deref_attrs ***_deref_res)
 {
     TALLOC_CTX *tmp_ctx;
     LDAPDerefVal *dval;
     const char *orig_dn;
     const char **ocs;
     struct sdap_attr_map *map;
+    struct sdap_attr_map_index *index;
     int num_attrs;
     int ret, i, a, mi;
     const char *name;
@@ -761,6 +925,8 @@ errno_t sdap_parse_deref(TALLOC_CTX *mem_ctx,
         }
         if (!map) continue;
 
+        index = indexes != NULL ? indexes[mi] : NULL;
+
         res[mi]->attrs = sysdb_new_attrs(res[mi]);
         if (!res[mi]->attrs) {
             ret = ENOMEM;
@@ -777,15 +943,10 @@ errno_t sdap_parse_deref(TALLOC_CTX *mem_ctx,
             DEBUG(SSSDBG_TRACE_INTERNAL,
                   "Dereferenced attribute: %s\n", dval->type);
 
-            for (a = 1; a < num_attrs; a++) {
-                /* check if this attr is valid with the chosen schema */
-                if (!map[a].name) continue;
-                /* check if it is an attr we are interested in */
-                if (strcasecmp(dval->type, map[a].name) == 0) break;
-            }
+            a = sdap_attr_map_lookup(index, map, num_attrs, dval->type);
 
             /* interesting attr */
-            if (a < num_attrs) {
+            if (a != 0) {
                 name = map[a].sys_name;
             } else {
                 continue;
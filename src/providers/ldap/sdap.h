@@ -52,6 +52,11 @@ struct sdap_op {
     struct tevent_context *ev;
     struct sdap_msg *list;
     struct sdap_msg *last;
+
+    /* when the request was sent, to measure the server latency */
+    struct timeval start;
+
+    struct sss_trace_span *span;
 };
 
 struct fd_event_item {
@@ -89,6 +94,9 @@ struct sdap_handle {
 
     struct sdap_op *ops;
 
+    /* fail over server the handle is connected to, if known */
+    struct fo_server *srv;
+
     /* during release we need to lock access to the handler
      * from the destructor to avoid recursion */
     bool destructor_lock;
@@ -96,11 +104,16 @@ struct sdap_handle {
     bool release_memory;
 };
 
+struct sdap_kinit_cache;
+
 struct sdap_service {
     char *name;
     char *uri;
     char *kinit_service_name;
     struct sockaddr_storage *sockaddr;
+
+    /* TGT obtained for GSSAPI binds, shared by all connections */
+    struct sdap_kinit_cache *kinit_cache;
 };
 
 struct sdap_ppolicy_data {
@@ -240,6 +253,11 @@ enum sdap_basic_opt {
     SDAP_MAX_ID,
     SDAP_PWDLOCKOUT_DN,
     SDAP_WILDCARD_LIMIT,
+    SDAP_NESTING_PARALLEL_LOOKUPS,
+    SDAP_NESTING_BATCH_SIZE,
+    SDAP_CONNECTION_POOL_SIZE,
+    SDAP_ENUM_CONTENT_SYNC,
+    SDAP_CONNECTION_SPARE,
 
     SDAP_OPTS_BASIC /* opts counter */
 };
@@ -456,6 +474,10 @@ struct sdap_domain {
     struct sdap_domain **head;
 
     void *pvt;
+    /* If set, creates pvt on first use, see sdap_domain_get_pvt() */
+    errno_t (*pvt_init)(struct sdap_domain *sdom, void *pvt_init_data,
+                        void **_pvt);
+    void *pvt_init_data;
 };
 
 typedef struct tevent_req *
@@ -616,12 +638,42 @@ int sdap_parse_entry(TALLOC_CTX *memctx,
                      struct sysdb_attrs **_attrs,
                      bool disable_range_retrieval);
 
+/* Precomputed lookup of the LDAP attribute names of a map, searches that
+ * parse many entries with the same map should create it once and pass it
+ * to sdap_parse_entry_ex(). */
+struct sdap_attr_map_index;
+
+errno_t sdap_attr_map_index_create(TALLOC_CTX *mem_ctx,
+                                   struct sdap_attr_map *map,
+                                   int attrs_num,
+                                   struct sdap_attr_map_index **_index);
+
+/* Creates a NULL terminated array with an index for every map. */
+errno_t sdap_attr_map_info_index_create(TALLOC_CTX *mem_ctx,
+                                        struct sdap_attr_map_info *minfo,
+                                        size_t num_maps,
+                                        struct sdap_attr_map_index ***_indexes);
+
+int sdap_parse_entry_ex(TALLOC_CTX *memctx,
+                        struct sdap_handle *sh, struct sdap_msg *sm,
+                        struct sdap_attr_map *map, int attrs_num,
+                        struct sdap_attr_map_index *index,
+                        struct sysdb_attrs **_attrs,
+                        bool disable_range_retrieval);
+
 errno_t sdap_parse_deref(TALLOC_CTX *mem_ctx,
                          struct sdap_attr_map_info *minfo,
                          size_t num_maps,
                          LDAPDerefRes *dref,
                          struct sdap_deref_attrs ***_deref_res);
 
+errno_t sdap_parse_deref_ex(TALLOC_CTX *mem_ctx,
+                            struct sdap_attr_map_info *minfo,
+                            struct sdap_attr_map_index **indexes,
+                            size_t num_maps,
+                            LDAPDerefRes *dref,
+                            struct sdap_deref_attrs ***_deref_res);
+
 errno_t setup_tls_config(struct dp_option *basic_opts);
 
 int sdap_set_rootdse_supported_lists(struct sysdb_attrs *rootdse,
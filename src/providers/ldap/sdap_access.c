@@ -73,7 +73,8 @@ sdap_access_ppolicy_send(TALLOC_CTX *mem_ctx,
                          struct sdap_id_conn_ctx *conn,
                          const char *username,
                          struct ldb_message *user_entry,
-                         enum sdap_pwpolicy_mode pwpol_mod);
+                         struct sysdb_attrs *ldap_user,
+                         enum sdap_pwpolicy_mode pwpol_mode);
 
 static struct tevent_req *sdap_access_filter_send(TALLOC_CTX *mem_ctx,
                                              struct tevent_context *ev,
@@ -84,7 +85,9 @@ static struct tevent_req *sdap_access_filter_send(TALLOC_CTX *mem_ctx,
                                              const char *username,
                                              struct ldb_message *user_entry);
 
-static errno_t sdap_access_filter_recv(struct tevent_req *req);
+static errno_t sdap_access_filter_recv(TALLOC_CTX *mem_ctx,
+                                       struct tevent_req *req,
+                                       struct sysdb_attrs **_ldap_user);
 
 static errno_t sdap_access_ppolicy_recv(struct tevent_req *req);
 
@@ -112,6 +115,9 @@ struct sdap_access_req_ctx {
     struct be_ctx *be_ctx;
     struct sss_domain_info *domain;
     struct ldb_message *user_entry;
+    /* User entry read by the filter check, including the lockout
+     * attributes, so the ppolicy check does not need to read it again. */
+    struct sysdb_attrs *ldap_user;
     size_t current_rule;
     enum sdap_access_control_type ac_type;
 };
@@ -226,6 +232,7 @@ static errno_t sdap_access_check_next_rule(struct sdap_access_req_ctx *state,
                                               state->conn,
                                               state->pd->user,
                                               state->user_entry,
+                                              state->ldap_user,
                                               PWP_LOCKOUT_ONLY);
             if (subreq == NULL) {
                 DEBUG(SSSDBG_CRIT_FAILURE,
@@ -245,6 +252,7 @@ static errno_t sdap_access_check_next_rule(struct sdap_access_req_ctx *state,
                                               state->conn,
                                               state->pd->user,
                                               state->user_entry,
+                                              state->ldap_user,
                                               PWP_LOCKOUT_EXPIRE);
             if (subreq == NULL) {
                 DEBUG(SSSDBG_CRIT_FAILURE,
@@ -339,7 +347,7 @@ static void sdap_access_done(struct tevent_req *subreq)
     /* process subrequest */
     switch(state->ac_type) {
     case SDAP_ACCESS_CONTROL_FILTER:
-        ret = sdap_access_filter_recv(subreq);
+        ret = sdap_access_filter_recv(state, subreq, &state->ldap_user);
         break;
     case SDAP_ACCESS_CONTROL_PPOLICY_LOCK:
         ret = sdap_access_ppolicy_recv(subreq);
@@ -825,6 +833,7 @@ struct sdap_access_filter_req_ctx {
     /* cached result of access control checks */
     bool cached_access;
     const char *basedn;
+    struct sysdb_attrs *ldap_user;
 };
 
 static errno_t sdap_access_decide_offline(bool cached_ac);
@@ -982,6 +991,10 @@ static void sdap_access_filter_connect_done(struct tevent_req *subreq)
                                                       struct tevent_req);
     struct sdap_access_filter_req_ctx *state =
             tevent_req_data(req, struct sdap_access_filter_req_ctx);
+    /* The entry is kept for the ppolicy check, see sdap_access_req_ctx. */
+    const char *attrs[] = { SYSDB_LDAP_ACCESS_LOCKED_TIME,
+                            SYSDB_LDAP_ACESS_LOCKOUT_DURATION,
+                            NULL };
     int ret, dp_error;
 
     ret = sdap_id_op_connect_recv(subreq, &dp_error);
@@ -1009,7 +1022,7 @@ static void sdap_access_filter_connect_done(struct tevent_req *subreq)
                                    sdap_id_op_handle(state->sdap_op),
                                    state->basedn,
                                    LDAP_SCOPE_BASE,
-                                   state->filter, NULL,
+                                   state->filter, attrs,
                                    NULL, 0,
                                    dp_opt_get_int(state->opts->basic,
                                                   SDAP_SEARCH_TIMEOUT),
@@ -1087,6 +1100,7 @@ static void sdap_access_filter_done(struct tevent_req *subreq)
     }
     else { /* Ok, we got a single reply */
         found = true;
+        state->ldap_user = results[0];
     }
 
     if (found) {
@@ -1121,10 +1135,19 @@ done:
     }
 }
 
-static errno_t sdap_access_filter_recv(struct tevent_req *req)
+static errno_t sdap_access_filter_recv(TALLOC_CTX *mem_ctx,
+                                       struct tevent_req *req,
+                                       struct sysdb_attrs **_ldap_user)
 {
+    struct sdap_access_filter_req_ctx *state;
+
+    state = tevent_req_data(req, struct sdap_access_filter_req_ctx);
+
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
+    /* NULL if the check was decided offline. */
+    *_ldap_user = talloc_steal(mem_ctx, state->ldap_user);
+
     return EOK;
 }
 
@@ -1386,10 +1409,18 @@ errno_t sdap_access_rhost(struct ldb_message *user_entry, char *pam_rhost)
     return ret;
 }
 
+/* How long the lockout setting of the password policy is remembered. */
+#define SDAP_ACCESS_PPOLICY_LOCKOUT_TIMEOUT 300
+
 static void sdap_access_ppolicy_get_lockout_done(struct tevent_req *subreq);
 static int sdap_access_ppolicy_retry(struct tevent_req *req);
 static errno_t sdap_access_ppolicy_step(struct tevent_req *req);
 static void sdap_access_ppolicy_step_done(struct tevent_req *subreq);
+static errno_t sdap_access_ppolicy_locked(struct tevent_req *req,
+                                          bool pwdLockout);
+static errno_t sdap_access_ppolicy_evaluate(struct tevent_req *req,
+                                            size_t num_results,
+                                            struct sysdb_attrs **results);
 
 struct sdap_access_ppolicy_req_ctx {
     const char *username;
@@ -1408,6 +1439,8 @@ struct sdap_access_ppolicy_req_ctx {
     const char **ppolicy_dns;
     unsigned int ppolicy_dns_index;
     enum sdap_pwpolicy_mode pwpol_mode;
+    /* user entry already read from LDAP by this access request */
+    struct sysdb_attrs *ldap_user;
 };
 
 static struct tevent_req *
@@ -1419,6 +1452,7 @@ sdap_access_ppolicy_send(TALLOC_CTX *mem_ctx,
                          struct sdap_id_conn_ctx *conn,
                          const char *username,
                          struct ldb_message *user_entry,
+                         struct sysdb_attrs *ldap_user,
                          enum sdap_pwpolicy_mode pwpol_mode)
 {
     struct sdap_access_ppolicy_req_ctx *state;
@@ -1440,6 +1474,7 @@ sdap_access_ppolicy_send(TALLOC_CTX *mem_ctx,
     state->domain = domain;
     state->ppolicy_dns_index = 0;
     state->pwpol_mode = pwpol_mode;
+    state->ldap_user = ldap_user;
 
     DEBUG(SSSDBG_TRACE_FUNC,
           "Performing access ppolicy check for user [%s]\n", username);
@@ -1460,6 +1495,15 @@ sdap_access_ppolicy_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* Without lockout nothing has to be read from the user entry and with
+     * it the entry may have been read already. */
+    if (access_ctx->ppolicy_lockout_expire > time(NULL)
+            && (!access_ctx->ppolicy_lockout || ldap_user != NULL)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Checking ppolicy without LDAP search\n");
+        ret = sdap_access_ppolicy_locked(req, access_ctx->ppolicy_lockout);
+        goto done;
+    }
+
     DEBUG(SSSDBG_TRACE_FUNC, "Checking ppolicy against LDAP\n");
 
     state->sdap_op = sdap_id_op_create(state,
@@ -1713,37 +1757,11 @@ static void sdap_access_ppolicy_get_lockout_done(struct tevent_req *subreq)
         }
     }
 
-    if (pwdLockout) {
-        DEBUG(SSSDBG_TRACE_FUNC,
-              "Password policy is enabled on LDAP server.\n");
+    state->access_ctx->ppolicy_lockout = pwdLockout;
+    state->access_ctx->ppolicy_lockout_expire =
+                            time(NULL) + SDAP_ACCESS_PPOLICY_LOCKOUT_TIMEOUT;
 
-        /* ppolicy is enabled => find out if account is locked */
-        ret = sdap_access_ppolicy_step(req);
-        if (ret != EOK && ret != EAGAIN) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "sdap_access_ppolicy_step failed: [%d][%s].\n",
-                  ret, sss_strerror(ret));
-        }
-        goto done;
-    } else {
-        DEBUG(SSSDBG_TRACE_FUNC,
-              "Password policy is disabled on LDAP server "
-              "- storing 'access granted' in sysdb.\n");
-        tret = sdap_save_user_cache_bool(state->domain, state->username,
-                                         SYSDB_LDAP_ACCESS_CACHED_LOCKOUT,
-                                         true);
-        if (tret != EOK) {
-            /* Failing to save to the cache is non-fatal.
-             * Just return the result.
-             */
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Failed to set user locked attribute\n");
-            goto done;
-        }
-
-        ret = EOK;
-        goto done;
-    }
+    ret = sdap_access_ppolicy_locked(req, pwdLockout);
 
 done:
     if (ret != EAGAIN) {
@@ -1763,6 +1781,52 @@ done:
     }
 }
 
+/* Decides the request once it is known whether the password policy
+ * enables lockout. Returns EAGAIN if the user entry must be searched. */
+static errno_t sdap_access_ppolicy_locked(struct tevent_req *req,
+                                          bool pwdLockout)
+{
+    struct sdap_access_ppolicy_req_ctx *state;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sdap_access_ppolicy_req_ctx);
+
+    if (pwdLockout) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Password policy is enabled on LDAP server.\n");
+
+        if (state->ldap_user != NULL) {
+            /* The filter check of this request has read the entry. */
+            return sdap_access_ppolicy_evaluate(req, 1, &state->ldap_user);
+        }
+
+        /* ppolicy is enabled => find out if account is locked */
+        ret = sdap_access_ppolicy_step(req);
+        if (ret != EOK && ret != EAGAIN) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "sdap_access_ppolicy_step failed: [%d][%s].\n",
+                  ret, sss_strerror(ret));
+        }
+        return ret;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Password policy is disabled on LDAP server "
+          "- storing 'access granted' in sysdb.\n");
+    ret = sdap_save_user_cache_bool(state->domain, state->username,
+                                    SYSDB_LDAP_ACCESS_CACHED_LOCKOUT,
+                                    true);
+    if (ret != EOK) {
+        /* Failing to save to the cache is non-fatal.
+         * Just return the result.
+         */
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Failed to set user locked attribute\n");
+    }
+
+    return EOK;
+}
+
 errno_t sdap_access_ppolicy_step(struct tevent_req *req)
 {
     errno_t ret;
@@ -1888,9 +1952,6 @@ static void sdap_access_ppolicy_step_done(struct tevent_req *subreq)
 {
     int ret, tret, dp_error;
     size_t num_results;
-    bool locked = false;
-    const char *pwdAccountLockedTime;
-    const char *pwdAccountLockedDurationTime;
     struct sysdb_attrs **results;
     struct tevent_req *req;
     struct sdap_access_ppolicy_req_ctx *state;
@@ -1920,6 +1981,28 @@ static void sdap_access_ppolicy_step_done(struct tevent_req *subreq)
         goto done;
     }
 
+    ret = sdap_access_ppolicy_evaluate(req, num_results, results);
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+}
+
+static errno_t sdap_access_ppolicy_evaluate(struct tevent_req *req,
+                                            size_t num_results,
+                                            struct sysdb_attrs **results)
+{
+    struct sdap_access_ppolicy_req_ctx *state;
+    const char *pwdAccountLockedTime;
+    const char *pwdAccountLockedDurationTime;
+    bool locked = false;
+    int ret, tret;
+
+    state = tevent_req_data(req, struct sdap_access_ppolicy_req_ctx);
+
     /* Check the number of responses we got
      * If it's exactly 1, we passed the check
      * If it's < 1, we failed the check
@@ -1931,15 +2014,13 @@ static void sdap_access_ppolicy_step_done(struct tevent_req *subreq)
               "Denying access.\n", state->username);
     } else if (results == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "num_results > 0, but results is NULL\n");
-        ret = ERR_INTERNAL;
-        goto done;
+        return ERR_INTERNAL;
     } else if (num_results > 1) {
         /* It should not be possible to get more than one reply
          * here, since we're doing a base-scoped search
          */
         DEBUG(SSSDBG_CRIT_FAILURE, "Received multiple replies\n");
-        ret = ERR_INTERNAL;
-        goto done;
+        return ERR_INTERNAL;
     } else { /* Ok, we got a single reply */
         ret = sysdb_attrs_get_string(results[0], SYSDB_LDAP_ACESS_LOCKOUT_DURATION,
                                      &pwdAccountLockedDurationTime);
@@ -2004,15 +2085,9 @@ static void sdap_access_ppolicy_step_done(struct tevent_req *subreq)
          * Just return the result.
          */
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to set user locked attribute\n");
-        goto done;
     }
 
-done:
-    if (ret == EOK) {
-        tevent_req_done(req);
-    } else {
-        tevent_req_error(req, ret);
-    }
+    return ret;
 }
 
 static errno_t sdap_access_ppolicy_recv(struct tevent_req *req)
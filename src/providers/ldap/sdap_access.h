@@ -75,6 +75,11 @@ struct sdap_access_ctx {
     struct sdap_id_ctx *id_ctx;
     const char *filter;
     int access_rule[LDAP_ACCESS_LAST + 1];
+
+    /* Whether the password policy on the server enables lockout, valid
+     * until ppolicy_lockout_expire. */
+    bool ppolicy_lockout;
+    time_t ppolicy_lockout_expire;
 };
 
 struct tevent_req *
@@ -24,6 +24,9 @@
 #include "util/util.h"
 #include "util/strtonum.h"
 #include "util/probes.h"
+#include "util/sss_trace.h"
+#include "util/sss_metrics.h"
+#include "util/sss_loop_stats.h"
 #include "providers/ldap/sdap_async_private.h"
 
 #define REPLY_REALLOC_INCREMENT 10
@@ -141,6 +144,8 @@ static void sdap_process_result(struct tevent_context *ev, void *pvt)
     LDAPMessage *msg;
     int ret;
 
+    SSS_LOOP_STATS_MARK();
+
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "Trace: sh[%p], connected[%d], ops[%p], ldap[%p]\n",
               sh, (int)sh->connected, sh->ops, sh->ldap);
@@ -245,11 +250,61 @@ static const char *sdap_ldap_result_str(int msgtype)
  * NOTE: this function may even end up freeing the sdap_handle
  * so sdap_handle must not be used after this function is called
  */
+/* Accounts the latency of the operation and tells fail over how the server
+ * behaves. If there is a better server, no new operations are started on
+ * this connection. */
+static void sdap_op_report_health(struct sdap_op *op, bool failed,
+                                  const char *outcome)
+{
+    struct timeval now;
+    struct timeval diff;
+    uint64_t latency;
+
+    now = tevent_timeval_current();
+    diff = tevent_timeval_until(&op->start, &now);
+    latency = (uint64_t)diff.tv_sec * 1000000 + diff.tv_usec;
+
+    sss_metrics_observe(SSS_METRIC_LDAP_OP_DURATION, latency, outcome);
+
+    if (op->sh->srv == NULL) {
+        return;
+    }
+
+    if (fo_server_report_op(op->sh->srv, latency, failed)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Server %s is degraded, the connection "
+              "will not be reused\n", fo_get_server_str_name(op->sh->srv));
+        op->sh->expire_time = time(NULL);
+    }
+}
+
+static bool sdap_server_failed(struct sdap_handle *sh, LDAPMessage *msg)
+{
+    int result;
+    int ret;
+
+    ret = ldap_parse_result(sh->ldap, msg, &result,
+                            NULL, NULL, NULL, NULL, 0);
+    if (ret != LDAP_SUCCESS) {
+        return false;
+    }
+
+    switch (result) {
+    case LDAP_BUSY:
+    case LDAP_UNAVAILABLE:
+    case LDAP_TIMELIMIT_EXCEEDED:
+    case LDAP_OTHER:
+        return true;
+    default:
+        return false;
+    }
+}
+
 static void sdap_process_message(struct tevent_context *ev,
                                  struct sdap_handle *sh, LDAPMessage *msg)
 {
     struct sdap_msg *reply;
     struct sdap_op *op;
+    bool failed;
     int msgid;
     int msgtype;
     int ret;
@@ -289,7 +344,9 @@ static void sdap_process_message(struct tevent_context *ev,
     switch (msgtype) {
     case LDAP_RES_SEARCH_ENTRY:
     case LDAP_RES_SEARCH_REFERENCE:
-        /* go and process entry */
+    case LDAP_RES_INTERMEDIATE:
+        /* go and process entry, intermediate responses are never the
+         * final one (RFC 4511 section 4.13) */
         break;
 
     case LDAP_RES_BIND:
@@ -300,9 +357,11 @@ static void sdap_process_message(struct tevent_context *ev,
     case LDAP_RES_MODDN:
     case LDAP_RES_COMPARE:
     case LDAP_RES_EXTENDED:
-    case LDAP_RES_INTERMEDIATE:
         /* no more results expected with this msgid */
         op->done = true;
+        failed = sdap_server_failed(sh, msg);
+        sss_trace_span_end(op->span, failed ? EIO : EOK);
+        sdap_op_report_health(op, failed, failed ? "error" : "success");
         break;
 
     default:
@@ -420,6 +479,8 @@ static void sdap_op_timeout(struct tevent_req *req)
 
     /* signal the caller that we have a timeout */
     DEBUG(SSSDBG_TRACE_LIBS, "Issuing timeout for %d\n", op->msgid);
+    sss_trace_span_end(op->span, ETIMEDOUT);
+    sdap_op_report_health(op, true, "timeout");
     op->callback(op, NULL, ETIMEDOUT, op->data);
 }
 
@@ -438,6 +499,8 @@ int sdap_op_add(TALLOC_CTX *memctx, struct tevent_context *ev,
     op->callback = callback;
     op->data = data;
     op->ev = ev;
+    op->start = tevent_timeval_current();
+    op->span = sss_trace_span_start_child(op, "LDAP operation", NULL);
 
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "New operation %d timeout %d\n", op->msgid, timeout);
@@ -1289,6 +1352,10 @@ typedef errno_t (*sdap_parse_cb)(struct sdap_handle *sh,
                                  struct sdap_msg *msg,
                                  void *pvt);
 
+/* Called when all entries of a page were parsed. If there is another page,
+ * it is already requested so the server works on it meanwhile. */
+typedef errno_t (*sdap_page_done_cb)(void *pvt);
+
 struct sdap_get_generic_ext_state {
     struct tevent_context *ev;
     struct sdap_options *opts;
@@ -1314,6 +1381,9 @@ struct sdap_get_generic_ext_state {
     sdap_parse_cb parse_cb;
     void *cb_data;
 
+    sdap_page_done_cb page_done_cb;
+    void *page_done_data;
+
     unsigned int flags;
 };
 
@@ -1547,6 +1617,28 @@ done:
     return ret;
 }
 
+static void
+sdap_get_generic_ext_set_page_done_cb(struct tevent_req *req,
+                                      sdap_page_done_cb page_done_cb,
+                                      void *page_done_data)
+{
+    struct sdap_get_generic_ext_state *state =
+            tevent_req_data(req, struct sdap_get_generic_ext_state);
+
+    state->page_done_cb = page_done_cb;
+    state->page_done_data = page_done_data;
+}
+
+static errno_t
+sdap_get_generic_ext_page_done(struct sdap_get_generic_ext_state *state)
+{
+    if (state->page_done_cb == NULL) {
+        return EOK;
+    }
+
+    return state->page_done_cb(state->page_done_data);
+}
+
 static errno_t
 sdap_get_generic_ext_add_references(struct sdap_get_generic_ext_state *state,
                                     char **refs)
@@ -1689,6 +1781,13 @@ static void sdap_get_generic_op_finished(struct sdap_op *op,
             ldap_memfree(errmsg);
             tevent_req_error(req, ENOTSUP);
             return;
+        } else if (result == LDAP_BUSY || result == LDAP_UNAVAILABLE) {
+            DEBUG(SSSDBG_OP_FAILURE, "Server is busy: %s(%d), %s\n",
+                  sss_ldap_err2string(result), result,
+                  errmsg ? errmsg : "no errmsg set");
+            ldap_memfree(errmsg);
+            tevent_req_error(req, ERR_SERVER_BUSY);
+            return;
         } else if (result == LDAP_REFERRAL) {
             ret = sdap_get_generic_ext_add_references(state, refs);
             if (ret != EOK) {
@@ -1714,6 +1813,12 @@ static void sdap_get_generic_op_finished(struct sdap_op *op,
                                          returned_controls, NULL );
         if (!page_control) {
             /* No paging support. We are done */
+            ret = sdap_get_generic_ext_page_done(state);
+            if (ret != EOK) {
+                tevent_req_error(req, ret);
+                return;
+            }
+
             tevent_req_done(req);
             return;
         }
@@ -1749,12 +1854,27 @@ static void sdap_get_generic_op_finished(struct sdap_op *op,
                 return;
             }
 
+            /* The next page is in flight, hand over this one. The next
+             * reply is not processed until the callback returns, so at
+             * most one page waits on the wire while another one is
+             * consumed. */
+            ret = sdap_get_generic_ext_page_done(state);
+            if (ret != EOK) {
+                tevent_req_error(req, ret);
+                return;
+            }
+
             return;
         }
         /* The cookie must be freed even if len == 0 */
         ber_memfree(cookie.bv_val);
 
         /* This was the last page. We're done */
+        ret = sdap_get_generic_ext_page_done(state);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
 
         tevent_req_done(req);
         return;
@@ -1831,15 +1951,20 @@ static void generic_ext_search_handler(struct tevent_req *subreq,
 struct sdap_get_and_parse_generic_state {
     struct sdap_attr_map *map;
     int map_num_attrs;
+    struct sdap_attr_map_index *map_index;
 
     struct sdap_reply sreply;
     struct sdap_options *opts;
+
+    sdap_page_cb page_cb;
+    void *page_pvt;
 };
 
 static void sdap_get_and_parse_generic_done(struct tevent_req *subreq);
 static errno_t sdap_get_and_parse_generic_parse_entry(struct sdap_handle *sh,
                                                       struct sdap_msg *msg,
                                                       void *pvt);
+static errno_t sdap_get_and_parse_generic_page_done(void *pvt);
 
 struct tevent_req *sdap_get_and_parse_generic_send(TALLOC_CTX *memctx,
                                                    struct tevent_context *ev,
@@ -1862,6 +1987,7 @@ struct tevent_req *sdap_get_and_parse_generic_send(TALLOC_CTX *memctx,
     struct tevent_req *subreq = NULL;
     struct sdap_get_and_parse_generic_state *state = NULL;
     unsigned int flags = 0;
+    errno_t ret;
 
     req = tevent_req_create(memctx, &state,
                             struct sdap_get_and_parse_generic_state);
@@ -1871,6 +1997,15 @@ struct tevent_req *sdap_get_and_parse_generic_send(TALLOC_CTX *memctx,
     state->map_num_attrs = map_num_attrs;
     state->opts = opts;
 
+    if (map != NULL) {
+        ret = sdap_attr_map_index_create(state, map, map_num_attrs,
+                                         &state->map_index);
+        if (ret != EOK) {
+            talloc_zfree(req);
+            return NULL;
+        }
+    }
+
     if (allow_paging) {
         flags |= SDAP_SRCH_FLG_PAGING;
     }
@@ -1905,9 +2040,10 @@ static errno_t sdap_get_and_parse_generic_parse_entry(struct sdap_handle *sh,
     bool disable_range_rtrvl = dp_opt_get_bool(state->opts->basic,
                                                SDAP_DISABLE_RANGE_RETRIEVAL);
 
-    ret = sdap_parse_entry(state, sh, msg,
-                           state->map, state->map_num_attrs,
-                           &attrs, disable_range_rtrvl);
+    ret = sdap_parse_entry_ex(state, sh, msg,
+                              state->map, state->map_num_attrs,
+                              state->map_index,
+                              &attrs, disable_range_rtrvl);
     if (ret != EOK) {
         DEBUG(SSSDBG_MINOR_FAILURE,
               "sdap_parse_entry failed [%d]: %s\n", ret, strerror(ret));
@@ -1925,6 +2061,87 @@ static errno_t sdap_get_and_parse_generic_parse_entry(struct sdap_handle *sh,
     return EOK;
 }
 
+struct tevent_req *
+sdap_get_and_parse_generic_paged_send(TALLOC_CTX *memctx,
+                                      struct tevent_context *ev,
+                                      struct sdap_options *opts,
+                                      struct sdap_handle *sh,
+                                      const char *search_base,
+                                      int scope,
+                                      const char *filter,
+                                      const char **attrs,
+                                      struct sdap_attr_map *map,
+                                      int map_num_attrs,
+                                      int sizelimit,
+                                      int timeout,
+                                      sdap_page_cb page_cb,
+                                      void *page_pvt)
+{
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    struct sdap_get_and_parse_generic_state *state;
+    errno_t ret;
+
+    req = tevent_req_create(memctx, &state,
+                            struct sdap_get_and_parse_generic_state);
+    if (!req) return NULL;
+
+    state->map = map;
+    state->map_num_attrs = map_num_attrs;
+    state->opts = opts;
+    state->page_cb = page_cb;
+    state->page_pvt = page_pvt;
+
+    if (map != NULL) {
+        ret = sdap_attr_map_index_create(state, map, map_num_attrs,
+                                         &state->map_index);
+        if (ret != EOK) {
+            talloc_zfree(req);
+            return NULL;
+        }
+    }
+
+    subreq = sdap_get_generic_ext_send(state, ev, opts, sh, search_base,
+                                       scope, filter, attrs, NULL, NULL,
+                                       sizelimit, timeout,
+                                       sdap_get_and_parse_generic_parse_entry,
+                                       state, SDAP_SRCH_FLG_PAGING);
+    if (!subreq) {
+        talloc_zfree(req);
+        return NULL;
+    }
+    sdap_get_generic_ext_set_page_done_cb(subreq,
+                                          sdap_get_and_parse_generic_page_done,
+                                          state);
+    tevent_req_set_callback(subreq, sdap_get_and_parse_generic_done, req);
+
+    return req;
+}
+
+static errno_t sdap_get_and_parse_generic_page_done(void *pvt)
+{
+    struct sdap_get_and_parse_generic_state *state =
+                talloc_get_type(pvt, struct sdap_get_and_parse_generic_state);
+    errno_t ret;
+
+    if (state->sreply.reply_count == 0) {
+        return EOK;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Handing over a page of %zu entries\n",
+          state->sreply.reply_count);
+
+    ret = state->page_cb(state->sreply.reply, state->sreply.reply_count,
+                         state->page_pvt);
+
+    /* Keep only one page of entries in memory. */
+    talloc_zfree(state->sreply.reply);
+    state->sreply.reply_count = 0;
+    state->sreply.reply_max = 0;
+
+    return ret;
+}
+
 static void sdap_get_and_parse_generic_done(struct tevent_req *subreq)
 {
     struct tevent_req *req = tevent_req_callback_data(subreq,
@@ -2042,6 +2259,7 @@ struct sdap_x_deref_search_state {
     struct sdap_handle *sh;
     struct sdap_op *op;
     struct sdap_attr_map_info *maps;
+    struct sdap_attr_map_index **map_indexes;
     LDAPControl **ctrls;
     struct sdap_options *opts;
 
@@ -2075,6 +2293,13 @@ sdap_x_deref_search_send(TALLOC_CTX *memctx, struct tevent_context *ev,
         talloc_zfree(req);
         return NULL;
     }
+
+    ret = sdap_attr_map_info_index_create(state, maps, num_maps,
+                                          &state->map_indexes);
+    if (ret != EOK) {
+        talloc_zfree(req);
+        return NULL;
+    }
     talloc_set_destructor((TALLOC_CTX *) state->ctrls,
                           sdap_x_deref_search_ctrls_destructor);
 
@@ -2194,8 +2419,8 @@ static errno_t sdap_x_deref_parse_entry(struct sdap_handle *sh,
     }
 
     for (dref = deref_res; dref; dref=dref->next) {
-        ret = sdap_parse_deref(tmp_ctx, state->maps, state->num_maps,
-                               dref, &res);
+        ret = sdap_parse_deref_ex(tmp_ctx, state->maps, state->map_indexes,
+                                  state->num_maps, dref, &res);
         if (ret) {
             DEBUG(SSSDBG_OP_FAILURE, "sdap_parse_deref failed [%d]: %s\n",
                   ret, strerror(ret));
@@ -2463,6 +2688,7 @@ int sdap_sd_search_recv(struct tevent_req *req,
 /* ==Attribute scoped search============================================ */
 struct sdap_asq_search_state {
     struct sdap_attr_map_info *maps;
+    struct sdap_attr_map_index **map_indexes;
     int num_maps;
     LDAPControl **ctrls;
     struct sdap_options *opts;
@@ -2502,6 +2728,13 @@ sdap_asq_search_send(TALLOC_CTX *memctx, struct tevent_context *ev,
         talloc_zfree(req);
         return NULL;
     }
+
+    ret = sdap_attr_map_info_index_create(state, maps, num_maps,
+                                          &state->map_indexes);
+    if (ret != EOK) {
+        talloc_zfree(req);
+        return NULL;
+    }
     talloc_set_destructor((TALLOC_CTX *) state->ctrls,
                           sdap_asq_search_ctrls_destructor);
 
@@ -2650,9 +2883,9 @@ static errno_t sdap_asq_search_parse_entry(struct sdap_handle *sh,
         disable_range_rtrvl = dp_opt_get_bool(state->opts->basic,
                                               SDAP_DISABLE_RANGE_RETRIEVAL);
 
-        ret = sdap_parse_entry(res[mi], sh, msg,
-                               map, num_attrs,
-                               &res[mi]->attrs, disable_range_rtrvl);
+        ret = sdap_parse_entry_ex(res[mi], sh, msg,
+                                  map, num_attrs, state->map_indexes[mi],
+                                  &res[mi]->attrs, disable_range_rtrvl);
         if (ret != EOK) {
             DEBUG(SSSDBG_MINOR_FAILURE,
                   "sdap_parse_entry failed [%d]: %s\n", ret, strerror(ret));
@@ -2962,3 +3195,572 @@ bool sdap_has_deref_support(struct sdap_handle *sh, struct sdap_options *opts)
 {
     return sdap_has_deref_support_ex(sh, opts, false);
 }
+
+/* ==Content Synchronization refresh (RFC 4533)========================== */
+struct sdap_sync_refresh_state {
+    struct sdap_options *opts;
+    struct sdap_handle *sh;
+    struct sdap_attr_map *map;
+    int map_num_attrs;
+    struct sdap_attr_map_index *map_index;
+
+    struct sdap_op *op;
+
+    struct sdap_reply sreply;
+    char **deleted;
+    size_t num_deleted;
+
+    uint8_t *cookie;
+    size_t cookie_len;
+};
+
+static errno_t sdap_sync_create_control(struct sdap_handle *sh,
+                                        const uint8_t *cookie,
+                                        size_t cookie_len,
+                                        LDAPControl **ctrl);
+static void sdap_sync_refresh_done(struct sdap_op *op,
+                                   struct sdap_msg *reply,
+                                   int error, void *pvt);
+
+struct tevent_req *
+sdap_sync_refresh_send(TALLOC_CTX *memctx,
+                       struct tevent_context *ev,
+                       struct sdap_options *opts,
+                       struct sdap_handle *sh,
+                       const char *search_base,
+                       int scope,
+                       const char *filter,
+                       const char **attrs,
+                       struct sdap_attr_map *map,
+                       int map_num_attrs,
+                       const uint8_t *cookie,
+                       size_t cookie_len,
+                       int timeout)
+{
+    struct tevent_req *req;
+    struct sdap_sync_refresh_state *state;
+    LDAPControl *ctrls[2] = { NULL, NULL };
+    int msgid;
+    int lret;
+    errno_t ret;
+
+    req = tevent_req_create(memctx, &state, struct sdap_sync_refresh_state);
+    if (req == NULL) return NULL;
+
+    state->opts = opts;
+    state->sh = sh;
+    state->map = map;
+    state->map_num_attrs = map_num_attrs;
+
+    if (sh == NULL || sh->ldap == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Trying LDAP search while not connected.\n");
+        ret = EIO;
+        goto done;
+    }
+
+    ret = sdap_attr_map_index_create(state, map, map_num_attrs,
+                                     &state->map_index);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sdap_sync_create_control(sh, cookie, cookie_len, &ctrls[0]);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Content synchronization refresh of [%s] with [%s], %s cookie\n",
+          search_base, filter, cookie == NULL ? "without" : "with");
+
+    lret = ldap_search_ext(sh->ldap, search_base, scope, filter,
+                           discard_const(attrs), 0, ctrls, NULL, NULL, 0,
+                           &msgid);
+    ldap_control_free(ctrls[0]);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "ldap_search_ext failed: %s\n", sss_ldap_err2string(lret));
+        ret = lret == LDAP_SERVER_DOWN ? ETIMEDOUT : EIO;
+        goto done;
+    }
+    DEBUG(SSSDBG_TRACE_INTERNAL, "ldap_search_ext called, msgid = %d\n", msgid);
+
+    ret = sdap_op_add(state, ev, sh, msgid, sdap_sync_refresh_done, req,
+                      timeout, &state->op);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to set up operation!\n");
+        goto done;
+    }
+
+done:
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static errno_t sdap_sync_create_control(struct sdap_handle *sh,
+                                        const uint8_t *cookie,
+                                        size_t cookie_len,
+                                        LDAPControl **ctrl)
+{
+    BerElement *ber;
+    struct berval *value = NULL;
+    struct berval bv_cookie;
+    int lret;
+
+    ber = ber_alloc_t(LBER_USE_DER);
+    if (ber == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ber_alloc_t failed.\n");
+        return ENOMEM;
+    }
+
+    if (cookie != NULL) {
+        bv_cookie.bv_val = discard_const(cookie);
+        bv_cookie.bv_len = cookie_len;
+        lret = ber_printf(ber, "{eO}", (ber_int_t)LDAP_SYNC_REFRESH_ONLY,
+                          &bv_cookie);
+    } else {
+        lret = ber_printf(ber, "{e}", (ber_int_t)LDAP_SYNC_REFRESH_ONLY);
+    }
+    if (lret == -1) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ber_printf failed.\n");
+        ber_free(ber, 1);
+        return EIO;
+    }
+
+    lret = ber_flatten(ber, &value);
+    ber_free(ber, 1);
+    if (lret == -1) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ber_flatten failed.\n");
+        return EIO;
+    }
+
+    lret = sdap_control_create(sh, LDAP_CONTROL_SYNC, 1, value, 1, ctrl);
+    ber_bvfree(value);
+    if (lret != LDAP_SUCCESS) {
+        return lret == LDAP_NOT_SUPPORTED ? ENOTSUP : EIO;
+    }
+
+    return EOK;
+}
+
+static errno_t sdap_sync_set_cookie(struct sdap_sync_refresh_state *state,
+                                    struct berval *cookie)
+{
+    uint8_t *dup;
+
+    if (cookie->bv_val == NULL || cookie->bv_len == 0) {
+        return EOK;
+    }
+
+    dup = talloc_memdup(state, cookie->bv_val, cookie->bv_len);
+    if (dup == NULL) {
+        return ENOMEM;
+    }
+
+    talloc_free(state->cookie);
+    state->cookie = dup;
+    state->cookie_len = cookie->bv_len;
+
+    return EOK;
+}
+
+static char *sdap_sync_uuid_to_str(TALLOC_CTX *mem_ctx, struct berval *uuid)
+{
+    const uint8_t *u = (const uint8_t *)uuid->bv_val;
+
+    if (uuid->bv_len != 16) {
+        return NULL;
+    }
+
+    return talloc_asprintf(mem_ctx,
+                           "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-"
+                           "%02x%02x%02x%02x%02x%02x",
+                           u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7],
+                           u[8], u[9], u[10], u[11], u[12], u[13], u[14],
+                           u[15]);
+}
+
+static errno_t sdap_sync_add_deleted(struct sdap_sync_refresh_state *state,
+                                     struct berval *uuid)
+{
+    char **deleted;
+    char *str;
+
+    if (uuid->bv_len != 16) {
+        DEBUG(SSSDBG_OP_FAILURE, "Invalid syncUUID length %zu\n",
+              (size_t)uuid->bv_len);
+        return EINVAL;
+    }
+
+    str = sdap_sync_uuid_to_str(state, uuid);
+    if (str == NULL) {
+        return ENOMEM;
+    }
+
+    deleted = talloc_realloc(state, state->deleted, char *,
+                             state->num_deleted + 2);
+    if (deleted == NULL) {
+        talloc_free(str);
+        return ENOMEM;
+    }
+
+    deleted[state->num_deleted] = talloc_steal(deleted, str);
+    state->num_deleted++;
+    deleted[state->num_deleted] = NULL;
+    state->deleted = deleted;
+
+    return EOK;
+}
+
+static errno_t sdap_sync_parse_entry(struct sdap_sync_refresh_state *state,
+                                     struct sdap_msg *msg)
+{
+    LDAPControl **ctrls = NULL;
+    LDAPControl *state_ctrl;
+    BerElement *ber = NULL;
+    struct berval uuid;
+    struct sysdb_attrs *attrs;
+    ber_int_t entry_state;
+    char *uuid_str;
+    bool disable_range_rtrvl;
+    errno_t ret;
+    int lret;
+
+    lret = ldap_get_entry_controls(state->sh->ldap, msg->msg, &ctrls);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldap_get_entry_controls failed\n");
+        return EIO;
+    }
+
+    state_ctrl = ldap_control_find(LDAP_CONTROL_SYNC_STATE, ctrls, NULL);
+    if (state_ctrl == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Entry without Sync State Control\n");
+        ret = EIO;
+        goto done;
+    }
+
+    ber = ber_init(&state_ctrl->ldctl_value);
+    if (ber == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (ber_scanf(ber, "{em", &entry_state, &uuid) == LBER_ERROR) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot parse Sync State Control\n");
+        ret = EIO;
+        goto done;
+    }
+
+    switch (entry_state) {
+    case LDAP_SYNC_PRESENT:
+        /* Unchanged entry reported in the present phase, entries that were
+         * not reported are removed by the regular cache cleanup. */
+        ret = EOK;
+        break;
+    case LDAP_SYNC_ADD:
+    case LDAP_SYNC_MODIFY:
+        disable_range_rtrvl = dp_opt_get_bool(state->opts->basic,
+                                              SDAP_DISABLE_RANGE_RETRIEVAL);
+        ret = sdap_parse_entry_ex(state, state->sh, msg,
+                                  state->map, state->map_num_attrs,
+                                  state->map_index,
+                                  &attrs, disable_range_rtrvl);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "sdap_parse_entry failed [%d]: %s\n", ret, strerror(ret));
+            goto done;
+        }
+
+        uuid_str = sdap_sync_uuid_to_str(attrs, &uuid);
+        if (uuid_str == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "Invalid syncUUID\n");
+            talloc_free(attrs);
+            ret = EINVAL;
+            goto done;
+        }
+
+        ret = sysdb_attrs_add_string(attrs, SYSDB_SYNC_UUID, uuid_str);
+        if (ret != EOK) {
+            talloc_free(attrs);
+            goto done;
+        }
+
+        ret = add_to_reply(state, &state->sreply, attrs);
+        if (ret != EOK) {
+            talloc_free(attrs);
+            goto done;
+        }
+        break;
+    case LDAP_SYNC_DELETE:
+        ret = sdap_sync_add_deleted(state, &uuid);
+        break;
+    default:
+        DEBUG(SSSDBG_OP_FAILURE, "Unknown sync state %d\n", entry_state);
+        ret = EIO;
+        break;
+    }
+
+done:
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ldap_controls_free(ctrls);
+    return ret;
+}
+
+static errno_t sdap_sync_parse_info(struct sdap_sync_refresh_state *state,
+                                    struct sdap_msg *msg)
+{
+    char *oid = NULL;
+    struct berval *data = NULL;
+    BerElement *ber = NULL;
+    BerVarray uuids = NULL;
+    struct berval cookie;
+    ber_tag_t tag;
+    ber_len_t len;
+    ber_int_t refresh_deletes = 0;
+    errno_t ret;
+    int lret;
+    int i;
+
+    lret = ldap_parse_intermediate(state->sh->ldap, msg->msg, &oid, &data,
+                                   NULL, 0);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldap_parse_intermediate failed\n");
+        return EIO;
+    }
+
+    if (oid == NULL || strcmp(oid, LDAP_SYNC_INFO) != 0 || data == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Ignoring unexpected intermediate "
+              "response [%s]\n", oid == NULL ? "no oid" : oid);
+        ret = EOK;
+        goto done;
+    }
+
+    ber = ber_init(data);
+    if (ber == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    cookie.bv_val = NULL;
+    cookie.bv_len = 0;
+
+    tag = ber_peek_tag(ber, &len);
+    switch (tag) {
+    case LDAP_TAG_SYNC_NEW_COOKIE:
+        if (ber_scanf(ber, "tm", &tag, &cookie) == LBER_ERROR) {
+            ret = EIO;
+            goto done;
+        }
+        break;
+    case LDAP_TAG_SYNC_REFRESH_DELETE:
+    case LDAP_TAG_SYNC_REFRESH_PRESENT:
+        if (ber_scanf(ber, "t{", &tag) == LBER_ERROR) {
+            ret = EIO;
+            goto done;
+        }
+        if (ber_peek_tag(ber, &len) == LDAP_TAG_SYNC_COOKIE
+                && ber_scanf(ber, "m", &cookie) == LBER_ERROR) {
+            ret = EIO;
+            goto done;
+        }
+        break;
+    case LDAP_TAG_SYNC_ID_SET:
+        if (ber_scanf(ber, "t{", &tag) == LBER_ERROR) {
+            ret = EIO;
+            goto done;
+        }
+        if (ber_peek_tag(ber, &len) == LDAP_TAG_SYNC_COOKIE
+                && ber_scanf(ber, "m", &cookie) == LBER_ERROR) {
+            ret = EIO;
+            goto done;
+        }
+        if (ber_peek_tag(ber, &len) == LDAP_TAG_REFRESHDELETES
+                && ber_scanf(ber, "b", &refresh_deletes) == LBER_ERROR) {
+            ret = EIO;
+            goto done;
+        }
+        if (ber_scanf(ber, "[W]}", &uuids) == LBER_ERROR) {
+            ret = EIO;
+            goto done;
+        }
+
+        /* Present UUIDs are not interesting, see the present phase in
+         * sdap_sync_parse_entry(). */
+        if (refresh_deletes && uuids != NULL) {
+            for (i = 0; uuids[i].bv_val != NULL; i++) {
+                ret = sdap_sync_add_deleted(state, &uuids[i]);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+        }
+        break;
+    default:
+        DEBUG(SSSDBG_OP_FAILURE, "Unknown Sync Info Message [%lx]\n",
+              (unsigned long)tag);
+        ret = EIO;
+        goto done;
+    }
+
+    ret = sdap_sync_set_cookie(state, &cookie);
+
+done:
+    ber_bvarray_free(uuids);
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ldap_memfree(oid);
+    ber_bvfree(data);
+    return ret;
+}
+
+static errno_t sdap_sync_parse_result(struct sdap_sync_refresh_state *state,
+                                      struct sdap_msg *msg)
+{
+    LDAPControl **ctrls = NULL;
+    LDAPControl *done_ctrl;
+    BerElement *ber = NULL;
+    struct berval cookie;
+    char *errmsg = NULL;
+    ber_len_t len;
+    int result;
+    errno_t ret;
+    int lret;
+
+    lret = ldap_parse_result(state->sh->ldap, msg->msg, &result, NULL,
+                             &errmsg, NULL, &ctrls, 0);
+    if (lret != LDAP_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "ldap_parse_result failed (%d)\n", state->op->msgid);
+        return EIO;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Search result: %s(%d), %s\n",
+          sss_ldap_err2string(result), result,
+          errmsg ? errmsg : "no errmsg set");
+
+    if (result == LDAP_SYNC_REFRESH_REQUIRED) {
+        /* The cookie is too old, the caller must start over. */
+        ret = ESTALE;
+        goto done;
+    } else if (result != LDAP_SUCCESS) {
+        ret = EIO;
+        goto done;
+    }
+
+    done_ctrl = ldap_control_find(LDAP_CONTROL_SYNC_DONE, ctrls, NULL);
+    if (done_ctrl == NULL) {
+        ret = EOK;
+        goto done;
+    }
+
+    ber = ber_init(&done_ctrl->ldctl_value);
+    if (ber == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    cookie.bv_val = NULL;
+    cookie.bv_len = 0;
+
+    if (ber_scanf(ber, "{") == LBER_ERROR) {
+        ret = EIO;
+        goto done;
+    }
+    if (ber_peek_tag(ber, &len) == LDAP_TAG_SYNC_COOKIE
+            && ber_scanf(ber, "m", &cookie) == LBER_ERROR) {
+        ret = EIO;
+        goto done;
+    }
+
+    ret = sdap_sync_set_cookie(state, &cookie);
+
+done:
+    if (ber != NULL) {
+        ber_free(ber, 1);
+    }
+    ldap_controls_free(ctrls);
+    ldap_memfree(errmsg);
+    return ret;
+}
+
+static void sdap_sync_refresh_done(struct sdap_op *op,
+                                   struct sdap_msg *reply,
+                                   int error, void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct sdap_sync_refresh_state *state = tevent_req_data(req,
+                                            struct sdap_sync_refresh_state);
+    errno_t ret;
+
+    if (error) {
+        tevent_req_error(req, error);
+        return;
+    }
+
+    switch (ldap_msgtype(reply->msg)) {
+    case LDAP_RES_SEARCH_ENTRY:
+        ret = sdap_sync_parse_entry(state, reply);
+        break;
+    case LDAP_RES_INTERMEDIATE:
+        ret = sdap_sync_parse_info(state, reply);
+        break;
+    case LDAP_RES_SEARCH_REFERENCE:
+        /* References are not followed during enumeration. */
+        ret = EOK;
+        break;
+    case LDAP_RES_SEARCH_RESULT:
+        ret = sdap_sync_parse_result(state, reply);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Content synchronization returned %zu "
+              "changed and %zu deleted entries\n",
+              state->sreply.reply_count, state->num_deleted);
+        tevent_req_done(req);
+        return;
+    default:
+        ret = EIO;
+        break;
+    }
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    sdap_unlock_next_reply(state->op);
+}
+
+errno_t sdap_sync_refresh_recv(struct tevent_req *req,
+                               TALLOC_CTX *mem_ctx,
+                               size_t *_reply_count,
+                               struct sysdb_attrs ***_reply,
+                               size_t *_num_deleted,
+                               char ***_deleted,
+                               uint8_t **_cookie,
+                               size_t *_cookie_len)
+{
+    struct sdap_sync_refresh_state *state = tevent_req_data(req,
+                                            struct sdap_sync_refresh_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_reply_count = state->sreply.reply_count;
+    *_reply = talloc_steal(mem_ctx, state->sreply.reply);
+    *_num_deleted = state->num_deleted;
+    *_deleted = talloc_steal(mem_ctx, state->deleted);
+    *_cookie = talloc_steal(mem_ctx, state->cookie);
+    *_cookie_len = state->cookie_len;
+
+    return EOK;
+}
@@ -38,7 +38,8 @@ struct tevent_req *sdap_connect_send(TALLOC_CTX *memctx,
                                      struct sdap_options *opts,
                                      const char *uri,
                                      struct sockaddr_storage *sockaddr,
-                                     bool use_start_tls);
+                                     bool use_start_tls,
+                                     struct fo_server *srv);
 int sdap_connect_recv(struct tevent_req *req,
                       TALLOC_CTX *memctx,
                       struct sdap_handle **sh);
@@ -238,6 +239,31 @@ int sdap_get_and_parse_generic_recv(struct tevent_req *req,
                                     size_t *reply_count,
                                     struct sysdb_attrs ***reply);
 
+/* Receives the entries of one page of a paged search. The entries are
+ * freed when the callback returns. */
+typedef errno_t (*sdap_page_cb)(struct sysdb_attrs **reply,
+                                size_t reply_count,
+                                void *pvt);
+
+/* Paged search that hands over the entries page by page while the next
+ * page is already requested from the server. The recv function returns
+ * no entries. */
+struct tevent_req *
+sdap_get_and_parse_generic_paged_send(TALLOC_CTX *memctx,
+                                      struct tevent_context *ev,
+                                      struct sdap_options *opts,
+                                      struct sdap_handle *sh,
+                                      const char *search_base,
+                                      int scope,
+                                      const char *filter,
+                                      const char **attrs,
+                                      struct sdap_attr_map *map,
+                                      int map_num_attrs,
+                                      int sizelimit,
+                                      int timeout,
+                                      sdap_page_cb page_cb,
+                                      void *page_pvt);
+
 struct tevent_req *sdap_get_generic_send(TALLOC_CTX *memctx,
                                          struct tevent_context *ev,
                                          struct sdap_options *opts,
@@ -315,6 +341,34 @@ int sdap_sd_search_recv(struct tevent_req *req,
                         size_t *_ref_count,
                         char ***_refs);
 
+/* Content synchronization (RFC 4533) in refreshOnly mode. Without a cookie
+ * all entries are returned, with a cookie only added or modified entries
+ * and the syncUUIDs of deleted ones. Changed entries carry their syncUUID
+ * in SYSDB_SYNC_UUID. Fails with ESTALE if the server wants a full refresh
+ * because the cookie is no longer valid. */
+struct tevent_req *
+sdap_sync_refresh_send(TALLOC_CTX *memctx,
+                       struct tevent_context *ev,
+                       struct sdap_options *opts,
+                       struct sdap_handle *sh,
+                       const char *search_base,
+                       int scope,
+                       const char *filter,
+                       const char **attrs,
+                       struct sdap_attr_map *map,
+                       int map_num_attrs,
+                       const uint8_t *cookie,
+                       size_t cookie_len,
+                       int timeout);
+errno_t sdap_sync_refresh_recv(struct tevent_req *req,
+                               TALLOC_CTX *mem_ctx,
+                               size_t *_reply_count,
+                               struct sysdb_attrs ***_reply,
+                               size_t *_num_deleted,
+                               char ***_deleted,
+                               uint8_t **_cookie,
+                               size_t *_cookie_len);
+
 errno_t
 sdap_attrs_add_ldap_attr(struct sysdb_attrs *ldap_attrs,
                          const char *attr_name,
@@ -24,6 +24,17 @@
 #ifndef SDAP_ASYNC_AD_H_
 #define SDAP_ASYNC_AD_H_
 
+/* Returns the DNs of the groups the SIDs map to algorithmically, groups that
+ * are not cached yet are added as incomplete groups. */
+errno_t
+sdap_ad_get_group_dns_with_idmapping(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *user_dom,
+                                     struct sdap_idmap_ctx *idmap_ctx,
+                                     size_t num_sids,
+                                     char **sids,
+                                     size_t *_num_groups,
+                                     char ***_groups);
+
 errno_t sdap_ad_save_group_membership_with_idmapping(const char *username,
                                                struct sdap_options *opts,
                                                struct sss_domain_info *user_dom,
@@ -182,6 +182,73 @@ del_autofs_entries(struct sss_domain_info *dom,
     return EOK;
 }
 
+/* Extends the expiration of the cached entries that are still present in
+ * LDAP. Entries which are still valid are left untouched. */
+static errno_t
+refresh_autofs_entries(struct sss_domain_info *dom,
+                       struct ldb_message **entries,
+                       size_t count,
+                       hash_table_t *entry_hash)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs *attrs;
+    hash_key_t key;
+    time_t now;
+    size_t refreshed = 0;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    attrs = sysdb_new_attrs(tmp_ctx);
+    if (attrs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    now = time(NULL);
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_CACHE_EXPIRE,
+                                 dom->autofsmap_timeout ?
+                                 now + dom->autofsmap_timeout : 0);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        key.type = HASH_KEY_STRING;
+        key.str = discard_const(ldb_dn_get_linearized(entries[i]->dn));
+        if (key.str == NULL || !hash_has_key(entry_hash, &key)) {
+            /* new or deleted entry */
+            continue;
+        }
+
+        if (ldb_msg_find_attr_as_uint64(entries[i], SYSDB_CACHE_EXPIRE, 0)
+                > now) {
+            continue;
+        }
+
+        ret = sysdb_set_entry_attr(dom->sysdb, entries[i]->dn, attrs,
+                                   SYSDB_MOD_REP);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cannot refresh entry [%s]\n",
+                  key.str);
+            goto done;
+        }
+        refreshed++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Refreshed %zu unchanged autofs entries\n",
+          refreshed);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 static errno_t
 save_autofs_map(struct sss_domain_info *dom,
                 struct sdap_options *opts,
@@ -790,7 +857,7 @@ sdap_autofs_setautomntent_save(struct tevent_req *req)
     char **del_entries;
     size_t i, j;
 
-    hash_table_t *entry_hash;
+    hash_table_t *entry_hash = NULL;
     hash_key_t hkey;
     hash_value_t value;
     int hret;
@@ -814,7 +881,7 @@ sdap_autofs_setautomntent_save(struct tevent_req *req)
             goto done;
         }
 
-        ret = sss_hash_create(state, 32, &entry_hash);
+        ret = sss_hash_create(tmp_ctx, state->entries_count, &entry_hash);
         if (ret) {
             goto done;
         }
@@ -868,7 +935,7 @@ sdap_autofs_setautomntent_save(struct tevent_req *req)
         /* No map members for this map in sysdb currently */
         sysdb_entrylist = NULL;
     } else {
-        sysdb_entrylist = talloc_array(state, char *, count+1);
+        sysdb_entrylist = talloc_array(tmp_ctx, char *, count+1);
         if (!sysdb_entrylist) {
             ret = ENOMEM;
             goto done;
@@ -935,6 +1002,17 @@ sdap_autofs_setautomntent_save(struct tevent_req *req)
         }
     }
 
+    /* Entries that did not change are only marked as valid again */
+    if (entry_hash != NULL && count > 0) {
+        ret = refresh_autofs_entries(state->dom, entries, count, entry_hash);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot refresh autofs entries [%d]: %s\n",
+                  ret, strerror(ret));
+            goto done;
+        }
+    }
+
 
     ret = sysdb_transaction_commit(state->sysdb);
     if (ret != EOK) {
@@ -23,6 +23,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sasl/sasl.h>
+#ifdef HAVE_LIBCRYPTO
+#include <openssl/ssl.h>
+#endif
 #include "util/util.h"
 #include "util/sss_krb5.h"
 #include "util/sss_ldap.h"
@@ -30,6 +33,158 @@
 #include "providers/ldap/sdap_async_private.h"
 #include "providers/ldap/ldap_common.h"
 
+/* ==TLS-Session-Resumption============================================== */
+
+/* Sessions can only be resumed if libldap uses OpenSSL as well, the
+ * session handles of the other TLS libraries are not supported. */
+#if defined(HAVE_LIBCRYPTO) && defined(LDAP_OPT_X_TLS_CONNECT_CB) \
+        && defined(LDAP_OPT_X_TLS_PACKAGE) && defined(LDAP_OPT_X_TLS_SSL_CTX)
+#define SDAP_TLS_SESSION_RESUMPTION 1
+#endif
+
+/* Last TLS session negotiated with a server, kept in its fail over server
+ * entry. It lives as long as the server so it can be safely passed to
+ * libldap while a connection is being established. */
+struct sdap_tls_session {
+#ifdef SDAP_TLS_SESSION_RESUMPTION
+    SSL_SESSION *session;
+#endif
+};
+
+#ifdef SDAP_TLS_SESSION_RESUMPTION
+static bool sdap_tls_session_supported(void)
+{
+    static int supported = -1;
+    char *package = NULL;
+    int lret;
+
+    if (supported != -1) {
+        return supported;
+    }
+
+    lret = ldap_get_option(NULL, LDAP_OPT_X_TLS_PACKAGE, &package);
+    if (lret != LDAP_OPT_SUCCESS || package == NULL) {
+        supported = false;
+    } else {
+        supported = (strcmp(package, "OpenSSL") == 0);
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "libldap uses %s, TLS sessions will %sbe "
+          "resumed\n", package == NULL ? "unknown TLS library" : package,
+          supported ? "" : "not ");
+
+    ldap_memfree(package);
+    return supported;
+}
+
+static int sdap_tls_session_destructor(struct sdap_tls_session *tls_session)
+{
+    if (tls_session->session != NULL) {
+        SSL_SESSION_free(tls_session->session);
+        tls_session->session = NULL;
+    }
+
+    return 0;
+}
+
+static struct sdap_tls_session *sdap_tls_session_get(struct fo_server *srv)
+{
+    struct sdap_tls_session *tls_session;
+
+    if (srv == NULL || !sdap_tls_session_supported()) {
+        return NULL;
+    }
+
+    tls_session = fo_get_server_tls_session(srv);
+    if (tls_session != NULL) {
+        return tls_session;
+    }
+
+    tls_session = talloc_zero(NULL, struct sdap_tls_session);
+    if (tls_session == NULL) {
+        return NULL;
+    }
+
+    talloc_set_destructor(tls_session, sdap_tls_session_destructor);
+    fo_set_server_tls_session(srv, tls_session);
+
+    return tls_session;
+}
+
+static int sdap_tls_session_connect_cb(LDAP *ld, void *ssl, void *ctx,
+                                       void *arg)
+{
+    struct sdap_tls_session *tls_session = arg;
+
+    if (tls_session == NULL || tls_session->session == NULL) {
+        return 0;
+    }
+
+    if (SSL_set_session(ssl, tls_session->session) != 1) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to offer cached TLS session\n");
+    }
+
+    return 0;
+}
+
+/* Remember the session of an established connection. This is done once
+ * the connection was used, TLS 1.3 servers send the session tickets only
+ * after the handshake. */
+static void sdap_tls_session_save(struct fo_server *srv,
+                                  struct sdap_handle *sh)
+{
+    struct sdap_tls_session *tls_session;
+    SSL_SESSION *session;
+    SSL *ssl = NULL;
+    int lret;
+
+    tls_session = sdap_tls_session_get(srv);
+    if (tls_session == NULL || sh == NULL || sh->ldap == NULL) {
+        return;
+    }
+
+    lret = ldap_get_option(sh->ldap, LDAP_OPT_X_TLS_SSL_CTX, &ssl);
+    if (lret != LDAP_OPT_SUCCESS || ssl == NULL) {
+        /* Not a TLS connection */
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_ALL, "TLS session to %s was %s\n",
+          fo_get_server_str_name(srv),
+          SSL_session_reused(ssl) ? "resumed" : "negotiated");
+
+    session = SSL_get1_session(ssl);
+    if (session == NULL) {
+        return;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    if (!SSL_SESSION_is_resumable(session)) {
+        SSL_SESSION_free(session);
+        return;
+    }
+#endif
+
+    if (tls_session->session != NULL) {
+        SSL_SESSION_free(tls_session->session);
+    }
+    tls_session->session = session;
+}
+#else
+static struct sdap_tls_session *sdap_tls_session_get(struct fo_server *srv)
+{
+    return NULL;
+}
+
+#define sdap_tls_session_connect_cb NULL
+
+static void sdap_tls_session_save(struct fo_server *srv,
+                                  struct sdap_handle *sh)
+{
+    return;
+}
+#endif
+
 /* ==Connect-to-LDAP-Server=============================================== */
 
 struct sdap_rebind_proc_params {
@@ -64,11 +219,13 @@ struct tevent_req *sdap_connect_send(TALLOC_CTX *memctx,
                                      struct sdap_options *opts,
                                      const char *uri,
                                      struct sockaddr_storage *sockaddr,
-                                     bool use_start_tls)
+                                     bool use_start_tls,
+                                     struct fo_server *srv)
 {
     struct tevent_req *req;
     struct tevent_req *subreq;
     struct sdap_connect_state *state;
+    struct sdap_tls_session *tls_session;
     int ret;
     int timeout;
 
@@ -108,9 +265,14 @@ struct tevent_req *sdap_connect_send(TALLOC_CTX *memctx,
 
     timeout = dp_opt_get_int(state->opts->basic, SDAP_NETWORK_TIMEOUT);
 
+    tls_session = sdap_tls_session_get(srv);
+
     subreq = sss_ldap_init_send(state, ev, state->uri, sockaddr,
                                 sizeof(struct sockaddr_storage),
-                                timeout);
+                                timeout,
+                                tls_session == NULL ? NULL
+                                    : sdap_tls_session_connect_cb,
+                                tls_session);
     if (subreq == NULL) {
         ret = ENOMEM;
         DEBUG(SSSDBG_CRIT_FAILURE, "sss_ldap_init_send failed.\n");
@@ -558,7 +720,8 @@ static void sdap_connect_host_resolv_done(struct tevent_req *subreq)
     DEBUG(SSSDBG_TRACE_FUNC, "Connecting to %s\n", state->uri);
 
     subreq = sdap_connect_send(state, state->ev, state->opts,
-                               state->uri, sockaddr, state->use_start_tls);
+                               state->uri, sockaddr, state->use_start_tls,
+                               NULL);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto done;
@@ -1093,6 +1256,7 @@ struct sdap_kinit_state {
     struct be_ctx *be;
 
     struct fo_server *kdc_srv;
+    char *ccname;
     time_t expire_time;
 };
 
@@ -1258,6 +1422,7 @@ static void sdap_kinit_done(struct tevent_req *subreq)
             return;
         }
 
+        state->ccname = talloc_steal(state, ccname);
         state->expire_time = expire_time;
         tevent_req_done(req);
         return;
@@ -1280,6 +1445,8 @@ static void sdap_kinit_done(struct tevent_req *subreq)
 }
 
 static errno_t sdap_kinit_recv(struct tevent_req *req,
+                               TALLOC_CTX *mem_ctx,
+                               char **ccname,
                                time_t *expire_time)
 {
     struct sdap_kinit_state *state = tevent_req_data(req,
@@ -1298,6 +1465,9 @@ static errno_t sdap_kinit_recv(struct tevent_req *req,
         }
     }
 
+    if (ccname != NULL) {
+        *ccname = talloc_steal(mem_ctx, state->ccname);
+    }
     *expire_time = state->expire_time;
     return EOK;
 }
@@ -1457,7 +1627,6 @@ static void sdap_cli_rootdse_step(struct tevent_req *req);
 static void sdap_cli_rootdse_done(struct tevent_req *subreq);
 static errno_t sdap_cli_use_rootdse(struct sdap_cli_connect_state *state);
 static void sdap_cli_kinit_step(struct tevent_req *req);
-static void sdap_cli_kinit_done(struct tevent_req *subreq);
 static void sdap_cli_auth_step(struct tevent_req *req);
 static void sdap_cli_auth_done(struct tevent_req *subreq);
 static errno_t sdap_cli_auth_reconnect(struct tevent_req *subreq);
@@ -1580,7 +1749,7 @@ static void sdap_cli_resolve_done(struct tevent_req *subreq)
     subreq = sdap_connect_send(state, state->ev, state->opts,
                                state->service->uri,
                                state->service->sockaddr,
-                               state->use_tls);
+                               state->use_tls, state->srv);
     if (!subreq) {
         tevent_req_error(req, ENOMEM);
         return;
@@ -1758,45 +1927,239 @@ static errno_t sdap_cli_use_rootdse(struct sdap_cli_connect_state *state)
     return EOK;
 }
 
+/* The TGT obtained by ldap_child is shared by all connections of the
+ * service. It is reused until three quarters of its lifetime have passed
+ * and renewed in the background at that time, so new connections neither
+ * wait for nor fork another ldap_child. */
+struct sdap_kinit_waiter {
+    struct sdap_kinit_waiter *prev;
+    struct sdap_kinit_waiter *next;
+
+    struct sdap_kinit_cache *cache;
+    struct tevent_req *req;
+};
+
+struct sdap_kinit_cache {
+    struct tevent_context *ev;
+    struct be_ctx *be;
+    struct sdap_options *opts;
+    struct sdap_service *service;
+
+    char *ccname;
+    time_t expire_time;
+    time_t renew_time;
+
+    struct tevent_req *kinit_req;
+    struct sdap_kinit_waiter *waiters;
+    struct tevent_timer *renew_timer;
+};
+
+static void sdap_cli_kinit_finish(struct tevent_req *req,
+                                  errno_t ret,
+                                  time_t expire_time);
+static void sdap_kinit_cache_done(struct tevent_req *subreq);
+
+static int sdap_kinit_cache_destructor(struct sdap_kinit_cache *cache)
+{
+    struct sdap_kinit_waiter *waiter;
+
+    while ((waiter = cache->waiters) != NULL) {
+        DLIST_REMOVE(cache->waiters, waiter);
+        talloc_set_destructor(waiter, NULL);
+    }
+
+    return 0;
+}
+
+static struct sdap_kinit_cache *
+sdap_kinit_cache_get(struct sdap_cli_connect_state *state)
+{
+    struct sdap_kinit_cache *cache;
+
+    if (state->service->kinit_cache != NULL) {
+        return state->service->kinit_cache;
+    }
+
+    cache = talloc_zero(state->service, struct sdap_kinit_cache);
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->ev = state->ev;
+    cache->be = state->be;
+    cache->opts = state->opts;
+    cache->service = state->service;
+    talloc_set_destructor(cache, sdap_kinit_cache_destructor);
+
+    state->service->kinit_cache = cache;
+    return cache;
+}
+
+static errno_t sdap_kinit_cache_start(struct sdap_kinit_cache *cache)
+{
+    struct dp_option *basic = cache->opts->basic;
+
+    if (cache->kinit_req != NULL) {
+        return EOK;
+    }
+
+    cache->kinit_req = sdap_kinit_send(cache, cache->ev,
+                                       cache->be,
+                                       NULL,
+                                       cache->service->kinit_service_name,
+                                       dp_opt_get_int(basic, SDAP_OPT_TIMEOUT),
+                                       dp_opt_get_string(basic, SDAP_KRB5_KEYTAB),
+                                       dp_opt_get_string(basic, SDAP_SASL_AUTHID),
+                                       sdap_gssapi_realm(basic),
+                                       dp_opt_get_bool(basic,
+                                                       SDAP_KRB5_CANONICALIZE),
+                                       dp_opt_get_int(basic,
+                                                      SDAP_KRB5_TICKET_LIFETIME));
+    if (cache->kinit_req == NULL) {
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(cache->kinit_req, sdap_kinit_cache_done, cache);
+    return EOK;
+}
+
+static void sdap_kinit_cache_renew_handler(struct tevent_context *ev,
+                                           struct tevent_timer *te,
+                                           struct timeval current_time,
+                                           void *pvt)
+{
+    struct sdap_kinit_cache *cache;
+    errno_t ret;
+
+    cache = talloc_get_type(pvt, struct sdap_kinit_cache);
+    cache->renew_timer = NULL;
+
+    if (be_is_offline(cache->be)) {
+        /* The next connection will request a new TGT if needed */
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Renewing TGT for service %s\n",
+          cache->service->name);
+
+    ret = sdap_kinit_cache_start(cache);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to renew TGT [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
+
+static void sdap_kinit_cache_done(struct tevent_req *subreq)
+{
+    struct sdap_kinit_cache *cache;
+    struct sdap_kinit_waiter *waiter;
+    struct tevent_req *req;
+    char *ccname = NULL;
+    time_t expire_time = 0;
+    time_t now;
+    errno_t ret;
+
+    cache = tevent_req_callback_data(subreq, struct sdap_kinit_cache);
+
+    ret = sdap_kinit_recv(subreq, cache, &ccname, &expire_time);
+    talloc_zfree(subreq);
+    cache->kinit_req = NULL;
+
+    now = time(NULL);
+    if (ret == EOK && expire_time > now) {
+        talloc_free(cache->ccname);
+        cache->ccname = ccname;
+        cache->expire_time = expire_time;
+        cache->renew_time = now + (expire_time - now) * 3 / 4;
+
+        talloc_zfree(cache->renew_timer);
+        cache->renew_timer = tevent_add_timer(cache->ev, cache,
+                                   tevent_timeval_set(cache->renew_time, 0),
+                                   sdap_kinit_cache_renew_handler, cache);
+        if (cache->renew_timer == NULL) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to schedule TGT renewal, it will be requested "
+                  "again by the next connection\n");
+        } else {
+            DEBUG(SSSDBG_TRACE_FUNC, "TGT will be renewed in %ld seconds\n",
+                  (long)(cache->renew_time - now));
+        }
+    } else {
+        talloc_free(ccname);
+    }
+
+    while ((waiter = cache->waiters) != NULL) {
+        DLIST_REMOVE(cache->waiters, waiter);
+        req = waiter->req;
+        talloc_set_destructor(waiter, NULL);
+        talloc_free(waiter);
+
+        sdap_cli_kinit_finish(req, ret, expire_time);
+    }
+}
+
+static int sdap_kinit_waiter_destructor(struct sdap_kinit_waiter *waiter)
+{
+    DLIST_REMOVE(waiter->cache->waiters, waiter);
+    return 0;
+}
+
 static void sdap_cli_kinit_step(struct tevent_req *req)
 {
     struct sdap_cli_connect_state *state = tevent_req_data(req,
                                              struct sdap_cli_connect_state);
-    struct tevent_req *subreq;
+    struct sdap_kinit_cache *cache;
+    struct sdap_kinit_waiter *waiter;
+    errno_t ret;
 
-    subreq = sdap_kinit_send(state, state->ev,
-                             state->be,
-                             state->sh,
-                             state->service->kinit_service_name,
-                        dp_opt_get_int(state->opts->basic,
-                                                   SDAP_OPT_TIMEOUT),
-                        dp_opt_get_string(state->opts->basic,
-                                                   SDAP_KRB5_KEYTAB),
-                        dp_opt_get_string(state->opts->basic,
-                                                   SDAP_SASL_AUTHID),
-                        sdap_gssapi_realm(state->opts->basic),
-                        dp_opt_get_bool(state->opts->basic,
-                                                   SDAP_KRB5_CANONICALIZE),
-                        dp_opt_get_int(state->opts->basic,
-                                                   SDAP_KRB5_TICKET_LIFETIME));
-    if (!subreq) {
+    cache = sdap_kinit_cache_get(state);
+    if (cache == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+
+    if (cache->ccname != NULL && time(NULL) < cache->renew_time) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Using cached TGT from %s\n", cache->ccname);
+
+        /* Another service may have pointed the process to its own ccache */
+        ret = setenv("KRB5CCNAME", cache->ccname, 1);
+        if (ret == -1) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Unable to set env. variable KRB5CCNAME!\n");
+            sdap_cli_kinit_finish(req, ERR_AUTH_FAILED, 0);
+            return;
+        }
+
+        sdap_cli_kinit_finish(req, EOK, cache->expire_time);
+        return;
+    }
+
+    waiter = talloc_zero(state, struct sdap_kinit_waiter);
+    if (waiter == NULL) {
         tevent_req_error(req, ENOMEM);
         return;
     }
-    tevent_req_set_callback(subreq, sdap_cli_kinit_done, req);
+
+    ret = sdap_kinit_cache_start(cache);
+    if (ret != EOK) {
+        talloc_free(waiter);
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    waiter->cache = cache;
+    waiter->req = req;
+    DLIST_ADD_END(cache->waiters, waiter, struct sdap_kinit_waiter *);
+    talloc_set_destructor(waiter, sdap_kinit_waiter_destructor);
 }
 
-static void sdap_cli_kinit_done(struct tevent_req *subreq)
+static void sdap_cli_kinit_finish(struct tevent_req *req,
+                                  errno_t ret,
+                                  time_t expire_time)
 {
-    struct tevent_req *req = tevent_req_callback_data(subreq,
-                                                      struct tevent_req);
     struct sdap_cli_connect_state *state = tevent_req_data(req,
                                              struct sdap_cli_connect_state);
-    time_t expire_time = 0;
-    errno_t ret;
 
-    ret = sdap_kinit_recv(subreq, &expire_time);
-    talloc_zfree(subreq);
     if (ret != EOK) {
         /* We're not able to authenticate to the LDAP server.
          * There's not much we can do except for going offline */
@@ -1934,7 +2297,7 @@ static errno_t sdap_cli_auth_reconnect(struct tevent_req *req)
     subreq = sdap_connect_send(state, state->ev, state->opts,
                                state->service->uri,
                                state->service->sockaddr,
-                               state->use_tls);
+                               state->use_tls, state->srv);
 
     if (subreq == NULL) {
         ret = ENOMEM;
@@ -2112,6 +2475,11 @@ int sdap_cli_connect_recv(struct tevent_req *req,
 
         be_fo_set_port_status(state->be, state->service->name,
                               state->srv, PORT_WORKING);
+
+        sdap_tls_session_save(state->srv, state->sh);
+
+        fo_ref_server(state->sh, state->srv);
+        state->sh->srv = state->srv;
     }
 
     if (gsh) {
@@ -29,6 +29,7 @@
 #include "db/sysdb.h"
 #include "providers/ldap/ldap_common.h"
 #include "providers/ldap/sdap_async.h"
+#include "providers/ldap/sdap_async_private.h"
 #include "providers/ldap/sdap_async_enum.h"
 #include "providers/ldap/sdap_idmap.h"
 
@@ -74,6 +75,7 @@ static void sdap_dom_enum_ex_get_groups(struct tevent_req *subreq);
 static void sdap_dom_enum_ex_groups_done(struct tevent_req *subreq);
 static void sdap_dom_enum_ex_get_svcs(struct tevent_req *subreq);
 static void sdap_dom_enum_ex_svcs_done(struct tevent_req *subreq);
+static void sdap_dom_enum_ex_cleanup_done(struct tevent_req *subreq);
 
 struct tevent_req *
 sdap_dom_enum_ex_send(TALLOC_CTX *memctx,
@@ -381,14 +383,34 @@ static void sdap_dom_enum_ex_svcs_done(struct tevent_req *subreq)
     }
 
     if (state->purge) {
-        ret = ldap_id_cleanup(state->ctx, state->sdom);
-        if (ret != EOK) {
-            /* Not fatal, worst case we'll have stale entries that would be
-             * removed on a subsequent online lookup
-             */
-            DEBUG(SSSDBG_MINOR_FAILURE, "Cleanup failed: [%d]: %s\n",
-                  ret, sss_strerror(ret));
+        subreq = ldap_id_cleanup_send(state, state->ev, state->ctx,
+                                      state->sdom);
+        if (subreq == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
         }
+
+        tevent_req_set_callback(subreq, sdap_dom_enum_ex_cleanup_done, req);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void sdap_dom_enum_ex_cleanup_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    errno_t ret;
+
+    ret = ldap_id_cleanup_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        /* Not fatal, worst case we'll have stale entries that would be
+         * removed on a subsequent online lookup
+         */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cleanup failed: [%d]: %s\n",
+              ret, sss_strerror(ret));
     }
 
     tevent_req_done(req);
@@ -426,9 +448,16 @@ struct enum_users_state {
 
     char *filter;
     const char **attrs;
+
+    bool full_sync;
 };
 
 static void enum_users_done(struct tevent_req *subreq);
+static bool enum_users_use_sync(struct sdap_id_ctx *ctx,
+                                struct sdap_domain *sdom,
+                                struct sdap_id_op *op);
+static errno_t enum_users_sync_step(struct tevent_req *req);
+static void enum_users_sync_done(struct tevent_req *subreq);
 
 static struct tevent_req *enum_users_send(TALLOC_CTX *memctx,
                                           struct tevent_context *ev,
@@ -441,6 +470,7 @@ static struct tevent_req *enum_users_send(TALLOC_CTX *memctx,
     struct enum_users_state *state;
     int ret;
     bool use_mapping;
+    bool use_sync;
 
     req = tevent_req_create(memctx, &state, struct enum_users_state);
     if (!req) return NULL;
@@ -449,6 +479,9 @@ static struct tevent_req *enum_users_send(TALLOC_CTX *memctx,
     state->sdom = sdom;
     state->ctx = ctx;
     state->op = op;
+    state->full_sync = purge;
+
+    use_sync = enum_users_use_sync(ctx, sdom, op);
 
     use_mapping = sdap_idmap_domain_has_algorithmic_mapping(
                                                         ctx->opts->idmap_ctx,
@@ -488,7 +521,8 @@ static struct tevent_req *enum_users_send(TALLOC_CTX *memctx,
         goto fail;
     }
 
-    if (ctx->srv_opts && ctx->srv_opts->max_user_value && !purge) {
+    if (!use_sync && ctx->srv_opts && ctx->srv_opts->max_user_value
+            && !purge) {
         /* If we have lastUSN available and we're not doing a full
          * refresh, limit to changes with a higher entryUSN value.
          */
@@ -521,6 +555,13 @@ static struct tevent_req *enum_users_send(TALLOC_CTX *memctx,
                                NULL, &state->attrs, NULL);
     if (ret != EOK) goto fail;
 
+    if (use_sync) {
+        ret = enum_users_sync_step(req);
+        if (ret != EOK) goto fail;
+
+        return req;
+    }
+
     /* TODO: restrict the enumerations to using a single
      * search base at a time.
      */
@@ -585,6 +626,225 @@ static void enum_users_done(struct tevent_req *subreq)
     tevent_req_done(req);
 }
 
+static bool enum_users_use_sync(struct sdap_id_ctx *ctx,
+                                struct sdap_domain *sdom,
+                                struct sdap_id_op *op)
+{
+    if (!dp_opt_get_bool(ctx->opts->basic, SDAP_ENUM_CONTENT_SYNC)) {
+        return false;
+    }
+
+    if (!sdap_is_control_supported(sdap_id_op_handle(op),
+                                   LDAP_CONTROL_SYNC)) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "The server does not support "
+              "Content Synchronization, using modification timestamps\n");
+        return false;
+    }
+
+    /* The cookie describes a single search. */
+    if (sdom->user_search_bases == NULL
+            || sdom->user_search_bases[0] == NULL
+            || sdom->user_search_bases[1] != NULL) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Content Synchronization needs exactly "
+              "one user search base, using modification timestamps\n");
+        return false;
+    }
+
+    return true;
+}
+
+static errno_t enum_users_sync_step(struct tevent_req *req)
+{
+    struct enum_users_state *state = tevent_req_data(req,
+                                                     struct enum_users_state);
+    struct sdap_search_base *base = state->sdom->user_search_bases[0];
+    struct tevent_req *subreq;
+    uint8_t *cookie = NULL;
+    size_t cookie_len = 0;
+    char *filter;
+    errno_t ret;
+
+    if (!state->full_sync) {
+        ret = sysdb_get_sync_cookie(state, state->sdom->dom,
+                                    SYSDB_USER_SYNC_COOKIE,
+                                    &cookie, &cookie_len);
+        if (ret != EOK && ret != ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cannot read the sync cookie, "
+                  "requesting all users [%d]: %s\n", ret, sss_strerror(ret));
+        }
+    }
+
+    filter = sdap_combine_filters(state, state->filter, base->filter);
+    if (filter == NULL) {
+        return ENOMEM;
+    }
+
+    subreq = sdap_sync_refresh_send(state, state->ev, state->ctx->opts,
+                                    sdap_id_op_handle(state->op),
+                                    base->basedn, base->scope, filter,
+                                    state->attrs,
+                                    state->ctx->opts->user_map,
+                                    state->ctx->opts->user_map_cnt,
+                                    cookie, cookie_len,
+                                    dp_opt_get_int(state->ctx->opts->basic,
+                                                   SDAP_ENUM_SEARCH_TIMEOUT));
+    talloc_free(cookie);
+    if (subreq == NULL) {
+        return ENOMEM;
+    }
+    tevent_req_set_callback(subreq, enum_users_sync_done, req);
+
+    return EOK;
+}
+
+static errno_t enum_users_sync_delete(struct sss_domain_info *dom,
+                                      char **deleted,
+                                      size_t num_deleted)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    struct ldb_message **msgs;
+    const char *name;
+    char *filter;
+    size_t count;
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num_deleted; i++) {
+        filter = talloc_asprintf(tmp_ctx, "(%s=%s)",
+                                 SYSDB_SYNC_UUID, deleted[i]);
+        if (filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sysdb_search_users(tmp_ctx, dom, filter, attrs, &count, &msgs);
+        if (ret == ENOENT) {
+            continue;
+        } else if (ret != EOK) {
+            goto done;
+        }
+
+        for (j = 0; j < count; j++) {
+            name = ldb_msg_find_attr_as_string(msgs[j], SYSDB_NAME, NULL);
+            if (name == NULL) {
+                continue;
+            }
+
+            DEBUG(SSSDBG_TRACE_FUNC, "User [%s] was deleted\n", name);
+            ret = sysdb_delete_user(dom, name, 0);
+            if (ret != EOK && ret != ENOENT) {
+                goto done;
+            }
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static void enum_users_sync_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct enum_users_state *state = tevent_req_data(req,
+                                                     struct enum_users_state);
+    struct sss_domain_info *dom = state->sdom->dom;
+    struct sysdb_attrs **users;
+    size_t count;
+    char **deleted;
+    size_t num_deleted;
+    uint8_t *cookie;
+    size_t cookie_len;
+    bool in_transaction = false;
+    errno_t sret;
+    errno_t ret;
+
+    ret = sdap_sync_refresh_recv(subreq, state, &count, &users,
+                                 &num_deleted, &deleted,
+                                 &cookie, &cookie_len);
+    talloc_zfree(subreq);
+    if (ret == ESTALE && !state->full_sync) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "The sync cookie has expired, requesting all users\n");
+        state->full_sync = true;
+        ret = enum_users_sync_step(req);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+        }
+        return;
+    } else if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    /* Store the changes together with the cookie so that a failure does
+     * not lose any of them. */
+    ret = sysdb_transaction_start(dom->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sdap_save_users(state, dom->sysdb, dom, state->ctx->opts,
+                          users, count, NULL, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to store users [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = enum_users_sync_delete(dom, deleted, num_deleted);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to remove deleted users [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = sysdb_set_sync_cookie(dom, SYSDB_USER_SYNC_COOKIE,
+                                cookie, cookie_len);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to store the sync cookie [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = sysdb_transaction_commit(dom->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Synchronized %zu changed and %zu deleted "
+          "users\n", count, num_deleted);
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(dom->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to cancel transaction\n");
+        }
+    }
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
 static errno_t enum_users_recv(struct tevent_req *req)
 {
     TEVENT_REQ_RETURN_ON_ERROR(req);
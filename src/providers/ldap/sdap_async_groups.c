@@ -23,10 +23,12 @@
 
 #include "util/util.h"
 #include "util/probes.h"
+#include "util/sss_budget.h"
 #include "db/sysdb.h"
 #include "providers/ldap/sdap_async_private.h"
 #include "providers/ldap/ldap_common.h"
 #include "providers/ldap/sdap_idmap.h"
+#include "providers/ldap/sdap_range.h"
 
 /* ==Group-Parsing Routines=============================================== */
 
@@ -1067,6 +1069,10 @@ static int sdap_save_groups(TALLOC_CTX *memctx,
         return ENOMEM;
     }
 
+    /* The groups are saved in one transaction, only measure how long the
+     * event loop is blocked. It is reported when tmpctx is freed. */
+    sss_budget_create(tmpctx, "save groups", 0);
+
     ret = sysdb_transaction_start(sysdb);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
@@ -1729,6 +1735,342 @@ static int sdap_process_group_recv(struct tevent_req *req)
 }
 
 
+/* ==Retrieve-Ranged-Group-Members======================================= */
+
+/* Servers like Active Directory return at most a range of the values of
+ * large member attributes. The next ranges of one group are requested
+ * before the previous ones are received, up to this many at once. */
+#define SDAP_RANGE_MAX_SEARCHES 4
+
+struct sdap_group_range {
+    uint32_t low;
+    uint32_t high;
+};
+
+struct sdap_get_group_ranges_state {
+    struct tevent_context *ev;
+    struct sdap_options *opts;
+    struct sdap_handle *sh;
+    int timeout;
+    const char *member_attr;
+
+    struct sysdb_attrs **groups;
+    size_t count;
+    size_t group_iter;
+
+    /* The group whose members are being retrieved. */
+    const char *group_dn;
+    uint32_t step;
+    uint32_t next_low;
+    uint32_t end;
+    struct sdap_group_range *pending;
+    size_t num_pending;
+    size_t num_searches;
+};
+
+struct sdap_get_group_range_ctx {
+    struct tevent_req *req;
+    struct sdap_group_range range;
+};
+
+static errno_t sdap_get_group_ranges_next(struct tevent_req *req);
+static void sdap_get_group_ranges_done(struct tevent_req *subreq);
+
+static bool sdap_groups_have_ranges(struct sdap_options *opts,
+                                    struct sysdb_attrs **groups,
+                                    size_t count)
+{
+    uint32_t offset;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (sdap_range_get_next(groups[i],
+                                opts->group_map[SDAP_AT_GROUP_MEMBER].name,
+                                &offset) == EOK) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct tevent_req *
+sdap_get_group_ranges_send(TALLOC_CTX *mem_ctx,
+                           struct tevent_context *ev,
+                           struct sdap_options *opts,
+                           struct sdap_handle *sh,
+                           struct sysdb_attrs **groups,
+                           size_t count,
+                           int timeout)
+{
+    struct sdap_get_group_ranges_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sdap_get_group_ranges_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->opts = opts;
+    state->sh = sh;
+    state->timeout = timeout;
+    state->member_attr = opts->group_map[SDAP_AT_GROUP_MEMBER].name;
+    state->groups = groups;
+    state->count = count;
+    state->group_iter = 0;
+
+    ret = sdap_get_group_ranges_next(req);
+    if (ret != EAGAIN) {
+        if (ret == EOK) {
+            tevent_req_done(req);
+        } else {
+            tevent_req_error(req, ret);
+        }
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static errno_t sdap_get_group_ranges_next_group(struct tevent_req *req)
+{
+    struct sdap_get_group_ranges_state *state;
+    struct sysdb_attrs *group;
+    uint32_t offset;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sdap_get_group_ranges_state);
+
+    for (; state->group_iter < state->count; state->group_iter++) {
+        group = state->groups[state->group_iter];
+
+        ret = sdap_range_get_next(group, state->member_attr, &offset);
+        if (ret == ENOENT) {
+            continue;
+        } else if (ret != EOK) {
+            return ret;
+        }
+
+        ret = sysdb_attrs_get_string(group, SYSDB_ORIG_DN, &state->group_dn);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Ranged group members without originalDN\n");
+            continue;
+        }
+
+        /* The first range started at 0, the server sends ranges of the
+         * same size until the last one. */
+        state->step = offset;
+        state->next_low = offset;
+        state->end = UINT32_MAX;
+        state->num_pending = 0;
+
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Retrieving members of [%s] in ranges of %"PRIu32"\n",
+              state->group_dn, state->step);
+        return EAGAIN;
+    }
+
+    return EOK;
+}
+
+/* Returns EOK when the members of all groups were retrieved and EAGAIN while
+ * searches are running. */
+static errno_t sdap_get_group_ranges_next(struct tevent_req *req)
+{
+    struct sdap_get_group_ranges_state *state;
+    struct sdap_get_group_range_ctx *range_ctx;
+    struct tevent_req *subreq;
+    struct sdap_group_range range;
+    const char *attrs[2];
+    char *attr;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sdap_get_group_ranges_state);
+
+    if (state->group_dn == NULL) {
+        ret = sdap_get_group_ranges_next_group(req);
+        if (ret != EAGAIN) {
+            return ret;
+        }
+    }
+
+    while (state->num_searches < SDAP_RANGE_MAX_SEARCHES) {
+        if (state->num_pending > 0) {
+            state->num_pending--;
+            range = state->pending[state->num_pending];
+        } else if (state->next_low < state->end) {
+            range.low = state->next_low;
+            range.high = range.low + state->step - 1;
+            if (range.high < range.low) {
+                range.high = UINT32_MAX;
+            }
+            state->next_low = range.high + 1;
+        } else if (state->num_searches > 0) {
+            /* Only wait for the running searches. */
+            break;
+        } else {
+            /* All members of this group were retrieved. */
+            state->group_dn = NULL;
+            state->group_iter++;
+            ret = sdap_get_group_ranges_next_group(req);
+            if (ret != EAGAIN) {
+                return ret;
+            }
+            continue;
+        }
+
+        attr = talloc_asprintf(state, "%s;range=%"PRIu32"-%"PRIu32,
+                               state->member_attr, range.low, range.high);
+        if (attr == NULL) {
+            return ENOMEM;
+        }
+        attrs[0] = attr;
+        attrs[1] = NULL;
+
+        subreq = sdap_get_generic_send(state, state->ev, state->opts,
+                                       state->sh, state->group_dn,
+                                       LDAP_SCOPE_BASE, "(objectclass=*)",
+                                       attrs, NULL, 0, state->timeout, false);
+        talloc_free(attr);
+        if (subreq == NULL) {
+            return ENOMEM;
+        }
+
+        range_ctx = talloc_zero(subreq, struct sdap_get_group_range_ctx);
+        if (range_ctx == NULL) {
+            talloc_free(subreq);
+            return ENOMEM;
+        }
+        range_ctx->req = req;
+        range_ctx->range = range;
+
+        tevent_req_set_callback(subreq, sdap_get_group_ranges_done, range_ctx);
+        state->num_searches++;
+    }
+
+    return EAGAIN;
+}
+
+static errno_t
+sdap_get_group_ranges_add(struct sdap_get_group_ranges_state *state,
+                          struct sdap_group_range *range,
+                          struct sysdb_attrs *reply)
+{
+    struct sysdb_attrs *group = state->groups[state->group_iter];
+    struct sdap_group_range *pending;
+    struct ldb_message_element *el;
+    uint32_t offset;
+    errno_t ret;
+
+    ret = sysdb_attrs_get_el_ext(reply, state->member_attr, false, &el);
+    if (ret == EOK) {
+        /* Members are processed as the ranges arrive, their order does
+         * not matter. */
+        ret = sysdb_attrs_add_vals(group,
+                    state->opts->group_map[SDAP_AT_GROUP_MEMBER].sys_name,
+                    el->values, el->num_values);
+        if (ret != EOK) {
+            return ret;
+        }
+    } else if (ret != ENOENT) {
+        return ret;
+    }
+
+    ret = sdap_range_get_next(reply, state->member_attr, &offset);
+    if (ret == ENOENT) {
+        /* This was the last range, there are no values above it. */
+        if (range->high < UINT32_MAX) {
+            state->end = MIN(state->end, range->high + 1);
+        } else {
+            state->end = MIN(state->end, range->low);
+        }
+        return EOK;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    if (offset > range->low && offset <= range->high) {
+        /* The server returned less values than requested, ask for the
+         * rest of this range again. */
+        pending = talloc_realloc(state, state->pending,
+                                 struct sdap_group_range,
+                                 state->num_pending + 1);
+        if (pending == NULL) {
+            return ENOMEM;
+        }
+        state->pending = pending;
+        state->pending[state->num_pending].low = offset;
+        state->pending[state->num_pending].high = range->high;
+        state->num_pending++;
+    }
+
+    return EOK;
+}
+
+static void sdap_get_group_ranges_done(struct tevent_req *subreq)
+{
+    struct sdap_get_group_range_ctx *range_ctx;
+    struct sdap_get_group_ranges_state *state;
+    struct sdap_group_range range;
+    struct sysdb_attrs **reply;
+    struct tevent_req *req;
+    size_t reply_count;
+    errno_t ret;
+
+    range_ctx = tevent_req_callback_data(subreq,
+                                         struct sdap_get_group_range_ctx);
+    req = range_ctx->req;
+    range = range_ctx->range;
+    state = tevent_req_data(req, struct sdap_get_group_ranges_state);
+
+    state->num_searches--;
+
+    ret = sdap_get_generic_recv(subreq, state, &reply_count, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        if (range.low >= state->end) {
+            /* A range behind the last one may be refused by the server. */
+            ret = EOK;
+        } else {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Unable to retrieve members %"PRIu32"-%"PRIu32" of [%s] "
+                  "[%d]: %s\n", range.low, range.high, state->group_dn,
+                  ret, sss_strerror(ret));
+            tevent_req_error(req, ret);
+            return;
+        }
+    } else if (reply_count == 1) {
+        ret = sdap_get_group_ranges_add(state, &range, reply[0]);
+        talloc_free(reply);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+    } else {
+        /* The group is gone or does not have values in this range. */
+        talloc_free(reply);
+        state->end = MIN(state->end, range.low);
+    }
+
+    ret = sdap_get_group_ranges_next(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static errno_t sdap_get_group_ranges_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
 /* ==Search-Groups-with-filter============================================ */
 
 struct sdap_get_groups_state {
@@ -1926,6 +2268,8 @@ static errno_t sdap_get_groups_next_base(struct tevent_req *req)
 }
 
 static void sdap_nested_done(struct tevent_req *req);
+static void sdap_get_groups_ranges_done(struct tevent_req *subreq);
+static void sdap_get_groups_members(struct tevent_req *req);
 static void sdap_search_group_copy_batch(struct sdap_get_groups_state *state,
                                          struct sysdb_attrs **groups,
                                          size_t count);
@@ -1937,7 +2281,6 @@ static void sdap_get_groups_process(struct tevent_req *subreq)
     struct sdap_get_groups_state *state =
                         tevent_req_data(req, struct sdap_get_groups_state);
     int ret;
-    int i;
     bool next_base = false;
     size_t count;
     struct sysdb_attrs **groups;
@@ -2022,6 +2365,45 @@ static void sdap_get_groups_process(struct tevent_req *subreq)
         return;
     }
 
+    if (sdap_groups_have_ranges(state->opts, state->groups, state->count)) {
+        subreq = sdap_get_group_ranges_send(state, state->ev, state->opts,
+                            state->ldap_sh != NULL ? state->ldap_sh : state->sh,
+                            state->groups, state->count, state->timeout);
+        if (subreq == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
+        }
+        tevent_req_set_callback(subreq, sdap_get_groups_ranges_done, req);
+        return;
+    }
+
+    sdap_get_groups_members(req);
+}
+
+static void sdap_get_groups_ranges_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req =
+                        tevent_req_callback_data(subreq, struct tevent_req);
+    int ret;
+
+    ret = sdap_get_group_ranges_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    sdap_get_groups_members(req);
+}
+
+static void sdap_get_groups_members(struct tevent_req *req)
+{
+    struct sdap_get_groups_state *state =
+                        tevent_req_data(req, struct sdap_get_groups_state);
+    struct tevent_req *subreq;
+    int ret;
+    int i;
+
     /* Check whether we need to do nested searches
      * for RFC2307bis/FreeIPA/ActiveDirectory
      * We don't need to do this for enumeration,
@@ -2411,14 +2793,14 @@ static errno_t sdap_nested_group_populate_users(TALLOC_CTX *mem_ctx,
                                        SYSDB_MOD_REP);
             if (ret != EOK) goto done;
         } else {
+            /* the key is copied by the hash table */
             key.type = HASH_KEY_STRING;
-            key.str = talloc_steal(ghosts, discard_const(original_dn));
+            key.str = discard_const(original_dn);
             value.type = HASH_VALUE_PTR;
             /* Already qualified from sdap_get_user_primary_name() */
             value.ptr = talloc_steal(ghosts, discard_const(username));
             ret = hash_enter(ghosts, &key, &value);
             if (ret != HASH_SUCCESS) {
-                talloc_free(key.str);
                 talloc_free(value.ptr);
                 ret = ENOMEM;
                 goto done;
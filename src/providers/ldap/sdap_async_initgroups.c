@@ -3624,7 +3624,7 @@ sdap_handle_id_collision_for_incomplete_groups(struct data_provider *dp,
         return ret;
     }
 
-    dp_sbus_invalidate_group_memcache(dp, gid);
+    dp_sbus_invalidate_group_memcache(dp, domain, gid);
 
     return EOK;
 }
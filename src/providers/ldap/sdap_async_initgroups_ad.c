@@ -251,6 +251,9 @@ done:
     return ret;
 }
 
+/* Maximum number of SIDs of one domain that are looked up with one search */
+#define SDAP_AD_RESOLVE_SIDS_BATCH 100
+
 struct sdap_ad_resolve_sids_state {
     struct tevent_context *ev;
     struct sdap_id_ctx *id_ctx;
@@ -259,10 +262,27 @@ struct sdap_ad_resolve_sids_state {
     struct sss_domain_info *domain;
     char **sids;
 
+    /* SIDs that are looked up one by one */
+    char **lookup_sids;
     const char *current_sid;
     int index;
+
+    /* Batched searches that did not finish yet and SIDs they did not find */
+    TALLOC_CTX *batches;
+    size_t num_batches;
+    char **missing_sids;
+    size_t num_missing_sids;
+};
+
+struct sdap_ad_resolve_sids_batch {
+    struct tevent_req *req;
+    struct sss_domain_info *domain;
+    const char **sids;
+    size_t num_sids;
 };
 
+static errno_t sdap_ad_resolve_sids_batches(struct tevent_req *req);
+static void sdap_ad_resolve_sids_batch_done(struct tevent_req *subreq);
 static errno_t sdap_ad_resolve_sids_step(struct tevent_req *req);
 static void sdap_ad_resolve_sids_done(struct tevent_req *subreq);
 
@@ -292,6 +312,7 @@ sdap_ad_resolve_sids_send(TALLOC_CTX *mem_ctx,
     state->opts = opts;
     state->domain = get_domains_head(domain);
     state->sids = sids;
+    state->lookup_sids = sids;
     state->index = 0;
 
     if (state->sids == NULL || state->sids[0] == NULL) {
@@ -299,7 +320,11 @@ sdap_ad_resolve_sids_send(TALLOC_CTX *mem_ctx,
         goto immediately;
     }
 
-    ret = sdap_ad_resolve_sids_step(req);
+    ret = sdap_ad_resolve_sids_batches(req);
+    if (ret == EOK) {
+        /* Nothing to batch, look up the SIDs one by one */
+        ret = sdap_ad_resolve_sids_step(req);
+    }
     if (ret != EAGAIN) {
         goto immediately;
     }
@@ -317,6 +342,188 @@ immediately:
     return req;
 }
 
+/* Groups the SIDs by domain and looks up every group in batches of
+ * SDAP_AD_RESOLVE_SIDS_BATCH SIDs, all batches are sent at once. Returns
+ * EOK if there is nothing to batch. */
+static errno_t sdap_ad_resolve_sids_batches(struct tevent_req *req)
+{
+    struct sdap_ad_resolve_sids_state *state = NULL;
+    struct sdap_ad_resolve_sids_batch **batches = NULL;
+    struct sdap_ad_resolve_sids_batch *batch;
+    struct sss_domain_info *domain;
+    struct sdap_domain *sdap_domain;
+    struct tevent_req *subreq;
+    size_t num_sids;
+    size_t num_batches = 0;
+    size_t i;
+    size_t j;
+
+    state = tevent_req_data(req, struct sdap_ad_resolve_sids_state);
+
+    for (num_sids = 0; state->sids[num_sids] != NULL; num_sids++);
+    if (num_sids < 2) {
+        return EOK;
+    }
+
+    batches = talloc_zero_array(state, struct sdap_ad_resolve_sids_batch *,
+                                num_sids);
+    state->missing_sids = talloc_zero_array(state, char *, num_sids + 1);
+    if (batches == NULL || state->missing_sids == NULL) {
+        return ENOMEM;
+    }
+    state->batches = batches;
+
+    for (i = 0; i < num_sids; i++) {
+        domain = sss_get_domain_by_sid_ldap_fallback(state->domain,
+                                                     state->sids[i]);
+        if (domain == NULL) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "SID %s does not belong to any known "
+                                         "domain\n", state->sids[i]);
+            continue;
+        }
+
+        batch = NULL;
+        for (j = 0; j < num_batches; j++) {
+            if (batches[j]->domain == domain
+                    && batches[j]->num_sids < SDAP_AD_RESOLVE_SIDS_BATCH) {
+                batch = batches[j];
+                break;
+            }
+        }
+
+        if (batch == NULL) {
+            batch = talloc_zero(batches, struct sdap_ad_resolve_sids_batch);
+            if (batch == NULL) {
+                return ENOMEM;
+            }
+
+            batch->req = req;
+            batch->domain = domain;
+            batch->sids = talloc_zero_array(batch, const char *,
+                                            MIN(num_sids - i,
+                                                SDAP_AD_RESOLVE_SIDS_BATCH));
+            if (batch->sids == NULL) {
+                return ENOMEM;
+            }
+            batches[num_batches] = batch;
+            num_batches++;
+        }
+
+        batch->sids[batch->num_sids] = state->sids[i];
+        batch->num_sids++;
+    }
+
+    if (num_batches == num_sids) {
+        /* Every SID is in a domain of its own, nothing to batch. */
+        talloc_zfree(state->batches);
+        return EOK;
+    }
+
+    for (i = 0; i < num_batches; i++) {
+        sdap_domain = sdap_domain_get(state->opts, batches[i]->domain);
+        if (sdap_domain == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "SDAP domain does not exist?\n");
+            /* Cancel the batches that were already sent */
+            talloc_zfree(state->batches);
+            return ERR_INTERNAL;
+        }
+
+        subreq = groups_by_sids_get_send(batches[i], state->ev, state->id_ctx,
+                                         sdap_domain, state->conn,
+                                         batches[i]->sids,
+                                         batches[i]->num_sids, true);
+        if (subreq == NULL) {
+            talloc_zfree(state->batches);
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, sdap_ad_resolve_sids_batch_done,
+                                batches[i]);
+        state->num_batches++;
+    }
+
+    return EAGAIN;
+}
+
+static void sdap_ad_resolve_sids_batch_done(struct tevent_req *subreq)
+{
+    struct sdap_ad_resolve_sids_state *state = NULL;
+    struct sdap_ad_resolve_sids_batch *batch = NULL;
+    struct tevent_req *req = NULL;
+    struct ldb_message *msg;
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    int dp_error;
+    int sdap_error;
+    size_t i;
+    errno_t ret;
+
+    batch = tevent_req_callback_data(subreq, struct sdap_ad_resolve_sids_batch);
+    req = batch->req;
+    state = tevent_req_data(req, struct sdap_ad_resolve_sids_state);
+
+    ret = groups_by_sids_get_recv(subreq, &dp_error, &sdap_error);
+    talloc_zfree(subreq);
+    state->num_batches--;
+
+    if (ret == EOK && sdap_error == ENOENT && dp_error == DP_ERR_OK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "None of the %zu SIDs was found, they will "
+              "be looked up one by one.\n", batch->num_sids);
+    } else if (ret != EOK || sdap_error != EOK || dp_error != DP_ERR_OK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to resolve %zu SIDs [dp_error: %d, "
+              "sdap_error: %d, ret: %d]: %s\n", batch->num_sids, dp_error,
+              sdap_error, ret, strerror(ret));
+        if (ret == EOK) {
+            ret = sdap_error != EOK ? sdap_error : EIO;
+        }
+        goto done;
+    }
+
+    /* SIDs that were not found are looked up again one by one, there may
+     * be a user private group or the group was outside of the search base
+     * the others were found in. */
+    for (i = 0; i < batch->num_sids; i++) {
+        ret = sysdb_search_group_by_sid_str(batch, batch->domain,
+                                            batch->sids[i], attrs, &msg);
+        if (ret == EOK) {
+            talloc_free(msg);
+            continue;
+        } else if (ret != ENOENT) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Could not look up SID %s in sysdb: "
+                  "[%s]\n", batch->sids[i], strerror(ret));
+            goto done;
+        }
+
+        state->missing_sids[state->num_missing_sids] =
+                                            discard_const(batch->sids[i]);
+        state->num_missing_sids++;
+    }
+    talloc_free(batch);
+
+    if (state->num_batches > 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "%zu SIDs were not found by batched lookups\n",
+          state->num_missing_sids);
+
+    state->lookup_sids = state->missing_sids;
+    state->index = 0;
+    ret = sdap_ad_resolve_sids_step(req);
+    if (ret == EAGAIN) {
+        return;
+    }
+
+done:
+    if (ret != EOK) {
+        /* Cancel the other batches */
+        talloc_zfree(state->batches);
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
 static errno_t sdap_ad_resolve_sids_step(struct tevent_req *req)
 {
     struct sdap_ad_resolve_sids_state *state = NULL;
@@ -327,7 +534,7 @@ static errno_t sdap_ad_resolve_sids_step(struct tevent_req *req)
     state = tevent_req_data(req, struct sdap_ad_resolve_sids_state);
 
     do {
-        state->current_sid = state->sids[state->index];
+        state->current_sid = state->lookup_sids[state->index];
         if (state->current_sid == NULL) {
             return EOK;
         }
@@ -478,7 +685,7 @@ sdap_ad_tokengroups_initgr_mapping_send(TALLOC_CTX *mem_ctx,
     }
 
     sdom = sdap_domain_get(opts, domain);
-    if (sdom == NULL || sdom->pvt == NULL) {
+    if (sdom == NULL || sdap_domain_get_pvt(sdom) == NULL) {
         ret = handle_missing_pvt(mem_ctx, ev, opts, orig_dn, timeout,
                                  state->username, sh, req,
                                  sdap_ad_tokengroups_initgr_mapping_done);
@@ -558,12 +765,14 @@ sdap_ad_tokengroups_initgr_mapping_connect_done(struct tevent_req *subreq)
     return;
 }
 
-errno_t sdap_ad_save_group_membership_with_idmapping(const char *username,
-                                               struct sdap_options *opts,
-                                               struct sss_domain_info *user_dom,
-                                               struct sdap_idmap_ctx *idmap_ctx,
-                                               size_t num_sids,
-                                               char **sids)
+errno_t
+sdap_ad_get_group_dns_with_idmapping(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *user_dom,
+                                     struct sdap_idmap_ctx *idmap_ctx,
+                                     size_t num_sids,
+                                     char **sids,
+                                     size_t *_num_groups,
+                                     char ***_groups)
 {
     TALLOC_CTX *tmp_ctx = NULL;
     struct sss_domain_info *domain = NULL;
@@ -577,8 +786,6 @@ errno_t sdap_ad_save_group_membership_with_idmapping(const char *username,
     char **groups = NULL;
     size_t num_groups;
     errno_t ret;
-    errno_t sret;
-    bool in_transaction = false;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
@@ -594,11 +801,6 @@ errno_t sdap_ad_save_group_membership_with_idmapping(const char *username,
     }
 
     now = time(NULL);
-    ret = sysdb_transaction_start(user_dom->sysdb);
-    if (ret != EOK) {
-        goto done;
-    }
-    in_transaction = true;
 
     for (i = 0; i < num_sids; i++) {
         sid = sids[i];
@@ -670,7 +872,7 @@ errno_t sdap_ad_save_group_membership_with_idmapping(const char *username,
             goto done;
         }
 
-        groups[num_groups] = sysdb_group_strdn(tmp_ctx, domain->name, name);
+        groups[num_groups] = sysdb_group_strdn(groups, domain->name, name);
         if (groups[num_groups] == NULL) {
             ret = ENOMEM;
             goto done;
@@ -680,6 +882,50 @@ errno_t sdap_ad_save_group_membership_with_idmapping(const char *username,
 
     groups[num_groups] = NULL;
 
+    *_num_groups = num_groups;
+    *_groups = talloc_steal(mem_ctx, groups);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+errno_t sdap_ad_save_group_membership_with_idmapping(const char *username,
+                                               struct sdap_options *opts,
+                                               struct sss_domain_info *user_dom,
+                                               struct sdap_idmap_ctx *idmap_ctx,
+                                               size_t num_sids,
+                                               char **sids)
+{
+    TALLOC_CTX *tmp_ctx = NULL;
+    char **groups = NULL;
+    size_t num_groups;
+    errno_t ret;
+    errno_t sret;
+    bool in_transaction = false;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
+        return ENOMEM;
+    }
+
+    ret = sysdb_transaction_start(user_dom->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sdap_ad_get_group_dns_with_idmapping(tmp_ctx, user_dom, idmap_ctx,
+                                               num_sids, sids,
+                                               &num_groups, &groups);
+    if (ret != EOK) {
+        goto done;
+    }
+
     ret = sdap_ad_tokengroups_update_members(username,
                                              user_dom->sysdb, user_dom,
                                              groups);
@@ -826,7 +1072,7 @@ sdap_ad_tokengroups_initgr_posix_send(TALLOC_CTX *mem_ctx,
     }
 
     sdom = sdap_domain_get(opts, domain);
-    if (sdom == NULL || sdom->pvt == NULL) {
+    if (sdom == NULL || sdap_domain_get_pvt(sdom) == NULL) {
         ret = handle_missing_pvt(mem_ctx, ev, opts, orig_dn, timeout,
                                  state->username, sh, req,
                                  sdap_ad_tokengroups_initgr_posix_tg_done);
@@ -1728,7 +1974,8 @@ struct sdap_id_conn_ctx *get_ldap_conn_from_sdom_pvt(struct sdap_options *opts,
     struct ad_id_ctx *ad_id_ctx;
     struct sdap_id_conn_ctx *user_conn = NULL;
 
-    if (opts->schema_type == SDAP_SCHEMA_AD && sdom->pvt != NULL) {
+    if (opts->schema_type == SDAP_SCHEMA_AD
+            && sdap_domain_get_pvt(sdom) != NULL) {
         ad_id_ctx = talloc_get_type(sdom->pvt, struct ad_id_ctx);
         if (ad_id_ctx != NULL &&  ad_id_ctx->ldap_ctx != NULL) {
             DEBUG(SSSDBG_TRACE_ALL,
@@ -31,6 +31,9 @@
 
 #include "util/util.h"
 #include "util/probes.h"
+#include "util/sss_str_intern.h"
+#include "util/sss_hash_map.h"
+#include "util/dlinklist.h"
 #include "db/sysdb.h"
 #include "providers/ldap/ldap_common.h"
 #include "providers/ldap/sdap_async.h"
@@ -61,6 +64,19 @@ struct sdap_nested_group_member {
 #define EXTERNAL_MEMBERS_CHUNK  16
 #endif /* EXTERNAL_MEMBERS_CHUNK */
 
+/* Members of the same type that live in the same container are looked up
+ * together with a single one level search for their RDN values. */
+struct sdap_nested_group_batch {
+    enum sdap_nested_group_dn_type type;
+    const char *base_dn;
+    const char *filter;
+
+    struct sdap_nested_group_member **members;
+    struct ldb_dn **dns;
+    const char **rdn_filters;
+    int num_members;
+};
+
 struct sdap_external_missing_member {
     const char **parent_group_dns;
     size_t parent_dn_idx;
@@ -72,12 +88,25 @@ struct sdap_nested_group_ctx {
     struct sdap_search_base **user_search_bases;
     struct sdap_search_base **group_search_bases;
     struct sdap_handle *sh;
-    hash_table_t *users;
-    hash_table_t *groups;
+    /* users and groups found so far by their original DN */
+    struct sss_hash_map *users;
+    struct sss_hash_map *groups;
     hash_table_t *missing_external;
+    /* member and parent group DNs, the same DN is a member of many groups */
+    struct sss_str_intern_pool *dns;
     bool try_deref;
     int deref_threshold;
     int max_nesting_level;
+
+    /* Member lookups are sent in parallel up to max_lookups, the groups
+     * that have to wait for a free slot are queued in waiting. */
+    int max_lookups;
+    int num_lookups;
+    struct sdap_nested_group_single_state *waiting;
+    struct tevent_immediate *wakeup;
+
+    /* maximum number of members looked up with one search */
+    int batch_size;
 };
 
 static struct tevent_req *
@@ -120,6 +149,18 @@ static errno_t sdap_nested_group_lookup_group_recv(TALLOC_CTX *mem_ctx,
                                                    struct tevent_req *req,
                                                    struct sysdb_attrs **_group);
 
+static struct tevent_req *
+sdap_nested_group_lookup_batch_send(TALLOC_CTX *mem_ctx,
+                                    struct tevent_context *ev,
+                                    struct sdap_nested_group_ctx *group_ctx,
+                                    struct sdap_nested_group_batch *batch);
+
+static errno_t
+sdap_nested_group_lookup_batch_recv(TALLOC_CTX *mem_ctx,
+                                    struct tevent_req *req,
+                                    struct sysdb_attrs ***_entries,
+                                    size_t *_num_entries);
+
 static struct tevent_req *
 sdap_nested_group_lookup_unknown_send(TALLOC_CTX *mem_ctx,
                                       struct tevent_context *ev,
@@ -142,36 +183,30 @@ sdap_nested_group_deref_send(TALLOC_CTX *mem_ctx,
 
 static errno_t sdap_nested_group_deref_recv(struct tevent_req *req);
 
+SSS_HASH_MAP_TYPED(sdap_nested_group_map, struct sysdb_attrs)
+
 static errno_t
-sdap_nested_group_extract_hash_table(TALLOC_CTX *mem_ctx,
-                                     hash_table_t *table,
-                                     unsigned long *_num_entries,
-                                     struct sysdb_attrs ***_entries)
+sdap_nested_group_extract_map(TALLOC_CTX *mem_ctx,
+                              struct sss_hash_map *map,
+                              unsigned long *_num_entries,
+                              struct sysdb_attrs ***_entries)
 {
     struct sysdb_attrs **entries = NULL;
     struct sysdb_attrs *entry = NULL;
-    hash_value_t *values;
     unsigned long num_entries;
-    unsigned int i;
-    bool hret;
-    errno_t ret;
+    unsigned long i = 0;
+    size_t iter = 0;
 
-    hret = hash_values(table, &num_entries, &values);
-    if (hret != HASH_SUCCESS) {
-        ret = EIO;
-        goto done;
-    }
+    num_entries = sss_hash_map_count(map);
 
     if (num_entries > 0) {
         entries = talloc_array(mem_ctx, struct sysdb_attrs *, num_entries);
         if (entries == NULL) {
-            ret = ENOMEM;
-            goto done;
+            return ENOMEM;
         }
 
-        for (i = 0; i < num_entries; i++) {
-            entry = talloc_get_type(values[i].ptr, struct sysdb_attrs);
-            entries[i] = talloc_steal(entries, entry);
+        while (sdap_nested_group_map_next(map, &iter, NULL, &entry)) {
+            entries[i++] = talloc_steal(entries, entry);
         }
     }
 
@@ -183,16 +218,7 @@ sdap_nested_group_extract_hash_table(TALLOC_CTX *mem_ctx,
         *_entries = entries;
     }
 
-    ret = EOK;
-
-done:
-    talloc_free(values);
-
-    if (ret != EOK) {
-        talloc_free(entries);
-    }
-
-    return ret;
+    return EOK;
 }
 
 static errno_t sdap_nested_group_hash_insert(hash_table_t *table,
@@ -208,14 +234,11 @@ static errno_t sdap_nested_group_hash_insert(hash_table_t *table,
     DEBUG(SSSDBG_TRACE_ALL, "Inserting [%s] into hash table [%s]\n",
                              entry_key, table_name);
 
+    /* the key is copied by the hash table */
     key.type = HASH_KEY_STRING;
-    key.str = talloc_strdup(NULL, entry_key);
-    if (key.str == NULL) {
-        return ENOMEM;
-    }
+    key.str = discard_const(entry_key);
 
     if (overwrite == false && hash_has_key(table, &key)) {
-        talloc_free(key.str);
         return EEXIST;
     }
 
@@ -224,17 +247,15 @@ static errno_t sdap_nested_group_hash_insert(hash_table_t *table,
 
     hret = hash_enter(table, &key, &value);
     if (hret != HASH_SUCCESS) {
-        talloc_free(key.str);
         return EIO;
     }
 
-    talloc_steal(table, key.str);
     talloc_steal(table, value.ptr);
 
     return EOK;
 }
 
-static errno_t sdap_nested_group_hash_entry(hash_table_t *table,
+static errno_t sdap_nested_group_hash_entry(struct sss_hash_map *map,
                                             struct sysdb_attrs *entry,
                                             const char *table_name)
 {
@@ -246,7 +267,17 @@ static errno_t sdap_nested_group_hash_entry(hash_table_t *table,
         return ret;
     }
 
-    return sdap_nested_group_hash_insert(table, name, entry, false, table_name);
+    DEBUG(SSSDBG_TRACE_ALL, "Inserting [%s] into hash table [%s]\n",
+                             name, table_name);
+
+    ret = sdap_nested_group_map_add(map, name, entry);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    talloc_steal(map, entry);
+
+    return EOK;
 }
 
 static errno_t
@@ -319,6 +350,7 @@ sdap_nested_group_hash_group(struct sdap_nested_group_ctx *group_ctx,
 }
 
 static errno_t sdap_nested_group_external_add(hash_table_t *table,
+                                              struct sss_str_intern_pool *dns,
                                               const char *ext_member,
                                               const char *parent_group_dn)
 {
@@ -378,8 +410,7 @@ static errno_t sdap_nested_group_external_add(hash_table_t *table,
     }
 
     ext_mem->parent_group_dns[ext_mem->parent_dn_idx] = \
-                                        talloc_strdup(ext_mem->parent_group_dns,
-                                                      parent_group_dn);
+                                        sss_str_intern(dns, parent_group_dn);
     if (ext_mem->parent_group_dns[ext_mem->parent_dn_idx] == NULL) {
         return ENOMEM;
     }
@@ -546,8 +577,6 @@ sdap_nested_group_split_members(TALLOC_CTX *mem_ctx,
     char *group_filter = NULL;
     int num_missing = 0;
     int num_groups = 0;
-    hash_key_t key;
-    bool bret;
     bool is_user;
     bool is_group;
     errno_t ret;
@@ -591,16 +620,8 @@ sdap_nested_group_split_members(TALLOC_CTX *mem_ctx,
         type = SDAP_NESTED_GROUP_DN_UNKNOWN;
 
         /* check hash tables */
-        key.type = HASH_KEY_STRING;
-        key.str = dn;
-
-        bret = hash_has_key(group_ctx->users, &key);
-        if (bret) {
-            continue;
-        }
-
-        bret = hash_has_key(group_ctx->groups, &key);
-        if (bret) {
+        if (sss_hash_map_has_key(group_ctx->users, dn)
+                || sss_hash_map_has_key(group_ctx->groups, dn)) {
             continue;
         }
 
@@ -656,7 +677,7 @@ sdap_nested_group_split_members(TALLOC_CTX *mem_ctx,
             }
         }
 
-        missing[num_missing].dn = talloc_strdup(missing, dn);
+        missing[num_missing].dn = sss_str_intern(group_ctx->dns, dn);
         if (missing[num_missing].dn == NULL) {
             ret = ENOMEM;
             goto done;
@@ -734,6 +755,7 @@ sdap_nested_group_add_ext_members(struct sdap_nested_group_ctx *group_ctx,
         ext_member_attr = (const char *) ext_members->values[i].data;
 
         ret = sdap_nested_group_external_add(group_ctx->missing_external,
+                                             group_ctx->dns,
                                              ext_member_attr,
                                              orig_dn);
         if (ret != EOK) {
@@ -805,17 +827,17 @@ sdap_nested_group_send(TALLOC_CTX *mem_ctx,
         goto immediately;
     }
 
-    ret = sss_hash_create(state->group_ctx, 32, &state->group_ctx->users);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create hash table [%d]: %s\n",
-                                    ret, strerror(ret));
+    state->group_ctx->users = sss_hash_map_create(state->group_ctx, 0);
+    if (state->group_ctx->users == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create hash table\n");
+        ret = ENOMEM;
         goto immediately;
     }
 
-    ret = sss_hash_create(state->group_ctx, 32, &state->group_ctx->groups);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create hash table [%d]: %s\n",
-                                    ret, strerror(ret));
+    state->group_ctx->groups = sss_hash_map_create(state->group_ctx, 0);
+    if (state->group_ctx->groups == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create hash table\n");
+        ret = ENOMEM;
         goto immediately;
     }
 
@@ -827,11 +849,33 @@ sdap_nested_group_send(TALLOC_CTX *mem_ctx,
         goto immediately;
     }
 
+    /* Parent group DNs of external members are returned together with
+     * the missing_external table. */
+    state->group_ctx->dns = sss_str_intern_pool_create(
+                                        state->group_ctx->missing_external);
+    if (state->group_ctx->dns == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
     state->group_ctx->try_deref = true;
     state->group_ctx->deref_threshold = dp_opt_get_int(opts->basic,
                                                       SDAP_DEREF_THRESHOLD);
     state->group_ctx->max_nesting_level = dp_opt_get_int(opts->basic,
                                                          SDAP_NESTING_LEVEL);
+    state->group_ctx->max_lookups = dp_opt_get_int(opts->basic,
+                                                SDAP_NESTING_PARALLEL_LOOKUPS);
+    if (state->group_ctx->max_lookups <= 0) {
+        state->group_ctx->max_lookups = 1;
+    }
+    state->group_ctx->batch_size = dp_opt_get_int(opts->basic,
+                                                  SDAP_NESTING_BATCH_SIZE);
+
+    state->group_ctx->wakeup = tevent_create_immediate(state->group_ctx);
+    if (state->group_ctx->wakeup == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
     state->group_ctx->domain = sdom->dom;
     state->group_ctx->opts = opts;
     state->group_ctx->user_search_bases = sdom->user_search_bases;
@@ -935,8 +979,8 @@ errno_t sdap_nested_group_recv(TALLOC_CTX *mem_ctx,
     PROBE(SDAP_NESTED_GROUP_RECV);
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
-    ret = sdap_nested_group_extract_hash_table(state, state->group_ctx->users,
-                                               &num_users, &users);
+    ret = sdap_nested_group_extract_map(state, state->group_ctx->users,
+                                        &num_users, &users);
     if (ret != EOK) {
         return ret;
     }
@@ -944,8 +988,8 @@ errno_t sdap_nested_group_recv(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_FUNC, "%lu users found in the hash table\n",
                               num_users);
 
-    ret = sdap_nested_group_extract_hash_table(state, state->group_ctx->groups,
-                                               &num_groups, &groups);
+    ret = sdap_nested_group_extract_map(state, state->group_ctx->groups,
+                                        &num_groups, &groups);
     if (ret != EOK) {
         return ret;
     }
@@ -1231,6 +1275,7 @@ struct sdap_nested_group_recurse_state {
     struct sysdb_attrs **groups;
     int num_groups;
     int index;
+    int num_active;
     int nesting_level;
 };
 
@@ -1261,9 +1306,10 @@ sdap_nested_group_recurse_send(TALLOC_CTX *mem_ctx,
     state->groups = nested_groups;
     state->num_groups = num_groups;
     state->index = 0;
+    state->num_active = 0;
     state->nesting_level = nesting_level;
 
-    /* process each group individually */
+    /* process each group individually, several of them in parallel */
     ret = sdap_nested_group_recurse_step(req);
     if (ret != EAGAIN) {
         goto immediately;
@@ -1289,34 +1335,42 @@ static errno_t sdap_nested_group_recurse_step(struct tevent_req *req)
 
     state = tevent_req_data(req, struct sdap_nested_group_recurse_state);
 
-    if (state->index >= state->num_groups) {
-        /* we're done */
-        return EOK;
-    }
+    while (state->index < state->num_groups
+            && state->num_active < state->group_ctx->max_lookups) {
+        subreq = sdap_nested_group_process_send(state, state->ev,
+                                                state->group_ctx,
+                                                state->nesting_level,
+                                                state->groups[state->index]);
+        if (subreq == NULL) {
+            return ENOMEM;
+        }
 
-    subreq = sdap_nested_group_process_send(state, state->ev, state->group_ctx,
-                                            state->nesting_level,
-                                            state->groups[state->index]);
-    if (subreq == NULL) {
-        return ENOMEM;
-    }
+        tevent_req_set_callback(subreq, sdap_nested_group_recurse_done, req);
 
-    tevent_req_set_callback(subreq, sdap_nested_group_recurse_done, req);
+        state->index++;
+        state->num_active++;
+    }
 
-    state->index++;
+    if (state->num_active > 0) {
+        return EAGAIN;
+    }
 
-    return EAGAIN;
+    /* we're done */
+    return EOK;
 }
 
 static void sdap_nested_group_recurse_done(struct tevent_req *subreq)
 {
+    struct sdap_nested_group_recurse_state *state = NULL;
     struct tevent_req *req = NULL;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_nested_group_recurse_state);
 
     ret = sdap_nested_group_process_recv(subreq);
     talloc_zfree(subreq);
+    state->num_active--;
     if (ret != EOK) {
         goto done;
     }
@@ -1341,23 +1395,362 @@ static errno_t sdap_nested_group_recurse_recv(struct tevent_req *req)
 }
 
 struct sdap_nested_group_single_state {
+    struct sdap_nested_group_single_state *prev;
+    struct sdap_nested_group_single_state *next;
+
+    struct tevent_req *req;
     struct tevent_context *ev;
     struct sdap_nested_group_ctx *group_ctx;
     struct sdap_nested_group_member *members;
     int nesting_level;
 
-    struct sdap_nested_group_member *current_member;
     int num_members;
     int member_index;
+    int num_lookups;
+    bool waiting;
+
+    /* NULL if every member is looked up on its own */
+    struct sdap_nested_group_batch *batches;
+    int num_batches;
+    int batch_index;
 
     struct sysdb_attrs **nested_groups;
     int num_groups;
 };
 
+struct sdap_nested_group_single_lookup {
+    struct tevent_req *req;
+    struct sdap_nested_group_single_state *state;
+    struct sdap_nested_group_member *member;
+    struct sdap_nested_group_batch *batch;
+};
+
 static errno_t sdap_nested_group_single_step(struct tevent_req *req);
 static void sdap_nested_group_single_step_done(struct tevent_req *subreq);
 static void sdap_nested_group_single_done(struct tevent_req *subreq);
 
+static int
+sdap_nested_group_single_state_destructor(
+                                    struct sdap_nested_group_single_state *state)
+{
+    if (state->waiting) {
+        DLIST_REMOVE(state->group_ctx->waiting, state);
+        state->waiting = false;
+    }
+
+    return 0;
+}
+
+static int
+sdap_nested_group_single_lookup_destructor(
+                                struct sdap_nested_group_single_lookup *lookup)
+{
+    lookup->state->num_lookups--;
+    lookup->state->group_ctx->num_lookups--;
+
+    return 0;
+}
+
+static errno_t
+sdap_nested_group_batch_key(TALLOC_CTX *mem_ctx,
+                            struct ldb_context *ldb,
+                            struct sdap_nested_group_ctx *group_ctx,
+                            struct sdap_nested_group_member *member,
+                            char **_key,
+                            const char **_base_dn,
+                            struct ldb_dn **_dn,
+                            char **_rdn_filter)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *dn;
+    struct ldb_dn *parent;
+    const struct ldb_val *rdn_val;
+    const char *rdn_name;
+    const char *base_dn;
+    const char *casefold;
+    const char *filter;
+    char *rdn_value;
+    char *sanitized;
+    char *key;
+    char *rdn_filter;
+    errno_t ret;
+
+    switch (member->type) {
+    case SDAP_NESTED_GROUP_DN_USER:
+        if (group_ctx->opts->schema_type == SDAP_SCHEMA_IPA_V1) {
+            /* IPA users are not looked up at all */
+            return EINVAL;
+        }
+        break;
+    case SDAP_NESTED_GROUP_DN_GROUP:
+        break;
+    case SDAP_NESTED_GROUP_DN_UNKNOWN:
+        return EINVAL;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dn = ldb_dn_new(tmp_ctx, ldb, member->dn);
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (!ldb_dn_validate(dn) || ldb_dn_get_comp_num(dn) < 2) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    rdn_name = ldb_dn_get_rdn_name(dn);
+    rdn_val = ldb_dn_get_rdn_val(dn);
+    parent = ldb_dn_get_parent(tmp_ctx, dn);
+    if (rdn_name == NULL || rdn_val == NULL || parent == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    base_dn = ldb_dn_get_linearized(parent);
+    if (base_dn == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    rdn_value = talloc_strndup(tmp_ctx, (const char *)rdn_val->data,
+                               rdn_val->length);
+    if (rdn_value == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_filter_sanitize(tmp_ctx, rdn_value, &sanitized);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    rdn_filter = talloc_asprintf(tmp_ctx, "(%s=%s)", rdn_name, sanitized);
+    if (rdn_filter == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    filter = member->type == SDAP_NESTED_GROUP_DN_USER ? member->user_filter
+                                                       : member->group_filter;
+    casefold = ldb_dn_get_casefold(parent);
+    if (casefold == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    key = talloc_asprintf(tmp_ctx, "%d:%s:%s", member->type, casefold,
+                          filter == NULL ? "" : filter);
+    if (key == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    *_key = talloc_steal(mem_ctx, key);
+    *_base_dn = talloc_strdup(mem_ctx, base_dn);
+    *_dn = talloc_steal(mem_ctx, dn);
+    *_rdn_filter = talloc_steal(mem_ctx, rdn_filter);
+    if (*_base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+SSS_HASH_MAP_TYPED(sdap_nested_group_batch_map, struct sdap_nested_group_batch)
+
+/* Split members into batches of up to batch_size members. Members that
+ * cannot be looked up together end up in a batch of their own. */
+static errno_t
+sdap_nested_group_batch_members(TALLOC_CTX *mem_ctx,
+                                struct sdap_nested_group_ctx *group_ctx,
+                                struct sdap_nested_group_member *members,
+                                int num_members,
+                                struct sdap_nested_group_batch **_batches,
+                                int *_num_batches)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sdap_nested_group_batch *batches;
+    struct sdap_nested_group_batch *batch;
+    struct ldb_context *ldb;
+    struct sss_hash_map *open_batches;
+    const char *base_dn;
+    struct ldb_dn *dn;
+    char *rdn_filter;
+    char *key_str;
+    int num_batches = 0;
+    int size;
+    int i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    open_batches = sss_hash_map_create(tmp_ctx, 0);
+    if (open_batches == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    batches = talloc_zero_array(tmp_ctx, struct sdap_nested_group_batch,
+                                num_members);
+    if (batches == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ldb = sysdb_ctx_get_ldb(group_ctx->domain->sysdb);
+
+    for (i = 0; i < num_members; i++) {
+        batch = NULL;
+        key_str = NULL;
+        base_dn = NULL;
+        dn = NULL;
+        rdn_filter = NULL;
+
+        ret = sdap_nested_group_batch_key(batches, ldb, group_ctx,
+                                          &members[i], &key_str, &base_dn,
+                                          &dn, &rdn_filter);
+        if (ret == EOK) {
+            batch = sdap_nested_group_batch_map_lookup(open_batches, key_str);
+        } else if (ret != EINVAL) {
+            goto done;
+        }
+
+        if (batch == NULL) {
+            batch = &batches[num_batches];
+            /* only the remaining members can join the batch */
+            size = key_str == NULL ? 1 : MIN(group_ctx->batch_size,
+                                             num_members - i);
+
+            batch->type = members[i].type;
+            batch->base_dn = base_dn;
+            batch->filter = members[i].type == SDAP_NESTED_GROUP_DN_USER
+                                ? members[i].user_filter
+                                : members[i].group_filter;
+            batch->members = talloc_zero_array(batches,
+                                            struct sdap_nested_group_member *,
+                                            size);
+            batch->dns = talloc_zero_array(batches, struct ldb_dn *, size);
+            batch->rdn_filters = talloc_zero_array(batches, const char *,
+                                                   size);
+            if (batch->members == NULL || batch->dns == NULL
+                    || batch->rdn_filters == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            if (key_str != NULL) {
+                ret = sdap_nested_group_batch_map_add(open_batches, key_str,
+                                                      batch);
+                if (ret != EOK) {
+                    goto done;
+                }
+            }
+
+            num_batches++;
+        }
+
+        batch->members[batch->num_members] = &members[i];
+        batch->dns[batch->num_members] = dn;
+        batch->rdn_filters[batch->num_members] = rdn_filter;
+        batch->num_members++;
+
+        if (key_str != NULL && batch->num_members >= group_ctx->batch_size) {
+            /* the batch is full, the next member starts a new one */
+            sdap_nested_group_batch_map_delete(open_batches, key_str);
+        }
+
+        talloc_free(key_str);
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "%d members will be looked up with "
+          "%d searches\n", num_members, num_batches);
+
+    *_batches = talloc_steal(mem_ctx, batches);
+    *_num_batches = num_batches;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static bool
+sdap_nested_group_single_has_next(struct sdap_nested_group_single_state *state)
+{
+    if (state->batches == NULL) {
+        return state->member_index < state->num_members;
+    }
+
+    return state->batch_index < state->num_batches;
+}
+
+static void
+sdap_nested_group_single_next(struct sdap_nested_group_single_state *state,
+                              struct sdap_nested_group_member **_member,
+                              struct sdap_nested_group_batch **_batch)
+{
+    struct sdap_nested_group_batch *batch;
+
+    if (state->batches == NULL) {
+        *_member = &state->members[state->member_index];
+        *_batch = NULL;
+        state->member_index++;
+        return;
+    }
+
+    batch = &state->batches[state->batch_index];
+    state->batch_index++;
+
+    if (batch->num_members == 1) {
+        /* a base search is cheaper for a single member */
+        *_member = batch->members[0];
+        *_batch = NULL;
+    } else {
+        *_member = NULL;
+        *_batch = batch;
+    }
+}
+
+static void
+sdap_nested_group_single_wakeup(struct tevent_context *ev,
+                                struct tevent_immediate *imm,
+                                void *pvt)
+{
+    struct sdap_nested_group_ctx *group_ctx;
+    struct sdap_nested_group_single_state *state;
+    errno_t ret;
+
+    group_ctx = talloc_get_type(pvt, struct sdap_nested_group_ctx);
+
+    while (group_ctx->waiting != NULL
+            && group_ctx->num_lookups < group_ctx->max_lookups) {
+        state = group_ctx->waiting;
+
+        /* a waiting group always has members left to look up */
+        ret = sdap_nested_group_single_step(state->req);
+        if (ret != EAGAIN) {
+            /* the whole operation may be gone after this */
+            tevent_req_error(state->req, ret == EOK ? EINVAL : ret);
+            return;
+        }
+    }
+}
+
 static struct tevent_req *
 sdap_nested_group_single_send(TALLOC_CTX *mem_ctx,
                               struct tevent_context *ev,
@@ -1378,13 +1771,16 @@ sdap_nested_group_single_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    state->req = req;
     state->ev = ev;
     state->group_ctx = group_ctx;
     state->members = members;
     state->nesting_level = nesting_level;
-    state->current_member = NULL;
     state->num_members = num_members;
     state->member_index = 0;
+    state->num_lookups = 0;
+    state->waiting = false;
+    talloc_set_destructor(state, sdap_nested_group_single_state_destructor);
     state->nested_groups = talloc_zero_array(state, struct sysdb_attrs *,
                                              num_groups_max);
     if (state->nested_groups == NULL) {
@@ -1393,7 +1789,18 @@ sdap_nested_group_single_send(TALLOC_CTX *mem_ctx,
     }
     state->num_groups = 0; /* we will count exact number of the groups */
 
-    /* process each member individually */
+    if (group_ctx->batch_size > 1 && num_members > 1) {
+        ret = sdap_nested_group_batch_members(state, group_ctx, members,
+                                              num_members, &state->batches,
+                                              &state->num_batches);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to batch members [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto immediately;
+        }
+    }
+
+    /* process each member individually, up to max_lookups in parallel */
     ret = sdap_nested_group_single_step(req);
     if (ret != EAGAIN) {
         goto immediately;
@@ -1415,60 +1822,167 @@ immediately:
 static errno_t sdap_nested_group_single_step(struct tevent_req *req)
 {
     struct sdap_nested_group_single_state *state = NULL;
+    struct sdap_nested_group_ctx *group_ctx = NULL;
+    struct sdap_nested_group_single_lookup *lookup = NULL;
     struct tevent_req *subreq = NULL;
 
     state = tevent_req_data(req, struct sdap_nested_group_single_state);
+    group_ctx = state->group_ctx;
 
-    if (state->member_index >= state->num_members) {
-        /* we're done */
-        return EOK;
+    if (state->waiting) {
+        DLIST_REMOVE(group_ctx->waiting, state);
+        state->waiting = false;
     }
 
-    state->current_member = &state->members[state->member_index];
-    state->member_index++;
+    while (sdap_nested_group_single_has_next(state)) {
+        if (group_ctx->num_lookups >= group_ctx->max_lookups) {
+            /* wait until a lookup of any group finishes */
+            DLIST_ADD_END(group_ctx->waiting, state,
+                          struct sdap_nested_group_single_state *);
+            state->waiting = true;
+            return EAGAIN;
+        }
+
+        lookup = talloc_zero(state, struct sdap_nested_group_single_lookup);
+        if (lookup == NULL) {
+            return ENOMEM;
+        }
+
+        lookup->req = req;
+        lookup->state = state;
+        sdap_nested_group_single_next(state, &lookup->member, &lookup->batch);
+
+        state->num_lookups++;
+        group_ctx->num_lookups++;
+        talloc_set_destructor(lookup,
+                              sdap_nested_group_single_lookup_destructor);
 
-    switch (state->current_member->type) {
+        if (lookup->batch != NULL) {
+            subreq = sdap_nested_group_lookup_batch_send(lookup, state->ev,
+                                                         group_ctx,
+                                                         lookup->batch);
+        } else {
+            switch (lookup->member->type) {
+            case SDAP_NESTED_GROUP_DN_USER:
+                subreq = sdap_nested_group_lookup_user_send(lookup, state->ev,
+                                                            group_ctx,
+                                                            lookup->member);
+                break;
+            case SDAP_NESTED_GROUP_DN_GROUP:
+                subreq = sdap_nested_group_lookup_group_send(lookup, state->ev,
+                                                             group_ctx,
+                                                             lookup->member);
+                break;
+            case SDAP_NESTED_GROUP_DN_UNKNOWN:
+                subreq = sdap_nested_group_lookup_unknown_send(lookup,
+                                                               state->ev,
+                                                               group_ctx,
+                                                               lookup->member);
+                break;
+            }
+        }
+
+        if (subreq == NULL) {
+            talloc_free(lookup);
+            return ENOMEM;
+        }
+
+        tevent_req_set_callback(subreq, sdap_nested_group_single_step_done,
+                                lookup);
+    }
+
+    if (state->num_lookups > 0) {
+        return EAGAIN;
+    }
+
+    /* we're done */
+    return EOK;
+}
+
+static errno_t
+sdap_nested_group_single_save(struct sdap_nested_group_single_state *state,
+                              enum sdap_nested_group_dn_type type,
+                              struct sysdb_attrs *entry)
+{
+    errno_t ret;
+
+    switch (type) {
     case SDAP_NESTED_GROUP_DN_USER:
-        subreq = sdap_nested_group_lookup_user_send(state, state->ev,
-                                                    state->group_ctx,
-                                                    state->current_member);
+        /* save user in hash table */
+        ret = sdap_nested_group_hash_user(state->group_ctx, entry);
+        if (ret == EEXIST) {
+            /* the user is already present, skip it */
+            talloc_zfree(entry);
+            return EOK;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save user in hash table "
+                                        "[%d]: %s\n", ret, strerror(ret));
+            return ret;
+        }
         break;
     case SDAP_NESTED_GROUP_DN_GROUP:
-        subreq = sdap_nested_group_lookup_group_send(state, state->ev,
-                                                     state->group_ctx,
-                                                     state->current_member);
+        /* save group in hash table */
+        ret = sdap_nested_group_hash_group(state->group_ctx, entry);
+        if (ret == EEXIST) {
+            /* the group is already present, skip it */
+            talloc_zfree(entry);
+            return EOK;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save group in hash table "
+                                        "[%d]: %s\n", ret, strerror(ret));
+            return ret;
+        }
+
+        /* remember the group for later processing */
+        state->nested_groups[state->num_groups] = entry;
+        state->num_groups++;
         break;
     case SDAP_NESTED_GROUP_DN_UNKNOWN:
-        subreq = sdap_nested_group_lookup_unknown_send(state, state->ev,
-                                                   state->group_ctx,
-                                                   state->current_member);
         break;
     }
 
-    if (subreq == NULL) {
-        return ENOMEM;
+    return EOK;
+}
+
+static errno_t
+sdap_nested_group_single_batch_process(struct sdap_nested_group_single_state *state,
+                                       struct sdap_nested_group_batch *batch,
+                                       struct tevent_req *subreq)
+{
+    struct sysdb_attrs **entries = NULL;
+    size_t num_entries = 0;
+    size_t i;
+    errno_t ret;
+
+    ret = sdap_nested_group_lookup_batch_recv(state, subreq,
+                                              &entries, &num_entries);
+    if (ret != EOK) {
+        return ret;
     }
 
-    tevent_req_set_callback(subreq, sdap_nested_group_single_step_done, req);
+    for (i = 0; i < num_entries; i++) {
+        ret = sdap_nested_group_single_save(state, batch->type, entries[i]);
+        if (ret != EOK) {
+            break;
+        }
+    }
 
-    return EAGAIN;
+    talloc_free(entries);
+    return ret;
 }
 
 static errno_t
-sdap_nested_group_single_step_process(struct tevent_req *subreq)
+sdap_nested_group_single_step_process(struct sdap_nested_group_single_state *state,
+                                      struct sdap_nested_group_member *member,
+                                      struct tevent_req *subreq)
 {
-    struct sdap_nested_group_single_state *state = NULL;
-    struct tevent_req *req = NULL;
     struct sysdb_attrs *entry = NULL;
     enum sdap_nested_group_dn_type type = SDAP_NESTED_GROUP_DN_UNKNOWN;
     const char *orig_dn = NULL;
     errno_t ret;
 
-    req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct sdap_nested_group_single_state);
-
     /* set correct type if possible */
-    if (state->current_member->type == SDAP_NESTED_GROUP_DN_UNKNOWN) {
+    if (member->type == SDAP_NESTED_GROUP_DN_UNKNOWN) {
         ret = sdap_nested_group_lookup_unknown_recv(state, subreq,
                                                     &entry, &type);
         if (ret != EOK) {
@@ -1476,11 +1990,11 @@ sdap_nested_group_single_step_process(struct tevent_req *subreq)
         }
 
         if (entry != NULL) {
-            state->current_member->type = type;
+            member->type = type;
         }
     }
 
-    switch (state->current_member->type) {
+    switch (member->type) {
     case SDAP_NESTED_GROUP_DN_USER:
         if (entry == NULL) {
             /* type was not unknown, receive data */
@@ -1495,16 +2009,8 @@ sdap_nested_group_single_step_process(struct tevent_req *subreq)
             }
         }
 
-        /* save user in hash table */
-        ret = sdap_nested_group_hash_user(state->group_ctx, entry);
-        if (ret == EEXIST) {
-            /* the user is already present, skip it */
-            talloc_zfree(entry);
-            ret = EOK;
-            goto done;
-        } else if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save user in hash table "
-                                        "[%d]: %s\n", ret, strerror(ret));
+        ret = sdap_nested_group_single_save(state, member->type, entry);
+        if (ret != EOK) {
             goto done;
         }
         break;
@@ -1538,23 +2044,10 @@ sdap_nested_group_single_step_process(struct tevent_req *subreq)
             }
         }
 
-        /* save group in hash table */
-        ret = sdap_nested_group_hash_group(state->group_ctx, entry);
-        if (ret == EEXIST) {
-            /* the group is already present, skip it */
-            talloc_zfree(entry);
-            ret = EOK;
-            goto done;
-        } else if (ret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to save group in hash table "
-                                        "[%d]: %s\n", ret, strerror(ret));
+        ret = sdap_nested_group_single_save(state, member->type, entry);
+        if (ret != EOK) {
             goto done;
         }
-
-        /* remember the group for later processing */
-        state->nested_groups[state->num_groups] = entry;
-        state->num_groups++;
-
         break;
     case SDAP_NESTED_GROUP_DN_UNKNOWN:
         /* not found in users nor nested_groups, continue */
@@ -1570,15 +2063,32 @@ done:
 static void sdap_nested_group_single_step_done(struct tevent_req *subreq)
 {
     struct sdap_nested_group_single_state *state = NULL;
+    struct sdap_nested_group_single_lookup *lookup = NULL;
     struct tevent_req *req = NULL;
     errno_t ret;
 
-    req = tevent_req_callback_data(subreq, struct tevent_req);
+    lookup = tevent_req_callback_data(subreq,
+                                      struct sdap_nested_group_single_lookup);
+    req = lookup->req;
     state = tevent_req_data(req, struct sdap_nested_group_single_state);
 
     /* process direct members */
-    ret = sdap_nested_group_single_step_process(subreq);
-    talloc_zfree(subreq);
+    if (lookup->batch != NULL) {
+        ret = sdap_nested_group_single_batch_process(state, lookup->batch,
+                                                     subreq);
+    } else {
+        ret = sdap_nested_group_single_step_process(state, lookup->member,
+                                                    subreq);
+    }
+    talloc_zfree(lookup);
+
+    /* let other groups use the free slot once we are done here */
+    if (state->group_ctx->waiting != NULL) {
+        tevent_schedule_immediate(state->group_ctx->wakeup, state->ev,
+                                  sdap_nested_group_single_wakeup,
+                                  state->group_ctx);
+    }
+
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Error processing direct membership "
                                     "[%d]: %s\n", ret, strerror(ret));
@@ -2000,6 +2510,263 @@ static errno_t sdap_nested_group_lookup_group_recv(TALLOC_CTX *mem_ctx,
      return EOK;
 }
 
+struct sdap_nested_group_lookup_batch_state {
+    struct sdap_nested_group_batch *batch;
+    struct ldb_context *ldb;
+    struct sysdb_attrs **entries;
+    size_t num_entries;
+};
+
+static void sdap_nested_group_lookup_batch_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sdap_nested_group_lookup_batch_send(TALLOC_CTX *mem_ctx,
+                                    struct tevent_context *ev,
+                                    struct sdap_nested_group_ctx *group_ctx,
+                                    struct sdap_nested_group_batch *batch)
+{
+    struct sdap_nested_group_lookup_batch_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct tevent_req *subreq = NULL;
+    struct sdap_attr_map *map = NULL;
+    size_t map_num;
+    const char **attrs = NULL;
+    const char *base_filter = NULL;
+    const char *filter = NULL;
+    char *member_filter = NULL;
+    char *oc_list;
+    errno_t ret;
+    int i;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sdap_nested_group_lookup_batch_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->batch = batch;
+    state->ldb = sysdb_ctx_get_ldb(group_ctx->domain->sysdb);
+
+    /* same attributes and filters as if the members were looked up
+     * one by one */
+    if (batch->type == SDAP_NESTED_GROUP_DN_USER) {
+        map = group_ctx->opts->user_map;
+        map_num = group_ctx->opts->user_map_cnt;
+
+        attrs = talloc_array(state, const char *, 3);
+        if (attrs == NULL) {
+            ret = ENOMEM;
+            goto immediately;
+        }
+
+        attrs[0] = "objectClass";
+        attrs[1] = map[SDAP_AT_USER_NAME].name;
+        attrs[2] = NULL;
+
+        base_filter = talloc_asprintf(state, "(objectclass=%s)",
+                                      map[SDAP_OC_USER].name);
+    } else {
+        map = group_ctx->opts->group_map;
+        map_num = SDAP_OPTS_GROUP;
+
+        ret = build_attrs_from_map(state, map, SDAP_OPTS_GROUP, NULL,
+                                   &attrs, NULL);
+        if (ret != EOK) {
+            goto immediately;
+        }
+
+        oc_list = sdap_make_oc_list(state, map);
+        if (oc_list == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to create objectClass list.\n");
+            ret = ENOMEM;
+            goto immediately;
+        }
+
+        base_filter = talloc_asprintf(state, "(&(%s)(%s=*))", oc_list,
+                                      map[SDAP_AT_GROUP_NAME].name);
+    }
+    if (base_filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    member_filter = talloc_strdup(state, "(|");
+    for (i = 0; i < batch->num_members && member_filter != NULL; i++) {
+        member_filter = talloc_strdup_append_buffer(member_filter,
+                                                    batch->rdn_filters[i]);
+    }
+    if (member_filter != NULL) {
+        member_filter = talloc_strdup_append_buffer(member_filter, ")");
+    }
+    if (member_filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    base_filter = talloc_asprintf(state, "(&%s%s)", base_filter,
+                                  member_filter);
+    if (base_filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    /* use search base filter if needed */
+    filter = sdap_combine_filters(state, base_filter, batch->filter);
+    if (filter == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Looking up %d members under [%s]\n",
+          batch->num_members, batch->base_dn);
+
+    subreq = sdap_get_generic_send(state, ev, group_ctx->opts, group_ctx->sh,
+                                   batch->base_dn, LDAP_SCOPE_ONELEVEL,
+                                   filter, attrs, map, map_num,
+                                   dp_opt_get_int(group_ctx->opts->basic,
+                                                  SDAP_SEARCH_TIMEOUT),
+                                   false);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    tevent_req_set_callback(subreq, sdap_nested_group_lookup_batch_done, req);
+
+    return req;
+
+immediately:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+/* The RDN attributes may have more values than the RDN, keep only entries
+ * that are one of the requested members. */
+static int
+sdap_nested_group_lookup_batch_match(struct sdap_nested_group_lookup_batch_state *state,
+                                     struct sysdb_attrs *entry,
+                                     bool *matched)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *dn;
+    const char *orig_dn;
+    int found = -1;
+    errno_t ret;
+    int i;
+
+    ret = sysdb_attrs_get_string(entry, SYSDB_ORIG_DN, &orig_dn);
+    if (ret != EOK) {
+        return -1;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return -1;
+    }
+
+    dn = ldb_dn_new(tmp_ctx, state->ldb, orig_dn);
+    if (dn == NULL || !ldb_dn_validate(dn)) {
+        goto done;
+    }
+
+    for (i = 0; i < state->batch->num_members; i++) {
+        if (!matched[i] && ldb_dn_compare(dn, state->batch->dns[i]) == 0) {
+            found = i;
+            break;
+        }
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return found;
+}
+
+static void sdap_nested_group_lookup_batch_done(struct tevent_req *subreq)
+{
+    struct sdap_nested_group_lookup_batch_state *state = NULL;
+    struct tevent_req *req = NULL;
+    struct sysdb_attrs **reply = NULL;
+    bool *matched = NULL;
+    size_t count = 0;
+    size_t i;
+    int index;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_nested_group_lookup_batch_state);
+
+    ret = sdap_get_generic_recv(subreq, state, &count, &reply);
+    talloc_zfree(subreq);
+    if (ret == ENOENT) {
+        count = 0;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    state->entries = talloc_zero_array(state, struct sysdb_attrs *,
+                                       state->batch->num_members + 1);
+    matched = talloc_zero_array(state, bool, state->batch->num_members);
+    if (state->entries == NULL || matched == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        index = sdap_nested_group_lookup_batch_match(state, reply[i],
+                                                     matched);
+        if (index < 0) {
+            DEBUG(SSSDBG_TRACE_ALL, "Skipping entry that was not "
+                  "requested\n");
+            continue;
+        }
+
+        matched[index] = true;
+        state->entries[state->num_entries] = talloc_steal(state->entries,
+                                                          reply[i]);
+        state->num_entries++;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Found %zu of %d members under [%s]\n",
+          state->num_entries, state->batch->num_members,
+          state->batch->base_dn);
+
+    ret = EOK;
+
+done:
+    talloc_free(matched);
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t
+sdap_nested_group_lookup_batch_recv(TALLOC_CTX *mem_ctx,
+                                    struct tevent_req *req,
+                                    struct sysdb_attrs ***_entries,
+                                    size_t *_num_entries)
+{
+    struct sdap_nested_group_lookup_batch_state *state = NULL;
+    state = tevent_req_data(req, struct sdap_nested_group_lookup_batch_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_entries = talloc_steal(mem_ctx, state->entries);
+    *_num_entries = state->num_entries;
+
+    return EOK;
+}
+
 struct sdap_nested_group_lookup_unknown_state {
     struct tevent_context *ev;
     struct sdap_nested_group_ctx *group_ctx;
@@ -559,7 +559,7 @@ static errno_t netgroup_translate_ldap_members_recv(struct tevent_req *req,
 
 /* ==Search-Netgroups-with-filter============================================ */
 
-struct sdap_get_netgroups_state {
+struct sdap_search_netgroups_state {
     struct tevent_context *ev;
     struct sdap_options *opts;
     struct sdap_handle *sh;
@@ -569,8 +569,9 @@ struct sdap_get_netgroups_state {
     const char *base_filter;
     char *filter;
     int timeout;
+    /* Search all bases instead of stopping at the first one with results */
+    bool all_bases;
 
-    char *higher_timestamp;
     struct sysdb_attrs **netgroups;
     size_t count;
 
@@ -578,26 +579,56 @@ struct sdap_get_netgroups_state {
     struct sdap_search_base **search_bases;
 };
 
-static errno_t sdap_get_netgroups_next_base(struct tevent_req *req);
-static void sdap_get_netgroups_process(struct tevent_req *subreq);
+static errno_t sdap_concat_attrs_arrays(TALLOC_CTX *mem_ctx,
+                                        struct sysdb_attrs ***_dest,
+                                        size_t *_dest_count,
+                                        struct sysdb_attrs **src,
+                                        size_t src_count)
+{
+    struct sysdb_attrs **dest;
+    size_t c;
+
+    dest = talloc_realloc(mem_ctx, *_dest, struct sysdb_attrs *,
+                          *_dest_count + src_count + 1);
+    if (dest == NULL) {
+        return ENOMEM;
+    }
+
+    for (c = 0; c < src_count; c++) {
+        dest[*_dest_count + c] = talloc_steal(dest, src[c]);
+    }
+    dest[*_dest_count + src_count] = NULL;
+
+    *_dest = dest;
+    *_dest_count += src_count;
+
+    return EOK;
+}
+
+static errno_t sdap_search_netgroups_next_base(struct tevent_req *req);
+static void sdap_search_netgroups_process(struct tevent_req *subreq);
 static void netgr_translate_members_done(struct tevent_req *subreq);
 
-struct tevent_req *sdap_get_netgroups_send(TALLOC_CTX *memctx,
-                                           struct tevent_context *ev,
-                                           struct sss_domain_info *dom,
-                                           struct sysdb_ctx *sysdb,
-                                           struct sdap_options *opts,
-                                           struct sdap_search_base **search_bases,
-                                           struct sdap_handle *sh,
-                                           const char **attrs,
-                                           const char *filter,
-                                           int timeout)
+/* Searches netgroups and translates their members, nothing is saved. */
+static struct tevent_req *
+sdap_search_netgroups_send(TALLOC_CTX *memctx,
+                           struct tevent_context *ev,
+                           struct sss_domain_info *dom,
+                           struct sysdb_ctx *sysdb,
+                           struct sdap_options *opts,
+                           struct sdap_search_base **search_bases,
+                           struct sdap_handle *sh,
+                           const char **attrs,
+                           const char *filter,
+                           int timeout,
+                           bool all_bases)
 {
     errno_t ret;
     struct tevent_req *req;
-    struct sdap_get_netgroups_state *state;
+    struct sdap_search_netgroups_state *state;
 
-    req = tevent_req_create(memctx, &state, struct sdap_get_netgroups_state);
+    req = tevent_req_create(memctx, &state,
+                            struct sdap_search_netgroups_state);
     if (!req) return NULL;
 
     state->ev = ev;
@@ -606,13 +637,13 @@ struct tevent_req *sdap_get_netgroups_send(TALLOC_CTX *memctx,
     state->sh = sh;
     state->sysdb = sysdb;
     state->attrs = attrs;
-    state->higher_timestamp = NULL;
     state->netgroups =  NULL;
     state->count = 0;
     state->timeout = timeout;
     state->base_filter = filter;
     state->base_iter = 0;
     state->search_bases = search_bases;
+    state->all_bases = all_bases;
 
     if (!state->search_bases) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -622,7 +653,7 @@ struct tevent_req *sdap_get_netgroups_send(TALLOC_CTX *memctx,
     }
 
 
-    ret = sdap_get_netgroups_next_base(req);
+    ret = sdap_search_netgroups_next_base(req);
 
 done:
     if (ret != EOK) {
@@ -632,12 +663,12 @@ done:
     return req;
 }
 
-static errno_t sdap_get_netgroups_next_base(struct tevent_req *req)
+static errno_t sdap_search_netgroups_next_base(struct tevent_req *req)
 {
     struct tevent_req *subreq;
-    struct sdap_get_netgroups_state *state;
+    struct sdap_search_netgroups_state *state;
 
-    state = tevent_req_data(req, struct sdap_get_netgroups_state);
+    state = tevent_req_data(req, struct sdap_search_netgroups_state);
 
     talloc_zfree(state->filter);
     state->filter = sdap_combine_filters(state, state->base_filter,
@@ -661,21 +692,22 @@ static errno_t sdap_get_netgroups_next_base(struct tevent_req *req)
     if (!subreq) {
         return ENOMEM;
     }
-    tevent_req_set_callback(subreq, sdap_get_netgroups_process, req);
+    tevent_req_set_callback(subreq, sdap_search_netgroups_process, req);
 
     return EOK;
 }
 
-static void sdap_get_netgroups_process(struct tevent_req *subreq)
+static void sdap_search_netgroups_process(struct tevent_req *subreq)
 {
     struct tevent_req *req = tevent_req_callback_data(subreq,
                                                       struct tevent_req);
-    struct sdap_get_netgroups_state *state = tevent_req_data(req,
-                                               struct sdap_get_netgroups_state);
+    struct sdap_search_netgroups_state *state = tevent_req_data(req,
+                                          struct sdap_search_netgroups_state);
+    struct sysdb_attrs **netgroups;
+    size_t count;
     int ret;
 
-    ret = sdap_get_generic_recv(subreq, state,
-                                &state->count, &state->netgroups);
+    ret = sdap_get_generic_recv(subreq, state, &count, &netgroups);
     talloc_zfree(subreq);
     if (ret) {
         tevent_req_error(req, ret);
@@ -683,20 +715,30 @@ static void sdap_get_netgroups_process(struct tevent_req *subreq)
     }
 
     DEBUG(SSSDBG_TRACE_FUNC,
-          "Search for netgroups, returned %zu results.\n", state->count);
+          "Search for netgroups, returned %zu results.\n", count);
 
-    if (state->count == 0) {
-        /* No netgroups found in this search */
+    if (count > 0) {
+        ret = sdap_concat_attrs_arrays(state, &state->netgroups, &state->count,
+                                       netgroups, count);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+    }
+
+    if (state->count == 0 || state->all_bases) {
         state->base_iter++;
         if (state->search_bases[state->base_iter]) {
             /* There are more search bases to try */
-            ret = sdap_get_netgroups_next_base(req);
+            ret = sdap_search_netgroups_next_base(req);
             if (ret != EOK) {
                 tevent_req_error(req, ENOENT);
             }
             return;
         }
+    }
 
+    if (state->count == 0) {
         tevent_req_error(req, ENOENT);
         return;
     }
@@ -718,11 +760,9 @@ static void netgr_translate_members_done(struct tevent_req *subreq)
 {
     struct tevent_req *req = tevent_req_callback_data(subreq,
                                                       struct tevent_req);
-    struct sdap_get_netgroups_state *state = tevent_req_data(req,
-                                               struct sdap_get_netgroups_state);
+    struct sdap_search_netgroups_state *state = tevent_req_data(req,
+                                          struct sdap_search_netgroups_state);
     int ret;
-    size_t c;
-    time_t now;
 
     ret = netgroup_translate_ldap_members_recv(subreq, state, &state->count,
                                                &state->netgroups);
@@ -732,24 +772,403 @@ static void netgr_translate_members_done(struct tevent_req *subreq)
         return;
     }
 
+    tevent_req_done(req);
+}
+
+static errno_t sdap_search_netgroups_recv(struct tevent_req *req,
+                                          TALLOC_CTX *mem_ctx,
+                                          size_t *_count,
+                                          struct sysdb_attrs ***_netgroups)
+{
+    struct sdap_search_netgroups_state *state = tevent_req_data(req,
+                                          struct sdap_search_netgroups_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_count = state->count;
+    *_netgroups = talloc_steal(mem_ctx, state->netgroups);
+
+    return EOK;
+}
+
+/* ==Search-Netgroups-with-nested-netgroups================================== */
+
+/* Nested netgroups are looked up level by level with this many names in one
+ * OR filter and at most this many searches at the same time. */
+#define SDAP_NETGROUP_BATCH_SIZE 32
+#define SDAP_NETGROUP_MAX_SEARCHES 4
+
+struct sdap_get_netgroups_state {
+    struct tevent_context *ev;
+    struct sdap_options *opts;
+    struct sdap_handle *sh;
+    struct sss_domain_info *dom;
+    struct sysdb_ctx *sysdb;
+    struct sdap_search_base **search_bases;
+    const char **attrs;
+    int timeout;
+
+    char *higher_timestamp;
+
+    /* Netgroups matching the filter. */
+    struct sysdb_attrs **netgroups;
+    size_t count;
+
+    /* The whole tree, saved at once when it is complete. */
+    struct sysdb_attrs **tree;
+    size_t tree_count;
+
+    /* Names of netgroups which were already seen in the tree. */
+    hash_table_t *seen;
+
+    /* Nested netgroups of the level being looked up and of the next one. */
+    const char **level;
+    size_t level_count;
+    size_t level_iter;
+    const char **next_level;
+    size_t next_level_count;
+    size_t num_searches;
+};
+
+static void sdap_get_netgroups_top_done(struct tevent_req *subreq);
+static errno_t sdap_get_netgroups_nested_step(struct tevent_req *req);
+static void sdap_get_netgroups_nested_done(struct tevent_req *subreq);
+static errno_t sdap_get_netgroups_save(struct sdap_get_netgroups_state *state);
+
+struct tevent_req *sdap_get_netgroups_send(TALLOC_CTX *memctx,
+                                           struct tevent_context *ev,
+                                           struct sss_domain_info *dom,
+                                           struct sysdb_ctx *sysdb,
+                                           struct sdap_options *opts,
+                                           struct sdap_search_base **search_bases,
+                                           struct sdap_handle *sh,
+                                           const char **attrs,
+                                           const char *filter,
+                                           int timeout)
+{
+    errno_t ret;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    struct sdap_get_netgroups_state *state;
+
+    req = tevent_req_create(memctx, &state, struct sdap_get_netgroups_state);
+    if (!req) return NULL;
+
+    state->ev = ev;
+    state->opts = opts;
+    state->dom = dom;
+    state->sh = sh;
+    state->sysdb = sysdb;
+    state->search_bases = search_bases;
+    state->attrs = attrs;
+    state->timeout = timeout;
+
+    ret = sss_hash_create(state, 0, &state->seen);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    subreq = sdap_search_netgroups_send(state, ev, dom, sysdb, opts,
+                                        search_bases, sh, attrs, filter,
+                                        timeout, false);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    tevent_req_set_callback(subreq, sdap_get_netgroups_top_done, req);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+    return req;
+}
+
+static errno_t
+sdap_get_netgroups_add_to_tree(struct sdap_get_netgroups_state *state,
+                               struct sysdb_attrs **netgroups,
+                               size_t count)
+{
+    const char **members;
+    const char *name;
+    const char **next;
+    hash_key_t key;
+    hash_value_t value;
+    size_t c;
+    size_t mc;
+    errno_t ret;
+    int hret;
+
+    ret = sdap_concat_attrs_arrays(state, &state->tree, &state->tree_count,
+                                   netgroups, count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_UNDEF;
+
+    /* Netgroups found by this search must not be searched again. */
+    for (c = 0; c < count; c++) {
+        ret = sysdb_attrs_get_string(netgroups[c], SYSDB_NAME, &name);
+        if (ret != EOK) {
+            continue;
+        }
+
+        key.str = discard_const(name);
+        hret = hash_enter(state->seen, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            return ENOMEM;
+        }
+    }
+
+    for (c = 0; c < count; c++) {
+        ret = sysdb_attrs_get_string_array(netgroups[c], SYSDB_NETGROUP_MEMBER,
+                                           state, &members);
+        if (ret == ENOENT) {
+            continue;
+        } else if (ret != EOK) {
+            return ret;
+        }
+
+        for (mc = 0; members[mc] != NULL; mc++) {
+            key.str = discard_const(members[mc]);
+            if (hash_has_key(state->seen, &key)) {
+                continue;
+            }
+
+            hret = hash_enter(state->seen, &key, &value);
+            if (hret != HASH_SUCCESS) {
+                return ENOMEM;
+            }
+
+            next = talloc_realloc(state, state->next_level, const char *,
+                                  state->next_level_count + 1);
+            if (next == NULL) {
+                return ENOMEM;
+            }
+            state->next_level = next;
+            state->next_level[state->next_level_count] = members[mc];
+            state->next_level_count++;
+        }
+    }
+
+    return EOK;
+}
+
+static void sdap_get_netgroups_top_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct sdap_get_netgroups_state *state = tevent_req_data(req,
+                                               struct sdap_get_netgroups_state);
+    int ret;
+
+    ret = sdap_search_netgroups_recv(subreq, state, &state->count,
+                                     &state->netgroups);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sdap_get_netgroups_add_to_tree(state, state->netgroups,
+                                         state->count);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sdap_get_netgroups_nested_step(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static char *
+sdap_get_netgroups_batch_filter(TALLOC_CTX *mem_ctx,
+                                struct sdap_get_netgroups_state *state,
+                                const char **names,
+                                size_t count)
+{
+    char *filter;
+    char *clean_name;
+    size_t c;
+    errno_t ret;
+
+    filter = talloc_asprintf(mem_ctx, "(&(objectclass=%s)(|",
+                         state->opts->netgroup_map[SDAP_OC_NETGROUP].name);
+    if (filter == NULL) {
+        return NULL;
+    }
+
+    for (c = 0; c < count; c++) {
+        ret = sss_filter_sanitize(filter, names[c], &clean_name);
+        if (ret != EOK) {
+            talloc_free(filter);
+            return NULL;
+        }
+
+        filter = talloc_asprintf_append_buffer(filter, "(%s=%s)",
+                         state->opts->netgroup_map[SDAP_AT_NETGROUP_NAME].name,
+                         clean_name);
+        if (filter == NULL) {
+            return NULL;
+        }
+    }
+
+    return talloc_asprintf_append_buffer(filter, "))");
+}
+
+/* Returns EOK when the whole tree was looked up and saved, EAGAIN while
+ * searches are running. */
+static errno_t sdap_get_netgroups_nested_step(struct tevent_req *req)
+{
+    struct sdap_get_netgroups_state *state = tevent_req_data(req,
+                                               struct sdap_get_netgroups_state);
+    struct tevent_req *subreq;
+    char *filter;
+    size_t count;
+
+    while (state->num_searches < SDAP_NETGROUP_MAX_SEARCHES) {
+        if (state->level_iter == state->level_count) {
+            if (state->num_searches > 0) {
+                /* The next level is complete when these searches are. */
+                break;
+            }
+
+            if (state->next_level_count == 0) {
+                /* No more nested netgroups. */
+                return sdap_get_netgroups_save(state);
+            }
+
+            talloc_zfree(state->level);
+            state->level = state->next_level;
+            state->level_count = state->next_level_count;
+            state->level_iter = 0;
+            state->next_level = NULL;
+            state->next_level_count = 0;
+
+            DEBUG(SSSDBG_TRACE_FUNC, "Looking up %zu nested netgroups\n",
+                  state->level_count);
+        }
+
+        count = MIN(SDAP_NETGROUP_BATCH_SIZE,
+                    state->level_count - state->level_iter);
+
+        filter = sdap_get_netgroups_batch_filter(state, state,
+                                                 state->level + state->level_iter,
+                                                 count);
+        if (filter == NULL) {
+            return ENOMEM;
+        }
+
+        subreq = sdap_search_netgroups_send(state, state->ev, state->dom,
+                                            state->sysdb, state->opts,
+                                            state->search_bases, state->sh,
+                                            state->attrs, filter,
+                                            state->timeout, true);
+        if (subreq == NULL) {
+            return ENOMEM;
+        }
+        talloc_steal(subreq, filter);
+        tevent_req_set_callback(subreq, sdap_get_netgroups_nested_done, req);
+
+        state->level_iter += count;
+        state->num_searches++;
+    }
+
+    return EAGAIN;
+}
+
+static void sdap_get_netgroups_nested_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct sdap_get_netgroups_state *state = tevent_req_data(req,
+                                               struct sdap_get_netgroups_state);
+    struct sysdb_attrs **netgroups;
+    size_t count;
+    int ret;
+
+    state->num_searches--;
+
+    ret = sdap_search_netgroups_recv(subreq, state, &count, &netgroups);
+    talloc_zfree(subreq);
+    if (ret == EOK) {
+        ret = sdap_get_netgroups_add_to_tree(state, netgroups, count);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+    } else if (ret != ENOENT) {
+        /* Nested netgroups are also looked up on their own when they are
+         * needed, do not fail the requested netgroup because of them. */
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to look up nested netgroups [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
+    ret = sdap_get_netgroups_nested_step(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static errno_t sdap_get_netgroups_save(struct sdap_get_netgroups_state *state)
+{
+    bool in_transaction = false;
+    size_t c;
+    time_t now;
+    errno_t ret;
+    errno_t tret;
+
+    ret = sysdb_transaction_start(state->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
     now = time(NULL);
-    for (c = 0; c < state->count; c++) {
+    for (c = 0; c < state->tree_count; c++) {
         ret = sdap_save_netgroup(state,
                                  state->dom,
                                  state->opts,
-                                 state->netgroups[c],
+                                 state->tree[c],
                                  &state->higher_timestamp,
                                  now);
         if (ret) {
             DEBUG(SSSDBG_OP_FAILURE, "Failed to store netgroups.\n");
-            tevent_req_error(req, ret);
-            return;
+            goto done;
         }
     }
 
-    DEBUG(SSSDBG_TRACE_ALL, "Saving %zu Netgroups - Done\n", state->count);
+    ret = sysdb_transaction_commit(state->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_ALL, "Saving %zu Netgroups - Done\n", state->tree_count);
 
-    tevent_req_done(req);
+done:
+    if (in_transaction) {
+        tret = sysdb_transaction_cancel(state->sysdb);
+        if (tret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to cancel transaction\n");
+        }
+    }
+
+    return ret;
 }
 
 int sdap_get_netgroups_recv(struct tevent_req *req,
@@ -586,8 +586,6 @@ static void sdap_sudo_refresh_done(struct tevent_req *subreq)
     char *usn = NULL;
     int dp_error;
     int ret;
-    errno_t sret;
-    bool in_transaction = false;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
     state = tevent_req_data(req, struct sdap_sudo_refresh_state);
@@ -616,34 +614,14 @@ static void sdap_sudo_refresh_done(struct tevent_req *subreq)
         goto done;
     }
 
-    /* start transaction */
-    ret = sysdb_transaction_start(state->sysdb);
+    /* Replace only the rules that changed and do not hold a single
+     * transaction for the whole rule set, the sudo responder would be
+     * blocked until it is committed. */
+    ret = sysdb_sudo_update(state->domain, state->delete_filter,
+                            rules, rules_count);
     if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
         goto done;
     }
-    in_transaction = true;
-
-    /* purge cache */
-    ret = sysdb_sudo_purge(state->domain, state->delete_filter,
-                           rules, rules_count);
-    if (ret != EOK) {
-        goto done;
-    }
-
-    /* store rules */
-    ret = sysdb_sudo_store(state->domain, rules, rules_count);
-    if (ret != EOK) {
-        goto done;
-    }
-
-    /* commit transaction */
-    ret = sysdb_transaction_commit(state->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
-        goto done;
-    }
-    in_transaction = false;
 
     DEBUG(SSSDBG_TRACE_FUNC, "Sudoers is successfully stored in cache\n");
 
@@ -662,13 +640,6 @@ static void sdap_sudo_refresh_done(struct tevent_req *subreq)
     state->num_rules = rules_count;
 
 done:
-    if (in_transaction) {
-        sret = sysdb_transaction_cancel(state->sysdb);
-        if (sret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "Could not cancel transaction\n");
-        }
-    }
-
     state->dp_error = dp_error;
     if (ret == EOK) {
         tevent_req_done(req);
@@ -180,6 +180,7 @@ int sdap_save_user(TALLOC_CTX *memctx,
     struct ldb_message_element *el;
     int ret;
     const char *user_name = NULL;
+    const char *sync_uuid;
     const char *fullname = NULL;
     const char *pwd;
     const char *gecos;
@@ -248,6 +249,15 @@ int sdap_save_user(TALLOC_CTX *memctx,
               "Failed to retrieve UUID [%d][%s].\n", ret, sss_strerror(ret));
     }
 
+    /* Set by content synchronization to find the user when it is deleted */
+    ret = sysdb_attrs_get_string(attrs, SYSDB_SYNC_UUID, &sync_uuid);
+    if (ret == EOK) {
+        ret = sysdb_attrs_add_string(user_attrs, SYSDB_SYNC_UUID, sync_uuid);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     /* If this object has a SID available, we will determine the correct
      * domain by its SID. */
     if (sid_str != NULL) {
@@ -762,26 +772,37 @@ struct sdap_search_user_state {
     struct sysdb_attrs **users;
     size_t count;
 
+    /* Users handed over page by page instead of being returned. */
+    sdap_page_cb page_cb;
+    void *page_pvt;
+    size_t paged_count;
+
     size_t base_iter;
     struct sdap_search_base **search_bases;
 };
 
 static errno_t sdap_search_user_next_base(struct tevent_req *req);
+static errno_t sdap_search_user_page(struct sysdb_attrs **users,
+                                     size_t count,
+                                     void *pvt);
 static void sdap_search_user_copy_batch(struct sdap_search_user_state *state,
                                         struct sysdb_attrs **users,
                                         size_t count);
 static void sdap_search_user_process(struct tevent_req *subreq);
 
-struct tevent_req *sdap_search_user_send(TALLOC_CTX *memctx,
-                                         struct tevent_context *ev,
-                                         struct sss_domain_info *dom,
-                                         struct sdap_options *opts,
-                                         struct sdap_search_base **search_bases,
-                                         struct sdap_handle *sh,
-                                         const char **attrs,
-                                         const char *filter,
-                                         int timeout,
-                                         enum sdap_entry_lookup_type lookup_type)
+static struct tevent_req *
+sdap_search_user_paged_send(TALLOC_CTX *memctx,
+                            struct tevent_context *ev,
+                            struct sss_domain_info *dom,
+                            struct sdap_options *opts,
+                            struct sdap_search_base **search_bases,
+                            struct sdap_handle *sh,
+                            const char **attrs,
+                            const char *filter,
+                            int timeout,
+                            enum sdap_entry_lookup_type lookup_type,
+                            sdap_page_cb page_cb,
+                            void *page_pvt)
 {
     errno_t ret;
     struct tevent_req *req;
@@ -803,6 +824,8 @@ struct tevent_req *sdap_search_user_send(TALLOC_CTX *memctx,
     state->base_iter = 0;
     state->search_bases = search_bases;
     state->lookup_type = lookup_type;
+    state->page_cb = page_cb;
+    state->page_pvt = page_pvt;
 
     if (!state->search_bases) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -822,6 +845,22 @@ done:
     return req;
 }
 
+struct tevent_req *sdap_search_user_send(TALLOC_CTX *memctx,
+                                         struct tevent_context *ev,
+                                         struct sss_domain_info *dom,
+                                         struct sdap_options *opts,
+                                         struct sdap_search_base **search_bases,
+                                         struct sdap_handle *sh,
+                                         const char **attrs,
+                                         const char *filter,
+                                         int timeout,
+                                         enum sdap_entry_lookup_type lookup_type)
+{
+    return sdap_search_user_paged_send(memctx, ev, dom, opts, search_bases,
+                                       sh, attrs, filter, timeout,
+                                       lookup_type, NULL, NULL);
+}
+
 static errno_t sdap_search_user_next_base(struct tevent_req *req)
 {
     struct tevent_req *subreq;
@@ -857,14 +896,25 @@ static errno_t sdap_search_user_next_base(struct tevent_req *req)
         break;
     }
 
-    subreq = sdap_get_and_parse_generic_send(
-            state, state->ev, state->opts, state->sh,
-            state->search_bases[state->base_iter]->basedn,
-            state->search_bases[state->base_iter]->scope,
-            state->filter, state->attrs,
-            state->opts->user_map, state->opts->user_map_cnt,
-            0, NULL, NULL, sizelimit, state->timeout,
-            need_paging);
+    if (state->page_cb != NULL) {
+        subreq = sdap_get_and_parse_generic_paged_send(
+                state, state->ev, state->opts, state->sh,
+                state->search_bases[state->base_iter]->basedn,
+                state->search_bases[state->base_iter]->scope,
+                state->filter, state->attrs,
+                state->opts->user_map, state->opts->user_map_cnt,
+                sizelimit, state->timeout,
+                sdap_search_user_page, req);
+    } else {
+        subreq = sdap_get_and_parse_generic_send(
+                state, state->ev, state->opts, state->sh,
+                state->search_bases[state->base_iter]->basedn,
+                state->search_bases[state->base_iter]->scope,
+                state->filter, state->attrs,
+                state->opts->user_map, state->opts->user_map_cnt,
+                0, NULL, NULL, sizelimit, state->timeout,
+                need_paging);
+    }
     if (subreq == NULL) {
         return ENOMEM;
     }
@@ -873,6 +923,27 @@ static errno_t sdap_search_user_next_base(struct tevent_req *req)
     return EOK;
 }
 
+static errno_t sdap_search_user_page(struct sysdb_attrs **users,
+                                     size_t count,
+                                     void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct sdap_search_user_state *state = tevent_req_data(req,
+                                            struct sdap_search_user_state);
+    errno_t ret;
+
+    /* Paged lookups are never filtered by domain, see
+     * sdap_search_user_copy_batch(). */
+    ret = state->page_cb(users, count, state->page_pvt);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    state->paged_count += count;
+
+    return EOK;
+}
+
 static void sdap_search_user_process(struct tevent_req *subreq)
 {
     struct tevent_req *req = tevent_req_callback_data(subreq,
@@ -929,12 +1000,13 @@ static void sdap_search_user_process(struct tevent_req *subreq)
         }
     }
 
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Retrieved total %zu users\n", state->count);
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Retrieved total %zu users\n",
+          state->count + state->paged_count);
 
     /* No more search bases
      * Return ENOENT if no users were found
      */
-    if (state->count == 0) {
+    if (state->count == 0 && state->paged_count == 0) {
         tevent_req_error(req, ENOENT);
         return;
     }
@@ -997,8 +1069,14 @@ struct sdap_get_users_state {
     struct sysdb_attrs **users;
     struct sysdb_attrs *mapped_attrs;
     size_t count;
+
+    char *paged_usn;
+    size_t paged_count;
 };
 
+static errno_t sdap_get_users_save_page(struct sysdb_attrs **users,
+                                        size_t count,
+                                        void *pvt);
 static void sdap_get_users_done(struct tevent_req *subreq);
 
 struct tevent_req *sdap_get_users_send(TALLOC_CTX *memctx,
@@ -1046,8 +1124,19 @@ struct tevent_req *sdap_get_users_send(TALLOC_CTX *memctx,
         }
     }
 
-    subreq = sdap_search_user_send(state, ev, dom, opts, search_bases,
-                                   sh, attrs, filter, timeout, lookup_type);
+    if (lookup_type == SDAP_LOOKUP_ENUMERATE && mapped_attrs == NULL) {
+        /* Store every page while the next one is being retrieved instead
+         * of holding the whole enumeration in memory. */
+        subreq = sdap_search_user_paged_send(state, ev, dom, opts,
+                                             search_bases, sh, attrs,
+                                             filter, timeout, lookup_type,
+                                             sdap_get_users_save_page,
+                                             state);
+    } else {
+        subreq = sdap_search_user_send(state, ev, dom, opts, search_bases,
+                                       sh, attrs, filter, timeout,
+                                       lookup_type);
+    }
     if (subreq == NULL) {
         ret = ENOMEM;
         goto done;
@@ -1064,6 +1153,49 @@ done:
     return req;
 }
 
+static void sdap_get_users_update_usn(struct sdap_get_users_state *state,
+                                      char *usn_value)
+{
+    if (usn_value == NULL) {
+        return;
+    }
+
+    if (state->paged_usn != NULL
+            && strlen(usn_value) <= strlen(state->paged_usn)
+            && strcmp(usn_value, state->paged_usn) <= 0) {
+        talloc_free(usn_value);
+        return;
+    }
+
+    talloc_free(state->paged_usn);
+    state->paged_usn = usn_value;
+}
+
+static errno_t sdap_get_users_save_page(struct sysdb_attrs **users,
+                                        size_t count,
+                                        void *pvt)
+{
+    struct sdap_get_users_state *state =
+                talloc_get_type(pvt, struct sdap_get_users_state);
+    char *usn_value = NULL;
+    errno_t ret;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Saving a page of %zu users\n", count);
+
+    ret = sdap_save_users(state, state->sysdb, state->dom, state->opts,
+                          users, count, NULL, &usn_value);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to store users [%d][%s].\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    sdap_get_users_update_usn(state, usn_value);
+    state->paged_count += count;
+
+    return EOK;
+}
+
 static void sdap_get_users_done(struct tevent_req *subreq)
 {
     struct tevent_req *req = tevent_req_callback_data(subreq,
@@ -1098,7 +1230,14 @@ static void sdap_get_users_done(struct tevent_req *subreq)
         return;
     }
 
-    DEBUG(SSSDBG_TRACE_ALL, "Saving %zu Users - Done\n", state->count);
+    if (state->paged_count > 0) {
+        sdap_get_users_update_usn(state, state->higher_usn);
+        state->higher_usn = state->paged_usn;
+        state->paged_usn = NULL;
+    }
+
+    DEBUG(SSSDBG_TRACE_ALL, "Saving %zu Users - Done\n",
+          state->count + state->paged_count);
 
     tevent_req_done(req);
 }
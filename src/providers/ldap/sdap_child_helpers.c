@@ -106,33 +106,23 @@ static errno_t sdap_fork_child(struct tevent_context *ev,
         goto fail;
     }
 
-    pid = fork();
-
-    if (pid == 0) { /* child */
-        exec_child(child,
-                   pipefd_to_child, pipefd_from_child,
-                   LDAP_CHILD, LDAP_CHILD_LOG_FILE);
-
-        /* We should never get here */
-        DEBUG(SSSDBG_CRIT_FAILURE, "BUG: Could not exec LDAP child\n");
-    } else if (pid > 0) { /* parent */
-        child->pid = pid;
-        child->io->read_from_child_fd = pipefd_from_child[0];
-        PIPE_FD_CLOSE(pipefd_from_child[1]);
-        child->io->write_to_child_fd = pipefd_to_child[1];
-        PIPE_FD_CLOSE(pipefd_to_child[0]);
-        sss_fd_nonblocking(child->io->read_from_child_fd);
-        sss_fd_nonblocking(child->io->write_to_child_fd);
-
-        ret = child_handler_setup(ev, pid, child_callback, req, NULL);
-        if (ret != EOK) {
-            goto fail;
-        }
-
-    } else { /* error */
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "fork failed [%d][%s].\n", ret, strerror(ret));
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child,
+                          LDAP_CHILD, LDAP_CHILD_LOG_FILE, NULL, false,
+                          STDIN_FILENO, STDOUT_FILENO, &pid);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    child->pid = pid;
+    child->io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    child->io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(child->io->read_from_child_fd);
+    sss_fd_nonblocking(child->io->write_to_child_fd);
+
+    ret = child_handler_setup(ev, pid, child_callback, req, NULL);
+    if (ret != EOK) {
         goto fail;
     }
 
@@ -44,6 +44,32 @@ sdap_domain_get(struct sdap_options *opts,
     return sditer;
 }
 
+void *sdap_domain_get_pvt(struct sdap_domain *sdom)
+{
+    void *pvt;
+    errno_t ret;
+
+    if (sdom == NULL) {
+        return NULL;
+    }
+
+    if (sdom->pvt == NULL && sdom->pvt_init != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Initializing domain [%s] on first use\n",
+              sdom->dom->name);
+
+        ret = sdom->pvt_init(sdom, sdom->pvt_init_data, &pvt);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to initialize domain [%s] "
+                  "[%d]: %s\n", sdom->dom->name, ret, sss_strerror(ret));
+            return NULL;
+        }
+
+        sdom->pvt = pvt;
+    }
+
+    return sdom->pvt;
+}
+
 struct sdap_domain *
 sdap_domain_get_by_dn(struct sdap_options *opts,
                       const char *dn)
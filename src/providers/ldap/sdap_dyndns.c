@@ -44,6 +44,7 @@ sdap_dyndns_get_addrs_recv(struct tevent_req *req,
 struct sdap_dyndns_update_state {
     struct tevent_context *ev;
     struct be_resolv_ctx *be_res;
+    struct be_nsupdate_ctx *dyndns_ctx;
     struct dp_option *opts;
 
     const char *hostname;
@@ -68,9 +69,7 @@ static void sdap_dyndns_dns_addrs_done(struct tevent_req *subreq);
 static errno_t sdap_dyndns_addrs_diff(struct sdap_dyndns_update_state *state,
                                       bool *_do_update);
 static errno_t sdap_dyndns_update_step(struct tevent_req *req);
-static errno_t sdap_dyndns_update_ptr_step(struct tevent_req *req);
 static void sdap_dyndns_update_done(struct tevent_req *subreq);
-static void sdap_dyndns_update_ptr_done(struct tevent_req *subreq);
 
 static bool should_retry(int nsupdate_ret, int child_status)
 {
@@ -86,9 +85,8 @@ struct tevent_req *
 sdap_dyndns_update_send(TALLOC_CTX *mem_ctx,
                         struct tevent_context *ev,
                         struct be_ctx *be_ctx,
-                        struct dp_option *opts,
+                        struct be_nsupdate_ctx *dyndns_ctx,
                         struct sdap_id_ctx *sdap_ctx,
-                        enum be_nsupdate_auth auth_type,
                         const char *ifname,
                         const char *hostname,
                         const char *realm,
@@ -99,6 +97,7 @@ sdap_dyndns_update_send(TALLOC_CTX *mem_ctx,
     struct tevent_req *req;
     struct tevent_req *subreq;
     struct sdap_dyndns_update_state *state;
+    struct dp_option *opts = dyndns_ctx->opts;
     const char *conf_servername;
 
     req = tevent_req_create(mem_ctx, &state, struct sdap_dyndns_update_state);
@@ -115,8 +114,9 @@ sdap_dyndns_update_send(TALLOC_CTX *mem_ctx,
     state->ttl = ttl;
     state->be_res = be_ctx->be_res;
     state->ev = ev;
+    state->dyndns_ctx = dyndns_ctx;
     state->opts = opts;
-    state->auth_type = auth_type;
+    state->auth_type = dyndns_ctx->auth_type;
 
     /* fallback servername is overridden by user option */
     conf_servername = dp_opt_get_string(opts, DP_OPT_DYNDNS_SERVER);
@@ -185,6 +185,14 @@ sdap_dyndns_update_addrs_done(struct tevent_req *subreq)
         return;
     }
 
+    if (be_nsupdate_addrs_unchanged(state->dyndns_ctx, state->hostname,
+                                    state->addresses)) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Addresses did not change since the last "
+              "update, no DNS update needed\n");
+        tevent_req_done(req);
+        return;
+    }
+
     if (state->check_diff || state->update_ptr) {
         /* Check if we need the update at all. In case we are updating the PTR
          * records as well, we need to know the old addresses to be able to
@@ -316,6 +324,9 @@ sdap_dyndns_addrs_diff(struct sdap_dyndns_update_state *state, bool *_do_update)
     return EOK;
 }
 
+/* The PTR records are usually in a different zone, so they can not be part
+ * of the same DNS update message. They are sent by the same nsupdate child,
+ * though, so that one refresh only forks once. */
 static errno_t
 sdap_dyndns_update_step(struct tevent_req *req)
 {
@@ -323,6 +334,7 @@ sdap_dyndns_update_step(struct tevent_req *req)
     struct sdap_dyndns_update_state *state;
     const char *servername;
     const char *realm;
+    char *ptr_msg;
     struct tevent_req *subreq;
 
     state = tevent_req_data(req, struct sdap_dyndns_update_state);
@@ -334,6 +346,7 @@ sdap_dyndns_update_step(struct tevent_req *req)
         realm = state->realm;
     }
 
+    talloc_zfree(state->update_msg);
     ret = be_nsupdate_create_fwd_msg(state, realm, servername,
                                      state->hostname,
                                      state->ttl, state->remove_af,
@@ -345,6 +358,25 @@ sdap_dyndns_update_step(struct tevent_req *req)
         return ret;
     }
 
+    if (state->update_ptr) {
+        ret = be_nsupdate_create_ptr_msg(state, realm, servername,
+                                         state->hostname,
+                                         state->ttl, state->remove_af,
+                                         state->addresses,
+                                         state->update_per_family,
+                                         &ptr_msg);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Can't get addresses for DNS update\n");
+            return ret;
+        }
+
+        state->update_msg = talloc_strdup_append(state->update_msg, ptr_msg);
+        talloc_free(ptr_msg);
+        if (state->update_msg == NULL) {
+            return ENOMEM;
+        }
+    }
+
     /* Fork a child process to perform the DNS update */
     subreq = be_nsupdate_send(state, state->ev, state->auth_type,
                               state->update_msg,
@@ -383,94 +415,19 @@ sdap_dyndns_update_done(struct tevent_req *subreq)
                 return;
             }
         }
-    }
 
-    if (state->update_ptr == false) {
-        DEBUG(SSSDBG_TRACE_FUNC, "No PTR update requested, done\n");
-        tevent_req_done(req);
-        return;
-    }
-
-    talloc_free(state->update_msg);
-
-    ret = sdap_dyndns_update_ptr_step(req);
-    if (ret != EOK) {
+        /* Do not skip the next update. */
+        be_nsupdate_set_last_update(state->dyndns_ctx, NULL, NULL);
         tevent_req_error(req, ret);
         return;
     }
-    /* Execution will resume in sdap_dyndns_update_ptr_done */
-}
-
-static errno_t
-sdap_dyndns_update_ptr_step(struct tevent_req *req)
-{
-    errno_t ret;
-    struct sdap_dyndns_update_state *state;
-    const char *servername;
-    const char *realm;
-    struct tevent_req *subreq;
-
-    state = tevent_req_data(req, struct sdap_dyndns_update_state);
-
-    servername = NULL;
-    realm = NULL;
-    if (state->fallback_mode == true) {
-        servername = state->servername;
-        realm = state->realm;
-    }
-
-    ret = be_nsupdate_create_ptr_msg(state, realm, servername,
-                                     state->hostname,
-                                     state->ttl, state->remove_af,
-                                     state->addresses,
-                                     state->update_per_family,
-                                     &state->update_msg);
 
+    ret = be_nsupdate_set_last_update(state->dyndns_ctx, state->hostname,
+                                      state->addresses);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Can't get addresses for DNS update\n");
-        return ret;
-    }
-
-    /* Fork a child process to perform the DNS update */
-    subreq = be_nsupdate_send(state, state->ev, state->auth_type,
-                              state->update_msg,
-                              dp_opt_get_bool(state->opts,
-                                              DP_OPT_DYNDNS_FORCE_TCP));
-    if (subreq == NULL) {
-        return EIO;
-    }
-
-    tevent_req_set_callback(subreq, sdap_dyndns_update_ptr_done, req);
-    return EOK;
-}
-
-static void
-sdap_dyndns_update_ptr_done(struct tevent_req *subreq)
-{
-    errno_t ret;
-    int child_status;
-    struct tevent_req *req;
-    struct sdap_dyndns_update_state *state;
-
-    req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct sdap_dyndns_update_state);
-
-    ret = be_nsupdate_recv(subreq, &child_status);
-    talloc_zfree(subreq);
-    if (ret != EOK) {
-        /* If the update didn't succeed, we can retry using the server name */
-        if (state->fallback_mode == false
-                && should_retry(ret, child_status)) {
-            state->fallback_mode = true;
-            DEBUG(SSSDBG_MINOR_FAILURE, "nsupdate failed, retrying\n");
-            ret = sdap_dyndns_update_ptr_step(req);
-            if (ret == EOK) {
-                return;
-            }
-        }
-
-        tevent_req_error(req, ret);
-        return;
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot remember the updated addresses, the next update will "
+              "not be skipped [%d]: %s\n", ret, sss_strerror(ret));
     }
 
     tevent_req_done(req);
@@ -34,9 +34,8 @@ struct tevent_req *
 sdap_dyndns_update_send(TALLOC_CTX *mem_ctx,
                         struct tevent_context *ev,
                         struct be_ctx *be_ctx,
-                        struct dp_option *opts,
+                        struct be_nsupdate_ctx *dyndns_ctx,
                         struct sdap_id_ctx *sdap_ctx,
-                        enum be_nsupdate_auth auth_type,
                         const char *ifname,
                         const char *hostname,
                         const char *realm,
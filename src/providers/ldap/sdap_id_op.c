@@ -32,8 +32,13 @@ struct sdap_id_conn_cache {
 
     /* list of all open connections */
     struct sdap_id_conn_data *connections;
-    /* cached (current) connection */
-    struct sdap_id_conn_data *cached_connection;
+    /* cached (current) connections, new operations are spread among
+     * up to ldap_connection_pool_size of them */
+    struct sdap_id_conn_data **cached_connections;
+    int num_slots;
+    /* pre-bound connection that replaces the first cached connection
+     * that expires, see ldap_connection_spare */
+    struct sdap_id_conn_data *spare;
 };
 
 /* LDAP async operation tracker:
@@ -68,6 +73,10 @@ struct sdap_id_conn_data {
     struct tevent_req *connect_req;
     /* timer for connection expiration */
     struct tevent_timer *expire_timer;
+    /* timer for opening a spare connection before this one expires */
+    struct tevent_timer *spare_timer;
+    /* server options of a spare connection, used once it is rotated in */
+    struct sdap_server_opts *srv_opts;
     /* number of running connection notifies */
     int notify_lock;
     /* list of operations using connect */
@@ -76,12 +85,16 @@ struct sdap_id_conn_data {
      * connection will be disconnected and should
      * not be used any more */
     bool disconnecting;
+    /* number of operations using the connection */
+    int num_ops;
 };
 
 static void sdap_id_conn_cache_be_offline_cb(void *pvt);
 static void sdap_id_conn_cache_fo_reconnect_cb(void *pvt);
 
 static void sdap_id_release_conn_data(struct sdap_id_conn_data *conn_data);
+static bool sdap_id_conn_cache_is_cached(struct sdap_id_conn_data *conn_data);
+static void sdap_id_conn_cache_uncache(struct sdap_id_conn_data *conn_data);
 static int sdap_id_conn_data_destroy(struct sdap_id_conn_data *conn_data);
 static bool sdap_is_connection_expired(struct sdap_id_conn_data *conn_data, int timeout);
 static bool sdap_can_reuse_connection(struct sdap_id_conn_data *conn_data);
@@ -90,6 +103,15 @@ static void sdap_id_conn_data_expire_handler(struct tevent_context *ev,
                                              struct timeval current_time,
                                              void *pvt);
 static int sdap_id_conn_data_set_expire_timer(struct sdap_id_conn_data *conn_data);
+static void sdap_id_conn_data_spare_handler(struct tevent_context *ev,
+                                            struct tevent_timer *te,
+                                            struct timeval current_time,
+                                            void *pvt);
+static void sdap_id_conn_cache_open_spare(struct sdap_id_conn_cache *conn_cache);
+static void sdap_id_conn_cache_drop_spare(struct sdap_id_conn_cache *conn_cache);
+static bool sdap_id_conn_cache_use_spare(struct sdap_id_conn_cache *conn_cache,
+                                         int slot);
+static void sdap_id_conn_spare_done(struct tevent_req *subreq);
 
 static void sdap_id_op_hook_conn_data(struct sdap_id_op *op, struct sdap_id_conn_data *conn_data);
 static int sdap_id_op_destroy(void *pvt);
@@ -140,29 +162,141 @@ fail:
     return ret;
 }
 
+/* Make sure there is a slot for every connection of the pool */
+static int sdap_id_conn_cache_init_slots(struct sdap_id_conn_cache *conn_cache)
+{
+    struct sdap_id_conn_data **slots;
+    int pool_size;
+    int i;
+
+    pool_size = dp_opt_get_int(conn_cache->id_conn->id_ctx->opts->basic,
+                               SDAP_CONNECTION_POOL_SIZE);
+    if (pool_size < 1) {
+        pool_size = 1;
+    }
+
+    if (pool_size <= conn_cache->num_slots) {
+        return EOK;
+    }
+
+    slots = talloc_realloc(conn_cache, conn_cache->cached_connections,
+                           struct sdap_id_conn_data *, pool_size);
+    if (slots == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = conn_cache->num_slots; i < pool_size; i++) {
+        slots[i] = NULL;
+    }
+
+    conn_cache->cached_connections = slots;
+    conn_cache->num_slots = pool_size;
+
+    return EOK;
+}
+
+/* Check whether connection is one of the cached connections */
+static bool sdap_id_conn_cache_is_cached(struct sdap_id_conn_data *conn_data)
+{
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    int i;
+
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        if (conn_cache->cached_connections[i] == conn_data) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Drop connection from the cache, it is not used by new operations */
+static void sdap_id_conn_cache_uncache(struct sdap_id_conn_data *conn_data)
+{
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    int i;
+
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        if (conn_cache->cached_connections[i] == conn_data) {
+            conn_cache->cached_connections[i] = NULL;
+        }
+    }
+}
+
+/* Put connection into a free slot of the cache */
+static bool sdap_id_conn_cache_add(struct sdap_id_conn_data *conn_data)
+{
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    int i;
+
+    if (sdap_id_conn_cache_is_cached(conn_data)) {
+        return true;
+    }
+
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        if (conn_cache->cached_connections[i] == NULL) {
+            conn_cache->cached_connections[i] = conn_data;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Check whether some other cached connection is already established */
+static bool sdap_id_conn_cache_has_other(struct sdap_id_conn_data *conn_data)
+{
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    struct sdap_id_conn_data *cached;
+    int i;
+
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        cached = conn_cache->cached_connections[i];
+        if (cached != NULL && cached != conn_data && cached->sh != NULL
+                && cached->sh->connected && cached->connect_req == NULL) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /* Callback on BE going offline */
 static void sdap_id_conn_cache_be_offline_cb(void *pvt)
 {
     struct sdap_id_conn_cache *conn_cache = talloc_get_type(pvt, struct sdap_id_conn_cache);
-    struct sdap_id_conn_data *cached_connection = conn_cache->cached_connection;
+    struct sdap_id_conn_data *cached_connection;
+    int i;
 
     /* Release any cached connection on going offline */
-    if (cached_connection != NULL) {
-        conn_cache->cached_connection = NULL;
-        sdap_id_release_conn_data(cached_connection);
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        cached_connection = conn_cache->cached_connections[i];
+        if (cached_connection != NULL) {
+            conn_cache->cached_connections[i] = NULL;
+            sdap_id_release_conn_data(cached_connection);
+        }
     }
+
+    sdap_id_conn_cache_drop_spare(conn_cache);
 }
 
 /* Callback for attempt to reconnect to primary server */
 static void sdap_id_conn_cache_fo_reconnect_cb(void *pvt)
 {
     struct sdap_id_conn_cache *conn_cache = talloc_get_type(pvt, struct sdap_id_conn_cache);
-    struct sdap_id_conn_data *cached_connection = conn_cache->cached_connection;
+    struct sdap_id_conn_data *cached_connection;
+    int i;
 
     /* Release any cached connection on going offline */
-    if (cached_connection != NULL) {
-        cached_connection->disconnecting = true;
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        cached_connection = conn_cache->cached_connections[i];
+        if (cached_connection != NULL) {
+            cached_connection->disconnecting = true;
+        }
     }
+
+    /* The spare connection is to the server that is being left */
+    sdap_id_conn_cache_drop_spare(conn_cache);
 }
 
 /* Release sdap_id_conn_data and destroy it if no longer needed */
@@ -175,7 +309,7 @@ static void sdap_id_release_conn_data(struct sdap_id_conn_data *conn_data)
     }
 
     conn_cache = conn_data->conn_cache;
-    if (conn_data == conn_cache->cached_connection) {
+    if (sdap_id_conn_cache_is_cached(conn_data)) {
         return;
     }
 
@@ -195,6 +329,7 @@ static int sdap_id_conn_data_destroy(struct sdap_id_conn_data *conn_data)
         op->conn_data = NULL;
         DLIST_REMOVE(conn_data->ops, op);
     }
+    conn_data->num_ops = 0;
 
     return 0;
 }
@@ -233,7 +368,9 @@ static bool sdap_can_reuse_connection(struct sdap_id_conn_data *conn_data)
 /* Set expiration timer for connection if needed */
 static int sdap_id_conn_data_set_expire_timer(struct sdap_id_conn_data *conn_data)
 {
+    struct dp_option *opts = conn_data->conn_cache->id_conn->id_ctx->opts->basic;
     int timeout;
+    int lead;
     struct timeval tv;
 
     memset(&tv, 0, sizeof(tv));
@@ -243,8 +380,7 @@ static int sdap_id_conn_data_set_expire_timer(struct sdap_id_conn_data *conn_dat
         return EOK;
     }
 
-    timeout = dp_opt_get_int(conn_data->conn_cache->id_conn->id_ctx->opts->basic,
-                             SDAP_OPT_TIMEOUT);
+    timeout = dp_opt_get_int(opts, SDAP_OPT_TIMEOUT);
     if (timeout > 0) {
         tv.tv_sec -= timeout;
     }
@@ -264,6 +400,30 @@ static int sdap_id_conn_data_set_expire_timer(struct sdap_id_conn_data *conn_dat
         return ENOMEM;
     }
 
+    if (!dp_opt_get_bool(opts, SDAP_CONNECTION_SPARE)) {
+        return EOK;
+    }
+
+    /* Leave enough time to connect and bind the spare connection before
+     * this one is released. */
+    lead = dp_opt_get_int(opts, SDAP_NETWORK_TIMEOUT)
+           + dp_opt_get_int(opts, SDAP_OPT_TIMEOUT);
+    tv.tv_sec -= lead;
+    if (tv.tv_sec < time(NULL)) {
+        tv.tv_sec = time(NULL);
+    }
+
+    talloc_zfree(conn_data->spare_timer);
+
+    conn_data->spare_timer =
+              tevent_add_timer(conn_data->conn_cache->id_conn->id_ctx->be->ev,
+                               conn_data, tv,
+                               sdap_id_conn_data_spare_handler,
+                               conn_data);
+    if (!conn_data->spare_timer) {
+        return ENOMEM;
+    }
+
     return EOK;
 }
 
@@ -276,15 +436,160 @@ static void sdap_id_conn_data_expire_handler(struct tevent_context *ev,
     struct sdap_id_conn_data *conn_data = talloc_get_type(pvt,
                                                           struct sdap_id_conn_data);
     struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    int i;
 
     DEBUG(SSSDBG_MINOR_FAILURE,
           "connection is about to expire, releasing it\n");
 
-    if (conn_cache->cached_connection == conn_data) {
-        conn_cache->cached_connection = NULL;
+    conn_data->expire_timer = NULL;
 
-        sdap_id_release_conn_data(conn_data);
+    if (!sdap_id_conn_cache_is_cached(conn_data)) {
+        return;
+    }
+
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        if (conn_cache->cached_connections[i] == conn_data) {
+            conn_cache->cached_connections[i] = NULL;
+            sdap_id_conn_cache_use_spare(conn_cache, i);
+        }
+    }
+
+    sdap_id_release_conn_data(conn_data);
+}
+
+/* Handler for the timer that opens a spare connection */
+static void sdap_id_conn_data_spare_handler(struct tevent_context *ev,
+                                            struct tevent_timer *te,
+                                            struct timeval current_time,
+                                            void *pvt)
+{
+    struct sdap_id_conn_data *conn_data = talloc_get_type(pvt,
+                                                          struct sdap_id_conn_data);
+
+    conn_data->spare_timer = NULL;
+
+    if (!sdap_id_conn_cache_is_cached(conn_data)
+            || conn_data->disconnecting) {
+        return;
+    }
+
+    sdap_id_conn_cache_open_spare(conn_data->conn_cache);
+}
+
+/* Start connecting a spare connection in the background */
+static void sdap_id_conn_cache_open_spare(struct sdap_id_conn_cache *conn_cache)
+{
+    struct sdap_id_conn_ctx *id_conn = conn_cache->id_conn;
+    struct sdap_id_conn_data *conn_data;
+    struct tevent_req *subreq;
+
+    if (conn_cache->spare != NULL || be_is_offline(id_conn->id_ctx->be)) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "opening spare connection\n");
+
+    conn_data = talloc_zero(conn_cache, struct sdap_id_conn_data);
+    if (conn_data == NULL) {
+        return;
+    }
+
+    talloc_set_destructor(conn_data, sdap_id_conn_data_destroy);
+    conn_data->conn_cache = conn_cache;
+
+    subreq = sdap_cli_connect_send(conn_data, id_conn->id_ctx->be->ev,
+                                   id_conn->id_ctx->opts,
+                                   id_conn->id_ctx->be,
+                                   id_conn->service, false,
+                                   CON_TLS_DFL, false);
+    if (subreq == NULL) {
+        talloc_free(conn_data);
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sdap_id_conn_spare_done, conn_data);
+    conn_data->connect_req = subreq;
+    conn_cache->spare = conn_data;
+}
+
+/* Subrequest callback for spare connection completion */
+static void sdap_id_conn_spare_done(struct tevent_req *subreq)
+{
+    struct sdap_id_conn_data *conn_data =
+                tevent_req_callback_data(subreq, struct sdap_id_conn_data);
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    struct sdap_server_opts *srv_opts = NULL;
+    bool can_retry = false;
+    int ret;
+
+    ret = sdap_cli_connect_recv(subreq, conn_data, &can_retry,
+                                &conn_data->sh, &srv_opts);
+    conn_data->connect_req = NULL;
+    talloc_zfree(subreq);
+
+    if (ret == EOK && (!conn_data->sh || !conn_data->sh->connected)) {
+        ret = EFAULT;
+    }
+
+    if (ret != EOK) {
+        /* Expiring connections are replaced the usual way */
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to open spare connection [%d]: %s\n",
+              ret, sss_strerror(ret));
+        sdap_id_conn_cache_drop_spare(conn_cache);
+        return;
     }
+
+    conn_data->srv_opts = talloc_steal(conn_data, srv_opts);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "spare connection is ready\n");
+}
+
+/* Release the spare connection, an ongoing connection attempt is cancelled */
+static void sdap_id_conn_cache_drop_spare(struct sdap_id_conn_cache *conn_cache)
+{
+    if (conn_cache->spare == NULL) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_ALL, "releasing spare connection\n");
+    talloc_zfree(conn_cache->spare);
+}
+
+/* Put the spare connection into the given empty slot of the cache */
+static bool sdap_id_conn_cache_use_spare(struct sdap_id_conn_cache *conn_cache,
+                                         int slot)
+{
+    struct sdap_id_conn_data *spare = conn_cache->spare;
+    errno_t ret;
+
+    if (spare == NULL || spare->connect_req != NULL) {
+        return false;
+    }
+
+    if (!sdap_can_reuse_connection(spare)) {
+        sdap_id_conn_cache_drop_spare(conn_cache);
+        return false;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "rotating in spare connection\n");
+
+    conn_cache->spare = NULL;
+    DLIST_ADD(conn_cache->connections, spare);
+    conn_cache->cached_connections[slot] = spare;
+
+    if (spare->srv_opts != NULL) {
+        sdap_steal_server_opts(conn_cache->id_conn->id_ctx, &spare->srv_opts);
+    }
+
+    ret = sdap_id_conn_data_set_expire_timer(spare);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "sdap_id_conn_data_set_expire_timer() failed [%d]: %s",
+              ret, sss_strerror(ret));
+    }
+
+    return true;
 }
 
 /* Create an operation object */
@@ -316,12 +621,14 @@ static void sdap_id_op_hook_conn_data(struct sdap_id_op *op, struct sdap_id_conn
 
     if (current) {
         DLIST_REMOVE(current->ops, op);
+        current->num_ops--;
     }
 
     op->conn_data = conn_data;
 
     if (conn_data) {
         DLIST_ADD_END(conn_data->ops, op, struct sdap_id_op*);
+        conn_data->num_ops++;
     }
 
     if (current) {
@@ -458,10 +765,53 @@ static int sdap_id_op_connect_step(struct tevent_req *req)
 
     int ret = EOK;
     struct sdap_id_conn_data *conn_data;
+    struct sdap_id_conn_data *best = NULL;
+    struct sdap_id_conn_data *connecting = NULL;
     struct tevent_req *subreq = NULL;
+    bool free_slot = false;
+    int i;
+
+    ret = sdap_id_conn_cache_init_slots(conn_cache);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* Try to reuse the cached connection with the fewest operations */
+    for (i = 0; i < conn_cache->num_slots; i++) {
+        conn_data = conn_cache->cached_connections[i];
+        if (conn_data == NULL) {
+            free_slot = true;
+            continue;
+        }
+
+        if (conn_data->connect_req == NULL
+                && !sdap_can_reuse_connection(conn_data)) {
+            DEBUG(SSSDBG_TRACE_ALL, "releasing expired cached connection\n");
+            conn_cache->cached_connections[i] = NULL;
+            sdap_id_release_conn_data(conn_data);
+            if (!sdap_id_conn_cache_use_spare(conn_cache, i)) {
+                free_slot = true;
+                continue;
+            }
+            conn_data = conn_cache->cached_connections[i];
+        }
+
+        if (conn_data->connect_req != NULL && connecting == NULL) {
+            connecting = conn_data;
+        }
+
+        if (best == NULL || conn_data->num_ops < best->num_ops) {
+            best = conn_data;
+        }
+    }
+
+    /* Open another connection only if all of them are busy and none
+     * is being established */
+    conn_data = best;
+    if (conn_data && conn_data->num_ops > 0 && free_slot) {
+        conn_data = connecting;
+    }
 
-    /* Try to reuse context cached connection */
-    conn_data = conn_cache->cached_connection;
     if (conn_data) {
         if (conn_data->connect_req) {
             DEBUG(SSSDBG_TRACE_ALL, "waiting for connection to complete\n");
@@ -469,15 +819,9 @@ static int sdap_id_op_connect_step(struct tevent_req *req)
             goto done;
         }
 
-        if (sdap_can_reuse_connection(conn_data)) {
-            DEBUG(SSSDBG_TRACE_ALL, "reusing cached connection\n");
-            sdap_id_op_hook_conn_data(op, conn_data);
-            goto done;
-        }
-
-        DEBUG(SSSDBG_TRACE_ALL, "releasing expired cached connection\n");
-        conn_cache->cached_connection = NULL;
-        sdap_id_release_conn_data(conn_data);
+        DEBUG(SSSDBG_TRACE_ALL, "reusing cached connection\n");
+        sdap_id_op_hook_conn_data(op, conn_data);
+        goto done;
     }
 
     DEBUG(SSSDBG_TRACE_ALL, "beginning to connect\n");
@@ -506,7 +850,7 @@ static int sdap_id_op_connect_step(struct tevent_req *req)
     conn_data->connect_req = subreq;
 
     DLIST_ADD(conn_cache->connections, conn_data);
-    conn_cache->cached_connection = conn_data;
+    sdap_id_conn_cache_add(conn_data);
 
     sdap_id_op_hook_conn_data(op, conn_data);
 
@@ -658,9 +1002,7 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
             bool retry = false;
 
             /* drop connection from cache now */
-            if (conn_cache->cached_connection == conn_data) {
-                conn_cache->cached_connection = NULL;
-            }
+            sdap_id_conn_cache_uncache(conn_data);
 
             if (can_retry) {
                 /* determining whether retry is possible */
@@ -720,19 +1062,19 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
 
     if ((ret == EOK) &&
         conn_data->sh->connected &&
-        !be_is_offline(conn_cache->id_conn->id_ctx->be)) {
+        !be_is_offline(conn_cache->id_conn->id_ctx->be) &&
+        sdap_id_conn_cache_add(conn_data)) {
         DEBUG(SSSDBG_TRACE_ALL,
               "caching successful connection after %d notifies\n", notify_count);
-        conn_cache->cached_connection = conn_data;
 
-        /* Run any post-connection routines */
-        be_run_unconditional_online_cb(conn_cache->id_conn->id_ctx->be);
-        be_run_online_cb(conn_cache->id_conn->id_ctx->be);
+        /* Run any post-connection routines, once for the whole pool */
+        if (!sdap_id_conn_cache_has_other(conn_data)) {
+            be_run_unconditional_online_cb(conn_cache->id_conn->id_ctx->be);
+            be_run_online_cb(conn_cache->id_conn->id_ctx->be);
+        }
 
     } else {
-        if (conn_cache->cached_connection == conn_data) {
-            conn_cache->cached_connection = NULL;
-        }
+        sdap_id_conn_cache_uncache(conn_data);
 
         sdap_id_release_conn_data(conn_data);
     }
@@ -835,9 +1177,11 @@ int sdap_id_op_done(struct sdap_id_op *op, int retval, int *dp_err_out)
     }
 
     if (communication_error && current_conn != 0
-            && current_conn == op->conn_cache->cached_connection) {
-        /* do not reuse failed connection */
-        op->conn_cache->cached_connection = NULL;
+            && sdap_id_conn_cache_is_cached(current_conn)) {
+        /* do not reuse failed connection, nor the other connections
+         * to the same server */
+        sdap_id_conn_cache_uncache(current_conn);
+        sdap_id_conn_cache_fo_reconnect_cb(op->conn_cache);
 
         DEBUG(SSSDBG_FUNC_DATA,
               "communication error on cached connection, moving to next server\n");
@@ -140,3 +140,39 @@ done:
     talloc_free(tmp_ctx);
     return ret;
 }
+
+errno_t sdap_range_set_next(struct sysdb_attrs *attrs,
+                            const char *base_attr,
+                            uint32_t range_offset)
+{
+    char *name;
+    errno_t ret;
+
+    name = talloc_asprintf(NULL, SDAP_RANGE_NEXT_PREFIX"%s", base_attr);
+    if (name == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_attrs_add_uint32(attrs, name, range_offset);
+    talloc_free(name);
+
+    return ret;
+}
+
+errno_t sdap_range_get_next(struct sysdb_attrs *attrs,
+                            const char *base_attr,
+                            uint32_t *_range_offset)
+{
+    char *name;
+    errno_t ret;
+
+    name = talloc_asprintf(NULL, SDAP_RANGE_NEXT_PREFIX"%s", base_attr);
+    if (name == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_attrs_get_uint32_t(attrs, name, _range_offset);
+    talloc_free(name);
+
+    return ret;
+}
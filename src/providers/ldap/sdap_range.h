@@ -24,6 +24,11 @@
 #define SDAP_RANGE_H_
 
 #include "src/util/util.h"
+#include "src/db/sysdb.h"
+
+/* Prefix of the internal attribute which remembers where the values of a
+ * ranged attribute continue. It is never saved to the cache. */
+#define SDAP_RANGE_NEXT_PREFIX "sdapRangeNext;"
 
 errno_t sdap_parse_range(TALLOC_CTX *mem_ctx,
                          const char *attr_desc,
@@ -31,4 +36,13 @@ errno_t sdap_parse_range(TALLOC_CTX *mem_ctx,
                          uint32_t *range_offset,
                          bool disable_range_retrieval);
 
+errno_t sdap_range_set_next(struct sysdb_attrs *attrs,
+                            const char *base_attr,
+                            uint32_t range_offset);
+
+/* Returns ENOENT if all values of base_attr were retrieved. */
+errno_t sdap_range_get_next(struct sysdb_attrs *attrs,
+                            const char *base_attr,
+                            uint32_t *_range_offset);
+
 #endif /* SDAP_RANGE_H_ */
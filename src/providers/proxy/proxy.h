@@ -34,6 +34,7 @@
 
 #include "util/util.h"
 #include "util/nss_dl_load.h"
+#include "util/child_common.h"
 #include "providers/backend.h"
 #include "db/sysdb.h"
 #include <dhash.h>
@@ -52,6 +53,9 @@ struct proxy_id_ctx {
     struct be_ctx *be;
     bool fast_alias;
     struct sss_nss_ops ops;
+
+    /* NULL unless the lookups run in proxy_nss_child processes */
+    struct sss_child_pool *nss_pool;
 };
 
 struct proxy_auth_ctx {
@@ -105,6 +109,80 @@ struct pc_init_ctx {
 #define DEFAULT_BUFSIZE 4096
 #define MAX_BUF_SIZE 1024*1024 /* max 1MiB */
 
+/*
+ * With proxy_nss_workers set, user and group lookups in the NSS module run
+ * in proxy_nss_child processes so that a slow module does not block the
+ * backend. The child makes all NSS calls the lookup may need and returns
+ * their results. The lookup is then processed by the code in proxy_id.c
+ * with NSS operations that answer from these results.
+ *
+ * Request:
+ *   uint32_t lookup (enum proxy_nss_lookup)
+ *   name (string) or ID (uint32_t)
+ *
+ * Reply:
+ *   uint32_t number of records
+ *   records:
+ *     uint32_t call (enum proxy_nss_call)
+ *     name (string) or ID (uint32_t), for initgroups the user name
+ *     uint32_t primary GID, only for initgroups
+ *     int32_t  enum nss_status
+ *     int32_t  errno
+ *     the result if the status is NSS_STATUS_SUCCESS:
+ *       passwd: name, passwd, uint32_t uid, uint32_t gid, gecos, dir, shell
+ *       group: name, passwd, uint32_t gid, uint32_t count, members
+ *       initgroups: uint32_t count, uint32_t GIDs
+ *
+ * Strings are a uint32_t length followed by the characters without the
+ * terminating NUL, a length of UINT32_MAX stands for NULL.
+ */
+#define PROXY_NSS_CHILD SSSD_LIBEXEC_PATH"/proxy_nss_child"
+#define PROXY_NSS_CHILD_LOG_FILE "proxy_nss_child"
+
+enum proxy_nss_lookup {
+    PROXY_NSS_USER_BY_NAME = 1,
+    PROXY_NSS_USER_BY_ID,
+    PROXY_NSS_GROUP_BY_NAME,
+    PROXY_NSS_GROUP_BY_ID,
+    PROXY_NSS_INITGROUPS,
+};
+
+enum proxy_nss_call {
+    PROXY_NSS_GETPWNAM = 1,
+    PROXY_NSS_GETPWUID,
+    PROXY_NSS_GETGRNAM,
+    PROXY_NSS_GETGRGID,
+    PROXY_NSS_INITGROUPS_DYN,
+};
+
+#define PROXY_NSS_NULL_STRING UINT32_MAX
+
+/* From proxy_nss_worker.c */
+struct proxy_nss_records;
+
+errno_t proxy_nss_workers_init(struct proxy_id_ctx *ctx,
+                               const char *libname,
+                               int num_workers);
+
+bool proxy_nss_workers_handle(struct proxy_id_ctx *ctx,
+                              struct dp_id_data *data);
+
+struct tevent_req *proxy_nss_lookup_send(TALLOC_CTX *mem_ctx,
+                                         struct tevent_context *ev,
+                                         struct proxy_id_ctx *ctx,
+                                         struct dp_id_data *data);
+
+errno_t proxy_nss_lookup_recv(TALLOC_CTX *mem_ctx,
+                              struct tevent_req *req,
+                              struct proxy_nss_records **_records);
+
+/* Fill @_ops with operations that answer from @records instead of calling
+ * the module, until proxy_nss_replay_end() is called. */
+void proxy_nss_replay_start(struct proxy_nss_records *records,
+                            const struct sss_nss_ops *module_ops,
+                            struct sss_nss_ops *_ops);
+void proxy_nss_replay_end(void);
+
 /* From proxy_id.c */
 struct tevent_req *
 proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
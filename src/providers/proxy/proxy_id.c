@@ -1745,9 +1745,15 @@ proxy_account_info(TALLOC_CTX *mem_ctx,
 }
 
 struct proxy_account_info_handler_state {
+    struct proxy_id_ctx *id_ctx;
+    struct dp_id_data *data;
+    struct be_ctx *be_ctx;
+
     struct dp_reply_std reply;
 };
 
+static void proxy_account_info_handler_done(struct tevent_req *subreq);
+
 struct tevent_req *
 proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
                                struct proxy_id_ctx *id_ctx,
@@ -1755,6 +1761,7 @@ proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
                                struct dp_req_params *params)
 {
     struct proxy_account_info_handler_state *state;
+    struct tevent_req *subreq;
     struct tevent_req *req;
 
     req = tevent_req_create(mem_ctx, &state,
@@ -1764,9 +1771,25 @@ proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    state->id_ctx = id_ctx;
+    state->data = data;
+    state->be_ctx = params->be_ctx;
+
+    if (proxy_nss_workers_handle(id_ctx, data)) {
+        subreq = proxy_nss_lookup_send(state, params->ev, id_ctx, data);
+        if (subreq == NULL) {
+            dp_reply_std_set(&state->reply, DP_ERR_FATAL, ENOMEM, NULL);
+            goto immediately;
+        }
+
+        tevent_req_set_callback(subreq, proxy_account_info_handler_done, req);
+        return req;
+    }
+
     state->reply = proxy_account_info(state, id_ctx, data, params->be_ctx,
                                       params->be_ctx->domain);
 
+immediately:
     /* TODO For backward compatibility we always return EOK to DP now. */
     tevent_req_done(req);
     tevent_req_post(req, params->ev);
@@ -1774,6 +1797,37 @@ proxy_account_info_handler_send(TALLOC_CTX *mem_ctx,
     return req;
 }
 
+static void proxy_account_info_handler_done(struct tevent_req *subreq)
+{
+    struct proxy_account_info_handler_state *state;
+    struct proxy_nss_records *records;
+    struct proxy_id_ctx replay_ctx;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_account_info_handler_state);
+
+    ret = proxy_nss_lookup_recv(state, subreq, &records);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        dp_reply_std_set(&state->reply, DP_ERR_FATAL, ret, NULL);
+        tevent_req_done(req);
+        return;
+    }
+
+    /* Process the lookup as usual, the NSS calls are answered from the
+     * results of proxy_nss_child. */
+    replay_ctx = *state->id_ctx;
+    proxy_nss_replay_start(records, &state->id_ctx->ops, &replay_ctx.ops);
+    state->reply = proxy_account_info(state, &replay_ctx, state->data,
+                                      state->be_ctx, state->be_ctx->domain);
+    proxy_nss_replay_end();
+
+    talloc_free(records);
+    tevent_req_done(req);
+}
+
 errno_t proxy_account_info_handler_recv(TALLOC_CTX *mem_ctx,
                                        struct tevent_req *req,
                                        struct dp_reply_std *data)
@@ -32,11 +32,13 @@
 static errno_t proxy_id_conf(TALLOC_CTX *mem_ctx,
                              struct be_ctx *be_ctx,
                              char **_libname,
-                             bool *_fast_alias)
+                             bool *_fast_alias,
+                             int *_nss_workers)
 {
     TALLOC_CTX *tmp_ctx;
     char *libname;
     bool fast_alias;
+    int nss_workers;
     errno_t ret;
 
     tmp_ctx = talloc_new(NULL);
@@ -65,8 +67,24 @@ static errno_t proxy_id_conf(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    ret = confdb_get_int(be_ctx->cdb, be_ctx->conf_path,
+                         CONFDB_PROXY_NSS_WORKERS, 0, &nss_workers);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read confdb [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (nss_workers < 0) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Option " CONFDB_PROXY_NSS_WORKERS " must not be negative\n");
+        ret = EINVAL;
+        goto done;
+    }
+
     *_libname = talloc_steal(mem_ctx, libname);
     *_fast_alias = fast_alias;
+    *_nss_workers = nss_workers;
 
     ret = EOK;
 
@@ -324,6 +342,7 @@ errno_t sssm_proxy_id_init(TALLOC_CTX *mem_ctx,
 {
     struct proxy_module_ctx *module_ctx;
     char *libname;
+    int nss_workers;
     errno_t ret;
 
     module_ctx = talloc_get_type(module_data, struct proxy_module_ctx);
@@ -335,7 +354,7 @@ errno_t sssm_proxy_id_init(TALLOC_CTX *mem_ctx,
     module_ctx->id_ctx->be = be_ctx;
 
     ret = proxy_id_conf(module_ctx->id_ctx, be_ctx, &libname,
-                        &module_ctx->id_ctx->fast_alias);
+                        &module_ctx->id_ctx->fast_alias, &nss_workers);
     if (ret != EOK) {
         goto done;
     }
@@ -347,6 +366,14 @@ errno_t sssm_proxy_id_init(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    if (nss_workers > 0) {
+        ret = proxy_nss_workers_init(module_ctx->id_ctx, libname,
+                                     nss_workers);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     dp_set_method(dp_methods, DPM_ACCOUNT_HANDLER,
                   proxy_account_info_handler_send, proxy_account_info_handler_recv,
                   module_ctx->id_ctx, struct proxy_id_ctx, struct dp_id_data,
@@ -0,0 +1,581 @@
+/*
+    SSSD
+
+    Proxy provider, NSS lookup helper
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <popt.h>
+
+#include "util/util.h"
+#include "util/child_common.h"
+#include "shared/safealign.h"
+#include "providers/proxy/proxy.h"
+
+struct proxy_nss_reply {
+    uint8_t *buf;
+    size_t len;
+    uint32_t count;
+};
+
+static errno_t reply_add(struct proxy_nss_reply *reply,
+                         const void *data, size_t len)
+{
+    uint8_t *buf;
+    size_t p;
+
+    if (reply->len + len > SSS_CHILD_POOL_MAX_FRAME) {
+        DEBUG(SSSDBG_OP_FAILURE, "The reply is too large\n");
+        return EMSGSIZE;
+    }
+
+    buf = talloc_realloc(NULL, reply->buf, uint8_t, reply->len + len);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+    reply->buf = buf;
+
+    p = reply->len;
+    safealign_memcpy(&reply->buf[p], data, len, &p);
+    reply->len = p;
+
+    return EOK;
+}
+
+static errno_t reply_add_uint32(struct proxy_nss_reply *reply, uint32_t value)
+{
+    return reply_add(reply, &value, sizeof(uint32_t));
+}
+
+static errno_t reply_add_string(struct proxy_nss_reply *reply,
+                                const char *str)
+{
+    errno_t ret;
+
+    if (str == NULL) {
+        return reply_add_uint32(reply, PROXY_NSS_NULL_STRING);
+    }
+
+    ret = reply_add_uint32(reply, strlen(str));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return reply_add(reply, str, strlen(str));
+}
+
+/* Add the part of a record that is the same for all calls. */
+static errno_t reply_add_record(struct proxy_nss_reply *reply,
+                                enum proxy_nss_call call,
+                                const char *name, uint32_t id,
+                                enum nss_status status, int err)
+{
+    errno_t ret;
+
+    reply->count++;
+
+    ret = reply_add_uint32(reply, call);
+    if (ret == EOK) {
+        if (name != NULL) {
+            ret = reply_add_string(reply, name);
+        } else {
+            ret = reply_add_uint32(reply, id);
+        }
+    }
+    if (ret == EOK && call == PROXY_NSS_INITGROUPS_DYN) {
+        ret = reply_add_uint32(reply, id);
+    }
+    if (ret == EOK) {
+        ret = reply_add_uint32(reply, (uint32_t) status);
+    }
+    if (ret == EOK) {
+        ret = reply_add_uint32(reply, (uint32_t) err);
+    }
+
+    return ret;
+}
+
+static errno_t reply_add_passwd(struct proxy_nss_reply *reply,
+                                enum proxy_nss_call call,
+                                const char *name, uid_t uid,
+                                enum nss_status status, int err,
+                                struct passwd *pwd)
+{
+    errno_t ret;
+
+    ret = reply_add_record(reply, call, name, uid, status, err);
+    if (ret != EOK || status != NSS_STATUS_SUCCESS) {
+        return ret;
+    }
+
+    ret = reply_add_string(reply, pwd->pw_name);
+    if (ret == EOK) {
+        ret = reply_add_string(reply, pwd->pw_passwd);
+    }
+    if (ret == EOK) {
+        ret = reply_add_uint32(reply, pwd->pw_uid);
+    }
+    if (ret == EOK) {
+        ret = reply_add_uint32(reply, pwd->pw_gid);
+    }
+    if (ret == EOK) {
+        ret = reply_add_string(reply, pwd->pw_gecos);
+    }
+    if (ret == EOK) {
+        ret = reply_add_string(reply, pwd->pw_dir);
+    }
+    if (ret == EOK) {
+        ret = reply_add_string(reply, pwd->pw_shell);
+    }
+
+    return ret;
+}
+
+static errno_t reply_add_group(struct proxy_nss_reply *reply,
+                               enum proxy_nss_call call,
+                               const char *name, gid_t gid,
+                               enum nss_status status, int err,
+                               struct group *grp)
+{
+    uint32_t count = 0;
+    uint32_t i;
+    errno_t ret;
+
+    ret = reply_add_record(reply, call, name, gid, status, err);
+    if (ret != EOK || status != NSS_STATUS_SUCCESS) {
+        return ret;
+    }
+
+    if (grp->gr_mem != NULL) {
+        for (count = 0; grp->gr_mem[count] != NULL; count++);
+    }
+
+    ret = reply_add_string(reply, grp->gr_name);
+    if (ret == EOK) {
+        ret = reply_add_string(reply, grp->gr_passwd);
+    }
+    if (ret == EOK) {
+        ret = reply_add_uint32(reply, grp->gr_gid);
+    }
+    if (ret == EOK) {
+        ret = reply_add_uint32(reply, count);
+    }
+    for (i = 0; ret == EOK && i < count; i++) {
+        ret = reply_add_string(reply, grp->gr_mem[i]);
+    }
+
+    return ret;
+}
+
+/* The buffer sizes match the ones used by proxy_id.c so that a result that
+ * does not fit there is not returned either. */
+static errno_t proxy_nss_getpw(TALLOC_CTX *mem_ctx,
+                               struct sss_nss_ops *ops,
+                               struct proxy_nss_reply *reply,
+                               const char *name, uid_t uid,
+                               struct passwd **_pwd)
+{
+    struct passwd *pwd;
+    enum nss_status status;
+    char *buffer;
+    int err = 0;
+    errno_t ret;
+
+    pwd = talloc_zero(mem_ctx, struct passwd);
+    buffer = talloc_size(mem_ctx, DEFAULT_BUFSIZE);
+    if (pwd == NULL || buffer == NULL) {
+        return ENOMEM;
+    }
+
+    if (name != NULL) {
+        status = ops->getpwnam_r(name, pwd, buffer, DEFAULT_BUFSIZE, &err);
+        ret = reply_add_passwd(reply, PROXY_NSS_GETPWNAM, name, 0,
+                               status, err, pwd);
+    } else {
+        status = ops->getpwuid_r(uid, pwd, buffer, DEFAULT_BUFSIZE, &err);
+        ret = reply_add_passwd(reply, PROXY_NSS_GETPWUID, NULL, uid,
+                               status, err, pwd);
+    }
+
+    *_pwd = status == NSS_STATUS_SUCCESS ? pwd : NULL;
+    return ret;
+}
+
+static errno_t proxy_nss_getgr(TALLOC_CTX *mem_ctx,
+                               struct sss_nss_ops *ops,
+                               struct proxy_nss_reply *reply,
+                               const char *name, gid_t gid,
+                               struct group **_grp)
+{
+    struct group *grp;
+    enum nss_status status;
+    char *buffer = NULL;
+    size_t buflen = DEFAULT_BUFSIZE;
+    int err;
+
+    grp = talloc_zero(mem_ctx, struct group);
+    if (grp == NULL) {
+        return ENOMEM;
+    }
+
+    do {
+        buflen *= 2;
+        if (buflen > MAX_BUF_SIZE) {
+            buflen = MAX_BUF_SIZE;
+        }
+
+        buffer = talloc_realloc_size(mem_ctx, buffer, buflen);
+        if (buffer == NULL) {
+            return ENOMEM;
+        }
+
+        memset(grp, 0, sizeof(struct group));
+        err = 0;
+        if (name != NULL) {
+            status = ops->getgrnam_r(name, grp, buffer, buflen, &err);
+        } else {
+            status = ops->getgrgid_r(gid, grp, buffer, buflen, &err);
+        }
+    } while (status == NSS_STATUS_TRYAGAIN && err == ERANGE
+                && buflen < MAX_BUF_SIZE);
+
+    *_grp = status == NSS_STATUS_SUCCESS ? grp : NULL;
+
+    return reply_add_group(reply,
+                           name != NULL ? PROXY_NSS_GETGRNAM
+                                        : PROXY_NSS_GETGRGID,
+                           name, gid, status, err, grp);
+}
+
+static errno_t proxy_nss_initgroups(TALLOC_CTX *mem_ctx,
+                                    struct sss_nss_ops *ops,
+                                    struct proxy_nss_reply *reply,
+                                    struct passwd *pwd,
+                                    gid_t **_gids,
+                                    size_t *_num_gids)
+{
+    enum nss_status status;
+    long int start = 1;
+    long int size = 64;
+    gid_t *groups;
+    gid_t *gids;
+    int err = 0;
+    long int i;
+    errno_t ret;
+
+    if (ops->initgroups_dyn == NULL) {
+        return reply_add_record(reply, PROXY_NSS_INITGROUPS_DYN,
+                                pwd->pw_name, pwd->pw_gid,
+                                NSS_STATUS_UNAVAIL, ENOSYS);
+    }
+
+    /* The module may realloc() the array. */
+    groups = malloc(size * sizeof(gid_t));
+    if (groups == NULL) {
+        return ENOMEM;
+    }
+    groups[0] = pwd->pw_gid;
+
+    status = ops->initgroups_dyn(pwd->pw_name, pwd->pw_gid, &start, &size,
+                                 &groups, -1, &err);
+
+    ret = reply_add_record(reply, PROXY_NSS_INITGROUPS_DYN, pwd->pw_name,
+                           pwd->pw_gid, status, err);
+    if (ret != EOK || status != NSS_STATUS_SUCCESS) {
+        goto done;
+    }
+
+    /* The primary group is added by the caller. */
+    ret = reply_add_uint32(reply, start - 1);
+    for (i = 1; ret == EOK && i < start; i++) {
+        ret = reply_add_uint32(reply, groups[i]);
+    }
+    if (ret != EOK) {
+        goto done;
+    }
+
+    gids = talloc_realloc(mem_ctx, *_gids, gid_t, *_num_gids + start);
+    if (gids == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(&gids[*_num_gids], groups, start * sizeof(gid_t));
+    *_gids = gids;
+    *_num_gids += start;
+
+done:
+    free(groups);
+    return ret;
+}
+
+static errno_t proxy_nss_initgr(TALLOC_CTX *mem_ctx,
+                                struct sss_nss_ops *ops,
+                                struct proxy_nss_reply *reply,
+                                const char *name)
+{
+    struct passwd *pwnam;
+    struct passwd *pwuid;
+    struct group *grp;
+    gid_t *gids = NULL;
+    size_t num_gids = 0;
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    ret = proxy_nss_getpw(mem_ctx, ops, reply, name, 0, &pwnam);
+    if (ret != EOK || pwnam == NULL) {
+        return ret;
+    }
+
+    ret = proxy_nss_getpw(mem_ctx, ops, reply, NULL, pwnam->pw_uid, &pwuid);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* The groups are looked up for the canonical name unless proxy_fast_alias
+     * finds the user in the cache, both are needed. */
+    ret = proxy_nss_initgroups(mem_ctx, ops, reply, pwnam, &gids, &num_gids);
+    if (ret == EOK && pwuid != NULL
+            && (strcmp(pwuid->pw_name, pwnam->pw_name) != 0
+                || pwuid->pw_gid != pwnam->pw_gid)) {
+        ret = proxy_nss_initgroups(mem_ctx, ops, reply, pwuid,
+                                   &gids, &num_gids);
+    }
+
+    for (i = 0; ret == EOK && i < num_gids; i++) {
+        for (j = 0; j < i && gids[j] != gids[i]; j++);
+        if (j < i) {
+            continue;
+        }
+
+        ret = proxy_nss_getgr(mem_ctx, ops, reply, NULL, gids[i], &grp);
+    }
+
+    return ret;
+}
+
+static errno_t proxy_nss_handle(TALLOC_CTX *mem_ctx,
+                                uint8_t *buf, size_t len,
+                                uint8_t **_reply, size_t *_reply_len,
+                                void *pvt)
+{
+    struct sss_nss_ops *ops = talloc_get_type(pvt, struct sss_nss_ops);
+    struct proxy_nss_reply reply = { 0 };
+    TALLOC_CTX *tmp_ctx;
+    struct passwd *pwd;
+    struct group *grp;
+    uint32_t lookup;
+    uint32_t id = 0;
+    uint32_t name_len;
+    char *name = NULL;
+    size_t p = 0;
+    errno_t ret;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&lookup, buf, len, &p);
+
+    switch (lookup) {
+    case PROXY_NSS_USER_BY_NAME:
+    case PROXY_NSS_GROUP_BY_NAME:
+    case PROXY_NSS_INITGROUPS:
+        SAFEALIGN_COPY_UINT32_CHECK(&name_len, buf + p, len, &p);
+        if (name_len == 0 || name_len > len - p) {
+            return EINVAL;
+        }
+        break;
+    case PROXY_NSS_USER_BY_ID:
+    case PROXY_NSS_GROUP_BY_ID:
+        SAFEALIGN_COPY_UINT32_CHECK(&id, buf + p, len, &p);
+        name_len = 0;
+        break;
+    default:
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unknown lookup %u\n", lookup);
+        return EINVAL;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (name_len > 0) {
+        name = talloc_strndup(tmp_ctx, (char *) buf + p, name_len);
+        if (name == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    /* Room for the number of records. */
+    ret = reply_add_uint32(&reply, 0);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Lookup %u of %s [%"PRIu32"]\n",
+          lookup, name == NULL ? "-" : name, id);
+
+    /* Mirror the calls made by proxy_id.c for the lookup. */
+    switch (lookup) {
+    case PROXY_NSS_USER_BY_NAME:
+        ret = proxy_nss_getpw(tmp_ctx, ops, &reply, name, 0, &pwd);
+        if (ret == EOK && pwd != NULL) {
+            ret = proxy_nss_getpw(tmp_ctx, ops, &reply, NULL, pwd->pw_uid,
+                                  &pwd);
+        }
+        break;
+    case PROXY_NSS_USER_BY_ID:
+        ret = proxy_nss_getpw(tmp_ctx, ops, &reply, NULL, id, &pwd);
+        break;
+    case PROXY_NSS_GROUP_BY_NAME:
+        ret = proxy_nss_getgr(tmp_ctx, ops, &reply, name, 0, &grp);
+        if (ret == EOK && grp != NULL) {
+            ret = proxy_nss_getgr(tmp_ctx, ops, &reply, NULL, grp->gr_gid,
+                                  &grp);
+        }
+        break;
+    case PROXY_NSS_GROUP_BY_ID:
+        ret = proxy_nss_getgr(tmp_ctx, ops, &reply, NULL, id, &grp);
+        break;
+    case PROXY_NSS_INITGROUPS:
+        ret = proxy_nss_initgr(tmp_ctx, ops, &reply, name);
+        break;
+    }
+
+    if (ret != EOK) {
+        goto done;
+    }
+
+    p = 0;
+    SAFEALIGN_SET_UINT32(reply.buf, reply.count, &p);
+
+    *_reply = talloc_steal(mem_ctx, reply.buf);
+    *_reply_len = reply.len;
+    reply.buf = NULL;
+
+done:
+    talloc_free(reply.buf);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t proxy_nss_child_load(struct sss_nss_ops *ops,
+                                    const char *libname)
+{
+    struct sss_nss_symbols syms[] = {
+        {(void*)&ops->getpwnam_r,      true,  "getpwnam_r" },
+        {(void*)&ops->getpwuid_r,      true,  "getpwuid_r" },
+        {(void*)&ops->getgrnam_r,      true,  "getgrnam_r" },
+        {(void*)&ops->getgrgid_r,      true,  "getgrgid_r" },
+        {(void*)&ops->initgroups_dyn,  false, "initgroups_dyn" },
+    };
+    size_t nsyms = sizeof(syms) / sizeof(struct sss_nss_symbols);
+
+    return sss_load_nss_symbols(ops, libname, syms, nsyms);
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int debug_fd = -1;
+    const char *opt_logger = NULL;
+    const char *libname = NULL;
+    struct sss_nss_ops *ops;
+    errno_t ret;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        {"debug-level", 'd', POPT_ARG_INT, &debug_level, 0,
+         _("Debug level"), NULL},
+        {"debug-timestamps", 0, POPT_ARG_INT, &debug_timestamps, 0,
+         _("Add debug timestamps"), NULL},
+        {"debug-microseconds", 0, POPT_ARG_INT, &debug_microseconds, 0,
+         _("Show timestamps with microseconds"), NULL},
+        {"debug-fd", 0, POPT_ARG_INT, &debug_fd, 0,
+         _("An open file descriptor for the debug logs"), NULL},
+        {"debug-to-stderr", 0, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN,
+         &debug_to_stderr, 0,
+         _("Send the debug output to stderr directly."), NULL },
+        {"library", 0, POPT_ARG_STRING, &libname, 0,
+         _("Name of the NSS module"), NULL},
+        SSSD_LOGGER_OPTS
+        POPT_TABLEEND
+    };
+
+    /* Set debug level to invalid value so we can decide if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+        fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                  poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            _exit(-1);
+        }
+    }
+
+    poptFreeContext(pc);
+
+    DEBUG_INIT(debug_level);
+
+    debug_prg_name = talloc_asprintf(NULL, "proxy_nss_child[%d]", getpid());
+    if (debug_prg_name == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_asprintf failed.\n");
+        return EXIT_FAILURE;
+    }
+
+    if (debug_fd != -1) {
+        ret = set_debug_file_from_fd(debug_fd);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "set_debug_file_from_fd failed.\n");
+        }
+        opt_logger = sss_logger_str[FILES_LOGGER];
+    }
+
+    sss_set_logger(opt_logger);
+
+    if (libname == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "No library name given\n");
+        return EXIT_FAILURE;
+    }
+
+    ops = talloc_zero(NULL, struct sss_nss_ops);
+    if (ops == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    ret = proxy_nss_child_load(ops, libname);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to load NSS symbols [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return EXIT_FAILURE;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "proxy_nss_child started.\n");
+
+    ret = sss_child_pool_serve(STDIN_FILENO, STDOUT_FILENO,
+                               proxy_nss_handle, ops);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "proxy_nss_child failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "proxy_nss_child completed successfully\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,756 @@
+/*
+    SSSD
+
+    Proxy provider, NSS lookups in proxy_nss_child processes
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include "util/strtonum.h"
+#include "shared/safealign.h"
+#include "providers/proxy/proxy.h"
+
+/* idle workers above one are stopped after this many seconds */
+#define PROXY_NSS_WORKER_IDLE_TIMEOUT 60
+/* the same time proxy_child is given for an authentication */
+#define PROXY_NSS_WORKER_TIMEOUT (SSS_CLI_SOCKET_TIMEOUT / 4 / 1000)
+
+struct proxy_nss_record {
+    enum proxy_nss_call call;
+    char *name;
+    /* UID or GID, the primary GID for initgroups */
+    uint32_t id;
+    enum nss_status status;
+    int err;
+
+    struct passwd pwd;
+    struct group grp;
+    gid_t *gids;
+    uint32_t num_gids;
+};
+
+struct proxy_nss_records {
+    struct proxy_nss_record *recs;
+    size_t num;
+};
+
+errno_t proxy_nss_workers_init(struct proxy_id_ctx *ctx,
+                               const char *libname,
+                               int num_workers)
+{
+    struct sss_child_pool_opts opts = { 0 };
+    const char *extra_argv[2] = { NULL, NULL };
+    char *library_arg;
+    errno_t ret;
+
+    library_arg = talloc_asprintf(ctx, "--library=%s", libname);
+    if (library_arg == NULL) {
+        return ENOMEM;
+    }
+    extra_argv[0] = library_arg;
+
+    opts.name = "proxy_nss";
+    opts.binary = PROXY_NSS_CHILD;
+    opts.logfile = PROXY_NSS_CHILD_LOG_FILE;
+    opts.extra_argv = extra_argv;
+    opts.min_idle = 1;
+    opts.max_helpers = num_workers;
+    opts.idle_timeout = PROXY_NSS_WORKER_IDLE_TIMEOUT;
+    opts.timeout = PROXY_NSS_WORKER_TIMEOUT;
+
+    ret = sss_child_pool_create(ctx, ctx->be->ev, &opts, &ctx->nss_pool);
+    talloc_free(library_arg);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to start proxy_nss_child "
+              "workers [%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Up to %d proxy_nss_child workers will "
+          "run the lookups\n", num_workers);
+
+    return EOK;
+}
+
+bool proxy_nss_workers_handle(struct proxy_id_ctx *ctx,
+                              struct dp_id_data *data)
+{
+    if (ctx->nss_pool == NULL) {
+        return false;
+    }
+
+    switch (data->entry_type & BE_REQ_TYPE_MASK) {
+    case BE_REQ_USER:
+    case BE_REQ_GROUP:
+        return data->filter_type == BE_FILTER_NAME
+                    || data->filter_type == BE_FILTER_IDNUM;
+    case BE_REQ_INITGROUPS:
+        return data->filter_type == BE_FILTER_NAME
+                    && ctx->ops.initgroups_dyn != NULL;
+    default:
+        /* Enumerations, netgroups and services stay in the backend. */
+        return false;
+    }
+}
+
+static errno_t proxy_nss_lookup_request(TALLOC_CTX *mem_ctx,
+                                        struct dp_id_data *data,
+                                        uint8_t **_buf,
+                                        size_t *_len)
+{
+    enum proxy_nss_lookup lookup;
+    char *name = NULL;
+    char *endptr;
+    uint32_t id = 0;
+    uint8_t *buf;
+    size_t len;
+    size_t p = 0;
+    errno_t ret;
+
+    switch (data->entry_type & BE_REQ_TYPE_MASK) {
+    case BE_REQ_USER:
+        lookup = data->filter_type == BE_FILTER_NAME ? PROXY_NSS_USER_BY_NAME
+                                                     : PROXY_NSS_USER_BY_ID;
+        break;
+    case BE_REQ_GROUP:
+        lookup = data->filter_type == BE_FILTER_NAME ? PROXY_NSS_GROUP_BY_NAME
+                                                     : PROXY_NSS_GROUP_BY_ID;
+        break;
+    case BE_REQ_INITGROUPS:
+        lookup = PROXY_NSS_INITGROUPS;
+        break;
+    default:
+        return EINVAL;
+    }
+
+    if (data->filter_type == BE_FILTER_NAME) {
+        ret = sss_parse_internal_fqname(mem_ctx, data->filter_value,
+                                        &name, NULL);
+        if (ret != EOK) {
+            return ret;
+        }
+        len = 2 * sizeof(uint32_t) + strlen(name);
+    } else {
+        id = strtouint32(data->filter_value, &endptr, 10);
+        if (errno || *endptr || (data->filter_value == endptr)) {
+            return EINVAL;
+        }
+        len = 2 * sizeof(uint32_t);
+    }
+
+    buf = talloc_size(mem_ctx, len);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    SAFEALIGN_SET_UINT32(&buf[p], lookup, &p);
+    if (name != NULL) {
+        SAFEALIGN_SET_UINT32(&buf[p], strlen(name), &p);
+        SAFEALIGN_SET_STRING(&buf[p], name, strlen(name), &p);
+    } else {
+        SAFEALIGN_SET_UINT32(&buf[p], id, &p);
+    }
+
+    *_buf = buf;
+    *_len = len;
+
+    return EOK;
+}
+
+static errno_t proxy_nss_read_string(TALLOC_CTX *mem_ctx,
+                                     uint8_t *buf, size_t len, size_t *_p,
+                                     char **_str)
+{
+    uint32_t slen;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&slen, buf + *_p, len, _p);
+    if (slen == PROXY_NSS_NULL_STRING) {
+        *_str = NULL;
+        return EOK;
+    }
+
+    if (slen > len - *_p) {
+        return EINVAL;
+    }
+
+    *_str = talloc_strndup(mem_ctx, (char *) buf + *_p, slen);
+    if (*_str == NULL) {
+        return ENOMEM;
+    }
+    *_p += slen;
+
+    return EOK;
+}
+
+static errno_t proxy_nss_parse_passwd(TALLOC_CTX *mem_ctx,
+                                      uint8_t *buf, size_t len, size_t *_p,
+                                      struct passwd *pwd)
+{
+    uint32_t value;
+    errno_t ret;
+
+    ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &pwd->pw_name);
+    if (ret == EOK) {
+        ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &pwd->pw_passwd);
+    }
+    if (ret != EOK) {
+        return ret;
+    }
+
+    SAFEALIGN_COPY_UINT32_CHECK(&value, buf + *_p, len, _p);
+    pwd->pw_uid = value;
+    SAFEALIGN_COPY_UINT32_CHECK(&value, buf + *_p, len, _p);
+    pwd->pw_gid = value;
+
+    ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &pwd->pw_gecos);
+    if (ret == EOK) {
+        ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &pwd->pw_dir);
+    }
+    if (ret == EOK) {
+        ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &pwd->pw_shell);
+    }
+
+    return ret;
+}
+
+static errno_t proxy_nss_parse_group(TALLOC_CTX *mem_ctx,
+                                     uint8_t *buf, size_t len, size_t *_p,
+                                     struct group *grp)
+{
+    uint32_t value;
+    uint32_t count;
+    uint32_t i;
+    errno_t ret;
+
+    ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &grp->gr_name);
+    if (ret == EOK) {
+        ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &grp->gr_passwd);
+    }
+    if (ret != EOK) {
+        return ret;
+    }
+
+    SAFEALIGN_COPY_UINT32_CHECK(&value, buf + *_p, len, _p);
+    grp->gr_gid = value;
+    SAFEALIGN_COPY_UINT32_CHECK(&count, buf + *_p, len, _p);
+    if (count > (len - *_p) / sizeof(uint32_t)) {
+        return EINVAL;
+    }
+
+    grp->gr_mem = talloc_zero_array(mem_ctx, char *, count + 1);
+    if (grp->gr_mem == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = proxy_nss_read_string(grp->gr_mem, buf, len, _p,
+                                    &grp->gr_mem[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+        if (grp->gr_mem[i] == NULL) {
+            return EINVAL;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t proxy_nss_parse_record(TALLOC_CTX *mem_ctx,
+                                      uint8_t *buf, size_t len, size_t *_p,
+                                      struct proxy_nss_record *rec)
+{
+    uint32_t value;
+    int32_t status;
+    int32_t err;
+    uint32_t i;
+    errno_t ret;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&value, buf + *_p, len, _p);
+    rec->call = value;
+
+    switch (rec->call) {
+    case PROXY_NSS_GETPWNAM:
+    case PROXY_NSS_GETGRNAM:
+    case PROXY_NSS_INITGROUPS_DYN:
+        ret = proxy_nss_read_string(mem_ctx, buf, len, _p, &rec->name);
+        if (ret != EOK) {
+            return ret;
+        }
+        if (rec->name == NULL) {
+            return EINVAL;
+        }
+        break;
+    case PROXY_NSS_GETPWUID:
+    case PROXY_NSS_GETGRGID:
+        SAFEALIGN_COPY_UINT32_CHECK(&rec->id, buf + *_p, len, _p);
+        break;
+    default:
+        return EINVAL;
+    }
+
+    if (rec->call == PROXY_NSS_INITGROUPS_DYN) {
+        SAFEALIGN_COPY_UINT32_CHECK(&rec->id, buf + *_p, len, _p);
+    }
+
+    SAFEALIGN_COPY_INT32_CHECK(&status, buf + *_p, len, _p);
+    rec->status = status;
+    SAFEALIGN_COPY_INT32_CHECK(&err, buf + *_p, len, _p);
+    rec->err = err;
+
+    if (rec->status != NSS_STATUS_SUCCESS) {
+        return EOK;
+    }
+
+    switch (rec->call) {
+    case PROXY_NSS_GETPWNAM:
+    case PROXY_NSS_GETPWUID:
+        return proxy_nss_parse_passwd(mem_ctx, buf, len, _p, &rec->pwd);
+    case PROXY_NSS_GETGRNAM:
+    case PROXY_NSS_GETGRGID:
+        return proxy_nss_parse_group(mem_ctx, buf, len, _p, &rec->grp);
+    case PROXY_NSS_INITGROUPS_DYN:
+        SAFEALIGN_COPY_UINT32_CHECK(&rec->num_gids, buf + *_p, len, _p);
+        if (rec->num_gids > (len - *_p) / sizeof(uint32_t)) {
+            return EINVAL;
+        }
+
+        rec->gids = talloc_array(mem_ctx, gid_t, rec->num_gids + 1);
+        if (rec->gids == NULL) {
+            return ENOMEM;
+        }
+
+        for (i = 0; i < rec->num_gids; i++) {
+            SAFEALIGN_COPY_UINT32_CHECK(&value, buf + *_p, len, _p);
+            rec->gids[i] = value;
+        }
+        break;
+    }
+
+    return EOK;
+}
+
+static errno_t proxy_nss_parse_reply(TALLOC_CTX *mem_ctx,
+                                     uint8_t *buf, size_t len,
+                                     struct proxy_nss_records **_records)
+{
+    struct proxy_nss_records *records;
+    uint32_t count;
+    size_t p = 0;
+    size_t i;
+    errno_t ret;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&count, buf, len, &p);
+    /* A record is at least four numbers. */
+    if (count > len / (4 * sizeof(uint32_t))) {
+        return EINVAL;
+    }
+
+    records = talloc_zero(mem_ctx, struct proxy_nss_records);
+    if (records == NULL) {
+        return ENOMEM;
+    }
+
+    records->recs = talloc_zero_array(records, struct proxy_nss_record,
+                                      count + 1);
+    if (records->recs == NULL) {
+        talloc_free(records);
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = proxy_nss_parse_record(records->recs, buf, len, &p,
+                                     &records->recs[i]);
+        if (ret != EOK) {
+            talloc_free(records);
+            return ret;
+        }
+    }
+    records->num = count;
+
+    *_records = records;
+
+    return EOK;
+}
+
+struct proxy_nss_lookup_state {
+    struct proxy_nss_records *records;
+};
+
+static void proxy_nss_lookup_done(struct tevent_req *subreq);
+
+struct tevent_req *proxy_nss_lookup_send(TALLOC_CTX *mem_ctx,
+                                         struct tevent_context *ev,
+                                         struct proxy_id_ctx *ctx,
+                                         struct dp_id_data *data)
+{
+    struct proxy_nss_lookup_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    uint8_t *buf;
+    size_t len;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct proxy_nss_lookup_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    ret = proxy_nss_lookup_request(state, data, &buf, &len);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to create the request for %s "
+              "[%d]: %s\n", data->filter_value, ret, sss_strerror(ret));
+        goto immediately;
+    }
+
+    subreq = sss_child_pool_send(state, ctx->nss_pool, buf, len);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediately;
+    }
+
+    tevent_req_set_callback(subreq, proxy_nss_lookup_done, req);
+
+    return req;
+
+immediately:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static void proxy_nss_lookup_done(struct tevent_req *subreq)
+{
+    struct proxy_nss_lookup_state *state;
+    struct tevent_req *req;
+    uint8_t *buf;
+    size_t len;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct proxy_nss_lookup_state);
+
+    ret = sss_child_pool_recv(subreq, state, &buf, &len);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "proxy_nss_child failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = proxy_nss_parse_reply(state, buf, len, &state->records);
+    talloc_free(buf);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed reply from proxy_nss_child "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+errno_t proxy_nss_lookup_recv(TALLOC_CTX *mem_ctx,
+                              struct tevent_req *req,
+                              struct proxy_nss_records **_records)
+{
+    struct proxy_nss_lookup_state *state;
+
+    state = tevent_req_data(req, struct proxy_nss_lookup_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_records = talloc_steal(mem_ctx, state->records);
+
+    return EOK;
+}
+
+/* The NSS operations take no private data, the records answered from are
+ * only set while proxy_id.c processes one lookup. */
+static struct proxy_nss_records *proxy_nss_replayed;
+
+static struct proxy_nss_record *
+proxy_nss_replay_find(enum proxy_nss_call call, const char *name, uint32_t id)
+{
+    struct proxy_nss_record *rec;
+    size_t i;
+
+    if (proxy_nss_replayed == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < proxy_nss_replayed->num; i++) {
+        rec = &proxy_nss_replayed->recs[i];
+        if (rec->call != call) {
+            continue;
+        }
+
+        switch (call) {
+        case PROXY_NSS_GETPWNAM:
+        case PROXY_NSS_GETGRNAM:
+            if (strcmp(rec->name, name) == 0) {
+                return rec;
+            }
+            break;
+        case PROXY_NSS_INITGROUPS_DYN:
+            if (strcmp(rec->name, name) == 0 && rec->id == id) {
+                return rec;
+            }
+            break;
+        default:
+            if (rec->id == id) {
+                return rec;
+            }
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static enum nss_status proxy_nss_replay_status(struct proxy_nss_record *rec,
+                                               int *errnop)
+{
+    if (rec == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "BUG: proxy_nss_child did not make the requested call\n");
+        *errnop = EIO;
+        return NSS_STATUS_RETURN;
+    }
+
+    *errnop = rec->err;
+
+    /* The child has already given the module its largest buffer. */
+    if (rec->status == NSS_STATUS_TRYAGAIN) {
+        return NSS_STATUS_RETURN;
+    }
+
+    return rec->status;
+}
+
+static errno_t proxy_nss_replay_string(const char *str, char **_out,
+                                       char **_buf, size_t *_buflen)
+{
+    size_t len;
+
+    if (str == NULL) {
+        *_out = NULL;
+        return EOK;
+    }
+
+    len = strlen(str) + 1;
+    if (len > *_buflen) {
+        return ERANGE;
+    }
+
+    memcpy(*_buf, str, len);
+    *_out = *_buf;
+    *_buf += len;
+    *_buflen -= len;
+
+    return EOK;
+}
+
+static enum nss_status proxy_nss_replay_pw(struct proxy_nss_record *rec,
+                                           struct passwd *result,
+                                           char *buffer, size_t buflen,
+                                           int *errnop)
+{
+    enum nss_status status;
+    errno_t ret;
+
+    status = proxy_nss_replay_status(rec, errnop);
+    if (status != NSS_STATUS_SUCCESS) {
+        return status;
+    }
+
+    ret = proxy_nss_replay_string(rec->pwd.pw_name, &result->pw_name,
+                                  &buffer, &buflen);
+    if (ret == EOK) {
+        ret = proxy_nss_replay_string(rec->pwd.pw_passwd, &result->pw_passwd,
+                                      &buffer, &buflen);
+    }
+    if (ret == EOK) {
+        ret = proxy_nss_replay_string(rec->pwd.pw_gecos, &result->pw_gecos,
+                                      &buffer, &buflen);
+    }
+    if (ret == EOK) {
+        ret = proxy_nss_replay_string(rec->pwd.pw_dir, &result->pw_dir,
+                                      &buffer, &buflen);
+    }
+    if (ret == EOK) {
+        ret = proxy_nss_replay_string(rec->pwd.pw_shell, &result->pw_shell,
+                                      &buffer, &buflen);
+    }
+    if (ret != EOK) {
+        *errnop = ERANGE;
+        return NSS_STATUS_TRYAGAIN;
+    }
+
+    result->pw_uid = rec->pwd.pw_uid;
+    result->pw_gid = rec->pwd.pw_gid;
+
+    return NSS_STATUS_SUCCESS;
+}
+
+static enum nss_status proxy_nss_replay_getpwnam_r(const char *name,
+                                                   struct passwd *result,
+                                                   char *buffer, size_t buflen,
+                                                   int *errnop)
+{
+    return proxy_nss_replay_pw(proxy_nss_replay_find(PROXY_NSS_GETPWNAM,
+                                                     name, 0),
+                               result, buffer, buflen, errnop);
+}
+
+static enum nss_status proxy_nss_replay_getpwuid_r(uid_t uid,
+                                                   struct passwd *result,
+                                                   char *buffer, size_t buflen,
+                                                   int *errnop)
+{
+    return proxy_nss_replay_pw(proxy_nss_replay_find(PROXY_NSS_GETPWUID,
+                                                     NULL, uid),
+                               result, buffer, buflen, errnop);
+}
+
+static enum nss_status proxy_nss_replay_gr(struct proxy_nss_record *rec,
+                                           struct group *result,
+                                           char *buffer, size_t buflen,
+                                           int *errnop)
+{
+    enum nss_status status;
+    size_t count;
+    size_t pad;
+    size_t i;
+    errno_t ret;
+
+    status = proxy_nss_replay_status(rec, errnop);
+    if (status != NSS_STATUS_SUCCESS) {
+        return status;
+    }
+
+    for (count = 0; rec->grp.gr_mem[count] != NULL; count++);
+
+    /* The member array comes first, aligned for the pointers. */
+    pad = (uintptr_t) buffer % sizeof(char *);
+    pad = pad == 0 ? 0 : sizeof(char *) - pad;
+    if (pad + (count + 1) * sizeof(char *) > buflen) {
+        *errnop = ERANGE;
+        return NSS_STATUS_TRYAGAIN;
+    }
+
+    result->gr_mem = (char **) (buffer + pad);
+    buffer += pad + (count + 1) * sizeof(char *);
+    buflen -= pad + (count + 1) * sizeof(char *);
+
+    ret = proxy_nss_replay_string(rec->grp.gr_name, &result->gr_name,
+                                  &buffer, &buflen);
+    if (ret == EOK) {
+        ret = proxy_nss_replay_string(rec->grp.gr_passwd, &result->gr_passwd,
+                                      &buffer, &buflen);
+    }
+    for (i = 0; ret == EOK && i < count; i++) {
+        ret = proxy_nss_replay_string(rec->grp.gr_mem[i], &result->gr_mem[i],
+                                      &buffer, &buflen);
+    }
+    if (ret != EOK) {
+        *errnop = ERANGE;
+        return NSS_STATUS_TRYAGAIN;
+    }
+    result->gr_mem[count] = NULL;
+
+    result->gr_gid = rec->grp.gr_gid;
+
+    return NSS_STATUS_SUCCESS;
+}
+
+static enum nss_status proxy_nss_replay_getgrnam_r(const char *name,
+                                                   struct group *result,
+                                                   char *buffer, size_t buflen,
+                                                   int *errnop)
+{
+    return proxy_nss_replay_gr(proxy_nss_replay_find(PROXY_NSS_GETGRNAM,
+                                                     name, 0),
+                               result, buffer, buflen, errnop);
+}
+
+static enum nss_status proxy_nss_replay_getgrgid_r(gid_t gid,
+                                                   struct group *result,
+                                                   char *buffer, size_t buflen,
+                                                   int *errnop)
+{
+    return proxy_nss_replay_gr(proxy_nss_replay_find(PROXY_NSS_GETGRGID,
+                                                     NULL, gid),
+                               result, buffer, buflen, errnop);
+}
+
+static enum nss_status
+proxy_nss_replay_initgroups_dyn(const char *user, gid_t group,
+                                long int *start, long int *size,
+                                gid_t **groups, long int limit,
+                                int *errnop)
+{
+    struct proxy_nss_record *rec;
+    enum nss_status status;
+    long int num;
+
+    rec = proxy_nss_replay_find(PROXY_NSS_INITGROUPS_DYN, user, group);
+    status = proxy_nss_replay_status(rec, errnop);
+    if (status != NSS_STATUS_SUCCESS) {
+        return status;
+    }
+
+    num = rec->num_gids;
+    if (*start + num > *size) {
+        /* Let the caller grow the array until it reaches its maximum. */
+        if (*size * sizeof(gid_t) < MAX_BUF_SIZE) {
+            *errnop = ERANGE;
+            return NSS_STATUS_TRYAGAIN;
+        }
+        num = *size - *start;
+    }
+
+    memcpy(&(*groups)[*start], rec->gids, num * sizeof(gid_t));
+    *start += num;
+
+    return NSS_STATUS_SUCCESS;
+}
+
+void proxy_nss_replay_start(struct proxy_nss_records *records,
+                            const struct sss_nss_ops *module_ops,
+                            struct sss_nss_ops *_ops)
+{
+    memset(_ops, 0, sizeof(struct sss_nss_ops));
+
+    _ops->getpwnam_r = proxy_nss_replay_getpwnam_r;
+    _ops->getpwuid_r = proxy_nss_replay_getpwuid_r;
+    _ops->getgrnam_r = proxy_nss_replay_getgrnam_r;
+    _ops->getgrgid_r = proxy_nss_replay_getgrgid_r;
+    if (module_ops->initgroups_dyn != NULL) {
+        _ops->initgroups_dyn = proxy_nss_replay_initgroups_dyn;
+    }
+    _ops->dl_handle = module_ops->dl_handle;
+
+    proxy_nss_replayed = records;
+}
+
+void proxy_nss_replay_end(void)
+{
+    proxy_nss_replayed = NULL;
+}
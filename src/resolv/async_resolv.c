@@ -41,6 +41,7 @@
 #include "config.h"
 #include "resolv/async_resolv.h"
 #include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
 #include "util/util.h"
 
 #define DNS__16BIT(p)                   (((p)[0] << 8) | (p)[1])
@@ -88,6 +89,9 @@ struct resolv_ctx {
      * if our pending requests didn't timeout. */
     int pending_requests;
     struct tevent_timer *timeout_watcher;
+
+    /* Cache of DNS answers, NULL if disabled. */
+    struct resolv_cache *cache;
 };
 
 struct request_watch {
@@ -488,6 +492,8 @@ done:
 void
 resolv_reread_configuration(struct resolv_ctx *ctx)
 {
+    /* The servers may answer differently now. */
+    resolv_cache_flush(ctx);
     recreate_ares_channel(ctx);
 }
 
@@ -663,6 +669,363 @@ fail:
     return NULL;
 }
 
+/* ========================= Cache of DNS answers ==========================*/
+
+/* Answers that are kept at most. */
+#define RESOLV_CACHE_SIZE 256
+
+/* Seconds to remember that a name does not exist. */
+#define RESOLV_CACHE_NEGATIVE_TIMEOUT 5
+
+struct resolv_cache_entry {
+    struct resolv_cache_entry *prev;
+    struct resolv_cache_entry *next;
+
+    struct resolv_cache *cache;
+    time_t expire;
+
+    /* ARES_SUCCESS, ARES_ENOTFOUND or ARES_ENODATA */
+    int status;
+    struct resolv_hostent *rhostent;
+    struct ares_srv_reply *reply_list;
+};
+
+struct resolv_cache {
+    hash_table_t *table;
+    int timeout;
+    struct resolv_cache_stats stats;
+
+    /* Most recently used entry first. */
+    struct resolv_cache_entry *entries;
+    struct resolv_cache_entry *last;
+    unsigned int num_entries;
+};
+
+static int resolv_cache_entry_destructor(struct resolv_cache_entry *entry)
+{
+    struct resolv_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+errno_t resolv_cache_init(struct resolv_ctx *ctx, int timeout)
+{
+    struct resolv_cache *cache;
+
+    talloc_zfree(ctx->cache);
+
+    if (timeout <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Cache of DNS answers is disabled.\n");
+        return EOK;
+    }
+
+    cache = talloc_zero(ctx, struct resolv_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->timeout = timeout;
+    ctx->cache = cache;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "DNS answers are cached for at most "
+          "%d seconds\n", timeout);
+
+    return EOK;
+}
+
+void resolv_cache_flush(struct resolv_ctx *ctx)
+{
+    struct resolv_cache *cache = ctx->cache;
+
+    if (cache == NULL || cache->num_entries == 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing %u cached DNS answers [hits: "
+          "%"PRIu64", negative hits: %"PRIu64", misses: %"PRIu64"]\n",
+          cache->num_entries, cache->stats.hits, cache->stats.negative_hits,
+          cache->stats.misses);
+
+    while (cache->last != NULL) {
+        talloc_free(cache->last);
+    }
+}
+
+void resolv_cache_get_stats(struct resolv_ctx *ctx,
+                            struct resolv_cache_stats *_stats)
+{
+    if (ctx->cache == NULL) {
+        memset(_stats, 0, sizeof(struct resolv_cache_stats));
+        return;
+    }
+
+    *_stats = ctx->cache->stats;
+}
+
+static struct resolv_hostent *
+resolv_cache_copy_hostent(TALLOC_CTX *mem_ctx,
+                          struct resolv_hostent *src,
+                          int ttl)
+{
+    struct resolv_hostent *ret;
+    size_t addrlen;
+    int len;
+    int i;
+
+    ret = talloc_zero(mem_ctx, struct resolv_hostent);
+    if (ret == NULL) {
+        return NULL;
+    }
+
+    ret->family = src->family;
+    addrlen = src->family == AF_INET6 ? sizeof(struct in6_addr)
+                                      : sizeof(struct in_addr);
+
+    if (src->name != NULL) {
+        ret->name = talloc_strdup(ret, src->name);
+        if (ret->name == NULL) {
+            goto fail;
+        }
+    }
+
+    if (src->aliases != NULL) {
+        for (len = 0; src->aliases[len] != NULL; len++);
+
+        ret->aliases = talloc_zero_array(ret, char *, len + 1);
+        if (ret->aliases == NULL) {
+            goto fail;
+        }
+
+        for (i = 0; i < len; i++) {
+            ret->aliases[i] = talloc_strdup(ret->aliases, src->aliases[i]);
+            if (ret->aliases[i] == NULL) {
+                goto fail;
+            }
+        }
+    }
+
+    if (src->addr_list != NULL) {
+        for (len = 0; src->addr_list[len] != NULL; len++);
+
+        ret->addr_list = talloc_zero_array(ret, struct resolv_addr *,
+                                           len + 1);
+        if (ret->addr_list == NULL) {
+            goto fail;
+        }
+
+        for (i = 0; i < len; i++) {
+            ret->addr_list[i] = talloc_zero(ret->addr_list,
+                                            struct resolv_addr);
+            if (ret->addr_list[i] == NULL) {
+                goto fail;
+            }
+
+            ret->addr_list[i]->ipaddr = talloc_memdup(ret->addr_list[i],
+                                            src->addr_list[i]->ipaddr,
+                                            addrlen);
+            if (ret->addr_list[i]->ipaddr == NULL) {
+                goto fail;
+            }
+
+            ret->addr_list[i]->ttl = ttl < 0
+                                     ? src->addr_list[i]->ttl
+                                     : MIN(src->addr_list[i]->ttl, ttl);
+        }
+    }
+
+    return ret;
+
+fail:
+    talloc_free(ret);
+    return NULL;
+}
+
+static struct ares_srv_reply *
+resolv_cache_copy_srv(TALLOC_CTX *mem_ctx, struct ares_srv_reply *src)
+{
+    struct ares_srv_reply *head = NULL;
+    struct ares_srv_reply *prev = NULL;
+    struct ares_srv_reply *cur;
+
+    for (; src != NULL; src = src->next) {
+        cur = talloc_zero(head == NULL ? mem_ctx : head,
+                          struct ares_srv_reply);
+        if (cur == NULL) {
+            talloc_free(head);
+            return NULL;
+        }
+
+        cur->priority = src->priority;
+        cur->weight = src->weight;
+        cur->port = src->port;
+        cur->host = talloc_strdup(cur, src->host);
+        if (cur->host == NULL) {
+            talloc_free(head == NULL ? cur : head);
+            return NULL;
+        }
+
+        if (prev == NULL) {
+            head = cur;
+        } else {
+            prev->next = cur;
+        }
+        prev = cur;
+    }
+
+    return head;
+}
+
+/* Returns the entry if it is valid, ttl is set to its remaining lifetime. */
+static struct resolv_cache_entry *
+resolv_cache_get(struct resolv_ctx *ctx, const char *type, const char *name,
+                 uint32_t *_ttl)
+{
+    struct resolv_cache *cache = ctx->cache;
+    struct resolv_cache_entry *entry;
+    time_t now;
+    char *key;
+
+    if (cache == NULL || name == NULL) {
+        return NULL;
+    }
+
+    key = talloc_asprintf(NULL, "%s:%s", type, name);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key, struct resolv_cache_entry);
+    talloc_free(key);
+
+    now = time(NULL);
+    if (entry != NULL && entry->expire <= now) {
+        talloc_zfree(entry);
+    }
+
+    if (entry == NULL) {
+        cache->stats.misses++;
+        return NULL;
+    }
+
+    if (entry->status == ARES_SUCCESS) {
+        cache->stats.hits++;
+    } else {
+        cache->stats.negative_hits++;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    *_ttl = entry->expire - now;
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Using cached %s answer for '%s'\n",
+          type, name);
+
+    return entry;
+}
+
+/* Takes the data of the answer, either @rhostent or @reply_list are set for
+ * positive answers. */
+static void
+resolv_cache_add(struct resolv_ctx *ctx, const char *type, const char *name,
+                 int status, uint32_t ttl,
+                 struct resolv_hostent *rhostent,
+                 struct ares_srv_reply *reply_list)
+{
+    struct resolv_cache *cache = ctx->cache;
+    struct resolv_cache_entry *entry;
+    char *key;
+    errno_t ret;
+
+    if (cache == NULL || name == NULL) {
+        return;
+    }
+
+    if (status == ARES_SUCCESS) {
+        ttl = MIN(ttl, cache->timeout);
+    } else if (status == ARES_ENOTFOUND || status == ARES_ENODATA) {
+        ttl = MIN(RESOLV_CACHE_NEGATIVE_TIMEOUT, cache->timeout);
+    } else {
+        /* Server failures and timeouts are not cached. */
+        return;
+    }
+
+    if (ttl == 0) {
+        return;
+    }
+
+    key = talloc_asprintf(NULL, "%s:%s", type, name);
+    if (key == NULL) {
+        return;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key, struct resolv_cache_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= RESOLV_CACHE_SIZE) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct resolv_cache_entry);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    entry->status = status;
+    if (rhostent != NULL) {
+        entry->rhostent = resolv_cache_copy_hostent(entry, rhostent, -1);
+        if (entry->rhostent == NULL) {
+            talloc_free(entry);
+            goto done;
+        }
+    }
+
+    if (reply_list != NULL) {
+        entry->reply_list = resolv_cache_copy_srv(entry, reply_list);
+        if (entry->reply_list == NULL) {
+            talloc_free(entry);
+            goto done;
+        }
+    }
+
+    ret = sss_ptr_hash_add(cache->table, key, entry,
+                           struct resolv_cache_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    entry->cache = cache;
+    entry->expire = time(NULL) + ttl;
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    cache->stats.stored++;
+    talloc_set_destructor(entry, resolv_cache_entry_destructor);
+
+done:
+    talloc_free(key);
+}
+
 /* =================== Resolve host name in files =========================*/
 struct gethostbyname_files_state {
     struct resolv_ctx *resolv_ctx;
@@ -775,6 +1138,9 @@ struct gethostbyname_dns_state {
 
 static void
 resolv_gethostbyname_dns_wakeup(struct tevent_req *subreq);
+static bool
+resolv_gethostbyname_dns_cached(struct tevent_req *req,
+                                struct gethostbyname_dns_state *state);
 static void
 resolv_gethostbyname_dns_query(struct tevent_req *req,
                                struct gethostbyname_dns_state *state);
@@ -850,9 +1216,69 @@ resolv_gethostbyname_dns_wakeup(struct tevent_req *subreq)
         return;
     }
 
+    if (resolv_gethostbyname_dns_cached(req, state)) {
+        return;
+    }
+
     resolv_gethostbyname_dns_query(req, state);
 }
 
+static const char *
+resolv_gethostbyname_dns_type(struct gethostbyname_dns_state *state)
+{
+    return state->family == AF_INET ? "A" : "AAAA";
+}
+
+static bool
+resolv_gethostbyname_dns_cached(struct tevent_req *req,
+                                struct gethostbyname_dns_state *state)
+{
+    struct resolv_cache_entry *entry;
+    uint32_t ttl;
+
+    entry = resolv_cache_get(state->resolv_ctx,
+                             resolv_gethostbyname_dns_type(state),
+                             state->name, &ttl);
+    if (entry == NULL) {
+        return false;
+    }
+
+    state->status = entry->status;
+    if (entry->status != ARES_SUCCESS) {
+        tevent_req_error(req, ENOENT);
+        return true;
+    }
+
+    state->rhostent = resolv_cache_copy_hostent(state, entry->rhostent, ttl);
+    if (state->rhostent == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return true;
+    }
+
+    tevent_req_done(req);
+    return true;
+}
+
+static void
+resolv_gethostbyname_dns_store(struct gethostbyname_dns_state *state)
+{
+    uint32_t ttl = UINT32_MAX;
+    int i;
+
+    if (state->status == ARES_SUCCESS) {
+        if (state->rhostent == NULL || state->rhostent->addr_list == NULL) {
+            return;
+        }
+
+        for (i = 0; state->rhostent->addr_list[i] != NULL; i++) {
+            ttl = MIN(ttl, state->rhostent->addr_list[i]->ttl);
+        }
+    }
+
+    resolv_cache_add(state->resolv_ctx, resolv_gethostbyname_dns_type(state),
+                     state->name, state->status, ttl, state->rhostent, NULL);
+}
+
 static void
 resolv_gethostbyname_dns_query(struct tevent_req *req,
                                struct gethostbyname_dns_state *state)
@@ -912,6 +1338,7 @@ resolv_gethostbyname_dns_query_done(void *arg, int status, int timeouts,
     if (status == ARES_ENOTFOUND || status == ARES_ENODATA) {
         /* Just say we didn't find anything and let the caller decide
          * about retrying */
+        resolv_gethostbyname_dns_store(state);
         tevent_req_error(req, ENOENT);
         return;
     }
@@ -930,6 +1357,7 @@ resolv_gethostbyname_dns_query_done(void *arg, int status, int timeouts,
         return;
     }
 
+    resolv_gethostbyname_dns_store(state);
     tevent_req_done(req);
 }
 
@@ -1030,6 +1458,221 @@ resolv_gethostbyname_dns_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+/* ============= Resolve host name in DNS, both families ==================*/
+
+/* How long an answer for the fallback family waits for the preferred one. */
+#define RESOLV_FAMILY_GRACE_MSEC 50
+
+#define RESOLV_DUAL_PREFERRED 0
+#define RESOLV_DUAL_FALLBACK 1
+
+struct gethostbyname_dual_family {
+    struct tevent_req *subreq;
+    int family;
+    bool finished;
+
+    errno_t ret;
+    int status;
+    int timeouts;
+    struct resolv_hostent *rhostent;
+};
+
+struct gethostbyname_dual_state {
+    struct tevent_context *ev;
+    const char *name;
+
+    struct gethostbyname_dual_family families[2];
+    struct tevent_timer *grace_te;
+
+    /* the answer that was picked */
+    struct resolv_hostent *rhostent;
+    int status;
+    int timeouts;
+};
+
+static void
+resolv_gethostbyname_dual_done(struct tevent_req *subreq);
+
+/* Sends the A and AAAA queries at once. An answer for the preferred family
+ * is returned as soon as it arrives; an answer for the other family is only
+ * returned if the preferred family does not answer within a short grace
+ * period or has no addresses. A broken path for one family thus does not
+ * delay the resolution by a full timeout. */
+static struct tevent_req *
+resolv_gethostbyname_dual_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                               struct resolv_ctx *ctx, const char *name,
+                               enum restrict_family family_order)
+{
+    struct gethostbyname_dual_state *state;
+    struct gethostbyname_dual_family *f;
+    struct tevent_req *req;
+    int i;
+
+    req = tevent_req_create(mem_ctx, &state, struct gethostbyname_dual_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->name = name;
+
+    if (family_order == IPV6_FIRST) {
+        state->families[RESOLV_DUAL_PREFERRED].family = AF_INET6;
+        state->families[RESOLV_DUAL_FALLBACK].family = AF_INET;
+    } else {
+        state->families[RESOLV_DUAL_PREFERRED].family = AF_INET;
+        state->families[RESOLV_DUAL_FALLBACK].family = AF_INET6;
+    }
+
+    for (i = RESOLV_DUAL_PREFERRED; i <= RESOLV_DUAL_FALLBACK; i++) {
+        f = &state->families[i];
+
+        f->subreq = resolv_gethostbyname_dns_send(state, ev, ctx,
+                                                  name, f->family);
+        if (f->subreq == NULL) {
+            talloc_zfree(req);
+            return NULL;
+        }
+        tevent_req_set_callback(f->subreq, resolv_gethostbyname_dual_done,
+                                req);
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Querying both address families of %s\n",
+          name);
+
+    return req;
+}
+
+static void
+resolv_gethostbyname_dual_finish(struct tevent_req *req,
+                                 struct gethostbyname_dual_family *f)
+{
+    struct gethostbyname_dual_state *state = tevent_req_data(req,
+                                            struct gethostbyname_dual_state);
+    int i;
+
+    /* Cancel the query that lost, if any. */
+    talloc_zfree(state->grace_te);
+    for (i = RESOLV_DUAL_PREFERRED; i <= RESOLV_DUAL_FALLBACK; i++) {
+        talloc_zfree(state->families[i].subreq);
+    }
+
+    state->status = f->status;
+    state->timeouts = f->timeouts;
+
+    if (f->ret != EOK) {
+        tevent_req_error(req, f->ret);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Using the %s address of %s\n",
+          f->family == AF_INET ? "IPv4" : "IPv6", state->name);
+
+    state->rhostent = talloc_steal(state, f->rhostent);
+    tevent_req_done(req);
+}
+
+static void
+resolv_gethostbyname_dual_grace(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval tv,
+                                void *pvt)
+{
+    struct tevent_req *req = talloc_get_type(pvt, struct tevent_req);
+    struct gethostbyname_dual_state *state = tevent_req_data(req,
+                                            struct gethostbyname_dual_state);
+
+    state->grace_te = NULL;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "No answer for the preferred address family of "
+          "%s within %d ms\n", state->name, RESOLV_FAMILY_GRACE_MSEC);
+
+    resolv_gethostbyname_dual_finish(req,
+                                &state->families[RESOLV_DUAL_FALLBACK]);
+}
+
+static void
+resolv_gethostbyname_dual_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct gethostbyname_dual_state *state = tevent_req_data(req,
+                                            struct gethostbyname_dual_state);
+    struct gethostbyname_dual_family *preferred;
+    struct gethostbyname_dual_family *fallback;
+    struct gethostbyname_dual_family *f;
+    struct timeval tv;
+
+    preferred = &state->families[RESOLV_DUAL_PREFERRED];
+    fallback = &state->families[RESOLV_DUAL_FALLBACK];
+    f = subreq == preferred->subreq ? preferred : fallback;
+
+    f->ret = resolv_gethostbyname_dns_recv(subreq, state, &f->status,
+                                           &f->timeouts, &f->rhostent);
+    f->finished = true;
+    talloc_zfree(f->subreq);
+
+    if (f->ret == ETIMEDOUT) {
+        /* In case we killed the request before c-ares answered */
+        f->status = ARES_ETIMEOUT;
+    }
+
+    if (preferred->finished && preferred->ret == EOK) {
+        resolv_gethostbyname_dual_finish(req, preferred);
+        return;
+    }
+
+    if (!preferred->finished) {
+        if (fallback->ret == EOK) {
+            tv = tevent_timeval_current_ofs(0,
+                                        RESOLV_FAMILY_GRACE_MSEC * 1000);
+            state->grace_te = tevent_add_timer(state->ev, state, tv,
+                                           resolv_gethostbyname_dual_grace,
+                                           req);
+            if (state->grace_te == NULL) {
+                resolv_gethostbyname_dual_finish(req, fallback);
+            }
+        }
+        return;
+    }
+
+    if (!fallback->finished) {
+        return;
+    }
+
+    /* The preferred family has no usable answer. Report its error unless
+     * it simply has no addresses, as if the families were tried in turn. */
+    if (fallback->ret == EOK || preferred->ret == ENOENT) {
+        resolv_gethostbyname_dual_finish(req, fallback);
+    } else {
+        resolv_gethostbyname_dual_finish(req, preferred);
+    }
+}
+
+static int
+resolv_gethostbyname_dual_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
+                               int *status, int *timeouts,
+                               struct resolv_hostent **rhostent)
+{
+    struct gethostbyname_dual_state *state = tevent_req_data(req,
+                                            struct gethostbyname_dual_state);
+
+    if (status) {
+        *status = state->status;
+    }
+    if (timeouts) {
+        *timeouts = state->timeouts;
+    }
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (rhostent) {
+        *rhostent = talloc_steal(mem_ctx, state->rhostent);
+    }
+
+    return EOK;
+}
+
 /*******************************************************************
  * Get host by name.                                               *
  *******************************************************************/
@@ -1049,6 +1692,9 @@ struct gethostbyname_state {
     enum host_database *db;
     int dbi;
 
+    /* Both address families are queried in DNS at once */
+    bool dual;
+
     /* These are returned by ares. The hostent struct will be freed
      * when the user callback returns. */
     struct resolv_hostent *rhostent;
@@ -1290,6 +1936,18 @@ resolv_gethostbyname_step(struct tevent_req *req)
             break;
         case DB_DNS:
             DEBUG(SSSDBG_TRACE_INTERNAL, "Querying DNS\n");
+            state->dual = (state->family_order == IPV4_FIRST
+                                || state->family_order == IPV6_FIRST)
+                          && state->family == resolv_gethostbyname_family_init(
+                                                        state->family_order);
+            if (state->dual) {
+                subreq = resolv_gethostbyname_dual_send(state, state->ev,
+                                                        state->resolv_ctx,
+                                                        state->name,
+                                                        state->family_order);
+                break;
+            }
+
             subreq = resolv_gethostbyname_dns_send(state, state->ev,
                                                    state->resolv_ctx,
                                                    state->name,
@@ -1326,6 +1984,19 @@ resolv_gethostbyname_done(struct tevent_req *subreq)
             state->timeouts = 0;
             break;
         case DB_DNS:
+            if (state->dual) {
+                ret = resolv_gethostbyname_dual_recv(subreq, state,
+                                                     &state->status,
+                                                     &state->timeouts,
+                                                     &state->rhostent);
+                if (ret == ENOENT) {
+                    /* Both families were tried already. */
+                    state->family = state->family == AF_INET ? AF_INET6
+                                                             : AF_INET;
+                }
+                break;
+            }
+
             ret = resolv_gethostbyname_dns_recv(subreq, state,
                                                 &state->status, &state->timeouts,
                                                 &state->rhostent);
@@ -1736,6 +2407,8 @@ resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int
     state->timeouts = timeouts;
 
     if (status != ARES_SUCCESS) {
+        resolv_cache_add(state->resolv_ctx, "SRV", state->query, status, 0,
+                         NULL, NULL);
         ret = return_code(status);
         goto fail;
     }
@@ -1759,6 +2432,9 @@ resolv_getsrv_done(void *arg, int status, int timeouts, unsigned char *abuf, int
     }
     DEBUG(SSSDBG_TRACE_LIBS, "Using TTL [%"PRIu32"]\n", state->ttl);
 
+    resolv_cache_add(state->resolv_ctx, "SRV", state->query, status,
+                     state->ttl, NULL, state->reply_list);
+
     tevent_req_done(req);
     return;
 
@@ -1796,6 +2472,7 @@ ares_getsrv_wakeup(struct tevent_req *subreq)
                                                 struct tevent_req);
     struct getsrv_state *state = tevent_req_data(req,
                                                 struct getsrv_state);
+    struct resolv_cache_entry *entry;
 
     if (!tevent_wakeup_recv(subreq)) {
         return;
@@ -1809,6 +2486,25 @@ ares_getsrv_wakeup(struct tevent_req *subreq)
         return;
     }
 
+    entry = resolv_cache_get(state->resolv_ctx, "SRV", state->query,
+                             &state->ttl);
+    if (entry != NULL) {
+        state->status = entry->status;
+        if (entry->status != ARES_SUCCESS) {
+            tevent_req_error(req, return_code(entry->status));
+            return;
+        }
+
+        state->reply_list = resolv_cache_copy_srv(state, entry->reply_list);
+        if (state->reply_list == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
+        }
+
+        tevent_req_done(req);
+        return;
+    }
+
     return resolv_getsrv_query(req, state);
 }
 
@@ -56,6 +56,23 @@ int resolv_init(TALLOC_CTX *mem_ctx, struct tevent_context *ev_ctx,
 
 void resolv_reread_configuration(struct resolv_ctx *ctx);
 
+/* Cache of DNS answers. Positive answers are kept for their TTL but at
+ * most @timeout seconds, names that do not exist are kept for a few
+ * seconds. The cache is disabled if @timeout is 0. */
+errno_t resolv_cache_init(struct resolv_ctx *ctx, int timeout);
+
+void resolv_cache_flush(struct resolv_ctx *ctx);
+
+struct resolv_cache_stats {
+    uint64_t hits;
+    uint64_t negative_hits;
+    uint64_t misses;
+    uint64_t stored;
+};
+
+void resolv_cache_get_stats(struct resolv_ctx *ctx,
+                            struct resolv_cache_stats *_stats);
+
 const char *resolv_strerror(int ares_code);
 
 struct resolv_hostent *
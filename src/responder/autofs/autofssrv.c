@@ -87,9 +87,10 @@ autofs_register_service_iface(struct autofs_ctx *autofs_ctx,
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to register service interface"
               "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
     }
 
-    return ret;
+    return sss_resp_register_stats_iface(rctx);
 }
 
 static int
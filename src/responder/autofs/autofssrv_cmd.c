@@ -80,37 +80,42 @@ autofs_cmd_done(struct autofs_cmd_ctx *cmdctx, int ret)
     return EOK;
 }
 
-static errno_t
-autofs_fill_entry(struct ldb_message *entry, struct sss_packet *packet, size_t *rp)
+/* Returns the space needed by the entry in the reply or 0 if the entry
+ * cannot be returned. */
+static size_t
+autofs_entry_len(struct ldb_message *entry)
 {
-    errno_t ret;
     const char *key;
-    size_t keylen;
     const char *value;
-    size_t valuelen;
-    uint8_t *body;
-    size_t blen;
-    size_t len;
 
     key = ldb_msg_find_attr_as_string(entry, SYSDB_AUTOFS_ENTRY_KEY, NULL);
     value = ldb_msg_find_attr_as_string(entry, SYSDB_AUTOFS_ENTRY_VALUE, NULL);
     if (!key || !value) {
         DEBUG(SSSDBG_MINOR_FAILURE, "Incomplete entry\n");
-        return EINVAL;
+        return 0;
     }
 
+    return sizeof(uint32_t) + sizeof(uint32_t) + strlen(key) + 1
+           + sizeof(uint32_t) + strlen(value) + 1;
+}
+
+/* The body must already have space for autofs_entry_len() bytes. */
+static void
+autofs_fill_entry(struct ldb_message *entry, uint8_t *body, size_t *rp)
+{
+    const char *key;
+    size_t keylen;
+    const char *value;
+    size_t valuelen;
+    size_t len;
+
+    key = ldb_msg_find_attr_as_string(entry, SYSDB_AUTOFS_ENTRY_KEY, NULL);
+    value = ldb_msg_find_attr_as_string(entry, SYSDB_AUTOFS_ENTRY_VALUE, NULL);
+
     keylen = 1 + strlen(key);
     valuelen = 1 + strlen(value);
     len = sizeof(uint32_t) + sizeof(uint32_t) + keylen + sizeof(uint32_t) + valuelen;
 
-    ret = sss_packet_grow(packet, len);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Cannot grow packet\n");
-        return ret;
-    }
-
-    sss_packet_get_body(packet, &body, &blen);
-
     SAFEALIGN_SET_UINT32(&body[*rp], len, rp);
     SAFEALIGN_SET_UINT32(&body[*rp], keylen, rp);
 
@@ -128,8 +133,6 @@ autofs_fill_entry(struct ldb_message *entry, struct sss_packet *packet, size_t *
         memcpy(&body[*rp], value, valuelen);
     }
     *rp += valuelen;
-
-    return EOK;
 }
 
 void
@@ -589,9 +592,10 @@ autofs_write_getautomntent_output(struct cli_ctx *cli_ctx,
 {
     struct cli_protocol *pctx;
     struct ldb_message **entries;
-    struct ldb_message *entry;
     size_t count;
     size_t num_entries;
+    size_t *lens;
+    size_t total;
     uint8_t *body;
     size_t blen;
     size_t rp;
@@ -616,34 +620,45 @@ autofs_write_getautomntent_output(struct cli_ctx *cli_ctx,
         return sss_cmd_empty_packet(pctx->creq->out);
     }
 
-    /* allocate memory for number of entries in the packet */
-    ret = sss_packet_grow(pctx->creq->out, sizeof(uint32_t));
+    left = count - cursor;
+    stop = max_entries < left ? max_entries : left;
+
+    lens = talloc_array(NULL, size_t, stop);
+    if (lens == NULL) {
+        return ENOMEM;
+    }
+
+    /* Size the whole batch first so that the packet is grown only once. */
+    total = sizeof(uint32_t);
+    for (i = 0; i < stop; i++) {
+        lens[i] = autofs_entry_len(entries[cursor + i]);
+        if (lens[i] == 0) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot fill entry %d/%d, skipping\n", i, stop);
+        }
+        total += lens[i];
+    }
+
+    ret = sss_packet_grow(pctx->creq->out, total);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Cannot grow packet\n");
+        talloc_free(lens);
         return ret;
     }
 
-    rp = sizeof(uint32_t);  /* We will first write the elements. */
-    left = count - cursor;
-    stop = max_entries < left ? max_entries : left;
+    sss_packet_get_body(pctx->creq->out, &body, &blen);
 
+    rp = sizeof(uint32_t);  /* We will first write the elements. */
     num_entries = 0;
     for (i = 0; i < stop; i++) {
-        entry = entries[cursor];
-        cursor++;
-
-        ret = autofs_fill_entry(entry, pctx->creq->out, &rp);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "Cannot fill entry %d/%d, skipping\n", i, stop);
+        if (lens[i] == 0) {
             continue;
         }
+
+        autofs_fill_entry(entries[cursor + i], body, &rp);
         num_entries++;
     }
-
-    /* packet grows in fill_autofs_entry, body pointer may change,
-     * thus we have to obtain it here */
-    sss_packet_get_body(pctx->creq->out, &body, &blen);
+    talloc_free(lens);
 
     rp = 0;
     SAFEALIGN_SET_UINT32(&body[rp], num_entries, &rp);
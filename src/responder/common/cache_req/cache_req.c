@@ -24,6 +24,10 @@
 #include <errno.h>
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
+#include "util/sss_trace.h"
+#include "util/probes.h"
+#include "util/sss_metrics.h"
 #include "responder/common/responder.h"
 #include "responder/common/cache_req/cache_req_private.h"
 #include "responder/common/cache_req/cache_req_plugin.h"
@@ -118,6 +122,38 @@ cache_req_dom_type_as_str(struct cache_req *cr)
     return "Unknown";
 }
 
+/* Bounds of the memory pool a cache request keeps its internal data in. */
+#define CACHE_REQ_POOL_MIN_SIZE 1024
+#define CACHE_REQ_POOL_MAX_SIZE (16 * 1024)
+#define CACHE_REQ_POOL_MIN_OBJECTS 4
+#define CACHE_REQ_POOL_MAX_OBJECTS 64
+
+static int cache_req_destructor(struct cache_req *cr)
+{
+    struct resp_ctx *rctx = cr->rctx;
+    size_t size;
+    unsigned int objects;
+
+    /* Follow growth at once and shrink slowly so that a single small
+     * request does not make the next larger ones allocate again. */
+    size = talloc_total_size(cr);
+    if (size >= rctx->cache_req_pool_size) {
+        rctx->cache_req_pool_size = size;
+    } else {
+        rctx->cache_req_pool_size -= (rctx->cache_req_pool_size - size) / 8;
+    }
+
+    objects = talloc_total_blocks(cr);
+    if (objects >= rctx->cache_req_pool_objects) {
+        rctx->cache_req_pool_objects = objects;
+    } else {
+        rctx->cache_req_pool_objects -=
+                            (rctx->cache_req_pool_objects - objects) / 8;
+    }
+
+    return 0;
+}
+
 static struct cache_req *
 cache_req_create(TALLOC_CTX *mem_ctx,
                  struct resp_ctx *rctx,
@@ -128,12 +164,24 @@ cache_req_create(TALLOC_CTX *mem_ctx,
 {
     struct cache_req *cr;
     bool bypass_cache;
+    size_t pool_size;
+    unsigned int pool_objects;
     errno_t ret;
 
-    cr = talloc_zero(mem_ctx, struct cache_req);
+    /* The request, its debug names and its copy of the domain list are
+     * allocated from a single pool. Results are not, they outlive it. */
+    pool_size = MIN(MAX(rctx->cache_req_pool_size, CACHE_REQ_POOL_MIN_SIZE),
+                    CACHE_REQ_POOL_MAX_SIZE);
+    pool_objects = MIN(MAX(rctx->cache_req_pool_objects,
+                           CACHE_REQ_POOL_MIN_OBJECTS),
+                       CACHE_REQ_POOL_MAX_OBJECTS);
+
+    cr = talloc_pooled_object(mem_ctx, struct cache_req, pool_objects,
+                              pool_size - sizeof(struct cache_req));
     if (cr == NULL) {
         return NULL;
     }
+    memset(cr, 0, sizeof(struct cache_req));
 
     cr->rctx = rctx;
     cr->data = data;
@@ -151,6 +199,8 @@ cache_req_create(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    talloc_set_destructor(cr, cache_req_destructor);
+
     bypass_cache = cr->plugin->bypass_cache || cr->data->bypass_cache;
     if (bypass_cache && cr->data->bypass_dp) {
         CACHE_REQ_DEBUG(SSSDBG_CRIT_FAILURE, cr,
@@ -693,9 +743,24 @@ struct cache_req_search_domains_state {
     bool dp_success;
     bool first_iteration;
     enum cache_req_behavior cache_behavior;
+
+    /* parallel search, in the order of the domains */
+    struct cache_req_parallel_search *searches;
+    size_t num_searches;
+};
+
+struct cache_req_parallel_search {
+    struct tevent_req *req;
+    struct cache_req *cr;
+    struct sss_domain_info *domain;
+
+    /* EAGAIN while the search is running */
+    errno_t ret;
+    struct ldb_result *result;
 };
 
 static errno_t cache_req_search_domains_next(struct tevent_req *req);
+static errno_t cache_req_search_domains_parallel(struct tevent_req *req);
 static errno_t cache_req_handle_result(struct tevent_req *req,
                                        struct ldb_result *result);
 
@@ -731,6 +796,19 @@ cache_req_search_domains_send(TALLOC_CTX *mem_ctx,
     state->dp_success = true;
     state->first_iteration = first_iteration;
 
+    ret = cache_req_search_domains_parallel(req);
+    if (ret == EAGAIN) {
+        return req;
+    } else if (ret != ENOENT) {
+        if (ret == EOK) {
+            tevent_req_done(req);
+        } else {
+            tevent_req_error(req, ret);
+        }
+        tevent_req_post(req, ev);
+        return req;
+    }
+
     if (cr->plugin->dp_get_domain_send_fn != NULL
             && ((state->check_next && cr_domain->next != NULL)
                 || ((state->cr->cache_behavior == CACHE_REQ_CACHE_FIRST)
@@ -758,46 +836,52 @@ cache_req_search_domains_send(TALLOC_CTX *mem_ctx,
     return req;
 }
 
+static bool cache_req_search_domains_skip(struct cache_req *cr,
+                                          struct cache_req_domain *cr_domain,
+                                          bool check_next)
+{
+    struct sss_domain_info *domain = cr_domain->domain;
+
+    /* As the cr_domain list is a flatten version of the domains
+     * list, we have to ensure to only go through the subdomains in
+     * case it's specified in the plugin to do so.
+     */
+    if (cr->plugin->get_next_domain_flags == 0 && IS_SUBDOMAIN(domain)) {
+        return true;
+    }
+
+    /* Check if this domain is valid for this request. */
+    if (!cache_req_validate_domain(cr, domain)) {
+        return true;
+    }
+
+    /* If not specified otherwise, we skip domains that require fully
+     * qualified names on domain less search. We do not descend into
+     * subdomains here since those are implicitly qualified.
+     */
+    if (check_next && !cr->plugin->allow_missing_fqn && cr_domain->fqnames) {
+        return true;
+    }
+
+    return false;
+}
+
 static errno_t cache_req_search_domains_next(struct tevent_req *req)
 {
     struct cache_req_search_domains_state *state;
     struct tevent_req *subreq;
     struct cache_req *cr;
     struct sss_domain_info *domain;
-    uint32_t next_domain_flag;
-    bool is_domain_valid;
-    bool allow_no_fqn;
     errno_t ret;
 
     state = tevent_req_data(req, struct cache_req_search_domains_state);
     cr = state->cr;
 
-    next_domain_flag = cr->plugin->get_next_domain_flags;
-    allow_no_fqn = cr->plugin->allow_missing_fqn;
-
     while (state->cr_domain != NULL) {
         domain = state->cr_domain->domain;
-        /* As the cr_domain list is a flatten version of the domains
-         * list, we have to ensure to only go through the subdomains in
-         * case it's specified in the plugin to do so.
-         */
-        if (next_domain_flag == 0 && IS_SUBDOMAIN(domain)) {
-            state->cr_domain = state->cr_domain->next;
-            continue;
-        }
 
-        /* Check if this domain is valid for this request. */
-        is_domain_valid = cache_req_validate_domain(cr, domain);
-        if (!is_domain_valid) {
-            state->cr_domain = state->cr_domain->next;
-            continue;
-        }
-
-        /* If not specified otherwise, we skip domains that require fully
-         * qualified names on domain less search. We do not descend into
-         * subdomains here since those are implicitly qualified.
-         */
-        if (state->check_next && !allow_no_fqn && state->cr_domain->fqnames) {
+        if (cache_req_search_domains_skip(cr, state->cr_domain,
+                                          state->check_next)) {
             state->cr_domain = state->cr_domain->next;
             continue;
         }
@@ -1009,6 +1093,233 @@ done:
     return;
 }
 
+/* A copy of the request that searches one domain of a parallel search
+ * without changing the domain data of the original request. */
+static struct cache_req *
+cache_req_parallel_search_cr(TALLOC_CTX *mem_ctx,
+                             struct cache_req *cr,
+                             struct sss_domain_info *domain)
+{
+    struct cache_req *dom_cr;
+    errno_t ret;
+
+    dom_cr = talloc(mem_ctx, struct cache_req);
+    if (dom_cr == NULL) {
+        return NULL;
+    }
+
+    *dom_cr = *cr;
+    dom_cr->debugobj = NULL;
+
+    dom_cr->data = talloc(dom_cr, struct cache_req_data);
+    if (dom_cr->data == NULL) {
+        talloc_free(dom_cr);
+        return NULL;
+    }
+
+    *dom_cr->data = *cr->data;
+    dom_cr->data->name.lookup = NULL;
+    dom_cr->data->svc.protocol.lookup = NULL;
+
+    ret = cache_req_set_domain(dom_cr, domain);
+    if (ret != EOK) {
+        talloc_free(dom_cr);
+        return NULL;
+    }
+
+    return dom_cr;
+}
+
+static bool
+cache_req_search_domains_parallel_allowed(struct cache_req_search_domains_state *state)
+{
+    struct cache_req *cr = state->cr;
+
+    if (!cr->rctx->parallel_domain_lookups || !state->check_next) {
+        return false;
+    }
+
+    /* Requests that collect the results of all domains or that first
+     * locate the right domain are still sent one after another. */
+    if (cr->plugin->search_all_domains
+            || cr->plugin->dp_get_domain_send_fn != NULL) {
+        return false;
+    }
+
+    /* The parsed service name is shared by all copies of the request. */
+    if (cr->data->svc.name != NULL) {
+        return false;
+    }
+
+    return true;
+}
+
+static void cache_req_search_domains_parallel_done(struct tevent_req *subreq);
+
+/* Searches all candidate domains at once. Returns ENOENT if the request
+ * has to search them one by one instead. */
+static errno_t cache_req_search_domains_parallel(struct tevent_req *req)
+{
+    struct cache_req_search_domains_state *state;
+    struct cache_req_parallel_search *search;
+    struct cache_req_domain *cr_domain;
+    struct tevent_req *subreq;
+    size_t count = 0;
+    size_t i;
+
+    state = tevent_req_data(req, struct cache_req_search_domains_state);
+
+    if (!cache_req_search_domains_parallel_allowed(state)) {
+        return ENOENT;
+    }
+
+    for (cr_domain = state->cr_domain; cr_domain != NULL;
+         cr_domain = cr_domain->next) {
+        if (!cache_req_search_domains_skip(state->cr, cr_domain, true)) {
+            count++;
+        }
+    }
+
+    if (count < 2) {
+        return ENOENT;
+    }
+
+    state->searches = talloc_zero_array(state, struct cache_req_parallel_search,
+                                        count);
+    if (state->searches == NULL) {
+        return ENOMEM;
+    }
+
+    CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->cr,
+                    "Searching %zu domains in parallel\n", count);
+
+    i = 0;
+    for (cr_domain = state->cr_domain; cr_domain != NULL;
+         cr_domain = cr_domain->next) {
+        if (cache_req_search_domains_skip(state->cr, cr_domain, true)) {
+            continue;
+        }
+
+        search = &state->searches[i];
+        search->req = req;
+        search->domain = cr_domain->domain;
+        search->ret = EAGAIN;
+
+        search->cr = cache_req_parallel_search_cr(state->searches, state->cr,
+                                                  search->domain);
+        if (search->cr == NULL) {
+            talloc_zfree(state->searches);
+            return ENOMEM;
+        }
+
+        subreq = cache_req_search_send(state->searches, state->ev, search->cr,
+                                       state->first_iteration, false);
+        if (subreq == NULL) {
+            talloc_zfree(state->searches);
+            return ENOMEM;
+        }
+        tevent_req_set_callback(subreq, cache_req_search_domains_parallel_done,
+                                search);
+        i++;
+    }
+    state->num_searches = count;
+
+    return EAGAIN;
+}
+
+/* The results are used in the order of the domains, so a result can only
+ * be returned once all the domains before its own one found nothing. */
+static errno_t
+cache_req_search_domains_parallel_check(struct tevent_req *req)
+{
+    struct cache_req_search_domains_state *state;
+    struct cache_req_parallel_search *search;
+    errno_t ret;
+    size_t i;
+
+    state = tevent_req_data(req, struct cache_req_search_domains_state);
+
+    for (i = 0; i < state->num_searches; i++) {
+        search = &state->searches[i];
+
+        switch (search->ret) {
+        case EAGAIN:
+            return EAGAIN;
+        case ENOENT:
+            continue;
+        case EOK:
+            /* Leave the request as if it searched this domain last. */
+            ret = cache_req_set_domain(state->cr, search->domain);
+            if (ret != EOK) {
+                return ret;
+            }
+
+            state->selected_domain = search->domain;
+            return cache_req_handle_result(req, search->result);
+        default:
+            return search->ret;
+        }
+    }
+
+    if (state->dp_success) {
+        cache_req_global_ncache_add(state->cr);
+    }
+
+    return ENOENT;
+}
+
+static void cache_req_search_domains_parallel_done(struct tevent_req *subreq)
+{
+    struct cache_req_search_domains_state *state;
+    struct cache_req_parallel_search *search;
+    struct tevent_req *req;
+    bool dp_success;
+    errno_t ret;
+
+    search = tevent_req_callback_data(subreq, struct cache_req_parallel_search);
+    req = search->req;
+    state = tevent_req_data(req, struct cache_req_search_domains_state);
+
+    ret = cache_req_search_recv(state->searches, subreq, &search->result,
+                                &dp_success);
+    talloc_zfree(subreq);
+
+    state->cr->lookup_flags |= search->cr->lookup_flags;
+
+    /* Remember if any DP request fails. */
+    state->dp_success = !dp_success ? false : state->dp_success;
+
+    switch (ret) {
+    case EOK:
+        CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, state->cr,
+                        "Domain [%s] answered with a result\n",
+                        search->domain->name);
+        break;
+    case ERR_ID_OUTSIDE_RANGE:
+    case ENOENT:
+        ret = ENOENT;
+        break;
+    default:
+        break;
+    }
+    search->ret = ret;
+
+    ret = cache_req_search_domains_parallel_check(req);
+    if (ret == EAGAIN) {
+        return;
+    }
+
+    /* Searches of lower priority domains are not needed anymore. */
+    talloc_zfree(state->searches);
+    state->num_searches = 0;
+
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+}
+
 static errno_t
 cache_req_search_domains_recv(TALLOC_CTX *mem_ctx,
                               struct tevent_req *req,
@@ -1042,6 +1353,12 @@ struct cache_req_state {
     struct cache_req_result **results;
     size_t num_results;
     bool first_iteration;
+
+    /* Lookup flags of a request that waited for an identical one. */
+    uint32_t lookup_flags;
+
+    /* root of the trace of the lookup */
+    struct sss_trace_span *span;
 };
 
 static errno_t cache_req_process_input(TALLOC_CTX *mem_ctx,
@@ -1070,14 +1387,14 @@ static void cache_req_process_result(struct tevent_req *subreq);
 
 static void cache_req_done(struct tevent_req *subreq);
 
-struct tevent_req *cache_req_send(TALLOC_CTX *mem_ctx,
-                                  struct tevent_context *ev,
-                                  struct resp_ctx *rctx,
-                                  struct sss_nc_ctx *ncache,
-                                  int midpoint,
-                                  enum cache_req_dom_type req_dom_type,
-                                  const char *domain,
-                                  struct cache_req_data *data)
+static struct tevent_req *cache_req_lookup_send(TALLOC_CTX *mem_ctx,
+                                                struct tevent_context *ev,
+                                                struct resp_ctx *rctx,
+                                                struct sss_nc_ctx *ncache,
+                                                int midpoint,
+                                                enum cache_req_dom_type req_dom_type,
+                                                const char *domain,
+                                                struct cache_req_data *data)
 {
     struct cache_req_state *state;
     struct cache_req_result *result;
@@ -1099,11 +1416,14 @@ struct tevent_req *cache_req_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
     state->first_iteration = true;
+    state->span = sss_trace_span_start(state, 0, 0, cr->reqname, domain);
 
     CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, cr, "New request '%s'\n", cr->reqname);
+    PROBE(CACHE_REQ_SEND, cr->reqname, cr->reqid, PROBE_SAFE_STR(domain));
 
     ret = cache_req_is_well_known_object(state, cr, &result);
     if (ret == EOK) {
+        cr->lookup_flags |= CACHE_REQ_LOOKUP_WELL_KNOWN;
         ret = cache_req_add_result(state, result, &state->results,
                                    &state->num_results);
         goto done;
@@ -1131,6 +1451,337 @@ done:
     return req;
 }
 
+/* Identical requests that are started while a lookup is still in progress
+ * do not search the cache and the data provider again. They are attached
+ * to the pending lookup (flight) and receive its result instead. */
+struct cache_req_flight_waiter {
+    struct cache_req_flight_waiter *prev;
+    struct cache_req_flight_waiter *next;
+
+    struct cache_req_flight *flight;
+    struct tevent_req *req;
+};
+
+struct cache_req_flight {
+    hash_table_t *table;
+    const char *key;
+    const char *domain;
+    struct cache_req_data *data;
+
+    struct cache_req_flight_waiter *waiters;
+};
+
+static void cache_req_flight_done(struct tevent_req *subreq);
+
+static bool cache_req_flight_allowed(struct resp_ctx *rctx,
+                                     struct cache_req_data *data)
+{
+    if (rctx->cache_req_flights == NULL) {
+        return false;
+    }
+
+    if (data->attrs != NULL || data->bypass_cache || data->bypass_dp) {
+        return false;
+    }
+
+    switch (data->type) {
+    case CACHE_REQ_USER_BY_NAME:
+    case CACHE_REQ_GROUP_BY_NAME:
+    case CACHE_REQ_INITGROUPS:
+        return data->name.input != NULL;
+    case CACHE_REQ_USER_BY_ID:
+    case CACHE_REQ_GROUP_BY_ID:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static const char *
+cache_req_flight_key(TALLOC_CTX *mem_ctx,
+                     struct sss_nc_ctx *ncache,
+                     int midpoint,
+                     enum cache_req_dom_type req_dom_type,
+                     const char *domain,
+                     struct cache_req_data *data)
+{
+    if (data->name.input != NULL) {
+        /* Results of gids_only requests are not complete. */
+        return talloc_asprintf(mem_ctx, "%d:%d:%d:%d:%p:%s:%s", data->type,
+                               data->gids_only, req_dom_type, midpoint, ncache,
+                               domain == NULL ? "" : domain,
+                               data->name.input);
+    }
+
+    return talloc_asprintf(mem_ctx, "%d:%d:%d:%p:%s:%"PRIu32, data->type,
+                           req_dom_type, midpoint, ncache,
+                           domain == NULL ? "" : domain, data->id);
+}
+
+static int cache_req_flight_destructor(struct cache_req_flight *flight)
+{
+    struct cache_req_flight_waiter *waiter;
+
+    /* The responder is going away, waiters are left unfinished. */
+    for (waiter = flight->waiters; waiter != NULL; waiter = waiter->next) {
+        waiter->flight = NULL;
+    }
+
+    return 0;
+}
+
+static int cache_req_flight_waiter_destructor(
+                                        struct cache_req_flight_waiter *waiter)
+{
+    if (waiter->flight != NULL) {
+        DLIST_REMOVE(waiter->flight->waiters, waiter);
+    }
+
+    return 0;
+}
+
+static struct cache_req_flight *
+cache_req_flight_create(struct tevent_context *ev,
+                        struct resp_ctx *rctx,
+                        struct sss_nc_ctx *ncache,
+                        int midpoint,
+                        enum cache_req_dom_type req_dom_type,
+                        const char *domain,
+                        struct cache_req_data *data,
+                        const char *key)
+{
+    struct cache_req_flight *flight;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    flight = talloc_zero(rctx->cache_req_flights, struct cache_req_flight);
+    if (flight == NULL) {
+        return NULL;
+    }
+
+    flight->table = rctx->cache_req_flights;
+    flight->key = talloc_strdup(flight, key);
+    if (flight->key == NULL) {
+        goto fail;
+    }
+
+    if (domain != NULL) {
+        flight->domain = talloc_strdup(flight, domain);
+        if (flight->domain == NULL) {
+            goto fail;
+        }
+    }
+
+    /* The lookup must not depend on the input of any of the waiters as they
+     * may be freed before it finishes. */
+    if (data->name.input != NULL) {
+        flight->data = cache_req_data_name(flight, data->type,
+                                           data->name.input);
+    } else {
+        flight->data = cache_req_data_id(flight, data->type, data->id);
+    }
+    if (flight->data == NULL) {
+        goto fail;
+    }
+
+    ret = sss_ptr_hash_add(flight->table, flight->key, flight,
+                           struct cache_req_flight);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    talloc_set_destructor(flight, cache_req_flight_destructor);
+
+    subreq = cache_req_lookup_send(flight, ev, rctx, ncache, midpoint,
+                                   req_dom_type, flight->domain,
+                                   flight->data);
+    if (subreq == NULL) {
+        goto fail;
+    }
+
+    tevent_req_set_callback(subreq, cache_req_flight_done, flight);
+
+    return flight;
+
+fail:
+    talloc_free(flight);
+    return NULL;
+}
+
+/* Results of a flight are shared by all its waiters. Every waiter gets its
+ * own copy of each result, the messages are kept alive for as long as any
+ * of them exists. */
+static errno_t
+cache_req_flight_share_results(TALLOC_CTX *mem_ctx,
+                               struct cache_req_result **shared,
+                               struct cache_req_result ***_results,
+                               size_t *_num_results)
+{
+    struct cache_req_result **results;
+    size_t count;
+    size_t i;
+
+    for (count = 0; shared[count] != NULL; count++);
+
+    results = talloc_zero_array(mem_ctx, struct cache_req_result *, count + 1);
+    if (results == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        results[i] = cache_req_share_result(results, shared[i]);
+        if (results[i] == NULL) {
+            talloc_free(results);
+            return ENOMEM;
+        }
+    }
+
+    *_results = results;
+    *_num_results = count;
+
+    return EOK;
+}
+
+static void cache_req_flight_done(struct tevent_req *subreq)
+{
+    struct cache_req_flight *flight;
+    struct cache_req_flight_waiter *waiter;
+    struct cache_req_state *state;
+    struct cache_req_result **results = NULL;
+    struct tevent_req *req;
+    bool shared = false;
+    uint32_t lookup_flags;
+    errno_t ret;
+
+    flight = tevent_req_callback_data(subreq, struct cache_req_flight);
+
+    lookup_flags = cache_req_get_lookup_flags(subreq);
+    ret = cache_req_recv(flight, subreq, &results);
+    talloc_zfree(subreq);
+
+    /* Requests that start from now on need a new lookup. */
+    sss_ptr_hash_delete(flight->table, flight->key, false);
+
+    while ((waiter = flight->waiters) != NULL) {
+        DLIST_REMOVE(flight->waiters, waiter);
+        waiter->flight = NULL;
+
+        req = waiter->req;
+        state = tevent_req_data(req, struct cache_req_state);
+        state->lookup_flags = lookup_flags;
+
+        if (ret != EOK || results == NULL) {
+            tevent_req_error(req, ret == EOK ? ERR_INTERNAL : ret);
+            continue;
+        }
+
+        if (flight->waiters == NULL && !shared) {
+            /* The only waiter can take the results as they are. */
+            state->results = talloc_steal(state, results);
+            for (state->num_results = 0;
+                 results[state->num_results] != NULL;
+                 state->num_results++);
+            tevent_req_done(req);
+            continue;
+        }
+
+        if (cache_req_flight_share_results(state, results, &state->results,
+                                           &state->num_results) != EOK) {
+            tevent_req_error(req, ENOMEM);
+            continue;
+        }
+        shared = true;
+
+        tevent_req_done(req);
+    }
+
+    talloc_free(flight);
+}
+
+static errno_t cache_req_flight_join(struct tevent_req *req,
+                                     struct tevent_context *ev,
+                                     struct resp_ctx *rctx,
+                                     struct sss_nc_ctx *ncache,
+                                     int midpoint,
+                                     enum cache_req_dom_type req_dom_type,
+                                     const char *domain,
+                                     struct cache_req_data *data)
+{
+    struct cache_req_state *state;
+    struct cache_req_flight_waiter *waiter;
+    struct cache_req_flight *flight;
+    const char *key;
+
+    state = tevent_req_data(req, struct cache_req_state);
+
+    key = cache_req_flight_key(state, ncache, midpoint, req_dom_type,
+                               domain, data);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    flight = sss_ptr_hash_lookup(rctx->cache_req_flights, key,
+                                 struct cache_req_flight);
+    if (flight != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Waiting for identical request in progress [%s]\n", key);
+    } else {
+        flight = cache_req_flight_create(ev, rctx, ncache, midpoint,
+                                         req_dom_type, domain, data, key);
+        if (flight == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    waiter = talloc_zero(state, struct cache_req_flight_waiter);
+    if (waiter == NULL) {
+        return ENOMEM;
+    }
+
+    waiter->flight = flight;
+    waiter->req = req;
+    DLIST_ADD_END(flight->waiters, waiter, struct cache_req_flight_waiter *);
+    talloc_set_destructor(waiter, cache_req_flight_waiter_destructor);
+
+    return EAGAIN;
+}
+
+struct tevent_req *cache_req_send(TALLOC_CTX *mem_ctx,
+                                  struct tevent_context *ev,
+                                  struct resp_ctx *rctx,
+                                  struct sss_nc_ctx *ncache,
+                                  int midpoint,
+                                  enum cache_req_dom_type req_dom_type,
+                                  const char *domain,
+                                  struct cache_req_data *data)
+{
+    struct cache_req_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    if (!cache_req_flight_allowed(rctx, data)) {
+        return cache_req_lookup_send(mem_ctx, ev, rctx, ncache, midpoint,
+                                     req_dom_type, domain, data);
+    }
+
+    req = tevent_req_create(mem_ctx, &state, struct cache_req_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->ev = ev;
+
+    ret = cache_req_flight_join(req, ev, rctx, ncache, midpoint,
+                                req_dom_type, domain, data);
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
 static errno_t cache_req_process_input(TALLOC_CTX *mem_ctx,
                                        struct tevent_req *req,
                                        struct cache_req *cr,
@@ -1301,7 +1952,7 @@ static errno_t cache_req_select_domains(struct tevent_req *req,
         }
     }
 
-    ret = cache_req_domain_copy_cr_domains(state,
+    ret = cache_req_domain_copy_cr_domains(state->cr,
                                            state->cr->rctx->cr_domains,
                                            &state->cr_domains);
     if (ret != EOK) {
@@ -1480,6 +2131,61 @@ uint32_t cache_req_get_reqid(struct tevent_req *req)
     return 0;
 }
 
+uint32_t cache_req_get_lookup_flags(struct tevent_req *req)
+{
+    const struct cache_req_state *state;
+
+    state = tevent_req_data(req, struct cache_req_state);
+    if (state == NULL) {
+        return 0;
+    }
+
+    if (state->cr != NULL) {
+        return state->cr->lookup_flags;
+    }
+
+    return state->lookup_flags;
+}
+
+static const char *cache_req_source_str(uint32_t lookup_flags, errno_t ret)
+{
+    if (ret != EOK && ret != ENOENT) {
+        return "error";
+    } else if (lookup_flags & CACHE_REQ_LOOKUP_WELL_KNOWN) {
+        return "well_known";
+    } else if (lookup_flags & CACHE_REQ_LOOKUP_PROVIDER) {
+        return "provider";
+    } else if (lookup_flags & CACHE_REQ_LOOKUP_NCACHE) {
+        return "negcache";
+    }
+
+    return "cache";
+}
+
+static void cache_req_finished(struct tevent_req *req)
+{
+    struct cache_req_state *state;
+    enum tevent_req_state req_state;
+    uint64_t err;
+    int ret = EOK;
+
+    state = tevent_req_data(req, struct cache_req_state);
+    if (tevent_req_is_error(req, &req_state, &err)) {
+        ret = req_state == TEVENT_REQ_USER_ERROR ? err : ERR_INTERNAL;
+    }
+
+    PROBE(CACHE_REQ_DONE,
+          state->cr != NULL ? state->cr->reqname : "Waiting request",
+          cache_req_get_reqid(req), ret, cache_req_get_lookup_flags(req));
+
+    /* Requests that waited for an identical lookup are not accounted
+     * again. */
+    if (state->cr != NULL) {
+        sss_metrics_inc(SSS_METRIC_CACHE_REQ_LOOKUPS, 1, state->cr->reqname,
+                        cache_req_source_str(state->cr->lookup_flags, ret));
+    }
+}
+
 errno_t cache_req_recv(TALLOC_CTX *mem_ctx,
                        struct tevent_req *req,
                        struct cache_req_result ***_results)
@@ -1487,6 +2193,8 @@ errno_t cache_req_recv(TALLOC_CTX *mem_ctx,
     struct cache_req_state *state;
 
     state = tevent_req_data(req, struct cache_req_state);
+    sss_trace_span_end_req(state->span, req, EOK);
+    cache_req_finished(req);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
@@ -1504,6 +2212,8 @@ errno_t cache_req_single_domain_recv(TALLOC_CTX *mem_ctx,
     struct cache_req_state *state;
 
     state = tevent_req_data(req, struct cache_req_state);
+    sss_trace_span_end_req(state->span, req, EOK);
+    cache_req_finished(req);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
@@ -167,10 +167,24 @@ void
 cache_req_data_set_bypass_dp(struct cache_req_data *data,
                              bool bypass_dp);
 
+/**
+ * The caller of an initgroups request reads only SYSDB_GIDNUM of the
+ * groups, so they may be read from the initgroups index of the user.
+ */
+void
+cache_req_data_set_gids_only(struct cache_req_data *data,
+                             bool gids_only);
+
 
 enum cache_req_type
 cache_req_data_get_type(struct cache_req_data *data);
 
+bool
+cache_req_data_get_bypass_cache(struct cache_req_data *data);
+
+bool
+cache_req_data_get_bypass_dp(struct cache_req_data *data);
+
 /* Output data. */
 
 struct cache_req_result {
@@ -221,6 +235,14 @@ cache_req_copy_limited_result(TALLOC_CTX *mem_ctx,
                               uint32_t start,
                               uint32_t limit);
 
+/**
+ * Shallow copy of cache request result that keeps @result alive for as long
+ * as the copy exists. The messages are shared and must not be modified.
+ */
+struct cache_req_result *
+cache_req_share_result(TALLOC_CTX *mem_ctx,
+                       struct cache_req_result *result);
+
 /* Generic request. */
 
 struct tevent_req *cache_req_send(TALLOC_CTX *mem_ctx,
@@ -234,6 +256,19 @@ struct tevent_req *cache_req_send(TALLOC_CTX *mem_ctx,
 
 uint32_t cache_req_get_reqid(struct tevent_req *req);
 
+/* The answer was found in the negative cache. */
+#define CACHE_REQ_LOOKUP_NCACHE   0x0001
+/* The data provider was contacted. */
+#define CACHE_REQ_LOOKUP_PROVIDER 0x0002
+/* The answer is a well-known object that is never looked up. */
+#define CACHE_REQ_LOOKUP_WELL_KNOWN 0x0004
+
+/**
+ * Return CACHE_REQ_LOOKUP_* flags describing how the request obtained
+ * its answer.
+ */
+uint32_t cache_req_get_lookup_flags(struct tevent_req *req);
+
 errno_t cache_req_recv(TALLOC_CTX *mem_ctx,
                        struct tevent_req *req,
                        struct cache_req_result ***_results);
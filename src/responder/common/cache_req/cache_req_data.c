@@ -445,6 +445,18 @@ cache_req_data_set_bypass_dp(struct cache_req_data *data,
     data->bypass_dp = bypass_dp;
 }
 
+void
+cache_req_data_set_gids_only(struct cache_req_data *data,
+                             bool gids_only)
+{
+    if (data == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "cache_req_data should never be NULL\n");
+        return;
+    }
+
+    data->gids_only = gids_only;
+}
+
 enum cache_req_type
 cache_req_data_get_type(struct cache_req_data *data)
 {
@@ -455,3 +467,25 @@ cache_req_data_get_type(struct cache_req_data *data)
 
     return data->type;
 }
+
+bool
+cache_req_data_get_bypass_cache(struct cache_req_data *data)
+{
+    if (data == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "cache_req_data should never be NULL\n");
+        return false;
+    }
+
+    return data->bypass_cache;
+}
+
+bool
+cache_req_data_get_bypass_dp(struct cache_req_data *data)
+{
+    if (data == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "cache_req_data should never be NULL\n");
+        return false;
+    }
+
+    return data->bypass_dp;
+}
@@ -54,6 +54,9 @@ struct cache_req {
 
     /* Time when the request started. Useful for by-filter lookups */
     time_t req_start;
+
+    /* What the lookup had to do, CACHE_REQ_LOOKUP_* flags */
+    uint32_t lookup_flags;
 };
 
 /**
@@ -100,6 +103,9 @@ struct cache_req_data {
 
     bool bypass_cache;
     bool bypass_dp;
+
+    /* initgroups result is used only for the group ids */
+    bool gids_only;
 };
 
 struct tevent_req *
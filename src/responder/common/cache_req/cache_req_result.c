@@ -133,7 +133,7 @@ cache_req_create_ldb_result_from_msg_list(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ldb_result = talloc_zero(NULL, struct ldb_result);
+    ldb_result = talloc_zero(mem_ctx, struct ldb_result);
     if (ldb_result == NULL) {
         return NULL;
     }
@@ -167,7 +167,7 @@ cache_req_create_ldb_result_from_msg(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ldb_result = talloc_zero(NULL, struct ldb_result);
+    ldb_result = talloc_zero(mem_ctx, struct ldb_result);
     if (ldb_result == NULL) {
         return NULL;
     }
@@ -272,3 +272,42 @@ done:
 
     return out;
 }
+
+struct cache_req_result *
+cache_req_share_result(TALLOC_CTX *mem_ctx,
+                       struct cache_req_result *result)
+{
+    struct cache_req_result *out;
+
+    out = talloc(mem_ctx, struct cache_req_result);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    *out = *result;
+
+    /* Callers may steal the ldb result and free the rest, both of them
+     * need to keep the shared messages alive. */
+    if (result->ldb_result != NULL) {
+        out->ldb_result = talloc(out, struct ldb_result);
+        if (out->ldb_result == NULL) {
+            goto fail;
+        }
+
+        *out->ldb_result = *result->ldb_result;
+
+        if (talloc_reference(out->ldb_result, result) == NULL) {
+            goto fail;
+        }
+    }
+
+    if (talloc_reference(out, result) == NULL) {
+        goto fail;
+    }
+
+    return out;
+
+fail:
+    talloc_free(out);
+    return NULL;
+}
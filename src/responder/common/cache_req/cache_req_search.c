@@ -46,6 +46,7 @@ static errno_t cache_req_search_ncache(struct cache_req *cr)
         CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, cr,
                         "[%s] does not exist (negative cache)\n",
                         cr->debugobj);
+        cr->lookup_flags |= CACHE_REQ_LOOKUP_NCACHE;
         return ENOENT;
     } else if (ret != EOK && ret != ENOENT) {
         CACHE_REQ_DEBUG(SSSDBG_CRIT_FAILURE, cr,
@@ -91,45 +92,35 @@ static void cache_req_search_ncache_add(struct cache_req *cr)
     return cache_req_search_ncache_add_to_domain(cr, cr->domain);
 }
 
-static errno_t cache_req_search_ncache_filter(TALLOC_CTX *mem_ctx,
-                                              struct cache_req *cr,
-                                              struct ldb_result **_result)
+/* Filtered out messages are removed from the result in place, they are
+ * freed together with the result. */
+static errno_t cache_req_search_ncache_filter(struct cache_req *cr,
+                                              struct ldb_result *result)
 {
-    TALLOC_CTX *tmp_ctx;
-    struct ldb_result *filtered_result;
-    struct ldb_message **msgs;
     size_t msg_count;
     const char *name;
     errno_t ret;
 
-    tmp_ctx = talloc_new(NULL);
-    if (tmp_ctx == NULL) {
-        return ENOMEM;
-    }
-
     if (cr->plugin->ncache_filter_fn == NULL) {
         CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, cr,
                         "This request type does not support filtering "
                         "result by negative cache\n");
 
-        ret = EOK;
-        goto done;
+        return EOK;
     }
 
     CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, cr,
                     "Filtering out results by negative cache\n");
 
-    msgs = talloc_zero_array(tmp_ctx, struct ldb_message *, (*_result)->count);
     msg_count = 0;
 
-    for (size_t i = 0; i < (*_result)->count; i++) {
-        name = sss_get_name_from_msg(cr->domain, (*_result)->msgs[i]);
+    for (size_t i = 0; i < result->count; i++) {
+        name = sss_get_name_from_msg(cr->domain, result->msgs[i]);
         if (name == NULL) {
             CACHE_REQ_DEBUG(SSSDBG_CRIT_FAILURE, cr,
                   "sss_get_name_from_msg() returned NULL, which should never "
                   "happen in this scenario!\n");
-            ret = ERR_INTERNAL;
-            goto done;
+            return ERR_INTERNAL;
         }
 
         ret = cr->plugin->ncache_filter_fn(cr->ncache, cr->domain, name);
@@ -142,32 +133,23 @@ static errno_t cache_req_search_ncache_filter(TALLOC_CTX *mem_ctx,
             CACHE_REQ_DEBUG(SSSDBG_CRIT_FAILURE, cr,
                             "Unable to check negative cache [%d]: %s\n",
                             ret, sss_strerror(ret));
-            goto done;
+            return ret;
         }
 
-        msgs[msg_count] = talloc_steal(msgs, (*_result)->msgs[i]);
+        result->msgs[msg_count] = result->msgs[i];
         msg_count++;
     }
 
-    if (msg_count == 0) {
-        ret = ENOENT;
-        goto done;
+    for (size_t i = msg_count; i < result->count; i++) {
+        result->msgs[i] = NULL;
     }
+    result->count = msg_count;
 
-    filtered_result = cache_req_create_ldb_result_from_msg_list(tmp_ctx, msgs,
-                                                                msg_count);
-    if (filtered_result == NULL) {
-        ret = ENOMEM;
-        goto done;
+    if (msg_count == 0) {
+        return ENOENT;
     }
 
-    talloc_zfree(*_result);
-    *_result = talloc_steal(mem_ctx, filtered_result);
-    ret = EOK;
-
-done:
-    talloc_free(tmp_ctx);
-    return ret;
+    return EOK;
 }
 
 static int
@@ -257,6 +239,38 @@ done:
     return ret;
 }
 
+/* Users and groups written before the cache generation of the domain was
+ * bumped are expired regardless of their expiration timestamp. */
+static bool cache_req_generation_is_stale(struct cache_req *cr,
+                                          struct ldb_message *msg)
+{
+    const char *category;
+    uint32_t generation;
+    errno_t ret;
+
+    if (cr->domain == NULL) {
+        return false;
+    }
+
+    category = ldb_msg_find_attr_as_string(msg, SYSDB_OBJECTCATEGORY, NULL);
+    if (category == NULL
+            || (strcmp(category, SYSDB_USER_CLASS) != 0
+                && strcmp(category, SYSDB_GROUP_CLASS) != 0)) {
+        return false;
+    }
+
+    ret = sysdb_get_cache_generation(cr->domain, &generation);
+    if (ret != EOK) {
+        CACHE_REQ_DEBUG(SSSDBG_MINOR_FAILURE, cr,
+                        "Unable to read the cache generation [%d]: %s\n",
+                        ret, sss_strerror(ret));
+        return false;
+    }
+
+    return sysdb_cache_generation_is_stale(msg, cr->plugin->attr_expiration,
+                                           generation);
+}
+
 static enum cache_object_status
 cache_req_expiration_status(struct cache_req *cr,
                             struct ldb_result *result)
@@ -272,6 +286,14 @@ cache_req_expiration_status(struct cache_req *cr,
                                          cr->plugin->attr_expiration, 0);
 
     ret = sss_cmd_check_cache(result->msgs[0], cr->midpoint, expire);
+    if ((ret == EOK || ret == EAGAIN)
+            && cache_req_generation_is_stale(cr, result->msgs[0])) {
+        CACHE_REQ_DEBUG(SSSDBG_TRACE_FUNC, cr,
+                        "Object was cached before the last cache "
+                        "generation bump\n");
+        return CACHE_OBJECT_EXPIRED;
+    }
+
     if (ret == EOK) {
         return CACHE_OBJECT_VALID;
     } else if (ret == EAGAIN) {
@@ -398,7 +420,7 @@ cache_req_search_send(TALLOC_CTX *mem_ctx,
 
 done:
     if (ret == EOK) {
-        ret = cache_req_search_ncache_filter(state, cr, &state->result);
+        ret = cache_req_search_ncache_filter(cr, state->result);
     }
 
     if (ret == EOK) {
@@ -462,6 +484,7 @@ static errno_t cache_req_search_dp(struct tevent_req *req,
         }
 
         tevent_req_set_callback(subreq, cache_req_search_done, req);
+        state->cr->lookup_flags |= CACHE_REQ_LOOKUP_PROVIDER;
         ret = EAGAIN;
         break;
     default:
@@ -509,7 +532,7 @@ static void cache_req_search_done(struct tevent_req *subreq)
     }
 
     /* ret == EOK */
-    ret = cache_req_search_ncache_filter(state, state->cr, &state->result);
+    ret = cache_req_search_ncache_filter(state->cr, state->result);
     if (ret != EOK) {
         goto done;
     }
@@ -78,8 +78,7 @@ struct tevent_req *cache_req_sr_overlay_send(
         case CACHE_REQ_USER_BY_ID:
         case CACHE_REQ_ENUM_USERS:
             /* If we have group names to match against */
-            if (rctx->sr_conf.groups != NULL &&
-                rctx->sr_conf.groups[0] != NULL) {
+            if (rctx->sr_conf.group_set != NULL) {
                 /* Pull and match group and user names for each user entry */
                 subreq = cache_req_sr_overlay_match_all_step_send(state);
                 if (subreq == NULL) {
@@ -127,7 +126,6 @@ static errno_t cache_req_sr_overlay_match_users(
     struct ldb_message *msg;
     const char *name;
     char *output_name;
-    char **conf_user;
     bool enabled;
     char *enabled_str;
 
@@ -167,18 +165,9 @@ static errno_t cache_req_sr_overlay_match_users(
                 goto done;
             }
 
-            /* For each user name in session recording config */
-            enabled = false;
-            conf_user = rctx->sr_conf.users;
-            if (conf_user != NULL) {
-                for (; *conf_user != NULL; conf_user++) {
-                    /* If it matches the requested user name */
-                    if (strcmp(*conf_user, output_name) == 0) {
-                        enabled = true;
-                        break;
-                    }
-                }
-            }
+            /* If the user is listed in session recording config */
+            enabled = session_recording_conf_has_user(&rctx->sr_conf,
+                                                      output_name);
 
             /* Set sessionRecording attribute to enabled value */
             ldb_msg_remove_attr(msg, SYSDB_SESSION_RECORDING);
@@ -41,7 +41,9 @@ cache_req_enum_groups_lookup(TALLOC_CTX *mem_ctx,
                              struct sss_domain_info *domain,
                              struct ldb_result **_result)
 {
-    return sysdb_enumgrent_with_views(mem_ctx, domain, _result);
+    /* Only the names are read here, the consumer loads the complete entries
+     * in chunks with sysdb_enum_load_groups(). */
+    return sysdb_enumgrent_names(mem_ctx, domain, _result);
 }
 
 static struct tevent_req *
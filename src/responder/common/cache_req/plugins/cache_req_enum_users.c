@@ -41,7 +41,9 @@ cache_req_enum_users_lookup(TALLOC_CTX *mem_ctx,
                             struct sss_domain_info *domain,
                             struct ldb_result **_result)
 {
-    return sysdb_enumpwent_with_views(mem_ctx, domain, _result);
+    /* Only the names are read here, the consumer loads the complete entries
+     * in chunks with sysdb_enum_load_users(). */
+    return sysdb_enumpwent_names(mem_ctx, domain, _result);
 }
 
 static struct tevent_req *
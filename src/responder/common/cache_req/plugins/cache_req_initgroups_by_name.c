@@ -105,6 +105,16 @@ cache_req_initgroups_by_name_lookup(TALLOC_CTX *mem_ctx,
                                     struct sss_domain_info *domain,
                                     struct ldb_result **_result)
 {
+    errno_t ret;
+
+    if (data->gids_only) {
+        ret = sysdb_initgroups_gids(mem_ctx, domain, data->name.lookup,
+                                    _result);
+        if (ret != ENOENT) {
+            return ret;
+        }
+    }
+
     return sysdb_initgroups_with_views(mem_ctx, domain, data->name.lookup,
                                        _result);
 }
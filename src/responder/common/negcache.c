@@ -19,10 +19,14 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <fcntl.h>
 #include <time.h>
-#include "tdb.h"
+#include <fcntl.h>
+#include <sys/stat.h>
 #include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/probes.h"
+#include "util/sss_metrics.h"
+#include "shared/murmurhash3.h"
 #include "util/nss_dl_load.h"
 #include "confdb/confdb.h"
 #include "responder/common/negcache_files.h"
@@ -41,14 +45,45 @@
 #define NC_CERT_PREFIX NC_ENTRY_PREFIX"CERT"
 #define NC_DOMAIN_ACCT_LOCATE_PREFIX NC_ENTRY_PREFIX"DOM_LOCATE"
 #define NC_DOMAIN_ACCT_LOCATE_TYPE_PREFIX NC_ENTRY_PREFIX"DOM_LOCATE_TYPE"
+#define NC_UNKNOWN_DOMAIN_PREFIX NC_ENTRY_PREFIX"UNKNOWN_DOMAIN"
+
+/* initial number of slots of the hash table, must be a power of two */
+#define NC_TABLE_MIN_SIZE 1024
+/* number of seconds covered by one turn of the expiry wheel */
+#define NC_WHEEL_SLOTS 256
+/* first four bytes of a snapshot written by sss_ncache_save() */
+#define NC_SNAPSHOT_MAGIC 0x53534e31
+
+struct sss_nc_entry {
+    /* expiry wheel slot, permanent entries are not on the wheel */
+    struct sss_nc_entry *prev;
+    struct sss_nc_entry *next;
+
+    char *key;
+    uint32_t hash;
+    /* 0 means the entry never expires */
+    time_t expire;
+};
 
 struct sss_nc_ctx {
-    struct tdb_context *tdb;
+    /* open addressed with linear probing */
+    struct sss_nc_entry **table;
+    size_t size;
+    size_t num_entries;
+    size_t num_deleted;
+
+    struct sss_nc_entry *wheel[NC_WHEEL_SLOTS];
+    /* all entries that expired before this time are removed */
+    time_t wheel_time;
+
     uint32_t timeout;
     uint32_t local_timeout;
     struct sss_nss_ops ops;
 };
 
+/* marks a slot of a removed entry, lookups have to continue past it */
+static struct sss_nc_entry sss_nc_deleted;
+
 typedef int (*ncache_set_byname_fn_t)(struct sss_nc_ctx *, bool,
                                       const char *, const char *);
 
@@ -56,16 +91,125 @@ static int sss_ncache_set_ent(struct sss_nc_ctx *ctx, bool permanent,
                               struct sss_domain_info *dom, const char *name,
                               ncache_set_byname_fn_t setter);
 
-static int string_to_tdb_data(char *str, TDB_DATA *ret)
+static uint32_t sss_nc_hash(const char *key)
+{
+    return murmurhash3(key, strlen(key), 0xdeadbeef);
+}
+
+/* Returns the slot of the key or, if it is not present, the slot where it
+ * would be inserted. */
+static size_t sss_nc_find_slot(struct sss_nc_ctx *ctx, const char *key,
+                               uint32_t hash)
+{
+    struct sss_nc_entry *entry;
+    size_t mask = ctx->size - 1;
+    size_t free_slot = ctx->size;
+    size_t i;
+
+    for (i = hash & mask; ; i = (i + 1) & mask) {
+        entry = ctx->table[i];
+        if (entry == NULL) {
+            break;
+        }
+
+        if (entry == &sss_nc_deleted) {
+            if (free_slot == ctx->size) {
+                free_slot = i;
+            }
+            continue;
+        }
+
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            return i;
+        }
+    }
+
+    return free_slot != ctx->size ? free_slot : i;
+}
+
+static errno_t sss_nc_resize(struct sss_nc_ctx *ctx, size_t size)
 {
-    if (!str || !ret) return EINVAL;
+    struct sss_nc_entry **old_table = ctx->table;
+    size_t old_size = ctx->size;
+    size_t mask = size - 1;
+    size_t i;
+    size_t j;
+
+    ctx->table = talloc_zero_array(ctx, struct sss_nc_entry *, size);
+    if (ctx->table == NULL) {
+        ctx->table = old_table;
+        return ENOMEM;
+    }
+    ctx->size = size;
+    ctx->num_deleted = 0;
 
-    ret->dptr = (uint8_t *)str;
-    ret->dsize = strlen(str)+1;
+    for (i = 0; i < old_size; i++) {
+        if (old_table[i] == NULL || old_table[i] == &sss_nc_deleted) {
+            continue;
+        }
+
+        for (j = old_table[i]->hash & mask;
+             ctx->table[j] != NULL;
+             j = (j + 1) & mask);
+        ctx->table[j] = old_table[i];
+    }
 
+    talloc_free(old_table);
     return EOK;
 }
 
+static void sss_nc_remove_slot(struct sss_nc_ctx *ctx, size_t slot)
+{
+    struct sss_nc_entry *entry = ctx->table[slot];
+
+    if (entry->expire != 0) {
+        DLIST_REMOVE(ctx->wheel[entry->expire % NC_WHEEL_SLOTS], entry);
+    }
+
+    ctx->table[slot] = &sss_nc_deleted;
+    ctx->num_entries--;
+    ctx->num_deleted++;
+
+    talloc_free(entry);
+}
+
+static void sss_nc_remove_entry(struct sss_nc_ctx *ctx,
+                                struct sss_nc_entry *entry)
+{
+    sss_nc_remove_slot(ctx, sss_nc_find_slot(ctx, entry->key, entry->hash));
+}
+
+/* Removes the entries the expiry time of which passed since the last
+ * call. Entries are kept in the wheel slot of the second they expire in,
+ * a slot holds the entries of all turns of the wheel. */
+static void sss_nc_advance_wheel(struct sss_nc_ctx *ctx, time_t now)
+{
+    struct sss_nc_entry *entry;
+    struct sss_nc_entry *next;
+    time_t t;
+
+    if (now <= ctx->wheel_time) {
+        return;
+    }
+
+    if (now - ctx->wheel_time > NC_WHEEL_SLOTS) {
+        ctx->wheel_time = now - NC_WHEEL_SLOTS;
+    }
+
+    for (t = ctx->wheel_time; t < now; t++) {
+        for (entry = ctx->wheel[t % NC_WHEEL_SLOTS];
+             entry != NULL;
+             entry = next) {
+            next = entry->next;
+            if (entry->expire < now) {
+                sss_nc_remove_entry(ctx, entry);
+            }
+        }
+    }
+
+    ctx->wheel_time = now;
+}
+
 static errno_t ncache_load_nss_symbols(struct sss_nss_ops *ops)
 {
     errno_t ret;
@@ -85,6 +229,15 @@ static errno_t ncache_load_nss_symbols(struct sss_nss_ops *ops)
     return EOK;
 }
 
+static void sss_ncache_collect_metrics(void *pvt)
+{
+    struct sss_nc_ctx *ctx = talloc_get_type(pvt, struct sss_nc_ctx);
+
+    /* Do not count entries that expired already. */
+    sss_nc_advance_wheel(ctx, time(NULL));
+    sss_metrics_set(SSS_METRIC_NCACHE_ENTRIES, ctx->num_entries);
+}
+
 int sss_ncache_init(TALLOC_CTX *memctx, uint32_t timeout,
                     uint32_t local_timeout, struct sss_nc_ctx **_ctx)
 {
@@ -102,14 +255,24 @@ int sss_ncache_init(TALLOC_CTX *memctx, uint32_t timeout,
         return ret;
     }
 
-    errno = 0;
-    /* open a memory only tdb with default hash size */
-    ctx->tdb = tdb_open("memcache", 0, TDB_INTERNAL, O_RDWR|O_CREAT, 0);
-    if (!ctx->tdb) return errno;
+    ctx->table = talloc_zero_array(ctx, struct sss_nc_entry *,
+                                   NC_TABLE_MIN_SIZE);
+    if (ctx->table == NULL) {
+        talloc_free(ctx);
+        return ENOMEM;
+    }
+    ctx->size = NC_TABLE_MIN_SIZE;
+    ctx->wheel_time = time(NULL);
 
     ctx->timeout = timeout;
     ctx->local_timeout = local_timeout;
 
+    ret = sss_metrics_add_collector(ctx, sss_ncache_collect_metrics, ctx);
+    if (ret != EOK) {
+        talloc_free(ctx);
+        return ret;
+    }
+
     *_ctx = ctx;
     return EOK;
 };
@@ -121,105 +284,114 @@ uint32_t sss_ncache_get_timeout(struct sss_nc_ctx *ctx)
 
 static int sss_ncache_check_str(struct sss_nc_ctx *ctx, char *str)
 {
-    TDB_DATA key;
-    TDB_DATA data;
-    unsigned long long int timestamp;
-    bool expired = false;
-    char *ep;
-    int ret;
+    struct sss_nc_entry *entry;
+    uint32_t hash;
+    size_t slot;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Checking negative cache for [%s]\n", str);
 
-    data.dptr = NULL;
+    sss_nc_advance_wheel(ctx, time(NULL));
 
-    ret = string_to_tdb_data(str, &key);
-    if (ret != EOK) goto done;
+    hash = sss_nc_hash(str);
+    slot = sss_nc_find_slot(ctx, str, hash);
+    entry = ctx->table[slot];
+    if (entry == NULL || entry == &sss_nc_deleted) {
+        PROBE(NCACHE_CHECK, str, 0);
+        return ENOENT;
+    }
 
-    data = tdb_fetch(ctx->tdb, key);
+    /* expired entries were removed from the wheel */
+    PROBE(NCACHE_CHECK, str, 1);
+    return EEXIST;
+}
 
-    if (!data.dptr) {
-        ret = ENOENT;
-        goto done;
-    }
+/* Adds the key or updates its expiry time, 0 means it never expires. */
+static errno_t sss_nc_store(struct sss_nc_ctx *ctx, const char *str,
+                            time_t expire, time_t now)
+{
+    struct sss_nc_entry *entry;
+    uint32_t hash;
+    size_t slot;
+    errno_t ret;
 
-    errno = 0;
-    timestamp = strtoull((const char *)data.dptr, &ep, 10);
-    if (errno != 0 || *ep != '\0') {
-        /* Malformed entry, remove it and return no entry */
-        expired = true;
-        goto done;
-    }
+    sss_nc_advance_wheel(ctx, now);
 
-    if (timestamp == 0) {
-        /* a 0 timestamp means this is a permanent entry */
-        ret = EEXIST;
-        goto done;
-    }
+    hash = sss_nc_hash(str);
+    slot = sss_nc_find_slot(ctx, str, hash);
+    entry = ctx->table[slot];
 
-    if (timestamp >= time(NULL)) {
-        /* still valid */
-        ret = EEXIST;
-        goto done;
-    }
+    if (entry != NULL && entry != &sss_nc_deleted) {
+        if (entry->expire != 0) {
+            DLIST_REMOVE(ctx->wheel[entry->expire % NC_WHEEL_SLOTS], entry);
+        }
+    } else {
+        /* keep at least a quarter of the slots free */
+        if ((ctx->num_entries + ctx->num_deleted + 1) * 4 > ctx->size * 3) {
+            ret = sss_nc_resize(ctx, ctx->num_entries * 2 >= ctx->size
+                                        ? ctx->size * 2 : ctx->size);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                      "Negative cache failed to set entry: [%s]\n",
+                      sss_strerror(ret));
+                return ret;
+            }
+            slot = sss_nc_find_slot(ctx, str, hash);
+        }
 
-    expired = true;
+        entry = talloc_zero(ctx, struct sss_nc_entry);
+        if (entry == NULL) {
+            return ENOMEM;
+        }
 
-done:
-    if (expired) {
-        /* expired, remove and return no entry */
-        tdb_delete(ctx->tdb, key);
-        ret = ENOENT;
+        entry->key = talloc_strdup(entry, str);
+        if (entry->key == NULL) {
+            talloc_free(entry);
+            return ENOMEM;
+        }
+        entry->hash = hash;
+
+        if (ctx->table[slot] == &sss_nc_deleted) {
+            ctx->num_deleted--;
+        }
+        ctx->table[slot] = entry;
+        ctx->num_entries++;
     }
 
-    free(data.dptr);
-    return ret;
+    entry->expire = expire;
+    if (expire != 0) {
+        DLIST_ADD(ctx->wheel[expire % NC_WHEEL_SLOTS], entry);
+    }
+
+    return EOK;
 }
 
 static int sss_ncache_set_str(struct sss_nc_ctx *ctx, char *str,
                               bool permanent, bool use_local_negative)
 {
-    TDB_DATA key;
-    TDB_DATA data;
-    char *timest;
-    unsigned long long int timell;
-    int ret;
+    time_t expire;
+    time_t now;
 
-    ret = string_to_tdb_data(str, &key);
-    if (ret != EOK) return ret;
+    now = time(NULL);
 
     if (permanent) {
-        timest = talloc_strdup(ctx, "0");
+        expire = 0;
     } else {
         if (use_local_negative == true && ctx->local_timeout > ctx->timeout) {
-            timell = ctx->local_timeout;
+            expire = ctx->local_timeout;
         } else {
             /* EOK is tested in cwrap based unit test */
             if (ctx->timeout == 0) {
                 return EOK;
             }
-            timell = ctx->timeout;
+            expire = ctx->timeout;
         }
-        timell += (unsigned long long int)time(NULL);
-        timest = talloc_asprintf(ctx, "%llu", timell);
+        expire += now;
     }
-    if (!timest) return ENOMEM;
-
-    ret = string_to_tdb_data(timest, &data);
-    if (ret != EOK) goto done;
 
     DEBUG(SSSDBG_TRACE_FUNC, "Adding [%s] to negative cache%s\n",
               str, permanent?" permanently":"");
 
-    ret = tdb_store(ctx->tdb, key, data, TDB_REPLACE);
-    if (ret != 0) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Negative cache failed to set entry: [%s]\n",
-                  tdb_errorstr(ctx->tdb));
-        ret = EFAULT;
-    }
-
-done:
-    talloc_free(timest);
-    return ret;
+    return sss_nc_store(ctx, str, expire, now);
 }
 
 static int sss_ncache_check_user_int(struct sss_nc_ctx *ctx, const char *domain,
@@ -851,79 +1023,93 @@ int sss_ncache_check_locate_uid(struct sss_nc_ctx *ctx,
     return ret;
 }
 
-static int delete_permanent(struct tdb_context *tdb,
-                            TDB_DATA key, TDB_DATA data, void *state)
+static char *unknown_domain_str(TALLOC_CTX *mem_ctx, const char *domain)
 {
-    unsigned long long int timestamp;
-    bool remove_key = false;
-    char *ep;
+    char *lc_domain;
+    char *str;
 
-    if (strncmp((char *)key.dptr,
-                NC_ENTRY_PREFIX, sizeof(NC_ENTRY_PREFIX) - 1) != 0) {
-        /* not interested in this key */
-        return 0;
+    lc_domain = sss_tc_utf8_str_tolower(mem_ctx, domain);
+    if (lc_domain == NULL) {
+        return NULL;
     }
 
-    errno = 0;
-    timestamp = strtoull((const char *)data.dptr, &ep, 10);
-    if (errno != 0 || *ep != '\0') {
-        /* Malformed entry, remove it */
-        remove_key = true;
-        goto done;
-    }
+    str = talloc_asprintf(mem_ctx, "%s/%s", NC_UNKNOWN_DOMAIN_PREFIX,
+                          lc_domain);
+    talloc_free(lc_domain);
 
-    if (timestamp == 0) {
-        /* a 0 timestamp means this is a permanent entry */
-        remove_key = true;
-    }
+    return str;
+}
 
-done:
-    if (remove_key) {
-        return tdb_delete(tdb, key);
-    }
+int sss_ncache_set_unknown_domain(struct sss_nc_ctx *ctx,
+                                  const char *domain)
+{
+    char *str;
+    int ret;
+
+    if (domain == NULL || *domain == '\0') return EINVAL;
 
-    return 0;
+    str = unknown_domain_str(ctx, domain);
+    if (str == NULL) return ENOMEM;
+
+    ret = sss_ncache_set_str(ctx, str, false, false);
+
+    talloc_free(str);
+    return ret;
 }
 
-int sss_ncache_reset_permanent(struct sss_nc_ctx *ctx)
+int sss_ncache_check_unknown_domain(struct sss_nc_ctx *ctx,
+                                    const char *domain)
 {
+    char *str;
     int ret;
 
-    ret = tdb_traverse(ctx->tdb, delete_permanent, NULL);
-    if (ret < 0)
-        return EIO;
+    if (domain == NULL || *domain == '\0') return EINVAL;
 
-    return EOK;
+    str = unknown_domain_str(ctx, domain);
+    if (str == NULL) return ENOMEM;
+
+    ret = sss_ncache_check_str(ctx, str);
+
+    talloc_free(str);
+    return ret;
 }
 
-static int delete_prefix(struct tdb_context *tdb,
-                         TDB_DATA key, TDB_DATA data, void *state)
+int sss_ncache_reset_permanent(struct sss_nc_ctx *ctx)
 {
-    const char *prefix = (const char *) state;
+    size_t i;
+
+    for (i = 0; i < ctx->size; i++) {
+        if (ctx->table[i] == NULL || ctx->table[i] == &sss_nc_deleted) {
+            continue;
+        }
 
-    if (strncmp((char *)key.dptr, prefix, strlen(prefix) - 1) != 0) {
-        /* not interested in this key */
-        return 0;
+        if (ctx->table[i]->expire == 0) {
+            sss_nc_remove_slot(ctx, i);
+        }
     }
 
-    return tdb_delete(tdb, key);
+    return EOK;
 }
 
 static int sss_ncache_reset_pfx(struct sss_nc_ctx *ctx,
                                 const char **prefixes)
 {
-    int ret;
+    size_t i;
 
     if (prefixes == NULL) {
         return EOK;
     }
 
-    for (int i = 0; prefixes[i] != NULL; i++) {
-        ret = tdb_traverse(ctx->tdb,
-                           delete_prefix,
-                           discard_const(prefixes[i]));
-        if (ret < 0) {
-            return EIO;
+    for (int p = 0; prefixes[p] != NULL; p++) {
+        for (i = 0; i < ctx->size; i++) {
+            if (ctx->table[i] == NULL || ctx->table[i] == &sss_nc_deleted) {
+                continue;
+            }
+
+            if (strncmp(ctx->table[i]->key, prefixes[p],
+                        strlen(prefixes[p]) - 1) == 0) {
+                sss_nc_remove_slot(ctx, i);
+            }
         }
     }
 
@@ -952,6 +1138,241 @@ int sss_ncache_reset_groups(struct sss_nc_ctx *ctx)
     return sss_ncache_reset_pfx(ctx, prefixes);
 }
 
+/*
+ * The snapshot starts with NC_SNAPSHOT_MAGIC followed by one record per
+ * entry:
+ *
+ *   int64_t  expiry time
+ *   uint32_t length of the key
+ *   key without the terminating zero
+ *
+ * Permanent entries are not stored, they come from the configuration.
+ */
+errno_t sss_ncache_save(struct sss_nc_ctx *ctx, const char *path)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_nc_entry *entry;
+    char *tmp_path;
+    uint8_t *buf;
+    size_t len;
+    size_t keylen;
+    size_t count = 0;
+    size_t c = 0;
+    ssize_t written;
+    time_t now;
+    size_t i;
+    int fd = -1;
+    errno_t ret;
+
+    now = time(NULL);
+    sss_nc_advance_wheel(ctx, now);
+
+    len = sizeof(uint32_t);
+    for (i = 0; i < ctx->size; i++) {
+        entry = ctx->table[i];
+        if (entry == NULL || entry == &sss_nc_deleted || entry->expire == 0) {
+            continue;
+        }
+
+        len += sizeof(int64_t) + sizeof(uint32_t) + strlen(entry->key);
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    buf = talloc_size(tmp_ctx, len);
+    if (buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    SAFEALIGN_SET_UINT32(buf, NC_SNAPSHOT_MAGIC, &c);
+    for (i = 0; i < ctx->size; i++) {
+        entry = ctx->table[i];
+        if (entry == NULL || entry == &sss_nc_deleted || entry->expire == 0) {
+            continue;
+        }
+
+        keylen = strlen(entry->key);
+        SAFEALIGN_SET_INT64(buf + c, entry->expire, &c);
+        SAFEALIGN_SET_UINT32(buf + c, keylen, &c);
+        SAFEALIGN_SET_STRING(buf + c, entry->key, keylen, &c);
+        count++;
+    }
+
+    tmp_path = talloc_asprintf(tmp_ctx, "%s.XXXXXX", path);
+    if (tmp_path == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    fd = sss_unique_file(NULL, tmp_path, &ret);
+    if (fd == -1) {
+        goto done;
+    }
+
+    errno = 0;
+    written = sss_atomic_write_s(fd, buf, len);
+    if (written == -1) {
+        ret = errno;
+        goto done;
+    } else if ((size_t)written != len) {
+        ret = EIO;
+        goto done;
+    }
+
+    ret = rename(tmp_path, path);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Saved %zu negative cache entries to %s\n",
+          count, path);
+
+    ret = EOK;
+
+done:
+    if (fd != -1) {
+        close(fd);
+        if (ret != EOK) {
+            unlink(tmp_path);
+        }
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to save negative cache to %s "
+              "[%d]: %s\n", path, ret, sss_strerror(ret));
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t sss_nc_load_records(struct sss_nc_ctx *ctx,
+                                   uint8_t *buf, size_t len,
+                                   size_t *_count)
+{
+    uint32_t magic;
+    uint32_t keylen;
+    int64_t expire;
+    time_t max_expire;
+    time_t now;
+    char *key;
+    size_t c = 0;
+    errno_t ret;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&magic, buf, len, &c);
+    if (magic != NC_SNAPSHOT_MAGIC) {
+        return EINVAL;
+    }
+
+    /* the timeouts may have been lowered since the snapshot was taken */
+    now = time(NULL);
+    max_expire = now + MAX(ctx->timeout, ctx->local_timeout);
+
+    while (c < len) {
+        SAFEALIGN_MEMCPY_CHECK(&expire, buf + c, sizeof(int64_t), len, &c);
+        SAFEALIGN_COPY_UINT32_CHECK(&keylen, buf + c, len, &c);
+        if (keylen == 0 || keylen > len - c) {
+            return EINVAL;
+        }
+
+        if (expire > max_expire) {
+            expire = max_expire;
+        }
+
+        if (expire <= now) {
+            c += keylen;
+            continue;
+        }
+
+        key = talloc_strndup(NULL, (const char *)buf + c, keylen);
+        if (key == NULL) {
+            return ENOMEM;
+        }
+        c += keylen;
+
+        ret = sss_nc_store(ctx, key, expire, now);
+        talloc_free(key);
+        if (ret != EOK) {
+            return ret;
+        }
+        (*_count)++;
+    }
+
+    return EOK;
+}
+
+errno_t sss_ncache_load(struct sss_nc_ctx *ctx, const char *path)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct stat st;
+    uint8_t *buf;
+    size_t count = 0;
+    ssize_t len;
+    int fd;
+    errno_t ret;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        if (ret != ENOENT) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to open %s [%d]: %s\n",
+                  path, ret, sss_strerror(ret));
+        }
+        return ret;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = fstat(fd, &st);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    buf = talloc_size(tmp_ctx, st.st_size);
+    if (buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    errno = 0;
+    len = sss_atomic_read_s(fd, buf, st.st_size);
+    if (len == -1) {
+        ret = errno;
+        goto done;
+    } else if (len != st.st_size) {
+        ret = EIO;
+        goto done;
+    }
+
+    ret = sss_nc_load_records(ctx, buf, len, &count);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Loaded %zu negative cache entries from %s\n",
+          count, path);
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to load negative cache from %s "
+              "[%d]: %s\n", path, ret, sss_strerror(ret));
+    }
+
+    close(fd);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t sss_ncache_prepopulate(struct sss_nc_ctx *ncache,
                                struct confdb_ctx *cdb,
                                struct resp_ctx *rctx)
@@ -145,10 +145,27 @@ int sss_ncache_set_locate_uid(struct sss_nc_ctx *ctx,
                               struct sss_domain_info *dom,
                               uid_t uid);
 
+/*
+ * Call these two functions to remember a domain name which was not found
+ * after the subdomains were refreshed, e.g. from a user@domain input.
+ * While the entry is valid, requests for such names fail without asking
+ * the data providers for their subdomains again.
+ */
+int sss_ncache_set_unknown_domain(struct sss_nc_ctx *ctx,
+                                  const char *domain);
+int sss_ncache_check_unknown_domain(struct sss_nc_ctx *ctx,
+                                    const char *domain);
+
 int sss_ncache_reset_permanent(struct sss_nc_ctx *ctx);
 int sss_ncache_reset_users(struct sss_nc_ctx *ctx);
 int sss_ncache_reset_groups(struct sss_nc_ctx *ctx);
 
+/* Write the entries that expire to a file and read them back, so a
+ * restarted responder does not have to ask the providers about them
+ * again. */
+errno_t sss_ncache_save(struct sss_nc_ctx *ctx, const char *path);
+errno_t sss_ncache_load(struct sss_nc_ctx *ctx, const char *path);
+
 struct resp_ctx;
 
 /* Set up the negative cache with values from filter_users and
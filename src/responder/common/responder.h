@@ -124,6 +124,9 @@ struct resp_ctx {
 
     time_t last_request_time;
     int idle_timeout;
+    /* stay alive with the caches loaded instead of exiting when idle */
+    bool idle_hibernate;
+    bool hibernating;
     struct tevent_timer *idle;
 
     struct sss_cmd_table *sss_cmds;
@@ -131,6 +134,8 @@ struct resp_ctx {
     const char *confdb_service_path;
 
     struct timeval get_domains_last_call;
+    /* a refresh of the subdomains for unknown domain names is running */
+    bool get_domains_background;
 
     size_t allowed_uids_count;
     uid_t *allowed_uids;
@@ -148,6 +153,26 @@ struct resp_ctx {
     struct session_recording_conf sr_conf;
 
     uint32_t cache_req_num;
+    /* memory and number of objects a cache request usually needs, the
+     * pool of the next request is sized from them, see cache_req.c */
+    size_t cache_req_pool_size;
+    unsigned int cache_req_pool_objects;
+    /* identical cache requests that are in progress, see cache_req.c */
+    hash_table_t *cache_req_flights;
+    /* command latency histograms, see responder_stats.c */
+    struct sss_cmd_stats *cmd_stats;
+    /* number of commands the clients of one uid may run at the same time,
+     * commands over the limit wait in the queue of the uid */
+    unsigned int client_max_requests;
+    hash_table_t *client_throttle;
+    /* account requests that are sent to the backends together,
+     * see responder_dp.c */
+    unsigned int dp_batch_size;
+    hash_table_t *dp_batches;
+    /* the negative cache is saved to this file and the memory cache files
+     * are reused when the responder restarts */
+    bool warm_restart;
+    char *ncache_snapshot;
 
     void *pvt_ctx;
 
@@ -155,6 +180,7 @@ struct resp_ctx {
     bool socket_activated;
     bool dbus_activated;
     bool cache_first;
+    bool parallel_domain_lookups;
     bool enumeration_warn_logged;
 };
 
@@ -176,6 +202,15 @@ struct cli_ctx {
 
     struct tevent_timer *idle;
     time_t last_request_time;
+
+    /* Command in progress, used for the latency histograms. */
+    struct timeval cmd_start;
+    enum sss_cmd_source cmd_source;
+    const char *cmd_domain;
+
+    /* Slot of the client in the queue of its uid, see
+     * sss_client_throttle_acquire(). */
+    struct cli_throttle_ref *throttle;
 };
 
 struct sss_cmd_table {
@@ -222,6 +257,14 @@ responder_get_domain(struct resp_ctx *rctx, const char *domain);
 errno_t responder_get_domain_by_id(struct resp_ctx *rctx, const char *id,
                                    struct sss_domain_info **_ret_dom);
 
+/* Take one of the client_max_requests slots of the uid of the client
+ * before running its command. Returns EAGAIN if all slots are taken, the
+ * command is then run once a command of the same uid finishes. Commands
+ * sent over the privileged pipe and PAM commands are never queued. */
+errno_t sss_client_throttle_acquire(struct cli_ctx *cctx,
+                                    enum sss_cli_command cmd);
+void sss_client_throttle_release(struct cli_ctx *cctx);
+
 int create_pipe_fd(const char *sock_name, int *_fd, mode_t umaskval);
 int activate_unix_sockets(struct resp_ctx *rctx,
                           connection_setup_t conn_setup);
@@ -235,6 +278,23 @@ int sss_cmd_get_version(struct cli_ctx *cctx);
 int sss_cmd_execute(struct cli_ctx *cctx,
                     enum sss_cli_command cmd,
                     struct sss_cmd_table *sss_cmds);
+
+/* responder_stats.c */
+void sss_cmd_stats_start(struct cli_ctx *cctx);
+void sss_cmd_stats_finish(struct cli_ctx *cctx);
+
+/* Record the source of the data of the current command of the client,
+ * see enum sss_cmd_source. */
+void sss_cmd_set_source(struct cli_ctx *cctx,
+                        enum sss_cmd_source source,
+                        struct sss_domain_info *domain);
+
+/* Record the source of the data of the current command of the client from
+ * CACHE_REQ_LOOKUP_* flags of a finished cache_req request. */
+void sss_cmd_set_lookup_source(struct cli_ctx *cctx,
+                               uint32_t lookup_flags,
+                               struct sss_domain_info *domain);
+
 struct cli_protocol_version *register_cli_protocol_version(void);
 
 struct setent_req_list;
@@ -370,6 +430,10 @@ errno_t schedule_get_domains_task(TALLOC_CTX *mem_ctx,
                                   struct resp_ctx *rctx,
                                   struct sss_nc_ctx *optional_ncache);
 
+/* Use the domains already read from the cache to answer requests right
+ * away, the data provider is asked for the current list shortly after. */
+errno_t sss_resp_use_cached_domains(struct resp_ctx *rctx);
+
 errno_t csv_string_to_uid_array(TALLOC_CTX *mem_ctx, const char *csv_string,
                                 bool allow_sss_loop,
                                 size_t *_uid_count, uid_t **_uids);
@@ -451,4 +515,10 @@ sss_resp_register_sbus_iface(struct sbus_connection *conn,
 errno_t
 sss_resp_register_service_iface(struct resp_ctx *rctx);
 
+/**
+ * Register statistics sbus interface on monitor connection.
+ */
+errno_t
+sss_resp_register_stats_iface(struct resp_ctx *rctx);
+
 #endif /* __SSS_RESPONDER_H__ */
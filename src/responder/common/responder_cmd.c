@@ -93,6 +93,11 @@ int sss_cmd_send_empty(struct cli_ctx *cctx)
 
 void sss_cmd_done(struct cli_ctx *cctx, void *freectx)
 {
+    sss_cmd_stats_finish(cctx);
+
+    /* let the next command of the same uid run */
+    sss_client_throttle_release(cctx);
+
     /* now that the packet is in place, unlock queue
      * making the event writable */
     TEVENT_FD_WRITEABLE(cctx->cfde);
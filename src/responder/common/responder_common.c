@@ -32,9 +32,15 @@
 #include <fcntl.h>
 #include <popt.h>
 #include <dbus/dbus.h>
+#ifdef HAVE_MALLOC_TRIM
+#include <malloc.h>
+#endif
 
 #include "util/util.h"
 #include "util/strtonum.h"
+#include "util/sss_ptr_hash.h"
+#include "util/sss_loop_stats.h"
+#include "util/dlinklist.h"
 #include "db/sysdb.h"
 #include "confdb/confdb.h"
 #include "responder/common/responder.h"
@@ -50,6 +56,10 @@
 #define SHELL_REALLOC_INCREMENT 5
 #define SHELL_REALLOC_MAX       50
 
+/* how often the negative cache is saved with warm_restart, it is also saved
+ * when the responder shuts down */
+#define NCACHE_SNAPSHOT_INTERVAL 300
+
 static errno_t set_close_on_exec(int fd)
 {
     int v;
@@ -276,6 +286,11 @@ static void client_send(struct cli_ctx *cctx)
 
     pctx = talloc_get_type(cctx->protocol_ctx, struct cli_protocol);
 
+    /* clients that pipeline requests match the replies by this id */
+    if (pctx->creq->in != NULL && pctx->creq->out != NULL) {
+        sss_packet_set_id(pctx->creq->out, sss_packet_get_id(pctx->creq->in));
+    }
+
     ret = sss_packet_send(pctx->creq->out, cctx->cfd);
     if (ret == EAGAIN) {
         /* not all data was sent, loop again */
@@ -288,6 +303,7 @@ static void client_send(struct cli_ctx *cctx)
     }
 
     /* ok all sent */
+    sss_client_throttle_release(cctx);
     TEVENT_FD_NOT_WRITEABLE(cctx->cfde);
     TEVENT_FD_READABLE(cctx->cfde);
     talloc_zfree(pctx->creq);
@@ -301,9 +317,191 @@ static int client_cmd_execute(struct cli_ctx *cctx, struct sss_cmd_table *sss_cm
 
     pctx = talloc_get_type(cctx->protocol_ctx, struct cli_protocol);
     cmd = sss_packet_get_cmd(pctx->creq->in);
+    sss_cmd_stats_start(cctx);
     return sss_cmd_execute(cctx, cmd, sss_cmds);
 }
 
+/* Commands of all clients with the same uid. */
+struct cli_throttle_uid {
+    struct resp_ctx *rctx;
+    unsigned int running;
+
+    /* Clients that wait for a slot, the oldest first. */
+    struct cli_throttle_ref *waiting;
+};
+
+struct cli_throttle_ref {
+    struct cli_throttle_ref *prev;
+    struct cli_throttle_ref *next;
+
+    struct cli_throttle_uid *owner;
+    struct cli_ctx *cctx;
+    struct tevent_immediate *imm;
+    bool running;
+};
+
+static void cli_throttle_resume(struct tevent_context *ev,
+                                struct tevent_immediate *imm,
+                                void *private_data)
+{
+    struct cli_ctx *cctx = talloc_get_type(private_data, struct cli_ctx);
+    int ret;
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Running queued command of client [%p][%d]\n",
+          cctx, cctx->cfd);
+
+    ret = client_cmd_execute(cctx, cctx->rctx->sss_cmds);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to execute request, aborting client!\n");
+        talloc_free(cctx);
+    }
+}
+
+static void cli_throttle_next(struct cli_throttle_uid *owner)
+{
+    struct cli_throttle_ref *ref;
+
+    while (owner->waiting != NULL
+            && owner->running < owner->rctx->client_max_requests) {
+        ref = owner->waiting;
+        DLIST_REMOVE(owner->waiting, ref);
+        ref->running = true;
+        owner->running++;
+
+        /* Do not run the command from within the destructor of the
+         * previous one. */
+        tevent_schedule_immediate(ref->imm, ref->cctx->ev,
+                                  cli_throttle_resume, ref->cctx);
+    }
+}
+
+static int cli_throttle_ref_destructor(struct cli_throttle_ref *ref)
+{
+    struct cli_throttle_uid *owner = ref->owner;
+
+    if (ref->running) {
+        owner->running--;
+        cli_throttle_next(owner);
+    } else {
+        DLIST_REMOVE(owner->waiting, ref);
+    }
+
+    if (owner->running == 0 && owner->waiting == NULL) {
+        /* This also removes it from the table. */
+        talloc_free(owner);
+    }
+
+    return 0;
+}
+
+static bool cli_throttle_is_priority(struct cli_ctx *cctx,
+                                     enum sss_cli_command cmd)
+{
+    /* Keep logins responsive however busy the other clients are. */
+    if (cctx->priv) {
+        return true;
+    }
+
+    switch (cmd) {
+    case SSS_PAM_AUTHENTICATE:
+    case SSS_PAM_SETCRED:
+    case SSS_PAM_ACCT_MGMT:
+    case SSS_PAM_OPEN_SESSION:
+    case SSS_PAM_CLOSE_SESSION:
+    case SSS_PAM_CHAUTHTOK:
+    case SSS_PAM_CHAUTHTOK_PRELIM:
+    case SSS_PAM_PREAUTH:
+        return true;
+    default:
+        return false;
+    }
+}
+
+errno_t sss_client_throttle_acquire(struct cli_ctx *cctx,
+                                    enum sss_cli_command cmd)
+{
+    struct resp_ctx *rctx = cctx->rctx;
+    struct cli_throttle_uid *owner;
+    struct cli_throttle_ref *ref;
+    char *key;
+    errno_t ret;
+
+    if (rctx->client_max_requests == 0 || rctx->client_throttle == NULL
+            || cli_throttle_is_priority(cctx, cmd)) {
+        return EOK;
+    }
+
+    /* Clients whose credentials are unknown share one queue. */
+    key = talloc_asprintf(cctx, "%"SPRIuid, client_euid(cctx->creds));
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    owner = sss_ptr_hash_lookup(rctx->client_throttle, key,
+                                struct cli_throttle_uid);
+    if (owner == NULL) {
+        owner = talloc_zero(rctx->client_throttle, struct cli_throttle_uid);
+        if (owner == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        owner->rctx = rctx;
+
+        ret = sss_ptr_hash_add(rctx->client_throttle, key, owner,
+                               struct cli_throttle_uid);
+        if (ret != EOK) {
+            talloc_free(owner);
+            goto done;
+        }
+    }
+
+    ref = talloc_zero(cctx, struct cli_throttle_ref);
+    if (ref == NULL) {
+        if (owner->running == 0 && owner->waiting == NULL) {
+            talloc_free(owner);
+        }
+        ret = ENOMEM;
+        goto done;
+    }
+    ref->owner = owner;
+    ref->cctx = cctx;
+    talloc_set_destructor(ref, cli_throttle_ref_destructor);
+
+    talloc_free(cctx->throttle);
+    cctx->throttle = ref;
+
+    if (owner->running < rctx->client_max_requests) {
+        ref->running = true;
+        owner->running++;
+        ret = EOK;
+        goto done;
+    }
+
+    ref->imm = tevent_create_immediate(ref);
+    if (ref->imm == NULL) {
+        talloc_zfree(cctx->throttle);
+        ret = ENOMEM;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Client [%p][%d] of uid [%s] has to wait, %u commands running\n",
+          cctx, cctx->cfd, key, owner->running);
+
+    DLIST_ADD_END(owner->waiting, ref, struct cli_throttle_ref *);
+    ret = EAGAIN;
+
+done:
+    talloc_free(key);
+    return ret;
+}
+
+void sss_client_throttle_release(struct cli_ctx *cctx)
+{
+    talloc_zfree(cctx->throttle);
+}
+
 static void client_recv(struct cli_ctx *cctx)
 {
     struct cli_protocol *pctx;
@@ -337,6 +535,19 @@ static void client_recv(struct cli_ctx *cctx)
     case EOK:
         /* do not read anymore */
         TEVENT_FD_NOT_READABLE(cctx->cfde);
+
+        ret = sss_client_throttle_acquire(cctx,
+                                          sss_packet_get_cmd(pctx->creq->in));
+        if (ret == EAGAIN) {
+            /* the command is run once the client gets its turn */
+            return;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE,
+                  "Failed to queue request, aborting client!\n");
+            talloc_free(cctx);
+            return;
+        }
+
         /* execute command */
         ret = client_cmd_execute(cctx, cctx->rctx->sss_cmds);
         if (ret != EOK) {
@@ -373,6 +584,24 @@ static void client_recv(struct cli_ctx *cctx)
 
 static errno_t schedule_responder_idle_timer(struct resp_ctx *rctx);
 
+/* Instead of exiting, keep the process with its domain list, negative cache
+ * and open caches, so the next request does not pay the whole startup, and
+ * only give the memory that is not used back to the system. */
+static void responder_hibernate(struct resp_ctx *rctx)
+{
+    DEBUG(SSSDBG_TRACE_FUNC, "Responder is idle, hibernating\n");
+
+    if (rctx->ncache != NULL && rctx->ncache_snapshot != NULL) {
+        sss_ncache_save(rctx->ncache, rctx->ncache_snapshot);
+    }
+
+#ifdef HAVE_MALLOC_TRIM
+    malloc_trim(0);
+#endif
+
+    rctx->hibernating = true;
+}
+
 static void responder_idle_handler(struct tevent_context *ev,
                                    struct tevent_timer *te,
                                    struct timeval current_time,
@@ -391,6 +620,13 @@ static void responder_idle_handler(struct tevent_context *ev,
     }
 
     if ((now - rctx->last_request_time) > rctx->idle_timeout) {
+        if (rctx->idle_hibernate) {
+            if (!rctx->hibernating) {
+                responder_hibernate(rctx);
+            }
+            goto end;
+        }
+
         /* This responder is idle. Terminate it */
         DEBUG(SSSDBG_TRACE_INTERNAL,
               "Terminating idle responder [%p]\n", rctx);
@@ -400,6 +636,8 @@ static void responder_idle_handler(struct tevent_context *ev,
         orderly_shutdown(0);
     }
 
+    rctx->hibernating = false;
+
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "Re-scheduling the idle timeout for the responder [%p]\n", rctx);
 
@@ -457,6 +695,8 @@ static void client_fd_handler(struct tevent_context *ev,
                               struct tevent_fd *fde,
                               uint16_t flags, void *ptr)
 {
+    SSS_LOOP_STATS_MARK();
+
     sss_client_fd_handler(ptr, client_recv, client_send, flags);
 }
 
@@ -504,46 +744,23 @@ static void accept_and_terminate_cli(int fd)
     return;
 }
 
-static void accept_fd_handler(struct tevent_context *ev,
-                              struct tevent_fd *fde,
-                              uint16_t flags, void *ptr)
+/* Returns false if there was no client to accept or accepting failed */
+static bool accept_one_client(struct tevent_context *ev,
+                              struct accept_fd_ctx *accept_ctx)
 {
-    /* accept and attach new event handler */
-    struct accept_fd_ctx *accept_ctx =
-            talloc_get_type(ptr, struct accept_fd_ctx);
     struct resp_ctx *rctx = accept_ctx->rctx;
     struct cli_ctx *cctx;
     socklen_t len;
-    struct stat stat_buf;
     int ret;
     int fd = accept_ctx->is_private ? rctx->priv_lfd : rctx->lfd;
 
-    if (accept_ctx->is_private) {
-        ret = stat(rctx->priv_sock_name, &stat_buf);
-        if (ret == -1) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "stat on privileged pipe failed: [%d][%s].\n",
-                  errno, strerror(errno));
-            accept_and_terminate_cli(fd);
-            return;
-        }
-
-        if ( ! (stat_buf.st_uid == 0 && stat_buf.st_gid == 0 &&
-               (stat_buf.st_mode&(S_IFSOCK|S_IRUSR|S_IWUSR)) == stat_buf.st_mode)) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "privileged pipe has an illegal status.\n");
-            accept_and_terminate_cli(fd);
-            return;
-        }
-    }
-
     cctx = talloc_zero(rctx, struct cli_ctx);
     if (!cctx) {
         DEBUG(SSSDBG_FATAL_FAILURE,
               "Out of memory trying to setup client context%s!\n",
               accept_ctx->is_private ? " on privileged pipe": "");
         accept_and_terminate_cli(fd);
-        return;
+        return false;
     }
 
     talloc_set_destructor(cctx, cli_ctx_destructor);
@@ -551,9 +768,15 @@ static void accept_fd_handler(struct tevent_context *ev,
     len = sizeof(cctx->addr);
     cctx->cfd = accept(fd, (struct sockaddr *)&cctx->addr, &len);
     if (cctx->cfd == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            /* another process sharing the socket accepted the client */
+            DEBUG(SSSDBG_TRACE_ALL, "No client to accept\n");
+            talloc_free(cctx);
+            return false;
+        }
         DEBUG(SSSDBG_CRIT_FAILURE, "Accept failed [%s]\n", strerror(errno));
         talloc_free(cctx);
-        return;
+        return false;
     }
 
     cctx->priv = accept_ctx->is_private;
@@ -572,7 +795,7 @@ static void accept_fd_handler(struct tevent_context *ev,
                                         "socket. Access denied.\n");
             close(cctx->cfd);
             talloc_free(cctx);
-            return;
+            return true;
         }
 
         ret = check_allowed_uids(client_euid(cctx->creds), rctx->allowed_uids_count,
@@ -587,7 +810,7 @@ static void accept_fd_handler(struct tevent_context *ev,
             }
             close(cctx->cfd);
             talloc_free(cctx);
-            return;
+            return true;
         }
     }
 
@@ -598,7 +821,7 @@ static void accept_fd_handler(struct tevent_context *ev,
         DEBUG(SSSDBG_OP_FAILURE,
               "Failed to setup client handler%s\n",
                accept_ctx->is_private ? " on privileged pipe" : "");
-        return;
+        return true;
     }
 
     cctx->cfde = tevent_add_fd(ev, cctx, cctx->cfd,
@@ -610,7 +833,7 @@ static void accept_fd_handler(struct tevent_context *ev,
         DEBUG(SSSDBG_OP_FAILURE,
               "Failed to queue client handler%s\n",
                accept_ctx->is_private ? " on privileged pipe" : "");
-        return;
+        return true;
     }
     tevent_fd_set_close_fn(cctx->cfde, client_close_fn);
 
@@ -639,7 +862,50 @@ static void accept_fd_handler(struct tevent_context *ev,
           cctx, cctx->cfd,
           accept_ctx->is_private ? " to privileged pipe" : "");
 
-    return;
+    return true;
+}
+
+/* Accepting a batch of clients per readiness event saves a round trip
+ * through the event loop for each client during logon storms */
+#define RESPONDER_ACCEPT_BATCH 16
+
+static void accept_fd_handler(struct tevent_context *ev,
+                              struct tevent_fd *fde,
+                              uint16_t flags, void *ptr)
+{
+    /* accept and attach new event handler */
+    struct accept_fd_ctx *accept_ctx =
+            talloc_get_type(ptr, struct accept_fd_ctx);
+    struct resp_ctx *rctx = accept_ctx->rctx;
+    struct stat stat_buf;
+    int ret;
+    int fd = accept_ctx->is_private ? rctx->priv_lfd : rctx->lfd;
+    int i;
+
+    if (accept_ctx->is_private) {
+        ret = stat(rctx->priv_sock_name, &stat_buf);
+        if (ret == -1) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "stat on privileged pipe failed: [%d][%s].\n",
+                  errno, strerror(errno));
+            accept_and_terminate_cli(fd);
+            return;
+        }
+
+        if ( ! (stat_buf.st_uid == 0 && stat_buf.st_gid == 0 &&
+               (stat_buf.st_mode&(S_IFSOCK|S_IRUSR|S_IWUSR)) == stat_buf.st_mode)) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "privileged pipe has an illegal status.\n");
+            accept_and_terminate_cli(fd);
+            return;
+        }
+    }
+
+    for (i = 0; i < RESPONDER_ACCEPT_BATCH; i++) {
+        if (!accept_one_client(ev, accept_ctx)) {
+            break;
+        }
+    }
 }
 
 static void client_idle_handler(struct tevent_context *ev,
@@ -711,8 +977,10 @@ sss_dp_init(struct resp_ctx *rctx,
 {
     struct tevent_req *req;
     struct be_conn *be_conn;
+    char **no_coalescing = NULL;
     int max_retries;
     errno_t ret;
+    int i;
 
     ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
                          CONFDB_SERVICE_RECON_RETRIES, 3, &max_retries);
@@ -758,6 +1026,33 @@ sss_dp_init(struct resp_ctx *rctx,
         goto done;
     }
 
+    ret = confdb_get_string_as_list(rctx->cdb, be_conn,
+                                    rctx->confdb_service_path,
+                                    CONFDB_RESPONDER_PROVIDER_COALESCING_EXCLUDE,
+                                    &no_coalescing);
+    if (ret == EOK) {
+        for (i = 0; no_coalescing[i] != NULL; i++) {
+            ret = sbus_connection_disable_coalescing(be_conn->conn,
+                                                     "sssd.dataprovider",
+                                                     no_coalescing[i]);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+        talloc_free(no_coalescing);
+    } else if (ret != ENOENT) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to read confdb [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* Replies to authentication requests are dispatched first. */
+    ret = sbus_connection_set_priority(be_conn->conn, "sssd.dataprovider",
+                                       "pamHandler");
+    if (ret != EOK) {
+        goto done;
+    }
+
     sbus_reconnect_enable(be_conn->conn, max_retries, sss_dp_on_reconnect,
                           be_conn);
 
@@ -1113,9 +1408,89 @@ static int sss_responder_ctx_destructor(void *ptr)
     DEBUG(SSSDBG_TRACE_FUNC, "Responder is being shut down\n");
     rctx->shutting_down = true;
 
+    if (rctx->ncache != NULL && rctx->ncache_snapshot != NULL) {
+        sss_ncache_save(rctx->ncache, rctx->ncache_snapshot);
+    }
+
     return 0;
 }
 
+static void responder_ncache_snapshot_handler(struct tevent_context *ev,
+                                              struct tevent_timer *te,
+                                              struct timeval current_time,
+                                              void *data)
+{
+    struct resp_ctx *rctx = talloc_get_type(data, struct resp_ctx);
+    struct timeval tv;
+
+    sss_ncache_save(rctx->ncache, rctx->ncache_snapshot);
+
+    tv = tevent_timeval_current_ofs(NCACHE_SNAPSHOT_INTERVAL, 0);
+    te = tevent_add_timer(ev, rctx, tv, responder_ncache_snapshot_handler,
+                          rctx);
+    if (te == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to schedule the next negative cache snapshot\n");
+    }
+}
+
+/* Reads what the previous instance of the responder left behind: the
+ * domain list from the cache, so lookups do not wait for the providers to
+ * report subdomains, and the negative cache. */
+static errno_t responder_warm_restart(struct resp_ctx *rctx,
+                                      const char *conn_name)
+{
+    struct sss_domain_info *dom;
+    struct tevent_timer *te;
+    struct timeval tv;
+    errno_t ret;
+
+    for (dom = rctx->domains; dom != NULL; dom = get_next_domain(dom, 0)) {
+        if (dom->realm == NULL || dom->flat_name == NULL
+                || dom->domain_id == NULL) {
+            ret = sysdb_master_domain_update(dom);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Domain %s is not cached yet\n",
+                      dom->name);
+                continue;
+            }
+        }
+
+        ret = sysdb_update_subdomains(dom, rctx->cdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to read the subdomains of %s from the cache "
+                  "[%d]: %s\n", dom->name, ret, sss_strerror(ret));
+        }
+    }
+
+    /* The first request does not have to wait for the providers */
+    ret = sss_resp_use_cached_domains(rctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cached domains are not used, the first request will wait "
+              "for the providers\n");
+    }
+
+    rctx->ncache_snapshot = talloc_asprintf(rctx, "%s/negcache_%s.snapshot",
+                                            DB_PATH, conn_name);
+    if (rctx->ncache_snapshot == NULL) {
+        return ENOMEM;
+    }
+
+    /* a missing or damaged snapshot only means a cold negative cache */
+    sss_ncache_load(rctx->ncache, rctx->ncache_snapshot);
+
+    tv = tevent_timeval_current_ofs(NCACHE_SNAPSHOT_INTERVAL, 0);
+    te = tevent_add_timer(rctx->ev, rctx, tv,
+                          responder_ncache_snapshot_handler, rctx);
+    if (te == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
 static errno_t responder_init_ncache(TALLOC_CTX *mem_ctx,
                                      struct confdb_ctx *cdb,
                                      struct sss_nc_ctx **ncache)
@@ -1258,6 +1633,8 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
 {
     struct resp_ctx *rctx;
     struct sss_domain_info *dom;
+    int max_requests;
+    int batch_size;
     int ret;
     char *tmp = NULL;
 
@@ -1280,6 +1657,13 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
 
     talloc_set_destructor((TALLOC_CTX*)rctx, sss_responder_ctx_destructor);
 
+    rctx->cache_req_flights = sss_ptr_hash_create(rctx, NULL, NULL);
+    if (rctx->cache_req_flights == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "fatal error initializing cache_req\n");
+        ret = ENOMEM;
+        goto fail;
+    }
+
     ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
                          CONFDB_RESPONDER_CLI_IDLE_TIMEOUT,
                          CONFDB_RESPONDER_CLI_IDLE_DEFAULT_TIMEOUT,
@@ -1296,6 +1680,62 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
         rctx->client_idle_timeout = 10;
     }
 
+    ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
+                         CONFDB_RESPONDER_CLI_MAX_REQUESTS,
+                         CONFDB_RESPONDER_CLI_MAX_REQUESTS_DEFAULT,
+                         &max_requests);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the client request limit [%d]: %s\n",
+               ret, sss_strerror(ret));
+        goto fail;
+    }
+
+    if (max_requests > 0) {
+        rctx->client_max_requests = max_requests;
+        rctx->client_throttle = sss_ptr_hash_create(rctx, NULL, NULL);
+        if (rctx->client_throttle == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+    }
+
+    ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
+                         CONFDB_RESPONDER_PROVIDER_BATCH_SIZE,
+                         CONFDB_RESPONDER_PROVIDER_BATCH_SIZE_DEFAULT,
+                         &batch_size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the provider batch size [%d]: %s\n",
+               ret, sss_strerror(ret));
+        goto fail;
+    }
+
+    if (batch_size > DP_ACCOUNT_BATCH_MAX) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Provider batch size is limited to %d\n", DP_ACCOUNT_BATCH_MAX);
+        batch_size = DP_ACCOUNT_BATCH_MAX;
+    }
+
+    if (batch_size > 1) {
+        rctx->dp_batch_size = batch_size;
+        rctx->dp_batches = sss_ptr_hash_create(rctx, NULL, NULL);
+        if (rctx->dp_batches == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+    }
+
+    ret = confdb_get_bool(rctx->cdb, rctx->confdb_service_path,
+                          CONFDB_RESPONDER_WARM_RESTART, false,
+                          &rctx->warm_restart);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the \"%s\" option [%d]: %s\n",
+              CONFDB_RESPONDER_WARM_RESTART, ret, sss_strerror(ret));
+        goto fail;
+    }
+
     if (rctx->socket_activated || rctx->dbus_activated) {
         ret = responder_setup_idle_timeout_config(rctx);
         if (ret != EOK) {
@@ -1314,6 +1754,17 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
               ret, sss_strerror(ret));
     }
 
+    ret = confdb_get_bool(rctx->cdb, rctx->confdb_service_path,
+                          CONFDB_RESPONDER_PARALLEL_DOMAIN_LOOKUPS,
+                          false, &rctx->parallel_domain_lookups);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get \"%s\" option, domains will be searched one "
+              "after another [%d]: %s.\n",
+              CONFDB_RESPONDER_PARALLEL_DOMAIN_LOOKUPS,
+              ret, sss_strerror(ret));
+    }
+
     ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
                          CONFDB_RESPONDER_GET_DOMAINS_TIMEOUT,
                          GET_DOMAINS_DEFAULT_TIMEOUT, &rctx->domains_timeout);
@@ -1462,6 +1913,14 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    if (rctx->warm_restart) {
+        ret = responder_warm_restart(rctx, conn_name);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "fatal error restoring caches\n");
+            goto fail;
+        }
+    }
+
     ret = sss_ad_default_names_ctx(rctx, &rctx->global_names);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "sss_ad_default_names_ctx failed.\n");
@@ -1663,6 +2122,16 @@ errno_t responder_setup_idle_timeout_config(struct resp_ctx *rctx)
               "Responder idle timeout won't be set up as the "
               "responder_idle_timeout is set to 0");
     } else {
+        ret = confdb_get_bool(rctx->cdb, rctx->confdb_service_path,
+                              CONFDB_RESPONDER_IDLE_HIBERNATE, false,
+                              &rctx->idle_hibernate);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot get the \"%s\" option [%d]: %s\n",
+                  CONFDB_RESPONDER_IDLE_HIBERNATE, ret, sss_strerror(ret));
+            goto fail;
+        }
+
         /* Ensure that the responder timeout is at least sixty seconds */
         if (rctx->idle_timeout < 60) {
             DEBUG(SSSDBG_TRACE_INTERNAL,
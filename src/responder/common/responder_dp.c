@@ -23,6 +23,9 @@
 #include <sys/time.h>
 #include <time.h>
 #include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "util/sss_trace.h"
 #include "responder/common/responder_packet.h"
 #include "responder/common/responder.h"
 #include "providers/data_provider.h"
@@ -163,8 +166,323 @@ struct sss_dp_get_account_state {
     uint16_t dp_error;
     uint32_t error;
     const char *error_message;
+
+    struct sss_trace_span *span;
+};
+
+/* Account requests for the same domain that are issued within this time
+ * are sent to the backend together. */
+#define SSS_DP_BATCH_DELAY_USEC 1000
+
+struct sss_dp_batch_item;
+
+struct sss_dp_batch {
+    struct resp_ctx *rctx;
+    const char *key;
+    const char *conn_name;
+    const char *domain;
+    const char *extra;
+    uint32_t dp_flags;
+    uint32_t entry_type;
+
+    struct sss_dp_batch_item *items;
+    unsigned int num_items;
+    struct tevent_timer *timer;
+    /* new requests are still added to this batch */
+    bool open;
+};
+
+struct sss_dp_batch_item {
+    struct sss_dp_batch_item *prev;
+    struct sss_dp_batch_item *next;
+
+    struct sss_dp_batch *batch;
+    struct tevent_req *req;
+    const char *filter;
+    unsigned int index;
 };
 
+static void sss_dp_batch_done(struct tevent_req *subreq);
+
+static int sss_dp_batch_destructor(struct sss_dp_batch *batch)
+{
+    struct sss_dp_batch_item *item;
+
+    DLIST_FOR_EACH(item, batch->items) {
+        item->batch = NULL;
+    }
+
+    return 0;
+}
+
+static int sss_dp_batch_item_destructor(struct sss_dp_batch_item *item)
+{
+    if (item->batch != NULL) {
+        DLIST_REMOVE(item->batch->items, item);
+        item->batch->num_items--;
+    }
+
+    return 0;
+}
+
+static void sss_dp_batch_finish(struct sss_dp_batch *batch,
+                                errno_t ret,
+                                uint16_t *dp_errors,
+                                uint32_t *errors,
+                                const char **error_messages)
+{
+    struct sss_dp_get_account_state *state;
+    struct sss_dp_batch_item *item;
+    struct tevent_req *req;
+
+    /* Callers may free other requests of the batch. */
+    while ((item = batch->items) != NULL) {
+        DLIST_REMOVE(batch->items, item);
+        batch->num_items--;
+        item->batch = NULL;
+        req = item->req;
+
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            continue;
+        }
+
+        state = tevent_req_data(req, struct sss_dp_get_account_state);
+        state->dp_error = dp_errors[item->index];
+        state->error = errors[item->index];
+        state->error_message = talloc_strdup(state,
+                                             error_messages[item->index]);
+        if (state->error_message == NULL) {
+            tevent_req_error(req, ENOMEM);
+            continue;
+        }
+
+        tevent_req_done(req);
+    }
+
+    talloc_free(batch);
+}
+
+static void sss_dp_batch_flush(struct sss_dp_batch *batch)
+{
+    struct sss_dp_batch_item *item;
+    struct tevent_req *subreq;
+    struct be_conn *be_conn;
+    const char **filters;
+    unsigned int i;
+    errno_t ret;
+
+    /* New requests start a new batch. */
+    if (batch->open) {
+        sss_ptr_hash_delete(batch->rctx->dp_batches, batch->key, false);
+        batch->open = false;
+    }
+    talloc_zfree(batch->timer);
+
+    if (batch->num_items == 0) {
+        talloc_free(batch);
+        return;
+    }
+
+    ret = sss_dp_get_domain_conn(batch->rctx, batch->conn_name, &be_conn);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "BUG: The Data Provider connection for %s is not available!\n",
+              batch->domain);
+        ret = EIO;
+        goto done;
+    }
+
+    filters = talloc_zero_array(batch, const char *, batch->num_items + 1);
+    if (filters == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    i = 0;
+    DLIST_FOR_EACH(item, batch->items) {
+        item->index = i;
+        filters[i] = item->filter;
+        i++;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Sending batch of %u requests for [%s][%#x][%s]\n",
+          batch->num_items, batch->domain, batch->entry_type,
+          be_req2str(batch->entry_type));
+
+    subreq = sbus_call_dp_dp_getAccountInfoBatch_send(batch, be_conn->conn,
+                 be_conn->bus_name, SSS_BUS_PATH, batch->dp_flags,
+                 batch->entry_type, filters, batch->domain, batch->extra);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sss_dp_batch_done, batch);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        sss_dp_batch_finish(batch, ret, NULL, NULL, NULL);
+    }
+}
+
+static void sss_dp_batch_timeout(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval tv,
+                                 void *pvt)
+{
+    struct sss_dp_batch *batch;
+
+    batch = talloc_get_type(pvt, struct sss_dp_batch);
+
+    sss_dp_batch_flush(batch);
+}
+
+static void sss_dp_batch_done(struct tevent_req *subreq)
+{
+    struct sss_dp_batch *batch;
+    uint16_t *dp_errors = NULL;
+    uint32_t *errors = NULL;
+    const char **error_messages = NULL;
+    size_t num_messages;
+    errno_t ret;
+
+    batch = tevent_req_callback_data(subreq, struct sss_dp_batch);
+
+    ret = sbus_call_dp_dp_getAccountInfoBatch_recv(batch, subreq, &dp_errors,
+                                                   &errors, &error_messages);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    for (num_messages = 0; error_messages != NULL
+                           && error_messages[num_messages] != NULL;
+         num_messages++) {
+        /* count */
+    }
+
+    /* Requests that were freed meanwhile are not in the list anymore but
+     * they still have their place in the reply. */
+    if (talloc_array_length(dp_errors) != num_messages
+            || talloc_array_length(errors) != num_messages
+            || num_messages < batch->num_items) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid reply to batch request\n");
+        ret = EIO;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    sss_dp_batch_finish(batch, ret, dp_errors, errors, error_messages);
+}
+
+static errno_t sss_dp_batch_add(struct tevent_req *req,
+                                struct resp_ctx *rctx,
+                                struct sss_domain_info *dom,
+                                uint32_t dp_flags,
+                                uint32_t entry_type,
+                                const char *filter,
+                                const char *extra)
+{
+    struct sss_dp_get_account_state *state;
+    struct sss_dp_batch_item *item;
+    struct sss_dp_batch *batch;
+    struct tevent_timer *te;
+    struct timeval tv;
+    char *key;
+    errno_t ret;
+
+    state = tevent_req_data(req, struct sss_dp_get_account_state);
+
+    key = talloc_asprintf(state, "%s:%s:%#x:%#x:%s", dom->conn_name,
+                          dom->name, entry_type, dp_flags,
+                          extra == NULL ? "" : extra);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    batch = sss_ptr_hash_lookup(rctx->dp_batches, key, struct sss_dp_batch);
+    if (batch == NULL) {
+        batch = talloc_zero(rctx, struct sss_dp_batch);
+        if (batch == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        batch->rctx = rctx;
+        batch->key = talloc_steal(batch, key);
+        key = NULL;
+        batch->conn_name = talloc_strdup(batch, dom->conn_name);
+        batch->domain = talloc_strdup(batch, dom->name);
+        batch->extra = talloc_strdup(batch, extra);
+        if (batch->conn_name == NULL || batch->domain == NULL
+                || (extra != NULL && batch->extra == NULL)) {
+            talloc_free(batch);
+            ret = ENOMEM;
+            goto done;
+        }
+        batch->dp_flags = dp_flags;
+        batch->entry_type = entry_type;
+
+        tv = tevent_timeval_current_ofs(0, SSS_DP_BATCH_DELAY_USEC);
+        batch->timer = tevent_add_timer(rctx->ev, batch, tv,
+                                        sss_dp_batch_timeout, batch);
+        if (batch->timer == NULL) {
+            talloc_free(batch);
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sss_ptr_hash_add(rctx->dp_batches, batch->key, batch,
+                               struct sss_dp_batch);
+        if (ret != EOK) {
+            talloc_free(batch);
+            goto done;
+        }
+
+        batch->open = true;
+        talloc_set_destructor(batch, sss_dp_batch_destructor);
+    }
+
+    item = talloc_zero(state, struct sss_dp_batch_item);
+    if (item == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    item->req = req;
+    item->batch = batch;
+    item->filter = filter;
+    DLIST_ADD_END(batch->items, item, struct sss_dp_batch_item *);
+    batch->num_items++;
+    talloc_set_destructor(item, sss_dp_batch_item_destructor);
+
+    if (batch->num_items >= rctx->dp_batch_size) {
+        /* Send it from the event loop, the caller has not set its callback
+         * yet. If this fails the batch is sent when the delay is over. */
+        te = tevent_add_timer(rctx->ev, batch, tevent_timeval_zero(),
+                              sss_dp_batch_timeout, batch);
+        if (te != NULL) {
+            talloc_free(batch->timer);
+            batch->timer = te;
+            sss_ptr_hash_delete(rctx->dp_batches, batch->key, false);
+            batch->open = false;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(key);
+    return ret;
+}
+
 static void sss_dp_get_account_done(struct tevent_req *subreq);
 
 struct tevent_req *
@@ -203,6 +521,9 @@ sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    state->span = sss_trace_span_start_child(state, "Data provider",
+                                             dom->name);
+
     if (NEED_CHECK_PROVIDER(dom->provider) == false) {
         if (strcmp(dom->provider, "files") == 0) {
             /* This is a special case. If the files provider is just being updated,
@@ -262,9 +583,20 @@ sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
           dom->name, entry_type, be_req2str(entry_type),
           filter, extra == NULL ? "-" : extra);
 
+    if (rctx->dp_batches != NULL) {
+        ret = sss_dp_batch_add(req, rctx, dom, dp_flags, entry_type,
+                               filter, extra);
+        if (ret == EOK) {
+            ret = EAGAIN;
+        }
+        goto done;
+    }
+
     subreq = sbus_call_dp_dp_getAccountInfo_send(state, be_conn->conn,
                  be_conn->bus_name, SSS_BUS_PATH, dp_flags,
-                 entry_type, filter, dom->name, extra);
+                 entry_type, filter, dom->name, extra,
+                 sss_trace_span_trace_id(state->span),
+                 sss_trace_span_id(state->span));
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
         ret = ENOMEM;
@@ -317,8 +649,11 @@ sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
                         const char **_error_message)
 {
     struct sss_dp_get_account_state *state;
+
     state = tevent_req_data(req, struct sss_dp_get_account_state);
 
+    sss_trace_span_end_req(state->span, req, state->error);
+
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
     *_dp_error = state->dp_error;
@@ -24,6 +24,10 @@
 #include "db/sysdb.h"
 #include "sss_iface/sss_iface_async.h"
 
+/* How soon the data provider is asked again after the domains were loaded
+ * from the cache because it did not answer, e.g. while it is starting */
+#define GET_DOMAINS_CACHED_RETRY 5
+
 /* ========== Get subdomains for a domain ================= */
 struct get_subdomains_state {
     uint16_t dp_error;
@@ -143,12 +147,14 @@ get_subdomains_recv(TALLOC_CTX *mem_ctx,
 static errno_t process_subdomains(struct sss_domain_info *dom,
                                   struct confdb_ctx *confdb);
 static void set_time_of_last_request(struct resp_ctx *rctx);
+static void set_time_of_cached_request(struct resp_ctx *rctx);
 static errno_t check_last_request(struct resp_ctx *rctx, const char *hint);
 
 struct sss_dp_get_domains_state {
     struct resp_ctx *rctx;
     struct sss_domain_info *dom;
     const char *hint;
+    bool from_cache;
 };
 
 static void
@@ -277,7 +283,13 @@ sss_dp_get_domains_process(struct tevent_req *subreq)
     ret = get_subdomains_recv(subreq, subreq, &dp_err, &dp_ret, &err_msg);
     talloc_zfree(subreq);
     if (ret != EOK) {
-        goto fail;
+        /* The back end is not connected yet or does not answer, use the
+         * subdomains it stored in the cache so that the responder can
+         * answer from the cache in the meantime. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to get subdomains of [%s] "
+              "[%d]: %s, using the cached ones\n", state->dom->name,
+              ret, sss_strerror(ret));
+        state->from_cache = true;
     }
 
     ret = process_subdomains(state->dom, state->rctx->cdb);
@@ -297,7 +309,11 @@ sss_dp_get_domains_process(struct tevent_req *subreq)
 
     if (state->dom == NULL) {
         /* No more domains to check, refreshing the active configuration */
-        set_time_of_last_request(state->rctx);
+        if (state->from_cache) {
+            set_time_of_cached_request(state->rctx);
+        } else {
+            set_time_of_last_request(state->rctx);
+        }
         ret = sss_resp_populate_cr_domains(state->rctx);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE,
@@ -395,6 +411,20 @@ static void set_time_of_last_request(struct resp_ctx *rctx)
     }
 }
 
+/* Make the next request ask the data provider again after a short while
+ * instead of waiting for the whole get_domains_timeout. */
+static void set_time_of_cached_request(struct resp_ctx *rctx)
+{
+    time_t retry;
+
+    set_time_of_last_request(rctx);
+
+    retry = rctx->domains_timeout - GET_DOMAINS_CACHED_RETRY;
+    if (retry > 0 && rctx->get_domains_last_call.tv_sec > retry) {
+        rctx->get_domains_last_call.tv_sec -= retry;
+    }
+}
+
 static errno_t check_last_request(struct resp_ctx *rctx, const char *hint)
 {
     struct sss_domain_info *dom;
@@ -486,6 +516,24 @@ static void get_domains_at_startup(struct tevent_context *ev,
     return;
 }
 
+errno_t sss_resp_use_cached_domains(struct resp_ctx *rctx)
+{
+    errno_t ret;
+
+    ret = sss_resp_populate_cr_domains(rctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "sss_resp_populate_cr_domains() failed [%d]: [%s]\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    sss_resp_update_certmaps(rctx);
+    set_time_of_cached_request(rctx);
+
+    return EOK;
+}
+
 errno_t schedule_get_domains_task(TALLOC_CTX *mem_ctx,
                                   struct tevent_context *ev,
                                   struct resp_ctx *rctx,
@@ -513,6 +561,46 @@ errno_t schedule_get_domains_task(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static void sss_dp_get_domains_background_done(struct tevent_req *req);
+
+/* Refresh the subdomains without holding the request which asked for an
+ * unknown domain. The refresh is rate limited by get_domains_timeout. */
+static void sss_dp_get_domains_background(struct resp_ctx *rctx,
+                                          const char *hint)
+{
+    struct tevent_req *req;
+
+    if (rctx->get_domains_background) {
+        return;
+    }
+
+    req = sss_dp_get_domains_send(rctx, rctx, false, hint);
+    if (req == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sss_dp_get_domains_send failed.\n");
+        return;
+    }
+
+    tevent_req_set_callback(req, sss_dp_get_domains_background_done, rctx);
+    rctx->get_domains_background = true;
+}
+
+static void sss_dp_get_domains_background_done(struct tevent_req *req)
+{
+    struct resp_ctx *rctx;
+    errno_t ret;
+
+    rctx = tevent_req_callback_data(req, struct resp_ctx);
+    rctx->get_domains_background = false;
+
+    ret = sss_dp_get_domains_recv(req);
+    talloc_free(req);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Background refresh of subdomains failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
+
 struct sss_parse_inp_state {
     struct resp_ctx *rctx;
     const char *default_domain;
@@ -578,6 +666,20 @@ sss_parse_inp_send(TALLOC_CTX *mem_ctx,
             ret = ERR_INPUT_PARSE;
             goto done;
         }
+
+        if (state->domname != NULL && state->name == NULL
+                && rctx->ncache != NULL
+                && sss_ncache_check_unknown_domain(rctx->ncache,
+                                                   state->domname) == EEXIST) {
+            /* The last refresh did not find this domain either. Look for
+             * it in the background, the request fails right away. */
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Domain [%s] is in the negative cache\n", state->domname);
+            sss_dp_get_domains_background(rctx, state->domname);
+            state->error = ERR_DOMAIN_NOT_FOUND;
+            ret = ERR_DOMAIN_NOT_FOUND;
+            goto done;
+        }
     }
 
     /* EAGAIN - check the DP for subdomains */
@@ -633,6 +735,15 @@ static void sss_parse_inp_done(struct tevent_req *subreq)
         DEBUG(SSSDBG_OP_FAILURE,
               "Unknown domain in [%s]\n", state->rawinp);
         state->error = ERR_DOMAIN_NOT_FOUND;
+        if (state->rctx->ncache != NULL) {
+            ret = sss_ncache_set_unknown_domain(state->rctx->ncache,
+                                                state->domname);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Unable to store unknown domain [%s] in the negative "
+                      "cache, ignored.\n", state->domname);
+            }
+        }
     } else if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Invalid name received [%s]\n", state->rawinp);
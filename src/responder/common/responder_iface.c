@@ -153,7 +153,8 @@ sss_resp_register_service_iface(struct resp_ctx *rctx)
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to register service interface"
               "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
     }
 
-    return ret;
+    return sss_resp_register_stats_iface(rctx);
 }
@@ -40,7 +40,7 @@ struct sss_packet {
     * 0-3      packet length (uint32_t)
     * 4-7      command type (uint32_t)
     * 8-11     status (uint32_t)
-    * 12-15    reserved
+    * 12-15    request id (uint32_t), echoed back in the reply
     * 16+      packet body */
     uint8_t *buffer;
 
@@ -52,6 +52,7 @@ struct sss_packet {
 #define SSS_PACKET_LEN_OFFSET 0
 #define SSS_PACKET_CMD_OFFSET sizeof(uint32_t)
 #define SSS_PACKET_ERR_OFFSET (2*(sizeof(uint32_t)))
+#define SSS_PACKET_ID_OFFSET (3*(sizeof(uint32_t)))
 #define SSS_PACKET_BODY_OFFSET (4*(sizeof(uint32_t)))
 
 static void sss_packet_set_len(struct sss_packet *packet, uint32_t len);
@@ -182,61 +183,73 @@ int sss_packet_recv(struct sss_packet *packet, int fd)
     size_t new_len;
     int ret;
 
-    buf = (uint8_t *)packet->buffer + packet->iop;
-    if (packet->iop > 4) len = sss_packet_get_len(packet) - packet->iop;
-    else len = packet->memsize - packet->iop;
-
-    /* check for wrapping */
-    if (len > packet->memsize) {
-        return EINVAL;
-    }
+    /* The header and the body are usually sent together, so after the
+     * length is known the rest is read right away instead of waiting for
+     * the next readiness event */
+    while (true) {
+        buf = (uint8_t *)packet->buffer + packet->iop;
+        /* never read past the end of this packet, the client may already
+         * have sent the next request on the same connection */
+        if (packet->iop >= 4) len = sss_packet_get_len(packet) - packet->iop;
+        else len = 4 - packet->iop;
+
+        /* check for wrapping */
+        if (len > packet->memsize) {
+            return EINVAL;
+        }
 
-    errno = 0;
-    rb = recv(fd, buf, len, 0);
+        errno = 0;
+        rb = recv(fd, buf, len, 0);
 
-    if (rb == -1) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-            return EAGAIN;
-        } else {
-            return errno;
+        if (rb == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return EAGAIN;
+            } else {
+                return errno;
+            }
         }
-    }
 
-    if (rb == 0) {
-        return ENODATA;
-    }
+        if (rb == 0) {
+            return ENODATA;
+        }
 
-    if (sss_packet_get_len(packet) > packet->memsize) {
-        /* Allow certificate based requests to use larger buffer but not
-         * larger than SSS_CERT_PACKET_MAX_RECV_SIZE. Due to the way
-         * sss_packet_grow() works the packet len must be set to '0' first and
-         * then grow to the expected size. */
-        if ((sss_packet_get_cmd(packet) == SSS_NSS_GETNAMEBYCERT
-                    || sss_packet_get_cmd(packet) == SSS_NSS_GETLISTBYCERT)
-                && packet->memsize < SSS_CERT_PACKET_MAX_RECV_SIZE
-                && (new_len = sss_packet_get_len(packet))
-                                   < SSS_CERT_PACKET_MAX_RECV_SIZE) {
-            new_len = sss_packet_get_len(packet);
-            sss_packet_set_len(packet, 0);
-            ret = sss_packet_grow(packet, new_len);
-            if (ret != EOK) {
-                return ret;
+        if (sss_packet_get_len(packet) > packet->memsize) {
+            /* Allow certificate based requests to use larger buffer but not
+             * larger than SSS_CERT_PACKET_MAX_RECV_SIZE. Due to the way
+             * sss_packet_grow() works the packet len must be set to '0'
+             * first and then grow to the expected size. */
+            if ((sss_packet_get_cmd(packet) == SSS_NSS_GETNAMEBYCERT
+                        || sss_packet_get_cmd(packet) == SSS_NSS_GETLISTBYCERT)
+                    && packet->memsize < SSS_CERT_PACKET_MAX_RECV_SIZE
+                    && (new_len = sss_packet_get_len(packet))
+                                       < SSS_CERT_PACKET_MAX_RECV_SIZE) {
+                new_len = sss_packet_get_len(packet);
+                sss_packet_set_len(packet, 0);
+                ret = sss_packet_grow(packet, new_len);
+                if (ret != EOK) {
+                    return ret;
+                }
+            } else {
+                return EINVAL;
             }
-        } else {
-            return EINVAL;
         }
-    }
 
-    packet->iop += rb;
-    if (packet->iop < 4) {
-        return EAGAIN;
-    }
+        packet->iop += rb;
+        if (packet->iop < 4) {
+            return EAGAIN;
+        }
 
-    if (packet->iop < sss_packet_get_len(packet)) {
-        return EAGAIN;
-    }
+        if (packet->iop < sss_packet_get_len(packet)) {
+            if (rb < len) {
+                /* short read, the socket is most probably drained */
+                return EAGAIN;
+            }
+            /* the length was just read, continue with the body */
+            continue;
+        }
 
-    return EOK;
+        return EOK;
+    }
 }
 
 int sss_packet_send(struct sss_packet *packet, int fd)
@@ -306,6 +319,19 @@ void sss_packet_set_error(struct sss_packet *packet, int error)
                             NULL);
 }
 
+uint32_t sss_packet_get_id(struct sss_packet *packet)
+{
+    uint32_t id;
+
+    SAFEALIGN_COPY_UINT32(&id, packet->buffer + SSS_PACKET_ID_OFFSET, NULL);
+    return id;
+}
+
+void sss_packet_set_id(struct sss_packet *packet, uint32_t id)
+{
+    SAFEALIGN_SETMEM_UINT32(packet->buffer + SSS_PACKET_ID_OFFSET, id, NULL);
+}
+
 static void sss_packet_set_len(struct sss_packet *packet, uint32_t len)
 {
     SAFEALIGN_SETMEM_UINT32(packet->buffer + SSS_PACKET_LEN_OFFSET, len, NULL);
@@ -41,5 +41,7 @@ enum sss_cli_command sss_packet_get_cmd(struct sss_packet *packet);
 uint32_t sss_packet_get_status(struct sss_packet *packet);
 void sss_packet_get_body(struct sss_packet *packet, uint8_t **body, size_t *blen);
 void sss_packet_set_error(struct sss_packet *packet, int error);
+uint32_t sss_packet_get_id(struct sss_packet *packet);
+void sss_packet_set_id(struct sss_packet *packet, uint32_t id);
 
 #endif /* __SSSSRV_PACKET_H__ */
@@ -0,0 +1,400 @@
+/*
+    SSSD
+
+    Responder command latency histograms
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_cli_cmd.h"
+#include "util/sss_metrics.h"
+#include "sss_iface/sss_iface_async.h"
+#include "responder/common/responder.h"
+#include "responder/common/responder_packet.h"
+#include "responder/common/cache_req/cache_req.h"
+
+/* Commands of unknown subdomains are accounted without a domain once
+ * there are this many histograms. */
+#define SSS_CMD_STATS_MAX_ENTRIES 1024
+
+struct sss_cmd_stats_entry {
+    enum sss_cli_command cmd;
+    enum sss_cmd_source source;
+    const char *domain;
+
+    uint64_t count;
+    uint64_t total_usec;
+    uint64_t max_usec;
+    uint32_t buckets[SSS_CMD_STATS_BUCKETS];
+};
+
+struct sss_cmd_stats {
+    struct sss_cmd_stats_entry *entries;
+    size_t num_entries;
+};
+
+static struct sss_cmd_stats_entry *
+sss_cmd_stats_get_entry(struct resp_ctx *rctx,
+                        enum sss_cli_command cmd,
+                        enum sss_cmd_source source,
+                        const char *domain)
+{
+    struct sss_cmd_stats *stats;
+    struct sss_cmd_stats_entry *entries;
+    struct sss_cmd_stats_entry *entry;
+    size_t i;
+
+    if (rctx->cmd_stats == NULL) {
+        rctx->cmd_stats = talloc_zero(rctx, struct sss_cmd_stats);
+        if (rctx->cmd_stats == NULL) {
+            return NULL;
+        }
+    }
+    stats = rctx->cmd_stats;
+
+    if (domain != NULL && stats->num_entries >= SSS_CMD_STATS_MAX_ENTRIES) {
+        domain = NULL;
+    }
+
+    for (i = 0; i < stats->num_entries; i++) {
+        entry = &stats->entries[i];
+        if (entry->cmd == cmd && entry->source == source
+                && (entry->domain == domain
+                    || (entry->domain != NULL && domain != NULL
+                        && strcmp(entry->domain, domain) == 0))) {
+            return entry;
+        }
+    }
+
+    entries = talloc_realloc(stats, stats->entries,
+                             struct sss_cmd_stats_entry,
+                             stats->num_entries + 1);
+    if (entries == NULL) {
+        return NULL;
+    }
+    stats->entries = entries;
+
+    entry = &stats->entries[stats->num_entries];
+    memset(entry, 0, sizeof(struct sss_cmd_stats_entry));
+    entry->cmd = cmd;
+    entry->source = source;
+
+    if (domain != NULL) {
+        entry->domain = talloc_strdup(stats, domain);
+        if (entry->domain == NULL) {
+            return NULL;
+        }
+    }
+
+    stats->num_entries++;
+
+    return entry;
+}
+
+static size_t sss_cmd_stats_bucket(uint64_t usec)
+{
+    size_t bucket = 0;
+
+    usec >>= SSS_CMD_STATS_FIRST_SHIFT;
+    while (usec > 0 && bucket < SSS_CMD_STATS_BUCKETS - 1) {
+        usec >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void sss_cmd_stats_start(struct cli_ctx *cctx)
+{
+    cctx->cmd_start = tevent_timeval_current();
+    cctx->cmd_source = SSS_CMD_SOURCE_CACHE;
+    talloc_zfree(cctx->cmd_domain);
+}
+
+void sss_cmd_set_source(struct cli_ctx *cctx,
+                        enum sss_cmd_source source,
+                        struct sss_domain_info *domain)
+{
+    if (source < cctx->cmd_source) {
+        return;
+    }
+
+    if (source == cctx->cmd_source && cctx->cmd_domain != NULL) {
+        return;
+    }
+
+    cctx->cmd_source = source;
+
+    talloc_zfree(cctx->cmd_domain);
+    if (domain != NULL) {
+        /* The domain may go away before the command finishes. */
+        cctx->cmd_domain = talloc_strdup(cctx, domain->name);
+    }
+}
+
+void sss_cmd_set_lookup_source(struct cli_ctx *cctx,
+                               uint32_t lookup_flags,
+                               struct sss_domain_info *domain)
+{
+    enum sss_cmd_source source = SSS_CMD_SOURCE_CACHE;
+
+    if (lookup_flags & CACHE_REQ_LOOKUP_PROVIDER) {
+        source = SSS_CMD_SOURCE_PROVIDER;
+    } else if (lookup_flags & CACHE_REQ_LOOKUP_NCACHE) {
+        source = SSS_CMD_SOURCE_NCACHE;
+    }
+
+    sss_cmd_set_source(cctx, source, domain);
+}
+
+void sss_cmd_stats_finish(struct cli_ctx *cctx)
+{
+    struct sss_cmd_stats_entry *entry;
+    struct cli_protocol *pctx;
+    enum sss_cli_command cmd;
+    struct timeval now;
+    uint64_t usec;
+
+    if (!timerisset(&cctx->cmd_start)) {
+        return;
+    }
+
+    pctx = talloc_get_type(cctx->protocol_ctx, struct cli_protocol);
+    if (pctx == NULL || pctx->creq == NULL || pctx->creq->in == NULL) {
+        goto done;
+    }
+
+    now = tevent_timeval_current();
+    if (tevent_timeval_compare(&now, &cctx->cmd_start) < 0) {
+        usec = 0;
+    } else {
+        usec = (now.tv_sec - cctx->cmd_start.tv_sec) * 1000000ULL
+               + now.tv_usec - cctx->cmd_start.tv_usec;
+    }
+
+    cmd = sss_packet_get_cmd(pctx->creq->in);
+    sss_metrics_observe(SSS_METRIC_RESPONDER_COMMAND_DURATION, usec,
+                        sss_cmd2str(cmd));
+
+    entry = sss_cmd_stats_get_entry(cctx->rctx, cmd,
+                                    cctx->cmd_source, cctx->cmd_domain);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    entry->count++;
+    entry->total_usec += usec;
+    if (usec > entry->max_usec) {
+        entry->max_usec = usec;
+    }
+    entry->buckets[sss_cmd_stats_bucket(usec)]++;
+
+done:
+    timerclear(&cctx->cmd_start);
+    talloc_zfree(cctx->cmd_domain);
+}
+
+static errno_t
+sss_resp_get_command_stats(TALLOC_CTX *mem_ctx,
+                           struct sbus_request *sbus_req,
+                           struct resp_ctx *rctx,
+                           uint32_t **_commands,
+                           uint32_t **_sources,
+                           const char ***_domains,
+                           uint64_t **_counts,
+                           uint64_t **_total_usec,
+                           uint64_t **_max_usec,
+                           uint32_t **_histograms)
+{
+    struct sss_cmd_stats_entry *entry;
+    uint32_t *commands;
+    uint32_t *sources;
+    const char **domains;
+    uint64_t *counts;
+    uint64_t *total_usec;
+    uint64_t *max_usec;
+    uint32_t *histograms;
+    size_t num;
+    size_t i;
+
+    num = rctx->cmd_stats == NULL ? 0 : rctx->cmd_stats->num_entries;
+
+    commands = talloc_array(mem_ctx, uint32_t, num);
+    sources = talloc_array(mem_ctx, uint32_t, num);
+    domains = talloc_zero_array(mem_ctx, const char *, num + 1);
+    counts = talloc_array(mem_ctx, uint64_t, num);
+    total_usec = talloc_array(mem_ctx, uint64_t, num);
+    max_usec = talloc_array(mem_ctx, uint64_t, num);
+    histograms = talloc_array(mem_ctx, uint32_t, num * SSS_CMD_STATS_BUCKETS);
+    if (commands == NULL || sources == NULL || domains == NULL
+            || counts == NULL || total_usec == NULL || max_usec == NULL
+            || histograms == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num; i++) {
+        entry = &rctx->cmd_stats->entries[i];
+
+        commands[i] = entry->cmd;
+        sources[i] = entry->source;
+        domains[i] = entry->domain == NULL ? "" : entry->domain;
+        counts[i] = entry->count;
+        total_usec[i] = entry->total_usec;
+        max_usec[i] = entry->max_usec;
+        memcpy(&histograms[i * SSS_CMD_STATS_BUCKETS], entry->buckets,
+               sizeof(entry->buckets));
+    }
+
+    *_commands = commands;
+    *_sources = sources;
+    *_domains = domains;
+    *_counts = counts;
+    *_total_usec = total_usec;
+    *_max_usec = max_usec;
+    *_histograms = histograms;
+
+    return EOK;
+}
+
+static errno_t
+sss_resp_get_provider_request_stats(TALLOC_CTX *mem_ctx,
+                                    struct sbus_request *sbus_req,
+                                    struct resp_ctx *rctx,
+                                    const char ***_domains,
+                                    const char ***_methods,
+                                    uint64_t **_requests,
+                                    uint64_t **_coalesced,
+                                    uint32_t **_in_flight,
+                                    uint32_t **_waiting)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sbus_request_stats *stats;
+    struct be_conn *be_conn;
+    const char **domains = NULL;
+    const char **methods = NULL;
+    uint64_t *requests = NULL;
+    uint64_t *coalesced = NULL;
+    uint32_t *in_flight = NULL;
+    uint32_t *waiting = NULL;
+    size_t num_stats;
+    size_t num = 0;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    DLIST_FOR_EACH(be_conn, rctx->be_conns) {
+        ret = sbus_connection_get_request_stats(tmp_ctx, be_conn->conn,
+                                                &stats, &num_stats);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        if (num_stats == 0) {
+            continue;
+        }
+
+        domains = talloc_realloc(tmp_ctx, domains, const char *,
+                                 num + num_stats + 1);
+        methods = talloc_realloc(tmp_ctx, methods, const char *,
+                                 num + num_stats + 1);
+        requests = talloc_realloc(tmp_ctx, requests, uint64_t,
+                                  num + num_stats);
+        coalesced = talloc_realloc(tmp_ctx, coalesced, uint64_t,
+                                   num + num_stats);
+        in_flight = talloc_realloc(tmp_ctx, in_flight, uint32_t,
+                                   num + num_stats);
+        waiting = talloc_realloc(tmp_ctx, waiting, uint32_t,
+                                 num + num_stats);
+        if (domains == NULL || methods == NULL || requests == NULL
+                || coalesced == NULL || in_flight == NULL || waiting == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (i = 0; i < num_stats; i++) {
+            domains[num] = be_conn->domain->name;
+            methods[num] = talloc_steal(methods, stats[i].method);
+            requests[num] = stats[i].requests;
+            coalesced[num] = stats[i].coalesced;
+            in_flight[num] = stats[i].in_flight;
+            waiting[num] = stats[i].waiting;
+            num++;
+        }
+
+        domains[num] = NULL;
+        methods[num] = NULL;
+        talloc_free(stats);
+    }
+
+    if (num == 0) {
+        domains = talloc_zero_array(tmp_ctx, const char *, 1);
+        methods = talloc_zero_array(tmp_ctx, const char *, 1);
+        requests = talloc_array(tmp_ctx, uint64_t, 0);
+        coalesced = talloc_array(tmp_ctx, uint64_t, 0);
+        in_flight = talloc_array(tmp_ctx, uint32_t, 0);
+        waiting = talloc_array(tmp_ctx, uint32_t, 0);
+        if (domains == NULL || methods == NULL || requests == NULL
+                || coalesced == NULL || in_flight == NULL || waiting == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    *_domains = talloc_steal(mem_ctx, domains);
+    *_methods = talloc_steal(mem_ctx, methods);
+    *_requests = talloc_steal(mem_ctx, requests);
+    *_coalesced = talloc_steal(mem_ctx, coalesced);
+    *_in_flight = talloc_steal(mem_ctx, in_flight);
+    *_waiting = talloc_steal(mem_ctx, waiting);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t
+sss_resp_register_stats_iface(struct resp_ctx *rctx)
+{
+    errno_t ret;
+
+    SBUS_INTERFACE(iface_stats,
+        sssd_Responder_Statistics,
+        SBUS_METHODS(
+            SBUS_SYNC(METHOD, sssd_Responder_Statistics, GetCommandStats, sss_resp_get_command_stats, rctx),
+            SBUS_SYNC(METHOD, sssd_Responder_Statistics, GetProviderRequestStats, sss_resp_get_provider_request_stats, rctx)
+        ),
+        SBUS_SIGNALS(SBUS_NO_SIGNALS),
+        SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
+    );
+
+    ret = sbus_connection_add_path(rctx->mon_conn, SSS_BUS_PATH, &iface_stats);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to register statistics interface"
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return sss_iface_register_metrics(rctx->mon_conn);
+}
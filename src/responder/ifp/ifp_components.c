@@ -660,3 +660,138 @@ done:
 
     return ret;
 }
+
+struct ifp_component_get_command_stats_state {
+    uint32_t *commands;
+    uint32_t *sources;
+    const char **domains;
+    uint64_t *counts;
+    uint64_t *total_usec;
+    uint64_t *max_usec;
+    uint32_t *histograms;
+};
+
+static void ifp_component_get_command_stats_done(struct tevent_req *subreq);
+
+struct tevent_req *
+ifp_component_get_command_stats_send(TALLOC_CTX *mem_ctx,
+                                     struct tevent_context *ev,
+                                     struct sbus_request *sbus_req,
+                                     struct ifp_ctx *ctx)
+{
+    struct ifp_component_get_command_stats_state *state;
+    enum component_type type;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    const char *busname;
+    char *name;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct ifp_component_get_command_stats_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    ret = check_and_get_component_from_path(state, ctx->rctx->cdb,
+                                            sbus_req->path, &type, &name);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unknown object [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (type != COMPONENT_RESPONDER) {
+        DEBUG(SSSDBG_OP_FAILURE, "Command statistics are available only "
+              "for responders\n");
+        ret = ENOTSUP;
+        goto done;
+    }
+
+    /* Responders use their service name in the bus name, see
+     * SSS_BUS_NSS and the like. */
+    busname = talloc_asprintf(state, "sssd.%s", name);
+    if (busname == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    subreq = sbus_call_resp_stats_GetCommandStats_send(state,
+                                                       ctx->rctx->mon_conn,
+                                                       busname, SSS_BUS_PATH);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, ifp_component_get_command_stats_done,
+                            req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void ifp_component_get_command_stats_done(struct tevent_req *subreq)
+{
+    struct ifp_component_get_command_stats_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ifp_component_get_command_stats_state);
+
+    ret = sbus_call_resp_stats_GetCommandStats_recv(state, subreq,
+                                                    &state->commands,
+                                                    &state->sources,
+                                                    &state->domains,
+                                                    &state->counts,
+                                                    &state->total_usec,
+                                                    &state->max_usec,
+                                                    &state->histograms);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to get command statistics "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+errno_t
+ifp_component_get_command_stats_recv(TALLOC_CTX *mem_ctx,
+                                     struct tevent_req *req,
+                                     uint32_t **_commands,
+                                     uint32_t **_sources,
+                                     const char ***_domains,
+                                     uint64_t **_counts,
+                                     uint64_t **_total_usec,
+                                     uint64_t **_max_usec,
+                                     uint32_t **_histograms)
+{
+    struct ifp_component_get_command_stats_state *state;
+
+    state = tevent_req_data(req, struct ifp_component_get_command_stats_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_commands = talloc_steal(mem_ctx, state->commands);
+    *_sources = talloc_steal(mem_ctx, state->sources);
+    *_domains = talloc_steal(mem_ctx, state->domains);
+    *_counts = talloc_steal(mem_ctx, state->counts);
+    *_total_usec = talloc_steal(mem_ctx, state->total_usec);
+    *_max_usec = talloc_steal(mem_ctx, state->max_usec);
+    *_histograms = talloc_steal(mem_ctx, state->histograms);
+
+    return EOK;
+}
@@ -65,6 +65,23 @@ ifp_find_backend_by_name(TALLOC_CTX *mem_ctx,
 
 /* org.freedesktop.sssd.infopipe.Components */
 
+struct tevent_req *
+ifp_component_get_command_stats_send(TALLOC_CTX *mem_ctx,
+                                     struct tevent_context *ev,
+                                     struct sbus_request *sbus_req,
+                                     struct ifp_ctx *ctx);
+
+errno_t
+ifp_component_get_command_stats_recv(TALLOC_CTX *mem_ctx,
+                                     struct tevent_req *req,
+                                     uint32_t **_commands,
+                                     uint32_t **_sources,
+                                     const char ***_domains,
+                                     uint64_t **_counts,
+                                     uint64_t **_total_usec,
+                                     uint64_t **_max_usec,
+                                     uint32_t **_histograms);
+
 errno_t
 ifp_component_get_name(TALLOC_CTX *mem_ctx,
                        struct sbus_request *sbus_req,
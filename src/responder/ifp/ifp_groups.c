@@ -87,10 +87,13 @@ static int ifp_groups_list_copy(struct ifp_list_ctx *list_ctx,
                                 struct sss_domain_info *domain,
                                 struct ldb_result *result)
 {
-    size_t copy_count, i;
+    size_t copy_count, skip, i;
     errno_t ret;
 
-    ret = ifp_list_ctx_remaining_capacity(list_ctx, result->count, &copy_count);
+    skip = ifp_list_ctx_skip(list_ctx, result->count);
+
+    ret = ifp_list_ctx_remaining_capacity(list_ctx, result->count - skip,
+                                          &copy_count);
     if (ret != EOK) {
         goto done;
     }
@@ -98,7 +101,7 @@ static int ifp_groups_list_copy(struct ifp_list_ctx *list_ctx,
     for (i = 0; i < copy_count; i++) {
         list_ctx->paths[list_ctx->path_count + i] = \
             ifp_groups_build_path_from_msg(list_ctx->paths, domain,
-                                           result->msgs[i]);
+                                           result->msgs[skip + i]);
         if (list_ctx->paths[list_ctx->path_count + i] == NULL) {
             ret = ENOMEM;
             goto done;
@@ -310,6 +313,19 @@ ifp_groups_list_by_name_send(TALLOC_CTX *mem_ctx,
                              struct ifp_ctx *ctx,
                              const char *filter,
                              uint32_t limit)
+{
+    return ifp_groups_list_by_name_paged_send(mem_ctx, ev, sbus_req, ctx,
+                                              filter, 0, limit);
+}
+
+struct tevent_req *
+ifp_groups_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                   struct tevent_context *ev,
+                                   struct sbus_request *sbus_req,
+                                   struct ifp_ctx *ctx,
+                                   const char *filter,
+                                   uint32_t offset,
+                                   uint32_t limit)
 {
     struct ifp_groups_list_by_name_state *state;
     struct tevent_req *req;
@@ -327,6 +343,7 @@ ifp_groups_list_by_name_send(TALLOC_CTX *mem_ctx,
         ret = ENOMEM;
         goto done;
     }
+    state->list_ctx->offset = offset;
 
     ret = ifp_groups_list_by_name_step(req);
 
@@ -350,7 +367,7 @@ ifp_groups_list_by_name_step(struct tevent_req *req)
 
     state = tevent_req_data(req, struct ifp_groups_list_by_name_state);
 
-    if (state->list_ctx->dom == NULL) {
+    if (state->list_ctx->dom == NULL || ifp_list_ctx_full(state->list_ctx)) {
         return EOK;
     }
 
@@ -437,6 +454,22 @@ ifp_groups_list_by_domain_and_name_send(TALLOC_CTX *mem_ctx,
                                         const char *domain,
                                         const char *filter,
                                         uint32_t limit)
+{
+    return ifp_groups_list_by_domain_and_name_paged_send(mem_ctx, ev,
+                                                         sbus_req, ctx,
+                                                         domain, filter,
+                                                         0, limit);
+}
+
+struct tevent_req *
+ifp_groups_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                              struct tevent_context *ev,
+                                              struct sbus_request *sbus_req,
+                                              struct ifp_ctx *ctx,
+                                              const char *domain,
+                                              const char *filter,
+                                              uint32_t offset,
+                                              uint32_t limit)
 {
     struct ifp_groups_list_by_domain_and_name_state *state;
     struct tevent_req *subreq;
@@ -454,6 +487,7 @@ ifp_groups_list_by_domain_and_name_send(TALLOC_CTX *mem_ctx,
         ret = ENOMEM;
         goto done;
     }
+    state->list_ctx->offset = offset;
 
     subreq = cache_req_group_by_filter_send(state->list_ctx, ctx->rctx->ev,
                                             ctx->rctx, CACHE_REQ_ANY_DOM,
@@ -68,6 +68,15 @@ ifp_groups_list_by_name_recv(TALLOC_CTX *mem_ctx,
                              struct tevent_req *req,
                              const char ***_paths);
 
+struct tevent_req *
+ifp_groups_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                   struct tevent_context *ev,
+                                   struct sbus_request *sbus_req,
+                                   struct ifp_ctx *ctx,
+                                   const char *filter,
+                                   uint32_t offset,
+                                   uint32_t limit);
+
 struct tevent_req *
 ifp_groups_list_by_domain_and_name_send(TALLOC_CTX *mem_ctx,
                                         struct tevent_context *ev,
@@ -82,6 +91,16 @@ ifp_groups_list_by_domain_and_name_recv(TALLOC_CTX *mem_ctx,
                                         struct tevent_req *req,
                                         const char ***_paths);
 
+struct tevent_req *
+ifp_groups_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                              struct tevent_context *ev,
+                                              struct sbus_request *sbus_req,
+                                              struct ifp_ctx *ctx,
+                                              const char *domain,
+                                              const char *filter,
+                                              uint32_t offset,
+                                              uint32_t limit);
+
 /* org.freedesktop.sssd.infopipe.Groups.Group */
 
 struct tevent_req *
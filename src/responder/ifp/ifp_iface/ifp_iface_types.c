@@ -214,3 +214,83 @@ done:
     talloc_free(table_iter);
     return ret;
 }
+
+/**
+ * D-Bus signature: aa{sas}
+ */
+errno_t sbus_iterator_read_ifp_extra_list(TALLOC_CTX *mem_ctx,
+                                          DBusMessageIter *iterator,
+                                          hash_table_t ***_tables)
+{
+    DBusMessageIter iter_array;
+    hash_table_t **tables;
+    int arg_type;
+    errno_t ret;
+    int count;
+    int i;
+
+    arg_type = dbus_message_iter_get_arg_type(iterator);
+    if (arg_type != DBUS_TYPE_ARRAY) {
+        return ERR_SBUS_INVALID_TYPE;
+    }
+
+    count = dbus_message_iter_get_element_count(iterator);
+    dbus_message_iter_recurse(iterator, &iter_array);
+
+    tables = talloc_zero_array(mem_ctx, hash_table_t *, count + 1);
+    if (tables == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        ret = sbus_iterator_read_ifp_extra(tables, &iter_array, &tables[i]);
+        if (ret != EOK) {
+            talloc_free(tables);
+            return ret;
+        }
+
+        dbus_message_iter_next(&iter_array);
+    }
+
+    *_tables = tables;
+
+    return EOK;
+}
+
+/**
+ * D-Bus signature: aa{sas}
+ */
+errno_t sbus_iterator_write_ifp_extra_list(DBusMessageIter *iterator,
+                                           hash_table_t **tables)
+{
+    DBusMessageIter it_array;
+    dbus_bool_t dbret;
+    errno_t ret;
+    int i;
+
+    dbret = dbus_message_iter_open_container(iterator, DBUS_TYPE_ARRAY,
+                    DBUS_TYPE_ARRAY_AS_STRING
+                    DBUS_DICT_ENTRY_BEGIN_CHAR_AS_STRING
+                    DBUS_TYPE_STRING_AS_STRING
+                    DBUS_TYPE_ARRAY_AS_STRING
+                    DBUS_TYPE_STRING_AS_STRING
+                    DBUS_DICT_ENTRY_END_CHAR_AS_STRING, &it_array);
+    if (!dbret) {
+        return EIO;
+    }
+
+    for (i = 0; tables != NULL && tables[i] != NULL; i++) {
+        ret = sbus_iterator_write_ifp_extra(&it_array, tables[i]);
+        if (ret != EOK) {
+            dbus_message_iter_abandon_container(iterator, &it_array);
+            return ret;
+        }
+    }
+
+    dbret = dbus_message_iter_close_container(iterator, &it_array);
+    if (!dbret) {
+        return EIO;
+    }
+
+    return EOK;
+}
@@ -32,4 +32,11 @@ errno_t sbus_iterator_read_ifp_extra(TALLOC_CTX *mem_ctx,
 errno_t sbus_iterator_write_ifp_extra(DBusMessageIter *iterator,
                                       hash_table_t *table);
 
+errno_t sbus_iterator_read_ifp_extra_list(TALLOC_CTX *mem_ctx,
+                                          DBusMessageIter *iterator,
+                                          hash_table_t ***_tables);
+
+errno_t sbus_iterator_write_ifp_extra_list(DBusMessageIter *iterator,
+                                           hash_table_t **tables);
+
 #endif /* _SBUS_ITERATOR_READERS_H_ */
@@ -43,6 +43,22 @@ _sbus_ifp_invoker_write_ao
    (DBusMessageIter *iter,
     struct _sbus_ifp_invoker_args_ao *args);
 
+struct _sbus_ifp_invoker_args_aoas {
+    const char ** arg0;
+    const char ** arg1;
+};
+
+errno_t
+_sbus_ifp_invoker_read_aoas
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aoas *args);
+
+errno_t
+_sbus_ifp_invoker_write_aoas
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_aoas *args);
+
 struct _sbus_ifp_invoker_args_as {
     const char ** arg0;
 };
@@ -58,6 +74,27 @@ _sbus_ifp_invoker_write_as
    (DBusMessageIter *iter,
     struct _sbus_ifp_invoker_args_as *args);
 
+struct _sbus_ifp_invoker_args_auauasatatatau {
+    uint32_t * arg0;
+    uint32_t * arg1;
+    const char ** arg2;
+    uint64_t * arg3;
+    uint64_t * arg4;
+    uint64_t * arg5;
+    uint32_t * arg6;
+};
+
+errno_t
+_sbus_ifp_invoker_read_auauasatatatau
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_auauasatatatau *args);
+
+errno_t
+_sbus_ifp_invoker_write_auauasatatatau
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_auauasatatatau *args);
+
 struct _sbus_ifp_invoker_args_b {
     bool arg0;
 };
@@ -88,6 +125,21 @@ _sbus_ifp_invoker_write_ifp_extra
    (DBusMessageIter *iter,
     struct _sbus_ifp_invoker_args_ifp_extra *args);
 
+struct _sbus_ifp_invoker_args_ifp_extra_list {
+    hash_table_t ** arg0;
+};
+
+errno_t
+_sbus_ifp_invoker_read_ifp_extra_list
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_ifp_extra_list *args);
+
+errno_t
+_sbus_ifp_invoker_write_ifp_extra_list
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_ifp_extra_list *args);
+
 struct _sbus_ifp_invoker_args_o {
     const char * arg0;
 };
@@ -167,6 +219,24 @@ _sbus_ifp_invoker_write_ssu
    (DBusMessageIter *iter,
     struct _sbus_ifp_invoker_args_ssu *args);
 
+struct _sbus_ifp_invoker_args_ssuu {
+    const char * arg0;
+    const char * arg1;
+    uint32_t arg2;
+    uint32_t arg3;
+};
+
+errno_t
+_sbus_ifp_invoker_read_ssuu
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_ssuu *args);
+
+errno_t
+_sbus_ifp_invoker_write_ssuu
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_ssuu *args);
+
 struct _sbus_ifp_invoker_args_su {
     const char * arg0;
     uint32_t arg1;
@@ -183,6 +253,23 @@ _sbus_ifp_invoker_write_su
    (DBusMessageIter *iter,
     struct _sbus_ifp_invoker_args_su *args);
 
+struct _sbus_ifp_invoker_args_suu {
+    const char * arg0;
+    uint32_t arg1;
+    uint32_t arg2;
+};
+
+errno_t
+_sbus_ifp_invoker_read_suu
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_suu *args);
+
+errno_t
+_sbus_ifp_invoker_write_suu
+   (DBusMessageIter *iter,
+    struct _sbus_ifp_invoker_args_suu *args);
+
 struct _sbus_ifp_invoker_args_u {
     uint32_t arg0;
 };
@@ -164,6 +164,69 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in__out_auauasatatatau
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     uint32_t ** _arg0,
+     uint32_t ** _arg1,
+     const char *** _arg2,
+     uint64_t ** _arg3,
+     uint64_t ** _arg4,
+     uint64_t ** _arg5,
+     uint32_t ** _arg6)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_auauasatatatau *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_auauasatatatau);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL, NULL,
+                                bus, path, iface, method, NULL, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_auauasatatatau, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, out->arg1);
+    *_arg2 = talloc_steal(mem_ctx, out->arg2);
+    *_arg3 = talloc_steal(mem_ctx, out->arg3);
+    *_arg4 = talloc_steal(mem_ctx, out->arg4);
+    *_arg5 = talloc_steal(mem_ctx, out->arg5);
+    *_arg6 = talloc_steal(mem_ctx, out->arg6);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in__out_b
     (struct sbus_sync_connection *conn,
@@ -265,6 +328,63 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_aoas_out_ifp_extra_list
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char ** arg0,
+     const char ** arg1,
+     hash_table_t *** _arg0)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_aoas in;
+    struct _sbus_ifp_invoker_args_ifp_extra_list *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_ifp_extra_list);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_aoas,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_ifp_extra_list, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_s_out_ao
     (TALLOC_CTX *mem_ctx,
@@ -659,6 +779,67 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_ssuu_out_ao
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0,
+     const char * arg1,
+     uint32_t arg2,
+     uint32_t arg3,
+     const char *** _arg0)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_ssuu in;
+    struct _sbus_ifp_invoker_args_ao *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_ao);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+    in.arg2 = arg2;
+    in.arg3 = arg3;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_ssuu,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_ao, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_su_out_ao
     (TALLOC_CTX *mem_ctx,
@@ -716,6 +897,65 @@ done:
     return ret;
 }
 
+static errno_t
+sbus_method_in_suu_out_ao
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0,
+     uint32_t arg1,
+     uint32_t arg2,
+     const char *** _arg0)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct _sbus_ifp_invoker_args_suu in;
+    struct _sbus_ifp_invoker_args_ao *out;
+    DBusMessage *reply;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    out = talloc_zero(tmp_ctx, struct _sbus_ifp_invoker_args_ao);
+    if (out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    in.arg0 = arg0;
+    in.arg1 = arg1;
+    in.arg2 = arg2;
+
+    ret = sbus_sync_call_method(tmp_ctx, conn, NULL,
+                                (sbus_invoker_writer_fn)_sbus_ifp_invoker_write_suu,
+                                bus, path, iface, method, &in, &reply);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_read_output(out, reply, (sbus_invoker_reader_fn)_sbus_ifp_invoker_read_ao, out);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_arg0 = talloc_steal(mem_ctx, out->arg0);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
 static errno_t
 sbus_method_in_u_out_o
     (TALLOC_CTX *mem_ctx,
@@ -972,6 +1212,31 @@ sbus_call_ifp_cache_object_Store
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_components_GetCommandStats
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     uint32_t ** _arg_commands,
+     uint32_t ** _arg_sources,
+     const char *** _arg_domains,
+     uint64_t ** _arg_counts,
+     uint64_t ** _arg_total_usec,
+     uint64_t ** _arg_max_usec,
+     uint32_t ** _arg_histograms)
+{
+     return sbus_method_in__out_auauasatatatau(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Components", "GetCommandStats",
+          _arg_commands,
+          _arg_sources,
+          _arg_domains,
+          _arg_counts,
+          _arg_total_usec,
+          _arg_max_usec,
+          _arg_histograms);
+}
+
 errno_t
 sbus_call_ifp_domain_ActiveServer
     (TALLOC_CTX *mem_ctx,
@@ -1079,6 +1344,23 @@ sbus_call_ifp_groups_ListByDomainAndName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_groups_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result)
+{
+     return sbus_method_in_ssuu_out_ao(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Groups", "ListByDomainAndNamePaged", arg_domain_name, arg_name_filter, arg_offset, arg_limit,
+          _arg_result);
+}
+
 errno_t
 sbus_call_ifp_groups_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -1094,6 +1376,22 @@ sbus_call_ifp_groups_ListByName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_groups_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result)
+{
+     return sbus_method_in_suu_out_ao(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Groups", "ListByNamePaged", arg_name_filter, arg_offset, arg_limit,
+          _arg_result);
+}
+
 errno_t
 sbus_call_ifp_group_UpdateMemberList
     (struct sbus_sync_connection *conn,
@@ -1161,6 +1459,21 @@ sbus_call_ifp_users_FindByNameAndCertificate
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_GetUsersAttrs
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char ** arg_paths,
+     const char ** arg_attrs,
+     hash_table_t *** _arg_result)
+{
+     return sbus_method_in_aoas_out_ifp_extra_list(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "GetUsersAttrs", arg_paths, arg_attrs,
+          _arg_result);
+}
+
 errno_t
 sbus_call_ifp_users_ListByCertificate
     (TALLOC_CTX *mem_ctx,
@@ -1192,6 +1505,23 @@ sbus_call_ifp_users_ListByDomainAndName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result)
+{
+     return sbus_method_in_ssuu_out_ao(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "ListByDomainAndNamePaged", arg_domain_name, arg_name_filter, arg_offset, arg_limit,
+          _arg_result);
+}
+
 errno_t
 sbus_call_ifp_users_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -1207,6 +1537,22 @@ sbus_call_ifp_users_ListByName
           _arg_result);
 }
 
+errno_t
+sbus_call_ifp_users_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result)
+{
+     return sbus_method_in_suu_out_ao(mem_ctx, conn,
+          busname, object_path, "org.freedesktop.sssd.infopipe.Users", "ListByNamePaged", arg_name_filter, arg_offset, arg_limit,
+          _arg_result);
+}
+
 errno_t
 sbus_call_ifp_user_UpdateGroupsList
     (struct sbus_sync_connection *conn,
@@ -154,6 +154,20 @@ sbus_call_ifp_cache_object_Store
      const char *object_path,
      bool* _arg_result);
 
+errno_t
+sbus_call_ifp_components_GetCommandStats
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     uint32_t ** _arg_commands,
+     uint32_t ** _arg_sources,
+     const char *** _arg_domains,
+     uint64_t ** _arg_counts,
+     uint64_t ** _arg_total_usec,
+     uint64_t ** _arg_max_usec,
+     uint32_t ** _arg_histograms);
+
 errno_t
 sbus_call_ifp_domain_ActiveServer
     (TALLOC_CTX *mem_ctx,
@@ -222,6 +236,18 @@ sbus_call_ifp_groups_ListByDomainAndName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_groups_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result);
+
 errno_t
 sbus_call_ifp_groups_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -232,6 +258,17 @@ sbus_call_ifp_groups_ListByName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_groups_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result);
+
 errno_t
 sbus_call_ifp_group_UpdateMemberList
     (struct sbus_sync_connection *conn,
@@ -275,6 +312,16 @@ sbus_call_ifp_users_FindByNameAndCertificate
      const char * arg_pem_cert,
      const char ** _arg_result);
 
+errno_t
+sbus_call_ifp_users_GetUsersAttrs
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char ** arg_paths,
+     const char ** arg_attrs,
+     hash_table_t *** _arg_result);
+
 errno_t
 sbus_call_ifp_users_ListByCertificate
     (TALLOC_CTX *mem_ctx,
@@ -296,6 +343,18 @@ sbus_call_ifp_users_ListByDomainAndName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_users_ListByDomainAndNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result);
+
 errno_t
 sbus_call_ifp_users_ListByName
     (TALLOC_CTX *mem_ctx,
@@ -306,6 +365,17 @@ sbus_call_ifp_users_ListByName
      uint32_t arg_limit,
      const char *** _arg_result);
 
+errno_t
+sbus_call_ifp_users_ListByNamePaged
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_sync_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_name_filter,
+     uint32_t arg_offset,
+     uint32_t arg_limit,
+     const char *** _arg_result);
+
 errno_t
 sbus_call_ifp_user_UpdateGroupsList
     (struct sbus_sync_connection *conn,
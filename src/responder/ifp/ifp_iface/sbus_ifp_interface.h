@@ -379,6 +379,28 @@
         (methods), (signals), (properties)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Components.GetCommandStats */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Components_GetCommandStats(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **); \
+    sbus_method_sync("GetCommandStats", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Components_GetCommandStats, \
+        NULL, \
+        _sbus_ifp_invoke_in__out_auauasatatatau_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Components_GetCommandStats(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data)); \
+    SBUS_CHECK_RECV((handler_recv), uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **); \
+    sbus_method_async("GetCommandStats", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Components_GetCommandStats, \
+        NULL, \
+        _sbus_ifp_invoke_in__out_auauasatatatau_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Property: org.freedesktop.sssd.infopipe.Components.debug_level */
 #define SBUS_GETTER_SYNC_org_freedesktop_sssd_infopipe_Components_debug_level(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), uint32_t*); \
@@ -1238,6 +1260,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Groups.ListByDomainAndNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, const char *, uint32_t, uint32_t, const char ***); \
+    sbus_method_sync("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssuu_out_ao_send, \
+        _sbus_ifp_key_ssuu_0_1_2_3, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, const char *, uint32_t, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***); \
+    sbus_method_async("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssuu_out_ao_send, \
+        _sbus_ifp_key_ssuu_0_1_2_3, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: org.freedesktop.sssd.infopipe.Groups.ListByName */
 #define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Groups_ListByName(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t, const char ***); \
@@ -1260,6 +1304,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Groups.ListByNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t, uint32_t, const char ***); \
+    sbus_method_sync("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_suu_out_ao_send, \
+        _sbus_ifp_key_suu_0_1_2, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, uint32_t, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***); \
+    sbus_method_async("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_suu_out_ao_send, \
+        _sbus_ifp_key_suu_0_1_2, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Interface: org.freedesktop.sssd.infopipe.Groups.Group */
 #define SBUS_IFACE_org_freedesktop_sssd_infopipe_Groups_Group(methods, signals, properties) ({ \
     sbus_interface("org.freedesktop.sssd.infopipe.Groups.Group", NULL, \
@@ -1557,6 +1623,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Users.GetUsersAttrs */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_GetUsersAttrs(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char **, const char **, hash_table_t ***); \
+    sbus_method_sync("GetUsersAttrs", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_GetUsersAttrs, \
+        NULL, \
+        _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Users_GetUsersAttrs(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char **, const char **); \
+    SBUS_CHECK_RECV((handler_recv), hash_table_t ***); \
+    sbus_method_async("GetUsersAttrs", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_GetUsersAttrs, \
+        NULL, \
+        _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: org.freedesktop.sssd.infopipe.Users.ListByCertificate */
 #define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_ListByCertificate(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t, const char ***); \
@@ -1601,6 +1689,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Users.ListByDomainAndNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, const char *, uint32_t, uint32_t, const char ***); \
+    sbus_method_sync("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssuu_out_ao_send, \
+        _sbus_ifp_key_ssuu_0_1_2_3, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, const char *, uint32_t, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***); \
+    sbus_method_async("ListByDomainAndNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_ssuu_out_ao_send, \
+        _sbus_ifp_key_ssuu_0_1_2_3, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: org.freedesktop.sssd.infopipe.Users.ListByName */
 #define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_ListByName(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t, const char ***); \
@@ -1623,6 +1733,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: org.freedesktop.sssd.infopipe.Users.ListByNamePaged */
+#define SBUS_METHOD_SYNC_org_freedesktop_sssd_infopipe_Users_ListByNamePaged(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t, uint32_t, const char ***); \
+    sbus_method_sync("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_suu_out_ao_send, \
+        _sbus_ifp_key_suu_0_1_2, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_org_freedesktop_sssd_infopipe_Users_ListByNamePaged(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, uint32_t, uint32_t); \
+    SBUS_CHECK_RECV((handler_recv), const char ***); \
+    sbus_method_async("ListByNamePaged", \
+        &_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged, \
+        NULL, \
+        _sbus_ifp_invoke_in_suu_out_ao_send, \
+        _sbus_ifp_key_suu_0_1_2, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Interface: org.freedesktop.sssd.infopipe.Users.User */
 #define SBUS_IFACE_org_freedesktop_sssd_infopipe_Users_User(methods, signals, properties) ({ \
     sbus_interface("org.freedesktop.sssd.infopipe.Users.User", NULL, \
@@ -547,6 +547,173 @@ static void _sbus_ifp_invoke_in__out_as_done(struct tevent_req *subreq)
     return;
 }
 
+struct _sbus_ifp_invoke_in__out_auauasatatatau_state {
+    struct _sbus_ifp_invoker_args_auauasatatatau out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_ifp_invoke_in__out_auauasatatatau_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_ifp_invoke_in__out_auauasatatatau_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_ifp_invoke_in__out_auauasatatatau_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_ifp_invoke_in__out_auauasatatatau_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in__out_auauasatatatau_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in__out_auauasatatatau_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, NULL, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_ifp_invoke_in__out_auauasatatatau_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_ifp_invoke_in__out_auauasatatatau_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in__out_auauasatatatau_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3, &state->out.arg4, &state->out.arg5, &state->out.arg6);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_ifp_invoker_write_auauasatatatau(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in__out_auauasatatatau_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_ifp_invoke_in__out_auauasatatatau_done(struct tevent_req *subreq)
+{
+    struct _sbus_ifp_invoke_in__out_auauasatatatau_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in__out_auauasatatatau_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3, &state->out.arg4, &state->out.arg5, &state->out.arg6);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_ifp_invoker_write_auauasatatatau(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
 struct _sbus_ifp_invoke_in__out_b_state {
     struct _sbus_ifp_invoker_args_b out;
     struct {
@@ -1382,15 +1549,15 @@ static void _sbus_ifp_invoke_in__out_u_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_ifp_invoke_in_s_out_ao_state {
-    struct _sbus_ifp_invoker_args_s *in;
-    struct _sbus_ifp_invoker_args_ao out;
+struct _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_state {
+    struct _sbus_ifp_invoker_args_aoas in;
+    struct _sbus_ifp_invoker_args_ifp_extra_list out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char ***);
-        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char ***);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char **, const char **, hash_table_t ***);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char **, const char **);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, hash_table_t ***);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -1399,18 +1566,18 @@ struct _sbus_ifp_invoke_in_s_out_ao_state {
 };
 
 static void
-_sbus_ifp_invoke_in_s_out_ao_step
+_sbus_ifp_invoke_in_aoas_out_ifp_extra_list_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_ifp_invoke_in_s_out_ao_done
+_sbus_ifp_invoke_in_aoas_out_ifp_extra_list_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_ifp_invoke_in_s_out_ao_send
+_sbus_ifp_invoke_in_aoas_out_ifp_extra_list_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -1420,12 +1587,12 @@ _sbus_ifp_invoke_in_s_out_ao_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_ifp_invoke_in_s_out_ao_state *state;
+    struct _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_ao_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -1441,25 +1608,17 @@ _sbus_ifp_invoke_in_s_out_ao_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_aoas(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_s_out_ao_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1479,19 +1638,19 @@ done:
     return req;
 }
 
-static void _sbus_ifp_invoke_in_s_out_ao_step
+static void _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_ifp_invoke_in_s_out_ao_state *state;
+    struct _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_ao_state);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -1501,12 +1660,12 @@ static void _sbus_ifp_invoke_in_s_out_ao_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
+        ret = _sbus_ifp_invoker_write_ifp_extra_list(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -1515,14 +1674,14 @@ static void _sbus_ifp_invoke_in_s_out_ao_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_s_out_ao_done, req);
+        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -1537,14 +1696,14 @@ done:
     }
 }
 
-static void _sbus_ifp_invoke_in_s_out_ao_done(struct tevent_req *subreq)
+static void _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_done(struct tevent_req *subreq)
 {
-    struct _sbus_ifp_invoke_in_s_out_ao_state *state;
+    struct _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_ao_state);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_aoas_out_ifp_extra_list_state);
 
     ret = state->handler.recv(state, subreq, &state->out.arg0);
     talloc_zfree(subreq);
@@ -1553,7 +1712,7 @@ static void _sbus_ifp_invoke_in_s_out_ao_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
+    ret = _sbus_ifp_invoker_write_ifp_extra_list(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -1563,9 +1722,9 @@ static void _sbus_ifp_invoke_in_s_out_ao_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_ifp_invoke_in_s_out_as_state {
-    struct _sbus_ifp_invoker_args_s *in;
-    struct _sbus_ifp_invoker_args_as out;
+struct _sbus_ifp_invoke_in_s_out_ao_state {
+    struct _sbus_ifp_invoker_args_s in;
+    struct _sbus_ifp_invoker_args_ao out;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -1580,18 +1739,18 @@ struct _sbus_ifp_invoke_in_s_out_as_state {
 };
 
 static void
-_sbus_ifp_invoke_in_s_out_as_step
+_sbus_ifp_invoke_in_s_out_ao_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_ifp_invoke_in_s_out_as_done
+_sbus_ifp_invoke_in_s_out_ao_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_ifp_invoke_in_s_out_as_send
+_sbus_ifp_invoke_in_s_out_ao_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -1601,12 +1760,12 @@ _sbus_ifp_invoke_in_s_out_as_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_ifp_invoke_in_s_out_as_state *state;
+    struct _sbus_ifp_invoke_in_s_out_ao_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_as_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_ao_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -1622,25 +1781,17 @@ _sbus_ifp_invoke_in_s_out_as_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_s_out_as_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_s_out_ao_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1660,19 +1811,19 @@ done:
     return req;
 }
 
-static void _sbus_ifp_invoke_in_s_out_as_step
+static void _sbus_ifp_invoke_in_s_out_ao_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_ifp_invoke_in_s_out_as_state *state;
+    struct _sbus_ifp_invoke_in_s_out_ao_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_as_state);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_ao_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -1682,12 +1833,12 @@ static void _sbus_ifp_invoke_in_s_out_as_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_ifp_invoker_write_as(state->write_iterator, &state->out);
+        ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -1696,14 +1847,14 @@ static void _sbus_ifp_invoke_in_s_out_as_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_s_out_as_done, req);
+        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_s_out_ao_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -1718,14 +1869,14 @@ done:
     }
 }
 
-static void _sbus_ifp_invoke_in_s_out_as_done(struct tevent_req *subreq)
+static void _sbus_ifp_invoke_in_s_out_ao_done(struct tevent_req *subreq)
 {
-    struct _sbus_ifp_invoke_in_s_out_as_state *state;
+    struct _sbus_ifp_invoke_in_s_out_ao_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_as_state);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_ao_state);
 
     ret = state->handler.recv(state, subreq, &state->out.arg0);
     talloc_zfree(subreq);
@@ -1734,7 +1885,7 @@ static void _sbus_ifp_invoke_in_s_out_as_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = _sbus_ifp_invoker_write_as(state->write_iterator, &state->out);
+    ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -1744,15 +1895,15 @@ static void _sbus_ifp_invoke_in_s_out_as_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_ifp_invoke_in_s_out_o_state {
-    struct _sbus_ifp_invoker_args_s *in;
-    struct _sbus_ifp_invoker_args_o out;
+struct _sbus_ifp_invoke_in_s_out_as_state {
+    struct _sbus_ifp_invoker_args_s in;
+    struct _sbus_ifp_invoker_args_as out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char **);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char ***);
         struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char **);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char ***);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -1761,18 +1912,18 @@ struct _sbus_ifp_invoke_in_s_out_o_state {
 };
 
 static void
-_sbus_ifp_invoke_in_s_out_o_step
+_sbus_ifp_invoke_in_s_out_as_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_ifp_invoke_in_s_out_o_done
+_sbus_ifp_invoke_in_s_out_as_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_ifp_invoke_in_s_out_o_send
+_sbus_ifp_invoke_in_s_out_as_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -1782,12 +1933,12 @@ _sbus_ifp_invoke_in_s_out_o_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_ifp_invoke_in_s_out_o_state *state;
+    struct _sbus_ifp_invoke_in_s_out_as_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_o_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_as_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -1803,25 +1954,17 @@ _sbus_ifp_invoke_in_s_out_o_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_s_out_o_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_s_out_as_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1841,19 +1984,19 @@ done:
     return req;
 }
 
-static void _sbus_ifp_invoke_in_s_out_o_step
+static void _sbus_ifp_invoke_in_s_out_as_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_ifp_invoke_in_s_out_o_state *state;
+    struct _sbus_ifp_invoke_in_s_out_as_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_o_state);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_as_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -1863,12 +2006,12 @@ static void _sbus_ifp_invoke_in_s_out_o_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_ifp_invoker_write_o(state->write_iterator, &state->out);
+        ret = _sbus_ifp_invoker_write_as(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -1877,14 +2020,14 @@ static void _sbus_ifp_invoke_in_s_out_o_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_s_out_o_done, req);
+        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_s_out_as_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -1899,14 +2042,14 @@ done:
     }
 }
 
-static void _sbus_ifp_invoke_in_s_out_o_done(struct tevent_req *subreq)
+static void _sbus_ifp_invoke_in_s_out_as_done(struct tevent_req *subreq)
 {
-    struct _sbus_ifp_invoke_in_s_out_o_state *state;
+    struct _sbus_ifp_invoke_in_s_out_as_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_o_state);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_as_state);
 
     ret = state->handler.recv(state, subreq, &state->out.arg0);
     talloc_zfree(subreq);
@@ -1915,7 +2058,7 @@ static void _sbus_ifp_invoke_in_s_out_o_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = _sbus_ifp_invoker_write_o(state->write_iterator, &state->out);
+    ret = _sbus_ifp_invoker_write_as(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -1925,9 +2068,9 @@ static void _sbus_ifp_invoke_in_s_out_o_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_ifp_invoke_in_s_out_s_state {
-    struct _sbus_ifp_invoker_args_s *in;
-    struct _sbus_ifp_invoker_args_s out;
+struct _sbus_ifp_invoke_in_s_out_o_state {
+    struct _sbus_ifp_invoker_args_s in;
+    struct _sbus_ifp_invoker_args_o out;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -1942,18 +2085,18 @@ struct _sbus_ifp_invoke_in_s_out_s_state {
 };
 
 static void
-_sbus_ifp_invoke_in_s_out_s_step
+_sbus_ifp_invoke_in_s_out_o_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_ifp_invoke_in_s_out_s_done
+_sbus_ifp_invoke_in_s_out_o_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_ifp_invoke_in_s_out_s_send
+_sbus_ifp_invoke_in_s_out_o_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -1963,12 +2106,12 @@ _sbus_ifp_invoke_in_s_out_s_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_ifp_invoke_in_s_out_s_state *state;
+    struct _sbus_ifp_invoke_in_s_out_o_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_s_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_o_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -1984,15 +2127,180 @@ _sbus_ifp_invoke_in_s_out_s_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
+    ret = _sbus_ifp_invoker_read_s(state, read_iterator, &state->in);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_s_out_o_step, req);
+    if (ret != EOK) {
         goto done;
     }
 
-    ret = _sbus_ifp_invoker_read_s(state, read_iterator, state->in);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_ifp_invoke_in_s_out_o_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_ifp_invoke_in_s_out_o_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_o_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_ifp_invoker_write_o(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_s_out_o_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_ifp_invoke_in_s_out_o_done(struct tevent_req *subreq)
+{
+    struct _sbus_ifp_invoke_in_s_out_o_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_s_out_o_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_ifp_invoker_write_o(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+struct _sbus_ifp_invoke_in_s_out_s_state {
+    struct _sbus_ifp_invoker_args_s in;
+    struct _sbus_ifp_invoker_args_s out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char **);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char **);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_ifp_invoke_in_s_out_s_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_ifp_invoke_in_s_out_s_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_ifp_invoke_in_s_out_s_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_ifp_invoke_in_s_out_s_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_s_out_s_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = _sbus_ifp_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2002,7 +2310,7 @@ _sbus_ifp_invoke_in_s_out_s_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2044,7 +2352,7 @@ static void _sbus_ifp_invoke_in_s_out_s_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -2058,7 +2366,7 @@ static void _sbus_ifp_invoke_in_s_out_s_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2107,7 +2415,7 @@ static void _sbus_ifp_invoke_in_s_out_s_done(struct tevent_req *subreq)
 }
 
 struct _sbus_ifp_invoke_in_sas_out_raw_state {
-    struct _sbus_ifp_invoker_args_sas *in;
+    struct _sbus_ifp_invoker_args_sas in;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -2164,15 +2472,7 @@ _sbus_ifp_invoke_in_sas_out_raw_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_sas);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_sas(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_sas(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2182,7 +2482,7 @@ _sbus_ifp_invoke_in_sas_out_raw_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2224,7 +2524,7 @@ static void _sbus_ifp_invoke_in_sas_out_raw_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->write_iterator);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->write_iterator);
         if (ret != EOK) {
             goto done;
         }
@@ -2237,7 +2537,7 @@ static void _sbus_ifp_invoke_in_sas_out_raw_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->write_iterator);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->write_iterator);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2280,7 +2580,7 @@ static void _sbus_ifp_invoke_in_sas_out_raw_done(struct tevent_req *subreq)
 }
 
 struct _sbus_ifp_invoke_in_ss_out_o_state {
-    struct _sbus_ifp_invoker_args_ss *in;
+    struct _sbus_ifp_invoker_args_ss in;
     struct _sbus_ifp_invoker_args_o out;
     struct {
         enum sbus_handler_type type;
@@ -2338,15 +2638,7 @@ _sbus_ifp_invoke_in_ss_out_o_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_ss);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_ss(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_ss(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2356,7 +2648,7 @@ _sbus_ifp_invoke_in_ss_out_o_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2398,7 +2690,7 @@ static void _sbus_ifp_invoke_in_ss_out_o_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -2412,7 +2704,7 @@ static void _sbus_ifp_invoke_in_ss_out_o_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2461,7 +2753,7 @@ static void _sbus_ifp_invoke_in_ss_out_o_done(struct tevent_req *subreq)
 }
 
 struct _sbus_ifp_invoke_in_ssu_out_ao_state {
-    struct _sbus_ifp_invoker_args_ssu *in;
+    struct _sbus_ifp_invoker_args_ssu in;
     struct _sbus_ifp_invoker_args_ao out;
     struct {
         enum sbus_handler_type type;
@@ -2519,15 +2811,7 @@ _sbus_ifp_invoke_in_ssu_out_ao_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_ssu);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_ssu(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_ssu(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2537,7 +2821,7 @@ _sbus_ifp_invoke_in_ssu_out_ao_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2579,7 +2863,7 @@ static void _sbus_ifp_invoke_in_ssu_out_ao_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -2593,7 +2877,7 @@ static void _sbus_ifp_invoke_in_ssu_out_ao_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2641,8 +2925,181 @@ static void _sbus_ifp_invoke_in_ssu_out_ao_done(struct tevent_req *subreq)
     return;
 }
 
+struct _sbus_ifp_invoke_in_ssuu_out_ao_state {
+    struct _sbus_ifp_invoker_args_ssuu in;
+    struct _sbus_ifp_invoker_args_ao out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char *, uint32_t, uint32_t, const char ***);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *, const char *, uint32_t, uint32_t);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char ***);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_ifp_invoke_in_ssuu_out_ao_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_ifp_invoke_in_ssuu_out_ao_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_ifp_invoke_in_ssuu_out_ao_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_ifp_invoke_in_ssuu_out_ao_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_ssuu_out_ao_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = _sbus_ifp_invoker_read_ssuu(state, read_iterator, &state->in);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_ssuu_out_ao_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_ifp_invoke_in_ssuu_out_ao_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_ifp_invoke_in_ssuu_out_ao_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_ssuu_out_ao_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3, &state->out.arg0);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_ssuu_out_ao_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_ifp_invoke_in_ssuu_out_ao_done(struct tevent_req *subreq)
+{
+    struct _sbus_ifp_invoke_in_ssuu_out_ao_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_ssuu_out_ao_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
 struct _sbus_ifp_invoke_in_su_out_ao_state {
-    struct _sbus_ifp_invoker_args_su *in;
+    struct _sbus_ifp_invoker_args_su in;
     struct _sbus_ifp_invoker_args_ao out;
     struct {
         enum sbus_handler_type type;
@@ -2700,15 +3157,7 @@ _sbus_ifp_invoke_in_su_out_ao_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_su);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_su(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_su(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2718,7 +3167,7 @@ _sbus_ifp_invoke_in_su_out_ao_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2760,7 +3209,7 @@ static void _sbus_ifp_invoke_in_su_out_ao_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -2774,7 +3223,7 @@ static void _sbus_ifp_invoke_in_su_out_ao_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2822,8 +3271,181 @@ static void _sbus_ifp_invoke_in_su_out_ao_done(struct tevent_req *subreq)
     return;
 }
 
+struct _sbus_ifp_invoke_in_suu_out_ao_state {
+    struct _sbus_ifp_invoker_args_suu in;
+    struct _sbus_ifp_invoker_args_ao out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, uint32_t, uint32_t, const char ***);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *, uint32_t, uint32_t);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char ***);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_ifp_invoke_in_suu_out_ao_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_ifp_invoke_in_suu_out_ao_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_ifp_invoke_in_suu_out_ao_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_ifp_invoke_in_suu_out_ao_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_ifp_invoke_in_suu_out_ao_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = _sbus_ifp_invoker_read_suu(state, read_iterator, &state->in);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_ifp_invoke_in_suu_out_ao_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_ifp_invoke_in_suu_out_ao_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_ifp_invoke_in_suu_out_ao_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_suu_out_ao_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, &state->out.arg0);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_ifp_invoke_in_suu_out_ao_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_ifp_invoke_in_suu_out_ao_done(struct tevent_req *subreq)
+{
+    struct _sbus_ifp_invoke_in_suu_out_ao_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_ifp_invoke_in_suu_out_ao_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_ifp_invoker_write_ao(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
 struct _sbus_ifp_invoke_in_u_out_o_state {
-    struct _sbus_ifp_invoker_args_u *in;
+    struct _sbus_ifp_invoker_args_u in;
     struct _sbus_ifp_invoker_args_o out;
     struct {
         enum sbus_handler_type type;
@@ -2881,15 +3503,7 @@ _sbus_ifp_invoke_in_u_out_o_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_ifp_invoker_args_u);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_ifp_invoker_read_u(state, read_iterator, state->in);
+    ret = _sbus_ifp_invoker_read_u(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2899,7 +3513,7 @@ _sbus_ifp_invoke_in_u_out_o_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2941,7 +3555,7 @@ static void _sbus_ifp_invoke_in_u_out_o_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -2955,7 +3569,7 @@ static void _sbus_ifp_invoke_in_u_out_o_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -42,11 +42,13 @@
 _sbus_ifp_declare_invoker(, );
 _sbus_ifp_declare_invoker(, ao);
 _sbus_ifp_declare_invoker(, as);
+_sbus_ifp_declare_invoker(, auauasatatatau);
 _sbus_ifp_declare_invoker(, b);
 _sbus_ifp_declare_invoker(, ifp_extra);
 _sbus_ifp_declare_invoker(, o);
 _sbus_ifp_declare_invoker(, s);
 _sbus_ifp_declare_invoker(, u);
+_sbus_ifp_declare_invoker(aoas, ifp_extra_list);
 _sbus_ifp_declare_invoker(s, ao);
 _sbus_ifp_declare_invoker(s, as);
 _sbus_ifp_declare_invoker(s, o);
@@ -54,7 +56,9 @@ _sbus_ifp_declare_invoker(s, s);
 _sbus_ifp_declare_invoker(sas, raw);
 _sbus_ifp_declare_invoker(ss, o);
 _sbus_ifp_declare_invoker(ssu, ao);
+_sbus_ifp_declare_invoker(ssuu, ao);
 _sbus_ifp_declare_invoker(su, ao);
+_sbus_ifp_declare_invoker(suu, ao);
 _sbus_ifp_declare_invoker(u, o);
 
 #endif /* _SBUS_IFP_INVOKERS_H_ */
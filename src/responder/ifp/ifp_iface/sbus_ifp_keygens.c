@@ -72,6 +72,23 @@ _sbus_ifp_key_ssu_0_1_2
         sbus_req->path, args->arg0, args->arg1, args->arg2);
 }
 
+const char *
+_sbus_ifp_key_ssuu_0_1_2_3
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_request *sbus_req,
+    struct _sbus_ifp_invoker_args_ssuu *args)
+{
+    if (sbus_req->sender == NULL) {
+        return talloc_asprintf(mem_ctx, "-:%u:%s.%s:%s:%s:%s:%" PRIu32 ":%" PRIu32 "",
+            sbus_req->type, sbus_req->interface, sbus_req->member,
+            sbus_req->path, args->arg0, args->arg1, args->arg2, args->arg3);
+    }
+
+    return talloc_asprintf(mem_ctx, "%"PRIi64":%u:%s.%s:%s:%s:%s:%" PRIu32 ":%" PRIu32 "",
+        sbus_req->sender->uid, sbus_req->type, sbus_req->interface, sbus_req->member,
+        sbus_req->path, args->arg0, args->arg1, args->arg2, args->arg3);
+}
+
 const char *
 _sbus_ifp_key_su_0_1
    (TALLOC_CTX *mem_ctx,
@@ -89,6 +106,23 @@ _sbus_ifp_key_su_0_1
         sbus_req->path, args->arg0, args->arg1);
 }
 
+const char *
+_sbus_ifp_key_suu_0_1_2
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_request *sbus_req,
+    struct _sbus_ifp_invoker_args_suu *args)
+{
+    if (sbus_req->sender == NULL) {
+        return talloc_asprintf(mem_ctx, "-:%u:%s.%s:%s:%s:%" PRIu32 ":%" PRIu32 "",
+            sbus_req->type, sbus_req->interface, sbus_req->member,
+            sbus_req->path, args->arg0, args->arg1, args->arg2);
+    }
+
+    return talloc_asprintf(mem_ctx, "%"PRIi64":%u:%s.%s:%s:%s:%" PRIu32 ":%" PRIu32 "",
+        sbus_req->sender->uid, sbus_req->type, sbus_req->interface, sbus_req->member,
+        sbus_req->path, args->arg0, args->arg1, args->arg2);
+}
+
 const char *
 _sbus_ifp_key_u_0
    (TALLOC_CTX *mem_ctx,
@@ -42,12 +42,24 @@ _sbus_ifp_key_ssu_0_1_2
     struct sbus_request *sbus_req,
     struct _sbus_ifp_invoker_args_ssu *args);
 
+const char *
+_sbus_ifp_key_ssuu_0_1_2_3
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_request *sbus_req,
+    struct _sbus_ifp_invoker_args_ssuu *args);
+
 const char *
 _sbus_ifp_key_su_0_1
    (TALLOC_CTX *mem_ctx,
     struct sbus_request *sbus_req,
     struct _sbus_ifp_invoker_args_su *args);
 
+const char *
+_sbus_ifp_key_suu_0_1_2
+   (TALLOC_CTX *mem_ctx,
+    struct sbus_request *sbus_req,
+    struct _sbus_ifp_invoker_args_suu *args);
+
 const char *
 _sbus_ifp_key_u_0
    (TALLOC_CTX *mem_ctx,
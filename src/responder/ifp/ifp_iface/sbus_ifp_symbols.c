@@ -193,6 +193,23 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Cache_Object_Store = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Components_GetCommandStats = {
+    .input = (const struct sbus_argument[]){
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "au", .name = "commands"},
+        {.type = "au", .name = "sources"},
+        {.type = "as", .name = "domains"},
+        {.type = "at", .name = "counts"},
+        {.type = "at", .name = "total_usec"},
+        {.type = "at", .name = "max_usec"},
+        {.type = "au", .name = "histograms"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Domains_Domain_ActiveServer = {
     .input = (const struct sbus_argument[]){
@@ -287,6 +304,21 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByDomainAndNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain_name"},
+        {.type = "s", .name = "name_filter"},
+        {.type = "u", .name = "offset"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByName = {
     .input = (const struct sbus_argument[]){
@@ -300,6 +332,20 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_ListByNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "name_filter"},
+        {.type = "u", .name = "offset"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Groups_Group_UpdateMemberList = {
     .input = (const struct sbus_argument[]){
@@ -359,6 +405,19 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_FindByNameAndCertificate = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_GetUsersAttrs = {
+    .input = (const struct sbus_argument[]){
+        {.type = "ao", .name = "paths"},
+        {.type = "as", .name = "attrs"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "aa{sas}", .name = "result"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByCertificate = {
     .input = (const struct sbus_argument[]){
@@ -386,6 +445,21 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByDomainAndNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain_name"},
+        {.type = "s", .name = "name_filter"},
+        {.type = "u", .name = "offset"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByName = {
     .input = (const struct sbus_argument[]){
@@ -399,6 +473,20 @@ _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByName = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_ListByNamePaged = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "name_filter"},
+        {.type = "u", .name = "offset"},
+        {.type = "u", .name = "limit"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "ao", .name = "result"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_ifp_args_org_freedesktop_sssd_infopipe_Users_User_UpdateGroupsList = {
     .input = (const struct sbus_argument[]){
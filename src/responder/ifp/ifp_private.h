@@ -35,6 +35,8 @@
 #include "responder/common/negcache.h"
 #include "responder/ifp/ifp_iface/ifp_iface_async.h"
 
+struct ifp_result_cache;
+
 struct ifp_ctx {
     struct resp_ctx *rctx;
     struct sss_names_ctx *snctx;
@@ -42,6 +44,8 @@ struct ifp_ctx {
     struct sbus_connection *sysbus;
     const char **user_whitelist;
     uint32_t wildcard_limit;
+
+    struct ifp_result_cache *result_cache;
 };
 
 errno_t
@@ -106,6 +110,8 @@ bool ifp_is_user_attr_allowed(struct ifp_ctx *ifp_ctx, const char *attr);
 struct ifp_list_ctx {
     const char *filter;
     uint32_t limit;
+    /* number of matching entries that are not yet skipped */
+    uint32_t offset;
 
     struct sss_domain_info *dom;
     struct ifp_ctx *ctx;
@@ -124,6 +130,10 @@ errno_t ifp_list_ctx_remaining_capacity(struct ifp_list_ctx *list_ctx,
                                         size_t entries,
                                         size_t *_capacity);
 
+size_t ifp_list_ctx_skip(struct ifp_list_ctx *list_ctx, size_t entries);
+
+bool ifp_list_ctx_full(struct ifp_list_ctx *list_ctx);
+
 errno_t ifp_ldb_el_output_name(struct resp_ctx *rctx,
                                struct ldb_message *msg,
                                const char *el_name,
@@ -132,4 +142,19 @@ errno_t ifp_ldb_el_output_name(struct resp_ctx *rctx,
 char *ifp_format_name_attr(TALLOC_CTX *mem_ctx, struct ifp_ctx *ifp_ctx,
                            const char *in_name, struct sss_domain_info *dom);
 
+/* Result cache. */
+
+errno_t ifp_result_cache_init(struct ifp_ctx *ifp_ctx, time_t timeout);
+
+/* Returns data owned by the cache or NULL if there is none. It must be
+ * copied before returning to the main loop. */
+void *ifp_result_cache_get(struct ifp_result_cache *cache, const char *key);
+
+/* The cache takes over data, it is freed if it cannot be cached. */
+void ifp_result_cache_add(struct ifp_result_cache *cache,
+                          const char *key,
+                          void *data);
+
+void ifp_result_cache_flush(struct ifp_result_cache *cache);
+
 #endif /* _IFPSRV_PRIVATE_H_ */
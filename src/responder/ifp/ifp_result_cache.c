@@ -0,0 +1,184 @@
+/*
+    SSSD
+
+    InfoPipe responder - cache of lookup results
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <time.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "responder/ifp/ifp_private.h"
+
+/* Results that are kept at most. */
+#define IFP_RESULT_CACHE_SIZE 1024
+
+struct ifp_result_cache_entry {
+    struct ifp_result_cache_entry *prev;
+    struct ifp_result_cache_entry *next;
+
+    struct ifp_result_cache *cache;
+    time_t expire;
+
+    /* Owned by the entry. */
+    void *data;
+};
+
+struct ifp_result_cache {
+    hash_table_t *table;
+
+    /* Most recently used entry first. */
+    struct ifp_result_cache_entry *entries;
+    struct ifp_result_cache_entry *last;
+    unsigned int num_entries;
+
+    time_t timeout;
+};
+
+static int ifp_result_cache_entry_destructor(struct ifp_result_cache_entry *entry)
+{
+    struct ifp_result_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+errno_t ifp_result_cache_init(struct ifp_ctx *ifp_ctx, time_t timeout)
+{
+    struct ifp_result_cache *cache;
+
+    if (timeout <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Result cache is disabled.\n");
+        return EOK;
+    }
+
+    cache = talloc_zero(ifp_ctx, struct ifp_result_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->timeout = timeout;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Results are cached for %ld seconds\n",
+          (long)timeout);
+
+    ifp_ctx->result_cache = cache;
+
+    return EOK;
+}
+
+void *ifp_result_cache_get(struct ifp_result_cache *cache, const char *key)
+{
+    struct ifp_result_cache_entry *entry;
+
+    if (cache == NULL || key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct ifp_result_cache_entry);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    if (entry->expire < time(NULL)) {
+        talloc_free(entry);
+        return NULL;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    return entry->data;
+}
+
+void ifp_result_cache_add(struct ifp_result_cache *cache,
+                          const char *key,
+                          void *data)
+{
+    struct ifp_result_cache_entry *entry;
+    errno_t ret;
+
+    if (cache == NULL || key == NULL) {
+        talloc_free(data);
+        return;
+    }
+
+    /* An older result of the same lookup is replaced. */
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct ifp_result_cache_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= IFP_RESULT_CACHE_SIZE) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct ifp_result_cache_entry);
+    if (entry == NULL) {
+        talloc_free(data);
+        return;
+    }
+
+    ret = sss_ptr_hash_add(cache->table, key, entry,
+                           struct ifp_result_cache_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        talloc_free(data);
+        return;
+    }
+
+    entry->cache = cache;
+    entry->expire = time(NULL) + cache->timeout;
+    entry->data = talloc_steal(entry, data);
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    talloc_set_destructor(entry, ifp_result_cache_entry_destructor);
+}
+
+void ifp_result_cache_flush(struct ifp_result_cache *cache)
+{
+    if (cache == NULL || cache->num_entries == 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing %u entries of the result cache\n",
+          cache->num_entries);
+
+    while (cache->last != NULL) {
+        talloc_free(cache->last);
+    }
+}
@@ -89,10 +89,13 @@ static int ifp_users_list_copy(struct ifp_list_ctx *list_ctx,
                                struct sss_domain_info *domain,
                                struct ldb_result *result)
 {
-    size_t copy_count, i;
+    size_t copy_count, skip, i;
     errno_t ret;
 
-    ret = ifp_list_ctx_remaining_capacity(list_ctx, result->count, &copy_count);
+    skip = ifp_list_ctx_skip(list_ctx, result->count);
+
+    ret = ifp_list_ctx_remaining_capacity(list_ctx, result->count - skip,
+                                          &copy_count);
     if (ret != EOK) {
         goto done;
     }
@@ -101,7 +104,7 @@ static int ifp_users_list_copy(struct ifp_list_ctx *list_ctx,
         list_ctx->paths[list_ctx->path_count + i] = \
                              ifp_users_build_path_from_msg(list_ctx->paths,
                                                            domain,
-                                                           result->msgs[i]);
+                                                           result->msgs[skip + i]);
         if (list_ctx->paths[list_ctx->path_count + i] == NULL) {
             ret = ENOMEM;
             goto done;
@@ -818,6 +821,19 @@ ifp_users_list_by_name_send(TALLOC_CTX *mem_ctx,
                             struct ifp_ctx *ctx,
                             const char *filter,
                             uint32_t limit)
+{
+    return ifp_users_list_by_name_paged_send(mem_ctx, ev, sbus_req, ctx,
+                                             filter, 0, limit);
+}
+
+struct tevent_req *
+ifp_users_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                  struct tevent_context *ev,
+                                  struct sbus_request *sbus_req,
+                                  struct ifp_ctx *ctx,
+                                  const char *filter,
+                                  uint32_t offset,
+                                  uint32_t limit)
 {
     struct ifp_users_list_by_name_state *state;
     struct tevent_req *req;
@@ -835,6 +851,7 @@ ifp_users_list_by_name_send(TALLOC_CTX *mem_ctx,
         ret = ENOMEM;
         goto done;
     }
+    state->list_ctx->offset = offset;
 
     ret = ifp_users_list_by_name_step(req);
 
@@ -858,7 +875,7 @@ ifp_users_list_by_name_step(struct tevent_req *req)
 
     state = tevent_req_data(req, struct ifp_users_list_by_name_state);
 
-    if (state->list_ctx->dom == NULL) {
+    if (state->list_ctx->dom == NULL || ifp_list_ctx_full(state->list_ctx)) {
         return EOK;
     }
 
@@ -945,6 +962,22 @@ ifp_users_list_by_domain_and_name_send(TALLOC_CTX *mem_ctx,
                                        const char *domain,
                                        const char *filter,
                                        uint32_t limit)
+{
+    return ifp_users_list_by_domain_and_name_paged_send(mem_ctx, ev,
+                                                        sbus_req, ctx,
+                                                        domain, filter,
+                                                        0, limit);
+}
+
+struct tevent_req *
+ifp_users_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                             struct tevent_context *ev,
+                                             struct sbus_request *sbus_req,
+                                             struct ifp_ctx *ctx,
+                                             const char *domain,
+                                             const char *filter,
+                                             uint32_t offset,
+                                             uint32_t limit)
 {
     struct ifp_users_list_by_domain_and_name_state *state;
     struct tevent_req *subreq;
@@ -962,6 +995,7 @@ ifp_users_list_by_domain_and_name_send(TALLOC_CTX *mem_ctx,
         ret = ENOMEM;
         goto done;
     }
+    state->list_ctx->offset = offset;
 
     subreq = cache_req_user_by_filter_send(state->list_ctx, ctx->rctx->ev,
                                             ctx->rctx, CACHE_REQ_ANY_DOM,
@@ -1090,22 +1124,21 @@ done:
 }
 
 static errno_t
-ifp_users_user_get(TALLOC_CTX *mem_ctx,
-                   struct sbus_request *sbus_req,
-                   struct ifp_ctx *ifp_ctx,
-                   struct sss_domain_info **_domain,
-                   struct ldb_message **_user)
+ifp_users_user_get_by_path(TALLOC_CTX *mem_ctx,
+                           struct ifp_ctx *ifp_ctx,
+                           const char *path,
+                           struct sss_domain_info **_domain,
+                           struct ldb_message **_user)
 {
     struct sss_domain_info *domain;
     char *key;
     errno_t ret;
 
-    ret = ifp_users_decompose_path(NULL,
-                                   ifp_ctx->rctx->domains, sbus_req->path,
+    ret = ifp_users_decompose_path(NULL, ifp_ctx->rctx->domains, path,
                                    &domain, &key);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to decompose object path"
-              "[%s] [%d]: %s\n", sbus_req->path, ret, sss_strerror(ret));
+              "[%s] [%d]: %s\n", path, ret, sss_strerror(ret));
         return ret;
     }
 
@@ -1126,6 +1159,17 @@ ifp_users_user_get(TALLOC_CTX *mem_ctx,
     return ret;
 }
 
+static errno_t
+ifp_users_user_get(TALLOC_CTX *mem_ctx,
+                   struct sbus_request *sbus_req,
+                   struct ifp_ctx *ifp_ctx,
+                   struct sss_domain_info **_domain,
+                   struct ldb_message **_user)
+{
+    return ifp_users_user_get_by_path(mem_ctx, ifp_ctx, sbus_req->path,
+                                      _domain, _user);
+}
+
 static errno_t
 ifp_users_get_as_string(TALLOC_CTX *mem_ctx,
                         struct sbus_request *sbus_req,
@@ -1373,7 +1417,9 @@ ifp_users_user_get_groups(TALLOC_CTX *mem_ctx,
     const char *username;
     struct ldb_message *user;
     struct ldb_result *res;
+    const char **cached;
     const char **out;
+    char *key = NULL;
     int num_groups;
     gid_t gid;
     errno_t ret;
@@ -1385,6 +1431,21 @@ ifp_users_user_get_groups(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
+    if (ifp_ctx->result_cache != NULL) {
+        key = talloc_asprintf(tmp_ctx, "paths:%s", sbus_req->path);
+        if (key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        cached = ifp_result_cache_get(ifp_ctx->result_cache, key);
+        if (cached != NULL) {
+            *_out = dup_string_list(mem_ctx, cached);
+            ret = *_out == NULL ? ENOMEM : EOK;
+            goto done;
+        }
+    }
+
     ret = ifp_users_user_get(tmp_ctx, sbus_req, ifp_ctx, &domain, &user);
     if (ret != EOK) {
         return ret;
@@ -1437,6 +1498,11 @@ ifp_users_user_get_groups(TALLOC_CTX *mem_ctx,
         num_groups++;
     }
 
+    if (key != NULL) {
+        ifp_result_cache_add(ifp_ctx->result_cache, key,
+                             dup_string_list(NULL, out));
+    }
+
     *_out = talloc_steal(mem_ctx, out);
 
     ret = EOK;
@@ -1695,3 +1761,228 @@ ifp_cache_object_remove_user(TALLOC_CTX *mem_ctx,
 
     return ret;
 }
+
+static errno_t
+ifp_users_attrs_add(hash_table_t *table,
+                    const char *attr,
+                    const char **values)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = talloc_strdup(table, attr);
+    if (key.str == NULL) {
+        return ENOMEM;
+    }
+
+    value.type = HASH_VALUE_PTR;
+    value.ptr = values;
+
+    hret = hash_enter(table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to insert entry "
+             "into hash table: %d\n", hret);
+        return EIO;
+    }
+
+    return EOK;
+}
+
+/* Reads the requested attributes of one user. The standard attributes come
+ * from the same lookup that the property getters do, the others are read
+ * with one more search. */
+static errno_t
+ifp_users_get_user_attrs(TALLOC_CTX *mem_ctx,
+                         struct ifp_ctx *ifp_ctx,
+                         const char *path,
+                         const char **attrs,
+                         hash_table_t **_table)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *domain;
+    struct ldb_message *user;
+    struct ldb_message *extra_user;
+    struct ldb_message_element *el;
+    hash_table_t *table;
+    const char **missing;
+    const char **values;
+    const char *name;
+    size_t num_missing = 0;
+    errno_t ret;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_hash_create(tmp_ctx, 10, &table);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create hash table!\n");
+        goto done;
+    }
+
+    ret = ifp_users_user_get_by_path(tmp_ctx, ifp_ctx, path, &domain, &user);
+    if (ret != EOK) {
+        /* An unknown user gets an empty set so that the reply matches
+         * the requested paths. */
+        DEBUG(SSSDBG_TRACE_FUNC, "No attributes for %s\n", path);
+        ret = EOK;
+        goto done;
+    }
+
+    for (i = 0; attrs[i] != NULL; i++) {
+        /* Just count number of requested attributes. */
+    }
+
+    missing = talloc_zero_array(tmp_ctx, const char *, i + 1);
+    if (missing == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; attrs[i] != NULL; i++) {
+        if (!ifp_is_user_attr_allowed(ifp_ctx, attrs[i])) {
+            DEBUG(SSSDBG_TRACE_ALL, "Attribute %s is not allowed, "
+                  "skipping...\n", attrs[i]);
+            continue;
+        }
+
+        if (strcmp(attrs[i], SYSDB_NAME) == 0) {
+            name = sss_view_ldb_msg_find_attr_as_string(domain, user,
+                                                        SYSDB_NAME, NULL);
+            if (name == NULL) {
+                continue;
+            }
+
+            values = talloc_zero_array(table, const char *, 2);
+            if (values == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            values[0] = ifp_format_name_attr(values, ifp_ctx, name, domain);
+            if (values[0] == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = ifp_users_attrs_add(table, attrs[i], values);
+            if (ret != EOK) {
+                goto done;
+            }
+            continue;
+        }
+
+        el = sss_view_ldb_msg_find_element(domain, user, attrs[i]);
+        if (el == NULL) {
+            missing[num_missing] = attrs[i];
+            num_missing++;
+            continue;
+        }
+
+        values = sss_ldb_el_to_string_list(table, el);
+        if (values == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = ifp_users_attrs_add(table, attrs[i], values);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    if (num_missing == 0) {
+        ret = EOK;
+        goto done;
+    }
+
+    name = ldb_msg_find_attr_as_string(user, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "A user with no name\n");
+        ret = ERR_INTERNAL;
+        goto done;
+    }
+
+    ret = sysdb_search_user_by_name(tmp_ctx, domain, name, missing,
+                                    &extra_user);
+    if (ret == ENOENT) {
+        ret = EOK;
+        goto done;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to lookup user [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    for (i = 0; missing[i] != NULL; i++) {
+        el = ldb_msg_find_element(extra_user, missing[i]);
+        if (el == NULL) {
+            DEBUG(SSSDBG_TRACE_ALL, "Attribute %s not found, skipping...\n",
+                  missing[i]);
+            continue;
+        }
+
+        values = sss_ldb_el_to_string_list(table, el);
+        if (values == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = ifp_users_attrs_add(table, missing[i], values);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    if (ret == EOK) {
+        *_table = talloc_steal(mem_ctx, table);
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t
+ifp_users_get_users_attrs(TALLOC_CTX *mem_ctx,
+                          struct sbus_request *sbus_req,
+                          struct ifp_ctx *ctx,
+                          const char **paths,
+                          const char **attrs,
+                          hash_table_t ***_out)
+{
+    hash_table_t **tables;
+    errno_t ret;
+    int num_paths;
+    int i;
+
+    for (num_paths = 0; paths[num_paths] != NULL; num_paths++) {
+        /* Just count number of paths. */
+    }
+
+    tables = talloc_zero_array(mem_ctx, hash_table_t *, num_paths + 1);
+    if (tables == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num_paths; i++) {
+        ret = ifp_users_get_user_attrs(tables, ctx, paths[i], attrs,
+                                       &tables[i]);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to read attributes of %s "
+                  "[%d]: %s\n", paths[i], ret, sss_strerror(ret));
+            talloc_free(tables);
+            return ret;
+        }
+    }
+
+    *_out = tables;
+
+    return EOK;
+}
@@ -106,6 +106,15 @@ ifp_users_list_by_name_recv(TALLOC_CTX *mem_ctx,
                             struct tevent_req *req,
                             const char ***_paths);
 
+struct tevent_req *
+ifp_users_list_by_name_paged_send(TALLOC_CTX *mem_ctx,
+                                  struct tevent_context *ev,
+                                  struct sbus_request *sbus_req,
+                                  struct ifp_ctx *ctx,
+                                  const char *filter,
+                                  uint32_t offset,
+                                  uint32_t limit);
+
 struct tevent_req *
 ifp_users_list_by_domain_and_name_send(TALLOC_CTX *mem_ctx,
                                        struct tevent_context *ev,
@@ -120,6 +129,24 @@ ifp_users_list_by_domain_and_name_recv(TALLOC_CTX *mem_ctx,
                                        struct tevent_req *req,
                                        const char ***_paths);
 
+struct tevent_req *
+ifp_users_list_by_domain_and_name_paged_send(TALLOC_CTX *mem_ctx,
+                                             struct tevent_context *ev,
+                                             struct sbus_request *sbus_req,
+                                             struct ifp_ctx *ctx,
+                                             const char *domain,
+                                             const char *filter,
+                                             uint32_t offset,
+                                             uint32_t limit);
+
+errno_t
+ifp_users_get_users_attrs(TALLOC_CTX *mem_ctx,
+                          struct sbus_request *sbus_req,
+                          struct ifp_ctx *ctx,
+                          const char **paths,
+                          const char **attrs,
+                          hash_table_t ***_out);
+
 /* org.freedesktop.sssd.infopipe.Users.User */
 
 struct tevent_req *
@@ -150,6 +150,93 @@ ifp_register_service_iface(struct ifp_ctx *ifp_ctx,
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to register service interface"
               "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return sss_resp_register_stats_iface(rctx);
+}
+
+/* The data provider tells the NSS responder when cached users or groups
+ * change. The same notifications drop the results kept by InfoPipe. */
+static errno_t
+ifp_memorycache_invalidate(TALLOC_CTX *mem_ctx,
+                           struct sbus_request *sbus_req,
+                           struct ifp_ctx *ifp_ctx)
+{
+    ifp_result_cache_flush(ifp_ctx->result_cache);
+
+    return EOK;
+}
+
+static errno_t
+ifp_memorycache_update_initgroups(TALLOC_CTX *mem_ctx,
+                                  struct sbus_request *sbus_req,
+                                  struct ifp_ctx *ifp_ctx,
+                                  const char *user,
+                                  const char *domain,
+                                  uint32_t *groups)
+{
+    DEBUG(SSSDBG_TRACE_LIBS, "Groups of [%s@%s] changed\n", user, domain);
+
+    /* Results are not indexed by user, drop all of them. */
+    ifp_result_cache_flush(ifp_ctx->result_cache);
+
+    return EOK;
+}
+
+static errno_t
+ifp_memorycache_invalidate_group_by_id(TALLOC_CTX *mem_ctx,
+                                       struct sbus_request *sbus_req,
+                                       struct ifp_ctx *ifp_ctx,
+                                       uint32_t gid)
+{
+    ifp_result_cache_flush(ifp_ctx->result_cache);
+
+    return EOK;
+}
+
+static errno_t
+ifp_memorycache_invalidate_batch(TALLOC_CTX *mem_ctx,
+                                 struct sbus_request *sbus_req,
+                                 struct ifp_ctx *ifp_ctx,
+                                 const char *domain,
+                                 struct sss_iface_payload *records,
+                                 uint32_t *_num_users,
+                                 uint32_t *_num_groups)
+{
+    ifp_result_cache_flush(ifp_ctx->result_cache);
+
+    /* InfoPipe has no memory cache records. */
+    *_num_users = 0;
+    *_num_groups = 0;
+
+    return EOK;
+}
+
+static errno_t
+ifp_register_backend_iface(struct sbus_connection *conn,
+                           struct ifp_ctx *ifp_ctx)
+{
+    errno_t ret;
+
+    SBUS_INTERFACE(iface,
+        sssd_nss_MemoryCache,
+        SBUS_METHODS(
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, UpdateInitgroups, ifp_memorycache_update_initgroups, ifp_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllUsers, ifp_memorycache_invalidate, ifp_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllGroups, ifp_memorycache_invalidate, ifp_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllInitgroups, ifp_memorycache_invalidate, ifp_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateGroupById, ifp_memorycache_invalidate_group_by_id, ifp_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateBatch, ifp_memorycache_invalidate_batch, ifp_ctx)
+        ),
+        SBUS_SIGNALS(SBUS_NO_SIGNALS),
+        SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
+    );
+
+    ret = sbus_connection_add_path(conn, SSS_BUS_PATH, &iface);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to register backend interface"
+              "[%d]: %s\n", ret, sss_strerror(ret));
     }
 
     return ret;
@@ -166,6 +253,8 @@ int ifp_process_init(TALLOC_CTX *mem_ctx,
     char *uid_str;
     char *attr_list_str;
     char *wildcard_limit_str;
+    struct be_conn *iter;
+    int result_cache_timeout;
 
     ifp_cmds = get_ifp_cmds();
     ret = sss_process_init(mem_ctx, ev, cdb,
@@ -252,6 +341,29 @@ int ifp_process_init(TALLOC_CTX *mem_ctx,
         }
     }
 
+    ret = confdb_get_int(ifp_ctx->rctx->cdb,
+                         CONFDB_IFP_CONF_ENTRY,
+                         CONFDB_IFP_RESULT_CACHE_TIMEOUT,
+                         5, &result_cache_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to retrieve the result cache timeout\n");
+        goto fail;
+    }
+
+    ret = ifp_result_cache_init(ifp_ctx, result_cache_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Failed to set up the result cache\n");
+        goto fail;
+    }
+
+    for (iter = rctx->be_conns; iter; iter = iter->next) {
+        ret = ifp_register_backend_iface(iter->conn, ifp_ctx);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
     /* Connect to the D-BUS system bus and set up methods */
     ret = sysbus_init(ifp_ctx, ifp_ctx->rctx->ev, IFP_BUS,
                       ifp_ctx, &ifp_ctx->sysbus);
@@ -270,10 +270,34 @@ struct ifp_get_user_attr_state {
     const char *name;
     const char **attrs;
     struct resp_ctx *rctx;
+    struct ifp_result_cache *cache;
+    const char *key;
 
     DBusMessageIter *write_iter;
 };
 
+/* Domain and attributes of a user as returned by GetUserAttr. */
+struct ifp_user_attr_result {
+    struct sss_domain_info *domain;
+    struct ldb_result *res;
+};
+
+static const char *
+ifp_user_attr_cache_key(TALLOC_CTX *mem_ctx,
+                        const char *name,
+                        const char **attrs)
+{
+    char *key;
+    int i;
+
+    key = talloc_asprintf(mem_ctx, "attr:%s", name);
+    for (i = 0; key != NULL && attrs[i] != NULL; i++) {
+        key = talloc_asprintf_append_buffer(key, ":%s", attrs[i]);
+    }
+
+    return key;
+}
+
 static void ifp_get_user_attr_done(struct tevent_req *subreq);
 
 struct tevent_req *
@@ -286,6 +310,7 @@ ifp_get_user_attr_send(TALLOC_CTX *mem_ctx,
                        DBusMessageIter *write_iter)
 {
     struct ifp_get_user_attr_state *state;
+    struct ifp_user_attr_result *cached;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
@@ -302,12 +327,31 @@ ifp_get_user_attr_send(TALLOC_CTX *mem_ctx,
     state->name = name;
     state->attrs = attrs;
     state->rctx = ctx->rctx;
+    state->cache = ctx->result_cache;
     state->write_iter = write_iter;
 
     DEBUG(SSSDBG_FUNC_DATA,
           "Looking up attributes of user [%s] on behalf of %"PRIi64"\n",
           state->name, sbus_req->sender->uid);
 
+    if (state->cache != NULL) {
+        state->key = ifp_user_attr_cache_key(state, name, attrs);
+        if (state->key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        cached = ifp_result_cache_get(state->cache, state->key);
+        if (cached != NULL) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Returning cached attributes of [%s]\n",
+                  name);
+            ret = ifp_get_user_attr_write_reply(state->write_iter,
+                                                state->attrs, state->rctx,
+                                                cached->domain, cached->res);
+            goto done;
+        }
+    }
+
     subreq = ifp_user_get_attr_send(state, ctx->rctx, ctx->rctx->ncache,
                                     SSS_DP_USER, state->name, state->attrs);
     if (subreq == NULL) {
@@ -321,7 +365,10 @@ ifp_get_user_attr_send(TALLOC_CTX *mem_ctx,
     ret = EAGAIN;
 
 done:
-    if (ret != EAGAIN) {
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
         tevent_req_error(req, ret);
         tevent_req_post(req, ev);
     }
@@ -332,6 +379,7 @@ done:
 static void ifp_get_user_attr_done(struct tevent_req *subreq)
 {
     struct ifp_get_user_attr_state *state;
+    struct ifp_user_attr_result *cached;
     struct sss_domain_info *dom;
     struct ldb_result *res;
     struct tevent_req *req;
@@ -358,6 +406,15 @@ static void ifp_get_user_attr_done(struct tevent_req *subreq)
         return;
     }
 
+    if (state->key != NULL) {
+        cached = talloc_zero(NULL, struct ifp_user_attr_result);
+        if (cached != NULL) {
+            cached->domain = dom;
+            cached->res = talloc_steal(cached, res);
+            ifp_result_cache_add(state->cache, state->key, cached);
+        }
+    }
+
     tevent_req_done(req);
     return;
 }
@@ -428,6 +485,8 @@ ifp_user_get_groups_build_reply(TALLOC_CTX *mem_ctx,
 struct ifp_user_get_groups_state {
     struct tevent_context *ev;
     struct resp_ctx *rctx;
+    struct ifp_result_cache *cache;
+    const char *key;
     struct ldb_result *res;
     struct sss_domain_info *domain;
     const char **groupnames;
@@ -445,6 +504,7 @@ ifp_user_get_groups_send(TALLOC_CTX *mem_ctx,
 {
     const char *attrs[] = {SYSDB_MEMBEROF, NULL};
     struct ifp_user_get_groups_state *state;
+    const char **cached;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
@@ -457,11 +517,29 @@ ifp_user_get_groups_send(TALLOC_CTX *mem_ctx,
 
     state->ev = ev;
     state->rctx = ctx->rctx;
+    state->cache = ctx->result_cache;
 
     DEBUG(SSSDBG_FUNC_DATA,
           "Looking up groups of user [%s] on behalf of %"PRIi64"\n",
           name, sbus_req->sender->uid);
 
+    if (state->cache != NULL) {
+        state->key = talloc_asprintf(state, "groups:%s", name);
+        if (state->key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        cached = ifp_result_cache_get(state->cache, state->key);
+        if (cached != NULL) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Returning cached groups of [%s]\n",
+                  name);
+            state->groupnames = dup_string_list(state, cached);
+            ret = state->groupnames == NULL ? ENOMEM : EOK;
+            goto done;
+        }
+    }
+
     subreq = ifp_user_get_attr_send(state, ctx->rctx, ctx->rctx->ncache,
                                     SSS_DP_INITGROUPS, name, attrs);
     if (subreq == NULL) {
@@ -475,7 +553,10 @@ ifp_user_get_groups_send(TALLOC_CTX *mem_ctx,
     ret = EAGAIN;
 
 done:
-    if (ret != EAGAIN) {
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
         tevent_req_error(req, ret);
         tevent_req_post(req, ev);
     }
@@ -542,6 +623,11 @@ static void ifp_user_get_groups_done(struct tevent_req *subreq)
         return;
     }
 
+    if (state->key != NULL) {
+        ifp_result_cache_add(state->cache, state->key,
+                             dup_string_list(NULL, state->groupnames));
+    }
+
     tevent_req_done(req);
 }
 
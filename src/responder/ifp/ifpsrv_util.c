@@ -356,6 +356,23 @@ done:
     return ret;
 }
 
+/* Returns how many of the entries found in the next domain fall before the
+ * requested page and must not be returned. */
+size_t ifp_list_ctx_skip(struct ifp_list_ctx *list_ctx, size_t entries)
+{
+    size_t skip;
+
+    skip = MIN(list_ctx->offset, entries);
+    list_ctx->offset -= skip;
+
+    return skip;
+}
+
+bool ifp_list_ctx_full(struct ifp_list_ctx *list_ctx)
+{
+    return list_ctx->limit != 0 && list_ctx->path_count >= list_ctx->limit;
+}
+
 errno_t ifp_ldb_el_output_name(struct resp_ctx *rctx,
                                struct ldb_message *msg,
                                const char *el_name,
@@ -24,6 +24,7 @@
 #include "util/crypto/sss_crypto.h"
 #include "util/util.h"
 #include "util/sss_krb5.h"
+#include "util/sss_ptr_hash.h"
 #include "responder/kcm/kcmsrv_ccache.h"
 #include "responder/kcm/kcmsrv_ccache_pvt.h"
 #include "responder/kcm/kcmsrv_ccache_be.h"
@@ -204,15 +205,66 @@ struct kcm_cred *kcm_cred_new(TALLOC_CTX *mem_ctx,
     return kcreds;
 }
 
+errno_t kcm_cc_index_cred(struct kcm_ccache *cc, struct kcm_cred *crd)
+{
+    char uuid_str[UUID_STR_SIZE];
+
+    if (cc->cred_index == NULL) {
+        cc->cred_index = sss_ptr_hash_create(cc, NULL, NULL);
+        if (cc->cred_index == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    /* The entry is removed from the index when the credential is freed */
+    uuid_unparse(crd->uuid, uuid_str);
+    return sss_ptr_hash_add_or_override(cc->cred_index, uuid_str, crd,
+                                        struct kcm_cred);
+}
+
 /* Add a cred to ccache */
 errno_t kcm_cc_store_creds(struct kcm_ccache *cc,
                            struct kcm_cred *crd)
 {
-    DLIST_ADD(cc->creds, crd);
+    errno_t ret;
+
     talloc_steal(cc, crd);
+
+    ret = kcm_cc_index_cred(cc, crd);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot index the credential [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    DLIST_ADD(cc->creds, crd);
     return EOK;
 }
 
+struct kcm_cred *kcm_cc_find_cred(struct kcm_ccache *cc, uuid_t uuid)
+{
+    char uuid_str[UUID_STR_SIZE];
+    struct kcm_cred *crd;
+
+    if (cc == NULL) {
+        return NULL;
+    }
+
+    if (cc->cred_index != NULL) {
+        uuid_unparse(uuid, uuid_str);
+        return sss_ptr_hash_lookup(cc->cred_index, uuid_str, struct kcm_cred);
+    }
+
+    DLIST_FOR_EACH(crd, cc->creds) {
+        if (uuid_compare(crd->uuid, uuid) == 0) {
+            return crd;
+        }
+    }
+
+    return NULL;
+}
+
 errno_t kcm_cred_get_uuid(struct kcm_cred *crd, uuid_t _uuid)
 {
     if (crd == NULL) {
@@ -102,6 +102,9 @@ errno_t kcm_cc_store_creds(struct kcm_ccache *cc,
 
 errno_t kcm_cred_get_uuid(struct kcm_cred *crd, uuid_t uuid);
 
+/* Returns the credential with the given UUID or NULL */
+struct kcm_cred *kcm_cc_find_cred(struct kcm_ccache *cc, uuid_t uuid);
+
 /*
  * At the moment, the credentials are stored without unmarshalling
  * them, just as the clients sends the credentials.
@@ -345,4 +348,21 @@ errno_t kcm_ccache_to_sec_input(TALLOC_CTX *mem_ctx,
                                 struct cli_creds *client,
                                 struct sss_iobuf **_payload);
 
+/*
+ * The compact binary format is used by the libsss_secrets back end,
+ * sec_value_is_binary() tells it apart from the JSON format.
+ */
+bool sec_value_is_binary(struct sss_iobuf *sec_value);
+
+errno_t sec_kv_to_ccache_binary(TALLOC_CTX *mem_ctx,
+                                const char *sec_key,
+                                struct sss_iobuf *sec_value,
+                                struct cli_creds *client,
+                                struct kcm_ccache **_cc);
+
+errno_t kcm_ccache_to_sec_input_binary(TALLOC_CTX *mem_ctx,
+                                       struct kcm_ccache *cc,
+                                       struct cli_creds *client,
+                                       struct sss_iobuf **_payload);
+
 #endif /* _KCMSRV_CCACHE_H_ */
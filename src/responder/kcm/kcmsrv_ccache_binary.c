@@ -0,0 +1,581 @@
+/*
+   SSSD
+
+   KCM Server - compact binary (un)marshalling for storing ccaches in
+                libsss_secrets
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/util_creds.h"
+#include "util/sss_endian.h"
+#include "util/sss_iobuf.h"
+#include "responder/kcm/kcmsrv_ccache_pvt.h"
+
+/*
+ * The binary format is versioned as well. The version is the first
+ * item, stored in network byte order, so the first byte is always
+ * zero while a JSON object always starts with '{'.
+ *
+ * All numbers are 32 bits long and stored in network byte order:
+ *
+ *      version
+ *      kdc_offset
+ *      principal present (0 or 1)
+ *      [ principal type
+ *        realm length, realm
+ *        number of components
+ *        [ component length, component ] ... ]
+ *      number of credentials
+ *      [ credential UUID (16 bytes) ] ...
+ *      [ credential length, credential ] ...
+ *
+ * The UUIDs of all credentials come before the credentials themselves,
+ * in the same order.
+ */
+#define KS_BINARY_VERSION   1
+
+bool sec_value_is_binary(struct sss_iobuf *sec_value)
+{
+    uint8_t *data;
+
+    data = sss_iobuf_get_data(sec_value);
+    if (data == NULL || sss_iobuf_get_size(sec_value) < sizeof(uint32_t)) {
+        return false;
+    }
+
+    return data[0] == 0;
+}
+
+static size_t krb5_data_binary_size(const krb5_data *data)
+{
+    return sizeof(uint32_t) + data->length;
+}
+
+static size_t ccache_binary_size(struct kcm_ccache *cc)
+{
+    struct kcm_cred *crd;
+    size_t size;
+
+    /* version, kdc_offset, principal present, number of creds */
+    size = 4 * sizeof(uint32_t);
+
+    if (cc->client != NULL) {
+        /* type, number of components */
+        size += 2 * sizeof(uint32_t);
+        size += krb5_data_binary_size(&cc->client->realm);
+        for (krb5_int32 i = 0; i < cc->client->length; i++) {
+            size += krb5_data_binary_size(&cc->client->data[i]);
+        }
+    }
+
+    DLIST_FOR_EACH(crd, cc->creds) {
+        size += sizeof(uuid_t) + sizeof(uint32_t);
+        size += sss_iobuf_get_size(crd->cred_blob);
+    }
+
+    return size;
+}
+
+static errno_t write_blob(struct sss_iobuf *buf,
+                          uint8_t *data,
+                          size_t len)
+{
+    errno_t ret;
+
+    if (len > UINT32_MAX) {
+        return EINVAL;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, htobe32(len));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (len == 0) {
+        return EOK;
+    }
+
+    return sss_iobuf_write_len(buf, data, len);
+}
+
+static errno_t princ_to_binary(struct sss_iobuf *buf,
+                               krb5_principal princ)
+{
+    errno_t ret;
+
+    if (princ == NULL) {
+        return sss_iobuf_write_uint32(buf, htobe32(0));
+    }
+
+    ret = sss_iobuf_write_uint32(buf, htobe32(1));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_iobuf_write_int32(buf, htobe32(princ->type));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = write_blob(buf, (uint8_t *) princ->realm.data, princ->realm.length);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, htobe32(princ->length));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (krb5_int32 i = 0; i < princ->length; i++) {
+        ret = write_blob(buf, (uint8_t *) princ->data[i].data,
+                         princ->data[i].length);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t creds_to_binary(struct sss_iobuf *buf,
+                               struct kcm_cred *creds)
+{
+    struct kcm_cred *crd;
+    uint32_t count = 0;
+    errno_t ret;
+
+    DLIST_FOR_EACH(crd, creds) {
+        count++;
+    }
+
+    ret = sss_iobuf_write_uint32(buf, htobe32(count));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    DLIST_FOR_EACH(crd, creds) {
+        ret = sss_iobuf_write_len(buf, crd->uuid, sizeof(uuid_t));
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    DLIST_FOR_EACH(crd, creds) {
+        ret = write_blob(buf,
+                         sss_iobuf_get_data(crd->cred_blob),
+                         sss_iobuf_get_size(crd->cred_blob));
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+errno_t kcm_ccache_to_sec_input_binary(TALLOC_CTX *mem_ctx,
+                                       struct kcm_ccache *cc,
+                                       struct cli_creds *client,
+                                       struct sss_iobuf **_payload)
+{
+    struct sss_iobuf *payload;
+    size_t size;
+    errno_t ret;
+
+    /* The size is known upfront, so the buffer is allocated only once and
+     * its size is exactly the size of the payload. */
+    size = ccache_binary_size(cc);
+
+    payload = sss_iobuf_init_empty(mem_ctx, size, size);
+    if (payload == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_iobuf_write_uint32(payload, htobe32(KS_BINARY_VERSION));
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_iobuf_write_int32(payload, htobe32(cc->kdc_offset));
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = princ_to_binary(payload, cc->client);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot convert principal of %s [%d]: %s\n",
+              cc->name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = creds_to_binary(payload, cc->creds);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot convert credentials of %s [%d]: %s\n",
+              cc->name, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = EOK;
+    *_payload = payload;
+
+done:
+    if (ret != EOK) {
+        talloc_free(payload);
+    }
+    return ret;
+}
+
+/*
+ * ccache unmarshalling from the binary format
+ */
+static errno_t read_uint32(struct sss_iobuf *buf, uint32_t *_val)
+{
+    uint32_t val;
+    errno_t ret;
+
+    ret = sss_iobuf_read_uint32(buf, &val);
+    if (ret != EOK) {
+        return EINVAL;
+    }
+
+    *_val = be32toh(val);
+    return EOK;
+}
+
+static errno_t read_blob(TALLOC_CTX *mem_ctx,
+                         struct sss_iobuf *buf,
+                         uint8_t **_data,
+                         uint32_t *_len)
+{
+    uint8_t *data;
+    uint32_t len;
+    errno_t ret;
+
+    ret = read_uint32(buf, &len);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* Do not trust the length before allocating a buffer for it. */
+    if (len > sss_iobuf_get_size(buf) - sss_iobuf_get_len(buf)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Truncated binary ccache\n");
+        return EINVAL;
+    }
+
+    /* One more byte so that strings are always terminated. */
+    data = talloc_zero_array(mem_ctx, uint8_t, len + 1);
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_iobuf_read_len(buf, len, data);
+    if (ret != EOK) {
+        talloc_free(data);
+        return EINVAL;
+    }
+
+    *_data = data;
+    *_len = len;
+    return EOK;
+}
+
+static errno_t read_krb5_data(TALLOC_CTX *mem_ctx,
+                              struct sss_iobuf *buf,
+                              krb5_data *data)
+{
+    uint8_t *blob;
+    uint32_t len;
+    errno_t ret;
+
+    ret = read_blob(mem_ctx, buf, &blob, &len);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    data->magic = 0;
+    data->data = (char *) blob;
+    data->length = len;
+    return EOK;
+}
+
+static errno_t binary_to_princ(TALLOC_CTX *mem_ctx,
+                               struct sss_iobuf *buf,
+                               krb5_principal *_princ)
+{
+    krb5_principal princ;
+    uint32_t present;
+    uint32_t type;
+    uint32_t count;
+    errno_t ret;
+
+    ret = read_uint32(buf, &present);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (present == 0) {
+        *_princ = NULL;
+        return EOK;
+    }
+
+    princ = talloc_zero(mem_ctx, struct krb5_principal_data);
+    if (princ == NULL) {
+        return ENOMEM;
+    }
+    princ->magic = KV5M_PRINCIPAL;
+
+    ret = read_uint32(buf, &type);
+    if (ret != EOK) {
+        goto done;
+    }
+    princ->type = (krb5_int32) type;
+
+    ret = read_krb5_data(princ, buf, &princ->realm);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = read_uint32(buf, &count);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* Every component takes at least its length. */
+    if (count > INT32_MAX
+            || count > (sss_iobuf_get_size(buf) - sss_iobuf_get_len(buf))
+                       / sizeof(uint32_t)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid number of components\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (count > 0) {
+        princ->data = talloc_zero_array(princ, krb5_data, count);
+        if (princ->data == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ret = read_krb5_data(princ->data, buf, &princ->data[i]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+    princ->length = (krb5_int32) count;
+
+    ret = EOK;
+    *_princ = princ;
+
+done:
+    if (ret != EOK) {
+        talloc_free(princ);
+    }
+    return ret;
+}
+
+static errno_t binary_to_creds(struct kcm_ccache *cc,
+                               struct sss_iobuf *buf)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_iobuf *cred_blob;
+    struct kcm_cred *crd;
+    uuid_t *uuids;
+    uint8_t *data;
+    uint32_t count;
+    uint32_t len;
+    errno_t ret;
+
+    ret = read_uint32(buf, &count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* Every credential takes at least its UUID and its length. */
+    if (count > (sss_iobuf_get_size(buf) - sss_iobuf_get_len(buf))
+                / (sizeof(uuid_t) + sizeof(uint32_t))) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid number of credentials\n");
+        return EINVAL;
+    }
+
+    if (count == 0) {
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    uuids = talloc_array(tmp_ctx, uuid_t, count);
+    if (uuids == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ret = sss_iobuf_read_len(buf, sizeof(uuid_t), uuids[i]);
+        if (ret != EOK) {
+            ret = EINVAL;
+            goto done;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ret = read_blob(tmp_ctx, buf, &data, &len);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        cred_blob = sss_iobuf_init_readonly(tmp_ctx, data, len);
+        talloc_free(data);
+        if (cred_blob == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        crd = kcm_cred_new(cc, uuids[i], cred_blob);
+        if (crd == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = kcm_cc_index_cred(cc, crd);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        /* Keep the order of the credentials. */
+        DLIST_ADD_END(cc->creds, crd, struct kcm_cred *);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sec_kv_to_ccache_binary(TALLOC_CTX *mem_ctx,
+                                const char *sec_key,
+                                struct sss_iobuf *sec_value,
+                                struct cli_creds *client,
+                                struct kcm_ccache **_cc)
+{
+    struct kcm_ccache *cc = NULL;
+    struct sss_iobuf *buf;
+    TALLOC_CTX *tmp_ctx;
+    const char *name;
+    uint32_t version;
+    uint32_t kdc_offset;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(mem_ctx);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* Read from a private buffer so that the caller's one is not
+     * consumed. */
+    buf = sss_iobuf_init_readonly(tmp_ctx, sss_iobuf_get_data(sec_value),
+                                  sss_iobuf_get_size(sec_value));
+    if (buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    cc = talloc_zero(tmp_ctx, struct kcm_ccache);
+    if (cc == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* We rely on the secrets database only searching the user's subtree
+     * so we set the ownership to the client
+     */
+    cc->owner.uid = cli_creds_get_uid(client);
+    cc->owner.gid = cli_creds_get_gid(client);
+
+    name = sec_key_get_name(sec_key);
+    if (name == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    cc->name = talloc_strdup(cc, name);
+    if (cc->name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sec_key_get_uuid(sec_key, cc->uuid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot parse secret key [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = read_uint32(buf, &version);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (version != KS_BINARY_VERSION) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Expected version %d, received version %"PRIu32"\n",
+              KS_BINARY_VERSION, version);
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = read_uint32(buf, &kdc_offset);
+    if (ret != EOK) {
+        goto done;
+    }
+    cc->kdc_offset = (int32_t) kdc_offset;
+
+    ret = binary_to_princ(cc, buf, &cc->client);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot read the principal [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = binary_to_creds(cc, buf);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot read the credentials [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = EOK;
+    *_cc = talloc_steal(mem_ctx, cc);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
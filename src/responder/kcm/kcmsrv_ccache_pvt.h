@@ -23,6 +23,8 @@
 #ifndef _KCMSRV_CCACHE_PVT_H
 #define _KCMSRV_CCACHE_PVT_H
 
+#include <dhash.h>
+
 #include "responder/kcm/kcmsrv_ccache.h"
 #include "responder/kcm/kcmsrv_ccache_be.h"
 
@@ -57,6 +59,12 @@ struct kcm_ccache {
     int32_t kdc_offset;
 
     struct kcm_cred *creds;
+    /* UUID string:kcm_cred, shared by shallow copies of the ccache */
+    hash_table_t *cred_index;
 };
 
+/* Adds the credential to the UUID index of the ccache, the credential
+ * must be linked to the ccache by the caller. */
+errno_t kcm_cc_index_cred(struct kcm_ccache *cc, struct kcm_cred *crd);
+
 #endif /* _KCMSRV_CCACHE_PVT_H */
@@ -25,6 +25,7 @@
 #include <stdio.h>
 
 #include "util/util.h"
+#include "util/dlinklist.h"
 #include "util/secrets/secrets.h"
 #include "util/crypto/sss_crypto.h"
 #include "responder/kcm/kcmsrv_ccache_pvt.h"
@@ -35,6 +36,10 @@
 #define KCM_SECDB_CCACHE_FMT  KCM_SECDB_BASE_FMT"ccache/"
 #define KCM_SECDB_DFL_FMT     KCM_SECDB_BASE_FMT"default"
 
+/* Modified ccaches are written back to the database after this many
+ * seconds, so that a burst of modifications results in a single write. */
+#define KCM_SECDB_FLUSH_DELAY 1
+
 static errno_t sec_get_b64(TALLOC_CTX *mem_ctx,
                            struct sss_sec_req *req,
                            struct sss_iobuf **_buf)
@@ -206,7 +211,7 @@ static errno_t kcm_ccache_to_secdb_kv(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = kcm_ccache_to_sec_input(mem_ctx, cc, client, &payload);
+    ret = kcm_ccache_to_sec_input_binary(mem_ctx, cc, client, &payload);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Cannot convert ccache to a secret [%d][%s]\n", ret, sss_strerror(ret));
@@ -222,8 +227,47 @@ done:
     return ret;
 }
 
+/* ccaches that were read or modified are kept in memory, the in-memory
+ * copy is authoritative and modifications are only written back to the
+ * database later. New ccaches, deletions and the default ccache are
+ * written directly to the database. */
+struct ccdb_secdb_cache_entry {
+    struct ccdb_secdb_cache_entry *prev;
+    struct ccdb_secdb_cache_entry *next;
+
+    struct ccdb_secdb *secdb;
+    struct cli_creds *client;
+    char *secdb_key;
+    struct kcm_ccache *cc;
+    bool dirty;
+};
+
+/* Per-UID copy of the list of ccache keys and of the default ccache, so
+ * that listing the collection does not need to read the database. Both
+ * are loaded on the first access and updated or dropped by the
+ * operations that change them. */
+struct ccdb_secdb_uid_meta {
+    struct ccdb_secdb_uid_meta *prev;
+    struct ccdb_secdb_uid_meta *next;
+
+    uid_t uid;
+
+    char **keys;
+    size_t nkeys;
+    bool keys_valid;
+
+    uuid_t dfl_uuid;
+    bool dfl_valid;
+};
+
 struct ccdb_secdb {
     struct sss_sec_ctx *sctx;
+
+    struct tevent_context *ev;
+    struct ccdb_secdb_cache_entry *cache;
+    struct tevent_timer *flush_te;
+
+    struct ccdb_secdb_uid_meta *meta;
 };
 
 /* Since with the synchronous database, the database operations are just
@@ -365,161 +409,508 @@ done:
     return ret;
 }
 
+static struct ccdb_secdb_uid_meta *secdb_meta_get(struct ccdb_secdb *secdb,
+                                                  struct cli_creds *client)
+{
+    struct ccdb_secdb_uid_meta *meta;
+    uid_t uid = cli_creds_get_uid(client);
+
+    DLIST_FOR_EACH(meta, secdb->meta) {
+        if (meta->uid == uid) {
+            return meta;
+        }
+    }
+
+    meta = talloc_zero(secdb, struct ccdb_secdb_uid_meta);
+    if (meta == NULL) {
+        return NULL;
+    }
+    meta->uid = uid;
+
+    DLIST_ADD(secdb->meta, meta);
+    return meta;
+}
+
+/* Must be called after every change of the ccache container of the
+ * client. */
+static void secdb_meta_invalidate_keys(struct ccdb_secdb *secdb,
+                                       struct cli_creds *client)
+{
+    struct ccdb_secdb_uid_meta *meta;
+
+    DLIST_FOR_EACH(meta, secdb->meta) {
+        if (meta->uid == cli_creds_get_uid(client)) {
+            talloc_zfree(meta->keys);
+            meta->nkeys = 0;
+            meta->keys_valid = false;
+            return;
+        }
+    }
+}
+
+/* The returned keys are owned by the cache and are only valid until the
+ * ccache container of the client is changed. */
+static errno_t secdb_meta_get_keys(struct ccdb_secdb *secdb,
+                                   struct cli_creds *client,
+                                   char ***_keys,
+                                   size_t *_nkeys)
+{
+    struct ccdb_secdb_uid_meta *meta;
+    struct sss_sec_req *sreq = NULL;
+    char **keys = NULL;
+    size_t nkeys;
+    errno_t ret;
+
+    meta = secdb_meta_get(secdb, client);
+    if (meta == NULL) {
+        return ENOMEM;
+    }
+
+    if (meta->keys_valid) {
+        *_keys = meta->keys;
+        *_nkeys = meta->nkeys;
+        return EOK;
+    }
+
+    ret = secdb_container_url_req(meta, secdb->sctx, client, &sreq);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_sec_list(meta, sreq, &keys, &nkeys);
+    talloc_free(sreq);
+    if (ret == ENOENT) {
+        keys = NULL;
+        nkeys = 0;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    meta->keys = keys;
+    meta->nkeys = nkeys;
+    meta->keys_valid = true;
+
+    *_keys = meta->keys;
+    *_nkeys = meta->nkeys;
+    return EOK;
+}
+
 static errno_t key_by_uuid(TALLOC_CTX *mem_ctx,
-                           struct sss_sec_ctx *sctx,
+                           struct ccdb_secdb *secdb,
                            struct cli_creds *client,
                            uuid_t uuid,
                            char **_key)
 {
-    TALLOC_CTX *tmp_ctx;
     errno_t ret;
-    char *key_match = NULL;
     char **keys = NULL;
     size_t nkeys;
+    char *key;
+
+    ret = secdb_meta_get_keys(secdb, client, &keys, &nkeys);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (size_t i = 0; i < nkeys; i++) {
+        if (sec_key_match_uuid(keys[i], uuid)) {
+            DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", keys[i]);
+            key = talloc_strdup(mem_ctx, keys[i]);
+            if (key == NULL) {
+                return ENOMEM;
+            }
+
+            *_key = key;
+            return EOK;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
+    return ENOENT;
+}
+
+static errno_t key_by_name(TALLOC_CTX *mem_ctx,
+                           struct ccdb_secdb *secdb,
+                           struct cli_creds *client,
+                           const char *name,
+                           char **_key)
+{
+    errno_t ret;
+    char **keys = NULL;
+    size_t nkeys;
+    char *key;
+
+    ret = secdb_meta_get_keys(secdb, client, &keys, &nkeys);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (size_t i = 0; i < nkeys; i++) {
+        if (sec_key_match_name(keys[i], name)) {
+            DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", keys[i]);
+            key = talloc_strdup(mem_ctx, keys[i]);
+            if (key == NULL) {
+                return ENOMEM;
+            }
+
+            *_key = key;
+            return EOK;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
+    return ENOENT;
+}
+
+static errno_t secdb_get_cc(TALLOC_CTX *mem_ctx,
+                            struct sss_sec_ctx *sctx,
+                            const char *secdb_key,
+                            struct cli_creds *client,
+                            struct kcm_ccache **_cc)
+{
+    errno_t ret;
+    TALLOC_CTX *tmp_ctx = NULL;
+    struct kcm_ccache *cc = NULL;
     struct sss_sec_req *sreq = NULL;
+    struct sss_iobuf *ccbuf;
 
     tmp_ctx = talloc_new(mem_ctx);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_container_url_req(tmp_ctx, sctx, client, &sreq);
+    ret = secdb_cc_key_req(tmp_ctx, sctx, client, secdb_key, &sreq);
     if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot create secdb request [%d][%s]\n", ret, sss_strerror(ret));
         goto done;
     }
 
-    ret = sss_sec_list(tmp_ctx, sreq, &keys, &nkeys);
-    if (ret == ENOENT) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "The container was not found\n");
-        goto done;
-    } else if (ret != EOK) {
+    ret = sec_get_b64(tmp_ctx, sreq, &ccbuf);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the secret [%d][%s]\n", ret, sss_strerror(ret));
         goto done;
     }
 
-    for (size_t i = 0; i < nkeys; i++) {
-        if (sec_key_match_uuid(keys[i], uuid)) {
-            key_match = keys[i];
-            break;
+    if (sec_value_is_binary(ccbuf)) {
+        ret = sec_kv_to_ccache_binary(tmp_ctx, secdb_key, ccbuf, client, &cc);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot convert binary keyval to ccache blob [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+    } else {
+        ret = sec_kv_to_ccache(tmp_ctx,
+                               secdb_key,
+                               (const char *) sss_iobuf_get_data(ccbuf),
+                               client,
+                               &cc);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot convert JSON keyval to ccache blob [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
         }
-    }
 
-    if (key_match == NULL) {
-        DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
-        ret = ENOENT;
-        goto done;
+        /* ccaches written by older versions are converted to the binary
+         * format the first time they are read. */
+        ret = kcm_ccache_to_sec_input_binary(tmp_ctx, cc, client, &ccbuf);
+        if (ret == EOK) {
+            ret = sec_update_b64(tmp_ctx, sreq, ccbuf);
+        }
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot convert ccache %s to the binary format, "
+                  "keeping JSON [%d]: %s\n", cc->name, ret, sss_strerror(ret));
+        } else {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Converted ccache %s to the binary format\n", cc->name);
+        }
     }
 
     ret = EOK;
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", key_match);
-    *_key = talloc_steal(mem_ctx, key_match);
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Fetched the ccache\n");
+    *_cc = talloc_steal(mem_ctx, cc);
 done:
     talloc_free(tmp_ctx);
     return ret;
 }
 
-static errno_t key_by_name(TALLOC_CTX *mem_ctx,
-                           struct sss_sec_ctx *sctx,
-                           struct cli_creds *client,
-                           const char *name,
-                           char **_key)
+static int secdb_cache_entry_destructor(struct ccdb_secdb_cache_entry *entry)
+{
+    DLIST_REMOVE(entry->secdb->cache, entry);
+    return 0;
+}
+
+static struct ccdb_secdb_cache_entry *
+secdb_cache_find_by_uuid(struct ccdb_secdb *secdb,
+                         struct cli_creds *client,
+                         uuid_t uuid)
 {
+    struct ccdb_secdb_cache_entry *entry;
+
+    DLIST_FOR_EACH(entry, secdb->cache) {
+        if (cli_creds_get_uid(entry->client) == cli_creds_get_uid(client)
+                && uuid_compare(entry->cc->uuid, uuid) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static struct ccdb_secdb_cache_entry *
+secdb_cache_find_by_name(struct ccdb_secdb *secdb,
+                         struct cli_creds *client,
+                         const char *name)
+{
+    struct ccdb_secdb_cache_entry *entry;
+
+    DLIST_FOR_EACH(entry, secdb->cache) {
+        if (cli_creds_get_uid(entry->client) == cli_creds_get_uid(client)
+                && strcmp(entry->cc->name, name) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static errno_t secdb_cache_add(struct ccdb_secdb *secdb,
+                               struct cli_creds *client,
+                               char *secdb_key,
+                               struct kcm_ccache *cc,
+                               struct ccdb_secdb_cache_entry **_entry)
+{
+    struct ccdb_secdb_cache_entry *entry;
+
+    entry = talloc_zero(secdb, struct ccdb_secdb_cache_entry);
+    if (entry == NULL) {
+        return ENOMEM;
+    }
+
+    entry->client = talloc_memdup(entry, client, sizeof(struct cli_creds));
+    if (entry->client == NULL) {
+        talloc_free(entry);
+        return ENOMEM;
+    }
+    /* Only the UID is needed to address the ccache, the SELinux context
+     * belongs to the client connection. */
+    entry->client->selinux_ctx = NULL;
+
+    entry->secdb = secdb;
+    entry->secdb_key = talloc_steal(entry, secdb_key);
+    entry->cc = talloc_steal(entry, cc);
+
+    DLIST_ADD(secdb->cache, entry);
+    talloc_set_destructor(entry, secdb_cache_entry_destructor);
+
+    *_entry = entry;
+    return EOK;
+}
+
+/* Returns the cached ccache, reading it from the database on the first
+ * access. */
+static errno_t secdb_cache_get_by_uuid(struct ccdb_secdb *secdb,
+                                       struct cli_creds *client,
+                                       uuid_t uuid,
+                                       struct ccdb_secdb_cache_entry **_entry)
+{
+    struct ccdb_secdb_cache_entry *entry;
+    struct kcm_ccache *cc = NULL;
+    char *secdb_key = NULL;
     TALLOC_CTX *tmp_ctx;
     errno_t ret;
-    char *key_match = NULL;
-    char **keys = NULL;
-    size_t nkeys;
-    struct sss_sec_req *sreq = NULL;
 
-    tmp_ctx = talloc_new(mem_ctx);
+    entry = secdb_cache_find_by_uuid(secdb, client, uuid);
+    if (entry != NULL) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Found ccache %s in memory\n",
+              entry->cc->name);
+        *_entry = entry;
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_container_url_req(tmp_ctx, sctx, client, &sreq);
+    ret = key_by_uuid(tmp_ctx, secdb, client, uuid, &secdb_key);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sss_sec_list(tmp_ctx, sreq, &keys, &nkeys);
-    if (ret == ENOENT) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "The container was not found\n");
-        goto done;
-    } else if (ret != EOK) {
+    ret = secdb_get_cc(tmp_ctx, secdb->sctx, secdb_key, client, &cc);
+    if (ret != EOK) {
         goto done;
     }
 
-    for (size_t i = 0; i < nkeys; i++) {
-        if (sec_key_match_name(keys[i], name)) {
-            key_match = keys[i];
-            break;
-        }
+    ret = secdb_cache_add(secdb, client, secdb_key, cc, _entry);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t secdb_cache_get_by_name(struct ccdb_secdb *secdb,
+                                       struct cli_creds *client,
+                                       const char *name,
+                                       struct ccdb_secdb_cache_entry **_entry)
+{
+    struct ccdb_secdb_cache_entry *entry;
+    struct kcm_ccache *cc = NULL;
+    char *secdb_key = NULL;
+    TALLOC_CTX *tmp_ctx;
+    errno_t ret;
+
+    entry = secdb_cache_find_by_name(secdb, client, name);
+    if (entry != NULL) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Found ccache %s in memory\n", name);
+        *_entry = entry;
+        return EOK;
     }
 
-    if (key_match == NULL) {
-        DEBUG(SSSDBG_TRACE_INTERNAL, "No key matched\n");
-        ret = ENOENT;
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = key_by_name(tmp_ctx, secdb, client, name, &secdb_key);
+    if (ret != EOK) {
         goto done;
     }
 
-    ret = EOK;
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Found key %s\n", key_match);
-    *_key = talloc_steal(mem_ctx, key_match);
+    ret = secdb_get_cc(tmp_ctx, secdb->sctx, secdb_key, client, &cc);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = secdb_cache_add(secdb, client, secdb_key, cc, _entry);
+
 done:
     talloc_free(tmp_ctx);
     return ret;
 }
 
-static errno_t secdb_get_cc(TALLOC_CTX *mem_ctx,
-                            struct sss_sec_ctx *sctx,
-                            const char *secdb_key,
-                            struct cli_creds *client,
-                            struct kcm_ccache **_cc)
+/* Callers get a shallow copy, just like with the memory back end. */
+static struct kcm_ccache *secdb_cache_dup(TALLOC_CTX *mem_ctx,
+                                          struct kcm_ccache *in)
 {
-    errno_t ret;
-    TALLOC_CTX *tmp_ctx = NULL;
-    struct kcm_ccache *cc = NULL;
+    struct kcm_ccache *out;
+
+    out = talloc_zero(mem_ctx, struct kcm_ccache);
+    if (out == NULL) {
+        return NULL;
+    }
+    memcpy(out, in, sizeof(struct kcm_ccache));
+
+    return out;
+}
+
+static errno_t secdb_cache_write(struct ccdb_secdb_cache_entry *entry)
+{
+    struct sss_iobuf *payload = NULL;
     struct sss_sec_req *sreq = NULL;
-    struct sss_iobuf *ccbuf;
+    TALLOC_CTX *tmp_ctx;
+    errno_t ret;
 
-    tmp_ctx = talloc_new(mem_ctx);
+    tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
         return ENOMEM;
     }
 
-    ret = secdb_cc_key_req(tmp_ctx, sctx, client, secdb_key, &sreq);
+    ret = kcm_ccache_to_sec_input_binary(tmp_ctx, entry->cc, entry->client,
+                                         &payload);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot create secdb request [%d][%s]\n", ret, sss_strerror(ret));
         goto done;
     }
 
-    ret = sec_get_b64(tmp_ctx, sreq, &ccbuf);
+    ret = secdb_cc_key_req(tmp_ctx, entry->secdb->sctx, entry->client,
+                           entry->secdb_key, &sreq);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot get the secret [%d][%s]\n", ret, sss_strerror(ret));
         goto done;
     }
 
-    ret = sec_kv_to_ccache(tmp_ctx,
-                           secdb_key,
-                           (const char *) sss_iobuf_get_data(ccbuf),
-                           client,
-                           &cc);
+    ret = sec_update_b64(tmp_ctx, sreq, payload);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot convert JSON keyval to ccache blob [%d]: %s\n",
-              ret, sss_strerror(ret));
         goto done;
     }
 
+    entry->dirty = false;
     ret = EOK;
-    DEBUG(SSSDBG_TRACE_INTERNAL, "Fetched the ccache\n");
-    *_cc = talloc_steal(mem_ctx, cc);
+
 done:
     talloc_free(tmp_ctx);
     return ret;
 }
 
+static void secdb_cache_flush(struct ccdb_secdb *secdb)
+{
+    struct ccdb_secdb_cache_entry *entry;
+    struct ccdb_secdb_cache_entry *next;
+    errno_t ret;
+
+    talloc_zfree(secdb->flush_te);
+
+    DLIST_FOR_EACH_SAFE(entry, next, secdb->cache) {
+        if (!entry->dirty) {
+            continue;
+        }
+
+        ret = secdb_cache_write(entry);
+        if (ret != EOK) {
+            /* Forget the modification, the next access reads the ccache
+             * from the database again. */
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot write ccache %s, dropping the modification "
+                  "[%d]: %s\n", entry->cc->name, ret, sss_strerror(ret));
+            talloc_free(entry);
+        }
+    }
+}
+
+static void secdb_cache_flush_handler(struct tevent_context *ev,
+                                      struct tevent_timer *te,
+                                      struct timeval current_time,
+                                      void *pvt)
+{
+    struct ccdb_secdb *secdb = talloc_get_type(pvt, struct ccdb_secdb);
+
+    /* The timer is freed by tevent after this handler returns. */
+    secdb->flush_te = NULL;
+    secdb_cache_flush(secdb);
+}
+
+static void secdb_cache_mark_dirty(struct ccdb_secdb_cache_entry *entry)
+{
+    struct ccdb_secdb *secdb = entry->secdb;
+
+    entry->dirty = true;
+
+    if (secdb->flush_te != NULL) {
+        return;
+    }
+
+    secdb->flush_te = tevent_add_timer(secdb->ev, secdb,
+                            tevent_timeval_current_ofs(KCM_SECDB_FLUSH_DELAY,
+                                                       0),
+                            secdb_cache_flush_handler, secdb);
+    if (secdb->flush_te == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot schedule the ccache write, writing now\n");
+        secdb_cache_flush(secdb);
+    }
+}
+
+static int ccdb_secdb_destructor(struct ccdb_secdb *secdb)
+{
+    /* Modifications that were not written yet must not get lost on
+     * shutdown. */
+    secdb_cache_flush(secdb);
+    return 0;
+}
+
 static errno_t ccdb_secdb_init(struct kcm_ccdb *db,
                                struct confdb_ctx *cdb,
                                const char *confdb_service_path)
@@ -591,7 +982,11 @@ static errno_t ccdb_secdb_init(struct kcm_ccdb *db,
         kcm_section_quota[0]->quota.max_uid_secrets += 2;
     }
 
-    ret = sss_sec_init(db, kcm_section_quota, &secdb->sctx);
+    secdb->ev = db->ev;
+
+    /* The database must still be around when the destructor writes out
+     * the modified ccaches. */
+    ret = sss_sec_init(secdb, kcm_section_quota, &secdb->sctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Cannot initialize the security database\n");
@@ -599,6 +994,8 @@ static errno_t ccdb_secdb_init(struct kcm_ccdb *db,
         return ret;
     }
 
+    talloc_set_destructor(secdb, ccdb_secdb_destructor);
+
     DEBUG(SSSDBG_TRACE_INTERNAL, "secdb initialized\n");
     db->db_handle = secdb;
     return EOK;
@@ -630,7 +1027,6 @@ static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
     const int maxtries = 3;
     int numtry;
     errno_t ret;
-    struct sss_sec_req *sreq = NULL;
     char **keys = NULL;
     size_t nkeys;
     char *nextid_name = NULL;
@@ -648,16 +1044,8 @@ static struct tevent_req *ccdb_secdb_nextid_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_container_url_req(state, secdb->sctx, client, &sreq);
+    ret = secdb_meta_get_keys(secdb, client, &keys, &nkeys);
     if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = sss_sec_list(state, sreq, &keys, &nkeys);
-    if (ret == ENOENT) {
-        keys = NULL;
-        nkeys = 0;
-    } else if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot list keys [%d]: %s\n",
               ret, sss_strerror(ret));
@@ -722,6 +1110,7 @@ static struct tevent_req *ccdb_secdb_set_default_send(TALLOC_CTX *mem_ctx,
     char uuid_str[UUID_STR_SIZE];
     struct sss_sec_req *sreq = NULL;
     struct sss_iobuf *iobuf;
+    struct ccdb_secdb_uid_meta *meta;
     char *cur_default;
 
     uuid_unparse(uuid, uuid_str);
@@ -746,6 +1135,12 @@ static struct tevent_req *ccdb_secdb_set_default_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
+    meta = secdb_meta_get(secdb, client);
+    if (meta != NULL) {
+        /* Re-read on the next access in case the write fails */
+        meta->dfl_valid = false;
+    }
+
     ret = sss_sec_get(state, sreq, &cur_default);
     if (ret == ENOENT) {
         ret = sec_put_b64(state, sreq, iobuf);
@@ -757,6 +1152,12 @@ static struct tevent_req *ccdb_secdb_set_default_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
+    meta = secdb_meta_get(secdb, client);
+    if (meta != NULL) {
+        uuid_copy(meta->dfl_uuid, uuid);
+        meta->dfl_valid = true;
+    }
+
     ret = EOK;
     DEBUG(SSSDBG_TRACE_INTERNAL, "Set the default ccache\n");
 immediate:
@@ -790,6 +1191,7 @@ static struct tevent_req *ccdb_secdb_get_default_send(TALLOC_CTX *mem_ctx,
     errno_t ret;
     struct sss_sec_req *sreq = NULL;
     struct sss_iobuf *dfl_iobuf = NULL;
+    struct ccdb_secdb_uid_meta *meta;
     size_t uuid_size;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Getting the default ccache\n");
@@ -799,6 +1201,18 @@ static struct tevent_req *ccdb_secdb_get_default_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    meta = secdb_meta_get(secdb, client);
+    if (meta == NULL) {
+        ret = ENOMEM;
+        goto immediate;
+    }
+
+    if (meta->dfl_valid) {
+        uuid_copy(state->uuid, meta->dfl_uuid);
+        ret = EOK;
+        goto immediate;
+    }
+
     ret = secdb_dfl_url_req(state, secdb->sctx, client, &sreq);
     if (ret != EOK) {
         goto immediate;
@@ -807,6 +1221,8 @@ static struct tevent_req *ccdb_secdb_get_default_send(TALLOC_CTX *mem_ctx,
     ret = sec_get_b64(state, sreq, &dfl_iobuf);
     if (ret == ENOENT) {
         uuid_clear(state->uuid);
+        uuid_clear(meta->dfl_uuid);
+        meta->dfl_valid = true;
         ret = EOK;
         goto immediate;
     } else if (ret != EOK) {
@@ -821,6 +1237,8 @@ static struct tevent_req *ccdb_secdb_get_default_send(TALLOC_CTX *mem_ctx,
     }
 
     uuid_parse((const char *) sss_iobuf_get_data(dfl_iobuf), state->uuid);
+    uuid_copy(meta->dfl_uuid, state->uuid);
+    meta->dfl_valid = true;
     DEBUG(SSSDBG_TRACE_INTERNAL, "Got the default ccache\n");
     ret = EOK;
 immediate:
@@ -860,7 +1278,6 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
     errno_t ret;
     char **keys = NULL;
     size_t nkeys;
-    struct sss_sec_req *sreq = NULL;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Listing all ccaches\n");
 
@@ -869,18 +1286,10 @@ static struct tevent_req *ccdb_secdb_list_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = secdb_container_url_req(state, secdb->sctx, client, &sreq);
+    ret = secdb_meta_get_keys(secdb, client, &keys, &nkeys);
     if (ret != EOK) {
         goto immediate;
     }
-
-    ret = sss_sec_list(state, sreq, &keys, &nkeys);
-    if (ret == ENOENT) {
-        nkeys = 0;
-        /* Fall through and return an empty list */
-    } else if (ret != EOK) {
-        goto immediate;
-    }
     DEBUG(SSSDBG_TRACE_INTERNAL, "Found %zu ccaches\n", nkeys);
 
     state->uuid_list = talloc_array(state, uuid_t, nkeys + 1);
@@ -936,8 +1345,8 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct tevent_req *req = NULL;
     struct ccdb_secdb_getbyuuid_state *state = NULL;
+    struct ccdb_secdb_cache_entry *entry = NULL;
     errno_t ret;
-    char *secdb_key = NULL;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Getting ccache by UUID\n");
 
@@ -946,7 +1355,7 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = secdb_cache_get_by_uuid(secdb, client, uuid, &entry);
     if (ret == ENOENT) {
         state->cc = NULL;
         ret = EOK;
@@ -955,8 +1364,9 @@ static struct tevent_req *ccdb_secdb_getbyuuid_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &state->cc);
-    if (ret != EOK) {
+    state->cc = secdb_cache_dup(state, entry->cc);
+    if (state->cc == NULL) {
+        ret = ENOMEM;
         goto immediate;
     }
 
@@ -997,8 +1407,8 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct tevent_req *req = NULL;
     struct ccdb_secdb_getbyname_state *state = NULL;
+    struct ccdb_secdb_cache_entry *entry = NULL;
     errno_t ret;
-    char *secdb_key = NULL;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Getting ccache by name\n");
 
@@ -1007,7 +1417,7 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_name(state, secdb->sctx, client, name, &secdb_key);
+    ret = secdb_cache_get_by_name(secdb, client, name, &entry);
     if (ret == ENOENT) {
         state->cc = NULL;
         ret = EOK;
@@ -1016,8 +1426,9 @@ static struct tevent_req *ccdb_secdb_getbyname_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &state->cc);
-    if (ret != EOK) {
+    state->cc = secdb_cache_dup(state, entry->cc);
+    if (state->cc == NULL) {
+        ret = ENOMEM;
         goto immediate;
     }
 
@@ -1059,6 +1470,7 @@ struct tevent_req *ccdb_secdb_name_by_uuid_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct tevent_req *req = NULL;
     struct ccdb_secdb_name_by_uuid_state *state = NULL;
+    struct ccdb_secdb_cache_entry *entry;
     errno_t ret;
     char *key;
     const char *name;
@@ -1070,7 +1482,14 @@ struct tevent_req *ccdb_secdb_name_by_uuid_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &key);
+    entry = secdb_cache_find_by_uuid(secdb, client, uuid);
+    if (entry != NULL) {
+        state->name = talloc_strdup(state, entry->cc->name);
+        ret = state->name == NULL ? ENOMEM : EOK;
+        goto immediate;
+    }
+
+    ret = key_by_uuid(state, secdb, client, uuid, &key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1127,6 +1546,7 @@ struct tevent_req *ccdb_secdb_uuid_by_name_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct tevent_req *req = NULL;
     struct ccdb_secdb_uuid_by_name_state *state = NULL;
+    struct ccdb_secdb_cache_entry *entry;
     errno_t ret;
     char *key;
 
@@ -1137,7 +1557,14 @@ struct tevent_req *ccdb_secdb_uuid_by_name_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_name(state, secdb->sctx, client, name, &key);
+    entry = secdb_cache_find_by_name(secdb, client, name);
+    if (entry != NULL) {
+        uuid_copy(state->uuid, entry->cc->uuid);
+        ret = EOK;
+        goto immediate;
+    }
+
+    ret = key_by_name(state, secdb, client, name, &key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1239,6 +1666,7 @@ static struct tevent_req *ccdb_secdb_create_send(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_INTERNAL, "payload created\n");
     ret = EOK;
 immediate:
+    secdb_meta_invalidate_keys(secdb, client);
     if (ret == EOK) {
         tevent_req_done(req);
     } else {
@@ -1264,11 +1692,8 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct tevent_req *req = NULL;
     struct ccdb_secdb_state *state = NULL;
+    struct ccdb_secdb_cache_entry *entry = NULL;
     errno_t ret;
-    char *secdb_key = NULL;
-    struct kcm_ccache *cc = NULL;
-    struct sss_iobuf *payload = NULL;
-    struct sss_sec_req *sreq = NULL;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Modifying ccache\n");
 
@@ -1277,7 +1702,7 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = secdb_cache_get_by_uuid(secdb, client, uuid, &entry);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1285,12 +1710,7 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &cc);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = kcm_mod_cc(cc, mod_cc);
+    ret = kcm_mod_cc(entry->cc, mod_cc);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot modify ccache [%d]: %s\n",
@@ -1298,21 +1718,7 @@ static struct tevent_req *ccdb_secdb_mod_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = kcm_ccache_to_sec_input(state, cc, client, &payload);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = secdb_cc_key_req(state, secdb->sctx, client, secdb_key, &sreq);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = sec_update_b64(state, sreq, payload);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
+    secdb_cache_mark_dirty(entry);
     ret = EOK;
 immediate:
     if (ret == EOK) {
@@ -1340,10 +1746,7 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
     struct ccdb_secdb *secdb = talloc_get_type(db->db_handle, struct ccdb_secdb);
     struct tevent_req *req = NULL;
     struct ccdb_secdb_state *state = NULL;
-    char *secdb_key = NULL;
-    struct kcm_ccache *cc = NULL;
-    struct sss_iobuf *payload = NULL;
-    struct sss_sec_req *sreq = NULL;
+    struct ccdb_secdb_cache_entry *entry = NULL;
     errno_t ret;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Storing creds in ccache\n");
@@ -1353,7 +1756,7 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = secdb_cache_get_by_uuid(secdb, client, uuid, &entry);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1361,12 +1764,7 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = secdb_get_cc(state, secdb->sctx, secdb_key, client, &cc);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = kcm_cc_store_cred_blob(cc, cred_blob);
+    ret = kcm_cc_store_cred_blob(entry->cc, cred_blob);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot store credentials to ccache [%d]: %s\n",
@@ -1374,21 +1772,7 @@ static struct tevent_req *ccdb_secdb_store_cred_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = kcm_ccache_to_sec_input(state, cc, client, &payload);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = secdb_cc_key_req(state, secdb->sctx, client, secdb_key, &sreq);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
-    ret = sec_update_b64(state, sreq, payload);
-    if (ret != EOK) {
-        goto immediate;
-    }
-
+    secdb_cache_mark_dirty(entry);
     ret = EOK;
 immediate:
     if (ret == EOK) {
@@ -1429,24 +1813,28 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
+    /* Pending modifications of a deleted ccache are not interesting. */
+    talloc_free(secdb_cache_find_by_uuid(secdb, client, uuid));
+
     ret = secdb_container_url_req(state, secdb->sctx, client, &container_req);
     if (ret != EOK) {
         goto immediate;
     }
 
-    ret = sss_sec_list(state, container_req, &keys, &nkeys);
+    ret = secdb_meta_get_keys(secdb, client, &keys, &nkeys);
     if (ret != EOK) {
-        DEBUG(SSSDBG_MINOR_FAILURE, "No ccaches to delete\n");
         goto immediate;
     }
     DEBUG(SSSDBG_TRACE_INTERNAL, "Found %zu ccaches\n", nkeys);
 
     if (nkeys == 0) {
-        ret = EOK;
+        /* The container does not exist */
+        DEBUG(SSSDBG_MINOR_FAILURE, "No ccaches to delete\n");
+        ret = ENOENT;
         goto immediate;
     }
 
-    ret = key_by_uuid(state, secdb->sctx, client, uuid, &secdb_key);
+    ret = key_by_uuid(state, secdb, client, uuid, &secdb_key);
     if (ret == ENOENT) {
         ret = ERR_NO_CREDS;
         goto immediate;
@@ -1478,6 +1866,7 @@ static struct tevent_req *ccdb_secdb_delete_send(TALLOC_CTX *mem_ctx,
 
     ret = EOK;
 immediate:
+    secdb_meta_invalidate_keys(secdb, client);
     if (ret == EOK) {
         tevent_req_done(req);
     } else {
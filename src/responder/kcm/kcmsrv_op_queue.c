@@ -27,6 +27,8 @@
 
 struct kcm_ops_queue_entry {
     struct tevent_req *req;
+    bool readonly;
+    bool running;
 
     struct kcm_ops_queue *queue;
 
@@ -54,6 +56,12 @@ struct kcm_ops_queue_ctx {
  * hash table entry is kcm_ops_queue structure which in turn contains a
  * linked list of kcm_ops_queue_entry structures * which primarily hold the
  * tevent request being queued.
+ *
+ * The queue is a readers-writer queue. Read-only requests at the head of
+ * the queue run concurrently, a request that modifies the ccaches runs
+ * alone. Requests are started in the order they were queued, so a
+ * read-only request that comes after a waiting writer waits as well and
+ * writers do not starve.
  */
 struct kcm_ops_queue_ctx *kcm_ops_queue_create(TALLOC_CTX *mem_ctx)
 {
@@ -113,22 +121,62 @@ void queue_removal_cb(struct tevent_context *ctx,
     talloc_free(kq);
 }
 
+/* Returns true if the entry may run given the entries queued before it */
+static bool kcm_op_queue_entry_may_run(struct kcm_ops_queue_entry *entry)
+{
+    struct kcm_ops_queue_entry *prev;
+
+    if (entry == entry->queue->head) {
+        return true;
+    }
+
+    if (!entry->readonly) {
+        return false;
+    }
+
+    for (prev = entry->queue->head; prev != entry; prev = prev->next) {
+        if (!prev->readonly) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void kcm_op_queue_run_waiting(struct kcm_ops_queue *kq)
+{
+    struct kcm_ops_queue_entry *entry;
+
+again:
+    DLIST_FOR_EACH(entry, kq->head) {
+        if (!kcm_op_queue_entry_may_run(entry)) {
+            break;
+        }
+
+        if (entry->running) {
+            continue;
+        }
+
+        /* Mark the waiting request as done to run it. The callback may
+         * already finish requests and change the queue, so start over. */
+        entry->running = true;
+        tevent_req_done(entry->req);
+        goto again;
+    }
+}
+
 static int kcm_op_queue_entry_destructor(struct kcm_ops_queue_entry *entry)
 {
-    struct kcm_ops_queue_entry *next_entry;
     struct tevent_immediate *imm;
 
     if (entry == NULL) {
         return 1;
     }
 
-    /* Take the next entry from the queue */
-    next_entry = entry->next;
-
     /* Remove the current entry from the queue */
     DLIST_REMOVE(entry->queue->head, entry);
 
-    if (next_entry == NULL) {
+    if (entry->queue->head == NULL) {
         /* If there was no other entry, schedule removal of the queue. Do it
          * in another tevent tick to avoid issues with callbacks invoking
          * the destructor while another request is touching the queue
@@ -142,8 +190,8 @@ static int kcm_op_queue_entry_destructor(struct kcm_ops_queue_entry *entry)
         return 0;
     }
 
-    /* Otherwise, mark the current head as done to run the next request */
-    tevent_req_done(next_entry->req);
+    /* Otherwise, run the requests that were waiting for this one */
+    kcm_op_queue_run_waiting(entry->queue);
     return 0;
 }
 
@@ -214,22 +262,26 @@ struct kcm_op_queue_state {
 };
 
 static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
-                                    struct tevent_req *req);
+                                    struct tevent_req *req,
+                                    bool readonly);
 
 /*
  * Enqueue a request.
  *
  * If the request queue /for the given ID/ is empty, that is, if this
  * request is the first one in the queue, run the request immediately.
+ * A read-only request also runs immediately if only other read-only
+ * requests are queued.
  *
- * Otherwise just add it to the queue and wait until the previous request
- * finishes and only at that point mark the current request as done, which
+ * Otherwise just add it to the queue and wait until the previous requests
+ * finish and only at that point mark the current request as done, which
  * will trigger calling the recv function and allow the request to continue.
  */
 struct tevent_req *kcm_op_queue_send(TALLOC_CTX *mem_ctx,
                                      struct tevent_context *ev,
                                      struct kcm_ops_queue_ctx *qctx,
-                                     struct cli_creds *client)
+                                     struct cli_creds *client,
+                                     bool readonly)
 {
     errno_t ret;
     struct tevent_req *req;
@@ -255,10 +307,10 @@ struct tevent_req *kcm_op_queue_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    ret = kcm_op_queue_add_req(kq, req);
+    ret = kcm_op_queue_add_req(kq, req, readonly);
     if (ret == EOK) {
         DEBUG(SSSDBG_TRACE_LIBS,
-              "Queue was empty, running the request immediately\n");
+              "No conflicting request, running the request immediately\n");
         goto immediate;
     } else if (ret != EAGAIN) {
         DEBUG(SSSDBG_OP_FAILURE,
@@ -280,7 +332,8 @@ immediate:
 }
 
 static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
-                                    struct tevent_req *req)
+                                    struct tevent_req *req,
+                                    bool readonly)
 {
     errno_t ret;
     struct kcm_op_queue_state *state = tevent_req_data(req,
@@ -292,17 +345,20 @@ static errno_t kcm_op_queue_add_req(struct kcm_ops_queue *kq,
     }
     state->entry->req = req;
     state->entry->queue = kq;
+    state->entry->readonly = readonly;
     talloc_set_destructor(state->entry, kcm_op_queue_entry_destructor);
 
-    if (kq->head == NULL) {
-        /* First entry, will run callback at once */
+    DLIST_ADD_END(kq->head, state->entry, struct kcm_ops_queue_entry *);
+
+    if (kcm_op_queue_entry_may_run(state->entry)) {
+        /* Will run callback at once */
+        state->entry->running = true;
         ret = EOK;
     } else {
         /* Will wait for the previous callbacks to finish */
         ret = EAGAIN;
     }
 
-    DLIST_ADD_END(kq->head, state->entry, struct kcm_ops_queue_entry *);
     return ret;
 }
 
@@ -25,6 +25,7 @@
 
 #include "util/sss_iobuf.h"
 #include "util/sss_krb5.h"
+#include "util/probes.h"
 #include "util/util_creds.h"
 #include "responder/kcm/kcm.h"
 #include "responder/kcm/kcmsrv_pvt.h"
@@ -66,6 +67,9 @@ struct kcm_op {
     const char *name;
     kcm_srv_send_method fn_send;
     kcm_srv_recv_method fn_recv;
+    /* The operation does not modify any ccache and may run concurrently
+     * with other read-only operations of the same user */
+    bool readonly;
 };
 
 struct kcm_cmd_state {
@@ -109,6 +113,7 @@ struct tevent_req *kcm_cmd_send(TALLOC_CTX *mem_ctx,
 
     DEBUG(SSSDBG_TRACE_FUNC, "KCM operation %s\n", op->name);
     DEBUG(SSSDBG_TRACE_LIBS, "%zu bytes on KCM input\n", input->length);
+    PROBE(KCM_CMD_SEND, op->name, input->length);
 
     state->reply = sss_iobuf_init_empty(state,
                                         KCM_REPLY_MAX,
@@ -162,7 +167,7 @@ struct tevent_req *kcm_cmd_send(TALLOC_CTX *mem_ctx,
         goto immediate;
     }
 
-    subreq = kcm_op_queue_send(state, ev, qctx, client);
+    subreq = kcm_op_queue_send(state, ev, qctx, client, op->readonly);
     if (subreq == NULL) {
         ret = ENOMEM;
         goto immediate;
@@ -221,6 +226,7 @@ static void kcm_cmd_done(struct tevent_req *subreq)
     DEBUG(SSSDBG_TRACE_FUNC,
           "KCM operation %s returned [%d]: %s\n",
           kcm_opt_name(state->op), state->op_ret, sss_strerror(state->op_ret));
+    PROBE(KCM_CMD_DONE, kcm_opt_name(state->op), state->op_ret);
 
     kerr = sss2krb5_error(state->op_ret);
 
@@ -1202,7 +1208,6 @@ static void kcm_op_get_cred_by_uuid_getbyname_done(struct tevent_req *subreq)
     struct kcm_ccache *cc;
     struct kcm_cred *crd;
     uuid_t uuid_in;
-    uuid_t uuid;
     struct sss_iobuf *cred_blob;
 
     ret = kcm_ccdb_getbyname_recv(subreq, state, &cc);
@@ -1232,23 +1237,9 @@ static void kcm_op_get_cred_by_uuid_getbyname_done(struct tevent_req *subreq)
         return;
     }
 
-    for (crd = kcm_cc_get_cred(cc);
-         crd != NULL;
-         crd = kcm_cc_next_cred(crd)) {
-        ret = kcm_cred_get_uuid(crd, uuid);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "Cannot get UUID from creds, skipping\n");
-            continue;
-        }
-
-        if (uuid_compare(uuid, uuid_in) == 0) {
-            break;
-        }
-        kcm_debug_uuid(uuid);
-    }
-
+    crd = kcm_cc_find_cred(cc, uuid_in);
     if (crd == NULL) {
+        kcm_debug_uuid(uuid_in);
         state->op_ret = ERR_KCM_CC_END;
         DEBUG(SSSDBG_MINOR_FAILURE, "No credentials by that UUID\n");
         tevent_req_done(req);
@@ -1280,6 +1271,138 @@ static void kcm_op_get_cred_by_uuid_getbyname_done(struct tevent_req *subreq)
 
 /* (name, flags, credtag) -> () */
 /* FIXME */
+/* (name) -> (count, count*{len, cred}) */
+static void kcm_op_get_cred_list_getbyname_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+kcm_op_get_cred_list_send(TALLOC_CTX *mem_ctx,
+                          struct tevent_context *ev,
+                          struct kcm_op_ctx *op_ctx)
+{
+    struct tevent_req *req = NULL;
+    struct tevent_req *subreq = NULL;
+    struct kcm_op_common_state *state = NULL;
+    errno_t ret;
+    const char *name;
+
+    req = tevent_req_create(mem_ctx, &state, struct kcm_op_common_state);
+    if (req == NULL) {
+        return NULL;
+    }
+    state->op_ctx = op_ctx;
+
+    ret = sss_iobuf_read_stringz(op_ctx->input, &name);
+    if (ret != EOK) {
+        goto immediate;
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Returning credentials of %s\n", name);
+
+    subreq = kcm_ccdb_getbyname_send(state, ev,
+                                     op_ctx->kcm_data->db,
+                                     op_ctx->client,
+                                     name);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto immediate;
+    }
+    tevent_req_set_callback(subreq, kcm_op_get_cred_list_getbyname_done, req);
+    return req;
+
+immediate:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void kcm_op_get_cred_list_getbyname_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct kcm_op_common_state *state = tevent_req_data(req,
+                                                struct kcm_op_common_state);
+    errno_t ret;
+    struct kcm_ccache *cc;
+    struct kcm_cred *crd;
+    struct sss_iobuf *cred_blob;
+    uint32_t num_creds = 0;
+    size_t reply_size = sizeof(uint32_t);
+
+    ret = kcm_ccdb_getbyname_recv(subreq, state, &cc);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get ccache by name [%d]: %s\n",
+              ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    if (cc == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "No ccache by that name\n");
+        state->op_ret = ERR_NO_CREDS;
+        tevent_req_done(req);
+        return;
+    }
+
+    for (crd = kcm_cc_get_cred(cc);
+         crd != NULL;
+         crd = kcm_cc_next_cred(crd)) {
+        cred_blob = kcm_cred_get_creds(crd);
+        if (cred_blob == NULL) {
+            continue;
+        }
+
+        num_creds++;
+        reply_size += sizeof(uint32_t) + sss_iobuf_get_size(cred_blob);
+    }
+
+    if (reply_size > KCM_REPLY_MAX) {
+        /* The client falls back to iterating over the credentials. */
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "The credentials do not fit into a single reply\n");
+        state->op_ret = ERR_KCM_OP_NOT_IMPLEMENTED;
+        tevent_req_done(req);
+        return;
+    }
+
+    ret = sss_iobuf_write_uint32(state->op_ctx->reply, htobe32(num_creds));
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    for (crd = kcm_cc_get_cred(cc);
+         crd != NULL;
+         crd = kcm_cc_next_cred(crd)) {
+        cred_blob = kcm_cred_get_creds(crd);
+        if (cred_blob == NULL) {
+            continue;
+        }
+
+        ret = sss_iobuf_write_uint32(state->op_ctx->reply,
+                                     htobe32(sss_iobuf_get_size(cred_blob)));
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        ret = sss_iobuf_write_len(state->op_ctx->reply,
+                                  sss_iobuf_get_data(cred_blob),
+                                  sss_iobuf_get_size(cred_blob));
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Cannot write ccache blob [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            tevent_req_error(req, ret);
+            return;
+        }
+    }
+
+    state->op_ret = EOK;
+    tevent_req_done(req);
+}
+
 static struct tevent_req *
 kcm_op_remove_cred_send(TALLOC_CTX *mem_ctx,
                         struct tevent_context *ev,
@@ -2127,9 +2250,9 @@ static struct kcm_op kcm_optable[] = {
     { "DESTROY",             kcm_op_destroy_send, NULL },
     { "STORE",               kcm_op_store_send, kcm_op_store_recv },
     { "RETRIEVE",            NULL, NULL },
-    { "GET_PRINCIPAL",       kcm_op_get_principal_send, NULL },
-    { "GET_CRED_UUID_LIST",  kcm_op_get_cred_uuid_list_send, NULL },
-    { "GET_CRED_BY_UUID",    kcm_op_get_cred_by_uuid_send, NULL },
+    { "GET_PRINCIPAL",       kcm_op_get_principal_send, NULL, true },
+    { "GET_CRED_UUID_LIST",  kcm_op_get_cred_uuid_list_send, NULL, true },
+    { "GET_CRED_BY_UUID",    kcm_op_get_cred_by_uuid_send, NULL, true },
     { "REMOVE_CRED",         kcm_op_remove_cred_send, NULL },
     { "SET_FLAGS",           NULL, NULL },
     { "CHOWN",               NULL, NULL },
@@ -2137,11 +2260,11 @@ static struct kcm_op kcm_optable[] = {
     { "GET_INITIAL_TICKET",  NULL, NULL },
     { "GET_TICKET",          NULL, NULL },
     { "MOVE_CACHE",          NULL, NULL },
-    { "GET_CACHE_UUID_LIST", kcm_op_get_cache_uuid_list_send, NULL },
-    { "GET_CACHE_BY_UUID",   kcm_op_get_cache_by_uuid_send, NULL },
-    { "GET_DEFAULT_CACHE",   kcm_op_get_default_ccache_send, kcm_op_get_default_ccache_recv },
+    { "GET_CACHE_UUID_LIST", kcm_op_get_cache_uuid_list_send, NULL, true },
+    { "GET_CACHE_BY_UUID",   kcm_op_get_cache_by_uuid_send, NULL, true },
+    { "GET_DEFAULT_CACHE",   kcm_op_get_default_ccache_send, kcm_op_get_default_ccache_recv, true },
     { "SET_DEFAULT_CACHE",   kcm_op_set_default_ccache_send, kcm_op_set_default_ccache_recv },
-    { "GET_KDC_OFFSET",      kcm_op_get_kdc_offset_send, NULL },
+    { "GET_KDC_OFFSET",      kcm_op_get_kdc_offset_send, NULL, true },
     { "SET_KDC_OFFSET",      kcm_op_set_kdc_offset_send, kcm_op_set_kdc_offset_recv },
     { "ADD_NTLM_CRED",       NULL, NULL },
     { "HAVE_NTLM_CRED",      NULL, NULL },
@@ -2152,6 +2275,12 @@ static struct kcm_op kcm_optable[] = {
     { NULL, NULL, NULL }
 };
 
+static struct kcm_op kcm_mit_optable[] = {
+    { "GET_CRED_LIST",       kcm_op_get_cred_list_send, NULL, true },
+
+    { NULL, NULL, NULL }
+};
+
 struct kcm_op *kcm_get_opt(uint16_t opcode)
 {
     struct kcm_op *op;
@@ -2159,11 +2288,15 @@ struct kcm_op *kcm_get_opt(uint16_t opcode)
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "The client requested operation %"PRIu16"\n", opcode);
 
-    if (opcode >= KCM_OP_SENTINEL) {
+    if (opcode > KCM_OP_MIT_EXTENSION_BASE
+            && opcode < KCM_OP_MIT_EXTENSION_SENTINEL) {
+        op = &kcm_mit_optable[opcode - KCM_OP_MIT_EXTENSION_BASE - 1];
+    } else if (opcode < KCM_OP_SENTINEL) {
+        op = &kcm_optable[opcode];
+    } else {
         return NULL;
     }
 
-    op = &kcm_optable[opcode];
     if (op->fn_recv == NULL) {
         op->fn_recv = kcm_op_common_recv;
     }
@@ -20,9 +20,11 @@
 
 #include <tevent.h>
 #include <talloc.h>
+#include <arpa/inet.h>
 
 #include "util/util.h"
 #include "util/sss_ptr_hash.h"
+#include "util/mmap_cache.h"
 #include "db/sysdb.h"
 #include "responder/nss/nss_private.h"
 #include "responder/nss/nss_protocol.h"
@@ -105,6 +107,15 @@ static errno_t nss_getby_name(struct cli_ctx *cli_ctx,
 
     DEBUG(SSSDBG_TRACE_FUNC, "Input name: %s\n", rawname);
 
+    if (type == CACHE_REQ_IP_HOST_BY_NAME) {
+        cmd_ctx->mc_key = talloc_asprintf(cmd_ctx, MC_HOST_BY_NAME_KEY,
+                                          rawname);
+        if (cmd_ctx->mc_key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
     data = cache_req_data_name_attrs(cmd_ctx, type, rawname, attrs);
     if (data == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set cache request data!\n");
@@ -118,6 +129,11 @@ static errno_t nss_getby_name(struct cli_ctx *cli_ctx,
         goto done;
     }
 
+    if (type == CACHE_REQ_INITGROUPS) {
+        /* nss_protocol_fill_initgr() needs only the group ids. */
+        cache_req_data_set_gids_only(data, true);
+    }
+
     subreq = nss_get_object_send(cmd_ctx, cli_ctx->ev, cli_ctx,
                                  data, memcache, rawname, 0);
     if (subreq == NULL) {
@@ -171,6 +187,8 @@ static errno_t nss_getby_id(struct cli_ctx *cli_ctx,
     DEBUG(SSSDBG_TRACE_FUNC, "Input ID: %u (looking up '%s')\n", id,
           (fill_fn == nss_protocol_fill_sid) ? "SID" : "POSIX data");
 
+    cmd_ctx->sid_id = id;
+
     data = cache_req_data_id_attrs(cmd_ctx, type, id, attrs);
     if (data == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set cache request data!\n");
@@ -225,6 +243,18 @@ static errno_t nss_getby_svc(struct cli_ctx *cli_ctx,
 
     cmd_ctx->svc_protocol = protocol;
 
+    if (name != NULL) {
+        cmd_ctx->mc_key = talloc_asprintf(cmd_ctx, MC_SVC_BY_NAME_KEY, name,
+                                          protocol == NULL ? "" : protocol);
+    } else {
+        cmd_ctx->mc_key = talloc_asprintf(cmd_ctx, MC_SVC_BY_PORT_KEY, port,
+                                          protocol == NULL ? "" : protocol);
+    }
+    if (cmd_ctx->mc_key == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
     data = cache_req_data_svc(cmd_ctx, type, name, protocol, port);
     if (data == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set cache request data!\n");
@@ -459,6 +489,7 @@ static errno_t nss_getby_addr(struct cli_ctx *cli_ctx,
     struct cache_req_data *data;
     struct nss_cmd_ctx *cmd_ctx;
     struct tevent_req *subreq;
+    char addrstr[INET6_ADDRSTRLEN];
     uint8_t *addr;
     uint32_t addrlen;
     uint32_t af;
@@ -478,6 +509,20 @@ static errno_t nss_getby_addr(struct cli_ctx *cli_ctx,
         goto done;
     }
 
+    if (inet_ntop(af, addr, addrstr, sizeof(addrstr)) == NULL) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (type == CACHE_REQ_IP_HOST_BY_ADDR) {
+        cmd_ctx->mc_key = talloc_asprintf(cmd_ctx, MC_HOST_BY_ADDR_KEY,
+                                          addrstr);
+        if (cmd_ctx->mc_key == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
     data = cache_req_data_addr(cmd_ctx, type, af, addrlen, addr);
     if (data == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to set cache request data!\n");
@@ -486,7 +531,7 @@ static errno_t nss_getby_addr(struct cli_ctx *cli_ctx,
     }
 
     subreq = nss_get_object_send(cmd_ctx, cli_ctx->ev, cli_ctx,
-                                 data, memcache, NULL, 0);
+                                 data, memcache, addrstr, 0);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         ret = ENOMEM;
@@ -630,6 +675,280 @@ done:
     talloc_free(cmd_ctx);
 }
 
+enum nss_multi_input {
+    NSS_MULTI_BY_NAME,
+    NSS_MULTI_BY_ID,
+    NSS_MULTI_BY_SID
+};
+
+struct nss_multi_ctx {
+    struct nss_cmd_ctx *cmd_ctx;
+    struct cache_req_result **results;
+    /* requested IDs, needed to store SIDs by ID in the memory cache */
+    uint32_t *ids;
+    uint32_t count;
+    uint32_t pending;
+    errno_t error;
+};
+
+struct nss_multi_item {
+    struct nss_multi_ctx *multi_ctx;
+    uint32_t index;
+};
+
+static errno_t nss_multi_reply(struct nss_multi_ctx *multi_ctx);
+static void nss_getby_multi_done(struct tevent_req *subreq);
+
+/* Each entry is looked up with its own request so that they are all
+ * processed at the same time and identical lookups of other clients are
+ * joined. */
+static errno_t nss_getby_multi(struct cli_ctx *cli_ctx,
+                               enum nss_multi_input input,
+                               enum cache_req_type type,
+                               const char **attrs,
+                               enum sss_mc_type memcache,
+                               nss_protocol_fill_packet_fn fill_fn)
+{
+    struct nss_multi_ctx *multi_ctx;
+    struct nss_multi_item *item;
+    struct cache_req_data *data;
+    struct nss_cmd_ctx *cmd_ctx;
+    struct tevent_req *subreq;
+    const char **rawnames = NULL;
+    uint32_t *ids = NULL;
+    uint32_t count;
+    uint32_t i;
+    errno_t ret;
+
+    cmd_ctx = nss_cmd_ctx_create(cli_ctx, cli_ctx, type, fill_fn);
+    if (cmd_ctx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    switch (input) {
+    case NSS_MULTI_BY_NAME:
+        ret = nss_protocol_parse_name_list(cmd_ctx, cli_ctx, &rawnames,
+                                           &count);
+        break;
+    case NSS_MULTI_BY_ID:
+        ret = nss_protocol_parse_id_list(cmd_ctx, cli_ctx, &ids, &count);
+        break;
+    case NSS_MULTI_BY_SID:
+        ret = nss_protocol_parse_sid_list(cmd_ctx, cli_ctx, &rawnames,
+                                          &count);
+        break;
+    default:
+        ret = EINVAL;
+        break;
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid request message!\n");
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Looking up %"PRIu32" entries\n", count);
+
+    multi_ctx = talloc_zero(cmd_ctx, struct nss_multi_ctx);
+    if (multi_ctx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    multi_ctx->cmd_ctx = cmd_ctx;
+    multi_ctx->ids = ids;
+    multi_ctx->count = count;
+    multi_ctx->results = talloc_zero_array(multi_ctx,
+                                           struct cache_req_result *,
+                                           count);
+    if (multi_ctx->results == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        switch (input) {
+        case NSS_MULTI_BY_NAME:
+            data = cache_req_data_name_attrs(multi_ctx, type, rawnames[i],
+                                             attrs);
+            break;
+        case NSS_MULTI_BY_SID:
+            data = cache_req_data_sid(multi_ctx, type, rawnames[i], attrs);
+            break;
+        default:
+            data = cache_req_data_id_attrs(multi_ctx, type, ids[i], attrs);
+            break;
+        }
+        if (data == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set cache request data!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        item = talloc_zero(multi_ctx, struct nss_multi_item);
+        if (item == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        item->multi_ctx = multi_ctx;
+        item->index = i;
+
+        subreq = nss_get_object_send(item, cli_ctx->ev, cli_ctx, data,
+                                     memcache,
+                                     input == NSS_MULTI_BY_NAME ? rawnames[i]
+                                                                : NULL,
+                                     input == NSS_MULTI_BY_ID ? ids[i] : 0);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, nss_getby_multi_done, item);
+        multi_ctx->pending++;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(cmd_ctx);
+        return nss_protocol_done(cli_ctx, ret);
+    }
+
+    return EOK;
+}
+
+static void nss_getby_multi_done(struct tevent_req *subreq)
+{
+    struct nss_multi_ctx *multi_ctx;
+    struct nss_multi_item *item;
+    struct cli_ctx *cli_ctx;
+    errno_t ret;
+
+    item = tevent_req_callback_data(subreq, struct nss_multi_item);
+    multi_ctx = item->multi_ctx;
+
+    ret = nss_get_object_recv(multi_ctx->results, subreq,
+                              &multi_ctx->results[item->index], NULL);
+    talloc_zfree(subreq);
+    if (ret != EOK && ret != ENOENT && multi_ctx->error == EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to look up entry %"PRIu32" "
+              "[%d]: %s\n", item->index, ret, sss_strerror(ret));
+        multi_ctx->error = ret;
+    }
+    talloc_free(item);
+
+    multi_ctx->pending--;
+    if (multi_ctx->pending > 0) {
+        return;
+    }
+
+    cli_ctx = multi_ctx->cmd_ctx->cli_ctx;
+
+    ret = multi_ctx->error;
+    if (ret == EOK) {
+        ret = nss_multi_reply(multi_ctx);
+    }
+
+    talloc_free(multi_ctx->cmd_ctx);
+    nss_protocol_done(cli_ctx, ret);
+}
+
+static errno_t nss_multi_reply(struct nss_multi_ctx *multi_ctx)
+{
+    struct nss_cmd_ctx *cmd_ctx = multi_ctx->cmd_ctx;
+    struct cli_protocol *pctx;
+    struct sss_packet *item_packet = NULL;
+    uint8_t *item_body = NULL;
+    size_t item_len;
+    uint8_t *body;
+    size_t blen;
+    size_t rp;
+    uint32_t len;
+    uint32_t i;
+    errno_t ret;
+
+    pctx = talloc_get_type(cmd_ctx->cli_ctx->protocol_ctx, struct cli_protocol);
+
+    ret = sss_packet_new(pctx->creq, 2 * sizeof(uint32_t),
+                         sss_packet_get_cmd(pctx->creq->in),
+                         &pctx->creq->out);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    sss_packet_get_body(pctx->creq->out, &body, &blen);
+    rp = 0;
+    SAFEALIGN_SET_UINT32(&body[rp], multi_ctx->count, &rp);
+    SAFEALIGN_SETMEM_UINT32(&body[rp], 0, &rp); /* reserved */
+
+    for (i = 0; i < multi_ctx->count; i++) {
+        item_len = 0;
+        item_packet = NULL;
+
+        if (multi_ctx->results[i] != NULL) {
+            ret = sss_packet_new(multi_ctx, 0,
+                                 sss_packet_get_cmd(pctx->creq->in),
+                                 &item_packet);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            if (multi_ctx->ids != NULL) {
+                cmd_ctx->sid_id = multi_ctx->ids[i];
+            }
+
+            ret = cmd_ctx->fill_fn(cmd_ctx->nss_ctx, cmd_ctx, item_packet,
+                                   multi_ctx->results[i]);
+            if (ret == EOK) {
+                sss_packet_get_body(item_packet, &item_body, &item_len);
+            } else if (ret == ENOENT) {
+                item_len = 0;
+            } else if (ret == EINVAL) {
+                /* e.g. an object without a POSIX ID or a well known SID,
+                 * which is reported as not found like by the single entry
+                 * request */
+                DEBUG(SSSDBG_TRACE_FUNC, "Entry %"PRIu32" cannot be "
+                      "returned\n", i);
+                item_len = 0;
+            } else {
+                goto done;
+            }
+        }
+
+        if (item_len > UINT32_MAX) {
+            ret = EINVAL;
+            goto done;
+        }
+        len = item_len;
+
+        ret = sss_packet_grow(pctx->creq->out, sizeof(uint32_t) + item_len);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        sss_packet_get_body(pctx->creq->out, &body, &blen);
+        SAFEALIGN_SET_UINT32(&body[rp], len, &rp);
+        if (item_len > 0) {
+            safealign_memcpy(&body[rp], item_body, item_len, &rp);
+        }
+
+        talloc_zfree(item_packet);
+    }
+
+    sss_packet_set_error(pctx->creq->out, EOK);
+    ret = EOK;
+
+done:
+    talloc_free(item_packet);
+    if (ret != EOK) {
+        talloc_zfree(pctx->creq->out);
+    }
+    return ret;
+}
+
 static void nss_setent_done(struct tevent_req *subreq);
 
 static errno_t nss_setent(struct cli_ctx *cli_ctx,
@@ -739,6 +1058,79 @@ nss_getent_get_result(struct nss_enum_ctx *enum_ctx,
     return result;
 }
 
+/* Users and groups enumeration only keeps the names of the entries, the
+ * complete entries are read from the cache when they are returned. */
+static errno_t
+nss_getent_load_result(TALLOC_CTX *mem_ctx,
+                       enum cache_req_type type,
+                       struct cache_req_result *names,
+                       struct cache_req_result **_result)
+{
+    struct cache_req_result *result;
+    struct ldb_result *ldb_result;
+    const char *enabled;
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    switch (type) {
+    case CACHE_REQ_ENUM_USERS:
+        ret = sysdb_enum_load_users(mem_ctx, names->domain, names->msgs,
+                                    names->count, &ldb_result);
+        break;
+    case CACHE_REQ_ENUM_GROUPS:
+        ret = sysdb_enum_load_groups(mem_ctx, names->domain, names->msgs,
+                                     names->count, &ldb_result);
+        break;
+    default:
+        *_result = names;
+        return EOK;
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to load enumerated entries "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
+    }
+
+    result = talloc_zero(mem_ctx, struct cache_req_result);
+    if (result == NULL) {
+        talloc_free(ldb_result);
+        return ENOMEM;
+    }
+
+    /* Keep the session recording flag set by cache_req. The loaded entries
+     * are in the same order as the names. */
+    for (i = 0, j = 0; i < ldb_result->count && j < names->count; j++) {
+        if (ldb_dn_compare(ldb_result->msgs[i]->dn, names->msgs[j]->dn) != 0) {
+            continue;
+        }
+
+        enabled = ldb_msg_find_attr_as_string(names->msgs[j],
+                                              SYSDB_SESSION_RECORDING, NULL);
+        if (enabled != NULL) {
+            ldb_msg_remove_attr(ldb_result->msgs[i], SYSDB_SESSION_RECORDING);
+            ret = ldb_msg_add_fmt(ldb_result->msgs[i],
+                                  SYSDB_SESSION_RECORDING, "%s", enabled);
+            if (ret != LDB_SUCCESS) {
+                talloc_free(result);
+                talloc_free(ldb_result);
+                return sss_ldb_error_to_errno(ret);
+            }
+        }
+        i++;
+    }
+
+    result->domain = names->domain;
+    result->ldb_result = talloc_steal(result, ldb_result);
+    result->lookup_name = names->lookup_name;
+    result->count = ldb_result->count;
+    result->msgs = ldb_result->msgs;
+
+    *_result = result;
+
+    return EOK;
+}
+
 static void nss_getent_done(struct tevent_req *subreq)
 {
     struct cache_req_result *limited;
@@ -754,23 +1146,35 @@ static void nss_getent_done(struct tevent_req *subreq)
         goto done;
     }
 
-    result = nss_getent_get_result(cmd_ctx->enum_ctx, cmd_ctx->enum_index);
-    if (result == NULL) {
-        /* No more records to return. */
-        ret = ENOENT;
-        goto done;
-    }
+    do {
+        result = nss_getent_get_result(cmd_ctx->enum_ctx,
+                                       cmd_ctx->enum_index);
+        if (result == NULL) {
+            /* No more records to return. */
+            ret = ENOENT;
+            goto done;
+        }
 
-    /* Create copy of the result with limited number of records. */
-    limited = cache_req_copy_limited_result(cmd_ctx, result,
-                                            cmd_ctx->enum_index->result,
-                                            cmd_ctx->enum_limit);
-    if (limited == NULL) {
-        ret = ERR_INTERNAL;
-        goto done;
-    }
+        /* Create copy of the result with limited number of records. */
+        limited = cache_req_copy_limited_result(cmd_ctx, result,
+                                                cmd_ctx->enum_index->result,
+                                                cmd_ctx->enum_limit);
+        if (limited == NULL) {
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        cmd_ctx->enum_index->result += limited->count;
+
+        ret = nss_getent_load_result(cmd_ctx, cmd_ctx->type, limited,
+                                     &result);
+        if (ret != EOK) {
+            goto done;
+        }
 
-    cmd_ctx->enum_index->result += result->count;
+        /* Entries that were removed in the meantime are skipped, an empty
+         * reply would end the enumeration. */
+    } while (result->count == 0);
 
     /* Reply with limited result. */
     nss_protocol_reply(cmd_ctx->cli_ctx, cmd_ctx->nss_ctx, cmd_ctx,
@@ -959,6 +1363,79 @@ done:
     talloc_free(cmd_ctx);
 }
 
+static void nss_innetgr_cmd_done(struct tevent_req *subreq);
+
+static errno_t nss_innetgr(struct cli_ctx *cli_ctx,
+                           nss_protocol_fill_packet_fn fill_fn)
+{
+    struct nss_cmd_ctx *cmd_ctx;
+    struct tevent_req *subreq;
+    const char *netgroup;
+    const char *host;
+    const char *user;
+    const char *domain;
+    errno_t ret;
+
+    cmd_ctx = nss_cmd_ctx_create(cli_ctx, cli_ctx,
+                                 CACHE_REQ_NETGROUP_BY_NAME, fill_fn);
+    if (cmd_ctx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = nss_protocol_parse_innetgr(cli_ctx, &netgroup, &host, &user,
+                                     &domain);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid request message!\n");
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Checking (%s,%s,%s) in netgroup [%s]\n",
+          host == NULL ? "*" : host, user == NULL ? "*" : user,
+          domain == NULL ? "*" : domain, netgroup);
+
+    subreq = nss_innetgr_send(cmd_ctx, cli_ctx->ev, cli_ctx, netgroup,
+                              host, user, domain);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, nss_innetgr_cmd_done, cmd_ctx);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(cmd_ctx);
+        return nss_protocol_done(cli_ctx, ret);
+    }
+
+    return EOK;
+}
+
+static void nss_innetgr_cmd_done(struct tevent_req *subreq)
+{
+    struct nss_cmd_ctx *cmd_ctx;
+    errno_t ret;
+
+    cmd_ctx = tevent_req_callback_data(subreq, struct nss_cmd_ctx);
+
+    ret = nss_innetgr_recv(subreq, &cmd_ctx->innetgr_member);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        nss_protocol_done(cmd_ctx->cli_ctx, ret);
+        goto done;
+    }
+
+    nss_protocol_reply(cmd_ctx->cli_ctx, cmd_ctx->nss_ctx, cmd_ctx,
+                       NULL, cmd_ctx->fill_fn);
+
+done:
+    talloc_free(cmd_ctx);
+}
+
 static errno_t nss_endent(struct cli_ctx *cli_ctx,
                           struct nss_enum_index *idx)
 {
@@ -996,6 +1473,18 @@ static errno_t nss_cmd_getpwuid_ex(struct cli_ctx *cli_ctx)
                         SSS_MC_PASSWD, nss_protocol_fill_pwent);
 }
 
+static errno_t nss_cmd_getpwnam_multi(struct cli_ctx *cli_ctx)
+{
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_NAME, CACHE_REQ_USER_BY_NAME,
+                           NULL, SSS_MC_PASSWD, nss_protocol_fill_pwent);
+}
+
+static errno_t nss_cmd_getpwuid_multi(struct cli_ctx *cli_ctx)
+{
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_ID, CACHE_REQ_USER_BY_ID,
+                           NULL, SSS_MC_PASSWD, nss_protocol_fill_pwent);
+}
+
 static errno_t nss_cmd_setpwent(struct cli_ctx *cli_ctx)
 {
     struct nss_ctx *nss_ctx;
@@ -1051,6 +1540,18 @@ static errno_t nss_cmd_getgrgid_ex(struct cli_ctx *cli_ctx)
                         SSS_MC_GROUP, nss_protocol_fill_grent);
 }
 
+static errno_t nss_cmd_getgrnam_multi(struct cli_ctx *cli_ctx)
+{
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_NAME, CACHE_REQ_GROUP_BY_NAME,
+                           NULL, SSS_MC_GROUP, nss_protocol_fill_grent);
+}
+
+static errno_t nss_cmd_getgrgid_multi(struct cli_ctx *cli_ctx)
+{
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_ID, CACHE_REQ_GROUP_BY_ID,
+                           NULL, SSS_MC_GROUP, nss_protocol_fill_grent);
+}
+
 
 static errno_t nss_cmd_setgrent(struct cli_ctx *cli_ctx)
 {
@@ -1117,6 +1618,11 @@ static errno_t nss_cmd_endnetgrent(struct cli_ctx *cli_ctx)
     return nss_endent(cli_ctx, &state_ctx->netgrent);
 }
 
+static errno_t nss_cmd_innetgr(struct cli_ctx *cli_ctx)
+{
+    return nss_innetgr(cli_ctx, nss_protocol_fill_innetgr);
+}
+
 static errno_t nss_cmd_getservbyname(struct cli_ctx *cli_ctx)
 {
     const char *name;
@@ -1178,9 +1684,11 @@ static errno_t nss_cmd_endservent(struct cli_ctx *cli_ctx)
     return nss_endent(cli_ctx, &state_ctx->svcent);
 }
 
+/* The SID lookups also read the name and the POSIX IDs to fill the SID
+ * memory cache. */
 static errno_t nss_cmd_getsidbyname(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    const char *attrs[] = { SYSDB_SID_STR, NSS_SID_MC_ATTRS, NULL };
 
     return nss_getby_name(cli_ctx, false, CACHE_REQ_OBJECT_BY_NAME, attrs,
                           SSS_MC_NONE, nss_protocol_fill_sid);
@@ -1188,7 +1696,7 @@ static errno_t nss_cmd_getsidbyname(struct cli_ctx *cli_ctx)
 
 static errno_t nss_cmd_getsidbyid(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    const char *attrs[] = { SYSDB_SID_STR, NSS_SID_MC_ATTRS, NULL };
 
     return nss_getby_id(cli_ctx, false, CACHE_REQ_OBJECT_BY_ID, attrs,
                         SSS_MC_NONE, nss_protocol_fill_sid);
@@ -1196,7 +1704,7 @@ static errno_t nss_cmd_getsidbyid(struct cli_ctx *cli_ctx)
 
 static errno_t nss_cmd_getsidbyuid(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    const char *attrs[] = { SYSDB_SID_STR, NSS_SID_MC_ATTRS, NULL };
 
     return nss_getby_id(cli_ctx, false, CACHE_REQ_USER_BY_ID, attrs,
                         SSS_MC_NONE, nss_protocol_fill_sid);
@@ -1204,7 +1712,7 @@ static errno_t nss_cmd_getsidbyuid(struct cli_ctx *cli_ctx)
 
 static errno_t nss_cmd_getsidbygid(struct cli_ctx *cli_ctx)
 {
-    const char *attrs[] = { SYSDB_SID_STR, NULL };
+    const char *attrs[] = { SYSDB_SID_STR, NSS_SID_MC_ATTRS, NULL };
 
     return nss_getby_id(cli_ctx, false, CACHE_REQ_GROUP_BY_ID, attrs,
                         SSS_MC_NONE, nss_protocol_fill_sid);
@@ -1222,6 +1730,36 @@ static errno_t nss_cmd_getidbysid(struct cli_ctx *cli_ctx)
                          nss_protocol_fill_id);
 }
 
+static errno_t nss_cmd_getidbysid_multi(struct cli_ctx *cli_ctx)
+{
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_SID, CACHE_REQ_OBJECT_BY_SID,
+                           NULL, SSS_MC_NONE, nss_protocol_fill_id);
+}
+
+static errno_t nss_cmd_getsidbyid_multi(struct cli_ctx *cli_ctx)
+{
+    const char *attrs[] = { SYSDB_SID_STR, NSS_SID_MC_ATTRS, NULL };
+
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_ID, CACHE_REQ_OBJECT_BY_ID,
+                           attrs, SSS_MC_NONE, nss_protocol_fill_sid);
+}
+
+static errno_t nss_cmd_getsidbyuid_multi(struct cli_ctx *cli_ctx)
+{
+    const char *attrs[] = { SYSDB_SID_STR, NSS_SID_MC_ATTRS, NULL };
+
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_ID, CACHE_REQ_USER_BY_ID,
+                           attrs, SSS_MC_NONE, nss_protocol_fill_sid);
+}
+
+static errno_t nss_cmd_getsidbygid_multi(struct cli_ctx *cli_ctx)
+{
+    const char *attrs[] = { SYSDB_SID_STR, NSS_SID_MC_ATTRS, NULL };
+
+    return nss_getby_multi(cli_ctx, NSS_MULTI_BY_ID, CACHE_REQ_GROUP_BY_ID,
+                           attrs, SSS_MC_NONE, nss_protocol_fill_sid);
+}
+
 static errno_t nss_cmd_getorigbyname(struct cli_ctx *cli_ctx)
 {
     errno_t ret;
@@ -1381,6 +1919,7 @@ struct sss_cmd_table *get_nss_cmds(void)
         { SSS_NSS_SETNETGRENT, nss_cmd_setnetgrent },
         { SSS_NSS_GETNETGRENT, nss_cmd_getnetgrent },
         { SSS_NSS_ENDNETGRENT, nss_cmd_endnetgrent },
+        { SSS_NSS_INNETGR, nss_cmd_innetgr },
         { SSS_NSS_GETSERVBYNAME, nss_cmd_getservbyname },
         { SSS_NSS_GETSERVBYPORT, nss_cmd_getservbyport },
         { SSS_NSS_SETSERVENT, nss_cmd_setservent },
@@ -1392,6 +1931,10 @@ struct sss_cmd_table *get_nss_cmds(void)
         { SSS_NSS_GETSIDBYGID, nss_cmd_getsidbygid },
         { SSS_NSS_GETNAMEBYSID, nss_cmd_getnamebysid },
         { SSS_NSS_GETIDBYSID, nss_cmd_getidbysid },
+        { SSS_NSS_GETIDBYSID_MULTI, nss_cmd_getidbysid_multi },
+        { SSS_NSS_GETSIDBYID_MULTI, nss_cmd_getsidbyid_multi },
+        { SSS_NSS_GETSIDBYUID_MULTI, nss_cmd_getsidbyuid_multi },
+        { SSS_NSS_GETSIDBYGID_MULTI, nss_cmd_getsidbygid_multi },
         { SSS_NSS_GETORIGBYNAME, nss_cmd_getorigbyname },
         { SSS_NSS_GETNAMEBYCERT, nss_cmd_getnamebycert },
         { SSS_NSS_GETLISTBYCERT, nss_cmd_getlistbycert },
@@ -1399,6 +1942,10 @@ struct sss_cmd_table *get_nss_cmds(void)
         { SSS_NSS_GETPWUID_EX, nss_cmd_getpwuid_ex },
         { SSS_NSS_GETGRNAM_EX, nss_cmd_getgrnam_ex },
         { SSS_NSS_GETGRGID_EX, nss_cmd_getgrgid_ex },
+        { SSS_NSS_GETPWNAM_MULTI, nss_cmd_getpwnam_multi },
+        { SSS_NSS_GETPWUID_MULTI, nss_cmd_getpwuid_multi },
+        { SSS_NSS_GETGRNAM_MULTI, nss_cmd_getgrnam_multi },
+        { SSS_NSS_GETGRGID_MULTI, nss_cmd_getgrgid_multi },
         { SSS_NSS_INITGR_EX, nss_cmd_initgroups_ex },
         { SSS_NSS_GETHOSTBYNAME, nss_cmd_gethostbyname },
         { SSS_NSS_GETHOSTBYNAME2, nss_cmd_gethostbyname },
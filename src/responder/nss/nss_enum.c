@@ -25,6 +25,95 @@
 #include "util/sss_ptr_hash.h"
 #include "responder/nss/nss_private.h"
 
+/* Separator of the triple fields in the index keys, it can not appear in
+ * a host, user or domain name. */
+#define NSS_NETGR_KEY_SEP "\x1f"
+
+static char *
+nss_netgr_triple_key(TALLOC_CTX *mem_ctx,
+                     const char *host,
+                     const char *user,
+                     const char *domain)
+{
+    TALLOC_CTX *tmp_ctx;
+    char *lc_host = NULL;
+    char *lc_domain = NULL;
+    char *key = NULL;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return NULL;
+    }
+
+    /* Host and domain names are compared case insensitively. */
+    lc_host = sss_tc_utf8_str_tolower(tmp_ctx, host == NULL ? "" : host);
+    lc_domain = sss_tc_utf8_str_tolower(tmp_ctx, domain == NULL ? "" : domain);
+    if (lc_host == NULL || lc_domain == NULL) {
+        goto done;
+    }
+
+    key = talloc_asprintf(mem_ctx, "%s" NSS_NETGR_KEY_SEP "%s"
+                          NSS_NETGR_KEY_SEP "%s",
+                          lc_host, user == NULL ? "" : user, lc_domain);
+
+done:
+    talloc_free(tmp_ctx);
+    return key;
+}
+
+static errno_t
+nss_netgr_build_triples(struct nss_enum_ctx *enum_ctx)
+{
+    struct sysdb_netgroup_ctx *entry;
+    hash_key_t key;
+    hash_value_t value;
+    size_t i;
+    errno_t ret;
+    int hret;
+
+    talloc_zfree(enum_ctx->triples);
+
+    ret = sss_hash_create(enum_ctx, enum_ctx->netgroup_count,
+                          &enum_ctx->triples);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_UNDEF;
+    for (i = 0; i < enum_ctx->netgroup_count; i++) {
+        entry = enum_ctx->netgroup[i];
+        if (entry->type != SYSDB_NETGROUP_TRIPLE_VAL) {
+            continue;
+        }
+
+        key.str = nss_netgr_triple_key(enum_ctx->triples,
+                                       entry->value.triple.hostname,
+                                       entry->value.triple.username,
+                                       entry->value.triple.domainname);
+        if (key.str == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        hret = hash_enter(enum_ctx->triples, &key, &value);
+        talloc_free(key.str);
+        if (hret != HASH_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_zfree(enum_ctx->triples);
+    }
+
+    return ret;
+}
+
 typedef errno_t (*nss_setent_set_timeout_fn)(struct tevent_context *ev,
                                              struct nss_ctx *nss_ctx,
                                              struct nss_enum_ctx *enum_ctx);
@@ -150,12 +239,23 @@ static void nss_setent_internal_done(struct tevent_req *subreq)
             if (ret != EOK) {
                 goto done;
             }
+
+            /* And index the triples for innetgr. */
+            ret = nss_netgr_build_triples(state->enum_ctx);
+            if (ret != EOK) {
+                goto done;
+            }
+        } else if (state->type == CACHE_REQ_ENUM_HOST
+                       || state->type == CACHE_REQ_ENUM_IP_NETWORK) {
+            /* The enumeration refreshed the cache, load it again. */
+            nss_host_index_flush(state->nss_ctx->host_index);
         }
         break;
     case ENOENT:
         /* Reset the result but build it again next time setent is called. */
         talloc_zfree(state->enum_ctx->result);
         talloc_zfree(state->enum_ctx->netgroup);
+        talloc_zfree(state->enum_ctx->triples);
         goto done;
     default:
         /* In case of an error, we do not touch the enumeration context. */
@@ -364,3 +464,319 @@ errno_t nss_setnetgrent_recv(struct tevent_req *req)
 {
     return nss_setent_internal_recv(req);
 }
+
+static bool
+nss_innetgr_field_match(const char *value,
+                        const char *query,
+                        bool case_sensitive)
+{
+    /* Missing query matches anything, empty value is a wildcard. */
+    if (query == NULL || value == NULL || value[0] == '\0') {
+        return true;
+    }
+
+    return sss_string_equal(case_sensitive, value, query);
+}
+
+static bool
+nss_innetgr_match(struct nss_enum_ctx *enum_ctx,
+                  const char *host,
+                  const char *user,
+                  const char *domain)
+{
+    struct sysdb_netgroup_ctx *entry;
+    hash_key_t key;
+    size_t i;
+    int mask;
+    bool found;
+
+    if (host != NULL && user != NULL && domain != NULL
+            && enum_ctx->triples != NULL) {
+        /* Try the triple itself and all its wildcard variants. */
+        for (mask = 0; mask < 8; mask++) {
+            key.type = HASH_KEY_STRING;
+            key.str = nss_netgr_triple_key(enum_ctx,
+                                           (mask & 1) ? "" : host,
+                                           (mask & 2) ? "" : user,
+                                           (mask & 4) ? "" : domain);
+            if (key.str == NULL) {
+                /* Fall back to the linear scan below. */
+                break;
+            }
+
+            found = hash_has_key(enum_ctx->triples, &key);
+            talloc_free(key.str);
+            if (found) {
+                return true;
+            }
+        }
+
+        if (mask == 8) {
+            return false;
+        }
+    }
+
+    for (i = 0; i < enum_ctx->netgroup_count; i++) {
+        entry = enum_ctx->netgroup[i];
+        if (entry->type != SYSDB_NETGROUP_TRIPLE_VAL) {
+            continue;
+        }
+
+        if (nss_innetgr_field_match(entry->value.triple.hostname, host, false)
+            && nss_innetgr_field_match(entry->value.triple.username, user, true)
+            && nss_innetgr_field_match(entry->value.triple.domainname,
+                                       domain, false)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+struct nss_innetgr_state {
+    struct tevent_context *ev;
+    struct cli_ctx *cli_ctx;
+    struct nss_ctx *nss_ctx;
+    const char *host;
+    const char *user;
+    const char *domain;
+
+    /* Netgroups to be searched, nested netgroups are appended. */
+    const char **queue;
+    size_t queue_len;
+    size_t index;
+    hash_table_t *visited;
+
+    bool is_member;
+};
+
+static errno_t nss_innetgr_next(struct tevent_req *req);
+static void nss_innetgr_done(struct tevent_req *subreq);
+
+struct tevent_req *
+nss_innetgr_send(TALLOC_CTX *mem_ctx,
+                 struct tevent_context *ev,
+                 struct cli_ctx *cli_ctx,
+                 const char *netgroup,
+                 const char *host,
+                 const char *user,
+                 const char *domain)
+{
+    struct nss_innetgr_state *state;
+    struct tevent_req *req;
+    hash_key_t key;
+    hash_value_t value;
+    errno_t ret;
+    int hret;
+
+    req = tevent_req_create(mem_ctx, &state, struct nss_innetgr_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->cli_ctx = cli_ctx;
+    state->nss_ctx = talloc_get_type(cli_ctx->rctx->pvt_ctx, struct nss_ctx);
+    state->host = talloc_strdup(state, host);
+    state->user = talloc_strdup(state, user);
+    state->domain = talloc_strdup(state, domain);
+    if ((host != NULL && state->host == NULL)
+            || (user != NULL && state->user == NULL)
+            || (domain != NULL && state->domain == NULL)) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_hash_create(state, 0, &state->visited);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    state->queue = talloc_zero_array(state, const char *, 1);
+    if (state->queue == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->queue[0] = talloc_strdup(state->queue, netgroup);
+    if (state->queue[0] == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    state->queue_len = 1;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(state->queue[0]);
+    value.type = HASH_VALUE_UNDEF;
+    hret = hash_enter(state->visited, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = nss_innetgr_next(req);
+    if (ret != EAGAIN) {
+        goto done;
+    }
+
+    return req;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+
+    return req;
+}
+
+static errno_t nss_innetgr_next(struct tevent_req *req)
+{
+    struct nss_innetgr_state *state;
+    struct tevent_req *subreq;
+
+    state = tevent_req_data(req, struct nss_innetgr_state);
+
+    if (state->index >= state->queue_len) {
+        /* All nested netgroups were searched. */
+        return EOK;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "Searching netgroup [%s]\n",
+          state->queue[state->index]);
+
+    subreq = nss_setnetgrent_send(state, state->ev, state->cli_ctx,
+                                  CACHE_REQ_NETGROUP_BY_NAME,
+                                  state->nss_ctx->netgrent,
+                                  state->queue[state->index]);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(subreq, nss_innetgr_done, req);
+
+    return EAGAIN;
+}
+
+static errno_t
+nss_innetgr_add_nested(struct nss_innetgr_state *state,
+                       struct nss_enum_ctx *enum_ctx)
+{
+    struct sysdb_netgroup_ctx *entry;
+    const char **queue;
+    hash_key_t key;
+    hash_value_t value;
+    size_t i;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_UNDEF;
+
+    for (i = 0; i < enum_ctx->netgroup_count; i++) {
+        entry = enum_ctx->netgroup[i];
+        if (entry->type != SYSDB_NETGROUP_GROUP_VAL) {
+            continue;
+        }
+
+        /* Netgroups may be nested in a loop, search each only once. */
+        key.str = entry->value.groupname;
+        if (hash_has_key(state->visited, &key)) {
+            continue;
+        }
+
+        hret = hash_enter(state->visited, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            return ENOMEM;
+        }
+
+        queue = talloc_realloc(state, state->queue, const char *,
+                               state->queue_len + 1);
+        if (queue == NULL) {
+            return ENOMEM;
+        }
+        state->queue = queue;
+
+        state->queue[state->queue_len] = talloc_strdup(state->queue,
+                                                       key.str);
+        if (state->queue[state->queue_len] == NULL) {
+            return ENOMEM;
+        }
+        state->queue_len++;
+    }
+
+    return EOK;
+}
+
+static void nss_innetgr_done(struct tevent_req *subreq)
+{
+    struct nss_innetgr_state *state;
+    struct nss_enum_ctx *enum_ctx;
+    struct tevent_req *req;
+    const char *netgroup;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct nss_innetgr_state);
+    netgroup = state->queue[state->index];
+
+    ret = nss_setnetgrent_recv(subreq);
+    talloc_zfree(subreq);
+
+    if (ret == EOK) {
+        enum_ctx = sss_ptr_hash_lookup(state->nss_ctx->netgrent, netgroup,
+                                       struct nss_enum_ctx);
+        ret = enum_ctx == NULL ? ENOENT : EOK;
+    }
+
+    if (ret == EOK) {
+        if (nss_innetgr_match(enum_ctx, state->host, state->user,
+                              state->domain)) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Triple found in netgroup [%s]\n",
+                  netgroup);
+            state->is_member = true;
+            tevent_req_done(req);
+            return;
+        }
+
+        ret = nss_innetgr_add_nested(state, enum_ctx);
+        if (ret != EOK) {
+            goto done;
+        }
+    } else if (state->index == 0) {
+        /* The netgroup itself must exist. */
+        goto done;
+    } else {
+        /* Nested netgroups which can not be read are skipped the same
+         * way getnetgrent() skips them. */
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to read nested netgroup [%s] [%d]: %s\n",
+              netgroup, ret, sss_strerror(ret));
+    }
+
+    state->index++;
+    ret = nss_innetgr_next(req);
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+errno_t
+nss_innetgr_recv(struct tevent_req *req, bool *_is_member)
+{
+    struct nss_innetgr_state *state;
+    state = tevent_req_data(req, struct nss_innetgr_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_is_member = state->is_member;
+
+    return EOK;
+}
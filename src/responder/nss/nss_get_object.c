@@ -200,6 +200,7 @@ hybrid_domain_verify_gid_data(TALLOC_CTX *mem_ctx,
 static int
 hybrid_domain_user_to_group(struct cache_req_result *result)
 {
+    struct ldb_message **msgs;
     errno_t ret;
     uid_t uid;
     gid_t gid;
@@ -227,7 +228,25 @@ hybrid_domain_user_to_group(struct cache_req_result *result)
         return ENOENT;
     }
 
-    /* OK, we have a user with uid == gid; let's pretend this is a group */
+    /* OK, we have a user with uid == gid; let's pretend this is a group.
+     * The message may be shared with other requests for the same user,
+     * so the attribute is added to a copy of it. */
+    msgs = talloc_array(result, struct ldb_message *, 1);
+    if (msgs == NULL) {
+        return ENOMEM;
+    }
+
+    msgs[0] = ldb_msg_copy_shallow(msgs, result->msgs[0]);
+    if (msgs[0] == NULL) {
+        talloc_free(msgs);
+        return ENOMEM;
+    }
+
+    result->msgs = msgs;
+    if (result->ldb_result != NULL) {
+        result->ldb_result->msgs = msgs;
+    }
+
     ret = ldb_msg_add_string(result->msgs[0],
                              SYSDB_OBJECTCATEGORY,
                              SYSDB_GROUP_CLASS);
@@ -252,8 +271,38 @@ struct nss_get_object_state {
     uint32_t input_id;
 
     struct cache_req_result *result;
+
+    /* Type of the original request, it changes for hybrid lookups. */
+    enum cache_req_type type;
+    bool use_result_cache;
 };
 
+static bool
+nss_get_object_use_host_index(struct nss_ctx *nss_ctx,
+                              struct cache_req_data *data)
+{
+    if (nss_ctx->host_index == NULL) {
+        return false;
+    }
+
+    switch (cache_req_data_get_type(data)) {
+    case CACHE_REQ_IP_HOST_BY_NAME:
+    case CACHE_REQ_IP_HOST_BY_ADDR:
+    case CACHE_REQ_IP_NETWORK_BY_NAME:
+    case CACHE_REQ_IP_NETWORK_BY_ADDR:
+        break;
+    default:
+        return false;
+    }
+
+    if (cache_req_data_get_bypass_cache(data)
+            || cache_req_data_get_bypass_dp(data)) {
+        return false;
+    }
+
+    return true;
+}
+
 static void nss_get_object_done(struct tevent_req *subreq);
 static errno_t nss_get_hybrid_object_step(struct tevent_req *req);
 static void nss_get_hybrid_object_done(struct tevent_req *subreq);
@@ -261,6 +310,33 @@ static void nss_get_hybrid_gid_verify_done(struct tevent_req *subreq);
 static void nss_get_object_finish_req(struct tevent_req *req,
                                       errno_t ret);
 
+static bool
+nss_get_object_use_result_cache(struct nss_ctx *nss_ctx,
+                                struct cache_req_data *data,
+                                enum sss_mc_type memcache)
+{
+    if (nss_ctx->result_cache == NULL) {
+        return false;
+    }
+
+    switch (memcache) {
+    case SSS_MC_PASSWD:
+    case SSS_MC_GROUP:
+    case SSS_MC_INITGROUPS:
+        break;
+    default:
+        return false;
+    }
+
+    /* The client asked for a fresh lookup. */
+    if (cache_req_data_get_bypass_cache(data)
+            || cache_req_data_get_bypass_dp(data)) {
+        return false;
+    }
+
+    return true;
+}
+
 /* Cache request data memory context is stolen to internal state. */
 struct tevent_req *
 nss_get_object_send(TALLOC_CTX *mem_ctx,
@@ -295,6 +371,42 @@ nss_get_object_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    state->type = cache_req_data_get_type(data);
+    state->use_result_cache = nss_get_object_use_result_cache(state->nss_ctx,
+                                                              data, memcache);
+    if (state->use_result_cache) {
+        state->result = nss_result_cache_get(state,
+                                             state->nss_ctx->result_cache,
+                                             state->type, state->input_name,
+                                             state->input_id);
+        if (state->result != NULL) {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Client [%p][%d]: returning result from result cache\n",
+                  cli_ctx, cli_ctx->cfd);
+            nss_prefetch_hit(state->nss_ctx->prefetch, memcache,
+                             state->result);
+            sss_cmd_set_source(cli_ctx, SSS_CMD_SOURCE_CACHE,
+                               state->result->domain);
+            ret = EOK;
+            goto done;
+        }
+    }
+
+    /* Addresses are passed as input_name in their printed form. */
+    if (nss_get_object_use_host_index(state->nss_ctx, data)) {
+        state->result = nss_host_index_get(state, state->nss_ctx->host_index,
+                                           state->type, state->input_name);
+        if (state->result != NULL) {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Client [%p][%d]: returning result from hosts index\n",
+                  cli_ctx, cli_ctx->cfd);
+            sss_cmd_set_source(cli_ctx, SSS_CMD_SOURCE_CACHE,
+                               state->result->domain);
+            ret = EOK;
+            goto done;
+        }
+    }
+
     subreq = cache_req_send(req, ev, cli_ctx->rctx, cli_ctx->rctx->ncache,
                             state->nss_ctx->cache_refresh_percent,
                             CACHE_REQ_POSIX_DOM, NULL, data);
@@ -314,7 +426,10 @@ nss_get_object_send(TALLOC_CTX *mem_ctx,
     ret = EAGAIN;
 
 done:
-    if (ret != EAGAIN) {
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    } else if (ret != EAGAIN) {
         tevent_req_error(req, ret);
         tevent_req_post(req, ev);
     }
@@ -333,6 +448,9 @@ static void nss_get_object_done(struct tevent_req *subreq)
     state = tevent_req_data(req, struct nss_get_object_state);
 
     ret = cache_req_single_domain_recv(state, subreq, &state->result);
+    sss_cmd_set_lookup_source(state->cli_ctx,
+                              cache_req_get_lookup_flags(subreq),
+                              ret == EOK ? state->result->domain : NULL);
     talloc_zfree(subreq);
 
     if (ret == ENOENT
@@ -369,6 +487,20 @@ static void nss_get_object_finish_req(struct tevent_req *req,
                                   state->memcache);
         }
 
+        nss_prefetch_hit(state->nss_ctx->prefetch, state->memcache,
+                         state->result);
+
+        if (state->use_result_cache) {
+            ret = nss_result_cache_add(state, state->nss_ctx->result_cache,
+                                       state->type, state->input_name,
+                                       state->input_id, &state->result);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Unable to store result in result cache [%d]: %s\n",
+                      ret, sss_strerror(ret));
+            }
+        }
+
         tevent_req_done(req);
         break;
     case ENOENT:
@@ -430,6 +562,9 @@ static void nss_get_hybrid_object_done(struct tevent_req *subreq)
     state = tevent_req_data(req, struct nss_get_object_state);
 
     ret = cache_req_single_domain_recv(state, subreq, &state->result);
+    sss_cmd_set_lookup_source(state->cli_ctx,
+                              cache_req_get_lookup_flags(subreq),
+                              ret == EOK ? state->result->domain : NULL);
     talloc_zfree(subreq);
     if (ret != EOK) {
         goto done;
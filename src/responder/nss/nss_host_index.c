@@ -0,0 +1,429 @@
+/*
+    SSSD
+
+    NSS Responder - in-memory index of hosts and networks
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "util/util.h"
+#include "util/sss_hash_map.h"
+#include "db/sysdb_iphosts.h"
+#include "db/sysdb_ipnetworks.h"
+#include "responder/nss/nss_private.h"
+
+SSS_HASH_MAP_TYPED(nss_host_index_map, struct cache_req_result)
+
+typedef errno_t (*nss_host_index_search_fn)(TALLOC_CTX *mem_ctx,
+                                            struct sss_domain_info *domain,
+                                            const char *sub_filter,
+                                            const char **attrs,
+                                            size_t *msgs_count,
+                                            struct ldb_message ***msgs);
+
+/* All hosts or all networks of the cache, the maps point to the results
+ * that are allocated on @entries. */
+struct nss_host_index_table {
+    const char *desc;
+    enum cache_req_type by_name;
+    enum cache_req_type by_addr;
+    const char *addr_attr;
+    const char **attrs;
+    nss_host_index_search_fn search;
+
+    struct sss_hash_map *names;
+    struct sss_hash_map *addrs;
+    TALLOC_CTX *entries;
+    bool loaded;
+    time_t expire;
+};
+
+struct nss_host_index {
+    struct resp_ctx *rctx;
+    time_t timeout;
+
+    struct nss_host_index_table hosts;
+    struct nss_host_index_table networks;
+};
+
+/* The same attributes sysdb_gethostbyname() and sysdb_getipnetworkbyname()
+ * return, so the replies do not differ. */
+static const char *nss_host_index_host_attrs[] = {
+    SYSDB_NAME,
+    SYSDB_NAME_ALIAS,
+    SYSDB_IP_HOST_ATTR_ADDRESS,
+    SYSDB_DEFAULT_ATTRS,
+    NULL,
+};
+
+static const char *nss_host_index_network_attrs[] = {
+    SYSDB_NAME,
+    SYSDB_NAME_ALIAS,
+    SYSDB_IP_NETWORK_ATTR_NUMBER,
+    SYSDB_DEFAULT_ATTRS,
+    NULL,
+};
+
+static errno_t
+nss_host_index_table_init(struct nss_host_index *index,
+                          struct nss_host_index_table *table)
+{
+    table->names = sss_hash_map_create(index, 0);
+    table->addrs = sss_hash_map_create(index, 0);
+    if (table->names == NULL || table->addrs == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+errno_t nss_host_index_init(struct nss_ctx *nctx, time_t timeout)
+{
+    struct nss_host_index *index;
+    errno_t ret;
+
+    if (timeout <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Hosts index is disabled.\n");
+        return EOK;
+    }
+
+    index = talloc_zero(nctx, struct nss_host_index);
+    if (index == NULL) {
+        return ENOMEM;
+    }
+
+    index->rctx = nctx->rctx;
+    index->timeout = timeout;
+
+    index->hosts.desc = "hosts";
+    index->hosts.by_name = CACHE_REQ_IP_HOST_BY_NAME;
+    index->hosts.by_addr = CACHE_REQ_IP_HOST_BY_ADDR;
+    index->hosts.addr_attr = SYSDB_IP_HOST_ATTR_ADDRESS;
+    index->hosts.attrs = nss_host_index_host_attrs;
+    index->hosts.search = sysdb_search_hosts;
+
+    index->networks.desc = "networks";
+    index->networks.by_name = CACHE_REQ_IP_NETWORK_BY_NAME;
+    index->networks.by_addr = CACHE_REQ_IP_NETWORK_BY_ADDR;
+    index->networks.addr_attr = SYSDB_IP_NETWORK_ATTR_NUMBER;
+    index->networks.attrs = nss_host_index_network_attrs;
+    index->networks.search = sysdb_search_ipnetworks;
+
+    ret = nss_host_index_table_init(index, &index->hosts);
+    if (ret != EOK) {
+        talloc_free(index);
+        return ret;
+    }
+
+    ret = nss_host_index_table_init(index, &index->networks);
+    if (ret != EOK) {
+        talloc_free(index);
+        return ret;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Hosts index is reloaded after %ld "
+          "seconds\n", (long)timeout);
+
+    nctx->host_index = index;
+
+    return EOK;
+}
+
+/* A result of a single entry, as cache_req returns it. */
+static struct cache_req_result *
+nss_host_index_result(TALLOC_CTX *mem_ctx,
+                      struct sss_domain_info *domain,
+                      struct ldb_message *msg)
+{
+    struct cache_req_result *result;
+
+    result = talloc_zero(mem_ctx, struct cache_req_result);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    result->ldb_result = talloc_zero(result, struct ldb_result);
+    if (result->ldb_result == NULL) {
+        talloc_free(result);
+        return NULL;
+    }
+
+    result->ldb_result->msgs = talloc_zero_array(result->ldb_result,
+                                                 struct ldb_message *, 2);
+    if (result->ldb_result->msgs == NULL) {
+        talloc_free(result);
+        return NULL;
+    }
+
+    result->ldb_result->msgs[0] = talloc_steal(result->ldb_result->msgs, msg);
+    result->ldb_result->count = 1;
+
+    result->domain = domain;
+    result->count = 1;
+    result->msgs = result->ldb_result->msgs;
+
+    return result;
+}
+
+static void
+nss_host_index_table_flush(struct nss_host_index_table *table)
+{
+    sss_hash_map_clear(table->names);
+    sss_hash_map_clear(table->addrs);
+    talloc_zfree(table->entries);
+    table->loaded = false;
+}
+
+/* Host and network names are always case insensitive. */
+static errno_t
+nss_host_index_add_names(struct nss_host_index_table *table,
+                         struct ldb_message *msg,
+                         const char *attr,
+                         struct cache_req_result *result)
+{
+    struct ldb_message_element *el;
+    char *name;
+    unsigned int i;
+    errno_t ret;
+
+    el = ldb_msg_find_element(msg, attr);
+    if (el == NULL) {
+        return EOK;
+    }
+
+    for (i = 0; i < el->num_values; i++) {
+        name = sss_tc_utf8_str_tolower(NULL,
+                                       (const char *)el->values[i].data);
+        if (name == NULL) {
+            return ENOMEM;
+        }
+
+        /* The first domain that has the name answers lookups of it. */
+        ret = nss_host_index_map_add(table->names, name, result);
+        talloc_free(name);
+        if (ret != EOK && ret != EEXIST) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+/* Addresses are looked up in the form inet_ntop() prints them. */
+static errno_t
+nss_host_index_add_addrs(struct nss_host_index_table *table,
+                         struct ldb_message *msg,
+                         struct cache_req_result *result)
+{
+    struct ldb_message_element *el;
+    char buf[INET6_ADDRSTRLEN];
+    uint8_t addr[sizeof(struct in6_addr)];
+    const char *value;
+    const char *key;
+    unsigned int i;
+    errno_t ret;
+
+    el = ldb_msg_find_element(msg, table->addr_attr);
+    if (el == NULL) {
+        return EOK;
+    }
+
+    for (i = 0; i < el->num_values; i++) {
+        value = (const char *)el->values[i].data;
+
+        if (inet_pton(AF_INET, value, addr) == 1) {
+            key = inet_ntop(AF_INET, addr, buf, sizeof(buf));
+        } else if (inet_pton(AF_INET6, value, addr) == 1) {
+            key = inet_ntop(AF_INET6, addr, buf, sizeof(buf));
+        } else {
+            key = value;
+        }
+
+        if (key == NULL) {
+            continue;
+        }
+
+        ret = nss_host_index_map_add(table->addrs, key, result);
+        if (ret != EOK && ret != EEXIST) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static errno_t
+nss_host_index_table_load(struct nss_host_index *index,
+                          struct nss_host_index_table *table)
+{
+    struct cache_req_result *result;
+    struct sss_domain_info *dom;
+    struct ldb_message **msgs;
+    size_t count;
+    size_t total = 0;
+    size_t i;
+    errno_t ret;
+
+    nss_host_index_table_flush(table);
+
+    table->entries = talloc_new(index);
+    if (table->entries == NULL) {
+        return ENOMEM;
+    }
+
+    /* The same domains in the same order as cache_req searches them for
+     * names that are not qualified. */
+    for (dom = index->rctx->domains;
+         dom != NULL;
+         dom = get_next_domain(dom, 0)) {
+        if (dom->type != DOM_TYPE_POSIX) {
+            continue;
+        }
+
+        ret = table->search(table->entries, dom, "", table->attrs,
+                            &count, &msgs);
+        if (ret == ENOENT) {
+            continue;
+        } else if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to read %s of domain %s "
+                  "[%d]: %s\n", table->desc, dom->name, ret, sss_strerror(ret));
+            goto done;
+        }
+
+        for (i = 0; i < count; i++) {
+            result = nss_host_index_result(table->entries, dom, msgs[i]);
+            if (result == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = nss_host_index_add_names(table, result->msgs[0],
+                                           SYSDB_NAME, result);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            ret = nss_host_index_add_names(table, result->msgs[0],
+                                           SYSDB_NAME_ALIAS, result);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            ret = nss_host_index_add_addrs(table, result->msgs[0], result);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        total += count;
+        talloc_free(msgs);
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Loaded %zu %s into the hosts index\n",
+          total, table->desc);
+
+    table->loaded = true;
+    table->expire = time(NULL) + index->timeout;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        nss_host_index_table_flush(table);
+    }
+
+    return ret;
+}
+
+struct cache_req_result *
+nss_host_index_get(TALLOC_CTX *mem_ctx,
+                   struct nss_host_index *index,
+                   enum cache_req_type type,
+                   const char *key)
+{
+    struct nss_host_index_table *table;
+    struct cache_req_result *result;
+    struct sss_hash_map *map;
+    char *name = NULL;
+    time_t now;
+    errno_t ret;
+
+    if (index == NULL || key == NULL) {
+        return NULL;
+    }
+
+    if (type == index->hosts.by_name || type == index->hosts.by_addr) {
+        table = &index->hosts;
+    } else if (type == index->networks.by_name
+                   || type == index->networks.by_addr) {
+        table = &index->networks;
+    } else {
+        return NULL;
+    }
+
+    now = time(NULL);
+    if (!table->loaded || table->expire < now) {
+        ret = nss_host_index_table_load(index, table);
+        if (ret != EOK) {
+            return NULL;
+        }
+    }
+
+    if (type == table->by_name) {
+        /* Qualified names are left to cache_req. */
+        if (strchr(key, '@') != NULL) {
+            return NULL;
+        }
+
+        name = sss_tc_utf8_str_tolower(NULL, key);
+        if (name == NULL) {
+            return NULL;
+        }
+
+        key = name;
+        map = table->names;
+    } else {
+        map = table->addrs;
+    }
+
+    result = nss_host_index_map_lookup(map, key);
+    talloc_free(name);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    /* Expired entries are refreshed through cache_req. */
+    if (ldb_msg_find_attr_as_uint64(result->msgs[0],
+                                    SYSDB_CACHE_EXPIRE, 0) < (uint64_t)now) {
+        return NULL;
+    }
+
+    return cache_req_share_result(mem_ctx, result);
+}
+
+void nss_host_index_flush(struct nss_host_index *index)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing the hosts index\n");
+
+    nss_host_index_table_flush(&index->hosts);
+    nss_host_index_table_flush(&index->networks);
+}
@@ -122,6 +122,9 @@ nss_update_initgr_memcache(struct nss_ctx *nctx,
     }
 
     if (changed) {
+        nss_result_cache_flush(nctx->result_cache);
+        nss_initgr_cache_flush(nctx->initgr_cache);
+
         for (i = 0; i < gnum; i++) {
             id = groups[i];
 
@@ -154,6 +157,10 @@ nss_memorycache_invalidate_users(TALLOC_CTX *mem_ctx,
 {
     DEBUG(SSSDBG_TRACE_LIBS, "Invalidating all users in memory cache\n");
     sss_mmap_cache_reset(nctx->pwd_mc_ctx);
+    nss_result_cache_flush(nctx->result_cache);
+    nss_initgr_cache_flush(nctx->initgr_cache);
+    /* SID records of users may be stale as well */
+    sss_mmap_cache_reset(nctx->sid_mc_ctx);
 
     return EOK;
 }
@@ -165,6 +172,9 @@ nss_memorycache_invalidate_groups(TALLOC_CTX *mem_ctx,
 {
     DEBUG(SSSDBG_TRACE_LIBS, "Invalidating all groups in memory cache\n");
     sss_mmap_cache_reset(nctx->grp_mc_ctx);
+    nss_result_cache_flush(nctx->result_cache);
+    nss_initgr_cache_flush(nctx->initgr_cache);
+    sss_mmap_cache_reset(nctx->sid_mc_ctx);
 
     return EOK;
 }
@@ -177,6 +187,8 @@ nss_memorycache_invalidate_initgroups(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_LIBS,
           "Invalidating all initgroup records in memory cache\n");
     sss_mmap_cache_reset(nctx->initgr_mc_ctx);
+    nss_result_cache_flush(nctx->result_cache);
+    nss_initgr_cache_flush(nctx->initgr_cache);
 
     return EOK;
 }
@@ -209,10 +221,179 @@ nss_memorycache_invalidate_group_by_id(TALLOC_CTX *mem_ctx,
           "Invalidating group %u from memory cache\n", gid);
 
     sss_mmap_cache_gr_invalidate_gid(nctx->grp_mc_ctx, gid);
+    nss_result_cache_flush(nctx->result_cache);
+    nss_initgr_cache_flush(nctx->initgr_cache);
 
     return EOK;
 }
 
+static errno_t
+nss_batch_output_names(TALLOC_CTX *mem_ctx,
+                       struct nss_ctx *nctx,
+                       struct sss_domain_info *dom,
+                       const char **names,
+                       struct sized_string **_out_names,
+                       size_t *_num_names)
+{
+    struct sized_string *out_names;
+    struct sized_string *out_name;
+    size_t num_names;
+    size_t i;
+    errno_t ret;
+
+    for (num_names = 0; names != NULL && names[num_names] != NULL;
+         num_names++);
+
+    out_names = talloc_zero_array(mem_ctx, struct sized_string, num_names);
+    if (out_names == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num_names; i++) {
+        ret = sized_output_name(out_names, nctx->rctx, names[i], dom,
+                                &out_name);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "sized_output_name failed for '%s': %d [%s]\n",
+                  names[i], ret, sss_strerror(ret));
+            talloc_free(out_names);
+            return ret;
+        }
+
+        out_names[i] = *out_name;
+    }
+
+    *_out_names = out_names;
+    *_num_names = num_names;
+
+    return EOK;
+}
+
+static errno_t
+nss_memorycache_invalidate_batch(TALLOC_CTX *mem_ctx,
+                                 struct sbus_request *sbus_req,
+                                 struct nss_ctx *nctx,
+                                 const char *domain,
+                                 struct sss_iface_payload *records,
+                                 uint32_t *_num_users,
+                                 uint32_t *_num_groups)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *dom;
+    const char **string_lists[2];
+    uint32_t *id_lists[2];
+    const char **users;
+    const char **groups;
+    uint32_t *uids;
+    uint32_t *gids;
+    struct sized_string *user_names;
+    struct sized_string *group_names;
+    struct sized_string *initgr_names;
+    size_t num_user_names;
+    size_t num_group_names;
+    size_t i;
+    errno_t ret;
+
+    dom = find_domain_by_name(nctx->rctx->domains, domain, true);
+    if (dom == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Unknown domain (%s) requested by provider\n", domain);
+        return ERR_DOMAIN_NOT_FOUND;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* The names point into the records. */
+    ret = sss_iface_payload_unpack_lists(tmp_ctx, records, 2, string_lists,
+                                         2, id_lists);
+    if (ret != EOK) {
+        goto done;
+    }
+    users = string_lists[0];
+    groups = string_lists[1];
+    uids = id_lists[0];
+    gids = id_lists[1];
+
+    ret = nss_batch_output_names(tmp_ctx, nctx, dom, users,
+                                 &user_names, &num_user_names);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = nss_batch_output_names(tmp_ctx, nctx, dom, groups,
+                                 &group_names, &num_group_names);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* initgroups records are keyed by the internal name of the user */
+    initgr_names = talloc_zero_array(tmp_ctx, struct sized_string,
+                                     num_user_names);
+    if (initgr_names == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num_user_names; i++) {
+        to_sized_string(&initgr_names[i], users[i]);
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Invalidating %zu users and %zu groups of [%s] "
+          "in memory cache\n",
+          num_user_names + talloc_array_length(uids),
+          num_group_names + talloc_array_length(gids), domain);
+
+    *_num_users = 0;
+    *_num_groups = 0;
+
+    /* Entries are not indexed by domain, drop all of them. */
+    nss_result_cache_flush(nctx->result_cache);
+    nss_initgr_cache_flush(nctx->initgr_cache);
+
+    if (nctx->pwd_mc_ctx != NULL) {
+        ret = sss_mmap_cache_invalidate_batch(nctx->pwd_mc_ctx,
+                                              user_names, num_user_names,
+                                              uids, talloc_array_length(uids),
+                                              _num_users);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    if (nctx->initgr_mc_ctx != NULL) {
+        ret = sss_mmap_cache_invalidate_batch(nctx->initgr_mc_ctx,
+                                              initgr_names, num_user_names,
+                                              NULL, 0, NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    if (nctx->grp_mc_ctx != NULL) {
+        ret = sss_mmap_cache_invalidate_batch(nctx->grp_mc_ctx,
+                                              group_names, num_group_names,
+                                              gids, talloc_array_length(gids),
+                                              _num_groups);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    /* SID records of the objects may be stale as well */
+    if (*_num_users > 0 || *_num_groups > 0) {
+        sss_mmap_cache_reset(nctx->sid_mc_ctx);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t
 nss_register_backend_iface(struct sbus_connection *conn,
                            struct nss_ctx *nss_ctx)
@@ -226,7 +407,8 @@ nss_register_backend_iface(struct sbus_connection *conn,
             SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllUsers, nss_memorycache_invalidate_users, nss_ctx),
             SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllGroups, nss_memorycache_invalidate_groups, nss_ctx),
             SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateAllInitgroups, nss_memorycache_invalidate_initgroups, nss_ctx),
-            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateGroupById, nss_memorycache_invalidate_group_by_id, nss_ctx)
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateGroupById, nss_memorycache_invalidate_group_by_id, nss_ctx),
+            SBUS_SYNC(METHOD, sssd_nss_MemoryCache, InvalidateBatch, nss_memorycache_invalidate_batch, nss_ctx)
         ),
         SBUS_SIGNALS(SBUS_NO_SIGNALS),
         SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
@@ -0,0 +1,219 @@
+/*
+    SSSD
+
+    NSS Responder - cache of encoded initgroups replies
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "responder/nss/nss_private.h"
+
+struct nss_initgr_cache_entry {
+    struct nss_initgr_cache_entry *prev;
+    struct nss_initgr_cache_entry *next;
+
+    struct nss_initgr_cache *cache;
+    struct nss_initgr_stamp stamp;
+
+    uint32_t *gids;
+    uint32_t num_gids;
+};
+
+struct nss_initgr_cache {
+    hash_table_t *table;
+
+    /* Most recently used entry first. */
+    struct nss_initgr_cache_entry *entries;
+    struct nss_initgr_cache_entry *last;
+    unsigned int num_entries;
+    unsigned int max_entries;
+};
+
+static int nss_initgr_cache_entry_destructor(struct nss_initgr_cache_entry *entry)
+{
+    struct nss_initgr_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+static bool nss_initgr_stamp_equal(const struct nss_initgr_stamp *a,
+                                   const struct nss_initgr_stamp *b)
+{
+    return a->initgr_expire == b->initgr_expire
+        && a->num_msgs == b->num_msgs
+        && a->gid == b->gid
+        && a->orig_gid == b->orig_gid;
+}
+
+errno_t nss_initgr_cache_init(struct nss_ctx *nctx, unsigned int size)
+{
+    struct nss_initgr_cache *cache;
+
+    if (size == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Initgroups cache is disabled.\n");
+        return EOK;
+    }
+
+    cache = talloc_zero(nctx, struct nss_initgr_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->max_entries = size;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Initgroups cache holds up to %u users\n",
+          size);
+
+    nctx->initgr_cache = cache;
+
+    return EOK;
+}
+
+const uint32_t *
+nss_initgr_cache_get(struct nss_initgr_cache *cache,
+                     struct sss_domain_info *domain,
+                     const char *name,
+                     const struct nss_initgr_stamp *stamp,
+                     uint32_t *_num_gids)
+{
+    struct nss_initgr_cache_entry *entry;
+    char *key;
+
+    if (cache == NULL || name == NULL) {
+        return NULL;
+    }
+
+    key = talloc_asprintf(NULL, "%s:%s", domain->name, name);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct nss_initgr_cache_entry);
+    talloc_free(key);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    if (!nss_initgr_stamp_equal(&entry->stamp, stamp)) {
+        /* Group memberships were refreshed since. */
+        talloc_free(entry);
+        return NULL;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    *_num_gids = entry->num_gids;
+    return entry->gids;
+}
+
+void nss_initgr_cache_add(struct nss_initgr_cache *cache,
+                          struct sss_domain_info *domain,
+                          const char *name,
+                          const struct nss_initgr_stamp *stamp,
+                          const uint8_t *gids,
+                          uint32_t num_gids)
+{
+    struct nss_initgr_cache_entry *entry;
+    char *key;
+    errno_t ret;
+
+    if (cache == NULL || name == NULL) {
+        return;
+    }
+
+    key = talloc_asprintf(NULL, "%s:%s", domain->name, name);
+    if (key == NULL) {
+        return;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct nss_initgr_cache_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= cache->max_entries) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct nss_initgr_cache_entry);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    entry->gids = talloc_array(entry, uint32_t, num_gids);
+    if (entry->gids == NULL) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    /* The packet body is not aligned. */
+    memcpy(entry->gids, gids, num_gids * sizeof(uint32_t));
+    entry->num_gids = num_gids;
+
+    ret = sss_ptr_hash_add(cache->table, key, entry,
+                           struct nss_initgr_cache_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    entry->cache = cache;
+    entry->stamp = *stamp;
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    talloc_set_destructor(entry, nss_initgr_cache_entry_destructor);
+
+done:
+    talloc_free(key);
+}
+
+void nss_initgr_cache_flush(struct nss_initgr_cache *cache)
+{
+    if (cache == NULL || cache->num_entries == 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing %u entries of the initgroups cache\n",
+          cache->num_entries);
+
+    while (cache->last != NULL) {
+        talloc_free(cache->last);
+    }
+}
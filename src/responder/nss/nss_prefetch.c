@@ -0,0 +1,354 @@
+/*
+    SSSD
+
+    NSS Responder - refresh frequently requested entries before they expire
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <tevent.h>
+#include <time.h>
+
+#include "util/util.h"
+#include "util/sss_ptr_hash.h"
+#include "db/sysdb.h"
+#include "providers/data_provider.h"
+#include "responder/common/responder.h"
+#include "responder/nss/nss_private.h"
+
+/* How often the hot entries are checked, entries that expire before the
+ * next check are refreshed. */
+#define NSS_PREFETCH_INTERVAL 30
+
+/* Number of tracked entries per refreshed entry. */
+#define NSS_PREFETCH_TRACK_FACTOR 16
+
+struct nss_prefetch_entry {
+    struct nss_prefetch *prefetch;
+    struct sss_domain_info *domain;
+    enum sss_dp_acct_type type;
+    const char *name;
+
+    unsigned int hits;
+    /* 0 if a refresh was already sent. */
+    time_t expire;
+};
+
+struct nss_prefetch {
+    struct nss_ctx *nss_ctx;
+    hash_table_t *table;
+    unsigned int num_entries;
+    unsigned int max_refresh;
+    unsigned int pending;
+};
+
+static int nss_prefetch_entry_destructor(struct nss_prefetch_entry *entry)
+{
+    /* The hash table entry is removed by sss_ptr_hash. */
+    entry->prefetch->num_entries--;
+
+    return 0;
+}
+
+static void nss_prefetch_schedule(struct nss_prefetch *prefetch);
+
+errno_t nss_prefetch_init(struct nss_ctx *nctx, unsigned int max_refresh)
+{
+    struct nss_prefetch *prefetch;
+
+    if (max_refresh == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Prefetching of hot entries is "
+              "disabled.\n");
+        return EOK;
+    }
+
+    prefetch = talloc_zero(nctx, struct nss_prefetch);
+    if (prefetch == NULL) {
+        return ENOMEM;
+    }
+
+    prefetch->table = sss_ptr_hash_create(prefetch, NULL, NULL);
+    if (prefetch->table == NULL) {
+        talloc_free(prefetch);
+        return ENOMEM;
+    }
+
+    prefetch->nss_ctx = nctx;
+    prefetch->max_refresh = max_refresh;
+    nctx->prefetch = prefetch;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Refreshing up to %u hot entries every %d "
+          "seconds\n", max_refresh, NSS_PREFETCH_INTERVAL);
+
+    nss_prefetch_schedule(prefetch);
+
+    return EOK;
+}
+
+void nss_prefetch_hit(struct nss_prefetch *prefetch,
+                      enum sss_mc_type memcache,
+                      struct cache_req_result *result)
+{
+    struct nss_prefetch_entry *entry;
+    enum sss_dp_acct_type type;
+    const char *name;
+    time_t expire;
+    char *key;
+    errno_t ret;
+
+    if (prefetch == NULL || result == NULL || result->count != 1) {
+        return;
+    }
+
+    switch (memcache) {
+    case SSS_MC_PASSWD:
+        type = SSS_DP_USER;
+        break;
+    case SSS_MC_GROUP:
+        type = SSS_DP_GROUP;
+        break;
+    default:
+        return;
+    }
+
+    name = ldb_msg_find_attr_as_string(result->msgs[0], SYSDB_NAME, NULL);
+    if (name == NULL) {
+        return;
+    }
+
+    expire = ldb_msg_find_attr_as_uint64(result->msgs[0],
+                                         SYSDB_CACHE_EXPIRE, 0);
+
+    key = talloc_asprintf(NULL, "%d:%s:%s", type, result->domain->name, name);
+    if (key == NULL) {
+        return;
+    }
+
+    entry = sss_ptr_hash_lookup(prefetch->table, key,
+                                struct nss_prefetch_entry);
+    if (entry != NULL) {
+        entry->hits++;
+        entry->expire = expire;
+        goto done;
+    }
+
+    if (prefetch->num_entries
+            >= prefetch->max_refresh * NSS_PREFETCH_TRACK_FACTOR) {
+        /* Entries without hits are dropped at the next check. */
+        goto done;
+    }
+
+    entry = talloc_zero(prefetch, struct nss_prefetch_entry);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    entry->name = talloc_strdup(entry, name);
+    if (entry->name == NULL) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(prefetch->table, key, entry,
+                           struct nss_prefetch_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    entry->prefetch = prefetch;
+    entry->domain = result->domain;
+    entry->type = type;
+    entry->hits = 1;
+    entry->expire = expire;
+    prefetch->num_entries++;
+    talloc_set_destructor(entry, nss_prefetch_entry_destructor);
+
+done:
+    talloc_free(key);
+}
+
+void nss_prefetch_flush(struct nss_prefetch *prefetch)
+{
+    if (prefetch == NULL) {
+        return;
+    }
+
+    /* The tracked domains may go away, drop all entries. */
+    sss_ptr_hash_delete_all(prefetch->table, true);
+}
+
+static int nss_prefetch_cmp(const void *a, const void *b)
+{
+    const struct nss_prefetch_entry *e1;
+    const struct nss_prefetch_entry *e2;
+
+    e1 = *(struct nss_prefetch_entry * const *)a;
+    e2 = *(struct nss_prefetch_entry * const *)b;
+
+    if (e1->hits == e2->hits) {
+        return 0;
+    }
+
+    return e1->hits < e2->hits ? 1 : -1;
+}
+
+static void nss_prefetch_refresh_done(struct tevent_req *subreq)
+{
+    struct nss_prefetch *prefetch;
+    uint16_t err_maj;
+    uint32_t err_min;
+    const char *err_msg;
+    errno_t ret;
+
+    prefetch = tevent_req_callback_data(subreq, struct nss_prefetch);
+
+    ret = sss_dp_get_account_recv(subreq, subreq, &err_maj, &err_min,
+                                  &err_msg);
+    if (ret != EOK || err_maj != DP_ERR_OK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to refresh hot entry "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
+    talloc_zfree(subreq);
+
+    prefetch->pending--;
+}
+
+static void nss_prefetch_refresh(struct nss_prefetch *prefetch)
+{
+    struct nss_prefetch_entry **entries;
+    struct nss_prefetch_entry *entry;
+    struct tevent_req *subreq;
+    hash_value_t *values;
+    unsigned long count;
+    unsigned long num_due;
+    unsigned long i;
+    unsigned int sent;
+    time_t due;
+    int hret;
+
+    hret = hash_values(prefetch->table, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to list hot entries\n");
+        return;
+    }
+
+    entries = talloc_zero_array(prefetch, struct nss_prefetch_entry *,
+                                count + 1);
+    if (entries == NULL) {
+        talloc_free(values);
+        return;
+    }
+
+    /* Entries that expire before the next check are refreshed now. */
+    due = time(NULL) + 2 * NSS_PREFETCH_INTERVAL;
+    num_due = 0;
+    for (i = 0; i < count; i++) {
+        entry = sss_ptr_get_value(&values[i], struct nss_prefetch_entry);
+        if (entry->expire != 0 && entry->expire <= due) {
+            entries[num_due] = entry;
+            num_due++;
+        }
+    }
+    talloc_free(values);
+
+    qsort(entries, num_due, sizeof(struct nss_prefetch_entry *),
+          nss_prefetch_cmp);
+
+    sent = 0;
+    for (i = 0; i < num_due; i++) {
+        if (prefetch->pending >= prefetch->max_refresh) {
+            /* Previous refreshes did not finish yet. */
+            break;
+        }
+
+        entry = entries[i];
+
+        subreq = sss_dp_get_account_send(prefetch, prefetch->nss_ctx->rctx,
+                                         entry->domain, true, entry->type,
+                                         entry->name, 0, NULL);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to refresh hot entry %s\n",
+                  entry->name);
+            break;
+        }
+
+        tevent_req_set_callback(subreq, nss_prefetch_refresh_done, prefetch);
+        prefetch->pending++;
+        sent++;
+
+        /* The next hit sets the new expiration time. */
+        entry->expire = 0;
+    }
+
+    talloc_free(entries);
+
+    if (sent > 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Refreshing %u hot entries\n", sent);
+    }
+}
+
+static void nss_prefetch_decay(struct nss_prefetch *prefetch)
+{
+    struct nss_prefetch_entry *entry;
+    hash_value_t *values;
+    unsigned long count;
+    unsigned long i;
+    int hret;
+
+    hret = hash_values(prefetch->table, &count, &values);
+    if (hret != HASH_SUCCESS) {
+        return;
+    }
+
+    /* Halve the hits so that only currently used entries stay hot. */
+    for (i = 0; i < count; i++) {
+        entry = sss_ptr_get_value(&values[i], struct nss_prefetch_entry);
+        entry->hits /= 2;
+        if (entry->hits == 0) {
+            talloc_free(entry);
+        }
+    }
+
+    talloc_free(values);
+}
+
+static void nss_prefetch_timeout(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval current_time,
+                                 void *pvt)
+{
+    struct nss_prefetch *prefetch;
+
+    prefetch = talloc_get_type(pvt, struct nss_prefetch);
+
+    nss_prefetch_refresh(prefetch);
+    nss_prefetch_decay(prefetch);
+    nss_prefetch_schedule(prefetch);
+}
+
+static void nss_prefetch_schedule(struct nss_prefetch *prefetch)
+{
+    struct tevent_timer *te;
+    struct timeval tv;
+
+    tv = tevent_timeval_current_ofs(NSS_PREFETCH_INTERVAL, 0);
+    te = tevent_add_timer(prefetch->nss_ctx->rctx->ev, prefetch, tv,
+                          nss_prefetch_timeout, prefetch);
+    if (te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule refresh of hot "
+              "entries\n");
+    }
+}
@@ -43,6 +43,9 @@ struct nss_enum_ctx {
     struct sysdb_netgroup_ctx **netgroup;
     size_t netgroup_count;
 
+    /* Triples of the netgroup keyed by nss_netgr_triple_key(). */
+    hash_table_t *triples;
+
     /* Ongoing cache request that is constructing enumeration result. */
     struct tevent_req *ongoing;
 
@@ -54,6 +57,20 @@ struct nss_enum_ctx {
     struct setent_req_list *notify_list;
 };
 
+struct nss_result_cache;
+struct nss_prefetch;
+struct nss_initgr_cache;
+struct nss_host_index;
+
+/* Data of the user entry an initgroups reply was built from. The reply is
+ * still valid as long as none of them changes. */
+struct nss_initgr_stamp {
+    uint64_t initgr_expire;
+    unsigned int num_msgs;
+    uint32_t gid;
+    uint32_t orig_gid;
+};
+
 struct nss_state_ctx {
     struct nss_enum_index pwent;
     struct nss_enum_index grent;
@@ -91,8 +108,24 @@ struct nss_ctx {
     struct sss_mc_ctx *pwd_mc_ctx;
     struct sss_mc_ctx *grp_mc_ctx;
     struct sss_mc_ctx *initgr_mc_ctx;
+    struct sss_mc_ctx *sid_mc_ctx;
+    struct sss_mc_ctx *svc_mc_ctx;
+    struct sss_mc_ctx *host_mc_ctx;
     uid_t mc_uid;
     gid_t mc_gid;
+
+    /* Recently returned lookup results, NULL if disabled. */
+    struct nss_result_cache *result_cache;
+
+    /* Frequently requested entries refreshed ahead, NULL if disabled. */
+    struct nss_prefetch *prefetch;
+
+    /* Encoded group lists of initgroups replies, NULL if disabled. */
+    struct nss_initgr_cache *initgr_cache;
+
+    /* All cached hosts and networks by name and address, NULL if
+     * disabled. */
+    struct nss_host_index *host_index;
 };
 
 struct sss_cmd_table *get_nss_cmds(void);
@@ -143,6 +176,93 @@ nss_setnetgrent_send(TALLOC_CTX *mem_ctx,
 errno_t
 nss_setnetgrent_recv(struct tevent_req *req);
 
+struct tevent_req *
+nss_innetgr_send(TALLOC_CTX *mem_ctx,
+                 struct tevent_context *ev,
+                 struct cli_ctx *cli_ctx,
+                 const char *netgroup,
+                 const char *host,
+                 const char *user,
+                 const char *domain);
+
+errno_t
+nss_innetgr_recv(struct tevent_req *req, bool *_is_member);
+
+/* Result cache. */
+
+errno_t nss_result_cache_init(struct nss_ctx *nctx,
+                              unsigned int size,
+                              time_t timeout);
+
+/* Returns a shared copy of the cached result or NULL if there is none. */
+struct cache_req_result *
+nss_result_cache_get(TALLOC_CTX *mem_ctx,
+                     struct nss_result_cache *cache,
+                     enum cache_req_type type,
+                     const char *name,
+                     uint32_t id);
+
+/* The cache takes over *_result and replaces it with a shared copy
+ * allocated on mem_ctx. */
+errno_t nss_result_cache_add(TALLOC_CTX *mem_ctx,
+                             struct nss_result_cache *cache,
+                             enum cache_req_type type,
+                             const char *name,
+                             uint32_t id,
+                             struct cache_req_result **_result);
+
+void nss_result_cache_flush(struct nss_result_cache *cache);
+
+/* Refresh of hot entries. */
+
+errno_t nss_prefetch_init(struct nss_ctx *nctx, unsigned int max_refresh);
+
+/* Counts a returned user or group, the hottest entries are refreshed in the
+ * data provider shortly before they expire. */
+void nss_prefetch_hit(struct nss_prefetch *prefetch,
+                      enum sss_mc_type memcache,
+                      struct cache_req_result *result);
+
+void nss_prefetch_flush(struct nss_prefetch *prefetch);
+
+/* Initgroups cache. */
+
+errno_t nss_initgr_cache_init(struct nss_ctx *nctx, unsigned int size);
+
+/* Returns the GIDs of the reply built from the same user entry or NULL. The
+ * array is valid until the cache is modified. */
+const uint32_t *
+nss_initgr_cache_get(struct nss_initgr_cache *cache,
+                     struct sss_domain_info *domain,
+                     const char *name,
+                     const struct nss_initgr_stamp *stamp,
+                     uint32_t *_num_gids);
+
+void nss_initgr_cache_add(struct nss_initgr_cache *cache,
+                          struct sss_domain_info *domain,
+                          const char *name,
+                          const struct nss_initgr_stamp *stamp,
+                          const uint8_t *gids,
+                          uint32_t num_gids);
+
+void nss_initgr_cache_flush(struct nss_initgr_cache *cache);
+
+/* Hosts index. */
+
+errno_t nss_host_index_init(struct nss_ctx *nctx, time_t timeout);
+
+/* Returns a shared copy of the host or network stored under the name or
+ * address @key or NULL if it is not indexed or has expired. The index is
+ * loaded from the cache when it is older than its timeout. */
+struct cache_req_result *
+nss_host_index_get(TALLOC_CTX *mem_ctx,
+                   struct nss_host_index *index,
+                   enum cache_req_type type,
+                   const char *key);
+
+/* The index is loaded again by the next lookup. */
+void nss_host_index_flush(struct nss_host_index *index);
+
 /* Utils. */
 
 const char *
@@ -99,6 +99,47 @@ done:
     nss_protocol_done(cli_ctx, ret);
 }
 
+void nss_protocol_mc_store_reply(struct sss_mc_ctx **_mcc,
+                                 struct nss_cmd_ctx *cmd_ctx,
+                                 struct sss_packet *packet,
+                                 const char *key2)
+{
+    struct sized_string key;
+    struct sized_string sz_key2;
+    uint32_t num_results;
+    size_t body_len;
+    uint8_t *body;
+    errno_t ret;
+
+    if (*_mcc == NULL || cmd_ctx->mc_key == NULL || cmd_ctx->enumeration) {
+        return;
+    }
+
+    sss_packet_get_body(packet, &body, &body_len);
+    if (body_len <= 2 * sizeof(uint32_t)) {
+        return;
+    }
+
+    /* only answers with exactly one result can be replayed */
+    SAFEALIGN_COPY_UINT32(&num_results, body, NULL);
+    if (num_results != 1) {
+        return;
+    }
+
+    to_sized_string(&key, cmd_ctx->mc_key);
+    to_sized_string(&sz_key2, key2 == NULL ? cmd_ctx->mc_key : key2);
+
+    /* skip the number of results and the reserved field */
+    ret = sss_mmap_cache_reply_store(_mcc, &key, &sz_key2,
+                                     body + 2 * sizeof(uint32_t),
+                                     body_len - 2 * sizeof(uint32_t));
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store %s in mmap cache [%d]: %s!\n",
+              cmd_ctx->mc_key, ret, sss_strerror(ret));
+    }
+}
+
 errno_t
 nss_protocol_parse_name(struct cli_ctx *cli_ctx, const char **_rawname)
 {
@@ -246,6 +287,134 @@ nss_protocol_parse_id_ex(struct cli_ctx *cli_ctx, uint32_t *_id,
     return EOK;
 }
 
+errno_t
+nss_protocol_parse_id_list(TALLOC_CTX *mem_ctx,
+                           struct cli_ctx *cli_ctx,
+                           uint32_t **_ids,
+                           uint32_t *_count)
+{
+    struct cli_protocol *pctx;
+    uint32_t *ids;
+    uint32_t count;
+    uint8_t *body;
+    size_t blen;
+    size_t rp = 0;
+    uint32_t i;
+
+    pctx = talloc_get_type(cli_ctx->protocol_ctx, struct cli_protocol);
+
+    sss_packet_get_body(pctx->creq->in, &body, &blen);
+
+    if (blen < sizeof(uint32_t)) {
+        return EINVAL;
+    }
+
+    SAFEALIGN_COPY_UINT32(&count, body, &rp);
+    if (count == 0 || count > SSS_NSS_MULTI_MAX_ENTRIES) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid number of entries [%"PRIu32"]\n",
+              count);
+        return EINVAL;
+    }
+
+    if (blen != sizeof(uint32_t) * (count + 1)) {
+        return EINVAL;
+    }
+
+    ids = talloc_array(mem_ctx, uint32_t, count);
+    if (ids == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        SAFEALIGN_COPY_UINT32(&ids[i], body + rp, &rp);
+    }
+
+    *_ids = ids;
+    *_count = count;
+
+    return EOK;
+}
+
+errno_t
+nss_protocol_parse_name_list(TALLOC_CTX *mem_ctx,
+                             struct cli_ctx *cli_ctx,
+                             const char ***_rawnames,
+                             uint32_t *_count)
+{
+    struct cli_protocol *pctx;
+    const char **rawnames;
+    uint32_t count;
+    uint8_t *body;
+    size_t blen;
+    size_t rp = 0;
+    size_t len;
+    uint32_t i;
+
+    pctx = talloc_get_type(cli_ctx->protocol_ctx, struct cli_protocol);
+
+    sss_packet_get_body(pctx->creq->in, &body, &blen);
+
+    if (blen <= sizeof(uint32_t)) {
+        return EINVAL;
+    }
+
+    SAFEALIGN_COPY_UINT32(&count, body, &rp);
+    if (count == 0 || count > SSS_NSS_MULTI_MAX_ENTRIES) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid number of entries [%"PRIu32"]\n",
+              count);
+        return EINVAL;
+    }
+
+    /* If not terminated fail. */
+    if (body[blen - 1] != '\0') {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Body is not null terminated!\n");
+        return EINVAL;
+    }
+
+    rawnames = talloc_array(mem_ctx, const char *, count);
+    if (rawnames == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (rp >= blen) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Body contains less names than "
+                  "announced!\n");
+            goto fail;
+        }
+
+        len = strlen((const char *)body + rp);
+        if (len == 0) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "An empty name was provided!\n");
+            goto fail;
+        }
+
+        /* If the name isn't valid UTF-8, fail */
+        if (!sss_utf8_check(body + rp, len)) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Name is not UTF-8 string!\n");
+            goto fail;
+        }
+
+        rawnames[i] = (const char *)body + rp;
+        rp += len + 1;
+    }
+
+    if (rp != blen) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Body contains more names than "
+              "announced!\n");
+        goto fail;
+    }
+
+    *_rawnames = rawnames;
+    *_count = count;
+
+    return EOK;
+
+fail:
+    talloc_free(rawnames);
+    return EINVAL;
+}
+
 errno_t
 nss_protocol_parse_limit(struct cli_ctx *cli_ctx, uint32_t *_limit)
 {
@@ -309,6 +478,68 @@ nss_protocol_parse_svc_name(struct cli_ctx *cli_ctx,
     return EOK;
 }
 
+errno_t
+nss_protocol_parse_innetgr(struct cli_ctx *cli_ctx,
+                           const char **_netgroup,
+                           const char **_host,
+                           const char **_user,
+                           const char **_domain)
+{
+    struct cli_protocol *pctx;
+    const char *fields[4];
+    uint32_t mask;
+    uint8_t *body;
+    size_t blen;
+    size_t len;
+    size_t pos;
+    int i;
+
+    pctx = talloc_get_type(cli_ctx->protocol_ctx, struct cli_protocol);
+
+    sss_packet_get_body(pctx->creq->in, &body, &blen);
+
+    /* Mask followed by netgroup, host, user and domain. */
+    if (blen < sizeof(uint32_t) + 4 || body[blen - 1] != '\0') {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Invalid innetgr request\n");
+        return EINVAL;
+    }
+
+    pos = 0;
+    SAFEALIGN_COPY_UINT32(&mask, body, &pos);
+
+    for (i = 0; i < 4; i++) {
+        if (pos >= blen) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Missing innetgr request field\n");
+            return EINVAL;
+        }
+
+        len = strnlen((const char *)body + pos, blen - pos);
+        if (pos + len >= blen) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Field is not null terminated\n");
+            return EINVAL;
+        }
+
+        if (!sss_utf8_check(body + pos, len)) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Field is not UTF-8 string\n");
+            return EINVAL;
+        }
+
+        fields[i] = (const char *)body + pos;
+        pos += len + 1;
+    }
+
+    if (fields[0][0] == '\0') {
+        return EINVAL;
+    }
+
+    *_netgroup = fields[0];
+    *_host = (mask & SSS_INNETGR_HOST) ? fields[1] : NULL;
+    *_user = (mask & SSS_INNETGR_USER) ? fields[2] : NULL;
+    *_domain = (mask & SSS_INNETGR_DOMAIN) ? fields[3] : NULL;
+
+    return EOK;
+}
+
 errno_t
 nss_protocol_parse_svc_port(struct cli_ctx *cli_ctx,
                             uint16_t *_port,
@@ -442,6 +673,48 @@ nss_protocol_parse_sid(struct cli_ctx *cli_ctx,
     return EOK;
 }
 
+errno_t
+nss_protocol_parse_sid_list(TALLOC_CTX *mem_ctx,
+                            struct cli_ctx *cli_ctx,
+                            const char ***_sids,
+                            uint32_t *_count)
+{
+    struct nss_ctx *nss_ctx;
+    const char **sids;
+    uint32_t count;
+    uint8_t *bin_sid;
+    size_t bin_len;
+    uint32_t i;
+    enum idmap_error_code err;
+    errno_t ret;
+
+    nss_ctx = talloc_get_type(cli_ctx->rctx->pvt_ctx, struct nss_ctx);
+
+    ret = nss_protocol_parse_name_list(mem_ctx, cli_ctx, &sids, &count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* If one of the entries isn't a SID, fail */
+    for (i = 0; i < count; i++) {
+        err = sss_idmap_sid_to_bin_sid(nss_ctx->idmap_ctx, sids[i], &bin_sid,
+                                       &bin_len);
+        if (err != IDMAP_SUCCESS) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Unable to convert SID to binary [%s].\n", sids[i]);
+            talloc_free(sids);
+            return EINVAL;
+        }
+
+        sss_idmap_free_bin_sid(nss_ctx->idmap_ctx, bin_sid);
+    }
+
+    *_sids = sids;
+    *_count = count;
+
+    return EOK;
+}
+
 errno_t
 nss_protocol_parse_addr(struct cli_ctx *cli_ctx,
                         uint32_t *_af,
@@ -32,6 +32,11 @@
 
 struct nss_cmd_ctx;
 
+/* attributes needed to store the result of a SID lookup in the SID
+ * memory cache */
+#define NSS_SID_MC_ATTRS SYSDB_NAME, ORIGINALAD_PREFIX SYSDB_NAME, \
+                         SYSDB_UIDNUM, SYSDB_GIDNUM
+
 /**
  * Fill SSSD response packet.
  *
@@ -64,8 +69,15 @@ struct nss_cmd_ctx {
     /* For services. */
     const char *svc_protocol;
 
+    /* Memory cache key of service and host lookups. */
+    const char *mc_key;
+
     /* For SID lookups. */
     enum sss_id_type sid_id_type;
+    uint32_t sid_id;
+
+    /* For innetgr. */
+    bool innetgr_member;
 };
 
 /**
@@ -100,6 +112,26 @@ errno_t
 nss_protocol_parse_id_ex(struct cli_ctx *cli_ctx, uint32_t *_id,
                          uint32_t *_flags);
 
+/* Parse the body of the *_MULTI requests, the names point into the request
+ * packet. */
+errno_t
+nss_protocol_parse_id_list(TALLOC_CTX *mem_ctx,
+                           struct cli_ctx *cli_ctx,
+                           uint32_t **_ids,
+                           uint32_t *_count);
+
+errno_t
+nss_protocol_parse_name_list(TALLOC_CTX *mem_ctx,
+                             struct cli_ctx *cli_ctx,
+                             const char ***_rawnames,
+                             uint32_t *_count);
+
+errno_t
+nss_protocol_parse_sid_list(TALLOC_CTX *mem_ctx,
+                            struct cli_ctx *cli_ctx,
+                            const char ***_sids,
+                            uint32_t *_count);
+
 errno_t
 nss_protocol_parse_limit(struct cli_ctx *cli_ctx, uint32_t *_limit);
 
@@ -113,6 +145,13 @@ nss_protocol_parse_svc_port(struct cli_ctx *cli_ctx,
                             uint16_t *_port,
                             const char **_protocol);
 
+errno_t
+nss_protocol_parse_innetgr(struct cli_ctx *cli_ctx,
+                           const char **_netgroup,
+                           const char **_host,
+                           const char **_user,
+                           const char **_domain);
+
 errno_t
 nss_protocol_parse_cert(struct cli_ctx *cli_ctx,
                         const char **_derb64);
@@ -127,6 +166,16 @@ nss_protocol_parse_addr(struct cli_ctx *cli_ctx,
 			uint32_t *_addrlen,
 			uint8_t **_addr);
 
+/**
+ * Store the single result of a services or hosts reply in the memory cache.
+ * The record is found by cmd_ctx->mc_key and key2, which may be NULL if
+ * there is no second key.
+ */
+void nss_protocol_mc_store_reply(struct sss_mc_ctx **_mcc,
+                                 struct nss_cmd_ctx *cmd_ctx,
+                                 struct sss_packet *packet,
+                                 const char *key2);
+
 /* Create response packet. */
 
 errno_t
@@ -159,6 +208,12 @@ nss_protocol_fill_setnetgrent(struct nss_ctx *nss_ctx,
                               struct sss_packet *packet,
                               struct cache_req_result *result);
 
+errno_t
+nss_protocol_fill_innetgr(struct nss_ctx *nss_ctx,
+                          struct nss_cmd_ctx *cmd_ctx,
+                          struct sss_packet *packet,
+                          struct cache_req_result *result);
+
 errno_t
 nss_protocol_fill_svcent(struct nss_ctx *nss_ctx,
                          struct nss_cmd_ctx *cmd_ctx,
@@ -112,6 +112,9 @@ nss_get_group_ghosts(struct sss_domain_info *domain,
     return el;
 }
 
+/* Member names are formatted first so that the packet is grown only once
+ * for all of them, large groups would otherwise be reallocated and moved
+ * over and over while being appended name by name. */
 static errno_t
 nss_protocol_fill_members(struct sss_packet *packet,
                           struct nss_ctx *nss_ctx,
@@ -125,9 +128,11 @@ nss_protocol_fill_members(struct sss_packet *packet,
     struct resp_ctx *rctx = nss_ctx->rctx;
     struct ldb_message_element *members[2];
     struct ldb_message_element *el;
-    struct sized_string *name;
+    struct sized_string **names;
     const char *member_name;
     uint32_t num_members;
+    size_t max_members;
+    size_t members_len;
     size_t body_len;
     uint8_t *body;
     errno_t ret;
@@ -141,9 +146,34 @@ nss_protocol_fill_members(struct sss_packet *packet,
     members[0] = nss_get_group_members(domain, msg);
     members[1] = nss_get_group_ghosts(domain, msg, group_name);
 
-    sss_packet_get_body(packet, &body, &body_len);
+    max_members = 0;
+    for (i = 0; i < sizeof(members) / sizeof(members[0]); i++) {
+        if (members[i] != NULL) {
+            max_members += members[i]->num_values;
+        }
+    }
+
+    /* Huge groups are returned as if they were empty so that lookups of
+     * them stay cheap, the entry stored in the memory cache is also empty. */
+    if (domain->ignore_group_members_above > 0
+            && max_members > domain->ignore_group_members_above) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Group [%s] has %zu members which is more than %u, "
+              "members are not returned\n", group_name, max_members,
+              domain->ignore_group_members_above);
+        num_members = 0;
+        ret = EOK;
+        goto done;
+    }
+
+    names = talloc_array(tmp_ctx, struct sized_string *, max_members);
+    if (names == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
 
     num_members = 0;
+    members_len = 0;
     for (i = 0; i < sizeof(members) / sizeof(members[0]); i++) {
         el = members[i];
         if (el == NULL) {
@@ -163,25 +193,31 @@ nss_protocol_fill_members(struct sss_packet *packet,
                 }
             }
 
-            ret = sized_domain_name(tmp_ctx, rctx, member_name, &name);
+            ret = sized_domain_name(names, rctx, member_name,
+                                    &names[num_members]);
             if (ret != EOK) {
                 DEBUG(SSSDBG_OP_FAILURE, "Unable to get sized name [%d]: %s\n",
                       ret, sss_strerror(ret));
+                num_members = 0;
                 goto done;
             }
 
-            ret = sss_packet_grow(packet, name->len);
-            if (ret != EOK) {
-                goto done;
-            }
-
-            sss_packet_get_body(packet, &body, &body_len);
-            SAFEALIGN_SET_STRING(&body[*_rp], name->str, name->len, _rp);
-
+            members_len += names[num_members]->len;
             num_members++;
         }
     }
 
+    ret = sss_packet_grow(packet, members_len);
+    if (ret != EOK) {
+        num_members = 0;
+        goto done;
+    }
+
+    sss_packet_get_body(packet, &body, &body_len);
+    for (i = 0; i < num_members; i++) {
+        SAFEALIGN_SET_STRING(&body[*_rp], names[i]->str, names[i]->len, _rp);
+    }
+
     ret = EOK;
 
 done:
@@ -204,6 +240,7 @@ nss_protocol_fill_grent(struct nss_ctx *nss_ctx,
     uint32_t gid;
     uint32_t num_results;
     uint32_t num_members;
+    uint32_t strs_len;
     char *members;
     size_t members_size;
     size_t rp;
@@ -228,6 +265,7 @@ nss_protocol_fill_grent(struct nss_ctx *nss_ctx,
     rp = 2 * sizeof(uint32_t);
 
     num_results = 0;
+    strs_len = 0;
     for (i = 0; i < result->count; i++) {
         talloc_free_children(tmp_ctx);
         msg = result->msgs[i];
@@ -272,6 +310,8 @@ nss_protocol_fill_grent(struct nss_ctx *nss_ctx,
         sss_packet_get_body(packet, &body, &body_len);
         SAFEALIGN_SET_UINT32(&body[rp_num_members], num_members, NULL);
 
+        /* Length of name, password and member strings of this group. */
+        strs_len = rp - rp_num_members - sizeof(uint32_t);
         num_results++;
 
         /* Do not store entry in memory cache during enumeration or when
@@ -302,6 +342,51 @@ done:
     }
 
     sss_packet_get_body(packet, &body, &body_len);
+    SAFEALIGN_COPY_UINT32(body, &num_results, NULL);
+
+    /* The reserved field carries the length of all strings if there is a
+     * single group in the reply, which lets the client tell in advance
+     * whether the group fits into its buffer. Zero means unknown. */
+    if (num_results != 1) {
+        strs_len = 0;
+    }
+    SAFEALIGN_COPY_UINT32(body + sizeof(uint32_t), &strs_len, NULL);
+
+    return EOK;
+}
+
+static errno_t
+nss_protocol_initgr_finish(struct nss_ctx *nss_ctx,
+                           struct nss_cmd_ctx *cmd_ctx,
+                           struct sss_packet *packet,
+                           struct cache_req_result *result,
+                           uint32_t num_results)
+{
+    struct sized_string rawname;
+    struct sized_string unique_name;
+    uint8_t *body;
+    size_t body_len;
+    errno_t ret;
+
+    sss_packet_get_body(packet, &body, &body_len);
+
+    if (nss_ctx->initgr_mc_ctx
+                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0) {
+        to_sized_string(&rawname, cmd_ctx->rawname);
+        to_sized_string(&unique_name, result->lookup_name);
+
+        ret = sss_mmap_cache_initgr_store(&nss_ctx->initgr_mc_ctx, &rawname,
+                                          &unique_name, num_results,
+                                          body + 2 * sizeof(uint32_t));
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Failed to store initgroups %s (%s) in mem-cache [%d]: %s!\n",
+                  rawname.str, result->domain->name, ret, sss_strerror(ret));
+            sss_packet_set_size(packet, 0);
+            return ret;
+        }
+    }
+
     SAFEALIGN_COPY_UINT32(body, &num_results, NULL);
     SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), 0, NULL); /* reserved */
 
@@ -318,9 +403,9 @@ nss_protocol_fill_initgr(struct nss_ctx *nss_ctx,
     struct ldb_message *user;
     struct ldb_message *msg;
     struct ldb_message *primary_group_msg;
+    struct nss_initgr_stamp stamp;
+    const uint32_t *cached_gids;
     const char *posix;
-    struct sized_string rawname;
-    struct sized_string unique_name;
     uint32_t num_results;
     uint8_t *body;
     size_t body_len;
@@ -336,6 +421,37 @@ nss_protocol_fill_initgr(struct nss_ctx *nss_ctx,
 
     domain = result->domain;
 
+    user = result->msgs[0];
+    gid = sss_view_ldb_msg_find_attr_as_uint64(domain, user, SYSDB_GIDNUM, 0);
+    orig_gid = sss_view_ldb_msg_find_attr_as_uint64(domain, user,
+                                                    SYSDB_PRIMARY_GROUP_GIDNUM,
+                                                    0);
+
+    /* The group list changes only when the memberships are refreshed,
+     * which also moves the initgroups expiration time. */
+    stamp.initgr_expire = ldb_msg_find_attr_as_uint64(user,
+                                                      SYSDB_INITGR_EXPIRE, 0);
+    stamp.num_msgs = result->count;
+    stamp.gid = gid;
+    stamp.orig_gid = orig_gid;
+
+    cached_gids = nss_initgr_cache_get(nss_ctx->initgr_cache, domain,
+                                       result->lookup_name, &stamp,
+                                       &num_results);
+    if (cached_gids != NULL) {
+        ret = sss_packet_grow(packet, (2 + num_results) * sizeof(uint32_t));
+        if (ret != EOK) {
+            return ret;
+        }
+        sss_packet_get_body(packet, &body, &body_len);
+
+        memcpy(body + 2 * sizeof(uint32_t), cached_gids,
+               num_results * sizeof(uint32_t));
+
+        return nss_protocol_initgr_finish(nss_ctx, cmd_ctx, packet, result,
+                                          num_results);
+    }
+
     /* num_results, reserved + gids */
     ret = sss_packet_grow(packet, (2 + result->count) * sizeof(uint32_t));
     if (ret != EOK) {
@@ -344,12 +460,6 @@ nss_protocol_fill_initgr(struct nss_ctx *nss_ctx,
     sss_packet_get_body(packet, &body, &body_len);
     rp = 2 * sizeof(uint32_t);
 
-    user = result->msgs[0];
-    gid = sss_view_ldb_msg_find_attr_as_uint64(domain, user, SYSDB_GIDNUM, 0);
-    orig_gid = sss_view_ldb_msg_find_attr_as_uint64(domain, user,
-                                                    SYSDB_PRIMARY_GROUP_GIDNUM,
-                                                    0);
-
     /* Try to get the real gid in case the primary group's gid was overridden. */
     ret = sysdb_search_group_by_origgid(NULL, domain, orig_gid, NULL,
                                         &primary_group_msg);
@@ -405,26 +515,9 @@ nss_protocol_fill_initgr(struct nss_ctx *nss_ctx,
         num_results++;
     }
 
-    if (nss_ctx->initgr_mc_ctx
-                && (cmd_ctx->flags & SSS_NSS_EX_FLAG_INVALIDATE_CACHE) == 0) {
-        to_sized_string(&rawname, cmd_ctx->rawname);
-        to_sized_string(&unique_name, result->lookup_name);
+    nss_initgr_cache_add(nss_ctx->initgr_cache, domain, result->lookup_name,
+                         &stamp, body + 2 * sizeof(uint32_t), num_results);
 
-        ret = sss_mmap_cache_initgr_store(&nss_ctx->initgr_mc_ctx, &rawname,
-                                          &unique_name, num_results,
-                                          body + 2 * sizeof(uint32_t));
-        if (ret != EOK) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "Failed to store initgroups %s (%s) in mem-cache [%d]: %s!\n",
-                  rawname.str, domain->name, ret, sss_strerror(ret));
-            sss_packet_set_size(packet, 0);
-            return ret;
-        }
-    }
-
-    sss_packet_get_body(packet, &body, &body_len);
-    SAFEALIGN_COPY_UINT32(body, &num_results, NULL);
-    SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), 0, NULL); /* reserved */
-
-    return EOK;
+    return nss_protocol_initgr_finish(nss_ctx, cmd_ctx, packet, result,
+                                      num_results);
 }
@@ -22,6 +22,7 @@
 
 #include "db/sysdb.h"
 #include "db/sysdb_iphosts.h"
+#include "util/mmap_cache.h"
 #include "responder/nss/nss_protocol.h"
 
 static errno_t
@@ -185,6 +186,7 @@ nss_protocol_fill_hostent(struct nss_ctx *nss_ctx,
     struct sized_string name;
     struct sized_string *aliases;
     struct sized_string *addresses;
+    const char *mc_key2 = NULL;
     uint32_t num_aliases;
     uint32_t num_addresses;
     uint32_t num_results;
@@ -278,6 +280,12 @@ nss_protocol_fill_hostent(struct nss_ctx *nss_ctx,
                                  &rp);
         }
 
+        /* the result of a lookup by address is also the answer to a lookup
+         * of its name */
+        if (cmd_ctx->type == CACHE_REQ_IP_HOST_BY_ADDR && num_results == 0) {
+            mc_key2 = talloc_asprintf(cmd_ctx, MC_HOST_BY_NAME_KEY, name.str);
+        }
+
         num_results++;
     }
 
@@ -295,5 +303,8 @@ done:
     SAFEALIGN_COPY_UINT32(body, &num_results, NULL);
     SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), 0, NULL); /* reserved */
 
+    nss_protocol_mc_store_reply(&nss_ctx->host_mc_ctx, cmd_ctx, packet,
+                                mc_key2);
+
     return EOK;
 }
@@ -208,3 +208,28 @@ nss_protocol_fill_setnetgrent(struct nss_ctx *nss_ctx,
 
     return EOK;
 }
+
+errno_t
+nss_protocol_fill_innetgr(struct nss_ctx *nss_ctx,
+                          struct nss_cmd_ctx *cmd_ctx,
+                          struct sss_packet *packet,
+                          struct cache_req_result *result)
+{
+    size_t body_len;
+    uint8_t *body;
+    errno_t ret;
+
+    /* Three fields (length, reserved and the membership). */
+    ret = sss_packet_grow(packet, 3 * sizeof(uint32_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    sss_packet_get_body(packet, &body, &body_len);
+    SAFEALIGN_SET_UINT32(body, 1, NULL);
+    SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), 0, NULL); /* reserved */
+    SAFEALIGN_SET_UINT32(body + 2 * sizeof(uint32_t),
+                         cmd_ctx->innetgr_member ? 1 : 0, NULL);
+
+    return EOK;
+}
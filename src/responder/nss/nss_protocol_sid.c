@@ -19,6 +19,7 @@
 */
 
 #include "util/crypto/sss_crypto.h"
+#include "util/mmap_cache.h"
 #include "responder/nss/nss_protocol.h"
 
 static errno_t
@@ -87,6 +88,12 @@ nss_get_id_type(struct nss_cmd_ctx *cmd_ctx,
     return EOK;
 }
 
+static void
+nss_sid_mc_store(struct nss_ctx *nss_ctx,
+                 struct nss_cmd_ctx *cmd_ctx,
+                 struct cache_req_result *result,
+                 enum sss_id_type id_type);
+
 errno_t
 nss_protocol_fill_sid(struct nss_ctx *nss_ctx,
                       struct nss_cmd_ctx *cmd_ctx,
@@ -128,6 +135,8 @@ nss_protocol_fill_sid(struct nss_ctx *nss_ctx,
     SAFEALIGN_SET_UINT32(&body[rp], id_type, &rp);
     SAFEALIGN_SET_STRING(&body[rp], sz_sid.str, sz_sid.len, &rp);
 
+    nss_sid_mc_store(nss_ctx, cmd_ctx, result, id_type);
+
     return EOK;
 }
 
@@ -390,6 +399,95 @@ nss_get_ad_name(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static void
+nss_sid_mc_store(struct nss_ctx *nss_ctx,
+                 struct nss_cmd_ctx *cmd_ctx,
+                 struct cache_req_result *result,
+                 enum sss_id_type id_type)
+{
+    struct ldb_message *msg;
+    struct sized_string *sz_name = NULL;
+    struct sized_string sz_sid;
+    struct sized_string sz_key;
+    const char *key_fmt;
+    const char *sid;
+    char key[32];
+    uint64_t id64;
+    uint32_t id;
+    errno_t ret;
+
+    if (nss_ctx->sid_mc_ctx == NULL || result->well_known_object
+            || result->ldb_result == NULL || result->count != 1) {
+        return;
+    }
+
+    switch (cmd_ctx->type) {
+    case CACHE_REQ_OBJECT_BY_ID:
+        key_fmt = MC_SID_BY_ID_KEY;
+        break;
+    case CACHE_REQ_USER_BY_ID:
+        key_fmt = MC_SID_BY_UID_KEY;
+        break;
+    case CACHE_REQ_GROUP_BY_ID:
+        key_fmt = MC_SID_BY_GID_KEY;
+        break;
+    case CACHE_REQ_OBJECT_BY_NAME:
+    case CACHE_REQ_OBJECT_BY_SID:
+        key_fmt = NULL;
+        break;
+    default:
+        return;
+    }
+
+    msg = result->msgs[0];
+
+    sid = ldb_msg_find_attr_as_string(msg, SYSDB_SID_STR, NULL);
+    if (sid == NULL) {
+        return;
+    }
+    to_sized_string(&sz_sid, sid);
+
+    if (id_type == SSS_ID_TYPE_GID) {
+        id64 = ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0);
+    } else {
+        id64 = ldb_msg_find_attr_as_uint64(msg, SYSDB_UIDNUM, 0);
+    }
+    id = id64 >= UINT32_MAX ? 0 : (uint32_t)id64;
+
+    ret = nss_get_ad_name(cmd_ctx, nss_ctx->rctx, result, &sz_name);
+    if (ret != EOK) {
+        return;
+    }
+
+    if (key_fmt != NULL) {
+        ret = snprintf(key, sizeof(key), key_fmt, cmd_ctx->sid_id);
+        if (ret < 0 || ret >= sizeof(key)) {
+            goto done;
+        }
+        to_sized_string(&sz_key, key);
+
+        ret = sss_mmap_cache_sid_store(&nss_ctx->sid_mc_ctx, &sz_key,
+                                       &sz_sid, sz_name, id_type, id);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Failed to store SID of ID %u in the memory cache "
+                  "[%d]: %s\n", cmd_ctx->sid_id, ret, sss_strerror(ret));
+        }
+    }
+
+    /* the object itself can be found by SID and by name as well */
+    ret = sss_mmap_cache_sid_store(&nss_ctx->sid_mc_ctx, NULL,
+                                   &sz_sid, sz_name, id_type, id);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store SID %s in the memory cache [%d]: %s\n",
+              sid, ret, sss_strerror(ret));
+    }
+
+done:
+    talloc_free(sz_name);
+}
+
 errno_t
 nss_protocol_fill_single_name(struct nss_ctx *nss_ctx,
                               struct nss_cmd_ctx *cmd_ctx,
@@ -444,6 +542,8 @@ nss_protocol_fill_name(struct nss_ctx *nss_ctx,
 
     talloc_free(sz_name);
 
+    nss_sid_mc_store(nss_ctx, cmd_ctx, result, id_type);
+
     return EOK;
 }
 
@@ -498,6 +598,8 @@ nss_protocol_fill_id(struct nss_ctx *nss_ctx,
     SAFEALIGN_SET_UINT32(&body[rp], id_type, &rp);
     SAFEALIGN_SET_UINT32(&body[rp], id, &rp);
 
+    nss_sid_mc_store(nss_ctx, cmd_ctx, result, id_type);
+
     return EOK;
 }
 
@@ -20,6 +20,7 @@
 
 #include "db/sysdb.h"
 #include "db/sysdb_services.h"
+#include "util/mmap_cache.h"
 #include "responder/nss/nss_protocol.h"
 
 static errno_t
@@ -174,6 +175,7 @@ nss_protocol_fill_svcent(struct nss_ctx *nss_ctx,
     struct sized_string name;
     struct sized_string protocol;
     struct sized_string *aliases;
+    const char *mc_key2 = NULL;
     uint32_t num_aliases;
     uint16_t port;
     uint32_t num_results;
@@ -249,6 +251,14 @@ nss_protocol_fill_svcent(struct nss_ctx *nss_ctx,
                                  &rp);
         }
 
+        /* the result of a lookup by port is also the answer to a lookup of
+         * its name with the same protocol */
+        if (cmd_ctx->type == CACHE_REQ_SVC_BY_PORT && num_results == 0) {
+            mc_key2 = talloc_asprintf(cmd_ctx, MC_SVC_BY_NAME_KEY, name.str,
+                                      cmd_ctx->svc_protocol == NULL
+                                          ? "" : cmd_ctx->svc_protocol);
+        }
+
         num_results++;
     }
 
@@ -266,5 +276,8 @@ done:
     SAFEALIGN_COPY_UINT32(body, &num_results, NULL);
     SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), 0, NULL); /* reserved */
 
+    nss_protocol_mc_store_reply(&nss_ctx->svc_mc_ctx, cmd_ctx, packet,
+                                mc_key2);
+
     return EOK;
 }
@@ -0,0 +1,240 @@
+/*
+    SSSD
+
+    NSS Responder - in-memory cache of lookup results
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <time.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "responder/nss/nss_private.h"
+
+struct nss_result_cache_entry {
+    struct nss_result_cache_entry *prev;
+    struct nss_result_cache_entry *next;
+
+    struct nss_result_cache *cache;
+    time_t expire;
+
+    /* Owned by the entry, requests get shared copies of it. */
+    struct cache_req_result *result;
+};
+
+struct nss_result_cache {
+    hash_table_t *table;
+
+    /* Most recently used entry first. */
+    struct nss_result_cache_entry *entries;
+    struct nss_result_cache_entry *last;
+    unsigned int num_entries;
+    unsigned int max_entries;
+
+    time_t timeout;
+};
+
+static int nss_result_cache_entry_destructor(struct nss_result_cache_entry *entry)
+{
+    struct nss_result_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+static char *
+nss_result_cache_key(TALLOC_CTX *mem_ctx,
+                     enum cache_req_type type,
+                     const char *name,
+                     uint32_t id)
+{
+    if (name != NULL) {
+        return talloc_asprintf(mem_ctx, "%d:%s", type, name);
+    }
+
+    return talloc_asprintf(mem_ctx, "%d:%"PRIu32, type, id);
+}
+
+errno_t nss_result_cache_init(struct nss_ctx *nctx,
+                              unsigned int size,
+                              time_t timeout)
+{
+    struct nss_result_cache *cache;
+
+    if (size == 0 || timeout == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Result cache is disabled.\n");
+        return EOK;
+    }
+
+    cache = talloc_zero(nctx, struct nss_result_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->max_entries = size;
+    cache->timeout = timeout;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Result cache holds up to %u entries "
+          "for %ld seconds\n", size, (long)timeout);
+
+    nctx->result_cache = cache;
+
+    return EOK;
+}
+
+struct cache_req_result *
+nss_result_cache_get(TALLOC_CTX *mem_ctx,
+                     struct nss_result_cache *cache,
+                     enum cache_req_type type,
+                     const char *name,
+                     uint32_t id)
+{
+    struct nss_result_cache_entry *entry;
+    struct cache_req_result *result;
+    char *key;
+
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    key = nss_result_cache_key(NULL, type, name, id);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct nss_result_cache_entry);
+    talloc_free(key);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    if (entry->expire < time(NULL)) {
+        talloc_free(entry);
+        return NULL;
+    }
+
+    result = cache_req_share_result(mem_ctx, entry->result);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    return result;
+}
+
+errno_t nss_result_cache_add(TALLOC_CTX *mem_ctx,
+                             struct nss_result_cache *cache,
+                             enum cache_req_type type,
+                             const char *name,
+                             uint32_t id,
+                             struct cache_req_result **_result)
+{
+    struct nss_result_cache_entry *entry;
+    struct cache_req_result *shared;
+    char *key;
+    errno_t ret;
+
+    if (cache == NULL) {
+        return EOK;
+    }
+
+    key = nss_result_cache_key(NULL, type, name, id);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    /* An older result of the same lookup is replaced. */
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct nss_result_cache_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= cache->max_entries) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct nss_result_cache_entry);
+    if (entry == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    shared = cache_req_share_result(mem_ctx, *_result);
+    if (shared == NULL) {
+        talloc_free(entry);
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(cache->table, key, entry,
+                           struct nss_result_cache_entry);
+    if (ret != EOK) {
+        talloc_free(shared);
+        talloc_free(entry);
+        goto done;
+    }
+
+    entry->cache = cache;
+    entry->expire = time(NULL) + cache->timeout;
+    entry->result = talloc_steal(entry, *_result);
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    talloc_set_destructor(entry, nss_result_cache_entry_destructor);
+
+    *_result = shared;
+
+    ret = EOK;
+
+done:
+    talloc_free(key);
+    return ret;
+}
+
+void nss_result_cache_flush(struct nss_result_cache *cache)
+{
+    if (cache == NULL || cache->num_entries == 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing %u entries of the result cache\n",
+          cache->num_entries);
+
+    while (cache->last != NULL) {
+        talloc_free(cache->last);
+    }
+}
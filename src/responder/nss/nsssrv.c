@@ -28,14 +28,17 @@
 #include <sys/un.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 #include <errno.h>
 #include <popt.h>
 #include <dbus/dbus.h>
 
 #include "util/util.h"
 #include "util/sss_ptr_hash.h"
+#include "util/crypto/sss_crypto.h"
 #include "responder/nss/nss_private.h"
 #include "responder/nss/nss_iface.h"
+#include "util/mmap_cache.h"
 #include "responder/nss/nsssrv_mmap_cache.h"
 #include "responder/common/negcache.h"
 #include "db/sysdb.h"
@@ -44,10 +47,52 @@
 #include "responder/common/responder.h"
 #include "providers/data_provider.h"
 #include "util/util_sss_idmap.h"
+#include "util/child_common.h"
 #include "sss_iface/sss_iface_async.h"
 
 #define DEFAULT_PWFIELD "*"
 #define DEFAULT_NSS_FD_LIMIT 8192
+#define NSS_WORKER_RESPAWN_DELAY 1
+
+static errno_t
+nss_get_memcache_size(struct confdb_ctx *cdb,
+                      const char *option,
+                      size_t *_n_elem,
+                      size_t *_max_elem)
+{
+    bool auto_resize;
+    int n_elem;
+    errno_t ret;
+
+    ret = confdb_get_int(cdb, CONFDB_NSS_CONF_ENTRY, option,
+                         SSS_MC_CACHE_ELEMENTS, &n_elem);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get '%s' option from confdb.\n", option);
+        return ret;
+    }
+
+    if (n_elem <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Invalid value %d of '%s', using %d.\n",
+              n_elem, option, SSS_MC_CACHE_ELEMENTS);
+        n_elem = SSS_MC_CACHE_ELEMENTS;
+    }
+
+    ret = confdb_get_bool(cdb, CONFDB_NSS_CONF_ENTRY,
+                          CONFDB_MEMCACHE_AUTO_RESIZE, true, &auto_resize);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_auto_resize' option from confdb.\n");
+        return ret;
+    }
+
+    *_n_elem = n_elem;
+    *_max_elem = auto_resize ? (size_t)n_elem * SSS_MC_MAX_GROWTH_FACTOR
+                             : (size_t)n_elem;
+
+    return EOK;
+}
 
 static errno_t
 nss_clear_memcache(TALLOC_CTX *mem_ctx,
@@ -55,6 +100,8 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
                    struct nss_ctx *nctx)
 {
     int memcache_timeout;
+    size_t n_elem;
+    size_t max_elem;
     errno_t ret;
 
     ret = unlink(SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG);
@@ -83,10 +130,20 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
         return ret;
     }
 
-    /* TODO: read cache sizes from configuration */
     DEBUG(SSSDBG_TRACE_FUNC, "Clearing memory caches.\n");
+    nss_result_cache_flush(nctx->result_cache);
+    nss_prefetch_flush(nctx->prefetch);
+    nss_initgr_cache_flush(nctx->initgr_cache);
+    nss_host_index_flush(nctx->host_index);
+
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_PASSWD,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
-                                SSS_MC_CACHE_ELEMENTS,
+                                n_elem, max_elem,
                                 (time_t) memcache_timeout,
                                 &nctx->pwd_mc_ctx);
     if (ret != EOK) {
@@ -95,8 +152,14 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
         return ret;
     }
 
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_GROUP,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
-                                SSS_MC_CACHE_ELEMENTS,
+                                n_elem, max_elem,
                                 (time_t) memcache_timeout,
                                 &nctx->grp_mc_ctx);
     if (ret != EOK) {
@@ -105,8 +168,15 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
         return ret;
     }
 
+    ret = nss_get_memcache_size(nctx->rctx->cdb,
+                                CONFDB_MEMCACHE_SIZE_INITGROUPS,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
-                                SSS_MC_CACHE_ELEMENTS,
+                                n_elem, max_elem,
                                 (time_t)memcache_timeout,
                                 &nctx->initgr_mc_ctx);
     if (ret != EOK) {
@@ -115,6 +185,54 @@ nss_clear_memcache(TALLOC_CTX *mem_ctx,
         return ret;
     }
 
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_SID,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
+                                n_elem, max_elem,
+                                (time_t)memcache_timeout,
+                                &nctx->sid_mc_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "sid mmap cache invalidation failed\n");
+        return ret;
+    }
+
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_SERVICES,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
+                                n_elem, max_elem,
+                                (time_t)memcache_timeout,
+                                &nctx->svc_mc_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "services mmap cache invalidation failed\n");
+        return ret;
+    }
+
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_HOSTS,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_mmap_cache_reinit(nctx, nctx->mc_uid, nctx->mc_gid,
+                                n_elem, max_elem,
+                                (time_t)memcache_timeout,
+                                &nctx->host_mc_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "hosts mmap cache invalidation failed\n");
+        return ret;
+    }
+
     return EOK;
 }
 
@@ -208,10 +326,320 @@ done:
     return ret;
 }
 
+static int setup_result_cache(struct nss_ctx *nctx)
+{
+    int memcache_timeout;
+    int size;
+    int ret;
+
+    ret = confdb_get_int(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_RESULT_CACHE_SIZE, 0, &size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'result_cache_size' option from confdb.\n");
+        return ret;
+    }
+
+    if (size <= 0) {
+        return EOK;
+    }
+
+    /* Results go stale no later than the records of the memory cache. */
+    ret = confdb_get_int(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_MEMCACHE_TIMEOUT, 300, &memcache_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_timeout' option from confdb.\n");
+        return ret;
+    }
+
+    if (memcache_timeout <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "memcache_timeout is 0, result cache will not be used.\n");
+        return EOK;
+    }
+
+    return nss_result_cache_init(nctx, size, memcache_timeout);
+}
+
+static int setup_prefetch(struct nss_ctx *nctx)
+{
+    int num;
+    int ret;
+
+    ret = confdb_get_int(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_PREFETCH_HOT_ENTRIES, 0, &num);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'prefetch_hot_entries' option from confdb.\n");
+        return ret;
+    }
+
+    if (num <= 0) {
+        return EOK;
+    }
+
+    return nss_prefetch_init(nctx, num);
+}
+
+static int setup_initgr_cache(struct nss_ctx *nctx)
+{
+    int size;
+    int ret;
+
+    ret = confdb_get_int(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_INITGR_CACHE_SIZE, 1000, &size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'initgroups_cache_size' option from confdb.\n");
+        return ret;
+    }
+
+    if (size <= 0) {
+        return EOK;
+    }
+
+    return nss_initgr_cache_init(nctx, size);
+}
+
+static int setup_host_index(struct nss_ctx *nctx)
+{
+    bool enabled;
+    int ret;
+
+    ret = confdb_get_bool(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                          CONFDB_NSS_HOSTS_INDEX, false, &enabled);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'hosts_index' option from confdb.\n");
+        return ret;
+    }
+
+    if (!enabled) {
+        return EOK;
+    }
+
+    /* The index is as old as the enumeration results may be. */
+    return nss_host_index_init(nctx, nctx->enum_cache_timeout);
+}
+
+/* The lag of this timer is the load that is published in the memory cache
+ * files, clients that use adaptive timeouts fall back to the next NSS
+ * module instead of waiting for a responder that can not keep up. */
+struct nss_health {
+    struct nss_ctx *nctx;
+    struct timeval due;
+    /* smoothed lag in milliseconds */
+    uint32_t lag;
+};
+
+static errno_t nss_health_schedule(struct nss_health *health);
+
+static void nss_health_publish(struct nss_health *health)
+{
+    struct nss_ctx *nctx = health->nctx;
+    struct timespec now;
+    uint32_t state;
+    uint32_t word;
+
+    if (health->lag >= SSS_MC_HEALTH_OVERLOADED_MSEC) {
+        state = SSS_MC_HEALTH_OVERLOADED;
+    } else if (health->lag >= SSS_MC_HEALTH_BUSY_MSEC) {
+        state = SSS_MC_HEALTH_BUSY;
+    } else {
+        state = SSS_MC_HEALTH_OK;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    word = SSS_MC_HEALTH_WORD(state, MIN(health->lag / 10, 0xff), now.tv_sec);
+
+    sss_mmap_cache_set_health(nctx->pwd_mc_ctx, word);
+    sss_mmap_cache_set_health(nctx->grp_mc_ctx, word);
+    sss_mmap_cache_set_health(nctx->initgr_mc_ctx, word);
+    sss_mmap_cache_set_health(nctx->sid_mc_ctx, word);
+    sss_mmap_cache_set_health(nctx->svc_mc_ctx, word);
+    sss_mmap_cache_set_health(nctx->host_mc_ctx, word);
+}
+
+static void nss_health_update(struct tevent_context *ev,
+                              struct tevent_timer *te,
+                              struct timeval current_time,
+                              void *pvt)
+{
+    struct nss_health *health;
+    struct timeval late;
+    uint32_t lag;
+    errno_t ret;
+
+    health = talloc_get_type(pvt, struct nss_health);
+
+    late = tevent_timeval_until(&health->due, &current_time);
+    lag = MIN((uint64_t)late.tv_sec * 1000 + late.tv_usec / 1000,
+              UINT32_MAX / 4);
+
+    /* One slow handler does not make the responder overloaded. */
+    health->lag = (health->lag * 3 + lag) / 4;
+
+    nss_health_publish(health);
+
+    ret = nss_health_schedule(health);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule the health update, "
+              "clients will consider the responder unresponsive\n");
+    }
+}
+
+static errno_t nss_health_schedule(struct nss_health *health)
+{
+    struct tevent_timer *te;
+
+    health->due = tevent_timeval_current_ofs(SSS_MC_HEALTH_INTERVAL, 0);
+
+    te = tevent_add_timer(health->nctx->rctx->ev, health, health->due,
+                          nss_health_update, health);
+    if (te == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static int setup_health(struct nss_ctx *nctx)
+{
+    struct nss_health *health;
+    errno_t ret;
+
+    health = talloc_zero(nctx, struct nss_health);
+    if (health == NULL) {
+        return ENOMEM;
+    }
+    health->nctx = nctx;
+
+    nss_health_publish(health);
+
+    ret = nss_health_schedule(health);
+    if (ret != EOK) {
+        talloc_free(health);
+        return ret;
+    }
+
+    return EOK;
+}
+
+/* Stamp of the memory cache files, it is stored in the file and in the
+ * cache of every domain when the files are created. */
+#define MC_STAMP_FILE SSS_NSS_MCACHE_DIR"/stamp"
+
+static char *nss_memcache_read_stamp(TALLOC_CTX *mem_ctx)
+{
+    char buf[32];
+    ssize_t len;
+    int fd;
+
+    fd = open(MC_STAMP_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    len = sss_atomic_read_s(fd, (uint8_t *)buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) {
+        return NULL;
+    }
+    buf[len] = '\0';
+
+    return talloc_strdup(mem_ctx, buf);
+}
+
+/* The files of the previous instance can be reused if they were filled
+ * from the current content of the caches of all domains. */
+static bool nss_memcache_reusable(struct nss_ctx *nctx)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sss_domain_info *dom;
+    const char *dom_stamp;
+    char *stamp;
+    bool reuse = false;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return false;
+    }
+
+    stamp = nss_memcache_read_stamp(tmp_ctx);
+    if (stamp == NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Memory cache files are not stamped\n");
+        goto done;
+    }
+
+    for (dom = nctx->rctx->domains; dom; dom = get_next_domain(dom, 0)) {
+        ret = sysdb_get_memcache_stamp(tmp_ctx, dom, &dom_stamp);
+        if (ret != EOK || dom_stamp == NULL || strcmp(dom_stamp, stamp) != 0) {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Memory cache files were not filled from the cache of "
+                  "domain %s\n", dom->name);
+            goto done;
+        }
+    }
+
+    reuse = true;
+
+done:
+    talloc_free(tmp_ctx);
+    return reuse;
+}
+
+static errno_t nss_memcache_new_stamp(struct nss_ctx *nctx)
+{
+    struct sss_domain_info *dom;
+    uint64_t rand;
+    char stamp[32];
+    ssize_t written;
+    size_t len;
+    int fd;
+    errno_t ret;
+
+    ret = sss_generate_csprng_buffer((uint8_t *)&rand, sizeof(rand));
+    if (ret != EOK) {
+        return ret;
+    }
+    len = snprintf(stamp, sizeof(stamp), "%016"PRIx64, rand);
+
+    for (dom = nctx->rctx->domains; dom; dom = get_next_domain(dom, 0)) {
+        ret = sysdb_set_memcache_stamp(dom, stamp);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    fd = open(MC_STAMP_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return errno;
+    }
+
+    errno = 0;
+    written = sss_atomic_write_s(fd, (uint8_t *)stamp, len);
+    ret = written == -1 ? errno : ((size_t)written != len ? EIO : EOK);
+    close(fd);
+
+    return ret;
+}
+
 static int setup_memcaches(struct nss_ctx *nctx)
 {
     int ret;
     int memcache_timeout;
+    char *layout_str;
+    uint32_t layout;
+    char *hash_str;
+    uint32_t hash;
+    uint32_t flags = 0;
+    bool huge_pages;
+    int neg_timeout;
+    size_t n_elem;
+    size_t max_elem;
+    bool reuse = false;
 
     /* Remove the CLEAR_MC_FLAG file if exists. */
     ret = unlink(SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG);
@@ -239,34 +667,181 @@ static int setup_memcaches(struct nss_ctx *nctx)
         return EOK;
     }
 
-    /* TODO: read cache sizes from configuration */
+    ret = confdb_get_string(nctx->rctx->cdb, nctx,
+                            CONFDB_NSS_CONF_ENTRY,
+                            CONFDB_MEMCACHE_HASH_LAYOUT,
+                            "chained", &layout_str);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_hash_layout' option from confdb.\n");
+        return ret;
+    }
+
+    if (strcasecmp(layout_str, "chained") == 0) {
+        layout = SSS_MC_LAYOUT_CHAINED;
+    } else if (strcasecmp(layout_str, "probing") == 0) {
+        layout = SSS_MC_LAYOUT_PROBING;
+    } else {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unknown memcache_hash_layout '%s', using 'chained'.\n",
+              layout_str);
+        layout = SSS_MC_LAYOUT_CHAINED;
+    }
+    talloc_free(layout_str);
+
+    ret = confdb_get_string(nctx->rctx->cdb, nctx,
+                            CONFDB_NSS_CONF_ENTRY,
+                            CONFDB_MEMCACHE_HASH_FUNCTION,
+                            "murmurhash3", &hash_str);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_hash_function' option from confdb.\n");
+        return ret;
+    }
+
+    if (strcasecmp(hash_str, "murmurhash3") == 0) {
+        hash = SSS_MC_HASH_MURMURHASH3;
+    } else if (strcasecmp(hash_str, "wyhash") == 0) {
+        hash = SSS_MC_HASH_WYHASH;
+    } else {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unknown memcache_hash_function '%s', using 'murmurhash3'.\n",
+              hash_str);
+        hash = SSS_MC_HASH_MURMURHASH3;
+    }
+    talloc_free(hash_str);
+
+    ret = confdb_get_bool(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                          CONFDB_MEMCACHE_HUGE_PAGES, false, &huge_pages);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_huge_pages' option from confdb.\n");
+        return ret;
+    }
+
+    if (huge_pages) {
+        flags |= SSS_MC_FLAG_HUGE_PAGES;
+    }
+
+    ret = confdb_get_int(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_MEMCACHE_NEG_TIMEOUT, 0, &neg_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Failed to get "
+              "'memcache_negative_timeout' option from confdb.\n");
+        return ret;
+    }
+
+    if (neg_timeout < 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Invalid value %d of 'memcache_negative_timeout', using 0.\n",
+              neg_timeout);
+        neg_timeout = 0;
+    }
+
+    if (nctx->rctx->warm_restart) {
+        reuse = nss_memcache_reusable(nctx);
+        if (!reuse) {
+            ret = nss_memcache_new_stamp(nctx);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Unable to stamp the memory cache files, they will not "
+                      "be reused on restart [%d]: %s\n",
+                      ret, sss_strerror(ret));
+            }
+        }
+    }
+
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_PASSWD,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sss_mmap_cache_init(nctx, "passwd",
                               nctx->mc_uid, nctx->mc_gid,
-                              SSS_MC_PASSWD,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->pwd_mc_ctx);
+                              SSS_MC_PASSWD, layout, hash, flags,
+                              n_elem, max_elem, (time_t)memcache_timeout,
+                              (uint32_t)neg_timeout, reuse, &nctx->pwd_mc_ctx);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "passwd mmap cache is DISABLED\n");
     }
 
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_GROUP,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sss_mmap_cache_init(nctx, "group",
                               nctx->mc_uid, nctx->mc_gid,
-                              SSS_MC_GROUP,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->grp_mc_ctx);
+                              SSS_MC_GROUP, layout, hash, flags,
+                              n_elem, max_elem, (time_t)memcache_timeout,
+                              (uint32_t)neg_timeout, reuse, &nctx->grp_mc_ctx);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "group mmap cache is DISABLED\n");
     }
 
+    ret = nss_get_memcache_size(nctx->rctx->cdb,
+                                CONFDB_MEMCACHE_SIZE_INITGROUPS,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
     ret = sss_mmap_cache_init(nctx, "initgroups",
                               nctx->mc_uid, nctx->mc_gid,
-                              SSS_MC_INITGROUPS,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->initgr_mc_ctx);
+                              SSS_MC_INITGROUPS, layout, hash, flags,
+                              n_elem, max_elem, (time_t)memcache_timeout,
+                              0, reuse, &nctx->initgr_mc_ctx);
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "initgroups mmap cache is DISABLED\n");
     }
 
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_SID,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_mmap_cache_init(nctx, "sid",
+                              nctx->mc_uid, nctx->mc_gid,
+                              SSS_MC_SID, layout, hash, flags,
+                              n_elem, max_elem, (time_t)memcache_timeout,
+                              0, reuse, &nctx->sid_mc_ctx);
+    if (ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sid mmap cache is DISABLED\n");
+    }
+
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_SERVICES,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_mmap_cache_init(nctx, "services",
+                              nctx->mc_uid, nctx->mc_gid,
+                              SSS_MC_SERVICES, layout, hash, flags,
+                              n_elem, max_elem, (time_t)memcache_timeout,
+                              0, reuse, &nctx->svc_mc_ctx);
+    if (ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "services mmap cache is DISABLED\n");
+    }
+
+    ret = nss_get_memcache_size(nctx->rctx->cdb, CONFDB_MEMCACHE_SIZE_HOSTS,
+                                &n_elem, &max_elem);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_mmap_cache_init(nctx, "hosts",
+                              nctx->mc_uid, nctx->mc_gid,
+                              SSS_MC_HOSTS, layout, hash, flags,
+                              n_elem, max_elem, (time_t)memcache_timeout,
+                              0, reuse, &nctx->host_mc_ctx);
+    if (ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "hosts mmap cache is DISABLED\n");
+    }
+
     return EOK;
 }
 
@@ -292,9 +867,10 @@ nss_register_service_iface(struct nss_ctx *nss_ctx,
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to register service interface"
               "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret;
     }
 
-    return ret;
+    return sss_resp_register_stats_iface(rctx);
 }
 
 static int sssd_supplementary_group(struct nss_ctx *nss_ctx)
@@ -370,9 +946,207 @@ done:
     return ret;
 }
 
+struct nss_workers_ctx {
+    struct resp_ctx *rctx;
+    struct sss_sigchild_ctx *sigchld_ctx;
+    const char **argv;
+};
+
+struct nss_worker {
+    struct nss_workers_ctx *wctx;
+    int id;
+    pid_t pid;
+    struct sss_child_ctx *child_ctx;
+};
+
+static void nss_worker_exited(int pid, int wait_status, void *pvt);
+
+static errno_t nss_worker_spawn(struct nss_worker *worker)
+{
+    struct nss_workers_ctx *wctx = worker->wctx;
+    const char **argv;
+    int argc;
+    int flags;
+    pid_t pid;
+    errno_t ret;
+
+    for (argc = 0; wctx->argv[argc] != NULL; argc++);
+
+    argv = talloc_zero_array(worker, const char *, argc + 3);
+    if (argv == NULL) {
+        return ENOMEM;
+    }
+
+    memcpy(argv, wctx->argv, argc * sizeof(const char *));
+    argv[argc] = talloc_asprintf(argv, "--worker=%d", worker->id);
+    argv[argc + 1] = talloc_asprintf(argv, "--listen-fd=%d", wctx->rctx->lfd);
+    if (argv[argc] == NULL || argv[argc + 1] == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    pid = fork();
+    if (pid == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "fork failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (pid == 0) {
+        /* the listening socket is the one descriptor the worker inherits */
+        flags = fcntl(wctx->rctx->lfd, F_GETFD, 0);
+        if (flags == -1
+                || fcntl(wctx->rctx->lfd, F_SETFD, flags & ~FD_CLOEXEC) == -1) {
+            _exit(1);
+        }
+
+        execv(SSSD_LIBEXEC_PATH"/sssd_nss", discard_const(argv));
+
+        ret = errno;
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to start NSS worker [%d]: %s\n",
+              ret, sss_strerror(ret));
+        _exit(1);
+    }
+
+    ret = sss_child_register(worker, wctx->sigchld_ctx, pid,
+                             nss_worker_exited, worker, &worker->child_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to watch NSS worker %d\n",
+              worker->id);
+        kill(pid, SIGKILL);
+        goto done;
+    }
+
+    worker->pid = pid;
+    DEBUG(SSSDBG_TRACE_FUNC, "Started NSS worker %d [%d]\n",
+          worker->id, worker->pid);
+
+    ret = EOK;
+
+done:
+    talloc_free(argv);
+    return ret;
+}
+
+static void nss_worker_respawn(struct tevent_context *ev,
+                               struct tevent_timer *te,
+                               struct timeval current_time,
+                               void *pvt);
+
+static void nss_worker_schedule_respawn(struct nss_worker *worker)
+{
+    struct tevent_timer *te;
+    struct timeval tv;
+
+    tv = tevent_timeval_current_ofs(NSS_WORKER_RESPAWN_DELAY, 0);
+    te = tevent_add_timer(worker->wctx->rctx->ev, worker, tv,
+                          nss_worker_respawn, worker);
+    if (te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to schedule restart of NSS worker %d\n", worker->id);
+    }
+}
+
+static void nss_worker_respawn(struct tevent_context *ev,
+                               struct tevent_timer *te,
+                               struct timeval current_time,
+                               void *pvt)
+{
+    struct nss_worker *worker = talloc_get_type(pvt, struct nss_worker);
+    errno_t ret;
+
+    if (worker->wctx->rctx->shutting_down) {
+        return;
+    }
+
+    ret = nss_worker_spawn(worker);
+    if (ret != EOK) {
+        nss_worker_schedule_respawn(worker);
+    }
+}
+
+static void nss_worker_exited(int pid, int wait_status, void *pvt)
+{
+    struct nss_worker *worker = talloc_get_type(pvt, struct nss_worker);
+
+    DEBUG(SSSDBG_OP_FAILURE, "NSS worker %d [%d] exited with status %d\n",
+          worker->id, pid, wait_status);
+
+    talloc_zfree(worker->child_ctx);
+    worker->pid = -1;
+
+    if (worker->wctx->rctx->shutting_down) {
+        return;
+    }
+
+    nss_worker_schedule_respawn(worker);
+}
+
+static errno_t nss_start_workers(struct nss_ctx *nctx, const char **argv)
+{
+    struct nss_workers_ctx *wctx;
+    struct nss_worker *worker;
+    int num_workers;
+    errno_t ret;
+    int i;
+
+    ret = confdb_get_int(nctx->rctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_WORKER_PROCESSES, 1, &num_workers);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (num_workers <= 1) {
+        return EOK;
+    }
+
+    if (nctx->rctx->socket_activated || nctx->rctx->dbus_activated) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "The responder was activated on demand, "
+              "option %s is ignored\n", CONFDB_NSS_WORKER_PROCESSES);
+        return EOK;
+    }
+
+    wctx = talloc_zero(nctx, struct nss_workers_ctx);
+    if (wctx == NULL) {
+        return ENOMEM;
+    }
+
+    wctx->rctx = nctx->rctx;
+    wctx->argv = argv;
+
+    ret = sss_sigchld_init(wctx, nctx->rctx->ev, &wctx->sigchld_ctx);
+    if (ret != EOK) {
+        talloc_free(wctx);
+        return ret;
+    }
+
+    /* this process is worker 0 */
+    for (i = 1; i < num_workers; i++) {
+        worker = talloc_zero(wctx, struct nss_worker);
+        if (worker == NULL) {
+            return ENOMEM;
+        }
+
+        worker->wctx = wctx;
+        worker->id = i;
+        worker->pid = -1;
+
+        ret = nss_worker_spawn(worker);
+        if (ret != EOK) {
+            nss_worker_schedule_respawn(worker);
+        }
+    }
+
+    return EOK;
+}
+
 int nss_process_init(TALLOC_CTX *mem_ctx,
                      struct tevent_context *ev,
-                     struct confdb_ctx *cdb)
+                     struct confdb_ctx *cdb,
+                     const char **argv,
+                     int worker,
+                     int listen_fd)
 {
     struct resp_ctx *rctx;
     struct sss_cmd_table *nss_cmds;
@@ -381,14 +1155,23 @@ int nss_process_init(TALLOC_CTX *mem_ctx,
     int ret;
     enum idmap_error_code err;
     int fd_limit;
+    const char *conn_name = SSS_BUS_NSS;
 
     nss_cmds = get_nss_cmds();
 
+    if (worker > 0) {
+        /* every connection to the data providers needs its own name */
+        conn_name = talloc_asprintf(mem_ctx, "%s_worker%d", SSS_BUS_NSS, worker);
+        if (conn_name == NULL) {
+            return ENOMEM;
+        }
+    }
+
     ret = sss_process_init(mem_ctx, ev, cdb,
                            nss_cmds,
-                           SSS_NSS_SOCKET_NAME, -1, NULL, -1,
+                           SSS_NSS_SOCKET_NAME, listen_fd, NULL, -1,
                            CONFDB_NSS_CONF_ENTRY,
-                           SSS_BUS_NSS, NSS_SBUS_SERVICE_NAME,
+                           conn_name, NSS_SBUS_SERVICE_NAME,
                            nss_connection_setup,
                            &rctx);
     if (ret != EOK) {
@@ -482,7 +1265,41 @@ int nss_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
-    ret = setup_memcaches(nctx);
+    /* The main process is the only writer of the memory cache. It is also
+     * the only one which is told to invalidate it, so the results are not
+     * kept by workers. */
+    if (worker == 0) {
+        ret = setup_memcaches(nctx);
+        if (ret != EOK) {
+            goto fail;
+        }
+
+        ret = setup_health(nctx);
+        if (ret != EOK) {
+            goto fail;
+        }
+
+        ret = setup_result_cache(nctx);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
+    /* Every process refreshes the entries its own clients request most. */
+    ret = setup_prefetch(nctx);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    /* The cached group lists are checked against the cache database, so
+     * every process can keep its own. */
+    ret = setup_initgr_cache(nctx);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    /* The index is loaded from the cache database as well. */
+    ret = setup_host_index(nctx);
     if (ret != EOK) {
         goto fail;
     }
@@ -506,6 +1323,13 @@ int nss_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    if (worker > 0) {
+        /* Workers are managed by the main process, not by the monitor. */
+        DEBUG(SSSDBG_TRACE_FUNC, "NSS worker %d initialization complete\n",
+              worker);
+        return EOK;
+    }
+
     /* The responder is initialized. Now tell it to the monitor. */
     ret = sss_monitor_service_init(rctx, rctx->ev, SSS_BUS_NSS,
                                    NSS_SBUS_SERVICE_NAME,
@@ -521,6 +1345,12 @@ int nss_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    ret = nss_start_workers(nctx, argv);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to start NSS workers\n");
+        goto fail;
+    }
+
     DEBUG(SSSDBG_TRACE_FUNC, "NSS Initialization complete\n");
 
     return EOK;
@@ -539,6 +1369,8 @@ int main(int argc, const char *argv[])
     int ret;
     uid_t uid;
     gid_t gid;
+    int worker = 0;
+    int listen_fd = -1;
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
@@ -546,6 +1378,10 @@ int main(int argc, const char *argv[])
         SSSD_LOGGER_OPTS
         SSSD_SERVER_OPTS(uid, gid)
         SSSD_RESPONDER_OPTS
+        {"worker", 0, POPT_ARG_INT, &worker, 0,
+         _("Number of the worker process (internal)"), NULL },
+        {"listen-fd", 0, POPT_ARG_INT, &listen_fd, 0,
+         _("Listening socket inherited by a worker process (internal)"), NULL },
         POPT_TABLEEND
     };
 
@@ -567,10 +1403,20 @@ int main(int argc, const char *argv[])
 
     poptFreeContext(pc);
 
+    if (worker < 0 || (worker > 0 && listen_fd < 0)) {
+        fprintf(stderr, "\nA worker process needs --listen-fd.\n\n");
+        return 1;
+    }
+
     DEBUG_INIT(debug_level);
 
     /* set up things like debug, signals, daemonization, etc. */
-    debug_log_file = "sssd_nss";
+    if (worker > 0) {
+        debug_log_file = talloc_asprintf(NULL, "sssd_nss_worker%d", worker);
+        if (debug_log_file == NULL) return 2;
+    } else {
+        debug_log_file = "sssd_nss";
+    }
 
     sss_set_logger(opt_logger);
 
@@ -587,7 +1433,8 @@ int main(int argc, const char *argv[])
 
     ret = nss_process_init(main_ctx,
                            main_ctx->event_ctx,
-                           main_ctx->confdb_ctx);
+                           main_ctx->confdb_ctx,
+                           argv, worker, listen_fd);
     if (ret != EOK) return 3;
 
     /* loop on main */
@@ -25,6 +25,7 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include "util/mmap_cache.h"
+#include "util/probes.h"
 #include "responder/nss/nss_private.h"
 #include "responder/nss/nsssrv_mmap_cache.h"
 
@@ -34,6 +35,16 @@
 #define SSS_AVG_GROUP_PAYLOAD (MC_SLOT_SIZE * 3)
 /* average place for 40 supplementary groups + 2 names */
 #define SSS_AVG_INITGROUP_PAYLOAD (MC_SLOT_SIZE * 5)
+/* domain SID with a RID and a fully qualified name */
+#define SSS_AVG_SID_PAYLOAD (MC_SLOT_SIZE * 4)
+/* a service with a couple of aliases */
+#define SSS_AVG_SERVICES_PAYLOAD (MC_SLOT_SIZE * 3)
+/* a host with a couple of aliases and IPv4 and IPv6 addresses */
+#define SSS_AVG_HOSTS_PAYLOAD (MC_SLOT_SIZE * 5)
+
+/* the cache is grown once the number of records evicted before their
+ * expiration reaches 1/MC_GROW_EVICTION_RATIO of its elements */
+#define MC_GROW_EVICTION_RATIO 16
 
 #define MC_NEXT_BARRIER(val) ((((val) + 1) & 0x00ffffff) | 0xf0000000)
 
@@ -63,6 +74,7 @@ struct sss_mc_ctx {
 
     uint32_t seed;          /* pseudo-random seed to avoid collision attacks */
     time_t valid_time_slot; /* maximum time the entry is valid in seconds */
+    uint32_t neg_timeout;   /* clients may cache misses for this long */
 
     void *mmap_base;        /* base address of mmap */
     size_t mmap_size;       /* total size of mmap */
@@ -76,6 +88,15 @@ struct sss_mc_ctx {
 
     uint8_t *data_table;    /* data table address (in mmap) */
     uint32_t dt_size;       /* size of data table */
+
+    uint32_t layout;        /* hash table layout (SSS_MC_LAYOUT_*) */
+    uint32_t hash;          /* hash function of the keys (SSS_MC_HASH_*) */
+    uint32_t flags;         /* header flags (SSS_MC_FLAG_*) */
+
+    uint32_t generation;    /* barrier value of the last record write */
+
+    size_t max_elem;        /* the cache can grow up to this many elements */
+    uint32_t live_evictions; /* records evicted before their expiration */
 };
 
 #define MC_FIND_BIT(base, num) \
@@ -99,6 +120,19 @@ struct sss_mc_ctx {
     else used = false; \
 } while (0)
 
+/* Records get their barrier from a cache-wide generation counter instead of
+ * incrementing their own barrier. A freed slot starts over from
+ * MC_INVALID_VAL, so a per-record counter would hand the same barrier value
+ * to the next record stored there and a reader that sampled b1 of the old
+ * record could accept a torn copy of the new one. */
+static inline void sss_mc_raise_rec_barrier(struct sss_mc_ctx *mcc,
+                                            struct sss_mc_rec *rec)
+{
+    mcc->generation = MC_NEXT_BARRIER(mcc->generation);
+    rec->b2 = mcc->generation;
+    __sync_synchronize();
+}
+
 static inline
 uint32_t sss_mc_next_slot_with_hash(struct sss_mc_rec *rec,
                                     uint32_t hash)
@@ -201,7 +235,160 @@ done:
 static uint32_t sss_mc_hash(struct sss_mc_ctx *mcc,
                             const char *key, size_t len)
 {
-    return murmurhash3(key, len, mcc->seed) % MC_HT_ELEMS(mcc->ht_size);
+    uint32_t h;
+
+    if (mcc->hash == SSS_MC_HASH_WYHASH) {
+        h = wyhash(key, len, mcc->seed);
+    } else {
+        h = murmurhash3(key, len, mcc->seed);
+    }
+
+    return h % MC_HT_ELEMS(mcc->ht_size);
+}
+
+/* iterator over the records stored under a hash table bucket */
+struct sss_mc_ht_iter {
+    uint32_t hash;
+    uint32_t pos;
+    uint32_t probes;
+};
+
+static uint32_t sss_mc_ht_probe(struct sss_mc_ctx *mcc,
+                                struct sss_mc_ht_iter *iter)
+{
+    uint32_t elems = MC_HT_ELEMS(mcc->ht_size);
+    uint32_t entry;
+
+    while (iter->probes < MC_HT_MAX_PROBES) {
+        entry = mcc->hash_table[iter->pos];
+        iter->pos = (iter->pos + 1) % elems;
+        iter->probes++;
+
+        if (entry == MC_INVALID_VAL) {
+            break;
+        }
+
+        if (MC_HT_ENTRY_FP(entry) == MC_HT_FP(iter->hash)) {
+            return MC_HT_ENTRY_SLOT(entry);
+        }
+    }
+
+    return MC_INVALID_VAL;
+}
+
+static uint32_t sss_mc_ht_first(struct sss_mc_ctx *mcc,
+                                struct sss_mc_ht_iter *iter,
+                                uint32_t hash)
+{
+    iter->hash = hash;
+    iter->pos = hash;
+    iter->probes = 0;
+
+    if (mcc->layout == SSS_MC_LAYOUT_PROBING) {
+        return sss_mc_ht_probe(mcc, iter);
+    }
+
+    return mcc->hash_table[hash];
+}
+
+static uint32_t sss_mc_ht_next(struct sss_mc_ctx *mcc,
+                               struct sss_mc_ht_iter *iter,
+                               struct sss_mc_rec *rec)
+{
+    if (mcc->layout == SSS_MC_LAYOUT_PROBING) {
+        return sss_mc_ht_probe(mcc, iter);
+    }
+
+    return sss_mc_next_slot_with_hash(rec, iter->hash);
+}
+
+static errno_t sss_mc_ht_insert(struct sss_mc_ctx *mcc,
+                                struct sss_mc_rec *rec,
+                                uint32_t hash, bool key2)
+{
+    uint32_t elems = MC_HT_ELEMS(mcc->ht_size);
+    uint32_t entry;
+    uint32_t pos;
+    uint32_t i;
+
+    if (hash >= elems) {
+        return EINVAL;
+    }
+
+    entry = MC_HT_ENTRY(MC_PTR_TO_SLOT(mcc->data_table, rec), hash, key2);
+
+    pos = hash;
+    for (i = 0; i < MC_HT_MAX_PROBES; i++) {
+        if (mcc->hash_table[pos] == entry) {
+            /* rec already stored in hash table */
+            return EOK;
+        }
+
+        if (mcc->hash_table[pos] == MC_INVALID_VAL) {
+            mcc->hash_table[pos] = entry;
+            return EOK;
+        }
+
+        pos = (pos + 1) % elems;
+    }
+
+    /* the fingerprint could not identify the home bucket anymore */
+    return ENOMEM;
+}
+
+static void sss_mc_ht_remove(struct sss_mc_ctx *mcc,
+                             struct sss_mc_rec *rec,
+                             uint32_t hash, bool key2)
+{
+    uint32_t elems = MC_HT_ELEMS(mcc->ht_size);
+    uint32_t entry;
+    uint32_t hole;
+    uint32_t pos;
+    uint32_t i;
+
+    if (hash >= elems) {
+        return;
+    }
+
+    entry = MC_HT_ENTRY(MC_PTR_TO_SLOT(mcc->data_table, rec), hash, key2);
+
+    hole = hash;
+    for (i = 0; i < MC_HT_MAX_PROBES; i++) {
+        if (mcc->hash_table[hole] == entry) {
+            break;
+        }
+
+        if (mcc->hash_table[hole] == MC_INVALID_VAL) {
+            /* record has already been removed */
+            return;
+        }
+
+        hole = (hole + 1) % elems;
+    }
+
+    if (i == MC_HT_MAX_PROBES) {
+        return;
+    }
+
+    /* Instead of leaving a tombstone, move back every following entry of
+     * the cluster which is allowed to take the freed position, so probe
+     * sequences never contain gaps. A concurrent reader may miss a moved
+     * entry, in that case it just asks the responder. */
+    pos = hole;
+    for (i = 0; i < elems; i++) {
+        pos = (pos + 1) % elems;
+        entry = mcc->hash_table[pos];
+        if (entry == MC_INVALID_VAL) {
+            break;
+        }
+
+        if (MC_HT_ENTRY_DIST(entry, pos) >= (pos + elems - hole) % elems) {
+            mcc->hash_table[hole] = entry;
+            hole = pos;
+        }
+    }
+
+    mcc->hash_table[hole] = MC_INVALID_VAL;
 }
 
 static void sss_mc_add_rec_to_chain(struct sss_mc_ctx *mcc,
@@ -281,6 +468,21 @@ static void sss_mc_rm_rec_from_chain(struct sss_mc_ctx *mcc,
     }
 }
 
+static void sss_mmap_chain_out_rec(struct sss_mc_ctx *mcc,
+                                   struct sss_mc_rec *rec)
+{
+    if (mcc->layout == SSS_MC_LAYOUT_PROBING) {
+        sss_mc_ht_remove(mcc, rec, rec->hash1, false);
+        sss_mc_ht_remove(mcc, rec, rec->hash2, true);
+        return;
+    }
+
+    /* hash chain 1 */
+    sss_mc_rm_rec_from_chain(mcc, rec, rec->hash1);
+    /* hash chain 2 */
+    sss_mc_rm_rec_from_chain(mcc, rec, rec->hash2);
+}
+
 static void sss_mc_free_slots(struct sss_mc_ctx *mcc, struct sss_mc_rec *rec)
 {
     uint32_t slot;
@@ -302,11 +504,10 @@ static void sss_mc_invalidate_rec(struct sss_mc_ctx *mcc,
         return;
     }
 
+    PROBE(MMAP_CACHE_INVALIDATE, mcc->name, rec->len);
+
     /* Remove from hash chains */
-    /* hash chain 1 */
-    sss_mc_rm_rec_from_chain(mcc, rec, rec->hash1);
-    /* hash chain 2 */
-    sss_mc_rm_rec_from_chain(mcc, rec, rec->hash2);
+    sss_mmap_chain_out_rec(mcc, rec);
 
     /* Clear from free_table */
     sss_mc_free_slots(mcc, rec);
@@ -326,6 +527,7 @@ static void sss_mc_invalidate_rec(struct sss_mc_ctx *mcc,
 
 static bool sss_mc_is_valid_rec(struct sss_mc_ctx *mcc, struct sss_mc_rec *rec)
 {
+    struct sss_mc_ht_iter iter;
     struct sss_mc_rec *self;
     uint32_t slot;
 
@@ -353,10 +555,10 @@ static bool sss_mc_is_valid_rec(struct sss_mc_ctx *mcc, struct sss_mc_rec *rec)
         return false;
     } else {
         self = NULL;
-        slot = mcc->hash_table[rec->hash1];
+        slot = sss_mc_ht_first(mcc, &iter, rec->hash1);
         while (slot != MC_INVALID_VAL32 && self != rec) {
             self = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
-            slot = sss_mc_next_slot_with_hash(self, rec->hash1);
+            slot = sss_mc_ht_next(mcc, &iter, self);
         }
         if (self != rec) {
             return false;
@@ -364,10 +566,10 @@ static bool sss_mc_is_valid_rec(struct sss_mc_ctx *mcc, struct sss_mc_rec *rec)
     }
     if (rec->hash2 != MC_INVALID_VAL32) {
         self = NULL;
-        slot = mcc->hash_table[rec->hash2];
+        slot = sss_mc_ht_first(mcc, &iter, rec->hash2);
         while (slot != MC_INVALID_VAL32 && self != rec) {
             self = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
-            slot = sss_mc_next_slot_with_hash(self, rec->hash2);
+            slot = sss_mc_ht_next(mcc, &iter, self);
         }
         if (self != rec) {
             return false;
@@ -459,6 +661,11 @@ static errno_t sss_mc_find_free_slots(struct sss_mc_ctx *mcc,
             /* next loop skip the whole record */
             i += MC_SIZE_TO_SLOTS(rec->len) - 1;
 
+            if (rec->expire >= time(NULL)) {
+                /* the cache is too small for the working set */
+                mcc->live_evictions++;
+            }
+
             /* finally invalidate record completely */
             sss_mc_invalidate_rec(mcc, rec);
         }
@@ -482,6 +689,13 @@ static errno_t sss_mc_get_strs_offset(struct sss_mc_ctx *mcc,
     case SSS_MC_INITGROUPS:
         *_offset = offsetof(struct sss_mc_initgr_data, gids);
         return EOK;
+    case SSS_MC_SID:
+        *_offset = offsetof(struct sss_mc_sid_data, strs);
+        return EOK;
+    case SSS_MC_SERVICES:
+    case SSS_MC_HOSTS:
+        *_offset = offsetof(struct sss_mc_reply_data, strs);
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -502,6 +716,13 @@ static errno_t sss_mc_get_strs_len(struct sss_mc_ctx *mcc,
     case SSS_MC_INITGROUPS:
         *_len = ((struct sss_mc_initgr_data *)&rec->data)->data_len;
         return EOK;
+    case SSS_MC_SID:
+        *_len = ((struct sss_mc_sid_data *)&rec->data)->strs_len;
+        return EOK;
+    case SSS_MC_SERVICES:
+    case SSS_MC_HOSTS:
+        *_len = ((struct sss_mc_reply_data *)&rec->data)->strs_len;
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -511,6 +732,7 @@ static errno_t sss_mc_get_strs_len(struct sss_mc_ctx *mcc,
 static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
                                              struct sized_string *key)
 {
+    struct sss_mc_ht_iter iter;
     struct sss_mc_rec *rec;
     uint32_t hash;
     uint32_t slot;
@@ -523,7 +745,7 @@ static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
 
     hash = sss_mc_hash(mcc, key->str, key->len);
 
-    slot = mcc->hash_table[hash];
+    slot = sss_mc_ht_first(mcc, &iter, hash);
     if (!MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
         return NULL;
     }
@@ -553,7 +775,7 @@ static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
 
         if (key->len > strs_len) {
             /* The string cannot be in current record */
-            slot = sss_mc_next_slot_with_hash(rec, hash);
+            slot = sss_mc_ht_next(mcc, &iter, rec);
             continue;
         }
 
@@ -581,7 +803,7 @@ static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
             break;
         }
 
-        slot = sss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_mc_ht_next(mcc, &iter, rec);
     }
 
     if (slot == MC_INVALID_VAL) {
@@ -591,6 +813,30 @@ static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
     return rec;
 }
 
+static void sss_mc_count_fallback(struct sss_mc_ctx *mcc)
+{
+    struct sss_mc_header *h;
+
+    /* This is only a statistic, clients do not compare it, so it is
+     * updated without raising the header barriers. */
+    h = (struct sss_mc_header *)mcc->mmap_base;
+    __sync_add_and_fetch(&h->fallbacks, 1);
+}
+
+static bool sss_mc_needs_growth(struct sss_mc_ctx *mcc)
+{
+    size_t n_elem;
+
+    n_elem = mcc->ft_size * 8;
+    if (n_elem >= mcc->max_elem) {
+        return false;
+    }
+
+    return mcc->live_evictions >= MAX(n_elem / MC_GROW_EVICTION_RATIO, 1);
+}
+
+static errno_t sss_mc_grow(struct sss_mc_ctx **_mcc);
+
 static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
                                  size_t rec_len,
                                  struct sized_string *key,
@@ -605,13 +851,35 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
     errno_t ret;
     int i;
 
+    if (sss_mc_needs_growth(mcc)) {
+        ret = sss_mc_grow(_mcc);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Failed to grow memory cache %s [%d]: %s\n",
+                  mcc->name, ret, sss_strerror(ret));
+            /* try again only after the same amount of evictions */
+            mcc->live_evictions = 0;
+        }
+        mcc = *_mcc;
+    }
+
     num_slots = MC_SIZE_TO_SLOTS(rec_len);
 
     old_rec = sss_mc_find_record(mcc, key);
     if (old_rec) {
+        if (old_rec->expire >= time(NULL)) {
+            /* the client could have used the cached record but asked us */
+            sss_mc_count_fallback(mcc);
+        }
+
         old_slots = MC_SIZE_TO_SLOTS(old_rec->len);
 
         if (old_slots == num_slots) {
+            if (mcc->layout == SSS_MC_LAYOUT_PROBING) {
+                /* keys may change with the new content and stale entries
+                 * would stay in the table forever */
+                sss_mmap_chain_out_rec(mcc, old_rec);
+            }
             *_rec = old_rec;
             return EOK;
         }
@@ -628,7 +896,7 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
             DEBUG(SSSDBG_CRIT_FAILURE,
                   "Fatal internal mmap cache error, invalidating cache!\n");
             (void)sss_mmap_cache_reinit(talloc_parent(mcc),
-                                        -1, -1, -1, -1,
+                                        -1, -1, -1, -1, -1,
                                         _mcc);
         }
         return ret;
@@ -641,7 +909,7 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
     rec->len = rec_len;
     rec->next1 = MC_INVALID_VAL;
     rec->next2 = MC_INVALID_VAL;
-    rec->padding = MC_INVALID_VAL;
+    rec->generation = ((struct sss_mc_header *)mcc->mmap_base)->generation;
     MC_LOWER_BARRIER(rec);
 
     /* and now mark slots as used */
@@ -665,13 +933,29 @@ static inline void sss_mmap_set_rec_header(struct sss_mc_ctx *mcc,
     rec->hash2 = sss_mc_hash(mcc, key2, key2_len);
 }
 
-static inline void sss_mmap_chain_in_rec(struct sss_mc_ctx *mcc,
-                                         struct sss_mc_rec *rec)
+static inline errno_t sss_mmap_chain_in_rec(struct sss_mc_ctx *mcc,
+                                            struct sss_mc_rec *rec)
 {
-    /* name first */
-    sss_mc_add_rec_to_chain(mcc, rec, rec->hash1);
-    /* then uid/gid */
-    sss_mc_add_rec_to_chain(mcc, rec, rec->hash2);
+    errno_t ret;
+
+    if (mcc->layout == SSS_MC_LAYOUT_PROBING) {
+        ret = sss_mc_ht_insert(mcc, rec, rec->hash1, false);
+        if (ret != EOK) {
+            return ret;
+        }
+        ret = sss_mc_ht_insert(mcc, rec, rec->hash2, true);
+        if (ret != EOK) {
+            return ret;
+        }
+    } else {
+        /* name first */
+        sss_mc_add_rec_to_chain(mcc, rec, rec->hash1);
+        /* then uid/gid */
+        sss_mc_add_rec_to_chain(mcc, rec, rec->hash2);
+    }
+
+    PROBE(MMAP_CACHE_STORE, mcc->name, rec->len);
+    return EOK;
 }
 
 /***************************************************************************
@@ -699,6 +983,65 @@ static errno_t sss_mmap_cache_invalidate(struct sss_mc_ctx *mcc,
     return EOK;
 }
 
+/* The header barrier stays raised for the whole batch, so clients fall back
+ * to the socket once instead of racing every single record update. */
+errno_t sss_mmap_cache_invalidate_batch(struct sss_mc_ctx *mcc,
+                                        struct sized_string *names,
+                                        size_t num_names,
+                                        uint32_t *ids, size_t num_ids,
+                                        uint32_t *_count)
+{
+    struct sss_mc_header *h;
+    uint32_t count = 0;
+    size_t i;
+    errno_t ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    if (num_ids > 0
+            && mcc->type != SSS_MC_PASSWD && mcc->type != SSS_MC_GROUP) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Records of memory cache %s cannot be invalidated by ID\n",
+              mcc->name);
+        return EINVAL;
+    }
+
+    h = (struct sss_mc_header *)mcc->mmap_base;
+    MC_RAISE_BARRIER(h);
+
+    for (i = 0; i < num_names; i++) {
+        ret = sss_mmap_cache_invalidate(mcc, &names[i]);
+        if (ret == EOK) {
+            count++;
+        }
+    }
+
+    for (i = 0; i < num_ids; i++) {
+        if (mcc->type == SSS_MC_PASSWD) {
+            ret = sss_mmap_cache_pw_invalidate_uid(mcc, ids[i]);
+        } else {
+            ret = sss_mmap_cache_gr_invalidate_gid(mcc, ids[i]);
+        }
+        if (ret == EOK) {
+            count++;
+        }
+    }
+
+    MC_LOWER_BARRIER(h);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Invalidated %"PRIu32" records of %zu keys "
+          "in memory cache %s\n", count, num_names + num_ids, mcc->name);
+
+    if (_count != NULL) {
+        *_count = count;
+    }
+
+    return EOK;
+}
+
 /***************************************************************************
  * passwd map
  ***************************************************************************/
@@ -744,11 +1087,13 @@ errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
     if (ret != EOK) {
         return ret;
     }
+    /* the record may have been allocated in a grown cache */
+    mcc = *_mcc;
 
     data = (struct sss_mc_pwd_data *)rec->data;
     pos = 0;
 
-    MC_RAISE_BARRIER(rec);
+    sss_mc_raise_rec_barrier(mcc, rec);
 
     /* header */
     sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
@@ -773,7 +1118,13 @@ errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
     MC_LOWER_BARRIER(rec);
 
     /* finally chain the rec in the hash table */
-    sss_mmap_chain_in_rec(mcc, rec);
+    ret = sss_mmap_chain_in_rec(mcc, rec);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Hash table of memory cache is full, record not stored.\n");
+        sss_mc_invalidate_rec(mcc, rec);
+        return ret;
+    }
 
     return EOK;
 }
@@ -786,6 +1137,7 @@ errno_t sss_mmap_cache_pw_invalidate(struct sss_mc_ctx *mcc,
 
 errno_t sss_mmap_cache_pw_invalidate_uid(struct sss_mc_ctx *mcc, uid_t uid)
 {
+    struct sss_mc_ht_iter iter;
     struct sss_mc_rec *rec;
     struct sss_mc_pwd_data *data;
     uint32_t hash;
@@ -805,7 +1157,7 @@ errno_t sss_mmap_cache_pw_invalidate_uid(struct sss_mc_ctx *mcc, uid_t uid)
 
     hash = sss_mc_hash(mcc, uidstr, strlen(uidstr) + 1);
 
-    slot = mcc->hash_table[hash];
+    slot = sss_mc_ht_first(mcc, &iter, hash);
     if (!MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
         ret = ENOENT;
         goto done;
@@ -827,7 +1179,7 @@ errno_t sss_mmap_cache_pw_invalidate_uid(struct sss_mc_ctx *mcc, uid_t uid)
             break;
         }
 
-        slot = sss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_mc_ht_next(mcc, &iter, rec);
     }
 
     if (slot == MC_INVALID_VAL) {
@@ -887,11 +1239,13 @@ int sss_mmap_cache_gr_store(struct sss_mc_ctx **_mcc,
     if (ret != EOK) {
         return ret;
     }
+    /* the record may have been allocated in a grown cache */
+    mcc = *_mcc;
 
     data = (struct sss_mc_grp_data *)rec->data;
     pos = 0;
 
-    MC_RAISE_BARRIER(rec);
+    sss_mc_raise_rec_barrier(mcc, rec);
 
     /* header */
     sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
@@ -912,7 +1266,13 @@ int sss_mmap_cache_gr_store(struct sss_mc_ctx **_mcc,
     MC_LOWER_BARRIER(rec);
 
     /* finally chain the rec in the hash table */
-    sss_mmap_chain_in_rec(mcc, rec);
+    ret = sss_mmap_chain_in_rec(mcc, rec);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Hash table of memory cache is full, record not stored.\n");
+        sss_mc_invalidate_rec(mcc, rec);
+        return ret;
+    }
 
     return EOK;
 }
@@ -925,6 +1285,7 @@ errno_t sss_mmap_cache_gr_invalidate(struct sss_mc_ctx *mcc,
 
 errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid)
 {
+    struct sss_mc_ht_iter iter;
     struct sss_mc_rec *rec;
     struct sss_mc_grp_data *data;
     uint32_t hash;
@@ -944,7 +1305,7 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid)
 
     hash = sss_mc_hash(mcc, gidstr, strlen(gidstr) + 1);
 
-    slot = mcc->hash_table[hash];
+    slot = sss_mc_ht_first(mcc, &iter, hash);
     if (!MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
         ret = ENOENT;
         goto done;
@@ -966,7 +1327,7 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid)
             break;
         }
 
-        slot = sss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_mc_ht_next(mcc, &iter, rec);
     }
 
     if (slot == MC_INVALID_VAL) {
@@ -1015,11 +1376,13 @@ errno_t sss_mmap_cache_initgr_store(struct sss_mc_ctx **_mcc,
     if (ret != EOK) {
         return ret;
     }
+    /* the record may have been allocated in a grown cache */
+    mcc = *_mcc;
 
     data = (struct sss_mc_initgr_data *)rec->data;
     pos = 0;
 
-    MC_RAISE_BARRIER(rec);
+    sss_mc_raise_rec_barrier(mcc, rec);
 
     /* We cannot use two keys for searching in initgroups cache.
      * Use the first key twice.
@@ -1045,7 +1408,13 @@ errno_t sss_mmap_cache_initgr_store(struct sss_mc_ctx **_mcc,
     MC_LOWER_BARRIER(rec);
 
     /* finally chain the rec in the hash table */
-    sss_mmap_chain_in_rec(mcc, rec);
+    ret = sss_mmap_chain_in_rec(mcc, rec);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Hash table of memory cache is full, record not stored.\n");
+        sss_mc_invalidate_rec(mcc, rec);
+        return ret;
+    }
 
     return EOK;
 }
@@ -1057,68 +1426,245 @@ errno_t sss_mmap_cache_initgr_invalidate(struct sss_mc_ctx *mcc,
 }
 
 /***************************************************************************
- * initialization
+ * SID map
  ***************************************************************************/
 
-/* Copy of sss_mc_set_recycled is present in the src/tools/tools_mc_util.c.
- * If you modify this function, you should modify the duplicated function
- * too. */
-static errno_t sss_mc_set_recycled(int fd)
+errno_t sss_mmap_cache_sid_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *key,
+                                 struct sized_string *sid,
+                                 struct sized_string *name,
+                                 uint32_t type, uint32_t id)
 {
-    uint32_t w = SSS_MC_HEADER_RECYCLED;
-    struct sss_mc_header h;
-    off_t offset;
-    off_t pos;
-    ssize_t written;
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_sid_data *data;
+    struct sized_string *key2;
+    size_t data_len;
+    size_t rec_len;
+    size_t pos;
+    int ret;
 
-    offset = MC_PTR_DIFF(&h.status, &h);
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
 
-    pos = lseek(fd, offset, SEEK_SET);
-    if (pos == -1) {
-        /* What do we do now? */
-        return errno;
+    if (key == NULL) {
+        /* looked up by SID or name */
+        key2 = name;
+        data_len = sid->len + name->len;
+    } else {
+        key2 = key;
+        data_len = key->len + sid->len + name->len;
+    }
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_sid_data) +
+              data_len;
+    if (rec_len > mcc->dt_size) {
+        return ENOMEM;
     }
 
-    errno = 0;
-    written = sss_atomic_write_s(fd, (uint8_t *)&w, sizeof(h.status));
-    if (written == -1) {
-        return errno;
+    ret = sss_mc_get_record(_mcc, rec_len, key == NULL ? sid : key, &rec);
+    if (ret != EOK) {
+        return ret;
     }
+    /* the record may have been allocated in a grown cache */
+    mcc = *_mcc;
 
-    if (written != sizeof(h.status)) {
-        /* Write error */
-        return EIO;
+    data = (struct sss_mc_sid_data *)rec->data;
+    pos = 0;
+
+    sss_mc_raise_rec_barrier(mcc, rec);
+
+    /* header */
+    sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
+                            key == NULL ? sid->str : key->str,
+                            key == NULL ? sid->len : key->len,
+                            key2->str, key2->len);
+
+    /* sid struct */
+    data->type = type;
+    data->id = id;
+    data->strs_len = data_len;
+    if (key != NULL) {
+        memcpy(&data->strs[pos], key->str, key->len);
+        data->key = MC_PTR_DIFF(&data->strs[pos], data);
+        pos += key->len;
+    }
+    memcpy(&data->strs[pos], sid->str, sid->len);
+    data->sid = MC_PTR_DIFF(&data->strs[pos], data);
+    if (key == NULL) {
+        data->key = data->sid;
+    }
+    pos += sid->len;
+    memcpy(&data->strs[pos], name->str, name->len);
+    data->name = MC_PTR_DIFF(&data->strs[pos], data);
+    pos += name->len;
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    ret = sss_mmap_chain_in_rec(mcc, rec);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Hash table of memory cache is full, record not stored.\n");
+        sss_mc_invalidate_rec(mcc, rec);
+        return ret;
     }
 
     return EOK;
 }
 
-/*
- * When we (re)create a new file we must mark the current file as recycled
- * so active clients will abandon its use ASAP.
- * We unlink the current file and make a new one.
- */
-static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
+errno_t sss_mmap_cache_sid_invalidate(struct sss_mc_ctx *mcc,
+                                      struct sized_string *key)
 {
-    mode_t old_mask;
-    int ofd;
-    int ret, uret;
-    useconds_t t = 50000;
-    int retries = 3;
+    return sss_mmap_cache_invalidate(mcc, key);
+}
 
-    ofd = open(mc_ctx->file, O_RDWR);
-    if (ofd != -1) {
-        ret = sss_br_lock_file(ofd, 0, 1, retries, t);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_FATAL_FAILURE,
-                  "Failed to lock file %s.\n", mc_ctx->file);
-        }
-        ret = sss_mc_set_recycled(ofd);
-        if (ret) {
-            DEBUG(SSSDBG_FATAL_FAILURE, "Failed to mark mmap file %s as"
-                                         " recycled: %d(%s)\n",
-                                         mc_ctx->file, ret, strerror(ret));
-        }
+/***************************************************************************
+ * services and hosts map
+ ***************************************************************************/
+
+errno_t sss_mmap_cache_reply_store(struct sss_mc_ctx **_mcc,
+                                   struct sized_string *key,
+                                   struct sized_string *key2,
+                                   const uint8_t *reply, size_t reply_len)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_reply_data *data;
+    bool same_keys;
+    size_t data_len;
+    size_t rec_len;
+    size_t pos;
+    int ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized? */
+        return EINVAL;
+    }
+
+    same_keys = key2->len == key->len
+                    && memcmp(key2->str, key->str, key->len) == 0;
+
+    data_len = key->len + (same_keys ? 0 : key2->len) + reply_len;
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_reply_data) +
+              data_len;
+    if (rec_len > mcc->dt_size) {
+        return ENOMEM;
+    }
+
+    ret = sss_mc_get_record(_mcc, rec_len, key, &rec);
+    if (ret != EOK) {
+        return ret;
+    }
+    /* the record may have been allocated in a grown cache */
+    mcc = *_mcc;
+
+    data = (struct sss_mc_reply_data *)rec->data;
+    pos = 0;
+
+    sss_mc_raise_rec_barrier(mcc, rec);
+
+    /* header */
+    sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
+                            key->str, key->len, key2->str, key2->len);
+
+    /* reply struct */
+    data->strs_len = data_len;
+    memcpy(&data->strs[pos], key->str, key->len);
+    data->key = MC_PTR_DIFF(&data->strs[pos], data);
+    pos += key->len;
+    if (same_keys) {
+        data->key2 = data->key;
+    } else {
+        memcpy(&data->strs[pos], key2->str, key2->len);
+        data->key2 = MC_PTR_DIFF(&data->strs[pos], data);
+        pos += key2->len;
+    }
+    memcpy(&data->strs[pos], reply, reply_len);
+    data->reply = MC_PTR_DIFF(&data->strs[pos], data);
+    data->reply_len = reply_len;
+    pos += reply_len;
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    ret = sss_mmap_chain_in_rec(mcc, rec);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Hash table of memory cache is full, record not stored.\n");
+        sss_mc_invalidate_rec(mcc, rec);
+        return ret;
+    }
+
+    return EOK;
+}
+
+/***************************************************************************
+ * initialization
+ ***************************************************************************/
+
+/* Copy of sss_mc_set_recycled is present in the src/tools/tools_mc_util.c.
+ * If you modify this function, you should modify the duplicated function
+ * too. */
+static errno_t sss_mc_set_recycled(int fd)
+{
+    uint32_t w = SSS_MC_HEADER_RECYCLED;
+    struct sss_mc_header h;
+    off_t offset;
+    off_t pos;
+    ssize_t written;
+
+    offset = MC_PTR_DIFF(&h.status, &h);
+
+    pos = lseek(fd, offset, SEEK_SET);
+    if (pos == -1) {
+        /* What do we do now? */
+        return errno;
+    }
+
+    errno = 0;
+    written = sss_atomic_write_s(fd, (uint8_t *)&w, sizeof(h.status));
+    if (written == -1) {
+        return errno;
+    }
+
+    if (written != sizeof(h.status)) {
+        /* Write error */
+        return EIO;
+    }
+
+    return EOK;
+}
+
+/*
+ * When we (re)create a new file we must mark the current file as recycled
+ * so active clients will abandon its use ASAP.
+ * We unlink the current file and make a new one.
+ */
+static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
+{
+    mode_t old_mask;
+    int ofd;
+    int ret, uret;
+    useconds_t t = 50000;
+    int retries = 3;
+
+    ofd = open(mc_ctx->file, O_RDWR);
+    if (ofd != -1) {
+        ret = sss_br_lock_file(ofd, 0, 1, retries, t);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE,
+                  "Failed to lock file %s.\n", mc_ctx->file);
+        }
+        ret = sss_mc_set_recycled(ofd);
+        if (ret) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Failed to mark mmap file %s as"
+                                         " recycled: %d(%s)\n",
+                                         mc_ctx->file, ret, strerror(ret));
+        }
 
         close(ofd);
     } else if (errno != ENOENT) {
@@ -1194,6 +1740,26 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
     return ret;
 }
 
+/* Transparent huge pages are only a hint, a file system that does not
+ * support them for its page cache just keeps using regular pages. */
+static void sss_mc_advise_huge_pages(struct sss_mc_ctx *mc_ctx)
+{
+#ifdef MADV_HUGEPAGE
+    int ret;
+
+    ret = madvise(mc_ctx->mmap_base, mc_ctx->mmap_size, MADV_HUGEPAGE);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Huge pages are not available for %s: %d(%s)\n",
+              mc_ctx->file, ret, strerror(ret));
+    }
+#else
+    DEBUG(SSSDBG_MINOR_FAILURE,
+          "Huge pages are not supported on this platform\n");
+#endif
+}
+
 static void sss_mc_header_update(struct sss_mc_ctx *mc_ctx, int status)
 {
     struct sss_mc_header *h;
@@ -1213,7 +1779,11 @@ static void sss_mc_header_update(struct sss_mc_ctx *mc_ctx, int status)
         h->major_vno = SSS_MC_MAJOR_VNO;
         h->minor_vno = SSS_MC_MINOR_VNO;
         h->seed = mc_ctx->seed;
-        h->reserved = 0;
+        h->fallbacks = 0;
+        h->layout = mc_ctx->layout;
+        h->hash = mc_ctx->hash;
+        h->flags = mc_ctx->flags;
+        h->neg_timeout = mc_ctx->neg_timeout;
     }
     h->status = status;
     MC_LOWER_BARRIER(h);
@@ -1249,10 +1819,207 @@ static int mc_ctx_destructor(struct sss_mc_ctx *mc_ctx)
     return 0;
 }
 
-errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
-                            uid_t uid, gid_t gid,
-                            enum sss_mc_type type, size_t n_elem,
-                            time_t timeout, struct sss_mc_ctx **mcc)
+/* Checks that the tables described by the header of a file left by the
+ * previous instance fit the file and the current configuration. */
+static bool sss_mc_reuse_header_ok(struct sss_mc_ctx *mc_ctx,
+                                   struct sss_mc_header *h,
+                                   size_t file_size,
+                                   size_t n_elem)
+{
+    size_t size;
+
+    if (h->b1 != h->b2 || h->status != SSS_MC_HEADER_ALIVE
+            || h->major_vno != SSS_MC_MAJOR_VNO
+            || h->minor_vno != SSS_MC_MINOR_VNO
+            || h->layout != mc_ctx->layout
+            || h->hash != mc_ctx->hash
+            || h->flags != mc_ctx->flags) {
+        return false;
+    }
+
+    if (h->ht_size == 0 || h->ht_size % MC_32 != 0
+            || h->ft_size == 0 || h->dt_size < MC_SLOT_SIZE) {
+        return false;
+    }
+
+    /* the number of elements must still be within the configured range */
+    if (h->ft_size * 8 < MC_ALIGN64(n_elem)
+            || h->ft_size * 8 > mc_ctx->max_elem) {
+        return false;
+    }
+
+    if ((size_t)h->ft_size * 8 * MC_SLOT_SIZE > h->dt_size) {
+        return false;
+    }
+
+    if (mc_ctx->layout == SSS_MC_LAYOUT_PROBING
+            && (MC_HT_ELEMS(h->ht_size) % MC_HT_MAX_PROBES != 0
+                || h->dt_size / MC_SLOT_SIZE >= MC_HT_SLOT_MASK)) {
+        return false;
+    }
+
+    if (h->data_table != MC_HEADER_SIZE
+            || h->free_table != h->data_table + MC_ALIGN64(h->dt_size)
+            || h->hash_table != h->free_table + MC_ALIGN64(h->ft_size)) {
+        return false;
+    }
+
+    size = MC_HEADER_SIZE + MC_ALIGN64(h->dt_size) + MC_ALIGN64(h->ft_size)
+           + MC_ALIGN64(h->ht_size);
+    if (mc_ctx->flags & SSS_MC_FLAG_HUGE_PAGES) {
+        size = MC_ALIGN_HUGE_PAGE(size);
+    }
+
+    return size == file_size;
+}
+
+/*
+ * Keeps using the file of the previous instance instead of creating a new
+ * one, clients that have it mapped keep their records. The file is only
+ * reused if it was left in a consistent state, i.e. no record was being
+ * written when the previous instance stopped.
+ */
+static errno_t sss_mc_reuse_file(struct sss_mc_ctx *mc_ctx, size_t n_elem)
+{
+    struct sss_mc_header h;
+    struct sss_mc_rec *rec;
+    struct stat st;
+    uint32_t tot_slots;
+    uint32_t slot;
+    uint32_t records = 0;
+    ssize_t len;
+    bool used;
+    int ret;
+
+    mc_ctx->fd = open(mc_ctx->file, O_RDWR);
+    if (mc_ctx->fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_TRACE_FUNC, "Cannot open old mmap file %s: %d(%s)\n",
+              mc_ctx->file, ret, strerror(ret));
+        return ret;
+    }
+
+    ret = sss_br_lock_file(mc_ctx->fd, 0, 1, 3, 50000);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to lock file %s.\n", mc_ctx->file);
+        goto done;
+    }
+
+    ret = fstat(mc_ctx->fd, &st);
+    if (ret == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    len = sss_atomic_read_s(mc_ctx->fd, (uint8_t *)&h, sizeof(h));
+    if (len != sizeof(h)
+            || !sss_mc_reuse_header_ok(mc_ctx, &h, st.st_size, n_elem)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Old mmap file %s does not match the configuration.\n",
+              mc_ctx->file);
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = fchown(mc_ctx->fd, mc_ctx->uid, mc_ctx->gid);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to chown mmap file %s: %d(%s)\n",
+                                   mc_ctx->file, ret, strerror(ret));
+        goto done;
+    }
+
+    ret = fchmod(mc_ctx->fd, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to chmod mmap file %s: %d(%s)\n",
+                                   mc_ctx->file, ret, strerror(ret));
+        goto done;
+    }
+
+    mc_ctx->mmap_size = st.st_size;
+    mc_ctx->mmap_base = mmap(NULL, mc_ctx->mmap_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED, mc_ctx->fd, 0);
+    if (mc_ctx->mmap_base == MAP_FAILED) {
+        ret = errno;
+        mc_ctx->mmap_base = NULL;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to mmap file %s(%zu): %d(%s)\n",
+                                    mc_ctx->file, mc_ctx->mmap_size,
+                                    ret, strerror(ret));
+        goto done;
+    }
+
+    if (mc_ctx->flags & SSS_MC_FLAG_HUGE_PAGES) {
+        sss_mc_advise_huge_pages(mc_ctx);
+    }
+
+    mc_ctx->seed = h.seed;
+    mc_ctx->dt_size = h.dt_size;
+    mc_ctx->ft_size = h.ft_size;
+    mc_ctx->ht_size = h.ht_size;
+    mc_ctx->data_table = MC_PTR_ADD(mc_ctx->mmap_base, h.data_table);
+    mc_ctx->free_table = MC_PTR_ADD(mc_ctx->mmap_base, h.free_table);
+    mc_ctx->hash_table = MC_PTR_ADD(mc_ctx->mmap_base, h.hash_table);
+
+    /* the barriers of the old records are unknown, do not start the counter
+     * from a value they are likely to have */
+    ret = sss_generate_csprng_buffer((uint8_t *)&mc_ctx->generation,
+                                     sizeof(mc_ctx->generation));
+    if (ret != EOK) {
+        goto done;
+    }
+
+    tot_slots = mc_ctx->ft_size * 8;
+    slot = 0;
+    while (slot < tot_slots) {
+        MC_PROBE_BIT(mc_ctx->free_table, slot, used);
+        if (!used) {
+            slot++;
+            continue;
+        }
+
+        rec = MC_SLOT_TO_PTR(mc_ctx->data_table, slot, struct sss_mc_rec);
+        if (!sss_mc_is_valid_rec(mc_ctx, rec)) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Old mmap file %s contains an invalid record.\n",
+                  mc_ctx->file);
+            ret = EINVAL;
+            goto done;
+        }
+        slot += MC_SIZE_TO_SLOTS(rec->len);
+        records++;
+    }
+
+    sss_mc_header_update(mc_ctx, SSS_MC_HEADER_ALIVE);
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Reusing memory cache file %s with %u records.\n",
+          mc_ctx->file, records);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        if (mc_ctx->mmap_base != NULL) {
+            munmap(mc_ctx->mmap_base, mc_ctx->mmap_size);
+            mc_ctx->mmap_base = NULL;
+        }
+        close(mc_ctx->fd);
+        mc_ctx->fd = -1;
+    }
+
+    return ret;
+}
+
+static errno_t sss_mc_init_file(TALLOC_CTX *mem_ctx, const char *name,
+                                const char *file, uid_t uid, gid_t gid,
+                                enum sss_mc_type type, uint32_t layout,
+                                uint32_t hash, uint32_t flags,
+                                size_t n_elem, size_t max_elem,
+                                time_t timeout, uint32_t neg_timeout,
+                                bool reuse, struct sss_mc_ctx **mcc)
 {
     struct sss_mc_ctx *mc_ctx = NULL;
     int payload;
@@ -1268,10 +2035,27 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
     case SSS_MC_INITGROUPS:
         payload = SSS_AVG_INITGROUP_PAYLOAD;
         break;
+    case SSS_MC_SID:
+        payload = SSS_AVG_SID_PAYLOAD;
+        break;
+    case SSS_MC_SERVICES:
+        payload = SSS_AVG_SERVICES_PAYLOAD;
+        break;
+    case SSS_MC_HOSTS:
+        payload = SSS_AVG_HOSTS_PAYLOAD;
+        break;
     default:
         return EINVAL;
     }
 
+    if (layout != SSS_MC_LAYOUT_CHAINED && layout != SSS_MC_LAYOUT_PROBING) {
+        return EINVAL;
+    }
+
+    if (hash != SSS_MC_HASH_MURMURHASH3 && hash != SSS_MC_HASH_WYHASH) {
+        return EINVAL;
+    }
+
     mc_ctx = talloc_zero(mem_ctx, struct sss_mc_ctx);
     if (!mc_ctx) {
         return ENOMEM;
@@ -1289,33 +2073,60 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
     mc_ctx->gid = gid;
 
     mc_ctx->type = type;
+    mc_ctx->layout = layout;
+    mc_ctx->hash = hash;
+    mc_ctx->flags = flags;
 
     mc_ctx->valid_time_slot = timeout;
+    mc_ctx->neg_timeout = neg_timeout;
 
-    mc_ctx->file = talloc_asprintf(mc_ctx, "%s/%s",
-                                   SSS_NSS_MCACHE_DIR, name);
+    mc_ctx->file = talloc_strdup(mc_ctx, file);
     if (!mc_ctx->file) {
         ret = ENOMEM;
         goto done;
     }
 
+    mc_ctx->max_elem = max_elem;
+
+    if (reuse) {
+        ret = sss_mc_reuse_file(mc_ctx, n_elem);
+        if (ret == EOK) {
+            goto done;
+        }
+    }
+
     /* elements must always be multiple of 8 to make things easier to handle,
      * so we increase by the necessary amount if they are not a multiple */
     /* We can use MC_ALIGN64 for this */
     n_elem = MC_ALIGN64(n_elem);
 
-    /* hash table is double the size because it will store both forward and
-     * reverse keys (name/uid, name/gid, ..) */
-    mc_ctx->ht_size = MC_HT_SIZE(n_elem * 2);
+    if (layout == SSS_MC_LAYOUT_PROBING) {
+        /* every key is a separate entry, keep the load factor around 50%,
+         * the number of buckets must be a multiple of MC_HT_MAX_PROBES */
+        mc_ctx->ht_size = MC_HT_SIZE((n_elem * 4 + MC_HT_MAX_PROBES - 1)
+                                     & ~(MC_HT_MAX_PROBES - 1));
+    } else {
+        /* hash table is double the size because it will store both forward
+         * and reverse keys (name/uid, name/gid, ..) */
+        mc_ctx->ht_size = MC_HT_SIZE(n_elem * 2);
+    }
     mc_ctx->dt_size = MC_DT_SIZE(n_elem, payload);
+    if (layout == SSS_MC_LAYOUT_PROBING
+            && mc_ctx->dt_size / MC_SLOT_SIZE >= MC_HT_SLOT_MASK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Memory cache %s is too large for the probing layout.\n", name);
+        ret = EINVAL;
+        goto done;
+    }
     mc_ctx->ft_size = MC_FT_SIZE(n_elem);
     mc_ctx->mmap_size = MC_HEADER_SIZE +
                         MC_ALIGN64(mc_ctx->dt_size) +
                         MC_ALIGN64(mc_ctx->ft_size) +
                         MC_ALIGN64(mc_ctx->ht_size);
-
-
-    /* for now ALWAYS create a new file on restart */
+    if (flags & SSS_MC_FLAG_HUGE_PAGES) {
+        /* the tail of the last huge page is never used */
+        mc_ctx->mmap_size = MC_ALIGN_HUGE_PAGE(mc_ctx->mmap_size);
+    }
 
     ret = sss_mc_create_file(mc_ctx);
     if (ret) {
@@ -1341,6 +2152,10 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
         goto done;
     }
 
+    if (flags & SSS_MC_FLAG_HUGE_PAGES) {
+        sss_mc_advise_huge_pages(mc_ctx);
+    }
+
     mc_ctx->data_table = MC_PTR_ADD(mc_ctx->mmap_base, MC_HEADER_SIZE);
     mc_ctx->free_table = MC_PTR_ADD(mc_ctx->data_table,
                                     MC_ALIGN64(mc_ctx->dt_size));
@@ -1383,15 +2198,301 @@ done:
     return ret;
 }
 
+errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
+                            uid_t uid, gid_t gid,
+                            enum sss_mc_type type, uint32_t layout,
+                            uint32_t hash, uint32_t flags,
+                            size_t n_elem, size_t max_elem,
+                            time_t timeout, uint32_t neg_timeout,
+                            bool reuse, struct sss_mc_ctx **mcc)
+{
+    char *file;
+    errno_t ret;
+
+    file = talloc_asprintf(NULL, "%s/%s", SSS_NSS_MCACHE_DIR, name);
+    if (file == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_mc_init_file(mem_ctx, name, file, uid, gid, type, layout,
+                           hash, flags, n_elem, max_elem, timeout, neg_timeout,
+                           reuse, mcc);
+    talloc_free(file);
+    return ret;
+}
+
+/* Returns the two keys the record was hashed with. The id keys are not
+ * stored in the record, they are printed in idbuf. */
+static errno_t sss_mc_get_rec_keys(struct sss_mc_ctx *mcc,
+                                   struct sss_mc_rec *rec,
+                                   char *idbuf, size_t idbuf_len,
+                                   struct sized_string *key1,
+                                   struct sized_string *key2)
+{
+    struct sss_mc_pwd_data *pwd_data;
+    struct sss_mc_grp_data *grp_data;
+    struct sss_mc_initgr_data *initgr_data;
+    struct sss_mc_sid_data *sid_data;
+    struct sss_mc_reply_data *reply_data;
+    rel_ptr_t ptr1;
+    rel_ptr_t ptr2 = 0;
+    uint32_t id = 0;
+    size_t max_len;
+    size_t len;
+    int ret;
+
+    switch (mcc->type) {
+    case SSS_MC_PASSWD:
+        pwd_data = (struct sss_mc_pwd_data *)rec->data;
+        ptr1 = pwd_data->name;
+        id = pwd_data->uid;
+        break;
+    case SSS_MC_GROUP:
+        grp_data = (struct sss_mc_grp_data *)rec->data;
+        ptr1 = grp_data->name;
+        id = grp_data->gid;
+        break;
+    case SSS_MC_INITGROUPS:
+        initgr_data = (struct sss_mc_initgr_data *)rec->data;
+        ptr1 = initgr_data->name;
+        ptr2 = initgr_data->unique_name;
+        break;
+    case SSS_MC_SID:
+        sid_data = (struct sss_mc_sid_data *)rec->data;
+        ptr1 = sid_data->key;
+        /* records of lookups by ID use the same key twice */
+        ptr2 = sid_data->key == sid_data->sid ? sid_data->name : ptr1;
+        break;
+    case SSS_MC_SERVICES:
+    case SSS_MC_HOSTS:
+        reply_data = (struct sss_mc_reply_data *)rec->data;
+        ptr1 = reply_data->key;
+        ptr2 = reply_data->key2;
+        break;
+    default:
+        return EINVAL;
+    }
+
+    max_len = rec->len - sizeof(struct sss_mc_rec);
+
+    if (ptr1 >= max_len) {
+        return EINVAL;
+    }
+    len = strnlen(rec->data + ptr1, max_len - ptr1);
+    if (len == max_len - ptr1) {
+        return EINVAL;
+    }
+    key1->str = rec->data + ptr1;
+    key1->len = len + 1;
+
+    if (mcc->type != SSS_MC_PASSWD && mcc->type != SSS_MC_GROUP) {
+        if (ptr2 >= max_len) {
+            return EINVAL;
+        }
+        len = strnlen(rec->data + ptr2, max_len - ptr2);
+        if (len == max_len - ptr2) {
+            return EINVAL;
+        }
+        key2->str = rec->data + ptr2;
+        key2->len = len + 1;
+        return EOK;
+    }
+
+    ret = snprintf(idbuf, idbuf_len, "%ld", (long)id);
+    if (ret < 0 || (size_t)ret >= idbuf_len) {
+        return EINVAL;
+    }
+    to_sized_string(key2, idbuf);
+
+    return EOK;
+}
+
+/* Copies a record of the old cache into the new one. The new file is not
+ * visible to clients yet. */
+static errno_t sss_mc_migrate_rec(struct sss_mc_ctx *new_mcc,
+                                  struct sss_mc_ctx *old_mcc,
+                                  struct sss_mc_rec *old_rec)
+{
+    struct sss_mc_rec *rec;
+    struct sized_string key1;
+    struct sized_string key2;
+    char idbuf[11];
+    uint32_t base_slot;
+    int num_slots;
+    errno_t ret;
+    int i;
+
+    ret = sss_mc_get_rec_keys(old_mcc, old_rec, idbuf, sizeof(idbuf),
+                              &key1, &key2);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    num_slots = MC_SIZE_TO_SLOTS(old_rec->len);
+    ret = sss_mc_find_free_slots(new_mcc, num_slots, &base_slot);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    rec = MC_SLOT_TO_PTR(new_mcc->data_table, base_slot, struct sss_mc_rec);
+    for (i = 0; i < num_slots; i++) {
+        MC_SET_BIT(new_mcc->free_table, base_slot + i);
+    }
+
+    memcpy(rec, old_rec, old_rec->len);
+
+    sss_mc_raise_rec_barrier(new_mcc, rec);
+    rec->next1 = MC_INVALID_VAL;
+    rec->next2 = MC_INVALID_VAL;
+    /* the hash depends on the seed and on the size of the hash table */
+    rec->hash1 = sss_mc_hash(new_mcc, key1.str, key1.len);
+    rec->hash2 = sss_mc_hash(new_mcc, key2.str, key2.len);
+    MC_LOWER_BARRIER(rec);
+
+    ret = sss_mmap_chain_in_rec(new_mcc, rec);
+    if (ret != EOK) {
+        sss_mc_invalidate_rec(new_mcc, rec);
+        return ret;
+    }
+
+    return EOK;
+}
+
+/*
+ * Replaces the cache with one twice as large (up to max_elem) without
+ * dropping its content. The new file is built next to the current one,
+ * the records that are still valid are copied into it and then it is
+ * renamed over the current file. Finally the old file is marked as recycled
+ * so clients reopen the cache by name and find the new file with the
+ * migrated records.
+ */
+static errno_t sss_mc_grow(struct sss_mc_ctx **_mcc)
+{
+    struct sss_mc_ctx *old_mcc = *_mcc;
+    struct sss_mc_ctx *new_mcc = NULL;
+    struct sss_mc_rec *rec;
+    TALLOC_CTX *tmp_ctx;
+    char *tmp_file;
+    char *file;
+    size_t old_elem;
+    size_t n_elem;
+    uint32_t tot_slots;
+    uint32_t slot;
+    uint32_t migrated = 0;
+    time_t now;
+    bool used;
+    errno_t ret;
+
+    old_elem = old_mcc->ft_size * 8;
+    n_elem = MIN(old_elem * 2, old_mcc->max_elem);
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    tmp_file = talloc_asprintf(tmp_ctx, "%s.grow", old_mcc->file);
+    if (tmp_file == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_mc_init_file(talloc_parent(old_mcc), old_mcc->name, tmp_file,
+                           old_mcc->uid, old_mcc->gid, old_mcc->type,
+                           old_mcc->layout, old_mcc->hash, old_mcc->flags,
+                           n_elem, old_mcc->max_elem,
+                           old_mcc->valid_time_slot, old_mcc->neg_timeout,
+                           false, &new_mcc);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    now = time(NULL);
+    tot_slots = old_mcc->ft_size * 8;
+    slot = 0;
+    while (slot < tot_slots) {
+        MC_PROBE_BIT(old_mcc->free_table, slot, used);
+        if (!used) {
+            slot++;
+            continue;
+        }
+
+        rec = MC_SLOT_TO_PTR(old_mcc->data_table, slot, struct sss_mc_rec);
+        if (!sss_mc_is_valid_rec(old_mcc, rec)) {
+            slot++;
+            continue;
+        }
+        slot += MC_SIZE_TO_SLOTS(rec->len);
+
+        if (rec->expire < now) {
+            continue;
+        }
+
+        ret = sss_mc_migrate_rec(new_mcc, old_mcc, rec);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Failed to migrate record of memory cache %s [%d]: %s\n",
+                  old_mcc->name, ret, sss_strerror(ret));
+            goto done;
+        }
+        migrated++;
+    }
+
+    file = talloc_strdup(new_mcc, old_mcc->file);
+    if (file == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = rename(tmp_file, file);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to rename %s to %s: %d(%s)\n",
+              tmp_file, file, ret, strerror(ret));
+        goto done;
+    }
+
+    talloc_free(new_mcc->file);
+    new_mcc->file = file;
+
+    /* clients still using the old file will now switch to the new one */
+    sss_mc_header_update(old_mcc, SSS_MC_HEADER_RECYCLED);
+
+    DEBUG(SSSDBG_IMPORTANT_INFO,
+          "Memory cache %s grown from %zu to %zu elements, "
+          "%u records migrated.\n",
+          old_mcc->name, old_elem, n_elem, migrated);
+
+    talloc_free(old_mcc);
+    *_mcc = new_mcc;
+    new_mcc = NULL;
+    ret = EOK;
+
+done:
+    if (new_mcc != NULL) {
+        if (unlink(tmp_file) == -1) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Failed to rm mmap file %s\n",
+                  tmp_file);
+        }
+        talloc_free(new_mcc);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
                               uid_t uid, gid_t gid,
-                              size_t n_elem,
+                              size_t n_elem, size_t max_elem,
                               time_t timeout, struct sss_mc_ctx **mc_ctx)
 {
     errno_t ret;
     TALLOC_CTX* tmp_ctx = NULL;
     char *name;
     enum sss_mc_type type;
+    uint32_t layout;
+    uint32_t hash;
+    uint32_t flags;
+    uint32_t neg_timeout;
 
     if (mc_ctx == NULL || (*mc_ctx) == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -1413,11 +2514,19 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
     }
 
     type = (*mc_ctx)->type;
+    layout = (*mc_ctx)->layout;
+    hash = (*mc_ctx)->hash;
+    flags = (*mc_ctx)->flags;
+    neg_timeout = (*mc_ctx)->neg_timeout;
 
     if (n_elem == (size_t)-1) {
         n_elem = (*mc_ctx)->ft_size * 8;
     }
 
+    if (max_elem == (size_t)-1) {
+        max_elem = (*mc_ctx)->max_elem;
+    }
+
     if (timeout == (time_t)-1) {
         timeout = (*mc_ctx)->valid_time_slot;
     }
@@ -1439,8 +2548,14 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
                               name,
                               uid, gid,
                               type,
+                              layout,
+                              hash,
+                              flags,
                               n_elem,
+                              max_elem,
                               timeout,
+                              neg_timeout,
+                              false,
                               mc_ctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to re-initialize mmap cache.\n");
@@ -1468,6 +2583,20 @@ void sss_mmap_cache_reset(struct sss_mc_ctx *mc_ctx)
     memset(mc_ctx->data_table, 0xff, mc_ctx->dt_size);
     memset(mc_ctx->free_table, 0x00, mc_ctx->ft_size);
     memset(mc_ctx->hash_table, 0xff, mc_ctx->ht_size);
+    mc_ctx->live_evictions = 0;
 
     sss_mc_header_update(mc_ctx, SSS_MC_HEADER_ALIVE);
 }
+
+void sss_mmap_cache_set_health(struct sss_mc_ctx *mc_ctx, uint32_t health)
+{
+    struct sss_mc_header *h;
+
+    if (mc_ctx == NULL || mc_ctx->mmap_base == NULL) {
+        return;
+    }
+
+    /* A single aligned word, clients read it without the barriers. */
+    h = (struct sss_mc_header *)mc_ctx->mmap_base;
+    __atomic_store_n(&h->health, health, __ATOMIC_RELAXED);
+}
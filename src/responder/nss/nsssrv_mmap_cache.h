@@ -23,6 +23,9 @@
 #define _NSSSRV_MMAP_CACHE_H_
 
 #define SSS_MC_CACHE_ELEMENTS 50000
+/* a cache file that grows is never made larger than this many times the
+ * configured number of elements */
+#define SSS_MC_MAX_GROWTH_FACTOR 8
 
 struct sss_mc_ctx;
 
@@ -31,12 +34,18 @@ enum sss_mc_type {
     SSS_MC_PASSWD,
     SSS_MC_GROUP,
     SSS_MC_INITGROUPS,
+    SSS_MC_SID,
+    SSS_MC_SERVICES,
+    SSS_MC_HOSTS,
 };
 
 errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
                             uid_t uid, gid_t gid,
-                            enum sss_mc_type type, size_t n_elem,
-                            time_t valid_time, struct sss_mc_ctx **mcc);
+                            enum sss_mc_type type, uint32_t layout,
+                            uint32_t hash, uint32_t flags,
+                            size_t n_elem, size_t max_elem,
+                            time_t valid_time, uint32_t neg_timeout,
+                            bool reuse, struct sss_mc_ctx **mcc);
 
 errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
                                 struct sized_string *name,
@@ -71,11 +80,40 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid);
 errno_t sss_mmap_cache_initgr_invalidate(struct sss_mc_ctx *mcc,
                                          struct sized_string *name);
 
+/* Invalidates the records of all names and, in the passwd and group caches,
+ * of all IDs at once. _count is set to the number of records removed. */
+errno_t sss_mmap_cache_invalidate_batch(struct sss_mc_ctx *mcc,
+                                        struct sized_string *names,
+                                        size_t num_names,
+                                        uint32_t *ids, size_t num_ids,
+                                        uint32_t *_count);
+
+/* key is NULL for lookups by SID or name, otherwise it is the key built
+ * from the POSIX ID with one of the MC_SID_*_KEY formats */
+errno_t sss_mmap_cache_sid_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *key,
+                                 struct sized_string *sid,
+                                 struct sized_string *name,
+                                 uint32_t type, uint32_t id);
+
+errno_t sss_mmap_cache_sid_invalidate(struct sss_mc_ctx *mcc,
+                                      struct sized_string *key);
+
+/* Stores the result data of a services or hosts reply, key2 may be the same
+ * as key */
+errno_t sss_mmap_cache_reply_store(struct sss_mc_ctx **_mcc,
+                                   struct sized_string *key,
+                                   struct sized_string *key2,
+                                   const uint8_t *reply, size_t reply_len);
+
 errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx,
                               uid_t uid, gid_t gid,
-                              size_t n_elem,
+                              size_t n_elem, size_t max_elem,
                               time_t timeout, struct sss_mc_ctx **mc_ctx);
 
 void sss_mmap_cache_reset(struct sss_mc_ctx *mc_ctx);
 
+/* Publish the SSS_MC_HEALTH_WORD of the responder to the clients. */
+void sss_mmap_cache_set_health(struct sss_mc_ctx *mc_ctx, uint32_t health);
+
 #endif /* _NSSSRV_MMAP_CACHE_H_ */
@@ -0,0 +1,255 @@
+/*
+    SSSD
+
+    PAM Responder - cache of users found by certificate
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <ldb.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "shared/murmurhash3.h"
+#include "responder/pam/pamsrv.h"
+
+/* Certificates whose users are kept at most. */
+#define PAM_CERT_CACHE_SIZE 1024
+
+struct pam_cert_cache_entry {
+    struct pam_cert_cache_entry *prev;
+    struct pam_cert_cache_entry *next;
+
+    struct pam_cert_cache *cache;
+    time_t expire;
+
+    enum cache_req_dom_type dom_type;
+    char *cert;
+    struct ldb_result *users;
+};
+
+struct pam_cert_cache {
+    hash_table_t *table;
+    int timeout;
+
+    /* Most recently used entry first. */
+    struct pam_cert_cache_entry *entries;
+    struct pam_cert_cache_entry *last;
+    unsigned int num_entries;
+};
+
+static int pam_cert_cache_entry_destructor(struct pam_cert_cache_entry *entry)
+{
+    struct pam_cert_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+errno_t pam_cert_cache_init(struct pam_ctx *pctx, int timeout)
+{
+    struct pam_cert_cache *cache;
+
+    if (timeout <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Cache of users found by certificate is disabled.\n");
+        return EOK;
+    }
+
+    cache = talloc_zero(pctx, struct pam_cert_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->timeout = timeout;
+    pctx->cert_cache = cache;
+
+    return EOK;
+}
+
+static char *pam_cert_cache_key(TALLOC_CTX *mem_ctx,
+                                enum cache_req_dom_type dom_type,
+                                const char *cert)
+{
+    size_t len = strlen(cert);
+
+    return talloc_asprintf(mem_ctx, "%d:%zu:%08x", dom_type, len,
+                           murmurhash3(cert, len, 0xdeadbeef));
+}
+
+static struct ldb_result *pam_cert_cache_copy_users(TALLOC_CTX *mem_ctx,
+                                                    struct ldb_result *users)
+{
+    struct ldb_result *copy;
+    unsigned int i;
+
+    copy = talloc_zero(mem_ctx, struct ldb_result);
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    copy->msgs = talloc_zero_array(copy, struct ldb_message *, users->count);
+    if (copy->msgs == NULL) {
+        talloc_free(copy);
+        return NULL;
+    }
+
+    for (i = 0; i < users->count; i++) {
+        copy->msgs[i] = ldb_msg_copy(copy->msgs, users->msgs[i]);
+        if (copy->msgs[i] == NULL) {
+            talloc_free(copy);
+            return NULL;
+        }
+    }
+    copy->count = users->count;
+
+    return copy;
+}
+
+errno_t pam_cert_cache_get(TALLOC_CTX *mem_ctx,
+                           struct pam_cert_cache *cache,
+                           enum cache_req_dom_type dom_type,
+                           const char *cert,
+                           struct ldb_result **_users)
+{
+    struct pam_cert_cache_entry *entry;
+    struct ldb_result *users;
+    char *key;
+
+    if (cache == NULL || cert == NULL) {
+        return ENOENT;
+    }
+
+    key = pam_cert_cache_key(NULL, dom_type, cert);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct pam_cert_cache_entry);
+    talloc_free(key);
+    if (entry == NULL || entry->dom_type != dom_type
+            || strcmp(entry->cert, cert) != 0) {
+        return ENOENT;
+    }
+
+    if (entry->expire < time(NULL)) {
+        /* The users have to be looked up again. */
+        talloc_free(entry);
+        return ENOENT;
+    }
+
+    /* The entry may be evicted while the request is running. */
+    users = pam_cert_cache_copy_users(mem_ctx, entry->users);
+    if (users == NULL) {
+        return ENOMEM;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    *_users = users;
+    return EOK;
+}
+
+void pam_cert_cache_add(struct pam_cert_cache *cache,
+                        enum cache_req_dom_type dom_type,
+                        const char *cert,
+                        struct ldb_result *users)
+{
+    struct pam_cert_cache_entry *entry;
+    char *key;
+    errno_t ret;
+
+    if (cache == NULL || cert == NULL || users == NULL || users->count == 0) {
+        return;
+    }
+
+    key = pam_cert_cache_key(NULL, dom_type, cert);
+    if (key == NULL) {
+        return;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct pam_cert_cache_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= PAM_CERT_CACHE_SIZE) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct pam_cert_cache_entry);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    entry->cert = talloc_strdup(entry, cert);
+    entry->users = pam_cert_cache_copy_users(entry, users);
+    if (entry->cert == NULL || entry->users == NULL) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(cache->table, key, entry,
+                           struct pam_cert_cache_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    entry->cache = cache;
+    entry->dom_type = dom_type;
+    entry->expire = time(NULL) + cache->timeout;
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    talloc_set_destructor(entry, pam_cert_cache_entry_destructor);
+
+done:
+    talloc_free(key);
+}
+
+void pam_cert_cache_flush(struct pam_cert_cache *cache)
+{
+    if (cache == NULL || cache->num_entries == 0) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Flushing %u users found by certificate\n",
+          cache->num_entries);
+
+    while (cache->last != NULL) {
+        talloc_free(cache->last);
+    }
+}
@@ -22,6 +22,7 @@
 
 
 #include "src/responder/pam/pam_helpers.h"
+#include "util/sss_ptr_hash.h"
 
 struct pam_initgr_table_ctx {
     hash_table_t *id_table;
@@ -160,3 +161,108 @@ errno_t pam_initgr_check_timeout(hash_table_t *id_table,
     return EOK;
 }
 
+
+struct pam_login_entry {
+    struct ldb_message *user_obj;
+    char *domain;
+};
+
+static void pam_login_cache_remove(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval tv,
+                                   void *pvt)
+{
+    struct pam_login_entry *entry;
+
+    entry = talloc_get_type(pvt, struct pam_login_entry);
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    talloc_free(entry);
+}
+
+errno_t pam_login_cache_set(struct tevent_context *ev,
+                            hash_table_t *login_table,
+                            const char *key,
+                            struct ldb_message *user_obj,
+                            const char *domain,
+                            long timeout)
+{
+    struct pam_login_entry *entry;
+    struct tevent_timer *te;
+    struct timeval tv;
+    errno_t ret;
+
+    if (login_table == NULL || key == NULL || timeout <= 0) {
+        return EOK;
+    }
+
+    entry = sss_ptr_hash_lookup(login_table, key, struct pam_login_entry);
+    talloc_free(entry);
+
+    entry = talloc_zero(login_table, struct pam_login_entry);
+    if (entry == NULL) {
+        return ENOMEM;
+    }
+
+    entry->user_obj = ldb_msg_copy(entry, user_obj);
+    entry->domain = talloc_strdup(entry, domain);
+    if (entry->user_obj == NULL || entry->domain == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tv = tevent_timeval_current_ofs(timeout, 0);
+    te = tevent_add_timer(ev, entry, tv, pam_login_cache_remove, entry);
+    if (te == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(login_table, key, entry, struct pam_login_entry);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Could not add [%s] to the PAM login cache\n", key);
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "[%s] added to PAM login cache\n", key);
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(entry);
+    }
+    return ret;
+}
+
+errno_t pam_login_cache_get(TALLOC_CTX *mem_ctx,
+                            hash_table_t *login_table,
+                            const char *key,
+                            struct ldb_message **_user_obj,
+                            const char **_domain)
+{
+    struct pam_login_entry *entry;
+    struct ldb_message *user_obj;
+
+    if (login_table == NULL || key == NULL) {
+        return ENOENT;
+    }
+
+    entry = sss_ptr_hash_lookup(login_table, key, struct pam_login_entry);
+    if (entry == NULL) {
+        DEBUG(SSSDBG_TRACE_ALL, "[%s] not found in PAM login cache\n", key);
+        return ENOENT;
+    }
+
+    /* The entry may expire while the request is running. */
+    user_obj = ldb_msg_copy(mem_ctx, entry->user_obj);
+    if (user_obj == NULL) {
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_TRACE_INTERNAL, "[%s] found in PAM login cache\n", key);
+
+    *_user_obj = user_obj;
+    *_domain = entry->domain;
+    return EOK;
+}
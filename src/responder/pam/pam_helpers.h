@@ -39,4 +39,23 @@ errno_t pam_initgr_cache_set(struct tevent_context *ev,
 errno_t pam_initgr_check_timeout(hash_table_t *id_table,
                                  char *name);
 
+/* The user found by the first phase of a login (auth, acct_mgmt,
+ * open_session, ...) is kept for timeout seconds, so that the later phases
+ * of the same login do not have to look it up again. The key identifies the
+ * login, see pam_login_cache_key(). */
+errno_t pam_login_cache_set(struct tevent_context *ev,
+                            hash_table_t *login_table,
+                            const char *key,
+                            struct ldb_message *user_obj,
+                            const char *domain,
+                            long timeout);
+
+/* Returns EOK and a copy of the user object if the login is cached,
+ * ENOENT otherwise. */
+errno_t pam_login_cache_get(TALLOC_CTX *mem_ctx,
+                            hash_table_t *login_table,
+                            const char *key,
+                            struct ldb_message **_user_obj,
+                            const char **_domain);
+
 #endif /* PAM_HELPERS_H_ */
@@ -41,6 +41,7 @@
 #include "providers/data_provider.h"
 #include "responder/pam/pamsrv.h"
 #include "responder/common/negcache.h"
+#include "util/sss_ptr_hash.h"
 #include "sss_iface/sss_iface_async.h"
 
 #define DEFAULT_PAM_FD_LIMIT 8192
@@ -49,6 +50,8 @@
 #define NO_DOMAINS_ARE_PUBLIC "none"
 #define DEFAULT_ALLOWED_UIDS ALL_UIDS_ALLOWED
 #define DEFAULT_PAM_CERT_AUTH false
+#define DEFAULT_PAM_P11_CHILD_STANDBY false
+#define DEFAULT_PAM_CERT_USER_CACHE_TIMEOUT 60
 #ifdef HAVE_NSS
 #define DEFAULT_PAM_CERT_DB_PATH SYSCONFDIR"/pki/nssdb"
 #else
@@ -170,6 +173,8 @@ static int pam_process_init(TALLOC_CTX *mem_ctx,
     int id_timeout;
     int fd_limit;
     char *tmpstr = NULL;
+    bool p11_child_standby;
+    int cert_user_cache_timeout;
 
     pam_cmds = get_pam_cmds();
     ret = sss_process_init(mem_ctx, ev, cdb,
@@ -237,6 +242,13 @@ static int pam_process_init(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    pctx->login_table = sss_ptr_hash_create(pctx, NULL, NULL);
+    if (pctx->login_table == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Could not create login hash table\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
     /* Set up file descriptor limits */
     ret = confdb_get_int(pctx->rctx->cdb,
                          CONFDB_PAM_CONF_ENTRY,
@@ -296,6 +308,53 @@ static int pam_process_init(TALLOC_CTX *mem_ctx,
             goto done;
         }
 
+        ret = confdb_get_bool(pctx->rctx->cdb,
+                              CONFDB_PAM_CONF_ENTRY,
+                              CONFDB_PAM_P11_CHILD_STANDBY,
+                              DEFAULT_PAM_P11_CHILD_STANDBY,
+                              &p11_child_standby);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE,
+                  "Failed to read '"CONFDB_PAM_P11_CHILD_STANDBY"'.\n");
+            goto done;
+        }
+
+        if (p11_child_standby) {
+            ret = confdb_get_string(pctx->rctx->cdb, pctx,
+                                    CONFDB_MONITOR_CONF_ENTRY,
+                                    CONFDB_MONITOR_CERT_VERIFICATION, NULL,
+                                    &tmpstr);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_FATAL_FAILURE,
+                      "Failed to read '"CONFDB_MONITOR_CERT_VERIFICATION"'.\n");
+                goto done;
+            }
+
+            ret = p11_standby_init(pctx, pctx->rctx->ev, pctx->nss_db, tmpstr,
+                                   &pctx->p11_standby);
+            talloc_zfree(tmpstr);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Failed to start p11_child in standby, not fatal.\n");
+            }
+        }
+
+        ret = confdb_get_int(pctx->rctx->cdb,
+                             CONFDB_PAM_CONF_ENTRY,
+                             CONFDB_PAM_CERT_USER_CACHE_TIMEOUT,
+                             DEFAULT_PAM_CERT_USER_CACHE_TIMEOUT,
+                             &cert_user_cache_timeout);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE,
+                  "Failed to read '"CONFDB_PAM_CERT_USER_CACHE_TIMEOUT"'.\n");
+            goto done;
+        }
+
+        ret = pam_cert_cache_init(pctx, cert_user_cache_timeout);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "pam_cert_cache_init failed.\n");
+            goto done;
+        }
     }
 
     if (pctx->cert_auth || pctx->num_prompting_config_sections != 0) {
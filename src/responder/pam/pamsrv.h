@@ -43,6 +43,8 @@ struct pam_ctx {
     struct resp_ctx *rctx;
     time_t id_timeout;
     hash_table_t *id_table;
+    /* users found by the first phase of a login */
+    hash_table_t *login_table;
     size_t trusted_uids_count;
     uid_t *trusted_uids;
 
@@ -56,6 +58,10 @@ struct pam_ctx {
     bool cert_auth;
     char *nss_db;
     struct sss_certmap_ctx *sss_certmap_ctx;
+    /* p11_child started ahead of the next certificate request */
+    struct p11_standby *p11_standby;
+    /* users found by certificate, see pam_cert_cache.c */
+    struct pam_cert_cache *cert_cache;
     char **smartcard_services;
 
     char **prompting_config_sections;
@@ -94,6 +100,13 @@ int LOCAL_pam_handler(struct pam_auth_req *preq);
 
 errno_t p11_child_init(struct pam_ctx *pctx);
 
+struct p11_standby;
+errno_t p11_standby_init(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         const char *nss_db,
+                         const char *verify_opts,
+                         struct p11_standby **_standby);
+
 struct cert_auth_info;
 const char *sss_cai_get_cert(struct cert_auth_info *i);
 const char *sss_cai_get_token_name(struct cert_auth_info *i);
@@ -114,7 +127,27 @@ struct tevent_req *pam_check_cert_send(TALLOC_CTX *mem_ctx,
                                        const char *verify_opts,
                                        struct sss_certmap_ctx *sss_certmap_ctx,
                                        const char *uri,
-                                       struct pam_data *pd);
+                                       struct pam_data *pd,
+                                       struct p11_standby *standby);
+/* Users found by certificate are kept for timeout seconds, so that a
+ * certificate seen again does not need another lookup. Only the lookup is
+ * cached, the certificate itself is validated by p11_child every time. */
+struct pam_cert_cache;
+errno_t pam_cert_cache_init(struct pam_ctx *pctx, int timeout);
+
+/* Returns EOK and a copy of the users mapped to cert, ENOENT if the
+ * certificate is not cached or its entry expired. */
+errno_t pam_cert_cache_get(TALLOC_CTX *mem_ctx,
+                           struct pam_cert_cache *cache,
+                           enum cache_req_dom_type dom_type,
+                           const char *cert,
+                           struct ldb_result **_users);
+void pam_cert_cache_add(struct pam_cert_cache *cache,
+                        enum cache_req_dom_type dom_type,
+                        const char *cert,
+                        struct ldb_result *users);
+void pam_cert_cache_flush(struct pam_cert_cache *cache);
+
 errno_t pam_check_cert_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
                             struct cert_auth_info **cert_list);
 
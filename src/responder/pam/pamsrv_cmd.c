@@ -24,6 +24,7 @@
 #include "util/util.h"
 #include "util/auth_utils.h"
 #include "util/find_uid.h"
+#include "util/probes.h"
 #include "db/sysdb.h"
 #include "confdb/confdb.h"
 #include "responder/common/responder_packet.h"
@@ -1115,6 +1116,7 @@ static void pam_reply(struct pam_auth_req *preq)
 done:
     DEBUG(SSSDBG_FUNC_DATA, "Returning [%d]: %s to the client\n",
           pd->pam_status, pam_strerror(NULL, pd->pam_status));
+    PROBE(PAM_REPLY, pd->cmd, pd->pam_status);
     sss_cmd_done(cctx, preq);
 }
 
@@ -1407,7 +1409,7 @@ static errno_t check_cert(TALLOC_CTX *mctx,
     req = pam_check_cert_send(mctx, ev,
                               pctx->nss_db, p11_child_timeout,
                               cert_verification_opts, pctx->sss_certmap_ctx,
-                              uri, pd);
+                              uri, pd, pctx->p11_standby);
     if (req == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "pam_check_cert_send failed.\n");
         return ENOMEM;
@@ -1422,6 +1424,7 @@ static int pam_forwarder(struct cli_ctx *cctx, int pam_cmd)
     struct pam_auth_req *preq;
     struct pam_data *pd;
     int ret;
+    bool force;
     struct pam_ctx *pctx =
             talloc_get_type(cctx->rctx->pvt_ctx, struct pam_ctx);
     struct tevent_req *req;
@@ -1452,10 +1455,17 @@ static int pam_forwarder(struct cli_ctx *cctx, int pam_cmd)
 
     pd->cmd = pam_cmd;
     pd->priv = cctx->priv;
+    PROBE(PAM_REQ_START, pam_cmd);
 
     ret = pam_forwarder_parse_data(cctx, pd);
     if (ret == EAGAIN) {
-        req = sss_dp_get_domains_send(cctx->rctx, cctx->rctx, true, pd->domain);
+        /* Do not force a refresh of the subdomains for a domain which the
+         * last refresh did not find. */
+        force = pd->domain == NULL || cctx->rctx->ncache == NULL
+                || sss_ncache_check_unknown_domain(cctx->rctx->ncache,
+                                                   pd->domain) != EEXIST;
+        req = sss_dp_get_domains_send(cctx->rctx, cctx->rctx, force,
+                                      pd->domain);
         if (req == NULL) {
             ret = ENOMEM;
         } else {
@@ -1489,6 +1499,7 @@ done:
 
 static errno_t pam_user_by_cert_step(struct pam_auth_req *preq);
 static void pam_forwarder_lookup_by_cert_done(struct tevent_req *req);
+static void pam_user_by_cert_finish(struct pam_auth_req *preq);
 static void pam_forwarder_cert_cb(struct tevent_req *req)
 {
     struct pam_auth_req *preq = tevent_req_callback_data(req,
@@ -1556,12 +1567,37 @@ static errno_t pam_user_by_cert_step(struct pam_auth_req *preq)
     struct tevent_req *req;
     struct pam_ctx *pctx =
             talloc_get_type(preq->cctx->rctx->pvt_ctx, struct pam_ctx);
+    struct ldb_result *cert_user_objs;
+    errno_t ret;
 
     if (preq->current_cert == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Missing certificate data.\n");
         return EINVAL;
     }
 
+    /* Certificates seen recently are not looked up again. */
+    while (preq->current_cert != NULL) {
+        ret = pam_cert_cache_get(preq, pctx->cert_cache, preq->req_dom_type,
+                                 sss_cai_get_cert(preq->current_cert),
+                                 &cert_user_objs);
+        if (ret == ENOENT) {
+            break;
+        } else if (ret != EOK) {
+            return ret;
+        }
+
+        DEBUG(SSSDBG_TRACE_ALL,
+              "Using [%u] cached users of the certificate.\n",
+              cert_user_objs->count);
+        sss_cai_set_cert_user_objs(preq->current_cert, cert_user_objs);
+        preq->current_cert = sss_cai_get_next(preq->current_cert);
+    }
+
+    if (preq->current_cert == NULL) {
+        pam_user_by_cert_finish(preq);
+        return EOK;
+    }
+
     req = cache_req_user_by_cert_send(preq, cctx->ev, cctx->rctx,
                                       pctx->rctx->ncache, 0,
                                       preq->req_dom_type, NULL,
@@ -1651,9 +1687,8 @@ static void pam_forwarder_lookup_by_cert_done(struct tevent_req *req)
     struct cache_req_result **results;
     struct pam_auth_req *preq = tevent_req_callback_data(req,
                                                          struct pam_auth_req);
-    const char *cert_user = NULL;
-    size_t cert_count = 0;
-    size_t cert_user_count = 0;
+    struct pam_ctx *pctx =
+            talloc_get_type(preq->cctx->rctx->pvt_ctx, struct pam_ctx);
     struct ldb_result *cert_user_objs;
 
     ret = cache_req_recv(preq, req, &results);
@@ -1671,6 +1706,9 @@ static void pam_forwarder_lookup_by_cert_done(struct tevent_req *req)
             goto done;
         }
 
+        pam_cert_cache_add(pctx->cert_cache, preq->req_dom_type,
+                           sss_cai_get_cert(preq->current_cert),
+                           cert_user_objs);
         sss_cai_set_cert_user_objs(preq->current_cert, cert_user_objs);
     }
 
@@ -1684,6 +1722,21 @@ static void pam_forwarder_lookup_by_cert_done(struct tevent_req *req)
         return;
     }
 
+    pam_user_by_cert_finish(preq);
+    return;
+
+done:
+    pam_check_user_done(preq, ret);
+}
+
+static void pam_user_by_cert_finish(struct pam_auth_req *preq)
+{
+    int ret;
+    const char *cert_user = NULL;
+    size_t cert_count = 0;
+    size_t cert_user_count = 0;
+    struct ldb_result *cert_user_objs;
+
     sss_cai_check_users(&preq->cert_list, &cert_count, &cert_user_count);
     DEBUG(SSSDBG_TRACE_ALL,
           "Found [%zu] certificates and [%zu] related users.\n",
@@ -1857,6 +1910,15 @@ static void pam_forwarder_cb(struct tevent_req *req)
 
     ret = pam_forwarder_parse_data(cctx, pd);
     if (ret == EAGAIN) {
+        if (pd->domain != NULL && cctx->rctx->ncache != NULL) {
+            ret = sss_ncache_set_unknown_domain(cctx->rctx->ncache,
+                                                pd->domain);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE, "Unable to store unknown domain "
+                      "[%s] in the negative cache, ignored.\n", pd->domain);
+            }
+        }
+
         DEBUG(SSSDBG_TRACE_FUNC, "Assuming %s is a UPN\n", pd->logon_name);
         /* If not, cache_req will error out later */
         pd->user = talloc_strdup(pd, pd->logon_name);
@@ -1889,12 +1951,80 @@ static void pam_check_user_search_lookup(struct tevent_req *req);
 static void pam_check_user_search_done(struct pam_auth_req *preq, int ret,
                                        struct cache_req_result *result);
 
+/* A login is identified by the PAM client process and the user and domain
+ * it asked for. */
+static char *pam_login_cache_key(TALLOC_CTX *mem_ctx,
+                                 struct pam_auth_req *preq)
+{
+    return talloc_asprintf(mem_ctx, "%"PRIu32":%d:%s:%s",
+                           preq->pd->cli_pid, preq->req_dom_type,
+                           preq->pd->domain != NULL ? preq->pd->domain : "",
+                           preq->pd->logon_name);
+}
+
+/* The later phases of a login reuse the user found by the first one. */
+static errno_t pam_check_user_login_cache(struct pam_auth_req *preq)
+{
+    struct pam_ctx *pctx;
+    struct ldb_message *user_obj;
+    struct sss_domain_info *dom;
+    const char *domain;
+    char *key;
+    errno_t ret;
+
+    if (preq->pd->cli_pid == 0) {
+        /* Logins cannot be told apart. */
+        return ENOENT;
+    }
+
+    pctx = talloc_get_type(preq->cctx->rctx->pvt_ctx, struct pam_ctx);
+
+    key = pam_login_cache_key(preq, preq);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    ret = pam_login_cache_get(preq, pctx->login_table, key,
+                              &user_obj, &domain);
+    talloc_free(key);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* The domain might have been removed meanwhile. */
+    dom = find_domain_by_name(preq->cctx->rctx->domains, domain, true);
+    if (dom == NULL) {
+        talloc_free(user_obj);
+        return ENOENT;
+    }
+
+    preq->user_obj = user_obj;
+    pd_set_primary_name(preq->user_obj, preq->pd);
+    preq->domain = dom;
+
+    return EOK;
+}
+
 /* lookup the user uid from the cache first,
  * then we'll refresh initgroups if needed */
 static int pam_check_user_search(struct pam_auth_req *preq)
 {
     struct tevent_req *dpreq;
     struct cache_req_data *data;
+    errno_t ret;
+
+    ret = pam_check_user_login_cache(preq);
+    if (ret == EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "User [%s] was found by an earlier phase of "
+              "the same login\n", preq->pd->logon_name);
+        pam_dom_forwarder(preq);
+        /* The request is finished by pam_dom_forwarder(), like after an
+         * asynchronous lookup. */
+        return EAGAIN;
+    } else if (ret != ENOENT) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Could not look up the PAM login cache "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
 
     data = cache_req_data_name(preq,
                                CACHE_REQ_INITGROUPS,
@@ -2054,6 +2184,29 @@ static void pam_check_user_search_lookup(struct tevent_req *req)
     pam_check_user_search_done(preq, ret, result);
 }
 
+static errno_t pam_login_cache_set_user(struct pam_auth_req *preq,
+                                        struct pam_ctx *pctx)
+{
+    char *key;
+    errno_t ret;
+
+    if (preq->pd->cli_pid == 0) {
+        return EOK;
+    }
+
+    key = pam_login_cache_key(preq, preq);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    ret = pam_login_cache_set(pctx->rctx->ev, pctx->login_table, key,
+                              preq->user_obj, preq->domain->name,
+                              pctx->id_timeout);
+    talloc_free(key);
+
+    return ret;
+}
+
 static void pam_check_user_search_done(struct pam_auth_req *preq, int ret,
                                        struct cache_req_result *result)
 {
@@ -2061,6 +2214,9 @@ static void pam_check_user_search_done(struct pam_auth_req *preq, int ret,
 
     pctx = talloc_get_type(preq->cctx->rctx->pvt_ctx, struct pam_ctx);
 
+    PROBE(PAM_USER_FOUND, preq->pd->cmd, PROBE_SAFE_STR(preq->pd->logon_name),
+          ret == EOK ? result->domain->name : "", ret);
+
     if (ret == EOK) {
         preq->user_obj = result->msgs[0];
         pd_set_primary_name(preq->user_obj, preq->pd);
@@ -2076,6 +2232,13 @@ static void pam_check_user_search_done(struct pam_auth_req *preq, int ret,
                   "Proceeding with PAM actions\n");
         }
 
+        ret = pam_login_cache_set_user(preq, pctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Could not save the user for the next phases of the "
+                  "login. Proceeding with PAM actions\n");
+        }
+
         pam_dom_forwarder(preq);
     }
 
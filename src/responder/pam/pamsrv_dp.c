@@ -25,6 +25,7 @@
 
 #include "util/util.h"
 #include "util/sss_pam_data.h"
+#include "util/probes.h"
 #include "responder/pam/pamsrv.h"
 #include "sss_iface/sss_iface_async.h"
 
@@ -49,6 +50,7 @@ pam_dp_send_req(struct pam_auth_req *preq)
 
     DEBUG(SSSDBG_CONF_SETTINGS, "Sending request with the following data:\n");
     DEBUG_PAM_DATA(SSSDBG_CONF_SETTINGS, preq->pd);
+    PROBE(PAM_DP_SEND, preq->pd->cmd, preq->domain->name);
 
     subreq = sbus_call_dp_dp_pamHandler_send(preq, be_conn->conn,
                  be_conn->bus_name, SSS_BUS_PATH, preq->pd);
@@ -102,5 +104,6 @@ pam_dp_send_req_done(struct tevent_req *subreq)
     talloc_zfree(pam_response);
 
 done:
+    PROBE(PAM_DP_DONE, preq->pd->cmd, preq->pd->pam_status);
     preq->callback(preq);
 }
@@ -20,6 +20,7 @@
 */
 
 #include <time.h>
+#include <poll.h>
 
 #include "util/util.h"
 #include "providers/data_provider.h"
@@ -31,6 +32,8 @@
 #include "util/crypto/sss_crypto.h"
 #include "db/sysdb.h"
 
+/* Seconds a p11_child waits in standby before it is replaced */
+#define P11_STANDBY_REFRESH_TIMEOUT 300
 
 struct cert_auth_info {
     char *cert;
@@ -38,6 +41,8 @@ struct cert_auth_info {
     char *module_name;
     char *key_id;
     char *label;
+    /* parsed cert, may be NULL */
+    struct sss_cert_content *cert_content;
     struct ldb_result *cert_user_objs;
     struct cert_auth_info *prev;
     struct cert_auth_info *next;
@@ -210,6 +215,8 @@ done:
     if (ret == EOK) {
         sss_certmap_free_ctx(pctx->sss_certmap_ctx);
         pctx->sss_certmap_ctx = sss_certmap_ctx;
+        /* The mapping rules might have changed. */
+        pam_cert_cache_flush(pctx->cert_cache);
     } else {
         sss_certmap_free_ctx(sss_certmap_ctx);
     }
@@ -656,7 +663,13 @@ static errno_t parse_p11_child_response(TALLOC_CTX *mem_ctx, uint8_t *buf,
             goto done;
         }
 
-        ret = sss_certmap_match_cert(sss_certmap_ctx, der, der_size);
+        /* The parsed cert is used again for the prompt. */
+        ret = sss_certmap_parse_cert(cert_auth_info, der, der_size,
+                                     &cert_auth_info->cert_content);
+        if (ret == 0) {
+            ret = sss_certmap_match_cert_content(sss_certmap_ctx,
+                                                 cert_auth_info->cert_content);
+        }
         if (ret == 0) {
             DLIST_ADD(cert_list, cert_auth_info);
         } else {
@@ -685,12 +698,347 @@ done:
     return ret;
 }
 
+static errno_t p11_child_start(TALLOC_CTX *mem_ctx,
+                               struct tevent_context *ev,
+                               const char **extra_args,
+                               struct child_io_fds **_io,
+                               struct sss_child_ctx_old **_child_ctx)
+{
+    errno_t ret;
+    pid_t child_pid;
+    int pipefd_to_child[2] = PIPE_INIT;
+    int pipefd_from_child[2] = PIPE_INIT;
+    struct child_io_fds *io;
+
+    io = talloc(mem_ctx, struct child_io_fds);
+    if (io == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc failed.\n");
+        return ENOMEM;
+    }
+    io->write_to_child_fd = -1;
+    io->read_from_child_fd = -1;
+    talloc_set_destructor((void *) io, child_io_destructor);
+
+    ret = pipe(pipefd_from_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", ret, strerror(ret));
+        goto done;
+    }
+    ret = pipe(pipefd_to_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", ret, strerror(ret));
+        goto done;
+    }
+
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child,
+                          P11_CHILD_PATH, P11_CHILD_LOG_FILE, extra_args, false,
+                          STDIN_FILENO, STDOUT_FILENO, &child_pid);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    sss_fd_nonblocking(io->read_from_child_fd);
+
+    io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(io->write_to_child_fd);
+
+    /* Set up SIGCHLD handler */
+    ret = child_handler_setup(ev, child_pid, NULL, NULL, _child_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not set up child handlers [%d]: %s\n",
+            ret, sss_strerror(ret));
+        ret = ERR_P11_CHILD;
+        goto done;
+    }
+
+    *_io = io;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        PIPE_CLOSE(pipefd_from_child);
+        PIPE_CLOSE(pipefd_to_child);
+        talloc_free(io);
+    }
+
+    return ret;
+}
+
+/* A p11_child which already loaded the PKCS#11 modules and waits for the
+ * options of the next request on stdin. */
+struct p11_standby_child {
+    struct p11_standby *standby;
+    struct sss_child_ctx_old *child_ctx;
+    struct child_io_fds *io;
+    struct tevent_fd *exit_fde;
+    struct tevent_timer *refresh_te;
+};
+
+struct p11_standby {
+    struct tevent_context *ev;
+    char *nss_db;
+    char *verify_opts;
+
+    struct p11_standby_child *child;
+};
+
+static errno_t p11_standby_refill(struct p11_standby *standby);
+
+static int p11_standby_child_destructor(struct p11_standby_child *child)
+{
+    /* Closing the pipes makes the child exit. */
+    if (child->standby->child == child) {
+        child->standby->child = NULL;
+    }
+
+    return 0;
+}
+
+static void p11_standby_child_exited(struct tevent_context *ev,
+                                     struct tevent_fd *fde,
+                                     uint16_t flags, void *pvt)
+{
+    struct p11_standby_child *child;
+
+    child = talloc_get_type(pvt, struct p11_standby_child);
+
+    /* The child never writes before it got a request. */
+    DEBUG(SSSDBG_MINOR_FAILURE, "p11_child in standby exited.\n");
+    talloc_free(child);
+}
+
+static void p11_standby_child_refresh(struct tevent_context *ev,
+                                      struct tevent_timer *te,
+                                      struct timeval tv, void *pvt)
+{
+    struct p11_standby_child *child;
+    struct p11_standby *standby;
+    errno_t ret;
+
+    child = talloc_get_type(pvt, struct p11_standby_child);
+    standby = child->standby;
+
+    /* Do not keep the state of the PKCS#11 modules forever. */
+    DEBUG(SSSDBG_TRACE_FUNC, "Replacing p11_child in standby.\n");
+    talloc_free(child);
+
+    ret = p11_standby_refill(standby);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Failed to start p11_child in standby "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
+}
+
+static errno_t p11_standby_refill(struct p11_standby *standby)
+{
+    struct p11_standby_child *child;
+    const char *extra_args[5] = { NULL };
+    size_t arg_c = 0;
+    struct timeval tv;
+    errno_t ret;
+
+    if (standby == NULL || standby->child != NULL) {
+        return EOK;
+    }
+
+    child = talloc_zero(standby, struct p11_standby_child);
+    if (child == NULL) {
+        return ENOMEM;
+    }
+    child->standby = standby;
+
+    /* extra_args are added in revers order */
+    extra_args[arg_c++] = standby->nss_db;
+    extra_args[arg_c++] = "--nssdb";
+    if (standby->verify_opts != NULL) {
+        extra_args[arg_c++] = standby->verify_opts;
+        extra_args[arg_c++] = "--verify";
+    }
+    extra_args[arg_c++] = "--standby";
+
+    ret = p11_child_start(child, standby->ev, extra_args, &child->io,
+                          &child->child_ctx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    child->exit_fde = tevent_add_fd(standby->ev, child,
+                                    child->io->read_from_child_fd,
+                                    TEVENT_FD_READ,
+                                    p11_standby_child_exited, child);
+    if (child->exit_fde == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tv = tevent_timeval_current_ofs(P11_STANDBY_REFRESH_TIMEOUT, 0);
+    child->refresh_te = tevent_add_timer(standby->ev, child, tv,
+                                         p11_standby_child_refresh, child);
+    if (child->refresh_te == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    standby->child = child;
+    talloc_set_destructor(child, p11_standby_child_destructor);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(child);
+    }
+
+    return ret;
+}
+
+errno_t p11_standby_init(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         const char *nss_db,
+                         const char *verify_opts,
+                         struct p11_standby **_standby)
+{
+    struct p11_standby *standby;
+    errno_t ret;
+
+    standby = talloc_zero(mem_ctx, struct p11_standby);
+    if (standby == NULL) {
+        return ENOMEM;
+    }
+
+    standby->ev = ev;
+    standby->nss_db = talloc_strdup(standby, nss_db);
+    if (standby->nss_db == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (verify_opts != NULL) {
+        standby->verify_opts = talloc_strdup(standby, verify_opts);
+        if (standby->verify_opts == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    ret = p11_standby_refill(standby);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_standby = standby;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(standby);
+    }
+
+    return ret;
+}
+
+/* Returns the waiting child if it was started for the same options and is
+ * still alive. */
+static struct p11_standby_child *
+p11_standby_take(struct p11_standby *standby,
+                 const char *nss_db, const char *verify_opts)
+{
+    struct p11_standby_child *child;
+    struct pollfd pfd;
+
+    if (standby == NULL || standby->child == NULL) {
+        return NULL;
+    }
+
+    if (strcmp(standby->nss_db, nss_db) != 0
+            || (standby->verify_opts == NULL) != (verify_opts == NULL)
+            || (verify_opts != NULL
+                    && strcmp(standby->verify_opts, verify_opts) != 0)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "p11_child in standby was started with different options.\n");
+        return NULL;
+    }
+
+    child = standby->child;
+
+    /* The exit might not have been processed yet. */
+    pfd.fd = child->io->read_from_child_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) != 0) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "p11_child in standby exited.\n");
+        talloc_free(child);
+        return NULL;
+    }
+
+    talloc_zfree(child->exit_fde);
+    talloc_zfree(child->refresh_te);
+    standby->child = NULL;
+
+    return child;
+}
+
+/* The options of the request are sent to a child in standby mode as NUL
+ * terminated strings ending with an empty string, followed by the data
+ * p11_child usually reads from stdin. */
+static errno_t get_p11_standby_write_buffer(TALLOC_CTX *mem_ctx,
+                                            const char **extra_args,
+                                            size_t arg_c,
+                                            uint8_t *data, size_t data_len,
+                                            uint8_t **_buf, size_t *_len)
+{
+    uint8_t *buf;
+    size_t len;
+    size_t c;
+    size_t rp = 0;
+
+    len = data_len + 1;
+    for (c = 0; c < arg_c; c++) {
+        len += strlen(extra_args[c]) + 1;
+    }
+
+    if (len > P11_CHILD_IN_BUF_SIZE) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Request for p11_child is too large.\n");
+        return EINVAL;
+    }
+
+    buf = talloc_size(mem_ctx, len);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    /* extra_args are added in revers order */
+    for (c = arg_c; c > 0; c--) {
+        safealign_memcpy(&buf[rp], extra_args[c - 1],
+                         strlen(extra_args[c - 1]) + 1, &rp);
+    }
+    buf[rp++] = '\0';
+
+    if (data_len != 0) {
+        safealign_memcpy(&buf[rp], data, data_len, &rp);
+    }
+
+    *_buf = buf;
+    *_len = len;
+
+    return EOK;
+}
+
 struct pam_check_cert_state {
     int child_status;
     struct sss_child_ctx_old *child_ctx;
     struct tevent_timer *timeout_handler;
     struct tevent_context *ev;
     struct sss_certmap_ctx *sss_certmap_ctx;
+    struct p11_standby *standby;
 
     struct child_io_fds *io;
 
@@ -710,17 +1058,19 @@ struct tevent_req *pam_check_cert_send(TALLOC_CTX *mem_ctx,
                                        const char *verify_opts,
                                        struct sss_certmap_ctx *sss_certmap_ctx,
                                        const char *uri,
-                                       struct pam_data *pd)
+                                       struct pam_data *pd,
+                                       struct p11_standby *standby)
 {
     errno_t ret;
     struct tevent_req *req;
     struct tevent_req *subreq;
     struct pam_check_cert_state *state;
-    pid_t child_pid;
+    struct p11_standby_child *standby_child;
+    bool use_standby = false;
     struct timeval tv;
-    int pipefd_to_child[2] = PIPE_INIT;
-    int pipefd_from_child[2] = PIPE_INIT;
     const char *extra_args[16] = { NULL };
+    uint8_t *data_buf = NULL;
+    size_t data_buf_len = 0;
     uint8_t *write_buf = NULL;
     size_t write_buf_len = 0;
     size_t arg_c;
@@ -756,12 +1106,6 @@ struct tevent_req *pam_check_cert_send(TALLOC_CTX *mem_ctx,
     if ((pd->cli_flags & PAM_CLI_FLAGS_REQUIRE_CERT_AUTH) && pd->priv == 1) {
         extra_args[arg_c++] = "--wait_for_card";
     }
-    extra_args[arg_c++] = nss_db;
-    extra_args[arg_c++] = "--nssdb";
-    if (verify_opts != NULL) {
-        extra_args[arg_c++] = verify_opts;
-        extra_args[arg_c++] = "--verify";
-    }
 
     if (sss_authtok_get_type(pd->authtok) == SSS_AUTHTOK_TYPE_SC_PIN
             || sss_authtok_get_type(pd->authtok) == SSS_AUTHTOK_TYPE_SC_KEYPAD) {
@@ -811,113 +1155,90 @@ struct tevent_req *pam_check_cert_send(TALLOC_CTX *mem_ctx,
 
     state->ev = ev;
     state->sss_certmap_ctx = sss_certmap_ctx;
+    state->standby = standby;
     state->child_status = EFAULT;
-    state->io = talloc(state, struct child_io_fds);
-    if (state->io == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "talloc failed.\n");
-        ret = ENOMEM;
-        goto done;
-    }
-    state->io->write_to_child_fd = -1;
-    state->io->read_from_child_fd = -1;
-    talloc_set_destructor((void *) state->io, child_io_destructor);
 
-    ret = pipe(pipefd_from_child);
-    if (ret == -1) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "pipe failed [%d][%s].\n", ret, strerror(ret));
-        goto done;
+    standby_child = p11_standby_take(standby, nss_db, verify_opts);
+    if (standby_child != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Using p11_child in standby.\n");
+        use_standby = true;
+        state->io = talloc_steal(state, standby_child->io);
+        state->child_ctx = standby_child->child_ctx;
+        talloc_free(standby_child);
+    } else {
+        extra_args[arg_c++] = nss_db;
+        extra_args[arg_c++] = "--nssdb";
+        if (verify_opts != NULL) {
+            extra_args[arg_c++] = verify_opts;
+            extra_args[arg_c++] = "--verify";
+        }
+
+        ret = p11_child_start(state, ev, extra_args, &state->io,
+                              &state->child_ctx);
+        if (ret != EOK) {
+            goto done;
+        }
     }
-    ret = pipe(pipefd_to_child);
-    if (ret == -1) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "pipe failed [%d][%s].\n", ret, strerror(ret));
+
+    /* Set up timeout handler */
+    tv = tevent_timeval_current_ofs(timeout, 0);
+    state->timeout_handler = tevent_add_timer(ev, req, tv,
+                                              p11_child_timeout, req);
+    if(state->timeout_handler == NULL) {
+        ret = ERR_P11_CHILD;
         goto done;
     }
 
-    child_pid = fork();
-    if (child_pid == 0) { /* child */
-        exec_child_ex(state, pipefd_to_child, pipefd_from_child,
-                      P11_CHILD_PATH, P11_CHILD_LOG_FILE, extra_args, false,
-                      STDIN_FILENO, STDOUT_FILENO);
-
-        /* We should never get here */
-        DEBUG(SSSDBG_CRIT_FAILURE, "BUG: Could not exec p11 child\n");
-    } else if (child_pid > 0) { /* parent */
-
-        state->io->read_from_child_fd = pipefd_from_child[0];
-        PIPE_FD_CLOSE(pipefd_from_child[1]);
-        sss_fd_nonblocking(state->io->read_from_child_fd);
-
-        state->io->write_to_child_fd = pipefd_to_child[1];
-        PIPE_FD_CLOSE(pipefd_to_child[0]);
-        sss_fd_nonblocking(state->io->write_to_child_fd);
-
-        /* Set up SIGCHLD handler */
-        ret = child_handler_setup(ev, child_pid, NULL, NULL, &state->child_ctx);
+    if (pd->cmd == SSS_PAM_AUTHENTICATE) {
+        ret = get_p11_child_write_buffer(state, pd, &data_buf,
+                                         &data_buf_len);
         if (ret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "Could not set up child handlers [%d]: %s\n",
-                ret, sss_strerror(ret));
-            ret = ERR_P11_CHILD;
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "get_p11_child_write_buffer failed.\n");
             goto done;
         }
+    }
 
-        /* Set up timeout handler */
-        tv = tevent_timeval_current_ofs(timeout, 0);
-        state->timeout_handler = tevent_add_timer(ev, req, tv,
-                                                  p11_child_timeout, req);
-        if(state->timeout_handler == NULL) {
-            ret = ERR_P11_CHILD;
+    if (use_standby) {
+        ret = get_p11_standby_write_buffer(state, extra_args, arg_c,
+                                           data_buf, data_buf_len,
+                                           &write_buf, &write_buf_len);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "get_p11_standby_write_buffer failed.\n");
             goto done;
         }
+    } else {
+        write_buf = data_buf;
+        write_buf_len = data_buf_len;
+    }
 
-        if (pd->cmd == SSS_PAM_AUTHENTICATE) {
-            ret = get_p11_child_write_buffer(state, pd, &write_buf,
-                                             &write_buf_len);
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "get_p11_child_write_buffer failed.\n");
-                goto done;
-            }
+    if (write_buf_len != 0) {
+        subreq = write_pipe_send(state, ev, write_buf, write_buf_len,
+                                 state->io->write_to_child_fd);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "write_pipe_send failed.\n");
+            ret = ERR_P11_CHILD;
+            goto done;
         }
-
-        if (write_buf_len != 0) {
-            subreq = write_pipe_send(state, ev, write_buf, write_buf_len,
-                                     state->io->write_to_child_fd);
-            if (subreq == NULL) {
-                DEBUG(SSSDBG_OP_FAILURE, "write_pipe_send failed.\n");
-                ret = ERR_P11_CHILD;
-                goto done;
-            }
-            tevent_req_set_callback(subreq, p11_child_write_done, req);
-        } else {
-            subreq = read_pipe_send(state, ev, state->io->read_from_child_fd);
-            if (subreq == NULL) {
-                DEBUG(SSSDBG_OP_FAILURE, "read_pipe_send failed.\n");
-                ret = ERR_P11_CHILD;
-                goto done;
-            }
-            tevent_req_set_callback(subreq, p11_child_done, req);
+        tevent_req_set_callback(subreq, p11_child_write_done, req);
+    } else {
+        subreq = read_pipe_send(state, ev, state->io->read_from_child_fd);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "read_pipe_send failed.\n");
+            ret = ERR_P11_CHILD;
+            goto done;
         }
-
-        /* Now either wait for the timeout to fire or the child
-         * to finish
-         */
-    } else { /* error */
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE, "fork failed [%d][%s].\n",
-                                   ret, sss_strerror(ret));
-        goto done;
+        tevent_req_set_callback(subreq, p11_child_done, req);
     }
 
+    /* Now either wait for the timeout to fire or the child
+     * to finish
+     */
     ret = EOK;
 
 done:
     if (ret != EOK) {
-        PIPE_CLOSE(pipefd_from_child);
-        PIPE_CLOSE(pipefd_to_child);
         tevent_req_error(req, ret);
         tevent_req_post(req, ev);
     }
@@ -970,6 +1291,14 @@ static void p11_child_done(struct tevent_req *subreq)
 
     PIPE_FD_CLOSE(state->io->read_from_child_fd);
 
+    /* Prepare a child for the next request now that the card is not
+     * used anymore. */
+    ret = p11_standby_refill(state->standby);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Failed to start p11_child in standby "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
+
     ret = parse_p11_child_response(state, buf, buf_len, state->sss_certmap_ctx,
                                    &state->cert_list);
     if (ret != EOK) {
@@ -1043,13 +1372,21 @@ static char *get_cert_prompt(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    der = sss_base64_decode(mem_ctx, sss_cai_get_cert(cert_info), &der_size);
-    if (der == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "sss_base64_decode failed.\n");
-        goto done;
-    }
+    if (cert_info->cert_content != NULL) {
+        ret = sss_certmap_get_search_filter_content(ctx,
+                                                    cert_info->cert_content,
+                                                    &filter, &domains);
+    } else {
+        der = sss_base64_decode(mem_ctx, sss_cai_get_cert(cert_info),
+                                &der_size);
+        if (der == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "sss_base64_decode failed.\n");
+            goto done;
+        }
 
-    ret = sss_certmap_get_search_filter(ctx, der, der_size, &filter, &domains);
+        ret = sss_certmap_get_search_filter(ctx, der, der_size, &filter,
+                                            &domains);
+    }
     if (ret != 0) {
         DEBUG(SSSDBG_OP_FAILURE, "sss_certmap_get_search_filter failed.\n");
         goto done;
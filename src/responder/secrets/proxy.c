@@ -382,13 +382,16 @@ static errno_t proxy_http_create_request(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    body = sss_iobuf_init_readonly(tmp_ctx, (uint8_t *)secreq->body.data,
-                                   secreq->body.length);
+    /* The body is only forwarded, so it does not need to be copied. */
+    body = sss_iobuf_init_steal(tmp_ctx, (uint8_t *)secreq->body.data,
+                                secreq->body.length);
     if (body == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create HTTP body!\n");
         ret = ENOMEM;
         goto done;
     }
+    secreq->body.data = NULL;
+    secreq->body.length = 0;
 
     switch (secreq->method) {
     case HTTP_GET:
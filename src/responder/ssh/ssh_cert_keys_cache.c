@@ -0,0 +1,277 @@
+/*
+    SSSD
+
+    SSH Responder - cache of keys derived from certificates
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <talloc.h>
+#include <ldb.h>
+#include <sys/stat.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "shared/murmurhash3.h"
+#include "responder/ssh/ssh_private.h"
+
+/* Certificates whose keys are kept at most. */
+#define SSH_CERT_KEYS_CACHE_SIZE 1024
+
+struct ssh_cert_keys_entry {
+    struct ssh_cert_keys_entry *prev;
+    struct ssh_cert_keys_entry *next;
+
+    struct ssh_cert_keys_cache *cache;
+    time_t expire;
+
+    struct ldb_val cert;
+    /* empty if the certificate was not valid or did not match the rules */
+    struct ldb_val key;
+};
+
+struct ssh_cert_keys_cache {
+    hash_table_t *table;
+    int timeout;
+
+    /* CA database the keys were validated against */
+    struct stat ca_db_st;
+    bool ca_db_st_valid;
+
+    /* Most recently used entry first. */
+    struct ssh_cert_keys_entry *entries;
+    struct ssh_cert_keys_entry *last;
+    unsigned int num_entries;
+};
+
+static int ssh_cert_keys_entry_destructor(struct ssh_cert_keys_entry *entry)
+{
+    struct ssh_cert_keys_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+errno_t ssh_cert_keys_cache_init(struct ssh_ctx *ssh_ctx, int timeout)
+{
+    struct ssh_cert_keys_cache *cache;
+
+    if (timeout <= 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Cache of keys derived from certificates is disabled.\n");
+        return EOK;
+    }
+
+    cache = talloc_zero(ssh_ctx, struct ssh_cert_keys_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->timeout = timeout;
+    ssh_ctx->cert_keys_cache = cache;
+
+    return EOK;
+}
+
+static char *ssh_cert_keys_key(TALLOC_CTX *mem_ctx,
+                               const struct ldb_val *cert)
+{
+    return talloc_asprintf(mem_ctx, "%zu:%08x", cert->length,
+                           murmurhash3((const char *)cert->data,
+                                       cert->length, 0xdeadbeef));
+}
+
+static struct ssh_cert_keys_entry *
+ssh_cert_keys_lookup(struct ssh_cert_keys_cache *cache,
+                     const struct ldb_val *cert)
+{
+    struct ssh_cert_keys_entry *entry;
+    char *key;
+
+    key = ssh_cert_keys_key(NULL, cert);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key, struct ssh_cert_keys_entry);
+    talloc_free(key);
+
+    return entry;
+}
+
+bool ssh_cert_keys_cache_get(struct ssh_cert_keys_cache *cache,
+                             const struct ldb_val *cert,
+                             struct ldb_val *_key)
+{
+    struct ssh_cert_keys_entry *entry;
+
+    if (cache == NULL || cert->data == NULL) {
+        return false;
+    }
+
+    entry = ssh_cert_keys_lookup(cache, cert);
+    if (entry == NULL || ldb_val_equal_exact(&entry->cert, cert) == 0) {
+        return false;
+    }
+
+    if (entry->expire < time(NULL)) {
+        /* The certificate has to be validated again. */
+        talloc_free(entry);
+        return false;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    *_key = entry->key;
+    return true;
+}
+
+void ssh_cert_keys_cache_add(struct ssh_cert_keys_cache *cache,
+                             const struct ldb_val *cert,
+                             const struct ldb_val *key)
+{
+    struct ssh_cert_keys_entry *entry;
+    char *hash_key;
+    errno_t ret;
+
+    if (cache == NULL || cert->data == NULL) {
+        return;
+    }
+
+    hash_key = ssh_cert_keys_key(NULL, cert);
+    if (hash_key == NULL) {
+        return;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, hash_key,
+                                struct ssh_cert_keys_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= SSH_CERT_KEYS_CACHE_SIZE) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct ssh_cert_keys_entry);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    entry->cert.data = talloc_memdup(entry, cert->data, cert->length);
+    if (entry->cert.data == NULL) {
+        talloc_free(entry);
+        goto done;
+    }
+    entry->cert.length = cert->length;
+
+    if (key->data != NULL) {
+        entry->key.data = talloc_memdup(entry, key->data, key->length);
+        if (entry->key.data == NULL) {
+            talloc_free(entry);
+            goto done;
+        }
+        entry->key.length = key->length;
+    }
+
+    ret = sss_ptr_hash_add(cache->table, hash_key, entry,
+                           struct ssh_cert_keys_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        goto done;
+    }
+
+    entry->cache = cache;
+    entry->expire = time(NULL) + cache->timeout;
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    talloc_set_destructor(entry, ssh_cert_keys_entry_destructor);
+
+done:
+    talloc_free(hash_key);
+}
+
+void ssh_cert_keys_cache_flush(struct ssh_cert_keys_cache *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    while (cache->last != NULL) {
+        talloc_free(cache->last);
+    }
+}
+
+void ssh_cert_keys_cache_check_ca(struct ssh_cert_keys_cache *cache,
+                                  const char *ca_db)
+{
+    char *path = NULL;
+    struct stat st;
+    int ret;
+
+    if (cache == NULL || ca_db == NULL) {
+        return;
+    }
+
+    /* A NSS database keeps the certificates in cert9.db. */
+    if (strncmp(ca_db, "sql:", 4) == 0) {
+        path = talloc_asprintf(NULL, "%s/cert9.db", ca_db + 4);
+        if (path == NULL) {
+            ssh_cert_keys_cache_flush(cache);
+            return;
+        }
+    }
+
+    ret = stat(path != NULL ? path : ca_db, &st);
+    talloc_free(path);
+    if (ret != 0) {
+        memset(&st, 0, sizeof(st));
+    }
+
+    if (cache->ca_db_st_valid
+            && st.st_dev == cache->ca_db_st.st_dev
+            && st.st_ino == cache->ca_db_st.st_ino
+            && st.st_size == cache->ca_db_st.st_size
+            && st.st_mtime == cache->ca_db_st.st_mtime) {
+        return;
+    }
+
+    if (cache->num_entries > 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "CA database %s changed, dropping %u "
+              "cached certificate keys\n", ca_db, cache->num_entries);
+        ssh_cert_keys_cache_flush(cache);
+    }
+
+    cache->ca_db_st = st;
+    cache->ca_db_st_valid = true;
+}
@@ -259,6 +259,8 @@ done:
     if (ret == EOK) {
         sss_certmap_free_ctx(ssh_ctx->sss_certmap_ctx);
         ssh_ctx->sss_certmap_ctx = sss_certmap_ctx;
+        /* The keys were derived with the old matching rules. */
+        ssh_cert_keys_cache_flush(ssh_ctx->cert_keys_cache);
         ssh_ctx->certmap_last_read = ssh_ctx->rctx->get_domains_last_call.tv_sec;
     } else {
         sss_certmap_free_ctx(sss_certmap_ctx);
@@ -374,9 +376,7 @@ static void ssh_cmd_get_host_pubkeys_done(struct tevent_req *subreq)
     if (ret == EOK || ret == ENOENT) {
         domain = ssh_get_result_domain(ssh_ctx->rctx, result, cmd_ctx->domain);
 
-        ssh_update_known_hosts_file(ssh_ctx->rctx->domains, domain,
-                                    cmd_ctx->name, ssh_ctx->hash_known_hosts,
-                                    ssh_ctx->known_hosts_timeout);
+        ssh_update_known_hosts_file(ssh_ctx, domain, cmd_ctx->name);
     }
 
     if (ret != EOK) {
@@ -21,8 +21,11 @@
 #include "config.h"
 
 #include <talloc.h>
+#include <sys/stat.h>
 
 #include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
 #include "util/crypto/sss_crypto.h"
 #include "util/sss_ssh.h"
 #include "db/sysdb.h"
@@ -166,27 +169,170 @@ done:
     return result;
 }
 
+struct ssh_known_hosts_entry {
+    struct ssh_known_hosts_entry *prev;
+    struct ssh_known_hosts_entry *next;
+
+    struct ssh_known_hosts_cache *cache;
+    unsigned int generation;
+
+    /* lastUpdate of the host entry the line was formatted from */
+    uint64_t last_update;
+    char *line;
+};
+
+struct ssh_known_hosts_cache {
+    hash_table_t *table;
+    struct ssh_known_hosts_entry *entries;
+    unsigned int generation;
+
+    /* contents of the last written known_hosts file */
+    char *contents;
+};
+
+static int ssh_known_hosts_entry_destructor(struct ssh_known_hosts_entry *entry)
+{
+    /* The hash table entry is removed by sss_ptr_hash. */
+    DLIST_REMOVE(entry->cache->entries, entry);
+
+    return 0;
+}
+
+static struct ssh_known_hosts_cache *
+ssh_known_hosts_cache_get(struct ssh_ctx *ssh_ctx)
+{
+    struct ssh_known_hosts_cache *cache;
+
+    if (ssh_ctx->known_hosts_cache != NULL) {
+        return ssh_ctx->known_hosts_cache;
+    }
+
+    cache = talloc_zero(ssh_ctx, struct ssh_known_hosts_cache);
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return NULL;
+    }
+
+    ssh_ctx->known_hosts_cache = cache;
+
+    return cache;
+}
+
+/* Hosts whose entry was not stored again since the last run keep their
+ * formatted line, which also keeps the random salts of hashed entries and
+ * therefore the file contents stable. */
+static const char *
+ssh_known_hosts_format_host(struct ssh_known_hosts_cache *cache,
+                            struct sss_domain_info *dom,
+                            struct ldb_message *host,
+                            bool hash_known_hosts)
+{
+    struct ssh_known_hosts_entry *entry;
+    struct sss_ssh_ent *ent;
+    const char *name;
+    uint64_t last_update;
+    char *key;
+    errno_t ret;
+
+    name = ldb_msg_find_attr_as_string(host, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        return NULL;
+    }
+
+    last_update = ldb_msg_find_attr_as_uint64(host, SYSDB_LAST_UPDATE, 0);
+
+    key = talloc_asprintf(NULL, "%s:%s", dom->name, name);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct ssh_known_hosts_entry);
+    if (entry != NULL) {
+        if (last_update != 0 && entry->last_update == last_update) {
+            entry->generation = cache->generation;
+            talloc_free(key);
+            return entry->line;
+        }
+
+        talloc_free(entry);
+    }
+
+    entry = talloc_zero(cache, struct ssh_known_hosts_entry);
+    if (entry == NULL) {
+        goto fail;
+    }
+
+    ret = sss_ssh_make_ent(entry, host, &ent);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to get SSH host public keys\n");
+        goto fail;
+    }
+
+    if (hash_known_hosts) {
+        entry->line = ssh_host_pubkeys_format_known_host_hashed(entry, ent);
+    } else {
+        entry->line = ssh_host_pubkeys_format_known_host_plain(entry, ent);
+    }
+    talloc_free(ent);
+
+    if (entry->line == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to format known_hosts data "
+              "for [%s]\n", name);
+        goto fail;
+    }
+
+    ret = sss_ptr_hash_add(cache->table, key, entry,
+                           struct ssh_known_hosts_entry);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    entry->cache = cache;
+    entry->generation = cache->generation;
+    entry->last_update = last_update;
+    DLIST_ADD(cache->entries, entry);
+    talloc_set_destructor(entry, ssh_known_hosts_entry_destructor);
+
+    talloc_free(key);
+    return entry->line;
+
+fail:
+    talloc_free(entry);
+    talloc_free(key);
+    return NULL;
+}
+
 static errno_t
-ssh_write_known_hosts(struct sss_domain_info *domains,
+ssh_build_known_hosts(TALLOC_CTX *mem_ctx,
+                      struct ssh_known_hosts_cache *cache,
+                      struct sss_domain_info *domains,
                       bool hash_known_hosts,
                       time_t now,
-                      int fd)
+                      char **_contents)
 {
     TALLOC_CTX *tmp_ctx;
     struct sss_domain_info *dom;
     struct ldb_message **hosts;
+    struct ssh_known_hosts_entry *entry;
+    struct ssh_known_hosts_entry *next;
     struct sysdb_ctx *sysdb;
-    struct sss_ssh_ent *ent;
-    char *entstr;
+    const char *line;
+    char *contents;
     size_t num_hosts;
     size_t i;
-    ssize_t wret;
     errno_t ret;
 
     static const char *attrs[] = {
         SYSDB_NAME,
         SYSDB_NAME_ALIAS,
         SYSDB_SSH_PUBKEY,
+        SYSDB_LAST_UPDATE,
         NULL
     };
 
@@ -196,6 +342,14 @@ ssh_write_known_hosts(struct sss_domain_info *domains,
         return ENOMEM;
     }
 
+    contents = talloc_strdup(tmp_ctx, "");
+    if (contents == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    cache->generation++;
+
     for (dom = domains; dom != NULL; dom = get_next_domain(dom, false)) {
         sysdb = dom->sysdb;
         if (sysdb == NULL) {
@@ -216,37 +370,31 @@ ssh_write_known_hosts(struct sss_domain_info *domains,
         }
 
         for (i = 0; i < num_hosts; i++) {
-            ret = sss_ssh_make_ent(tmp_ctx, hosts[i], &ent);
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "Failed to get SSH host public keys\n");
-                continue;
-            }
-
-            if (hash_known_hosts) {
-                entstr = ssh_host_pubkeys_format_known_host_hashed(ent, ent);
-            } else {
-                entstr = ssh_host_pubkeys_format_known_host_plain(ent, ent);
-            }
-
-            if (entstr == NULL) {
-                DEBUG(SSSDBG_OP_FAILURE, "Failed to format known_hosts data "
-                      "for [%s]\n", ent->name);
+            line = ssh_known_hosts_format_host(cache, dom, hosts[i],
+                                               hash_known_hosts);
+            if (line == NULL) {
                 continue;
             }
 
-            wret = sss_atomic_write_s(fd, entstr, strlen(entstr));
-            if (wret == -1) {
-                ret = errno;
+            contents = talloc_strdup_append_buffer(contents, line);
+            if (contents == NULL) {
+                ret = ENOMEM;
                 goto done;
             }
-
-            talloc_free(ent);
         }
 
         talloc_free(hosts);
     }
 
+    /* Forget hosts that are no longer part of the file. */
+    for (entry = cache->entries; entry != NULL; entry = next) {
+        next = entry->next;
+        if (entry->generation != cache->generation) {
+            talloc_free(entry);
+        }
+    }
+
+    *_contents = talloc_steal(mem_ctx, contents);
     ret = EOK;
 
 done:
@@ -256,14 +404,16 @@ done:
 }
 
 errno_t
-ssh_update_known_hosts_file(struct sss_domain_info *domains,
+ssh_update_known_hosts_file(struct ssh_ctx *ssh_ctx,
                             struct sss_domain_info *domain,
-                            const char *name,
-                            bool hash_known_hosts,
-                            int known_hosts_timeout)
+                            const char *name)
 {
     TALLOC_CTX *tmp_ctx;
+    struct ssh_known_hosts_cache *cache;
+    struct stat st;
     char *filename;
+    char *contents;
+    ssize_t wret;
     errno_t ret;
     time_t now;
     int fd = -1;
@@ -279,12 +429,33 @@ ssh_update_known_hosts_file(struct sss_domain_info *domains,
     /* Update host's expiration time. */
     if (domain != NULL) {
         ret = sysdb_update_ssh_known_host_expire(domain, name, now,
-                                                 known_hosts_timeout);
+                                                 ssh_ctx->known_hosts_timeout);
         if (ret != EOK && ret != ENOENT) {
             goto done;
         }
     }
 
+    cache = ssh_known_hosts_cache_get(ssh_ctx);
+    if (cache == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ssh_build_known_hosts(tmp_ctx, cache, ssh_ctx->rctx->domains,
+                                ssh_ctx->hash_known_hosts, now, &contents);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to build known hosts file "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (cache->contents != NULL && strcmp(cache->contents, contents) == 0
+            && stat(SSS_SSH_KNOWN_HOSTS_PATH, &st) == 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Known hosts file is up to date\n");
+        ret = EOK;
+        goto done;
+    }
+
     /* Create temporary known hosts file. */
     filename = talloc_strdup(tmp_ctx, SSS_SSH_KNOWN_HOSTS_TEMP_TMPL);
     if (filename == NULL) {
@@ -299,14 +470,14 @@ ssh_update_known_hosts_file(struct sss_domain_info *domains,
     }
 
     /* Write contents. */
-    ret = ssh_write_known_hosts(domains, hash_known_hosts, now, fd);
-    if (ret != EOK) {
+    wret = sss_atomic_write_s(fd, contents, strlen(contents));
+    if (wret == -1) {
+        ret = errno;
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to write known hosts file "
               "[%d]: %s\n", ret, sss_strerror(ret));
         goto done;
     }
 
-
     /* Rename to SSH known hosts file. */
     ret = fchmod(fd, 0644);
     if (ret == -1) {
@@ -320,6 +491,9 @@ ssh_update_known_hosts_file(struct sss_domain_info *domains,
         goto done;
     }
 
+    talloc_free(cache->contents);
+    cache->contents = talloc_steal(cache, contents);
+
     ret = EOK;
 
 done:
@@ -27,6 +27,9 @@
 #define SSS_SSH_KNOWN_HOSTS_PATH PUBCONF_PATH"/known_hosts"
 #define SSS_SSH_KNOWN_HOSTS_TEMP_TMPL PUBCONF_PATH"/.known_hosts.XXXXXX"
 
+struct ssh_known_hosts_cache;
+struct ssh_cert_keys_cache;
+
 struct ssh_ctx {
     struct resp_ctx *rctx;
     struct sss_names_ctx *snctx;
@@ -40,6 +43,11 @@ struct ssh_ctx {
     struct sss_certmap_ctx *sss_certmap_ctx;
     char **cert_rules;
     bool cert_rules_error;
+
+    /* Formatted entries and contents of the last written known_hosts */
+    struct ssh_known_hosts_cache *known_hosts_cache;
+    /* Keys derived from certificates, NULL if disabled */
+    struct ssh_cert_keys_cache *cert_keys_cache;
 };
 
 struct sss_cmd_table *get_ssh_cmds(void);
@@ -80,10 +88,26 @@ ssh_protocol_build_reply(struct sss_packet *packet,
                          uint32_t num_keys);
 
 errno_t
-ssh_update_known_hosts_file(struct sss_domain_info *domains,
+ssh_update_known_hosts_file(struct ssh_ctx *ssh_ctx,
                             struct sss_domain_info *domain,
-                            const char *name,
-                            bool hash_known_hosts,
-                            int known_hosts_timeout);
+                            const char *name);
+
+errno_t ssh_cert_keys_cache_init(struct ssh_ctx *ssh_ctx, int timeout);
+
+/* Returns true if the key derived from the certificate is known. The key
+ * is empty if the certificate was not valid, it is owned by the cache. */
+bool ssh_cert_keys_cache_get(struct ssh_cert_keys_cache *cache,
+                             const struct ldb_val *cert,
+                             struct ldb_val *_key);
+
+void ssh_cert_keys_cache_add(struct ssh_cert_keys_cache *cache,
+                             const struct ldb_val *cert,
+                             const struct ldb_val *key);
+
+void ssh_cert_keys_cache_flush(struct ssh_cert_keys_cache *cache);
+
+/* Drops the cached keys if the CA database was changed since. */
+void ssh_cert_keys_cache_check_ca(struct ssh_cert_keys_cache *cache,
+                                  const char *ca_db);
 
 #endif /* _SSHSRV_PRIVATE_H_ */
@@ -116,6 +116,14 @@ struct ssh_get_output_keys_state {
     struct ldb_message_element *user_cert;
     struct ldb_message_element *user_cert_override;
     struct ldb_message_element *current_cert;
+    bool child_started;
+
+    /* keys of current_cert, the missing ones are converted by the child */
+    struct ldb_val *cert_keys;
+    size_t cached_valid_keys;
+    struct ldb_val *missing_certs;
+    unsigned int *missing_idx;
+    unsigned int num_missing;
 
     const char *name;
     struct ldb_message_element **elements;
@@ -125,6 +133,130 @@ struct ssh_get_output_keys_state {
 
 void ssh_get_output_keys_done(struct tevent_req *subreq);
 
+static errno_t ssh_get_output_keys_add(struct ssh_get_output_keys_state *state,
+                                       struct ldb_val *keys,
+                                       size_t valid_keys)
+{
+    state->elements[state->iter] = talloc_zero(state->elements,
+                                                struct ldb_message_element);
+    if (state->elements[state->iter] == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_zero failed.\n");
+        return ENOMEM;
+    }
+    state->elements[state->iter]->values = talloc_steal(
+                                                   state->elements[state->iter],
+                                                   keys);
+    state->elements[state->iter]->num_values = state->current_cert->num_values;
+    state->elements[state->iter]->flags |= SSS_EL_FLAG_BIN_DATA;
+    state->num_keys += valid_keys;
+    /* keys of the override certificates get their own element */
+    state->iter++;
+
+    if (state->current_cert == state->user_cert) {
+        state->current_cert = state->user_cert_override;
+    } else if (state->current_cert == state->user_cert_override) {
+        state->current_cert = NULL;
+    } else {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unexpected certificate pointer.\n");
+        return EINVAL;
+    }
+
+    return EOK;
+}
+
+/* Converts the remaining certificates. Keys derived recently from the same
+ * certificates are taken from the cache, only the others are passed to the
+ * child. */
+static errno_t ssh_get_output_keys_next(struct tevent_req *req)
+{
+    struct ssh_get_output_keys_state *state = tevent_req_data(req,
+                                              struct ssh_get_output_keys_state);
+    struct ldb_message_element *certs;
+    struct tevent_req *subreq;
+    struct ldb_val key;
+    unsigned int i;
+    errno_t ret;
+
+    while (state->current_cert != NULL) {
+        certs = state->current_cert;
+
+        talloc_zfree(state->cert_keys);
+        talloc_zfree(state->missing_certs);
+        talloc_zfree(state->missing_idx);
+        state->num_missing = 0;
+        state->cached_valid_keys = 0;
+
+        state->cert_keys = talloc_zero_array(state, struct ldb_val,
+                                             certs->num_values);
+        state->missing_certs = talloc_zero_array(state, struct ldb_val,
+                                                 certs->num_values);
+        state->missing_idx = talloc_zero_array(state, unsigned int,
+                                               certs->num_values);
+        if (state->cert_keys == NULL || state->missing_certs == NULL
+                || state->missing_idx == NULL) {
+            return ENOMEM;
+        }
+
+        for (i = 0; i < certs->num_values; i++) {
+            if (!ssh_cert_keys_cache_get(state->ssh_ctx->cert_keys_cache,
+                                         &certs->values[i], &key)) {
+                state->missing_certs[state->num_missing] = certs->values[i];
+                state->missing_idx[state->num_missing] = i;
+                state->num_missing++;
+                continue;
+            }
+
+            if (key.data == NULL) {
+                continue;
+            }
+
+            state->cert_keys[i].data = talloc_memdup(state->cert_keys,
+                                                     key.data, key.length);
+            if (state->cert_keys[i].data == NULL) {
+                return ENOMEM;
+            }
+            state->cert_keys[i].length = key.length;
+            state->cached_valid_keys++;
+        }
+
+        if (state->num_missing > 0) {
+            break;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC, "Using cached keys of %u certificates.\n",
+              certs->num_values);
+        ret = ssh_get_output_keys_add(state, state->cert_keys,
+                                      state->cached_valid_keys);
+        state->cert_keys = NULL;
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    if (state->current_cert == NULL) {
+        return EOK;
+    }
+
+    /* only the first child needs to set up its log file */
+    subreq = cert_to_ssh_key_send(state, state->ev,
+                                  state->child_started ? NULL
+                                                       : P11_CHILD_LOG_FILE,
+                                  state->p11_child_timeout,
+                                  state->ssh_ctx->ca_db,
+                                  state->ssh_ctx->sss_certmap_ctx,
+                                  state->num_missing,
+                                  state->missing_certs,
+                                  state->cert_verification_opts);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "cert_to_ssh_key_send failed.\n");
+        return ENOMEM;
+    }
+    tevent_req_set_callback(subreq, ssh_get_output_keys_done, req);
+    state->child_started = true;
+
+    return EAGAIN;
+}
+
 struct tevent_req *ssh_get_output_keys_send(TALLOC_CTX *mem_ctx,
                                             struct tevent_context *ev,
                                             struct cli_ctx *cli_ctx,
@@ -132,7 +264,6 @@ struct tevent_req *ssh_get_output_keys_send(TALLOC_CTX *mem_ctx,
                                             struct ldb_message *msg)
 {
     struct tevent_req *req;
-    struct tevent_req *subreq;
     errno_t ret;
     struct ssh_get_output_keys_state *state;
 
@@ -248,22 +379,10 @@ struct tevent_req *ssh_get_output_keys_send(TALLOC_CTX *mem_ctx,
     state->current_cert = state->user_cert != NULL ? state->user_cert
                                                    : state->user_cert_override;
 
-    subreq = cert_to_ssh_key_send(state, state->ev,
-                                  P11_CHILD_LOG_FILE,
-                                  state->p11_child_timeout,
-                                  state->ssh_ctx->ca_db,
-                                  state->ssh_ctx->sss_certmap_ctx,
-                                  state->current_cert->num_values,
-                                  state->current_cert->values,
-                                  state->cert_verification_opts);
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "cert_to_ssh_key_send failed.\n");
-        ret = ENOMEM;
-        goto done;
-    }
-    tevent_req_set_callback(subreq, ssh_get_output_keys_done, req);
+    ssh_cert_keys_cache_check_ca(state->ssh_ctx->cert_keys_cache,
+                                 state->ssh_ctx->ca_db);
 
-    ret = EAGAIN;
+    ret = ssh_get_output_keys_next(req);
 
 done:
     if (ret != EAGAIN) {
@@ -287,6 +406,7 @@ void ssh_get_output_keys_done(struct tevent_req *subreq)
     int ret;
     struct ldb_val *keys;
     size_t valid_keys;
+    unsigned int i;
 
     ret = cert_to_ssh_key_recv(subreq, state, &keys, &valid_keys);
     talloc_zfree(subreq);
@@ -305,50 +425,29 @@ void ssh_get_output_keys_done(struct tevent_req *subreq)
         return;
     }
 
-    state->elements[state->iter] = talloc_zero(state->elements,
-                                                struct ldb_message_element);
-    if (state->elements[state->iter] == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "talloc_zero failed.\n");
-        ret = ENOMEM;
-        goto done;
-    }
-    state->elements[state->iter]->values = talloc_steal(
-                                                   state->elements[state->iter],
-                                                   keys);
-    state->elements[state->iter]->num_values = state->current_cert->num_values;
-    state->elements[state->iter]->flags |= SSS_EL_FLAG_BIN_DATA;
-    state->num_keys += valid_keys;
+    for (i = 0; i < state->num_missing; i++) {
+        ssh_cert_keys_cache_add(state->ssh_ctx->cert_keys_cache,
+                                &state->missing_certs[i], &keys[i]);
 
-    if (state->current_cert == state->user_cert) {
-        state->current_cert = state->user_cert_override;
-    } else if (state->current_cert == state->user_cert_override) {
-        state->current_cert = NULL;
-    } else {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unexpected certificate pointer.\n");
-        tevent_req_error(req, EINVAL);
-        return;
+        state->cert_keys[state->missing_idx[i]].length = keys[i].length;
+        state->cert_keys[state->missing_idx[i]].data = talloc_steal(
+                                                        state->cert_keys,
+                                                        keys[i].data);
     }
+    talloc_free(keys);
 
-    if (state->current_cert == NULL) {
-        /* done */
-        ret = EOK;
+    ret = ssh_get_output_keys_add(state, state->cert_keys,
+                                  state->cached_valid_keys + valid_keys);
+    state->cert_keys = NULL;
+    if (ret != EOK) {
         goto done;
     }
 
-    subreq = cert_to_ssh_key_send(state, state->ev, NULL,
-                                  state->p11_child_timeout,
-                                  state->ssh_ctx->ca_db,
-                                  state->ssh_ctx->sss_certmap_ctx,
-                                  state->current_cert->num_values,
-                                  state->current_cert->values,
-                                  state->cert_verification_opts);
-    if (subreq == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "cert_to_ssh_key_send failed.\n");
-        ret = ENOMEM;
-        goto done;
+    ret = ssh_get_output_keys_next(req);
+    if (ret == EAGAIN) {
+        return;
     }
-    tevent_req_set_callback(subreq, ssh_get_output_keys_done, req);
-    return;
+
 done:
     if (ret == EOK) {
         tevent_req_done(req);
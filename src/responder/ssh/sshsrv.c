@@ -35,6 +35,7 @@ int ssh_process_init(TALLOC_CTX *mem_ctx,
     struct resp_ctx *rctx;
     struct sss_cmd_table *ssh_cmds;
     struct ssh_ctx *ssh_ctx;
+    int cert_keys_cache_timeout;
     int ret;
 
     ssh_cmds = get_ssh_cmds();
@@ -126,6 +127,23 @@ int ssh_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    ret = confdb_get_int(ssh_ctx->rctx->cdb, CONFDB_SSH_CONF_ENTRY,
+                         CONFDB_SSH_CERT_KEYS_CACHE_TIMEOUT,
+                         CONFDB_DEFAULT_SSH_CERT_KEYS_CACHE_TIMEOUT,
+                         &cert_keys_cache_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading "
+                                    CONFDB_SSH_CERT_KEYS_CACHE_TIMEOUT
+                                    " from confdb (%d) [%s].\n", ret,
+                                    sss_strerror(ret));
+        goto fail;
+    }
+
+    ret = ssh_cert_keys_cache_init(ssh_ctx, cert_keys_cache_timeout);
+    if (ret != EOK) {
+        goto fail;
+    }
+
     ret = schedule_get_domains_task(rctx, rctx->ev, rctx, NULL);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "schedule_get_domains_tasks failed.\n");
@@ -36,6 +36,7 @@ int sudo_process_init(TALLOC_CTX *mem_ctx,
     struct resp_ctx *rctx;
     struct sss_cmd_table *sudo_cmds;
     struct sudo_ctx *sudo_ctx;
+    int rules_cache_size;
     int ret;
 
     sudo_cmds = get_sudo_cmds();
@@ -102,6 +103,24 @@ int sudo_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    /* Get sudo_rules_cache_size option */
+    ret = confdb_get_int(sudo_ctx->rctx->cdb,
+                         CONFDB_SUDO_CONF_ENTRY, CONFDB_SUDO_RULES_CACHE_SIZE,
+                         CONFDB_DEFAULT_SUDO_RULES_CACHE_SIZE,
+                         &rules_cache_size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading from confdb (%d) [%s]\n",
+              ret, strerror(ret));
+        goto fail;
+    }
+
+    if (rules_cache_size > 0) {
+        ret = sudosrv_rules_cache_init(sudo_ctx, rules_cache_size);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
     ret = schedule_get_domains_task(rctx, rctx->ev, rctx, NULL);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "schedule_get_domains_tasks failed.\n");
@@ -37,6 +37,8 @@ static errno_t sudosrv_cmd_send_reply(struct sudo_cmd_ctx *cmd_ctx,
     errno_t ret;
     uint8_t *packet_body = NULL;
     size_t packet_len = 0;
+    size_t header_len = 0;
+    size_t offset = 0;
     struct cli_ctx *cli_ctx = cmd_ctx->cli_ctx;
     struct cli_protocol *pctx;
     TALLOC_CTX *tmp_ctx;
@@ -56,14 +58,29 @@ static errno_t sudosrv_cmd_send_reply(struct sudo_cmd_ctx *cmd_ctx,
         goto done;
     }
 
-    ret = sss_packet_grow(pctx->creq->out, response_len);
+    if (cmd_ctx->with_generation) {
+        /* generation and the unchanged flag precede the usual reply */
+        header_len = sizeof(uint64_t) + sizeof(uint32_t);
+    }
+
+    ret = sss_packet_grow(pctx->creq->out, header_len + response_len);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Unable to create response: %s\n", strerror(ret));
         goto done;
     }
     sss_packet_get_body(pctx->creq->out, &packet_body, &packet_len);
-    memcpy(packet_body, response_body, response_len);
+
+    if (cmd_ctx->with_generation) {
+        SAFEALIGN_SET_VALUE(packet_body, cmd_ctx->generation, uint64_t,
+                            &offset);
+        SAFEALIGN_SET_UINT32(packet_body + offset, cmd_ctx->unchanged ? 1 : 0,
+                             &offset);
+    }
+
+    if (response_len > 0) {
+        memcpy(packet_body + offset, response_body, response_len);
+    }
 
     sss_packet_set_error(pctx->creq->out, EOK);
     sss_cmd_done(cmd_ctx->cli_ctx, cmd_ctx);
@@ -89,6 +106,9 @@ static errno_t sudosrv_cmd_send_error(TALLOC_CTX *mem_ctx,
         return EFAULT;
     }
 
+    cmd_ctx->generation = 0;
+    cmd_ctx->unchanged = false;
+
     ret = sudosrv_build_response(mem_ctx, error, 0, NULL,
                                  &response_body, &response_len);
     if (ret != EOK) {
@@ -107,6 +127,19 @@ errno_t sudosrv_cmd_reply(struct sudo_cmd_ctx *cmd_ctx, int ret)
 
     switch (ret) {
     case EOK:
+        if (cmd_ctx->unchanged) {
+            /* the client already has this rule set */
+            ret = sudosrv_cmd_send_reply(cmd_ctx, NULL, 0);
+            break;
+        }
+
+        if (cmd_ctx->response_body != NULL) {
+            /* the reply was already encoded or taken from the rules cache */
+            ret = sudosrv_cmd_send_reply(cmd_ctx, cmd_ctx->response_body,
+                                         cmd_ctx->response_len);
+            break;
+        }
+
         /*
          * Parent of cmd_ctx->rules is in-memory cache, we must not talloc_free it!
          */
@@ -169,12 +202,14 @@ errno_t sudosrv_cmd_reply(struct sudo_cmd_ctx *cmd_ctx, int ret)
 
 static void sudosrv_cmd_done(struct tevent_req *req);
 
-static int sudosrv_cmd(enum sss_sudo_type type, struct cli_ctx *cli_ctx)
+static int sudosrv_cmd(enum sss_sudo_type type, bool with_generation,
+                       struct cli_ctx *cli_ctx)
 {
     struct tevent_req *req = NULL;
     struct sudo_cmd_ctx *cmd_ctx = NULL;
     uint8_t *query_body = NULL;
     size_t query_len = 0;
+    size_t offset = 0;
     struct cli_protocol *pctx;
     uint32_t protocol;
     errno_t ret;
@@ -190,6 +225,7 @@ static int sudosrv_cmd(enum sss_sudo_type type, struct cli_ctx *cli_ctx)
 
     cmd_ctx->cli_ctx = cli_ctx;
     cmd_ctx->type = type;
+    cmd_ctx->with_generation = with_generation;
     cmd_ctx->sudo_ctx = talloc_get_type(cli_ctx->rctx->pvt_ctx, struct sudo_ctx);
     if (cmd_ctx->sudo_ctx == NULL) {
         DEBUG(SSSDBG_FATAL_FAILURE, "sudo_ctx not set, killing connection!\n");
@@ -226,6 +262,19 @@ static int sudosrv_cmd(enum sss_sudo_type type, struct cli_ctx *cli_ctx)
         goto done;
     }
 
+    if (with_generation) {
+        /* generation of the rule set the client has, 0 if none */
+        if (query_len <= sizeof(uint64_t)) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Query is too small\n");
+            ret = EINVAL;
+            goto done;
+        }
+        safealign_memcpy(&cmd_ctx->known_generation, query_body,
+                         sizeof(uint64_t), &offset);
+        query_body += offset;
+        query_len -= offset;
+    }
+
     ret = sudosrv_parse_query(cmd_ctx, query_body, query_len,
                               &cmd_ctx->rawname, &cmd_ctx->uid);
     if (ret != EOK) {
@@ -236,7 +285,7 @@ static int sudosrv_cmd(enum sss_sudo_type type, struct cli_ctx *cli_ctx)
 
     req = sudosrv_get_rules_send(cmd_ctx, cli_ctx->ev, cmd_ctx->sudo_ctx,
                                  cmd_ctx->type, cmd_ctx->uid,
-                                 cmd_ctx->rawname);
+                                 cmd_ctx->rawname, cmd_ctx->known_generation);
     if (req == NULL) {
         ret = ENOMEM;
         goto done;
@@ -258,7 +307,11 @@ static void sudosrv_cmd_done(struct tevent_req *req)
     cmd_ctx = tevent_req_callback_data(req, struct sudo_cmd_ctx);
 
     ret = sudosrv_get_rules_recv(cmd_ctx, req, &cmd_ctx->rules,
-                                 &cmd_ctx->num_rules);
+                                 &cmd_ctx->num_rules,
+                                 &cmd_ctx->response_body,
+                                 &cmd_ctx->response_len,
+                                 &cmd_ctx->generation,
+                                 &cmd_ctx->unchanged);
     talloc_zfree(req);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to obtain cached rules [%d]: %s\n",
@@ -272,12 +325,17 @@ done:
 
 static int sudosrv_cmd_get_sudorules(struct cli_ctx *cli_ctx)
 {
-    return sudosrv_cmd(SSS_SUDO_USER, cli_ctx);
+    return sudosrv_cmd(SSS_SUDO_USER, false, cli_ctx);
+}
+
+static int sudosrv_cmd_get_sudorules_gen(struct cli_ctx *cli_ctx)
+{
+    return sudosrv_cmd(SSS_SUDO_USER, true, cli_ctx);
 }
 
 static int sudosrv_cmd_get_defaults(struct cli_ctx *cli_ctx)
 {
-    return sudosrv_cmd(SSS_SUDO_DEFAULTS, cli_ctx);
+    return sudosrv_cmd(SSS_SUDO_DEFAULTS, false, cli_ctx);
 }
 
 struct cli_protocol_version *register_cli_protocol_version(void)
@@ -295,6 +353,7 @@ struct sss_cmd_table *get_sudo_cmds(void) {
         {SSS_GET_VERSION, sss_cmd_get_version},
         {SSS_SUDO_GET_SUDORULES, sudosrv_cmd_get_sudorules},
         {SSS_SUDO_GET_DEFAULTS, sudosrv_cmd_get_defaults},
+        {SSS_SUDO_GET_SUDORULES_GEN, sudosrv_cmd_get_sudorules_gen},
         {SSS_CLI_NULL, NULL}
     };
 
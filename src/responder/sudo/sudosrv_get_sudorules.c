@@ -27,6 +27,7 @@
 #include <tevent.h>
 
 #include "util/util.h"
+#include "shared/murmurhash3.h"
 #include "db/sysdb_sudo.h"
 #include "responder/common/cache_req/cache_req.h"
 #include "responder/sudo/sudosrv_private.h"
@@ -215,6 +216,7 @@ static errno_t sudosrv_query_cache(TALLOC_CTX *mem_ctx,
     size_t count;
     struct sysdb_attrs **rules;
     struct ldb_message **msgs;
+    size_t i;
 
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
@@ -240,6 +242,15 @@ static errno_t sudosrv_query_cache(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    for (i = 0; i < count; i++) {
+        ret = sysdb_msg_unpack_values(msgs[i],
+                                      SYSDB_SUDO_CACHE_AT_COMMAND_PACKED,
+                                      SYSDB_SUDO_CACHE_AT_COMMAND);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     ret = sysdb_msg2attrs(tmp_ctx, count, msgs, &rules);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -301,6 +312,7 @@ static errno_t sudosrv_cached_rules_by_user(TALLOC_CTX *mem_ctx,
                             SYSDB_SUDO_CACHE_AT_CN,
                             SYSDB_SUDO_CACHE_AT_HOST,
                             SYSDB_SUDO_CACHE_AT_COMMAND,
+                            SYSDB_SUDO_CACHE_AT_COMMAND_PACKED,
                             SYSDB_SUDO_CACHE_AT_OPTION,
                             SYSDB_SUDO_CACHE_AT_RUNAS,
                             SYSDB_SUDO_CACHE_AT_RUNASUSER,
@@ -369,6 +381,7 @@ static errno_t sudosrv_cached_rules_by_ng(TALLOC_CTX *mem_ctx,
                             SYSDB_SUDO_CACHE_AT_USER,
                             SYSDB_SUDO_CACHE_AT_HOST,
                             SYSDB_SUDO_CACHE_AT_COMMAND,
+                            SYSDB_SUDO_CACHE_AT_COMMAND_PACKED,
                             SYSDB_SUDO_CACHE_AT_OPTION,
                             SYSDB_SUDO_CACHE_AT_RUNAS,
                             SYSDB_SUDO_CACHE_AT_RUNASUSER,
@@ -487,6 +500,7 @@ static errno_t sudosrv_cached_defaults(TALLOC_CTX *mem_ctx,
                             SYSDB_SUDO_CACHE_AT_USER,
                             SYSDB_SUDO_CACHE_AT_HOST,
                             SYSDB_SUDO_CACHE_AT_COMMAND,
+                            SYSDB_SUDO_CACHE_AT_COMMAND_PACKED,
                             SYSDB_SUDO_CACHE_AT_OPTION,
                             SYSDB_SUDO_CACHE_AT_RUNAS,
                             SYSDB_SUDO_CACHE_AT_RUNASUSER,
@@ -731,12 +745,22 @@ struct sudosrv_get_rules_state {
     char **groups;
     bool inverse_order;
     int threshold;
+    bool timed;
+    struct sudo_rules_cache *rules_cache;
+    uint64_t known_generation;
 
     uid_t orig_uid;
     const char *orig_username;
 
     struct sysdb_attrs **rules;
     uint32_t num_rules;
+
+    uint8_t *response_body;
+    size_t response_len;
+
+    uint64_t seq;
+    uint64_t generation;
+    bool unchanged;
 };
 
 static void sudosrv_get_rules_initgr_done(struct tevent_req *subreq);
@@ -747,7 +771,8 @@ struct tevent_req *sudosrv_get_rules_send(TALLOC_CTX *mem_ctx,
                                           struct sudo_ctx *sudo_ctx,
                                           enum sss_sudo_type type,
                                           uid_t cli_uid,
-                                          const char *username)
+                                          const char *username,
+                                          uint64_t known_generation)
 {
     struct sudosrv_get_rules_state *state;
     struct tevent_req *req;
@@ -766,6 +791,14 @@ struct tevent_req *sudosrv_get_rules_send(TALLOC_CTX *mem_ctx,
     state->cli_uid = cli_uid;
     state->inverse_order = sudo_ctx->inverse_order;
     state->threshold = sudo_ctx->threshold;
+    state->timed = sudo_ctx->timed;
+    state->known_generation = known_generation;
+
+    /* Time restrictions are applied to the rules when the reply is built,
+     * such a reply cannot be reused. */
+    if (!sudo_ctx->timed) {
+        state->rules_cache = sudo_ctx->rules_cache;
+    }
 
     DEBUG(SSSDBG_TRACE_FUNC, "Running initgroups for [%s]\n", username);
 
@@ -846,6 +879,90 @@ done:
     }
 }
 
+/* The generation handed out to the client combines the domain with the
+ * sequence number of its cache, so that a generation obtained for a user of
+ * one domain is never mistaken for one of another domain. Zero means that
+ * the reply must not be reused. */
+static uint64_t sudosrv_get_rules_generation(struct sudosrv_get_rules_state *state)
+{
+    uint64_t generation;
+
+    if (state->seq == 0 || state->timed) {
+        /* Time restrictions make the reply depend on the time of the
+         * request. */
+        return 0;
+    }
+
+    generation = murmurhash3(state->domain->name, strlen(state->domain->name),
+                             0xdeadbeef);
+    generation = (generation << 32) | (state->seq & 0xffffffff);
+
+    return generation;
+}
+
+static errno_t sudosrv_get_rules_cached(struct sudosrv_get_rules_state *state)
+{
+    const uint8_t *body;
+    size_t len;
+    char *key;
+    errno_t ret;
+
+    if (state->seq == 0) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to get sequence number of the "
+              "cache, the rules will not be cached.\n");
+        return sudosrv_fetch_rules(state, state->rctx, state->type,
+                                   state->domain, state->cli_uid,
+                                   state->orig_uid, state->orig_username,
+                                   state->groups, state->inverse_order,
+                                   &state->rules, &state->num_rules);
+    }
+
+    key = sudosrv_rules_cache_key(state, state->type, state->domain,
+                                  state->cli_uid, state->orig_uid,
+                                  state->orig_username, state->groups,
+                                  state->inverse_order);
+    if (key == NULL) {
+        return ENOMEM;
+    }
+
+    body = sudosrv_rules_cache_get(state->rules_cache, key, state->seq, &len);
+    if (body != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Returning cached rules of [%s]\n",
+              state->orig_username);
+        state->response_body = talloc_memdup(state, body, len);
+        if (state->response_body == NULL) {
+            return ENOMEM;
+        }
+        state->response_len = len;
+        talloc_free(key);
+        return EOK;
+    }
+
+    ret = sudosrv_fetch_rules(state, state->rctx, state->type, state->domain,
+                              state->cli_uid,
+                              state->orig_uid,
+                              state->orig_username,
+                              state->groups,
+                              state->inverse_order,
+                              &state->rules, &state->num_rules);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sudosrv_build_response(state, SSS_SUDO_ERROR_OK,
+                                 state->num_rules, state->rules,
+                                 &state->response_body, &state->response_len);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    sudosrv_rules_cache_add(state->rules_cache, key, state->seq,
+                            state->response_body, state->response_len);
+    talloc_free(key);
+
+    return EOK;
+}
+
 static void sudosrv_get_rules_done(struct tevent_req *subreq)
 {
     struct sudosrv_get_rules_state *state = NULL;
@@ -863,13 +980,37 @@ static void sudosrv_get_rules_done(struct tevent_req *subreq)
               "in cache.\n");
     }
 
-    ret = sudosrv_fetch_rules(state, state->rctx, state->type, state->domain,
-                              state->cli_uid,
-                              state->orig_uid,
-                              state->orig_username,
-                              state->groups,
-                              state->inverse_order,
-                              &state->rules, &state->num_rules);
+    ret = ldb_sequence_number(sysdb_ctx_get_ldb(state->domain->sysdb),
+                              LDB_SEQ_HIGHEST_SEQ, &state->seq);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to get sequence number of the cache\n");
+        state->seq = 0;
+    }
+
+    state->generation = sudosrv_get_rules_generation(state);
+    if (state->generation != 0
+            && state->generation == state->known_generation) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Rules of [%s] are unchanged since "
+              "generation %"PRIu64"\n", state->orig_username,
+              state->generation);
+        state->unchanged = true;
+        tevent_req_done(req);
+        return;
+    }
+
+    if (state->rules_cache != NULL) {
+        ret = sudosrv_get_rules_cached(state);
+    } else {
+        ret = sudosrv_fetch_rules(state, state->rctx, state->type,
+                                  state->domain,
+                                  state->cli_uid,
+                                  state->orig_uid,
+                                  state->orig_username,
+                                  state->groups,
+                                  state->inverse_order,
+                                  &state->rules, &state->num_rules);
+    }
 
     if (ret != EOK) {
         tevent_req_error(req, ret);
@@ -882,15 +1023,24 @@ static void sudosrv_get_rules_done(struct tevent_req *subreq)
 errno_t sudosrv_get_rules_recv(TALLOC_CTX *mem_ctx,
                                struct tevent_req *req,
                                struct sysdb_attrs ***_rules,
-                               uint32_t *_num_rules)
+                               uint32_t *_num_rules,
+                               uint8_t **_response_body,
+                               size_t *_response_len,
+                               uint64_t *_generation,
+                               bool *_unchanged)
 {
     struct sudosrv_get_rules_state *state = NULL;
     state = tevent_req_data(req, struct sudosrv_get_rules_state);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
+    *_generation = state->generation;
+    *_unchanged = state->unchanged;
+
     *_rules = talloc_steal(mem_ctx, state->rules);
     *_num_rules = state->num_rules;
+    *_response_body = talloc_steal(mem_ctx, state->response_body);
+    *_response_len = state->response_len;
 
     return EOK;
 }
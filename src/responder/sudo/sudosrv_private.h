@@ -40,6 +40,8 @@ enum sss_sudo_type {
     SSS_SUDO_USER
 };
 
+struct sudo_rules_cache;
+
 struct sudo_ctx {
     struct resp_ctx *rctx;
 
@@ -49,6 +51,9 @@ struct sudo_ctx {
     bool timed;
     bool inverse_order;
     int threshold;
+
+    /* Encoded replies of recent requests, NULL if disabled. */
+    struct sudo_rules_cache *rules_cache;
 };
 
 struct sudo_cmd_ctx {
@@ -60,9 +65,23 @@ struct sudo_cmd_ctx {
     uid_t uid;
     char *rawname;
 
+    /* the client asked with the generation of the rule set it already has
+     * and expects the generation in the reply */
+    bool with_generation;
+    uint64_t known_generation;
+
     /* output data */
     struct sysdb_attrs **rules;
     uint32_t num_rules;
+
+    /* already encoded reply, set instead of rules */
+    uint8_t *response_body;
+    size_t response_len;
+
+    /* generation of the rule set, 0 if it cannot be reused */
+    uint64_t generation;
+    /* the rule set is the one the client already has */
+    bool unchanged;
 };
 
 struct sss_cmd_table *get_sudo_cmds(void);
@@ -72,12 +91,17 @@ struct tevent_req *sudosrv_get_rules_send(TALLOC_CTX *mem_ctx,
                                           struct sudo_ctx *sudo_ctx,
                                           enum sss_sudo_type type,
                                           uid_t cli_uid,
-                                          const char *username);
+                                          const char *username,
+                                          uint64_t known_generation);
 
 errno_t sudosrv_get_rules_recv(TALLOC_CTX *mem_ctx,
                                struct tevent_req *req,
                                struct sysdb_attrs ***_rules,
-                               uint32_t *_num_rules);
+                               uint32_t *_num_rules,
+                               uint8_t **_response_body,
+                               size_t *_response_len,
+                               uint64_t *_generation,
+                               bool *_unchanged);
 
 errno_t sudosrv_parse_query(TALLOC_CTX *mem_ctx,
                             uint8_t *query_body,
@@ -92,6 +116,31 @@ errno_t sudosrv_build_response(TALLOC_CTX *mem_ctx,
                                uint8_t **_response_body,
                                size_t *_response_len);
 
+errno_t sudosrv_rules_cache_init(struct sudo_ctx *sudo_ctx, unsigned int size);
+
+/* The key must describe the request completely, the generation is the
+ * sequence number of the cache database the reply was built from. */
+char *sudosrv_rules_cache_key(TALLOC_CTX *mem_ctx,
+                              enum sss_sudo_type type,
+                              struct sss_domain_info *domain,
+                              uid_t cli_uid,
+                              uid_t orig_uid,
+                              const char *orig_username,
+                              char **groups,
+                              bool inverse_order);
+
+const uint8_t *
+sudosrv_rules_cache_get(struct sudo_rules_cache *cache,
+                        const char *key,
+                        uint64_t generation,
+                        size_t *_len);
+
+void sudosrv_rules_cache_add(struct sudo_rules_cache *cache,
+                             const char *key,
+                             uint64_t generation,
+                             const uint8_t *body,
+                             size_t len);
+
 struct tevent_req *
 sss_dp_get_sudoers_send(TALLOC_CTX *mem_ctx,
                         struct resp_ctx *rctx,
@@ -0,0 +1,231 @@
+/*
+    SSSD
+
+    SUDO Responder - cache of encoded rule sets
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
+#include "responder/sudo/sudosrv_private.h"
+
+struct sudo_rules_cache_entry {
+    struct sudo_rules_cache_entry *prev;
+    struct sudo_rules_cache_entry *next;
+
+    struct sudo_rules_cache *cache;
+    uint64_t generation;
+
+    uint8_t *body;
+    size_t len;
+};
+
+struct sudo_rules_cache {
+    hash_table_t *table;
+
+    /* Most recently used entry first. */
+    struct sudo_rules_cache_entry *entries;
+    struct sudo_rules_cache_entry *last;
+    unsigned int num_entries;
+    unsigned int max_entries;
+};
+
+static int sudo_rules_cache_entry_destructor(struct sudo_rules_cache_entry *entry)
+{
+    struct sudo_rules_cache *cache = entry->cache;
+
+    /* The hash table entry is removed by sss_ptr_hash. */
+    if (cache->last == entry) {
+        cache->last = entry->prev;
+    }
+
+    DLIST_REMOVE(cache->entries, entry);
+    cache->num_entries--;
+
+    return 0;
+}
+
+errno_t sudosrv_rules_cache_init(struct sudo_ctx *sudo_ctx, unsigned int size)
+{
+    struct sudo_rules_cache *cache;
+
+    if (size == 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS, "Sudo rules cache is disabled.\n");
+        return EOK;
+    }
+
+    cache = talloc_zero(sudo_ctx, struct sudo_rules_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->table = sss_ptr_hash_create(cache, NULL, NULL);
+    if (cache->table == NULL) {
+        talloc_free(cache);
+        return ENOMEM;
+    }
+
+    cache->max_entries = size;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Sudo rules cache holds up to %u rule sets\n",
+          size);
+
+    sudo_ctx->rules_cache = cache;
+
+    return EOK;
+}
+
+static int sudo_rules_cache_group_cmp(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+char *sudosrv_rules_cache_key(TALLOC_CTX *mem_ctx,
+                              enum sss_sudo_type type,
+                              struct sss_domain_info *domain,
+                              uid_t cli_uid,
+                              uid_t orig_uid,
+                              const char *orig_username,
+                              char **groups,
+                              bool inverse_order)
+{
+    char **sorted = NULL;
+    size_t num_groups = 0;
+    size_t i;
+    char *key;
+
+    key = talloc_asprintf(mem_ctx, "%d:%d:%s:%"SPRIuid":%"SPRIuid":%s",
+                          type, inverse_order, domain->name,
+                          cli_uid, orig_uid, orig_username);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    if (groups != NULL) {
+        for (num_groups = 0; groups[num_groups] != NULL; num_groups++);
+    }
+
+    if (num_groups == 0) {
+        return key;
+    }
+
+    /* The rule set does not depend on the order of the groups. */
+    sorted = talloc_memdup(key, groups, num_groups * sizeof(char *));
+    if (sorted == NULL) {
+        talloc_free(key);
+        return NULL;
+    }
+    qsort(sorted, num_groups, sizeof(char *), sudo_rules_cache_group_cmp);
+
+    for (i = 0; i < num_groups; i++) {
+        key = talloc_asprintf_append_buffer(key, ":%s", sorted[i]);
+        if (key == NULL) {
+            return NULL;
+        }
+    }
+
+    talloc_free(sorted);
+
+    return key;
+}
+
+const uint8_t *
+sudosrv_rules_cache_get(struct sudo_rules_cache *cache,
+                        const char *key,
+                        uint64_t generation,
+                        size_t *_len)
+{
+    struct sudo_rules_cache_entry *entry;
+
+    if (cache == NULL || key == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct sudo_rules_cache_entry);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    if (entry->generation != generation) {
+        /* Rules, users or groups were written since. */
+        talloc_free(entry);
+        return NULL;
+    }
+
+    if (cache->last == entry && entry->prev != NULL) {
+        cache->last = entry->prev;
+    }
+    DLIST_PROMOTE(cache->entries, entry);
+
+    *_len = entry->len;
+    return entry->body;
+}
+
+void sudosrv_rules_cache_add(struct sudo_rules_cache *cache,
+                             const char *key,
+                             uint64_t generation,
+                             const uint8_t *body,
+                             size_t len)
+{
+    struct sudo_rules_cache_entry *entry;
+    errno_t ret;
+
+    if (cache == NULL || key == NULL) {
+        return;
+    }
+
+    entry = sss_ptr_hash_lookup(cache->table, key,
+                                struct sudo_rules_cache_entry);
+    talloc_free(entry);
+
+    while (cache->num_entries >= cache->max_entries) {
+        talloc_free(cache->last);
+    }
+
+    entry = talloc_zero(cache, struct sudo_rules_cache_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->body = talloc_memdup(entry, body, len);
+    if (entry->body == NULL) {
+        talloc_free(entry);
+        return;
+    }
+    entry->len = len;
+
+    ret = sss_ptr_hash_add(cache->table, key, entry,
+                           struct sudo_rules_cache_entry);
+    if (ret != EOK) {
+        talloc_free(entry);
+        return;
+    }
+
+    entry->cache = cache;
+    entry->generation = generation;
+
+    DLIST_ADD(cache->entries, entry);
+    if (cache->last == NULL) {
+        cache->last = entry;
+    }
+    cache->num_entries++;
+    talloc_set_destructor(entry, sudo_rules_cache_entry_destructor);
+}
@@ -262,6 +262,10 @@ def InitializeDataTypes():
                     DBusType="uua(uay)", RequireTalloc=True)
     DataType.Create("ifp_extra", "hash_table_t *",
                     DBusType="a{sas}", RequireTalloc=True)
+    DataType.Create("ifp_extra_list", "hash_table_t **",
+                    DBusType="aa{sas}", RequireTalloc=True)
+    DataType.Create("payload", "struct sss_iface_payload *",
+                    DBusType="v", RequireTalloc=True)
 
 
 def main():
@@ -208,6 +208,13 @@ class InvokerKeygen:
 
     @staticmethod
     def BuildKeygenName(sbus_member, sbus_signature):
+        # Raw input is keyed by its message content, see sbus_message_keygen.
+        if Invoker.IsCustomInputHandler(sbus_signature):
+            if sbus_member.key is None:
+                return "NULL"
+
+            return "sbus_message_keygen"
+
         args = InvokerKeygen.GatherKeyArguments(sbus_member, sbus_signature)
 
         if args is None:
@@ -231,9 +238,15 @@ class InvokerKeygen:
             necessary to construct a key.
 
             Return None for SBus members that do not allow keying.
+            Members with custom input handler can not be keyed by their
+            arguments and are keyed by the caller only, therefore None
+            is returned for them as well.
         """
         keys = {}
 
+        if Invoker.IsCustomInputHandler(sbus_signature):
+            return None
+
         if sbus_signature is not None:
             for idx, arg in enumerate(sbus_signature.arguments.values()):
                 if arg.key is not None:
@@ -54,10 +54,10 @@
     sbus_method_in_${input-signature}_out_${output-signature}_send
         (TALLOC_CTX *mem_ctx,
          struct sbus_connection *conn,
+         sbus_invoker_keygen keygen,
          <toggle name="if-raw-input">
          DBusMessage *raw_message)
          <or>
-         sbus_invoker_keygen keygen,
          const char *bus,
          const char *path,
          const char *iface,
@@ -91,7 +91,7 @@
         </loop>
 
         <toggle name="if-raw-input">
-        subreq = sbus_call_method_send(state, conn, raw_message, NULL, NULL, NULL,
+        subreq = sbus_call_method_send(state, conn, raw_message, keygen, NULL, NULL,
                                        dbus_message_get_path(raw_message),
                                        dbus_message_get_interface(raw_message),
                                        dbus_message_get_member(raw_message), NULL);
@@ -222,7 +222,7 @@
          </toggle>
     {
         <toggle name="if-raw-input">
-        return sbus_method_in_${input-signature}_out_${output-signature}_send(mem_ctx, conn, raw_message);
+        return sbus_method_in_${input-signature}_out_${output-signature}_send(mem_ctx, conn, ${keygen}, raw_message);
         <or>
         return sbus_method_in_${input-signature}_out_${output-signature}_send(mem_ctx, conn, ${keygen},
             busname, object_path, "${iface}", "${method}"<loop name="in">, arg_${name}</loop>);
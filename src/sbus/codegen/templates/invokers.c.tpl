@@ -60,7 +60,7 @@
 <template name="invoker">
     struct _sbus_invoke_in_${input-signature}_out_${output-signature}_state {
         <toggle name="if-input-arguments">
-        struct _sbus_invoker_args_${input-signature} *in;
+        struct _sbus_invoker_args_${input-signature} in;
         </toggle>
         <toggle name="if-output-arguments">
         struct _sbus_invoker_args_${output-signature} out;
@@ -122,15 +122,7 @@
         state->write_iterator = write_iterator;
 
         <toggle name="if-input-arguments">
-        state->in = talloc_zero(state, struct _sbus_invoker_args_${input-signature});
-        if (state->in == NULL) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Unable to allocate space for input parameters!\n");
-            ret = ENOMEM;
-            goto done;
-        }
-
-        ret = _sbus_invoker_read_${input-signature}(state, read_iterator, state->in);
+        ret = _sbus_invoker_read_${input-signature}(state, read_iterator, &state->in);
         if (ret != EOK) {
             goto done;
         }
@@ -141,7 +133,7 @@
             goto done;
         }
 
-        ret = sbus_request_key(state, keygen, sbus_req,<toggle name="if-input-arguments"> state->in<or> NULL</toggle>, &key);
+        ret = sbus_request_key(state, keygen, sbus_req,<toggle name="if-input-arguments"> &state->in<or> NULL</toggle>, &key);
         if (ret != EOK) {
             goto done;
         }
@@ -183,7 +175,7 @@
                 goto done;
             }
 
-            ret = state->handler.sync(state, state->sbus_req, state->handler.data<loop name="in">, state->in->arg${index}</loop><loop name="in-raw">, state->read_iterator</loop><loop name="out">, &state->out.arg${index}</loop><loop name="out-raw">, state->write_iterator</loop>);
+            ret = state->handler.sync(state, state->sbus_req, state->handler.data<loop name="in">, state->in.arg${index}</loop><loop name="in-raw">, state->read_iterator</loop><loop name="out">, &state->out.arg${index}</loop><loop name="out-raw">, state->write_iterator</loop>);
             if (ret != EOK) {
                 goto done;
             }
@@ -199,7 +191,7 @@
                 goto done;
             }
 
-            subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data<loop name="in">, state->in->arg${index}</loop><loop name="in-raw">, state->read_iterator</loop><loop name="out-raw">, state->write_iterator</loop>);
+            subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data<loop name="in">, state->in.arg${index}</loop><loop name="in-raw">, state->read_iterator</loop><loop name="out-raw">, state->write_iterator</loop>);
             if (subreq == NULL) {
                 DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
                 ret = ENOMEM;
@@ -390,6 +390,20 @@ void sbus_connection_set_data(struct sbus_connection *conn,
     conn->data = data;
 }
 
+errno_t
+sbus_connection_set_priority(struct sbus_connection *conn,
+                             const char *interface,
+                             const char *member)
+{
+    if (conn == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Bug: connection is NULL\n");
+        return EINVAL;
+    }
+
+    return sbus_dispatch_priority_add(conn, &conn->priority_methods,
+                                      interface, member);
+}
+
 void *_sbus_connection_get_data(struct sbus_connection *conn)
 {
     if (conn == NULL) {
@@ -399,6 +413,15 @@ void *_sbus_connection_get_data(struct sbus_connection *conn)
     return conn->data;
 }
 
+bool sbus_connection_can_pass_fd(struct sbus_connection *conn)
+{
+    if (conn == NULL || conn->connection == NULL) {
+        return false;
+    }
+
+    return dbus_connection_can_send_type(conn->connection, DBUS_TYPE_UNIX_FD);
+}
+
 errno_t
 sbus_check_access(struct sbus_connection *conn,
                  struct sbus_request *sbus_req)
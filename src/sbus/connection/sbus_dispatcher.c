@@ -64,17 +64,225 @@ sbus_dispatch_reconnect(struct sbus_connection *conn)
     }
 }
 
+/* Upper bound of priority messages dispatched in one iteration. */
+#define SBUS_DISPATCH_PRIORITY_MAX 16
+
+/* Upper bound of remembered serials of priority calls. */
+#define SBUS_DISPATCH_PRIORITY_SERIALS_MAX 1024
+
+errno_t sbus_dispatch_priority_add(TALLOC_CTX *mem_ctx,
+                                   hash_table_t **_table,
+                                   const char *interface,
+                                   const char *member)
+{
+    hash_key_t key;
+    hash_value_t value;
+    char *name;
+    errno_t ret;
+    int hret;
+
+    if (*_table == NULL) {
+        ret = sss_hash_create(mem_ctx, 0, _table);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    name = talloc_asprintf(NULL, "%s.%s", interface, member);
+    if (name == NULL) {
+        return ENOMEM;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = name;
+    value.type = HASH_VALUE_INT;
+    value.i = 1;
+
+    hret = hash_enter(*_table, &key, &value);
+    talloc_free(name);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to add priority method "
+              "%s.%s [%d]: %s\n", interface, member, hret,
+              hash_error_string(hret));
+        return EIO;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Messages of %s.%s are dispatched with "
+          "priority\n", interface, member);
+
+    return EOK;
+}
+
+static bool
+sbus_dispatch_priority_method(struct sbus_connection *conn,
+                              DBusMessage *msg)
+{
+    const char *interface;
+    const char *member;
+    hash_key_t key;
+    char *name;
+    bool found;
+
+    if (conn->priority_methods == NULL
+            || hash_count(conn->priority_methods) == 0) {
+        return false;
+    }
+
+    interface = dbus_message_get_interface(msg);
+    member = dbus_message_get_member(msg);
+    if (interface == NULL || member == NULL) {
+        return false;
+    }
+
+    name = talloc_asprintf(NULL, "%s.%s", interface, member);
+    if (name == NULL) {
+        return false;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = name;
+    found = hash_has_key(conn->priority_methods, &key);
+    talloc_free(name);
+
+    return found;
+}
+
+void sbus_dispatch_priority_sent(struct sbus_connection *conn,
+                                 DBusMessage *msg)
+{
+    hash_key_t key;
+    hash_value_t value;
+    errno_t ret;
+    int hret;
+
+    if (!sbus_dispatch_priority_method(conn, msg)) {
+        return;
+    }
+
+    if (conn->priority_serials == NULL) {
+        ret = sss_hash_create(conn, 0, &conn->priority_serials);
+        if (ret != EOK) {
+            return;
+        }
+    }
+
+    /* Replies that never arrive must not make the table grow forever. They
+     * are dispatched in order with other messages if we forget them. */
+    if (hash_count(conn->priority_serials)
+            >= SBUS_DISPATCH_PRIORITY_SERIALS_MAX) {
+        hash_destroy(conn->priority_serials);
+        conn->priority_serials = NULL;
+        ret = sss_hash_create(conn, 0, &conn->priority_serials);
+        if (ret != EOK) {
+            return;
+        }
+    }
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = dbus_message_get_serial(msg);
+    value.type = HASH_VALUE_INT;
+    value.i = 1;
+
+    hret = hash_enter(conn->priority_serials, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to remember serial [%d]: %s\n",
+              hret, hash_error_string(hret));
+    }
+}
+
+static bool
+sbus_dispatch_priority_reply(struct sbus_connection *conn,
+                             DBusMessage *msg,
+                             bool remove)
+{
+    hash_key_t key;
+
+    if (conn->priority_serials == NULL) {
+        return false;
+    }
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = dbus_message_get_reply_serial(msg);
+
+    if (!hash_has_key(conn->priority_serials, &key)) {
+        return false;
+    }
+
+    if (remove) {
+        hash_delete(conn->priority_serials, &key);
+    }
+
+    return true;
+}
+
+/* Check whether the message that is going to be dispatched next is a
+ * priority message. If it is a reply, its serial is forgotten when @remove
+ * is set since it is going to be dispatched right away. */
+static bool
+sbus_dispatch_priority_head(struct sbus_connection *conn, bool remove)
+{
+    DBusMessage *msg;
+    bool priority;
+
+    if ((conn->priority_methods == NULL
+            || hash_count(conn->priority_methods) == 0)
+            && (conn->priority_serials == NULL
+            || hash_count(conn->priority_serials) == 0)) {
+        return false;
+    }
+
+    msg = dbus_connection_borrow_message(conn->connection);
+    if (msg == NULL) {
+        return false;
+    }
+
+    switch (dbus_message_get_type(msg)) {
+    case DBUS_MESSAGE_TYPE_METHOD_CALL:
+    case DBUS_MESSAGE_TYPE_SIGNAL:
+        priority = sbus_dispatch_priority_method(conn, msg);
+        break;
+    case DBUS_MESSAGE_TYPE_METHOD_RETURN:
+    case DBUS_MESSAGE_TYPE_ERROR:
+        priority = sbus_dispatch_priority_reply(conn, msg, remove);
+        break;
+    default:
+        priority = false;
+        break;
+    }
+
+    dbus_connection_return_message(conn->connection, msg);
+
+    return priority;
+}
+
 static void
-sbus_dispatch(struct tevent_context *ev,
-              struct tevent_timer *te,
-              struct timeval tv,
-              void *data)
+sbus_dispatch_priority_handler(struct tevent_context *ev,
+                               struct tevent_immediate *im,
+                               void *data);
+
+/* A priority message is waiting, dispatch it before other timers. */
+static void
+sbus_dispatch_schedule_priority(struct sbus_connection *conn)
+{
+    if (conn->priority_im == NULL) {
+        conn->priority_im = tevent_create_immediate(conn);
+        if (conn->priority_im == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "Could not add dispatch event!\n");
+            sbus_dispatch_schedule(conn, 0);
+            return;
+        }
+    }
+
+    tevent_schedule_immediate(conn->priority_im, conn->ev,
+                              sbus_dispatch_priority_handler, conn);
+}
+
+static void
+sbus_dispatch_messages(struct sbus_connection *conn)
 {
     DBusDispatchStatus status;
-    struct sbus_connection *conn;
     bool connected;
-
-    conn = talloc_get_type(data, struct sbus_connection);
+    int i;
 
     /* Just return if the connection is being terminated. */
     if (conn->disconnecting) {
@@ -95,20 +303,65 @@ sbus_dispatch(struct tevent_context *ev,
         return;
     }
 
-    /* Dispatch only once to avoid starving other tevent requests. */
-    status = dbus_connection_get_dispatch_status(conn->connection);
-    if (status != DBUS_DISPATCH_COMPLETE) {
+    /* Dispatch only once to avoid starving other tevent requests. Priority
+     * messages that directly follow are dispatched as well. */
+    for (i = 0; i < SBUS_DISPATCH_PRIORITY_MAX; i++) {
+        status = dbus_connection_get_dispatch_status(conn->connection);
+        if (status == DBUS_DISPATCH_COMPLETE) {
+            break;
+        }
+
+        if (i > 0 && !sbus_dispatch_priority_head(conn, false)) {
+            break;
+        }
+
+        /* Forget the serial if this is a priority reply. */
+        sbus_dispatch_priority_head(conn, true);
+
         DEBUG(SSSDBG_TRACE_ALL, "Dispatching.\n");
         dbus_connection_dispatch(conn->connection);
+
+        /* The handler may have scheduled the connection for release. */
+        if (conn->disconnecting) {
+            return;
+        }
     }
 
     /* If other dispatches are waiting, schedule next dispatch. */
     status = dbus_connection_get_dispatch_status(conn->connection);
     if (status != DBUS_DISPATCH_COMPLETE) {
+        if (sbus_dispatch_priority_head(conn, false)) {
+            sbus_dispatch_schedule_priority(conn);
+            return;
+        }
+
         sbus_dispatch_schedule(conn, 0);
     }
 }
 
+static void
+sbus_dispatch(struct tevent_context *ev,
+              struct tevent_timer *te,
+              struct timeval tv,
+              void *data)
+{
+    struct sbus_connection *conn;
+
+    conn = talloc_get_type(data, struct sbus_connection);
+    sbus_dispatch_messages(conn);
+}
+
+static void
+sbus_dispatch_priority_handler(struct tevent_context *ev,
+                               struct tevent_immediate *im,
+                               void *data)
+{
+    struct sbus_connection *conn;
+
+    conn = talloc_get_type(data, struct sbus_connection);
+    sbus_dispatch_messages(conn);
+}
+
 static void
 sbus_dispatch_schedule(struct sbus_connection *conn, uint32_t usecs)
 {
@@ -146,6 +146,9 @@ sbus_message_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* The serial is known now, prioritize the reply if needed. */
+    sbus_dispatch_priority_sent(conn, msg);
+
     talloc_set_destructor(state, sbus_message_destructor);
 
     ret = EAGAIN;
@@ -59,6 +59,29 @@ sbus_iterator_read_basic(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+/* Fixed types whose C representation matches the wire format can be
+ * copied in one block. D-Bus booleans are four bytes long. */
+static bool
+sbus_iterator_is_fixed_block(int dbus_type, int element_size)
+{
+    switch (dbus_type) {
+    case DBUS_TYPE_BYTE:
+        return element_size == 1;
+    case DBUS_TYPE_INT16:
+    case DBUS_TYPE_UINT16:
+        return element_size == 2;
+    case DBUS_TYPE_INT32:
+    case DBUS_TYPE_UINT32:
+        return element_size == 4;
+    case DBUS_TYPE_INT64:
+    case DBUS_TYPE_UINT64:
+    case DBUS_TYPE_DOUBLE:
+        return element_size == 8;
+    default:
+        return false;
+    }
+}
+
 static errno_t
 _sbus_iterator_read_basic_array(TALLOC_CTX *mem_ctx,
                                 DBusMessageIter *iterator,
@@ -68,6 +91,7 @@ _sbus_iterator_read_basic_array(TALLOC_CTX *mem_ctx,
 {
     DBusMessageIter subiter;
     uint8_t *arrayptr;
+    void *fixed;
     void *array;
     int arg_type;
     int count;
@@ -106,6 +130,19 @@ _sbus_iterator_read_basic_array(TALLOC_CTX *mem_ctx,
             goto done;
         }
 
+        if (sbus_iterator_is_fixed_block(dbus_type, element_size)) {
+            if (dbus_message_iter_get_arg_type(&subiter) != dbus_type) {
+                ret = ERR_SBUS_INVALID_TYPE;
+                goto done;
+            }
+
+            /* Points directly into the message. */
+            dbus_message_iter_get_fixed_array(&subiter, &fixed, &count);
+            array = talloc_memdup(mem_ctx, fixed, count * element_size);
+            ret = array == NULL ? ENOMEM : EOK;
+            goto done;
+        }
+
         array = talloc_zero_size(mem_ctx, count * element_size);
         if (array == NULL) {
             ret = ENOMEM;
@@ -139,6 +139,7 @@ static struct tevent_req *
 sbus_method_in_raw_out__send
     (TALLOC_CTX *mem_ctx,
      struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
      DBusMessage *raw_message)
 {
     struct sbus_method_in_raw_out__state *state;
@@ -153,7 +154,7 @@ sbus_method_in_raw_out__send
     }
 
 
-    subreq = sbus_call_method_send(state, conn, raw_message, NULL, NULL, NULL,
+    subreq = sbus_call_method_send(state, conn, raw_message, keygen, NULL, NULL,
                                    dbus_message_get_path(raw_message),
                                    dbus_message_get_interface(raw_message),
                                    dbus_message_get_member(raw_message), NULL);
@@ -740,7 +741,7 @@ sbus_call_DBusProperties_Set_send
      struct sbus_connection *conn,
      DBusMessage *raw_message)
 {
-    return sbus_method_in_raw_out__send(mem_ctx, conn, raw_message);
+    return sbus_method_in_raw_out__send(mem_ctx, conn, NULL, raw_message);
 }
 
 errno_t
@@ -25,6 +25,7 @@
 
 #include "util/util.h"
 #include "util/dlinklist.h"
+#include "util/sss_ptr_hash.h"
 #include "sbus/sbus_request.h"
 #include "sbus/sbus_private.h"
 
@@ -54,6 +55,11 @@ sbus_active_requests_init(TALLOC_CTX *mem_ctx)
         goto fail;
     }
 
+    requests->stats = sss_ptr_hash_create(requests, NULL, NULL);
+    if (requests->stats == NULL) {
+        goto fail;
+    }
+
     return requests;
 
 fail:
@@ -571,6 +577,56 @@ sbus_incoming_request_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+struct sbus_request_stats_entry {
+    uint64_t requests;
+    uint64_t coalesced;
+    bool no_coalescing;
+
+    /* Position in the output of sbus_connection_get_request_stats() */
+    size_t index;
+};
+
+static struct sbus_request_stats_entry *
+sbus_request_stats_get(struct sbus_active_requests *requests,
+                       const char *interface,
+                       const char *member)
+{
+    struct sbus_request_stats_entry *entry;
+    char *name;
+    errno_t ret;
+
+    if (interface == NULL || member == NULL) {
+        return NULL;
+    }
+
+    name = talloc_asprintf(NULL, "%s.%s", interface, member);
+    if (name == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(requests->stats, name,
+                                struct sbus_request_stats_entry);
+    if (entry != NULL) {
+        goto done;
+    }
+
+    entry = talloc_zero(requests->stats, struct sbus_request_stats_entry);
+    if (entry == NULL) {
+        goto done;
+    }
+
+    ret = sss_ptr_hash_add(requests->stats, name, entry,
+                           struct sbus_request_stats_entry);
+    if (ret != EOK) {
+        talloc_zfree(entry);
+        goto done;
+    }
+
+done:
+    talloc_free(name);
+    return entry;
+}
+
 struct sbus_outgoing_request_state {
     const char *key;
     struct sbus_connection *conn;
@@ -607,6 +663,7 @@ sbus_outgoing_request_send(TALLOC_CTX *mem_ctx,
                            DBusMessage *msg)
 {
     struct sbus_outgoing_request_state *state;
+    struct sbus_request_stats_entry *stats;
     struct tevent_req *subreq;
     struct tevent_req *req;
     bool key_exists;
@@ -620,6 +677,16 @@ sbus_outgoing_request_send(TALLOC_CTX *mem_ctx,
 
     state->conn = conn;
 
+    stats = sbus_request_stats_get(conn->requests,
+                                   dbus_message_get_interface(msg),
+                                   dbus_message_get_member(msg));
+    if (stats != NULL) {
+        stats->requests++;
+        if (stats->no_coalescing) {
+            key = NULL;
+        }
+    }
+
     if (key != NULL) {
         state->key = talloc_strdup(state, key);
         if (state->key == NULL) {
@@ -644,6 +711,9 @@ sbus_outgoing_request_send(TALLOC_CTX *mem_ctx,
     }
 
     if (key_exists) {
+        if (stats != NULL) {
+            stats->coalesced++;
+        }
         return req;
     }
 
@@ -715,6 +785,146 @@ sbus_outgoing_request_recv(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+errno_t
+sbus_connection_disable_coalescing(struct sbus_connection *conn,
+                                   const char *interface,
+                                   const char *member)
+{
+    struct sbus_request_stats_entry *stats;
+
+    stats = sbus_request_stats_get(conn->requests, interface, member);
+    if (stats == NULL) {
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Calls of %s.%s will not be coalesced\n",
+          interface, member);
+
+    stats->no_coalescing = true;
+
+    return EOK;
+}
+
+/* Keys start with "sender:type:interface.member:" */
+static struct sbus_request_stats_entry *
+sbus_request_stats_by_key(struct sbus_active_requests *requests,
+                          const char *key)
+{
+    struct sbus_request_stats_entry *entry;
+    const char *start;
+    const char *end;
+    char *name;
+
+    start = strchr(key, ':');
+    if (start != NULL) {
+        start = strchr(start + 1, ':');
+    }
+
+    if (start == NULL) {
+        return NULL;
+    }
+
+    start++;
+    end = strchr(start, ':');
+    if (end == NULL) {
+        return NULL;
+    }
+
+    name = talloc_strndup(NULL, start, end - start);
+    if (name == NULL) {
+        return NULL;
+    }
+
+    entry = sss_ptr_hash_lookup(requests->stats, name,
+                                struct sbus_request_stats_entry);
+    talloc_free(name);
+
+    return entry;
+}
+
+errno_t
+sbus_connection_get_request_stats(TALLOC_CTX *mem_ctx,
+                                  struct sbus_connection *conn,
+                                  struct sbus_request_stats **_stats,
+                                  size_t *_num_stats)
+{
+    struct sbus_request_stats_entry *entry;
+    struct sbus_request_stats *stats = NULL;
+    struct sbus_request_list *list;
+    struct sbus_request_list *item;
+    hash_entry_t *entries = NULL;
+    unsigned long int num = 0;
+    unsigned long int i;
+    errno_t ret;
+    int hret;
+
+    hret = hash_entries(conn->requests->stats, &num, &entries);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    stats = talloc_zero_array(mem_ctx, struct sbus_request_stats, num);
+    if (stats == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num; i++) {
+        entry = sss_ptr_get_value(&entries[i].value,
+                                  struct sbus_request_stats_entry);
+        entry->index = i;
+
+        stats[i].method = talloc_strdup(stats, entries[i].key.str);
+        if (stats[i].method == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        stats[i].requests = entry->requests;
+        stats[i].coalesced = entry->coalesced;
+    }
+
+    talloc_zfree(entries);
+
+    /* Calls that are in progress are those in the table of outgoing
+     * requests, each list holds one message and all its callers. */
+    hret = hash_entries(conn->requests->outgoing, &num, &entries);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num; i++) {
+        entry = sbus_request_stats_by_key(conn->requests, entries[i].key.str);
+        if (entry == NULL) {
+            continue;
+        }
+
+        list = sss_ptr_get_value(&entries[i].value, struct sbus_request_list);
+
+        stats[entry->index].in_flight++;
+        DLIST_FOR_EACH(item, list) {
+            if (!item->is_invalid) {
+                stats[entry->index].waiting++;
+            }
+        }
+    }
+
+    *_stats = stats;
+    *_num_stats = talloc_array_length(stats);
+
+    ret = EOK;
+
+done:
+    talloc_free(entries);
+    if (ret != EOK) {
+        talloc_free(stats);
+    }
+
+    return ret;
+}
+
 struct sbus_request_await_state {
     int dummy;
 };
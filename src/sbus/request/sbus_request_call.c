@@ -69,7 +69,10 @@ sbus_call_method_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, input, &key);
+    /* Methods with custom input handler are keyed by the raw message. */
+    ret = sbus_request_key(state, keygen, sbus_req,
+                           raw_message != NULL ? (void *)raw_message : input,
+                           &key);
     if (ret != EOK) {
         goto done;
     }
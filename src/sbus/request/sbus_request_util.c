@@ -18,8 +18,10 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <inttypes.h>
 #include <tevent.h>
 #include <talloc.h>
+#include <dbus/dbus.h>
 
 #include "sbus/sbus_request.h"
 #include "sbus/sbus_private.h"
@@ -65,3 +67,129 @@ sbus_request_key(TALLOC_CTX *mem_ctx,
     return EOK;
 
 }
+
+static char *
+sbus_message_key_append(char *key, DBusMessageIter *iter)
+{
+    DBusMessageIter subiter;
+    const char *str;
+    dbus_bool_t b;
+    uint8_t u8;
+    int16_t i16;
+    uint16_t u16;
+    int32_t i32;
+    uint32_t u32;
+    int64_t i64;
+    uint64_t u64;
+    double d;
+    int type;
+
+    do {
+        type = dbus_message_iter_get_arg_type(iter);
+        switch (type) {
+        case DBUS_TYPE_INVALID:
+            return key;
+        case DBUS_TYPE_STRING:
+        case DBUS_TYPE_OBJECT_PATH:
+        case DBUS_TYPE_SIGNATURE:
+            dbus_message_iter_get_basic(iter, &str);
+            /* Length prefix keeps strings with delimiters unambiguous. */
+            key = talloc_asprintf_append_buffer(key, ":%zu=%s",
+                                                strlen(str), str);
+            break;
+        case DBUS_TYPE_BOOLEAN:
+            dbus_message_iter_get_basic(iter, &b);
+            key = talloc_asprintf_append_buffer(key, ":%u", b ? 1 : 0);
+            break;
+        case DBUS_TYPE_BYTE:
+            dbus_message_iter_get_basic(iter, &u8);
+            key = talloc_asprintf_append_buffer(key, ":%" PRIu8, u8);
+            break;
+        case DBUS_TYPE_INT16:
+            dbus_message_iter_get_basic(iter, &i16);
+            key = talloc_asprintf_append_buffer(key, ":%" PRIi16, i16);
+            break;
+        case DBUS_TYPE_UINT16:
+            dbus_message_iter_get_basic(iter, &u16);
+            key = talloc_asprintf_append_buffer(key, ":%" PRIu16, u16);
+            break;
+        case DBUS_TYPE_INT32:
+            dbus_message_iter_get_basic(iter, &i32);
+            key = talloc_asprintf_append_buffer(key, ":%" PRIi32, i32);
+            break;
+        case DBUS_TYPE_UINT32:
+            dbus_message_iter_get_basic(iter, &u32);
+            key = talloc_asprintf_append_buffer(key, ":%" PRIu32, u32);
+            break;
+        case DBUS_TYPE_INT64:
+            dbus_message_iter_get_basic(iter, &i64);
+            key = talloc_asprintf_append_buffer(key, ":%" PRIi64, i64);
+            break;
+        case DBUS_TYPE_UINT64:
+            dbus_message_iter_get_basic(iter, &u64);
+            key = talloc_asprintf_append_buffer(key, ":%" PRIu64, u64);
+            break;
+        case DBUS_TYPE_DOUBLE:
+            dbus_message_iter_get_basic(iter, &d);
+            key = talloc_asprintf_append_buffer(key, ":%a", d);
+            break;
+        case DBUS_TYPE_ARRAY:
+        case DBUS_TYPE_STRUCT:
+        case DBUS_TYPE_DICT_ENTRY:
+        case DBUS_TYPE_VARIANT:
+            dbus_message_iter_recurse(iter, &subiter);
+            key = talloc_strdup_append_buffer(key, ":[");
+            if (key == NULL) {
+                return NULL;
+            }
+
+            key = sbus_message_key_append(key, &subiter);
+            if (key == NULL) {
+                return NULL;
+            }
+
+            key = talloc_strdup_append_buffer(key, "]");
+            break;
+        default:
+            /* File descriptors can not be compared by value. */
+            DEBUG(SSSDBG_MINOR_FAILURE, "Type %c can not be used in a key\n",
+                  type);
+            talloc_free(key);
+            return NULL;
+        }
+
+        if (key == NULL) {
+            return NULL;
+        }
+    } while (dbus_message_iter_next(iter));
+
+    return key;
+}
+
+const char *
+sbus_message_keygen(TALLOC_CTX *mem_ctx,
+                    struct sbus_request *sbus_req,
+                    DBusMessage *msg)
+{
+    DBusMessageIter iter;
+    const char *signature;
+    char *key;
+
+    signature = dbus_message_get_signature(msg);
+
+    if (sbus_req->sender == NULL) {
+        key = talloc_asprintf(mem_ctx, "-:%u:%s.%s:%s:%s",
+                  sbus_req->type, sbus_req->interface, sbus_req->member,
+                  sbus_req->path, signature);
+    } else {
+        key = talloc_asprintf(mem_ctx, "%"PRIi64":%u:%s.%s:%s:%s",
+                  sbus_req->sender->uid, sbus_req->type, sbus_req->interface,
+                  sbus_req->member, sbus_req->path, signature);
+    }
+
+    if (key == NULL || !dbus_message_iter_init(msg, &iter)) {
+        return key;
+    }
+
+    return sbus_message_key_append(key, &iter);
+}
@@ -205,6 +205,21 @@ sbus_server_create_and_connect_recv(TALLOC_CTX *mem_ctx,
 struct sbus_connection *
 sbus_server_find_connection(struct sbus_server *server, const char *name);
 
+/**
+ * Dispatch messages of this method before other messages on all
+ * connections of the server. See @sbus_connection_set_priority.
+ *
+ * @param server        An sbus server.
+ * @param interface     Interface name.
+ * @param member        Method or signal name.
+ *
+ * @return EOK or other error code.
+ */
+errno_t
+sbus_server_set_priority(struct sbus_server *server,
+                         const char *interface,
+                         const char *member);
+
 /**
  * Set server callback that is run everytime a new connection is established
  * with the server.
@@ -293,6 +308,84 @@ void sbus_connection_set_data(struct sbus_connection *conn,
 #define sbus_connection_get_data(conn, type) \
     talloc_get_type(_sbus_connection_get_data(conn), type)
 
+/**
+ * Check whether file descriptors can be passed over the connection.
+ *
+ * @param conn          An sbus connection.
+ *
+ * @return True if messages may contain file descriptors.
+ */
+bool sbus_connection_can_pass_fd(struct sbus_connection *conn);
+
+/**
+ * Dispatch calls, signals and replies of this method before other
+ * messages. Consecutive priority messages are dispatched within one
+ * tevent loop iteration and the connection is scheduled ahead of other
+ * connections while a priority message is waiting.
+ *
+ * @param conn          An sbus connection.
+ * @param interface     Interface name.
+ * @param member        Method or signal name.
+ *
+ * @return EOK or other error code.
+ */
+errno_t
+sbus_connection_set_priority(struct sbus_connection *conn,
+                             const char *interface,
+                             const char *member);
+
+/**
+ * Statistics of outgoing calls of a single method.
+ */
+struct sbus_request_stats {
+    /* Method name in the form of interface.member. */
+    const char *method;
+
+    /* Number of calls made through the connection. */
+    uint64_t requests;
+
+    /* Number of calls that were attached to an identical call
+     * already in progress instead of sending a new message. */
+    uint64_t coalesced;
+
+    /* Number of messages that are waiting for a reply and number
+     * of callers waiting for them. Only known for methods that
+     * support coalescing. */
+    uint32_t in_flight;
+    uint32_t waiting;
+};
+
+/**
+ * Get statistics of outgoing method calls on this connection.
+ *
+ * @param mem_ctx       Memory context.
+ * @param conn          An sbus connection.
+ * @param _stats        Array of statistics, one item per method.
+ * @param _num_stats    Number of items in the array.
+ *
+ * @return EOK or other error code.
+ */
+errno_t
+sbus_connection_get_request_stats(TALLOC_CTX *mem_ctx,
+                                  struct sbus_connection *conn,
+                                  struct sbus_request_stats **_stats,
+                                  size_t *_num_stats);
+
+/**
+ * Always send a new message when calling this method even if an identical
+ * call is already in progress.
+ *
+ * @param conn          An sbus connection.
+ * @param interface     Interface name.
+ * @param member        Method name.
+ *
+ * @return EOK or other error code.
+ */
+errno_t
+sbus_connection_disable_coalescing(struct sbus_connection *conn,
+                                   const char *interface,
+                                   const char *member);
+
 /**
  * Reconnection status that is pass to a reconnection callback.
  */
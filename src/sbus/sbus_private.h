@@ -108,6 +108,17 @@ struct sbus_connection {
     /* Pointer to a caller's last activity variable. The time is updated
      * each time the bus is active (when a method arrives). */
     time_t *last_activity;
+
+    /**
+     * Messages of these methods are dispatched before other events, see
+     * sbus_connection_set_priority(). Connections created by sbus server
+     * share the table of the server.
+     */
+    hash_table_t *priority_methods;
+
+    /* Serials of priority calls that are waiting for a reply. */
+    hash_table_t *priority_serials;
+    struct tevent_immediate *priority_im;
 };
 
 struct sbus_server {
@@ -120,6 +131,7 @@ struct sbus_server {
     time_t *last_activity;
     hash_table_t *names;
     hash_table_t *match_rules;
+    hash_table_t *priority_methods;
     uint32_t max_connections;
     uid_t uid;
     gid_t gid;
@@ -247,6 +259,16 @@ void sbus_dispatcher_setup(struct sbus_connection *conn);
 void sbus_dispatcher_disable(struct sbus_connection *conn);
 void sbus_dispatch_now(struct sbus_connection *conn);
 
+/* Add method to a table of priority methods. */
+errno_t sbus_dispatch_priority_add(TALLOC_CTX *mem_ctx,
+                                   hash_table_t **_table,
+                                   const char *interface,
+                                   const char *member);
+
+/* Remember a sent priority method call so its reply is prioritized too. */
+void sbus_dispatch_priority_sent(struct sbus_connection *conn,
+                                 DBusMessage *msg);
+
 /* Send a new D-Bus message. */
 struct tevent_req *
 sbus_message_send(TALLOC_CTX *mem_ctx,
@@ -451,6 +473,9 @@ struct sbus_request_list {
 struct sbus_active_requests {
     hash_table_t *incoming;
     hash_table_t *outgoing;
+
+    /* Statistics of outgoing requests by interface.method. */
+    hash_table_t *stats;
 };
 
 /* Initialize active requests structure. */
@@ -578,6 +603,13 @@ sbus_request_key(TALLOC_CTX *mem_ctx,
                  void *input,
                  const char **_key);
 
+/* Key generator of methods with custom input handler. The key is built
+ * from the content of the raw message that is passed as input. */
+const char *
+sbus_message_keygen(TALLOC_CTX *mem_ctx,
+                    struct sbus_request *sbus_req,
+                    DBusMessage *msg);
+
 /**
  * Create copy of provided interface. It expects that the interface was
  * not created manually but through sbus API, therefore many of its fields
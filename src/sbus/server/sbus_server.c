@@ -459,6 +459,8 @@ sbus_server_new_connection(DBusServer *dbus_server,
         return;
     }
 
+    sbus_conn->priority_methods = sbus_server->priority_methods;
+
     dbret = dbus_connection_set_data(dbus_conn, sbus_server->data_slot,
                                      sbus_conn, NULL);
     if (!dbret) {
@@ -688,6 +690,12 @@ sbus_server_create(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* Created now so that all connections can share it. */
+    ret = sss_hash_create(sbus_server, 0, &sbus_server->priority_methods);
+    if (ret != EOK) {
+        goto done;
+    }
+
     sbus_server->router = sbus_router_init(sbus_server, NULL);
     if (sbus_server->router == NULL) {
         ret = ENOMEM;
@@ -731,6 +739,15 @@ sbus_server_find_connection(struct sbus_server *server, const char *name)
     return sss_ptr_hash_lookup(server->names, name, struct sbus_connection);
 }
 
+errno_t
+sbus_server_set_priority(struct sbus_server *server,
+                         const char *interface,
+                         const char *member)
+{
+    return sbus_dispatch_priority_add(server, &server->priority_methods,
+                                      interface, member);
+}
+
 void
 _sbus_server_set_on_connection(struct sbus_server *server,
                                const char *name,
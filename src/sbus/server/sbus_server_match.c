@@ -387,23 +387,6 @@ sbus_server_remove_match(struct sbus_server *server,
     return ret;
 }
 
-static bool
-sbus_server_connection_has_name(struct sbus_server *server,
-                                struct sbus_connection *conn,
-                                const char *name)
-{
-    struct sbus_connection *named_conn;
-
-    named_conn = sss_ptr_hash_lookup(server->names, name,
-                                     struct sbus_connection);
-
-    if (named_conn == NULL || named_conn != conn) {
-        return false;
-    }
-
-    return true;
-}
-
 errno_t
 sbus_server_matchmaker(struct sbus_server *server,
                        struct sbus_connection *conn,
@@ -412,7 +395,7 @@ sbus_server_matchmaker(struct sbus_server *server,
 {
     struct sss_ptr_list *list;
     struct sbus_connection *match_conn;
-    bool has_name;
+    struct sbus_connection *avoid_conn = NULL;
 
     /* We can't really send signals when the server is being destroyed. */
     if (server == NULL || server->disconnecting) {
@@ -427,20 +410,22 @@ sbus_server_matchmaker(struct sbus_server *server,
         return EOK;
     }
 
+    /* Sometimes (e.g. when a name is being deleted), we do not want to
+     * send the signal to a specific name. Resolve it only once instead
+     * of for every listener. */
+    if (avoid_name != NULL) {
+        avoid_conn = sss_ptr_hash_lookup(server->names, avoid_name,
+                                         struct sbus_connection);
+    }
+
     SSS_PTR_LIST_FOR_EACH(list, match_conn, struct sbus_connection) {
         /* Do not send signal back to the sender. */
         if (match_conn == conn) {
             continue;
         }
 
-        /* Sometimes (e.g. when a name is being deleted), we do not want to
-         * send the signal to a specific name. */
-        if (avoid_name != NULL) {
-            has_name = sbus_server_connection_has_name(server, match_conn,
-                                                       avoid_name);
-            if (has_name) {
-                continue;
-            }
+        if (avoid_conn != NULL && match_conn == avoid_conn) {
+            continue;
         }
 
         dbus_connection_send(match_conn->connection, message, NULL);
@@ -0,0 +1,21 @@
+/* This file is based on the public domain wyhash (final version 4) from
+ * Wang Yi: https://github.com/wangyi-fudan/wyhash
+ *
+ * The 64 bit result is folded to 32 bits and all arithmetic is done the same
+ * way on every architecture because 32 and 64 bit clients must produce the
+ * same result.
+ */
+
+#ifndef _SHARED_WYHASH_H_
+#define _SHARED_WYHASH_H_
+
+/* CAUTION:
+ * This file is also used in sss_client (pam, nss). Therefore it have to be
+ * minimalist and cannot include DEBUG macros or header file util.h.
+ */
+
+#include <stdint.h>
+
+uint32_t wyhash(const char *key, int len, uint32_t seed);
+
+#endif /* _SHARED_WYHASH_H_ */
@@ -31,7 +31,7 @@
 #define MAX_AUTOMNTKEYNAME_LEN  PATH_MAX
 
 /* How many entries shall _sss_getautomntent_r retrieve at once */
-#define GETAUTOMNTENT_MAX_ENTRIES   512
+#define GETAUTOMNTENT_MAX_ENTRIES   2048
 
 struct automtent {
     char *mapname;
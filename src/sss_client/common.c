@@ -31,6 +31,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -44,6 +45,7 @@
 #define _(STRING) dgettext (PACKAGE, STRING)
 #include "sss_cli.h"
 #include "common_private.h"
+#include "util/mmap_cache.h"
 
 #if HAVE_PTHREAD
 #include <pthread.h>
@@ -529,7 +531,8 @@ static int make_safe_fd(int fd)
     return new_fd;
 }
 
-static int sss_cli_open_socket(int *errnop, const char *socket_name, int timeout)
+static int sss_cli_open_socket(int *errnop, const char *socket_name, int timeout,
+                               struct stat *sb)
 {
     struct sockaddr_un nssaddr;
     bool inprogress = true;
@@ -624,7 +627,7 @@ static int sss_cli_open_socket(int *errnop, const char *socket_name, int timeout
         return -1;
     }
 
-    ret = fstat(sd, &sss_cli_sb);
+    ret = fstat(sd, sb);
     if (ret != 0) {
         close(sd);
         return -1;
@@ -701,7 +704,7 @@ static enum sss_status sss_cli_check_socket(int *errnop,
         sss_cli_close_socket();
     }
 
-    mysd = sss_cli_open_socket(errnop, socket_name, timeout);
+    mysd = sss_cli_open_socket(errnop, socket_name, timeout, &sss_cli_sb);
     if (mysd == -1) {
         return SSS_STATUS_UNAVAIL;
     }
@@ -717,22 +720,209 @@ static enum sss_status sss_cli_check_socket(int *errnop,
     return SSS_STATUS_UNAVAIL;
 }
 
-/* this function will check command codes match and returned length is ok */
-/* repbuf and replen report only the data section not the header */
-enum nss_status sss_nss_make_request_timeout(enum sss_cli_command cmd,
-                                             struct sss_cli_req_data *rd,
-                                             int timeout,
-                                             uint8_t **repbuf, size_t *replen,
-                                             int *errnop)
+/* Adaptive timeouts
+ *
+ * Processes that set SSS_NSS_ADAPTIVE_TIMEOUT to "YES" do not always wait
+ * the full timeout for the NSS responder. The responder publishes its
+ * health in the header of the memory cache files (SSS_MC_HEALTH_WORD):
+ *  - overloaded: the request is not sent at all, NSS_STATUS_UNAVAIL lets
+ *    nsswitch continue with the next module, e.g. files
+ *  - ok: the timeout of the caller is used, a slow reply is waiting for
+ *    the backend and not for the responder
+ *  - not updated for SSS_MC_HEALTH_STALE seconds: the responder does not
+ *    run its event loop, e.g. because it is restarting, the timeout is at
+ *    most SSS_CLI_ADAPTIVE_MIN_TIMEOUT
+ *  - busy or not published: the timeout is derived from the reply times
+ *    that this process has seen, smoothed like TCP round trip times, and
+ *    from the load of the responder
+ * The state is per process and is updated under the NSS lock.
+ */
+#define SSS_CLI_ADAPTIVE_MIN_TIMEOUT 5000
+#define SSS_CLI_ADAPTIVE_DEFAULT_TIMEOUT 30000
+#define SSS_CLI_ADAPTIVE_HEALTH_FILE SSS_NSS_MCACHE_DIR"/passwd"
+
+static struct {
+    int enabled;                    /* -1 until the environment is read */
+    struct sss_mc_header *header;   /* only the header is mapped */
+    time_t next_map;
+    uint32_t srtt;                  /* milliseconds, 0 without samples */
+    uint32_t rttvar;
+} sss_cli_adaptive = { -1, NULL, 0, 0, 0 };
+
+static bool sss_cli_adaptive_enabled(void)
 {
-    enum sss_status ret;
     char *envval;
 
-    /* avoid looping in the nss daemon */
-    envval = getenv("_SSS_LOOPS");
-    if (envval && strcmp(envval, "NO") == 0) {
-        return NSS_STATUS_NOTFOUND;
+    if (sss_cli_adaptive.enabled == -1) {
+        envval = getenv("SSS_NSS_ADAPTIVE_TIMEOUT");
+        sss_cli_adaptive.enabled = envval != NULL
+                                   && strcmp(envval, "YES") == 0 ? 1 : 0;
+    }
+
+    return sss_cli_adaptive.enabled == 1;
+}
+
+static uint64_t sss_cli_adaptive_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void sss_cli_adaptive_unmap(void)
+{
+    if (sss_cli_adaptive.header != NULL) {
+        munmap(sss_cli_adaptive.header, MC_HEADER_SIZE);
+        sss_cli_adaptive.header = NULL;
+    }
+}
+
+static void sss_cli_adaptive_map(void)
+{
+    struct sss_mc_header *h;
+    struct stat sb;
+    time_t now;
+    int fd;
+
+    /* The memory cache may be disabled, try again only once a second. */
+    now = time(NULL);
+    if (now < sss_cli_adaptive.next_map) {
+        return;
+    }
+    sss_cli_adaptive.next_map = now + 1;
+
+    fd = open(SSS_CLI_ADAPTIVE_HEALTH_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+
+    if (fstat(fd, &sb) != 0 || sb.st_size < MC_HEADER_SIZE) {
+        close(fd);
+        return;
+    }
+
+    h = mmap(NULL, MC_HEADER_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (h == MAP_FAILED) {
+        return;
+    }
+
+    if (h->major_vno != SSS_MC_MAJOR_VNO
+            || h->minor_vno != SSS_MC_MINOR_VNO) {
+        munmap(h, MC_HEADER_SIZE);
+        return;
+    }
+
+    sss_cli_adaptive.header = h;
+}
+
+static uint32_t sss_cli_adaptive_health(void)
+{
+    if (sss_cli_adaptive.header != NULL
+            && sss_cli_adaptive.header->status == SSS_MC_HEADER_RECYCLED) {
+        /* the responder has created a new file */
+        sss_cli_adaptive_unmap();
+    }
+
+    if (sss_cli_adaptive.header == NULL) {
+        sss_cli_adaptive_map();
+        if (sss_cli_adaptive.header == NULL) {
+            return SSS_MC_HEALTH_UNKNOWN;
+        }
+    }
+
+    return __atomic_load_n(&sss_cli_adaptive.header->health,
+                           __ATOMIC_RELAXED);
+}
+
+/* Returns false if the request should not be sent at all. */
+static bool sss_cli_adaptive_timeout(int *timeout)
+{
+    struct timespec now;
+    uint32_t health;
+    uint32_t load = 0;
+    uint64_t rto;
+
+    health = sss_cli_adaptive_health();
+    if (SSS_MC_HEALTH_STATE(health) != SSS_MC_HEALTH_UNKNOWN) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (SSS_MC_HEALTH_AGE(health, now.tv_sec) > SSS_MC_HEALTH_STALE) {
+            if (*timeout > SSS_CLI_ADAPTIVE_MIN_TIMEOUT) {
+                *timeout = SSS_CLI_ADAPTIVE_MIN_TIMEOUT;
+            }
+            return true;
+        }
+
+        switch (SSS_MC_HEALTH_STATE(health)) {
+        case SSS_MC_HEALTH_OVERLOADED:
+            return false;
+        case SSS_MC_HEALTH_OK:
+            return true;
+        default:
+            load = SSS_MC_HEALTH_LOAD(health) * 10;
+            break;
+        }
+    }
+
+    if (sss_cli_adaptive.srtt == 0) {
+        rto = SSS_CLI_ADAPTIVE_DEFAULT_TIMEOUT;
+    } else {
+        rto = sss_cli_adaptive.srtt + 4 * (uint64_t)sss_cli_adaptive.rttvar;
+    }
+
+    rto += load;
+    if (rto < SSS_CLI_ADAPTIVE_MIN_TIMEOUT) {
+        rto = SSS_CLI_ADAPTIVE_MIN_TIMEOUT;
+    }
+
+    if (rto < *timeout) {
+        *timeout = rto;
+    }
+
+    return true;
+}
+
+static void sss_cli_adaptive_sample(uint64_t start)
+{
+    uint64_t elapsed;
+    uint32_t rtt;
+    uint32_t delta;
+
+    elapsed = sss_cli_adaptive_now() - start;
+    if (elapsed == 0) {
+        rtt = 1;
+    } else if (elapsed > SSS_CLI_SOCKET_TIMEOUT) {
+        rtt = SSS_CLI_SOCKET_TIMEOUT;
+    } else {
+        rtt = elapsed;
+    }
+
+    if (sss_cli_adaptive.srtt == 0) {
+        sss_cli_adaptive.srtt = rtt;
+        sss_cli_adaptive.rttvar = rtt / 2;
+        return;
+    }
+
+    delta = rtt > sss_cli_adaptive.srtt ? rtt - sss_cli_adaptive.srtt
+                                        : sss_cli_adaptive.srtt - rtt;
+    sss_cli_adaptive.rttvar = (sss_cli_adaptive.rttvar * 3 + delta) / 4;
+    sss_cli_adaptive.srtt = (sss_cli_adaptive.srtt * 7 + rtt) / 8;
+    if (sss_cli_adaptive.srtt == 0) {
+        sss_cli_adaptive.srtt = 1;
     }
+}
+
+/* this function will check command codes match and returned length is ok */
+/* repbuf and replen report only the data section not the header */
+static enum nss_status sss_nss_make_request_once(enum sss_cli_command cmd,
+                                                 struct sss_cli_req_data *rd,
+                                                 int timeout,
+                                                 uint8_t **repbuf,
+                                                 size_t *replen,
+                                                 int *errnop)
+{
+    enum sss_status ret;
 
     ret = sss_cli_check_socket(errnop, SSS_NSS_SOCKET_NAME, timeout);
     if (ret != SSS_STATUS_SUCCESS) {
@@ -781,6 +971,50 @@ enum nss_status sss_nss_make_request_timeout(enum sss_cli_command cmd,
     }
 }
 
+enum nss_status sss_nss_make_request_timeout(enum sss_cli_command cmd,
+                                             struct sss_cli_req_data *rd,
+                                             int timeout,
+                                             uint8_t **repbuf, size_t *replen,
+                                             int *errnop)
+{
+    enum nss_status nret;
+    uint64_t start;
+    char *envval;
+
+    /* avoid looping in the nss daemon */
+    envval = getenv("_SSS_LOOPS");
+    if (envval && strcmp(envval, "NO") == 0) {
+        return NSS_STATUS_NOTFOUND;
+    }
+
+    if (!sss_cli_adaptive_enabled()) {
+        return sss_nss_make_request_once(cmd, rd, timeout, repbuf, replen,
+                                         errnop);
+    }
+
+    if (!sss_cli_adaptive_timeout(&timeout)) {
+        /* the responder is overloaded */
+#ifdef NONSTANDARD_SSS_NSS_BEHAVIOUR
+        *errnop = 0;
+        errno = 0;
+        return NSS_STATUS_NOTFOUND;
+#else
+        *errnop = EAGAIN;
+        return NSS_STATUS_UNAVAIL;
+#endif
+    }
+
+    start = sss_cli_adaptive_now();
+
+    nret = sss_nss_make_request_once(cmd, rd, timeout, repbuf, replen,
+                                     errnop);
+    if (nret == NSS_STATUS_SUCCESS) {
+        sss_cli_adaptive_sample(start);
+    }
+
+    return nret;
+}
+
 enum nss_status sss_nss_make_request(enum sss_cli_command cmd,
                                      struct sss_cli_req_data *rd,
                                      uint8_t **repbuf, size_t *replen,
@@ -790,6 +1024,950 @@ enum nss_status sss_nss_make_request(enum sss_cli_command cmd,
                                         repbuf, replen, errnop);
 }
 
+#if HAVE_PTHREAD
+
+/* Multiplexed NSS connection
+ *
+ * Processes that opt in share one more connection to the NSS responder
+ * between all their threads without serializing them on sss_nss_lock().
+ * Every request carries an id in bytes 12-15 of its header which the
+ * responder copies into the reply. Requests are written while holding the
+ * channel mutex, replies are read by one of the waiting threads at a time
+ * and handed over to the thread whose request they answer. The channel is
+ * only used if the responder echoed the id of the version check on a new
+ * connection; older responders leave the field zero. */
+
+struct sss_cli_mux_req {
+    uint32_t id;
+    enum sss_cli_command cmd;
+
+    bool done;
+    enum sss_status status;
+    int errnop;
+    uint8_t *buf;
+    size_t len;
+
+    struct sss_cli_mux_req *next;
+};
+
+static struct sss_cli_mux {
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+
+    int sd;
+    struct stat sb;
+    pid_t pid;
+    uint32_t next_id;
+
+    bool reading;     /* a thread reads replies without holding mtx */
+    bool broken;      /* the reading thread must close the connection */
+    bool unsupported; /* the responder does not echo request ids */
+
+    struct sss_cli_mux_req *pending;
+} sss_cli_mux = {
+    .mtx = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .sd = -1,
+};
+
+static int sss_cli_fd_write(int sd, const void *buf, size_t len, int timeout)
+{
+    struct pollfd pfd;
+    size_t sent = 0;
+    ssize_t res;
+    int error;
+
+    while (sent < len) {
+        pfd.fd = sd;
+        pfd.events = POLLOUT;
+
+        do {
+            errno = 0;
+            res = poll(&pfd, 1, timeout);
+            error = errno;
+        } while (res == -1 && error == EINTR);
+
+        if (res == -1) {
+            return error;
+        }
+        if (res == 0) {
+            return ETIME;
+        }
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            return EPIPE;
+        }
+
+        errno = 0;
+        res = send(sd, (const uint8_t *)buf + sent, len - sent,
+                   SSS_DEFAULT_WRITE_FLAGS);
+        error = errno;
+        if (res == -1 || res == 0) {
+            if (error == EINTR || error == EAGAIN) {
+                continue;
+            }
+            return error ? error : EPIPE;
+        }
+
+        sent += res;
+    }
+
+    return 0;
+}
+
+/* _got tells whether a timeout left the stream in a consistent state */
+static int sss_cli_fd_read(int sd, void *buf, size_t len, int timeout,
+                            size_t *_got)
+{
+    struct pollfd pfd;
+    size_t got = 0;
+    ssize_t res;
+    int error;
+    int ret;
+
+    while (got < len) {
+        pfd.fd = sd;
+        pfd.events = POLLIN;
+
+        do {
+            errno = 0;
+            res = poll(&pfd, 1, timeout);
+            error = errno;
+        } while (res == -1 && error == EINTR);
+
+        if (res == -1) {
+            ret = error;
+            goto done;
+        }
+        if (res == 0) {
+            ret = ETIME;
+            goto done;
+        }
+        if (pfd.revents & (POLLERR | POLLNVAL)) {
+            ret = EPIPE;
+            goto done;
+        }
+
+        errno = 0;
+        res = read(sd, (uint8_t *)buf + got, len - got);
+        error = errno;
+        if (res == -1 || res == 0) {
+            if (res == -1 && (error == EINTR || error == EAGAIN)) {
+                continue;
+            }
+            ret = error ? error : EPIPE;
+            goto done;
+        }
+
+        got += res;
+    }
+
+    ret = 0;
+
+done:
+    if (_got != NULL) {
+        *_got = got;
+    }
+    return ret;
+}
+
+static int sss_cli_fd_send_req(int sd, uint32_t id,
+                                enum sss_cli_command cmd,
+                                struct sss_cli_req_data *rd,
+                                int timeout)
+{
+    uint32_t header[4];
+    int ret;
+
+    header[0] = SSS_NSS_HEADER_SIZE + (rd ? rd->len : 0);
+    header[1] = cmd;
+    header[2] = 0;
+    header[3] = id;
+
+    ret = sss_cli_fd_write(sd, header, SSS_NSS_HEADER_SIZE, timeout);
+    if (ret != 0 || rd == NULL || rd->len == 0) {
+        return ret;
+    }
+
+    return sss_cli_fd_write(sd, rd->data, rd->len, timeout);
+}
+
+/* Reads one complete reply. A timeout before the first byte arrived returns
+ * EAGAIN, any other error means the connection cannot be used anymore. */
+static int sss_cli_fd_recv_rep(int sd, int timeout, uint32_t header[4],
+                                uint8_t **_buf, size_t *_len)
+{
+    uint8_t *buf = NULL;
+    size_t len;
+    size_t got;
+    int ret;
+
+    ret = sss_cli_fd_read(sd, header, SSS_NSS_HEADER_SIZE, timeout, &got);
+    if (ret == ETIME && got == 0) {
+        return EAGAIN;
+    } else if (ret != 0) {
+        return ret;
+    }
+
+    if (header[0] < SSS_NSS_HEADER_SIZE) {
+        return EBADMSG;
+    }
+
+    len = header[0] - SSS_NSS_HEADER_SIZE;
+    if (len > 0) {
+        buf = malloc(len);
+        if (buf == NULL) {
+            return ENOMEM;
+        }
+
+        /* the rest of the reply follows the header immediately */
+        ret = sss_cli_fd_read(sd, buf, len, SSS_CLI_SOCKET_TIMEOUT, NULL);
+        if (ret != 0) {
+            free(buf);
+            return ret;
+        }
+    }
+
+    *_buf = buf;
+    *_len = len;
+    return 0;
+}
+
+static void sss_cli_mux_close_locked(int error)
+{
+    struct sss_cli_mux_req *req;
+
+    for (req = sss_cli_mux.pending; req != NULL; req = req->next) {
+        if (!req->done) {
+            req->done = true;
+            req->status = SSS_STATUS_UNAVAIL;
+            req->errnop = error;
+        }
+    }
+
+    if (sss_cli_mux.sd != -1) {
+        if (sss_cli_mux.reading) {
+            /* wake up the reader, it closes the socket */
+            shutdown(sss_cli_mux.sd, SHUT_RDWR);
+            sss_cli_mux.broken = true;
+        } else {
+            close(sss_cli_mux.sd);
+            sss_cli_mux.sd = -1;
+            sss_cli_mux.broken = false;
+        }
+    }
+
+    pthread_cond_broadcast(&sss_cli_mux.cond);
+}
+
+static void sss_cli_mux_deliver_locked(uint32_t header[4],
+                                       uint8_t *buf, size_t len)
+{
+    struct sss_cli_mux_req *req;
+
+    for (req = sss_cli_mux.pending; req != NULL; req = req->next) {
+        if (req->id == header[3]) {
+            break;
+        }
+    }
+
+    if (req == NULL || req->done) {
+        /* the thread waiting for this reply gave up already */
+        free(buf);
+        return;
+    }
+
+    req->done = true;
+    if (header[2] != 0) {
+        /* server side error */
+        req->errnop = header[2];
+        req->status = (header[2] == EAGAIN) ? SSS_STATUS_TRYAGAIN
+                                            : SSS_STATUS_UNAVAIL;
+        free(buf);
+    } else if (header[1] != req->cmd) {
+        req->errnop = EBADMSG;
+        req->status = SSS_STATUS_UNAVAIL;
+        free(buf);
+    } else {
+        req->status = SSS_STATUS_SUCCESS;
+        req->buf = buf;
+        req->len = len;
+    }
+}
+
+static uint32_t sss_cli_mux_new_id_locked(void)
+{
+    /* zero is what responders without support for ids send back */
+    sss_cli_mux.next_id++;
+    if (sss_cli_mux.next_id == 0) {
+        sss_cli_mux.next_id++;
+    }
+
+    return sss_cli_mux.next_id;
+}
+
+/* Checks the protocol version on a new NSS connection. Returns ENOTSUP if
+ * the responder did not echo the request id. */
+static int sss_cli_fd_check_version(int sd, uint32_t id, int timeout)
+{
+    uint32_t expected_version = SSS_NSS_PROTOCOL_VERSION;
+    uint32_t obtained_version;
+    struct sss_cli_req_data rd;
+    uint32_t header[4];
+    uint8_t *buf = NULL;
+    size_t len;
+    int ret;
+
+    rd.len = sizeof(expected_version);
+    rd.data = &expected_version;
+
+    ret = sss_cli_fd_send_req(sd, id, SSS_GET_VERSION, &rd, timeout);
+    if (ret == 0) {
+        ret = sss_cli_fd_recv_rep(sd, timeout, header, &buf, &len);
+        if (ret == EAGAIN) {
+            ret = ETIME;
+        }
+    }
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (header[3] != id) {
+        ret = ENOTSUP;
+    } else if (header[1] != SSS_GET_VERSION || header[2] != 0
+                   || len < sizeof(uint32_t)) {
+        ret = EBADMSG;
+    } else {
+        SAFEALIGN_COPY_UINT32(&obtained_version, buf, NULL);
+        ret = (obtained_version == expected_version) ? 0 : EFAULT;
+    }
+    free(buf);
+
+    return ret;
+}
+
+/* Forgets a connection inherited from the parent process, the descriptor is
+ * only closed if it still refers to the socket that was opened */
+static void sss_cli_fd_forget(int sd, const struct stat *sb)
+{
+    struct stat mysb;
+    int ret;
+
+    if (sd == -1) {
+        return;
+    }
+
+    ret = fstat(sd, &mysb);
+    if (ret == 0 && S_ISSOCK(mysb.st_mode)
+            && mysb.st_dev == sb->st_dev
+            && mysb.st_ino == sb->st_ino) {
+        close(sd);
+    }
+}
+
+static enum sss_status sss_cli_mux_connect_locked(int timeout, int *errnop)
+{
+    int sd;
+    int ret;
+
+    if (getpid() != sss_cli_mux.pid) {
+        /* the connection and requests of the parent are not ours */
+        sss_cli_fd_forget(sss_cli_mux.sd, &sss_cli_mux.sb);
+        sss_cli_mux.sd = -1;
+        sss_cli_mux.reading = false;
+        sss_cli_mux.broken = false;
+        sss_cli_mux.pending = NULL;
+        sss_cli_mux.pid = getpid();
+    }
+
+    if (sss_cli_mux.broken) {
+        *errnop = EPIPE;
+        return SSS_STATUS_UNAVAIL;
+    }
+
+    if (sss_cli_mux.sd != -1) {
+        return SSS_STATUS_SUCCESS;
+    }
+
+    if (sss_cli_mux.unsupported) {
+        *errnop = ENOTSUP;
+        return SSS_STATUS_UNAVAIL;
+    }
+
+    sd = sss_cli_open_socket(errnop, SSS_NSS_SOCKET_NAME, timeout,
+                             &sss_cli_mux.sb);
+    if (sd == -1) {
+        return SSS_STATUS_UNAVAIL;
+    }
+
+    /* nobody else knows about the socket yet, check the version and
+     * whether the responder echoes the request id */
+    ret = sss_cli_fd_check_version(sd, sss_cli_mux_new_id_locked(), timeout);
+    if (ret == ENOTSUP) {
+        sss_cli_mux.unsupported = true;
+    }
+    if (ret != 0) {
+        close(sd);
+        *errnop = ret;
+        return SSS_STATUS_UNAVAIL;
+    }
+
+    sss_cli_mux.sd = sd;
+    return SSS_STATUS_SUCCESS;
+}
+
+static int sss_cli_mux_remaining(const struct timespec *deadline)
+{
+    struct timespec now;
+    long ms;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    ms = (deadline->tv_sec - now.tv_sec) * 1000
+             + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+
+    return ms > 0 ? ms : 0;
+}
+
+static enum sss_status sss_cli_mux_request(enum sss_cli_command cmd,
+                                           struct sss_cli_req_data *rd,
+                                           int timeout,
+                                           uint8_t **repbuf, size_t *replen,
+                                           int *errnop)
+{
+    struct sss_cli_mux_req req = { 0 };
+    struct sss_cli_mux_req **iter;
+    struct timespec deadline;
+    uint32_t header[4];
+    uint8_t *buf;
+    size_t len;
+    int old_cancel_state;
+    int remaining;
+    int sd;
+    int ret;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (timeout % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&sss_cli_mux.mtx);
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancel_state);
+
+    req.status = sss_cli_mux_connect_locked(timeout, &req.errnop);
+    if (req.status != SSS_STATUS_SUCCESS) {
+        goto done;
+    }
+
+    req.id = sss_cli_mux_new_id_locked();
+    req.cmd = cmd;
+
+    ret = sss_cli_fd_send_req(sss_cli_mux.sd, req.id, cmd, rd, timeout);
+    if (ret != 0) {
+        sss_cli_mux_close_locked(ret);
+        req.status = SSS_STATUS_UNAVAIL;
+        req.errnop = ret;
+        goto done;
+    }
+
+    req.next = sss_cli_mux.pending;
+    sss_cli_mux.pending = &req;
+
+    while (!req.done) {
+        if (sss_cli_mux.reading) {
+            ret = pthread_cond_timedwait(&sss_cli_mux.cond, &sss_cli_mux.mtx,
+                                         &deadline);
+            if (ret == ETIMEDOUT && !req.done) {
+                req.done = true;
+                req.status = SSS_STATUS_UNAVAIL;
+                req.errnop = ETIME;
+            }
+            continue;
+        }
+
+        remaining = sss_cli_mux_remaining(&deadline);
+        if (remaining == 0) {
+            req.done = true;
+            req.status = SSS_STATUS_UNAVAIL;
+            req.errnop = ETIME;
+            break;
+        }
+
+        /* nobody reads the replies, do it while the others can send */
+        sss_cli_mux.reading = true;
+        sd = sss_cli_mux.sd;
+        pthread_mutex_unlock(&sss_cli_mux.mtx);
+
+        buf = NULL;
+        len = 0;
+        ret = sss_cli_fd_recv_rep(sd, remaining, header, &buf, &len);
+
+        pthread_mutex_lock(&sss_cli_mux.mtx);
+        sss_cli_mux.reading = false;
+
+        if (ret == 0 && !sss_cli_mux.broken) {
+            sss_cli_mux_deliver_locked(header, buf, len);
+            pthread_cond_broadcast(&sss_cli_mux.cond);
+        } else if (ret == EAGAIN && !sss_cli_mux.broken) {
+            /* our reply did not arrive in time, let another thread read */
+            if (!req.done) {
+                req.done = true;
+                req.status = SSS_STATUS_UNAVAIL;
+                req.errnop = ETIME;
+            }
+            pthread_cond_broadcast(&sss_cli_mux.cond);
+        } else {
+            free(buf);
+            sss_cli_mux_close_locked(ret != 0 ? ret : EPIPE);
+        }
+    }
+
+    for (iter = &sss_cli_mux.pending; *iter != NULL; iter = &(*iter)->next) {
+        if (*iter == &req) {
+            *iter = req.next;
+            break;
+        }
+    }
+
+done:
+    pthread_setcancelstate(old_cancel_state, NULL);
+    pthread_mutex_unlock(&sss_cli_mux.mtx);
+
+    *errnop = req.errnop;
+    if (req.status != SSS_STATUS_SUCCESS) {
+        return req.status;
+    }
+
+    if (repbuf && req.buf) {
+        *repbuf = req.buf;
+        if (replen) {
+            *replen = req.len;
+        }
+    } else {
+        free(req.buf);
+        if (replen) {
+            *replen = 0;
+        }
+    }
+
+    return SSS_STATUS_SUCCESS;
+}
+
+/* Per-thread NSS connections
+ *
+ * Processes that set SSS_NSS_THREAD_SOCKETS to "YES" give every thread its
+ * own connection to the NSS responder, kept in thread specific data and
+ * closed when the thread exits. Lookups sent on it skip sss_nss_lock(). */
+
+struct sss_cli_thread_conn {
+    int sd;
+    struct stat sb;
+    pid_t pid;
+};
+
+static pthread_key_t sss_cli_thread_key;
+static pthread_once_t sss_cli_thread_once = PTHREAD_ONCE_INIT;
+static bool sss_cli_thread_key_ok;
+
+static void sss_cli_thread_conn_free(void *ptr)
+{
+    struct sss_cli_thread_conn *conn = ptr;
+
+    if (conn->sd != -1 && conn->pid == getpid()) {
+        close(conn->sd);
+    }
+    free(conn);
+}
+
+static void sss_cli_thread_key_init(void)
+{
+    sss_cli_thread_key_ok = (pthread_key_create(&sss_cli_thread_key,
+                                                sss_cli_thread_conn_free) == 0);
+}
+
+static struct sss_cli_thread_conn *sss_cli_thread_conn_get(int *errnop)
+{
+    struct sss_cli_thread_conn *conn;
+
+    pthread_once(&sss_cli_thread_once, sss_cli_thread_key_init);
+    if (!sss_cli_thread_key_ok) {
+        *errnop = ENOTSUP;
+        return NULL;
+    }
+
+    conn = pthread_getspecific(sss_cli_thread_key);
+    if (conn == NULL) {
+        conn = calloc(1, sizeof(struct sss_cli_thread_conn));
+        if (conn == NULL) {
+            *errnop = ENOMEM;
+            return NULL;
+        }
+        conn->sd = -1;
+        conn->pid = getpid();
+
+        if (pthread_setspecific(sss_cli_thread_key, conn) != 0) {
+            free(conn);
+            *errnop = ENOTSUP;
+            return NULL;
+        }
+    }
+
+    if (conn->pid != getpid()) {
+        sss_cli_fd_forget(conn->sd, &conn->sb);
+        conn->sd = -1;
+        conn->pid = getpid();
+    }
+
+    return conn;
+}
+
+static void sss_cli_thread_conn_close(struct sss_cli_thread_conn *conn)
+{
+    if (conn->sd != -1) {
+        close(conn->sd);
+        conn->sd = -1;
+    }
+}
+
+static enum sss_status sss_cli_thread_request_once(
+                                       struct sss_cli_thread_conn *conn,
+                                       enum sss_cli_command cmd,
+                                       struct sss_cli_req_data *rd,
+                                       int timeout,
+                                       uint8_t **repbuf, size_t *replen,
+                                       int *errnop)
+{
+    uint32_t header[4];
+    uint8_t *buf = NULL;
+    size_t len = 0;
+    int ret;
+
+    if (conn->sd == -1) {
+        conn->sd = sss_cli_open_socket(errnop, SSS_NSS_SOCKET_NAME, timeout,
+                                       &conn->sb);
+        if (conn->sd == -1) {
+            return SSS_STATUS_UNAVAIL;
+        }
+
+        ret = sss_cli_fd_check_version(conn->sd, 0, timeout);
+        if (ret != 0) {
+            sss_cli_thread_conn_close(conn);
+            *errnop = ret;
+            return SSS_STATUS_UNAVAIL;
+        }
+    }
+
+    ret = sss_cli_fd_send_req(conn->sd, 0, cmd, rd, timeout);
+    if (ret == 0) {
+        ret = sss_cli_fd_recv_rep(conn->sd, timeout, header, &buf, &len);
+        if (ret == EAGAIN) {
+            ret = ETIME;
+        }
+    }
+    if (ret != 0) {
+        sss_cli_thread_conn_close(conn);
+        *errnop = ret;
+        return SSS_STATUS_UNAVAIL;
+    }
+
+    if (header[2] != 0) {
+        /* server side error */
+        free(buf);
+        *errnop = header[2];
+        return (header[2] == EAGAIN) ? SSS_STATUS_TRYAGAIN
+                                     : SSS_STATUS_UNAVAIL;
+    }
+
+    if (header[1] != cmd) {
+        free(buf);
+        sss_cli_thread_conn_close(conn);
+        *errnop = EBADMSG;
+        return SSS_STATUS_UNAVAIL;
+    }
+
+    *errnop = 0;
+    if (repbuf && buf) {
+        *repbuf = buf;
+        if (replen) {
+            *replen = len;
+        }
+    } else {
+        free(buf);
+        if (replen) {
+            *replen = 0;
+        }
+    }
+
+    return SSS_STATUS_SUCCESS;
+}
+
+static enum sss_status sss_cli_thread_request(enum sss_cli_command cmd,
+                                              struct sss_cli_req_data *rd,
+                                              int timeout,
+                                              uint8_t **repbuf,
+                                              size_t *replen,
+                                              int *errnop)
+{
+    struct sss_cli_thread_conn *conn;
+    enum sss_status ret;
+    bool reused;
+    int old_cancel_state;
+
+    conn = sss_cli_thread_conn_get(errnop);
+    if (conn == NULL) {
+        return SSS_STATUS_UNAVAIL;
+    }
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancel_state);
+
+    reused = (conn->sd != -1);
+    ret = sss_cli_thread_request_once(conn, cmd, rd, timeout,
+                                      repbuf, replen, errnop);
+    if (ret == SSS_STATUS_UNAVAIL && reused
+            && (*errnop == EPIPE || *errnop == ECONNRESET)) {
+        /* the responder might have closed the idle connection */
+        ret = sss_cli_thread_request_once(conn, cmd, rd, timeout,
+                                          repbuf, replen, errnop);
+    }
+
+    pthread_setcancelstate(old_cancel_state, NULL);
+
+    return ret;
+}
+
+static bool sss_cli_env_is_yes(const char *name)
+{
+    char *envval;
+
+    envval = getenv(name);
+    return envval != NULL && strcmp(envval, "YES") == 0;
+}
+
+static bool sss_cli_thread_sockets(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1) {
+        enabled = sss_cli_env_is_yes("SSS_NSS_THREAD_SOCKETS") ? 1 : 0;
+    }
+
+    return enabled == 1;
+}
+
+static bool sss_cli_multiplex(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1) {
+        enabled = sss_cli_env_is_yes("SSS_NSS_MULTIPLEX") ? 1 : 0;
+    }
+
+    return enabled == 1 && !sss_cli_mux.unsupported;
+}
+
+bool sss_nss_mux_enabled(void)
+{
+    return sss_cli_thread_sockets() || sss_cli_multiplex();
+}
+
+enum nss_status sss_nss_make_request_mux(enum sss_cli_command cmd,
+                                         struct sss_cli_req_data *rd,
+                                         uint8_t **repbuf, size_t *replen,
+                                         int *errnop)
+{
+    enum nss_status nret;
+    enum sss_status ret;
+    char *envval;
+
+    /* avoid looping in the nss daemon */
+    envval = getenv("_SSS_LOOPS");
+    if (envval && strcmp(envval, "NO") == 0) {
+        return NSS_STATUS_NOTFOUND;
+    }
+
+    if (sss_cli_thread_sockets()) {
+        ret = sss_cli_thread_request(cmd, rd, SSS_CLI_SOCKET_TIMEOUT,
+                                     repbuf, replen, errnop);
+    } else {
+        ret = sss_cli_mux_request(cmd, rd, SSS_CLI_SOCKET_TIMEOUT,
+                                  repbuf, replen, errnop);
+    }
+    if (ret == SSS_STATUS_UNAVAIL && (*errnop == ENOTSUP || *errnop == EPIPE)) {
+        /* fall back to the serialized connection */
+        sss_nss_lock();
+        nret = sss_nss_make_request(cmd, rd, repbuf, replen, errnop);
+        sss_nss_unlock();
+        return nret;
+    }
+
+    switch (ret) {
+    case SSS_STATUS_TRYAGAIN:
+        return NSS_STATUS_TRYAGAIN;
+    case SSS_STATUS_SUCCESS:
+        return NSS_STATUS_SUCCESS;
+    case SSS_STATUS_UNAVAIL:
+    default:
+#ifdef NONSTANDARD_SSS_NSS_BEHAVIOUR
+        *errnop = 0;
+        errno = 0;
+        return NSS_STATUS_NOTFOUND;
+#else
+        return NSS_STATUS_UNAVAIL;
+#endif
+    }
+}
+
+#else /* HAVE_PTHREAD */
+
+bool sss_nss_mux_enabled(void)
+{
+    return false;
+}
+
+enum nss_status sss_nss_make_request_mux(enum sss_cli_command cmd,
+                                         struct sss_cli_req_data *rd,
+                                         uint8_t **repbuf, size_t *replen,
+                                         int *errnop)
+{
+    return sss_nss_make_request(cmd, rd, repbuf, replen, errnop);
+}
+
+#endif /* HAVE_PTHREAD */
+
+/* Replies kept for a retry with a larger buffer. glibc grows the buffer and
+ * calls the lookup again right away, an older reply belongs to a caller that
+ * gave up and is not used. */
+#define SSS_NSS_RETRY_REPLY_TIMEOUT 5
+
+struct sss_nss_retry_reply {
+    enum sss_cli_command cmd;
+    uint8_t *key;
+    size_t key_len;
+    uint8_t *repbuf;
+    size_t replen;
+    time_t stamp;
+};
+
+static void sss_nss_retry_reply_clean(struct sss_nss_retry_reply *rr)
+{
+    free(rr->key);
+    free(rr->repbuf);
+    memset(rr, 0, sizeof(struct sss_nss_retry_reply));
+}
+
+#if HAVE_PTHREAD
+
+static pthread_key_t sss_nss_retry_key;
+static pthread_once_t sss_nss_retry_once = PTHREAD_ONCE_INIT;
+static bool sss_nss_retry_key_ok;
+
+static void sss_nss_retry_reply_free(void *ptr)
+{
+    sss_nss_retry_reply_clean(ptr);
+    free(ptr);
+}
+
+static void sss_nss_retry_key_init(void)
+{
+    sss_nss_retry_key_ok = (pthread_key_create(&sss_nss_retry_key,
+                                               sss_nss_retry_reply_free) == 0);
+}
+
+static struct sss_nss_retry_reply *sss_nss_retry_reply_get(bool create)
+{
+    struct sss_nss_retry_reply *rr;
+
+    pthread_once(&sss_nss_retry_once, sss_nss_retry_key_init);
+    if (!sss_nss_retry_key_ok) {
+        return NULL;
+    }
+
+    rr = pthread_getspecific(sss_nss_retry_key);
+    if (rr == NULL && create) {
+        rr = calloc(1, sizeof(struct sss_nss_retry_reply));
+        if (rr == NULL) {
+            return NULL;
+        }
+
+        if (pthread_setspecific(sss_nss_retry_key, rr) != 0) {
+            free(rr);
+            return NULL;
+        }
+    }
+
+    return rr;
+}
+
+#else /* HAVE_PTHREAD */
+
+static struct sss_nss_retry_reply *sss_nss_retry_reply_get(bool create)
+{
+    static struct sss_nss_retry_reply rr;
+
+    return &rr;
+}
+
+#endif /* HAVE_PTHREAD */
+
+void sss_nss_save_retry_reply(enum sss_cli_command cmd,
+                              struct sss_cli_req_data *rd,
+                              uint8_t **repbuf, size_t replen)
+{
+    struct sss_nss_retry_reply *rr;
+
+    rr = sss_nss_retry_reply_get(true);
+    if (rr == NULL) {
+        goto done;
+    }
+
+    sss_nss_retry_reply_clean(rr);
+
+    rr->key = malloc(rd->len);
+    if (rr->key == NULL) {
+        goto done;
+    }
+    memcpy(rr->key, rd->data, rd->len);
+
+    rr->cmd = cmd;
+    rr->key_len = rd->len;
+    rr->repbuf = *repbuf;
+    rr->replen = replen;
+    rr->stamp = time(NULL);
+    *repbuf = NULL;
+
+done:
+    free(*repbuf);
+    *repbuf = NULL;
+}
+
+bool sss_nss_get_retry_reply(enum sss_cli_command cmd,
+                             struct sss_cli_req_data *rd,
+                             uint8_t **repbuf, size_t *replen)
+{
+    struct sss_nss_retry_reply *rr;
+    bool found = false;
+
+    rr = sss_nss_retry_reply_get(false);
+    if (rr == NULL || rr->repbuf == NULL) {
+        return false;
+    }
+
+    if (rr->cmd == cmd
+            && rr->key_len == rd->len
+            && memcmp(rr->key, rd->data, rd->len) == 0
+            && time(NULL) - rr->stamp < SSS_NSS_RETRY_REPLY_TIMEOUT) {
+        *repbuf = rr->repbuf;
+        *replen = rr->replen;
+        rr->repbuf = NULL;
+        found = true;
+    }
+
+    /* a reply is used at most once, whether it matched or not */
+    sss_nss_retry_reply_clean(rr);
+    return found;
+}
+
 int sss_pac_check_and_open(void)
 {
     enum sss_status ret;
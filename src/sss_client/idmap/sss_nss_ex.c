@@ -23,6 +23,7 @@
 */
 #include <stdlib.h>
 #include <errno.h>
+#include <string.h>
 
 #include <sys/param.h> /* for MIN() */
 
@@ -529,3 +530,439 @@ int sss_nss_getgrouplist_timeout(const char *name, gid_t group,
 
     return ret;
 }
+
+static size_t sss_nss_str_used(const char *str, const char *buffer)
+{
+    if (str == NULL) {
+        return 0;
+    }
+
+    return (str - buffer) + strlen(str) + 1;
+}
+
+/* Returns the number of bytes of buffer used by the last parsed entry. */
+static size_t sss_nss_multi_used(struct passwd *pwd, struct group *grp,
+                                 const char *buffer)
+{
+    size_t used = 0;
+    size_t c;
+
+    if (pwd != NULL) {
+        used = MAX(used, sss_nss_str_used(pwd->pw_name, buffer));
+        used = MAX(used, sss_nss_str_used(pwd->pw_passwd, buffer));
+        used = MAX(used, sss_nss_str_used(pwd->pw_gecos, buffer));
+        used = MAX(used, sss_nss_str_used(pwd->pw_dir, buffer));
+        used = MAX(used, sss_nss_str_used(pwd->pw_shell, buffer));
+        return used;
+    }
+
+    used = MAX(used, sss_nss_str_used(grp->gr_name, buffer));
+    used = MAX(used, sss_nss_str_used(grp->gr_passwd, buffer));
+    for (c = 0; grp->gr_mem[c] != NULL; c++) {
+        used = MAX(used, sss_nss_str_used(grp->gr_mem[c], buffer));
+    }
+    used = MAX(used, (size_t)((char *)&grp->gr_mem[c + 1] - buffer));
+
+    return used;
+}
+
+/* All entries are requested with a single request, the memory cache is not
+ * used. The parsed entries share buffer. */
+static int sss_get_multi(enum sss_cli_command cmd,
+                         struct sss_cli_req_data *rd,
+                         size_t count,
+                         struct passwd *pwds,
+                         struct group *grps,
+                         char *buffer, size_t buflen,
+                         int *errs,
+                         unsigned int timeout)
+{
+    struct sss_nss_pw_rep pwrep;
+    struct sss_nss_gr_rep grrep;
+    uint8_t *repbuf = NULL;
+    size_t replen;
+    size_t idx;
+    size_t len;
+    size_t used;
+    size_t pos = 0;
+    uint32_t num_entries;
+    uint32_t num_results;
+    uint32_t entry_len;
+    size_t c;
+    int time_left;
+    int errnop;
+    int ret;
+
+    ret = sss_nss_timedlock(timeout, &time_left);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = sss_nss_make_request_timeout(cmd, rd, time_left,
+                                       &repbuf, &replen, &errnop);
+    if (ret != NSS_STATUS_SUCCESS) {
+        ret = errnop != 0 ? errnop : EIO;
+        goto out;
+    }
+
+    if (replen < 2 * sizeof(uint32_t)) {
+        ret = EBADMSG;
+        goto out;
+    }
+
+    SAFEALIGN_COPY_UINT32(&num_entries, repbuf, NULL);
+    if (num_entries != count) {
+        ret = EBADMSG;
+        goto out;
+    }
+
+    idx = 2 * sizeof(uint32_t);
+    for (c = 0; c < count; c++) {
+        if (replen - idx < sizeof(uint32_t)) {
+            ret = EBADMSG;
+            goto out;
+        }
+        SAFEALIGN_COPY_UINT32(&entry_len, repbuf + idx, &idx);
+        if (replen - idx < entry_len) {
+            ret = EBADMSG;
+            goto out;
+        }
+
+        if (entry_len == 0) {
+            errs[c] = ENOENT;
+            continue;
+        }
+
+        if (entry_len < 2 * sizeof(uint32_t)) {
+            ret = EBADMSG;
+            goto out;
+        }
+
+        SAFEALIGN_COPY_UINT32(&num_results, repbuf + idx, NULL);
+        if (num_results == 0) {
+            errs[c] = ENOENT;
+            idx += entry_len;
+            continue;
+        }
+
+        /* only 1 result is accepted for each entry */
+        if (num_results != 1) {
+            ret = EBADMSG;
+            goto out;
+        }
+
+        /* Make sure every entry starts aligned to sizeof(char *) */
+        pos += PADDING_SIZE(pos, char *);
+        if (pos >= buflen) {
+            ret = ERANGE;
+            goto out;
+        }
+
+        len = entry_len - 2 * sizeof(uint32_t);
+        if (pwds != NULL) {
+            pwrep.result = &pwds[c];
+            pwrep.buffer = buffer + pos;
+            pwrep.buflen = buflen - pos;
+            ret = sss_nss_getpw_readrep(&pwrep,
+                                        repbuf + idx + 2 * sizeof(uint32_t),
+                                        &len);
+            used = ret == 0 ? sss_nss_multi_used(&pwds[c], NULL, pwrep.buffer)
+                            : 0;
+        } else {
+            grrep.result = &grps[c];
+            grrep.buffer = buffer + pos;
+            grrep.buflen = buflen - pos;
+            ret = sss_nss_getgr_readrep(&grrep,
+                                        repbuf + idx + 2 * sizeof(uint32_t),
+                                        &len);
+            used = ret == 0 ? sss_nss_multi_used(NULL, &grps[c], grrep.buffer)
+                            : 0;
+        }
+        if (ret != 0) {
+            goto out;
+        }
+
+        errs[c] = 0;
+        pos += used;
+        idx += entry_len;
+    }
+
+    ret = 0;
+
+out:
+    free(repbuf);
+
+    sss_nss_unlock();
+    return ret;
+}
+
+int sss_nss_make_id_list_req_data(const uint32_t *ids, size_t count,
+                                  struct sss_cli_req_data *rd)
+{
+    uint8_t *data;
+    uint32_t num;
+    size_t rp = 0;
+    size_t c;
+
+    if (ids == NULL || count == 0 || count > SSS_NSS_MULTI_MAX_ENTRIES) {
+        return EINVAL;
+    }
+
+    data = malloc((count + 1) * sizeof(uint32_t));
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    num = count;
+    SAFEALIGN_COPY_UINT32(data, &num, &rp);
+    for (c = 0; c < count; c++) {
+        SAFEALIGN_COPY_UINT32(data + rp, &ids[c], &rp);
+    }
+
+    rd->len = rp;
+    rd->data = data;
+
+    return 0;
+}
+
+int sss_nss_make_name_list_req_data(const char **names, size_t count,
+                                    struct sss_cli_req_data *rd)
+{
+    size_t len = sizeof(uint32_t);
+    size_t name_len;
+    size_t rp = 0;
+    uint8_t *data;
+    uint32_t num;
+    size_t c;
+    int ret;
+
+    if (names == NULL || count == 0 || count > SSS_NSS_MULTI_MAX_ENTRIES) {
+        return EINVAL;
+    }
+
+    for (c = 0; c < count; c++) {
+        if (names[c] == NULL) {
+            return EINVAL;
+        }
+
+        ret = sss_strnlen(names[c], SSS_NAME_MAX, &name_len);
+        if (ret != 0) {
+            return ret;
+        }
+        len += name_len + 1;
+    }
+
+    data = malloc(len);
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    num = count;
+    SAFEALIGN_COPY_UINT32(data, &num, &rp);
+    for (c = 0; c < count; c++) {
+        name_len = strlen(names[c]) + 1;
+        memcpy(data + rp, names[c], name_len);
+        rp += name_len;
+    }
+
+    rd->len = len;
+    rd->data = data;
+
+    return 0;
+}
+
+int sss_nss_getpwnam_multi(const char **names, size_t count,
+                           struct passwd *pwds,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout)
+{
+    struct sss_cli_req_data rd;
+    int ret;
+
+    if (pwds == NULL || errs == NULL) {
+        return EINVAL;
+    }
+
+    ret = sss_nss_make_name_list_req_data(names, count, &rd);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = sss_get_multi(SSS_NSS_GETPWNAM_MULTI, &rd, count, pwds, NULL,
+                        buffer, buflen, errs, timeout);
+    free(discard_const(rd.data));
+
+    return ret;
+}
+
+int sss_nss_getpwuid_multi(const uid_t *uids, size_t count,
+                           struct passwd *pwds,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout)
+{
+    struct sss_cli_req_data rd;
+    int ret;
+
+    if (pwds == NULL || errs == NULL) {
+        return EINVAL;
+    }
+
+    ret = sss_nss_make_id_list_req_data((const uint32_t *)uids, count, &rd);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = sss_get_multi(SSS_NSS_GETPWUID_MULTI, &rd, count, pwds, NULL,
+                        buffer, buflen, errs, timeout);
+    free(discard_const(rd.data));
+
+    return ret;
+}
+
+int sss_nss_getgrnam_multi(const char **names, size_t count,
+                           struct group *grps,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout)
+{
+    struct sss_cli_req_data rd;
+    int ret;
+
+    if (grps == NULL || errs == NULL) {
+        return EINVAL;
+    }
+
+    ret = sss_nss_make_name_list_req_data(names, count, &rd);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = sss_get_multi(SSS_NSS_GETGRNAM_MULTI, &rd, count, NULL, grps,
+                        buffer, buflen, errs, timeout);
+    free(discard_const(rd.data));
+
+    return ret;
+}
+
+int sss_nss_getgrgid_multi(const gid_t *gids, size_t count,
+                           struct group *grps,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout)
+{
+    struct sss_cli_req_data rd;
+    int ret;
+
+    if (grps == NULL || errs == NULL) {
+        return EINVAL;
+    }
+
+    ret = sss_nss_make_id_list_req_data((const uint32_t *)gids, count, &rd);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = sss_get_multi(SSS_NSS_GETGRGID_MULTI, &rd, count, NULL, grps,
+                        buffer, buflen, errs, timeout);
+    free(discard_const(rd.data));
+
+    return ret;
+}
+
+int sss_nss_innetgr_timeout(const char *netgroup, const char *host,
+                            const char *user, const char *domain,
+                            unsigned int timeout, int *_is_member)
+{
+    const char *fields[4];
+    size_t lens[4];
+    struct sss_cli_req_data rd;
+    uint8_t *data;
+    uint8_t *repbuf = NULL;
+    size_t replen;
+    size_t pos;
+    size_t c;
+    uint32_t mask = 0;
+    uint32_t num_results;
+    uint32_t is_member;
+    int time_left;
+    int errnop;
+    int ret;
+
+    if (netgroup == NULL || *netgroup == '\0' || _is_member == NULL) {
+        return EINVAL;
+    }
+
+    if (host != NULL) {
+        mask |= SSS_INNETGR_HOST;
+    }
+    if (user != NULL) {
+        mask |= SSS_INNETGR_USER;
+    }
+    if (domain != NULL) {
+        mask |= SSS_INNETGR_DOMAIN;
+    }
+
+    fields[0] = netgroup;
+    fields[1] = host == NULL ? "" : host;
+    fields[2] = user == NULL ? "" : user;
+    fields[3] = domain == NULL ? "" : domain;
+
+    rd.len = sizeof(uint32_t);
+    for (c = 0; c < 4; c++) {
+        lens[c] = strlen(fields[c]) + 1;
+        rd.len += lens[c];
+    }
+
+    data = malloc(rd.len);
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    pos = 0;
+    SAFEALIGN_COPY_UINT32(data, &mask, &pos);
+    for (c = 0; c < 4; c++) {
+        memcpy(data + pos, fields[c], lens[c]);
+        pos += lens[c];
+    }
+    rd.data = data;
+
+    ret = sss_nss_timedlock(timeout, &time_left);
+    if (ret != 0) {
+        free(data);
+        return ret;
+    }
+
+    ret = sss_nss_make_request_timeout(SSS_NSS_INNETGR, &rd, time_left,
+                                       &repbuf, &replen, &errnop);
+    if (ret != NSS_STATUS_SUCCESS) {
+        ret = errnop != 0 ? errnop : EIO;
+        goto out;
+    }
+
+    if (replen < 2 * sizeof(uint32_t)) {
+        ret = EBADMSG;
+        goto out;
+    }
+
+    SAFEALIGN_COPY_UINT32(&num_results, repbuf, NULL);
+    if (num_results == 0) {
+        /* No such netgroup. */
+        ret = ENOENT;
+        goto out;
+    }
+
+    if (num_results != 1 || replen < 3 * sizeof(uint32_t)) {
+        ret = EBADMSG;
+        goto out;
+    }
+
+    SAFEALIGN_COPY_UINT32(&is_member, repbuf + 2 * sizeof(uint32_t), NULL);
+    *_is_member = is_member != 0 ? 1 : 0;
+
+    ret = 0;
+
+out:
+    free(repbuf);
+    free(data);
+
+    sss_nss_unlock();
+    return ret;
+}
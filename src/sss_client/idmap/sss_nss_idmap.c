@@ -22,19 +22,27 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <nss.h>
+#include <sys/param.h> /* for MIN() */
 
 #include "sss_client/sss_cli.h"
 #include "sss_client/idmap/sss_nss_idmap.h"
 #include "sss_client/idmap/sss_nss_idmap_private.h"
+#include "sss_client/nss_mc.h"
+#include "util/mmap_cache.h"
 #include "util/strtonum.h"
 
 #define DATA_START (3 * sizeof(uint32_t))
 #define LIST_START (2 * sizeof(uint32_t))
 #define NO_TIMEOUT ((unsigned int) -1)
 
+#ifndef discard_const
+#define discard_const(ptr) ((void *)((uintptr_t)(ptr)))
+#endif
+
 union input {
     const char *str;
     uint32_t id;
@@ -201,6 +209,85 @@ done:
     return ret;
 }
 
+/* Returns EOK and fills out if the memory cache has an answer */
+static int sss_nss_mc_getyyybyxxx(union input inp, enum sss_cli_command cmd,
+                                  struct output *out)
+{
+    char key[32];
+    const char *key_fmt;
+    size_t key_len;
+    uint32_t type;
+    uint32_t id;
+    int ret;
+
+    switch (cmd) {
+    case SSS_NSS_GETSIDBYNAME:
+        ret = sss_strnlen(inp.str, 2048, &key_len);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = sss_nss_mc_get_sid(inp.str, key_len, true,
+                                 &out->d.str, NULL, NULL, &type);
+        break;
+    case SSS_NSS_GETNAMEBYSID:
+        ret = sss_strnlen(inp.str, 2048, &key_len);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = sss_nss_mc_get_sid(inp.str, key_len, false,
+                                 NULL, &out->d.str, NULL, &type);
+        break;
+    case SSS_NSS_GETIDBYSID:
+        ret = sss_strnlen(inp.str, 2048, &key_len);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = sss_nss_mc_get_sid(inp.str, key_len, false,
+                                 NULL, NULL, &id, &type);
+        if (ret == EOK && id == 0) {
+            /* the object does not have a POSIX ID, let the responder
+             * return the proper error */
+            ret = ENOENT;
+        }
+        if (ret == EOK) {
+            out->d.id = id;
+        }
+        break;
+    case SSS_NSS_GETSIDBYID:
+    case SSS_NSS_GETSIDBYUID:
+    case SSS_NSS_GETSIDBYGID:
+        if (cmd == SSS_NSS_GETSIDBYUID) {
+            key_fmt = MC_SID_BY_UID_KEY;
+        } else if (cmd == SSS_NSS_GETSIDBYGID) {
+            key_fmt = MC_SID_BY_GID_KEY;
+        } else {
+            key_fmt = MC_SID_BY_ID_KEY;
+        }
+
+        ret = snprintf(key, sizeof(key), key_fmt, inp.id);
+        if (ret < 0 || ret >= sizeof(key)) {
+            return EINVAL;
+        }
+        key_len = ret;
+
+        ret = sss_nss_mc_get_sid(key, key_len, false,
+                                 &out->d.str, NULL, NULL, &type);
+        break;
+    default:
+        /* not handled by the memory cache */
+        return ENOENT;
+    }
+
+    if (ret == EOK) {
+        out->type = type;
+    }
+
+    return ret;
+}
+
 static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd,
                                unsigned int timeout, struct output *out)
 {
@@ -256,6 +343,11 @@ static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd,
         return EINVAL;
     }
 
+    ret = sss_nss_mc_getyyybyxxx(inp, cmd, out);
+    if (ret == EOK) {
+        return EOK;
+    }
+
     if (timeout == NO_TIMEOUT) {
         sss_nss_lock();
     } else {
@@ -528,6 +620,396 @@ int sss_nss_getidbysid(const char *sid, uint32_t *id, enum sss_id_type *id_type)
     return sss_nss_getidbysid_timeout(sid, NO_TIMEOUT, id, id_type);
 }
 
+/* Sends one *_MULTI request and reads the replies of the count entries
+ * listed in idx. */
+static int sss_nss_multi_request(enum sss_cli_command cmd,
+                                 struct sss_cli_req_data *rd,
+                                 unsigned int timeout,
+                                 const size_t *idx, size_t count,
+                                 struct output *out, int *errs)
+{
+    uint8_t *repbuf = NULL;
+    size_t replen;
+    size_t rp;
+    uint32_t num_entries;
+    uint32_t num_results;
+    uint32_t entry_len;
+    uint8_t *data;
+    size_t data_len;
+    struct output *o;
+    enum nss_status nret;
+    int time_left = SSS_CLI_SOCKET_TIMEOUT;
+    int errnop;
+    size_t c;
+    int ret;
+
+    if (timeout == NO_TIMEOUT) {
+        sss_nss_lock();
+    } else {
+        ret = sss_nss_timedlock(timeout, &time_left);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    nret = sss_nss_make_request_timeout(cmd, rd, time_left, &repbuf, &replen,
+                                        &errnop);
+    if (nret != NSS_STATUS_SUCCESS) {
+        ret = nss_status_to_errno(nret);
+        goto done;
+    }
+
+    if (replen < LIST_START) {
+        ret = EBADMSG;
+        goto done;
+    }
+
+    SAFEALIGN_COPY_UINT32(&num_entries, repbuf, NULL);
+    if (num_entries != count) {
+        ret = EBADMSG;
+        goto done;
+    }
+
+    rp = LIST_START;
+    for (c = 0; c < count; c++) {
+        o = &out[idx[c]];
+
+        if (replen - rp < sizeof(uint32_t)) {
+            ret = EBADMSG;
+            goto done;
+        }
+        SAFEALIGN_COPY_UINT32(&entry_len, repbuf + rp, &rp);
+        if (replen - rp < entry_len) {
+            ret = EBADMSG;
+            goto done;
+        }
+
+        if (entry_len == 0) {
+            errs[idx[c]] = ENOENT;
+            continue;
+        }
+
+        if (entry_len < DATA_START) {
+            ret = EBADMSG;
+            goto done;
+        }
+
+        SAFEALIGN_COPY_UINT32(&num_results, repbuf + rp, NULL);
+        if (num_results == 0) {
+            errs[idx[c]] = ENOENT;
+            rp += entry_len;
+            continue;
+        } else if (num_results > 1) {
+            ret = EBADMSG;
+            goto done;
+        }
+
+        SAFEALIGN_COPY_UINT32(&o->type, repbuf + rp + 2 * sizeof(uint32_t),
+                              NULL);
+
+        data = repbuf + rp + DATA_START;
+        data_len = entry_len - DATA_START;
+
+        if (cmd == SSS_NSS_GETIDBYSID_MULTI) {
+            if (data_len != sizeof(uint32_t)) {
+                ret = EBADMSG;
+                goto done;
+            }
+
+            SAFEALIGN_COPY_UINT32(&o->d.id, data, NULL);
+        } else {
+            if (data_len <= 1 || data[data_len - 1] != '\0') {
+                ret = EBADMSG;
+                goto done;
+            }
+
+            o->d.str = strdup((char *) data);
+            if (o->d.str == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+
+        errs[idx[c]] = 0;
+        rp += entry_len;
+    }
+
+    ret = 0;
+
+done:
+    sss_nss_unlock();
+    free(repbuf);
+
+    return ret;
+}
+
+/* The num entries of inp listed in idx are first looked up in the memory
+ * cache, only the missing ones are requested from SSSD with as few *_MULTI
+ * requests as possible. */
+static int sss_nss_getyyybyxxx_multi(enum sss_cli_command cmd,
+                                     const union input *inp,
+                                     const size_t *idx, size_t num,
+                                     unsigned int timeout,
+                                     struct output *out, int *errs)
+{
+    enum sss_cli_command multi_cmd;
+    struct sss_cli_req_data rd;
+    const char **strs = NULL;
+    uint32_t *ids = NULL;
+    size_t *missing = NULL;
+    size_t num_missing = 0;
+    size_t start;
+    size_t n;
+    size_t c;
+    int ret;
+
+    switch (cmd) {
+    case SSS_NSS_GETIDBYSID:
+        multi_cmd = SSS_NSS_GETIDBYSID_MULTI;
+        break;
+    case SSS_NSS_GETSIDBYID:
+        multi_cmd = SSS_NSS_GETSIDBYID_MULTI;
+        break;
+    case SSS_NSS_GETSIDBYUID:
+        multi_cmd = SSS_NSS_GETSIDBYUID_MULTI;
+        break;
+    case SSS_NSS_GETSIDBYGID:
+        multi_cmd = SSS_NSS_GETSIDBYGID_MULTI;
+        break;
+    default:
+        return EINVAL;
+    }
+
+    if (num == 0) {
+        return 0;
+    }
+
+    missing = malloc(num * sizeof(size_t));
+    if (missing == NULL) {
+        return ENOMEM;
+    }
+
+    for (c = 0; c < num; c++) {
+        ret = sss_nss_mc_getyyybyxxx(inp[idx[c]], cmd, &out[idx[c]]);
+        if (ret == EOK) {
+            errs[idx[c]] = 0;
+        } else {
+            missing[num_missing++] = idx[c];
+        }
+    }
+
+    if (num_missing == 0) {
+        ret = 0;
+        goto done;
+    }
+
+    n = MIN(num_missing, SSS_NSS_MULTI_MAX_ENTRIES);
+    if (multi_cmd == SSS_NSS_GETIDBYSID_MULTI) {
+        strs = malloc(n * sizeof(char *));
+    } else {
+        ids = malloc(n * sizeof(uint32_t));
+    }
+    if (strs == NULL && ids == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (start = 0; start < num_missing; start += n) {
+        n = MIN(num_missing - start, SSS_NSS_MULTI_MAX_ENTRIES);
+
+        for (c = 0; c < n; c++) {
+            if (strs != NULL) {
+                strs[c] = inp[missing[start + c]].str;
+            } else {
+                ids[c] = inp[missing[start + c]].id;
+            }
+        }
+
+        if (strs != NULL) {
+            ret = sss_nss_make_name_list_req_data(strs, n, &rd);
+        } else {
+            ret = sss_nss_make_id_list_req_data(ids, n, &rd);
+        }
+        if (ret != 0) {
+            goto done;
+        }
+
+        ret = sss_nss_multi_request(multi_cmd, &rd, timeout,
+                                    missing + start, n, out, errs);
+        free(discard_const(rd.data));
+        if (ret != 0) {
+            goto done;
+        }
+    }
+
+    ret = 0;
+
+done:
+    free(missing);
+    free(strs);
+    free(ids);
+
+    return ret;
+}
+
+int sss_nss_getidsbysids_timeout(const char **sids, size_t count,
+                                 unsigned int timeout,
+                                 uint32_t *ids, enum sss_id_type *id_types,
+                                 int *errs)
+{
+    union input *inp = NULL;
+    struct output *out = NULL;
+    size_t *idx = NULL;
+    size_t c;
+    int ret;
+
+    if (sids == NULL || count == 0 || ids == NULL || id_types == NULL
+            || errs == NULL) {
+        return EINVAL;
+    }
+
+    for (c = 0; c < count; c++) {
+        if (sids[c] == NULL || *sids[c] == '\0') {
+            return EINVAL;
+        }
+    }
+
+    inp = calloc(count, sizeof(union input));
+    out = calloc(count, sizeof(struct output));
+    idx = calloc(count, sizeof(size_t));
+    if (inp == NULL || out == NULL || idx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (c = 0; c < count; c++) {
+        inp[c].str = sids[c];
+        idx[c] = c;
+        errs[c] = ENOENT;
+    }
+
+    ret = sss_nss_getyyybyxxx_multi(SSS_NSS_GETIDBYSID, inp, idx, count,
+                                    timeout, out, errs);
+    if (ret != 0) {
+        goto done;
+    }
+
+    for (c = 0; c < count; c++) {
+        if (errs[c] == 0) {
+            ids[c] = out[c].d.id;
+            id_types[c] = out[c].type;
+        }
+    }
+
+done:
+    free(inp);
+    free(out);
+    free(idx);
+
+    return ret;
+}
+
+int sss_nss_getidsbysids(const char **sids, size_t count,
+                         uint32_t *ids, enum sss_id_type *id_types,
+                         int *errs)
+{
+    return sss_nss_getidsbysids_timeout(sids, count, NO_TIMEOUT, ids,
+                                        id_types, errs);
+}
+
+static enum sss_cli_command sid_by_id_cmd(const enum sss_id_type *id_types,
+                                          size_t c)
+{
+    if (id_types != NULL && id_types[c] == SSS_ID_TYPE_UID) {
+        return SSS_NSS_GETSIDBYUID;
+    } else if (id_types != NULL && id_types[c] == SSS_ID_TYPE_GID) {
+        return SSS_NSS_GETSIDBYGID;
+    }
+
+    return SSS_NSS_GETSIDBYID;
+}
+
+int sss_nss_getsidsbyids_timeout(const uint32_t *ids,
+                                 const enum sss_id_type *id_types,
+                                 size_t count, unsigned int timeout,
+                                 char **sids, enum sss_id_type *sid_types,
+                                 int *errs)
+{
+    enum sss_cli_command cmds[] = { SSS_NSS_GETSIDBYID,
+                                    SSS_NSS_GETSIDBYUID,
+                                    SSS_NSS_GETSIDBYGID };
+    union input *inp = NULL;
+    struct output *out = NULL;
+    size_t *idx = NULL;
+    size_t num;
+    size_t c;
+    size_t i;
+    int ret;
+
+    if (ids == NULL || count == 0 || sids == NULL || sid_types == NULL
+            || errs == NULL) {
+        return EINVAL;
+    }
+
+    inp = calloc(count, sizeof(union input));
+    out = calloc(count, sizeof(struct output));
+    idx = calloc(count, sizeof(size_t));
+    if (inp == NULL || out == NULL || idx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (c = 0; c < count; c++) {
+        inp[c].id = ids[c];
+        errs[c] = ENOENT;
+    }
+
+    /* UIDs, GIDs and IDs of any type need different requests. */
+    for (i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+        num = 0;
+        for (c = 0; c < count; c++) {
+            if (sid_by_id_cmd(id_types, c) == cmds[i]) {
+                idx[num++] = c;
+            }
+        }
+
+        ret = sss_nss_getyyybyxxx_multi(cmds[i], inp, idx, num, timeout,
+                                        out, errs);
+        if (ret != 0) {
+            goto done;
+        }
+    }
+
+    for (c = 0; c < count; c++) {
+        sids[c] = errs[c] == 0 ? out[c].d.str : NULL;
+        if (errs[c] == 0) {
+            sid_types[c] = out[c].type;
+        }
+    }
+
+    ret = 0;
+
+done:
+    if (ret != 0 && out != NULL) {
+        for (c = 0; c < count; c++) {
+            free(out[c].d.str);
+        }
+    }
+    free(inp);
+    free(out);
+    free(idx);
+
+    return ret;
+}
+
+int sss_nss_getsidsbyids(const uint32_t *ids,
+                         const enum sss_id_type *id_types, size_t count,
+                         char **sids, enum sss_id_type *sid_types, int *errs)
+{
+    return sss_nss_getsidsbyids_timeout(ids, id_types, count, NO_TIMEOUT,
+                                        sids, sid_types, errs);
+}
+
 int sss_nss_getorigbyname_timeout(const char *fq_name, unsigned int timeout,
                                   struct sss_nss_kv **kv_list,
                                   enum sss_id_type *type)
@@ -131,6 +131,51 @@ int sss_nss_getnamebysid(const char *sid, char **fq_name,
 int sss_nss_getidbysid(const char *sid, uint32_t *id,
                        enum sss_id_type *id_type);
 
+/**
+ * @brief Return the POSIX IDs for several SIDs
+ *
+ * SIDs which are not in the memory cache are looked up with a single
+ * request for up to 1024 SIDs.
+ *
+ * @param[in]  sids     array of string representations of SIDs
+ * @param[in]  count    number of elements of sids
+ * @param[out] ids      array of count POSIX IDs related to the SIDs
+ * @param[out] id_types array of count types of the objects related to the
+ *                      SIDs
+ * @param[out] errs     array of count ints, set to 0 if the SID was found
+ *                      and to ENOENT if not
+ *
+ * @return
+ *  - 0:      the lookup was done, see errs for the individual results
+ *  - EINVAL: invalid input
+ *  - ENOMEM: memory allocation failed
+ */
+int sss_nss_getidsbysids(const char **sids, size_t count,
+                         uint32_t *ids, enum sss_id_type *id_types,
+                         int *errs);
+
+/**
+ * @brief Return the SIDs for several POSIX IDs
+ *
+ * @param[in]  ids       array of POSIX IDs
+ * @param[in]  id_types  array of count types of the IDs, SSS_ID_TYPE_UID
+ *                       and SSS_ID_TYPE_GID select users or groups, other
+ *                       types or NULL for all IDs mean any object
+ * @param[in]  count     number of elements of ids
+ * @param[out] sids      array of count string representations of the SIDs,
+ *                       the found ones must be freed by the caller
+ * @param[out] sid_types array of count types of the objects related to the
+ *                       IDs
+ * @param[out] errs      array of count ints, set to 0 if the ID was found
+ *                       and to ENOENT if not
+ *
+ * @return
+ *  - see #sss_nss_getidsbysids
+ */
+int sss_nss_getsidsbyids(const uint32_t *ids,
+                         const enum sss_id_type *id_types, size_t count,
+                         char **sids, enum sss_id_type *sid_types, int *errs);
+
 /**
  * @brief Find original data by fully qualified name
  *
@@ -426,6 +471,29 @@ int sss_nss_getnamebysid_timeout(const char *sid, unsigned int timeout,
 int sss_nss_getidbysid_timeout(const char *sid, unsigned int timeout,
                                uint32_t *id, enum sss_id_type *id_type);
 
+/**
+ * @brief Return the POSIX IDs for several SIDs with timeout
+ *
+ * See sss_nss_getidsbysids() for details, the timeout in milliseconds
+ * applies to every request sent to SSSD.
+ */
+int sss_nss_getidsbysids_timeout(const char **sids, size_t count,
+                                 unsigned int timeout,
+                                 uint32_t *ids, enum sss_id_type *id_types,
+                                 int *errs);
+
+/**
+ * @brief Return the SIDs for several POSIX IDs with timeout
+ *
+ * See sss_nss_getsidsbyids() for details, the timeout in milliseconds
+ * applies to every request sent to SSSD.
+ */
+int sss_nss_getsidsbyids_timeout(const uint32_t *ids,
+                                 const enum sss_id_type *id_types,
+                                 size_t count, unsigned int timeout,
+                                 char **sids, enum sss_id_type *sid_types,
+                                 int *errs);
+
 /**
  * @brief Find original data by fully qualified name with timeout
  *
@@ -483,5 +551,84 @@ int sss_nss_getnamebycert_timeout(const char *cert, unsigned int timeout,
 int sss_nss_getlistbycert_timeout(const char *cert, unsigned int timeout,
                                   char ***fq_name, enum sss_id_type **type);
 
+
+/**
+ * @brief Return user information for several user names with one request
+ *
+ * @param[in]  names      array of user names
+ * @param[in]  count      number of elements of names, at most 1024
+ * @param[out] pwds       array of count passwd structs
+ * @param[in]  buffer     buffer for the string data of all found users
+ * @param[in]  buflen     size of buffer
+ * @param[out] errs       array of count ints, set to 0 if the user was found
+ *                        and to ENOENT if not
+ * @param[in]  timeout    timeout in milliseconds
+ *
+ * The memory cache is not used, all users are looked up by SSSD.
+ *
+ * @return
+ *  - 0:         the lookup was done, see errs for the individual results
+ *  - ERANGE:    Insufficient buffer space supplied
+ *  - ETIME:     request timed out but was send to SSSD
+ *  - ETIMEDOUT: request timed out but was not send to SSSD
+ */
+int sss_nss_getpwnam_multi(const char **names, size_t count,
+                           struct passwd *pwds,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout);
+
+/**
+ * @brief Return user information for several UIDs with one request
+ *
+ * See sss_nss_getpwnam_multi() for details.
+ */
+int sss_nss_getpwuid_multi(const uid_t *uids, size_t count,
+                           struct passwd *pwds,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout);
+
+/**
+ * @brief Return group information for several group names with one request
+ *
+ * See sss_nss_getpwnam_multi() for details.
+ */
+int sss_nss_getgrnam_multi(const char **names, size_t count,
+                           struct group *grps,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout);
+
+/**
+ * @brief Return group information for several GIDs with one request
+ *
+ * See sss_nss_getpwnam_multi() for details.
+ */
+int sss_nss_getgrgid_multi(const gid_t *gids, size_t count,
+                           struct group *grps,
+                           char *buffer, size_t buflen,
+                           int *errs, unsigned int timeout);
+
+/**
+ * @brief Check if a triple is a member of a netgroup with timeout
+ *
+ * Unlike innetgr(3) the netgroup is not enumerated by the caller, SSSD
+ * checks the triple in the netgroup and its nested netgroups.
+ *
+ * @param[in]  netgroup   name of the netgroup
+ * @param[in]  host       host name or NULL to match any host
+ * @param[in]  user       user name or NULL to match any user
+ * @param[in]  domain     domain name or NULL to match any domain
+ * @param[in]  timeout    timeout in milliseconds
+ * @param[out] _is_member 1 if the triple is a member, 0 otherwise
+ *
+ * @return
+ *  - 0:         success
+ *  - ENOENT:    no netgroup with the given name found
+ *  - ETIME:     request timed out but was send to SSSD
+ *  - ETIMEDOUT: request timed out but was not send to SSSD
+ */
+int sss_nss_innetgr_timeout(const char *netgroup, const char *host,
+                            const char *user, const char *domain,
+                            unsigned int timeout, int *_is_member);
+
 #endif /* IPA_389DS_PLUGIN_HELPER_CALLS */
 #endif /* SSS_NSS_IDMAP_H_ */
@@ -25,6 +25,16 @@
 #ifndef SSS_NSS_IDMAP_PRIVATE_H_
 #define SSS_NSS_IDMAP_PRIVATE_H_
 
+struct sss_cli_req_data;
+
 int sss_nss_timedlock(unsigned int timeout_ms, int *time_left_ms);
 
+/* Request data of the *_MULTI requests, rd->data must be freed by the
+ * caller. */
+int sss_nss_make_id_list_req_data(const uint32_t *ids, size_t count,
+                                  struct sss_cli_req_data *rd);
+
+int sss_nss_make_name_list_req_data(const char **names, size_t count,
+                                    struct sss_cli_req_data *rd);
+
 #endif /* SSS_NSS_IDMAP_PRIVATE_H_ */
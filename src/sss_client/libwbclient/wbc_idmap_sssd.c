@@ -21,6 +21,8 @@
 
 /* Required Headers */
 
+#include <stdlib.h>
+#include <errno.h>
 #include "sss_client/idmap/sss_nss_idmap.h"
 
 #include "libwbclient.h"
@@ -160,71 +162,191 @@ wbcErr wbcAllocateGid(gid_t *pgid)
     WBC_SSSD_NOT_IMPLEMENTED;
 }
 
-/* Convert a list of SIDs */
+/* Convert a list of SIDs, all SIDs are looked up with a single request */
 wbcErr wbcSidsToUnixIds(const struct wbcDomainSid *sids, uint32_t num_sids,
             struct wbcUnixId *ids)
 {
     int ret;
-    char *sid_str;
-    uint32_t id;
-    enum sss_id_type type;
+    char **sid_strs = NULL;
+    size_t *pos = NULL;
+    uint32_t *sss_ids = NULL;
+    enum sss_id_type *types = NULL;
+    int *errs = NULL;
+    size_t num = 0;
     size_t c;
+    size_t i;
     wbcErr wbc_status;
 
     for (c = 0; c < num_sids; c++) {
-        type = SSS_ID_TYPE_NOT_SPECIFIED;
-        wbc_status = wbcSidToString(&sids[c], &sid_str);
+        ids[c].type = WBC_ID_TYPE_NOT_SPECIFIED;
+    }
+
+    if (num_sids == 0) {
+        return WBC_ERR_SUCCESS;
+    }
+
+    sid_strs = calloc(num_sids, sizeof(char *));
+    pos = calloc(num_sids, sizeof(size_t));
+    sss_ids = calloc(num_sids, sizeof(uint32_t));
+    types = calloc(num_sids, sizeof(enum sss_id_type));
+    errs = calloc(num_sids, sizeof(int));
+    if (sid_strs == NULL || pos == NULL || sss_ids == NULL || types == NULL
+            || errs == NULL) {
+        wbc_status = WBC_ERR_NO_MEMORY;
+        goto done;
+    }
+
+    /* SIDs which cannot be converted are not sent to SSSD */
+    for (c = 0; c < num_sids; c++) {
+        wbc_status = wbcSidToString(&sids[c], &sid_strs[num]);
         if (WBC_ERROR_IS_OK(wbc_status)) {
-            ret = sss_nss_getidbysid(sid_str, &id, &type);
-            wbcFreeMemory(sid_str);
-            if (ret != 0) {
-                type = SSS_ID_TYPE_NOT_SPECIFIED;
-            }
+            pos[num++] = c;
         }
+    }
+
+    wbc_status = WBC_ERR_SUCCESS;
+    if (num == 0) {
+        goto done;
+    }
+
+    ret = sss_nss_getidsbysids((const char **) sid_strs, num, sss_ids, types,
+                               errs);
+    if (ret == ENOMEM) {
+        wbc_status = WBC_ERR_NO_MEMORY;
+        goto done;
+    } else if (ret != 0) {
+        /* like a failed lookup of every single SID */
+        goto done;
+    }
 
-        switch (type) {
+    for (i = 0; i < num; i++) {
+        if (errs[i] != 0) {
+            continue;
+        }
+
+        c = pos[i];
+        switch (types[i]) {
         case SSS_ID_TYPE_UID:
             ids[c].type = WBC_ID_TYPE_UID;
-            ids[c].id.uid = (uid_t) id;
+            ids[c].id.uid = (uid_t) sss_ids[i];
             break;
         case SSS_ID_TYPE_GID:
             ids[c].type = WBC_ID_TYPE_GID;
-            ids[c].id.gid = (gid_t) id;
+            ids[c].id.gid = (gid_t) sss_ids[i];
             break;
         case SSS_ID_TYPE_BOTH:
             ids[c].type = WBC_ID_TYPE_BOTH;
-            ids[c].id.uid = (uid_t) id;
+            ids[c].id.uid = (uid_t) sss_ids[i];
             break;
         default:
             ids[c].type = WBC_ID_TYPE_NOT_SPECIFIED;
         }
     }
 
-    return WBC_ERR_SUCCESS;
+done:
+    if (sid_strs != NULL) {
+        for (i = 0; i < num; i++) {
+            wbcFreeMemory(sid_strs[i]);
+        }
+    }
+    free(sid_strs);
+    free(pos);
+    free(sss_ids);
+    free(types);
+    free(errs);
+
+    return wbc_status;
 }
 
+/* Convert a list of Unix IDs, all IDs are looked up with as few requests as
+ * possible */
 wbcErr wbcUnixIdsToSids(const struct wbcUnixId *ids, uint32_t num_ids,
                         struct wbcDomainSid *sids)
 {
+    int ret;
+    uint32_t *sss_ids = NULL;
+    enum sss_id_type *id_types = NULL;
+    size_t *pos = NULL;
+    char **sid_strs = NULL;
+    enum sss_id_type *sid_types = NULL;
+    int *errs = NULL;
+    size_t num = 0;
     size_t c;
+    size_t i;
     wbcErr wbc_status;
 
+    for (c = 0; c < num_ids; c++) {
+        sids[c] = (struct wbcDomainSid){ 0 };
+    }
+
+    if (num_ids == 0) {
+        return WBC_ERR_SUCCESS;
+    }
+
+    sss_ids = calloc(num_ids, sizeof(uint32_t));
+    id_types = calloc(num_ids, sizeof(enum sss_id_type));
+    pos = calloc(num_ids, sizeof(size_t));
+    sid_strs = calloc(num_ids, sizeof(char *));
+    sid_types = calloc(num_ids, sizeof(enum sss_id_type));
+    errs = calloc(num_ids, sizeof(int));
+    if (sss_ids == NULL || id_types == NULL || pos == NULL || sid_strs == NULL
+            || sid_types == NULL || errs == NULL) {
+        wbc_status = WBC_ERR_NO_MEMORY;
+        goto done;
+    }
+
+    /* Only UIDs and GIDs can be converted */
     for (c = 0; c < num_ids; c++) {
         switch (ids[c].type) {
         case WBC_ID_TYPE_UID:
-            wbc_status = wbcUidToSid(ids[c].id.uid, &sids[c]);
+            sss_ids[num] = ids[c].id.uid;
+            id_types[num] = SSS_ID_TYPE_UID;
             break;
         case WBC_ID_TYPE_GID:
-            wbc_status = wbcGidToSid(ids[c].id.gid, &sids[c]);
+            sss_ids[num] = ids[c].id.gid;
+            id_types[num] = SSS_ID_TYPE_GID;
             break;
         default:
-            wbc_status = WBC_ERR_INVALID_PARAM;
+            continue;
+        }
+        pos[num++] = c;
+    }
+
+    wbc_status = WBC_ERR_SUCCESS;
+    if (num == 0) {
+        goto done;
+    }
+
+    ret = sss_nss_getsidsbyids(sss_ids, id_types, num, sid_strs, sid_types,
+                               errs);
+    if (ret == ENOMEM) {
+        wbc_status = WBC_ERR_NO_MEMORY;
+        goto done;
+    } else if (ret != 0) {
+        goto done;
+    }
+
+    for (i = 0; i < num; i++) {
+        if (errs[i] != 0) {
+            continue;
         }
 
-        if (!WBC_ERROR_IS_OK(wbc_status)) {
-            sids[c] = (struct wbcDomainSid){ 0 };
-        };
+        /* The found object must have the requested type */
+        if (sid_types[i] == id_types[i] || sid_types[i] == SSS_ID_TYPE_BOTH) {
+            if (!WBC_ERROR_IS_OK(wbcStringToSid(sid_strs[i], &sids[pos[i]]))) {
+                sids[pos[i]] = (struct wbcDomainSid){ 0 };
+            }
+        }
+        free(sid_strs[i]);
     }
 
-    return WBC_ERR_SUCCESS;
+done:
+    free(sss_ids);
+    free(id_types);
+    free(pos);
+    free(sid_strs);
+    free(sid_types);
+    free(errs);
+
+    return wbc_status;
 }
@@ -27,6 +27,10 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
+#if HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include <nfsidmap.h>
 
@@ -39,24 +43,73 @@
 
 #include "sss_client/sss_cli.h"
 #include "sss_client/nss_mc.h"
+#include "shared/murmurhash3.h"
 
 
 /*. . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .*/
 #define PLUGIN_NAME                 "sss_nfs"
 #define CONF_SECTION                "sss_nfs"
 #define CONF_USE_MC                 "memcache"
+#define CONF_CACHE_TIMEOUT          "cache_timeout"
 #define REPLY_ID_OFFSET             (8)
 #define REPLY_NAME_OFFSET           (REPLY_ID_OFFSET + 8)
 #define BUF_LEN                     (4096)
 #define USE_MC_DEFAULT              true
+#define CACHE_TIMEOUT_DEFAULT       (60)
+#define CACHE_SIZE                  (256) /* must be a power of 2 */
 
 
 /*. . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .*/
 static char sss_nfs_plugin_name[]   = PLUGIN_NAME;
 static char nfs_conf_sect[]         = CONF_SECTION;
 static char nfs_conf_use_mc[]       = CONF_USE_MC;
+static char nfs_conf_cache_timeout[] = CONF_CACHE_TIMEOUT;
 
 static bool nfs_use_mc              = USE_MC_DEFAULT;
+static int nfs_cache_timeout        = CACHE_TIMEOUT_DEFAULT;
+
+
+/*. . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .*/
+/* In-process cache of recent translations
+ *
+ * rpc.idmapd asks for the same few names and IDs over and over again.
+ * Keeping the answers for a short time avoids both the memory cache
+ * lookup and, for entries which are not in the memory cache, the round
+ * trip to the NSS responder. Every table is direct mapped, a new entry
+ * simply replaces the one in its slot. */
+enum nfs_cache_table {
+    NFS_CACHE_UID_BY_NAME,
+    NFS_CACHE_GID_BY_NAME,
+    NFS_CACHE_NAME_BY_UID,
+    NFS_CACHE_NAME_BY_GID,
+
+    NFS_CACHE_TABLES
+};
+
+struct nfs_cache_entry {
+    time_t expire;
+    id_t id;
+    char name[SSS_NAME_MAX + 1];
+};
+
+static struct nfs_cache_entry nfs_cache[NFS_CACHE_TABLES][CACHE_SIZE];
+
+#if HAVE_PTHREAD
+static pthread_mutex_t nfs_cache_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static void nfs_cache_lock(void)
+{
+    pthread_mutex_lock(&nfs_cache_mtx);
+}
+
+static void nfs_cache_unlock(void)
+{
+    pthread_mutex_unlock(&nfs_cache_mtx);
+}
+#else
+static void nfs_cache_lock(void) { return; }
+static void nfs_cache_unlock(void) { return; }
+#endif
 
 
 /*. . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .*/
@@ -67,6 +120,103 @@ static int reply_to_id(id_t *idp, uint8_t *rep, size_t rep_len);
 static int reply_to_name(char *name, size_t len, uint8_t *rep, size_t rep_len);
 
 
+/*. . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .*/
+/* in-process cache functions */
+static bool is_by_name(enum nfs_cache_table table)
+{
+    return table == NFS_CACHE_UID_BY_NAME || table == NFS_CACHE_GID_BY_NAME;
+}
+
+static struct nfs_cache_entry *cache_slot(enum nfs_cache_table table,
+                                          const char *name, id_t id)
+{
+    uint32_t hash;
+
+    if (is_by_name(table)) {
+        hash = murmurhash3(name, strlen(name), 0xdeadbeef);
+    } else {
+        hash = murmurhash3((const char *)&id, sizeof(id), 0xdeadbeef);
+    }
+
+    return &nfs_cache[table][hash & (CACHE_SIZE - 1)];
+}
+
+static int cache_get_id(enum nfs_cache_table table, const char *name,
+                        id_t *id)
+{
+    struct nfs_cache_entry *entry;
+    int rc = ENOENT;
+
+    if (nfs_cache_timeout <= 0) {
+        return rc;
+    }
+
+    nfs_cache_lock();
+    entry = cache_slot(table, name, 0);
+    if (entry->expire > time(NULL) && strcmp(entry->name, name) == 0) {
+        *id = entry->id;
+        rc = 0;
+    }
+    nfs_cache_unlock();
+
+    if (rc == 0) {
+        IDMAP_LOG(1, ("found %s in cache", name));
+    }
+
+    return rc;
+}
+
+static int cache_get_name(enum nfs_cache_table table, id_t id,
+                          char *name, size_t len)
+{
+    struct nfs_cache_entry *entry;
+    size_t name_len;
+    int rc = ENOENT;
+
+    if (nfs_cache_timeout <= 0) {
+        return rc;
+    }
+
+    nfs_cache_lock();
+    entry = cache_slot(table, NULL, id);
+    if (entry->expire > time(NULL) && entry->id == id) {
+        name_len = strlen(entry->name) + 1;
+        if (name_len <= len) {
+            memcpy(name, entry->name, name_len);
+            rc = 0;
+        }
+    }
+    nfs_cache_unlock();
+
+    if (rc == 0) {
+        IDMAP_LOG(1, ("found id %i in cache", id));
+    }
+
+    return rc;
+}
+
+static void cache_add(enum nfs_cache_table table, const char *name, id_t id)
+{
+    struct nfs_cache_entry *entry;
+    size_t name_len;
+
+    if (nfs_cache_timeout <= 0) {
+        return;
+    }
+
+    name_len = strlen(name) + 1;
+    if (name_len > sizeof(entry->name)) {
+        return;
+    }
+
+    nfs_cache_lock();
+    entry = cache_slot(table, name, id);
+    memcpy(entry->name, name, name_len);
+    entry->id = id;
+    entry->expire = time(NULL) + nfs_cache_timeout;
+    nfs_cache_unlock();
+}
+
 /*. . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .*/
 /* get from memcache functions */
 static int get_uid_from_mc(id_t *uid, const char *name)
@@ -172,9 +322,10 @@ static int get_user_from_mc(char *name, size_t len, uid_t uid)
             IDMAP_LOG(0, ("%s: reply too long; pw_name_len=%lu, len=%lu",
                           __func__, pw_name_len, len));
             rc = ENOBUFS;
+        } else {
+            IDMAP_LOG(1, ("found uid %i in memcache", uid));
+            memcpy(name, pwd.pw_name, pw_name_len);
         }
-        IDMAP_LOG(1, ("found uid %i in memcache", uid));
-        memcpy(name, pwd.pw_name, pw_name_len);
     } else {
         IDMAP_LOG(1, ("uid %i not in memcache", uid));
     }
@@ -213,9 +364,10 @@ static int get_group_from_mc(char *name, size_t len, id_t gid)
             IDMAP_LOG(0, ("%s: reply too long; gr_name_len=%lu, len=%lu",
                           __func__, gr_name_len, len));
             rc = ENOBUFS;
+        } else {
+            IDMAP_LOG(1, ("found gid %i in memcache", gid));
+            memcpy(name, grp.gr_name, gr_name_len);
         }
-        IDMAP_LOG(1, ("found gid %i in memcache", gid));
-        memcpy(name, grp.gr_name, gr_name_len);
     } else {
         IDMAP_LOG(1, ("gid %i not in memcache", gid));
     }
@@ -405,6 +557,30 @@ static int nfs_conf_get_bool(const char *sect, const char *attr, int def)
     return res;
 }
 
+static int nfs_conf_get_int(const char *sect, const char *attr, int def)
+{
+    int res;
+    long val;
+    const char *str;
+    char *endptr;
+
+    res = def;
+    str = nfsidmap_config_get(sect, attr);
+    if (str) {
+        errno = 0;
+        val = strtol(str, &endptr, 10);
+        if (errno == 0 && *str != '\0' && *endptr == '\0'
+                && val >= 0 && val <= INT32_MAX) {
+            res = val;
+        } else {
+            IDMAP_LOG(0, ("%s: invalid value '%s' of %s, using %i",
+                          __func__, str, attr, def));
+        }
+    }
+
+    return res;
+}
+
 
 /*. . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . . .*/
 /* libnfsidmap return-code aids */
@@ -440,6 +616,10 @@ static int sss_nfs_init(void)
                                    USE_MC_DEFAULT);
     IDMAP_LOG(1, ("%s: use memcache: %i", __func__, nfs_use_mc));
 
+    nfs_cache_timeout = nfs_conf_get_int(nfs_conf_sect, nfs_conf_cache_timeout,
+                                         CACHE_TIMEOUT_DEFAULT);
+    IDMAP_LOG(1, ("%s: cache timeout: %i", __func__, nfs_cache_timeout));
+
     return 0;
 }
 
@@ -470,9 +650,15 @@ static int sss_nfs_name_to_uid(char *name, uid_t *uid)
         return -rc;
     }
 
-    rc = get_uid_from_mc(uid, name);
+    rc = cache_get_id(NFS_CACHE_UID_BY_NAME, name, uid);
     if (rc != 0) {
-        rc = name_to_id(name, uid, SSS_NSS_GETPWNAM);
+        rc = get_uid_from_mc(uid, name);
+        if (rc != 0) {
+            rc = name_to_id(name, uid, SSS_NSS_GETPWNAM);
+        }
+        if (rc == 0) {
+            cache_add(NFS_CACHE_UID_BY_NAME, name, *uid);
+        }
     }
 
     log_actual_rc(__func__, rc);
@@ -501,9 +687,15 @@ static int sss_nfs_name_to_gid(char *name, gid_t *gid)
         return -rc;
     }
 
-    rc = get_gid_from_mc(gid, name);
+    rc = cache_get_id(NFS_CACHE_GID_BY_NAME, name, gid);
     if (rc != 0) {
-        rc = name_to_id(name, gid, SSS_NSS_GETGRNAM);
+        rc = get_gid_from_mc(gid, name);
+        if (rc != 0) {
+            rc = name_to_id(name, gid, SSS_NSS_GETGRNAM);
+        }
+        if (rc == 0) {
+            cache_add(NFS_CACHE_GID_BY_NAME, name, *gid);
+        }
     }
 
     log_actual_rc(__func__, rc);
@@ -521,9 +713,15 @@ static int sss_nfs_uid_to_name(uid_t uid, char *domain, char *name, size_t len)
         return -EINVAL;
     }
 
-    rc = get_user_from_mc(name, len, uid);
+    rc = cache_get_name(NFS_CACHE_NAME_BY_UID, uid, name, len);
     if (rc != 0) {
-        rc = id_to_name(name, len, uid, SSS_NSS_GETPWUID);
+        rc = get_user_from_mc(name, len, uid);
+        if (rc != 0) {
+            rc = id_to_name(name, len, uid, SSS_NSS_GETPWUID);
+        }
+        if (rc == 0) {
+            cache_add(NFS_CACHE_NAME_BY_UID, name, uid);
+        }
     }
 
     log_actual_rc(__func__, rc);
@@ -541,9 +739,15 @@ static int sss_nfs_gid_to_name(gid_t gid, char *domain, char *name, size_t len)
         return -EINVAL;
     }
 
-    rc = get_group_from_mc(name, len, gid);
+    rc = cache_get_name(NFS_CACHE_NAME_BY_GID, gid, name, len);
     if (rc != 0) {
-        rc = id_to_name(name, len, gid, SSS_NSS_GETGRGID);
+        rc = get_group_from_mc(name, len, gid);
+        if (rc != 0) {
+            rc = id_to_name(name, len, gid, SSS_NSS_GETGRGID);
+        }
+        if (rc == 0) {
+            cache_add(NFS_CACHE_NAME_BY_GID, name, gid);
+        }
     }
 
     log_actual_rc(__func__, rc);
@@ -25,6 +25,8 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 #include "sss_cli.h"
@@ -47,126 +49,6 @@ static void sss_nss_getgrent_data_clean(void)
     sss_nss_getgrent_data.ptr = 0;
 }
 
-enum sss_nss_gr_type {
-    GETGR_NONE,
-    GETGR_NAME,
-    GETGR_GID
-};
-
-static struct sss_nss_getgr_data {
-    enum sss_nss_gr_type type;
-    union {
-        char *grname;
-        gid_t gid;
-    } id;
-
-    uint8_t *repbuf;
-    size_t replen;
-} sss_nss_getgr_data;
-
-static void sss_nss_getgr_data_clean(bool freebuf)
-{
-    if (sss_nss_getgr_data.type == GETGR_NAME) {
-        free(sss_nss_getgr_data.id.grname);
-    }
-    if (freebuf) {
-        free(sss_nss_getgr_data.repbuf);
-    }
-    memset(&sss_nss_getgr_data, 0, sizeof(struct sss_nss_getgr_data));
-}
-
-static enum nss_status sss_nss_get_getgr_cache(const char *name, gid_t gid,
-                                               enum sss_nss_gr_type type,
-                                               uint8_t **repbuf,
-                                               size_t *replen,
-                                               int *errnop)
-{
-    bool freebuf = true;
-    enum nss_status status;
-    int ret = 0;
-
-    if (sss_nss_getgr_data.type != type) {
-        status = NSS_STATUS_NOTFOUND;
-        goto done;
-    }
-
-    switch (type) {
-    case GETGR_NAME:
-        ret = strcmp(name, sss_nss_getgr_data.id.grname);
-        if (ret != 0) {
-            status = NSS_STATUS_NOTFOUND;
-            goto done;
-        }
-        break;
-    case GETGR_GID:
-        if (sss_nss_getgr_data.id.gid != gid) {
-            status = NSS_STATUS_NOTFOUND;
-            goto done;
-        }
-        break;
-    default:
-        status = NSS_STATUS_TRYAGAIN;
-        ret = EINVAL;
-        goto done;
-    }
-
-    /* ok we have it, remove from cache and pass back to the caller */
-    *repbuf = sss_nss_getgr_data.repbuf;
-    *replen = sss_nss_getgr_data.replen;
-
-    /* prevent _clean() from freeing the buffer */
-    freebuf = false;
-    status = NSS_STATUS_SUCCESS;
-
-done:
-    sss_nss_getgr_data_clean(freebuf);
-    *errnop = ret;
-    return status;
-}
-
-/* this function always takes ownership of repbuf and NULLs it before
- * returning */
-static void sss_nss_save_getgr_cache(const char *name, gid_t gid,
-                                     enum sss_nss_gr_type type,
-                                     uint8_t **repbuf, size_t replen)
-{
-    int ret = 0;
-
-    sss_nss_getgr_data.type = type;
-    sss_nss_getgr_data.repbuf = *repbuf;
-    sss_nss_getgr_data.replen = replen;
-
-    switch (type) {
-    case GETGR_NAME:
-        if (name == NULL) {
-            ret = EINVAL;
-            goto done;
-        }
-        sss_nss_getgr_data.id.grname = strdup(name);
-        if (!sss_nss_getgr_data.id.grname) {
-            ret = ENOMEM;
-            goto done;
-        }
-        break;
-    case GETGR_GID:
-        if (gid == 0) {
-            ret = EINVAL;
-            goto done;
-        }
-        sss_nss_getgr_data.id.gid = gid;
-        break;
-    default:
-        ret = EINVAL;
-        goto done;
-    }
-
-done:
-    if (ret) {
-        sss_nss_getgr_data_clean(true);
-    }
-    *repbuf = NULL;
-}
-
 /* GETGRNAM Request:
  *
  * 0-X: string with name
@@ -183,7 +65,7 @@ done:
  * Replies:
  *
  * 0-3: 32bit unsigned number of results
- * 4-7: 32bit unsigned (reserved/padding)
+ * 4-7: 32bit unsigned length of all strings if there is one result, or 0
  *  For each result (64bit padded?):
  *  0-3: 32bit number gid
  *  4-7: 32bit unsigned number of members
@@ -258,6 +140,53 @@ int sss_nss_getgr_readrep(struct sss_nss_gr_rep *pr,
     return 0;
 }
 
+/* Check whether the single group in the reply fits into a buffer of
+ * @buflen bytes before anything is copied. Large groups would otherwise be
+ * copied almost completely before ERANGE is found, once for each buffer
+ * size glibc tries. Replies from older responders carry no string length
+ * and are left to sss_nss_getgr_readrep(). */
+static int sss_nss_getgr_check_size(uint8_t *repbuf, size_t replen,
+                                    size_t buflen)
+{
+    const size_t hdr = 4 * sizeof(uint32_t);
+    uint32_t strs_len;
+    uint32_t mem_num;
+    size_t name_len;
+    size_t passwd_len;
+    size_t fields;
+    uint64_t needed;
+
+    if (replen <= hdr) {
+        return 0;
+    }
+
+    SAFEALIGN_COPY_UINT32(&strs_len, repbuf + sizeof(uint32_t), NULL);
+    if (strs_len == 0 || strs_len > replen - hdr) {
+        return 0;
+    }
+
+    SAFEALIGN_COPY_UINT32(&mem_num, repbuf + 3 * sizeof(uint32_t), NULL);
+
+    name_len = strnlen((char *)repbuf + hdr, strs_len);
+    if (name_len + 1 >= strs_len) {
+        return 0;
+    }
+    passwd_len = strnlen((char *)repbuf + hdr + name_len + 1,
+                         strs_len - name_len - 1);
+    fields = name_len + 1 + passwd_len + 1;
+    if (fields > strs_len) {
+        return 0;
+    }
+
+    needed = (uint64_t)strs_len + PADDING_SIZE(fields, char *)
+                 + ((uint64_t)mem_num + 1) * sizeof(char *);
+    if (needed > buflen) {
+        return ERANGE; /* not ENOMEM, ERANGE is what glibc looks for */
+    }
+
+    return 0;
+}
+
 /* INITGROUP Reply:
  *
  * 0-3: 32bit unsigned number of results
@@ -280,6 +209,7 @@ enum nss_status _nss_sss_initgroups_dyn(const char *user, gid_t group,
     size_t user_len;
     uint32_t num_ret;
     long int l, max_ret;
+    bool mux;
     int ret;
 
     ret = sss_strnlen(user, SSS_NAME_MAX, &user_len);
@@ -310,32 +240,40 @@ enum nss_status _nss_sss_initgroups_dyn(const char *user, gid_t group,
     rd.len = user_len + 1;
     rd.data = user;
 
-    sss_nss_lock();
-
-    /* previous thread might already initialize entry in mmap cache */
-    ret = sss_nss_mc_initgroups_dyn(user, user_len, group, start, size,
-                                    groups, limit);
-    switch (ret) {
-    case 0:
-        *errnop = 0;
-        nret = NSS_STATUS_SUCCESS;
-        goto out;
-    case ERANGE:
-        *errnop = ERANGE;
-        nret = NSS_STATUS_TRYAGAIN;
-        goto out;
-    case ENOENT:
-        /* fall through, we need to actively ask the parent
-         * if no entry is found */
-        break;
-    default:
-        /* if using the mmapped cache failed,
-         * fall back to socket based comms */
-        break;
+    mux = sss_nss_mux_enabled();
+    if (!mux) {
+        sss_nss_lock();
+
+        /* previous thread might already initialize entry in mmap cache */
+        ret = sss_nss_mc_initgroups_dyn(user, user_len, group, start, size,
+                                        groups, limit);
+        switch (ret) {
+        case 0:
+            *errnop = 0;
+            nret = NSS_STATUS_SUCCESS;
+            goto out;
+        case ERANGE:
+            *errnop = ERANGE;
+            nret = NSS_STATUS_TRYAGAIN;
+            goto out;
+        case ENOENT:
+            /* fall through, we need to actively ask the parent
+             * if no entry is found */
+            break;
+        default:
+            /* if using the mmapped cache failed,
+             * fall back to socket based comms */
+            break;
+        }
     }
 
-    nret = sss_nss_make_request(SSS_NSS_INITGR, &rd,
-                                &repbuf, &replen, errnop);
+    if (mux) {
+        nret = sss_nss_make_request_mux(SSS_NSS_INITGR, &rd,
+                                        &repbuf, &replen, errnop);
+    } else {
+        nret = sss_nss_make_request(SSS_NSS_INITGR, &rd,
+                                    &repbuf, &replen, errnop);
+    }
     if (nret != NSS_STATUS_SUCCESS) {
         goto out;
     }
@@ -385,7 +323,9 @@ enum nss_status _nss_sss_initgroups_dyn(const char *user, gid_t group,
     nret = NSS_STATUS_SUCCESS;
 
 out:
-    sss_nss_unlock();
+    if (!mux) {
+        sss_nss_unlock();
+    }
     return nret;
 }
 
@@ -399,6 +339,7 @@ enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
     size_t replen, len, name_len;
     uint32_t num_results;
     enum nss_status nret;
+    bool mux;
     int ret;
 
     /* Caught once glibc passing in buffer == 0x0 */
@@ -431,35 +372,47 @@ enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
         break;
     }
 
+    /* the lookup might have found nothing a moment ago */
+    if (sss_nss_mc_getgr_is_negative(name, false)) {
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
+    }
+
     rd.len = name_len + 1;
     rd.data = name;
 
-    sss_nss_lock();
+    mux = sss_nss_mux_enabled();
+    if (!mux) {
+        sss_nss_lock();
 
-    /* previous thread might already initialize entry in mmap cache */
-    ret = sss_nss_mc_getgrnam(name, name_len, result, buffer, buflen);
-    switch (ret) {
-    case 0:
-        *errnop = 0;
-        nret = NSS_STATUS_SUCCESS;
-        goto out;
-    case ERANGE:
-        *errnop = ERANGE;
-        nret = NSS_STATUS_TRYAGAIN;
-        goto out;
-    case ENOENT:
-        /* fall through, we need to actively ask the parent
-         * if no entry is found */
-        break;
-    default:
-        /* if using the mmapped cache failed,
-         * fall back to socket based comms */
-        break;
+        /* previous thread might already initialize entry in mmap cache */
+        ret = sss_nss_mc_getgrnam(name, name_len, result, buffer, buflen);
+        switch (ret) {
+        case 0:
+            *errnop = 0;
+            nret = NSS_STATUS_SUCCESS;
+            goto out;
+        case ERANGE:
+            *errnop = ERANGE;
+            nret = NSS_STATUS_TRYAGAIN;
+            goto out;
+        case ENOENT:
+            /* fall through, we need to actively ask the parent
+             * if no entry is found */
+            break;
+        default:
+            /* if using the mmapped cache failed,
+             * fall back to socket based comms */
+            break;
+        }
     }
 
-    nret = sss_nss_get_getgr_cache(name, 0, GETGR_NAME,
-                                   &repbuf, &replen, errnop);
-    if (nret == NSS_STATUS_NOTFOUND) {
+    if (sss_nss_get_retry_reply(SSS_NSS_GETGRNAM, &rd, &repbuf, &replen)) {
+        nret = NSS_STATUS_SUCCESS;
+    } else if (mux) {
+        nret = sss_nss_make_request_mux(SSS_NSS_GETGRNAM, &rd,
+                                        &repbuf, &replen, errnop);
+    } else {
         nret = sss_nss_make_request(SSS_NSS_GETGRNAM, &rd,
                                     &repbuf, &replen, errnop);
     }
@@ -477,6 +430,7 @@ enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
     /* no results if not found */
     if (num_results == 0) {
         free(repbuf);
+        sss_nss_mc_getgr_set_negative(name, false);
         nret = NSS_STATUS_NOTFOUND;
         goto out;
     }
@@ -490,9 +444,12 @@ enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
     }
 
     len = replen - 8;
-    ret = sss_nss_getgr_readrep(&grrep, repbuf+8, &len);
+    ret = sss_nss_getgr_check_size(repbuf, replen, buflen);
+    if (ret == 0) {
+        ret = sss_nss_getgr_readrep(&grrep, repbuf+8, &len);
+    }
     if (ret == ERANGE) {
-        sss_nss_save_getgr_cache(name, 0, GETGR_NAME, &repbuf, replen);
+        sss_nss_save_retry_reply(SSS_NSS_GETGRNAM, &rd, &repbuf, replen);
     } else {
         free(repbuf);
     }
@@ -505,7 +462,9 @@ enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
     nret = NSS_STATUS_SUCCESS;
 
 out:
-    sss_nss_unlock();
+    if (!mux) {
+        sss_nss_unlock();
+    }
     return nret;
 }
 
@@ -519,6 +478,8 @@ enum nss_status _nss_sss_getgrgid_r(gid_t gid, struct group *result,
     uint32_t num_results;
     enum nss_status nret;
     uint32_t group_gid;
+    char id_key[11];
+    bool mux;
     int ret;
 
     /* Caught once glibc passing in buffer == 0x0 */
@@ -545,36 +506,49 @@ enum nss_status _nss_sss_getgrgid_r(gid_t gid, struct group *result,
         break;
     }
 
+    /* the lookup might have found nothing a moment ago */
+    snprintf(id_key, sizeof(id_key), "%"PRIu32, (uint32_t)gid);
+    if (sss_nss_mc_getgr_is_negative(id_key, true)) {
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
+    }
+
     group_gid = gid;
     rd.len = sizeof(uint32_t);
     rd.data = &group_gid;
 
-    sss_nss_lock();
+    mux = sss_nss_mux_enabled();
+    if (!mux) {
+        sss_nss_lock();
 
-    /* previous thread might already initialize entry in mmap cache */
-    ret = sss_nss_mc_getgrgid(gid, result, buffer, buflen);
-    switch (ret) {
-    case 0:
-        *errnop = 0;
-        nret = NSS_STATUS_SUCCESS;
-        goto out;
-    case ERANGE:
-        *errnop = ERANGE;
-        nret = NSS_STATUS_TRYAGAIN;
-        goto out;
-    case ENOENT:
-        /* fall through, we need to actively ask the parent
-         * if no entry is found */
-        break;
-    default:
-        /* if using the mmapped cache failed,
-         * fall back to socket based comms */
-        break;
+        /* previous thread might already initialize entry in mmap cache */
+        ret = sss_nss_mc_getgrgid(gid, result, buffer, buflen);
+        switch (ret) {
+        case 0:
+            *errnop = 0;
+            nret = NSS_STATUS_SUCCESS;
+            goto out;
+        case ERANGE:
+            *errnop = ERANGE;
+            nret = NSS_STATUS_TRYAGAIN;
+            goto out;
+        case ENOENT:
+            /* fall through, we need to actively ask the parent
+             * if no entry is found */
+            break;
+        default:
+            /* if using the mmapped cache failed,
+             * fall back to socket based comms */
+            break;
+        }
     }
 
-    nret = sss_nss_get_getgr_cache(NULL, gid, GETGR_GID,
-                                   &repbuf, &replen, errnop);
-    if (nret == NSS_STATUS_NOTFOUND) {
+    if (sss_nss_get_retry_reply(SSS_NSS_GETGRGID, &rd, &repbuf, &replen)) {
+        nret = NSS_STATUS_SUCCESS;
+    } else if (mux) {
+        nret = sss_nss_make_request_mux(SSS_NSS_GETGRGID, &rd,
+                                        &repbuf, &replen, errnop);
+    } else {
         nret = sss_nss_make_request(SSS_NSS_GETGRGID, &rd,
                                     &repbuf, &replen, errnop);
     }
@@ -592,6 +566,7 @@ enum nss_status _nss_sss_getgrgid_r(gid_t gid, struct group *result,
     /* no results if not found */
     if (num_results == 0) {
         free(repbuf);
+        sss_nss_mc_getgr_set_negative(id_key, true);
         nret = NSS_STATUS_NOTFOUND;
         goto out;
     }
@@ -605,9 +580,12 @@ enum nss_status _nss_sss_getgrgid_r(gid_t gid, struct group *result,
     }
 
     len = replen - 8;
-    ret = sss_nss_getgr_readrep(&grrep, repbuf+8, &len);
+    ret = sss_nss_getgr_check_size(repbuf, replen, buflen);
+    if (ret == 0) {
+        ret = sss_nss_getgr_readrep(&grrep, repbuf+8, &len);
+    }
     if (ret == ERANGE) {
-        sss_nss_save_getgr_cache(NULL, gid, GETGR_GID, &repbuf, replen);
+        sss_nss_save_retry_reply(SSS_NSS_GETGRGID, &rd, &repbuf, replen);
     } else {
         free(repbuf);
     }
@@ -620,7 +598,9 @@ enum nss_status _nss_sss_getgrgid_r(gid_t gid, struct group *result,
     nret = NSS_STATUS_SUCCESS;
 
 out:
-    sss_nss_unlock();
+    if (!mux) {
+        sss_nss_unlock();
+    }
     return nret;
 }
 
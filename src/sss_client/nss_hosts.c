@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "sss_cli.h"
+#include "nss_mc.h"
 
 static struct sss_nss_gethostent_data {
     size_t len;
@@ -207,6 +208,38 @@ sss_nss_gethost_readrep(struct sss_nss_host_rep *sr,
     return EOK;
 }
 
+/* Parses the result data found in the memory cache */
+static enum nss_status
+sss_nss_gethost_mc_readrep(uint8_t *repbuf, size_t replen, int af,
+                           struct hostent *result,
+                           char *buffer, size_t buflen,
+                           int *errnop, int *h_errnop)
+{
+    struct sss_nss_host_rep hostrep;
+    int ret;
+
+    hostrep.result = result;
+    hostrep.buffer = buffer;
+    hostrep.buflen = buflen;
+
+    ret = sss_nss_gethost_readrep(&hostrep, repbuf, &replen, af);
+    free(repbuf);
+    if (ret) {
+        *errnop = ret;
+        *h_errnop = NETDB_INTERNAL;
+        return NSS_STATUS_TRYAGAIN;
+    }
+
+    /* If host name is valid but does not have an IP address of the requested
+     * address family return the correct error.  */
+    if (result->h_addr_list[0] == NULL) {
+        *h_errnop = NO_DATA;
+        return NSS_STATUS_TRYAGAIN;
+    }
+
+    return NSS_STATUS_SUCCESS;
+}
+
 static enum nss_status
 internal_gethostbyname2_r(const char *name, int af,
                           struct hostent *result,
@@ -242,6 +275,12 @@ internal_gethostbyname2_r(const char *name, int af,
         return NSS_STATUS_UNAVAIL;
     }
 
+    ret = sss_nss_mc_gethostbyname(name, &repbuf, &replen);
+    if (ret == 0) {
+        return sss_nss_gethost_mc_readrep(repbuf, replen, af, result,
+                                          buffer, buflen, errnop, h_errnop);
+    }
+
     rd.len = name_len + 1;
     rd.data = name;
 
@@ -355,6 +394,16 @@ _nss_sss_gethostbyaddr_r(const void *addr, socklen_t addrlen,
         return NSS_STATUS_TRYAGAIN;
     }
 
+    if ((af == AF_INET && addrlen == INADDRSZ)
+            || (af == AF_INET6 && addrlen == IN6ADDRSZ)) {
+        ret = sss_nss_mc_gethostbyaddr(addr, af, &repbuf, &replen);
+        if (ret == 0) {
+            return sss_nss_gethost_mc_readrep(repbuf, replen, af, result,
+                                              buffer, buflen,
+                                              errnop, h_errnop);
+        }
+    }
+
     data_len = sizeof(uint32_t) + sizeof(socklen_t) + addrlen;
     data = malloc(data_len);
     if (data == NULL) {
@@ -54,8 +54,20 @@ struct sss_cli_mc_ctx {
 
     uint32_t *hash_table;   /* hash table address (in mmap) */
     uint32_t ht_size;       /* size of hash table */
+    uint32_t layout;        /* hash table layout (SSS_MC_LAYOUT_*) */
+    uint32_t hash;          /* hash function of the keys (SSS_MC_HASH_*) */
 
     uint32_t active_threads; /* count of threads which use memory cache */
+
+    uint32_t neg_timeout;   /* how long misses may be remembered */
+};
+
+/* state of a key lookup in the hash table */
+struct sss_nss_mc_lookup {
+    uint32_t hash;          /* home bucket of the key */
+    uint32_t pos;           /* next position to probe */
+    uint32_t probes;        /* number of probed positions */
+    uint32_t key2;          /* looking up the second key of records */
 };
 
 errno_t sss_nss_mc_get_ctx(const char *name, struct sss_cli_mc_ctx *ctx);
@@ -64,10 +76,30 @@ uint32_t sss_nss_mc_hash(struct sss_cli_mc_ctx *ctx,
                          const char *key, size_t len);
 errno_t sss_nss_mc_get_record(struct sss_cli_mc_ctx *ctx,
                               uint32_t slot, struct sss_mc_rec **_rec);
+/* true if the record was written before the generation in the header of the
+ * file was bumped, the caller must ask the responder instead */
+bool sss_nss_mc_rec_is_stale(struct sss_cli_mc_ctx *ctx,
+                             struct sss_mc_rec *rec);
 errno_t sss_nss_str_ptr_from_buffer(char **str, void **cookie,
                                     char *buf, size_t len);
 uint32_t sss_nss_mc_next_slot_with_hash(struct sss_mc_rec *rec,
                                         uint32_t hash);
+uint32_t sss_nss_mc_lookup_first(struct sss_cli_mc_ctx *ctx,
+                                 struct sss_nss_mc_lookup *lk,
+                                 const char *key, size_t len, bool key2);
+uint32_t sss_nss_mc_lookup_next(struct sss_cli_mc_ctx *ctx,
+                                struct sss_nss_mc_lookup *lk,
+                                struct sss_mc_rec *rec);
+errno_t sss_nss_mc_get_reply(const char *name, struct sss_cli_mc_ctx *ctx,
+                             const char *key,
+                             uint8_t **_reply, size_t *_reply_len);
+
+/* per-process negative cache, the keys of lookups by ID are the second
+ * keys of the memory cache */
+bool sss_nss_mc_neg_check(const char *name, struct sss_cli_mc_ctx *ctx,
+                          const char *key, bool key2);
+void sss_nss_mc_neg_add(const char *name, struct sss_cli_mc_ctx *ctx,
+                        const char *key, bool key2);
 
 /* passwd db */
 errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
@@ -76,6 +108,8 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
 errno_t sss_nss_mc_getpwuid(uid_t uid,
                             struct passwd *result,
                             char *buffer, size_t buflen);
+bool sss_nss_mc_getpw_is_negative(const char *key, bool by_uid);
+void sss_nss_mc_getpw_set_negative(const char *key, bool by_uid);
 
 /* group db */
 errno_t sss_nss_mc_getgrnam(const char *name, size_t name_len,
@@ -84,10 +118,30 @@ errno_t sss_nss_mc_getgrnam(const char *name, size_t name_len,
 errno_t sss_nss_mc_getgrgid(gid_t gid,
                             struct group *result,
                             char *buffer, size_t buflen);
+bool sss_nss_mc_getgr_is_negative(const char *key, bool by_gid);
+void sss_nss_mc_getgr_set_negative(const char *key, bool by_gid);
 
 /* initgroups db */
 errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
                                   gid_t group, long int *start, long int *size,
                                   gid_t **groups, long int limit);
 
+/* services db, the result data of the reply is returned to be parsed like
+ * the one received from the responder */
+errno_t sss_nss_mc_getservbyname(const char *name, const char *protocol,
+                                 uint8_t **_reply, size_t *_reply_len);
+errno_t sss_nss_mc_getservbyport(int port, const char *protocol,
+                                 uint8_t **_reply, size_t *_reply_len);
+
+/* hosts db, the result data of the reply is returned as well */
+errno_t sss_nss_mc_gethostbyname(const char *name,
+                                 uint8_t **_reply, size_t *_reply_len);
+errno_t sss_nss_mc_gethostbyaddr(const void *addr, int af,
+                                 uint8_t **_reply, size_t *_reply_len);
+
+/* sid db */
+errno_t sss_nss_mc_get_sid(const char *key, size_t key_len, bool by_name,
+                           char **_sid, char **_name,
+                           uint32_t *_id, uint32_t *_type);
+
 #endif /* _NSS_MC_H_ */
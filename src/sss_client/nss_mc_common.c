@@ -30,6 +30,9 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include <sched.h>
 #include "nss_mc.h"
 #include "sss_cli.h"
 #include "shared/io.h"
@@ -55,6 +58,19 @@ do { \
     } \
 } while(0)
 
+/* Called before every retry of a barrier protected read. The writer only
+ * holds a record for the duration of a memcpy(), so spinning is cheaper
+ * than a context switch at first, but if the responder was preempted in
+ * the middle of an update we must let it run again. */
+static inline void sss_nss_mc_read_backoff(int attempt)
+{
+    if (attempt < MC_READ_SPIN_RETRIES) {
+        __sync_synchronize();
+    } else {
+        sched_yield();
+    }
+}
+
 errno_t sss_nss_check_header(struct sss_cli_mc_ctx *ctx)
 {
     struct sss_mc_header h;
@@ -63,8 +79,11 @@ errno_t sss_nss_check_header(struct sss_cli_mc_ctx *ctx)
     int ret;
     struct stat fdstat;
 
-    /* retry barrier protected reading max 5 times then give up */
-    for (count = 5; count > 0; count--) {
+    /* retry barrier protected reading then give up */
+    for (count = 0; count < MC_READ_MAX_RETRIES; count++) {
+        if (count > 0) {
+            sss_nss_mc_read_backoff(count);
+        }
         MEMCPY_WITH_BARRIERS(copy_ok, &h,
                              (struct sss_mc_header *)ctx->mmap_base,
                              sizeof(struct sss_mc_header));
@@ -73,7 +92,7 @@ errno_t sss_nss_check_header(struct sss_cli_mc_ctx *ctx)
             break;
         }
     }
-    if (count == 0) {
+    if (count == MC_READ_MAX_RETRIES) {
         /* couldn't successfully read header we have to give up */
         return EIO;
     }
@@ -84,19 +103,34 @@ errno_t sss_nss_check_header(struct sss_cli_mc_ctx *ctx)
         return EINVAL;
     }
 
+    if (h.layout != SSS_MC_LAYOUT_CHAINED &&
+        h.layout != SSS_MC_LAYOUT_PROBING) {
+        return EINVAL;
+    }
+
+    if (h.hash != SSS_MC_HASH_MURMURHASH3 &&
+        h.hash != SSS_MC_HASH_WYHASH) {
+        return EINVAL;
+    }
+
     /* first time we check the header, let's fill our own struct */
     if (ctx->data_table == NULL) {
         ctx->seed = h.seed;
+        ctx->neg_timeout = h.neg_timeout;
         ctx->data_table = MC_PTR_ADD(ctx->mmap_base, h.data_table);
         ctx->hash_table = MC_PTR_ADD(ctx->mmap_base, h.hash_table);
         ctx->dt_size = h.dt_size;
         ctx->ht_size = h.ht_size;
+        ctx->layout = h.layout;
+        ctx->hash = h.hash;
     } else {
         if (ctx->seed != h.seed ||
             ctx->data_table != MC_PTR_ADD(ctx->mmap_base, h.data_table) ||
             ctx->hash_table != MC_PTR_ADD(ctx->mmap_base, h.hash_table) ||
             ctx->dt_size != h.dt_size ||
-            ctx->ht_size != h.ht_size) {
+            ctx->ht_size != h.ht_size ||
+            ctx->layout != h.layout ||
+            ctx->hash != h.hash) {
             return EINVAL;
         }
     }
@@ -180,6 +214,15 @@ static errno_t sss_nss_mc_init_ctx(const char *name,
         goto done;
     }
 
+#ifdef MADV_HUGEPAGE
+    /* the flags never change during the life of the file, a failure only
+     * means that regular pages are used */
+    if (((struct sss_mc_header *)ctx->mmap_base)->flags
+            & SSS_MC_FLAG_HUGE_PAGES) {
+        (void)madvise(ctx->mmap_base, ctx->mmap_size, MADV_HUGEPAGE);
+    }
+#endif
+
     ctx->initialized = INITIALIZED;
 
     ret = 0;
@@ -251,7 +294,24 @@ errno_t sss_nss_mc_get_ctx(const char *name, struct sss_cli_mc_ctx *ctx)
 uint32_t sss_nss_mc_hash(struct sss_cli_mc_ctx *ctx,
                          const char *key, size_t len)
 {
-    return murmurhash3(key, len, ctx->seed) % MC_HT_ELEMS(ctx->ht_size);
+    uint32_t h;
+
+    if (ctx->hash == SSS_MC_HASH_WYHASH) {
+        h = wyhash(key, len, ctx->seed);
+    } else {
+        h = murmurhash3(key, len, ctx->seed);
+    }
+
+    return h % MC_HT_ELEMS(ctx->ht_size);
+}
+
+bool sss_nss_mc_rec_is_stale(struct sss_cli_mc_ctx *ctx,
+                             struct sss_mc_rec *rec)
+{
+    volatile struct sss_mc_header *h;
+
+    h = (volatile struct sss_mc_header *)ctx->mmap_base;
+    return rec->generation != h->generation;
 }
 
 errno_t sss_nss_mc_get_record(struct sss_cli_mc_ctx *ctx,
@@ -267,18 +327,28 @@ errno_t sss_nss_mc_get_record(struct sss_cli_mc_ctx *ctx,
     int count;
     int ret;
 
-    /* try max 5 times */
-    for (count = 5; count > 0; count--) {
-        rec = MC_SLOT_TO_PTR(ctx->data_table, slot, struct sss_mc_rec);
+    rec = MC_SLOT_TO_PTR(ctx->data_table, slot, struct sss_mc_rec);
+
+    for (count = 0; count < MC_READ_MAX_RETRIES; count++) {
+        if (count > 0) {
+            sss_nss_mc_read_backoff(count);
+        }
 
         /* fetch record length */
         b1 = rec->b1;
+        if (b1 == MC_INVALID_VAL) {
+            /* The record was invalidated after we read the slot from the
+             * hash chain, or it is not chained yet. Either way it will not
+             * become valid by waiting, the caller must ask the responder. */
+            ret = ENOENT;
+            goto done;
+        }
         __sync_synchronize();
         rec_len = rec->len;
         __sync_synchronize();
         b2 = rec->b2;
         if (!MC_VALID_BARRIER(b1) || b1 != b2) {
-            /* record is inconsistent, retry */
+            /* record is being written, retry */
             continue;
         }
 
@@ -307,7 +377,7 @@ errno_t sss_nss_mc_get_record(struct sss_cli_mc_ctx *ctx,
             break;
         }
     }
-    if (count == 0) {
+    if (count == MC_READ_MAX_RETRIES) {
         /* couldn't successfully read header we have to give up */
         ret = EIO;
         goto done;
@@ -381,3 +451,283 @@ uint32_t sss_nss_mc_next_slot_with_hash(struct sss_mc_rec *rec,
     }
 
 }
+
+/* Returns the slot of the next entry in the probe sequence which has the
+ * fingerprint and the key type we are looking for. The probe sequence ends
+ * with the first empty bucket. */
+static uint32_t sss_nss_mc_probe(struct sss_cli_mc_ctx *ctx,
+                                 struct sss_nss_mc_lookup *lk)
+{
+    uint32_t elems = MC_HT_ELEMS(ctx->ht_size);
+    uint32_t entry;
+
+    while (lk->probes < MC_HT_MAX_PROBES && lk->probes < elems) {
+        entry = ctx->hash_table[lk->pos];
+        lk->pos = (lk->pos + 1) % elems;
+        lk->probes++;
+
+        if (entry == MC_INVALID_VAL) {
+            break;
+        }
+
+        if (MC_HT_ENTRY_FP(entry) == MC_HT_FP(lk->hash)
+                && MC_HT_ENTRY_KEY2(entry) == lk->key2) {
+            return MC_HT_ENTRY_SLOT(entry);
+        }
+    }
+
+    return MC_INVALID_VAL;
+}
+
+uint32_t sss_nss_mc_lookup_first(struct sss_cli_mc_ctx *ctx,
+                                 struct sss_nss_mc_lookup *lk,
+                                 const char *key, size_t len, bool key2)
+{
+    lk->hash = sss_nss_mc_hash(ctx, key, len);
+    lk->pos = lk->hash;
+    lk->probes = 0;
+    lk->key2 = key2 ? 1 : 0;
+
+    if (ctx->layout == SSS_MC_LAYOUT_PROBING) {
+        return sss_nss_mc_probe(ctx, lk);
+    }
+
+    return ctx->hash_table[lk->hash];
+}
+
+uint32_t sss_nss_mc_lookup_next(struct sss_cli_mc_ctx *ctx,
+                                struct sss_nss_mc_lookup *lk,
+                                struct sss_mc_rec *rec)
+{
+    if (ctx->layout == SSS_MC_LAYOUT_PROBING) {
+        return sss_nss_mc_probe(ctx, lk);
+    }
+
+    return sss_nss_mc_next_slot_with_hash(rec, lk->hash);
+}
+
+/* Looks the key up as the first and then as the second key of the records of
+ * the services or hosts cache. Returns a copy of the result data of the
+ * responder reply which the caller must free. */
+static errno_t sss_nss_mc_find_reply(struct sss_cli_mc_ctx *ctx,
+                                     const char *key, size_t key_len,
+                                     bool key2,
+                                     uint8_t **_reply, size_t *_reply_len)
+{
+    const size_t strs_offset = offsetof(struct sss_mc_reply_data, strs);
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_reply_data *data;
+    struct sss_nss_mc_lookup lk;
+    const char *rec_key;
+    rel_ptr_t key_ptr;
+    uint8_t *reply;
+    uint32_t slot;
+    int ret;
+
+    /* hashes are calculated including the NULL terminator */
+    slot = sss_nss_mc_lookup_first(ctx, &lk, key, key_len + 1, key2);
+
+    /* If slot is not within the bounds of mmapped region and
+     * it's value is not MC_INVALID_VAL, then the cache is
+     * probably corrupted. */
+    while (MC_SLOT_WITHIN_BOUNDS(slot, ctx->dt_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(ctx, slot, &rec);
+        if (ret) {
+            goto done;
+        }
+
+        /* check record matches what we are searching for */
+        if (lk.hash != (key2 ? rec->hash2 : rec->hash1)) {
+            /* if key hash does not match we can skip this immediately */
+            slot = sss_nss_mc_lookup_next(ctx, &lk, rec);
+            continue;
+        }
+
+        data = (struct sss_mc_reply_data *)rec->data;
+        key_ptr = key2 ? data->key2 : data->key;
+        /* Integrity check
+         * - all strings and the result data must be within copy of record
+         * - the key must be within strs and zero terminated
+         * - the result data must be within strs */
+        if (rec->len < sizeof(struct sss_mc_rec) + strs_offset
+            || data->strs_len > rec->len - sizeof(struct sss_mc_rec)
+                                         - strs_offset
+            || key_ptr < strs_offset
+            || key_ptr >= strs_offset + data->strs_len
+            || data->reply < strs_offset
+            || data->reply_len > data->strs_len
+            || data->reply - strs_offset > data->strs_len - data->reply_len) {
+            ret = ENOENT;
+            goto done;
+        }
+
+        rec_key = (const char *)data + key_ptr;
+        if (strnlen(rec_key, strs_offset + data->strs_len - key_ptr)
+                == strs_offset + data->strs_len - key_ptr) {
+            ret = ENOENT;
+            goto done;
+        }
+
+        if (strcmp(key, rec_key) == 0) {
+            break;
+        }
+
+        slot = sss_nss_mc_lookup_next(ctx, &lk, rec);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, ctx->dt_size)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    /* additional checks before filling result*/
+    if (rec->expire < time(NULL) || sss_nss_mc_rec_is_stale(ctx, rec)) {
+        /* entry is now invalid */
+        ret = ENOENT;
+        goto done;
+    }
+
+    reply = malloc(data->reply_len);
+    if (reply == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(reply, (uint8_t *)data + data->reply, data->reply_len);
+
+    *_reply = reply;
+    *_reply_len = data->reply_len;
+    ret = 0;
+
+done:
+    free(rec);
+    return ret;
+}
+
+errno_t sss_nss_mc_get_reply(const char *name, struct sss_cli_mc_ctx *ctx,
+                             const char *key,
+                             uint8_t **_reply, size_t *_reply_len)
+{
+    size_t key_len;
+    int ret;
+
+    key_len = strlen(key);
+
+    ret = sss_nss_mc_get_ctx(name, ctx);
+    if (ret) {
+        return ret;
+    }
+
+    ret = sss_nss_mc_find_reply(ctx, key, key_len, false, _reply, _reply_len);
+    if (ret == ENOENT) {
+        ret = sss_nss_mc_find_reply(ctx, key, key_len, true,
+                                    _reply, _reply_len);
+    }
+
+    __sync_sub_and_fetch(&ctx->active_threads, 1);
+    return ret;
+}
+
+/* The memory cache only stores positive results. Misses are remembered by
+ * every process on its own for the time the responder published in the
+ * header, in a small table indexed by the hash of the key. The seed of the
+ * file is remembered too, so a new file drops all negative entries. */
+#define MC_NEG_SLOTS 256
+#define MC_NEG_KEY_MAX 64
+
+struct sss_nss_mc_neg_entry {
+    const struct sss_cli_mc_ctx *ctx;
+    uint32_t seed;
+    bool key2;
+    time_t expire;
+    char key[MC_NEG_KEY_MAX];
+};
+
+static struct sss_nss_mc_neg_entry sss_nss_mc_neg_table[MC_NEG_SLOTS];
+
+static struct sss_nss_mc_neg_entry *
+sss_nss_mc_neg_entry(struct sss_cli_mc_ctx *ctx, const char *key,
+                     size_t key_len)
+{
+    uint32_t hash;
+
+    hash = sss_nss_mc_hash(ctx, key, key_len + 1);
+    return &sss_nss_mc_neg_table[hash % MC_NEG_SLOTS];
+}
+
+bool sss_nss_mc_neg_check(const char *name, struct sss_cli_mc_ctx *ctx,
+                          const char *key, bool key2)
+{
+    struct sss_nss_mc_neg_entry *entry;
+    size_t key_len;
+    bool found = false;
+    int ret;
+
+    key_len = strlen(key);
+    if (key_len >= MC_NEG_KEY_MAX) {
+        return false;
+    }
+
+    ret = sss_nss_mc_get_ctx(name, ctx);
+    if (ret) {
+        return false;
+    }
+
+    if (ctx->neg_timeout == 0) {
+        goto done;
+    }
+
+    entry = sss_nss_mc_neg_entry(ctx, key, key_len);
+
+    sss_nss_mc_lock();
+    if (entry->ctx == ctx
+            && entry->seed == ctx->seed
+            && entry->key2 == key2
+            && entry->expire >= time(NULL)
+            && strcmp(entry->key, key) == 0) {
+        found = true;
+    }
+    sss_nss_mc_unlock();
+
+done:
+    __sync_sub_and_fetch(&ctx->active_threads, 1);
+    return found;
+}
+
+void sss_nss_mc_neg_add(const char *name, struct sss_cli_mc_ctx *ctx,
+                        const char *key, bool key2)
+{
+    struct sss_nss_mc_neg_entry *entry;
+    size_t key_len;
+    int ret;
+
+    key_len = strlen(key);
+    if (key_len >= MC_NEG_KEY_MAX) {
+        return;
+    }
+
+    ret = sss_nss_mc_get_ctx(name, ctx);
+    if (ret) {
+        return;
+    }
+
+    if (ctx->neg_timeout == 0) {
+        goto done;
+    }
+
+    entry = sss_nss_mc_neg_entry(ctx, key, key_len);
+
+    sss_nss_mc_lock();
+    entry->ctx = ctx;
+    entry->seed = ctx->seed;
+    entry->key2 = key2;
+    entry->expire = time(NULL) + ctx->neg_timeout;
+    memcpy(entry->key, key, key_len + 1);
+    sss_nss_mc_unlock();
+
+done:
+    __sync_sub_and_fetch(&ctx->active_threads, 1);
+}
@@ -30,7 +30,7 @@
 #include "shared/safealign.h"
 
 static struct sss_cli_mc_ctx gr_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
-                                           NULL, 0, 0 };
+                                           NULL, 0, 0, 0 };
 
 static errno_t sss_nss_mc_parse_result(struct sss_mc_rec *rec,
                                        struct group *result,
@@ -109,7 +109,7 @@ errno_t sss_nss_mc_getgrnam(const char *name, size_t name_len,
     struct sss_mc_rec *rec = NULL;
     struct sss_mc_grp_data *data;
     char *rec_name;
-    uint32_t hash;
+    struct sss_nss_mc_lookup lk;
     uint32_t slot;
     int ret;
     const size_t strs_offset = offsetof(struct sss_mc_grp_data, strs);
@@ -124,8 +124,7 @@ errno_t sss_nss_mc_getgrnam(const char *name, size_t name_len,
     data_size = gr_mc_ctx.dt_size;
 
     /* hashes are calculated including the NULL terminator */
-    hash = sss_nss_mc_hash(&gr_mc_ctx, name, name_len + 1);
-    slot = gr_mc_ctx.hash_table[hash];
+    slot = sss_nss_mc_lookup_first(&gr_mc_ctx, &lk, name, name_len + 1, false);
 
     /* If slot is not within the bounds of mmapped region and
      * it's value is not MC_INVALID_VAL, then the cache is
@@ -141,9 +140,9 @@ errno_t sss_nss_mc_getgrnam(const char *name, size_t name_len,
         }
 
         /* check record matches what we are searching for */
-        if (hash != rec->hash1) {
+        if (lk.hash != rec->hash1) {
             /* if name hash does not match we can skip this immediately */
-            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            slot = sss_nss_mc_lookup_next(&gr_mc_ctx, &lk, rec);
             continue;
         }
 
@@ -164,7 +163,7 @@ errno_t sss_nss_mc_getgrnam(const char *name, size_t name_len,
             break;
         }
 
-        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_nss_mc_lookup_next(&gr_mc_ctx, &lk, rec);
     }
 
     if (!MC_SLOT_WITHIN_BOUNDS(slot, data_size)) {
@@ -172,6 +171,11 @@ errno_t sss_nss_mc_getgrnam(const char *name, size_t name_len,
         goto done;
     }
 
+    if (sss_nss_mc_rec_is_stale(&gr_mc_ctx, rec)) {
+        ret = ENOENT;
+        goto done;
+    }
+
     ret = sss_nss_mc_parse_result(rec, result, buffer, buflen);
 
 done:
@@ -187,7 +191,7 @@ errno_t sss_nss_mc_getgrgid(gid_t gid,
     struct sss_mc_rec *rec = NULL;
     struct sss_mc_grp_data *data;
     char gidstr[11];
-    uint32_t hash;
+    struct sss_nss_mc_lookup lk;
     uint32_t slot;
     int len;
     int ret;
@@ -204,8 +208,7 @@ errno_t sss_nss_mc_getgrgid(gid_t gid,
     }
 
     /* hashes are calculated including the NULL terminator */
-    hash = sss_nss_mc_hash(&gr_mc_ctx, gidstr, len+1);
-    slot = gr_mc_ctx.hash_table[hash];
+    slot = sss_nss_mc_lookup_first(&gr_mc_ctx, &lk, gidstr, len+1, true);
 
     /* If slot is not within the bounds of mmapped region and
      * it's value is not MC_INVALID_VAL, then the cache is
@@ -221,9 +224,9 @@ errno_t sss_nss_mc_getgrgid(gid_t gid,
         }
 
         /* check record matches what we are searching for */
-        if (hash != rec->hash2) {
+        if (lk.hash != rec->hash2) {
             /* if uid hash does not match we can skip this immediately */
-            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            slot = sss_nss_mc_lookup_next(&gr_mc_ctx, &lk, rec);
             continue;
         }
 
@@ -232,7 +235,7 @@ errno_t sss_nss_mc_getgrgid(gid_t gid,
             break;
         }
 
-        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_nss_mc_lookup_next(&gr_mc_ctx, &lk, rec);
     }
 
     if (!MC_SLOT_WITHIN_BOUNDS(slot, gr_mc_ctx.dt_size)) {
@@ -240,6 +243,11 @@ errno_t sss_nss_mc_getgrgid(gid_t gid,
         goto done;
     }
 
+    if (sss_nss_mc_rec_is_stale(&gr_mc_ctx, rec)) {
+        ret = ENOENT;
+        goto done;
+    }
+
     ret = sss_nss_mc_parse_result(rec, result, buffer, buflen);
 
 done:
@@ -248,3 +256,13 @@ done:
     return ret;
 }
 
+
+bool sss_nss_mc_getgr_is_negative(const char *key, bool by_gid)
+{
+    return sss_nss_mc_neg_check("group", &gr_mc_ctx, key, by_gid);
+}
+
+void sss_nss_mc_getgr_set_negative(const char *key, bool by_gid)
+{
+    sss_nss_mc_neg_add("group", &gr_mc_ctx, key, by_gid);
+}
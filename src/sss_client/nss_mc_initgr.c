@@ -33,7 +33,7 @@
 #include "shared/safealign.h"
 
 static struct sss_cli_mc_ctx initgr_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
-                                               NULL, 0, 0 };
+                                               NULL, 0, 0, 0 };
 
 static errno_t sss_nss_mc_parse_result(struct sss_mc_rec *rec,
                                        long int *start, long int *size,
@@ -90,7 +90,7 @@ errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
     struct sss_mc_rec *rec = NULL;
     struct sss_mc_initgr_data *data;
     char *rec_name;
-    uint32_t hash;
+    struct sss_nss_mc_lookup lk;
     uint32_t slot;
     int ret;
     const size_t data_offset = offsetof(struct sss_mc_initgr_data, gids);
@@ -105,8 +105,8 @@ errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
     data_size = initgr_mc_ctx.dt_size;
 
     /* hashes are calculated including the NULL terminator */
-    hash = sss_nss_mc_hash(&initgr_mc_ctx, name, name_len + 1);
-    slot = initgr_mc_ctx.hash_table[hash];
+    slot = sss_nss_mc_lookup_first(&initgr_mc_ctx, &lk,
+                                   name, name_len + 1, false);
 
     /* If slot is not within the bounds of mmapped region and
      * it's value is not MC_INVALID_VAL, then the cache is
@@ -122,9 +122,9 @@ errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
         }
 
         /* check record matches what we are searching for */
-        if (hash != rec->hash1) {
+        if (lk.hash != rec->hash1) {
             /* if name hash does not match we can skip this immediately */
-            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            slot = sss_nss_mc_lookup_next(&initgr_mc_ctx, &lk, rec);
             continue;
         }
 
@@ -147,7 +147,7 @@ errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
             break;
         }
 
-        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_nss_mc_lookup_next(&initgr_mc_ctx, &lk, rec);
     }
 
     if (!MC_SLOT_WITHIN_BOUNDS(slot, data_size)) {
@@ -155,6 +155,11 @@ errno_t sss_nss_mc_initgroups_dyn(const char *name, size_t name_len,
         goto done;
     }
 
+    if (sss_nss_mc_rec_is_stale(&initgr_mc_ctx, rec)) {
+        ret = ENOENT;
+        goto done;
+    }
+
     ret = sss_nss_mc_parse_result(rec, start, size, groups, limit);
 
 done:
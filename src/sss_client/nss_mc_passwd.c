@@ -29,7 +29,7 @@
 #include "nss_mc.h"
 
 static struct sss_cli_mc_ctx pw_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
-                                           NULL, 0, 0 };
+                                           NULL, 0, 0, 0 };
 
 static errno_t sss_nss_mc_parse_result(struct sss_mc_rec *rec,
                                        struct passwd *result,
@@ -102,7 +102,7 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
     struct sss_mc_rec *rec = NULL;
     struct sss_mc_pwd_data *data;
     char *rec_name;
-    uint32_t hash;
+    struct sss_nss_mc_lookup lk;
     uint32_t slot;
     int ret;
     const size_t strs_offset = offsetof(struct sss_mc_pwd_data, strs);
@@ -117,8 +117,7 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
     data_size = pw_mc_ctx.dt_size;
 
     /* hashes are calculated including the NULL terminator */
-    hash = sss_nss_mc_hash(&pw_mc_ctx, name, name_len + 1);
-    slot = pw_mc_ctx.hash_table[hash];
+    slot = sss_nss_mc_lookup_first(&pw_mc_ctx, &lk, name, name_len + 1, false);
 
     /* If slot is not within the bounds of mmapped region and
      * it's value is not MC_INVALID_VAL, then the cache is
@@ -134,9 +133,9 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
         }
 
         /* check record matches what we are searching for */
-        if (hash != rec->hash1) {
+        if (lk.hash != rec->hash1) {
             /* if name hash does not match we can skip this immediately */
-            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            slot = sss_nss_mc_lookup_next(&pw_mc_ctx, &lk, rec);
             continue;
         }
 
@@ -157,7 +156,7 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
             break;
         }
 
-        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_nss_mc_lookup_next(&pw_mc_ctx, &lk, rec);
     }
 
     if (!MC_SLOT_WITHIN_BOUNDS(slot, data_size)) {
@@ -165,6 +164,11 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
         goto done;
     }
 
+    if (sss_nss_mc_rec_is_stale(&pw_mc_ctx, rec)) {
+        ret = ENOENT;
+        goto done;
+    }
+
     ret = sss_nss_mc_parse_result(rec, result, buffer, buflen);
 
 done:
@@ -180,7 +184,7 @@ errno_t sss_nss_mc_getpwuid(uid_t uid,
     struct sss_mc_rec *rec = NULL;
     struct sss_mc_pwd_data *data;
     char uidstr[11];
-    uint32_t hash;
+    struct sss_nss_mc_lookup lk;
     uint32_t slot;
     int len;
     int ret;
@@ -197,8 +201,7 @@ errno_t sss_nss_mc_getpwuid(uid_t uid,
     }
 
     /* hashes are calculated including the NULL terminator */
-    hash = sss_nss_mc_hash(&pw_mc_ctx, uidstr, len+1);
-    slot = pw_mc_ctx.hash_table[hash];
+    slot = sss_nss_mc_lookup_first(&pw_mc_ctx, &lk, uidstr, len+1, true);
 
     /* If slot is not within the bounds of mmapped region and
      * it's value is not MC_INVALID_VAL, then the cache is
@@ -214,9 +217,9 @@ errno_t sss_nss_mc_getpwuid(uid_t uid,
         }
 
         /* check record matches what we are searching for */
-        if (hash != rec->hash2) {
+        if (lk.hash != rec->hash2) {
             /* if uid hash does not match we can skip this immediately */
-            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            slot = sss_nss_mc_lookup_next(&pw_mc_ctx, &lk, rec);
             continue;
         }
 
@@ -225,7 +228,7 @@ errno_t sss_nss_mc_getpwuid(uid_t uid,
             break;
         }
 
-        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+        slot = sss_nss_mc_lookup_next(&pw_mc_ctx, &lk, rec);
     }
 
     if (!MC_SLOT_WITHIN_BOUNDS(slot, pw_mc_ctx.dt_size)) {
@@ -233,6 +236,11 @@ errno_t sss_nss_mc_getpwuid(uid_t uid,
         goto done;
     }
 
+    if (sss_nss_mc_rec_is_stale(&pw_mc_ctx, rec)) {
+        ret = ENOENT;
+        goto done;
+    }
+
     ret = sss_nss_mc_parse_result(rec, result, buffer, buflen);
 
 done:
@@ -241,3 +249,13 @@ done:
     return ret;
 }
 
+
+bool sss_nss_mc_getpw_is_negative(const char *key, bool by_uid)
+{
+    return sss_nss_mc_neg_check("passwd", &pw_mc_ctx, key, by_uid);
+}
+
+void sss_nss_mc_getpw_set_negative(const char *key, bool by_uid)
+{
+    sss_nss_mc_neg_add("passwd", &pw_mc_ctx, key, by_uid);
+}
@@ -0,0 +1,68 @@
+/*
+ * System Security Services Daemon. NSS client interface
+ *
+ * Copyright (C) 2020 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* SERVICES database NSS interface using mmap cache */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <arpa/inet.h>
+#include "nss_mc.h"
+#include "sss_cli.h"
+
+/* name and protocol are limited to SSS_NAME_MAX by the callers */
+#define SVC_KEY_MAX (2 * SSS_NAME_MAX + 16)
+
+static struct sss_cli_mc_ctx svc_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
+                                            NULL, 0, 0, 0 };
+
+errno_t sss_nss_mc_getservbyname(const char *name, const char *protocol,
+                                 uint8_t **_reply, size_t *_reply_len)
+{
+    char key[SVC_KEY_MAX];
+    int ret;
+
+    ret = snprintf(key, sizeof(key), MC_SVC_BY_NAME_KEY, name,
+                   protocol == NULL ? "" : protocol);
+    if (ret < 0 || ret >= sizeof(key)) {
+        return EINVAL;
+    }
+
+    return sss_nss_mc_get_reply("services", &svc_mc_ctx, key,
+                                _reply, _reply_len);
+}
+
+errno_t sss_nss_mc_getservbyport(int port, const char *protocol,
+                                 uint8_t **_reply, size_t *_reply_len)
+{
+    char key[SVC_KEY_MAX];
+    int ret;
+
+    /* the port is passed in network byte order */
+    ret = snprintf(key, sizeof(key), MC_SVC_BY_PORT_KEY,
+                   (unsigned int)ntohs((uint16_t)port),
+                   protocol == NULL ? "" : protocol);
+    if (ret < 0 || ret >= sizeof(key)) {
+        return EINVAL;
+    }
+
+    return sss_nss_mc_get_reply("services", &svc_mc_ctx, key,
+                                _reply, _reply_len);
+}
@@ -0,0 +1,188 @@
+/*
+ * System Security Services Daemon. NSS client interface
+ *
+ * Copyright (C) 2020 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* SID mapping database interface using mmap cache */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "nss_mc.h"
+
+static struct sss_cli_mc_ctx sid_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
+                                            NULL, 0, 0, 0 };
+
+/* Returns the string rel_ptr points to or NULL if it is not a zero
+ * terminated string inside of the strings of the record */
+static const char *sss_nss_mc_sid_str(struct sss_mc_sid_data *data,
+                                      rel_ptr_t ptr)
+{
+    const size_t strs_offset = offsetof(struct sss_mc_sid_data, strs);
+    const char *str;
+
+    if (ptr < strs_offset || ptr >= strs_offset + data->strs_len) {
+        return NULL;
+    }
+
+    str = (const char *)data + ptr;
+    if (memchr(str, '\0', strs_offset + data->strs_len - ptr) == NULL) {
+        return NULL;
+    }
+
+    return str;
+}
+
+errno_t sss_nss_mc_get_sid(const char *key, size_t key_len, bool by_name,
+                           char **_sid, char **_name,
+                           uint32_t *_id, uint32_t *_type)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_sid_data *data = NULL;
+    struct sss_nss_mc_lookup lk;
+    const char *rec_key = NULL;
+    const char *rec_sid = NULL;
+    const char *rec_name = NULL;
+    char *sid = NULL;
+    char *name = NULL;
+    uint32_t rec_hash;
+    uint32_t slot;
+    size_t data_size;
+    int ret;
+
+    ret = sss_nss_mc_get_ctx("sid", &sid_mc_ctx);
+    if (ret) {
+        return ret;
+    }
+
+    /* Get max size of data table. */
+    data_size = sid_mc_ctx.dt_size;
+
+    /* hashes are calculated including the NULL terminator,
+     * names are the second key of the records */
+    slot = sss_nss_mc_lookup_first(&sid_mc_ctx, &lk, key, key_len + 1,
+                                   by_name);
+
+    /* If slot is not within the bounds of mmapped region and
+     * it's value is not MC_INVALID_VAL, then the cache is
+     * probably corrupted. */
+    while (MC_SLOT_WITHIN_BOUNDS(slot, data_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(&sid_mc_ctx, slot, &rec);
+        if (ret) {
+            goto done;
+        }
+
+        /* check record matches what we are searching for */
+        rec_hash = by_name ? rec->hash2 : rec->hash1;
+        if (lk.hash != rec_hash) {
+            /* if key hash does not match we can skip this immediately */
+            slot = sss_nss_mc_lookup_next(&sid_mc_ctx, &lk, rec);
+            continue;
+        }
+
+        data = (struct sss_mc_sid_data *)rec->data;
+        /* Integrity check
+         * - all strings must be within copy of record
+         * - all pointers must point to zero terminated strings in strs */
+        if (rec->len < sizeof(struct sss_mc_rec)
+                           + sizeof(struct sss_mc_sid_data)
+            || data->strs_len > rec->len - sizeof(struct sss_mc_rec)
+                                         - sizeof(struct sss_mc_sid_data)) {
+            ret = ENOENT;
+            goto done;
+        }
+
+        rec_key = sss_nss_mc_sid_str(data, data->key);
+        rec_sid = sss_nss_mc_sid_str(data, data->sid);
+        rec_name = sss_nss_mc_sid_str(data, data->name);
+        if (rec_key == NULL || rec_sid == NULL || rec_name == NULL) {
+            ret = ENOENT;
+            goto done;
+        }
+
+        if (by_name) {
+            /* only records of objects are found by name */
+            if (data->key == data->sid && strcmp(key, rec_name) == 0) {
+                break;
+            }
+        } else if (strcmp(key, rec_key) == 0) {
+            break;
+        }
+
+        slot = sss_nss_mc_lookup_next(&sid_mc_ctx, &lk, rec);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, data_size)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    /* additional checks before filling result*/
+    if (rec->expire < time(NULL) || sss_nss_mc_rec_is_stale(&sid_mc_ctx, rec)) {
+        /* entry is now invalid */
+        ret = ENOENT;
+        goto done;
+    }
+
+    if (_sid != NULL) {
+        sid = strdup(rec_sid);
+        if (sid == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    if (_name != NULL) {
+        name = strdup(rec_name);
+        if (name == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    if (_sid != NULL) {
+        *_sid = sid;
+        sid = NULL;
+    }
+    if (_name != NULL) {
+        *_name = name;
+        name = NULL;
+    }
+    if (_id != NULL) {
+        *_id = data->id;
+    }
+    if (_type != NULL) {
+        *_type = data->type;
+    }
+
+    ret = 0;
+
+done:
+    free(sid);
+    free(name);
+    free(rec);
+    __sync_sub_and_fetch(&sid_mc_ctx.active_threads, 1);
+    return ret;
+}
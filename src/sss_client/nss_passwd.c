@@ -25,6 +25,8 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 #include "sss_cli.h"
 #include "nss_mc.h"
@@ -136,6 +138,7 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
     size_t replen, len, name_len;
     uint32_t num_results;
     enum nss_status nret;
+    bool mux;
     int ret;
 
     /* Caught once glibc passing in buffer == 0x0 */
@@ -168,34 +171,50 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
         break;
     }
 
+    /* the lookup might have found nothing a moment ago */
+    if (sss_nss_mc_getpw_is_negative(name, false)) {
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
+    }
+
     rd.len = name_len + 1;
     rd.data = name;
 
-    sss_nss_lock();
+    mux = sss_nss_mux_enabled();
+    if (!mux) {
+        sss_nss_lock();
+
+        /* previous thread might already initialize entry in mmap cache */
+        ret = sss_nss_mc_getpwnam(name, name_len, result, buffer, buflen);
+        switch (ret) {
+        case 0:
+            *errnop = 0;
+            nret = NSS_STATUS_SUCCESS;
+            goto out;
+        case ERANGE:
+            *errnop = ERANGE;
+            nret = NSS_STATUS_TRYAGAIN;
+            goto out;
+        case ENOENT:
+            /* fall through, we need to actively ask the parent
+             * if no entry is found */
+            break;
+        default:
+            /* if using the mmapped cache failed,
+             * fall back to socket based comms */
+            break;
+        }
+    }
 
-    /* previous thread might already initialize entry in mmap cache */
-    ret = sss_nss_mc_getpwnam(name, name_len, result, buffer, buflen);
-    switch (ret) {
-    case 0:
-        *errnop = 0;
+    if (sss_nss_get_retry_reply(SSS_NSS_GETPWNAM, &rd, &repbuf, &replen)) {
         nret = NSS_STATUS_SUCCESS;
-        goto out;
-    case ERANGE:
-        *errnop = ERANGE;
-        nret = NSS_STATUS_TRYAGAIN;
-        goto out;
-    case ENOENT:
-        /* fall through, we need to actively ask the parent
-         * if no entry is found */
-        break;
-    default:
-        /* if using the mmapped cache failed,
-         * fall back to socket based comms */
-        break;
+    } else if (mux) {
+        nret = sss_nss_make_request_mux(SSS_NSS_GETPWNAM, &rd,
+                                        &repbuf, &replen, errnop);
+    } else {
+        nret = sss_nss_make_request(SSS_NSS_GETPWNAM, &rd,
+                                    &repbuf, &replen, errnop);
     }
-
-    nret = sss_nss_make_request(SSS_NSS_GETPWNAM, &rd,
-                                &repbuf, &replen, errnop);
     if (nret != NSS_STATUS_SUCCESS) {
         goto out;
     }
@@ -210,6 +229,7 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
     /* no results if not found */
     if (num_results == 0) {
         free(repbuf);
+        sss_nss_mc_getpw_set_negative(name, false);
         nret = NSS_STATUS_NOTFOUND;
         goto out;
     }
@@ -224,7 +244,11 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
 
     len = replen - 8;
     ret = sss_nss_getpw_readrep(&pwrep, repbuf+8, &len);
-    free(repbuf);
+    if (ret == ERANGE) {
+        sss_nss_save_retry_reply(SSS_NSS_GETPWNAM, &rd, &repbuf, replen);
+    } else {
+        free(repbuf);
+    }
     if (ret) {
         *errnop = ret;
         nret = NSS_STATUS_TRYAGAIN;
@@ -234,7 +258,9 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
     nret = NSS_STATUS_SUCCESS;
 
 out:
-    sss_nss_unlock();
+    if (!mux) {
+        sss_nss_unlock();
+    }
     return nret;
 }
 
@@ -248,6 +274,8 @@ enum nss_status _nss_sss_getpwuid_r(uid_t uid, struct passwd *result,
     uint32_t num_results;
     enum nss_status nret;
     uint32_t user_uid;
+    char id_key[11];
+    bool mux;
     int ret;
 
     /* Caught once glibc passing in buffer == 0x0 */
@@ -274,35 +302,52 @@ enum nss_status _nss_sss_getpwuid_r(uid_t uid, struct passwd *result,
         break;
     }
 
+    /* the lookup might have found nothing a moment ago */
+    snprintf(id_key, sizeof(id_key), "%"PRIu32, (uint32_t)uid);
+    if (sss_nss_mc_getpw_is_negative(id_key, true)) {
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
+    }
+
     user_uid = uid;
     rd.len = sizeof(uint32_t);
     rd.data = &user_uid;
 
-    sss_nss_lock();
+    mux = sss_nss_mux_enabled();
+    if (!mux) {
+        sss_nss_lock();
+
+        /* previous thread might already initialize entry in mmap cache */
+        ret = sss_nss_mc_getpwuid(uid, result, buffer, buflen);
+        switch (ret) {
+        case 0:
+            *errnop = 0;
+            nret = NSS_STATUS_SUCCESS;
+            goto out;
+        case ERANGE:
+            *errnop = ERANGE;
+            nret = NSS_STATUS_TRYAGAIN;
+            goto out;
+        case ENOENT:
+            /* fall through, we need to actively ask the parent
+             * if no entry is found */
+            break;
+        default:
+            /* if using the mmapped cache failed,
+             * fall back to socket based comms */
+            break;
+        }
+    }
 
-    /* previous thread might already initialize entry in mmap cache */
-    ret = sss_nss_mc_getpwuid(uid, result, buffer, buflen);
-    switch (ret) {
-    case 0:
-        *errnop = 0;
+    if (sss_nss_get_retry_reply(SSS_NSS_GETPWUID, &rd, &repbuf, &replen)) {
         nret = NSS_STATUS_SUCCESS;
-        goto out;
-    case ERANGE:
-        *errnop = ERANGE;
-        nret = NSS_STATUS_TRYAGAIN;
-        goto out;
-    case ENOENT:
-        /* fall through, we need to actively ask the parent
-         * if no entry is found */
-        break;
-    default:
-        /* if using the mmapped cache failed,
-         * fall back to socket based comms */
-        break;
+    } else if (mux) {
+        nret = sss_nss_make_request_mux(SSS_NSS_GETPWUID, &rd,
+                                        &repbuf, &replen, errnop);
+    } else {
+        nret = sss_nss_make_request(SSS_NSS_GETPWUID, &rd,
+                                    &repbuf, &replen, errnop);
     }
-
-    nret = sss_nss_make_request(SSS_NSS_GETPWUID, &rd,
-                                &repbuf, &replen, errnop);
     if (nret != NSS_STATUS_SUCCESS) {
         goto out;
     }
@@ -317,6 +362,7 @@ enum nss_status _nss_sss_getpwuid_r(uid_t uid, struct passwd *result,
     /* no results if not found */
     if (num_results == 0) {
         free(repbuf);
+        sss_nss_mc_getpw_set_negative(id_key, true);
         nret = NSS_STATUS_NOTFOUND;
         goto out;
     }
@@ -331,7 +377,11 @@ enum nss_status _nss_sss_getpwuid_r(uid_t uid, struct passwd *result,
 
     len = replen - 8;
     ret = sss_nss_getpw_readrep(&pwrep, repbuf+8, &len);
-    free(repbuf);
+    if (ret == ERANGE) {
+        sss_nss_save_retry_reply(SSS_NSS_GETPWUID, &rd, &repbuf, replen);
+    } else {
+        free(repbuf);
+    }
     if (ret) {
         *errnop = ret;
         nret = NSS_STATUS_TRYAGAIN;
@@ -341,7 +391,9 @@ enum nss_status _nss_sss_getpwuid_r(uid_t uid, struct passwd *result,
     nret = NSS_STATUS_SUCCESS;
 
 out:
-    sss_nss_unlock();
+    if (!mux) {
+        sss_nss_unlock();
+    }
     return nret;
 }
 
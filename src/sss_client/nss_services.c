@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "sss_cli.h"
+#include "nss_mc.h"
 
 static struct sss_nss_getservent_data {
     size_t len;
@@ -158,6 +159,30 @@ sss_nss_getsvc_readrep(struct sss_nss_svc_rep *sr,
     return EOK;
 }
 
+/* Parses the result data found in the memory cache */
+static enum nss_status
+sss_nss_getsvc_mc_readrep(uint8_t *repbuf, size_t replen,
+                          struct servent *result,
+                          char *buffer, size_t buflen,
+                          int *errnop)
+{
+    struct sss_nss_svc_rep svcrep;
+    int ret;
+
+    svcrep.result = result;
+    svcrep.buffer = buffer;
+    svcrep.buflen = buflen;
+
+    ret = sss_nss_getsvc_readrep(&svcrep, repbuf, &replen);
+    free(repbuf);
+    if (ret) {
+        *errnop = ret;
+        return NSS_STATUS_TRYAGAIN;
+    }
+
+    return NSS_STATUS_SUCCESS;
+}
+
 enum nss_status
 _nss_sss_getservbyname_r(const char *name,
                          const char *protocol,
@@ -196,6 +221,12 @@ _nss_sss_getservbyname_r(const char *name,
         }
     }
 
+    ret = sss_nss_mc_getservbyname(name, protocol, &repbuf, &replen);
+    if (ret == 0) {
+        return sss_nss_getsvc_mc_readrep(repbuf, replen, result,
+                                         buffer, buflen, errnop);
+    }
+
     rd.len = name_len + proto_len + 2;
     data = malloc(sizeof(uint8_t)*rd.len);
     if (data == NULL) {
@@ -294,6 +325,12 @@ _nss_sss_getservbyport_r(int port, const char *protocol,
         }
     }
 
+    ret = sss_nss_mc_getservbyport(port, protocol, &repbuf, &replen);
+    if (ret == 0) {
+        return sss_nss_getsvc_mc_readrep(repbuf, replen, result,
+                                         buffer, buflen, errnop);
+    }
+
     rd.len = sizeof(uint32_t)*2 + proto_len + 1;
     data = malloc(sizeof(uint8_t)*rd.len);
     if (data == NULL) {
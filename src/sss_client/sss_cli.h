@@ -30,6 +30,7 @@
 #include <grp.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <limits.h>
 
 #include "shared/safealign.h"
@@ -81,6 +82,8 @@ enum sss_cli_command {
 
     SSS_NSS_GETPWNAM_EX    = 0x0019,
     SSS_NSS_GETPWUID_EX    = 0x001A,
+    SSS_NSS_GETPWNAM_MULTI = 0x001B, /**< see SSS_NSS_MULTI_MAX_ENTRIES */
+    SSS_NSS_GETPWUID_MULTI = 0x001C,
 
 /* group */
 
@@ -93,6 +96,8 @@ enum sss_cli_command {
 
     SSS_NSS_GETGRNAM_EX    = 0x0029,
     SSS_NSS_GETGRGID_EX    = 0x002A,
+    SSS_NSS_GETGRNAM_MULTI = 0x002B,
+    SSS_NSS_GETGRGID_MULTI = 0x002C,
     SSS_NSS_INITGR_EX      = 0x002E,
 
 #if 0
@@ -127,7 +132,10 @@ enum sss_cli_command {
     SSS_NSS_SETNETGRENT    = 0x0061,
     SSS_NSS_GETNETGRENT    = 0x0062,
     SSS_NSS_ENDNETGRENT    = 0x0063,
-    /* SSS_NSS_INNETGR     = 0x0064, */
+    SSS_NSS_INNETGR        = 0x0064, /**< checks whether a (host, user,
+                                      * domain) triple is a member of a
+                                      * netgroup, including its nested
+                                      * netgroups */
 
 /* networks */
 
@@ -176,6 +184,11 @@ enum sss_cli_command {
 /* SUDO */
     SSS_SUDO_GET_SUDORULES = 0x00C1,
     SSS_SUDO_GET_DEFAULTS  = 0x00C2,
+    SSS_SUDO_GET_SUDORULES_GEN = 0x00C3, /**< like SSS_SUDO_GET_SUDORULES,
+                                              but the query starts with the
+                                              generation of the rule set the
+                                              client has and the reply with
+                                              the current generation */
 
 /* autofs */
     SSS_AUTOFS_SETAUTOMNTENT    = 0x00D1,
@@ -282,6 +295,12 @@ SSS_NSS_GETSIDBYGID   = 0x0119, /**< Takes an unsigned 32bit integer (POSIX GID)
                                      and return the zero terminated string
                                      representation of the SID of the object
                                      with the given UID. */
+SSS_NSS_GETIDBYSID_MULTI  = 0x011A, /**< see SSS_NSS_MULTI_MAX_ENTRIES, the
+                                         entries are zero terminated string
+                                         representations of SIDs */
+SSS_NSS_GETSIDBYID_MULTI  = 0x011B,
+SSS_NSS_GETSIDBYUID_MULTI = 0x011C,
+SSS_NSS_GETSIDBYGID_MULTI = 0x011D,
 };
 
 /**
@@ -383,6 +402,14 @@ enum pam_item_type {
 #define PAM_CLI_FLAGS_REQUIRE_CERT_AUTH (1 << 9)
 
 #define SSS_NSS_MAX_ENTRIES 256
+
+/* The *_MULTI requests start with the number of entries as unsigned 32bit
+ * integer, followed by the POSIX IDs or the zero terminated names. The
+ * reply starts with the number of entries and a reserved field, then for
+ * every requested entry the length of its reply as unsigned 32bit integer
+ * and the reply of the matching single entry request. A length of 0 means
+ * that the entry was not found. */
+#define SSS_NSS_MULTI_MAX_ENTRIES 1024
 #define SSS_NSS_HEADER_SIZE (sizeof(uint32_t) * 4)
 struct sss_cli_req_data {
     size_t len;
@@ -615,6 +642,12 @@ enum sss_netgr_rep_type {
     SSS_NETGR_REP_GROUP
 };
 
+/* Fields of the SSS_NSS_INNETGR request which were given by the caller,
+ * a missing field matches any value. */
+#define SSS_INNETGR_HOST   0x01
+#define SSS_INNETGR_USER   0x02
+#define SSS_INNETGR_DOMAIN 0x04
+
 enum sss_cli_error_codes {
     ESSS_SSS_CLI_ERROR_START = 0x1000,
     ESSS_BAD_PRIV_SOCKET,
@@ -634,12 +667,42 @@ enum nss_status sss_nss_make_request(enum sss_cli_command cmd,
                                      uint8_t **repbuf, size_t *replen,
                                      int *errnop);
 
+/* If the process set SSS_NSS_ADAPTIVE_TIMEOUT to "YES", @timeout may be
+ * shortened or the request may fail with NSS_STATUS_UNAVAIL right away
+ * depending on the health the NSS responder publishes, see common.c. */
 enum nss_status sss_nss_make_request_timeout(enum sss_cli_command cmd,
                                              struct sss_cli_req_data *rd,
                                              int timeout,
                                              uint8_t **repbuf, size_t *replen,
                                              int *errnop);
 
+/* Returns true if the process asked for per-thread NSS connections by
+ * setting SSS_NSS_THREAD_SOCKETS to "YES" or for the multiplexed NSS
+ * connection by setting SSS_NSS_MULTIPLEX to "YES" and the responder
+ * supports it. Requests sent with sss_nss_make_request_mux() must not hold
+ * sss_nss_lock(), several threads can wait for their replies at the same
+ * time. If the connection turns out to be unusable the request is sent the
+ * classic way, serialized by sss_nss_lock(). */
+bool sss_nss_mux_enabled(void);
+
+enum nss_status sss_nss_make_request_mux(enum sss_cli_command cmd,
+                                         struct sss_cli_req_data *rd,
+                                         uint8_t **repbuf, size_t *replen,
+                                         int *errnop);
+
+/* A reply that did not fit into the buffer of the caller is kept for the
+ * calling thread, keyed by the command and the request data, so that the
+ * retry with a larger buffer is served without another request sent to
+ * the responder. The save takes ownership of *repbuf and sets it to NULL,
+ * the get hands the reply over and returns false if there is none. */
+void sss_nss_save_retry_reply(enum sss_cli_command cmd,
+                              struct sss_cli_req_data *rd,
+                              uint8_t **repbuf, size_t replen);
+
+bool sss_nss_get_retry_reply(enum sss_cli_command cmd,
+                             struct sss_cli_req_data *rd,
+                             uint8_t **repbuf, size_t *replen);
+
 int sss_pam_make_request(enum sss_cli_command cmd,
                          struct sss_cli_req_data *rd,
                          uint8_t **repbuf, size_t *replen,
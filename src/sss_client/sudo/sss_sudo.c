@@ -32,6 +32,7 @@
 
 static int sss_sudo_create_query(uid_t uid,
                                  const char *username,
+                                 const uint64_t *generation,
                                  uint8_t **_query,
                                  size_t *_query_len);
 
@@ -41,9 +42,13 @@ static void sss_sudo_free_rules(unsigned int num_rules,
 static void sss_sudo_free_attrs(unsigned int num_attrs,
                                 struct sss_sudo_attr *attrs);
 
+/* If _generation is not NULL, the command is one that carries the
+ * generation of the rule set in the query and in the reply, see
+ * sss_sudo_send_recv_generation(). */
 static int sss_sudo_send_recv_generic(enum sss_cli_command command,
                                       uid_t uid,
                                       const char *username,
+                                      uint64_t *_generation,
                                       uint32_t *_error,
                                       char **_domainname,
                                       struct sss_sudo_result **_result)
@@ -53,12 +58,15 @@ static int sss_sudo_send_recv_generic(enum sss_cli_command command,
     size_t query_len = 0;
     uint8_t *reply_buf = NULL;
     size_t reply_len = 0;
+    size_t offset = 0;
+    uint32_t unchanged;
     int errnop = 0;
     int ret = 0;
 
     /* create query */
 
-    ret = sss_sudo_create_query(uid, username, &query_buf, &query_len);
+    ret = sss_sudo_create_query(uid, username, _generation,
+                                &query_buf, &query_len);
     if (ret != EOK) {
         goto done;
     }
@@ -76,9 +84,28 @@ static int sss_sudo_send_recv_generic(enum sss_cli_command command,
         goto done;
     }
 
+    if (_generation != NULL) {
+        if (reply_len < sizeof(uint64_t) + sizeof(uint32_t)) {
+            ret = EBADMSG;
+            goto done;
+        }
+
+        safealign_memcpy(_generation, reply_buf, sizeof(uint64_t), &offset);
+        SAFEALIGN_COPY_UINT32(&unchanged, reply_buf + offset, &offset);
+
+        if (unchanged) {
+            /* the rule set the caller has is still current */
+            *_error = SSS_SUDO_ERROR_OK;
+            *_result = NULL;
+            ret = EOK;
+            goto done;
+        }
+    }
+
     /* parse structure */
 
-    ret = sss_sudo_parse_response((const char*)reply_buf, reply_len,
+    ret = sss_sudo_parse_response((const char*)reply_buf + offset,
+                                  reply_len - offset,
                                   _domainname, _result, _error);
 
 done:
@@ -102,10 +129,26 @@ int sss_sudo_send_recv(uid_t uid,
     /* send query and receive response */
 
     ret = sss_sudo_send_recv_generic(SSS_SUDO_GET_SUDORULES, uid, username,
-                                     _error, NULL, _result);
+                                     NULL, _error, NULL, _result);
     return ret;
 }
 
+int sss_sudo_send_recv_generation(uid_t uid,
+                                  const char *username,
+                                  const char *domainname,
+                                  uint64_t *_generation,
+                                  uint32_t *_error,
+                                  struct sss_sudo_result **_result)
+{
+    if (username == NULL || strlen(username) == 0 || _generation == NULL) {
+        return EINVAL;
+    }
+
+    return sss_sudo_send_recv_generic(SSS_SUDO_GET_SUDORULES_GEN, uid,
+                                      username, _generation, _error, NULL,
+                                      _result);
+}
+
 int sss_sudo_send_recv_defaults(uid_t uid,
                                 const char *username,
                                 uint32_t *_error,
@@ -117,10 +160,11 @@ int sss_sudo_send_recv_defaults(uid_t uid,
     }
 
     return sss_sudo_send_recv_generic(SSS_SUDO_GET_DEFAULTS, uid, username,
-                                      _error, _domainname, _result);
+                                      NULL, _error, _domainname, _result);
 }
 
 static int sss_sudo_create_query(uid_t uid, const char *username,
+                                 const uint64_t *generation,
                                  uint8_t **_query, size_t *_query_len)
 {
     uint8_t *data = NULL;
@@ -128,12 +172,19 @@ static int sss_sudo_create_query(uid_t uid, const char *username,
     size_t data_len = sizeof(uid_t) + username_len;
     size_t offset = 0;
 
+    if (generation != NULL) {
+        data_len += sizeof(uint64_t);
+    }
+
     data = (uint8_t*)malloc(data_len * sizeof(uint8_t));
     if (data == NULL) {
         return ENOMEM;
     }
 
-    SAFEALIGN_SET_VALUE(data, uid, uid_t, &offset);
+    if (generation != NULL) {
+        SAFEALIGN_SET_VALUE(data, *generation, uint64_t, &offset);
+    }
+    SAFEALIGN_SET_VALUE(data + offset, uid, uid_t, &offset);
     memcpy(data + offset, username, username_len);
 
     *_query = data;
@@ -118,6 +118,37 @@ int sss_sudo_send_recv(uid_t uid,
                        uint32_t *_error,
                        struct sss_sudo_result **_result);
 
+/**
+ * @brief Send a request to SSSD to retrieve all SUDO rules for a given
+ * user unless they are unchanged since the caller has retrieved them.
+ *
+ * This is sss_sudo_send_recv() for callers that keep the parsed rules of a
+ * user between calls. The generation identifies the rule set of one user and
+ * is only valid for the same uid and username.
+ *
+ * @param[in] uid             The uid of the user to retrieve the rules for.
+ * @param[in] username        The username to retrieve the rules for
+ * @param[in] domainname      The domain name the user is a member of.
+ * @param[in,out] _generation On input the generation returned together with
+ *                            the rules the caller has, 0 if it has none. On
+ *                            output the generation of the current rules, 0
+ *                            if they must not be kept.
+ * @param[out] _error         See sss_sudo_send_recv().
+ * @param[out] _result        See sss_sudo_send_recv(). Set to NULL if the
+ *                            rules are unchanged, in this case _error is
+ *                            SSS_SUDO_ERROR_OK and _generation is not
+ *                            changed.
+ *
+ * @return 0 on success and other errno values on failure, see
+ *         sss_sudo_send_recv().
+ */
+int sss_sudo_send_recv_generation(uid_t uid,
+                                  const char *username,
+                                  const char *domainname,
+                                  uint64_t *_generation,
+                                  uint32_t *_error,
+                                  struct sss_sudo_result **_result);
+
 /**
  * @brief Send a request to SSSD to retrieve the default options, commonly
  * stored in the "cn=defaults" record,
@@ -28,6 +28,23 @@
 
 #include "sss_iface/sss_iface_types.h"
 
+struct _sbus_sss_invoker_args_aqauas {
+    uint16_t * arg0;
+    uint32_t * arg1;
+    const char ** arg2;
+};
+
+errno_t
+_sbus_sss_invoker_read_aqauas
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_aqauas *args);
+
+errno_t
+_sbus_sss_invoker_write_aqauas
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_aqauas *args);
+
 struct _sbus_sss_invoker_args_as {
     const char ** arg0;
 };
@@ -43,6 +60,65 @@ _sbus_sss_invoker_write_as
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_as *args);
 
+struct _sbus_sss_invoker_args_asasatatauau {
+    const char ** arg0;
+    const char ** arg1;
+    uint64_t * arg2;
+    uint64_t * arg3;
+    uint32_t * arg4;
+    uint32_t * arg5;
+};
+
+errno_t
+_sbus_sss_invoker_read_asasatatauau
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_asasatatauau *args);
+
+errno_t
+_sbus_sss_invoker_write_asasatatauau
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_asasatatauau *args);
+
+struct _sbus_sss_invoker_args_auasasas {
+    uint32_t * arg0;
+    const char ** arg1;
+    const char ** arg2;
+    const char ** arg3;
+};
+
+errno_t
+_sbus_sss_invoker_read_auasasas
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_auasasas *args);
+
+errno_t
+_sbus_sss_invoker_write_auasasas
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_auasasas *args);
+
+struct _sbus_sss_invoker_args_auauasatatatau {
+    uint32_t * arg0;
+    uint32_t * arg1;
+    const char ** arg2;
+    uint64_t * arg3;
+    uint64_t * arg4;
+    uint64_t * arg5;
+    uint32_t * arg6;
+};
+
+errno_t
+_sbus_sss_invoker_read_auauasatatatau
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_auauasatatatau *args);
+
+errno_t
+_sbus_sss_invoker_write_auauasatatatau
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_auauasatatatau *args);
+
 struct _sbus_sss_invoker_args_b {
     bool arg0;
 };
@@ -150,6 +226,22 @@ _sbus_sss_invoker_write_s
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_s *args);
 
+struct _sbus_sss_invoker_args_spayload {
+    const char * arg0;
+    struct sss_iface_payload * arg1;
+};
+
+errno_t
+_sbus_sss_invoker_read_spayload
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_spayload *args);
+
+errno_t
+_sbus_sss_invoker_write_spayload
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_spayload *args);
+
 struct _sbus_sss_invoker_args_sqq {
     const char * arg0;
     uint16_t arg1;
@@ -265,24 +357,61 @@ _sbus_sss_invoker_write_uss
    (DBusMessageIter *iter,
     struct _sbus_sss_invoker_args_uss *args);
 
-struct _sbus_sss_invoker_args_uusss {
+struct _sbus_sss_invoker_args_uu {
+    uint32_t arg0;
+    uint32_t arg1;
+};
+
+errno_t
+_sbus_sss_invoker_read_uu
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_uu *args);
+
+errno_t
+_sbus_sss_invoker_write_uu
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_uu *args);
+
+struct _sbus_sss_invoker_args_uuasss {
+    uint32_t arg0;
+    uint32_t arg1;
+    const char ** arg2;
+    const char * arg3;
+    const char * arg4;
+};
+
+errno_t
+_sbus_sss_invoker_read_uuasss
+   (TALLOC_CTX *mem_ctx,
+    DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_uuasss *args);
+
+errno_t
+_sbus_sss_invoker_write_uuasss
+   (DBusMessageIter *iter,
+    struct _sbus_sss_invoker_args_uuasss *args);
+
+struct _sbus_sss_invoker_args_uussstt {
     uint32_t arg0;
     uint32_t arg1;
     const char * arg2;
     const char * arg3;
     const char * arg4;
+    uint64_t arg5;
+    uint64_t arg6;
 };
 
 errno_t
-_sbus_sss_invoker_read_uusss
+_sbus_sss_invoker_read_uussstt
    (TALLOC_CTX *mem_ctx,
     DBusMessageIter *iter,
-    struct _sbus_sss_invoker_args_uusss *args);
+    struct _sbus_sss_invoker_args_uussstt *args);
 
 errno_t
-_sbus_sss_invoker_write_uusss
+_sbus_sss_invoker_write_uussstt
    (DBusMessageIter *iter,
-    struct _sbus_sss_invoker_args_uusss *args);
+    struct _sbus_sss_invoker_args_uussstt *args);
 
 struct _sbus_sss_invoker_args_uuus {
     uint32_t arg0;
@@ -108,6 +108,334 @@ sbus_method_in__out__recv
     return EOK;
 }
 
+struct sbus_method_in__out_asasatatauau_state {
+    struct _sbus_sss_invoker_args_asasatatauau *out;
+};
+
+static void sbus_method_in__out_asasatatauau_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in__out_asasatatauau_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method)
+{
+    struct sbus_method_in__out_asasatatauau_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in__out_asasatatauau_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_asasatatauau);
+    if (state->out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen, NULL,
+                                   bus, path, iface, method, NULL);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in__out_asasatatauau_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in__out_asasatatauau_done(struct tevent_req *subreq)
+{
+    struct sbus_method_in__out_asasatatauau_state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in__out_asasatatauau_state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_asasatatauau, state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in__out_asasatatauau_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     const char *** _arg0,
+     const char *** _arg1,
+     uint64_t ** _arg2,
+     uint64_t ** _arg3,
+     uint32_t ** _arg4,
+     uint32_t ** _arg5)
+{
+    struct sbus_method_in__out_asasatatauau_state *state;
+    state = tevent_req_data(req, struct sbus_method_in__out_asasatatauau_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_arg0 = talloc_steal(mem_ctx, state->out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, state->out->arg1);
+    *_arg2 = talloc_steal(mem_ctx, state->out->arg2);
+    *_arg3 = talloc_steal(mem_ctx, state->out->arg3);
+    *_arg4 = talloc_steal(mem_ctx, state->out->arg4);
+    *_arg5 = talloc_steal(mem_ctx, state->out->arg5);
+
+    return EOK;
+}
+
+struct sbus_method_in__out_auasasas_state {
+    struct _sbus_sss_invoker_args_auasasas *out;
+};
+
+static void sbus_method_in__out_auasasas_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in__out_auasasas_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method)
+{
+    struct sbus_method_in__out_auasasas_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in__out_auasasas_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_auasasas);
+    if (state->out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen, NULL,
+                                   bus, path, iface, method, NULL);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in__out_auasasas_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in__out_auasasas_done(struct tevent_req *subreq)
+{
+    struct sbus_method_in__out_auasasas_state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in__out_auasasas_state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_auasasas, state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in__out_auasasas_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint32_t ** _arg0,
+     const char *** _arg1,
+     const char *** _arg2,
+     const char *** _arg3)
+{
+    struct sbus_method_in__out_auasasas_state *state;
+    state = tevent_req_data(req, struct sbus_method_in__out_auasasas_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_arg0 = talloc_steal(mem_ctx, state->out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, state->out->arg1);
+    *_arg2 = talloc_steal(mem_ctx, state->out->arg2);
+    *_arg3 = talloc_steal(mem_ctx, state->out->arg3);
+
+    return EOK;
+}
+
+struct sbus_method_in__out_auauasatatatau_state {
+    struct _sbus_sss_invoker_args_auauasatatatau *out;
+};
+
+static void sbus_method_in__out_auauasatatatau_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in__out_auauasatatatau_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method)
+{
+    struct sbus_method_in__out_auauasatatatau_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in__out_auauasatatatau_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_auauasatatatau);
+    if (state->out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen, NULL,
+                                   bus, path, iface, method, NULL);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in__out_auauasatatatau_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in__out_auauasatatatau_done(struct tevent_req *subreq)
+{
+    struct sbus_method_in__out_auauasatatatau_state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in__out_auauasatatatau_state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_auauasatatatau, state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in__out_auauasatatatau_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint32_t ** _arg0,
+     uint32_t ** _arg1,
+     const char *** _arg2,
+     uint64_t ** _arg3,
+     uint64_t ** _arg4,
+     uint64_t ** _arg5,
+     uint32_t ** _arg6)
+{
+    struct sbus_method_in__out_auauasatatatau_state *state;
+    state = tevent_req_data(req, struct sbus_method_in__out_auauasatatatau_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_arg0 = talloc_steal(mem_ctx, state->out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, state->out->arg1);
+    *_arg2 = talloc_steal(mem_ctx, state->out->arg2);
+    *_arg3 = talloc_steal(mem_ctx, state->out->arg3);
+    *_arg4 = talloc_steal(mem_ctx, state->out->arg4);
+    *_arg5 = talloc_steal(mem_ctx, state->out->arg5);
+    *_arg6 = talloc_steal(mem_ctx, state->out->arg6);
+
+    return EOK;
+}
+
 struct sbus_method_in_pam_data_out_pam_response_state {
     struct _sbus_sss_invoker_args_pam_data in;
     struct _sbus_sss_invoker_args_pam_response *out;
@@ -222,6 +550,7 @@ static struct tevent_req *
 sbus_method_in_raw_out_qus_send
     (TALLOC_CTX *mem_ctx,
      struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
      DBusMessage *raw_message)
 {
     struct sbus_method_in_raw_out_qus_state *state;
@@ -244,7 +573,7 @@ sbus_method_in_raw_out_qus_send
     }
 
 
-    subreq = sbus_call_method_send(state, conn, raw_message, NULL, NULL, NULL,
+    subreq = sbus_call_method_send(state, conn, raw_message, keygen, NULL, NULL,
                                    dbus_message_get_path(raw_message),
                                    dbus_message_get_interface(raw_message),
                                    dbus_message_get_member(raw_message), NULL);
@@ -548,7 +877,218 @@ sbus_method_in_s_out_b_send
         goto done;
     }
 
-    tevent_req_set_callback(subreq, sbus_method_in_s_out_b_done, req);
+    tevent_req_set_callback(subreq, sbus_method_in_s_out_b_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in_s_out_b_done(struct tevent_req *subreq)
+{
+    struct sbus_method_in_s_out_b_state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in_s_out_b_state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_b, state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in_s_out_b_recv
+    (struct tevent_req *req,
+     bool* _arg0)
+{
+    struct sbus_method_in_s_out_b_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_s_out_b_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_arg0 = state->out->arg0;
+
+    return EOK;
+}
+
+struct sbus_method_in_s_out_qus_state {
+    struct _sbus_sss_invoker_args_s in;
+    struct _sbus_sss_invoker_args_qus *out;
+};
+
+static void sbus_method_in_s_out_qus_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in_s_out_qus_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0)
+{
+    struct sbus_method_in_s_out_qus_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_s_out_qus_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_qus);
+    if (state->out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->in.arg0 = arg0;
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_s,
+                                   bus, path, iface, method, &state->in);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in_s_out_qus_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in_s_out_qus_done(struct tevent_req *subreq)
+{
+    struct sbus_method_in_s_out_qus_state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in_s_out_qus_state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_qus, state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in_s_out_qus_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint16_t* _arg0,
+     uint32_t* _arg1,
+     const char ** _arg2)
+{
+    struct sbus_method_in_s_out_qus_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_s_out_qus_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_arg0 = state->out->arg0;
+    *_arg1 = state->out->arg1;
+    *_arg2 = talloc_steal(mem_ctx, state->out->arg2);
+
+    return EOK;
+}
+
+struct sbus_method_in_s_out_s_state {
+    struct _sbus_sss_invoker_args_s in;
+    struct _sbus_sss_invoker_args_s *out;
+};
+
+static void sbus_method_in_s_out_s_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in_s_out_s_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     const char * arg0)
+{
+    struct sbus_method_in_s_out_s_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_s_out_s_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_s);
+    if (state->out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->in.arg0 = arg0;
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_s,
+                                   bus, path, iface, method, &state->in);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in_s_out_s_done, req);
 
     ret = EAGAIN;
 
@@ -561,15 +1101,15 @@ done:
     return req;
 }
 
-static void sbus_method_in_s_out_b_done(struct tevent_req *subreq)
+static void sbus_method_in_s_out_s_done(struct tevent_req *subreq)
 {
-    struct sbus_method_in_s_out_b_state *state;
+    struct sbus_method_in_s_out_s_state *state;
     struct tevent_req *req;
     DBusMessage *reply;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct sbus_method_in_s_out_b_state);
+    state = tevent_req_data(req, struct sbus_method_in_s_out_s_state);
 
     ret = sbus_call_method_recv(state, subreq, &reply);
     talloc_zfree(subreq);
@@ -578,7 +1118,7 @@ static void sbus_method_in_s_out_b_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_b, state->out);
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_s, state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -589,29 +1129,30 @@ static void sbus_method_in_s_out_b_done(struct tevent_req *subreq)
 }
 
 static errno_t
-sbus_method_in_s_out_b_recv
-    (struct tevent_req *req,
-     bool* _arg0)
+sbus_method_in_s_out_s_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     const char ** _arg0)
 {
-    struct sbus_method_in_s_out_b_state *state;
-    state = tevent_req_data(req, struct sbus_method_in_s_out_b_state);
+    struct sbus_method_in_s_out_s_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_s_out_s_state);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
-    *_arg0 = state->out->arg0;
+    *_arg0 = talloc_steal(mem_ctx, state->out->arg0);
 
     return EOK;
 }
 
-struct sbus_method_in_s_out_qus_state {
+struct sbus_method_in_s_out_uu_state {
     struct _sbus_sss_invoker_args_s in;
-    struct _sbus_sss_invoker_args_qus *out;
+    struct _sbus_sss_invoker_args_uu *out;
 };
 
-static void sbus_method_in_s_out_qus_done(struct tevent_req *subreq);
+static void sbus_method_in_s_out_uu_done(struct tevent_req *subreq);
 
 static struct tevent_req *
-sbus_method_in_s_out_qus_send
+sbus_method_in_s_out_uu_send
     (TALLOC_CTX *mem_ctx,
      struct sbus_connection *conn,
      sbus_invoker_keygen keygen,
@@ -621,18 +1162,18 @@ sbus_method_in_s_out_qus_send
      const char *method,
      const char * arg0)
 {
-    struct sbus_method_in_s_out_qus_state *state;
+    struct sbus_method_in_s_out_uu_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_s_out_qus_state);
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_s_out_uu_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
     }
 
-    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_qus);
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_uu);
     if (state->out == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Unable to allocate space for output parameters!\n");
@@ -651,7 +1192,7 @@ sbus_method_in_s_out_qus_send
         goto done;
     }
 
-    tevent_req_set_callback(subreq, sbus_method_in_s_out_qus_done, req);
+    tevent_req_set_callback(subreq, sbus_method_in_s_out_uu_done, req);
 
     ret = EAGAIN;
 
@@ -664,15 +1205,15 @@ done:
     return req;
 }
 
-static void sbus_method_in_s_out_qus_done(struct tevent_req *subreq)
+static void sbus_method_in_s_out_uu_done(struct tevent_req *subreq)
 {
-    struct sbus_method_in_s_out_qus_state *state;
+    struct sbus_method_in_s_out_uu_state *state;
     struct tevent_req *req;
     DBusMessage *reply;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct sbus_method_in_s_out_qus_state);
+    state = tevent_req_data(req, struct sbus_method_in_s_out_uu_state);
 
     ret = sbus_call_method_recv(state, subreq, &reply);
     talloc_zfree(subreq);
@@ -681,7 +1222,7 @@ static void sbus_method_in_s_out_qus_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_qus, state->out);
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_uu, state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -692,34 +1233,31 @@ static void sbus_method_in_s_out_qus_done(struct tevent_req *subreq)
 }
 
 static errno_t
-sbus_method_in_s_out_qus_recv
-    (TALLOC_CTX *mem_ctx,
-     struct tevent_req *req,
-     uint16_t* _arg0,
-     uint32_t* _arg1,
-     const char ** _arg2)
+sbus_method_in_s_out_uu_recv
+    (struct tevent_req *req,
+     uint32_t* _arg0,
+     uint32_t* _arg1)
 {
-    struct sbus_method_in_s_out_qus_state *state;
-    state = tevent_req_data(req, struct sbus_method_in_s_out_qus_state);
+    struct sbus_method_in_s_out_uu_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_s_out_uu_state);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
     *_arg0 = state->out->arg0;
     *_arg1 = state->out->arg1;
-    *_arg2 = talloc_steal(mem_ctx, state->out->arg2);
 
     return EOK;
 }
 
-struct sbus_method_in_s_out_s_state {
-    struct _sbus_sss_invoker_args_s in;
-    struct _sbus_sss_invoker_args_s *out;
+struct sbus_method_in_spayload_out_uu_state {
+    struct _sbus_sss_invoker_args_spayload in;
+    struct _sbus_sss_invoker_args_uu *out;
 };
 
-static void sbus_method_in_s_out_s_done(struct tevent_req *subreq);
+static void sbus_method_in_spayload_out_uu_done(struct tevent_req *subreq);
 
 static struct tevent_req *
-sbus_method_in_s_out_s_send
+sbus_method_in_spayload_out_uu_send
     (TALLOC_CTX *mem_ctx,
      struct sbus_connection *conn,
      sbus_invoker_keygen keygen,
@@ -727,20 +1265,21 @@ sbus_method_in_s_out_s_send
      const char *path,
      const char *iface,
      const char *method,
-     const char * arg0)
+     const char * arg0,
+     struct sss_iface_payload * arg1)
 {
-    struct sbus_method_in_s_out_s_state *state;
+    struct sbus_method_in_spayload_out_uu_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_s_out_s_state);
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_spayload_out_uu_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
     }
 
-    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_s);
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_uu);
     if (state->out == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Unable to allocate space for output parameters!\n");
@@ -749,9 +1288,10 @@ sbus_method_in_s_out_s_send
     }
 
     state->in.arg0 = arg0;
+    state->in.arg1 = arg1;
 
     subreq = sbus_call_method_send(state, conn, NULL, keygen,
-                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_s,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_spayload,
                                    bus, path, iface, method, &state->in);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
@@ -759,7 +1299,7 @@ sbus_method_in_s_out_s_send
         goto done;
     }
 
-    tevent_req_set_callback(subreq, sbus_method_in_s_out_s_done, req);
+    tevent_req_set_callback(subreq, sbus_method_in_spayload_out_uu_done, req);
 
     ret = EAGAIN;
 
@@ -772,15 +1312,15 @@ done:
     return req;
 }
 
-static void sbus_method_in_s_out_s_done(struct tevent_req *subreq)
+static void sbus_method_in_spayload_out_uu_done(struct tevent_req *subreq)
 {
-    struct sbus_method_in_s_out_s_state *state;
+    struct sbus_method_in_spayload_out_uu_state *state;
     struct tevent_req *req;
     DBusMessage *reply;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct sbus_method_in_s_out_s_state);
+    state = tevent_req_data(req, struct sbus_method_in_spayload_out_uu_state);
 
     ret = sbus_call_method_recv(state, subreq, &reply);
     talloc_zfree(subreq);
@@ -789,7 +1329,7 @@ static void sbus_method_in_s_out_s_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_s, state->out);
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_uu, state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -800,17 +1340,18 @@ static void sbus_method_in_s_out_s_done(struct tevent_req *subreq)
 }
 
 static errno_t
-sbus_method_in_s_out_s_recv
-    (TALLOC_CTX *mem_ctx,
-     struct tevent_req *req,
-     const char ** _arg0)
+sbus_method_in_spayload_out_uu_recv
+    (struct tevent_req *req,
+     uint32_t* _arg0,
+     uint32_t* _arg1)
 {
-    struct sbus_method_in_s_out_s_state *state;
-    state = tevent_req_data(req, struct sbus_method_in_s_out_s_state);
+    struct sbus_method_in_spayload_out_uu_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_spayload_out_uu_state);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
-    *_arg0 = talloc_steal(mem_ctx, state->out->arg0);
+    *_arg0 = state->out->arg0;
+    *_arg1 = state->out->arg1;
 
     return EOK;
 }
@@ -1568,15 +2109,131 @@ sbus_method_in_uss_out_qus_recv
     return EOK;
 }
 
-struct sbus_method_in_uusss_out_qus_state {
-    struct _sbus_sss_invoker_args_uusss in;
+struct sbus_method_in_uuasss_out_aqauas_state {
+    struct _sbus_sss_invoker_args_uuasss in;
+    struct _sbus_sss_invoker_args_aqauas *out;
+};
+
+static void sbus_method_in_uuasss_out_aqauas_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+sbus_method_in_uuasss_out_aqauas_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     sbus_invoker_keygen keygen,
+     const char *bus,
+     const char *path,
+     const char *iface,
+     const char *method,
+     uint32_t arg0,
+     uint32_t arg1,
+     const char ** arg2,
+     const char * arg3,
+     const char * arg4)
+{
+    struct sbus_method_in_uuasss_out_aqauas_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_uuasss_out_aqauas_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->out = talloc_zero(state, struct _sbus_sss_invoker_args_aqauas);
+    if (state->out == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unable to allocate space for output parameters!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    state->in.arg0 = arg0;
+    state->in.arg1 = arg1;
+    state->in.arg2 = arg2;
+    state->in.arg3 = arg3;
+    state->in.arg4 = arg4;
+
+    subreq = sbus_call_method_send(state, conn, NULL, keygen,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_uuasss,
+                                   bus, path, iface, method, &state->in);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    tevent_req_set_callback(subreq, sbus_method_in_uuasss_out_aqauas_done, req);
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, conn->ev);
+    }
+
+    return req;
+}
+
+static void sbus_method_in_uuasss_out_aqauas_done(struct tevent_req *subreq)
+{
+    struct sbus_method_in_uuasss_out_aqauas_state *state;
+    struct tevent_req *req;
+    DBusMessage *reply;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sbus_method_in_uuasss_out_aqauas_state);
+
+    ret = sbus_call_method_recv(state, subreq, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sbus_read_output(state->out, reply, (sbus_invoker_reader_fn)_sbus_sss_invoker_read_aqauas, state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+static errno_t
+sbus_method_in_uuasss_out_aqauas_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint16_t ** _arg0,
+     uint32_t ** _arg1,
+     const char *** _arg2)
+{
+    struct sbus_method_in_uuasss_out_aqauas_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_uuasss_out_aqauas_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_arg0 = talloc_steal(mem_ctx, state->out->arg0);
+    *_arg1 = talloc_steal(mem_ctx, state->out->arg1);
+    *_arg2 = talloc_steal(mem_ctx, state->out->arg2);
+
+    return EOK;
+}
+
+struct sbus_method_in_uussstt_out_qus_state {
+    struct _sbus_sss_invoker_args_uussstt in;
     struct _sbus_sss_invoker_args_qus *out;
 };
 
-static void sbus_method_in_uusss_out_qus_done(struct tevent_req *subreq);
+static void sbus_method_in_uussstt_out_qus_done(struct tevent_req *subreq);
 
 static struct tevent_req *
-sbus_method_in_uusss_out_qus_send
+sbus_method_in_uussstt_out_qus_send
     (TALLOC_CTX *mem_ctx,
      struct sbus_connection *conn,
      sbus_invoker_keygen keygen,
@@ -1588,14 +2245,16 @@ sbus_method_in_uusss_out_qus_send
      uint32_t arg1,
      const char * arg2,
      const char * arg3,
-     const char * arg4)
+     const char * arg4,
+     uint64_t arg5,
+     uint64_t arg6)
 {
-    struct sbus_method_in_uusss_out_qus_state *state;
+    struct sbus_method_in_uussstt_out_qus_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_uusss_out_qus_state);
+    req = tevent_req_create(mem_ctx, &state, struct sbus_method_in_uussstt_out_qus_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -1614,9 +2273,11 @@ sbus_method_in_uusss_out_qus_send
     state->in.arg2 = arg2;
     state->in.arg3 = arg3;
     state->in.arg4 = arg4;
+    state->in.arg5 = arg5;
+    state->in.arg6 = arg6;
 
     subreq = sbus_call_method_send(state, conn, NULL, keygen,
-                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_uusss,
+                                   (sbus_invoker_writer_fn)_sbus_sss_invoker_write_uussstt,
                                    bus, path, iface, method, &state->in);
     if (subreq == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
@@ -1624,7 +2285,7 @@ sbus_method_in_uusss_out_qus_send
         goto done;
     }
 
-    tevent_req_set_callback(subreq, sbus_method_in_uusss_out_qus_done, req);
+    tevent_req_set_callback(subreq, sbus_method_in_uussstt_out_qus_done, req);
 
     ret = EAGAIN;
 
@@ -1637,15 +2298,15 @@ done:
     return req;
 }
 
-static void sbus_method_in_uusss_out_qus_done(struct tevent_req *subreq)
+static void sbus_method_in_uussstt_out_qus_done(struct tevent_req *subreq)
 {
-    struct sbus_method_in_uusss_out_qus_state *state;
+    struct sbus_method_in_uussstt_out_qus_state *state;
     struct tevent_req *req;
     DBusMessage *reply;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct sbus_method_in_uusss_out_qus_state);
+    state = tevent_req_data(req, struct sbus_method_in_uussstt_out_qus_state);
 
     ret = sbus_call_method_recv(state, subreq, &reply);
     talloc_zfree(subreq);
@@ -1665,15 +2326,15 @@ static void sbus_method_in_uusss_out_qus_done(struct tevent_req *subreq)
 }
 
 static errno_t
-sbus_method_in_uusss_out_qus_recv
+sbus_method_in_uussstt_out_qus_recv
     (TALLOC_CTX *mem_ctx,
      struct tevent_req *req,
      uint16_t* _arg0,
      uint32_t* _arg1,
      const char ** _arg2)
 {
-    struct sbus_method_in_uusss_out_qus_state *state;
-    state = tevent_req_data(req, struct sbus_method_in_uusss_out_qus_state);
+    struct sbus_method_in_uussstt_out_qus_state *state;
+    state = tevent_req_data(req, struct sbus_method_in_uussstt_out_qus_state);
 
     TEVENT_REQ_RETURN_ON_ERROR(req);
 
@@ -1898,6 +2559,27 @@ sbus_call_dp_autofs_GetMap_recv
     return sbus_method_in_us_out__recv(req);
 }
 
+struct tevent_req *
+sbus_call_dp_backend_CleanupProgress_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name)
+{
+    return sbus_method_in_s_out_uu_send(mem_ctx, conn, _sbus_sss_key_s_0,
+        busname, object_path, "sssd.DataProvider.Backend", "CleanupProgress", arg_domain_name);
+}
+
+errno_t
+sbus_call_dp_backend_CleanupProgress_recv
+    (struct tevent_req *req,
+     uint32_t* _processed,
+     uint32_t* _total)
+{
+    return sbus_method_in_s_out_uu_recv(req, _processed, _total);
+}
+
 struct tevent_req *
 sbus_call_dp_backend_IsOnline_send
     (TALLOC_CTX *mem_ctx,
@@ -2000,6 +2682,29 @@ sbus_call_dp_failover_ListServices_recv
     return sbus_method_in_s_out_as_recv(mem_ctx, req, _services);
 }
 
+struct tevent_req *
+sbus_call_metrics_GetMetrics_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path)
+{
+    return sbus_method_in__out_auasasas_send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.Metrics", "GetMetrics");
+}
+
+errno_t
+sbus_call_metrics_GetMetrics_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint32_t ** _metrics,
+     const char *** _suffixes,
+     const char *** _labels,
+     const char *** _values)
+{
+    return sbus_method_in__out_auasasas_recv(mem_ctx, req, _metrics, _suffixes, _labels, _values);
+}
+
 struct tevent_req *
 sbus_call_proxy_auth_PAM_send
     (TALLOC_CTX *mem_ctx,
@@ -2114,6 +2819,57 @@ sbus_call_resp_negcache_ResetUsers_recv
     return sbus_method_in__out__recv(req);
 }
 
+struct tevent_req *
+sbus_call_resp_stats_GetCommandStats_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path)
+{
+    return sbus_method_in__out_auauasatatatau_send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.Responder.Statistics", "GetCommandStats");
+}
+
+errno_t
+sbus_call_resp_stats_GetCommandStats_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint32_t ** _commands,
+     uint32_t ** _sources,
+     const char *** _domains,
+     uint64_t ** _counts,
+     uint64_t ** _total_usec,
+     uint64_t ** _max_usec,
+     uint32_t ** _histograms)
+{
+    return sbus_method_in__out_auauasatatatau_recv(mem_ctx, req, _commands, _sources, _domains, _counts, _total_usec, _max_usec, _histograms);
+}
+
+struct tevent_req *
+sbus_call_resp_stats_GetProviderRequestStats_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path)
+{
+    return sbus_method_in__out_asasatatauau_send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.Responder.Statistics", "GetProviderRequestStats");
+}
+
+errno_t
+sbus_call_resp_stats_GetProviderRequestStats_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     const char *** _domains,
+     const char *** _methods,
+     uint64_t ** _requests,
+     uint64_t ** _coalesced,
+     uint32_t ** _in_flight,
+     uint32_t ** _waiting)
+{
+    return sbus_method_in__out_asasatatauau_recv(mem_ctx, req, _domains, _methods, _requests, _coalesced, _in_flight, _waiting);
+}
+
 struct tevent_req *
 sbus_call_dp_dp_getAccountDomain_send
     (TALLOC_CTX *mem_ctx,
@@ -2148,10 +2904,12 @@ sbus_call_dp_dp_getAccountInfo_send
      uint32_t arg_entry_type,
      const char * arg_filter,
      const char * arg_domain,
-     const char * arg_extra)
+     const char * arg_extra,
+     uint64_t arg_trace_id,
+     uint64_t arg_parent_span_id)
 {
-    return sbus_method_in_uusss_out_qus_send(mem_ctx, conn, _sbus_sss_key_uusss_0_1_2_3_4,
-        busname, object_path, "sssd.dataprovider", "getAccountInfo", arg_dp_flags, arg_entry_type, arg_filter, arg_domain, arg_extra);
+    return sbus_method_in_uussstt_out_qus_send(mem_ctx, conn, _sbus_sss_key_uussstt_0_1_2_3_4,
+        busname, object_path, "sssd.dataprovider", "getAccountInfo", arg_dp_flags, arg_entry_type, arg_filter, arg_domain, arg_extra, arg_trace_id, arg_parent_span_id);
 }
 
 errno_t
@@ -2162,7 +2920,34 @@ sbus_call_dp_dp_getAccountInfo_recv
      uint32_t* _error,
      const char ** _error_message)
 {
-    return sbus_method_in_uusss_out_qus_recv(mem_ctx, req, _dp_error, _error, _error_message);
+    return sbus_method_in_uussstt_out_qus_recv(mem_ctx, req, _dp_error, _error, _error_message);
+}
+
+struct tevent_req *
+sbus_call_dp_dp_getAccountInfoBatch_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     uint32_t arg_dp_flags,
+     uint32_t arg_entry_type,
+     const char ** arg_filters,
+     const char * arg_domain,
+     const char * arg_extra)
+{
+    return sbus_method_in_uuasss_out_aqauas_send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.dataprovider", "getAccountInfoBatch", arg_dp_flags, arg_entry_type, arg_filters, arg_domain, arg_extra);
+}
+
+errno_t
+sbus_call_dp_dp_getAccountInfoBatch_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint16_t ** _dp_errors,
+     uint32_t ** _errors,
+     const char *** _error_messages)
+{
+    return sbus_method_in_uuasss_out_aqauas_recv(mem_ctx, req, _dp_errors, _errors, _error_messages);
 }
 
 struct tevent_req *
@@ -2266,7 +3051,7 @@ sbus_call_dp_dp_sudoHandler_send
      struct sbus_connection *conn,
      DBusMessage *raw_message)
 {
-    return sbus_method_in_raw_out_qus_send(mem_ctx, conn, raw_message);
+    return sbus_method_in_raw_out_qus_send(mem_ctx, conn, sbus_message_keygen, raw_message);
 }
 
 errno_t
@@ -2356,6 +3141,28 @@ sbus_call_nss_memcache_InvalidateAllUsers_recv
     return sbus_method_in__out__recv(req);
 }
 
+struct tevent_req *
+sbus_call_nss_memcache_InvalidateBatch_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain,
+     struct sss_iface_payload * arg_records)
+{
+    return sbus_method_in_spayload_out_uu_send(mem_ctx, conn, NULL,
+        busname, object_path, "sssd.nss.MemoryCache", "InvalidateBatch", arg_domain, arg_records);
+}
+
+errno_t
+sbus_call_nss_memcache_InvalidateBatch_recv
+    (struct tevent_req *req,
+     uint32_t* _num_users,
+     uint32_t* _num_groups)
+{
+    return sbus_method_in_spayload_out_uu_recv(req, _num_users, _num_groups);
+}
+
 struct tevent_req *
 sbus_call_nss_memcache_InvalidateGroupById_send
     (TALLOC_CTX *mem_ctx,
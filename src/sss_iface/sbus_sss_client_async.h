@@ -93,6 +93,20 @@ errno_t
 sbus_call_dp_autofs_GetMap_recv
     (struct tevent_req *req);
 
+struct tevent_req *
+sbus_call_dp_backend_CleanupProgress_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain_name);
+
+errno_t
+sbus_call_dp_backend_CleanupProgress_recv
+    (struct tevent_req *req,
+     uint32_t* _processed,
+     uint32_t* _total);
+
 struct tevent_req *
 sbus_call_dp_backend_IsOnline_send
     (TALLOC_CTX *mem_ctx,
@@ -160,6 +174,22 @@ sbus_call_dp_failover_ListServices_recv
      struct tevent_req *req,
      const char *** _services);
 
+struct tevent_req *
+sbus_call_metrics_GetMetrics_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path);
+
+errno_t
+sbus_call_metrics_GetMetrics_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint32_t ** _metrics,
+     const char *** _suffixes,
+     const char *** _labels,
+     const char *** _values);
+
 struct tevent_req *
 sbus_call_proxy_auth_PAM_send
     (TALLOC_CTX *mem_ctx,
@@ -232,6 +262,43 @@ errno_t
 sbus_call_resp_negcache_ResetUsers_recv
     (struct tevent_req *req);
 
+struct tevent_req *
+sbus_call_resp_stats_GetCommandStats_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path);
+
+errno_t
+sbus_call_resp_stats_GetCommandStats_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint32_t ** _commands,
+     uint32_t ** _sources,
+     const char *** _domains,
+     uint64_t ** _counts,
+     uint64_t ** _total_usec,
+     uint64_t ** _max_usec,
+     uint32_t ** _histograms);
+
+struct tevent_req *
+sbus_call_resp_stats_GetProviderRequestStats_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path);
+
+errno_t
+sbus_call_resp_stats_GetProviderRequestStats_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     const char *** _domains,
+     const char *** _methods,
+     uint64_t ** _requests,
+     uint64_t ** _coalesced,
+     uint32_t ** _in_flight,
+     uint32_t ** _waiting);
+
 struct tevent_req *
 sbus_call_dp_dp_getAccountDomain_send
     (TALLOC_CTX *mem_ctx,
@@ -259,7 +326,9 @@ sbus_call_dp_dp_getAccountInfo_send
      uint32_t arg_entry_type,
      const char * arg_filter,
      const char * arg_domain,
-     const char * arg_extra);
+     const char * arg_extra,
+     uint64_t arg_trace_id,
+     uint64_t arg_parent_span_id);
 
 errno_t
 sbus_call_dp_dp_getAccountInfo_recv
@@ -269,6 +338,26 @@ sbus_call_dp_dp_getAccountInfo_recv
      uint32_t* _error,
      const char ** _error_message);
 
+struct tevent_req *
+sbus_call_dp_dp_getAccountInfoBatch_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     uint32_t arg_dp_flags,
+     uint32_t arg_entry_type,
+     const char ** arg_filters,
+     const char * arg_domain,
+     const char * arg_extra);
+
+errno_t
+sbus_call_dp_dp_getAccountInfoBatch_recv
+    (TALLOC_CTX *mem_ctx,
+     struct tevent_req *req,
+     uint16_t ** _dp_errors,
+     uint32_t ** _errors,
+     const char *** _error_messages);
+
 struct tevent_req *
 sbus_call_dp_dp_getDomains_send
     (TALLOC_CTX *mem_ctx,
@@ -398,6 +487,21 @@ errno_t
 sbus_call_nss_memcache_InvalidateAllUsers_recv
     (struct tevent_req *req);
 
+struct tevent_req *
+sbus_call_nss_memcache_InvalidateBatch_send
+    (TALLOC_CTX *mem_ctx,
+     struct sbus_connection *conn,
+     const char *busname,
+     const char *object_path,
+     const char * arg_domain,
+     struct sss_iface_payload * arg_records);
+
+errno_t
+sbus_call_nss_memcache_InvalidateBatch_recv
+    (struct tevent_req *req,
+     uint32_t* _num_users,
+     uint32_t* _num_groups);
+
 struct tevent_req *
 sbus_call_nss_memcache_InvalidateGroupById_send
     (TALLOC_CTX *mem_ctx,
@@ -231,6 +231,28 @@
         (methods), (signals), (properties)); \
 })
 
+/* Method: sssd.DataProvider.Backend.CleanupProgress */
+#define SBUS_METHOD_SYNC_sssd_DataProvider_Backend_CleanupProgress(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, uint32_t*, uint32_t*); \
+    sbus_method_sync("CleanupProgress", \
+        &_sbus_sss_args_sssd_DataProvider_Backend_CleanupProgress, \
+        NULL, \
+        _sbus_sss_invoke_in_s_out_uu_send, \
+        _sbus_sss_key_s_0, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_DataProvider_Backend_CleanupProgress(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *); \
+    SBUS_CHECK_RECV((handler_recv), uint32_t*, uint32_t*); \
+    sbus_method_async("CleanupProgress", \
+        &_sbus_sss_args_sssd_DataProvider_Backend_CleanupProgress, \
+        NULL, \
+        _sbus_sss_invoke_in_s_out_uu_send, \
+        _sbus_sss_key_s_0, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: sssd.DataProvider.Backend.IsOnline */
 #define SBUS_METHOD_SYNC_sssd_DataProvider_Backend_IsOnline(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), const char *, bool*); \
@@ -353,6 +375,34 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Interface: sssd.Metrics */
+#define SBUS_IFACE_sssd_Metrics(methods, signals, properties) ({ \
+    sbus_interface("sssd.Metrics", NULL, \
+        (methods), (signals), (properties)); \
+})
+
+/* Method: sssd.Metrics.GetMetrics */
+#define SBUS_METHOD_SYNC_sssd_Metrics_GetMetrics(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), uint32_t **, const char ***, const char ***, const char ***); \
+    sbus_method_sync("GetMetrics", \
+        &_sbus_sss_args_sssd_Metrics_GetMetrics, \
+        NULL, \
+        _sbus_sss_invoke_in__out_auasasas_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_Metrics_GetMetrics(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data)); \
+    SBUS_CHECK_RECV((handler_recv), uint32_t **, const char ***, const char ***, const char ***); \
+    sbus_method_async("GetMetrics", \
+        &_sbus_sss_args_sssd_Metrics_GetMetrics, \
+        NULL, \
+        _sbus_sss_invoke_in__out_auasasas_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Interface: sssd.ProxyChild.Auth */
 #define SBUS_IFACE_sssd_ProxyChild_Auth(methods, signals, properties) ({ \
     sbus_interface("sssd.ProxyChild.Auth", NULL, \
@@ -509,6 +559,56 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Interface: sssd.Responder.Statistics */
+#define SBUS_IFACE_sssd_Responder_Statistics(methods, signals, properties) ({ \
+    sbus_interface("sssd.Responder.Statistics", NULL, \
+        (methods), (signals), (properties)); \
+})
+
+/* Method: sssd.Responder.Statistics.GetCommandStats */
+#define SBUS_METHOD_SYNC_sssd_Responder_Statistics_GetCommandStats(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **); \
+    sbus_method_sync("GetCommandStats", \
+        &_sbus_sss_args_sssd_Responder_Statistics_GetCommandStats, \
+        NULL, \
+        _sbus_sss_invoke_in__out_auauasatatatau_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_Responder_Statistics_GetCommandStats(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data)); \
+    SBUS_CHECK_RECV((handler_recv), uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **); \
+    sbus_method_async("GetCommandStats", \
+        &_sbus_sss_args_sssd_Responder_Statistics_GetCommandStats, \
+        NULL, \
+        _sbus_sss_invoke_in__out_auauasatatatau_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
+/* Method: sssd.Responder.Statistics.GetProviderRequestStats */
+#define SBUS_METHOD_SYNC_sssd_Responder_Statistics_GetProviderRequestStats(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char ***, const char ***, uint64_t **, uint64_t **, uint32_t **, uint32_t **); \
+    sbus_method_sync("GetProviderRequestStats", \
+        &_sbus_sss_args_sssd_Responder_Statistics_GetProviderRequestStats, \
+        NULL, \
+        _sbus_sss_invoke_in__out_asasatatauau_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_Responder_Statistics_GetProviderRequestStats(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data)); \
+    SBUS_CHECK_RECV((handler_recv), const char ***, const char ***, uint64_t **, uint64_t **, uint32_t **, uint32_t **); \
+    sbus_method_async("GetProviderRequestStats", \
+        &_sbus_sss_args_sssd_Responder_Statistics_GetProviderRequestStats, \
+        NULL, \
+        _sbus_sss_invoke_in__out_asasatatauau_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Interface: sssd.dataprovider */
 #define SBUS_IFACE_sssd_dataprovider(methods, signals, properties) ({ \
     sbus_interface("sssd.dataprovider", NULL, \
@@ -539,23 +639,45 @@
 
 /* Method: sssd.dataprovider.getAccountInfo */
 #define SBUS_METHOD_SYNC_sssd_dataprovider_getAccountInfo(handler, data) ({ \
-    SBUS_CHECK_SYNC((handler), (data), uint32_t, uint32_t, const char *, const char *, const char *, uint16_t*, uint32_t*, const char **); \
+    SBUS_CHECK_SYNC((handler), (data), uint32_t, uint32_t, const char *, const char *, const char *, uint64_t, uint64_t, uint16_t*, uint32_t*, const char **); \
     sbus_method_sync("getAccountInfo", \
         &_sbus_sss_args_sssd_dataprovider_getAccountInfo, \
         NULL, \
-        _sbus_sss_invoke_in_uusss_out_qus_send, \
-        _sbus_sss_key_uusss_0_1_2_3_4, \
+        _sbus_sss_invoke_in_uussstt_out_qus_send, \
+        _sbus_sss_key_uussstt_0_1_2_3_4, \
         (handler), (data)); \
 })
 
 #define SBUS_METHOD_ASYNC_sssd_dataprovider_getAccountInfo(handler_send, handler_recv, data) ({ \
-    SBUS_CHECK_SEND((handler_send), (data), uint32_t, uint32_t, const char *, const char *, const char *); \
+    SBUS_CHECK_SEND((handler_send), (data), uint32_t, uint32_t, const char *, const char *, const char *, uint64_t, uint64_t); \
     SBUS_CHECK_RECV((handler_recv), uint16_t*, uint32_t*, const char **); \
     sbus_method_async("getAccountInfo", \
         &_sbus_sss_args_sssd_dataprovider_getAccountInfo, \
         NULL, \
-        _sbus_sss_invoke_in_uusss_out_qus_send, \
-        _sbus_sss_key_uusss_0_1_2_3_4, \
+        _sbus_sss_invoke_in_uussstt_out_qus_send, \
+        _sbus_sss_key_uussstt_0_1_2_3_4, \
+        (handler_send), (handler_recv), (data)); \
+})
+
+/* Method: sssd.dataprovider.getAccountInfoBatch */
+#define SBUS_METHOD_SYNC_sssd_dataprovider_getAccountInfoBatch(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), uint32_t, uint32_t, const char **, const char *, const char *, uint16_t **, uint32_t **, const char ***); \
+    sbus_method_sync("getAccountInfoBatch", \
+        &_sbus_sss_args_sssd_dataprovider_getAccountInfoBatch, \
+        NULL, \
+        _sbus_sss_invoke_in_uuasss_out_aqauas_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_dataprovider_getAccountInfoBatch(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), uint32_t, uint32_t, const char **, const char *, const char *); \
+    SBUS_CHECK_RECV((handler_recv), uint16_t **, uint32_t **, const char ***); \
+    sbus_method_async("getAccountInfoBatch", \
+        &_sbus_sss_args_sssd_dataprovider_getAccountInfoBatch, \
+        NULL, \
+        _sbus_sss_invoke_in_uuasss_out_aqauas_send, \
+        NULL, \
         (handler_send), (handler_recv), (data)); \
 })
 
@@ -769,6 +891,28 @@
         (handler_send), (handler_recv), (data)); \
 })
 
+/* Method: sssd.nss.MemoryCache.InvalidateBatch */
+#define SBUS_METHOD_SYNC_sssd_nss_MemoryCache_InvalidateBatch(handler, data) ({ \
+    SBUS_CHECK_SYNC((handler), (data), const char *, struct sss_iface_payload *, uint32_t*, uint32_t*); \
+    sbus_method_sync("InvalidateBatch", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_InvalidateBatch, \
+        NULL, \
+        _sbus_sss_invoke_in_spayload_out_uu_send, \
+        NULL, \
+        (handler), (data)); \
+})
+
+#define SBUS_METHOD_ASYNC_sssd_nss_MemoryCache_InvalidateBatch(handler_send, handler_recv, data) ({ \
+    SBUS_CHECK_SEND((handler_send), (data), const char *, struct sss_iface_payload *); \
+    SBUS_CHECK_RECV((handler_recv), uint32_t*, uint32_t*); \
+    sbus_method_async("InvalidateBatch", \
+        &_sbus_sss_args_sssd_nss_MemoryCache_InvalidateBatch, \
+        NULL, \
+        _sbus_sss_invoke_in_spayload_out_uu_send, \
+        NULL, \
+        (handler_send), (handler_recv), (data)); \
+})
+
 /* Method: sssd.nss.MemoryCache.InvalidateGroupById */
 #define SBUS_METHOD_SYNC_sssd_nss_MemoryCache_InvalidateGroupById(handler, data) ({ \
     SBUS_CHECK_SYNC((handler), (data), uint32_t); \
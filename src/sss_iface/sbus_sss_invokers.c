@@ -213,15 +213,855 @@ static void _sbus_sss_invoke_in__out__done(struct tevent_req *subreq)
     return;
 }
 
+struct _sbus_sss_invoke_in__out_asasatatauau_state {
+    struct _sbus_sss_invoker_args_asasatatauau out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char ***, const char ***, uint64_t **, uint64_t **, uint32_t **, uint32_t **);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char ***, const char ***, uint64_t **, uint64_t **, uint32_t **, uint32_t **);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_sss_invoke_in__out_asasatatauau_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_sss_invoke_in__out_asasatatauau_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_sss_invoke_in__out_asasatatauau_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_sss_invoke_in__out_asasatatauau_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in__out_asasatatauau_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in__out_asasatatauau_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, NULL, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_sss_invoke_in__out_asasatatauau_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_sss_invoke_in__out_asasatatauau_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in__out_asasatatauau_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3, &state->out.arg4, &state->out.arg5);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_sss_invoker_write_asasatatauau(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in__out_asasatatauau_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_sss_invoke_in__out_asasatatauau_done(struct tevent_req *subreq)
+{
+    struct _sbus_sss_invoke_in__out_asasatatauau_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in__out_asasatatauau_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3, &state->out.arg4, &state->out.arg5);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_sss_invoker_write_asasatatauau(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+struct _sbus_sss_invoke_in__out_auasasas_state {
+    struct _sbus_sss_invoker_args_auasasas out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, uint32_t **, const char ***, const char ***, const char ***);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint32_t **, const char ***, const char ***, const char ***);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_sss_invoke_in__out_auasasas_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_sss_invoke_in__out_auasasas_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_sss_invoke_in__out_auasasas_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_sss_invoke_in__out_auasasas_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in__out_auasasas_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in__out_auasasas_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, NULL, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_sss_invoke_in__out_auasasas_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_sss_invoke_in__out_auasasas_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in__out_auasasas_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_sss_invoker_write_auasasas(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in__out_auasasas_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_sss_invoke_in__out_auasasas_done(struct tevent_req *subreq)
+{
+    struct _sbus_sss_invoke_in__out_auasasas_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in__out_auasasas_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_sss_invoker_write_auasasas(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+struct _sbus_sss_invoke_in__out_auauasatatatau_state {
+    struct _sbus_sss_invoker_args_auauasatatatau out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint32_t **, uint32_t **, const char ***, uint64_t **, uint64_t **, uint64_t **, uint32_t **);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_sss_invoke_in__out_auauasatatatau_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_sss_invoke_in__out_auauasatatatau_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_sss_invoke_in__out_auauasatatatau_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_sss_invoke_in__out_auauasatatatau_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in__out_auauasatatatau_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in__out_auauasatatatau_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, NULL, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_sss_invoke_in__out_auauasatatatau_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_sss_invoke_in__out_auauasatatatau_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in__out_auauasatatatau_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3, &state->out.arg4, &state->out.arg5, &state->out.arg6);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_sss_invoker_write_auauasatatatau(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in__out_auauasatatatau_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_sss_invoke_in__out_auauasatatatau_done(struct tevent_req *subreq)
+{
+    struct _sbus_sss_invoke_in__out_auauasatatatau_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in__out_auauasatatatau_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2, &state->out.arg3, &state->out.arg4, &state->out.arg5, &state->out.arg6);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_sss_invoker_write_auauasatatatau(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
 struct _sbus_sss_invoke_in_pam_data_out_pam_response_state {
-    struct _sbus_sss_invoker_args_pam_data *in;
+    struct _sbus_sss_invoker_args_pam_data in;
     struct _sbus_sss_invoker_args_pam_response out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, struct pam_data *, struct pam_data **);
-        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, struct pam_data *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, struct pam_data **);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, struct pam_data *, struct pam_data **);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, struct pam_data *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, struct pam_data **);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_sss_invoke_in_pam_data_out_pam_response_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_sss_invoke_in_pam_data_out_pam_response_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_sss_invoke_in_pam_data_out_pam_response_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_sss_invoke_in_pam_data_out_pam_response_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_pam_data_out_pam_response_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = _sbus_sss_invoker_read_pam_data(state, read_iterator, &state->in);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_pam_data_out_pam_response_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_sss_invoke_in_pam_data_out_pam_response_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_sss_invoke_in_pam_data_out_pam_response_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_pam_data_out_pam_response_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_sss_invoker_write_pam_response(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_pam_data_out_pam_response_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_sss_invoke_in_pam_data_out_pam_response_done(struct tevent_req *subreq)
+{
+    struct _sbus_sss_invoke_in_pam_data_out_pam_response_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_pam_data_out_pam_response_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_sss_invoker_write_pam_response(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+struct _sbus_sss_invoke_in_raw_out_qus_state {
+    struct _sbus_sss_invoker_args_qus out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, DBusMessageIter *, uint16_t*, uint32_t*, const char **);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, DBusMessageIter *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint16_t*, uint32_t*, const char **);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_sss_invoke_in_raw_out_qus_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_sss_invoke_in_raw_out_qus_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_sss_invoke_in_raw_out_qus_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_sss_invoke_in_raw_out_qus_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_raw_out_qus_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_raw_out_qus_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, NULL, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_sss_invoke_in_raw_out_qus_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_sss_invoke_in_raw_out_qus_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_raw_out_qus_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->read_iterator, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->read_iterator);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_raw_out_qus_done, req);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_sss_invoke_in_raw_out_qus_done(struct tevent_req *subreq)
+{
+    struct _sbus_sss_invoke_in_raw_out_qus_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_raw_out_qus_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+struct _sbus_sss_invoke_in_s_out__state {
+    struct _sbus_sss_invoker_args_s in;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -230,18 +1070,18 @@ struct _sbus_sss_invoke_in_pam_data_out_pam_response_state {
 };
 
 static void
-_sbus_sss_invoke_in_pam_data_out_pam_response_step
+_sbus_sss_invoke_in_s_out__step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_pam_data_out_pam_response_done
+_sbus_sss_invoke_in_s_out__done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_pam_data_out_pam_response_send
+_sbus_sss_invoke_in_s_out__send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -251,12 +1091,12 @@ _sbus_sss_invoke_in_pam_data_out_pam_response_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_pam_data_out_pam_response_state *state;
+    struct _sbus_sss_invoke_in_s_out__state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_pam_data_out_pam_response_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out__state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -272,25 +1112,17 @@ _sbus_sss_invoke_in_pam_data_out_pam_response_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_pam_data);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_pam_data(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_pam_data_out_pam_response_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out__step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -310,19 +1142,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_pam_data_out_pam_response_step
+static void _sbus_sss_invoke_in_s_out__step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_pam_data_out_pam_response_state *state;
+    struct _sbus_sss_invoke_in_s_out__state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_pam_data_out_pam_response_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out__state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -332,12 +1164,11 @@ static void _sbus_sss_invoke_in_pam_data_out_pam_response_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_sss_invoker_write_pam_response(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -346,14 +1177,14 @@ static void _sbus_sss_invoke_in_pam_data_out_pam_response_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_pam_data_out_pam_response_done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out__done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -368,40 +1199,35 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_pam_data_out_pam_response_done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_s_out__done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_pam_data_out_pam_response_state *state;
+    struct _sbus_sss_invoke_in_s_out__state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_pam_data_out_pam_response_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out__state);
 
-    ret = state->handler.recv(state, subreq, &state->out.arg0);
+    ret = state->handler.recv(state, subreq);
     talloc_zfree(subreq);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
-    ret = _sbus_sss_invoker_write_pam_response(state->write_iterator, &state->out);
-    if (ret != EOK) {
-        tevent_req_error(req, ret);
-        return;
-    }
-
     tevent_req_done(req);
     return;
 }
 
-struct _sbus_sss_invoke_in_raw_out_qus_state {
-    struct _sbus_sss_invoker_args_qus out;
+struct _sbus_sss_invoke_in_s_out_as_state {
+    struct _sbus_sss_invoker_args_s in;
+    struct _sbus_sss_invoker_args_as out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, DBusMessageIter *, uint16_t*, uint32_t*, const char **);
-        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, DBusMessageIter *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint16_t*, uint32_t*, const char **);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char ***);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char ***);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -410,18 +1236,18 @@ struct _sbus_sss_invoke_in_raw_out_qus_state {
 };
 
 static void
-_sbus_sss_invoke_in_raw_out_qus_step
+_sbus_sss_invoke_in_s_out_as_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_raw_out_qus_done
+_sbus_sss_invoke_in_s_out_as_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_raw_out_qus_send
+_sbus_sss_invoke_in_s_out_as_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -431,12 +1257,12 @@ _sbus_sss_invoke_in_raw_out_qus_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_raw_out_qus_state *state;
+    struct _sbus_sss_invoke_in_s_out_as_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_raw_out_qus_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_as_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -452,12 +1278,17 @@ _sbus_sss_invoke_in_raw_out_qus_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_raw_out_qus_step, req);
+    ret = _sbus_sss_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, NULL, &key);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_as_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -477,19 +1308,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_raw_out_qus_step
+static void _sbus_sss_invoke_in_s_out_as_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_raw_out_qus_state *state;
+    struct _sbus_sss_invoke_in_s_out_as_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_raw_out_qus_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_as_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -499,12 +1330,12 @@ static void _sbus_sss_invoke_in_raw_out_qus_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->read_iterator, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
+        ret = _sbus_sss_invoker_write_as(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -513,14 +1344,14 @@ static void _sbus_sss_invoke_in_raw_out_qus_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->read_iterator);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_raw_out_qus_done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_as_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -535,23 +1366,23 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_raw_out_qus_done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_s_out_as_done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_raw_out_qus_state *state;
+    struct _sbus_sss_invoke_in_s_out_as_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_raw_out_qus_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_as_state);
 
-    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+    ret = state->handler.recv(state, subreq, &state->out.arg0);
     talloc_zfree(subreq);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
-    ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
+    ret = _sbus_sss_invoker_write_as(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -561,14 +1392,15 @@ static void _sbus_sss_invoke_in_raw_out_qus_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_sss_invoke_in_s_out__state {
-    struct _sbus_sss_invoker_args_s *in;
+struct _sbus_sss_invoke_in_s_out_b_state {
+    struct _sbus_sss_invoker_args_s in;
+    struct _sbus_sss_invoker_args_b out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, bool*);
         struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, bool*);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -577,18 +1409,18 @@ struct _sbus_sss_invoke_in_s_out__state {
 };
 
 static void
-_sbus_sss_invoke_in_s_out__step
+_sbus_sss_invoke_in_s_out_b_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_s_out__done
+_sbus_sss_invoke_in_s_out_b_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_s_out__send
+_sbus_sss_invoke_in_s_out_b_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -598,12 +1430,12 @@ _sbus_sss_invoke_in_s_out__send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_s_out__state *state;
+    struct _sbus_sss_invoke_in_s_out_b_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out__state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_b_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -619,25 +1451,17 @@ _sbus_sss_invoke_in_s_out__send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out__step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_b_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -657,19 +1481,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_s_out__step
+static void _sbus_sss_invoke_in_s_out_b_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_s_out__state *state;
+    struct _sbus_sss_invoke_in_s_out_b_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out__state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_b_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -679,11 +1503,12 @@ static void _sbus_sss_invoke_in_s_out__step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
 
+        ret = _sbus_sss_invoker_write_b(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -692,14 +1517,14 @@ static void _sbus_sss_invoke_in_s_out__step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out__done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_b_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -714,35 +1539,41 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_s_out__done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_s_out_b_done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_s_out__state *state;
+    struct _sbus_sss_invoke_in_s_out_b_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out__state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_b_state);
 
-    ret = state->handler.recv(state, subreq);
+    ret = state->handler.recv(state, subreq, &state->out.arg0);
     talloc_zfree(subreq);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
+    ret = _sbus_sss_invoker_write_b(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
     tevent_req_done(req);
     return;
 }
 
-struct _sbus_sss_invoke_in_s_out_as_state {
-    struct _sbus_sss_invoker_args_s *in;
-    struct _sbus_sss_invoker_args_as out;
+struct _sbus_sss_invoke_in_s_out_qus_state {
+    struct _sbus_sss_invoker_args_s in;
+    struct _sbus_sss_invoker_args_qus out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char ***);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, uint16_t*, uint32_t*, const char **);
         struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char ***);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint16_t*, uint32_t*, const char **);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -751,18 +1582,18 @@ struct _sbus_sss_invoke_in_s_out_as_state {
 };
 
 static void
-_sbus_sss_invoke_in_s_out_as_step
+_sbus_sss_invoke_in_s_out_qus_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_s_out_as_done
+_sbus_sss_invoke_in_s_out_qus_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_s_out_as_send
+_sbus_sss_invoke_in_s_out_qus_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -772,12 +1603,12 @@ _sbus_sss_invoke_in_s_out_as_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_s_out_as_state *state;
+    struct _sbus_sss_invoke_in_s_out_qus_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_as_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_qus_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -793,25 +1624,17 @@ _sbus_sss_invoke_in_s_out_as_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_as_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_qus_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -831,19 +1654,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_s_out_as_step
+static void _sbus_sss_invoke_in_s_out_qus_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_s_out_as_state *state;
+    struct _sbus_sss_invoke_in_s_out_qus_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_as_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_qus_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -853,12 +1676,12 @@ static void _sbus_sss_invoke_in_s_out_as_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0, &state->out.arg1, &state->out.arg2);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_sss_invoker_write_as(state->write_iterator, &state->out);
+        ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -867,14 +1690,14 @@ static void _sbus_sss_invoke_in_s_out_as_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_as_done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_qus_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -889,23 +1712,23 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_s_out_as_done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_s_out_qus_done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_s_out_as_state *state;
+    struct _sbus_sss_invoke_in_s_out_qus_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_as_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_qus_state);
 
-    ret = state->handler.recv(state, subreq, &state->out.arg0);
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2);
     talloc_zfree(subreq);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
-    ret = _sbus_sss_invoker_write_as(state->write_iterator, &state->out);
+    ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -915,15 +1738,15 @@ static void _sbus_sss_invoke_in_s_out_as_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_sss_invoke_in_s_out_b_state {
-    struct _sbus_sss_invoker_args_s *in;
-    struct _sbus_sss_invoker_args_b out;
+struct _sbus_sss_invoke_in_s_out_s_state {
+    struct _sbus_sss_invoker_args_s in;
+    struct _sbus_sss_invoker_args_s out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, bool*);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char **);
         struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, bool*);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char **);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -932,18 +1755,18 @@ struct _sbus_sss_invoke_in_s_out_b_state {
 };
 
 static void
-_sbus_sss_invoke_in_s_out_b_step
+_sbus_sss_invoke_in_s_out_s_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_s_out_b_done
+_sbus_sss_invoke_in_s_out_s_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_s_out_b_send
+_sbus_sss_invoke_in_s_out_s_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -953,12 +1776,12 @@ _sbus_sss_invoke_in_s_out_b_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_s_out_b_state *state;
+    struct _sbus_sss_invoke_in_s_out_s_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_b_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_s_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -974,25 +1797,17 @@ _sbus_sss_invoke_in_s_out_b_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_b_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_s_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1012,19 +1827,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_s_out_b_step
+static void _sbus_sss_invoke_in_s_out_s_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_s_out_b_state *state;
+    struct _sbus_sss_invoke_in_s_out_s_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_b_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_s_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -1034,12 +1849,12 @@ static void _sbus_sss_invoke_in_s_out_b_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_sss_invoker_write_b(state->write_iterator, &state->out);
+        ret = _sbus_sss_invoker_write_s(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -1048,14 +1863,14 @@ static void _sbus_sss_invoke_in_s_out_b_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_b_done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_s_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -1070,14 +1885,14 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_s_out_b_done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_s_out_s_done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_s_out_b_state *state;
+    struct _sbus_sss_invoke_in_s_out_s_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_b_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_s_state);
 
     ret = state->handler.recv(state, subreq, &state->out.arg0);
     talloc_zfree(subreq);
@@ -1086,7 +1901,7 @@ static void _sbus_sss_invoke_in_s_out_b_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = _sbus_sss_invoker_write_b(state->write_iterator, &state->out);
+    ret = _sbus_sss_invoker_write_s(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -1096,15 +1911,15 @@ static void _sbus_sss_invoke_in_s_out_b_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_sss_invoke_in_s_out_qus_state {
-    struct _sbus_sss_invoker_args_s *in;
-    struct _sbus_sss_invoker_args_qus out;
+struct _sbus_sss_invoke_in_s_out_uu_state {
+    struct _sbus_sss_invoker_args_s in;
+    struct _sbus_sss_invoker_args_uu out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, uint16_t*, uint32_t*, const char **);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, uint32_t*, uint32_t*);
         struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint16_t*, uint32_t*, const char **);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint32_t*, uint32_t*);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -1113,18 +1928,18 @@ struct _sbus_sss_invoke_in_s_out_qus_state {
 };
 
 static void
-_sbus_sss_invoke_in_s_out_qus_step
+_sbus_sss_invoke_in_s_out_uu_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_s_out_qus_done
+_sbus_sss_invoke_in_s_out_uu_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_s_out_qus_send
+_sbus_sss_invoke_in_s_out_uu_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -1134,12 +1949,12 @@ _sbus_sss_invoke_in_s_out_qus_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_s_out_qus_state *state;
+    struct _sbus_sss_invoke_in_s_out_uu_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_qus_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_uu_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -1155,25 +1970,17 @@ _sbus_sss_invoke_in_s_out_qus_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_s(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_qus_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_uu_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1193,19 +2000,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_s_out_qus_step
+static void _sbus_sss_invoke_in_s_out_uu_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_s_out_qus_state *state;
+    struct _sbus_sss_invoke_in_s_out_uu_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_qus_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_uu_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -1215,12 +2022,12 @@ static void _sbus_sss_invoke_in_s_out_qus_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, &state->out.arg0, &state->out.arg1);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
+        ret = _sbus_sss_invoker_write_uu(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -1229,14 +2036,14 @@ static void _sbus_sss_invoke_in_s_out_qus_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_qus_done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_uu_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -1251,23 +2058,23 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_s_out_qus_done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_s_out_uu_done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_s_out_qus_state *state;
+    struct _sbus_sss_invoke_in_s_out_uu_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_qus_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_uu_state);
 
-    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1);
     talloc_zfree(subreq);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
-    ret = _sbus_sss_invoker_write_qus(state->write_iterator, &state->out);
+    ret = _sbus_sss_invoker_write_uu(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -1277,15 +2084,15 @@ static void _sbus_sss_invoke_in_s_out_qus_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_sss_invoke_in_s_out_s_state {
-    struct _sbus_sss_invoker_args_s *in;
-    struct _sbus_sss_invoker_args_s out;
+struct _sbus_sss_invoke_in_spayload_out_uu_state {
+    struct _sbus_sss_invoker_args_spayload in;
+    struct _sbus_sss_invoker_args_uu out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, const char **);
-        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, const char **);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, const char *, struct sss_iface_payload *, uint32_t*, uint32_t*);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, const char *, struct sss_iface_payload *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint32_t*, uint32_t*);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -1294,18 +2101,18 @@ struct _sbus_sss_invoke_in_s_out_s_state {
 };
 
 static void
-_sbus_sss_invoke_in_s_out_s_step
+_sbus_sss_invoke_in_spayload_out_uu_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_s_out_s_done
+_sbus_sss_invoke_in_spayload_out_uu_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_s_out_s_send
+_sbus_sss_invoke_in_spayload_out_uu_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -1315,12 +2122,12 @@ _sbus_sss_invoke_in_s_out_s_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_s_out_s_state *state;
+    struct _sbus_sss_invoke_in_spayload_out_uu_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_s_out_s_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_spayload_out_uu_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -1336,25 +2143,17 @@ _sbus_sss_invoke_in_s_out_s_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_s);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_s(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_spayload(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_s_out_s_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_spayload_out_uu_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1374,19 +2173,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_s_out_s_step
+static void _sbus_sss_invoke_in_spayload_out_uu_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_s_out_s_state *state;
+    struct _sbus_sss_invoke_in_spayload_out_uu_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_s_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_spayload_out_uu_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -1396,12 +2195,12 @@ static void _sbus_sss_invoke_in_s_out_s_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, &state->out.arg0, &state->out.arg1);
         if (ret != EOK) {
             goto done;
         }
 
-        ret = _sbus_sss_invoker_write_s(state->write_iterator, &state->out);
+        ret = _sbus_sss_invoker_write_uu(state->write_iterator, &state->out);
         goto done;
     case SBUS_HANDLER_ASYNC:
         if (state->handler.send == NULL || state->handler.recv == NULL) {
@@ -1410,14 +2209,14 @@ static void _sbus_sss_invoke_in_s_out_s_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_s_out_s_done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_spayload_out_uu_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -1432,23 +2231,23 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_s_out_s_done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_spayload_out_uu_done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_s_out_s_state *state;
+    struct _sbus_sss_invoke_in_spayload_out_uu_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_s_out_s_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_spayload_out_uu_state);
 
-    ret = state->handler.recv(state, subreq, &state->out.arg0);
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1);
     talloc_zfree(subreq);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
 
-    ret = _sbus_sss_invoker_write_s(state->write_iterator, &state->out);
+    ret = _sbus_sss_invoker_write_uu(state->write_iterator, &state->out);
     if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
@@ -1459,7 +2258,7 @@ static void _sbus_sss_invoke_in_s_out_s_done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_sqq_out_q_state {
-    struct _sbus_sss_invoker_args_sqq *in;
+    struct _sbus_sss_invoker_args_sqq in;
     struct _sbus_sss_invoker_args_q out;
     struct {
         enum sbus_handler_type type;
@@ -1517,15 +2316,7 @@ _sbus_sss_invoke_in_sqq_out_q_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_sqq);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_sqq(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_sqq(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -1535,7 +2326,7 @@ _sbus_sss_invoke_in_sqq_out_q_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1577,7 +2368,7 @@ static void _sbus_sss_invoke_in_sqq_out_q_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -1591,7 +2382,7 @@ static void _sbus_sss_invoke_in_sqq_out_q_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -1640,7 +2431,7 @@ static void _sbus_sss_invoke_in_sqq_out_q_done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_ss_out_o_state {
-    struct _sbus_sss_invoker_args_ss *in;
+    struct _sbus_sss_invoker_args_ss in;
     struct _sbus_sss_invoker_args_o out;
     struct {
         enum sbus_handler_type type;
@@ -1698,15 +2489,7 @@ _sbus_sss_invoke_in_ss_out_o_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_ss);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_ss(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_ss(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -1716,7 +2499,7 @@ _sbus_sss_invoke_in_ss_out_o_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1758,7 +2541,7 @@ static void _sbus_sss_invoke_in_ss_out_o_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, &state->out.arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, &state->out.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -1772,7 +2555,7 @@ static void _sbus_sss_invoke_in_ss_out_o_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -1821,7 +2604,7 @@ static void _sbus_sss_invoke_in_ss_out_o_done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_ssau_out__state {
-    struct _sbus_sss_invoker_args_ssau *in;
+    struct _sbus_sss_invoker_args_ssau in;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -1878,15 +2661,7 @@ _sbus_sss_invoke_in_ssau_out__send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_ssau);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_ssau(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_ssau(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -1896,7 +2671,7 @@ _sbus_sss_invoke_in_ssau_out__send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -1938,7 +2713,7 @@ static void _sbus_sss_invoke_in_ssau_out__step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (ret != EOK) {
             goto done;
         }
@@ -1951,7 +2726,7 @@ static void _sbus_sss_invoke_in_ssau_out__step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -1994,7 +2769,7 @@ static void _sbus_sss_invoke_in_ssau_out__done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_u_out__state {
-    struct _sbus_sss_invoker_args_u *in;
+    struct _sbus_sss_invoker_args_u in;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -2051,15 +2826,7 @@ _sbus_sss_invoke_in_u_out__send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_u);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_u(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_u(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2069,7 +2836,7 @@ _sbus_sss_invoke_in_u_out__send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2111,7 +2878,7 @@ static void _sbus_sss_invoke_in_u_out__step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0);
         if (ret != EOK) {
             goto done;
         }
@@ -2124,7 +2891,7 @@ static void _sbus_sss_invoke_in_u_out__step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2167,7 +2934,7 @@ static void _sbus_sss_invoke_in_u_out__done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_us_out__state {
-    struct _sbus_sss_invoker_args_us *in;
+    struct _sbus_sss_invoker_args_us in;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -2224,15 +2991,7 @@ _sbus_sss_invoke_in_us_out__send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_us);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_us(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_us(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2242,7 +3001,7 @@ _sbus_sss_invoke_in_us_out__send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2284,7 +3043,7 @@ static void _sbus_sss_invoke_in_us_out__step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (ret != EOK) {
             goto done;
         }
@@ -2297,7 +3056,7 @@ static void _sbus_sss_invoke_in_us_out__step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2340,7 +3099,7 @@ static void _sbus_sss_invoke_in_us_out__done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_us_out_qus_state {
-    struct _sbus_sss_invoker_args_us *in;
+    struct _sbus_sss_invoker_args_us in;
     struct _sbus_sss_invoker_args_qus out;
     struct {
         enum sbus_handler_type type;
@@ -2398,15 +3157,7 @@ _sbus_sss_invoke_in_us_out_qus_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_us);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_us(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_us(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2416,7 +3167,7 @@ _sbus_sss_invoke_in_us_out_qus_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2458,7 +3209,7 @@ static void _sbus_sss_invoke_in_us_out_qus_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, &state->out.arg0, &state->out.arg1, &state->out.arg2);
         if (ret != EOK) {
             goto done;
         }
@@ -2472,7 +3223,7 @@ static void _sbus_sss_invoke_in_us_out_qus_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2521,7 +3272,7 @@ static void _sbus_sss_invoke_in_us_out_qus_done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_usq_out__state {
-    struct _sbus_sss_invoker_args_usq *in;
+    struct _sbus_sss_invoker_args_usq in;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -2578,15 +3329,7 @@ _sbus_sss_invoke_in_usq_out__send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_usq);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_usq(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_usq(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2596,7 +3339,7 @@ _sbus_sss_invoke_in_usq_out__send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2638,7 +3381,7 @@ static void _sbus_sss_invoke_in_usq_out__step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (ret != EOK) {
             goto done;
         }
@@ -2651,7 +3394,7 @@ static void _sbus_sss_invoke_in_usq_out__step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2694,7 +3437,7 @@ static void _sbus_sss_invoke_in_usq_out__done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_uss_out__state {
-    struct _sbus_sss_invoker_args_uss *in;
+    struct _sbus_sss_invoker_args_uss in;
     struct {
         enum sbus_handler_type type;
         void *data;
@@ -2751,15 +3494,7 @@ _sbus_sss_invoke_in_uss_out__send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_uss);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_uss(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_uss(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2769,7 +3504,7 @@ _sbus_sss_invoke_in_uss_out__send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2811,7 +3546,7 @@ static void _sbus_sss_invoke_in_uss_out__step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (ret != EOK) {
             goto done;
         }
@@ -2824,7 +3559,7 @@ static void _sbus_sss_invoke_in_uss_out__step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -2867,7 +3602,7 @@ static void _sbus_sss_invoke_in_uss_out__done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_uss_out_qus_state {
-    struct _sbus_sss_invoker_args_uss *in;
+    struct _sbus_sss_invoker_args_uss in;
     struct _sbus_sss_invoker_args_qus out;
     struct {
         enum sbus_handler_type type;
@@ -2925,15 +3660,7 @@ _sbus_sss_invoke_in_uss_out_qus_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_uss);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_uss(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_uss(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -2943,7 +3670,7 @@ _sbus_sss_invoke_in_uss_out_qus_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -2985,7 +3712,7 @@ static void _sbus_sss_invoke_in_uss_out_qus_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, &state->out.arg0, &state->out.arg1, &state->out.arg2);
         if (ret != EOK) {
             goto done;
         }
@@ -2999,7 +3726,7 @@ static void _sbus_sss_invoke_in_uss_out_qus_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
@@ -3047,15 +3774,15 @@ static void _sbus_sss_invoke_in_uss_out_qus_done(struct tevent_req *subreq)
     return;
 }
 
-struct _sbus_sss_invoke_in_uusss_out_qus_state {
-    struct _sbus_sss_invoker_args_uusss *in;
-    struct _sbus_sss_invoker_args_qus out;
+struct _sbus_sss_invoke_in_uuasss_out_aqauas_state {
+    struct _sbus_sss_invoker_args_uuasss in;
+    struct _sbus_sss_invoker_args_aqauas out;
     struct {
         enum sbus_handler_type type;
         void *data;
-        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, uint32_t, uint32_t, const char *, const char *, const char *, uint16_t*, uint32_t*, const char **);
-        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, uint32_t, uint32_t, const char *, const char *, const char *);
-        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint16_t*, uint32_t*, const char **);
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, uint32_t, uint32_t, const char **, const char *, const char *, uint16_t **, uint32_t **, const char ***);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, uint32_t, uint32_t, const char **, const char *, const char *);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint16_t **, uint32_t **, const char ***);
     } handler;
 
     struct sbus_request *sbus_req;
@@ -3064,18 +3791,18 @@ struct _sbus_sss_invoke_in_uusss_out_qus_state {
 };
 
 static void
-_sbus_sss_invoke_in_uusss_out_qus_step
+_sbus_sss_invoke_in_uuasss_out_aqauas_step
     (struct tevent_context *ev,
      struct tevent_timer *te,
      struct timeval tv,
      void *private_data);
 
 static void
-_sbus_sss_invoke_in_uusss_out_qus_done
+_sbus_sss_invoke_in_uuasss_out_aqauas_done
    (struct tevent_req *subreq);
 
 struct tevent_req *
-_sbus_sss_invoke_in_uusss_out_qus_send
+_sbus_sss_invoke_in_uuasss_out_aqauas_send
    (TALLOC_CTX *mem_ctx,
     struct tevent_context *ev,
     struct sbus_request *sbus_req,
@@ -3085,12 +3812,12 @@ _sbus_sss_invoke_in_uusss_out_qus_send
     DBusMessageIter *write_iterator,
     const char **_key)
 {
-    struct _sbus_sss_invoke_in_uusss_out_qus_state *state;
+    struct _sbus_sss_invoke_in_uuasss_out_aqauas_state *state;
     struct tevent_req *req;
     const char *key;
     errno_t ret;
 
-    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_uusss_out_qus_state);
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_uuasss_out_aqauas_state);
     if (req == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
         return NULL;
@@ -3106,25 +3833,190 @@ _sbus_sss_invoke_in_uusss_out_qus_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_uusss);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
+    ret = _sbus_sss_invoker_read_uuasss(state, read_iterator, &state->in);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_uuasss_out_aqauas_step, req);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (_key != NULL) {
+        *_key = talloc_steal(mem_ctx, key);
+    }
+
+    ret = EAGAIN;
+
+done:
+    if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void _sbus_sss_invoke_in_uuasss_out_aqauas_step
+   (struct tevent_context *ev,
+    struct tevent_timer *te,
+    struct timeval tv,
+    void *private_data)
+{
+    struct _sbus_sss_invoke_in_uuasss_out_aqauas_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = talloc_get_type(private_data, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_uuasss_out_aqauas_state);
+
+    switch (state->handler.type) {
+    case SBUS_HANDLER_SYNC:
+        if (state->handler.sync == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: sync handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3, state->in.arg4, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = _sbus_sss_invoker_write_aqauas(state->write_iterator, &state->out);
+        goto done;
+    case SBUS_HANDLER_ASYNC:
+        if (state->handler.send == NULL || state->handler.recv == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Bug: async handler is not specified!\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3, state->in.arg4);
+        if (subreq == NULL) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
+            ret = ENOMEM;
+            goto done;
+        }
+
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_uuasss_out_aqauas_done, req);
+        ret = EAGAIN;
         goto done;
     }
 
-    ret = _sbus_sss_invoker_read_uusss(state, read_iterator, state->in);
+    ret = ERR_INTERNAL;
+
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void _sbus_sss_invoke_in_uuasss_out_aqauas_done(struct tevent_req *subreq)
+{
+    struct _sbus_sss_invoke_in_uuasss_out_aqauas_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_uuasss_out_aqauas_state);
+
+    ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = _sbus_sss_invoker_write_aqauas(state->write_iterator, &state->out);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+    return;
+}
+
+struct _sbus_sss_invoke_in_uussstt_out_qus_state {
+    struct _sbus_sss_invoker_args_uussstt in;
+    struct _sbus_sss_invoker_args_qus out;
+    struct {
+        enum sbus_handler_type type;
+        void *data;
+        errno_t (*sync)(TALLOC_CTX *, struct sbus_request *, void *, uint32_t, uint32_t, const char *, const char *, const char *, uint64_t, uint64_t, uint16_t*, uint32_t*, const char **);
+        struct tevent_req * (*send)(TALLOC_CTX *, struct tevent_context *, struct sbus_request *, void *, uint32_t, uint32_t, const char *, const char *, const char *, uint64_t, uint64_t);
+        errno_t (*recv)(TALLOC_CTX *, struct tevent_req *, uint16_t*, uint32_t*, const char **);
+    } handler;
+
+    struct sbus_request *sbus_req;
+    DBusMessageIter *read_iterator;
+    DBusMessageIter *write_iterator;
+};
+
+static void
+_sbus_sss_invoke_in_uussstt_out_qus_step
+    (struct tevent_context *ev,
+     struct tevent_timer *te,
+     struct timeval tv,
+     void *private_data);
+
+static void
+_sbus_sss_invoke_in_uussstt_out_qus_done
+   (struct tevent_req *subreq);
+
+struct tevent_req *
+_sbus_sss_invoke_in_uussstt_out_qus_send
+   (TALLOC_CTX *mem_ctx,
+    struct tevent_context *ev,
+    struct sbus_request *sbus_req,
+    sbus_invoker_keygen keygen,
+    const struct sbus_handler *handler,
+    DBusMessageIter *read_iterator,
+    DBusMessageIter *write_iterator,
+    const char **_key)
+{
+    struct _sbus_sss_invoke_in_uussstt_out_qus_state *state;
+    struct tevent_req *req;
+    const char *key;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct _sbus_sss_invoke_in_uussstt_out_qus_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create tevent request!\n");
+        return NULL;
+    }
+
+    state->handler.type = handler->type;
+    state->handler.data = handler->data;
+    state->handler.sync = handler->sync;
+    state->handler.send = handler->async_send;
+    state->handler.recv = handler->async_recv;
+
+    state->sbus_req = sbus_req;
+    state->read_iterator = read_iterator;
+    state->write_iterator = write_iterator;
+
+    ret = _sbus_sss_invoker_read_uussstt(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_uusss_out_qus_step, req);
+    ret = sbus_invoker_schedule(state, ev, _sbus_sss_invoke_in_uussstt_out_qus_step, req);
     if (ret != EOK) {
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -3144,19 +4036,19 @@ done:
     return req;
 }
 
-static void _sbus_sss_invoke_in_uusss_out_qus_step
+static void _sbus_sss_invoke_in_uussstt_out_qus_step
    (struct tevent_context *ev,
     struct tevent_timer *te,
     struct timeval tv,
     void *private_data)
 {
-    struct _sbus_sss_invoke_in_uusss_out_qus_state *state;
+    struct _sbus_sss_invoke_in_uussstt_out_qus_state *state;
     struct tevent_req *subreq;
     struct tevent_req *req;
     errno_t ret;
 
     req = talloc_get_type(private_data, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_uusss_out_qus_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_uussstt_out_qus_state);
 
     switch (state->handler.type) {
     case SBUS_HANDLER_SYNC:
@@ -3166,7 +4058,7 @@ static void _sbus_sss_invoke_in_uusss_out_qus_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2, state->in->arg3, state->in->arg4, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3, state->in.arg4, state->in.arg5, state->in.arg6, &state->out.arg0, &state->out.arg1, &state->out.arg2);
         if (ret != EOK) {
             goto done;
         }
@@ -3180,14 +4072,14 @@ static void _sbus_sss_invoke_in_uusss_out_qus_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2, state->in->arg3, state->in->arg4);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3, state->in.arg4, state->in.arg5, state->in.arg6);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
             goto done;
         }
 
-        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_uusss_out_qus_done, req);
+        tevent_req_set_callback(subreq, _sbus_sss_invoke_in_uussstt_out_qus_done, req);
         ret = EAGAIN;
         goto done;
     }
@@ -3202,14 +4094,14 @@ done:
     }
 }
 
-static void _sbus_sss_invoke_in_uusss_out_qus_done(struct tevent_req *subreq)
+static void _sbus_sss_invoke_in_uussstt_out_qus_done(struct tevent_req *subreq)
 {
-    struct _sbus_sss_invoke_in_uusss_out_qus_state *state;
+    struct _sbus_sss_invoke_in_uussstt_out_qus_state *state;
     struct tevent_req *req;
     errno_t ret;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct _sbus_sss_invoke_in_uusss_out_qus_state);
+    state = tevent_req_data(req, struct _sbus_sss_invoke_in_uussstt_out_qus_state);
 
     ret = state->handler.recv(state, subreq, &state->out.arg0, &state->out.arg1, &state->out.arg2);
     talloc_zfree(subreq);
@@ -3229,7 +4121,7 @@ static void _sbus_sss_invoke_in_uusss_out_qus_done(struct tevent_req *subreq)
 }
 
 struct _sbus_sss_invoke_in_uuus_out_qus_state {
-    struct _sbus_sss_invoker_args_uuus *in;
+    struct _sbus_sss_invoker_args_uuus in;
     struct _sbus_sss_invoker_args_qus out;
     struct {
         enum sbus_handler_type type;
@@ -3287,15 +4179,7 @@ _sbus_sss_invoke_in_uuus_out_qus_send
     state->read_iterator = read_iterator;
     state->write_iterator = write_iterator;
 
-    state->in = talloc_zero(state, struct _sbus_sss_invoker_args_uuus);
-    if (state->in == NULL) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Unable to allocate space for input parameters!\n");
-        ret = ENOMEM;
-        goto done;
-    }
-
-    ret = _sbus_sss_invoker_read_uuus(state, read_iterator, state->in);
+    ret = _sbus_sss_invoker_read_uuus(state, read_iterator, &state->in);
     if (ret != EOK) {
         goto done;
     }
@@ -3305,7 +4189,7 @@ _sbus_sss_invoke_in_uuus_out_qus_send
         goto done;
     }
 
-    ret = sbus_request_key(state, keygen, sbus_req, state->in, &key);
+    ret = sbus_request_key(state, keygen, sbus_req, &state->in, &key);
     if (ret != EOK) {
         goto done;
     }
@@ -3347,7 +4231,7 @@ static void _sbus_sss_invoke_in_uuus_out_qus_step
             goto done;
         }
 
-        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2, state->in->arg3, &state->out.arg0, &state->out.arg1, &state->out.arg2);
+        ret = state->handler.sync(state, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3, &state->out.arg0, &state->out.arg1, &state->out.arg2);
         if (ret != EOK) {
             goto done;
         }
@@ -3361,7 +4245,7 @@ static void _sbus_sss_invoke_in_uuus_out_qus_step
             goto done;
         }
 
-        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in->arg0, state->in->arg1, state->in->arg2, state->in->arg3);
+        subreq = state->handler.send(state, ev, state->sbus_req, state->handler.data, state->in.arg0, state->in.arg1, state->in.arg2, state->in.arg3);
         if (subreq == NULL) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Unable to create subrequest!\n");
             ret = ENOMEM;
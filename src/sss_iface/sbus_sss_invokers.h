@@ -40,6 +40,9 @@
          const char **_key)
 
 _sbus_sss_declare_invoker(, );
+_sbus_sss_declare_invoker(, asasatatauau);
+_sbus_sss_declare_invoker(, auasasas);
+_sbus_sss_declare_invoker(, auauasatatatau);
 _sbus_sss_declare_invoker(pam_data, pam_response);
 _sbus_sss_declare_invoker(raw, qus);
 _sbus_sss_declare_invoker(s, );
@@ -47,6 +50,8 @@ _sbus_sss_declare_invoker(s, as);
 _sbus_sss_declare_invoker(s, b);
 _sbus_sss_declare_invoker(s, qus);
 _sbus_sss_declare_invoker(s, s);
+_sbus_sss_declare_invoker(s, uu);
+_sbus_sss_declare_invoker(spayload, uu);
 _sbus_sss_declare_invoker(sqq, q);
 _sbus_sss_declare_invoker(ss, o);
 _sbus_sss_declare_invoker(ssau, );
@@ -56,7 +61,8 @@ _sbus_sss_declare_invoker(us, qus);
 _sbus_sss_declare_invoker(usq, );
 _sbus_sss_declare_invoker(uss, );
 _sbus_sss_declare_invoker(uss, qus);
-_sbus_sss_declare_invoker(uusss, qus);
+_sbus_sss_declare_invoker(uuasss, aqauas);
+_sbus_sss_declare_invoker(uussstt, qus);
 _sbus_sss_declare_invoker(uuus, qus);
 
 #endif /* _SBUS_SSS_INVOKERS_H_ */
@@ -119,6 +119,19 @@ _sbus_sss_args_sssd_DataProvider_Autofs_GetMap = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_DataProvider_Backend_CleanupProgress = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain_name"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "u", .name = "processed"},
+        {.type = "u", .name = "total"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_DataProvider_Backend_IsOnline = {
     .input = (const struct sbus_argument[]){
@@ -178,6 +191,20 @@ _sbus_sss_args_sssd_DataProvider_Failover_ListServices = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_Metrics_GetMetrics = {
+    .input = (const struct sbus_argument[]){
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "au", .name = "metrics"},
+        {.type = "as", .name = "suffixes"},
+        {.type = "as", .name = "labels"},
+        {.type = "as", .name = "values"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_ProxyChild_Auth_PAM = {
     .input = (const struct sbus_argument[]){
@@ -243,6 +270,39 @@ _sbus_sss_args_sssd_Responder_NegativeCache_ResetUsers = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_Responder_Statistics_GetCommandStats = {
+    .input = (const struct sbus_argument[]){
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "au", .name = "commands"},
+        {.type = "au", .name = "sources"},
+        {.type = "as", .name = "domains"},
+        {.type = "at", .name = "counts"},
+        {.type = "at", .name = "total_usec"},
+        {.type = "at", .name = "max_usec"},
+        {.type = "au", .name = "histograms"},
+        {NULL}
+    }
+};
+
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_Responder_Statistics_GetProviderRequestStats = {
+    .input = (const struct sbus_argument[]){
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "as", .name = "domains"},
+        {.type = "as", .name = "methods"},
+        {.type = "at", .name = "requests"},
+        {.type = "at", .name = "coalesced"},
+        {.type = "au", .name = "in_flight"},
+        {.type = "au", .name = "waiting"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getAccountDomain = {
     .input = (const struct sbus_argument[]){
@@ -266,6 +326,8 @@ _sbus_sss_args_sssd_dataprovider_getAccountInfo = {
         {.type = "s", .name = "filter"},
         {.type = "s", .name = "domain"},
         {.type = "s", .name = "extra"},
+        {.type = "t", .name = "trace_id"},
+        {.type = "t", .name = "parent_span_id"},
         {NULL}
     },
     .output = (const struct sbus_argument[]){
@@ -276,6 +338,24 @@ _sbus_sss_args_sssd_dataprovider_getAccountInfo = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_dataprovider_getAccountInfoBatch = {
+    .input = (const struct sbus_argument[]){
+        {.type = "u", .name = "dp_flags"},
+        {.type = "u", .name = "entry_type"},
+        {.type = "as", .name = "filters"},
+        {.type = "s", .name = "domain"},
+        {.type = "s", .name = "extra"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "aq", .name = "dp_errors"},
+        {.type = "au", .name = "errors"},
+        {.type = "as", .name = "error_messages"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getDomains = {
     .input = (const struct sbus_argument[]){
@@ -392,6 +472,20 @@ _sbus_sss_args_sssd_nss_MemoryCache_InvalidateAllUsers = {
     }
 };
 
+const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_InvalidateBatch = {
+    .input = (const struct sbus_argument[]){
+        {.type = "s", .name = "domain"},
+        {.type = "v", .name = "records"},
+        {NULL}
+    },
+    .output = (const struct sbus_argument[]){
+        {.type = "u", .name = "num_users"},
+        {.type = "u", .name = "num_groups"},
+        {NULL}
+    }
+};
+
 const struct sbus_method_arguments
 _sbus_sss_args_sssd_nss_MemoryCache_InvalidateGroupById = {
     .input = (const struct sbus_argument[]){
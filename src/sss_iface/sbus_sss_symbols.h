@@ -46,6 +46,9 @@ _sbus_sss_args_sssd_DataProvider_Autofs_GetEntry;
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_DataProvider_Autofs_GetMap;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_DataProvider_Backend_CleanupProgress;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_DataProvider_Backend_IsOnline;
 
@@ -61,6 +64,9 @@ _sbus_sss_args_sssd_DataProvider_Failover_ListServers;
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_DataProvider_Failover_ListServices;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_Metrics_GetMetrics;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_ProxyChild_Auth_PAM;
 
@@ -79,12 +85,21 @@ _sbus_sss_args_sssd_Responder_NegativeCache_ResetGroups;
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_Responder_NegativeCache_ResetUsers;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_Responder_Statistics_GetCommandStats;
+
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_Responder_Statistics_GetProviderRequestStats;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getAccountDomain;
 
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getAccountInfo;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_dataprovider_getAccountInfoBatch;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_dataprovider_getDomains;
 
@@ -112,6 +127,9 @@ _sbus_sss_args_sssd_nss_MemoryCache_InvalidateAllInitgroups;
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_nss_MemoryCache_InvalidateAllUsers;
 
+extern const struct sbus_method_arguments
+_sbus_sss_args_sssd_nss_MemoryCache_InvalidateBatch;
+
 extern const struct sbus_method_arguments
 _sbus_sss_args_sssd_nss_MemoryCache_InvalidateGroupById;
 
@@ -23,6 +23,7 @@
 #include <resolv.h>
 
 #include "util/util.h"
+#include "util/sss_metrics.h"
 #include "sbus/sbus.h"
 #include "sbus/sbus_opath.h"
 #include "sss_iface/sss_iface_async.h"
@@ -207,3 +208,73 @@ monitor_common_res_init(TALLOC_CTX *mem_ctx,
 
     return EOK;
 }
+
+static errno_t
+sss_iface_get_metrics(TALLOC_CTX *mem_ctx,
+                      struct sbus_request *sbus_req,
+                      void *no_data,
+                      uint32_t **_metrics,
+                      const char ***_suffixes,
+                      const char ***_labels,
+                      const char ***_values)
+{
+    struct sss_metrics_sample *samples;
+    uint32_t *metrics;
+    const char **suffixes;
+    const char **labels;
+    const char **values;
+    size_t num;
+    size_t i;
+    errno_t ret;
+
+    ret = sss_metrics_export(mem_ctx, &samples, &num);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    metrics = talloc_array(mem_ctx, uint32_t, num);
+    suffixes = talloc_zero_array(mem_ctx, const char *, num + 1);
+    labels = talloc_zero_array(mem_ctx, const char *, num + 1);
+    values = talloc_zero_array(mem_ctx, const char *, num + 1);
+    if (metrics == NULL || suffixes == NULL || labels == NULL
+            || values == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num; i++) {
+        metrics[i] = samples[i].metric;
+        suffixes[i] = samples[i].suffix;
+        labels[i] = samples[i].labels;
+        values[i] = samples[i].value;
+    }
+
+    *_metrics = metrics;
+    *_suffixes = suffixes;
+    *_labels = labels;
+    *_values = values;
+
+    return EOK;
+}
+
+errno_t
+sss_iface_register_metrics(struct sbus_connection *conn)
+{
+    errno_t ret;
+
+    SBUS_INTERFACE(iface_metrics,
+        sssd_Metrics,
+        SBUS_METHODS(
+            SBUS_SYNC(METHOD, sssd_Metrics, GetMetrics, sss_iface_get_metrics, NULL)
+        ),
+        SBUS_SIGNALS(SBUS_NO_SIGNALS),
+        SBUS_PROPERTIES(SBUS_NO_PROPERTIES)
+    );
+
+    ret = sbus_connection_add_path(conn, SSS_BUS_PATH, &iface_metrics);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to register metrics interface "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+    }
+
+    return ret;
+}
@@ -60,6 +60,24 @@
 #define PAC_SBUS_SERVICE_NAME "pac"
 #define PAC_SBUS_SERVICE_VERSION 0x0001
 
+/* Source of the data returned by a responder command, see
+ * sssd.Responder.Statistics. A command is accounted to the slowest
+ * source it used. */
+enum sss_cmd_source {
+    SSS_CMD_SOURCE_CACHE,
+    SSS_CMD_SOURCE_NCACHE,
+    SSS_CMD_SOURCE_PROVIDER,
+
+    SSS_CMD_SOURCE_SENTINEL
+};
+
+/* Each command latency histogram has SSS_CMD_STATS_BUCKETS buckets. The
+ * first one counts commands that took less than 2^SSS_CMD_STATS_FIRST_SHIFT
+ * microseconds, every other one doubles the limit of the previous one and
+ * the last one counts all slower commands. */
+#define SSS_CMD_STATS_BUCKETS 20
+#define SSS_CMD_STATS_FIRST_SHIFT 7
+
 /**
  * Return domain address.
  */
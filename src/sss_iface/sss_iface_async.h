@@ -64,4 +64,11 @@ monitor_common_res_init(TALLOC_CTX *mem_ctx,
                        struct sbus_request *sbus_req,
                        void *no_data);
 
+/**
+ * Export the metrics of this process through the sssd.Metrics interface
+ * on SSS_BUS_PATH so the monitor can collect them.
+ */
+errno_t
+sss_iface_register_metrics(struct sbus_connection *conn);
+
 #endif /* _SSS_IFACE_ASYNC_H_ */
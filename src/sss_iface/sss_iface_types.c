@@ -21,11 +21,13 @@
 #include <errno.h>
 #include <string.h>
 #include <stdint.h>
+#include <unistd.h>
 #include <talloc.h>
 #include <dbus/dbus.h>
 
 #include "util/util.h"
 #include "util/sss_utf8.h"
+#include "util/sss_memfd.h"
 #include "sss_iface/sss_iface_types.h"
 #include "sbus/interface/sbus_iterator_readers.h"
 #include "sbus/interface/sbus_iterator_writers.h"
@@ -420,3 +422,411 @@ done:
 
     return ret;
 }
+
+static int sss_iface_payload_destructor(struct sss_iface_payload *payload)
+{
+    if (payload->fd != -1) {
+        close(payload->fd);
+    }
+
+    return 0;
+}
+
+struct sss_iface_payload *
+sss_iface_payload_new(TALLOC_CTX *mem_ctx,
+                      const uint8_t *data,
+                      size_t length,
+                      bool allow_memfd)
+{
+    struct sss_iface_payload *payload;
+    errno_t ret;
+
+    payload = talloc_zero(mem_ctx, struct sss_iface_payload);
+    if (payload == NULL) {
+        return NULL;
+    }
+
+    payload->data = data;
+    payload->length = length;
+    payload->fd = -1;
+    talloc_set_destructor(payload, sss_iface_payload_destructor);
+
+    if (!allow_memfd || length < SSS_IFACE_PAYLOAD_MEMFD_MIN) {
+        return payload;
+    }
+
+    ret = sss_memfd_create("sssd-payload", data, length, &payload->fd);
+    if (ret != EOK) {
+        /* Send it inline. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to create memory file for "
+              "payload [%d]: %s\n", ret, sss_strerror(ret));
+        payload->fd = -1;
+    }
+
+    return payload;
+}
+
+/* Packed lists consist of 32-bit numbers in host byte order: the number
+ * of string lists and of id lists, then for every string list the number
+ * of strings, the size of the strings including their terminating zeros
+ * and the strings padded to four bytes, then for every id list the
+ * number of ids and the ids. */
+#define SSS_IFACE_PAD(size) (((size) + 3) & ~((size_t)3))
+
+static size_t
+sss_iface_strings_size(const char **strings, uint32_t *_count)
+{
+    size_t size = 0;
+    uint32_t count;
+
+    for (count = 0; strings != NULL && strings[count] != NULL; count++) {
+        size += strlen(strings[count]) + 1;
+    }
+
+    *_count = count;
+    return size;
+}
+
+errno_t sss_iface_payload_pack_lists(TALLOC_CTX *mem_ctx,
+                                     const char ***string_lists,
+                                     size_t num_string_lists,
+                                     uint32_t **id_lists,
+                                     size_t num_id_lists,
+                                     uint8_t **_data,
+                                     size_t *_length)
+{
+    uint8_t *data;
+    size_t length;
+    size_t size;
+    size_t pos;
+    size_t len;
+    uint32_t count;
+    uint32_t num;
+    size_t i;
+    size_t j;
+
+    length = 2 * sizeof(uint32_t);
+    for (i = 0; i < num_string_lists; i++) {
+        size = sss_iface_strings_size(string_lists[i], &count);
+        length += 2 * sizeof(uint32_t) + SSS_IFACE_PAD(size);
+    }
+
+    for (i = 0; i < num_id_lists; i++) {
+        length += sizeof(uint32_t)
+                  + talloc_array_length(id_lists[i]) * sizeof(uint32_t);
+    }
+
+    /* zeroed so the padding is defined */
+    data = talloc_zero_size(mem_ctx, length);
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    pos = 0;
+    num = num_string_lists;
+    SAFEALIGN_SET_UINT32(data + pos, num, &pos);
+    num = num_id_lists;
+    SAFEALIGN_SET_UINT32(data + pos, num, &pos);
+
+    for (i = 0; i < num_string_lists; i++) {
+        size = sss_iface_strings_size(string_lists[i], &count);
+        num = size;
+        SAFEALIGN_SET_UINT32(data + pos, count, &pos);
+        SAFEALIGN_SET_UINT32(data + pos, num, &pos);
+
+        for (j = 0; j < count; j++) {
+            len = strlen(string_lists[i][j]) + 1;
+            memcpy(data + pos, string_lists[i][j], len);
+            pos += len;
+        }
+
+        pos += SSS_IFACE_PAD(size) - size;
+    }
+
+    for (i = 0; i < num_id_lists; i++) {
+        count = talloc_array_length(id_lists[i]);
+        SAFEALIGN_SET_UINT32(data + pos, count, &pos);
+        if (count > 0) {
+            memcpy(data + pos, id_lists[i], count * sizeof(uint32_t));
+            pos += count * sizeof(uint32_t);
+        }
+    }
+
+    *_data = data;
+    *_length = length;
+
+    return EOK;
+}
+
+static errno_t
+sss_iface_payload_read_uint32(struct sss_iface_payload *payload,
+                              size_t *_pos,
+                              uint32_t *_value)
+{
+    if (payload->length - *_pos < sizeof(uint32_t)) {
+        return EINVAL;
+    }
+
+    SAFEALIGN_COPY_UINT32(_value, payload->data + *_pos, _pos);
+    return EOK;
+}
+
+errno_t sss_iface_payload_unpack_lists(TALLOC_CTX *mem_ctx,
+                                       struct sss_iface_payload *payload,
+                                       size_t num_string_lists,
+                                       const char ***_string_lists,
+                                       size_t num_id_lists,
+                                       uint32_t **_id_lists)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char ***string_lists;
+    uint32_t **id_lists;
+    const char *str;
+    const char *end;
+    uint32_t count;
+    uint32_t size;
+    size_t pos = 0;
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    string_lists = talloc_zero_array(tmp_ctx, const char **,
+                                     num_string_lists);
+    id_lists = talloc_zero_array(tmp_ctx, uint32_t *, num_id_lists);
+    if (string_lists == NULL || id_lists == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_iface_payload_read_uint32(payload, &pos, &count);
+    if (ret != EOK || count != num_string_lists) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = sss_iface_payload_read_uint32(payload, &pos, &count);
+    if (ret != EOK || count != num_id_lists) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    for (i = 0; i < num_string_lists; i++) {
+        ret = sss_iface_payload_read_uint32(payload, &pos, &count);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = sss_iface_payload_read_uint32(payload, &pos, &size);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        /* every string takes at least its terminating zero */
+        if (count > size || SSS_IFACE_PAD(size) > payload->length - pos) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        string_lists[i] = talloc_zero_array(string_lists, const char *,
+                                            count + 1);
+        if (string_lists[i] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        str = (const char *)payload->data + pos;
+        end = str + size;
+        for (j = 0; j < count; j++) {
+            string_lists[i][j] = str;
+
+            str = memchr(str, '\0', end - str);
+            if (str == NULL) {
+                ret = EINVAL;
+                goto done;
+            }
+            str++;
+        }
+
+        if (str != end) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        pos += SSS_IFACE_PAD(size);
+    }
+
+    for (i = 0; i < num_id_lists; i++) {
+        ret = sss_iface_payload_read_uint32(payload, &pos, &count);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        if (count > (payload->length - pos) / sizeof(uint32_t)) {
+            ret = EINVAL;
+            goto done;
+        }
+
+        if (count == 0) {
+            continue;
+        }
+
+        id_lists[i] = talloc_array(id_lists, uint32_t, count);
+        if (id_lists[i] == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        memcpy(id_lists[i], payload->data + pos, count * sizeof(uint32_t));
+        pos += count * sizeof(uint32_t);
+    }
+
+    if (pos != payload->length) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    for (i = 0; i < num_string_lists; i++) {
+        _string_lists[i] = talloc_steal(mem_ctx, string_lists[i]);
+    }
+
+    for (i = 0; i < num_id_lists; i++) {
+        _id_lists[i] = talloc_steal(mem_ctx, id_lists[i]);
+    }
+
+    ret = EOK;
+
+done:
+    if (ret == EINVAL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed payload\n");
+    }
+
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/**
+ * D-Bus signature: v, containing either h or ay
+ */
+errno_t sbus_iterator_read_payload(TALLOC_CTX *mem_ctx,
+                                   DBusMessageIter *iterator,
+                                   struct sss_iface_payload **_payload)
+{
+    struct sss_iface_payload *payload;
+    struct sss_memfd_map *map;
+    DBusMessageIter variant_iter;
+    uint8_t *bytes;
+    int fd;
+    errno_t ret;
+
+    if (dbus_message_iter_get_arg_type(iterator) != DBUS_TYPE_VARIANT) {
+        return ERR_SBUS_INVALID_TYPE;
+    }
+
+    payload = sss_iface_payload_new(mem_ctx, NULL, 0, false);
+    if (payload == NULL) {
+        return ENOMEM;
+    }
+
+    dbus_message_iter_recurse(iterator, &variant_iter);
+
+    switch (dbus_message_iter_get_arg_type(&variant_iter)) {
+    case DBUS_TYPE_UNIX_FD:
+        /* libdbus gives us our own copy of the descriptor */
+        dbus_message_iter_get_basic(&variant_iter, &fd);
+
+        ret = sss_memfd_map(payload, fd, &map);
+        close(fd);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        payload->data = map->data;
+        payload->length = map->length;
+        break;
+    case DBUS_TYPE_ARRAY:
+        ret = sbus_iterator_read_ay(payload, &variant_iter, &bytes);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        payload->data = bytes;
+        payload->length = talloc_array_length(bytes);
+        break;
+    default:
+        ret = ERR_SBUS_INVALID_TYPE;
+        goto done;
+    }
+
+    dbus_message_iter_next(iterator);
+
+    *_payload = payload;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read payload [%d]: %s\n",
+              ret, sss_strerror(ret));
+        talloc_free(payload);
+    }
+
+    return ret;
+}
+
+/**
+ * D-Bus signature: v, containing either h or ay
+ */
+errno_t sbus_iterator_write_payload(DBusMessageIter *iterator,
+                                    struct sss_iface_payload *payload)
+{
+    DBusMessageIter variant_iter;
+    dbus_bool_t dbret;
+    errno_t ret;
+
+    dbret = dbus_message_iter_open_container(iterator, DBUS_TYPE_VARIANT,
+                                             payload->fd != -1 ? "h" : "ay",
+                                             &variant_iter);
+    if (!dbret) {
+        ret = EIO;
+        goto done;
+    }
+
+    if (payload->fd != -1) {
+        /* The descriptor is duplicated by libdbus. */
+        dbret = dbus_message_iter_append_basic(&variant_iter,
+                                               DBUS_TYPE_UNIX_FD,
+                                               &payload->fd);
+        ret = dbret ? EOK : EIO;
+    } else {
+        ret = sbus_iterator_write_basic_array_len(&variant_iter,
+                                                  DBUS_TYPE_BYTE, uint8_t,
+                                                  payload->data,
+                                                  payload->length);
+    }
+
+    if (ret != EOK) {
+        dbus_message_iter_abandon_container(iterator, &variant_iter);
+        goto done;
+    }
+
+    dbret = dbus_message_iter_close_container(iterator, &variant_iter);
+    if (!dbret) {
+        dbus_message_iter_abandon_container(iterator, &variant_iter);
+        ret = EIO;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to write payload [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
+    return ret;
+}
@@ -26,6 +26,67 @@
 
 #include "util/sss_pam_data.h"
 
+/* Payloads of at least this size are sent in a sealed memory file. */
+#define SSS_IFACE_PAYLOAD_MEMFD_MIN (64 * 1024)
+
+/**
+ * Opaque data of the custom type 'payload'. Small payloads are sent as
+ * a byte array inside the D-Bus message. Large payloads are written once
+ * into a sealed memory file whose descriptor is passed with the message
+ * and which the receiver maps read-only, so the data is not copied into
+ * and out of libdbus buffers.
+ */
+struct sss_iface_payload {
+    const uint8_t *data;
+    size_t length;
+
+    /* Sealed memory file with the data or -1. */
+    int fd;
+};
+
+/**
+ * Create a payload for sending @data. @data is not copied and must be
+ * valid as long as the payload is used. A memory file is only used
+ * if @allow_memfd is true and @length is at least
+ * SSS_IFACE_PAYLOAD_MEMFD_MIN, see sbus_connection_can_pass_fd().
+ */
+struct sss_iface_payload *
+sss_iface_payload_new(TALLOC_CTX *mem_ctx,
+                      const uint8_t *data,
+                      size_t length,
+                      bool allow_memfd);
+
+/**
+ * Pack NULL terminated string lists and talloc arrays of ids into a single
+ * buffer, e.g. for a payload. Any list may be NULL.
+ */
+errno_t sss_iface_payload_pack_lists(TALLOC_CTX *mem_ctx,
+                                     const char ***string_lists,
+                                     size_t num_string_lists,
+                                     uint32_t **id_lists,
+                                     size_t num_id_lists,
+                                     uint8_t **_data,
+                                     size_t *_length);
+
+/**
+ * Unpack lists packed by sss_iface_payload_pack_lists(). The strings
+ * point into @payload and are valid as long as it is. String lists are
+ * always returned, id lists are NULL if they are empty.
+ */
+errno_t sss_iface_payload_unpack_lists(TALLOC_CTX *mem_ctx,
+                                       struct sss_iface_payload *payload,
+                                       size_t num_string_lists,
+                                       const char ***_string_lists,
+                                       size_t num_id_lists,
+                                       uint32_t **_id_lists);
+
+errno_t sbus_iterator_read_payload(TALLOC_CTX *mem_ctx,
+                                   DBusMessageIter *iterator,
+                                   struct sss_iface_payload **_payload);
+
+errno_t sbus_iterator_write_payload(DBusMessageIter *iterator,
+                                    struct sss_iface_payload *payload);
+
 errno_t sbus_iterator_read_pam_data(TALLOC_CTX *mem_ctx,
                                     DBusMessageIter *iterator,
                                     struct pam_data **_pd);
@@ -21,6 +21,7 @@
 */
 
 #include "util/util.h"
+#include "util/sss_ptr_hash.h"
 #include "tests/cmocka/common_mock_resp.h"
 
 /* Mock a responder context */
@@ -45,6 +46,13 @@ mock_rctx(TALLOC_CTX *mem_ctx,
     rctx->ev = ev;
     rctx->domains = domains;
     rctx->pvt_ctx = pvt_ctx;
+
+    rctx->cache_req_flights = sss_ptr_hash_create(rctx, NULL, NULL);
+    if (rctx->cache_req_flights == NULL) {
+        talloc_free(rctx);
+        return NULL;
+    }
+
     if (domains != NULL) {
         ret = sss_resp_populate_cr_domains(rctx);
         if (ret != EOK) {
@@ -270,6 +270,179 @@ static void test_get_name_by_uid(void **state)
     talloc_free(md);
 }
 
+struct recv_found
+{
+    bool found;
+};
+
+static errno_t
+get_found_by_uid_recv(TALLOC_CTX *mem_ctx,
+                      struct tevent_req *req,
+                      struct recv_found *recv_data)
+{
+    struct test_state *state;
+
+    state = tevent_req_data(req, struct test_state);
+    recv_data->found = state->name != NULL;
+
+    return EOK;
+}
+
+static void test_shared_request(void **state)
+{
+    errno_t ret;
+    struct test_ctx *test_ctx;
+    const char *req_name;
+    struct tevent_req *req;
+    struct tevent_req *req2;
+    struct tevent_req *req3;
+    struct method_data *md;
+    struct req_data *req_data;
+    struct req_data *req_data2;
+    struct req_data *req_data3;
+    struct recv_found *recv_data;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+
+    md = talloc(test_ctx, struct method_data);
+    assert_non_null(md);
+
+    dp_set_method(test_ctx->dp_methods,
+                  DPM_ACCOUNT_HANDLER,
+                  get_name_by_uid_send, get_found_by_uid_recv,
+                  md,
+                  struct method_data, struct req_data, struct recv_found);
+
+    req_data = talloc_zero(test_ctx, struct req_data);
+    assert_non_null(req_data);
+    req_data->uid = UID;
+
+    req_data2 = talloc_zero(test_ctx, struct req_data);
+    assert_non_null(req_data2);
+    req_data2->uid = UID;
+
+    req_data3 = talloc_zero(test_ctx, struct req_data);
+    assert_non_null(req_data3);
+    req_data3->uid = UID_FAIL;
+
+    req = dp_req_shared_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                             DPT_ID, DPM_ACCOUNT_HANDLER, 0, req_data,
+                             "uid:100001", &req_name);
+    assert_non_null(req);
+    assert_string_equal(req_name, REQ_NAME" #0");
+    talloc_zfree(req_name);
+
+    /* The same key, this caller joins request #0. */
+    req2 = dp_req_shared_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                              DPT_ID, DPM_ACCOUNT_HANDLER, DP_FAST_REPLY,
+                              req_data2, "uid:100001", &req_name);
+    assert_non_null(req2);
+    assert_string_equal(req_name, REQ_NAME" #0");
+    talloc_zfree(req_name);
+
+    req3 = dp_req_shared_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                              DPT_ID, DPM_ACCOUNT_HANDLER, 0, req_data3,
+                              "uid:100003", &req_name);
+    assert_non_null(req3);
+    assert_string_equal(req_name, REQ_NAME" #1");
+    talloc_zfree(req_name);
+
+    assert_int_equal(test_ctx->provider->requests.num_active, 2);
+    assert_int_equal(test_ctx->provider->requests.num_joined, 1);
+
+    tevent_loop_wait(test_ctx->tctx->ev);
+
+    ret = dp_req_recv_ptr(test_ctx, req, struct recv_found, &recv_data);
+    assert_int_equal(ret, EOK);
+    assert_true(recv_data->found);
+    talloc_free(recv_data);
+
+    ret = dp_req_recv_ptr(test_ctx, req2, struct recv_found, &recv_data);
+    assert_int_equal(ret, EOK);
+    assert_true(recv_data->found);
+    talloc_free(recv_data);
+
+    ret = dp_req_recv_ptr(test_ctx, req3, struct recv_found, &recv_data);
+    assert_int_equal(ret, EOK);
+    assert_false(recv_data->found);
+    talloc_free(recv_data);
+
+    talloc_free(req);
+    talloc_free(req2);
+    talloc_free(req3);
+    talloc_free(md);
+    talloc_zfree(test_ctx->provider->requests.shared);
+}
+
+static void test_queued_request(void **state)
+{
+    errno_t ret;
+    struct test_ctx *test_ctx;
+    struct dp_target *target;
+    const char *req_name;
+    struct tevent_req *req;
+    struct tevent_req *req2;
+    struct method_data *md;
+    struct req_data *req_data;
+    struct req_data *req_data2;
+    struct recv_data *recv_data;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+    target = test_ctx->provider->targets[DPT_ID];
+    target->max_requests = 1;
+
+    md = talloc(test_ctx, struct method_data);
+    assert_non_null(md);
+
+    dp_set_method(test_ctx->dp_methods,
+                  DPM_ACCOUNT_HANDLER,
+                  get_name_by_uid_send, get_name_by_uid_recv,
+                  md,
+                  struct method_data, struct req_data, struct recv_data);
+
+    req_data = talloc_zero(test_ctx, struct req_data);
+    assert_non_null(req_data);
+    req_data->uid = UID;
+
+    req_data2 = talloc_zero(test_ctx, struct req_data);
+    assert_non_null(req_data2);
+    req_data2->uid = UID2;
+
+    req = dp_req_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                      DPT_ID, DPM_ACCOUNT_HANDLER, 0, req_data, &req_name);
+    assert_non_null(req);
+    talloc_zfree(req_name);
+
+    /* The second request waits for the first one. */
+    req2 = dp_req_send(test_ctx, test_ctx->provider, NULL, REQ_NAME,
+                       DPT_ID, DPM_ACCOUNT_HANDLER, 0, req_data2, &req_name);
+    assert_non_null(req2);
+    talloc_zfree(req_name);
+
+    assert_int_equal(target->num_running, 1);
+    assert_non_null(target->queue);
+
+    tevent_loop_wait(test_ctx->tctx->ev);
+
+    assert_int_equal(target->num_running, 0);
+    assert_null(target->queue);
+
+    ret = dp_req_recv_ptr(test_ctx, req, struct recv_data, &recv_data);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(recv_data->name, NAME);
+    talloc_free(recv_data);
+
+    ret = dp_req_recv_ptr(test_ctx, req2, struct recv_data, &recv_data);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(recv_data->name, NAME2);
+    talloc_free(recv_data);
+
+    talloc_free(req);
+    talloc_free(req2);
+    talloc_free(md);
+    target->max_requests = 0;
+}
+
 static void test_type_mismatch(void **state)
 {
     errno_t ret;
@@ -426,6 +599,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_get_name_by_uid,
                                         test_setup,
                                         test_teardown),
+        cmocka_unit_test_setup_teardown(test_shared_request,
+                                        test_setup,
+                                        test_teardown),
+        cmocka_unit_test_setup_teardown(test_queued_request,
+                                        test_setup,
+                                        test_teardown),
         cmocka_unit_test_setup_teardown(test_fast_reply,
                                         test_setup,
                                         test_teardown),
@@ -30,6 +30,29 @@
 #include "util/util.h"
 #include "util/child_common.h"
 
+/* Answer with the pid of the helper followed by the request. */
+static errno_t pool_echo(TALLOC_CTX *mem_ctx,
+                         uint8_t *buf, size_t len,
+                         uint8_t **_reply, size_t *_reply_len,
+                         void *pvt)
+{
+    char *reply;
+
+    if (strcmp((char *) buf, "fail") == 0) {
+        return EIO;
+    }
+
+    reply = talloc_asprintf(mem_ctx, "%d %s", getpid(), (char *) buf);
+    if (reply == NULL) {
+        return ENOMEM;
+    }
+
+    *_reply = (uint8_t *) reply;
+    *_reply_len = strlen(reply);
+
+    return EOK;
+}
+
 int main(int argc, const char *argv[])
 {
     int opt;
@@ -107,6 +130,12 @@ int main(int argc, const char *argv[])
                       "debug_timestamp was not passed as expected\n");
                 _exit(1);
             }
+        } else if (strcasecmp(action, "pool_echo") == 0) {
+            ret = sss_child_pool_serve(STDIN_FILENO, STDOUT_FILENO,
+                                       pool_echo, NULL);
+            if (ret != EOK) {
+                _exit(1);
+            }
         } else if (strcasecmp(action, "echo") == 0) {
             errno = 0;
             len = sss_atomic_read_s(STDIN_FILENO, buf, IN_BUF_SIZE);
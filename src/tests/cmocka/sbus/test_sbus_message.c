@@ -27,6 +27,9 @@
 
 #include "util/util.h"
 #include "sbus/sbus_message.h"
+#include "sbus/sbus_private.h"
+#include "sbus/interface/sbus_iterator_readers.h"
+#include "sbus/interface/sbus_iterator_writers.h"
 #include "tests/cmocka/common_mock.h"
 #include "tests/common.h"
 
@@ -443,6 +446,132 @@ void test_sbus_reply_parse__ok(void **state)
     dbus_message_unref(reply);
 }
 
+void test_sbus_iterator_fixed_array(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    DBusMessage *msg;
+    DBusMessageIter iter;
+    uint32_t *in_au;
+    uint32_t *out_au;
+    uint8_t *in_ay;
+    uint8_t *out_ay;
+    uint8_t *out_empty;
+    errno_t ret;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    in_au = talloc_array(tmp_ctx, uint32_t, 100);
+    assert_non_null(in_au);
+    for (i = 0; i < 100; i++) {
+        in_au[i] = i * 1000;
+    }
+
+    in_ay = talloc_array(tmp_ctx, uint8_t, 3);
+    assert_non_null(in_ay);
+    in_ay[0] = 0;
+    in_ay[1] = 0x7f;
+    in_ay[2] = 0xff;
+
+    msg = dbus_message_new_method_call("bus.test", "/", "iface.test", "method");
+    assert_non_null(msg);
+
+    dbus_message_iter_init_append(msg, &iter);
+    ret = sbus_iterator_write_au(&iter, in_au);
+    assert_int_equal(ret, EOK);
+    ret = sbus_iterator_write_ay(&iter, in_ay);
+    assert_int_equal(ret, EOK);
+    ret = sbus_iterator_write_ay(&iter, NULL);
+    assert_int_equal(ret, EOK);
+
+    dbus_message_iter_init(msg, &iter);
+    ret = sbus_iterator_read_au(tmp_ctx, &iter, &out_au);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(talloc_array_length(out_au), 100);
+    assert_memory_equal(out_au, in_au, 100 * sizeof(uint32_t));
+
+    ret = sbus_iterator_read_ay(tmp_ctx, &iter, &out_ay);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(talloc_array_length(out_ay), 3);
+    assert_memory_equal(out_ay, in_ay, 3);
+
+    ret = sbus_iterator_read_ay(tmp_ctx, &iter, &out_empty);
+    assert_int_equal(ret, EOK);
+    assert_null(out_empty);
+
+    dbus_message_unref(msg);
+    talloc_free(tmp_ctx);
+}
+
+static DBusMessage *
+test_keygen_msg(uint32_t flags, const char **names)
+{
+    DBusMessage *msg;
+    DBusMessageIter iter;
+    errno_t ret;
+
+    msg = dbus_message_new_method_call("bus.test", "/", "iface.test", "method");
+    assert_non_null(msg);
+
+    dbus_message_iter_init_append(msg, &iter);
+    ret = sbus_iterator_write_u(&iter, flags);
+    assert_int_equal(ret, EOK);
+    ret = sbus_iterator_write_as(&iter, names);
+    assert_int_equal(ret, EOK);
+
+    return msg;
+}
+
+void test_sbus_message_keygen(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sbus_request sbus_req = {0};
+    const char *names1[] = {"rule1", "rule2", NULL};
+    const char *names2[] = {"rule1:rule2", NULL};
+    DBusMessage *msg1;
+    DBusMessage *msg2;
+    DBusMessage *msg3;
+    DBusMessage *msg4;
+    const char *key1;
+    const char *key2;
+    const char *key3;
+    const char *key4;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    sbus_req.type = SBUS_REQUEST_METHOD;
+    sbus_req.interface = "iface.test";
+    sbus_req.member = "method";
+    sbus_req.path = "/";
+
+    msg1 = test_keygen_msg(1, names1);
+    msg2 = test_keygen_msg(1, names1);
+    msg3 = test_keygen_msg(2, names1);
+    msg4 = test_keygen_msg(1, names2);
+
+    key1 = sbus_message_keygen(tmp_ctx, &sbus_req, msg1);
+    key2 = sbus_message_keygen(tmp_ctx, &sbus_req, msg2);
+    key3 = sbus_message_keygen(tmp_ctx, &sbus_req, msg3);
+    key4 = sbus_message_keygen(tmp_ctx, &sbus_req, msg4);
+    assert_non_null(key1);
+    assert_non_null(key2);
+    assert_non_null(key3);
+    assert_non_null(key4);
+
+    assert_string_equal(key1, key2);
+    assert_string_not_equal(key1, key3);
+    assert_string_not_equal(key1, key4);
+    assert_true(strncmp(key1, "-:0:iface.test.method:/:", 24) == 0);
+
+    dbus_message_unref(msg1);
+    dbus_message_unref(msg2);
+    dbus_message_unref(msg3);
+    dbus_message_unref(msg4);
+    talloc_free(tmp_ctx);
+}
+
 void test_sbus_reply_parse__error(void **state)
 {
     DBusMessage *msg;
@@ -577,6 +706,8 @@ int main(int argc, const char *argv[])
                                         test_setup, test_teardown),
         cmocka_unit_test_setup_teardown(test_sbus_reply_parse__ok,
                                         test_setup, test_teardown),
+        cmocka_unit_test(test_sbus_iterator_fixed_array),
+        cmocka_unit_test(test_sbus_message_keygen),
         cmocka_unit_test_setup_teardown(test_sbus_reply_parse__error,
                                         test_setup, test_teardown),
         cmocka_unit_test_setup_teardown(test_sbus_reply_parse__wrong_type,
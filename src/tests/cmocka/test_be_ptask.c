@@ -27,6 +27,7 @@
 #include "providers/backend.h"
 #include "providers/be_ptask_private.h"
 #include "providers/be_ptask.h"
+#include "shared/murmurhash3.h"
 #include "tests/cmocka/common_mock.h"
 #include "tests/cmocka/common_mock_be.h"
 #include "tests/common.h"
@@ -222,6 +223,18 @@ errno_t test_be_ptask_error_recv(struct tevent_req *req)
     return ERR_INTERNAL;
 }
 
+errno_t test_be_ptask_busy_recv(struct tevent_req *req)
+{
+    struct test_be_ptask_state *state = NULL;
+
+    state = tevent_req_data(req, struct test_be_ptask_state);
+    assert_non_null(state);
+
+    state->test_ctx->done = true;
+
+    return ERR_SERVER_BUSY;
+}
+
 errno_t test_be_ptask_sync(TALLOC_CTX *mem_ctx,
                            struct tevent_context *ev,
                            struct be_ctx *be_ctx,
@@ -873,6 +886,71 @@ void test_be_ptask_reschedule_backoff(void **state)
     assert_null(ptask);
 }
 
+void test_be_ptask_spread(void **state)
+{
+    struct test_ctx *test_ctx = (struct test_ctx *)(*state);
+    struct be_ptask *ptask = NULL;
+    time_t offset;
+    time_t before;
+    time_t after;
+    errno_t ret;
+
+    test_ctx->be_ctx->ptask_spread = 100;
+    test_ctx->be_ctx->ptask_host_seed = 0x12345678;
+    offset = murmurhash3("Test ptask", strlen("Test ptask"), 0x12345678) % 100;
+
+    before = get_current_time();
+    ret = be_ptask_create(test_ctx, test_ctx->be_ctx, 1000, DELAY, 0, 0, 0,
+                          0, test_be_ptask_send,
+                          test_be_ptask_recv, test_ctx, "Test ptask",
+                          BE_PTASK_OFFLINE_SKIP | BE_PTASK_SCHEDULE_FROM_LAST,
+                          &ptask);
+    after = get_current_time();
+    assert_int_equal(ret, ERR_OK);
+    assert_non_null(ptask);
+    assert_non_null(ptask->timer);
+
+    /* The first run is moved by the same offset every time. */
+    assert_true(before + DELAY + offset <= ptask->next_execution);
+    assert_true(ptask->next_execution <= after + DELAY + offset);
+
+    be_ptask_destroy(&ptask);
+    assert_null(ptask);
+}
+
+void test_be_ptask_reschedule_busy(void **state)
+{
+    struct test_ctx *test_ctx = (struct test_ctx *)(*state);
+    struct be_ptask *ptask = NULL;
+    time_t now = 0;
+    errno_t ret;
+
+    /* Offsets are always zero since the period is smaller than the window. */
+    test_ctx->be_ctx->ptask_spread = 100;
+    test_ctx->be_ctx->ptask_host_seed = 0x12345678;
+
+    ret = be_ptask_create(test_ctx, test_ctx->be_ctx, PERIOD, 0, 0, 0, 0,
+                          0, test_be_ptask_send,
+                          test_be_ptask_busy_recv, test_ctx, "Test ptask",
+                          BE_PTASK_OFFLINE_SKIP | BE_PTASK_SCHEDULE_FROM_LAST,
+                          &ptask);
+    assert_int_equal(ret, ERR_OK);
+    assert_non_null(ptask);
+    assert_non_null(ptask->timer);
+
+    while (!test_ctx->done) {
+        now = get_current_time();
+        tevent_loop_once(test_ctx->be_ctx->ev);
+    }
+
+    assert_int_equal(ptask->busy_factor, 2);
+    assert_true(now + PERIOD * 2 <= ptask->next_execution);
+    assert_non_null(ptask->timer);
+
+    be_ptask_destroy(&ptask);
+    assert_null(ptask);
+}
+
 void test_be_ptask_get_period(void **state)
 {
     struct test_ctx *test_ctx = (struct test_ctx *)(*state);
@@ -1116,6 +1194,8 @@ int main(int argc, const char *argv[])
         new_test(be_ptask_reschedule_error),
         new_test(be_ptask_reschedule_timeout),
         new_test(be_ptask_reschedule_backoff),
+        new_test(be_ptask_spread),
+        new_test(be_ptask_reschedule_busy),
         new_test(be_ptask_get_period),
         new_test(be_ptask_get_timeout),
         new_test(be_ptask_no_periodic),
@@ -1408,6 +1408,66 @@ static void test_sss_certmap_add_mapping_rule(void **state)
             "\\a2\\d3\\43\\21\\5b\\dc\\a2\\1d\\55\\a9\\48\\c5\\c4\\aa\\f3\\8b" \
             "\\e6\\3e\\75\\96\\e4\\3e\\64\\af\\e8\\a7\\6a\\b6"
 
+static void test_sss_certmap_cert_content(void **state)
+{
+    int ret;
+    struct sss_certmap_ctx *ctx;
+    struct sss_cert_content *content;
+    char *filter;
+    char **domains;
+
+    ret = sss_certmap_parse_cert(NULL, test_cert_der, sizeof(test_cert_der),
+                                 &content);
+    assert_int_equal(ret, 0);
+    assert_non_null(content);
+
+    ret = sss_certmap_init(NULL, ext_debug, NULL, &ctx);
+    assert_int_equal(ret, EOK);
+
+    /* Rules with the same issuer share the pattern. */
+    ret = sss_certmap_add_rule(ctx, 10,
+                            "KRB5:<ISSUER>CN=Certificate Authority,O=IPA.DEVEL"
+                            "<SUBJECT>^CN=other",
+                            "LDAP:rule10={subject_dn}", NULL);
+    assert_int_equal(ret, 0);
+    ret = sss_certmap_add_rule(ctx, 20, "KRB5:<ISSUER>^CN=Other CA",
+                               "LDAP:rule20={subject_dn}", NULL);
+    assert_int_equal(ret, 0);
+    ret = sss_certmap_add_rule(ctx, 30,
+                            "KRB5:<ISSUER>CN=Certificate Authority,O=IPA.DEVEL"
+                            "<SUBJECT>^CN=ipa-devel",
+                            "LDAP:rule30={subject_dn}", NULL);
+    assert_int_equal(ret, 0);
+    assert_int_equal(ctx->num_issuer_patterns, 2);
+
+    ret = sss_certmap_match_cert_content(ctx, content);
+    assert_int_equal(ret, 0);
+
+    ret = sss_certmap_get_search_filter_content(ctx, content,
+                                                &filter, &domains);
+    assert_int_equal(ret, 0);
+    assert_string_equal(filter,
+                        "rule30=CN=ipa-devel.ipa.devel,O=IPA.DEVEL");
+    assert_null(domains);
+    sss_certmap_free_filter_and_domains(filter, domains);
+
+    /* The content can be used with other contexts as well. */
+    sss_certmap_free_ctx(ctx);
+
+    ret = sss_certmap_init(NULL, ext_debug, NULL, &ctx);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_certmap_add_rule(ctx, 10, "KRB5:<ISSUER>^CN=Other CA",
+                               NULL, NULL);
+    assert_int_equal(ret, 0);
+
+    ret = sss_certmap_match_cert_content(ctx, content);
+    assert_int_equal(ret, ENOENT);
+
+    sss_certmap_free_ctx(ctx);
+    sss_certmap_free_cert_content(content);
+}
+
 static void test_sss_certmap_get_search_filter(void **state)
 {
     int ret;
@@ -1621,6 +1681,7 @@ int main(int argc, const char *argv[])
         cmocka_unit_test(test_sss_certmap_match_cert),
         cmocka_unit_test(test_sss_certmap_add_mapping_rule),
         cmocka_unit_test(test_sss_certmap_get_search_filter),
+        cmocka_unit_test(test_sss_certmap_cert_content),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -367,6 +367,53 @@ void test_exec_child_echo(void **state)
     assert_int_equal(ret, EOK);
 }
 
+/* Same as test_exec_child_echo but the child is started by sss_child_spawn
+ * without forking the test. */
+void test_child_spawn_echo(void **state)
+{
+    errno_t ret;
+    pid_t child_pid;
+    struct child_test_ctx *child_tctx = talloc_get_type(*state,
+                                                        struct child_test_ctx);
+    struct tevent_req *req;
+    struct child_io_fds *io_fds;
+
+    setenv("TEST_CHILD_ACTION", "echo", 1);
+
+    io_fds = talloc(child_tctx, struct child_io_fds);
+    assert_non_null(io_fds);
+    io_fds->read_from_child_fd = -1;
+    io_fds->write_to_child_fd = -1;
+    talloc_set_destructor((void *) io_fds, child_io_destructor);
+
+    ret = sss_child_spawn(child_tctx->pipefd_to_child,
+                          child_tctx->pipefd_from_child,
+                          CHILD_DIR"/"TEST_BIN, NULL, NULL, false,
+                          STDIN_FILENO, 3, &child_pid);
+    assert_int_equal(ret, EOK);
+
+    DEBUG(SSSDBG_FUNC_DATA, "Spawned %d\n", child_pid);
+
+    io_fds->read_from_child_fd = child_tctx->pipefd_from_child[0];
+    close(child_tctx->pipefd_from_child[1]);
+    io_fds->write_to_child_fd = child_tctx->pipefd_to_child[1];
+    close(child_tctx->pipefd_to_child[0]);
+
+    sss_fd_nonblocking(io_fds->write_to_child_fd);
+    sss_fd_nonblocking(io_fds->read_from_child_fd);
+
+    ret = child_handler_setup(child_tctx->test_ctx->ev, child_pid,
+                              NULL, NULL, NULL);
+    assert_int_equal(ret, EOK);
+
+    req = echo_child_write_send(child_tctx, child_tctx, io_fds, ECHO_STR);
+    assert_non_null(req);
+
+    ret = test_ev_loop(child_tctx->test_ctx);
+    talloc_free(io_fds);
+    assert_int_equal(ret, EOK);
+}
+
 struct test_exec_echo_state {
     struct child_io_fds *io_fds;
     struct io_buffer buf;
@@ -500,6 +547,156 @@ void sss_child_cb(int pid, int wait_status, void *pvt)
     child_ctx->test_ctx->done = true;
 }
 
+struct test_pool_ctx {
+    struct sss_test_ctx *test_ctx;
+    size_t num;
+    size_t finished;
+    errno_t errors[4];
+    pid_t pids[4];
+    char words[4][16];
+};
+
+struct test_pool_req {
+    struct test_pool_ctx *ctx;
+    size_t idx;
+};
+
+static void test_child_pool_done(struct tevent_req *req)
+{
+    struct test_pool_req *pool_req;
+    struct test_pool_ctx *ctx;
+    uint8_t *buf;
+    size_t len;
+    int pid;
+    errno_t ret;
+
+    pool_req = tevent_req_callback_data(req, struct test_pool_req);
+    ctx = pool_req->ctx;
+
+    ret = sss_child_pool_recv(req, pool_req, &buf, &len);
+    talloc_zfree(req);
+
+    ctx->errors[pool_req->idx] = ret;
+    if (ret == EOK) {
+        assert_int_equal(sscanf((char *) buf, "%d %15s", &pid,
+                                ctx->words[pool_req->idx]), 2);
+        ctx->pids[pool_req->idx] = pid;
+    }
+
+    talloc_free(pool_req);
+
+    ctx->finished++;
+    if (ctx->finished == ctx->num) {
+        ctx->test_ctx->done = true;
+    }
+}
+
+static void test_child_pool_send(struct test_pool_ctx *ctx,
+                                 struct sss_child_pool *pool,
+                                 const char *word)
+{
+    struct test_pool_req *pool_req;
+    struct tevent_req *req;
+
+    pool_req = talloc_zero(ctx, struct test_pool_req);
+    assert_non_null(pool_req);
+    pool_req->ctx = ctx;
+    pool_req->idx = ctx->num++;
+
+    req = sss_child_pool_send(pool_req, pool, (uint8_t *) discard_const(word),
+                              strlen(word));
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_child_pool_done, pool_req);
+}
+
+/* Requests wait for the single helper, which is replaced after two. */
+void test_child_pool(void **state)
+{
+    struct child_test_ctx *child_tctx = talloc_get_type(*state,
+                                                        struct child_test_ctx);
+    struct sss_child_pool_opts opts = { 0 };
+    struct sss_child_pool *pool;
+    struct test_pool_ctx *ctx;
+    errno_t ret;
+
+    setenv("TEST_CHILD_ACTION", "pool_echo", 1);
+
+    opts.name = "test";
+    opts.binary = CHILD_DIR"/"TEST_BIN;
+    opts.min_idle = 1;
+    opts.max_helpers = 1;
+    opts.max_uses = 2;
+    opts.timeout = 5;
+
+    ret = sss_child_pool_create(child_tctx, child_tctx->test_ctx->ev, &opts,
+                                &pool);
+    assert_int_equal(ret, EOK);
+
+    ctx = talloc_zero(child_tctx, struct test_pool_ctx);
+    assert_non_null(ctx);
+    ctx->test_ctx = child_tctx->test_ctx;
+
+    test_child_pool_send(ctx, pool, "john");
+    test_child_pool_send(ctx, pool, "paul");
+    test_child_pool_send(ctx, pool, "george");
+
+    ret = test_ev_loop(child_tctx->test_ctx);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(ctx->errors[0], EOK);
+    assert_int_equal(ctx->errors[1], EOK);
+    assert_int_equal(ctx->errors[2], EOK);
+    assert_string_equal(ctx->words[0], "john");
+    assert_string_equal(ctx->words[1], "paul");
+    assert_string_equal(ctx->words[2], "george");
+    assert_int_equal(ctx->pids[0], ctx->pids[1]);
+    assert_int_not_equal(ctx->pids[1], ctx->pids[2]);
+
+    talloc_free(pool);
+    talloc_free(ctx);
+}
+
+/* A helper that fails a request is replaced for the next one. */
+void test_child_pool_failed(void **state)
+{
+    struct child_test_ctx *child_tctx = talloc_get_type(*state,
+                                                        struct child_test_ctx);
+    struct sss_child_pool_opts opts = { 0 };
+    struct sss_child_pool *pool;
+    struct test_pool_ctx *ctx;
+    errno_t ret;
+
+    setenv("TEST_CHILD_ACTION", "pool_echo", 1);
+
+    opts.name = "test";
+    opts.binary = CHILD_DIR"/"TEST_BIN;
+    opts.max_helpers = 1;
+    opts.timeout = 5;
+
+    ret = sss_child_pool_create(child_tctx, child_tctx->test_ctx->ev, &opts,
+                                &pool);
+    assert_int_equal(ret, EOK);
+
+    ctx = talloc_zero(child_tctx, struct test_pool_ctx);
+    assert_non_null(ctx);
+    ctx->test_ctx = child_tctx->test_ctx;
+
+    test_child_pool_send(ctx, pool, "ringo");
+    test_child_pool_send(ctx, pool, "fail");
+    test_child_pool_send(ctx, pool, "ringo");
+
+    ret = test_ev_loop(child_tctx->test_ctx);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(ctx->errors[0], EOK);
+    assert_int_equal(ctx->errors[1], EPIPE);
+    assert_int_equal(ctx->errors[2], EOK);
+    assert_int_not_equal(ctx->pids[0], ctx->pids[2]);
+
+    talloc_free(pool);
+    talloc_free(ctx);
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -527,6 +724,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_exec_child_echo,
                                         child_test_setup,
                                         child_test_teardown),
+        cmocka_unit_test_setup_teardown(test_child_spawn_echo,
+                                        child_test_setup,
+                                        child_test_teardown),
         cmocka_unit_test_setup_teardown(test_sss_child,
                                         child_test_setup,
                                         child_test_teardown),
@@ -536,6 +736,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_exec_child_only_extra_args_neg,
                                         only_extra_args_setup,
                                         only_extra_args_teardown),
+        cmocka_unit_test_setup_teardown(test_child_pool,
+                                        child_test_setup,
+                                        child_test_teardown),
+        cmocka_unit_test_setup_teardown(test_child_pool_failed,
+                                        child_test_setup,
+                                        child_test_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
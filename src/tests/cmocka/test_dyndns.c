@@ -693,6 +693,61 @@ void dyndns_test_create_ptr_msg(void **state)
     assert_true(check_leaks_pop(dyndns_test_ctx) == true);
 }
 
+void dyndns_test_addrs_unchanged(void **state)
+{
+    errno_t ret;
+    struct be_nsupdate_ctx *ctx;
+    struct sss_iface_addr *addrlist;
+    struct sss_iface_addr *reordered;
+    struct sss_iface_addr *changed;
+
+    ret = be_nsupdate_init(dyndns_test_ctx, dyndns_test_ctx->be_ctx, NULL,
+                           &ctx);
+    assert_int_equal(ret, EOK);
+
+    will_return_getifaddrs("eth0", "192.168.0.1", AF_INET);
+    will_return_getifaddrs("eth0", "2001:cdba::555", AF_INET6);
+    will_return_getifaddrs(NULL, NULL, 0); /* sentinel */
+    ret = sss_iface_addr_list_get(ctx, "eth0", &addrlist);
+    assert_int_equal(ret, EOK);
+
+    will_return_getifaddrs("eth0", "2001:cdba::555", AF_INET6);
+    will_return_getifaddrs("eth0", "192.168.0.1", AF_INET);
+    will_return_getifaddrs(NULL, NULL, 0); /* sentinel */
+    ret = sss_iface_addr_list_get(ctx, "eth0", &reordered);
+    assert_int_equal(ret, EOK);
+
+    will_return_getifaddrs("eth0", "192.168.0.2", AF_INET);
+    will_return_getifaddrs("eth0", "2001:cdba::555", AF_INET6);
+    will_return_getifaddrs(NULL, NULL, 0); /* sentinel */
+    ret = sss_iface_addr_list_get(ctx, "eth0", &changed);
+    assert_int_equal(ret, EOK);
+
+    /* Nothing was updated yet */
+    assert_false(be_nsupdate_addrs_unchanged(ctx, "bran_stark", addrlist));
+
+    ret = be_nsupdate_set_last_update(ctx, "bran_stark", addrlist);
+    assert_int_equal(ret, EOK);
+
+    assert_true(be_nsupdate_addrs_unchanged(ctx, "bran_stark", addrlist));
+    assert_true(be_nsupdate_addrs_unchanged(ctx, "bran_stark", reordered));
+    assert_false(be_nsupdate_addrs_unchanged(ctx, "bran_stark", changed));
+    assert_false(be_nsupdate_addrs_unchanged(ctx, "arya_stark", addrlist));
+
+    /* The records have to be refreshed after the interval */
+    ctx->last_update -= 604800;
+    assert_false(be_nsupdate_addrs_unchanged(ctx, "bran_stark", addrlist));
+
+    /* A failed update is not skipped */
+    ret = be_nsupdate_set_last_update(ctx, "bran_stark", addrlist);
+    assert_int_equal(ret, EOK);
+    ret = be_nsupdate_set_last_update(ctx, NULL, NULL);
+    assert_int_equal(ret, EOK);
+    assert_false(be_nsupdate_addrs_unchanged(ctx, "bran_stark", addrlist));
+
+    talloc_free(ctx);
+}
+
 void dyndns_test_dualstack(void **state)
 {
     errno_t ret;
@@ -1072,6 +1127,11 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(dyndns_test_create_ptr_msg,
                                         dyndns_test_setup,
                                         dyndns_test_teardown),
+
+        /* Skipping unchanged updates */
+        cmocka_unit_test_setup_teardown(dyndns_test_addrs_unchanged,
+                                        dyndns_test_setup,
+                                        dyndns_test_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
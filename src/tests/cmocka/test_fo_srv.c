@@ -29,6 +29,8 @@
 #include <sys/types.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
 
 #include "providers/fail_over_srv.h"
 #include "tests/cmocka/common_mock.h"
@@ -76,6 +78,26 @@ const char *resolv_strerror(int ares_code)
     return NULL;
 }
 
+/* All servers live on the loopback when they are probed. */
+struct sockaddr_storage *
+resolv_get_sockaddr_address_index(TALLOC_CTX *mem_ctx,
+                                  struct resolv_hostent *hostent,
+                                  int port, int addrindex)
+{
+    struct sockaddr_in *sin;
+
+    sin = talloc_zero_size(mem_ctx, sizeof(struct sockaddr_storage));
+    if (sin == NULL) {
+        return NULL;
+    }
+
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons(port);
+    sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    return (struct sockaddr_storage *)sin;
+}
+
 struct tevent_req *resolv_discover_srv_send(TALLOC_CTX *mem_ctx,
                                             struct tevent_context *ev,
                                             struct resolv_ctx *resolv_ctx,
@@ -693,6 +715,188 @@ static void test_fo_hostlist(void **state)
     assert_int_equal(ret, ERR_OK);
 }
 
+static int test_fo_listen(int *_port)
+{
+    struct sockaddr_in sin;
+    socklen_t len = sizeof(sin);
+    int ret;
+    int sd;
+
+    sd = socket(AF_INET, SOCK_STREAM, 0);
+    assert_true(sd >= 0);
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    ret = bind(sd, (struct sockaddr *)&sin, sizeof(sin));
+    assert_int_equal(ret, 0);
+
+    ret = getsockname(sd, (struct sockaddr *)&sin, &len);
+    assert_int_equal(ret, 0);
+
+    ret = listen(sd, 1);
+    assert_int_equal(ret, 0);
+
+    *_port = ntohs(sin.sin_port);
+    return sd;
+}
+
+static void test_fo_probe_done(struct tevent_req *req);
+
+void test_fo_probe(void **state)
+{
+    struct test_fo_ctx *test_ctx =
+        talloc_get_type(*state, struct test_fo_ctx);
+    struct fo_options fopts;
+    struct fo_service *fo_svc;
+    struct fo_ctx *fo_ctx;
+    struct tevent_req *req;
+    int dead_port;
+    int port;
+    int sd;
+    errno_t ret;
+
+    memset(&fopts, 0, sizeof(fopts));
+    fopts.retry_timeout = TEST_FO_TIMEOUT;
+    fopts.service_resolv_timeout = TEST_RESOLV_TIMEOUT;
+    fopts.family_order = IPV4_FIRST;
+    fopts.probe_servers = 3;
+
+    fo_ctx = fo_context_init(test_ctx, &fopts);
+    assert_non_null(fo_ctx);
+
+    ret = fo_new_service(fo_ctx, "ldap", test_fo_srv_data_cmp, &fo_svc);
+    assert_int_equal(ret, ERR_OK);
+
+    /* Nobody listens on the port once it is closed. */
+    sd = test_fo_listen(&dead_port);
+    close(sd);
+    sd = test_fo_listen(&port);
+
+    /* The first server does not answer, the second one does. */
+    ret = fo_add_server(fo_svc, "ldap1.sssd.com", dead_port, test_ctx, true);
+    assert_int_equal(ret, ERR_OK);
+
+    ret = fo_add_server(fo_svc, "ldap2.sssd.com", port, test_ctx, true);
+    assert_int_equal(ret, ERR_OK);
+
+    req = fo_resolve_service_send(test_ctx, test_ctx->ctx->ev,
+                                  test_ctx->resolv, fo_ctx, fo_svc);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_fo_probe_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->ctx);
+    close(sd);
+    assert_int_equal(ret, ERR_OK);
+}
+
+static void test_fo_probe_done(struct tevent_req *req)
+{
+    struct test_fo_ctx *test_ctx = \
+        tevent_req_callback_data(req, struct test_fo_ctx);
+    struct fo_server *srv;
+    errno_t ret;
+
+    ret = fo_resolve_service_recv(req, req, &srv);
+    assert_int_equal(ret, ERR_OK);
+    assert_non_null(srv);
+    assert_string_equal(fo_get_server_name(srv), "ldap2.sssd.com");
+    talloc_free(req);
+
+    test_ev_done(test_ctx->ctx, ERR_OK);
+}
+
+static void test_fo_health_done(struct tevent_req *req);
+
+static void test_fo_health_resolve(struct test_fo_ctx *test_ctx,
+                                   struct fo_ctx *fo_ctx,
+                                   const char *name)
+{
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = fo_resolve_service_send(test_ctx, test_ctx->ctx->ev,
+                                  test_ctx->resolv, fo_ctx,
+                                  test_ctx->fo_svc);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_fo_health_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->ctx);
+    assert_int_equal(ret, ERR_OK);
+    test_ctx->ctx->done = false;
+
+    assert_string_equal(fo_get_server_name(test_ctx->srv), name);
+}
+
+void test_fo_health(void **state)
+{
+    struct test_fo_ctx *test_ctx =
+        talloc_get_type(*state, struct test_fo_ctx);
+    struct fo_options fopts;
+    struct fo_ctx *fo_ctx;
+    bool reconnect = false;
+    errno_t ret;
+    int i;
+
+    memset(&fopts, 0, sizeof(fopts));
+    fopts.retry_timeout = TEST_FO_TIMEOUT;
+    fopts.service_resolv_timeout = TEST_RESOLV_TIMEOUT;
+    fopts.family_order = IPV4_FIRST;
+    fopts.slow_server_msec = 100;
+
+    fo_ctx = fo_context_init(test_ctx, &fopts);
+    assert_non_null(fo_ctx);
+
+    ret = fo_new_service(fo_ctx, "ldap", test_fo_srv_data_cmp,
+                         &test_ctx->fo_svc);
+    assert_int_equal(ret, ERR_OK);
+
+    ret = fo_add_server(test_ctx->fo_svc, "ldap1.sssd.com", 389,
+                        test_ctx, true);
+    assert_int_equal(ret, ERR_OK);
+
+    ret = fo_add_server(test_ctx->fo_svc, "ldap2.sssd.com", 389,
+                        test_ctx, true);
+    assert_int_equal(ret, ERR_OK);
+
+    test_fo_health_resolve(test_ctx, fo_ctx, "ldap1.sssd.com");
+    fo_set_port_status(test_ctx->srv, PORT_WORKING);
+
+    /* Fast operations keep the server. */
+    for (i = 0; i < 10; i++) {
+        assert_false(fo_server_report_op(test_ctx->srv, 10000, false));
+    }
+    test_fo_health_resolve(test_ctx, fo_ctx, "ldap1.sssd.com");
+
+    /* Slow operations make the other server preferred. */
+    for (i = 0; i < 30 && !reconnect; i++) {
+        reconnect = fo_server_report_op(test_ctx->srv, 1000000, false);
+    }
+    assert_true(reconnect);
+    test_fo_health_resolve(test_ctx, fo_ctx, "ldap2.sssd.com");
+    fo_set_port_status(test_ctx->srv, PORT_WORKING);
+
+    /* Failing operations count too, but there is no better server now. */
+    for (i = 0; i < 30; i++) {
+        assert_false(fo_server_report_op(test_ctx->srv, 10000, true));
+    }
+    test_fo_health_resolve(test_ctx, fo_ctx, "ldap2.sssd.com");
+}
+
+static void test_fo_health_done(struct tevent_req *req)
+{
+    struct test_fo_ctx *test_ctx = \
+        tevent_req_callback_data(req, struct test_fo_ctx);
+    errno_t ret;
+
+    ret = fo_resolve_service_recv(req, test_ctx, &test_ctx->srv);
+    talloc_zfree(req);
+    assert_int_equal(ret, ERR_OK);
+
+    test_ev_done(test_ctx->ctx, ERR_OK);
+}
+
 static void test_fo_srv_dup_done(struct tevent_req *req);
 
 /* Test that running two parallel SRV queries doesn't return an error.
@@ -781,6 +985,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_fo_srv_duplicates,
                                         test_fo_srv_setup,
                                         test_fo_srv_teardown),
+        cmocka_unit_test_setup_teardown(test_fo_probe,
+                                        test_fo_setup,
+                                        test_fo_teardown),
+        cmocka_unit_test_setup_teardown(test_fo_health,
+                                        test_fo_setup,
+                                        test_fo_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -264,6 +264,84 @@ void test_attr_allowed(void **state)
     assert_false(ifp_attr_allowed(NULL, "name"));
 }
 
+void test_list_ctx_paged(void **state)
+{
+    struct ifp_list_ctx *list_ctx;
+    struct ifp_ctx *ifp_ctx;
+    size_t capacity;
+    size_t skip;
+    errno_t ret;
+
+    ifp_ctx = talloc_zero(NULL, struct ifp_ctx);
+    assert_non_null(ifp_ctx);
+    ifp_ctx->rctx = talloc_zero(ifp_ctx, struct resp_ctx);
+    assert_non_null(ifp_ctx->rctx);
+
+    list_ctx = ifp_list_ctx_new(ifp_ctx, ifp_ctx, "*", 3);
+    assert_non_null(list_ctx);
+    list_ctx->offset = 5;
+
+    /* the first domain lies completely before the page */
+    skip = ifp_list_ctx_skip(list_ctx, 4);
+    assert_int_equal(skip, 4);
+    assert_false(ifp_list_ctx_full(list_ctx));
+
+    /* the page starts in the second domain */
+    skip = ifp_list_ctx_skip(list_ctx, 10);
+    assert_int_equal(skip, 1);
+    ret = ifp_list_ctx_remaining_capacity(list_ctx, 10 - skip, &capacity);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(capacity, 3);
+    list_ctx->path_count += capacity;
+    assert_true(ifp_list_ctx_full(list_ctx));
+
+    skip = ifp_list_ctx_skip(list_ctx, 10);
+    assert_int_equal(skip, 0);
+
+    talloc_free(ifp_ctx);
+}
+
+void test_result_cache(void **state)
+{
+    const char *groups[] = {"group1", "group2", NULL};
+    const char **cached;
+    struct ifp_ctx *ifp_ctx;
+    errno_t ret;
+
+    ifp_ctx = talloc_zero(NULL, struct ifp_ctx);
+    assert_non_null(ifp_ctx);
+
+    /* a disabled cache keeps nothing */
+    ret = ifp_result_cache_init(ifp_ctx, 0);
+    assert_int_equal(ret, EOK);
+    assert_null(ifp_ctx->result_cache);
+    ifp_result_cache_add(ifp_ctx->result_cache, "groups:user1",
+                         dup_string_list(NULL, groups));
+    assert_null(ifp_result_cache_get(ifp_ctx->result_cache, "groups:user1"));
+
+    ret = ifp_result_cache_init(ifp_ctx, 60);
+    assert_int_equal(ret, EOK);
+    assert_non_null(ifp_ctx->result_cache);
+
+    assert_null(ifp_result_cache_get(ifp_ctx->result_cache, "groups:user1"));
+
+    ifp_result_cache_add(ifp_ctx->result_cache, "groups:user1",
+                         dup_string_list(NULL, groups));
+    cached = ifp_result_cache_get(ifp_ctx->result_cache, "groups:user1");
+    assert_non_null(cached);
+    assert_string_equal(cached[0], "group1");
+    assert_string_equal(cached[1], "group2");
+    assert_null(cached[2]);
+
+    assert_null(ifp_result_cache_get(ifp_ctx->result_cache, "groups:user2"));
+
+    /* invalidation drops everything */
+    ifp_result_cache_flush(ifp_ctx->result_cache);
+    assert_null(ifp_result_cache_get(ifp_ctx->result_cache, "groups:user1"));
+
+    talloc_free(ifp_ctx);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -279,6 +357,8 @@ int main(int argc, const char *argv[])
         cmocka_unit_test(test_attr_acl),
         cmocka_unit_test(test_attr_acl_ex),
         cmocka_unit_test(test_attr_allowed),
+        cmocka_unit_test(test_list_ctx_paged),
+        cmocka_unit_test(test_result_cache),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -184,11 +184,47 @@ static void test_sss_iobuf_write(void **state)
     talloc_zfree(rb);
 }
 
+static void test_sss_iobuf_steal(void **state)
+{
+    struct sss_iobuf *rb;
+    uint8_t *data;
+    uint8_t readbuf[64] = { 0 };
+    size_t nread;
+    errno_t ret;
+
+    data = (uint8_t *) talloc_strdup(NULL, "Hello world");
+    assert_non_null(data);
+
+    rb = sss_iobuf_init_steal(NULL, data, sizeof("Hello") - 1);
+    assert_non_null(rb);
+    /* The data is not copied */
+    assert_ptr_equal(sss_iobuf_get_data(rb), data);
+    assert_ptr_equal(talloc_parent(data), rb);
+    assert_int_equal(sss_iobuf_get_size(rb), 5);
+
+    ret = sss_iobuf_read(rb, sizeof(readbuf), readbuf, &nread);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(nread, 5);
+    assert_int_equal(strncmp((const char *) readbuf, "Hello", 5), 0);
+
+    /* The buffer cannot grow */
+    ret = sss_iobuf_write_len(rb, (uint8_t *) "!", 1);
+    assert_int_equal(ret, ENOBUFS);
+    talloc_free(rb);
+
+    /* No data */
+    rb = sss_iobuf_init_steal(NULL, NULL, 0);
+    assert_non_null(rb);
+    assert_int_equal(sss_iobuf_get_size(rb), 0);
+    talloc_free(rb);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_sss_iobuf_read),
         cmocka_unit_test(test_sss_iobuf_write),
+        cmocka_unit_test(test_sss_iobuf_steal),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -270,6 +270,164 @@ static void test_kcm_ccache_no_princ(void **state)
     assert_cc_equal(cc, cc2);
 }
 
+static void assert_cc_creds_equal(struct kcm_ccache *cc1,
+                                  struct kcm_ccache *cc2)
+{
+    struct kcm_cred *crd1;
+    struct kcm_cred *crd2;
+    struct sss_iobuf *blob1;
+    struct sss_iobuf *blob2;
+    uuid_t u1, u2;
+    errno_t ret;
+
+    crd1 = kcm_cc_get_cred(cc1);
+    crd2 = kcm_cc_get_cred(cc2);
+    while (crd1 != NULL && crd2 != NULL) {
+        ret = kcm_cred_get_uuid(crd1, u1);
+        assert_int_equal(ret, EOK);
+        ret = kcm_cred_get_uuid(crd2, u2);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(uuid_compare(u1, u2), 0);
+
+        /* Both ccaches find the credential through their index */
+        assert_ptr_equal(kcm_cc_find_cred(cc1, u1), crd1);
+        assert_ptr_equal(kcm_cc_find_cred(cc2, u2), crd2);
+
+        blob1 = kcm_cred_get_creds(crd1);
+        blob2 = kcm_cred_get_creds(crd2);
+        assert_int_equal(sss_iobuf_get_size(blob1),
+                         sss_iobuf_get_size(blob2));
+        assert_memory_equal(sss_iobuf_get_data(blob1),
+                            sss_iobuf_get_data(blob2),
+                            sss_iobuf_get_size(blob1));
+
+        crd1 = kcm_cc_next_cred(crd1);
+        crd2 = kcm_cc_next_cred(crd2);
+    }
+    assert_null(crd1);
+    assert_null(crd2);
+}
+
+static void test_kcm_ccache_binary(void **state)
+{
+    struct kcm_marshalling_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_marshalling_test_ctx);
+    errno_t ret;
+    struct cli_creds owner;
+    struct kcm_ccache *cc;
+    struct kcm_ccache *cc2;
+    struct sss_iobuf *payload;
+    struct sss_iobuf *json_payload;
+    struct sss_iobuf *truncated;
+    struct sss_iobuf *cred_blob;
+    const char *name;
+    const char *key;
+    uuid_t uuid;
+    int i;
+
+    owner.ucred.uid = getuid();
+    owner.ucred.gid = getuid();
+
+    name = talloc_asprintf(test_ctx, "%"SPRIuid, getuid());
+    assert_non_null(name);
+
+    ret = kcm_cc_new(test_ctx,
+                     test_ctx->kctx,
+                     &owner,
+                     name,
+                     test_ctx->princ,
+                     &cc);
+    assert_int_equal(ret, EOK);
+
+    for (i = 0; i < 3; i++) {
+        cred_blob = sss_iobuf_init_readonly(cc,
+                                            (const uint8_t *) TEST_CREDS,
+                                            sizeof(TEST_CREDS) - i);
+        assert_non_null(cred_blob);
+
+        ret = kcm_cc_store_cred_blob(cc, cred_blob);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = kcm_ccache_to_sec_input_binary(test_ctx, cc, &owner, &payload);
+    assert_int_equal(ret, EOK);
+    assert_true(sec_value_is_binary(payload));
+
+    ret = kcm_ccache_to_sec_input(test_ctx, cc, &owner, &json_payload);
+    assert_int_equal(ret, EOK);
+    assert_false(sec_value_is_binary(json_payload));
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+    key = sec_key_create(test_ctx, name, uuid);
+    assert_non_null(key);
+
+    ret = sec_kv_to_ccache_binary(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EOK);
+
+    assert_cc_equal(cc, cc2);
+    assert_cc_creds_equal(cc, cc2);
+
+    /* The payload can be read again */
+    ret = sec_kv_to_ccache_binary(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EOK);
+
+    /* Missing the last byte of the last credential */
+    truncated = sss_iobuf_init_readonly(test_ctx,
+                                        sss_iobuf_get_data(payload),
+                                        sss_iobuf_get_size(payload) - 1);
+    assert_non_null(truncated);
+
+    ret = sec_kv_to_ccache_binary(test_ctx, key, truncated, &owner, &cc2);
+    assert_int_equal(ret, EINVAL);
+
+    ret = sec_kv_to_ccache_binary(test_ctx, TEST_UUID_STR"-", payload,
+                                  &owner, &cc2);
+    assert_int_equal(ret, EINVAL);
+}
+
+static void test_kcm_ccache_binary_no_princ(void **state)
+{
+    struct kcm_marshalling_test_ctx *test_ctx = talloc_get_type(*state,
+                                        struct kcm_marshalling_test_ctx);
+    errno_t ret;
+    struct cli_creds owner;
+    struct kcm_ccache *cc;
+    struct kcm_ccache *cc2;
+    struct sss_iobuf *payload;
+    const char *name;
+    const char *key;
+    uuid_t uuid;
+
+    owner.ucred.uid = getuid();
+    owner.ucred.gid = getuid();
+
+    name = talloc_asprintf(test_ctx, "%"SPRIuid, getuid());
+    assert_non_null(name);
+
+    ret = kcm_cc_new(test_ctx,
+                     test_ctx->kctx,
+                     &owner,
+                     name,
+                     NULL,
+                     &cc);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_ccache_to_sec_input_binary(test_ctx, cc, &owner, &payload);
+    assert_int_equal(ret, EOK);
+
+    ret = kcm_cc_get_uuid(cc, uuid);
+    assert_int_equal(ret, EOK);
+    key = sec_key_create(test_ctx, name, uuid);
+    assert_non_null(key);
+
+    ret = sec_kv_to_ccache_binary(test_ctx, key, payload, &owner, &cc2);
+    assert_int_equal(ret, EOK);
+
+    assert_cc_equal(cc, cc2);
+    assert_null(kcm_cc_get_cred(cc2));
+}
+
 void test_sec_key_get_uuid(void **state)
 {
     errno_t ret;
@@ -346,6 +504,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_kcm_ccache_no_princ,
                                         setup_kcm_marshalling,
                                         teardown_kcm_marshalling),
+        cmocka_unit_test_setup_teardown(test_kcm_ccache_binary,
+                                        setup_kcm_marshalling,
+                                        teardown_kcm_marshalling),
+        cmocka_unit_test_setup_teardown(test_kcm_ccache_binary_no_princ,
+                                        setup_kcm_marshalling,
+                                        teardown_kcm_marshalling),
         cmocka_unit_test(test_sec_key_get_uuid),
         cmocka_unit_test(test_sec_key_get_name),
         cmocka_unit_test(test_sec_key_match_name),
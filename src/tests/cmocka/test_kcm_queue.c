@@ -50,12 +50,13 @@ static void timed_request_done(struct tevent_context *ev,
                                struct timeval current_time,
                                void *pvt);
 
-static struct tevent_req *timed_request_send(TALLOC_CTX *mem_ctx,
-                                             struct tevent_context *ev,
-                                             struct kcm_ops_queue_ctx *qctx,
-                                             struct cli_creds *client,
-                                             int delay,
-                                             int req_id)
+static struct tevent_req *timed_request_send_ex(TALLOC_CTX *mem_ctx,
+                                                struct tevent_context *ev,
+                                                struct kcm_ops_queue_ctx *qctx,
+                                                struct cli_creds *client,
+                                                int delay,
+                                                int req_id,
+                                                bool readonly)
 {
     struct tevent_req *req;
     struct tevent_req *subreq;
@@ -73,7 +74,7 @@ static struct tevent_req *timed_request_send(TALLOC_CTX *mem_ctx,
 
     DEBUG(SSSDBG_TRACE_ALL, "Request %p with delay %d\n", req, delay);
 
-    subreq = kcm_op_queue_send(state, ev, qctx, client);
+    subreq = kcm_op_queue_send(state, ev, qctx, client, readonly);
     if (subreq == NULL) {
         return NULL;
     }
@@ -82,6 +83,17 @@ static struct tevent_req *timed_request_send(TALLOC_CTX *mem_ctx,
     return req;
 }
 
+static struct tevent_req *timed_request_send(TALLOC_CTX *mem_ctx,
+                                             struct tevent_context *ev,
+                                             struct kcm_ops_queue_ctx *qctx,
+                                             struct cli_creds *client,
+                                             int delay,
+                                             int req_id)
+{
+    return timed_request_send_ex(mem_ctx, ev, qctx, client,
+                                 delay, req_id, false);
+}
+
 static void timed_request_start(struct tevent_req *subreq)
 {
     struct timeval tv;
@@ -315,6 +327,102 @@ static void test_kcm_queue_multi_different_id(void **state)
     assert_int_equal(test_ctx->error, EOK);
 }
 
+/*
+ * Test that read-only requests from the same ID run concurrently
+ */
+static void test_kcm_queue_multi_same_id_readonly(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct tevent_req *req;
+    struct cli_creds client;
+    static int req_ids[] = { FAST_REQ_ID, SLOW_REQ_ID };
+
+    client.ucred.uid = getuid();
+    client.ucred.gid = getgid();
+
+    req = timed_request_send_ex(test_ctx,
+                                test_ctx->ev,
+                                test_ctx->qctx,
+                                &client,
+                                SLOW_REQ_DELAY,
+                                SLOW_REQ_ID,
+                                true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    req = timed_request_send_ex(test_ctx,
+                                test_ctx->ev,
+                                test_ctx->qctx,
+                                &client,
+                                FAST_REQ_DELAY,
+                                FAST_REQ_ID,
+                                true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    test_ctx->num_requests = 2;
+    test_ctx->req_ids = req_ids;
+
+    while (test_ctx->done == false) {
+        tevent_loop_once(test_ctx->ev);
+    }
+    assert_int_equal(test_ctx->error, EOK);
+}
+
+/*
+ * Test that a read-only request waits for a modifying request that was
+ * queued before it and that a modifying request waits for a running
+ * read-only request
+ */
+static void test_kcm_queue_readonly_waits_for_writer(void **state)
+{
+    struct test_ctx *test_ctx = talloc_get_type(*state, struct test_ctx);
+    struct tevent_req *req;
+    struct cli_creds client;
+    static int req_ids[] = { SLOW_REQ_ID, FAST_REQ_ID, FAST_REQ_ID };
+
+    client.ucred.uid = getuid();
+    client.ucred.gid = getgid();
+
+    req = timed_request_send_ex(test_ctx,
+                                test_ctx->ev,
+                                test_ctx->qctx,
+                                &client,
+                                SLOW_REQ_DELAY,
+                                SLOW_REQ_ID,
+                                true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    req = timed_request_send_ex(test_ctx,
+                                test_ctx->ev,
+                                test_ctx->qctx,
+                                &client,
+                                FAST_REQ_DELAY,
+                                FAST_REQ_ID,
+                                false);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    req = timed_request_send_ex(test_ctx,
+                                test_ctx->ev,
+                                test_ctx->qctx,
+                                &client,
+                                FAST_REQ_DELAY,
+                                FAST_REQ_ID,
+                                true);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_kcm_queue_done, test_ctx);
+
+    test_ctx->num_requests = 3;
+    test_ctx->req_ids = req_ids;
+
+    while (test_ctx->done == false) {
+        tevent_loop_once(test_ctx->ev);
+    }
+    assert_int_equal(test_ctx->error, EOK);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -336,6 +444,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_kcm_queue_multi_different_id,
                                         setup_kcm_queue,
                                         teardown_kcm_queue),
+        cmocka_unit_test_setup_teardown(test_kcm_queue_multi_same_id_readonly,
+                                        setup_kcm_queue,
+                                        teardown_kcm_queue),
+        cmocka_unit_test_setup_teardown(test_kcm_queue_readonly_waits_for_writer,
+                                        setup_kcm_queue,
+                                        teardown_kcm_queue),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
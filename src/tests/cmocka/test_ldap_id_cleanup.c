@@ -300,6 +300,77 @@ static void test_id_cleanup_exp_group(void **state)
     assert_int_equal(ret, ENOENT);
 }
 
+static void test_id_cleanup_done(struct tevent_req *req)
+{
+    errno_t *_ret = tevent_req_callback_data(req, errno_t);
+
+    *_ret = ldap_id_cleanup_recv(req);
+    talloc_free(req);
+}
+
+static void test_id_cleanup_chunks(void **state)
+{
+    errno_t ret;
+    struct ldb_message *msg;
+    struct sdap_domain sdom;
+    struct tevent_req *req;
+    char *name;
+    char *grp;
+    /* More than one chunk of the cleanup */
+    const int num_groups = 250;
+    const uint64_t CACHE_TIMEOUT = 30;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                            struct sysdb_test_ctx);
+
+    for (int i = 0; i < num_groups; i++) {
+        name = talloc_asprintf(test_ctx, "chunk_grp_%d", i);
+        assert_non_null(name);
+        grp = sss_create_internal_fqname(test_ctx, name,
+                                         test_ctx->domain->name);
+        assert_non_null(grp);
+        talloc_free(name);
+
+        ret = sysdb_store_group(test_ctx->domain, grp,
+                                20000 + i, NULL, CACHE_TIMEOUT, 0);
+        assert_int_equal(ret, EOK);
+
+        ret = invalidate_group(test_ctx, test_ctx->domain, grp);
+        assert_int_equal(ret, EOK);
+        talloc_free(grp);
+    }
+
+    sdom.dom = test_ctx->domain;
+
+    req = ldap_id_cleanup_send(test_ctx, test_ctx->ev,
+                               test_ctx->id_ctx, &sdom);
+    assert_non_null(req);
+
+    ret = EAGAIN;
+    tevent_req_set_callback(req, test_id_cleanup_done, &ret);
+
+    while (ret == EAGAIN) {
+        assert_int_equal(tevent_loop_once(test_ctx->ev), 0);
+    }
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_ctx->domain->cleanup_total, num_groups);
+    assert_int_equal(test_ctx->domain->cleanup_processed, num_groups);
+
+    for (int i = 0; i < num_groups; i++) {
+        name = talloc_asprintf(test_ctx, "chunk_grp_%d", i);
+        assert_non_null(name);
+        grp = sss_create_internal_fqname(test_ctx, name,
+                                         test_ctx->domain->name);
+        assert_non_null(grp);
+        talloc_free(name);
+
+        ret = sysdb_search_group_by_name(test_ctx, test_ctx->domain,
+                                         grp, NULL, &msg);
+        assert_int_equal(ret, ENOENT);
+        talloc_free(grp);
+    }
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -317,6 +388,8 @@ int main(int argc, const char *argv[])
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_id_cleanup_exp_group,
                                         test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_id_cleanup_chunks,
+                                        test_sysdb_setup, test_sysdb_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -1059,6 +1059,115 @@ static void test_sss_ncache_domain_locate_type(void **state)
     assert_int_equal(ret, ENOENT);
 }
 
+/* @test_sss_ncache_unknown_domain : test following functions
+ * sss_ncache_set_unknown_domain
+ * sss_ncache_check_unknown_domain
+ */
+static void test_sss_ncache_unknown_domain(void **state)
+{
+    int ret;
+    struct test_state *ts;
+
+    ts = talloc_get_type_abort(*state, struct test_state);
+
+    ret = sss_ncache_check_unknown_domain(ts->ctx, "unknown.example");
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_ncache_set_unknown_domain(ts->ctx, "Unknown.Example");
+    assert_int_equal(ret, EOK);
+
+    /* Domain names are compared case-insensitively */
+    ret = sss_ncache_check_unknown_domain(ts->ctx, "unknown.example");
+    assert_int_equal(ret, EEXIST);
+
+    ret = sss_ncache_check_unknown_domain(ts->ctx, TEST_DOM_NAME);
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_ncache_set_unknown_domain(ts->ctx, "");
+    assert_int_equal(ret, EINVAL);
+}
+
+/* @test_sss_ncache_many_entries : the cache keeps working while its table
+ * grows and entries expire or are removed */
+static void test_sss_ncache_many_entries(void **state)
+{
+    int ret;
+    uid_t uid;
+    struct test_state *ts;
+
+    ts = talloc_get_type_abort(*state, struct test_state);
+
+    for (uid = 10000; uid < 15000; uid++) {
+        ret = sss_ncache_set_uid(ts->ctx, uid % 2 == 0, NULL, uid);
+        assert_int_equal(ret, EOK);
+    }
+
+    for (uid = 10000; uid < 15000; uid++) {
+        ret = sss_ncache_check_uid(ts->ctx, NULL, uid);
+        assert_int_equal(ret, EEXIST);
+    }
+
+    sleep(SHORTSPAN + 1);
+
+    /* only the permanent entries are left */
+    for (uid = 10000; uid < 15000; uid++) {
+        ret = sss_ncache_check_uid(ts->ctx, NULL, uid);
+        assert_int_equal(ret, uid % 2 == 0 ? EEXIST : ENOENT);
+    }
+
+    ret = sss_ncache_reset_users(ts->ctx);
+    assert_int_equal(ret, EOK);
+
+    for (uid = 10000; uid < 15000; uid++) {
+        ret = sss_ncache_check_uid(ts->ctx, NULL, uid);
+        assert_int_equal(ret, ENOENT);
+    }
+}
+
+/* @test_sss_ncache_save_load : entries that expire survive a restart,
+ * permanent ones come from the configuration again */
+static void test_sss_ncache_save_load(void **state)
+{
+    int ret;
+    struct test_state *ts;
+    struct sss_nc_ctx *ctx;
+    const char *path = TESTS_PATH "/negcache.snapshot";
+
+    ts = talloc_get_type_abort(*state, struct test_state);
+
+    ret = sss_ncache_set_uid(ts->ctx, true, NULL, 1001);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_ncache_set_uid(ts->ctx, false, NULL, 1002);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_ncache_save(ts->ctx, path);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_ncache_init(ts, SHORTSPAN, 0, &ctx);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_ncache_load(ctx, path);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_ncache_check_uid(ctx, NULL, 1001);
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_ncache_check_uid(ctx, NULL, 1002);
+    assert_int_equal(ret, EEXIST);
+
+    sleep(SHORTSPAN + 1);
+
+    ret = sss_ncache_check_uid(ctx, NULL, 1002);
+    assert_int_equal(ret, ENOENT);
+
+    ret = unlink(path);
+    assert_int_equal(ret, 0);
+
+    ret = sss_ncache_load(ctx, path);
+    assert_int_equal(ret, ENOENT);
+}
+
 int main(void)
 {
     int rv;
@@ -1089,6 +1198,12 @@ int main(void)
                                         setup, teardown),
         cmocka_unit_test_setup_teardown(test_sss_ncache_domain_locate_type,
                                         setup, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_unknown_domain,
+                                        setup, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_many_entries,
+                                        setup, teardown),
+        cmocka_unit_test_setup_teardown(test_sss_ncache_save_load,
+                                        setup, teardown),
 
         /* user */
         cmocka_unit_test_setup_teardown(test_ncache_nocache_user,
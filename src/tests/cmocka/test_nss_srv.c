@@ -1259,6 +1259,92 @@ void test_nss_getpwuid_neg(void **state)
     assert_int_equal(nss_test_ctx->ncache_hits, 1);
 }
 
+/* Test that several UIDs can be looked up with a single request and that
+ * a missing entry does not fail the whole request.
+ */
+struct passwd getpwuid_multi_usr = {
+    .pw_name = discard_const("testmultiuser1"),
+    .pw_uid = 111,
+    .pw_gid = 411,
+    .pw_dir = discard_const("/home/testmultiuser1"),
+    .pw_gecos = discard_const("test multi user1"),
+    .pw_shell = discard_const("/bin/sh"),
+    .pw_passwd = discard_const("*"),
+};
+
+static int test_nss_getpwuid_multi_check(uint32_t status,
+                                         uint8_t *body, size_t blen)
+{
+    struct passwd pwd;
+    uint32_t count;
+    uint32_t len;
+    size_t rp = 0;
+    errno_t ret;
+
+    assert_int_equal(status, EOK);
+
+    SAFEALIGN_COPY_UINT32(&count, body, &rp);
+    assert_int_equal(count, 2);
+    rp += sizeof(uint32_t); /* reserved */
+
+    SAFEALIGN_COPY_UINT32(&len, body + rp, &rp);
+    assert_true(len > 0);
+    assert_true(rp + len <= blen);
+
+    ret = parse_user_packet(body + rp, len, &pwd);
+    assert_int_equal(ret, EOK);
+    assert_users_equal(&pwd, &getpwuid_multi_usr);
+    rp += len;
+
+    /* The second UID does not exist */
+    SAFEALIGN_COPY_UINT32(&len, body + rp, &rp);
+    assert_int_equal(len, 0);
+    assert_int_equal(rp, blen);
+
+    return EOK;
+}
+
+void test_nss_getpwuid_multi(void **state)
+{
+    errno_t ret;
+    uint8_t *body;
+
+    ret = store_user(nss_test_ctx, nss_test_ctx->tctx->dom,
+                     &getpwuid_multi_usr, NULL, 0);
+    assert_int_equal(ret, EOK);
+
+    body = talloc_zero_array(nss_test_ctx, uint8_t, 3 * sizeof(uint32_t));
+    assert_non_null(body);
+    SAFEALIGN_SETMEM_UINT32(body, 2, NULL);
+    SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t),
+                            getpwuid_multi_usr.pw_uid, NULL);
+    SAFEALIGN_SETMEM_UINT32(body + 2 * sizeof(uint32_t), 112, NULL);
+
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_WRAPPER);
+    will_return(__wrap_sss_packet_get_body, body);
+    will_return(__wrap_sss_packet_get_body, 3 * sizeof(uint32_t));
+
+    /* Only the missing UID is looked up in the DP */
+    mock_account_recv_simple();
+
+    /* The reply header, the found entry and the lengths of both entries */
+    will_return_count(__wrap_sss_packet_get_cmd, SSS_NSS_GETPWUID_MULTI, 2);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    mock_fill_user();
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    set_cmd_cb(test_nss_getpwuid_multi_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETPWUID_MULTI,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    /* Wait until the test finishes with EOK */
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+}
+
 /* Test that lookup by UID for a user that does
  * not exist in the cache fetches the user from DP
  */
@@ -1541,6 +1627,7 @@ static int test_nss_getgrnam_members_check(uint32_t status,
 {
     int ret;
     uint32_t nmem;
+    uint32_t strs_len;
     struct group gr;
     const char *exp_members[] = { testmember1.pw_name,
                                   testmember2.pw_name };
@@ -1557,14 +1644,15 @@ static int test_nss_getgrnam_members_check(uint32_t status,
     assert_int_equal(ret, EOK);
     assert_int_equal(nmem, 2);
 
+    /* The reserved field holds the length of the strings of the group. */
+    SAFEALIGN_COPY_UINT32(&strs_len, body + sizeof(uint32_t), NULL);
+    assert_int_equal(strs_len, blen - 4 * sizeof(uint32_t));
+
     assert_groups_equal(&expected, &gr, nmem);
     return EOK;
 }
 
-/* Test that requesting a valid, cached group with some members returns a valid
- * group structure with those members present
- */
-void test_nss_getgrnam_members(void **state)
+static void store_testgroup_members(void)
 {
     errno_t ret;
 
@@ -1595,6 +1683,16 @@ void test_nss_getgrnam_members(void **state)
                              nss_test_ctx->tctx->dom,
                              SYSDB_MEMBER_USER);
     assert_int_equal(ret, EOK);
+}
+
+/* Test that requesting a valid, cached group with some members returns a valid
+ * group structure with those members present
+ */
+void test_nss_getgrnam_members(void **state)
+{
+    errno_t ret;
+
+    store_testgroup_members();
 
     mock_input_user_or_group("testgroup_members");
     will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETGRNAM);
@@ -1611,6 +1709,48 @@ void test_nss_getgrnam_members(void **state)
     assert_int_equal(ret, EOK);
 }
 
+static int test_nss_getgrnam_members_above_check(uint32_t status,
+                                                 uint8_t *body, size_t blen)
+{
+    int ret;
+    uint32_t nmem;
+    struct group gr;
+
+    assert_int_equal(status, EOK);
+
+    ret = parse_group_packet(body, blen, &gr, &nmem);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(nmem, 0);
+
+    assert_groups_equal(&testgroup_members, &gr, nmem);
+    return EOK;
+}
+
+/* Test that a group with more members than ignore_group_members_above is
+ * returned as if it was empty
+ */
+void test_nss_getgrnam_members_above(void **state)
+{
+    errno_t ret;
+
+    store_testgroup_members();
+    nss_test_ctx->tctx->dom->ignore_group_members_above = 1;
+
+    mock_input_user_or_group("testgroup_members");
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETGRNAM);
+    will_return_always(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    set_cmd_cb(test_nss_getgrnam_members_above_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETGRNAM,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    nss_test_ctx->tctx->dom->ignore_group_members_above = 0;
+}
+
 static int test_nss_getgrnam_members_check_fqdn(uint32_t status,
                                                 uint8_t *body, size_t blen)
 {
@@ -3009,6 +3149,26 @@ void test_nss_initgroups(void **state)
     assert_int_equal(ret, EOK);
 }
 
+/* The second request is answered from the initgroups cache. */
+void test_nss_initgroups_cached(void **state)
+{
+    errno_t ret;
+
+    test_nss_initgroups(state);
+    nss_test_ctx->tctx->done = false;
+
+    mock_input_user_or_group("testinitgr");
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_INITGR);
+
+    set_cmd_cb(test_nss_initgr_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_INITGR,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+}
+
 /* Test that searching for a nonexistent user yields ENOENT.
  * Account callback will be called
  */
@@ -3442,6 +3602,17 @@ static int nss_test_setup(void **state)
     return 0;
 }
 
+static int nss_test_setup_initgr_cache(void **state)
+{
+    errno_t ret;
+
+    nss_test_setup(state);
+
+    ret = nss_initgr_cache_init(nss_test_ctx->nctx, 10);
+    assert_int_equal(ret, EOK);
+    return 0;
+}
+
 static int nss_fqdn_test_setup(void **state)
 {
     struct sss_test_conf_param params[] = {
@@ -4235,6 +4406,86 @@ void test_nss_getsidbyuid(void **state)
     assert_int_equal(ret, EOK);
 }
 
+static int test_nss_getsidbyuid_multi_check(uint32_t status,
+                                            uint8_t *body, size_t blen)
+{
+    enum sss_id_type type;
+    uint32_t count;
+    uint32_t len;
+    size_t rp = 0;
+
+    assert_int_equal(status, EOK);
+
+    SAFEALIGN_COPY_UINT32(&count, body, &rp);
+    assert_int_equal(count, 2);
+    rp += sizeof(uint32_t); /* reserved */
+
+    SAFEALIGN_COPY_UINT32(&len, body + rp, &rp);
+    assert_true(len > 3 * sizeof(uint32_t));
+    assert_true(rp + len <= blen);
+
+    /* Num results and reserved of the single reply */
+    rp += 2 * sizeof(uint32_t);
+    SAFEALIGN_COPY_UINT32(&type, body + rp, &rp);
+    assert_int_equal(type, SSS_ID_TYPE_UID);
+    assert_string_equal((char *) body + rp, "S-1-2-3-4");
+    rp += len - 3 * sizeof(uint32_t);
+
+    /* The second UID does not exist */
+    SAFEALIGN_COPY_UINT32(&len, body + rp, &rp);
+    assert_int_equal(len, 0);
+    assert_int_equal(rp, blen);
+
+    return EOK;
+}
+
+void test_nss_getsidbyuid_multi(void **state)
+{
+    errno_t ret;
+    struct sysdb_attrs *attrs;
+    uint8_t *body;
+
+    attrs = sysdb_new_attrs(nss_test_ctx);
+    assert_non_null(attrs);
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_SID_STR, "S-1-2-3-4");
+    assert_int_equal(ret, EOK);
+
+    ret = store_user(nss_test_ctx, nss_test_ctx->tctx->dom,
+                     &sid_user, attrs, 0);
+    assert_int_equal(ret, EOK);
+
+    body = talloc_zero_array(nss_test_ctx, uint8_t, 3 * sizeof(uint32_t));
+    assert_non_null(body);
+    SAFEALIGN_SETMEM_UINT32(body, 2, NULL);
+    SAFEALIGN_SETMEM_UINT32(body + sizeof(uint32_t), sid_user.pw_uid, NULL);
+    SAFEALIGN_SETMEM_UINT32(body + 2 * sizeof(uint32_t), 1235, NULL);
+
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_WRAPPER);
+    will_return(__wrap_sss_packet_get_body, body);
+    will_return(__wrap_sss_packet_get_body, 3 * sizeof(uint32_t));
+
+    /* Only the missing UID is looked up in the DP */
+    mock_account_recv_simple();
+
+    /* The reply header, the found entry and the lengths of both entries */
+    will_return_count(__wrap_sss_packet_get_cmd,
+                      SSS_NSS_GETSIDBYUID_MULTI, 2);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    set_cmd_cb(test_nss_getsidbyuid_multi_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETSIDBYUID_MULTI,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    /* Wait until the test finishes with EOK */
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+}
+
 void test_nss_getsidbygid_no_group(void **state)
 {
     errno_t ret;
@@ -5286,6 +5537,69 @@ static int nss_host_test_setup(void **state)
     return 0;
 }
 
+/* The entries are valid, so the index answers without the data provider. */
+void test_nss_gethostbyname_index(void **state)
+{
+    errno_t ret;
+
+    /* The name is not parsed by cache_req. */
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_WRAPPER);
+    will_return(__wrap_sss_packet_get_body, "TestHost_Alias2");
+    will_return(__wrap_sss_packet_get_body, 0);
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETHOSTBYNAME);
+    will_return_count(__wrap_sss_packet_get_body, WRAP_CALL_REAL, 9);
+
+    set_cmd_cb(test_nss_gethostbyname_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETHOSTBYNAME,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    nss_test_ctx->tctx->done = false;
+
+    mock_input_netaddr(nss_test_ctx, AF_INET6, "2001:DB8:1234:0::0000");
+    will_return(__wrap_sss_packet_get_cmd, SSS_NSS_GETHOSTBYADDR);
+    will_return_count(__wrap_sss_packet_get_body, WRAP_CALL_REAL, 9);
+
+    set_cmd_cb(test_nss_gethostbyaddr_v6_check);
+    ret = sss_cmd_execute(nss_test_ctx->cctx, SSS_NSS_GETHOSTBYADDR,
+                          nss_test_ctx->nss_cmds);
+    assert_int_equal(ret, EOK);
+
+    ret = test_ev_loop(nss_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+}
+
+static int nss_host_index_test_setup(void **state)
+{
+    struct sysdb_attrs *attrs;
+    struct ldb_dn *dn;
+    errno_t ret;
+
+    nss_host_test_setup(state);
+
+    attrs = sysdb_new_attrs(nss_test_ctx);
+    assert_non_null(attrs);
+
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_CACHE_EXPIRE, time(NULL) + 300);
+    assert_int_equal(ret, EOK);
+
+    dn = sysdb_host_dn(attrs, nss_test_ctx->tctx->dom, test_hostent.h_name);
+    assert_non_null(dn);
+
+    ret = sysdb_set_entry_attr(nss_test_ctx->tctx->dom->sysdb, dn, attrs,
+                               SYSDB_MOD_REP);
+    assert_int_equal(ret, EOK);
+    talloc_free(attrs);
+
+    ret = nss_host_index_init(nss_test_ctx->nctx, 120);
+    assert_int_equal(ret, EOK);
+
+    return 0;
+}
+
 static int nss_host_test_teardown(void **state)
 {
     errno_t ret;
@@ -5550,6 +5864,8 @@ int main(int argc, const char *argv[])
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwuid_neg,
                                         nss_test_setup, nss_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_getpwuid_multi,
+                                        nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwnam_search,
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getpwuid_search,
@@ -5575,6 +5891,8 @@ int main(int argc, const char *argv[])
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getgrnam_members,
                                         nss_test_setup, nss_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_getgrnam_members_above,
+                                        nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getgrnam_members_fqdn,
                                         nss_fqdn_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getgrnam_members_subdom,
@@ -5639,6 +5957,9 @@ int main(int argc, const char *argv[])
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_initgroups,
                                         nss_test_setup, nss_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_initgroups_cached,
+                                        nss_test_setup_initgr_cache,
+                                        nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_initgr_neg,
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_initgr_search,
@@ -5672,6 +5993,8 @@ int main(int argc, const char *argv[])
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getsidbyuid,
                                         nss_test_setup, nss_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_getsidbyuid_multi,
+                                        nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getsidbygid_no_group,
                                         nss_test_setup, nss_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getsidbyname_group,
@@ -5702,6 +6025,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_nss_gethostbyaddr,
                                         nss_host_test_setup,
                                         nss_host_test_teardown),
+        cmocka_unit_test_setup_teardown(test_nss_gethostbyname_index,
+                                        nss_host_index_test_setup,
+                                        nss_host_test_teardown),
         cmocka_unit_test_setup_teardown(test_nss_getnetbyname,
                                         nss_network_test_setup,
                                         nss_network_test_teardown),
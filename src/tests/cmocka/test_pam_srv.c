@@ -33,6 +33,7 @@
 #include "sss_client/pam_message.h"
 #include "sss_client/sss_cli.h"
 #include "confdb/confdb.h"
+#include "util/sss_ptr_hash.h"
 
 #include "util/crypto/sss_crypto.h"
 #ifdef HAVE_NSS
@@ -403,6 +404,9 @@ struct pam_ctx *mock_pctx(TALLOC_CTX *mem_ctx)
     ret = sss_hash_create(pctx, 10, &pctx->id_table);
     assert_int_equal(ret, EOK);
 
+    pctx->login_table = sss_ptr_hash_create(pctx, NULL, NULL);
+    assert_non_null(pctx->login_table);
+
     /* Two NULLs so that tests can just assign a const to the first slot
      * should they need it. The code iterates until first NULL anyway
      */
@@ -1497,6 +1501,98 @@ void test_pam_close_session(void **state)
     assert_int_equal(ret, EOK);
 }
 
+void test_pam_login_cache(void **state)
+{
+    struct ldb_result *res;
+    struct ldb_message *user_obj;
+    const char *domain;
+    int ret;
+
+    ret = sysdb_getpwnam(pam_test_ctx, pam_test_ctx->tctx->dom,
+                         pam_test_ctx->pam_user_fqdn, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+
+    ret = pam_login_cache_get(pam_test_ctx, pam_test_ctx->pctx->login_table,
+                              "4321:0::pamuser", &user_obj, &domain);
+    assert_int_equal(ret, ENOENT);
+
+    ret = pam_login_cache_set(pam_test_ctx->pctx->rctx->ev,
+                              pam_test_ctx->pctx->login_table,
+                              "4321:0::pamuser", res->msgs[0],
+                              pam_test_ctx->tctx->dom->name,
+                              pam_test_ctx->pctx->id_timeout);
+    assert_int_equal(ret, EOK);
+
+    /* The cached user does not depend on the original message. */
+    talloc_free(res);
+
+    ret = pam_login_cache_get(pam_test_ctx, pam_test_ctx->pctx->login_table,
+                              "4321:0::pamuser", &user_obj, &domain);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(domain, pam_test_ctx->tctx->dom->name);
+    assert_string_equal(ldb_msg_find_attr_as_string(user_obj, SYSDB_NAME,
+                                                    NULL),
+                        pam_test_ctx->pam_user_fqdn);
+    talloc_free(user_obj);
+
+    /* A different client process is a different login. */
+    ret = pam_login_cache_get(pam_test_ctx, pam_test_ctx->pctx->login_table,
+                              "4322:0::pamuser", &user_obj, &domain);
+    assert_int_equal(ret, ENOENT);
+}
+
+void test_pam_cert_cache(void **state)
+{
+    struct pam_ctx *pctx = pam_test_ctx->pctx;
+    struct ldb_result *res;
+    struct ldb_result *users;
+    int ret;
+
+    ret = pam_cert_cache_init(pctx, 60);
+    assert_int_equal(ret, EOK);
+    assert_non_null(pctx->cert_cache);
+
+    ret = sysdb_getpwnam(pam_test_ctx, pam_test_ctx->tctx->dom,
+                         pam_test_ctx->pam_user_fqdn, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+
+    ret = pam_cert_cache_get(pam_test_ctx, pctx->cert_cache,
+                             CACHE_REQ_POSIX_DOM, "MIIcertA", &users);
+    assert_int_equal(ret, ENOENT);
+
+    pam_cert_cache_add(pctx->cert_cache, CACHE_REQ_POSIX_DOM, "MIIcertA", res);
+
+    /* The cached users do not depend on the original result. */
+    talloc_free(res);
+
+    ret = pam_cert_cache_get(pam_test_ctx, pctx->cert_cache,
+                             CACHE_REQ_POSIX_DOM, "MIIcertA", &users);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(users->count, 1);
+    assert_string_equal(ldb_msg_find_attr_as_string(users->msgs[0],
+                                                    SYSDB_NAME, NULL),
+                        pam_test_ctx->pam_user_fqdn);
+    talloc_free(users);
+
+    /* Other certificates and other kinds of domains are not cached. */
+    ret = pam_cert_cache_get(pam_test_ctx, pctx->cert_cache,
+                             CACHE_REQ_POSIX_DOM, "MIIcertB", &users);
+    assert_int_equal(ret, ENOENT);
+
+    ret = pam_cert_cache_get(pam_test_ctx, pctx->cert_cache,
+                             CACHE_REQ_APPLICATION_DOM, "MIIcertA", &users);
+    assert_int_equal(ret, ENOENT);
+
+    pam_cert_cache_flush(pctx->cert_cache);
+    ret = pam_cert_cache_get(pam_test_ctx, pctx->cert_cache,
+                             CACHE_REQ_POSIX_DOM, "MIIcertA", &users);
+    assert_int_equal(ret, ENOENT);
+
+    talloc_zfree(pctx->cert_cache);
+}
+
 void test_pam_chauthtok(void **state)
 {
     int ret;
@@ -2348,6 +2444,34 @@ void test_pam_preauth_cert_match(void **state)
     assert_int_equal(ret, EOK);
 }
 
+/* Same as test_pam_preauth_cert_match but with a p11_child in standby */
+void test_pam_preauth_cert_match_standby(void **state)
+{
+    int ret;
+
+    set_cert_auth_param(pam_test_ctx->pctx, CA_DB);
+
+    ret = p11_standby_init(pam_test_ctx->pctx, pam_test_ctx->tctx->ev,
+                           pam_test_ctx->pctx->nss_db, "no_ocsp",
+                           &pam_test_ctx->pctx->p11_standby);
+    assert_int_equal(ret, EOK);
+
+    mock_input_pam_cert(pam_test_ctx, "pamuser", NULL, NULL, NULL, NULL, NULL,
+                        test_lookup_by_cert_cb, SSSD_TEST_CERT_0001);
+
+    will_return(__wrap_sss_packet_get_cmd, SSS_PAM_PREAUTH);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    set_cmd_cb(test_pam_cert_check);
+    ret = sss_cmd_execute(pam_test_ctx->cctx, SSS_PAM_PREAUTH,
+                          pam_test_ctx->pam_cmds);
+    assert_int_equal(ret, EOK);
+
+    /* Wait until the test finishes with EOK */
+    ret = test_ev_loop(pam_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+}
+
 /* Test if PKCS11_LOGIN_TOKEN_NAME is added for the gdm-smartcard service */
 void test_pam_preauth_cert_match_gdm_smartcard(void **state)
 {
@@ -3389,6 +3513,10 @@ int main(int argc, const char *argv[])
                                         pam_test_setup, pam_test_teardown),
         cmocka_unit_test_setup_teardown(test_pam_close_session,
                                         pam_test_setup, pam_test_teardown),
+        cmocka_unit_test_setup_teardown(test_pam_login_cache,
+                                        pam_test_setup, pam_test_teardown),
+        cmocka_unit_test_setup_teardown(test_pam_cert_cache,
+                                        pam_test_setup, pam_test_teardown),
         cmocka_unit_test_setup_teardown(test_pam_chauthtok,
                                         pam_test_setup, pam_test_teardown),
         cmocka_unit_test_setup_teardown(test_pam_chauthtok_prelim,
@@ -3461,6 +3589,8 @@ int main(int argc, const char *argv[])
                                         pam_test_setup, pam_test_teardown),
         cmocka_unit_test_setup_teardown(test_pam_preauth_cert_match,
                                         pam_test_setup, pam_test_teardown),
+        cmocka_unit_test_setup_teardown(test_pam_preauth_cert_match_standby,
+                                        pam_test_setup, pam_test_teardown),
         cmocka_unit_test_setup_teardown(test_pam_preauth_cert_match_gdm_smartcard,
                                         pam_test_setup, pam_test_teardown),
         cmocka_unit_test_setup_teardown(test_pam_preauth_cert_match_wrong_user,
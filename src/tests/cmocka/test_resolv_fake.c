@@ -39,6 +39,7 @@
 #define TEST_BUFSIZE         1024
 #define TEST_DEFAULT_TIMEOUT 5
 #define TEST_SRV_QUERY "_ldap._tcp.sssd.com"
+#define TEST_HOST_QUERY "ldap.sssd.com"
 
 static TALLOC_CTX *global_mock_context = NULL;
 
@@ -189,6 +190,60 @@ unsigned char *create_srv_buffer(TALLOC_CTX *mem_ctx,
     return buf_head;
 }
 
+static ssize_t add_addr_rr(uint16_t type,
+                           uint32_t ttl,
+                           const char *address,
+                           const char *question,
+                           uint8_t *answer,
+                           size_t anslen)
+{
+    uint8_t *a = answer;
+    ssize_t resp_size;
+    size_t rdata_size;
+    int ret;
+
+    rdata_size = type == ns_t_a ? sizeof(struct in_addr)
+                                : sizeof(struct in6_addr);
+
+    resp_size = add_rr_common(type, ttl, rdata_size, question, anslen, &a);
+
+    ret = inet_pton(type == ns_t_a ? AF_INET : AF_INET6, address, a);
+    assert_int_equal(ret, 1);
+
+    return resp_size;
+}
+
+unsigned char *create_addr_buffer(TALLOC_CTX *mem_ctx,
+                                  const char *question,
+                                  uint16_t type,
+                                  const char *address,
+                                  size_t *_buflen)
+{
+    unsigned char *buf;
+    unsigned char *buf_head;
+    ssize_t len;
+    ssize_t total = 0;
+
+    buf = talloc_zero_array(mem_ctx, unsigned char, TEST_BUFSIZE);
+    assert_non_null(buf);
+    buf_head = buf;
+
+    len = dns_header(&buf, 1);
+    assert_true(len > 0);
+    total += len;
+
+    len = dns_question(question, type, &buf, TEST_BUFSIZE - total);
+    assert_true(len > 0);
+    total += len;
+
+    len = add_addr_rr(type, 600, address, question, buf, TEST_BUFSIZE - total);
+    assert_true(len > 0);
+    total += len;
+
+    *_buflen = total;
+    return buf_head;
+}
+
 struct fake_ares_query {
     int status;
     int timeouts;
@@ -217,6 +272,28 @@ void __wrap_ares_query(ares_channel channel, const char *name, int dnsclass,
     callback(arg, query.status, query.timeouts, query.abuf, query.alen);
 }
 
+void mock_ares_search(int type, int status, unsigned char *abuf, int alen)
+{
+    will_return(__wrap_ares_search, type);
+    will_return(__wrap_ares_search, status);
+    will_return(__wrap_ares_search, abuf);
+    will_return(__wrap_ares_search, alen);
+}
+
+void __wrap_ares_search(ares_channel channel, const char *name, int dnsclass,
+                        int type, ares_callback callback, void *arg)
+{
+    struct fake_ares_query query;
+
+    assert_int_equal(type, sss_mock_type(int));
+    query.status = sss_mock_type(int);
+    query.timeouts = 0;
+    query.abuf = sss_mock_ptr_type(unsigned char *);
+    query.alen = sss_mock_type(int);
+
+    callback(arg, query.status, query.timeouts, query.abuf, query.alen);
+}
+
 /* The unit test */
 struct resolv_fake_ctx {
     struct resolv_ctx *resolv;
@@ -334,6 +411,190 @@ void test_resolv_fake_srv(void **state)
     assert_int_equal(ret, ERR_OK);
 }
 
+void test_resolv_fake_srv_cached_done(struct tevent_req *req)
+{
+    errno_t ret;
+    TALLOC_CTX *tmp_ctx;
+    int status;
+    uint32_t ttl;
+    struct ares_srv_reply *srv_replies = NULL;
+    struct resolv_fake_ctx *test_ctx =
+        tevent_req_callback_data(req, struct resolv_fake_ctx);
+
+    tmp_ctx = talloc_new(test_ctx);
+    assert_non_null(tmp_ctx);
+
+    ret = resolv_getsrv_recv(tmp_ctx, req, &status, NULL,
+                             &srv_replies, &ttl);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(status, ARES_SUCCESS);
+
+    assert_non_null(srv_replies);
+    assert_string_equal(srv_replies->host, "ldap.sssd.com");
+    assert_null(srv_replies->next);
+
+    /* Bounded by the cache timeout. */
+    assert_true(ttl > 0 && ttl <= 60);
+
+    talloc_free(tmp_ctx);
+    test_ev_done(test_ctx->ctx, EOK);
+}
+
+void test_resolv_fake_srv_cached(void **state)
+{
+    int ret;
+    struct tevent_req *req;
+    struct resolv_fake_ctx *test_ctx =
+        talloc_get_type(*state, struct resolv_fake_ctx);
+    struct resolv_cache_stats stats;
+
+    unsigned char *buf;
+    size_t buflen;
+
+    struct srv_rrdata rr[1];
+
+    rr[0].prio = 1;
+    rr[0].port = 389;
+    rr[0].weight = 40;
+    rr[0].ttl = 600;
+    rr[0].hostname = "ldap.sssd.com";
+
+    ret = resolv_cache_init(test_ctx->resolv, 60);
+    assert_int_equal(ret, EOK);
+
+    /* Only the first request reaches the server. */
+    buf = create_srv_buffer(test_ctx, TEST_SRV_QUERY, rr, 1, &buflen);
+    assert_non_null(buf);
+    mock_ares_query(0, 0, buf, buflen);
+
+    req = resolv_getsrv_send(test_ctx, test_ctx->ctx->ev,
+                             test_ctx->resolv, TEST_SRV_QUERY);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_resolv_fake_srv_cached_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->ctx);
+    assert_int_equal(ret, ERR_OK);
+
+    test_ctx->ctx->done = false;
+
+    req = resolv_getsrv_send(test_ctx, test_ctx->ctx->ev,
+                             test_ctx->resolv, TEST_SRV_QUERY);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_resolv_fake_srv_cached_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->ctx);
+    assert_int_equal(ret, ERR_OK);
+
+    resolv_cache_get_stats(test_ctx->resolv, &stats);
+    assert_int_equal(stats.misses, 1);
+    assert_int_equal(stats.hits, 1);
+    assert_int_equal(stats.stored, 1);
+
+    /* A flush sends the next request to the server again. */
+    resolv_cache_flush(test_ctx->resolv);
+    mock_ares_query(0, 0, buf, buflen);
+    test_ctx->ctx->done = false;
+
+    req = resolv_getsrv_send(test_ctx, test_ctx->ctx->ev,
+                             test_ctx->resolv, TEST_SRV_QUERY);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_resolv_fake_srv_cached_done, test_ctx);
+
+    ret = test_ev_loop(test_ctx->ctx);
+    assert_int_equal(ret, ERR_OK);
+
+    resolv_cache_get_stats(test_ctx->resolv, &stats);
+    assert_int_equal(stats.misses, 2);
+}
+
+struct resolv_fake_host_ctx {
+    struct resolv_fake_ctx *test_ctx;
+    int family;
+    const char *address;
+};
+
+void test_resolv_fake_host_done(struct tevent_req *req)
+{
+    errno_t ret;
+    int status;
+    struct resolv_hostent *rhostent = NULL;
+    char *address;
+    struct resolv_fake_host_ctx *host_ctx =
+        tevent_req_callback_data(req, struct resolv_fake_host_ctx);
+
+    ret = resolv_gethostbyname_recv(req, host_ctx, &status, NULL, &rhostent);
+    talloc_free(req);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(status, ARES_SUCCESS);
+
+    assert_non_null(rhostent);
+    assert_int_equal(rhostent->family, host_ctx->family);
+
+    address = resolv_get_string_address_index(host_ctx, rhostent, 0);
+    assert_non_null(address);
+    assert_string_equal(address, host_ctx->address);
+    assert_null(rhostent->addr_list[1]);
+
+    talloc_free(address);
+    talloc_free(rhostent);
+    test_ev_done(host_ctx->test_ctx->ctx, EOK);
+}
+
+static void test_resolv_fake_host(struct resolv_fake_ctx *test_ctx,
+                                  enum restrict_family family_order,
+                                  int family,
+                                  const char *address)
+{
+    enum host_database db[] = { DB_DNS, DB_SENTINEL };
+    struct resolv_fake_host_ctx host_ctx;
+    struct tevent_req *req;
+    int ret;
+
+    host_ctx.test_ctx = test_ctx;
+    host_ctx.family = family;
+    host_ctx.address = address;
+
+    req = resolv_gethostbyname_send(test_ctx, test_ctx->ctx->ev,
+                                    test_ctx->resolv, TEST_HOST_QUERY,
+                                    family_order, db);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_resolv_fake_host_done, &host_ctx);
+
+    ret = test_ev_loop(test_ctx->ctx);
+    assert_int_equal(ret, ERR_OK);
+}
+
+void test_resolv_fake_host_preferred(void **state)
+{
+    struct resolv_fake_ctx *test_ctx =
+        talloc_get_type(*state, struct resolv_fake_ctx);
+    unsigned char *buf;
+    size_t buflen;
+
+    /* The AAAA query is cancelled before it is sent. */
+    buf = create_addr_buffer(test_ctx, TEST_HOST_QUERY, ns_t_a,
+                             "192.168.1.10", &buflen);
+    mock_ares_search(ns_t_a, ARES_SUCCESS, buf, buflen);
+
+    test_resolv_fake_host(test_ctx, IPV4_FIRST, AF_INET, "192.168.1.10");
+}
+
+void test_resolv_fake_host_fallback(void **state)
+{
+    struct resolv_fake_ctx *test_ctx =
+        talloc_get_type(*state, struct resolv_fake_ctx);
+    unsigned char *buf;
+    size_t buflen;
+
+    /* Both queries are sent at once, the preferred one has no answer. */
+    mock_ares_search(ns_t_aaaa, ARES_ENODATA, NULL, 0);
+    buf = create_addr_buffer(test_ctx, TEST_HOST_QUERY, ns_t_a,
+                             "192.168.1.10", &buflen);
+    mock_ares_search(ns_t_a, ARES_SUCCESS, buf, buflen);
+
+    test_resolv_fake_host(test_ctx, IPV6_FIRST, AF_INET, "192.168.1.10");
+}
+
 void test_resolv_is_address(void **state)
 {
     bool ret;
@@ -372,6 +633,15 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_resolv_fake_srv,
                                         test_resolv_fake_setup,
                                         test_resolv_fake_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_fake_srv_cached,
+                                        test_resolv_fake_setup,
+                                        test_resolv_fake_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_fake_host_preferred,
+                                        test_resolv_fake_setup,
+                                        test_resolv_fake_teardown),
+        cmocka_unit_test_setup_teardown(test_resolv_fake_host_fallback,
+                                        test_resolv_fake_setup,
+                                        test_resolv_fake_teardown),
         cmocka_unit_test(test_resolv_is_address),
     };
 
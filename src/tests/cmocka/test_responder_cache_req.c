@@ -124,6 +124,7 @@ struct cache_req_test_ctx {
 
     struct cache_req_result *result;
     bool dp_called;
+    int num_done;
 
     /* NOTE: Please, instead of adding new create_[user|group] bool,
      * use bitshift. */
@@ -164,6 +165,37 @@ static void cache_req_user_by_name_test_done(struct tevent_req *req)
     ctx->tctx->done = true;
 }
 
+static void cache_req_user_by_name_coalesced_done(struct tevent_req *req)
+{
+    struct cache_req_test_ctx *ctx = NULL;
+    struct cache_req_result *result;
+    errno_t ret;
+
+    ctx = tevent_req_callback_data(req, struct cache_req_test_ctx);
+
+    ret = cache_req_user_by_name_recv(ctx, req, &result);
+    talloc_zfree(req);
+    if (ret != EOK) {
+        ctx->tctx->error = ret;
+        ctx->tctx->done = true;
+        return;
+    }
+
+    if (ctx->result == NULL) {
+        ctx->result = result;
+    } else {
+        assert_int_equal(result->count, ctx->result->count);
+        assert_ptr_equal(result->msgs[0], ctx->result->msgs[0]);
+        talloc_free(result);
+    }
+
+    ctx->num_done++;
+    if (ctx->num_done == 2) {
+        ctx->tctx->error = EOK;
+        ctx->tctx->done = true;
+    }
+}
+
 static void cache_req_user_by_id_test_done(struct tevent_req *req)
 {
     struct cache_req_test_ctx *ctx = NULL;
@@ -760,6 +792,55 @@ void test_user_by_name_multiple_domains_notfound(void **state)
     assert_true(test_ctx->dp_called);
 }
 
+void test_user_by_name_multiple_domains_parallel_found(void **state)
+{
+    struct cache_req_test_ctx *test_ctx = NULL;
+    struct sss_domain_info *domain = NULL;
+    struct sss_domain_info *last_domain = NULL;
+
+    test_ctx = talloc_get_type_abort(*state, struct cache_req_test_ctx);
+    test_ctx->rctx->parallel_domain_lookups = true;
+
+    /* Setup user, the domain that comes first wins. */
+    domain = find_domain_by_name(test_ctx->tctx->dom,
+                                 "responder_cache_req_test_b", true);
+    assert_non_null(domain);
+
+    last_domain = find_domain_by_name(test_ctx->tctx->dom,
+                                      "responder_cache_req_test_d", true);
+    assert_non_null(last_domain);
+
+    prepare_user(last_domain, &users[0], 1000, time(NULL));
+    prepare_user(domain, &users[0], 1000, time(NULL));
+
+    /* Mock values. */
+    will_return_always(__wrap_sss_dp_get_account_send, test_ctx);
+    will_return_always(sss_dp_get_account_recv, 0);
+    mock_parse_inp(users[0].short_name, NULL, ERR_OK);
+
+    /* Test. */
+    run_user_by_name(test_ctx, NULL, 0, ERR_OK);
+    assert_true(test_ctx->dp_called);
+    check_user(test_ctx, &users[0], domain);
+}
+
+void test_user_by_name_multiple_domains_parallel_notfound(void **state)
+{
+    struct cache_req_test_ctx *test_ctx = NULL;
+
+    test_ctx = talloc_get_type_abort(*state, struct cache_req_test_ctx);
+    test_ctx->rctx->parallel_domain_lookups = true;
+
+    /* Mock values. */
+    will_return_always(__wrap_sss_dp_get_account_send, test_ctx);
+    will_return_always(sss_dp_get_account_recv, 0);
+    mock_parse_inp(users[0].short_name, NULL, ERR_OK);
+
+    /* Test. */
+    run_user_by_name(test_ctx, NULL, 0, ENOENT);
+    assert_true(test_ctx->dp_called);
+}
+
 void test_user_by_name_multiple_domains_parse(void **state)
 {
     struct cache_req_test_ctx *test_ctx = NULL;
@@ -844,6 +925,33 @@ void test_user_by_name_cache_valid(void **state)
     check_user(test_ctx, &users[0], test_ctx->tctx->dom);
 }
 
+void test_user_by_name_cache_pool(void **state)
+{
+    struct cache_req_test_ctx *test_ctx = NULL;
+    size_t pool_size;
+
+    test_ctx = talloc_get_type_abort(*state, struct cache_req_test_ctx);
+
+    /* Setup user. */
+    prepare_user(test_ctx->tctx->dom, &users[0], 1000, time(NULL));
+
+    /* The first request sizes the pool of the following ones. */
+    assert_int_equal(test_ctx->rctx->cache_req_pool_size, 0);
+    run_user_by_name(test_ctx, test_ctx->tctx->dom, 0, ERR_OK);
+    check_user(test_ctx, &users[0], test_ctx->tctx->dom);
+
+    pool_size = test_ctx->rctx->cache_req_pool_size;
+    assert_true(pool_size > 0);
+    assert_true(test_ctx->rctx->cache_req_pool_objects > 0);
+
+    /* Results do not depend on the pool. */
+    talloc_zfree(test_ctx->result);
+    test_ctx->tctx->done = false;
+    run_user_by_name(test_ctx, test_ctx->tctx->dom, 0, ERR_OK);
+    check_user(test_ctx, &users[0], test_ctx->tctx->dom);
+    assert_int_equal(test_ctx->rctx->cache_req_pool_size, pool_size);
+}
+
 void test_user_by_name_cache_expired(void **state)
 {
     struct cache_req_test_ctx *test_ctx = NULL;
@@ -925,6 +1033,48 @@ void test_user_by_name_missing_found(void **state)
     check_user(test_ctx, &users[0], test_ctx->tctx->dom);
 }
 
+void test_user_by_name_coalesced(void **state)
+{
+    struct cache_req_test_ctx *test_ctx = NULL;
+    TALLOC_CTX *req_mem_ctx;
+    struct tevent_req *req;
+    errno_t ret;
+    int i;
+
+    test_ctx = talloc_get_type_abort(*state, struct cache_req_test_ctx);
+
+    /* Mock values. The data provider is asked only once. */
+    will_return(__wrap_sss_dp_get_account_send, test_ctx);
+    mock_account_recv_simple();
+
+    test_ctx->create_user1 = true;
+    test_ctx->create_user2 = false;
+
+    /* Test. */
+    req_mem_ctx = talloc_new(global_talloc_context);
+    check_leaks_push(req_mem_ctx);
+
+    for (i = 0; i < 2; i++) {
+        req = cache_req_user_by_name_send(req_mem_ctx, test_ctx->tctx->ev,
+                                          test_ctx->rctx, test_ctx->ncache,
+                                          0, CACHE_REQ_POSIX_DOM,
+                                          test_ctx->tctx->dom->name,
+                                          users[0].short_name);
+        assert_non_null(req);
+        tevent_req_set_callback(req, cache_req_user_by_name_coalesced_done,
+                                test_ctx);
+    }
+
+    ret = test_ev_loop(test_ctx->tctx);
+    assert_int_equal(ret, ERR_OK);
+    assert_true(check_leaks_pop(req_mem_ctx));
+    talloc_free(req_mem_ctx);
+
+    assert_int_equal(test_ctx->num_done, 2);
+    assert_true(test_ctx->dp_called);
+    check_user(test_ctx, &users[0], test_ctx->tctx->dom);
+}
+
 void test_user_by_name_missing_notfound(void **state)
 {
     struct cache_req_test_ctx *test_ctx = NULL;
@@ -3951,13 +4101,17 @@ int main(int argc, const char *argv[])
 
     const struct CMUnitTest tests[] = {
         new_single_domain_test(user_by_name_cache_valid),
+        new_single_domain_test(user_by_name_cache_pool),
         new_single_domain_test(user_by_name_cache_expired),
         new_single_domain_test(user_by_name_cache_midpoint),
         new_single_domain_test(user_by_name_ncache),
         new_single_domain_test(user_by_name_missing_found),
+        new_single_domain_test(user_by_name_coalesced),
         new_single_domain_test(user_by_name_missing_notfound),
         new_multi_domain_test(user_by_name_multiple_domains_found),
         new_multi_domain_test(user_by_name_multiple_domains_notfound),
+        new_multi_domain_test(user_by_name_multiple_domains_parallel_found),
+        new_multi_domain_test(user_by_name_multiple_domains_parallel_notfound),
         new_multi_domain_test(user_by_name_multiple_domains_parse),
 
         new_single_domain_test(user_by_upn_cache_valid),
@@ -27,6 +27,7 @@
 
 #include "tests/cmocka/common_mock.h"
 #include "tests/cmocka/common_mock_resp.h"
+#include "util/sss_ptr_hash.h"
 
 #define TESTS_PATH "tp_" BASE_FILE_STEM
 #define TEST_CONF_DB "test_responder_conf.ldb"
@@ -290,6 +291,93 @@ void test_sss_output_fqname(void **state)
     talloc_zfree(res);
 }
 
+static struct cli_ctx *test_throttle_client(struct parse_inp_test_ctx *ctx,
+                                            uid_t uid, int priv)
+{
+    struct cli_ctx *cctx;
+
+    cctx = talloc_zero(ctx, struct cli_ctx);
+    assert_non_null(cctx);
+    cctx->rctx = ctx->rctx;
+    cctx->ev = ctx->rctx->ev;
+    cctx->priv = priv;
+    cctx->cfd = -1;
+
+    cctx->creds = talloc_zero(cctx, struct cli_creds);
+    assert_non_null(cctx->creds);
+#ifdef HAVE_UCRED
+    cctx->creds->ucred.uid = uid;
+#endif
+
+    return cctx;
+}
+
+void test_client_throttle(void **state)
+{
+    struct parse_inp_test_ctx *parse_inp_ctx = talloc_get_type(*state,
+                                                   struct parse_inp_test_ctx);
+    struct resp_ctx *rctx = parse_inp_ctx->rctx;
+    struct cli_ctx *first;
+    struct cli_ctx *second;
+    struct cli_ctx *third;
+    struct cli_ctx *cctx;
+    errno_t ret;
+
+    rctx->client_max_requests = 1;
+    rctx->client_throttle = sss_ptr_hash_create(rctx, NULL, NULL);
+    assert_non_null(rctx->client_throttle);
+
+    first = test_throttle_client(parse_inp_ctx, 1000, 0);
+    second = test_throttle_client(parse_inp_ctx, 1000, 0);
+    third = test_throttle_client(parse_inp_ctx, 1000, 0);
+
+    ret = sss_client_throttle_acquire(first, SSS_NSS_GETPWNAM);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_client_throttle_acquire(second, SSS_NSS_GETPWNAM);
+    assert_int_equal(ret, EAGAIN);
+
+    ret = sss_client_throttle_acquire(third, SSS_NSS_GETPWENT);
+    assert_int_equal(ret, EAGAIN);
+
+    /* PAM commands and the privileged pipe are not limited */
+    cctx = test_throttle_client(parse_inp_ctx, 1000, 0);
+    ret = sss_client_throttle_acquire(cctx, SSS_PAM_AUTHENTICATE);
+    assert_int_equal(ret, EOK);
+    talloc_free(cctx);
+
+    cctx = test_throttle_client(parse_inp_ctx, 1000, 1);
+    ret = sss_client_throttle_acquire(cctx, SSS_NSS_GETPWNAM);
+    assert_int_equal(ret, EOK);
+    talloc_free(cctx);
+
+#ifdef HAVE_UCRED
+    /* other users have their own limit */
+    cctx = test_throttle_client(parse_inp_ctx, 1001, 0);
+    ret = sss_client_throttle_acquire(cctx, SSS_NSS_GETPWNAM);
+    assert_int_equal(ret, EOK);
+    sss_client_throttle_release(cctx);
+    talloc_free(cctx);
+#endif
+
+    /* a client that disconnects gives up its place in the queue */
+    talloc_free(second);
+    assert_int_equal(hash_count(rctx->client_throttle), 1);
+
+    /* the next client in the queue gets the slot */
+    sss_client_throttle_release(first);
+    assert_null(first->throttle);
+    assert_non_null(third->throttle);
+
+    /* the queued command would be run from the event loop */
+    talloc_free(third);
+    assert_int_equal(hash_count(rctx->client_throttle), 0);
+
+    talloc_free(first);
+    talloc_zfree(rctx->client_throttle);
+    rctx->client_max_requests = 0;
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -325,6 +413,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sss_output_fqname,
                                         parse_inp_test_setup,
                                         parse_inp_test_teardown),
+        cmocka_unit_test_setup_teardown(test_client_throttle,
+                                        parse_inp_test_setup,
+                                        parse_inp_test_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
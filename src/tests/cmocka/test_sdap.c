@@ -25,6 +25,7 @@
 
 #include "tests/cmocka/common_mock.h"
 #include "providers/ldap/ldap_opts.h"
+#include "providers/ldap/sdap_range.h"
 #include "providers/ipa/ipa_opts.h"
 #include "util/crypto/sss_crypto.h"
 
@@ -114,100 +115,81 @@ int __wrap_ldap_set_option(LDAP *ld,
     return LDAP_OPT_SUCCESS;
 }
 
-char *__wrap_ldap_get_dn(LDAP *ld, LDAPMessage *entry)
-{
-    struct mock_ldap_entry *ldap_entry = mock_ldap_entry_get();
-    return discard_const(ldap_entry->dn);
-}
-
 void __wrap_ldap_memfree(void *p)
 {
     return;
 }
 
-struct berval **__wrap_ldap_get_values_len(LDAP *ld,
-                                           LDAPMessage *entry,
-                                           LDAP_CONST char *target)
+int __wrap_ldap_get_dn_ber(LDAP *ld, LDAPMessage *entry,
+                           BerElement **berout, struct berval *dn)
 {
-    size_t count, i;
-    struct berval **vals;
-    const char **attrvals;
     struct mock_ldap_entry *ldap_entry = mock_ldap_entry_get();
 
-    if (target == NULL) return NULL;
-    if (ldap_entry == NULL) return NULL;
-    /* Should we return empty array here? */
-    if (ldap_entry->attrs == NULL) return NULL;
-
-    attrvals = NULL;
-    for (i = 0; ldap_entry->attrs[i].name != NULL; i++) {
-        if (strcmp(ldap_entry->attrs[i].name, target) == 0) {
-            attrvals = ldap_entry->attrs[i].values;
-            break;
-        }
+    if (ldap_entry == NULL || ldap_entry->dn == NULL) {
+        return LDAP_DECODING_ERROR;
     }
 
-    if (attrvals == NULL) {
-        return NULL;
+    dn->bv_val = discard_const(ldap_entry->dn);
+    dn->bv_len = strlen(ldap_entry->dn);
+    if (berout != NULL) {
+        *berout = NULL;
     }
 
-    count = 0;
-    for (i = 0; attrvals[i]; i++) {
-        count++;
+    if (ldap_entry->attrs != NULL) {
+        will_return(mock_ldap_entry_iter, 0);
     }
+    return LDAP_SUCCESS;
+}
 
-    vals = talloc_zero_array(global_talloc_context,
-                             struct berval *,
-                             count + 1);
-    assert_non_null(vals);
+int __wrap_ldap_get_attribute_ber(LDAP *ld, LDAPMessage *entry,
+                                  BerElement *ber, struct berval *attr,
+                                  struct berval **vals)
+{
+    struct mock_ldap_entry *ldap_entry = mock_ldap_entry_get();
+    const char **attrvals;
+    size_t count, i;
+    int idx;
 
-    for (i = 0; attrvals[i]; i++) {
-        vals[i] = talloc_zero(vals, struct berval);
-        assert_non_null(vals[i]);
+    attr->bv_val = NULL;
+    attr->bv_len = 0;
+    if (vals != NULL) {
+        *vals = NULL;
+    }
 
-        vals[i]->bv_val = talloc_strdup(vals[i], attrvals[i]);
-        if (vals[i]->bv_val == NULL) {
-            talloc_free(vals);
-            return NULL;
-        }
-        vals[i]->bv_len = strlen(attrvals[i]);
+    if (ldap_entry == NULL) return LDAP_SUCCESS;
+    if (ldap_entry->attrs == NULL) return LDAP_SUCCESS;
+
+    idx = mock_ldap_entry_iter();
+    if (ldap_entry->attrs[idx].name == NULL) {
+        return LDAP_SUCCESS;
     }
+    will_return(mock_ldap_entry_iter, idx + 1);
 
-    return vals;
-}
+    attr->bv_val = discard_const(ldap_entry->attrs[idx].name);
+    attr->bv_len = strlen(attr->bv_val);
 
-void __wrap_ldap_value_free_len(struct berval **vals)
-{
-    talloc_free(vals);  /* Allocated on global_talloc_context */
-}
+    if (vals == NULL) {
+        return LDAP_SUCCESS;
+    }
 
-char *__wrap_ldap_first_attribute(LDAP *ld,
-                                  LDAPMessage *entry,
-                                  BerElement **berout)
-{
-    struct mock_ldap_entry *ldap_entry = mock_ldap_entry_get();
+    /* Like liblber, point to the values instead of copying them */
+    attrvals = ldap_entry->attrs[idx].values;
+    for (count = 0; attrvals[count]; count++);
+
+    *vals = talloc_zero_array(global_talloc_context, struct berval, count + 1);
+    assert_non_null(*vals);
 
-    if (ldap_entry == NULL) return NULL;
-    if (ldap_entry->attrs == NULL) return NULL;
+    for (i = 0; i < count; i++) {
+        (*vals)[i].bv_val = discard_const(attrvals[i]);
+        (*vals)[i].bv_len = strlen(attrvals[i]);
+    }
 
-    will_return(mock_ldap_entry_iter, 1);
-    return discard_const(ldap_entry->attrs[0].name);
+    return LDAP_SUCCESS;
 }
 
-char *__wrap_ldap_next_attribute(LDAP *ld,
-                                 LDAPMessage *entry,
-                                 BerElement *ber)
+void __wrap_ber_memfree(void *p)
 {
-    struct mock_ldap_entry *ldap_entry = mock_ldap_entry_get();
-
-    int idx = mock_ldap_entry_iter();
-    char *val;
-
-    val = discard_const(ldap_entry->attrs[idx].name);
-    if (val != NULL) {
-        will_return(mock_ldap_entry_iter, idx + 1);
-    }
-    return val;
+    talloc_free(p);  /* Allocated on global_talloc_context */
 }
 
 /* Mock parsing search base without overlinking the test */
@@ -387,6 +369,50 @@ void test_parse_no_map(void **state)
     talloc_free(attrs);
 }
 
+/* The offset of the next range of ranged attributes is remembered */
+void test_parse_range(void **state)
+{
+    int ret;
+    struct sysdb_attrs *attrs;
+    struct parse_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct parse_test_ctx);
+    struct mock_ldap_entry test_range_entry;
+    struct ldb_message_element *el;
+    uint32_t offset;
+
+    const char *member_values[] = { "cn=user1,dc=example,dc=com",
+                                    "cn=user2,dc=example,dc=com",
+                                    NULL };
+    const char *last_values[] = { "lastval", NULL };
+    struct mock_ldap_attr test_range_entry_attrs[] = {
+        { .name = "member;range=0-1", .values = member_values },
+        { .name = "last;range=2-*", .values = last_values },
+        { NULL, NULL }
+    };
+
+    test_range_entry.dn = "cn=testentry,dc=example,dc=com";
+    test_range_entry.attrs = test_range_entry_attrs;
+    set_entry_parse(&test_range_entry);
+
+    ret = sdap_parse_entry(test_ctx, &test_ctx->sh, &test_ctx->sm,
+                           NULL, 0, &attrs, false);
+    assert_int_equal(ret, ERR_OK);
+
+    ret = sysdb_attrs_get_el_ext(attrs, "member", false, &el);
+    assert_int_equal(ret, ERR_OK);
+    assert_int_equal(el->num_values, 2);
+    assert_entry_has_attr(attrs, "last", "lastval");
+
+    ret = sdap_range_get_next(attrs, "member", &offset);
+    assert_int_equal(ret, ERR_OK);
+    assert_int_equal(offset, 2);
+
+    ret = sdap_range_get_next(attrs, "last", &offset);
+    assert_int_equal(ret, ENOENT);
+
+    talloc_free(attrs);
+}
+
 /* Only DN and OC, no real attributes */
 void test_parse_no_attrs(void **state)
 {
@@ -475,6 +501,68 @@ void test_parse_dups(void **state)
     talloc_free(attrs);
 }
 
+/* The same as test_parse_dups and test_parse_with_map, but using an index
+ * of the map */
+void test_parse_with_map_index(void **state)
+{
+    int ret;
+    struct sysdb_attrs *attrs;
+    struct parse_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                      struct parse_test_ctx);
+    struct mock_ldap_entry test_dupattr_user;
+    struct sdap_attr_map *map;
+    struct sdap_attr_map_index *index;
+    int i;
+
+    const char *oc_values[] = { "posixAccount", NULL };
+    const char *uid_values[] = { "1234", NULL };
+    const char *name_values[] = { "tuser1", NULL };
+    const char *extra_values[] = { "extra", NULL };
+    struct mock_ldap_attr test_dupattr_attrs[] = {
+        { .name = "objectClass", .values = oc_values },
+        { .name = "IDNUMBER", .values = uid_values },
+        { .name = "uid", .values = name_values },
+        { .name = "extra", .values = extra_values },
+        { NULL, NULL }
+    };
+
+    test_dupattr_user.dn = "cn=dupuser,dc=example,dc=com";
+    test_dupattr_user.attrs = test_dupattr_attrs;
+    set_entry_parse(&test_dupattr_user);
+
+    ret = sdap_copy_map(test_ctx, rfc2307_user_map, SDAP_OPTS_USER, &map);
+    assert_int_equal(ret, ERR_OK);
+    /* Set both uidNumber and gidNumber to idNumber */
+    for (i = 0; i < SDAP_OPTS_USER; i++) {
+        if (map[i].name == NULL) continue;
+
+        if (strcmp(map[i].name, "uidNumber") == 0
+             || strcmp(map[i].name, "gidNumber") == 0) {
+            map[i].name = discard_const("idNumber");
+        }
+    }
+
+    ret = sdap_attr_map_index_create(test_ctx, map, SDAP_OPTS_USER, &index);
+    assert_int_equal(ret, ERR_OK);
+
+    ret = sdap_parse_entry_ex(test_ctx, &test_ctx->sh, &test_ctx->sm,
+                              map, SDAP_OPTS_USER, index,
+                              &attrs, false);
+    assert_int_equal(ret, ERR_OK);
+
+    assert_int_equal(attrs->num, 4);
+    assert_entry_has_attr(attrs, SYSDB_ORIG_DN,
+                          "cn=dupuser,dc=example,dc=com");
+    assert_entry_has_attr(attrs, SYSDB_UIDNUM, "1234");
+    assert_entry_has_attr(attrs, SYSDB_GIDNUM, "1234");
+    assert_entry_has_attr(attrs, SYSDB_NAME, "tuser1");
+    assert_entry_has_no_attr(attrs, "extra");
+
+    talloc_free(index);
+    talloc_free(map);
+    talloc_free(attrs);
+}
+
 void test_parse_deref(void **state)
 {
     errno_t ret;
@@ -1136,12 +1224,18 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_parse_no_map,
                                         parse_entry_test_setup,
                                         parse_entry_test_teardown),
+        cmocka_unit_test_setup_teardown(test_parse_range,
+                                        parse_entry_test_setup,
+                                        parse_entry_test_teardown),
         cmocka_unit_test_setup_teardown(test_parse_no_attrs,
                                         parse_entry_test_setup,
                                         parse_entry_test_teardown),
         cmocka_unit_test_setup_teardown(test_parse_dups,
                                         parse_entry_test_setup,
                                         parse_entry_test_teardown),
+        cmocka_unit_test_setup_teardown(test_parse_with_map_index,
+                                        parse_entry_test_setup,
+                                        parse_entry_test_teardown),
         cmocka_unit_test_setup_teardown(test_parse_deref,
                                         parse_entry_test_setup,
                                         parse_entry_test_teardown),
@@ -648,6 +648,86 @@ void test_ssh_user_pubkey_cert(void **state)
     assert_int_equal(ret, EOK);
 }
 
+void test_ssh_user_pubkey_cert_cached(void **state)
+{
+    int ret;
+    struct sysdb_attrs *attrs;
+    struct ldb_message_element *el;
+    struct ldb_val key;
+    unsigned int i;
+
+    attrs = sysdb_new_attrs(ssh_test_ctx);
+    assert_non_null(attrs);
+    ret = sysdb_attrs_add_string(attrs, SYSDB_SSH_PUBKEY, TEST_SSH_PUBKEY);
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_base64_blob(attrs, SYSDB_USER_CERT,
+                                      SSSD_TEST_CERT_0001);
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_base64_blob(attrs, SYSDB_USER_CERT,
+                                      SSSD_TEST_CERT_0002);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_set_user_attr(ssh_test_ctx->tctx->dom,
+                              ssh_test_ctx->ssh_user_fqdn,
+                              attrs,
+                              LDB_FLAG_MOD_ADD);
+    assert_int_equal(ret, EOK);
+
+    ret = ssh_cert_keys_cache_init(ssh_test_ctx->ssh_ctx, 60);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_attrs_get_el_ext(attrs, SYSDB_USER_CERT, false, &el);
+    assert_int_equal(ret, EOK);
+
+    for (i = 0; i < el->num_values; i++) {
+        assert_false(ssh_cert_keys_cache_get(
+                                         ssh_test_ctx->ssh_ctx->cert_keys_cache,
+                                         &el->values[i], &key));
+    }
+
+    mock_input_user(ssh_test_ctx, ssh_test_ctx->ssh_user_fqdn);
+    will_return(__wrap_sss_packet_get_cmd, SSS_SSH_GET_USER_PUBKEYS);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+    will_return(__wrap_sss_packet_get_body, WRAP_CALL_REAL);
+
+    /* Enable certificate support */
+    ssh_test_ctx->ssh_ctx->use_cert_keys = true;
+#ifdef HAVE_NSS
+    ssh_test_ctx->ssh_ctx->ca_db = discard_const("sql:" ABS_BUILD_DIR
+                                                "/src/tests/test_CA/p11_nssdb");
+#else
+    ssh_test_ctx->ssh_ctx->ca_db = discard_const(ABS_BUILD_DIR
+                                                "/src/tests/test_CA/SSSD_test_CA.pem");
+#endif
+
+    set_cmd_cb(test_ssh_user_pubkey_cert_check);
+    ret = sss_cmd_execute(ssh_test_ctx->cctx, SSS_SSH_GET_USER_PUBKEYS,
+                          ssh_test_ctx->ssh_cmds);
+    assert_int_equal(ret, EOK);
+
+    /* Wait until the test finishes with EOK */
+    ret = test_ev_loop(ssh_test_ctx->tctx);
+    assert_int_equal(ret, EOK);
+
+    /* The derived keys are kept for the next lookup */
+    for (i = 0; i < el->num_values; i++) {
+        assert_true(ssh_cert_keys_cache_get(
+                                         ssh_test_ctx->ssh_ctx->cert_keys_cache,
+                                         &el->values[i], &key));
+        assert_non_null(key.data);
+    }
+
+    /* A changed CA database invalidates them */
+    ssh_cert_keys_cache_check_ca(ssh_test_ctx->ssh_ctx->cert_keys_cache,
+                                 "/dev/null");
+    assert_false(ssh_cert_keys_cache_get(ssh_test_ctx->ssh_ctx->cert_keys_cache,
+                                         &el->values[0], &key));
+
+    talloc_free(attrs);
+}
+
 struct certmap_info rule_1 = {
                             discard_const("rule1"), -1,
                             discard_const("<SUBJECT>CN=SSSD test cert 0001,.*"),
@@ -1018,6 +1098,8 @@ int main(int argc, const char *argv[])
                                         ssh_test_setup, ssh_test_teardown),
         cmocka_unit_test_setup_teardown(test_ssh_user_pubkey_cert,
                                         ssh_test_setup, ssh_test_teardown),
+        cmocka_unit_test_setup_teardown(test_ssh_user_pubkey_cert_cached,
+                                        ssh_test_setup, ssh_test_teardown),
         cmocka_unit_test_setup_teardown(test_ssh_user_pubkey_cert_with_rule,
                                         ssh_test_setup, ssh_test_teardown),
         cmocka_unit_test_setup_teardown(test_ssh_user_pubkey_cert_with_all_rules,
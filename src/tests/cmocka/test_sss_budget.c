@@ -0,0 +1,109 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unistd.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "util/sss_budget.h"
+
+void test_sss_budget_exhausted(void **state)
+{
+    struct sss_budget *budget;
+
+    budget = sss_budget_create(global_talloc_context, "test", 100);
+    assert_non_null(budget);
+    assert_false(sss_budget_exhausted(budget));
+
+    usleep(150000);
+    assert_true(sss_budget_exhausted(budget));
+
+    talloc_free(budget);
+
+    /* A budget of zero is only used to measure. */
+    budget = sss_budget_create(global_talloc_context, "test", 0);
+    assert_non_null(budget);
+    assert_true(sss_budget_exhausted(budget));
+    talloc_free(budget);
+}
+
+static void test_sss_budget_fd_handler(struct tevent_context *ev,
+                                       struct tevent_fd *fde,
+                                       uint16_t flags,
+                                       void *pvt)
+{
+    bool *called = talloc_get_type_abort(pvt, bool);
+
+    *called = true;
+    talloc_free(fde);
+}
+
+static void test_sss_budget_yield_done(struct tevent_req *req)
+{
+    bool *done = tevent_req_callback_data(req, bool);
+
+    assert_int_equal(sss_budget_yield_recv(req), EOK);
+    talloc_free(req);
+    *done = true;
+}
+
+void test_sss_budget_yield(void **state)
+{
+    struct tevent_context *ev;
+    struct sss_budget *budget;
+    struct tevent_req *req;
+    struct tevent_fd *fde;
+    bool *fd_called;
+    bool *done;
+    int fds[2];
+    int ret;
+
+    ev = tevent_context_init(global_talloc_context);
+    assert_non_null(ev);
+
+    fd_called = talloc_zero(ev, bool);
+    assert_non_null(fd_called);
+    done = talloc_zero(ev, bool);
+    assert_non_null(done);
+
+    budget = sss_budget_create(ev, "test", 100);
+    assert_non_null(budget);
+    usleep(150000);
+    assert_true(sss_budget_exhausted(budget));
+
+    /* A pending request of a responder. */
+    ret = pipe(fds);
+    assert_int_equal(ret, 0);
+    assert_int_equal(write(fds[1], "x", 1), 1);
+
+    fde = tevent_add_fd(ev, ev, fds[0], TEVENT_FD_READ,
+                        test_sss_budget_fd_handler, fd_called);
+    assert_non_null(fde);
+
+    req = sss_budget_yield_send(ev, ev, budget);
+    assert_non_null(req);
+    tevent_req_set_callback(req, test_sss_budget_yield_done, done);
+
+    while (!*done) {
+        assert_int_equal(tevent_loop_once(ev), 0);
+    }
+
+    /* The request was handled before the loop continued with a new slice */
+    assert_true(*fd_called);
+    assert_false(sss_budget_exhausted(budget));
+
+    close(fds[0]);
+    close(fds[1]);
+    talloc_free(ev);
+}
@@ -0,0 +1,121 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests/cmocka/common_mock.h"
+#include "util/sss_hash_map.h"
+
+/* More than the initial size of the map so it has to grow. */
+#define NUM_KEYS 1000
+
+SSS_HASH_MAP_TYPED(test_map, int)
+
+static void make_key(char *buf, size_t size, int i)
+{
+    snprintf(buf, size, "cn=group%d,cn=groups,dc=example,dc=com", i);
+}
+
+void test_sss_hash_map(void **state)
+{
+    struct sss_hash_map *map;
+    int values[NUM_KEYS];
+    int other = -1;
+    const char *key;
+    size_t iter;
+    char buf[64];
+    int *value;
+    errno_t ret;
+    int count;
+    int i;
+
+    map = sss_hash_map_create(global_talloc_context, 0);
+    assert_non_null(map);
+
+    assert_null(test_map_lookup(map, "missing"));
+    assert_int_equal(test_map_add(map, NULL, &other), EINVAL);
+    assert_int_equal(test_map_add(map, "key", NULL), EINVAL);
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        values[i] = i;
+        make_key(buf, sizeof(buf), i);
+        ret = test_map_add(map, buf, &values[i]);
+        assert_int_equal(ret, EOK);
+    }
+    assert_int_equal(sss_hash_map_count(map), NUM_KEYS);
+
+    /* the key is copied */
+    make_key(buf, sizeof(buf), 0);
+    assert_ptr_equal(test_map_lookup(map, buf), &values[0]);
+    buf[0] = 'C';
+    assert_null(test_map_lookup(map, buf));
+
+    make_key(buf, sizeof(buf), 1);
+    assert_int_equal(test_map_add(map, buf, &other), EEXIST);
+    assert_ptr_equal(test_map_lookup(map, buf), &values[1]);
+    assert_int_equal(test_map_override(map, buf, &other), EOK);
+    assert_ptr_equal(test_map_lookup(map, buf), &other);
+    assert_int_equal(test_map_override(map, buf, &values[1]), EOK);
+    assert_int_equal(sss_hash_map_count(map), NUM_KEYS);
+
+    /* delete every other key */
+    for (i = 0; i < NUM_KEYS; i += 2) {
+        make_key(buf, sizeof(buf), i);
+        assert_ptr_equal(test_map_delete(map, buf), &values[i]);
+        assert_null(test_map_delete(map, buf));
+    }
+    assert_int_equal(sss_hash_map_count(map), NUM_KEYS / 2);
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        make_key(buf, sizeof(buf), i);
+        assert_true(sss_hash_map_has_key(map, buf) == (i % 2 == 1));
+    }
+
+    /* iterate and delete the current entry */
+    iter = 0;
+    count = 0;
+    while (test_map_next(map, &iter, &key, &value)) {
+        assert_int_equal(*value % 2, 1);
+        make_key(buf, sizeof(buf), *value);
+        assert_string_equal(key, buf);
+        assert_ptr_equal(test_map_delete(map, key), value);
+        count++;
+    }
+    assert_int_equal(count, NUM_KEYS / 2);
+    assert_int_equal(sss_hash_map_count(map), 0);
+
+    /* deleted slots and keys are reused */
+    for (i = 0; i < NUM_KEYS * 10; i++) {
+        make_key(buf, sizeof(buf), i);
+        ret = test_map_add(map, buf, &values[i % NUM_KEYS]);
+        assert_int_equal(ret, EOK);
+
+        if (i >= 10) {
+            make_key(buf, sizeof(buf), i - 10);
+            assert_non_null(test_map_delete(map, buf));
+        }
+    }
+    assert_int_equal(sss_hash_map_count(map), 10);
+
+    for (i = NUM_KEYS * 10 - 10; i < NUM_KEYS * 10; i++) {
+        make_key(buf, sizeof(buf), i);
+        assert_ptr_equal(test_map_lookup(map, buf), &values[i % NUM_KEYS]);
+    }
+
+    sss_hash_map_clear(map);
+    assert_int_equal(sss_hash_map_count(map), 0);
+    iter = 0;
+    assert_false(test_map_next(map, &iter, NULL, NULL));
+
+    talloc_free(map);
+}
@@ -478,6 +478,138 @@ void test_map_id_external(void **state)
     assert_int_equal(err, IDMAP_EXTERNAL);
 }
 
+#define TEST_MANY_DOMAINS 80
+
+void test_map_id_many_domains(void **state)
+{
+    struct test_ctx *test_ctx;
+    struct sss_idmap_range range;
+    enum idmap_error_code err;
+    char name[64];
+    char dom_sid[64];
+    char range_id[64];
+    char sid[128];
+    uint32_t id;
+    int c;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+
+    assert_non_null(test_ctx);
+
+    /* Every domain gets a primary slice for the RIDs 0-199999 and a
+     * secondary slice for the RIDs 400000-599999. */
+    for (c = 0; c < TEST_MANY_DOMAINS; c++) {
+        snprintf(name, sizeof(name), "dom%d.test", c);
+        snprintf(dom_sid, sizeof(dom_sid), "S-1-5-21-100-200-%d", c);
+
+        range.min = (2 * c + 1) * 200000;
+        range.max = range.min + 199999;
+        err = sss_idmap_add_domain_ex(test_ctx->idmap_ctx, name, dom_sid,
+                                      &range, NULL, 0, false);
+        assert_int_equal(err, IDMAP_SUCCESS);
+
+        snprintf(range_id, sizeof(range_id), "%s-400000", dom_sid);
+        range.min = (2 * c + 2) * 200000;
+        range.max = range.min + 199999;
+        err = sss_idmap_add_domain_ex(test_ctx->idmap_ctx, name, dom_sid,
+                                      &range, range_id, 400000, false);
+        assert_int_equal(err, IDMAP_SUCCESS);
+    }
+
+    for (c = 0; c < TEST_MANY_DOMAINS; c++) {
+        snprintf(sid, sizeof(sid), "S-1-5-21-100-200-%d-1000", c);
+        err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, sid, &id);
+        assert_int_equal(err, IDMAP_SUCCESS);
+        assert_int_equal(id, (2 * c + 1) * 200000 + 1000);
+
+        snprintf(sid, sizeof(sid), "S-1-5-21-100-200-%d-400001", c);
+        err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, sid, &id);
+        assert_int_equal(err, IDMAP_SUCCESS);
+        assert_int_equal(id, (2 * c + 2) * 200000 + 1);
+
+        snprintf(sid, sizeof(sid), "S-1-5-21-100-200-%d-300000", c);
+        err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, sid, &id);
+        assert_int_equal(err, IDMAP_NO_RANGE);
+
+        /* additional sub-authority after the domain SID */
+        snprintf(sid, sizeof(sid), "S-1-5-21-100-200-%d-1-1000", c);
+        err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, sid, &id);
+        assert_int_equal(err, IDMAP_SID_INVALID);
+    }
+
+    err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx,
+                                "S-1-5-21-100-200-"
+                                TEST_OFFSET_STR"-1000", &id);
+    assert_int_equal(err, IDMAP_NO_DOMAIN);
+
+    err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, "S-1-1-0", &id);
+    assert_int_equal(err, IDMAP_NO_DOMAIN);
+}
+
+void test_map_bin_sids(void **state)
+{
+    struct test_ctx *test_ctx;
+    enum idmap_error_code err;
+    const char *sids[] = { TEST_DOM_SID"-0",
+                           TEST_DOM_SID"-400000",
+                           TEST_DOM_SID"-"TEST_OFFSET_STR,
+                           TEST_DOM_SID"-1-1000",
+                           TEST_DOM_SID"1-1",
+                           TEST_2_DOM_SID"-1000",
+                           "S-1-5-21-123-456-1000",
+                           "S-1-5-32-544",
+                           "S-1-1-0",
+                           NULL };
+    uint8_t *bin_sids[sizeof(sids) / sizeof(sids[0])];
+    size_t lengths[sizeof(sids) / sizeof(sids[0])];
+    enum idmap_error_code errs[sizeof(sids) / sizeof(sids[0])];
+    uint32_t ids[sizeof(sids) / sizeof(sids[0])];
+    uint32_t id;
+    size_t c;
+
+    test_ctx = talloc_get_type(*state, struct test_ctx);
+
+    assert_non_null(test_ctx);
+
+    for (c = 0; sids[c] != NULL; c++) {
+        err = sss_idmap_sid_to_bin_sid(test_ctx->idmap_ctx, sids[c],
+                                       &bin_sids[c], &lengths[c]);
+        assert_int_equal(err, IDMAP_SUCCESS);
+    }
+
+    err = sss_idmap_bin_sids_to_unix(test_ctx->idmap_ctx, bin_sids, lengths,
+                                     c, ids, errs);
+    assert_int_equal(err, IDMAP_SUCCESS);
+
+    /* The results must not differ from the ones of the string SIDs. */
+    for (c = 0; sids[c] != NULL; c++) {
+        err = sss_idmap_sid_to_unix(test_ctx->idmap_ctx, sids[c], &id);
+        assert_int_equal(errs[c], err);
+        if (err == IDMAP_SUCCESS) {
+            assert_int_equal(ids[c], id);
+        }
+
+        err = sss_idmap_bin_sid_to_unix(test_ctx->idmap_ctx, bin_sids[c],
+                                        lengths[c], &id);
+        assert_int_equal(errs[c], err);
+
+        /* truncated binary SID */
+        err = sss_idmap_bin_sid_to_unix(test_ctx->idmap_ctx, bin_sids[c],
+                                        lengths[c] - 1, &id);
+        assert_int_equal(err, IDMAP_SID_INVALID);
+
+        talloc_free(bin_sids[c]);
+    }
+
+    err = sss_idmap_bin_sids_to_unix(test_ctx->idmap_ctx, NULL, NULL, 0,
+                                     NULL, NULL);
+    assert_int_equal(err, IDMAP_SUCCESS);
+
+    err = sss_idmap_bin_sids_to_unix(test_ctx->idmap_ctx, NULL, NULL, 1,
+                                     NULL, NULL);
+    assert_int_equal(err, IDMAP_ERROR);
+}
+
 void test_check_sid_id(void **state)
 {
     struct test_ctx *test_ctx;
@@ -739,6 +871,18 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_map_id_external,
                                         test_sss_idmap_setup_with_external_mappings,
                                         test_sss_idmap_teardown),
+        cmocka_unit_test_setup_teardown(test_map_id_many_domains,
+                                        test_sss_idmap_setup,
+                                        test_sss_idmap_teardown),
+        cmocka_unit_test_setup_teardown(test_map_bin_sids,
+                                        test_sss_idmap_setup_with_domains,
+                                        test_sss_idmap_teardown),
+        cmocka_unit_test_setup_teardown(test_map_bin_sids,
+                                        test_sss_idmap_setup_with_external_mappings,
+                                        test_sss_idmap_teardown),
+        cmocka_unit_test_setup_teardown(test_map_bin_sids,
+                                        test_sss_idmap_setup_with_both,
+                                        test_sss_idmap_teardown),
         cmocka_unit_test_setup_teardown(test_check_sid_id,
                                         test_sss_idmap_setup_with_domains,
                                         test_sss_idmap_teardown),
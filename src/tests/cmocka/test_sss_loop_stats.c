@@ -0,0 +1,148 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <time.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "util/sss_metrics.h"
+#include "util/sss_loop_stats.h"
+
+#define TEST_LOOP_BUSY_USEC 2000
+
+static void test_loop_busy(void)
+{
+    struct timespec start;
+    struct timespec now;
+    uint64_t usec;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        usec = (now.tv_sec - start.tv_sec) * 1000000
+               + (now.tv_nsec - start.tv_nsec) / 1000;
+    } while (usec < TEST_LOOP_BUSY_USEC);
+}
+
+static void test_loop_stats_section(void)
+{
+    SSS_LOOP_STATS_ENTER();
+    test_loop_busy();
+    sss_loop_stats_leave();
+}
+
+static void test_loop_stats_handler(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv,
+                                    void *pvt)
+{
+    bool *done = pvt;
+
+    SSS_LOOP_STATS_MARK();
+
+    test_loop_busy();
+    test_loop_stats_section();
+
+    *done = true;
+}
+
+static void test_loop_stats_nop(struct tevent_context *ev,
+                                struct tevent_timer *te,
+                                struct timeval tv,
+                                void *pvt)
+{
+    bool *done = pvt;
+
+    *done = true;
+}
+
+static uint64_t test_loop_stats_value(struct sss_metrics_sample *samples,
+                                      size_t num,
+                                      enum sss_metric metric,
+                                      const char *location)
+{
+    char *labels;
+    uint64_t value = 0;
+    size_t i;
+
+    labels = talloc_asprintf(NULL, "location=\"%s\"", location);
+    assert_non_null(labels);
+
+    for (i = 0; i < num; i++) {
+        if (samples[i].metric == metric
+                && strcmp(samples[i].labels, labels) == 0) {
+            value = strtoull(samples[i].value, NULL, 10);
+            break;
+        }
+    }
+    assert_true(i < num);
+
+    talloc_free(labels);
+    return value;
+}
+
+static void test_loop_stats_run(struct tevent_context *ev,
+                                tevent_timer_handler_t handler)
+{
+    struct tevent_timer *te;
+    bool done = false;
+
+    te = tevent_add_timer(ev, ev, tevent_timeval_current_ofs(0, 1000),
+                          handler, &done);
+    assert_non_null(te);
+
+    while (!done) {
+        assert_int_equal(tevent_loop_once(ev), 0);
+    }
+}
+
+void test_sss_loop_stats(void **state)
+{
+    struct sss_metrics_sample *samples;
+    struct tevent_context *ev;
+    size_t num;
+    errno_t ret;
+
+    ev = tevent_context_init(global_talloc_context);
+    assert_non_null(ev);
+
+    ret = sss_loop_stats_init(ev);
+    assert_int_equal(ret, EOK);
+
+    test_loop_stats_run(ev, test_loop_stats_handler);
+    /* Without the loop trace points of newer tevent the iteration ends
+     * when the loop waits again. */
+    test_loop_stats_run(ev, test_loop_stats_nop);
+
+    ret = sss_metrics_export(global_talloc_context, &samples, &num);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(test_loop_stats_value(samples, num,
+                         SSS_METRIC_EVENT_LOOP_HANDLER_CALLS,
+                         "test_loop_stats_handler"), 1);
+    assert_true(test_loop_stats_value(samples, num,
+                    SSS_METRIC_EVENT_LOOP_HANDLER_TIME,
+                    "test_loop_stats_handler") >= TEST_LOOP_BUSY_USEC);
+
+    /* The section is accounted on its own. */
+    assert_int_equal(test_loop_stats_value(samples, num,
+                         SSS_METRIC_EVENT_LOOP_HANDLER_CALLS,
+                         "test_loop_stats_section"), 1);
+    assert_true(test_loop_stats_value(samples, num,
+                    SSS_METRIC_EVENT_LOOP_HANDLER_MAX,
+                    "test_loop_stats_section") >= TEST_LOOP_BUSY_USEC);
+
+    talloc_free(samples);
+    talloc_free(ev);
+}
@@ -0,0 +1,57 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "util/sss_memfd.h"
+
+void test_sss_memfd(void **state)
+{
+    struct sss_memfd_map *map;
+    uint8_t data[100000];
+    size_t i;
+    int fd;
+    int ret;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = i % 251;
+    }
+
+    ret = sss_memfd_create("test", data, sizeof(data), &fd);
+    if (ret == ENOTSUP) {
+        skip();
+    }
+    assert_int_equal(ret, EOK);
+
+    /* The content can not be changed anymore. */
+    assert_int_equal(write(fd, data, 1), -1);
+    assert_int_equal(ftruncate(fd, 1), -1);
+
+    ret = sss_memfd_map(global_talloc_context, fd, &map);
+    close(fd);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(map->length, sizeof(data));
+    assert_memory_equal(map->data, data, sizeof(data));
+    talloc_free(map);
+
+    /* Plain files are refused. */
+    fd = open("/dev/null", O_RDONLY);
+    assert_true(fd >= 0);
+    ret = sss_memfd_map(global_talloc_context, fd, &map);
+    close(fd);
+    assert_int_equal(ret, EPERM);
+}
@@ -0,0 +1,154 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests/cmocka/common_mock.h"
+#include "util/sss_metrics.h"
+
+static void test_metrics_collect(void *pvt)
+{
+    int *calls = pvt;
+
+    (*calls)++;
+    sss_metrics_set(SSS_METRIC_NCACHE_ENTRIES, 42);
+}
+
+static const char *test_metrics_value(struct sss_metrics_sample *samples,
+                                      size_t num,
+                                      enum sss_metric metric,
+                                      const char *suffix,
+                                      const char *labels)
+{
+    size_t i;
+
+    for (i = 0; i < num; i++) {
+        if (samples[i].metric == metric
+                && strcmp(samples[i].suffix, suffix) == 0
+                && strcmp(samples[i].labels, labels) == 0) {
+            return samples[i].value;
+        }
+    }
+
+    return NULL;
+}
+
+void test_sss_metrics(void **state)
+{
+    struct sss_metrics_source sources[2];
+    struct sss_metrics_sample *samples;
+    TALLOC_CTX *tmp_ctx;
+    TALLOC_CTX *owner;
+    size_t num;
+    char *text;
+    int calls = 0;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(global_talloc_context);
+    assert_non_null(tmp_ctx);
+    owner = talloc_new(tmp_ctx);
+    assert_non_null(owner);
+
+    sss_metrics_inc(SSS_METRIC_DP_REQUESTS, 1, "dom", "id", "success");
+    sss_metrics_inc(SSS_METRIC_DP_REQUESTS, 2, "dom", "id", "success");
+    sss_metrics_inc(SSS_METRIC_DP_REQUESTS, 1, "dom", "id", "offline");
+    sss_metrics_inc(SSS_METRIC_FAILOVER_SWITCHES, 1, "svc \"a\"");
+
+    sss_metrics_observe(SSS_METRIC_LDAP_OP_DURATION, 800, "success");
+    sss_metrics_observe(SSS_METRIC_LDAP_OP_DURATION, 30000, "success");
+    sss_metrics_observe(SSS_METRIC_LDAP_OP_DURATION, 20000000, "success");
+
+    ret = sss_metrics_add_collector(owner, test_metrics_collect, &calls);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_metrics_export(tmp_ctx, &samples, &num);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(calls, 1);
+
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_DP_REQUESTS, "_total",
+                            "domain=\"dom\",target=\"id\",result=\"success\""),
+                        "3");
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_DP_REQUESTS, "_total",
+                            "domain=\"dom\",target=\"id\",result=\"offline\""),
+                        "1");
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_FAILOVER_SWITCHES, "_total",
+                            "service=\"svc \\\"a\\\"\""),
+                        "1");
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_NCACHE_ENTRIES, "", ""),
+                        "42");
+
+    /* Buckets are cumulative, observations above the last bound are only
+     * counted in +Inf. */
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_LDAP_OP_DURATION, "_bucket",
+                            "outcome=\"success\",le=\"0.001\""),
+                        "1");
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_LDAP_OP_DURATION, "_bucket",
+                            "outcome=\"success\",le=\"10\""),
+                        "2");
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_LDAP_OP_DURATION, "_bucket",
+                            "outcome=\"success\",le=\"+Inf\""),
+                        "3");
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_LDAP_OP_DURATION, "_count",
+                            "outcome=\"success\""),
+                        "3");
+    assert_string_equal(test_metrics_value(samples, num,
+                            SSS_METRIC_LDAP_OP_DURATION, "_sum",
+                            "outcome=\"success\""),
+                        "20.030800");
+
+    sources[0].component = "nss";
+    sources[0].samples = samples;
+    sources[0].num_samples = num;
+    sources[1].component = "be[dom]";
+    sources[1].samples = samples;
+    sources[1].num_samples = num;
+
+    text = sss_metrics_format(tmp_ctx, sources, 2);
+    assert_non_null(text);
+
+    assert_non_null(strstr(text, "# TYPE sssd_dp_requests counter\n"));
+    assert_non_null(strstr(text,
+        "sssd_dp_requests_total{component=\"nss\",domain=\"dom\","
+        "target=\"id\",result=\"success\"} 3\n"));
+    assert_non_null(strstr(text,
+        "sssd_negative_cache_entries{component=\"be[dom]\"} 42\n"));
+    assert_non_null(strstr(text,
+        "sssd_ldap_operation_duration_seconds_bucket{component=\"nss\","
+        "outcome=\"success\",le=\"+Inf\"} 3\n"));
+    /* The family header is written only once for all components. */
+    assert_null(strstr(strstr(text, "# TYPE sssd_dp_requests ") + 1,
+                       "# TYPE sssd_dp_requests "));
+    assert_null(strstr(text, "sssd_child_forks"));
+    assert_string_equal(text + strlen(text) - strlen("# EOF\n"), "# EOF\n");
+
+    /* The collector is removed with its owner. */
+    talloc_free(owner);
+    ret = sss_metrics_export(tmp_ctx, &samples, &num);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(calls, 1);
+
+    sss_metrics_reset();
+    ret = sss_metrics_export(tmp_ctx, &samples, &num);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(num, 0);
+
+    talloc_free(tmp_ctx);
+}
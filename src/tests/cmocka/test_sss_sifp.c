@@ -52,6 +52,50 @@ __wrap_dbus_connection_send_with_reply_and_block(DBusConnection *connection,
     return sss_mock_ptr_type(DBusMessage *);
 }
 
+/* no real pending call is ever created, this only needs to be unique */
+static int fake_pending_call;
+
+dbus_bool_t
+__wrap_dbus_connection_send_with_reply(DBusConnection *connection,
+                                       DBusMessage *message,
+                                       DBusPendingCall **pending_return,
+                                       int timeout_milliseconds)
+{
+    *pending_return = (DBusPendingCall *)&fake_pending_call;
+    return TRUE;
+}
+
+dbus_bool_t
+__wrap_dbus_connection_read_write_dispatch(DBusConnection *connection,
+                                           int timeout_milliseconds)
+{
+    return TRUE;
+}
+
+dbus_bool_t
+__wrap_dbus_pending_call_get_completed(DBusPendingCall *pending)
+{
+    return sss_mock_type(bool) ? TRUE : FALSE;
+}
+
+DBusMessage *
+__wrap_dbus_pending_call_steal_reply(DBusPendingCall *pending)
+{
+    return sss_mock_ptr_type(DBusMessage *);
+}
+
+void
+__wrap_dbus_pending_call_cancel(DBusPendingCall *pending)
+{
+    return;
+}
+
+void
+__wrap_dbus_pending_call_unref(DBusPendingCall *pending)
+{
+    return;
+}
+
 static void reply_variant_basic(DBusMessage *reply,
                                 const char *type,
                                 const void *val)
@@ -2118,6 +2162,205 @@ void test_sss_sifp_fetch_domain_by_name(void **state)
     /* messages are unreferenced in the library */
 }
 
+static DBusMessage *users_attrs_reply(void)
+{
+    DBusMessage *reply = NULL;
+    DBusMessageIter iter;
+    DBusMessageIter array_iter;
+    DBusMessageIter attrs_iter;
+    DBusMessageIter dict_iter;
+    DBusMessageIter values_iter;
+    dbus_bool_t bret;
+    const char *names[] = {"name", "mail", NULL};
+    const char *values[] = {"user1", "user1@example.com", NULL};
+    int i;
+
+    reply = dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_RETURN);
+    assert_non_null(reply);
+
+    /* prepare message, the second user does not exist */
+    dbus_message_iter_init_append(reply, &iter);
+
+    bret = dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "a{sas}",
+                                            &array_iter);
+    assert_true(bret);
+
+    bret = dbus_message_iter_open_container(&array_iter, DBUS_TYPE_ARRAY,
+                                            "{sas}", &attrs_iter);
+    assert_true(bret);
+
+    for (i = 0; names[i] != NULL; i++) {
+        bret = dbus_message_iter_open_container(&attrs_iter,
+                                                DBUS_TYPE_DICT_ENTRY,
+                                                NULL, &dict_iter);
+        assert_true(bret);
+
+        bret = dbus_message_iter_append_basic(&dict_iter, DBUS_TYPE_STRING,
+                                              &names[i]);
+        assert_true(bret);
+
+        bret = dbus_message_iter_open_container(&dict_iter, DBUS_TYPE_ARRAY,
+                                                DBUS_TYPE_STRING_AS_STRING,
+                                                &values_iter);
+        assert_true(bret);
+
+        bret = dbus_message_iter_append_basic(&values_iter, DBUS_TYPE_STRING,
+                                              &values[i]);
+        assert_true(bret);
+
+        bret = dbus_message_iter_close_container(&dict_iter, &values_iter);
+        assert_true(bret);
+
+        bret = dbus_message_iter_close_container(&attrs_iter, &dict_iter);
+        assert_true(bret);
+    }
+
+    bret = dbus_message_iter_close_container(&array_iter, &attrs_iter);
+    assert_true(bret);
+
+    bret = dbus_message_iter_open_container(&array_iter, DBUS_TYPE_ARRAY,
+                                            "{sas}", &attrs_iter);
+    assert_true(bret);
+
+    bret = dbus_message_iter_close_container(&array_iter, &attrs_iter);
+    assert_true(bret);
+
+    bret = dbus_message_iter_close_container(&iter, &array_iter);
+    assert_true(bret);
+
+    return reply;
+}
+
+static void check_users_attrs(const char **paths,
+                              sss_sifp_object **out)
+{
+    const char * const *mail = NULL;
+    unsigned int num_values;
+    sss_sifp_error ret;
+
+    assert_non_null(out);
+    assert_non_null(out[0]);
+    assert_non_null(out[1]);
+    assert_null(out[2]);
+
+    assert_string_equal(out[0]->object_path, paths[0]);
+    assert_string_equal(out[0]->interface,
+                        "org.freedesktop.sssd.infopipe.Users.User");
+    assert_string_equal(out[0]->name, "user1");
+
+    ret = sss_sifp_find_attr_as_string_array(out[0]->attrs, "mail",
+                                             &num_values, &mail);
+    assert_int_equal(ret, SSS_SIFP_OK);
+    assert_int_equal(num_values, 1);
+    assert_string_equal(mail[0], "user1@example.com");
+
+    assert_string_equal(out[1]->object_path, paths[1]);
+    assert_null(out[1]->name);
+    assert_non_null(out[1]->attrs);
+    assert_null(out[1]->attrs[0]);
+}
+
+void test_sss_sifp_fetch_users_attrs(void **state)
+{
+    sss_sifp_ctx *ctx = test_ctx.dbus_ctx;
+    DBusMessage *reply = NULL;
+    sss_sifp_error ret;
+    const char *paths[] = {SSS_SIFP_PATH "/Users/LDAP/1000",
+                           SSS_SIFP_PATH "/Users/LDAP/1001",
+                           NULL};
+    const char *attrs[] = {"name", "mail", NULL};
+    sss_sifp_object **out = NULL;
+
+    reply = users_attrs_reply();
+
+    will_return(__wrap_dbus_connection_send_with_reply_and_block, reply);
+
+    /* test */
+    ret = sss_sifp_fetch_users_attrs(ctx, paths, attrs, &out);
+    assert_int_equal(ret, SSS_SIFP_OK);
+    check_users_attrs(paths, out);
+
+    sss_sifp_free_objects(ctx, &out);
+    assert_null(out);
+
+    /* messages are unreferenced in the library */
+}
+
+struct users_attrs_state {
+    bool done;
+    sss_sifp_error error;
+    sss_sifp_object **users;
+};
+
+static void users_attrs_done(sss_sifp_ctx *ctx,
+                             sss_sifp_error error,
+                             sss_sifp_object **objects,
+                             void *pvt)
+{
+    struct users_attrs_state *state = pvt;
+
+    state->done = true;
+    state->error = error;
+    state->users = objects;
+}
+
+void test_sss_sifp_fetch_users_attrs_send(void **state)
+{
+    sss_sifp_ctx *ctx = test_ctx.dbus_ctx;
+    struct users_attrs_state cb_state = { 0 };
+    unsigned int num_pending;
+    sss_sifp_error ret;
+    const char *paths[] = {SSS_SIFP_PATH "/Users/LDAP/1000",
+                           SSS_SIFP_PATH "/Users/LDAP/1001",
+                           NULL};
+    const char *attrs[] = {"name", "mail", NULL};
+
+    ret = sss_sifp_fetch_users_attrs_send(ctx, paths, attrs,
+                                          users_attrs_done, &cb_state);
+    assert_int_equal(ret, SSS_SIFP_OK);
+
+    /* the reply did not arrive yet */
+    will_return(__wrap_dbus_pending_call_get_completed, false);
+    will_return(__wrap_dbus_pending_call_get_completed, false);
+
+    ret = sss_sifp_dispatch(ctx, 0, &num_pending);
+    assert_int_equal(ret, SSS_SIFP_OK);
+    assert_int_equal(num_pending, 1);
+    assert_false(cb_state.done);
+
+    /* the reply was read by another context, so there is no need to wait */
+    will_return(__wrap_dbus_pending_call_get_completed, true);
+    will_return(__wrap_dbus_pending_call_get_completed, true);
+    will_return(__wrap_dbus_pending_call_steal_reply, users_attrs_reply());
+
+    ret = sss_sifp_dispatch(ctx, -1, &num_pending);
+    assert_int_equal(ret, SSS_SIFP_OK);
+    assert_int_equal(num_pending, 0);
+    assert_true(cb_state.done);
+    assert_int_equal(cb_state.error, SSS_SIFP_OK);
+    check_users_attrs(paths, cb_state.users);
+
+    sss_sifp_free_objects(ctx, &cb_state.users);
+    assert_null(cb_state.users);
+}
+
+void test_sss_sifp_free_pending(void **state)
+{
+    struct users_attrs_state cb_state = { 0 };
+    sss_sifp_error ret;
+    const char *paths[] = {SSS_SIFP_PATH "/Users/LDAP/1000", NULL};
+    const char *attrs[] = {"name", NULL};
+
+    ret = sss_sifp_fetch_users_attrs_send(test_ctx.dbus_ctx, paths, attrs,
+                                          users_attrs_done, &cb_state);
+    assert_int_equal(ret, SSS_SIFP_OK);
+
+    /* the request is cancelled without calling the callback */
+    sss_sifp_free(&test_ctx.dbus_ctx);
+    assert_null(test_ctx.dbus_ctx);
+    assert_false(cb_state.done);
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -2225,6 +2468,12 @@ int main(int argc, const char *argv[])
                                         test_setup, test_teardown_api),
         cmocka_unit_test_setup_teardown(test_sss_sifp_fetch_domain_by_name,
                                         test_setup, test_teardown_api),
+        cmocka_unit_test_setup_teardown(test_sss_sifp_fetch_users_attrs,
+                                        test_setup, test_teardown_api),
+        cmocka_unit_test_setup_teardown(test_sss_sifp_fetch_users_attrs_send,
+                                        test_setup, test_teardown_api),
+        cmocka_unit_test_setup_teardown(test_sss_sifp_free_pending,
+                                        test_setup, test_teardown_api),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
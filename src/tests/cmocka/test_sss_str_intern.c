@@ -0,0 +1,59 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests/cmocka/common_mock.h"
+#include "util/sss_str_intern.h"
+
+/* More than the initial size of the pool so it has to grow. */
+#define NUM_STRINGS 1000
+
+void test_sss_str_intern(void **state)
+{
+    struct sss_str_intern_pool *pool;
+    const char *interned[NUM_STRINGS];
+    const char *str;
+    char buf[64];
+    int i;
+
+    pool = sss_str_intern_pool_create(global_talloc_context);
+    assert_non_null(pool);
+
+    assert_null(sss_str_intern(pool, NULL));
+
+    for (i = 0; i < NUM_STRINGS; i++) {
+        snprintf(buf, sizeof(buf), "cn=group%d,cn=groups,dc=example,dc=com", i);
+        interned[i] = sss_str_intern(pool, buf);
+        assert_non_null(interned[i]);
+        assert_ptr_not_equal(interned[i], buf);
+        assert_string_equal(interned[i], buf);
+    }
+    assert_int_equal(sss_str_intern_count(pool), NUM_STRINGS);
+
+    /* the same copies are returned after the pool has grown */
+    for (i = 0; i < NUM_STRINGS; i++) {
+        snprintf(buf, sizeof(buf), "cn=group%d,cn=groups,dc=example,dc=com", i);
+        str = sss_str_intern(pool, buf);
+        assert_ptr_equal(str, interned[i]);
+    }
+    assert_int_equal(sss_str_intern_count(pool), NUM_STRINGS);
+
+    /* interning is case sensitive */
+    str = sss_str_intern(pool, "CN=group0,cn=groups,dc=example,dc=com");
+    assert_non_null(str);
+    assert_ptr_not_equal(str, interned[0]);
+    assert_int_equal(sss_str_intern_count(pool), NUM_STRINGS + 1);
+
+    talloc_free(pool);
+}
@@ -0,0 +1,156 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "shared/safealign.h"
+#include "util/sss_trace.h"
+
+#define TEST_TRACE_FILE "test_sss_trace.trace"
+
+struct test_trace_span {
+    uint64_t trace_id;
+    uint64_t span_id;
+    uint64_t parent_id;
+    int32_t outcome;
+    char name[256];
+};
+
+static size_t test_trace_read(struct test_trace_span *spans, size_t max)
+{
+    uint8_t buf[4096];
+    uint32_t len;
+    uint32_t type;
+    uint16_t slen;
+    size_t num = 0;
+    size_t size;
+    size_t p;
+    size_t c;
+    FILE *f;
+
+    f = fopen(TEST_TRACE_FILE, "r");
+    assert_non_null(f);
+    size = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+
+    assert_true(size > strlen(SSS_TRACE_MAGIC));
+    assert_memory_equal(buf, SSS_TRACE_MAGIC, strlen(SSS_TRACE_MAGIC));
+    p = strlen(SSS_TRACE_MAGIC);
+
+    while (p < size) {
+        c = p;
+        SAFEALIGN_COPY_UINT32(&len, &buf[c], &c);
+        SAFEALIGN_COPY_UINT32(&type, &buf[c], &c);
+        assert_true(p + len <= size);
+
+        if (type == SSS_TRACE_RECORD_SPAN) {
+            assert_true(num < max);
+            c += sizeof(uint32_t);
+            safealign_memcpy(&spans[num].trace_id, &buf[c],
+                             sizeof(uint64_t), &c);
+            safealign_memcpy(&spans[num].span_id, &buf[c],
+                             sizeof(uint64_t), &c);
+            safealign_memcpy(&spans[num].parent_id, &buf[c],
+                             sizeof(uint64_t), &c);
+            c += 2 * sizeof(uint64_t);
+            SAFEALIGN_COPY_INT32(&spans[num].outcome, &buf[c], &c);
+            SAFEALIGN_COPY_UINT16(&slen, &buf[c], &c);
+            memcpy(spans[num].name, &buf[c], slen);
+            spans[num].name[slen] = '\0';
+            num++;
+        } else {
+            assert_int_equal(type, SSS_TRACE_RECORD_PROCESS);
+        }
+
+        p += len;
+    }
+
+    return num;
+}
+
+void test_sss_trace(void **state)
+{
+    struct test_trace_span spans[4];
+    struct sss_trace_span *root;
+    struct sss_trace_span *child;
+    struct sss_trace_span *span;
+    TALLOC_CTX *owner;
+    TALLOC_CTX *sub;
+    size_t num;
+    errno_t ret;
+
+    unlink(TEST_TRACE_FILE);
+
+    /* Nothing is traced before the trace file is opened. */
+    assert_int_equal(sss_trace_new_id(), 0);
+    assert_null(sss_trace_span_start(global_talloc_context, 0, 0,
+                                     "Root", "test"));
+
+    ret = sss_trace_init(TEST_TRACE_FILE);
+    assert_int_equal(ret, EOK);
+    assert_true(sss_trace_enabled());
+
+    owner = talloc_new(global_talloc_context);
+    assert_non_null(owner);
+    sub = talloc_new(talloc_new(owner));
+    assert_non_null(sub);
+
+    root = sss_trace_span_start(owner, 0, 0, "Root", "test");
+    assert_non_null(root);
+    assert_int_not_equal(sss_trace_span_trace_id(root), 0);
+
+    /* A span is found through the talloc parents of its owner. */
+    assert_ptr_equal(sss_trace_span_find(sub), root);
+
+    child = sss_trace_span_start_child(sub, "Child", "test");
+    assert_non_null(child);
+    assert_ptr_equal(sss_trace_span_find(sub), child);
+    assert_int_equal(sss_trace_span_trace_id(child),
+                     sss_trace_span_trace_id(root));
+
+    sss_trace_span_end(child, ENOENT);
+    assert_ptr_equal(sss_trace_span_find(sub), root);
+
+    /* Spans whose owner is freed are canceled. */
+    span = sss_trace_span_start_child(sub, "Freed", NULL);
+    assert_non_null(span);
+    talloc_free(sub);
+
+    sss_trace_span_end(root, EOK);
+    assert_null(sss_trace_span_find(owner));
+    talloc_free(owner);
+
+    fflush(NULL);
+
+    num = test_trace_read(spans, 4);
+    assert_int_equal(num, 3);
+
+    assert_string_equal(spans[0].name, "Child");
+    assert_int_equal(spans[0].outcome, ENOENT);
+    assert_int_equal(spans[0].parent_id, spans[2].span_id);
+
+    assert_string_equal(spans[1].name, "Freed");
+    assert_int_equal(spans[1].outcome, ECANCELED);
+    assert_int_equal(spans[1].parent_id, spans[2].span_id);
+
+    assert_string_equal(spans[2].name, "Root");
+    assert_int_equal(spans[2].outcome, EOK);
+    assert_int_equal(spans[2].parent_id, 0);
+    assert_int_equal(spans[2].trace_id, spans[0].trace_id);
+
+    unlink(TEST_TRACE_FILE);
+}
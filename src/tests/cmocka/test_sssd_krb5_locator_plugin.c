@@ -384,6 +384,97 @@ void test_single(void **state)
     krb5_free_context(ctx);
 }
 
+void test_preferred_kdc(void **state)
+{
+    krb5_context ctx;
+    krb5_error_code kerr;
+    void *priv;
+    int fd;
+    struct serverlist list = SERVERLIST_INIT;
+    struct module_callback_data cbdata = { 0 };
+    ssize_t s;
+    int ret;
+    char host[NI_MAXHOST];
+    char service[NI_MAXSERV];
+    const char *kdcinfo = "155.42.66.53\n"TEST_IP_1"\n";
+
+    cbdata.list = &list;
+
+    kerr = krb5_init_context (&ctx);
+    assert_int_equal(kerr, 0);
+
+    kerr = sssd_krb5_locator_init(ctx, &priv);
+    assert_int_equal(kerr, 0);
+
+    mkdir(TEST_PUBCONF_PATH, 0777);
+    fd = open(TEST_PUBCONF_PATH"/kdcinfo."TEST_REALM, O_CREAT|O_RDWR, 0777);
+    assert_int_not_equal(fd, -1);
+    s = write(fd, kdcinfo, strlen(kdcinfo));
+    assert_int_equal(s, strlen(kdcinfo));
+    close(fd);
+
+    ret = setenv("SSSD_KRB5_LOCATOR_PREFERRED_REALM", TEST_REALM, 1);
+    assert_int_equal(ret, 0);
+    ret = setenv("SSSD_KRB5_LOCATOR_PREFERRED_KDC", TEST_IP_1_WITH_SERVICE, 1);
+    assert_int_equal(ret, 0);
+
+    kerr = sssd_krb5_locator_lookup(priv, locate_service_kdc , TEST_REALM,
+                                    SOCK_DGRAM, AF_INET, module_callback,
+                                    &cbdata);
+    assert_int_equal(kerr, 0);
+
+    /* The preferred KDC comes first and is not repeated. */
+    assert_int_equal(list.nservers, 2);
+    assert_non_null(list.servers);
+    ret = getnameinfo((struct sockaddr *) &list.servers[0].addr,
+                      list.servers[0].addrlen,
+                      host, sizeof(host), service, sizeof(service),
+                      NI_NUMERICHOST|NI_NUMERICSERV);
+    assert_int_equal(ret, 0);
+    assert_string_equal(TEST_IP_1, host);
+    assert_string_equal(TEST_SERVICE_1, service);
+
+    ret = getnameinfo((struct sockaddr *) &list.servers[1].addr,
+                      list.servers[1].addrlen,
+                      host, sizeof(host), service, sizeof(service),
+                      NI_NUMERICHOST|NI_NUMERICSERV);
+    assert_int_equal(ret, 0);
+    assert_string_equal("155.42.66.53", host);
+    assert_string_equal("88", service);
+
+    k5_free_serverlist(&list);
+    sssd_krb5_locator_close(priv);
+
+    /* Other realms are not affected. */
+    ret = setenv("SSSD_KRB5_LOCATOR_PREFERRED_REALM", "OTHER.REALM", 1);
+    assert_int_equal(ret, 0);
+
+    kerr = sssd_krb5_locator_init(ctx, &priv);
+    assert_int_equal(kerr, 0);
+
+    kerr = sssd_krb5_locator_lookup(priv, locate_service_kdc , TEST_REALM,
+                                    SOCK_DGRAM, AF_INET, module_callback,
+                                    &cbdata);
+    assert_int_equal(kerr, 0);
+    assert_int_equal(list.nservers, 2);
+    ret = getnameinfo((struct sockaddr *) &list.servers[0].addr,
+                      list.servers[0].addrlen,
+                      host, sizeof(host), service, sizeof(service),
+                      NI_NUMERICHOST|NI_NUMERICSERV);
+    assert_int_equal(ret, 0);
+    assert_string_equal("155.42.66.53", host);
+
+    k5_free_serverlist(&list);
+
+    unsetenv("SSSD_KRB5_LOCATOR_PREFERRED_REALM");
+    unsetenv("SSSD_KRB5_LOCATOR_PREFERRED_KDC");
+    unlink(TEST_PUBCONF_PATH"/kdcinfo."TEST_REALM);
+    rmdir(TEST_PUBCONF_PATH);
+    sssd_krb5_locator_close(priv);
+
+    krb5_free_context(ctx);
+}
+
 struct test_data {
     const char *ip;
     bool found;
@@ -756,6 +847,8 @@ int main(int argc, const char *argv[])
                                         setup, teardown),
         cmocka_unit_test_setup_teardown(test_single,
                                         setup, teardown),
+        cmocka_unit_test_setup_teardown(test_preferred_kdc,
+                                        setup, teardown),
         cmocka_unit_test_setup_teardown(test_multi,
                                         setup, teardown),
         cmocka_unit_test_setup_teardown(test_service,
@@ -573,6 +573,38 @@ static void test_sysdb_set_and_get_site(void **state)
     talloc_free(tmp_ctx);
 }
 
+static void test_sysdb_set_and_get_memcache_stamp(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct subdom_test_ctx *test_ctx =
+        talloc_get_type(*state, struct subdom_test_ctx);
+    const char *stamp;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    ret = sysdb_get_memcache_stamp(tmp_ctx, test_ctx->tctx->dom, &stamp);
+    assert_int_equal(ret, EOK);
+    assert_null(stamp);
+
+    ret = sysdb_set_memcache_stamp(test_ctx->tctx->dom, "1234abcd");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_get_memcache_stamp(tmp_ctx, test_ctx->tctx->dom, &stamp);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(stamp, "1234abcd");
+
+    ret = sysdb_set_memcache_stamp(test_ctx->tctx->dom, NULL);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_get_memcache_stamp(tmp_ctx, test_ctx->tctx->dom, &stamp);
+    assert_int_equal(ret, EOK);
+    assert_null(stamp);
+
+    talloc_free(tmp_ctx);
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -609,6 +641,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sysdb_set_and_get_site,
                                         test_sysdb_subdom_setup,
                                         test_sysdb_subdom_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_set_and_get_memcache_stamp,
+                                        test_sysdb_subdom_setup,
+                                        test_sysdb_subdom_teardown),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -432,6 +432,144 @@ void test_store_sudo_case_insensitive(void **state)
     talloc_zfree(msgs);
 }
 
+void test_store_sudo_user_index(void **state)
+{
+    errno_t ret;
+    char *filter;
+    const char *attrs[] = { SYSDB_SUDO_CACHE_AT_CN,
+                            SYSDB_SUDO_CACHE_AT_USER_INDEX, NULL };
+    struct ldb_message **msgs = NULL;
+    size_t msgs_count;
+    struct ldb_message_element *element;
+    struct sysdb_attrs *rule;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    rule = sysdb_new_attrs(test_ctx);
+    assert_non_null(rule);
+    create_rule_attrs(rule, 0);
+
+    ret = sysdb_attrs_add_string_safe(rule, SYSDB_SUDO_CACHE_AT_USER,
+                                      "+netgroup1");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_attrs_add_string_safe(rule, SYSDB_SUDO_CACHE_AT_USER,
+                                      "+netgroup2");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_store(test_ctx->tctx->dom, &rule, 1);
+    assert_int_equal(ret, EOK);
+
+    filter = sysdb_sudo_filter_user(test_ctx, users[0].name, NULL, 0);
+    assert_non_null(filter);
+
+    ret = sysdb_search_sudo_rules(test_ctx, test_ctx->tctx->dom, filter,
+                                  attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(msgs_count, 1);
+
+    /* all netgroups are indexed by a single value */
+    element = ldb_msg_find_element(msgs[0], SYSDB_SUDO_CACHE_AT_USER_INDEX);
+    assert_non_null(element);
+    assert_int_equal(element->num_values, 2);
+
+    ret = ldb_msg_check_string_attribute(msgs[0],
+                                         SYSDB_SUDO_CACHE_AT_USER_INDEX,
+                                         users[0].name);
+    assert_int_equal(ret, 1);
+
+    ret = ldb_msg_check_string_attribute(msgs[0],
+                                         SYSDB_SUDO_CACHE_AT_USER_INDEX,
+                                         SYSDB_SUDO_USER_INDEX_NETGROUP);
+    assert_int_equal(ret, 1);
+
+    talloc_zfree(filter);
+    talloc_zfree(msgs);
+
+    /* the rule matches the user directly so it is not a netgroup candidate */
+    filter = sysdb_sudo_filter_netgroups(test_ctx, users[0].name, NULL, 0);
+    assert_non_null(filter);
+
+    ret = sysdb_search_sudo_rules(test_ctx, test_ctx->tctx->dom, filter,
+                                  attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, ENOENT);
+    talloc_zfree(filter);
+
+    filter = sysdb_sudo_filter_netgroups(test_ctx, users[1].name, NULL, 0);
+    assert_non_null(filter);
+
+    ret = sysdb_search_sudo_rules(test_ctx, test_ctx->tctx->dom, filter,
+                                  attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(msgs_count, 1);
+
+    talloc_zfree(rule);
+    talloc_zfree(filter);
+    talloc_zfree(msgs);
+}
+
+void test_store_sudo_packed_commands(void **state)
+{
+    errno_t ret;
+    const char *commands[] = { "/usr/bin/less", "/usr/bin/less -R",
+                               "!/usr/bin/lessecho", NULL };
+    const char *attrs[] = { SYSDB_SUDO_CACHE_AT_CN,
+                            SYSDB_SUDO_CACHE_AT_COMMAND, NULL };
+    const char *all_attrs[] = { "*", NULL };
+    struct ldb_message **msgs = NULL;
+    struct ldb_message_element *el;
+    size_t msgs_count;
+    struct sysdb_attrs *rule;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    test_ctx->tctx->dom->cache_compress_threshold = 3;
+
+    rule = sysdb_new_attrs(test_ctx);
+    assert_non_null(rule);
+    create_rule_attrs(rule, 0);
+
+    for (int i = 0; commands[i] != NULL; i++) {
+        ret = sysdb_attrs_add_string_safe(rule, SYSDB_SUDO_CACHE_AT_COMMAND,
+                                          commands[i]);
+        assert_int_equal(ret, EOK);
+    }
+
+    ret = sysdb_sudo_store(test_ctx->tctx->dom, &rule, 1);
+    assert_int_equal(ret, EOK);
+
+    /* The commands are stored as a single value */
+    ret = sysdb_search_custom_by_name(test_ctx, test_ctx->tctx->dom,
+                                      rules[0].name, SUDORULE_SUBDIR,
+                                      all_attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(msgs_count, 1);
+    assert_null(ldb_msg_find_element(msgs[0], SYSDB_SUDO_CACHE_AT_COMMAND));
+    el = ldb_msg_find_element(msgs[0], SYSDB_SUDO_CACHE_AT_COMMAND_PACKED);
+    assert_non_null(el);
+    assert_int_equal(el->num_values, 1);
+    talloc_zfree(msgs);
+
+    /* And they are unpacked in the original order */
+    ret = sysdb_search_sudo_rules(test_ctx, test_ctx->tctx->dom, NULL,
+                                  attrs, &msgs_count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(msgs_count, 1);
+    assert_null(ldb_msg_find_element(msgs[0],
+                                     SYSDB_SUDO_CACHE_AT_COMMAND_PACKED));
+    el = ldb_msg_find_element(msgs[0], SYSDB_SUDO_CACHE_AT_COMMAND);
+    assert_non_null(el);
+    assert_int_equal(el->num_values, 3);
+
+    for (int i = 0; commands[i] != NULL; i++) {
+        assert_int_equal(el->values[i].length, strlen(commands[i]));
+        assert_string_equal((const char *)el->values[i].data, commands[i]);
+    }
+
+    talloc_zfree(rule);
+    talloc_zfree(msgs);
+}
+
 void test_sudo_purge_by_filter(void **state)
 {
     errno_t ret;
@@ -481,6 +619,86 @@ void test_sudo_purge_by_rules(void **state)
     talloc_zfree(rule);
 }
 
+void test_sudo_update(void **state)
+{
+    errno_t ret;
+    struct sysdb_attrs *stored[3];
+    struct sysdb_attrs *received[2];
+    struct ldb_message **msgs = NULL;
+    size_t count;
+    const char *value;
+    const char *attrs[] = { SYSDB_SUDO_CACHE_AT_RUNASUSER, NULL };
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    for (int i = 0; i < 3; i++) {
+        stored[i] = sysdb_new_attrs(test_ctx);
+        assert_non_null(stored[i]);
+        create_rule_attrs(stored[i], i);
+    }
+
+    ret = sysdb_sudo_store(test_ctx->tctx->dom, stored, 3);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(get_stored_rules_count(test_ctx), 3);
+
+    /* The first rule is unchanged, the second one is modified and the third
+     * one was removed */
+    for (int i = 0; i < 2; i++) {
+        received[i] = sysdb_new_attrs(test_ctx);
+        assert_non_null(received[i]);
+    }
+    create_rule_attrs(received[0], 0);
+
+    ret = sysdb_attrs_add_string_safe(received[1], SYSDB_SUDO_CACHE_AT_CN,
+                                      rules[1].name);
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string_safe(received[1], SYSDB_SUDO_CACHE_AT_USER,
+                                      users[1].name);
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string_safe(received[1],
+                                      SYSDB_SUDO_CACHE_AT_RUNASUSER,
+                                      "nobody");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_sudo_update(test_ctx->tctx->dom,
+                            "(" SYSDB_OBJECTCLASS "=" SYSDB_SUDO_CACHE_OC ")",
+                            received, 2);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(get_stored_rules_count(test_ctx), 2);
+
+    ret = sysdb_search_custom_by_name(test_ctx, test_ctx->tctx->dom,
+                                      rules[0].name, SUDORULE_SUBDIR, attrs,
+                                      &count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count, 1);
+    value = ldb_msg_find_attr_as_string(msgs[0],
+                                        SYSDB_SUDO_CACHE_AT_RUNASUSER, NULL);
+    assert_string_equal(value, rules[0].as_user);
+    talloc_zfree(msgs);
+
+    ret = sysdb_search_custom_by_name(test_ctx, test_ctx->tctx->dom,
+                                      rules[1].name, SUDORULE_SUBDIR, attrs,
+                                      &count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count, 1);
+    value = ldb_msg_find_attr_as_string(msgs[0],
+                                        SYSDB_SUDO_CACHE_AT_RUNASUSER, NULL);
+    assert_string_equal(value, "nobody");
+    talloc_zfree(msgs);
+
+    ret = sysdb_search_custom_by_name(test_ctx, test_ctx->tctx->dom,
+                                      rules[2].name, SUDORULE_SUBDIR, attrs,
+                                      &count, &msgs);
+    assert_int_equal(ret, ENOENT);
+
+    for (int i = 0; i < 3; i++) {
+        talloc_zfree(stored[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        talloc_zfree(received[i]);
+    }
+}
+
 void test_sudo_set_get_last_full_refresh(void **state)
 {
     errno_t ret;
@@ -971,6 +1189,12 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_store_sudo_case_insensitive,
                                         test_sysdb_setup,
                                         test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_store_sudo_user_index,
+                                        test_sysdb_setup,
+                                        test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_store_sudo_packed_commands,
+                                        test_sysdb_setup,
+                                        test_sysdb_teardown),
 
         /* sysdb_sudo_purge() */
         cmocka_unit_test_setup_teardown(test_sudo_purge_by_filter,
@@ -981,6 +1205,11 @@ int main(int argc, const char *argv[])
                                         test_sysdb_setup,
                                         test_sysdb_teardown),
 
+        /* sysdb_sudo_update() */
+        cmocka_unit_test_setup_teardown(test_sudo_update,
+                                        test_sysdb_setup,
+                                        test_sysdb_teardown),
+
         /*
          * sysdb_sudo_set_last_full_refresh()
          * sysdb_sudo_get_last_full_refresh()
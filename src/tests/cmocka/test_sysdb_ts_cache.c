@@ -572,6 +572,77 @@ static void test_sysdb_group_delete(void **state)
     talloc_free(ts_res);
 }
 
+struct expire_notify_ctx {
+    size_t calls;
+    bool deleted;
+    time_t expire;
+};
+
+static void test_expire_notify(struct ldb_dn *dn,
+                               const char *attr,
+                               time_t expire,
+                               void *pvt)
+{
+    struct expire_notify_ctx *ctx = (struct expire_notify_ctx *) pvt;
+
+    ctx->calls++;
+    ctx->deleted = (attr == NULL);
+    if (attr != NULL) {
+        assert_string_equal(attr, SYSDB_CACHE_EXPIRE);
+        ctx->expire = expire;
+    }
+}
+
+static void test_sysdb_expire_notify(void **state)
+{
+    int ret;
+    struct sysdb_ts_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                     struct sysdb_ts_test_ctx);
+    struct sysdb_attrs *group_attrs = NULL;
+    struct expire_notify_ctx notify_ctx = { 0 };
+
+    sysdb_set_expire_notify(test_ctx->tctx->dom->sysdb,
+                            test_expire_notify, &notify_ctx);
+
+    group_attrs = create_modstamp_attrs(test_ctx, TEST_MODSTAMP_1);
+    assert_non_null(group_attrs);
+
+    ret = sysdb_store_group(test_ctx->tctx->dom,
+                            TEST_GROUP_NAME,
+                            TEST_GROUP_GID,
+                            group_attrs,
+                            TEST_CACHE_TIMEOUT,
+                            TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+    assert_true(notify_ctx.calls > 0);
+    assert_false(notify_ctx.deleted);
+    assert_int_equal(notify_ctx.expire, TEST_CACHE_TIMEOUT + TEST_NOW_1);
+
+    /* Only the timestamp cache is updated */
+    notify_ctx.calls = 0;
+    ret = sysdb_store_group(test_ctx->tctx->dom,
+                            TEST_GROUP_NAME,
+                            TEST_GROUP_GID,
+                            group_attrs,
+                            TEST_CACHE_TIMEOUT,
+                            TEST_NOW_2);
+    assert_int_equal(ret, EOK);
+    assert_true(notify_ctx.calls > 0);
+    assert_false(notify_ctx.deleted);
+    assert_int_equal(notify_ctx.expire, TEST_CACHE_TIMEOUT + TEST_NOW_2);
+    talloc_free(group_attrs);
+
+    notify_ctx.calls = 0;
+    ret = sysdb_delete_group(test_ctx->tctx->dom,
+                            TEST_GROUP_NAME,
+                            TEST_GROUP_GID);
+    assert_int_equal(ret, EOK);
+    assert_true(notify_ctx.calls > 0);
+    assert_true(notify_ctx.deleted);
+
+    sysdb_set_expire_notify(test_ctx->tctx->dom->sysdb, NULL, NULL);
+}
+
 static void test_sysdb_group_rename(void **state)
 {
     int ret;
@@ -851,6 +922,82 @@ static void test_merge_ldb_results(void **state)
     talloc_free(res2);
 }
 
+static void test_sysdb_search_merges_many(void **state)
+{
+    int ret;
+    struct sysdb_ts_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                     struct sysdb_ts_test_ctx);
+    const char *gr_fetch_attrs[] = SYSDB_GRSRC_ATTRS;
+    struct sysdb_attrs *group_attrs;
+    const char *name;
+    char *filter;
+    size_t msgs_count;
+    struct ldb_message **msgs = NULL;
+    uint64_t now;
+
+    ret = sysdb_store_group(test_ctx->tctx->dom, TEST_GROUP_NAME,
+                            TEST_GROUP_GID, NULL,
+                            TEST_CACHE_TIMEOUT, TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_group(test_ctx->tctx->dom, TEST_GROUP_NAME_2,
+                            TEST_GROUP_GID_2, NULL,
+                            TEST_CACHE_TIMEOUT, TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_group(test_ctx->tctx->dom, TEST_GROUP_NAME_3,
+                            TEST_GROUP_GID_3, NULL,
+                            TEST_CACHE_TIMEOUT, TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    /* Only the timestamp cache is updated for the second and third group */
+    group_attrs = create_ts_attrs(test_ctx, TEST_NOW_2 + TEST_CACHE_TIMEOUT,
+                                  TEST_NOW_2);
+    assert_non_null(group_attrs);
+    ret = sysdb_set_group_attr(test_ctx->tctx->dom, TEST_GROUP_NAME_2,
+                               group_attrs, SYSDB_MOD_REP);
+    talloc_free(group_attrs);
+    assert_int_equal(ret, EOK);
+
+    group_attrs = create_ts_attrs(test_ctx, TEST_NOW_3 + TEST_CACHE_TIMEOUT,
+                                  TEST_NOW_3);
+    assert_non_null(group_attrs);
+    ret = sysdb_set_group_attr(test_ctx->tctx->dom, TEST_GROUP_NAME_3,
+                               group_attrs, SYSDB_MOD_REP);
+    talloc_free(group_attrs);
+    assert_int_equal(ret, EOK);
+
+    /* All three timestamps must be merged from one lookup */
+    filter = talloc_asprintf(test_ctx, "(|(%s=%s)(%s=%s)(%s=%s))",
+                             SYSDB_NAME, TEST_GROUP_NAME,
+                             SYSDB_NAME, TEST_GROUP_NAME_2,
+                             SYSDB_NAME, TEST_GROUP_NAME_3);
+    assert_non_null(filter);
+    ret = sysdb_search_groups(test_ctx, test_ctx->tctx->dom,
+                              filter, gr_fetch_attrs,
+                              &msgs_count, &msgs);
+    talloc_free(filter);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(msgs_count, 3);
+
+    for (size_t i = 0; i < msgs_count; i++) {
+        name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
+        assert_non_null(name);
+
+        if (strcmp(name, TEST_GROUP_NAME) == 0) {
+            now = TEST_NOW_1;
+        } else if (strcmp(name, TEST_GROUP_NAME_2) == 0) {
+            now = TEST_NOW_2;
+        } else {
+            assert_string_equal(name, TEST_GROUP_NAME_3);
+            now = TEST_NOW_3;
+        }
+
+        assert_ts_attrs_msg(msgs[i], now + TEST_CACHE_TIMEOUT, now);
+    }
+    talloc_free(msgs);
+}
+
 static void test_group_bysid(void **state)
 {
     int ret;
@@ -1016,6 +1163,212 @@ static void test_sysdb_user_update(void **state)
     assert_int_equal(cache_expire_ts, TEST_CACHE_TIMEOUT + TEST_NOW_5);
 }
 
+static void test_sysdb_invalidate_cache_entries(void **state)
+{
+    int ret;
+    struct sysdb_ts_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                     struct sysdb_ts_test_ctx);
+    struct sysdb_attrs *attrs;
+    struct ldb_message **msgs;
+    size_t count;
+    const char *search_attrs[] = { SYSDB_NAME, NULL };
+    uint64_t cache_expire_sysdb;
+    uint64_t cache_expire_ts;
+
+    ret = sysdb_store_user(test_ctx->tctx->dom, TEST_USER_NAME, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_NAME,
+                           "/home/"TEST_USER_NAME, "/bin/bash", NULL,
+                           NULL, NULL, TEST_CACHE_TIMEOUT, TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_group(test_ctx->tctx->dom, TEST_GROUP_NAME,
+                            TEST_GROUP_GID, NULL, TEST_CACHE_TIMEOUT,
+                            TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_group(test_ctx->tctx->dom, TEST_GROUP_NAME_2,
+                            TEST_GROUP_GID_2, NULL, TEST_CACHE_TIMEOUT,
+                            TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_CACHE_EXPIRE, 1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_search_groups(test_ctx, test_ctx->tctx->dom,
+                              "("SYSDB_NAME"=*)", search_attrs,
+                              &count, &msgs);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count, 2);
+
+    ret = sysdb_invalidate_cache_entries(test_ctx->tctx->dom, msgs, count,
+                                         attrs);
+    assert_int_equal(ret, EOK);
+    talloc_free(msgs);
+
+    /* Both groups expired in both caches */
+    get_gr_timestamp_attrs(test_ctx, TEST_GROUP_NAME,
+                           &cache_expire_sysdb, &cache_expire_ts);
+    assert_int_equal(cache_expire_sysdb, 1);
+    assert_int_equal(cache_expire_ts, 1);
+
+    get_gr_timestamp_attrs(test_ctx, TEST_GROUP_NAME_2,
+                           &cache_expire_sysdb, &cache_expire_ts);
+    assert_int_equal(cache_expire_sysdb, 1);
+    assert_int_equal(cache_expire_ts, 1);
+
+    /* The user was not in the list */
+    get_pw_timestamp_attrs(test_ctx, TEST_USER_NAME,
+                           &cache_expire_sysdb, &cache_expire_ts);
+    assert_int_equal(cache_expire_sysdb, TEST_CACHE_TIMEOUT + TEST_NOW_1);
+    assert_int_equal(cache_expire_ts, TEST_CACHE_TIMEOUT + TEST_NOW_1);
+
+    /* Nothing to do is not an error */
+    ret = sysdb_invalidate_cache_entries(test_ctx->tctx->dom, NULL, 0, attrs);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(attrs);
+}
+
+static void test_sysdb_cache_generation(void **state)
+{
+    int ret;
+    struct sysdb_ts_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                     struct sysdb_ts_test_ctx);
+    struct ldb_result *res;
+    uint32_t generation;
+
+    /* Nothing is stale before the first bump */
+    ret = sysdb_get_cache_generation(test_ctx->tctx->dom, &generation);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(generation, 0);
+
+    ret = sysdb_store_user(test_ctx->tctx->dom, TEST_USER_NAME, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_NAME,
+                           "/home/"TEST_USER_NAME, "/bin/bash", NULL,
+                           NULL, NULL, TEST_CACHE_TIMEOUT, TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    res = sysdb_getpwnam_res(test_ctx, test_ctx->tctx->dom, TEST_USER_NAME);
+    assert_int_equal(res->count, 1);
+    assert_false(sysdb_cache_generation_is_stale(res->msgs[0],
+                                                 SYSDB_CACHE_EXPIRE,
+                                                 generation));
+    talloc_free(res);
+
+    ret = sysdb_bump_cache_generation(test_ctx->tctx->dom, &generation);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(generation, 1);
+
+    ret = sysdb_get_cache_generation(test_ctx->tctx->dom, &generation);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(generation, 1);
+
+    /* The user was written before the bump */
+    res = sysdb_getpwnam_res(test_ctx, test_ctx->tctx->dom, TEST_USER_NAME);
+    assert_int_equal(res->count, 1);
+    assert_true(sysdb_cache_generation_is_stale(res->msgs[0],
+                                                SYSDB_CACHE_EXPIRE,
+                                                generation));
+    talloc_free(res);
+
+    /* Storing the same user again only updates the timestamp cache, which
+     * gets the new generation */
+    ret = sysdb_store_user(test_ctx->tctx->dom, TEST_USER_NAME, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_NAME,
+                           "/home/"TEST_USER_NAME, "/bin/bash", NULL,
+                           NULL, NULL, TEST_CACHE_TIMEOUT, TEST_NOW_2);
+    assert_int_equal(ret, EOK);
+
+    res = sysdb_getpwnam_res(test_ctx, test_ctx->tctx->dom, TEST_USER_NAME);
+    assert_int_equal(res->count, 1);
+    assert_false(sysdb_cache_generation_is_stale(res->msgs[0],
+                                                 SYSDB_CACHE_EXPIRE,
+                                                 generation));
+    /* The group memberships were not refreshed */
+    assert_true(sysdb_cache_generation_is_stale(res->msgs[0],
+                                                SYSDB_INITGR_EXPIRE,
+                                                generation));
+    talloc_free(res);
+
+    ret = sysdb_set_initgr_expire_timestamp(test_ctx->tctx->dom,
+                                            TEST_USER_NAME);
+    assert_int_equal(ret, EOK);
+
+    res = sysdb_getpwnam_res(test_ctx, test_ctx->tctx->dom, TEST_USER_NAME);
+    assert_int_equal(res->count, 1);
+    assert_false(sysdb_cache_generation_is_stale(res->msgs[0],
+                                                 SYSDB_INITGR_EXPIRE,
+                                                 generation));
+    talloc_free(res);
+
+    ret = sysdb_bump_cache_generation(test_ctx->tctx->dom, &generation);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(generation, 2);
+}
+
+static void test_sysdb_export_import(void **state)
+{
+    int ret;
+    struct sysdb_ts_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                     struct sysdb_ts_test_ctx);
+    const char *attrs[] = { SYSDB_MEMBER, SYSDB_GIDNUM, NULL };
+    struct ldb_message *msg;
+    struct ldb_result *res;
+    size_t count;
+    FILE *f;
+
+    ret = sysdb_store_user(test_ctx->tctx->dom, TEST_USER_NAME, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_NAME,
+                           "/home/"TEST_USER_NAME, "/bin/bash", NULL,
+                           NULL, NULL, TEST_CACHE_TIMEOUT, TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_group(test_ctx->tctx->dom, TEST_GROUP_NAME,
+                            TEST_GROUP_GID, NULL, TEST_CACHE_TIMEOUT,
+                            TEST_NOW_1);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_group_member(test_ctx->tctx->dom, TEST_GROUP_NAME,
+                                 TEST_USER_NAME, SYSDB_MEMBER_USER, false);
+    assert_int_equal(ret, EOK);
+
+    f = tmpfile();
+    assert_non_null(f);
+
+    ret = sysdb_export_domain(test_ctx->tctx->dom, false, f, &count);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count, 2);
+
+    ret = sysdb_delete_user(test_ctx->tctx->dom, TEST_USER_NAME, 0);
+    assert_int_equal(ret, EOK);
+    ret = sysdb_delete_group(test_ctx->tctx->dom, TEST_GROUP_NAME, 0);
+    assert_int_equal(ret, EOK);
+
+    rewind(f);
+    ret = sysdb_import_domain(test_ctx->tctx->dom, f, &count);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count, 2);
+    fclose(f);
+
+    res = sysdb_getpwnam_res(test_ctx, test_ctx->tctx->dom, TEST_USER_NAME);
+    assert_int_equal(res->count, 1);
+    assert_int_equal(ldb_msg_find_attr_as_uint(res->msgs[0], SYSDB_UIDNUM, 0),
+                     TEST_USER_UID);
+    talloc_free(res);
+
+    /* The membership is restored once both objects are stored */
+    ret = sysdb_search_group_by_name(test_ctx, test_ctx->tctx->dom,
+                                     TEST_GROUP_NAME, attrs, &msg);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(ldb_msg_find_attr_as_uint(msg, SYSDB_GIDNUM, 0),
+                     TEST_GROUP_GID);
+    assert_non_null(ldb_msg_find_element(msg, SYSDB_MEMBER));
+    assert_int_equal(ldb_msg_find_element(msg, SYSDB_MEMBER)->num_values, 1);
+    talloc_free(msg);
+}
+
 static void test_sysdb_user_delete(void **state)
 {
     int ret;
@@ -1423,6 +1776,7 @@ static void test_sysdb_search_with_ts(void **state)
                             SYSDB_GIDNUM,
                             SYSDB_CACHE_EXPIRE,
                             NULL };
+    const char *name_attrs[] = { SYSDB_NAME, NULL };
     struct sysdb_attrs *group_attrs = NULL;
     char *filter;
     uint64_t cache_expire_sysdb;
@@ -1600,9 +1954,41 @@ static void test_sysdb_search_with_ts(void **state)
                                     filter,
                                     attrs,
                                     &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 2);
+
+    /* Both entries carry the timestamps of the ts cache, no matter in which
+     * cache they matched */
+    for (count = 0; count < res->count; count++) {
+        if (ldb_msg_find_attr_as_uint64(res->msgs[count], SYSDB_GIDNUM, 0)
+                == TEST_GROUP_GID) {
+            assert_int_equal(TEST_CACHE_TIMEOUT + TEST_NOW_3,
+                             ldb_msg_find_attr_as_uint64(res->msgs[count],
+                                                         SYSDB_CACHE_EXPIRE,
+                                                         0));
+        } else {
+            assert_int_equal(TEST_CACHE_TIMEOUT + TEST_NOW_4,
+                             ldb_msg_find_attr_as_uint64(res->msgs[count],
+                                                         SYSDB_CACHE_EXPIRE,
+                                                         0));
+        }
+    }
+    talloc_free(res);
+
+    /* Timestamps that were not requested are not merged */
+    ret = sysdb_search_with_ts_attr(test_ctx,
+                                    test_ctx->tctx->dom,
+                                    base_dn,
+                                    LDB_SCOPE_SUBTREE,
+                                    SYSDB_CACHE_TYPE_NONE,
+                                    filter,
+                                    name_attrs,
+                                    &res);
     talloc_zfree(filter);
     assert_int_equal(ret, EOK);
     assert_int_equal(res->count, 2);
+    assert_null(ldb_msg_find_element(res->msgs[0], SYSDB_CACHE_EXPIRE));
+    assert_null(ldb_msg_find_element(res->msgs[1], SYSDB_CACHE_EXPIRE));
     talloc_free(res);
 }
 
@@ -1627,6 +2013,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sysdb_group_delete,
                                         test_sysdb_ts_setup,
                                         test_sysdb_ts_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_expire_notify,
+                                        test_sysdb_ts_setup,
+                                        test_sysdb_ts_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_group_rename,
                                         test_sysdb_ts_setup,
                                         test_sysdb_ts_teardown),
@@ -1639,9 +2028,21 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_merge_ldb_results,
                                         test_sysdb_ts_setup,
                                         test_sysdb_ts_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_search_merges_many,
+                                        test_sysdb_ts_setup,
+                                        test_sysdb_ts_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_user_update,
                                         test_sysdb_ts_setup,
                                         test_sysdb_ts_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_invalidate_cache_entries,
+                                        test_sysdb_ts_setup,
+                                        test_sysdb_ts_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_cache_generation,
+                                        test_sysdb_ts_setup,
+                                        test_sysdb_ts_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_export_import,
+                                        test_sysdb_ts_setup,
+                                        test_sysdb_ts_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_user_delete,
                                         test_sysdb_ts_setup,
                                         test_sysdb_ts_teardown),
@@ -346,6 +346,96 @@ void test_sysdb_add_overrides_to_object_missing_overridedn(void **state)
     assert_int_equal(ret, ENOENT);
 }
 
+static const char *
+add_overrides_get_gecos(struct sysdb_test_ctx *test_ctx, const char *name)
+{
+    int ret;
+    struct ldb_message *msg;
+    const char *attrs[] = { SYSDB_NAME, SYSDB_GECOS, SYSDB_LAST_UPDATE,
+                            SYSDB_OVERRIDE_DN, NULL };
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                    attrs, &msg);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_overrides_to_object(test_ctx->domain, msg, NULL, NULL);
+    assert_int_equal(ret, EOK);
+
+    return ldb_msg_find_attr_as_string(msg, OVERRIDE_PREFIX SYSDB_GECOS, NULL);
+}
+
+void test_sysdb_add_overrides_to_object_cached(void **state)
+{
+    int ret;
+    struct ldb_message *msg;
+    struct sysdb_attrs *attrs;
+    char *name;
+    time_t now;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    test_ctx->domain->mpg_mode = MPG_DISABLED;
+    test_ctx->domain->view_name = TEST_VIEW_NAME;
+    name = sss_create_internal_fqname(test_ctx, TEST_USER_NAME,
+                                      test_ctx->domain->name);
+    assert_non_null(name);
+
+    /* Overrides of objects updated in the current second are not cached */
+    now = time(NULL);
+    ret = sysdb_store_user(test_ctx->domain, name, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_GECOS,
+                           TEST_USER_HOMEDIR, TEST_USER_SHELL, NULL, NULL, NULL,
+                           0, now - 10);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                    NULL, &msg);
+    assert_int_equal(ret, EOK);
+
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+    ret = sysdb_attrs_add_string(attrs, SYSDB_OVERRIDE_ANCHOR_UUID,
+                                 TEST_ANCHOR_PREFIX TEST_USER_SID);
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string(attrs, SYSDB_GECOS, "first gecos");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_override(test_ctx->domain, TEST_VIEW_NAME,
+                               SYSDB_MEMBER_USER, attrs, msg->dn);
+    assert_int_equal(ret, EOK);
+
+    /* Read from the cache and then from memory */
+    assert_string_equal(add_overrides_get_gecos(test_ctx, name),
+                        "first gecos");
+    assert_string_equal(add_overrides_get_gecos(test_ctx, name),
+                        "first gecos");
+
+    /* Overrides are stored together with the original object */
+    talloc_free(attrs);
+    attrs = sysdb_new_attrs(test_ctx);
+    assert_non_null(attrs);
+    ret = sysdb_attrs_add_string(attrs, SYSDB_OVERRIDE_ANCHOR_UUID,
+                                 TEST_ANCHOR_PREFIX TEST_USER_SID);
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string(attrs, SYSDB_GECOS, "second gecos");
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_override(test_ctx->domain, TEST_VIEW_NAME,
+                               SYSDB_MEMBER_USER, attrs, msg->dn);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_user(test_ctx->domain, name, NULL,
+                           TEST_USER_UID, TEST_USER_GID, TEST_USER_GECOS,
+                           TEST_USER_HOMEDIR, TEST_USER_SHELL, NULL, NULL, NULL,
+                           0, now - 5);
+    assert_int_equal(ret, EOK);
+
+    assert_string_equal(add_overrides_get_gecos(test_ctx, name),
+                        "second gecos");
+
+    talloc_free(attrs);
+}
+
 void test_split_ipa_anchor(void **state)
 {
     int ret;
@@ -715,6 +805,42 @@ static void test_sysdb_enumpwent_views(void **state)
     check_enumpwent(ret, test_ctx->domain, res, true);
 }
 
+static void test_sysdb_enumpwent_names(void **state)
+{
+    int ret;
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                        struct sysdb_test_ctx);
+    struct ldb_result *names;
+    struct ldb_result *res;
+
+    ret = sysdb_enumpwent_names(test_ctx, test_ctx->domain, &names);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(names->count, N_ELEMENTS(users)-1);
+    assert_null(ldb_msg_find_element(names->msgs[0], SYSDB_GECOS));
+
+    /* Load the complete entries in two chunks */
+    ret = sysdb_enum_load_users(test_ctx, test_ctx->domain, names->msgs, 1,
+                                &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    assert_string_equal(ldb_msg_find_attr_as_string(res->msgs[0],
+                                                    SYSDB_NAME, NULL),
+                        ldb_msg_find_attr_as_string(names->msgs[0],
+                                                    SYSDB_NAME, NULL));
+    talloc_free(res);
+
+    ret = sysdb_enum_load_users(test_ctx, test_ctx->domain, names->msgs + 1,
+                                names->count - 1, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, names->count - 1);
+    talloc_free(res);
+
+    ret = sysdb_enum_load_users(test_ctx, test_ctx->domain, names->msgs,
+                                names->count, &res);
+    check_enumpwent(ret, test_ctx->domain, res, true);
+    talloc_free(names);
+}
+
 static void test_sysdb_enumpwent_filter(void **state)
 {
     int ret;
@@ -1069,6 +1195,8 @@ int main(int argc, const char *argv[])
                                         test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_add_overrides_to_object_missing_overridedn,
                                         test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_add_overrides_to_object_cached,
+                                        test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_split_ipa_anchor,
                                         test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_delete_view_tree,
@@ -1081,6 +1209,9 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_views,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_names,
+                                        test_enum_users_setup,
+                                        test_enum_users_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_enumpwent_filter,
                                         test_enum_users_setup,
                                         test_enum_users_teardown),
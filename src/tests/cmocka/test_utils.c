@@ -1737,6 +1737,24 @@ static void test_parse_cert_verify_opts(void **state)
     assert_null(cv_opts->ocsp_default_responder_signing_cert);
     assert_string_equal(cv_opts->crl_file, "hij");
     talloc_free(cv_opts);
+
+    ret = parse_cert_verify_opts(global_talloc_context,
+                                 "ocsp_cache_dir=/var/lib/sss/ocsp",
+                                 &cv_opts);
+    assert_int_equal(ret, EOK);
+    assert_true(cv_opts->do_ocsp);
+#ifdef HAVE_NSS
+    assert_null(cv_opts->ocsp_cache_dir);
+#else
+    assert_string_equal(cv_opts->ocsp_cache_dir, "/var/lib/sss/ocsp");
+#endif
+    talloc_free(cv_opts);
+
+#ifndef HAVE_NSS
+    ret = parse_cert_verify_opts(global_talloc_context, "ocsp_cache_dir=",
+                                 &cv_opts);
+    assert_int_equal(ret, EINVAL);
+#endif
 }
 
 static void assert_parse_fqname(const char *fqname,
@@ -2064,6 +2082,32 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sss_ptr_hash_without_cb,
                                         setup_leak_tests,
                                         teardown_leak_tests),
+        cmocka_unit_test_setup_teardown(test_sss_str_intern,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
+        cmocka_unit_test_setup_teardown(test_sss_hash_map,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
+        cmocka_unit_test_setup_teardown(test_sss_budget_exhausted,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
+        cmocka_unit_test_setup_teardown(test_sss_budget_yield,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
+        /* Tracing stays enabled once it is started. */
+        cmocka_unit_test_setup_teardown(test_sss_trace,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
+        cmocka_unit_test_setup_teardown(test_sss_metrics,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
+        cmocka_unit_test_setup_teardown(test_sss_memfd,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
+        /* Statistics stay enabled once they are started. */
+        cmocka_unit_test_setup_teardown(test_sss_loop_stats,
+                                        setup_leak_tests,
+                                        teardown_leak_tests),
     };
 
     /* Set debug level to invalid value so we can decide if -d 0 was used. */
@@ -38,5 +38,27 @@ void test_sss_ptr_hash_with_free_cb(void **state);
 void test_sss_ptr_hash_with_lookup_cb(void **state);
 void test_sss_ptr_hash_without_cb(void **state);
 
+/* from src/tests/cmocka/test_sss_str_intern.c */
+void test_sss_str_intern(void **state);
+
+/* from src/tests/cmocka/test_sss_hash_map.c */
+void test_sss_hash_map(void **state);
+
+/* from src/tests/cmocka/test_sss_budget.c */
+void test_sss_budget_exhausted(void **state);
+void test_sss_budget_yield(void **state);
+
+/* from src/tests/cmocka/test_sss_trace.c */
+void test_sss_trace(void **state);
+
+/* from src/tests/cmocka/test_sss_metrics.c */
+void test_sss_metrics(void **state);
+
+/* from src/tests/cmocka/test_sss_memfd.c */
+void test_sss_memfd(void **state);
+
+/* from src/tests/cmocka/test_sss_loop_stats.c */
+void test_sss_loop_stats(void **state);
+
 
 #endif /* __TESTS__CMOCKA__TEST_UTILS_H__ */
@@ -674,6 +674,145 @@ START_TEST(test_debug_is_set_false)
 }
 END_TEST
 
+START_TEST(test_debug_async_writer)
+{
+    char filename[24] = {'\0'};
+    char line[128];
+    char *expected;
+    mode_t old_umask;
+    FILE *file;
+    int fd;
+    int ret;
+    int i;
+
+    debug_timestamps = 0;
+    debug_microseconds = 0;
+    debug_to_file = 1;
+    debug_prg_name = "sssd";
+    debug_level = SSSDBG_MASK_ALL;
+    sss_set_logger(sss_logger_str[FILES_LOGGER]);
+
+    strncpy(filename, "sssd_debug_tests.XXXXXX", 24);
+
+    old_umask = umask(SSS_DFL_UMASK);
+    fd = mkstemp(filename);
+    umask(old_umask);
+    fail_if(fd == -1, "mkstemp failed");
+
+    file = fdopen(fd, "r");
+    fail_if(file == NULL, "fdopen failed");
+
+    ret = set_debug_file_from_fd(fd);
+    fail_unless(ret == EOK, "set_debug_file_from_fd failed");
+
+    ret = debug_start_async_writer();
+    fail_unless(ret == EOK, "debug_start_async_writer failed");
+
+    for (i = 0; i < 1000; i++) {
+        DEBUG(SSSDBG_TRACE_FUNC, "message %d\n", i);
+    }
+
+    /* All queued messages are written before the writer stops */
+    debug_stop_async_writer();
+
+    rewind(file);
+    for (i = 0; i < 1000; i++) {
+        fail_if(fgets(line, sizeof(line), file) == NULL,
+                "Message %d is missing", i);
+
+        expected = talloc_asprintf(NULL, "[sssd] [%s] (%#.4x): message %d\n",
+                                   __FUNCTION__, SSSDBG_TRACE_FUNC, i);
+        fail_if(expected == NULL, "talloc_asprintf failed");
+        ck_assert_str_eq(line, expected);
+        talloc_free(expected);
+    }
+    fail_unless(fgets(line, sizeof(line), file) == NULL,
+                "Unexpected line %s", line);
+
+    fclose(file);
+    remove(filename);
+}
+END_TEST
+
+START_TEST(test_debug_backtrace)
+{
+    char filename[24] = {'\0'};
+    char line[256];
+    char *expected;
+    mode_t old_umask;
+    FILE *file;
+    int fd;
+    int ret;
+    size_t i;
+    const char *hidden = "[sssd] [%s] (%#.4x): hidden\n";
+    int expected_levels[] = {
+        SSSDBG_TRACE_FUNC,
+        SSSDBG_CONF_SETTINGS,
+    };
+
+    debug_timestamps = 0;
+    debug_microseconds = 0;
+    debug_to_file = 1;
+    debug_prg_name = "sssd";
+    debug_level = SSSDBG_FATAL_FAILURE | SSSDBG_CRIT_FAILURE;
+    debug_backtrace_enabled = true;
+    sss_set_logger(sss_logger_str[FILES_LOGGER]);
+
+    strncpy(filename, "sssd_debug_tests.XXXXXX", 24);
+
+    old_umask = umask(SSS_DFL_UMASK);
+    fd = mkstemp(filename);
+    umask(old_umask);
+    fail_if(fd == -1, "mkstemp failed");
+
+    file = fdopen(fd, "r");
+    fail_if(file == NULL, "fdopen failed");
+
+    ret = set_debug_file_from_fd(fd);
+    fail_unless(ret == EOK, "set_debug_file_from_fd failed");
+
+    DEBUG(SSSDBG_TRACE_FUNC, "hidden\n");
+    /* Too verbose to be kept */
+    DEBUG(SSSDBG_TRACE_ALL, "hidden\n");
+    DEBUG(SSSDBG_CONF_SETTINGS, "hidden\n");
+    DEBUG(SSSDBG_CRIT_FAILURE, "failure\n");
+    /* The backtrace was already written */
+    DEBUG(SSSDBG_CRIT_FAILURE, "failure\n");
+
+    rewind(file);
+
+    fail_if(fgets(line, sizeof(line), file) == NULL, "Dump begin missing");
+    fail_if(strstr(line, "BACKTRACE DUMP BEGINS") == NULL,
+            "Unexpected line %s", line);
+
+    for (i = 0; i < N_ELEMENTS(expected_levels); i++) {
+        fail_if(fgets(line, sizeof(line), file) == NULL,
+                "Message %zu is missing", i);
+        expected = talloc_asprintf(NULL, hidden, __FUNCTION__,
+                                   expected_levels[i]);
+        fail_if(expected == NULL, "talloc_asprintf failed");
+        ck_assert_str_eq(line, expected);
+        talloc_free(expected);
+    }
+
+    fail_if(fgets(line, sizeof(line), file) == NULL, "Dump end missing");
+    fail_if(strstr(line, "BACKTRACE DUMP ENDS") == NULL,
+            "Unexpected line %s", line);
+
+    for (i = 0; i < 2; i++) {
+        fail_if(fgets(line, sizeof(line), file) == NULL,
+                "Failure %zu is missing", i);
+        fail_if(strstr(line, "failure") == NULL, "Unexpected line %s", line);
+    }
+    fail_unless(fgets(line, sizeof(line), file) == NULL,
+                "Unexpected line %s", line);
+
+    debug_backtrace_enabled = false;
+    fclose(file);
+    remove(filename);
+}
+END_TEST
+
 Suite *debug_suite(void)
 {
     Suite *s = suite_create("debug");
@@ -690,6 +829,8 @@ Suite *debug_suite(void)
     tcase_add_test(tc_debug, test_debug_is_notset_timestamp_microseconds);
     tcase_add_test(tc_debug, test_debug_is_set_true);
     tcase_add_test(tc_debug, test_debug_is_set_false);
+    tcase_add_test(tc_debug, test_debug_async_writer);
+    tcase_add_test(tc_debug, test_debug_backtrace);
     tcase_set_timeout(tc_debug, 60);
 
     suite_add_tcase(s, tc_debug);
@@ -150,6 +150,7 @@ test_resolve_service_callback(struct tevent_req *req)
     struct fo_server *server = NULL;
     struct fo_server *active_server = NULL;
     struct resolv_hostent *he;
+    char *tls_session;
     int i;
 
     task = tevent_req_callback_data(req, struct task);
@@ -167,6 +168,15 @@ test_resolve_service_callback(struct tevent_req *req)
     fail_if(port != task->port, "%s: Expected port %d, got %d", task->location,
             task->port, port);
 
+    /* The TLS session is owned by the server and replaced on update */
+    tls_session = talloc_strdup(NULL, task->location);
+    fail_if(tls_session == NULL);
+    fo_set_server_tls_session(server, tls_session);
+    fail_if(fo_get_server_tls_session(server) != tls_session,
+            "%s: Unexpected TLS session", task->location);
+    fail_if(talloc_parent(tls_session) != server,
+            "%s: TLS session is not owned by the server", task->location);
+
     if (task->new_port_status >= 0)
         fo_set_port_status(server, task->new_port_status);
     if (task->new_server_status >= 0)
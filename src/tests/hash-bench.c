@@ -0,0 +1,344 @@
+/*
+   SSSD
+
+   Hash table benchmark
+
+   Compares dhash, sss_ptr_hash and sss_hash_map on the operations that
+   the internal tables use: inserting DN like keys, looking up present
+   and missing keys and deleting them. The number of talloc blocks that
+   the table holds after all keys were inserted is printed as well.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <talloc.h>
+#include <popt.h>
+#include <time.h>
+#include <dhash.h>
+
+#include "util/util.h"
+#include "util/sss_ptr_hash.h"
+#include "util/sss_hash_map.h"
+
+#define DEFAULT_ENTRIES 100000
+#define DEFAULT_ROUNDS  5
+
+struct bench_value {
+    size_t index;
+};
+
+struct bench_table_ops {
+    const char *name;
+    void *(*create)(TALLOC_CTX *mem_ctx);
+    errno_t (*add)(void *table, const char *key, struct bench_value *value);
+    struct bench_value *(*lookup)(void *table, const char *key);
+    void (*del)(void *table, const char *key);
+};
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* dhash */
+
+static void *bench_dhash_create(TALLOC_CTX *mem_ctx)
+{
+    hash_table_t *table;
+    errno_t ret;
+
+    ret = sss_hash_create(mem_ctx, 0, &table);
+    return ret == EOK ? table : NULL;
+}
+
+static errno_t bench_dhash_add(void *table, const char *key,
+                               struct bench_value *value)
+{
+    hash_key_t hkey;
+    hash_value_t hvalue;
+
+    hkey.type = HASH_KEY_STRING;
+    hkey.str = discard_const(key);
+    hvalue.type = HASH_VALUE_PTR;
+    hvalue.ptr = value;
+
+    return hash_enter(table, &hkey, &hvalue) == HASH_SUCCESS ? EOK : EIO;
+}
+
+static struct bench_value *bench_dhash_lookup(void *table, const char *key)
+{
+    hash_key_t hkey;
+    hash_value_t hvalue;
+
+    hkey.type = HASH_KEY_STRING;
+    hkey.str = discard_const(key);
+
+    if (hash_lookup(table, &hkey, &hvalue) != HASH_SUCCESS) {
+        return NULL;
+    }
+
+    return hvalue.ptr;
+}
+
+static void bench_dhash_del(void *table, const char *key)
+{
+    hash_key_t hkey;
+
+    hkey.type = HASH_KEY_STRING;
+    hkey.str = discard_const(key);
+
+    hash_delete(table, &hkey);
+}
+
+/* sss_ptr_hash */
+
+static void *bench_ptr_hash_create(TALLOC_CTX *mem_ctx)
+{
+    return sss_ptr_hash_create(mem_ctx, NULL, NULL);
+}
+
+static errno_t bench_ptr_hash_add(void *table, const char *key,
+                                  struct bench_value *value)
+{
+    return sss_ptr_hash_add(table, key, value, struct bench_value);
+}
+
+static struct bench_value *bench_ptr_hash_lookup(void *table, const char *key)
+{
+    return sss_ptr_hash_lookup(table, key, struct bench_value);
+}
+
+static void bench_ptr_hash_del(void *table, const char *key)
+{
+    sss_ptr_hash_delete(table, key, false);
+}
+
+/* sss_hash_map */
+
+SSS_HASH_MAP_TYPED(bench_map, struct bench_value)
+
+static void *bench_map_create(TALLOC_CTX *mem_ctx)
+{
+    return sss_hash_map_create(mem_ctx, 0);
+}
+
+static errno_t bench_map_add_value(void *table, const char *key,
+                                   struct bench_value *value)
+{
+    return bench_map_add(table, key, value);
+}
+
+static struct bench_value *bench_map_lookup_value(void *table,
+                                                  const char *key)
+{
+    return bench_map_lookup(table, key);
+}
+
+static void bench_map_del(void *table, const char *key)
+{
+    bench_map_delete(table, key);
+}
+
+static const struct bench_table_ops bench_tables[] = {
+    { "dhash", bench_dhash_create, bench_dhash_add,
+      bench_dhash_lookup, bench_dhash_del },
+    { "ptr_hash", bench_ptr_hash_create, bench_ptr_hash_add,
+      bench_ptr_hash_lookup, bench_ptr_hash_del },
+    { "hash_map", bench_map_create, bench_map_add_value,
+      bench_map_lookup_value, bench_map_del },
+    { NULL, NULL, NULL, NULL, NULL }
+};
+
+struct bench_times {
+    uint64_t add;
+    uint64_t hit;
+    uint64_t miss;
+    uint64_t del;
+    size_t blocks;
+};
+
+static errno_t bench_table(TALLOC_CTX *mem_ctx,
+                           const struct bench_table_ops *ops,
+                           const char **keys,
+                           const char **missing,
+                           struct bench_value **values,
+                           size_t entries,
+                           struct bench_times *times)
+{
+    struct bench_value *value;
+    void *table;
+    uint64_t start;
+    errno_t ret;
+    size_t i;
+
+    table = ops->create(mem_ctx);
+    if (table == NULL) {
+        return ENOMEM;
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < entries; i++) {
+        ret = ops->add(table, keys[i], values[i]);
+        if (ret != EOK) {
+            fprintf(stderr, "%s: unable to add %s\n", ops->name, keys[i]);
+            goto done;
+        }
+    }
+    times->add += bench_now_ns() - start;
+
+    times->blocks = talloc_total_blocks(table);
+
+    start = bench_now_ns();
+    for (i = 0; i < entries; i++) {
+        value = ops->lookup(table, keys[i]);
+        if (value == NULL || value->index != i) {
+            fprintf(stderr, "%s: %s not found\n", ops->name, keys[i]);
+            ret = EINVAL;
+            goto done;
+        }
+    }
+    times->hit += bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for (i = 0; i < entries; i++) {
+        if (ops->lookup(table, missing[i]) != NULL) {
+            fprintf(stderr, "%s: %s found\n", ops->name, missing[i]);
+            ret = EINVAL;
+            goto done;
+        }
+    }
+    times->miss += bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for (i = 0; i < entries; i++) {
+        ops->del(table, keys[i]);
+    }
+    times->del += bench_now_ns() - start;
+
+    ret = EOK;
+
+done:
+    talloc_free(table);
+    return ret;
+}
+
+static void bench_print(const char *name, const char *op,
+                        uint64_t ns, size_t ops)
+{
+    printf("%-10s %-8s %10zu %12.1f\n", name, op, ops, (double)ns / ops);
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int pc_entries = DEFAULT_ENTRIES;
+    int pc_rounds = DEFAULT_ROUNDS;
+    TALLOC_CTX *mem_ctx;
+    const char **keys;
+    const char **missing;
+    struct bench_value **values;
+    struct bench_times times;
+    size_t entries;
+    size_t ops;
+    errno_t ret = ENOMEM;
+    size_t i;
+    int j;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "entries", 'e', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_entries, 0,
+                    "Number of keys in the table", NULL },
+        { "rounds", 'r', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_rounds, 0,
+                    "How many times every table is filled", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                poptBadOption(pc, 0), poptStrerror(opt));
+        poptPrintUsage(pc, stderr, 0);
+        return 1;
+    }
+    poptFreeContext(pc);
+
+    if (pc_entries <= 0 || pc_rounds <= 0) {
+        fprintf(stderr, "Entries and rounds must be positive\n");
+        return 1;
+    }
+    entries = pc_entries;
+
+    mem_ctx = talloc_new(NULL);
+    if (mem_ctx == NULL) {
+        return 1;
+    }
+
+    keys = talloc_array(mem_ctx, const char *, entries);
+    missing = talloc_array(mem_ctx, const char *, entries);
+    values = talloc_array(mem_ctx, struct bench_value *, entries);
+    if (keys == NULL || missing == NULL || values == NULL) {
+        goto done;
+    }
+
+    for (i = 0; i < entries; i++) {
+        keys[i] = talloc_asprintf(keys,
+                                  "cn=group%zu,cn=groups,dc=example,dc=com",
+                                  i);
+        missing[i] = talloc_asprintf(missing,
+                                     "cn=user%zu,cn=users,dc=example,dc=com",
+                                     i);
+        values[i] = talloc_zero(values, struct bench_value);
+        if (keys[i] == NULL || missing[i] == NULL || values[i] == NULL) {
+            goto done;
+        }
+        values[i]->index = i;
+    }
+
+    printf("%-10s %-8s %10s %12s\n", "table", "op", "ops", "ns/op");
+
+    for (i = 0; bench_tables[i].name != NULL; i++) {
+        memset(&times, 0, sizeof(times));
+
+        for (j = 0; j < pc_rounds; j++) {
+            ret = bench_table(mem_ctx, &bench_tables[i], keys, missing,
+                              values, entries, &times);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        ops = entries * pc_rounds;
+        bench_print(bench_tables[i].name, "add", times.add, ops);
+        bench_print(bench_tables[i].name, "hit", times.hit, ops);
+        bench_print(bench_tables[i].name, "miss", times.miss, ops);
+        bench_print(bench_tables[i].name, "delete", times.del, ops);
+        printf("%-10s %-8s %10zu %12.2f\n", bench_tables[i].name, "blocks",
+               times.blocks, (double)times.blocks / entries);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(mem_ctx);
+    return ret == EOK ? 0 : 1;
+}
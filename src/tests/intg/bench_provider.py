@@ -0,0 +1,303 @@
+#
+# Benchmark of the LDAP provider against a generated directory
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Not collected by "make intgcheck", run it with "make intgbench". The
+# directory is described by $SSS_GEN_ARGS (see ldap_gen.py --help), the
+# results are written as JSON to $PROVIDER_BENCH_OUTPUT.
+#
+import grp
+import json
+import os
+import pwd
+import random
+import shlex
+import signal
+import stat
+import subprocess
+import time
+
+import config
+import ds_openldap
+import ldb
+import ldap_gen
+import pytest
+import sssd_id
+from sssd_nss import NssReturnCode
+from util import unindent
+
+LDAP_BASE_DN = "dc=example,dc=com"
+
+DEFAULT_GEN_ARGS = ["--users=5000", "--groups=500", "--depth=4",
+                    "--memberships=5", "--distribution=zipf"]
+
+# Number of users used for the per-user lookups
+SAMPLE_SIZE = 200
+
+# Enumeration and cleanup are waited for at most this long
+WAIT_TIMEOUT = 600
+
+RESULTS = {}
+
+
+def timed(func, *args):
+    start = time.time()
+    res = func(*args)
+    return time.time() - start, res
+
+
+def summary(samples):
+    """Summarize a list of durations in seconds"""
+    samples = sorted(samples)
+    count = len(samples)
+
+    def pct(p):
+        return samples[min(int(count * p), count - 1)]
+    return dict(count=count, total=sum(samples),
+                mean=sum(samples) / count,
+                p50=pct(0.5), p90=pct(0.9), p99=pct(0.99),
+                max=samples[-1])
+
+
+@pytest.fixture(scope="module")
+def dataset():
+    argv = shlex.split(os.environ.get("SSS_GEN_ARGS", ""))
+    return ldap_gen.dataset_from_args(DEFAULT_GEN_ARGS + argv)
+
+
+@pytest.fixture(scope="module")
+def sample(dataset):
+    rnd = random.Random(dataset.seed)
+    return rnd.sample(dataset.user_names,
+                      min(SAMPLE_SIZE, len(dataset.user_names)))
+
+
+@pytest.fixture(scope="module")
+def results(request, dataset):
+    """Collect the results and write them out when the module is done"""
+    RESULTS.clear()
+    RESULTS["dataset"] = dataset.describe()
+
+    def write():
+        output = os.environ.get("PROVIDER_BENCH_OUTPUT") or \
+            "provider-bench.json"
+        with open(output, "w") as f:
+            json.dump(RESULTS, f, indent=4, sort_keys=True)
+    request.addfinalizer(write)
+    return RESULTS
+
+
+@pytest.fixture(scope="module")
+def ds_inst(request):
+    """LDAP server instance fixture"""
+    ds_inst = ds_openldap.DSOpenLDAP(
+        config.PREFIX, 10389, LDAP_BASE_DN,
+        "cn=admin", "Secret123")
+    try:
+        ds_inst.setup()
+    except:
+        ds_inst.teardown()
+        raise
+    request.addfinalizer(lambda: ds_inst.teardown())
+    return ds_inst
+
+
+@pytest.fixture(scope="module")
+def ldap_conn(request, ds_inst, dataset, results):
+    """LDAP server connection fixture loaded with the dataset"""
+    ldap_conn = ds_inst.bind()
+    ldap_conn.ds_inst = ds_inst
+    request.addfinalizer(lambda: ldap_conn.unbind_s())
+
+    ent_list = dataset.ent_list(ds_inst.base_dn)
+    elapsed, _ = timed(lambda: [ldap_conn.add_s(dn, attrs)
+                                for dn, attrs in ent_list])
+    results["load_seconds"] = elapsed
+    return ldap_conn
+
+
+def format_conf(ldap_conn, dataset, extra=""):
+    schema_conf = "ldap_schema         = " + dataset.schema + "\n"
+    if dataset.schema == ldap_gen.SCHEMA_RFC2307_BIS:
+        schema_conf += "ldap_group_object_class = groupOfNames\n"
+    return unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+        enable_files_domain = false
+
+        [nss]
+        memcache_timeout    = 0
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        {schema_conf}
+        id_provider         = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+        ldap_group_nesting_level = {depth}
+    """).format(depth=dataset.depth + 1, **locals()) + unindent(extra)
+
+
+def create_conf_fixture(request, contents):
+    """Generate sssd.conf and add teardown for removing it"""
+    conf = open(config.CONF_PATH, "w")
+    conf.write(contents)
+    conf.close()
+    os.chmod(config.CONF_PATH, stat.S_IRUSR | stat.S_IWUSR)
+    request.addfinalizer(lambda: os.unlink(config.CONF_PATH))
+
+
+def stop_sssd():
+    pid_file = open(config.PIDFILE_PATH, "r")
+    pid = int(pid_file.read())
+    os.kill(pid, signal.SIGTERM)
+    while True:
+        try:
+            os.kill(pid, signal.SIGCONT)
+        except:
+            break
+        time.sleep(1)
+
+
+def create_sssd_fixture(request):
+    """Start sssd and add teardown for stopping it and removing state"""
+    if subprocess.call(["sssd", "-D", "-f"]) != 0:
+        raise Exception("sssd start failed")
+
+    def teardown():
+        try:
+            stop_sssd()
+        except:
+            pass
+        for path in os.listdir(config.DB_PATH):
+            os.unlink(config.DB_PATH + "/" + path)
+        for path in os.listdir(config.MCACHE_PATH):
+            os.unlink(config.MCACHE_PATH + "/" + path)
+    request.addfinalizer(teardown)
+    return time.time()
+
+
+def cached_users():
+    """Return the number of users in the cache of the LDAP domain"""
+    cache = ldb.Ldb()
+    cache.connect(os.path.join(config.DB_PATH, "cache_LDAP.ldb"))
+    res = cache.search(base="cn=users,cn=LDAP,cn=sysdb",
+                       scope=ldb.SCOPE_ONELEVEL,
+                       expression="(objectCategory=user)", attrs=["name"])
+    return res.count
+
+
+def wait_for(check, timeout=WAIT_TIMEOUT):
+    """Poll check() until it is true, returns the time it took"""
+    start = time.time()
+    while not check():
+        assert time.time() - start < timeout, "timed out"
+        time.sleep(0.1)
+    return time.time() - start
+
+
+def initgroups(dataset, user):
+    res, errno, gids = sssd_id.call_sssd_initgroups(user,
+                                                    dataset.gid_start - 1)
+    assert res == NssReturnCode.SUCCESS, \
+        "initgroups of %s failed: %d" % (user, errno)
+    return gids
+
+
+def lookup_sample(dataset, sample):
+    """Time getpwnam and initgroups of every user of the sample"""
+    durations = []
+    for user in sample:
+        elapsed, _ = timed(pwd.getpwnam, user)
+        durations.append(elapsed)
+        elapsed, _ = timed(initgroups, dataset, user)
+        durations.append(elapsed)
+    return durations
+
+
+@pytest.fixture
+def bench_sssd(request, ldap_conn, dataset):
+    create_conf_fixture(request, format_conf(ldap_conn, dataset))
+    return create_sssd_fixture(request)
+
+
+def test_bench_initgroups(bench_sssd, dataset, sample, results):
+    durations = []
+    for user in sample:
+        elapsed, gids = timed(initgroups, dataset, user)
+        assert len(gids) > 1
+        durations.append(elapsed)
+    results["initgroups"] = summary(durations)
+
+
+def test_bench_nested_groups(bench_sssd, dataset, results):
+    durations = []
+    for group in dataset.top_groups():
+        elapsed, res = timed(grp.getgrnam, group)
+        assert len(res.gr_mem) > 0
+        durations.append(elapsed)
+    results["nested_groups"] = summary(durations)
+
+
+def test_bench_refresh(bench_sssd, dataset, sample, results):
+    cold = lookup_sample(dataset, sample)
+    warm = lookup_sample(dataset, sample)
+    subprocess.check_call(["sss_cache", "-E"])
+    expired = lookup_sample(dataset, sample)
+    results["refresh"] = dict(cold=summary(cold), warm=summary(warm),
+                              expired=summary(expired))
+
+
+@pytest.fixture
+def bench_enumeration(request, ldap_conn, dataset):
+    conf = format_conf(ldap_conn, dataset, """\
+        enumerate           = true
+        ldap_enumeration_refresh_timeout = {0}
+    """.format(WAIT_TIMEOUT))
+    create_conf_fixture(request, conf)
+    return create_sssd_fixture(request)
+
+
+def test_bench_enumeration(bench_enumeration, dataset, results):
+    def enumerated():
+        names = set(ent.pw_name for ent in pwd.getpwall())
+        return names.issuperset(dataset.user_names)
+
+    wait_for(enumerated)
+    # Measured from the start of sssd, so it includes the startup
+    results["enumeration"] = dict(seconds=time.time() - bench_enumeration)
+
+
+@pytest.fixture
+def bench_cleanup(request, ldap_conn, dataset):
+    conf = format_conf(ldap_conn, dataset, """\
+        entry_cache_timeout = 1
+        ldap_purge_cache_timeout = 1
+    """)
+    create_conf_fixture(request, conf)
+    return create_sssd_fixture(request)
+
+
+def test_bench_cleanup(bench_cleanup, dataset, sample, results):
+    lookup_sample(dataset, sample)
+    cached = cached_users()
+    assert cached >= len(sample)
+
+    # The cleanup task first runs ten seconds after the start and then
+    # every second, the wait for the first run is not counted
+    time.sleep(max(0, bench_cleanup + 10 - time.time()))
+    elapsed = wait_for(lambda: cached_users() == 0)
+    results["cleanup"] = dict(users=cached, seconds=elapsed)
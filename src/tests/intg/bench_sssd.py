@@ -0,0 +1,183 @@
+#
+# Benchmark of the NSS and PAM responders
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Not collected by "make intgcheck", run it with "make intgbench". The
+# results are written as JSON to $SSS_BENCH_OUTPUT, extra arguments of
+# sss-bench can be passed in $SSS_BENCH_ARGS.
+#
+import json
+import os
+import shlex
+import signal
+import stat
+import subprocess
+import time
+
+import config
+import ds_openldap
+import ldap_ent
+import pytest
+from util import unindent
+
+LDAP_BASE_DN = "dc=example,dc=com"
+
+BENCH_USERS = 1000
+BENCH_UID_START = 10001
+BENCH_BIG_GROUP_MEMBERS = 1000
+BENCH_PASSWORD = "Secret123"
+
+
+@pytest.fixture(scope="module")
+def ds_inst(request):
+    """LDAP server instance fixture"""
+    ds_inst = ds_openldap.DSOpenLDAP(
+        config.PREFIX, 10389, LDAP_BASE_DN,
+        "cn=admin", "Secret123")
+    try:
+        ds_inst.setup()
+    except:
+        ds_inst.teardown()
+        raise
+    request.addfinalizer(lambda: ds_inst.teardown())
+    return ds_inst
+
+
+@pytest.fixture(scope="module")
+def ldap_conn(request, ds_inst):
+    """LDAP server connection fixture"""
+    ldap_conn = ds_inst.bind()
+    ldap_conn.ds_inst = ds_inst
+    request.addfinalizer(lambda: ldap_conn.unbind_s())
+    return ldap_conn
+
+
+def create_ldap_fixture(request, ldap_conn, ent_list):
+    """Add LDAP entries and add teardown for removing them"""
+    for entry in ent_list:
+        ldap_conn.add_s(entry[0], entry[1])
+
+    def teardown():
+        for entry in ent_list:
+            ldap_conn.delete_s(entry[0])
+    request.addfinalizer(teardown)
+
+
+def create_conf_fixture(request, contents):
+    """Generate sssd.conf and add teardown for removing it"""
+    conf = open(config.CONF_PATH, "w")
+    conf.write(contents)
+    conf.close()
+    os.chmod(config.CONF_PATH, stat.S_IRUSR | stat.S_IWUSR)
+    request.addfinalizer(lambda: os.unlink(config.CONF_PATH))
+
+
+def stop_sssd():
+    pid_file = open(config.PIDFILE_PATH, "r")
+    pid = int(pid_file.read())
+    os.kill(pid, signal.SIGTERM)
+    while True:
+        try:
+            os.kill(pid, signal.SIGCONT)
+        except:
+            break
+        time.sleep(1)
+
+
+def create_sssd_fixture(request):
+    """Start sssd and add teardown for stopping it and removing state"""
+    if subprocess.call(["sssd", "-D", "-f"]) != 0:
+        raise Exception("sssd start failed")
+
+    def teardown():
+        try:
+            stop_sssd()
+        except:
+            pass
+        for path in os.listdir(config.DB_PATH):
+            os.unlink(config.DB_PATH + "/" + path)
+        for path in os.listdir(config.MCACHE_PATH):
+            os.unlink(config.MCACHE_PATH + "/" + path)
+    request.addfinalizer(teardown)
+
+
+@pytest.fixture
+def bench_rfc2307(request, ldap_conn):
+    ent_list = ldap_ent.List(ldap_conn.ds_inst.base_dn)
+    for i in range(1, BENCH_USERS + 1):
+        ent_list.add_user("user%d" % i, BENCH_UID_START + i - 1, 20000,
+                          userPassword=BENCH_PASSWORD)
+
+    ent_list.add_group("users", 20000)
+    for i in range(1, 11):
+        ent_list.add_group("group%d" % i, 20000 + i,
+                           ["user%d" % j for j in range(i, BENCH_USERS, 10)])
+    ent_list.add_group("biggroup", 30000,
+                       ["user%d" % j
+                        for j in range(1, BENCH_BIG_GROUP_MEMBERS + 1)])
+    create_ldap_fixture(request, ldap_conn, ent_list)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss, pam
+
+        [nss]
+
+        [pam]
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
+def test_bench(bench_rfc2307):
+    env = os.environ.copy()
+    env['PAM_WRAPPER'] = "1"
+    env['SSSD_INTG_PEER_UID'] = "0"
+    env['SSSD_INTG_PEER_GID'] = "0"
+    env['LD_PRELOAD'] += ':' + os.environ['PAM_WRAPPER_PATH']
+
+    output = os.environ.get("SSS_BENCH_OUTPUT") or "sss-bench.json"
+    args = [os.environ.get("SSS_BENCH") or "sss-bench",
+            "--threads=4", "--processes=2", "--duration=10",
+            "--workload=pwnam:35,pwuid:25,initgroups:20,grnam:15,pam:5",
+            "--phases=cold,warm,socket", "--cold-cmd=sss_cache -E",
+            "--prefix=user", "--start=1", "--stop=%d" % BENCH_USERS,
+            "--uid-start=%d" % BENCH_UID_START,
+            "--groups=biggroup,group1,group2,group3",
+            "--pam-service=pam_sss_service",
+            "--pam-password=" + BENCH_PASSWORD,
+            "--output=" + output]
+    args += shlex.split(os.environ.get("SSS_BENCH_ARGS", ""))
+
+    subprocess.check_call(args, env=env)
+
+    with open(output) as f:
+        results = json.load(f)
+
+    for phase in results["phases"]:
+        for op in phase["ops"]:
+            assert op["count"] > 0
+            assert op["errors"] == 0, \
+                "%s failed in the %s phase" % (op["op"], phase["phase"])
@@ -0,0 +1,242 @@
+#
+# Synthetic LDAP directory generator
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+"""
+Generate reproducible user and group datasets of arbitrary size.
+
+Groups are arranged in levels. Users are direct members of the groups of
+the lowest level only, each group of a higher level has groups of the level
+below as members, so the deepest nesting of a user is "depth" groups. With
+the RFC2307 schema nesting is not possible and all groups are flat.
+
+The number of groups a user is a direct member of is drawn from the
+"membership" distribution:
+
+    uniform - every user is a member of "memberships" groups
+    zipf    - the same on average, but the groups are chosen with a
+              Zipf-like skew, so a few groups get most of the users, like
+              the "domain users" style groups of large forests
+
+The same parameters and seed always give the same directory. Run the
+module as a script to get the dataset as LDIF.
+"""
+import argparse
+import random
+import sys
+
+import ldap_ent
+
+SCHEMA_RFC2307 = "rfc2307"
+SCHEMA_RFC2307_BIS = "rfc2307bis"
+
+
+class Dataset(object):
+    """Parameters and the generated content of a synthetic directory"""
+
+    def __init__(self, users=1000, groups=100, depth=3, memberships=5,
+                 distribution="uniform", fanout=4,
+                 schema=SCHEMA_RFC2307_BIS, seed=1,
+                 user_prefix="user", group_prefix="group",
+                 uid_start=100000, gid_start=200000,
+                 password="Secret123"):
+        if schema not in (SCHEMA_RFC2307, SCHEMA_RFC2307_BIS):
+            raise ValueError("Unknown schema " + schema)
+        if distribution not in ("uniform", "zipf"):
+            raise ValueError("Unknown distribution " + distribution)
+        if users < 1 or groups < 1:
+            raise ValueError("At least one user and one group is needed")
+
+        self.users = users
+        self.groups = groups
+        self.depth = depth if schema == SCHEMA_RFC2307_BIS else 0
+        self.memberships = min(memberships, groups)
+        self.distribution = distribution
+        self.fanout = max(fanout, 1)
+        self.schema = schema
+        self.seed = seed
+        self.user_prefix = user_prefix
+        self.group_prefix = group_prefix
+        self.uid_start = uid_start
+        self.gid_start = gid_start
+        self.password = password
+
+        self.user_names = []
+        self.group_names = []
+        # Group names by nesting level, level 0 holds the users
+        self.levels = []
+        self.user_members = {}
+        self.group_members = {}
+
+        self._generate()
+
+    def _split_levels(self):
+        """Split the groups into depth + 1 levels, halving each level"""
+        sizes = []
+        left = self.groups
+        for level in range(self.depth + 1):
+            if level == self.depth:
+                size = left
+            else:
+                size = max(left // 2, 1)
+            size = min(size, left)
+            if size == 0:
+                break
+            sizes.append(size)
+            left -= size
+
+        start = 0
+        for size in sizes:
+            self.levels.append(self.group_names[start:start + size])
+            start += size
+
+    def _pick(self, rnd, count, weights):
+        """Pick count distinct groups of the lowest level"""
+        level = self.levels[0]
+        count = min(count, len(level))
+        if self.distribution == "uniform":
+            return rnd.sample(level, count)
+
+        picked = set()
+        while len(picked) < count:
+            picked.add(rnd.choices(level, cum_weights=weights)[0])
+        return sorted(picked)
+
+    def _generate(self):
+        rnd = random.Random(self.seed)
+
+        self.user_names = ["%s%d" % (self.user_prefix, i)
+                           for i in range(1, self.users + 1)]
+        self.group_names = ["%s%d" % (self.group_prefix, i)
+                            for i in range(1, self.groups + 1)]
+        for name in self.group_names:
+            self.user_members[name] = []
+            self.group_members[name] = []
+        self._split_levels()
+
+        weights = []
+        total = 0.0
+        for rank in range(1, len(self.levels[0]) + 1):
+            total += 1.0 / rank
+            weights.append(total)
+
+        for user in self.user_names:
+            for group in self._pick(rnd, self.memberships, weights):
+                self.user_members[group].append(user)
+
+        for upper, lower in zip(self.levels[1:], self.levels):
+            # Every group of the lower level is nested at least once so
+            # that all users are reachable from the top
+            for i, child in enumerate(lower):
+                self.group_members[upper[i % len(upper)]].append(child)
+            for parent in upper:
+                extra = rnd.sample(lower, min(self.fanout, len(lower)))
+                for child in extra:
+                    if child not in self.group_members[parent]:
+                        self.group_members[parent].append(child)
+
+    def uid(self, user):
+        return self.uid_start + int(user[len(self.user_prefix):]) - 1
+
+    def gid(self, group):
+        return self.gid_start + int(group[len(self.group_prefix):]) - 1
+
+    def top_groups(self):
+        """Groups of the highest nesting level"""
+        return self.levels[-1]
+
+    def ent_list(self, base_dn):
+        """Return the dataset as an ldap_ent.List"""
+        ent_list = ldap_ent.List(base_dn)
+        primary_gid = self.gid_start - 1
+
+        for i, user in enumerate(self.user_names):
+            ent_list.add_user(user, self.uid_start + i, primary_gid,
+                              userPassword=self.password)
+
+        if self.schema == SCHEMA_RFC2307:
+            ent_list.add_group(self.user_prefix + "s", primary_gid)
+        else:
+            ent_list.add_group_bis(self.user_prefix + "s", primary_gid)
+
+        for i, group in enumerate(self.group_names):
+            if self.schema == SCHEMA_RFC2307:
+                ent_list.add_group(group, self.gid_start + i,
+                                   self.user_members[group])
+            else:
+                ent_list.add_group_bis(group, self.gid_start + i,
+                                       self.user_members[group],
+                                       self.group_members[group])
+        return ent_list
+
+    def describe(self):
+        """Return the parameters and the shape of the dataset"""
+        sizes = [len(self.user_members[g]) for g in self.group_names]
+        return dict(users=self.users, groups=self.groups, depth=self.depth,
+                    memberships=self.memberships,
+                    distribution=self.distribution, fanout=self.fanout,
+                    schema=self.schema, seed=self.seed,
+                    levels=[len(level) for level in self.levels],
+                    largest_group=max(sizes),
+                    member_links=sum(sizes) +
+                    sum(len(m) for m in self.group_members.values()))
+
+
+def parser():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--users", type=int, default=1000)
+    parser.add_argument("--groups", type=int, default=100)
+    parser.add_argument("--depth", type=int, default=3,
+                        help="levels of group nesting (rfc2307bis only)")
+    parser.add_argument("--memberships", type=int, default=5,
+                        help="direct group memberships per user")
+    parser.add_argument("--distribution", choices=("uniform", "zipf"),
+                        default="uniform")
+    parser.add_argument("--fanout", type=int, default=4,
+                        help="extra nested groups per group")
+    parser.add_argument("--schema", default=SCHEMA_RFC2307_BIS,
+                        choices=(SCHEMA_RFC2307, SCHEMA_RFC2307_BIS))
+    parser.add_argument("--seed", type=int, default=1)
+    return parser
+
+
+def dataset_from_args(argv):
+    """Create a Dataset from command line style arguments"""
+    return _dataset(parser().parse_args(argv))
+
+
+def _dataset(args):
+    return Dataset(users=args.users, groups=args.groups, depth=args.depth,
+                   memberships=args.memberships,
+                   distribution=args.distribution, fanout=args.fanout,
+                   schema=args.schema, seed=args.seed)
+
+
+def main(argv):
+    import ldif
+
+    p = parser()
+    p.add_argument("--base-dn", default="dc=example,dc=com")
+    args = p.parse_args(argv)
+    dataset = _dataset(args)
+
+    writer = ldif.LDIFWriter(sys.stdout)
+    for dn, attrs in dataset.ent_list(args.base_dn):
+        writer.unparse(dn, dict(attrs))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -573,3 +573,43 @@ def test_sssctl_domain_list_app_domain(dbus_system_bus,
     assert "Error" not in output
     assert output.find("LDAP") != -1
     assert output.find("app") != -1
+
+
+def test_get_command_stats(dbus_system_bus, ldap_conn, sanity_rfc2307):
+    SSS_NSS_GETPWNAM = 0x0011
+    SSS_CMD_SOURCE_PROVIDER = 2
+    SSS_CMD_STATS_BUCKETS = 20
+
+    pwd.getpwnam("user1")
+    with pytest.raises(KeyError):
+        pwd.getpwnam("non_existent_user")
+
+    nss_obj = dbus_system_bus.get_object(
+        'org.freedesktop.sssd.infopipe',
+        '/org/freedesktop/sssd/infopipe/Components/Responders/nss')
+    nss_iface = dbus.Interface(nss_obj,
+                               'org.freedesktop.sssd.infopipe.Components')
+
+    (commands, sources, domains, counts,
+     total_usec, max_usec, histograms) = nss_iface.GetCommandStats()
+    assert len(histograms) == len(commands) * SSS_CMD_STATS_BUCKETS
+
+    found = False
+    for i in range(len(commands)):
+        if commands[i] != SSS_NSS_GETPWNAM or \
+                sources[i] != SSS_CMD_SOURCE_PROVIDER or \
+                domains[i] != "LDAP":
+            continue
+
+        found = True
+        assert counts[i] >= 1
+        assert max_usec[i] <= total_usec[i]
+        buckets = histograms[i * SSS_CMD_STATS_BUCKETS:
+                             (i + 1) * SSS_CMD_STATS_BUCKETS]
+        assert sum(buckets) == counts[i]
+    assert found
+
+    output = get_call_output(["sssctl", "command-stats", "nss"],
+                             subprocess.STDOUT)
+    assert "Error" not in output
+    assert output.find("SSS_NSS_GETPWNAM") != -1
@@ -213,6 +213,32 @@ def fqname_case_insensitive_rfc2307(request, ldap_conn):
     return None
 
 
+@pytest.fixture
+def small_mc_rfc2307(request, ldap_conn):
+    load_data_to_ldap(request, ldap_conn)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+
+        [nss]
+        memcache_size_passwd = 16
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        sudo_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
 @pytest.fixture
 def zero_timeout_rfc2307(request, ldap_conn):
     load_data_to_ldap(request, ldap_conn)
@@ -239,6 +265,119 @@ def zero_timeout_rfc2307(request, ldap_conn):
     return None
 
 
+@pytest.fixture
+def refresh_rfc2307(request, ldap_conn):
+    load_data_to_ldap(request, ldap_conn)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+
+        [nss]
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        sudo_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+        entry_cache_timeout = 10
+        refresh_expired_interval = 5
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
+@pytest.fixture
+def negative_timeout_rfc2307(request, ldap_conn):
+    load_data_to_ldap(request, ldap_conn)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+
+        [nss]
+        entry_negative_timeout = 0
+        memcache_negative_timeout = 60
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        sudo_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
+@pytest.fixture
+def worker_processes_rfc2307(request, ldap_conn):
+    load_data_to_ldap(request, ldap_conn)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+
+        [nss]
+        worker_processes    = 3
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        sudo_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
+@pytest.fixture
+def result_cache_rfc2307(request, ldap_conn):
+    load_data_to_ldap(request, ldap_conn)
+
+    conf = unindent("""\
+        [sssd]
+        domains             = LDAP
+        services            = nss
+
+        [nss]
+        result_cache_size   = 4
+
+        [domain/LDAP]
+        ldap_auth_disable_tls_never_use_in_production = true
+        ldap_schema         = rfc2307
+        id_provider         = ldap
+        auth_provider       = ldap
+        sudo_provider       = ldap
+        ldap_uri            = {ldap_conn.ds_inst.ldap_url}
+        ldap_search_base    = {ldap_conn.ds_inst.base_dn}
+    """).format(**locals())
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+
+    # every lookup has to reach the responder
+    os.environ["SSS_NSS_USE_MEMCACHE"] = "NO"
+
+    def restore_memcache():
+        del os.environ["SSS_NSS_USE_MEMCACHE"]
+    request.addfinalizer(restore_memcache)
+    return None
+
+
 def test_getpwnam(ldap_conn, sanity_rfc2307):
     ent.assert_passwd_by_name(
         'user1',
@@ -328,6 +467,22 @@ def test_getpwnam_with_mc(ldap_conn, sanity_rfc2307):
     test_getpwnam(ldap_conn, sanity_rfc2307)
 
 
+def test_getpwnam_with_grown_mc(ldap_conn, small_mc_rfc2307):
+    """
+    The passwd cache is too small for all users, it has to grow and keep
+    the records it already contains
+    """
+    mc_file = config.MCACHE_PATH + "/passwd"
+    initial_size = os.stat(mc_file).st_size
+
+    test_getpwnam(ldap_conn, small_mc_rfc2307)
+    assert os.stat(mc_file).st_size > initial_size
+
+    # every user must have survived the resize
+    stop_sssd()
+    test_getpwnam(ldap_conn, small_mc_rfc2307)
+
+
 def test_getgrnam_simple(ldap_conn, sanity_rfc2307):
     ent.assert_group_by_name("group1", dict(name="group1", gid=2001))
     ent.assert_group_by_gid(2001, dict(name="group1", gid=2001))
@@ -404,6 +559,18 @@ def test_getgrnam_membership_with_mc(ldap_conn, sanity_rfc2307):
     test_getgrnam_membership(ldap_conn, sanity_rfc2307)
 
 
+def test_lookups_with_result_cache(ldap_conn, result_cache_rfc2307):
+    """
+    Results kept by the responder, including the ones that were already
+    evicted from its small result cache, are returned intact
+    """
+    for _ in range(2):
+        test_getpwnam(ldap_conn, result_cache_rfc2307)
+        test_getgrnam_membership(ldap_conn, result_cache_rfc2307)
+
+        assert_user_gids_equal('user1', [2000, 2001])
+
+
 def assert_user_gids_equal(user, expected_gids):
     (res, errno, gids) = sssd_id.get_user_gids(user)
     assert res == sssd_id.NssReturnCode.SUCCESS, \
@@ -919,3 +1086,114 @@ def test_mc_zero_timeout(ldap_conn, zero_timeout_rfc2307):
         grp.getgrnam('group1')
     with pytest.raises(KeyError):
         grp.getgrgid(2001)
+
+
+def test_invalidate_refreshed_records(ldap_conn, refresh_rfc2307):
+    """
+    Records refreshed by the backend are invalidated in the memory cache
+    """
+    ent.assert_passwd_by_name(
+        'user1',
+        dict(name='user1', passwd='*', uid=1001, gid=2001,
+             gecos='1001', shell='/bin/bash'))
+    ent.assert_group_by_name("group1", dict(name="group1", gid=2001))
+
+    # the first refresh runs 30 seconds after the backend started
+    time.sleep(40)
+    stop_sssd()
+
+    with pytest.raises(KeyError):
+        pwd.getpwnam('user1')
+    with pytest.raises(KeyError):
+        grp.getgrnam('group1')
+
+
+def test_negative_results_per_process(ldap_conn, negative_timeout_rfc2307):
+    """
+    Lookups that found nothing are remembered by the process that did them
+    """
+    with pytest.raises(KeyError):
+        pwd.getpwnam('user4')
+    with pytest.raises(KeyError):
+        pwd.getpwuid(1004)
+
+    ent_list = ldap_ent.List(ldap_conn.ds_inst.base_dn)
+    ent_list.add_user("user4", 1004, 2001)
+    ldap_conn.add_s(ent_list[0][0], ent_list[0][1])
+
+    try:
+        # this process still remembers the misses
+        with pytest.raises(KeyError):
+            pwd.getpwnam('user4')
+        with pytest.raises(KeyError):
+            pwd.getpwuid(1004)
+
+        # while a new one asks the responder
+        assert subprocess.call(["python3", "-c",
+                                "import pwd; pwd.getpwnam('user4')"]) == 0
+    finally:
+        ldap_conn.delete_s(ent_list[0][0])
+
+
+def run_threaded_lookups(env_name):
+    script = unindent("""\
+        import grp
+        import pwd
+        import sys
+        import threading
+
+        USERS = [("user1", 1001), ("user2", 1002), ("user3", 1003),
+                 ("user11", 1011), ("user12", 1012), ("user13", 1013)]
+        errors = []
+
+        def lookup(name, uid):
+            try:
+                for _ in range(20):
+                    assert pwd.getpwnam(name).pw_uid == uid
+                    assert pwd.getpwuid(uid).pw_name == name
+                    assert grp.getgrgid(2001).gr_name == "group1"
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=lookup, args=user)
+                   for user in USERS]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        sys.exit(1 if errors else 0)
+    """)
+
+    env = dict(os.environ)
+    env[env_name] = "YES"
+    env["SSS_NSS_USE_MEMCACHE"] = "NO"
+    return subprocess.call(["python3", "-c", script], env=env)
+
+
+def test_multiplexed_lookups(ldap_conn, sanity_rfc2307):
+    """
+    Threads of a process share the multiplexed connection to the responder
+    """
+    assert run_threaded_lookups("SSS_NSS_MULTIPLEX") == 0
+
+
+def test_thread_socket_lookups(ldap_conn, sanity_rfc2307):
+    """
+    Every thread of a process uses its own connection to the responder
+    """
+    assert run_threaded_lookups("SSS_NSS_THREAD_SOCKETS") == 0
+
+
+def test_worker_processes(ldap_conn, worker_processes_rfc2307):
+    """
+    Worker processes of the NSS responder answer lookups together with it
+    """
+    for _ in range(10):
+        workers = subprocess.run(["pgrep", "-f", "sssd_nss .*--worker="],
+                                 stdout=subprocess.PIPE)
+        if len(workers.stdout.split()) == 2:
+            break
+        time.sleep(1)
+    assert len(workers.stdout.split()) == 2
+
+    assert run_threaded_lookups("SSS_NSS_THREAD_SOCKETS") == 0
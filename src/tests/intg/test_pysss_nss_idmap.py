@@ -122,18 +122,23 @@ def create_sssd_process():
         raise Exception("sssd start failed")
 
 
+def stop_sssd():
+    """Stop the SSSD process"""
+    with open(config.PIDFILE_PATH, "r") as pid_file:
+        pid = int(pid_file.read())
+    os.kill(pid, signal.SIGTERM)
+    while True:
+        try:
+            os.kill(pid, signal.SIGCONT)
+        except:
+            break
+        time.sleep(1)
+
+
 def cleanup_sssd_process():
     """Stop the SSSD process and remove its state"""
     try:
-        with open(config.PIDFILE_PATH, "r") as pid_file:
-            pid = int(pid_file.read())
-        os.kill(pid, signal.SIGTERM)
-        while True:
-            try:
-                os.kill(pid, signal.SIGCONT)
-            except:
-                break
-            time.sleep(1)
+        stop_sssd()
     except:
         pass
     for path in os.listdir(config.DB_PATH):
@@ -289,3 +294,40 @@ def test_case_insensitive(ldap_conn, simple_ad):
     output = pysss_nss_idmap.getnamebysid(group_sid)[group_sid]
     assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_GROUP
     assert output[pysss_nss_idmap.NAME_KEY] == group.lower()
+
+
+def test_sid_memory_cache(ldap_conn, simple_ad):
+    user = 'user1_dom1-19661'
+    user_id = pwd.getpwnam(user).pw_uid
+    user_sid = 'S-1-5-21-1305200397-2901131868-73388776-82809'
+    group = 'group3_dom1-17775'
+    group_id = grp.getgrnam(group).gr_gid
+    group_sid = 'S-1-5-21-1305200397-2901131868-73388776-82764'
+
+    # fill the memory cache
+    pysss_nss_idmap.getsidbyname(user)
+    pysss_nss_idmap.getsidbyuid(user_id)
+    pysss_nss_idmap.getsidbygid(group_id)
+    pysss_nss_idmap.getidbysid(user_sid)
+
+    stop_sssd()
+
+    # the answers now come from the memory cache only
+    output = pysss_nss_idmap.getsidbyname(user)[user]
+    assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_USER
+    assert output[pysss_nss_idmap.SID_KEY] == user_sid
+
+    output = pysss_nss_idmap.getsidbyuid(user_id)[user_id]
+    assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_USER
+    assert output[pysss_nss_idmap.SID_KEY] == user_sid
+
+    output = pysss_nss_idmap.getsidbygid(group_id)[group_id]
+    assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_GROUP
+    assert output[pysss_nss_idmap.SID_KEY] == group_sid
+
+    output = pysss_nss_idmap.getidbysid(user_sid)[user_sid]
+    assert output[pysss_nss_idmap.TYPE_KEY] == pysss_nss_idmap.ID_USER
+    assert output[pysss_nss_idmap.ID_KEY] == user_id
+
+    output = pysss_nss_idmap.getnamebysid(user_sid)[user_sid]
+    assert output[pysss_nss_idmap.NAME_KEY] == user
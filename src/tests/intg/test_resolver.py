@@ -102,7 +102,7 @@ SCHEMA_RFC2307 = "rfc2307"
 SCHEMA_RFC2307_BIS = "rfc2307bis"
 
 
-def format_basic_conf(ldap_conn, schema):
+def format_basic_conf(ldap_conn, schema, memcache_timeout=0):
     """Format a basic SSSD configuration"""
     schema_conf = "ldap_schema         = " + schema + "\n"
     if schema == SCHEMA_RFC2307_BIS:
@@ -117,7 +117,7 @@ def format_basic_conf(ldap_conn, schema):
 
         [nss]
         debug_level         = 0xffff
-        memcache_timeout    = 0
+        memcache_timeout    = {memcache_timeout}
         entry_negative_timeout = 1
 
         [domain/LDAP]
@@ -173,8 +173,8 @@ def get_sssd_pid():
     return pid
 
 
-def cleanup_sssd_process():
-    """Stop the SSSD process and remove its state"""
+def stop_sssd():
+    """Stop the SSSD process, keeping its state"""
     try:
         pid = get_sssd_pid()
         os.kill(pid, signal.SIGTERM)
@@ -186,6 +186,11 @@ def cleanup_sssd_process():
             time.sleep(1)
     except:
         pass
+
+
+def cleanup_sssd_process():
+    """Stop the SSSD process and remove its state"""
+    stop_sssd()
     for path in os.listdir(config.DB_PATH):
         os.unlink(config.DB_PATH + "/" + path)
     for path in os.listdir(config.MCACHE_PATH):
@@ -279,6 +284,47 @@ def test_hostbyname(add_hosts):
     assert hres == 0
 
 
+@pytest.fixture
+def add_hosts_memcache(request, ldap_conn):
+    ent_list = ldap_ent.List(ldap_conn.ds_inst.base_dn)
+
+    ent_list.add_host("host1",
+                      aliases=["host1_alias1", "host1_alias2"],
+                      addresses=["192.168.1.1", "192.168.1.2"])
+
+    create_ldap_fixture(request, ldap_conn, ent_list)
+    conf = format_basic_conf(ldap_conn, SCHEMA_RFC2307, memcache_timeout=300)
+    create_conf_fixture(request, conf)
+    create_sssd_fixture(request)
+    return None
+
+
+def test_hostbyname_memcache(add_hosts_memcache):
+    (res, hres, _) = call_sssd_gethostbyname("host1")
+    assert res == NssReturnCode.SUCCESS
+    assert hres == 0
+
+    (res, hres, _) = call_sssd_gethostbyname("host1_alias1")
+    assert res == NssReturnCode.SUCCESS
+    assert hres == 0
+
+    assert os.path.exists(config.MCACHE_PATH + "/hosts")
+
+    # lookups are now answered from the memory cache
+    stop_sssd()
+
+    (res, hres, _) = call_sssd_gethostbyname("host1")
+    assert res == NssReturnCode.SUCCESS
+    assert hres == 0
+
+    (res, hres, _) = call_sssd_gethostbyname("host1_alias1")
+    assert res == NssReturnCode.SUCCESS
+    assert hres == 0
+
+    (res, hres, _) = call_sssd_gethostbyname("host1_alias2")
+    assert res == NssReturnCode.UNAVAIL
+
+
 def test_netbyname(add_nets):
     (res, hres, _) = call_sssd_getnetbyname("invalid")
     assert res == NssReturnCode.NOTFOUND
@@ -20,6 +20,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <unistd.h>
 #include <sys/types.h>
@@ -820,6 +821,124 @@ START_TEST(ipa_hbac_test_allow_srchostgroup)
 }
 END_TEST
 
+START_TEST(ipa_hbac_test_compiled)
+{
+    enum hbac_eval_result result;
+    enum hbac_error_code code;
+    TALLOC_CTX *test_ctx;
+    struct hbac_rule **rules;
+    struct hbac_compiled_rules *compiled;
+    struct hbac_eval_req *eval_req;
+    struct hbac_info *info = NULL;
+
+    test_ctx = talloc_new(global_talloc_context);
+
+    /* Create a request */
+    eval_req = talloc_zero(test_ctx, struct hbac_eval_req);
+    fail_if (eval_req == NULL);
+
+    get_test_user(eval_req, &eval_req->user);
+    get_test_service(eval_req, &eval_req->service);
+    get_test_srchost(eval_req, &eval_req->srchost);
+
+    /* Create the rules to evaluate against */
+    rules = talloc_array(test_ctx, struct hbac_rule *, 4);
+    fail_if (rules == NULL);
+
+    /* Allow an invalid user */
+    get_allow_all_rule(rules, &rules[0]);
+    rules[0]->name = talloc_strdup(rules[0], "Allow invalid user");
+    fail_if(rules[0]->name == NULL);
+    rules[0]->users->category = HBAC_CATEGORY_NULL;
+
+    rules[0]->users->names = talloc_array(rules[0], const char *, 2);
+    fail_if(rules[0]->users->names == NULL);
+
+    rules[0]->users->names[0] = HBAC_TEST_INVALID_USER;
+    rules[0]->users->names[1] = NULL;
+
+    /* Allow a user group to use a service */
+    get_allow_all_rule(rules, &rules[1]);
+    rules[1]->name = talloc_strdup(rules[1], "Allow group service");
+    fail_if(rules[1]->name == NULL);
+    rules[1]->users->category = HBAC_CATEGORY_NULL;
+    rules[1]->services->category = HBAC_CATEGORY_NULL;
+
+    rules[1]->users->groups = talloc_array(rules[1], const char *, 2);
+    fail_if(rules[1]->users->groups == NULL);
+
+    rules[1]->users->groups[0] = "TESTGROUP2";
+    rules[1]->users->groups[1] = NULL;
+
+    rules[1]->services->names = talloc_array(rules[1], const char *, 2);
+    fail_if(rules[1]->services->names == NULL);
+
+    rules[1]->services->names[0] = HBAC_TEST_SERVICE;
+    rules[1]->services->names[1] = NULL;
+
+    /* Allow everything */
+    get_allow_all_rule(rules, &rules[2]);
+    rules[2]->name = talloc_strdup(rules[2], "Allow All");
+    fail_if(rules[2]->name == NULL);
+
+    rules[3] = NULL;
+
+    code = hbac_compile_rules(rules, &compiled);
+    fail_unless(code == HBAC_SUCCESS,
+                "Unable to compile rules: [%s]", hbac_error_string(code));
+
+    /* The first matching rule grants access */
+    result = hbac_evaluate_compiled(compiled, eval_req, &info);
+    fail_unless(result == HBAC_EVAL_ALLOW,
+                "Expected [%s], got [%s]; "
+                "Error: [%s]",
+                hbac_result_string(HBAC_EVAL_ALLOW),
+                hbac_result_string(result),
+                info ? hbac_error_string(info->code):"Unknown");
+    fail_unless(strcmp(info->rule_name, "Allow group service") == 0,
+                "Expected [Allow group service], got [%s]", info->rule_name);
+    hbac_free_info(info);
+    info = NULL;
+
+    /* The compiled rules can be evaluated again */
+    eval_req->service->name = HBAC_TEST_INVALID_SERVICE;
+
+    result = hbac_evaluate_compiled(compiled, eval_req, &info);
+    fail_unless(result == HBAC_EVAL_ALLOW,
+                "Expected [%s], got [%s]; "
+                "Error: [%s]",
+                hbac_result_string(HBAC_EVAL_ALLOW),
+                hbac_result_string(result),
+                info ? hbac_error_string(info->code):"Unknown");
+    fail_unless(strcmp(info->rule_name, "Allow All") == 0,
+                "Expected [Allow All], got [%s]", info->rule_name);
+    hbac_free_info(info);
+    info = NULL;
+
+    hbac_free_compiled_rules(compiled);
+
+    /* Negative test */
+    rules[2] = NULL;
+
+    code = hbac_compile_rules(rules, &compiled);
+    fail_unless(code == HBAC_SUCCESS,
+                "Unable to compile rules: [%s]", hbac_error_string(code));
+
+    result = hbac_evaluate_compiled(compiled, eval_req, &info);
+    fail_unless(result == HBAC_EVAL_DENY,
+                "Expected [%s], got [%s]; "
+                "Error: [%s]",
+                hbac_result_string(HBAC_EVAL_DENY),
+                hbac_result_string(result),
+                info ? hbac_error_string(info->code):"Unknown");
+    hbac_free_info(info);
+    info = NULL;
+
+    hbac_free_compiled_rules(compiled);
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST(ipa_hbac_test_incomplete)
 {
     TALLOC_CTX *test_ctx;
@@ -860,6 +979,7 @@ Suite *hbac_test_suite (void)
     tcase_add_test(tc_hbac, ipa_hbac_test_allow_srchost);
     tcase_add_test(tc_hbac, ipa_hbac_test_allow_srchostgroup);
     tcase_add_test(tc_hbac, ipa_hbac_test_allow_utf8);
+    tcase_add_test(tc_hbac, ipa_hbac_test_compiled);
     tcase_add_test(tc_hbac, ipa_hbac_test_incomplete);
 
     suite_add_tcase(s, tc_hbac);
@@ -0,0 +1,456 @@
+/*
+   SSSD
+
+   Memory cache benchmark
+
+   Compares lookup times of the chained and the probing hash table layout
+   of the NSS memory cache at different fill levels, the initgroups
+   throughput of caches mapped with regular and with huge pages and the
+   cost of the hash functions on names of different lengths.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <talloc.h>
+#include <popt.h>
+#include <time.h>
+#include <pwd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "util/util.h"
+#include "util/mmap_cache.h"
+#include "responder/nss/nsssrv_mmap_cache.h"
+#include "sss_client/sss_cli.h"
+#include "sss_client/nss_mc.h"
+
+#define DEFAULT_ELEMS   50000
+#define DEFAULT_ROUNDS  5
+#define DEFAULT_GROUPS  64
+#define BENCH_BUF_SIZE  1024
+
+/* The client code takes these locks only while (re)mapping the file,
+ * this program is single threaded so they are not needed. */
+void sss_nss_mc_lock(void) { return; }
+void sss_nss_mc_unlock(void) { return; }
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static errno_t bench_store_users(struct sss_mc_ctx **mcc, size_t num)
+{
+    struct sized_string name;
+    struct sized_string pw;
+    struct sized_string gecos;
+    struct sized_string homedir;
+    struct sized_string shell;
+    char namebuf[32];
+    char homebuf[64];
+    size_t i;
+    errno_t ret;
+
+    to_sized_string(&pw, "*");
+    to_sized_string(&gecos, "Benchmark User");
+    to_sized_string(&shell, "/bin/bash");
+
+    for (i = 0; i < num; i++) {
+        snprintf(namebuf, sizeof(namebuf), "benchuser%zu", i);
+        snprintf(homebuf, sizeof(homebuf), "/home/benchuser%zu", i);
+        to_sized_string(&name, namebuf);
+        to_sized_string(&homedir, homebuf);
+
+        ret = sss_mmap_cache_pw_store(mcc, &name, &pw, 100000 + i, 100000 + i,
+                                      &gecos, &homedir, &shell);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+/* Returns the average time of a lookup in nanoseconds. Names starting
+ * with the miss prefix are never stored. */
+static double bench_lookup(size_t num, size_t rounds, bool miss,
+                           size_t *_found)
+{
+    struct passwd pwd;
+    char buf[BENCH_BUF_SIZE];
+    char namebuf[32];
+    uint64_t start;
+    uint64_t end;
+    size_t found = 0;
+    size_t r;
+    size_t i;
+    errno_t ret;
+
+    start = bench_now_ns();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < num; i++) {
+            snprintf(namebuf, sizeof(namebuf), "%s%zu",
+                     miss ? "nosuchuser" : "benchuser", i);
+            ret = sss_nss_mc_getpwnam(namebuf, strlen(namebuf),
+                                      &pwd, buf, sizeof(buf));
+            if (ret == 0) {
+                found++;
+            }
+        }
+    }
+    end = bench_now_ns();
+
+    *_found = found / rounds;
+    return (double)(end - start) / (num * rounds);
+}
+
+static errno_t bench_layout(TALLOC_CTX *mem_ctx, uint32_t layout,
+                            uint32_t hash, uint32_t flags, size_t elems,
+                            int fill, size_t rounds)
+{
+    struct sss_mc_ctx *mcc = NULL;
+    struct passwd pwd;
+    char buf[BENCH_BUF_SIZE];
+    size_t num;
+    size_t found_hit;
+    size_t found_miss;
+    double hit;
+    double miss;
+    errno_t ret;
+    int i;
+
+    ret = sss_mmap_cache_init(mem_ctx, "passwd", geteuid(), getegid(),
+                              SSS_MC_PASSWD, layout, hash, flags,
+                              elems, elems, 300, 0, false, &mcc);
+    if (ret != EOK) {
+        fprintf(stderr, "Cannot create memory cache [%d]: %s\n",
+                ret, sss_strerror(ret));
+        return ret;
+    }
+
+    num = elems * fill / 100;
+    ret = bench_store_users(&mcc, num);
+    if (ret != EOK) {
+        fprintf(stderr, "Cannot store users [%d]: %s\n",
+                ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* let the client drop the previous, recycled, file */
+    for (i = 0; i < 3; i++) {
+        (void)sss_nss_mc_getpwnam("benchuser0", strlen("benchuser0"),
+                                  &pwd, buf, sizeof(buf));
+    }
+
+    hit = bench_lookup(num, rounds, false, &found_hit);
+    miss = bench_lookup(num, rounds, true, &found_miss);
+
+    printf("%-8s %5d%% %10zu %10zu %12.1f %12.1f\n",
+           layout == SSS_MC_LAYOUT_PROBING ? "probing" : "chained",
+           fill, num, found_hit, hit, miss);
+
+    ret = EOK;
+
+done:
+    talloc_free(mcc);
+    return ret;
+}
+
+static errno_t bench_store_initgr(struct sss_mc_ctx **mcc, size_t num,
+                                  size_t num_groups)
+{
+    struct sized_string name;
+    char namebuf[32];
+    uint32_t gids[num_groups];
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    for (i = 0; i < num; i++) {
+        snprintf(namebuf, sizeof(namebuf), "benchuser%zu", i);
+        to_sized_string(&name, namebuf);
+
+        for (j = 0; j < num_groups; j++) {
+            gids[j] = 200000 + (i + j) % (num * 2);
+        }
+
+        ret = sss_mmap_cache_initgr_store(mcc, &name, &name, num_groups,
+                                          (uint8_t *)gids);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+/* Same work getgrouplist() does once the record is found, returns the
+ * number of initgroups lookups per second. */
+static double bench_initgroups(size_t num, size_t rounds, size_t *_found)
+{
+    gid_t *groups;
+    long int size;
+    long int start;
+    char namebuf[32];
+    uint64_t begin;
+    uint64_t end;
+    size_t found = 0;
+    size_t r;
+    size_t i;
+    errno_t ret;
+
+    size = 16;
+    groups = malloc(size * sizeof(gid_t));
+    if (groups == NULL) {
+        *_found = 0;
+        return 0;
+    }
+
+    begin = bench_now_ns();
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < num; i++) {
+            snprintf(namebuf, sizeof(namebuf), "benchuser%zu", i);
+            start = 0;
+            ret = sss_nss_mc_initgroups_dyn(namebuf, strlen(namebuf), 0,
+                                            &start, &size, &groups, -1);
+            if (ret == 0) {
+                found++;
+            }
+        }
+    }
+    end = bench_now_ns();
+
+    free(groups);
+    *_found = found / rounds;
+    return (double)(num * rounds) * 1000000000.0 / (end - begin);
+}
+
+static errno_t bench_pages(TALLOC_CTX *mem_ctx, uint32_t hash, uint32_t flags,
+                           size_t elems, size_t num_groups, size_t rounds)
+{
+    struct sss_mc_ctx *mcc = NULL;
+    gid_t *groups;
+    long int size = 0;
+    long int start = 0;
+    size_t num;
+    size_t found;
+    double rate;
+    errno_t ret;
+    int i;
+
+    ret = sss_mmap_cache_init(mem_ctx, "initgroups", geteuid(), getegid(),
+                              SSS_MC_INITGROUPS, SSS_MC_LAYOUT_CHAINED,
+                              hash, flags, elems, elems, 300, 0, false, &mcc);
+    if (ret != EOK) {
+        fprintf(stderr, "Cannot create memory cache [%d]: %s\n",
+                ret, sss_strerror(ret));
+        return ret;
+    }
+
+    /* the average initgroups payload is sized for a handful of groups,
+     * store fewer records to not evict them */
+    num = elems * 70 / 100 / (num_groups / 8 + 1);
+    ret = bench_store_initgr(&mcc, num, num_groups);
+    if (ret != EOK) {
+        fprintf(stderr, "Cannot store initgroups [%d]: %s\n",
+                ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* let the client drop the previous, recycled, file */
+    groups = NULL;
+    for (i = 0; i < 3; i++) {
+        start = 0;
+        (void)sss_nss_mc_initgroups_dyn("benchuser0", strlen("benchuser0"), 0,
+                                        &start, &size, &groups, -1);
+    }
+    free(groups);
+
+    rate = bench_initgroups(num, rounds, &found);
+
+    printf("%-8s %10zu %10zu %10zu %14.0f\n",
+           (flags & SSS_MC_FLAG_HUGE_PAGES) ? "huge" : "regular",
+           num_groups, num, found, rate);
+
+    ret = EOK;
+
+done:
+    talloc_free(mcc);
+    return ret;
+}
+
+/* Every name is hashed twice per stored record and once per lookup. */
+static void bench_hash(const char *name, uint32_t hash, size_t rounds)
+{
+    char key[BENCH_BUF_SIZE];
+    volatile uint32_t sink = 0;
+    uint64_t start;
+    size_t len;
+    size_t i;
+
+    len = strlen(name) + 1;
+    memcpy(key, name, len);
+
+    start = bench_now_ns();
+    for (i = 0; i < rounds; i++) {
+        /* make sure every round hashes a different key */
+        key[0] = 'a' + (i & 15);
+        if (hash == SSS_MC_HASH_WYHASH) {
+            sink += wyhash(key, len, i);
+        } else {
+            sink += murmurhash3(key, len, i);
+        }
+    }
+
+    printf("%-12s %6zu %12.1f\n",
+           hash == SSS_MC_HASH_WYHASH ? "wyhash" : "murmurhash3",
+           len, (double)(bench_now_ns() - start) / rounds);
+    (void)sink;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int pc_elems = DEFAULT_ELEMS;
+    int pc_rounds = DEFAULT_ROUNDS;
+    int pc_groups = DEFAULT_GROUPS;
+    int pc_huge_pages = 0;
+    const char *pc_hash = "murmurhash3";
+    uint32_t hash;
+    const char *names[] = {
+        "jsmith@EXAMPLE.COM",
+        "john.smith@EMEA.CORP.EXAMPLE.COM",
+        "svc-backup-storage-cluster-01.datacenter-west@INFRA.CORP.EXAMPLE.COM",
+        "very-long-service-account-name-for-the-application-deployment-"
+            "pipeline.production@SUBDOMAIN.INFRA.CORP.EXAMPLE.COM",
+        NULL
+    };
+    uint32_t flags = 0;
+    int fills[] = { 25, 50, 70, 90, 0 };
+    TALLOC_CTX *mem_ctx;
+    errno_t ret;
+    int i;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "elements", 'e', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_elems, 0,
+                    "Number of elements the cache is sized for", NULL },
+        { "rounds", 'r', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_rounds, 0,
+                    "How many times every name is looked up", NULL },
+        { "groups", 'g', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_groups, 0,
+                    "Number of groups of every user", NULL },
+        { "huge-pages", 'H', POPT_ARG_NONE, &pc_huge_pages, 0,
+                    "Map the caches of the layout comparison "
+                    "with huge pages", NULL },
+        { "hash", '\0', POPT_ARG_STRING | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_hash, 0,
+                    "Hash function of the caches (murmurhash3 or wyhash)",
+                    NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                poptBadOption(pc, 0), poptStrerror(opt));
+        poptPrintUsage(pc, stderr, 0);
+        return 1;
+    }
+    poptFreeContext(pc);
+
+    if (pc_elems <= 0 || pc_rounds <= 0 || pc_groups <= 0) {
+        fprintf(stderr, "Elements, rounds and groups must be positive\n");
+        return 1;
+    }
+
+    if (pc_huge_pages) {
+        flags |= SSS_MC_FLAG_HUGE_PAGES;
+    }
+
+    if (strcmp(pc_hash, "murmurhash3") == 0) {
+        hash = SSS_MC_HASH_MURMURHASH3;
+    } else if (strcmp(pc_hash, "wyhash") == 0) {
+        hash = SSS_MC_HASH_WYHASH;
+    } else {
+        fprintf(stderr, "Unknown hash function %s\n", pc_hash);
+        return 1;
+    }
+
+    ret = mkdir(SSS_NSS_MCACHE_DIR, 0755);
+    if (ret != 0 && errno != EEXIST) {
+        ret = errno;
+        fprintf(stderr, "Cannot create %s [%d]: %s\n",
+                SSS_NSS_MCACHE_DIR, ret, strerror(ret));
+        return 1;
+    }
+
+    mem_ctx = talloc_new(NULL);
+    if (mem_ctx == NULL) {
+        return 1;
+    }
+
+    printf("%-8s %6s %10s %10s %12s %12s\n",
+           "layout", "fill", "records", "found", "hit [ns]", "miss [ns]");
+
+    for (i = 0; fills[i] != 0; i++) {
+        ret = bench_layout(mem_ctx, SSS_MC_LAYOUT_CHAINED, hash, flags,
+                           pc_elems, fills[i], pc_rounds);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        ret = bench_layout(mem_ctx, SSS_MC_LAYOUT_PROBING, hash, flags,
+                           pc_elems, fills[i], pc_rounds);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    printf("\n%-8s %10s %10s %10s %14s\n",
+           "pages", "groups", "users", "found", "initgr [1/s]");
+
+    ret = bench_pages(mem_ctx, hash, 0, pc_elems, pc_groups, pc_rounds);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = bench_pages(mem_ctx, hash, SSS_MC_FLAG_HUGE_PAGES,
+                      pc_elems, pc_groups, pc_rounds);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    printf("\n%-12s %6s %12s\n", "hash", "length", "hash [ns]");
+
+    for (i = 0; names[i] != NULL; i++) {
+        bench_hash(names[i], SSS_MC_HASH_MURMURHASH3,
+                   (size_t)pc_elems * pc_rounds);
+        bench_hash(names[i], SSS_MC_HASH_WYHASH,
+                   (size_t)pc_elems * pc_rounds);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(mem_ctx);
+    return ret == EOK ? 0 : 1;
+}
@@ -0,0 +1,858 @@
+/*
+   SSSD
+
+   Load generator and benchmark of the NSS and PAM responders
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Every phase forks --processes workers, each running --threads threads
+ * that issue a weighted mix of lookups for --duration seconds. Latencies
+ * are kept per thread in shared memory and merged by the parent, which
+ * prints the results of all phases as JSON.
+ *
+ * Phases:
+ *   cold   - run --cold-cmd (e.g. "sss_cache -E") first, then measure
+ *   warm   - measure with whatever the previous phases left in the caches
+ *   socket - like warm, but with the memory cache disabled in the workers
+ *            (SSS_NSS_USE_MEMCACHE=NO) to see the cost of a responder hit
+ */
+
+#include <errno.h>
+#include <grp.h>
+#include <popt.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <security/pam_appl.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/strtonum.h"
+
+#define BENCH_DEFAULT_DURATION 10
+#define BENCH_DEFAULT_WORKLOAD "pwnam:40,pwuid:30,initgroups:20,grnam:10"
+#define BENCH_DEFAULT_PHASES "cold,warm"
+#define BENCH_DEFAULT_PAM_SERVICE "pam_sss_service"
+#define BENCH_START_DELAY_MS 200
+#define BENCH_BUFSIZE 4096
+
+/* Latencies in nanoseconds: values below 8 have a bucket of their own,
+ * every power of two above is split into 8 linear buckets. This keeps the
+ * relative error under 12.5% with a few hundred buckets. */
+#define BENCH_SUB_BITS 3
+#define BENCH_SUB_BUCKETS (1 << BENCH_SUB_BITS)
+#define BENCH_BUCKETS ((64 - BENCH_SUB_BITS + 1) * BENCH_SUB_BUCKETS)
+
+enum bench_op {
+    BENCH_OP_PWNAM,
+    BENCH_OP_PWUID,
+    BENCH_OP_INITGROUPS,
+    BENCH_OP_GRNAM,
+    BENCH_OP_PAM,
+
+    BENCH_OP_SENTINEL
+};
+
+static const char *bench_op_names[] = {
+    "pwnam", "pwuid", "initgroups", "grnam", "pam"
+};
+
+enum bench_result {
+    BENCH_OK,
+    BENCH_NOTFOUND,
+    BENCH_ERROR
+};
+
+struct bench_op_stats {
+    uint64_t count;
+    uint64_t notfound;
+    uint64_t errors;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[BENCH_BUCKETS];
+};
+
+/* Written by one thread only, lives in memory shared with the parent. */
+struct bench_slot {
+    struct bench_op_stats ops[BENCH_OP_SENTINEL];
+};
+
+struct bench_opts {
+    int threads;
+    int processes;
+    int duration;
+    const char *workload;
+    const char *phases;
+    const char *cold_cmd;
+    const char *user_prefix;
+    int user_start;
+    int user_stop;
+    int uid_start;
+    const char *groups;
+    const char *pam_service;
+    const char *pam_password;
+    const char *output;
+};
+
+struct bench_ctx {
+    struct bench_opts opts;
+
+    unsigned int weights[BENCH_OP_SENTINEL];
+    unsigned int weights_sum;
+    char **users;
+    size_t num_users;
+    char **groups;
+    size_t num_groups;
+
+    struct timespec start;
+    struct timespec deadline;
+    struct bench_slot *slots;
+    size_t num_slots;
+};
+
+struct bench_thread {
+    struct bench_ctx *bctx;
+    struct bench_slot *slot;
+    unsigned int seed;
+    char *buf;
+    size_t buflen;
+};
+
+static uint64_t bench_ts_ns(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000000000 + ts->tv_nsec;
+}
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return bench_ts_ns(&ts);
+}
+
+static size_t bench_bucket(uint64_t ns)
+{
+    int msb;
+
+    if (ns < BENCH_SUB_BUCKETS) {
+        return ns;
+    }
+
+    msb = 63 - __builtin_clzll(ns);
+    return (msb - BENCH_SUB_BITS + 1) * BENCH_SUB_BUCKETS
+               + ((ns >> (msb - BENCH_SUB_BITS)) & (BENCH_SUB_BUCKETS - 1));
+}
+
+static uint64_t bench_bucket_lower(size_t bucket)
+{
+    size_t group;
+
+    if (bucket < BENCH_SUB_BUCKETS) {
+        return bucket;
+    }
+
+    group = bucket / BENCH_SUB_BUCKETS - 1;
+    return (uint64_t)(BENCH_SUB_BUCKETS + bucket % BENCH_SUB_BUCKETS) << group;
+}
+
+static void bench_record(struct bench_op_stats *stats,
+                         enum bench_result result,
+                         uint64_t ns)
+{
+    stats->count++;
+    stats->sum_ns += ns;
+    if (ns > stats->max_ns) {
+        stats->max_ns = ns;
+    }
+    stats->buckets[bench_bucket(ns)]++;
+
+    if (result == BENCH_NOTFOUND) {
+        stats->notfound++;
+    } else if (result == BENCH_ERROR) {
+        stats->errors++;
+    }
+}
+
+/* === Operations === */
+
+static errno_t bench_grow_buf(struct bench_thread *th)
+{
+    char *buf;
+
+    buf = talloc_realloc(th, th->buf, char, th->buflen * 2);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    th->buf = buf;
+    th->buflen *= 2;
+    return EOK;
+}
+
+static enum bench_result bench_pwnam(struct bench_thread *th, size_t idx)
+{
+    struct passwd pwd;
+    struct passwd *res;
+    int ret;
+
+    while ((ret = getpwnam_r(th->bctx->users[idx], &pwd, th->buf,
+                             th->buflen, &res)) == ERANGE) {
+        if (bench_grow_buf(th) != EOK) {
+            return BENCH_ERROR;
+        }
+    }
+
+    if (ret != 0) {
+        return BENCH_ERROR;
+    }
+    return res == NULL ? BENCH_NOTFOUND : BENCH_OK;
+}
+
+static enum bench_result bench_pwuid(struct bench_thread *th, size_t idx)
+{
+    struct passwd pwd;
+    struct passwd *res;
+    uid_t uid;
+    int ret;
+
+    uid = th->bctx->opts.uid_start + idx;
+    while ((ret = getpwuid_r(uid, &pwd, th->buf, th->buflen, &res)) == ERANGE) {
+        if (bench_grow_buf(th) != EOK) {
+            return BENCH_ERROR;
+        }
+    }
+
+    if (ret != 0) {
+        return BENCH_ERROR;
+    }
+    return res == NULL ? BENCH_NOTFOUND : BENCH_OK;
+}
+
+static enum bench_result bench_initgroups(struct bench_thread *th, size_t idx)
+{
+    gid_t *groups;
+    int ngroups = 64;
+    int ret;
+
+    groups = talloc_array(th, gid_t, ngroups);
+    if (groups == NULL) {
+        return BENCH_ERROR;
+    }
+
+    while ((ret = getgrouplist(th->bctx->users[idx], 0, groups,
+                               &ngroups)) == -1) {
+        groups = talloc_realloc(th, groups, gid_t, ngroups);
+        if (groups == NULL) {
+            return BENCH_ERROR;
+        }
+    }
+
+    talloc_free(groups);
+
+    /* Only the base group was found. */
+    return ret <= 1 ? BENCH_NOTFOUND : BENCH_OK;
+}
+
+static enum bench_result bench_grnam(struct bench_thread *th, size_t idx)
+{
+    struct group grp;
+    struct group *res;
+    int ret;
+
+    idx %= th->bctx->num_groups;
+    while ((ret = getgrnam_r(th->bctx->groups[idx], &grp, th->buf,
+                             th->buflen, &res)) == ERANGE) {
+        if (bench_grow_buf(th) != EOK) {
+            return BENCH_ERROR;
+        }
+    }
+
+    if (ret != 0) {
+        return BENCH_ERROR;
+    }
+    return res == NULL ? BENCH_NOTFOUND : BENCH_OK;
+}
+
+static int bench_pam_conv(int num_msg, const struct pam_message **msgm,
+                          struct pam_response **response, void *appdata_ptr)
+{
+    struct pam_response *reply;
+    const char *password = appdata_ptr;
+    int i;
+
+    reply = calloc(num_msg, sizeof(struct pam_response));
+    if (reply == NULL) {
+        return PAM_CONV_ERR;
+    }
+
+    for (i = 0; i < num_msg; i++) {
+        if (msgm[i]->msg_style == PAM_PROMPT_ECHO_OFF) {
+            reply[i].resp = strdup(password == NULL ? "" : password);
+            if (reply[i].resp == NULL) {
+                goto fail;
+            }
+        }
+    }
+
+    *response = reply;
+    return PAM_SUCCESS;
+
+fail:
+    for (i = 0; i < num_msg; i++) {
+        free(reply[i].resp);
+    }
+    free(reply);
+    return PAM_CONV_ERR;
+}
+
+static enum bench_result bench_pam(struct bench_thread *th, size_t idx)
+{
+    struct pam_conv conv;
+    pam_handle_t *pamh;
+    int ret;
+
+    conv.conv = bench_pam_conv;
+    conv.appdata_ptr = discard_const(th->bctx->opts.pam_password);
+
+    ret = pam_start(th->bctx->opts.pam_service, th->bctx->users[idx],
+                    &conv, &pamh);
+    if (ret != PAM_SUCCESS) {
+        return BENCH_ERROR;
+    }
+
+    ret = pam_authenticate(pamh, 0);
+    if (ret == PAM_SUCCESS) {
+        ret = pam_acct_mgmt(pamh, 0);
+    }
+    pam_end(pamh, ret);
+
+    switch (ret) {
+    case PAM_SUCCESS:
+        return BENCH_OK;
+    case PAM_USER_UNKNOWN:
+        return BENCH_NOTFOUND;
+    default:
+        return BENCH_ERROR;
+    }
+}
+
+typedef enum bench_result (*bench_op_fn)(struct bench_thread *th,
+                                         size_t idx);
+
+static bench_op_fn bench_op_fns[] = {
+    bench_pwnam, bench_pwuid, bench_initgroups, bench_grnam, bench_pam
+};
+
+/* === Workers === */
+
+static enum bench_op bench_pick_op(struct bench_thread *th)
+{
+    unsigned int r;
+    int i;
+
+    r = rand_r(&th->seed) % th->bctx->weights_sum;
+    for (i = 0; i < BENCH_OP_SENTINEL; i++) {
+        if (r < th->bctx->weights[i]) {
+            break;
+        }
+        r -= th->bctx->weights[i];
+    }
+
+    return i;
+}
+
+static void *bench_thread_main(void *ptr)
+{
+    struct bench_thread *th = ptr;
+    struct bench_ctx *bctx = th->bctx;
+    enum bench_result result;
+    enum bench_op op;
+    uint64_t deadline;
+    uint64_t begin;
+    uint64_t end;
+    size_t idx;
+
+    deadline = bench_ts_ns(&bctx->deadline);
+
+    /* All workers of all processes start at the same time. */
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                           &bctx->start, NULL) == EINTR);
+
+    do {
+        op = bench_pick_op(th);
+        idx = rand_r(&th->seed) % bctx->num_users;
+
+        begin = bench_now_ns();
+        result = bench_op_fns[op](th, idx);
+        end = bench_now_ns();
+
+        bench_record(&th->slot->ops[op], result, end - begin);
+    } while (end < deadline);
+
+    return NULL;
+}
+
+static int bench_worker(struct bench_ctx *bctx, int proc, bool no_memcache)
+{
+    struct bench_thread *threads;
+    pthread_t *tids;
+    int started;
+    int i;
+
+    if (no_memcache) {
+        setenv("SSS_NSS_USE_MEMCACHE", "NO", 1);
+    }
+
+    threads = talloc_zero_array(NULL, struct bench_thread,
+                                bctx->opts.threads);
+    tids = talloc_zero_array(threads, pthread_t, bctx->opts.threads);
+    if (threads == NULL || tids == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    for (started = 0; started < bctx->opts.threads; started++) {
+        threads[started].bctx = bctx;
+        threads[started].slot = &bctx->slots[proc * bctx->opts.threads
+                                             + started];
+        threads[started].seed = time(NULL) ^ (getpid() << 8) ^ started;
+        threads[started].buflen = BENCH_BUFSIZE;
+        threads[started].buf = talloc_size(threads, BENCH_BUFSIZE);
+        if (threads[started].buf == NULL) {
+            break;
+        }
+
+        if (pthread_create(&tids[started], NULL, bench_thread_main,
+                           &threads[started]) != 0) {
+            break;
+        }
+    }
+
+    for (i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    talloc_free(threads);
+    return started == bctx->opts.threads ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* === Output === */
+
+static uint64_t bench_percentile(struct bench_op_stats *stats, double p)
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+    size_t i;
+
+    if (stats->count == 0) {
+        return 0;
+    }
+
+    rank = (uint64_t)(p * stats->count);
+    for (i = 0; i < BENCH_BUCKETS; i++) {
+        seen += stats->buckets[i];
+        if (seen > rank) {
+            return bench_bucket_lower(i);
+        }
+    }
+
+    return stats->max_ns;
+}
+
+static void bench_print_op(FILE *out, enum bench_op op,
+                           struct bench_op_stats *stats, double seconds,
+                           bool first)
+{
+    bool first_bucket = true;
+    size_t i;
+
+    fprintf(out, "%s\n        {\"op\": \"%s\", \"count\": %"PRIu64", "
+            "\"notfound\": %"PRIu64", \"errors\": %"PRIu64", "
+            "\"rate\": %.1f,\n", first ? "" : ",", bench_op_names[op],
+            stats->count, stats->notfound, stats->errors,
+            stats->count / seconds);
+    fprintf(out, "         \"latency_ns\": {\"mean\": %"PRIu64", "
+            "\"p50\": %"PRIu64", \"p90\": %"PRIu64", \"p99\": %"PRIu64", "
+            "\"p999\": %"PRIu64", \"max\": %"PRIu64"},\n",
+            stats->count == 0 ? 0 : stats->sum_ns / stats->count,
+            bench_percentile(stats, 0.5), bench_percentile(stats, 0.9),
+            bench_percentile(stats, 0.99), bench_percentile(stats, 0.999),
+            stats->max_ns);
+
+    /* Only buckets that were hit, as [lower bound, count]. */
+    fprintf(out, "         \"histogram\": [");
+    for (i = 0; i < BENCH_BUCKETS; i++) {
+        if (stats->buckets[i] == 0) {
+            continue;
+        }
+        fprintf(out, "%s[%"PRIu64", %"PRIu64"]", first_bucket ? "" : ", ",
+                bench_bucket_lower(i), stats->buckets[i]);
+        first_bucket = false;
+    }
+    fprintf(out, "]}");
+}
+
+static void bench_print_phase(FILE *out, struct bench_ctx *bctx,
+                              const char *name, double seconds, bool first)
+{
+    struct bench_op_stats total[BENCH_OP_SENTINEL];
+    uint64_t all = 0;
+    bool first_op = true;
+    size_t s;
+    size_t b;
+    int op;
+
+    memset(total, 0, sizeof(total));
+    for (s = 0; s < bctx->num_slots; s++) {
+        for (op = 0; op < BENCH_OP_SENTINEL; op++) {
+            struct bench_op_stats *src = &bctx->slots[s].ops[op];
+
+            total[op].count += src->count;
+            total[op].notfound += src->notfound;
+            total[op].errors += src->errors;
+            total[op].sum_ns += src->sum_ns;
+            total[op].max_ns = MAX(total[op].max_ns, src->max_ns);
+            for (b = 0; b < BENCH_BUCKETS; b++) {
+                total[op].buckets[b] += src->buckets[b];
+            }
+        }
+    }
+
+    fprintf(out, "%s\n    {\"phase\": \"%s\", \"seconds\": %.3f, \"ops\": [",
+            first ? "" : ",", name, seconds);
+    for (op = 0; op < BENCH_OP_SENTINEL; op++) {
+        if (bctx->weights[op] == 0) {
+            continue;
+        }
+        bench_print_op(out, op, &total[op], seconds, first_op);
+        all += total[op].count;
+        first_op = false;
+    }
+    fprintf(out, "],\n     \"rate\": %.1f}", all / seconds);
+}
+
+/* === Setup === */
+
+static errno_t bench_parse_workload(struct bench_ctx *bctx)
+{
+    char **items;
+    char *sep;
+    int num;
+    int i;
+    int op;
+    errno_t ret;
+
+    ret = split_on_separator(NULL, bctx->opts.workload, ',', true, true,
+                             &items, &num);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; i < num; i++) {
+        sep = strchr(items[i], ':');
+        if (sep != NULL) {
+            *sep = '\0';
+        }
+
+        for (op = 0; op < BENCH_OP_SENTINEL; op++) {
+            if (strcmp(items[i], bench_op_names[op]) == 0) {
+                break;
+            }
+        }
+        if (op == BENCH_OP_SENTINEL) {
+            fprintf(stderr, "Unknown operation [%s]\n", items[i]);
+            ret = EINVAL;
+            goto done;
+        }
+
+        bctx->weights[op] = sep == NULL ? 1 : strtouint32(sep + 1, NULL, 10);
+        if (errno != 0) {
+            fprintf(stderr, "Invalid weight of [%s]\n", items[i]);
+            ret = EINVAL;
+            goto done;
+        }
+        bctx->weights_sum += bctx->weights[op];
+    }
+
+    if (bctx->weights_sum == 0) {
+        fprintf(stderr, "The workload is empty\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (bctx->weights[BENCH_OP_GRNAM] != 0 && bctx->num_groups == 0) {
+        fprintf(stderr, "The grnam operation needs --groups\n");
+        ret = EINVAL;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(items);
+    return ret;
+}
+
+static errno_t bench_setup(TALLOC_CTX *mem_ctx, struct bench_ctx *bctx)
+{
+    int num;
+    int i;
+    errno_t ret;
+
+    if (bctx->opts.threads <= 0 || bctx->opts.processes <= 0
+            || bctx->opts.duration <= 0
+            || bctx->opts.user_stop < bctx->opts.user_start) {
+        fprintf(stderr, "Invalid thread, process, duration or user range\n");
+        return EINVAL;
+    }
+
+    bctx->num_users = bctx->opts.user_stop - bctx->opts.user_start + 1;
+    bctx->users = talloc_array(mem_ctx, char *, bctx->num_users);
+    if (bctx->users == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < bctx->num_users; i++) {
+        bctx->users[i] = talloc_asprintf(bctx->users, "%s%d",
+                                         bctx->opts.user_prefix,
+                                         bctx->opts.user_start + i);
+        if (bctx->users[i] == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    if (bctx->opts.groups != NULL) {
+        ret = split_on_separator(mem_ctx, bctx->opts.groups, ',', true, true,
+                                 &bctx->groups, &num);
+        if (ret != EOK) {
+            return ret;
+        }
+        bctx->num_groups = num;
+    }
+
+    ret = bench_parse_workload(bctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    bctx->num_slots = bctx->opts.processes * bctx->opts.threads;
+    bctx->slots = mmap(NULL, bctx->num_slots * sizeof(struct bench_slot),
+                       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                       -1, 0);
+    if (bctx->slots == MAP_FAILED) {
+        return errno;
+    }
+
+    return EOK;
+}
+
+static errno_t bench_run_phase(struct bench_ctx *bctx, const char *name,
+                               double *_seconds)
+{
+    bool no_memcache = false;
+    uint64_t begin;
+    pid_t *pids;
+    int status;
+    int failed = 0;
+    int i;
+
+    if (strcmp(name, "cold") == 0) {
+        if (bctx->opts.cold_cmd != NULL && system(bctx->opts.cold_cmd) != 0) {
+            fprintf(stderr, "The command [%s] failed\n", bctx->opts.cold_cmd);
+            return EIO;
+        }
+    } else if (strcmp(name, "socket") == 0) {
+        no_memcache = true;
+    } else if (strcmp(name, "warm") != 0) {
+        fprintf(stderr, "Unknown phase [%s]\n", name);
+        return EINVAL;
+    }
+
+    memset(bctx->slots, 0, bctx->num_slots * sizeof(struct bench_slot));
+
+    clock_gettime(CLOCK_MONOTONIC, &bctx->start);
+    bctx->start.tv_nsec += BENCH_START_DELAY_MS * 1000000L;
+    bctx->start.tv_sec += bctx->start.tv_nsec / 1000000000L;
+    bctx->start.tv_nsec %= 1000000000L;
+    bctx->deadline = bctx->start;
+    bctx->deadline.tv_sec += bctx->opts.duration;
+
+    pids = talloc_zero_array(NULL, pid_t, bctx->opts.processes);
+    if (pids == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < bctx->opts.processes; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            _exit(bench_worker(bctx, i, no_memcache));
+        } else if (pids[i] == -1) {
+            perror("fork");
+            failed++;
+        }
+    }
+
+    for (i = 0; i < bctx->opts.processes; i++) {
+        if (pids[i] <= 0) {
+            continue;
+        }
+        if (waitpid(pids[i], &status, 0) == -1
+                || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed++;
+        }
+    }
+    talloc_free(pids);
+
+    /* The last lookup of every thread may end after the deadline. */
+    begin = bench_ts_ns(&bctx->start);
+    *_seconds = (bench_now_ns() - begin) / 1e9;
+
+    if (failed != 0) {
+        fprintf(stderr, "%d worker processes failed\n", failed);
+        return EIO;
+    }
+
+    return EOK;
+}
+
+int main(int argc, const char *argv[])
+{
+    TALLOC_CTX *mem_ctx;
+    struct bench_ctx bctx;
+    poptContext pc;
+    char **phases;
+    double seconds;
+    FILE *out = stdout;
+    int num_phases;
+    int opt;
+    int i;
+    errno_t ret;
+
+    memset(&bctx, 0, sizeof(bctx));
+    bctx.opts.threads = 1;
+    bctx.opts.processes = 1;
+    bctx.opts.duration = BENCH_DEFAULT_DURATION;
+    bctx.opts.workload = BENCH_DEFAULT_WORKLOAD;
+    bctx.opts.phases = BENCH_DEFAULT_PHASES;
+    bctx.opts.user_prefix = "user";
+    bctx.opts.user_start = 1;
+    bctx.opts.user_stop = 100;
+    bctx.opts.uid_start = 1000;
+    bctx.opts.pam_service = BENCH_DEFAULT_PAM_SERVICE;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "threads", 't', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.threads, 0, "Threads in every process", NULL },
+        { "processes", 'p', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.processes, 0, "Worker processes", NULL },
+        { "duration", 'd', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.duration, 0, "Seconds every phase takes", NULL },
+        { "workload", 'w', POPT_ARG_STRING | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.workload, 0, "Weighted operations: "
+          "pwnam, pwuid, initgroups, grnam, pam", "OP:WEIGHT,..." },
+        { "phases", '\0', POPT_ARG_STRING | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.phases, 0, "Phases to run: cold, warm, socket",
+          "PHASE,..." },
+        { "cold-cmd", '\0', POPT_ARG_STRING, &bctx.opts.cold_cmd, 0,
+          "Command that empties the caches before a cold phase", NULL },
+        { "prefix", '\0', POPT_ARG_STRING | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.user_prefix, 0, "The user name prefix", NULL },
+        { "start", '\0', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.user_start, 0, "Start value to append to prefix", NULL },
+        { "stop", '\0', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.user_stop, 0, "End value to append to prefix", NULL },
+        { "uid-start", '\0', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.uid_start, 0, "UID of the first user", NULL },
+        { "groups", 'g', POPT_ARG_STRING, &bctx.opts.groups, 0,
+          "Groups looked up by grnam", "GROUP,..." },
+        { "pam-service", '\0', POPT_ARG_STRING | POPT_ARGFLAG_SHOW_DEFAULT,
+          &bctx.opts.pam_service, 0, "PAM service used by pam", NULL },
+        { "pam-password", '\0', POPT_ARG_STRING, &bctx.opts.pam_password, 0,
+          "Password of all users", NULL },
+        { "output", 'o', POPT_ARG_STRING, &bctx.opts.output, 0,
+          "Write the JSON results to this file instead of stdout", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                poptBadOption(pc, 0), poptStrerror(opt));
+        poptPrintUsage(pc, stderr, 0);
+        return EXIT_FAILURE;
+    }
+    poptFreeContext(pc);
+
+    mem_ctx = talloc_new(NULL);
+    if (mem_ctx == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    ret = bench_setup(mem_ctx, &bctx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = split_on_separator(mem_ctx, bctx.opts.phases, ',', true, true,
+                             &phases, &num_phases);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (bctx.opts.output != NULL) {
+        out = fopen(bctx.opts.output, "w");
+        if (out == NULL) {
+            ret = errno;
+            perror("fopen");
+            goto done;
+        }
+    }
+
+    fprintf(out, "{\"version\": \"%s\", \"threads\": %d, \"processes\": %d, "
+            "\"duration\": %d, \"workload\": \"%s\", \"phases\": [",
+            VERSION, bctx.opts.threads, bctx.opts.processes,
+            bctx.opts.duration, bctx.opts.workload);
+
+    for (i = 0; i < num_phases; i++) {
+        ret = bench_run_phase(&bctx, phases[i], &seconds);
+        if (ret != EOK) {
+            break;
+        }
+        bench_print_phase(out, &bctx, phases[i], seconds, i == 0);
+        fflush(out);
+    }
+
+    fprintf(out, "\n]}\n");
+    if (out != stdout) {
+        fclose(out);
+    }
+
+done:
+    if (bctx.slots != NULL && bctx.slots != MAP_FAILED) {
+        munmap(bctx.slots, bctx.num_slots * sizeof(struct bench_slot));
+    }
+    talloc_free(mem_ctx);
+    return ret == EOK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
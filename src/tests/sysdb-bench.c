@@ -0,0 +1,706 @@
+/*
+   SSSD
+
+   System Database benchmark
+
+   Builds a cache of configurable size and measures the throughput of the
+   sysdb operations the providers and responders use the most. The results
+   can be stored as a baseline, a later run against that baseline fails
+   when an operation got slower or allocates more than the threshold
+   allows.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <talloc.h>
+#include <popt.h>
+#include <time.h>
+#include <errno.h>
+
+#include "util/util.h"
+#include "db/sysdb.h"
+#include "tests/common.h"
+
+#define DEFAULT_USERS       10000
+#define DEFAULT_GROUPS      1000
+#define DEFAULT_MEMBERS     50
+#define DEFAULT_ROUNDS      3
+#define DEFAULT_THRESHOLD   20
+#define DEFAULT_PATH        "/dev/shm"
+
+#define BENCH_CONFDB        "sysdb-bench-confdb.ldb"
+#define BENCH_DOMAIN        "bench"
+#define BENCH_UID_START     100000
+#define BENCH_GID_START     200000
+#define BENCH_CACHE_TIMEOUT 300
+
+struct bench_ctx {
+    struct sss_test_ctx *tctx;
+    struct sss_domain_info *dom;
+
+    size_t users;
+    size_t groups;
+    size_t members;
+    size_t rounds;
+};
+
+struct bench_result {
+    const char *name;
+    size_t ops;
+    /* operations per second */
+    double rate;
+    /* talloc blocks of the result handed to the caller */
+    double blocks;
+    /* growth of the whole talloc tree, should be zero */
+    double retained;
+
+    uint64_t start_ns;
+    size_t start_blocks;
+    size_t result_blocks;
+};
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_begin(struct bench_result *res, const char *name)
+{
+    res->name = name;
+    res->result_blocks = 0;
+    res->start_blocks = talloc_total_blocks(NULL);
+    res->start_ns = bench_now_ns();
+}
+
+static void bench_end(struct bench_result *res, size_t ops)
+{
+    uint64_t elapsed;
+
+    elapsed = bench_now_ns() - res->start_ns;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+
+    res->ops = ops;
+    res->rate = (double)ops * 1000000000.0 / elapsed;
+    res->blocks = (double)res->result_blocks / ops;
+    res->retained = ((double)talloc_total_blocks(NULL) - res->start_blocks)
+                    / ops;
+}
+
+static char *bench_user(TALLOC_CTX *mem_ctx, struct bench_ctx *bctx,
+                        size_t i)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "benchuser%zu", i);
+    return sss_create_internal_fqname(mem_ctx, name, bctx->dom->name);
+}
+
+static char *bench_group(TALLOC_CTX *mem_ctx, struct bench_ctx *bctx,
+                         size_t i)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "benchgroup%zu", i);
+    return sss_create_internal_fqname(mem_ctx, name, bctx->dom->name);
+}
+
+/* The providers save a whole batch of a search in one transaction */
+static errno_t bench_store_users(struct bench_ctx *bctx,
+                                 struct bench_result *res,
+                                 const char *name)
+{
+    TALLOC_CTX *tmp_ctx;
+    char *user;
+    char home[64];
+    bool in_transaction = false;
+    errno_t ret;
+    size_t i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    bench_begin(res, name);
+
+    ret = sysdb_transaction_start(bctx->dom->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = true;
+
+    for (i = 0; i < bctx->users; i++) {
+        user = bench_user(tmp_ctx, bctx, i);
+        if (user == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        snprintf(home, sizeof(home), "/home/benchuser%zu", i);
+
+        ret = sysdb_store_user(bctx->dom, user, NULL,
+                               BENCH_UID_START + i, BENCH_GID_START + i,
+                               "Benchmark User", home, "/bin/bash",
+                               NULL, NULL, NULL, BENCH_CACHE_TIMEOUT, 0);
+        if (ret != EOK) {
+            goto done;
+        }
+        talloc_free(user);
+    }
+
+    ret = sysdb_transaction_commit(bctx->dom->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = false;
+
+    bench_end(res, bctx->users);
+
+done:
+    if (in_transaction) {
+        sysdb_transaction_cancel(bctx->dom->sysdb);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t bench_store_groups(struct bench_ctx *bctx,
+                                  struct bench_result *res)
+{
+    TALLOC_CTX *tmp_ctx;
+    char *group;
+    bool in_transaction = false;
+    errno_t ret;
+    size_t i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    bench_begin(res, "store_group");
+
+    ret = sysdb_transaction_start(bctx->dom->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = true;
+
+    for (i = 0; i < bctx->groups; i++) {
+        group = bench_group(tmp_ctx, bctx, i);
+        if (group == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sysdb_store_group(bctx->dom, group, BENCH_GID_START + i,
+                                NULL, BENCH_CACHE_TIMEOUT, 0);
+        if (ret != EOK) {
+            goto done;
+        }
+        talloc_free(group);
+    }
+
+    ret = sysdb_transaction_commit(bctx->dom->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = false;
+
+    bench_end(res, bctx->groups);
+
+done:
+    if (in_transaction) {
+        sysdb_transaction_cancel(bctx->dom->sysdb);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Every group gets a contiguous, wrapping, range of users, so every user
+ * is a member of about groups * members / users groups. */
+static errno_t bench_add_members(struct bench_ctx *bctx,
+                                 struct bench_result *res)
+{
+    TALLOC_CTX *tmp_ctx;
+    char *group;
+    char *user;
+    bool in_transaction = false;
+    errno_t ret;
+    size_t i;
+    size_t j;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    bench_begin(res, "add_group_member");
+
+    ret = sysdb_transaction_start(bctx->dom->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = true;
+
+    for (i = 0; i < bctx->groups; i++) {
+        group = bench_group(tmp_ctx, bctx, i);
+        if (group == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (j = 0; j < bctx->members; j++) {
+            user = bench_user(tmp_ctx, bctx,
+                              (i * bctx->members + j) % bctx->users);
+            if (user == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = sysdb_add_group_member(bctx->dom, group, user,
+                                         SYSDB_MEMBER_USER, false);
+            if (ret != EOK && ret != EEXIST) {
+                goto done;
+            }
+            talloc_free(user);
+        }
+        talloc_free(group);
+    }
+
+    ret = sysdb_transaction_commit(bctx->dom->sysdb);
+    if (ret != EOK) {
+        goto done;
+    }
+    in_transaction = false;
+
+    bench_end(res, bctx->groups * bctx->members);
+
+done:
+    if (in_transaction) {
+        sysdb_transaction_cancel(bctx->dom->sysdb);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static errno_t bench_initgroups(struct bench_ctx *bctx,
+                                struct bench_result *res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *result;
+    char *user;
+    errno_t ret;
+    size_t r;
+    size_t i;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    bench_begin(res, "initgroups");
+
+    for (r = 0; r < bctx->rounds; r++) {
+        for (i = 0; i < bctx->users; i++) {
+            user = bench_user(tmp_ctx, bctx, i);
+            if (user == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+
+            ret = sysdb_initgroups(tmp_ctx, bctx->dom, user, &result);
+            if (ret != EOK) {
+                goto done;
+            }
+
+            res->result_blocks += talloc_total_blocks(result);
+            talloc_free(result);
+            talloc_free(user);
+        }
+    }
+
+    bench_end(res, bctx->rounds * bctx->users);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* The filter is on an attribute kept in the timestamp cache, so both
+ * caches are searched and the results merged. Every round asks for a
+ * different window of the users. */
+static errno_t bench_search_ts(struct bench_ctx *bctx,
+                               struct bench_result *res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *base_dn;
+    struct ldb_result *result;
+    const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM,
+                            SYSDB_CACHE_EXPIRE, NULL };
+    char *filter;
+    size_t searches;
+    size_t i;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    base_dn = sysdb_user_base_dn(tmp_ctx, bctx->dom);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    searches = bctx->rounds * 10;
+
+    bench_begin(res, "search_with_ts_attr");
+
+    for (i = 0; i < searches; i++) {
+        filter = talloc_asprintf(tmp_ctx,
+                                 "(&("SYSDB_UC")("SYSDB_CACHE_EXPIRE">=1)"
+                                 "("SYSDB_UIDNUM">=%zu)"
+                                 "("SYSDB_UIDNUM"<=%zu))",
+                                 BENCH_UID_START + i * bctx->users / searches,
+                                 BENCH_UID_START + bctx->users);
+        if (filter == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        ret = sysdb_search_with_ts_attr(tmp_ctx, bctx->dom, base_dn,
+                                        LDB_SCOPE_SUBTREE,
+                                        SYSDB_CACHE_TYPE_NONE,
+                                        filter, attrs, &result);
+        if (ret != EOK) {
+            goto done;
+        }
+
+        res->result_blocks += talloc_total_blocks(result);
+        talloc_free(result);
+        talloc_free(filter);
+    }
+
+    bench_end(res, searches);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Enumeration merges the timestamp attributes into every entry */
+static errno_t bench_enumpwent(struct bench_ctx *bctx,
+                               struct bench_result *res)
+{
+    struct ldb_result *result;
+    errno_t ret;
+    size_t r;
+
+    bench_begin(res, "enumpwent");
+
+    for (r = 0; r < bctx->rounds; r++) {
+        ret = sysdb_enumpwent(NULL, bctx->dom, &result);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        if (result->count != bctx->users) {
+            fprintf(stderr, "Enumeration returned %u users instead of %zu\n",
+                    result->count, bctx->users);
+            talloc_free(result);
+            return EIO;
+        }
+
+        res->result_blocks += talloc_total_blocks(result);
+        talloc_free(result);
+    }
+
+    bench_end(res, bctx->rounds);
+    return EOK;
+}
+
+static struct bench_result *
+bench_find(struct bench_result *results, size_t count, const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (strcmp(results[i].name, name) == 0) {
+            return &results[i];
+        }
+    }
+
+    return NULL;
+}
+
+static errno_t bench_save_baseline(const char *path,
+                                   struct bench_result *results,
+                                   size_t count)
+{
+    FILE *f;
+    size_t i;
+    errno_t ret;
+
+    f = fopen(path, "w");
+    if (f == NULL) {
+        ret = errno;
+        fprintf(stderr, "Cannot open %s [%d]: %s\n",
+                path, ret, strerror(ret));
+        return ret;
+    }
+
+    fprintf(f, "# operation rate blocks\n");
+    for (i = 0; i < count; i++) {
+        fprintf(f, "%s %.1f %.1f\n",
+                results[i].name, results[i].rate, results[i].blocks);
+    }
+
+    ret = fclose(f) == 0 ? EOK : errno;
+    if (ret != EOK) {
+        fprintf(stderr, "Cannot write %s [%d]: %s\n",
+                path, ret, strerror(ret));
+    }
+    return ret;
+}
+
+/* Returns EOK if nothing regressed more than threshold percent, ERANGE
+ * otherwise. Operations missing from the baseline are not compared. */
+static errno_t bench_compare_baseline(const char *path, int threshold,
+                                      struct bench_result *results,
+                                      size_t count)
+{
+    struct bench_result *res;
+    char line[256];
+    char name[64];
+    double rate;
+    double blocks;
+    double min_rate;
+    double max_blocks;
+    bool regressed = false;
+    FILE *f;
+    errno_t ret;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        ret = errno;
+        fprintf(stderr, "Cannot open %s [%d]: %s\n",
+                path, ret, strerror(ret));
+        return ret;
+    }
+
+    printf("\n%-20s %12s %12s %10s %10s  %s\n",
+           "operation", "base [1/s]", "now [1/s]",
+           "base blk", "now blk", "result");
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        if (sscanf(line, "%63s %lf %lf", name, &rate, &blocks) != 3) {
+            fprintf(stderr, "Malformed baseline line: %s", line);
+            continue;
+        }
+
+        res = bench_find(results, count, name);
+        if (res == NULL) {
+            continue;
+        }
+
+        min_rate = rate * (100 - threshold) / 100;
+        /* one block of slack, results of a few blocks would otherwise
+         * fail on any change */
+        max_blocks = blocks * (100 + threshold) / 100 + 1;
+
+        printf("%-20s %12.1f %12.1f %10.1f %10.1f  %s\n",
+               name, rate, res->rate, blocks, res->blocks,
+               (res->rate < min_rate || res->blocks > max_blocks)
+                    ? "REGRESSED" : "ok");
+
+        if (res->rate < min_rate || res->blocks > max_blocks) {
+            regressed = true;
+        }
+    }
+
+    fclose(f);
+    return regressed ? ERANGE : EOK;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int pc_users = DEFAULT_USERS;
+    int pc_groups = DEFAULT_GROUPS;
+    int pc_members = DEFAULT_MEMBERS;
+    int pc_rounds = DEFAULT_ROUNDS;
+    int pc_threshold = DEFAULT_THRESHOLD;
+    const char *pc_path = DEFAULT_PATH;
+    const char *pc_baseline = NULL;
+    const char *pc_save = NULL;
+    struct sss_test_conf_param params[] = {
+        { "cache_credentials", "false" },
+        { NULL, NULL },
+    };
+    struct bench_result results[7];
+    struct bench_ctx bctx;
+    char *tests_path = NULL;
+    size_t count = 0;
+    errno_t ret;
+    size_t i;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        { "users", 'u', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_users, 0, "Number of users in the cache", NULL },
+        { "groups", 'g', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_groups, 0, "Number of groups in the cache", NULL },
+        { "members", 'm', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_members, 0, "Number of members of every group",
+                    NULL },
+        { "rounds", 'r', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_rounds, 0, "How many times the searches are repeated",
+                    NULL },
+        { "path", 'p', POPT_ARG_STRING | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_path, 0,
+                    "Directory the caches are created in, preferably a tmpfs",
+                    NULL },
+        { "baseline", 'b', POPT_ARG_STRING, &pc_baseline, 0,
+                    "Compare the results with this baseline", NULL },
+        { "save-baseline", 's', POPT_ARG_STRING, &pc_save, 0,
+                    "Store the results as a baseline", NULL },
+        { "threshold", 't', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_threshold, 0,
+                    "Allowed regression against the baseline in percent",
+                    NULL },
+        POPT_TABLEEND
+    };
+
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                poptBadOption(pc, 0), poptStrerror(opt));
+        poptPrintUsage(pc, stderr, 0);
+        return 1;
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    if (pc_users <= 0 || pc_groups <= 0 || pc_members <= 0
+            || pc_rounds <= 0) {
+        fprintf(stderr, "Users, groups, members and rounds must be "
+                "positive\n");
+        return 1;
+    }
+
+    if (pc_threshold < 0 || pc_threshold >= 100) {
+        fprintf(stderr, "The threshold must be between 0 and 99\n");
+        return 1;
+    }
+
+    /* Counts the blocks of the whole tree, see bench_result.retained */
+    talloc_enable_null_tracking();
+
+    tests_path = talloc_asprintf(NULL, "%s/sysdb-bench-XXXXXX", pc_path);
+    if (tests_path == NULL || mkdtemp(tests_path) == NULL) {
+        fprintf(stderr, "Cannot create a directory in %s\n", pc_path);
+        talloc_free(tests_path);
+        return 1;
+    }
+
+    bctx.users = pc_users;
+    bctx.groups = pc_groups;
+    bctx.members = MIN(pc_members, pc_users);
+    bctx.rounds = pc_rounds;
+
+    /* Not the local provider, so the timestamp cache is used */
+    bctx.tctx = create_dom_test_ctx(NULL, tests_path, BENCH_CONFDB,
+                                    BENCH_DOMAIN, "ldap", params);
+    if (bctx.tctx == NULL) {
+        fprintf(stderr, "Cannot create the cache in %s\n", tests_path);
+        ret = EIO;
+        goto done;
+    }
+    bctx.dom = bctx.tctx->dom;
+
+    printf("%zu users, %zu groups with %zu members in %s\n\n",
+           bctx.users, bctx.groups, bctx.members, tests_path);
+
+    ret = bench_store_users(&bctx, &results[count++], "store_user");
+    if (ret != EOK) goto done;
+
+    ret = bench_store_groups(&bctx, &results[count++]);
+    if (ret != EOK) goto done;
+
+    ret = bench_add_members(&bctx, &results[count++]);
+    if (ret != EOK) goto done;
+
+    /* The entries did not change, only the timestamp cache is written */
+    ret = bench_store_users(&bctx, &results[count++], "store_user_ts");
+    if (ret != EOK) goto done;
+
+    ret = bench_initgroups(&bctx, &results[count++]);
+    if (ret != EOK) goto done;
+
+    ret = bench_search_ts(&bctx, &results[count++]);
+    if (ret != EOK) goto done;
+
+    ret = bench_enumpwent(&bctx, &results[count++]);
+    if (ret != EOK) goto done;
+
+    printf("%-20s %10s %14s %10s %10s\n",
+           "operation", "ops", "rate [1/s]", "blocks", "retained");
+    for (i = 0; i < count; i++) {
+        printf("%-20s %10zu %14.1f %10.1f %10.2f\n",
+               results[i].name, results[i].ops, results[i].rate,
+               results[i].blocks, results[i].retained);
+    }
+
+    if (pc_save != NULL) {
+        ret = bench_save_baseline(pc_save, results, count);
+        if (ret != EOK) goto done;
+    }
+
+    if (pc_baseline != NULL) {
+        ret = bench_compare_baseline(pc_baseline, pc_threshold,
+                                     results, count);
+        if (ret == ERANGE) {
+            fprintf(stderr, "\nRegression of more than %d%% against %s\n",
+                    pc_threshold, pc_baseline);
+        }
+    }
+
+done:
+    if (ret != EOK && ret != ERANGE) {
+        fprintf(stderr, "Benchmark failed [%d]: %s\n", ret, sss_strerror(ret));
+    }
+    talloc_free(bctx.tctx);
+    test_dom_suite_cleanup(tests_path, BENCH_CONFDB, BENCH_DOMAIN);
+    talloc_free(tests_path);
+    return ret == EOK ? 0 : 1;
+}
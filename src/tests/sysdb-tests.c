@@ -724,6 +724,280 @@ START_TEST (test_sysdb_user_new_id)
 }
 END_TEST
 
+START_TEST (test_sysdb_write_batch)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct ldb_message *msg;
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    const char *user1;
+    const char *user2;
+    int ret;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    user1 = sss_create_internal_fqname(test_ctx, "batchuser1",
+                                       test_ctx->domain->name);
+    user2 = sss_create_internal_fqname(test_ctx, "batchuser2",
+                                       test_ctx->domain->name);
+    fail_if(user1 == NULL || user2 == NULL);
+
+    ret = sysdb_set_write_batch(test_ctx->sysdb, test_ctx->ev, 10);
+    fail_if(ret != EOK);
+
+    /* a cancelled transaction rolls back the whole batch */
+    ret = sysdb_add_user(test_ctx->domain, user1, 7001, 7001, user1, "/",
+                         "/bin/bash", NULL, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add user %s", user1);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, user1,
+                                    attrs, &msg);
+    fail_if(ret != EOK, "Batched user %s is not visible", user1);
+
+    ret = sysdb_transaction_start(test_ctx->sysdb);
+    fail_if(ret != EOK);
+
+    ret = sysdb_add_user(test_ctx->domain, user2, 7002, 7002, user2, "/",
+                         "/bin/bash", NULL, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add user %s", user2);
+
+    ret = sysdb_transaction_cancel(test_ctx->sysdb);
+    fail_if(ret != EOK);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, user1,
+                                    attrs, &msg);
+    fail_unless(ret == ENOENT, "User %s was not rolled back", user1);
+
+    /* a flushed batch is kept */
+    ret = sysdb_add_user(test_ctx->domain, user1, 7001, 7001, user1, "/",
+                         "/bin/bash", NULL, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add user %s", user1);
+
+    ret = sysdb_transaction_flush(test_ctx->sysdb);
+    fail_if(ret != EOK);
+
+    ret = sysdb_transaction_start(test_ctx->sysdb);
+    fail_if(ret != EOK);
+
+    ret = sysdb_add_user(test_ctx->domain, user2, 7002, 7002, user2, "/",
+                         "/bin/bash", NULL, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add user %s", user2);
+
+    ret = sysdb_transaction_cancel(test_ctx->sysdb);
+    fail_if(ret != EOK);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, user1,
+                                    attrs, &msg);
+    fail_if(ret != EOK, "Flushed user %s was rolled back", user1);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, user2,
+                                    attrs, &msg);
+    fail_unless(ret == ENOENT, "User %s was not rolled back", user2);
+
+    ret = sysdb_set_write_batch(test_ctx->sysdb, test_ctx->ev, 0);
+    fail_if(ret != EOK);
+
+    ret = sysdb_delete_user(test_ctx->domain, user1, 0);
+    fail_unless(ret == EOK, "sysdb_delete_user error [%d][%s]",
+                            ret, strerror(ret));
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+START_TEST (test_sysdb_checkpoint)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct sss_domain_info *domain;
+    struct ldb_message *msg;
+    const char *attrs[] = { SYSDB_NAME, NULL };
+    const char *user;
+    char *volatile_file;
+    int ret;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+    domain = test_ctx->domain;
+
+    user = sss_create_internal_fqname(test_ctx, "checkpointuser",
+                                      domain->name);
+    fail_if(user == NULL);
+
+    /* the volatile cache is created from the durable one */
+    talloc_zfree(domain->sysdb);
+    ret = sysdb_domain_init_internal(domain, domain, TESTS_PATH,
+                                     TESTS_PATH "/volatile", NULL,
+                                     &domain->sysdb);
+    fail_if(ret != EOK, "Could not open the volatile cache");
+    fail_if(domain->sysdb->ldb_checkpoint_file == NULL);
+
+    volatile_file = talloc_strdup(test_ctx, domain->sysdb->ldb_file);
+    fail_if(volatile_file == NULL);
+
+    ret = sysdb_add_user(domain, user, 7010, 7010, user, "/",
+                         "/bin/bash", NULL, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add user %s", user);
+
+    ret = sysdb_checkpoint(domain->sysdb);
+    fail_if(ret != EOK, "sysdb_checkpoint error [%d][%s]",
+                        ret, strerror(ret));
+
+    /* the durable cache contains the user now */
+    talloc_zfree(domain->sysdb);
+    ret = sysdb_domain_init(domain, domain, TESTS_PATH, &domain->sysdb);
+    fail_if(ret != EOK, "Could not reopen the cache");
+    test_ctx->sysdb = domain->sysdb;
+
+    ret = sysdb_search_user_by_name(test_ctx, domain, user, attrs, &msg);
+    fail_if(ret != EOK, "User %s is not in the checkpoint", user);
+
+    ret = sysdb_delete_user(domain, user, 0);
+    fail_unless(ret == EOK, "sysdb_delete_user error [%d][%s]",
+                            ret, strerror(ret));
+
+    unlink(volatile_file);
+    rmdir(TESTS_PATH "/volatile");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+START_TEST (test_sysdb_initgr_index)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct sss_domain_info *domain;
+    struct ldb_result *res;
+    struct sysdb_attrs *attrs;
+    const char *user;
+    const char *group1;
+    const char *group2;
+    const char *group3;
+    uint32_t gid1;
+    uint32_t gid2;
+    int ret;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+    domain = test_ctx->domain;
+
+    user = sss_create_internal_fqname(test_ctx, "idxuser", domain->name);
+    group1 = sss_create_internal_fqname(test_ctx, "idxgroup1", domain->name);
+    group2 = sss_create_internal_fqname(test_ctx, "idxgroup2", domain->name);
+    group3 = sss_create_internal_fqname(test_ctx, "idxgroup3", domain->name);
+    fail_if(user == NULL || group1 == NULL || group2 == NULL || group3 == NULL);
+
+    ret = sysdb_add_user(domain, user, 7020, 7020, user, "/", "/bin/bash",
+                         NULL, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add user %s", user);
+
+    ret = sysdb_add_group(domain, group1, 7021, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add group %s", group1);
+
+    ret = sysdb_add_group(domain, group2, 7022, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add group %s", group2);
+
+    ret = sysdb_add_group(domain, group3, 7024, NULL, 0, 0);
+    fail_if(ret != EOK, "Could not add group %s", group3);
+
+    /* user -> group2 -> group1 */
+    ret = sysdb_add_group_member(domain, group2, user, SYSDB_MEMBER_USER,
+                                 false);
+    fail_if(ret != EOK);
+
+    ret = sysdb_add_group_member(domain, group1, group2, SYSDB_MEMBER_GROUP,
+                                 false);
+    fail_if(ret != EOK);
+
+    /* no index yet */
+    ret = sysdb_initgroups_gids(test_ctx, domain, user, &res);
+    fail_unless(ret == ENOENT, "Unexpected index of %s", user);
+
+    ret = sysdb_initgroups(test_ctx, domain, user, &res);
+    fail_if(ret != EOK);
+
+    ret = sysdb_set_initgr_index(domain, res);
+    fail_if(ret != EOK, "sysdb_set_initgr_index error [%d][%s]",
+                        ret, strerror(ret));
+
+    ret = sysdb_initgroups_gids(test_ctx, domain, user, &res);
+    fail_if(ret != EOK, "sysdb_initgroups_gids error [%d][%s]",
+                        ret, strerror(ret));
+    ck_assert_int_eq(res->count, 3);
+    ck_assert_str_eq(ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_NAME,
+                                                 NULL), user);
+    gid1 = ldb_msg_find_attr_as_uint(res->msgs[1], SYSDB_GIDNUM, 0);
+    gid2 = ldb_msg_find_attr_as_uint(res->msgs[2], SYSDB_GIDNUM, 0);
+    fail_unless((gid1 == 7021 && gid2 == 7022)
+                    || (gid1 == 7022 && gid2 == 7021),
+                "Unexpected group ids %u, %u", gid1, gid2);
+
+    /* storing the same group id keeps the index */
+    attrs = sysdb_new_attrs(test_ctx);
+    fail_if(attrs == NULL);
+    ret = sysdb_attrs_add_uint32(attrs, SYSDB_GIDNUM, 7021);
+    fail_if(ret != EOK);
+
+    ret = sysdb_set_group_attr(domain, group1, attrs, SYSDB_MOD_REP);
+    fail_if(ret != EOK);
+
+    ret = sysdb_initgroups_gids(test_ctx, domain, user, &res);
+    fail_if(ret != EOK, "Index of %s was dropped", user);
+
+    /* a new group id drops it */
+    attrs = sysdb_new_attrs(test_ctx);
+    fail_if(attrs == NULL);
+    ret = sysdb_attrs_add_uint32(attrs, SYSDB_GIDNUM, 7023);
+    fail_if(ret != EOK);
+
+    ret = sysdb_set_group_attr(domain, group1, attrs, SYSDB_MOD_REP);
+    fail_if(ret != EOK);
+
+    ret = sysdb_initgroups_gids(test_ctx, domain, user, &res);
+    fail_unless(ret == ENOENT, "Stale index of %s after gid change", user);
+
+    ret = sysdb_initgroups(test_ctx, domain, user, &res);
+    fail_if(ret != EOK);
+
+    ret = sysdb_set_initgr_index(domain, res);
+    fail_if(ret != EOK);
+
+    ret = sysdb_initgroups_gids(test_ctx, domain, user, &res);
+    fail_if(ret != EOK);
+
+    /* so does a new membership */
+    ret = sysdb_add_group_member(domain, group3, user, SYSDB_MEMBER_USER,
+                                 false);
+    fail_if(ret != EOK);
+
+    ret = sysdb_initgroups_gids(test_ctx, domain, user, &res);
+    fail_unless(ret == ENOENT, "Stale index of %s after new membership",
+                user);
+
+    ret = sysdb_delete_user(domain, user, 0);
+    fail_if(ret != EOK);
+    ret = sysdb_delete_group(domain, group1, 0);
+    fail_if(ret != EOK);
+    ret = sysdb_delete_group(domain, group2, 0);
+    fail_if(ret != EOK);
+    ret = sysdb_delete_group(domain, group3, 0);
+    fail_if(ret != EOK);
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST (test_sysdb_store_user)
 {
     struct sysdb_test_ctx *test_ctx;
@@ -5371,6 +5645,51 @@ START_TEST(test_sysdb_attrs_add_val)
 }
 END_TEST
 
+START_TEST(test_sysdb_attrs_add_vals)
+{
+    int ret;
+    struct sysdb_attrs *attrs;
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_val vals[] = {
+        {discard_const("first"), sizeof("first") - 1},
+        {discard_const("second"), sizeof("second") - 1},
+    };
+    struct ldb_val val = {discard_const(TEST_ATTR_VALUE),
+                          sizeof(TEST_ATTR_VALUE) - 1};
+
+    tmp_ctx = talloc_new(NULL);
+    fail_unless(tmp_ctx != NULL, "talloc_new failed");
+
+    attrs = sysdb_new_attrs(tmp_ctx);
+    fail_unless(attrs != NULL, "sysdb_new_attrs failed");
+
+    ret = sysdb_attrs_add_vals(attrs, TEST_ATTR_NAME, vals, 0);
+    fail_unless(ret == EOK, "sysdb_attrs_add_vals failed.");
+    fail_unless(attrs->num == 0, "Unexpected number of attributes.");
+
+    ret = sysdb_attrs_add_val(attrs, TEST_ATTR_NAME, &val);
+    fail_unless(ret == EOK, "sysdb_attrs_add_val failed.");
+
+    ret = sysdb_attrs_add_vals(attrs, TEST_ATTR_NAME, vals, 2);
+    fail_unless(ret == EOK, "sysdb_attrs_add_vals failed.");
+
+    fail_unless(attrs->num == 1, "Unexpected number of attributes.");
+    fail_unless(attrs->a[0].num_values == 3,
+                "Unexpected number of attribute values.");
+    fail_unless(ldb_val_string_cmp(&attrs->a[0].values[0],
+                                   TEST_ATTR_VALUE) == 0,
+                "Unexpected attribute value.");
+    fail_unless(strcmp((const char *)attrs->a[0].values[1].data,
+                       "first") == 0,
+                "Unexpected attribute value.");
+    fail_unless(strcmp((const char *)attrs->a[0].values[2].data,
+                       "second") == 0,
+                "Unexpected attribute value.");
+
+    talloc_free(tmp_ctx);
+}
+END_TEST
+
 START_TEST(test_sysdb_attrs_add_val_safe)
 {
     int ret;
@@ -5731,6 +6050,53 @@ START_TEST(test_sysdb_has_enumerated)
 }
 END_TEST
 
+START_TEST(test_sysdb_sync_cookie)
+{
+    errno_t ret;
+    struct sysdb_test_ctx *test_ctx;
+    const uint8_t cookie[] = { 'r', 'i', 'd', '=', '0', 0x00, 0xff };
+    uint8_t *stored;
+    size_t stored_len;
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_if(ret != EOK, "Could not set up the test");
+
+    ret = sysdb_get_sync_cookie(test_ctx, test_ctx->domain,
+                                SYSDB_USER_SYNC_COOKIE,
+                                &stored, &stored_len);
+    fail_if(ret != ENOENT, "Expected ENOENT, got [%d][%s]",
+            ret, strerror(ret));
+
+    ret = sysdb_set_sync_cookie(test_ctx->domain, SYSDB_USER_SYNC_COOKIE,
+                                cookie, sizeof(cookie));
+    fail_if(ret != EOK, "Error [%d][%s] setting the cookie",
+            ret, strerror(ret));
+
+    ret = sysdb_get_sync_cookie(test_ctx, test_ctx->domain,
+                                SYSDB_USER_SYNC_COOKIE,
+                                &stored, &stored_len);
+    fail_if(ret != EOK, "Error [%d][%s] reading the cookie",
+            ret, strerror(ret));
+    fail_unless(stored_len == sizeof(cookie)
+                    && memcmp(stored, cookie, sizeof(cookie)) == 0,
+                "Unexpected cookie");
+
+    ret = sysdb_set_sync_cookie(test_ctx->domain, SYSDB_USER_SYNC_COOKIE,
+                                NULL, 0);
+    fail_if(ret != EOK, "Error [%d][%s] removing the cookie",
+            ret, strerror(ret));
+
+    ret = sysdb_get_sync_cookie(test_ctx, test_ctx->domain,
+                                SYSDB_USER_SYNC_COOKIE,
+                                &stored, &stored_len);
+    fail_if(ret != ENOENT, "Expected ENOENT, got [%d][%s]",
+            ret, strerror(ret));
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST(test_sysdb_original_dn_case_insensitive)
 {
     errno_t ret;
@@ -6310,6 +6676,44 @@ START_TEST(test_sysdb_delete_by_sid)
 }
 END_TEST
 
+START_TEST(test_sysdb_negcache)
+{
+    errno_t ret;
+    struct sysdb_test_ctx *test_ctx;
+    const char *key = "0x1:3:S-1-5-21-1-2-3-1234";
+
+    /* Setup */
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_if(ret != EOK, "Could not set up the test");
+
+    check_leaks_push(test_ctx);
+
+    ret = sysdb_negcache_check(test_ctx->domain, key);
+    fail_unless(ret == ENOENT, "Unexpected entry [%d][%s].",
+                ret, strerror(ret));
+
+    ret = sysdb_negcache_set(test_ctx->domain, key, 60);
+    fail_unless(ret == EOK, "sysdb_negcache_set failed with [%d][%s].",
+                ret, strerror(ret));
+
+    ret = sysdb_negcache_check(test_ctx->domain, key);
+    fail_unless(ret == EEXIST, "Entry not found [%d][%s].",
+                ret, strerror(ret));
+
+    /* Storing the key again replaces the old entry. */
+    ret = sysdb_negcache_set(test_ctx->domain, key, 120);
+    fail_unless(ret == EOK, "sysdb_negcache_set failed with [%d][%s].",
+                ret, strerror(ret));
+
+    ret = sysdb_negcache_check(test_ctx->domain, "0x2:3:S-1-5-21-1-2-3-1234");
+    fail_unless(ret == ENOENT, "Unexpected entry [%d][%s].",
+                ret, strerror(ret));
+
+    fail_unless(check_leaks_pop(test_ctx) == true, "Memory leak");
+    talloc_free(test_ctx);
+}
+END_TEST
+
 const char *const testdom[4] = { "test.sub", "TEST.SUB", "test", "S-3" };
 
 START_TEST(test_sysdb_subdomain_store_user)
@@ -7799,6 +8203,11 @@ Suite *create_sysdb_suite(void)
     /* Add a user with an automatic ID */
     tcase_add_test(tc_sysdb, test_sysdb_user_new_id);
 
+    /* Commit transactions in batches */
+    tcase_add_test(tc_sysdb, test_sysdb_write_batch);
+    tcase_add_test(tc_sysdb, test_sysdb_checkpoint);
+    tcase_add_test(tc_sysdb, test_sysdb_initgr_index);
+
     /* Create a new user */
     tcase_add_loop_test(tc_sysdb, test_sysdb_add_user, 27000, 27010);
 
@@ -7939,6 +8348,7 @@ Suite *create_sysdb_suite(void)
     tcase_add_test(tc_sysdb, test_sysdb_search_custom);
     tcase_add_test(tc_sysdb, test_sysdb_delete_custom);
     tcase_add_test(tc_sysdb, test_sysdb_delete_by_sid);
+    tcase_add_test(tc_sysdb, test_sysdb_negcache);
 
     /* test recursive delete */
     tcase_add_test(tc_sysdb, test_sysdb_delete_recursive);
@@ -7953,6 +8363,9 @@ Suite *create_sysdb_suite(void)
     /* Test sysdb enumerated flag */
     tcase_add_test(tc_sysdb, test_sysdb_has_enumerated);
 
+    /* Test the content synchronization cookie */
+    tcase_add_test(tc_sysdb, test_sysdb_sync_cookie);
+
     /* Test originalDN searches */
     tcase_add_test(tc_sysdb, test_sysdb_original_dn_case_insensitive);
 
@@ -8029,6 +8442,7 @@ Suite *create_sysdb_suite(void)
 /* ===== UTIL TESTS ===== */
     tcase_add_test(tc_sysdb, test_sysdb_attrs_get_string_array);
     tcase_add_test(tc_sysdb, test_sysdb_attrs_add_val);
+    tcase_add_test(tc_sysdb, test_sysdb_attrs_add_vals);
     tcase_add_test(tc_sysdb, test_sysdb_attrs_add_val_safe);
     tcase_add_test(tc_sysdb, test_sysdb_attrs_add_string_safe);
     tcase_add_test(tc_sysdb, test_sysdb_attrs_copy);
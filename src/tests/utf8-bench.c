@@ -0,0 +1,234 @@
+/*
+   SSSD
+
+   UTF-8 case folding benchmark
+
+   Compares the time needed to lower case and to compare names that are
+   ASCII only, which do not need the unicode library, with names that
+   contain other characters.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <talloc.h>
+#include <popt.h>
+#include <time.h>
+
+#include "util/util.h"
+#include "util/sss_utf8.h"
+
+#define DEFAULT_ITERATIONS 1000000
+
+/* Typical user and group names of different lengths. */
+static const char *ascii_names[] = {
+    "Admin",
+    "JSmith",
+    "Domain Users",
+    "Administrator@AD.EXAMPLE.COM",
+    "svc-backup-storage-cluster-01@EXAMPLE.COM",
+    NULL
+};
+
+static const char *ascii_names_lower[] = {
+    "admin",
+    "jsmith",
+    "domain users",
+    "administrator@ad.example.com",
+    "svc-backup-storage-cluster-01@example.com",
+    NULL
+};
+
+static const char *utf8_names[] = {
+    "M\xC3\x9C" "NCHEN",
+    "\xC4\x8C" "ech",
+    "Dom\xC3\xA9ne Utilisateurs",
+    "Administr\xC3\xA1tor@AD.EXAMPLE.COM",
+    "svc-backup-st\xC3\x96rage-cluster-01@EXAMPLE.COM",
+    NULL
+};
+
+static const char *utf8_names_lower[] = {
+    "m\xC3\xBC" "nchen",
+    "\xC4\x8D" "ech",
+    "dom\xC3\xA9ne utilisateurs",
+    "administr\xC3\xA1tor@ad.example.com",
+    "svc-backup-st\xC3\xB6rage-cluster-01@example.com",
+    NULL
+};
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_print(const char *what, const char *kind,
+                        uint64_t ns, size_t ops)
+{
+    printf("%-10s %-8s %10zu %12.1f\n", what, kind, ops, (double)ns / ops);
+}
+
+static errno_t bench_tolower(TALLOC_CTX *mem_ctx, const char *kind,
+                             const char **names, int iterations)
+{
+    uint64_t start;
+    size_t ops = 0;
+    char *lower;
+    int i;
+    int j;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++) {
+        for (j = 0; names[j] != NULL; j++) {
+            lower = sss_tc_utf8_str_tolower(mem_ctx, names[j]);
+            if (lower == NULL) {
+                return ENOMEM;
+            }
+            talloc_free(lower);
+            ops++;
+        }
+    }
+    bench_print("tolower", kind, bench_now_ns() - start, ops);
+
+    return EOK;
+}
+
+/* The unicode library path for ASCII names, as used before the fast path
+ * was added. */
+static errno_t bench_tolower_library(const char **names, int iterations)
+{
+    uint64_t start;
+    size_t ops = 0;
+    uint8_t *lower;
+    size_t nlen;
+    int i;
+    int j;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++) {
+        for (j = 0; names[j] != NULL; j++) {
+            lower = sss_utf8_tolower((const uint8_t *)names[j],
+                                     strlen(names[j]), &nlen);
+            if (lower == NULL) {
+                return ENOMEM;
+            }
+            sss_utf8_free(lower);
+            ops++;
+        }
+    }
+    bench_print("tolower", "library", bench_now_ns() - start, ops);
+
+    return EOK;
+}
+
+static errno_t bench_case_eq(const char *kind,
+                             const char **names,
+                             const char **names_lower,
+                             int iterations)
+{
+    uint64_t start;
+    size_t ops = 0;
+    errno_t ret;
+    int i;
+    int j;
+
+    start = bench_now_ns();
+    for (i = 0; i < iterations; i++) {
+        for (j = 0; names[j] != NULL; j++) {
+            ret = sss_utf8_case_eq((const uint8_t *)names[j],
+                                   (const uint8_t *)names_lower[j]);
+            if (ret != EOK) {
+                fprintf(stderr, "%s and %s do not match\n",
+                        names[j], names_lower[j]);
+                return EINVAL;
+            }
+            ops++;
+        }
+    }
+    bench_print("case_eq", kind, bench_now_ns() - start, ops);
+
+    return EOK;
+}
+
+int main(int argc, const char *argv[])
+{
+    int opt;
+    poptContext pc;
+    int pc_iterations = DEFAULT_ITERATIONS;
+    TALLOC_CTX *mem_ctx;
+    errno_t ret;
+
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        { "iterations", 'i', POPT_ARG_INT | POPT_ARGFLAG_SHOW_DEFAULT,
+                    &pc_iterations, 0,
+                    "How many times every name is processed", NULL },
+        POPT_TABLEEND
+    };
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while ((opt = poptGetNextOpt(pc)) != -1) {
+        fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                poptBadOption(pc, 0), poptStrerror(opt));
+        poptPrintUsage(pc, stderr, 0);
+        return 1;
+    }
+    poptFreeContext(pc);
+
+    if (pc_iterations <= 0) {
+        fprintf(stderr, "Iterations must be positive\n");
+        return 1;
+    }
+
+    mem_ctx = talloc_new(NULL);
+    if (mem_ctx == NULL) {
+        return 1;
+    }
+
+    printf("%-10s %-8s %10s %12s\n", "operation", "names", "ops", "ns/op");
+
+    ret = bench_tolower(mem_ctx, "ascii", ascii_names, pc_iterations);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = bench_tolower_library(ascii_names, pc_iterations);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = bench_tolower(mem_ctx, "utf8", utf8_names, pc_iterations);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = bench_case_eq("ascii", ascii_names, ascii_names_lower,
+                        pc_iterations);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = bench_case_eq("utf8", utf8_names, utf8_names_lower,
+                        pc_iterations);
+    if (ret != EOK) {
+        goto done;
+    }
+
+done:
+    talloc_free(mem_ctx);
+    return ret == EOK ? 0 : 1;
+}
@@ -543,6 +543,56 @@ START_TEST(test_utf8_caseeq)
 }
 END_TEST
 
+START_TEST(test_utf8_ascii)
+{
+    const char *upcase = "Domain Users Of The Test Realm";
+    const char *lowcase = "domain users of the test realm";
+    const uint8_t munchen_utf8_upcase[] = { 'M', 0xC3, 0x9C, 'N', 'C', 'H', 'E', 'N', 0x0 };
+    uint8_t all[128];
+    uint8_t all_lower[128];
+    char *lcase;
+    errno_t ret;
+    int i;
+
+    TALLOC_CTX *test_ctx;
+    test_ctx = talloc_new(NULL);
+    fail_if(test_ctx == NULL);
+
+    fail_unless(sss_utf8_is_ascii((const uint8_t *) upcase, strlen(upcase)));
+    fail_if(sss_utf8_is_ascii(munchen_utf8_upcase,
+                              strlen((const char *) munchen_utf8_upcase)));
+
+    for (i = 0; i < 128; i++) {
+        all[i] = i;
+    }
+    fail_unless(sss_utf8_is_ascii(all, sizeof(all)));
+
+    sss_ascii_tolower_copy(all_lower, all, sizeof(all));
+    for (i = 0; i < 128; i++) {
+        fail_unless(all_lower[i] == tolower(i),
+                    "Wrong lower case of %d: %d\n", i, all_lower[i]);
+    }
+
+    lcase = sss_tc_utf8_str_tolower(test_ctx, upcase);
+    fail_if(lcase == NULL);
+    fail_unless(strcmp(lcase, lowcase) == 0, "Got %s\n", lcase);
+
+    ret = sss_utf8_case_eq((const uint8_t *) upcase,
+                           (const uint8_t *) lowcase);
+    fail_unless(ret == EOK, "ASCII comparison failed\n");
+
+    ret = sss_utf8_case_eq((const uint8_t *) upcase,
+                           (const uint8_t *) "domain users of the test");
+    fail_if(ret == EOK, "Prefix matched\n");
+
+    ret = sss_utf8_case_eq((const uint8_t *) "Domain [Users]",
+                           (const uint8_t *) "domain {users}");
+    fail_if(ret == EOK, "Brackets matched braces\n");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST(test_utf8_check)
 {
     const char *invalid = "ad\351la\357d";
@@ -1155,6 +1205,7 @@ Suite *util_suite(void)
     tcase_add_test (tc_utf8, test_utf8_talloc_lowercase);
     tcase_add_test (tc_utf8, test_utf8_talloc_str_lowercase);
     tcase_add_test (tc_utf8, test_utf8_caseeq);
+    tcase_add_test (tc_utf8, test_utf8_ascii);
     tcase_add_test (tc_utf8, test_utf8_check);
 
     tcase_set_timeout(tc_utf8, 60);
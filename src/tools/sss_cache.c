@@ -116,6 +116,10 @@ struct cache_tool_ctx {
     bool update_autofs_filter;
     bool update_ssh_host_filter;
     bool update_sudo_rule_filter;
+
+    /* All users and groups are invalidated, bump the cache generation of
+     * the domains instead of expiring every entry */
+    bool bump_generation;
 };
 
 static void free_input_values(struct input_values *values);
@@ -128,6 +132,10 @@ static errno_t init_context(int argc, const char *argv[],
 static errno_t invalidate_entry(TALLOC_CTX *ctx,
                                 struct sss_domain_info *domain,
                                 const char *name, int entry_type);
+static errno_t invalidate_all_entries(TALLOC_CTX *ctx,
+                                      struct sss_domain_info *domain,
+                                      struct ldb_message **msgs,
+                                      size_t msg_count, int entry_type);
 static bool invalidate_entries(TALLOC_CTX *ctx,
                                struct sss_domain_info *dinfo,
                                enum sss_cache_entry entry_type,
@@ -146,6 +154,8 @@ int main(int argc, const char *argv[])
     struct sysdb_ctx *sysdb;
     bool skipped = true;
     struct sss_domain_info *dinfo;
+    bool bumped;
+    bool all_bumped = true;
 
     /* If systemd is in offline mode,
      * there's not going to be a sssd instance
@@ -200,6 +210,21 @@ int main(int argc, const char *argv[])
             goto done;
         }
 
+        bumped = false;
+        if (tctx->bump_generation) {
+            ret = sysdb_bump_cache_generation(dinfo, NULL);
+            if (ret == EOK) {
+                bumped = true;
+                skipped = false;
+            } else {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Cannot bump the cache generation of domain %s, "
+                      "expiring all entries instead [%d]: %s\n",
+                      dinfo->name, ret, sss_strerror(ret));
+            }
+        }
+        all_bumped &= bumped;
+
         ret = sysdb_transaction_start(sysdb);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE,
@@ -207,12 +232,14 @@ int main(int argc, const char *argv[])
             goto done;
         }
 
-        skipped &= !invalidate_entries(tctx, dinfo, TYPE_USER,
-                                       tctx->user_filter,
-                                       tctx->user_name);
-        skipped &= !invalidate_entries(tctx, dinfo, TYPE_GROUP,
-                                       tctx->group_filter,
-                                       tctx->group_name);
+        if (!bumped) {
+            skipped &= !invalidate_entries(tctx, dinfo, TYPE_USER,
+                                           tctx->user_filter,
+                                           tctx->user_name);
+            skipped &= !invalidate_entries(tctx, dinfo, TYPE_GROUP,
+                                           tctx->group_filter,
+                                           tctx->group_name);
+        }
         skipped &= !invalidate_entries(tctx, dinfo, TYPE_NETGROUP,
                                        tctx->netgroup_filter,
                                        tctx->netgroup_name);
@@ -245,7 +272,19 @@ int main(int argc, const char *argv[])
         ERROR("No cache object matched the specified search\n");
         ret = ENOENT;
         goto done;
-    } else {
+    }
+
+    ret = EINVAL;
+    if (tctx->bump_generation && all_bumped) {
+        ret = sss_memcache_bump_generation_all();
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot bump the generation of the memory cache, "
+                  "clearing it instead\n");
+        }
+    }
+
+    if (ret != EOK) {
         ret = sss_memcache_clear_all();
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE, "Failed to clear memory cache.\n");
@@ -526,6 +565,21 @@ static bool invalidate_entries(TALLOC_CTX *ctx,
         return false;
     }
 
+    /* Autofs maps also expire their entries, they are few and take the
+     * per-map path */
+    if (name == NULL && entry_type != TYPE_AUTOFSMAP) {
+        ret = invalidate_all_entries(ctx, dinfo, msgs, msg_count, entry_type);
+        talloc_zfree(msgs);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Couldn't invalidate %s entries of domain %s\n",
+                  type_string, dinfo->name);
+            ERROR("Couldn't invalidate %1$s\n", type_string);
+            return false;
+        }
+        return true;
+    }
+
     iret = true;
     for (i = 0; i < msg_count; i++) {
         c_name = ldb_msg_find_attr_as_string(msgs[i], SYSDB_NAME, NULL);
@@ -645,6 +699,42 @@ static errno_t invalidate_entry(TALLOC_CTX *ctx,
     return ret;
 }
 
+/* Same result as invalidate_entry() on every entry, but written in one
+ * transaction of the cache and one of the timestamp cache. */
+static errno_t invalidate_all_entries(TALLOC_CTX *ctx,
+                                      struct sss_domain_info *domain,
+                                      struct ldb_message **msgs,
+                                      size_t msg_count, int entry_type)
+{
+    struct sysdb_attrs *sys_attrs;
+    errno_t ret;
+
+    sys_attrs = sysdb_new_attrs(ctx);
+    if (sys_attrs == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Could not create sysdb attributes\n");
+        return ENOMEM;
+    }
+
+    ret = sysdb_attrs_add_time_t(sys_attrs, SYSDB_CACHE_EXPIRE, 1);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (entry_type == TYPE_USER) {
+        /* For users, we also need to reset the initgroups cache expiry */
+        ret = sysdb_attrs_add_time_t(sys_attrs, SYSDB_INITGR_EXPIRE, 1);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = sysdb_invalidate_cache_entries(domain, msgs, msg_count, sys_attrs);
+
+done:
+    talloc_free(sys_attrs);
+    return ret;
+}
+
 static errno_t init_domains(struct cache_tool_ctx *ctx,
                             const char *domain)
 {
@@ -848,6 +938,9 @@ static errno_t init_context(int argc, const char *argv[],
         ctx->update_group_filter = true;
     }
 
+    ctx->bump_generation = (idb & INVALIDATE_USERS)
+                           && (idb & INVALIDATE_GROUPS);
+
     if (idb & INVALIDATE_NETGROUPS) {
         ctx->netgroup_filter = talloc_asprintf(ctx, "(%s=*)", SYSDB_NAME);
         ctx->update_netgroup_filter = false;
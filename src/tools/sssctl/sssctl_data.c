@@ -333,3 +333,140 @@ done:
 
     return ret;
 }
+
+struct sssctl_cache_export_opts {
+    const char *file;
+    int sudo;
+};
+
+errno_t sssctl_cache_export(struct sss_cmdline *cmdline,
+                            struct sss_tool_ctx *tool_ctx,
+                            void *pvt)
+{
+    struct sssctl_cache_export_opts opts = {0};
+    struct sss_domain_info *dom;
+    const char *domname = NULL;
+    mode_t old_umask;
+    size_t count;
+    FILE *out;
+    errno_t ret;
+
+    /* Parse command line. */
+    struct poptOption options[] = {
+        {"file", 'f', POPT_ARG_STRING, &opts.file, 0, _("File to write the cache content to"), NULL },
+        {"sudo", 's', POPT_ARG_NONE, &opts.sudo, 0, _("Export sudo rules as well"), NULL },
+        POPT_TABLEEND
+    };
+
+    ret = sss_tool_popt_ex(cmdline, options, SSS_TOOL_OPT_OPTIONAL,
+                           NULL, NULL, "DOMAIN", _("Specify domain name."),
+                           &domname, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to parse command arguments\n");
+        return ret;
+    }
+
+    if (opts.file == NULL) {
+        ERROR("The output file must be specified with --file\n");
+        return EINVAL;
+    }
+
+    dom = find_domain_by_name(tool_ctx->domains, domname, true);
+    if (dom == NULL) {
+        ERROR("Cannot find domain %1$s\n", domname);
+        return ERR_DOMAIN_NOT_FOUND;
+    }
+
+    /* The export contains the whole identity data of the domain. */
+    old_umask = umask(SSS_DFL_UMASK);
+    out = fopen(opts.file, "w");
+    umask(old_umask);
+    if (out == NULL) {
+        ret = errno;
+        ERROR("Unable to open %1$s [%2$d]: %3$s\n",
+              opts.file, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    ret = sysdb_export_domain(dom, opts.sudo, out, &count);
+    if (fclose(out) != 0 && ret == EOK) {
+        ret = errno;
+    }
+    if (ret != EOK) {
+        ERROR("Unable to export cache of domain %1$s [%2$d]: %3$s\n",
+              dom->name, ret, sss_strerror(ret));
+        unlink(opts.file);
+        return ret;
+    }
+
+    PRINT("%1$zu entries exported to %2$s\n", count, opts.file);
+
+    return EOK;
+}
+
+errno_t sssctl_cache_import(struct sss_cmdline *cmdline,
+                            struct sss_tool_ctx *tool_ctx,
+                            void *pvt)
+{
+    struct sss_domain_info *dom;
+    const char *domname = NULL;
+    const char *file = NULL;
+    size_t count;
+    FILE *in;
+    errno_t ret;
+
+    /* Parse command line. */
+    struct poptOption options[] = {
+        {"file", 'f', POPT_ARG_STRING, &file, 0, _("File created by cache-export"), NULL },
+        POPT_TABLEEND
+    };
+
+    ret = sss_tool_popt_ex(cmdline, options, SSS_TOOL_OPT_OPTIONAL,
+                           NULL, NULL, "DOMAIN", _("Specify domain name."),
+                           &domname, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to parse command arguments\n");
+        return ret;
+    }
+
+    if (file == NULL) {
+        ERROR("The input file must be specified with --file\n");
+        return EINVAL;
+    }
+
+    /* The cache is seeded before the first start, a running back end
+     * would overwrite the imported entries anyway. */
+    if (sss_daemon_running()) {
+        fprintf(stderr, "Unable to import the cache unless SSSD is stopped.\n");
+        return ERR_SSSD_RUNNING;
+    }
+
+    dom = find_domain_by_name(tool_ctx->domains, domname, true);
+    if (dom == NULL) {
+        ERROR("Cannot find domain %1$s\n", domname);
+        return ERR_DOMAIN_NOT_FOUND;
+    }
+
+    in = fopen(file, "r");
+    if (in == NULL) {
+        ret = errno;
+        ERROR("Unable to open %1$s [%2$d]: %3$s\n",
+              file, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    ret = sysdb_import_domain(dom, in, &count);
+    fclose(in);
+    if (ret == ERR_DOMAIN_NOT_FOUND) {
+        ERROR("%1$s was not exported from domain %2$s\n", file, dom->name);
+        return ret;
+    } else if (ret != EOK) {
+        ERROR("Unable to import cache of domain %1$s [%2$d]: %3$s\n",
+              dom->name, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    PRINT("%1$zu entries imported into domain %2$s\n", count, dom->name);
+
+    return EOK;
+}
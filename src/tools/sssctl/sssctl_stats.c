@@ -0,0 +1,485 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <popt.h>
+#include <stdio.h>
+#include <string.h>
+#include <talloc.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "util/util.h"
+#include "util/atomic_io.h"
+#include "util/sss_cli_cmd.h"
+#include "confdb/confdb.h"
+#include "tools/common/sss_tools.h"
+#include "tools/sssctl/sssctl.h"
+#include "sbus/sbus_opath.h"
+#include "sss_iface/sss_iface.h"
+#include "responder/ifp/ifp_iface/ifp_iface_sync.h"
+
+static const char *sssctl_stats_source(uint32_t source)
+{
+    switch (source) {
+    case SSS_CMD_SOURCE_CACHE:
+        return "cache";
+    case SSS_CMD_SOURCE_NCACHE:
+        return "negcache";
+    case SSS_CMD_SOURCE_PROVIDER:
+        return "provider";
+    }
+
+    return "unknown";
+}
+
+/* Upper limit of the bucket that contains the given percentile, this is
+ * as precise as the histogram allows. */
+static double sssctl_stats_percentile(uint32_t *buckets,
+                                      uint64_t count,
+                                      uint64_t max_usec,
+                                      unsigned int percentile)
+{
+    uint64_t wanted;
+    uint64_t seen = 0;
+    uint64_t limit;
+    int i;
+
+    wanted = (count * percentile + 99) / 100;
+
+    for (i = 0; i < SSS_CMD_STATS_BUCKETS - 1; i++) {
+        seen += buckets[i];
+        if (seen >= wanted) {
+            limit = 1ULL << (SSS_CMD_STATS_FIRST_SHIFT + i);
+            return MIN(limit, max_usec) / 1000.0;
+        }
+    }
+
+    return max_usec / 1000.0;
+}
+
+errno_t sssctl_command_stats(struct sss_cmdline *cmdline,
+                             struct sss_tool_ctx *tool_ctx,
+                             void *pvt)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sbus_sync_connection *conn;
+    const char *responder = NULL;
+    const char *path;
+    uint32_t *commands;
+    uint32_t *sources;
+    const char **domains;
+    uint64_t *counts;
+    uint64_t *total_usec;
+    uint64_t *max_usec;
+    uint32_t *histograms;
+    uint32_t *buckets;
+    size_t num;
+    size_t i;
+    errno_t ret;
+
+    ret = sss_tool_popt_ex(cmdline, NULL, SSS_TOOL_OPT_OPTIONAL,
+                           NULL, NULL, "RESPONDER",
+                           _("Specify responder name, e.g. nss."),
+                           &responder, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to parse command arguments\n");
+        return ret;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    path = sbus_opath_compose(tmp_ctx, IFP_PATH_COMPONENTS "/Responders",
+                              responder);
+    if (path == NULL) {
+        PRINT("Out of memory!\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    conn = sbus_sync_connect_system(tmp_ctx, NULL);
+    if (conn == NULL) {
+        ERROR("Unable to connect to system bus!\n");
+        ret = EIO;
+        goto done;
+    }
+
+    ret = sbus_call_ifp_components_GetCommandStats(tmp_ctx, conn, IFP_BUS,
+                                                   path, &commands, &sources,
+                                                   &domains, &counts,
+                                                   &total_usec, &max_usec,
+                                                   &histograms);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to get command statistics "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        ERROR("Unable to get command statistics of %s\n", responder);
+        PRINT_IFP_WARNING(ret);
+        goto done;
+    }
+
+    num = talloc_array_length(commands);
+    if (talloc_array_length(sources) != num
+            || talloc_array_length(counts) != num
+            || talloc_array_length(total_usec) != num
+            || talloc_array_length(max_usec) != num
+            || talloc_array_length(histograms) != num * SSS_CMD_STATS_BUCKETS) {
+        ERROR("Invalid reply from %s\n", responder);
+        ret = EINVAL;
+        goto done;
+    }
+
+    if (num == 0) {
+        PRINT("No commands were processed yet.\n");
+        ret = EOK;
+        goto done;
+    }
+
+    PRINT("%-28s %-9s %-20s %10s %10s %10s %10s %10s\n",
+          _("Command"), _("Source"), _("Domain"), _("Count"),
+          _("Avg [ms]"), _("p50 [ms]"), _("p99 [ms]"), _("Max [ms]"));
+
+    for (i = 0; i < num; i++) {
+        if (counts[i] == 0) {
+            continue;
+        }
+
+        buckets = &histograms[i * SSS_CMD_STATS_BUCKETS];
+
+        PRINT("%-28s %-9s %-20s %10"PRIu64" %10.3f %10.3f %10.3f %10.3f\n",
+              sss_cmd2str(commands[i]), sssctl_stats_source(sources[i]),
+              domains[i] == NULL || domains[i][0] == '\0' ? "-" : domains[i],
+              counts[i],
+              total_usec[i] / 1000.0 / counts[i],
+              sssctl_stats_percentile(buckets, counts[i], max_usec[i], 50),
+              sssctl_stats_percentile(buckets, counts[i], max_usec[i], 99),
+              max_usec[i] / 1000.0);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
+
+#define SSSCTL_LOOP_PREFIX "sssd_event_loop_"
+
+struct sssctl_loop_row {
+    const char *component;
+    const char *location;
+    uint64_t calls;
+    uint64_t total_usec;
+    uint64_t max_usec;
+};
+
+/* Read everything the monitor prints on its metrics socket. */
+static errno_t sssctl_loop_read_metrics(TALLOC_CTX *mem_ctx,
+                                        const char *path,
+                                        char **_text)
+{
+    struct sockaddr_un addr;
+    char *text = NULL;
+    size_t size = 0;
+    size_t len = 0;
+    ssize_t n;
+    int fd;
+    errno_t ret;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return EINVAL;
+    }
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return errno;
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    do {
+        if (size - len < 4096) {
+            size += 16384;
+            text = talloc_realloc(mem_ctx, text, char, size);
+            if (text == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+
+        n = sss_atomic_read_s(fd, text + len, size - len - 1);
+        if (n == -1) {
+            ret = errno;
+            talloc_free(text);
+            goto done;
+        }
+        len += n;
+    } while (n > 0);
+
+    text[len] = '\0';
+    *_text = text;
+
+    ret = EOK;
+
+done:
+    close(fd);
+    return ret;
+}
+
+/* Return the value of label @name or NULL. The values that are read here
+ * are component and function names which are never escaped. */
+static const char *sssctl_loop_label(TALLOC_CTX *mem_ctx,
+                                     const char *labels,
+                                     const char *name)
+{
+    const char *start;
+    const char *end;
+    char *pattern;
+
+    pattern = talloc_asprintf(mem_ctx, "%s=\"", name);
+    if (pattern == NULL) {
+        return NULL;
+    }
+
+    start = strstr(labels, pattern);
+    if (start == NULL) {
+        talloc_free(pattern);
+        return NULL;
+    }
+    start += strlen(pattern);
+    talloc_free(pattern);
+
+    end = strchr(start, '"');
+    if (end == NULL) {
+        return NULL;
+    }
+
+    return talloc_strndup(mem_ctx, start, end - start);
+}
+
+static struct sssctl_loop_row *
+sssctl_loop_row(TALLOC_CTX *mem_ctx,
+                struct sssctl_loop_row **_rows,
+                const char *component,
+                const char *location)
+{
+    struct sssctl_loop_row *rows = *_rows;
+    size_t num;
+    size_t i;
+
+    num = talloc_array_length(rows);
+    for (i = 0; i < num; i++) {
+        if (strcmp(rows[i].component, component) == 0
+                && strcmp(rows[i].location, location) == 0) {
+            return &rows[i];
+        }
+    }
+
+    rows = talloc_realloc(mem_ctx, rows, struct sssctl_loop_row, num + 1);
+    if (rows == NULL) {
+        return NULL;
+    }
+
+    memset(&rows[num], 0, sizeof(struct sssctl_loop_row));
+    rows[num].component = component;
+    rows[num].location = location;
+    *_rows = rows;
+
+    return &rows[num];
+}
+
+/* Lag has no location, it is kept in a row with an empty one. */
+static errno_t sssctl_loop_parse(TALLOC_CTX *mem_ctx,
+                                 char *text,
+                                 const char *component,
+                                 struct sssctl_loop_row **_rows)
+{
+    struct sssctl_loop_row *rows = NULL;
+    struct sssctl_loop_row *row;
+    const char *comp;
+    const char *location;
+    const char *labels;
+    const char *value;
+    char *line;
+    char *name;
+    char *saveptr = NULL;
+    uint64_t number;
+
+    for (line = strtok_r(text, "\n", &saveptr);
+         line != NULL;
+         line = strtok_r(NULL, "\n", &saveptr)) {
+        if (strncmp(line, SSSCTL_LOOP_PREFIX,
+                    sizeof(SSSCTL_LOOP_PREFIX) - 1) != 0) {
+            continue;
+        }
+
+        name = line;
+        labels = strchr(line, '{');
+        value = strrchr(line, ' ');
+        if (labels == NULL || value == NULL) {
+            continue;
+        }
+        name[labels - line] = '\0';
+        labels++;
+
+        comp = sssctl_loop_label(mem_ctx, labels, "component");
+        if (comp == NULL) {
+            continue;
+        }
+
+        if (component != NULL && strcmp(comp, component) != 0) {
+            continue;
+        }
+
+        location = sssctl_loop_label(mem_ctx, labels, "location");
+        if (location == NULL) {
+            location = "";
+        }
+
+        row = sssctl_loop_row(mem_ctx, &rows, comp, location);
+        if (row == NULL) {
+            return ENOMEM;
+        }
+
+        number = strtoull(value + 1, NULL, 10);
+
+        if (strcmp(name, "sssd_event_loop_handler_calls_total") == 0) {
+            row->calls = number;
+        } else if (strcmp(name,
+                          "sssd_event_loop_handler_microseconds_total") == 0) {
+            row->total_usec = number;
+        } else if (strcmp(name,
+                          "sssd_event_loop_handler_max_microseconds") == 0) {
+            row->max_usec = number;
+        } else if (strcmp(name, "sssd_event_loop_lag_microseconds") == 0) {
+            row->total_usec = number;
+        } else if (strcmp(name, "sssd_event_loop_lag_max_microseconds") == 0) {
+            row->max_usec = number;
+        }
+    }
+
+    *_rows = rows;
+
+    return EOK;
+}
+
+errno_t sssctl_event_loop_stats(struct sss_cmdline *cmdline,
+                                struct sss_tool_ctx *tool_ctx,
+                                void *pvt)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sssctl_loop_row *rows = NULL;
+    const char *component = NULL;
+    char *path;
+    char *text;
+    size_t num;
+    size_t i;
+    errno_t ret;
+
+    ret = sss_tool_popt_ex(cmdline, NULL, SSS_TOOL_OPT_OPTIONAL,
+                           NULL, NULL, "COMPONENT",
+                           _("Specify component name, e.g. nss."),
+                           &component, NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to parse command arguments\n");
+        return ret;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Out of memory!\n");
+        return ENOMEM;
+    }
+
+    ret = confdb_get_string(tool_ctx->confdb, tmp_ctx,
+                            CONFDB_MONITOR_CONF_ENTRY,
+                            CONFDB_MONITOR_METRICS_SOCKET, NULL, &path);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read metrics_socket "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (path == NULL) {
+        ERROR("The statistics are served on metrics_socket which is "
+              "not configured\n");
+        ret = ENOENT;
+        goto done;
+    }
+
+    ret = sssctl_loop_read_metrics(tmp_ctx, path, &text);
+    if (ret != EOK) {
+        ERROR("Unable to read metrics from %s [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    ret = sssctl_loop_parse(tmp_ctx, text, component, &rows);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    num = talloc_array_length(rows);
+    if (num == 0) {
+        PRINT("No event loop statistics were collected, "
+              "enable debug_event_loop to collect them.\n");
+        ret = EOK;
+        goto done;
+    }
+
+    PRINT("%-12s %-36s %12s %12s %10s %10s\n",
+          _("Component"), _("Location"), _("Calls"), _("Total [ms]"),
+          _("Avg [ms]"), _("Max [ms]"));
+
+    for (i = 0; i < num; i++) {
+        if (rows[i].location[0] == '\0' || rows[i].calls == 0) {
+            continue;
+        }
+
+        PRINT("%-12s %-36s %12"PRIu64" %12.3f %10.3f %10.3f\n",
+              rows[i].component, rows[i].location, rows[i].calls,
+              rows[i].total_usec / 1000.0,
+              rows[i].total_usec / 1000.0 / rows[i].calls,
+              rows[i].max_usec / 1000.0);
+    }
+
+    PRINT("\n%-12s %12s %12s\n", _("Component"), _("Lag [ms]"),
+          _("Max lag [ms]"));
+
+    for (i = 0; i < num; i++) {
+        if (rows[i].location[0] != '\0') {
+            continue;
+        }
+
+        PRINT("%-12s %12.3f %12.3f\n", rows[i].component,
+              rows[i].total_usec / 1000.0, rows[i].max_usec / 1000.0);
+    }
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+
+    return ret;
+}
@@ -162,10 +162,111 @@ static int clear_memcache(bool *sssd_nss_is_off)
         }
     }
 
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/sid");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
+
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/services");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
+
+    ret = sss_memcache_invalidate(SSS_NSS_MCACHE_DIR"/hosts");
+    if (ret != EOK) {
+        if (ret == EACCES) {
+            *sssd_nss_is_off = false;
+            return EOK;
+        } else {
+            return ret;
+        }
+    }
+
     *sssd_nss_is_off = true;
     return EOK;
 }
 
+static errno_t sss_memcache_bump_generation(const char *mc_filename)
+{
+    struct sss_mc_header h;
+    uint32_t generation;
+    off_t offset;
+    ssize_t len;
+    int mc_fd;
+    errno_t ret;
+
+    mc_fd = open(mc_filename, O_RDWR);
+    if (mc_fd == -1) {
+        ret = errno;
+        if (ret == ENOENT) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Memory cache file %s "
+                  "does not exist.\n", mc_filename);
+            return EOK;
+        }
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to open file %s: %s\n",
+              mc_filename, strerror(ret));
+        return ret;
+    }
+
+    /* The generation is only written by this function, concurrent runs of
+     * the tool may lose a bump but both bumps make the records stale */
+    offset = MC_PTR_DIFF(&h.generation, &h);
+    len = pread(mc_fd, &generation, sizeof(generation), offset);
+    if (len != sizeof(generation)) {
+        ret = (len == -1) ? errno : EIO;
+        goto done;
+    }
+
+    generation++;
+    len = pwrite(mc_fd, &generation, sizeof(generation), offset);
+    if (len != sizeof(generation)) {
+        ret = (len == -1) ? errno : EIO;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to bump the generation of memory "
+              "cache file %s [%d]: %s\n", mc_filename, ret, strerror(ret));
+    }
+    close(mc_fd);
+    return ret;
+}
+
+errno_t sss_memcache_bump_generation_all(void)
+{
+    const char *files[] = { SSS_NSS_MCACHE_DIR"/passwd",
+                            SSS_NSS_MCACHE_DIR"/group",
+                            SSS_NSS_MCACHE_DIR"/initgroups",
+                            SSS_NSS_MCACHE_DIR"/sid",
+                            SSS_NSS_MCACHE_DIR"/services",
+                            SSS_NSS_MCACHE_DIR"/hosts",
+                            NULL };
+    errno_t ret;
+    int i;
+
+    for (i = 0; files[i] != NULL; i++) {
+        ret = sss_memcache_bump_generation(files[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
 static errno_t wait_till_nss_responder_invalidate_cache(void)
 {
     struct stat stat_buf = { 0 };
@@ -106,6 +106,10 @@ errno_t sss_memcache_invalidate(const char *mc_filename);
 
 errno_t sss_memcache_clear_all(void);
 
+/* Make all records of the memory caches stale by bumping the generation in
+ * the headers, the files are kept and sssd_nss is not signalled */
+errno_t sss_memcache_bump_generation_all(void);
+
 errno_t sss_mc_refresh_user(const char *username);
 errno_t sss_mc_refresh_group(const char *groupname);
 errno_t sss_mc_refresh_grouplist(struct tools_ctx *tctx,
@@ -201,49 +201,41 @@ static errno_t cert_to_ssh_key_step(struct tevent_req *req)
         goto done;
     }
 
-    child_pid = fork();
-    if (child_pid == 0) { /* child */
-        exec_child_ex(state, pipefd_to_child, pipefd_from_child, P11_CHILD_PATH,
-                      state->logfile, state->extra_args, false,
-                      STDIN_FILENO, STDOUT_FILENO);
-        /* We should never get here */
-        DEBUG(SSSDBG_CRIT_FAILURE, "BUG: Could not exec p11 child\n");
-    } else if (child_pid > 0) { /* parent */
-
-        state->io->read_from_child_fd = pipefd_from_child[0];
-        PIPE_FD_CLOSE(pipefd_from_child[1]);
-        sss_fd_nonblocking(state->io->read_from_child_fd);
-
-        state->io->write_to_child_fd = pipefd_to_child[1];
-        PIPE_FD_CLOSE(pipefd_to_child[0]);
-        sss_fd_nonblocking(state->io->write_to_child_fd);
-
-        /* Set up SIGCHLD handler */
-        ret = child_handler_setup(state->ev, child_pid, cert_to_ssh_key_done,
-                                  req, &state->child_ctx);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "Could not set up child handlers [%d]: %s\n",
-                ret, sss_strerror(ret));
-            ret = ERR_P11_CHILD;
-            goto done;
-        }
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child, P11_CHILD_PATH,
+                          state->logfile, state->extra_args, false,
+                          STDIN_FILENO, STDOUT_FILENO, &child_pid);
+    if (ret != EOK) {
+        goto done;
+    }
 
-        /* Set up timeout handler */
-        tv = tevent_timeval_current_ofs(state->timeout, 0);
-        state->timeout_handler = tevent_add_timer(state->ev, req, tv,
-                                                  p11_child_timeout,
-                                                  req);
-        if (state->timeout_handler == NULL) {
-            ret = ERR_P11_CHILD;
-            goto done;
-        }
-        /* Now either wait for the timeout to fire or the child to finish */
-    } else { /* error */
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE, "fork failed [%d][%s].\n",
-                                   ret, sss_strerror(ret));
+    state->io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    sss_fd_nonblocking(state->io->read_from_child_fd);
+
+    state->io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(state->io->write_to_child_fd);
+
+    /* Set up SIGCHLD handler */
+    ret = child_handler_setup(state->ev, child_pid, cert_to_ssh_key_done,
+                              req, &state->child_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not set up child handlers [%d]: %s\n",
+            ret, sss_strerror(ret));
+        ret = ERR_P11_CHILD;
+        goto done;
+    }
+
+    /* Set up timeout handler */
+    tv = tevent_timeval_current_ofs(state->timeout, 0);
+    state->timeout_handler = tevent_add_timer(state->ev, req, tv,
+                                              p11_child_timeout,
+                                              req);
+    if (state->timeout_handler == NULL) {
+        ret = ERR_P11_CHILD;
         goto done;
     }
+    /* Now either wait for the timeout to fire or the child to finish */
 
     return EAGAIN;
 
@@ -28,12 +28,18 @@
 #include <tevent.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <spawn.h>
 
 #include "util/util.h"
+#include "util/dlinklist.h"
 #include "util/find_uid.h"
+#include "util/probes.h"
+#include "util/sss_metrics.h"
 #include "db/sysdb.h"
 #include "util/child_common.h"
 
+extern char **environ;
+
 struct sss_sigchild_ctx {
     struct tevent_context *ev;
     hash_table_t *children;
@@ -148,11 +154,29 @@ errno_t sss_child_register(TALLOC_CTX *mem_ctx,
     }
 
     talloc_set_destructor((TALLOC_CTX *) child, sss_child_destructor);
+    PROBE(CHILD_REGISTER, pid);
+    sss_metrics_inc(SSS_METRIC_CHILD_FORKS, 1);
 
     *child_ctx = child;
     return EOK;
 }
 
+static void sss_child_account_exit(int wait_status)
+{
+    const char *status;
+
+    if (WIFEXITED(wait_status)) {
+        status = WEXITSTATUS(wait_status) == 0 ? "success" : "failure";
+    } else if (WIFSIGNALED(wait_status)) {
+        status = "signal";
+    } else {
+        /* stopped or continued */
+        return;
+    }
+
+    sss_metrics_inc(SSS_METRIC_CHILD_EXITS, 1, status);
+}
+
 struct sss_child_cb_pvt {
     struct sss_child_ctx *child_ctx;
     int wait_status;
@@ -219,6 +243,9 @@ static void sss_child_handler(struct tevent_context *ev,
             return;
         } else if (pid == 0) continue;
 
+        PROBE(CHILD_EXIT, pid, wait_status);
+        sss_child_account_exit(wait_status);
+
         key.ul = pid;
         error = hash_lookup(sigchld_ctx->children, &key, &value);
         if (error == HASH_SUCCESS) {
@@ -303,6 +330,8 @@ int child_handler_setup(struct tevent_context *ev, int pid,
     child_ctx->pvt = pvt;
 
     DEBUG(SSSDBG_TRACE_INTERNAL, "Signal handler set up for pid [%d]\n", pid);
+    PROBE(CHILD_REGISTER, pid);
+    sss_metrics_inc(SSS_METRIC_CHILD_FORKS, 1);
 
     if (_child_ctx != NULL) {
         *_child_ctx = child_ctx;
@@ -552,6 +581,9 @@ static void child_sig_handler(struct tevent_context *ev,
         DEBUG(SSSDBG_CRIT_FAILURE,
               "waitpid did not found a child with changed status.\n");
     } else {
+        PROBE(CHILD_EXIT, ret, child_ctx->child_status);
+        sss_child_account_exit(child_ctx->child_status);
+
         if (WIFEXITED(child_ctx->child_status)) {
             if (WEXITSTATUS(child_ctx->child_status) != 0) {
                 DEBUG(SSSDBG_CRIT_FAILURE,
@@ -772,6 +804,7 @@ void exec_child_ex(TALLOC_CTX *mem_ctx,
         exit(EXIT_FAILURE);
     }
 
+    PROBE(CHILD_EXEC, binary);
     execv(binary, argv);
     err = errno;
     DEBUG(SSSDBG_OP_FAILURE, "execv failed [%d][%s].\n", err, strerror(err));
@@ -787,6 +820,91 @@ void exec_child(TALLOC_CTX *mem_ctx,
                   STDIN_FILENO, STDOUT_FILENO);
 }
 
+errno_t sss_child_spawn(int *pipefd_to_child, int *pipefd_from_child,
+                        const char *binary, const char *logfile,
+                        const char *extra_argv[], bool extra_args_only,
+                        int child_in_fd, int child_out_fd,
+                        pid_t *_pid)
+{
+    posix_spawn_file_actions_t actions;
+    TALLOC_CTX *tmp_ctx;
+    FILE *debug_filep = NULL;
+    int debug_fd = STDERR_FILENO;
+    char **argv;
+    pid_t pid;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (logfile != NULL) {
+        debug_fd = -1;
+        if (sss_logger == FILES_LOGGER) {
+            /* The child inherits the descriptor, it is closed here once
+             * the child was started. */
+            ret = open_debug_file_ex(logfile, &debug_filep, false);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Error setting up logging "
+                      "(%d) [%s]\n", ret, sss_strerror(ret));
+                goto done;
+            }
+            debug_fd = fileno(debug_filep);
+        }
+    }
+
+    ret = prepare_child_argv(tmp_ctx, debug_fd, binary, extra_argv,
+                             extra_args_only, &argv);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "prepare_child_argv failed.\n");
+        goto done;
+    }
+
+    /* The same descriptor setup exec_child_ex() does after fork(). */
+    ret = posix_spawn_file_actions_init(&actions);
+    if (ret != 0) {
+        goto done;
+    }
+
+    ret = posix_spawn_file_actions_addclose(&actions, pipefd_to_child[1]);
+    if (ret == 0) {
+        ret = posix_spawn_file_actions_adddup2(&actions, pipefd_to_child[0],
+                                               child_in_fd);
+    }
+    if (ret == 0) {
+        ret = posix_spawn_file_actions_addclose(&actions,
+                                                pipefd_from_child[0]);
+    }
+    if (ret == 0) {
+        ret = posix_spawn_file_actions_adddup2(&actions, pipefd_from_child[1],
+                                               child_out_fd);
+    }
+
+    if (ret == 0) {
+        PROBE(CHILD_EXEC, binary);
+        ret = posix_spawn(&pid, binary, &actions, NULL, argv, environ);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    if (ret != 0) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to start %s [%d]: %s\n",
+              binary, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_LIBS, "Started %s [%d]\n", binary, pid);
+
+    *_pid = pid;
+    ret = EOK;
+
+done:
+    if (debug_filep != NULL) {
+        fclose(debug_filep);
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 int child_io_destructor(void *ptr)
 {
     int ret;
@@ -816,6 +934,1076 @@ int child_io_destructor(void *ptr)
     return EOK;
 }
 
+/* == helper pool ========================================================= */
+
+/* Housekeeping of the idle helpers runs this often, in seconds. */
+#define SSS_CHILD_POOL_MAINT_INTERVAL 10
+
+struct sss_child_pool_helper {
+    struct sss_child_pool_helper *prev;
+    struct sss_child_pool_helper *next;
+
+    struct sss_child_pool *pool;
+    pid_t pid;
+    struct sss_child_ctx_old *child_ctx;
+    struct child_io_fds *io;
+
+    bool busy;
+    unsigned int uses;
+    time_t idle_since;
+    time_t checked;
+    /* request or health check in progress */
+    struct tevent_req *exchange;
+};
+
+struct sss_child_pool_state;
+
+struct sss_child_pool {
+    struct tevent_context *ev;
+    struct sss_child_pool_opts opts;
+
+    /* most recently used first */
+    struct sss_child_pool_helper *idle;
+    struct sss_child_pool_helper *busy;
+    size_t num_idle;
+    size_t num_busy;
+
+    /* requests waiting for a helper, oldest first */
+    struct sss_child_pool_state *waiting;
+
+    struct tevent_timer *maint;
+};
+
+static void sss_child_pool_account(struct sss_child_pool *pool)
+{
+    sss_metrics_set(SSS_METRIC_CHILD_POOL_HELPERS, pool->num_idle,
+                    pool->opts.name, "idle");
+    sss_metrics_set(SSS_METRIC_CHILD_POOL_HELPERS, pool->num_busy,
+                    pool->opts.name, "busy");
+}
+
+static void sss_child_pool_exchange_detach(struct tevent_req *req);
+
+static int sss_child_pool_helper_destructor(struct sss_child_pool_helper *h)
+{
+    struct sss_child_pool *pool = h->pool;
+
+    if (h->busy) {
+        DLIST_REMOVE(pool->busy, h);
+        pool->num_busy--;
+    } else {
+        DLIST_REMOVE(pool->idle, h);
+        pool->num_idle--;
+    }
+
+    if (h->exchange != NULL) {
+        sss_child_pool_exchange_detach(h->exchange);
+        h->exchange = NULL;
+    }
+
+    if (h->child_ctx != NULL) {
+        child_handler_destroy(h->child_ctx);
+        h->child_ctx = NULL;
+    }
+
+    sss_child_pool_account(pool);
+
+    return 0;
+}
+
+/* A helper that is stopped gracefully exits when it reads EOF on stdin,
+ * a helper whose state is unknown is killed. */
+static void sss_child_pool_helper_stop(struct sss_child_pool_helper *helper,
+                                       const char *reason,
+                                       bool kill_helper)
+{
+    DEBUG(SSSDBG_TRACE_FUNC, "Stopping %s helper [%d]: %s\n",
+          helper->pool->opts.name, helper->pid, reason);
+
+    sss_metrics_inc(SSS_METRIC_CHILD_POOL_RECYCLES, 1,
+                    helper->pool->opts.name, reason);
+
+    if (helper->child_ctx != NULL && !kill_helper) {
+        /* only reap it */
+        helper->child_ctx->cb = NULL;
+        helper->child_ctx->pvt = NULL;
+        helper->child_ctx = NULL;
+    }
+
+    talloc_free(helper);
+}
+
+static void sss_child_pool_fill(struct sss_child_pool *pool);
+
+static void sss_child_pool_helper_exited(int child_status,
+                                         struct tevent_signal *sige,
+                                         void *pvt)
+{
+    struct sss_child_pool_helper *helper;
+    struct sss_child_pool *pool;
+
+    helper = talloc_get_type(pvt, struct sss_child_pool_helper);
+
+    /* The signal handler context is freed by the caller. */
+    helper->child_ctx = NULL;
+
+    DEBUG(SSSDBG_MINOR_FAILURE, "%s helper [%d] exited with status [%d]\n",
+          helper->pool->opts.name, helper->pid, child_status);
+
+    /* A running exchange ends with EOF on the pipe and stops the helper. */
+    if (helper->exchange == NULL) {
+        pool = helper->pool;
+        sss_child_pool_helper_stop(helper, "exited", false);
+        sss_child_pool_fill(pool);
+    }
+}
+
+static errno_t sss_child_pool_helper_start(struct sss_child_pool *pool,
+                                           struct sss_child_pool_helper **_h)
+{
+    int pipefd_to_child[2] = PIPE_INIT;
+    int pipefd_from_child[2] = PIPE_INIT;
+    struct sss_child_pool_helper *helper;
+    pid_t pid;
+    errno_t ret;
+
+    helper = talloc_zero(pool, struct sss_child_pool_helper);
+    if (helper == NULL) {
+        return ENOMEM;
+    }
+
+    helper->pool = pool;
+    helper->io = talloc(helper, struct child_io_fds);
+    if (helper->io == NULL) {
+        talloc_free(helper);
+        return ENOMEM;
+    }
+    helper->io->write_to_child_fd = -1;
+    helper->io->read_from_child_fd = -1;
+    talloc_set_destructor((void *) helper->io, child_io_destructor);
+
+    /* The helper is accounted as idle until it is handed a request. */
+    DLIST_ADD(pool->idle, helper);
+    pool->num_idle++;
+    talloc_set_destructor(helper, sss_child_pool_helper_destructor);
+
+    ret = pipe(pipefd_from_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", ret, strerror(ret));
+        goto done;
+    }
+    ret = pipe(pipefd_to_child);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "pipe failed [%d][%s].\n", ret, strerror(ret));
+        goto done;
+    }
+
+    ret = sss_child_spawn(pipefd_to_child, pipefd_from_child,
+                          pool->opts.binary, pool->opts.logfile,
+                          pool->opts.extra_argv, false,
+                          STDIN_FILENO, STDOUT_FILENO, &pid);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    helper->pid = pid;
+    helper->io->read_from_child_fd = pipefd_from_child[0];
+    PIPE_FD_CLOSE(pipefd_from_child[1]);
+    helper->io->write_to_child_fd = pipefd_to_child[1];
+    PIPE_FD_CLOSE(pipefd_to_child[0]);
+    sss_fd_nonblocking(helper->io->read_from_child_fd);
+    sss_fd_nonblocking(helper->io->write_to_child_fd);
+    /* Helpers must not inherit the pipes of each other. */
+    (void)fcntl(helper->io->read_from_child_fd, F_SETFD, FD_CLOEXEC);
+    (void)fcntl(helper->io->write_to_child_fd, F_SETFD, FD_CLOEXEC);
+
+    ret = child_handler_setup(pool->ev, pid, sss_child_pool_helper_exited,
+                              helper, &helper->child_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not set up child signal handler\n");
+        kill(pid, SIGKILL);
+        goto done;
+    }
+
+    helper->idle_since = time(NULL);
+    helper->checked = helper->idle_since;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Started %s helper [%d]\n",
+          pool->opts.name, pid);
+
+    sss_child_pool_account(pool);
+    *_h = helper;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        PIPE_CLOSE(pipefd_from_child);
+        PIPE_CLOSE(pipefd_to_child);
+        talloc_free(helper);
+    }
+
+    return ret;
+}
+
+/* Start helpers until there are enough idle ones. */
+static void sss_child_pool_fill(struct sss_child_pool *pool)
+{
+    struct sss_child_pool_helper *helper;
+    errno_t ret;
+
+    while (pool->waiting == NULL
+            && pool->num_idle < pool->opts.min_idle
+            && pool->num_idle + pool->num_busy < pool->opts.max_helpers) {
+        ret = sss_child_pool_helper_start(pool, &helper);
+        if (ret != EOK) {
+            /* tried again by the next housekeeping */
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to start %s helper [%d]: %s\n",
+                  pool->opts.name, ret, sss_strerror(ret));
+            return;
+        }
+    }
+}
+
+/* One request and its reply on the pipes of a helper. */
+struct sss_child_pool_exchange_state {
+    struct tevent_context *ev;
+    struct sss_child_pool_helper *helper;
+
+    uint8_t *frame;
+    struct tevent_req *write_req;
+    struct tevent_fd *read_fde;
+    struct tevent_timer *timeout;
+
+    uint8_t header[sizeof(uint32_t)];
+    bool have_header;
+    size_t pos;
+    uint8_t *reply;
+    size_t reply_len;
+};
+
+static int
+sss_child_pool_exchange_state_destructor(
+                                struct sss_child_pool_exchange_state *state);
+static void sss_child_pool_exchange_written(struct tevent_req *subreq);
+static void sss_child_pool_exchange_read(struct tevent_context *ev,
+                                         struct tevent_fd *fde,
+                                         uint16_t flags,
+                                         void *pvt);
+static void sss_child_pool_exchange_timeout(struct tevent_context *ev,
+                                            struct tevent_timer *te,
+                                            struct timeval tv,
+                                            void *pvt);
+
+static struct tevent_req *
+sss_child_pool_exchange_send(TALLOC_CTX *mem_ctx,
+                             struct sss_child_pool_helper *helper,
+                             uint8_t *buf,
+                             size_t len)
+{
+    struct sss_child_pool_exchange_state *state;
+    struct tevent_req *req;
+    struct timeval tv;
+    size_t p = 0;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sss_child_pool_exchange_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = helper->pool->ev;
+
+    if (len > SSS_CHILD_POOL_MAX_FRAME) {
+        ret = EMSGSIZE;
+        goto done;
+    }
+
+    state->frame = talloc_array(state, uint8_t, sizeof(uint32_t) + len);
+    if (state->frame == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    SAFEALIGN_SET_UINT32(state->frame, len, &p);
+    if (len > 0) {
+        safealign_memcpy(state->frame + p, buf, len, &p);
+    }
+
+    state->write_req = write_pipe_send(state, state->ev, state->frame, p,
+                                       helper->io->write_to_child_fd);
+    if (state->write_req == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    tevent_req_set_callback(state->write_req,
+                            sss_child_pool_exchange_written, req);
+
+    if (helper->pool->opts.timeout > 0) {
+        tv = tevent_timeval_current_ofs(helper->pool->opts.timeout, 0);
+        state->timeout = tevent_add_timer(state->ev, state, tv,
+                                          sss_child_pool_exchange_timeout,
+                                          req);
+        if (state->timeout == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    state->helper = helper;
+    helper->exchange = req;
+    talloc_set_destructor(state, sss_child_pool_exchange_state_destructor);
+
+    return req;
+
+done:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, state->ev);
+    return req;
+}
+
+/* Called when the helper goes away while the exchange is running. */
+static void sss_child_pool_exchange_detach(struct tevent_req *req)
+{
+    struct sss_child_pool_exchange_state *state;
+
+    state = tevent_req_data(req, struct sss_child_pool_exchange_state);
+
+    talloc_zfree(state->write_req);
+    talloc_zfree(state->read_fde);
+    talloc_zfree(state->timeout);
+    state->helper = NULL;
+}
+
+static void sss_child_pool_exchange_finish(struct tevent_req *req,
+                                           errno_t ret)
+{
+    struct sss_child_pool_exchange_state *state;
+
+    state = tevent_req_data(req, struct sss_child_pool_exchange_state);
+
+    if (state->helper != NULL) {
+        state->helper->exchange = NULL;
+    }
+    sss_child_pool_exchange_detach(req);
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static void sss_child_pool_dispatch(struct sss_child_pool *pool);
+
+static int
+sss_child_pool_exchange_state_destructor(
+                                struct sss_child_pool_exchange_state *state)
+{
+    struct sss_child_pool_helper *helper = state->helper;
+    struct sss_child_pool *pool;
+
+    if (helper != NULL) {
+        /* The reply would be read by the next request. */
+        pool = helper->pool;
+        helper->exchange = NULL;
+        state->helper = NULL;
+        sss_child_pool_helper_stop(helper, "cancelled", true);
+        sss_child_pool_dispatch(pool);
+    }
+
+    return 0;
+}
+
+static void sss_child_pool_exchange_written(struct tevent_req *subreq)
+{
+    struct sss_child_pool_exchange_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sss_child_pool_exchange_state);
+
+    ret = write_pipe_recv(subreq);
+    talloc_zfree(subreq);
+    state->write_req = NULL;
+    if (ret != EOK) {
+        sss_child_pool_exchange_finish(req, ret);
+        return;
+    }
+
+    state->read_fde = tevent_add_fd(state->ev, state,
+                                    state->helper->io->read_from_child_fd,
+                                    TEVENT_FD_READ,
+                                    sss_child_pool_exchange_read, req);
+    if (state->read_fde == NULL) {
+        sss_child_pool_exchange_finish(req, ENOMEM);
+        return;
+    }
+}
+
+static void sss_child_pool_exchange_read(struct tevent_context *ev,
+                                         struct tevent_fd *fde,
+                                         uint16_t flags,
+                                         void *pvt)
+{
+    struct sss_child_pool_exchange_state *state;
+    struct tevent_req *req;
+    uint32_t reply_len;
+    uint8_t *dest;
+    size_t want;
+    ssize_t size;
+    size_t p = 0;
+    errno_t ret;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct sss_child_pool_exchange_state);
+
+    if (!state->have_header) {
+        dest = state->header + state->pos;
+        want = sizeof(state->header) - state->pos;
+    } else {
+        dest = state->reply + state->pos;
+        want = state->reply_len - state->pos;
+    }
+
+    errno = 0;
+    size = read(state->helper->io->read_from_child_fd, dest, want);
+    if (size == -1) {
+        ret = errno;
+        if (ret == EAGAIN || ret == EINTR) {
+            return;
+        }
+
+        DEBUG(SSSDBG_CRIT_FAILURE, "read failed [%d][%s].\n",
+              ret, strerror(ret));
+        sss_child_pool_exchange_finish(req, ret);
+        return;
+    } else if (size == 0) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "%s helper [%d] closed the pipe\n",
+              state->helper->pool->opts.name, state->helper->pid);
+        sss_child_pool_exchange_finish(req, EPIPE);
+        return;
+    }
+
+    state->pos += size;
+
+    if (!state->have_header) {
+        if (state->pos < sizeof(state->header)) {
+            return;
+        }
+
+        SAFEALIGN_COPY_UINT32(&reply_len, state->header, &p);
+        if (reply_len > SSS_CHILD_POOL_MAX_FRAME) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Reply of %"PRIu32" bytes is too "
+                  "large\n", reply_len);
+            sss_child_pool_exchange_finish(req, EMSGSIZE);
+            return;
+        }
+
+        state->have_header = true;
+        state->reply_len = reply_len;
+        state->pos = 0;
+        state->reply = talloc_array(state, uint8_t, reply_len + 1);
+        if (state->reply == NULL) {
+            sss_child_pool_exchange_finish(req, ENOMEM);
+            return;
+        }
+        /* replies are often strings */
+        state->reply[reply_len] = '\0';
+    }
+
+    if (state->pos == state->reply_len) {
+        sss_child_pool_exchange_finish(req, EOK);
+    }
+}
+
+static void sss_child_pool_exchange_timeout(struct tevent_context *ev,
+                                            struct tevent_timer *te,
+                                            struct timeval tv,
+                                            void *pvt)
+{
+    struct sss_child_pool_exchange_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct sss_child_pool_exchange_state);
+
+    DEBUG(SSSDBG_CRIT_FAILURE, "%s helper [%d] did not answer in time\n",
+          state->helper->pool->opts.name, state->helper->pid);
+
+    state->timeout = NULL;
+    sss_child_pool_exchange_finish(req, ETIMEDOUT);
+}
+
+static errno_t sss_child_pool_exchange_recv(struct tevent_req *req,
+                                            TALLOC_CTX *mem_ctx,
+                                            uint8_t **_buf,
+                                            size_t *_len)
+{
+    struct sss_child_pool_exchange_state *state;
+
+    state = tevent_req_data(req, struct sss_child_pool_exchange_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (_buf != NULL) {
+        *_buf = talloc_steal(mem_ctx, state->reply);
+    }
+    if (_len != NULL) {
+        *_len = state->reply_len;
+    }
+
+    return EOK;
+}
+
+/* Give the helper back to the pool after an exchange. */
+static void sss_child_pool_helper_release(struct sss_child_pool_helper *helper,
+                                          errno_t ret,
+                                          bool used)
+{
+    struct sss_child_pool *pool = helper->pool;
+
+    if (ret != EOK) {
+        sss_child_pool_helper_stop(helper,
+                                   ret == ETIMEDOUT ? "timeout" : "failed",
+                                   true);
+        helper = NULL;
+    } else if (used) {
+        helper->uses++;
+        if (pool->opts.max_uses > 0 && helper->uses >= pool->opts.max_uses) {
+            sss_child_pool_helper_stop(helper, "max_uses", false);
+            helper = NULL;
+        }
+    }
+
+    if (helper != NULL) {
+        DLIST_REMOVE(pool->busy, helper);
+        pool->num_busy--;
+        helper->busy = false;
+        helper->idle_since = time(NULL);
+        DLIST_ADD(pool->idle, helper);
+        pool->num_idle++;
+        sss_child_pool_account(pool);
+    }
+
+    sss_child_pool_dispatch(pool);
+    sss_child_pool_fill(pool);
+}
+
+/* Take an idle helper or start a new one if the pool is not full. */
+static errno_t sss_child_pool_acquire(struct sss_child_pool *pool,
+                                      struct sss_child_pool_helper **_helper)
+{
+    struct sss_child_pool_helper *helper;
+    errno_t ret;
+
+    helper = pool->idle;
+    if (helper == NULL) {
+        if (pool->num_busy >= pool->opts.max_helpers) {
+            return EAGAIN;
+        }
+
+        ret = sss_child_pool_helper_start(pool, &helper);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    DLIST_REMOVE(pool->idle, helper);
+    pool->num_idle--;
+    helper->busy = true;
+    DLIST_ADD(pool->busy, helper);
+    pool->num_busy++;
+    sss_child_pool_account(pool);
+
+    *_helper = helper;
+    return EOK;
+}
+
+struct sss_child_pool_state {
+    struct sss_child_pool_state *prev;
+    struct sss_child_pool_state *next;
+
+    struct sss_child_pool *pool;
+    struct tevent_req *req;
+    struct timeval queued;
+    bool waiting;
+
+    uint8_t *buf;
+    size_t len;
+    struct sss_child_pool_helper *helper;
+
+    uint8_t *reply;
+    size_t reply_len;
+};
+
+static void sss_child_pool_done(struct tevent_req *subreq);
+
+static int sss_child_pool_state_destructor(struct sss_child_pool_state *state)
+{
+    if (state->waiting) {
+        DLIST_REMOVE(state->pool->waiting, state);
+        state->waiting = false;
+    }
+
+    return 0;
+}
+
+static errno_t sss_child_pool_start(struct sss_child_pool_state *state)
+{
+    struct tevent_req *subreq;
+    struct timeval now;
+    struct timeval waited;
+    errno_t ret;
+
+    ret = sss_child_pool_acquire(state->pool, &state->helper);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    now = tevent_timeval_current();
+    waited = tevent_timeval_until(&state->queued, &now);
+    sss_metrics_observe(SSS_METRIC_CHILD_POOL_WAIT_DURATION,
+                        (uint64_t)waited.tv_sec * 1000000 + waited.tv_usec,
+                        state->pool->opts.name);
+
+    subreq = sss_child_pool_exchange_send(state, state->helper,
+                                          state->buf, state->len);
+    if (subreq == NULL) {
+        sss_child_pool_helper_release(state->helper, ENOMEM, false);
+        state->helper = NULL;
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(subreq, sss_child_pool_done, state->req);
+
+    return EOK;
+}
+
+struct tevent_req *sss_child_pool_send(TALLOC_CTX *mem_ctx,
+                                       struct sss_child_pool *pool,
+                                       uint8_t *buf,
+                                       size_t len)
+{
+    struct sss_child_pool_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_create(mem_ctx, &state, struct sss_child_pool_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->pool = pool;
+    state->req = req;
+    state->queued = tevent_timeval_current();
+    talloc_set_destructor(state, sss_child_pool_state_destructor);
+
+    if (len == 0 || len > SSS_CHILD_POOL_MAX_FRAME) {
+        /* an empty request is a health check */
+        ret = EINVAL;
+        goto done;
+    }
+
+    state->buf = talloc_memdup(state, buf, len);
+    if (state->buf == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    state->len = len;
+
+    ret = EAGAIN;
+    if (pool->waiting == NULL) {
+        ret = sss_child_pool_start(state);
+    }
+
+    if (ret == EAGAIN) {
+        DEBUG(SSSDBG_TRACE_FUNC, "All %s helpers are busy, waiting\n",
+              pool->opts.name);
+        DLIST_ADD_END(pool->waiting, state, struct sss_child_pool_state *);
+        state->waiting = true;
+        return req;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+    return req;
+
+done:
+    sss_metrics_inc(SSS_METRIC_CHILD_POOL_REQUESTS, 1, pool->opts.name,
+                    "error");
+    tevent_req_error(req, ret);
+    tevent_req_post(req, pool->ev);
+    return req;
+}
+
+/* Hand waiting requests to the helpers that are free. */
+static void sss_child_pool_dispatch(struct sss_child_pool *pool)
+{
+    struct sss_child_pool_state *state;
+    errno_t ret;
+
+    while (pool->waiting != NULL) {
+        state = pool->waiting;
+        DLIST_REMOVE(pool->waiting, state);
+        state->waiting = false;
+
+        ret = sss_child_pool_start(state);
+        if (ret == EAGAIN) {
+            DLIST_ADD(pool->waiting, state);
+            state->waiting = true;
+            return;
+        } else if (ret != EOK) {
+            sss_metrics_inc(SSS_METRIC_CHILD_POOL_REQUESTS, 1,
+                            pool->opts.name, "error");
+            /* we may be called from a destructor */
+            tevent_req_defer_callback(state->req, pool->ev);
+            tevent_req_error(state->req, ret);
+        }
+    }
+}
+
+static void sss_child_pool_done(struct tevent_req *subreq)
+{
+    struct sss_child_pool_state *state;
+    struct tevent_req *req;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sss_child_pool_state);
+
+    ret = sss_child_pool_exchange_recv(subreq, state, &state->reply,
+                                       &state->reply_len);
+    talloc_zfree(subreq);
+
+    sss_metrics_inc(SSS_METRIC_CHILD_POOL_REQUESTS, 1, state->pool->opts.name,
+                    ret == EOK ? "success"
+                        : ret == ETIMEDOUT ? "timeout" : "error");
+
+    sss_child_pool_helper_release(state->helper, ret, true);
+    state->helper = NULL;
+
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+errno_t sss_child_pool_recv(struct tevent_req *req,
+                            TALLOC_CTX *mem_ctx,
+                            uint8_t **_buf,
+                            size_t *_len)
+{
+    struct sss_child_pool_state *state;
+
+    state = tevent_req_data(req, struct sss_child_pool_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_buf = talloc_steal(mem_ctx, state->reply);
+    *_len = state->reply_len;
+
+    return EOK;
+}
+
+static void sss_child_pool_checked(struct tevent_req *subreq)
+{
+    struct sss_child_pool_helper *helper;
+    struct sss_child_pool *pool;
+    size_t len;
+    errno_t ret;
+
+    helper = tevent_req_callback_data(subreq, struct sss_child_pool_helper);
+
+    ret = sss_child_pool_exchange_recv(subreq, NULL, NULL, &len);
+    talloc_zfree(subreq);
+    if (ret == EOK && len != 0) {
+        ret = EIO;
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "%s helper [%d] failed the health "
+              "check [%d]: %s\n", helper->pool->opts.name, helper->pid,
+              ret, sss_strerror(ret));
+        pool = helper->pool;
+        sss_child_pool_helper_stop(helper, "health", true);
+        sss_child_pool_dispatch(pool);
+        sss_child_pool_fill(pool);
+        return;
+    }
+
+    helper->checked = time(NULL);
+    sss_child_pool_helper_release(helper, EOK, false);
+}
+
+static void sss_child_pool_maint(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval tv,
+                                 void *pvt);
+
+static errno_t sss_child_pool_schedule_maint(struct sss_child_pool *pool)
+{
+    struct timeval tv;
+
+    tv = tevent_timeval_current_ofs(SSS_CHILD_POOL_MAINT_INTERVAL, 0);
+    pool->maint = tevent_add_timer(pool->ev, pool, tv,
+                                   sss_child_pool_maint, pool);
+    if (pool->maint == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule %s pool "
+              "housekeeping\n", pool->opts.name);
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static void sss_child_pool_maint(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval tv,
+                                 void *pvt)
+{
+    struct sss_child_pool_helper *helper;
+    struct sss_child_pool_helper *next;
+    struct sss_child_pool *pool;
+    struct tevent_req *subreq;
+    time_t now;
+
+    pool = talloc_get_type(pvt, struct sss_child_pool);
+    pool->maint = NULL;
+    now = time(NULL);
+
+    for (helper = pool->idle; helper != NULL; helper = next) {
+        next = helper->next;
+
+        if (pool->opts.idle_timeout > 0
+                && pool->num_idle > pool->opts.min_idle
+                && now - helper->idle_since >= pool->opts.idle_timeout) {
+            sss_child_pool_helper_stop(helper, "idle", false);
+            continue;
+        }
+
+        if (pool->opts.health_interval == 0
+                || now - helper->checked < pool->opts.health_interval) {
+            continue;
+        }
+
+        DLIST_REMOVE(pool->idle, helper);
+        pool->num_idle--;
+        helper->busy = true;
+        DLIST_ADD(pool->busy, helper);
+        pool->num_busy++;
+
+        subreq = sss_child_pool_exchange_send(helper, helper, NULL, 0);
+        if (subreq == NULL) {
+            sss_child_pool_helper_release(helper, ENOMEM, false);
+            continue;
+        }
+        tevent_req_set_callback(subreq, sss_child_pool_checked, helper);
+    }
+
+    sss_child_pool_account(pool);
+    sss_child_pool_dispatch(pool);
+    sss_child_pool_fill(pool);
+    sss_child_pool_schedule_maint(pool);
+}
+
+static int sss_child_pool_destructor(struct sss_child_pool *pool)
+{
+    struct sss_child_pool_state *state;
+
+    /* The helpers are freed with the pool and killed. */
+    while (pool->waiting != NULL) {
+        state = pool->waiting;
+        DLIST_REMOVE(pool->waiting, state);
+        state->waiting = false;
+        tevent_req_defer_callback(state->req, pool->ev);
+        tevent_req_error(state->req, ECANCELED);
+    }
+
+    return 0;
+}
+
+errno_t sss_child_pool_create(TALLOC_CTX *mem_ctx,
+                              struct tevent_context *ev,
+                              const struct sss_child_pool_opts *opts,
+                              struct sss_child_pool **_pool)
+{
+    struct sss_child_pool *pool;
+    size_t num;
+    size_t i;
+    errno_t ret;
+
+    if (opts->name == NULL || opts->binary == NULL) {
+        return EINVAL;
+    }
+
+    pool = talloc_zero(mem_ctx, struct sss_child_pool);
+    if (pool == NULL) {
+        return ENOMEM;
+    }
+
+    pool->ev = ev;
+    pool->opts = *opts;
+    pool->opts.name = talloc_strdup(pool, opts->name);
+    pool->opts.binary = talloc_strdup(pool, opts->binary);
+    pool->opts.logfile = opts->logfile == NULL ? NULL
+                                : talloc_strdup(pool, opts->logfile);
+    if (pool->opts.name == NULL || pool->opts.binary == NULL
+            || (opts->logfile != NULL && pool->opts.logfile == NULL)) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    if (opts->extra_argv != NULL) {
+        for (num = 0; opts->extra_argv[num] != NULL; num++);
+
+        pool->opts.extra_argv = talloc_zero_array(pool, const char *,
+                                                  num + 1);
+        if (pool->opts.extra_argv == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        for (i = 0; i < num; i++) {
+            pool->opts.extra_argv[i] = talloc_strdup(pool->opts.extra_argv,
+                                                     opts->extra_argv[i]);
+            if (pool->opts.extra_argv[i] == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+        }
+    }
+
+    if (pool->opts.max_helpers == 0) {
+        pool->opts.max_helpers = MAX(pool->opts.min_idle, 1);
+    }
+    pool->opts.min_idle = MIN(pool->opts.min_idle, pool->opts.max_helpers);
+
+    talloc_set_destructor(pool, sss_child_pool_destructor);
+
+    ret = sss_child_pool_schedule_maint(pool);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    sss_child_pool_fill(pool);
+    sss_child_pool_account(pool);
+
+    *_pool = pool;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(pool);
+    }
+
+    return ret;
+}
+
+errno_t sss_child_pool_serve(int in_fd, int out_fd,
+                             sss_child_pool_handler_fn fn, void *pvt)
+{
+    uint8_t header[sizeof(uint32_t)];
+    TALLOC_CTX *tmp_ctx;
+    uint8_t *reply;
+    size_t reply_len;
+    uint32_t len;
+    uint8_t *buf;
+    ssize_t size;
+    size_t p;
+    errno_t ret;
+
+    while (true) {
+        errno = 0;
+        size = sss_atomic_read_s(in_fd, header, sizeof(header));
+        if (size == 0) {
+            /* the pool closed the pipe */
+            return EOK;
+        } else if (size != sizeof(header)) {
+            ret = size == -1 ? errno : EIO;
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read request [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            return ret;
+        }
+
+        p = 0;
+        SAFEALIGN_COPY_UINT32(&len, header, &p);
+        if (len > SSS_CHILD_POOL_MAX_FRAME) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Request of %"PRIu32" bytes is too "
+                  "large\n", len);
+            return EMSGSIZE;
+        }
+
+        tmp_ctx = talloc_new(NULL);
+        if (tmp_ctx == NULL) {
+            return ENOMEM;
+        }
+
+        buf = talloc_array(tmp_ctx, uint8_t, len + 1);
+        if (buf == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        buf[len] = '\0';
+
+        errno = 0;
+        size = sss_atomic_read_s(in_fd, buf, len);
+        if (size != (ssize_t)len) {
+            ret = size == -1 ? errno : EIO;
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read request [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+
+        reply = NULL;
+        reply_len = 0;
+        if (len > 0) {
+            ret = fn(tmp_ctx, buf, len, &reply, &reply_len, pvt);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE, "Request failed [%d]: %s\n",
+                      ret, sss_strerror(ret));
+                goto done;
+            }
+        }
+        /* else it is a health check, answered with an empty reply */
+
+        if (reply_len > SSS_CHILD_POOL_MAX_FRAME) {
+            ret = EMSGSIZE;
+            goto done;
+        }
+
+        p = 0;
+        SAFEALIGN_SET_UINT32(header, reply_len, &p);
+        errno = 0;
+        size = sss_atomic_write_s(out_fd, header, sizeof(header));
+        if (size == sizeof(header) && reply_len > 0) {
+            size = sss_atomic_write_s(out_fd, reply, reply_len);
+            if (size == (ssize_t)reply_len) {
+                size = sizeof(header);
+            }
+        }
+        if (size != sizeof(header)) {
+            ret = size == -1 ? errno : EIO;
+            DEBUG(SSSDBG_CRIT_FAILURE, "Unable to write reply [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+
+        talloc_free(tmp_ctx);
+    }
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
 static errno_t child_debug_init(const char *logfile, int *debug_fd)
 {
     int ret;
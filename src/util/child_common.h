@@ -33,6 +33,16 @@
 #include "util/util.h"
 
 #define IN_BUF_SIZE         512
+
+/* selinux_child sets the login mappings of up to SELINUX_CHILD_MAX_BATCH
+ * users at once, the input must fit into SELINUX_CHILD_IN_BUF_SIZE. */
+#define SELINUX_CHILD_MAX_BATCH     32
+#define SELINUX_CHILD_IN_BUF_SIZE   (IN_BUF_SIZE * SELINUX_CHILD_MAX_BATCH)
+
+/* A request for a p11_child in standby mode carries the options of the
+ * request in addition to the PIN. */
+#define P11_CHILD_IN_BUF_SIZE   (IN_BUF_SIZE * 8)
+
 #define CHILD_MSG_CHUNK     256
 
 #define SIGTERM_TO_SIGKILL_TIME 2
@@ -117,6 +127,84 @@ void exec_child(TALLOC_CTX *mem_ctx,
                 int *pipefd_to_child, int *pipefd_from_child,
                 const char *binary, const char *logfile);
 
+/*
+ * Start a child like fork() followed by exec_child_ex() but with
+ * posix_spawn(), which does not copy the page tables of the possibly large
+ * parent process. Nothing runs in the child before the exec, the pipes are
+ * set up by the spawn file actions.
+ */
+errno_t sss_child_spawn(int *pipefd_to_child, int *pipefd_from_child,
+                        const char *binary, const char *logfile,
+                        const char *extra_argv[], bool extra_args_only,
+                        int child_in_fd, int child_out_fd,
+                        pid_t *_pid);
+
 int child_io_destructor(void *ptr);
 
+/* HELPER POOL */
+
+/*
+ * A helper pool keeps child processes started in advance and hands them one
+ * request after another, so that the start-up of a child is paid once for
+ * many requests. Requests are queued while all helpers are busy.
+ *
+ * Requests and replies are framed on the stdin and stdout of the helper:
+ *   uint32_t length of the payload (host byte order)
+ *   payload
+ * A request with an empty payload is a health check, the helper answers it
+ * with an empty reply. Helpers implement the protocol by calling
+ * sss_child_pool_serve().
+ */
+#define SSS_CHILD_POOL_MAX_FRAME (1024 * 1024)
+
+struct sss_child_pool;
+
+struct sss_child_pool_opts {
+    /* used in debug messages and as the pool label of the metrics */
+    const char *name;
+    const char *binary;
+    const char *logfile;
+    const char **extra_argv;
+
+    /* idle helpers kept started */
+    size_t min_idle;
+    /* started helpers at most, defaults to min_idle or 1 */
+    size_t max_helpers;
+    /* a helper is replaced after this many requests, 0 for no limit */
+    unsigned int max_uses;
+    /* idle helpers above min_idle are stopped after this many seconds,
+     * 0 to keep them */
+    time_t idle_timeout;
+    /* idle helpers are health checked this often in seconds, 0 to
+     * disable */
+    time_t health_interval;
+    /* a helper that does not answer in this many seconds is killed,
+     * 0 for no limit */
+    time_t timeout;
+};
+
+errno_t sss_child_pool_create(TALLOC_CTX *mem_ctx,
+                              struct tevent_context *ev,
+                              const struct sss_child_pool_opts *opts,
+                              struct sss_child_pool **_pool);
+
+/* Requests still waiting for a helper fail with ECANCELED when the pool is
+ * freed, running requests must not outlive the pool. */
+struct tevent_req *sss_child_pool_send(TALLOC_CTX *mem_ctx,
+                                       struct sss_child_pool *pool,
+                                       uint8_t *buf, size_t len);
+errno_t sss_child_pool_recv(struct tevent_req *req, TALLOC_CTX *mem_ctx,
+                            uint8_t **_buf, size_t *_len);
+
+/* Handle one request in the helper. A failure ends the helper. */
+typedef errno_t (*sss_child_pool_handler_fn)(TALLOC_CTX *mem_ctx,
+                                             uint8_t *buf, size_t len,
+                                             uint8_t **_reply,
+                                             size_t *_reply_len,
+                                             void *pvt);
+
+/* Serve the requests read from @in_fd until it is closed by the pool. */
+errno_t sss_child_pool_serve(int in_fd, int out_fd,
+                             sss_child_pool_handler_fn fn, void *pvt);
+
 #endif /* __CHILD_COMMON_H__ */
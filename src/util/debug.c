@@ -25,11 +25,16 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <inttypes.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#if HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #ifdef WITH_JOURNALD
 #include <systemd/sd-journal.h>
 #endif
@@ -176,6 +181,489 @@ int debug_convert_old_level(int old_level)
     return new_level;
 }
 
+/* Formats the beginning of a debug line into buf. Only used for lines
+ * which are not written directly, the formatted time is kept for the
+ * whole second to avoid calling localtime() for every line. */
+static int debug_format_prefix(char *buf, size_t size,
+                               const char *function, int level)
+{
+    static time_t last_sec = -1;
+    static char last_ts[32];
+    struct timeval tv;
+    struct tm *tm;
+    int len = 0;
+    int ret;
+
+    if (debug_timestamps) {
+        gettimeofday(&tv, NULL);
+        if (tv.tv_sec != last_sec) {
+            tm = localtime(&tv.tv_sec);
+            ret = snprintf(last_ts, sizeof(last_ts),
+                           "(%d-%02d-%02d %2d:%02d:%02d",
+                           tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+                           tm->tm_hour, tm->tm_min, tm->tm_sec);
+            if (ret < 0 || ret >= sizeof(last_ts)) {
+                return -1;
+            }
+            last_sec = tv.tv_sec;
+        }
+
+        if (debug_microseconds) {
+            ret = snprintf(buf, size, "%s:%.6ld): ", last_ts, tv.tv_usec);
+        } else {
+            ret = snprintf(buf, size, "%s): ", last_ts);
+        }
+        if (ret < 0 || ret >= size) {
+            return -1;
+        }
+        len += ret;
+    }
+
+    ret = snprintf(buf + len, size - len, "[%s] [%s] (%#.4x): ",
+                   debug_prg_name, function, level);
+    if (ret < 0 || ret >= size - len) {
+        return -1;
+    }
+
+    return len + ret;
+}
+
+#if HAVE_PTHREAD
+
+/* Asynchronous debug output
+ *
+ * While the writer thread runs, sss_vdebug_fn() formats every line into a
+ * ring buffer and returns. The writer thread wakes up every
+ * DEBUG_ASYNC_INTERVAL_MS, or earlier when the buffer is half full, and
+ * writes everything collected so far with a single flush.
+ *
+ * The buffer has one producer, the thread which runs the event loop, and
+ * one consumer, the writer thread, so head and tail are only ever changed
+ * by one side each and no lock is needed. When the buffer is full the line
+ * is dropped and counted; the writer reports the number of dropped lines.
+ * Only fatal and critical failures are never dropped, they are written
+ * directly instead. */
+#define DEBUG_ASYNC_BUFFER_SIZE (1 << 20) /* must be a power of 2 */
+#define DEBUG_ASYNC_LINE_SIZE 1024
+#define DEBUG_ASYNC_INTERVAL_MS 50
+
+struct debug_async {
+    bool active;
+    bool stop;
+
+    char *buf;
+    /* Total number of bytes written to and read from buf. */
+    uint64_t head;
+    uint64_t tail;
+    uint64_t dropped;
+
+    pthread_t thread;
+    pthread_mutex_t wake_mtx;
+    pthread_cond_t wake_cond;
+
+    /* Serializes writes to debug_file with log rotation. */
+    pthread_mutex_t file_mtx;
+};
+
+static struct debug_async debug_async = {
+    .wake_mtx = PTHREAD_MUTEX_INITIALIZER,
+    .wake_cond = PTHREAD_COND_INITIALIZER,
+    .file_mtx = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void debug_async_write_locked(const char *data, size_t len)
+{
+    FILE *f = debug_file ? debug_file : stderr;
+
+    fwrite(data, 1, len, f);
+}
+
+static void debug_async_drain(void)
+{
+    uint64_t head;
+    uint64_t tail;
+    uint64_t dropped;
+    size_t offset;
+    size_t len;
+    size_t first;
+
+    head = __atomic_load_n(&debug_async.head, __ATOMIC_ACQUIRE);
+    tail = debug_async.tail;
+    dropped = __atomic_exchange_n(&debug_async.dropped, 0, __ATOMIC_RELAXED);
+
+    if (head == tail && dropped == 0) {
+        return;
+    }
+
+    len = head - tail;
+    offset = tail & (DEBUG_ASYNC_BUFFER_SIZE - 1);
+    first = MIN(len, DEBUG_ASYNC_BUFFER_SIZE - offset);
+
+    pthread_mutex_lock(&debug_async.file_mtx);
+    debug_async_write_locked(debug_async.buf + offset, first);
+    debug_async_write_locked(debug_async.buf, len - first);
+    if (dropped > 0) {
+        fprintf(debug_file ? debug_file : stderr,
+                "[%s] [%s] (%#.4x): %"PRIu64" debug messages were dropped\n",
+                debug_prg_name, __FUNCTION__, SSSDBG_MINOR_FAILURE, dropped);
+    }
+    fflush(debug_file ? debug_file : stderr);
+    pthread_mutex_unlock(&debug_async.file_mtx);
+
+    __atomic_store_n(&debug_async.tail, head, __ATOMIC_RELEASE);
+}
+
+static void *debug_async_main(void *arg)
+{
+    struct timespec ts;
+    bool stop;
+
+    do {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += DEBUG_ASYNC_INTERVAL_MS * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&debug_async.wake_mtx);
+        if (!debug_async.stop) {
+            pthread_cond_timedwait(&debug_async.wake_cond,
+                                   &debug_async.wake_mtx, &ts);
+        }
+        stop = debug_async.stop;
+        pthread_mutex_unlock(&debug_async.wake_mtx);
+
+        debug_async_drain();
+    } while (!stop);
+
+    return NULL;
+}
+
+static bool debug_async_push(const char *data, size_t len)
+{
+    uint64_t head = debug_async.head;
+    uint64_t tail;
+    size_t offset;
+    size_t first;
+
+    tail = __atomic_load_n(&debug_async.tail, __ATOMIC_ACQUIRE);
+    if (len > DEBUG_ASYNC_BUFFER_SIZE - (head - tail)) {
+        return false;
+    }
+
+    offset = head & (DEBUG_ASYNC_BUFFER_SIZE - 1);
+    first = MIN(len, DEBUG_ASYNC_BUFFER_SIZE - offset);
+    memcpy(debug_async.buf + offset, data, first);
+    memcpy(debug_async.buf, data + first, len - first);
+
+    __atomic_store_n(&debug_async.head, head + len, __ATOMIC_RELEASE);
+
+    if (head + len - tail >= DEBUG_ASYNC_BUFFER_SIZE / 2) {
+        pthread_cond_signal(&debug_async.wake_cond);
+    }
+
+    return true;
+}
+
+static void debug_async_vprintf(const char *function, int level, int flags,
+                                const char *format, va_list ap)
+{
+    char stack_line[DEBUG_ASYNC_LINE_SIZE];
+    char *line = stack_line;
+    char *heap_line = NULL;
+    size_t size = sizeof(stack_line);
+    int prefix_len;
+    int msg_len;
+    size_t len;
+    va_list ap_copy;
+
+    prefix_len = debug_format_prefix(stack_line, size, function, level);
+    if (prefix_len < 0) {
+        goto drop;
+    }
+
+    va_copy(ap_copy, ap);
+    msg_len = vsnprintf(line + prefix_len, size - prefix_len, format, ap_copy);
+    va_end(ap_copy);
+    if (msg_len < 0) {
+        goto drop;
+    }
+
+    /* One more byte for the line feed */
+    len = prefix_len + msg_len;
+    if (len + 1 >= size) {
+        size = len + 2;
+        heap_line = malloc(size);
+        if (heap_line == NULL) {
+            goto drop;
+        }
+        memcpy(heap_line, stack_line, prefix_len);
+        vsnprintf(heap_line + prefix_len, size - prefix_len, format, ap);
+        line = heap_line;
+    }
+
+    if (flags & APPEND_LINE_FEED) {
+        line[len++] = '\n';
+    }
+
+    if (!debug_async_push(line, len)) {
+        if (!(level & (SSSDBG_FATAL_FAILURE | SSSDBG_CRIT_FAILURE))) {
+            free(heap_line);
+            goto drop;
+        }
+
+        pthread_mutex_lock(&debug_async.file_mtx);
+        debug_async_write_locked(line, len);
+        fflush(debug_file ? debug_file : stderr);
+        pthread_mutex_unlock(&debug_async.file_mtx);
+    }
+
+    free(heap_line);
+    return;
+
+drop:
+    __atomic_add_fetch(&debug_async.dropped, 1, __ATOMIC_RELAXED);
+}
+
+/* Writes complete lines, used for the backtrace dump. */
+static void debug_async_write(const char *data, size_t len)
+{
+    if (debug_async_push(data, len)) {
+        return;
+    }
+
+    pthread_mutex_lock(&debug_async.file_mtx);
+    debug_async_write_locked(data, len);
+    fflush(debug_file ? debug_file : stderr);
+    pthread_mutex_unlock(&debug_async.file_mtx);
+}
+
+static void debug_async_atfork_child(void)
+{
+    /* The writer thread does not exist in the child, the lines still in
+     * the buffer are written by the parent. */
+    debug_async.active = false;
+    pthread_mutex_init(&debug_async.file_mtx, NULL);
+    pthread_mutex_init(&debug_async.wake_mtx, NULL);
+    pthread_cond_init(&debug_async.wake_cond, NULL);
+}
+
+errno_t debug_start_async_writer(void)
+{
+    static bool atfork_registered = false;
+    int ret;
+
+    if (debug_async.active) {
+        return EOK;
+    }
+
+    if (debug_async.buf == NULL) {
+        debug_async.buf = malloc(DEBUG_ASYNC_BUFFER_SIZE);
+        if (debug_async.buf == NULL) {
+            return ENOMEM;
+        }
+    }
+
+    if (!atfork_registered) {
+        ret = pthread_atfork(NULL, NULL, debug_async_atfork_child);
+        if (ret != 0) {
+            return ret;
+        }
+
+        ret = atexit(debug_stop_async_writer);
+        if (ret != 0) {
+            return EIO;
+        }
+
+        atfork_registered = true;
+    }
+
+    debug_async.head = 0;
+    debug_async.tail = 0;
+    debug_async.stop = false;
+
+    ret = pthread_create(&debug_async.thread, NULL, debug_async_main, NULL);
+    if (ret != 0) {
+        return ret;
+    }
+
+    debug_async.active = true;
+
+    return EOK;
+}
+
+void debug_stop_async_writer(void)
+{
+    if (!debug_async.active) {
+        return;
+    }
+
+    pthread_mutex_lock(&debug_async.wake_mtx);
+    debug_async.stop = true;
+    pthread_cond_signal(&debug_async.wake_cond);
+    pthread_mutex_unlock(&debug_async.wake_mtx);
+
+    /* The writer drains the buffer before it exits, lines logged from now
+     * on are written directly. */
+    pthread_join(debug_async.thread, NULL);
+    debug_async.active = false;
+}
+
+static void debug_file_lock(void)
+{
+    if (debug_async.active) {
+        pthread_mutex_lock(&debug_async.file_mtx);
+    }
+}
+
+static void debug_file_unlock(void)
+{
+    if (debug_async.active) {
+        pthread_mutex_unlock(&debug_async.file_mtx);
+    }
+}
+
+#else /* HAVE_PTHREAD */
+
+errno_t debug_start_async_writer(void)
+{
+    return ENOTSUP;
+}
+
+void debug_stop_async_writer(void)
+{
+    return;
+}
+
+static void debug_file_lock(void) { return; }
+static void debug_file_unlock(void) { return; }
+
+#endif /* HAVE_PTHREAD */
+
+/* Debug backtrace
+ *
+ * Messages of the levels in DEBUG_BACKTRACE_LEVELS which are not written
+ * because of the debug level are formatted into a ring buffer instead,
+ * overwriting the oldest ones. When a failure (fatal, critical or
+ * operation failure) is written, the buffer is written before it, so the
+ * log contains what happened right before the failure although the debug
+ * level is low. The buffer is emptied by the dump. */
+#define DEBUG_BACKTRACE_SIZE (256 * 1024)
+#define DEBUG_BACKTRACE_LINE_SIZE 1024
+#define DEBUG_BACKTRACE_TRIGGER \
+    (SSSDBG_FATAL_FAILURE | SSSDBG_CRIT_FAILURE | SSSDBG_OP_FAILURE)
+
+bool debug_backtrace_enabled = false;
+
+static struct {
+    char buf[DEBUG_BACKTRACE_SIZE];
+    size_t pos;
+    bool wrapped;
+    bool empty;
+} debug_backtrace = { .empty = true };
+
+static void debug_backtrace_vprintf(const char *function, int level,
+                                    int flags, const char *format,
+                                    va_list ap)
+{
+    char line[DEBUG_BACKTRACE_LINE_SIZE];
+    size_t first;
+    size_t len;
+    int ret;
+
+    ret = debug_format_prefix(line, sizeof(line), function, level);
+    if (ret < 0) {
+        return;
+    }
+    len = ret;
+
+    ret = vsnprintf(line + len, sizeof(line) - len, format, ap);
+    if (ret < 0) {
+        return;
+    }
+
+    /* Long messages are truncated, the line feed always fits */
+    len = MIN(len + ret, sizeof(line) - 2);
+    if (flags & APPEND_LINE_FEED) {
+        line[len++] = '\n';
+    } else if (line[len - 1] != '\n') {
+        line[len++] = '\n';
+    }
+
+    first = MIN(len, DEBUG_BACKTRACE_SIZE - debug_backtrace.pos);
+    memcpy(debug_backtrace.buf + debug_backtrace.pos, line, first);
+    if (first < len) {
+        memcpy(debug_backtrace.buf, line + first, len - first);
+        debug_backtrace.pos = len - first;
+        debug_backtrace.wrapped = true;
+    } else {
+        debug_backtrace.pos += len;
+        if (debug_backtrace.pos == DEBUG_BACKTRACE_SIZE) {
+            debug_backtrace.pos = 0;
+            debug_backtrace.wrapped = true;
+        }
+    }
+    debug_backtrace.empty = false;
+}
+
+static void debug_write(const char *data, size_t len)
+{
+#if HAVE_PTHREAD
+    if (debug_async.active) {
+        debug_async_write(data, len);
+        return;
+    }
+#endif
+
+    fwrite(data, 1, len, debug_file ? debug_file : stderr);
+}
+
+static void debug_backtrace_dump(void)
+{
+    static const char begin[] =
+        "********************** BACKTRACE DUMP BEGINS HERE "
+        "**********************\n";
+    static const char end[] =
+        "********************** BACKTRACE DUMP ENDS HERE "
+        "************************\n";
+    const char *start;
+    const char *nl;
+
+    if (debug_backtrace.empty) {
+        return;
+    }
+
+    debug_write(begin, sizeof(begin) - 1);
+
+    if (debug_backtrace.wrapped) {
+        /* The oldest line was partially overwritten, skip it */
+        start = debug_backtrace.buf + debug_backtrace.pos;
+        nl = memchr(start, '\n', DEBUG_BACKTRACE_SIZE - debug_backtrace.pos);
+        if (nl != NULL) {
+            start = nl + 1;
+            debug_write(start,
+                        debug_backtrace.buf + DEBUG_BACKTRACE_SIZE - start);
+            debug_write(debug_backtrace.buf, debug_backtrace.pos);
+        } else {
+            nl = memchr(debug_backtrace.buf, '\n', debug_backtrace.pos);
+            if (nl != NULL) {
+                start = nl + 1;
+                debug_write(start,
+                            debug_backtrace.buf + debug_backtrace.pos - start);
+            }
+        }
+    } else {
+        debug_write(debug_backtrace.buf, debug_backtrace.pos);
+    }
+
+    debug_write(end, sizeof(end) - 1);
+
+    debug_backtrace.pos = 0;
+    debug_backtrace.wrapped = false;
+    debug_backtrace.empty = true;
+}
+
 static void debug_fflush(void)
 {
     fflush(debug_file ? debug_file : stderr);
@@ -277,6 +765,20 @@ void sss_vdebug_fn(const char *file,
 #ifdef WITH_JOURNALD
     errno_t ret;
     va_list ap_fallback;
+#endif
+
+    if (!DEBUG_IS_SET(level)) {
+        /* Only reached if the message is kept for the backtrace */
+#ifdef WITH_JOURNALD
+        if (sss_logger == JOURNALD_LOGGER) {
+            return;
+        }
+#endif
+        debug_backtrace_vprintf(function, level, flags, format, ap);
+        return;
+    }
+
+#ifdef WITH_JOURNALD
 
     if (sss_logger == JOURNALD_LOGGER) {
         /* If we are not outputting logs to files, we should be sending them
@@ -298,6 +800,17 @@ void sss_vdebug_fn(const char *file,
     }
 #endif
 
+    if (level & DEBUG_BACKTRACE_TRIGGER) {
+        debug_backtrace_dump();
+    }
+
+#if HAVE_PTHREAD
+    if (debug_async.active) {
+        debug_async_vprintf(function, level, flags, format, ap);
+        return;
+    }
+#endif
+
     if (debug_timestamps) {
         gettimeofday(&tv, NULL);
         tm = localtime(&tv.tv_sec);
@@ -465,6 +978,9 @@ int rotate_debug_files(void)
 
     if (sss_logger != FILES_LOGGER) return EOK;
 
+    /* The writer thread must not use the file while it is replaced */
+    debug_file_lock();
+
     do {
         error = 0;
         ret = fclose(debug_file);
@@ -494,7 +1010,10 @@ int rotate_debug_files(void)
 
     debug_file = NULL;
 
-    return open_debug_file();
+    ret = open_debug_file();
+    debug_file_unlock();
+
+    return ret;
 }
 
 void talloc_log_fn(const char *message)
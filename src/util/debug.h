@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <stdbool.h>
 
 #ifdef HAVE_FUNCTION_ATTRIBUTE_FORMAT
 #define SSS_ATTRIBUTE_PRINTF(a1, a2) __attribute__((format (printf, a1, a2)))
@@ -50,6 +51,7 @@ extern int debug_to_file;
 extern int debug_to_stderr;
 extern enum sss_logger_t sss_logger;
 extern const char *debug_log_file;
+extern bool debug_backtrace_enabled;
 
 void sss_set_logger(const char *logger);
 
@@ -69,6 +71,12 @@ int debug_convert_old_level(int old_level);
 errno_t set_debug_file_from_fd(const int fd);
 int get_fd_from_debug_file(void);
 
+/* Let a separate thread write the debug messages to the log file, the
+ * messages are then only queued by the caller. */
+errno_t debug_start_async_writer(void);
+/* Write the queued messages and stop the writer thread. */
+void debug_stop_async_writer(void);
+
 #define SSS_DOM_ENV           "_SSS_DOM"
 
 #define SSSDBG_FATAL_FAILURE  0x0010   /* level 0 */
@@ -100,6 +108,15 @@ int get_fd_from_debug_file(void);
 #define SSSDBG_MICROSECONDS_UNRESOLVED   -1
 #define SSSDBG_MICROSECONDS_DEFAULT       0
 
+/* levels which are kept in the backtrace if they are not written */
+#define SSSDBG_BACKTRACE_LEVELS (SSSDBG_FATAL_FAILURE | \
+                                 SSSDBG_CRIT_FAILURE | \
+                                 SSSDBG_OP_FAILURE | \
+                                 SSSDBG_MINOR_FAILURE | \
+                                 SSSDBG_CONF_SETTINGS | \
+                                 SSSDBG_FUNC_DATA | \
+                                 SSSDBG_TRACE_FUNC)
+
 #define SSSD_LOGGER_OPTS \
         {"logger", '\0', POPT_ARG_STRING, &opt_logger, 0, \
          _("Set logger"), "stderr|files|journald"},
@@ -124,10 +141,14 @@ int get_fd_from_debug_file(void);
     \param format the debug message format string, should result in a
                   newline-terminated message
     \param ... the debug message format arguments
+
+    Messages which are not written because of the debug level are kept in
+    the backtrace, see DEBUG_BACKTRACE_IS_SET().
 */
 #define DEBUG(level, format, ...) do { \
     int __debug_macro_level = level; \
-    if (DEBUG_IS_SET(__debug_macro_level)) { \
+    if (DEBUG_IS_SET(__debug_macro_level) \
+            || DEBUG_BACKTRACE_IS_SET(__debug_macro_level)) { \
         sss_debug_fn(__FILE__, __LINE__, __FUNCTION__, \
                      __debug_macro_level, \
                      format, ##__VA_ARGS__); \
@@ -144,6 +165,14 @@ int get_fd_from_debug_file(void);
                                             (level & (SSSDBG_FATAL_FAILURE | \
                                                       SSSDBG_CRIT_FAILURE))))
 
+/** \def DEBUG_BACKTRACE_IS_SET(level)
+    \brief checks whether a message of this level is kept in the backtrace
+
+    \param level the debug level, please use one of the SSSDBG*_ macros
+*/
+#define DEBUG_BACKTRACE_IS_SET(level) (debug_backtrace_enabled && \
+                                       ((level) & SSSDBG_BACKTRACE_LEVELS))
+
 #define DEBUG_INIT(dbg_lvl) do { \
     if (dbg_lvl != SSSDBG_INVALID) { \
         debug_level = debug_convert_old_level(dbg_lvl); \
@@ -23,6 +23,7 @@
 #define _MMAP_CACHE_H_
 
 #include "shared/murmurhash3.h"
+#include "shared/wyhash.h"
 
 
 /* NOTE: all the code here assumes that writing a uint32_t nto mmapped
@@ -70,8 +71,42 @@ typedef uint32_t rel_ptr_t;
 #define MC_SLOT_WITHIN_BOUNDS(slot, dt_size) \
     ((slot) < ((dt_size) / MC_SLOT_SIZE))
 
+/*
+ * With SSS_MC_LAYOUT_PROBING the hash table is an open addressing table with
+ * linear probing. Each 32 bit entry stores the slot of the record together
+ * with a fingerprint and a flag telling which of the two record keys the
+ * entry belongs to:
+ *
+ *   bit 31      key2 flag (0 - hash1/name, 1 - hash2/id)
+ *   bits 24-30  fingerprint, low 7 bits of the home bucket
+ *   bits 0-23   slot of the record in the data table
+ *
+ * Since no entry is ever stored further than MC_HT_MAX_PROBES positions from
+ * its home bucket and the number of buckets is a multiple of MC_HT_MAX_PROBES
+ * the home bucket can be recovered from the fingerprint, so lookups only need
+ * to read records whose fingerprint matches.
+ */
+#define MC_HT_MAX_PROBES 128
+#define MC_HT_SLOT_MASK 0x00ffffff
+#define MC_HT_FP(hash) ((hash) & (MC_HT_MAX_PROBES - 1))
+#define MC_HT_ENTRY(slot, hash, key2) \
+    ((((uint32_t)(key2) & 1) << 31) | (MC_HT_FP(hash) << 24) \
+     | ((slot) & MC_HT_SLOT_MASK))
+#define MC_HT_ENTRY_SLOT(e) ((e) & MC_HT_SLOT_MASK)
+#define MC_HT_ENTRY_FP(e) (((e) >> 24) & (MC_HT_MAX_PROBES - 1))
+#define MC_HT_ENTRY_KEY2(e) ((e) >> 31)
+#define MC_HT_ENTRY_DIST(e, pos) (((pos) - MC_HT_ENTRY_FP(e)) \
+                                  & (MC_HT_MAX_PROBES - 1))
+
 #define MC_VALID_BARRIER(val) (((val) & 0xff000000) == 0xf0000000)
 
+/* Readers treat the barriers as a seqlock: b1 is sampled before the copy and
+ * compared with b2 afterwards. A torn copy is retried up to
+ * MC_READ_MAX_RETRIES times, the first MC_READ_SPIN_RETRIES attempts spin,
+ * the following ones yield the CPU to let the writer finish. */
+#define MC_READ_SPIN_RETRIES 8
+#define MC_READ_MAX_RETRIES 32
+
 #define MC_CHECK_RECORD_LENGTH(mc_ctx, rec) \
         ((rec)->len >= MC_HEADER_SIZE && (rec)->len != MC_INVALID_VAL32 \
          && ((rec)->len <= ((mc_ctx)->dt_size \
@@ -79,12 +114,67 @@ typedef uint32_t rel_ptr_t;
 
 
 #define SSS_MC_MAJOR_VNO    1
-#define SSS_MC_MINOR_VNO    1
+#define SSS_MC_MINOR_VNO    8
 
 #define SSS_MC_HEADER_UNINIT    0   /* after ftruncate or before reset */
 #define SSS_MC_HEADER_ALIVE     1   /* current and in use */
 #define SSS_MC_HEADER_RECYCLED  2   /* file was recycled, reopen asap */
 
+#define SSS_MC_LAYOUT_CHAINED   0   /* buckets point to chains of records */
+#define SSS_MC_LAYOUT_PROBING   1   /* open addressing, see MC_HT_ENTRY */
+
+#define SSS_MC_HASH_MURMURHASH3 0   /* murmurhash3() */
+#define SSS_MC_HASH_WYHASH      1   /* wyhash() */
+
+/* header flags */
+#define SSS_MC_FLAG_HUGE_PAGES  0x0001  /* map the file with huge pages */
+
+/* The health word of the header is written by the responder every
+ * SSS_MC_HEALTH_INTERVAL seconds:
+ *   bits 24-31 state (SSS_MC_HEALTH_*)
+ *   bits 16-23 load, the smoothed lag of the responder in 10 ms units
+ *   bits 0-15  heartbeat, CLOCK_MONOTONIC seconds of the update
+ * Clients do not trust a word whose heartbeat is older than
+ * SSS_MC_HEALTH_STALE seconds. */
+#define SSS_MC_HEALTH_UNKNOWN       0   /* not published yet */
+#define SSS_MC_HEALTH_OK            1
+#define SSS_MC_HEALTH_BUSY          2   /* replies are delayed */
+#define SSS_MC_HEALTH_OVERLOADED    3   /* clients should not wait */
+
+#define SSS_MC_HEALTH_INTERVAL      1
+#define SSS_MC_HEALTH_STALE         5
+
+/* lag of the responder from which it reports itself busy or overloaded */
+#define SSS_MC_HEALTH_BUSY_MSEC         100
+#define SSS_MC_HEALTH_OVERLOADED_MSEC   1000
+
+#define SSS_MC_HEALTH_WORD(state, load, beat) \
+        (((uint32_t)(state) << 24) | (((uint32_t)(load) & 0xff) << 16) \
+         | ((uint32_t)(beat) & 0xffff))
+#define SSS_MC_HEALTH_STATE(word) ((word) >> 24)
+#define SSS_MC_HEALTH_LOAD(word) (((word) >> 16) & 0xff)
+#define SSS_MC_HEALTH_BEAT(word) ((word) & 0xffff)
+#define SSS_MC_HEALTH_AGE(word, now) (((now) - SSS_MC_HEALTH_BEAT(word)) \
+                                      & 0xffff)
+
+/* files with huge pages are a multiple of the PMD size of x86_64 and
+ * aarch64 with 4K pages */
+#define MC_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define MC_ALIGN_HUGE_PAGE(size) \
+        (((size) + MC_HUGE_PAGE_SIZE - 1) & ~((size_t)MC_HUGE_PAGE_SIZE - 1))
+
+/* keys of the SID cache records of lookups by POSIX ID */
+#define MC_SID_BY_ID_KEY    "id:%u"
+#define MC_SID_BY_UID_KEY   "uid:%u"
+#define MC_SID_BY_GID_KEY   "gid:%u"
+
+/* keys of the services and hosts cache records, the protocol of a service
+ * is empty if any protocol was requested */
+#define MC_SVC_BY_NAME_KEY  "name:%s/%s"
+#define MC_SVC_BY_PORT_KEY  "port:%u/%s"
+#define MC_HOST_BY_NAME_KEY "name:%s"
+#define MC_HOST_BY_ADDR_KEY "addr:%s"
+
 #pragma pack(1)
 struct sss_mc_header {
     uint32_t b1;            /* barrier 1 */
@@ -98,7 +188,19 @@ struct sss_mc_header {
     rel_ptr_t data_table;   /* data table pointer relative to mmap base */
     rel_ptr_t free_table;   /* free table pointer relative to mmap base */
     rel_ptr_t hash_table;   /* hash table pointer relative to mmap base */
-    rel_ptr_t reserved;     /* reserved for future changes */
+    uint32_t fallbacks;     /* number of lookups answered by the responder
+                             * while a valid record was already cached,
+                             * not protected by barriers */
+    uint32_t layout;        /* hash table layout */
+    uint32_t flags;         /* SSS_MC_FLAG_* */
+    uint32_t neg_timeout;   /* seconds clients may remember that a lookup
+                             * found nothing, 0 if they must not */
+    uint32_t hash;          /* hash function of the keys (SSS_MC_HASH_*) */
+    uint32_t generation;    /* records of other generations are stale, it
+                             * is bumped in place by sss_cache and not
+                             * protected by barriers */
+    uint32_t health;        /* SSS_MC_HEALTH_WORD of the responder, written
+                             * in place and not protected by barriers */
     uint32_t b2;            /* barrier 2 */
 };
 
@@ -112,7 +214,7 @@ struct sss_mc_rec {
                             /* next2 is related to hash2 */
     uint32_t hash1;         /* val of first hash (usually name of record) */
     uint32_t hash2;         /* val of second hash (usually id of record) */
-    uint32_t padding;       /* padding & reserved for future changes */
+    uint32_t generation;    /* header generation the record was written in */
     uint32_t b2;            /* barrier 2 - 32 bytes mark, fits a slot */
     char data[0];
 };
@@ -149,6 +251,37 @@ struct sss_mc_initgr_data {
                              * after gids */
 };
 
+/* Records of the SID cache are looked up by SID or by name (hash1 and hash2
+ * of the record) while records of lookups by POSIX ID use a key built with
+ * one of the MC_SID_*_KEY formats for both hashes. */
+struct sss_mc_sid_data {
+    rel_ptr_t key;          /* ptr to the key of the record (SID or id key),
+                             * rel. to struct base addr */
+    rel_ptr_t sid;          /* ptr to SID string, rel. to struct base addr */
+    rel_ptr_t name;         /* ptr to name string, rel. to struct base addr */
+    uint32_t type;          /* enum sss_id_type of the object */
+    uint32_t id;            /* POSIX ID, 0 if the object does not have one */
+    uint32_t strs_len;      /* length of strs */
+    char strs[0];           /* concatenation of all strings, each string is
+                             * zero terminated ordered as follows:
+                             * id key (only in id records), SID, name */
+};
+
+/* Records of the services and hosts caches keep the result data of the
+ * responder reply as it is sent over the socket, the clients parse it with
+ * the same code. Both keys are built with the MC_SVC_* or MC_HOST_* formats,
+ * records of lookups by name use the same key twice. */
+struct sss_mc_reply_data {
+    rel_ptr_t key;          /* ptr to the first key, rel. to struct base addr */
+    rel_ptr_t key2;         /* ptr to the second key, rel. to struct base addr */
+    rel_ptr_t reply;        /* ptr to the result data, rel. to struct base
+                             * addr */
+    uint32_t reply_len;     /* length of the result data */
+    uint32_t strs_len;      /* length of strs */
+    char strs[0];           /* zero terminated keys followed by the
+                             * result data */
+};
+
 #pragma pack()
 
 
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/types.h>
+#include <dhash.h>
 
 #include "util/secrets/secrets.h"
 
@@ -43,6 +44,11 @@ struct sss_sec_ctx {
 
     struct sss_sec_quota *quota_secrets;
     struct sss_sec_quota *quota_kcm;
+
+    /* Number of secrets under a hive or per-UID container, keyed by the
+     * DN. Valid as long as the database sequence number matches. */
+    hash_table_t *counters;
+    uint64_t counters_seqnum;
 };
 
 struct sss_sec_req {
@@ -202,13 +202,201 @@ done:
     return ret;
 }
 
+static struct ldb_dn *per_uid_container(TALLOC_CTX *mem_ctx,
+                                        struct ldb_dn *req_dn)
+{
+    int user_comp;
+    int num_comp;
+    struct ldb_dn *uid_base_dn;
+
+    uid_base_dn = ldb_dn_copy(mem_ctx, req_dn);
+    if (uid_base_dn == NULL) {
+        return NULL;
+    }
+
+    /* Remove all the components up to the per-user base path which consists
+     * of three components:
+     *  cn=<uidnumber>,cn=users,cn=secrets
+     */
+    user_comp = ldb_dn_get_comp_num(uid_base_dn) - 3;
+
+    if (!ldb_dn_remove_child_components(uid_base_dn, user_comp)) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot remove child components\n");
+        talloc_free(uid_base_dn);
+        return NULL;
+    }
+
+    num_comp = ldb_dn_get_comp_num(uid_base_dn);
+    if (num_comp != 3) {
+        DEBUG(SSSDBG_OP_FAILURE, "Expected 3 components got %d\n", num_comp);
+        talloc_free(uid_base_dn);
+        return NULL;
+    }
+
+    return uid_base_dn;
+}
+
+/* Drops the secret counters if the database was modified by someone else
+ * since they were last updated. */
+static void local_db_counters_check(struct sss_sec_ctx *sctx)
+{
+    uint64_t seqnum;
+    int ret;
+
+    if (sctx->counters == NULL) {
+        return;
+    }
+
+    ret = ldb_sequence_number(sctx->ldb, LDB_SEQ_HIGHEST_SEQ, &seqnum);
+    if (ret != LDB_SUCCESS || seqnum != sctx->counters_seqnum) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "The database was modified, "
+              "the number of secrets will be counted again\n");
+        talloc_zfree(sctx->counters);
+    }
+}
+
+static int local_db_count_secrets(TALLOC_CTX *mem_ctx,
+                                  struct sss_sec_ctx *sctx,
+                                  struct ldb_dn *dn,
+                                  unsigned long *_count)
+{
+    static const char *attrs[] = { NULL };
+    struct ldb_result *res = NULL;
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+    int ret;
+
+    if (sctx->counters == NULL) {
+        ret = ldb_sequence_number(sctx->ldb, LDB_SEQ_HIGHEST_SEQ,
+                                  &sctx->counters_seqnum);
+        if (ret != LDB_SUCCESS) {
+            return sss_ldb_error_to_errno(ret);
+        }
+
+        ret = sss_hash_create(sctx, 0, &sctx->counters);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(ldb_dn_get_linearized(dn));
+    if (key.str == NULL) {
+        return EINVAL;
+    }
+
+    hret = hash_lookup(sctx->counters, &key, &value);
+    if (hret == HASH_SUCCESS) {
+        *_count = value.ul;
+        return EOK;
+    }
+
+    ret = ldb_search(sctx->ldb, mem_ctx, &res, dn, LDB_SCOPE_SUBTREE,
+                     attrs, LOCAL_SIMPLE_FILTER);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_LIBS,
+              "ldb_search returned %d: %s\n", ret, ldb_strerror(ret));
+        return ret;
+    }
+
+    value.type = HASH_VALUE_ULONG;
+    value.ul = res->count;
+    talloc_free(res);
+
+    hret = hash_enter(sctx->counters, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        /* Not fatal, the secrets are just counted again next time. */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cannot store the number of secrets\n");
+    }
+
+    *_count = value.ul;
+    return EOK;
+}
+
+static void local_db_counter_add(struct sss_sec_ctx *sctx,
+                                 struct ldb_dn *dn,
+                                 int delta)
+{
+    hash_key_t key;
+    hash_value_t value;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(ldb_dn_get_linearized(dn));
+    if (key.str == NULL) {
+        talloc_zfree(sctx->counters);
+        return;
+    }
+
+    if (hash_lookup(sctx->counters, &key, &value) != HASH_SUCCESS) {
+        /* Not counted yet */
+        return;
+    }
+
+    if (delta < 0 && value.ul < (unsigned long) -delta) {
+        talloc_zfree(sctx->counters);
+        return;
+    }
+    value.ul += delta;
+
+    if (hash_enter(sctx->counters, &key, &value) != HASH_SUCCESS) {
+        talloc_zfree(sctx->counters);
+    }
+}
+
+/* Must be called after every successful write to the database, delta is
+ * the change of the number of secrets under the request DN. */
+static void local_db_counters_update(struct sss_sec_req *req, int delta)
+{
+    struct sss_sec_ctx *sctx = req->sctx;
+    struct ldb_dn *dn;
+    uint64_t seqnum;
+    int ret;
+
+    if (sctx->counters == NULL) {
+        return;
+    }
+
+    /* Every write increases the sequence number by one, anything else
+     * means that someone else wrote to the database in the meantime. */
+    ret = ldb_sequence_number(sctx->ldb, LDB_SEQ_HIGHEST_SEQ, &seqnum);
+    if (ret != LDB_SUCCESS || seqnum != sctx->counters_seqnum + 1) {
+        talloc_zfree(sctx->counters);
+        return;
+    }
+    sctx->counters_seqnum = seqnum;
+
+    if (delta == 0) {
+        return;
+    }
+
+    dn = ldb_dn_new(req, sctx->ldb, req->basedn);
+    if (dn == NULL) {
+        talloc_zfree(sctx->counters);
+        return;
+    }
+    local_db_counter_add(sctx, dn, delta);
+    talloc_free(dn);
+
+    if (sctx->counters == NULL) {
+        return;
+    }
+
+    dn = per_uid_container(req, req->req_dn);
+    if (dn == NULL) {
+        talloc_zfree(sctx->counters);
+        return;
+    }
+    local_db_counter_add(sctx, dn, delta);
+    talloc_free(dn);
+}
+
 static int local_db_check_number_of_secrets(TALLOC_CTX *mem_ctx,
                                             struct sss_sec_req *req)
 {
     TALLOC_CTX *tmp_ctx;
-    static const char *attrs[] = { NULL };
-    struct ldb_result *res = NULL;
     struct ldb_dn *dn;
+    unsigned long count;
     int ret;
 
     if (req->quota->max_secrets == 0) {
@@ -224,15 +412,12 @@ static int local_db_check_number_of_secrets(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, dn, LDB_SCOPE_SUBTREE,
-                     attrs, LOCAL_SIMPLE_FILTER);
+    ret = local_db_count_secrets(tmp_ctx, req->sctx, dn, &count);
     if (ret != EOK) {
-        DEBUG(SSSDBG_TRACE_LIBS,
-              "ldb_search returned %d: %s\n", ret, ldb_strerror(ret));
         goto done;
     }
 
-    if (res->count >= req->quota->max_secrets) {
+    if (count >= req->quota->max_secrets) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot store any more secrets as the maximum allowed limit (%d) "
               "has been reached\n", req->quota->max_secrets);
@@ -247,47 +432,12 @@ done:
     return ret;
 }
 
-static struct ldb_dn *per_uid_container(TALLOC_CTX *mem_ctx,
-                                        struct ldb_dn *req_dn)
-{
-    int user_comp;
-    int num_comp;
-    struct ldb_dn *uid_base_dn;
-
-    uid_base_dn = ldb_dn_copy(mem_ctx, req_dn);
-    if (uid_base_dn == NULL) {
-        return NULL;
-    }
-
-    /* Remove all the components up to the per-user base path which consists
-     * of three components:
-     *  cn=<uidnumber>,cn=users,cn=secrets
-     */
-    user_comp = ldb_dn_get_comp_num(uid_base_dn) - 3;
-
-    if (!ldb_dn_remove_child_components(uid_base_dn, user_comp)) {
-        DEBUG(SSSDBG_OP_FAILURE, "Cannot remove child components\n");
-        talloc_free(uid_base_dn);
-        return NULL;
-    }
-
-    num_comp = ldb_dn_get_comp_num(uid_base_dn);
-    if (num_comp != 3) {
-        DEBUG(SSSDBG_OP_FAILURE, "Expected 3 components got %d\n", num_comp);
-        talloc_free(uid_base_dn);
-        return NULL;
-    }
-
-    return uid_base_dn;
-}
-
 static int local_db_check_peruid_number_of_secrets(TALLOC_CTX *mem_ctx,
                                                    struct sss_sec_req *req)
 {
     TALLOC_CTX *tmp_ctx;
-    static const char *attrs[] = { NULL };
-    struct ldb_result *res = NULL;
     struct ldb_dn *cli_basedn = NULL;
+    unsigned long count;
     int ret;
 
     if (req->quota->max_uid_secrets == 0) {
@@ -305,15 +455,12 @@ static int local_db_check_peruid_number_of_secrets(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, cli_basedn, LDB_SCOPE_SUBTREE,
-                     attrs, LOCAL_SIMPLE_FILTER);
+    ret = local_db_count_secrets(tmp_ctx, req->sctx, cli_basedn, &count);
     if (ret != EOK) {
-        DEBUG(SSSDBG_TRACE_LIBS,
-              "ldb_search returned %d: %s\n", ret, ldb_strerror(ret));
         goto done;
     }
 
-    if (res->count >= req->quota->max_uid_secrets) {
+    if (count >= req->quota->max_uid_secrets) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Cannot store any more secrets for this client (basedn %s) "
               "as the maximum allowed limit (%d) has been reached\n",
@@ -378,6 +525,51 @@ static int local_db_check_containers_nest_level(struct sss_sec_req *req,
     return EOK;
 }
 
+/* The quota checks, the write and the update of the secret counters are
+ * done in one transaction, so that no other writer can change the number
+ * of secrets in between. */
+static int local_db_transaction_start(struct sss_sec_ctx *sctx)
+{
+    int ret;
+
+    ret = ldb_transaction_start(sctx->ldb);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot start a transaction [%d]: %s\n",
+              ret, ldb_strerror(ret));
+        return sss_ldb_error_to_errno(ret);
+    }
+
+    return EOK;
+}
+
+static int local_db_transaction_done(struct sss_sec_ctx *sctx, int ret)
+{
+    int lret;
+
+    if (ret != EOK) {
+        lret = ldb_transaction_cancel(sctx->ldb);
+        if (lret != LDB_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Cannot cancel the transaction [%d]: %s\n",
+                  lret, ldb_strerror(lret));
+        }
+        return ret;
+    }
+
+    lret = ldb_transaction_commit(sctx->ldb);
+    if (lret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot commit the transaction [%d]: %s\n",
+              lret, ldb_strerror(lret));
+        /* The counters already account for the write */
+        talloc_zfree(sctx->counters);
+        return sss_ldb_error_to_errno(lret);
+    }
+
+    return EOK;
+}
+
 static int local_db_create(struct sss_sec_req *req)
 {
     struct ldb_message *msg;
@@ -401,6 +593,8 @@ static int local_db_create(struct sss_sec_req *req)
         goto done;
     }
 
+    local_db_counters_check(req->sctx);
+
     ret = local_db_check_containers_nest_level(req, msg->dn);
     if (ret != EOK) goto done;
 
@@ -434,6 +628,7 @@ static int local_db_create(struct sss_sec_req *req)
         goto done;
     }
 
+    local_db_counters_update(req, 0);
     ret = EOK;
 
 done:
@@ -1018,8 +1213,8 @@ done:
     return ret;
 }
 
-errno_t sss_sec_put(struct sss_sec_req *req,
-                    const char *secret)
+static int local_db_put(struct sss_sec_req *req,
+                        const char *secret)
 {
     struct ldb_message *msg;
     const char *enctype = "masterkey";
@@ -1048,6 +1243,8 @@ errno_t sss_sec_put(struct sss_sec_req *req,
         goto done;
     }
 
+    local_db_counters_check(req->sctx);
+
     ret = local_db_check_number_of_secrets(msg, req);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
@@ -1125,14 +1322,33 @@ errno_t sss_sec_put(struct sss_sec_req *req,
         goto done;
     }
 
+    local_db_counters_update(req, 1);
     ret = EOK;
 done:
     talloc_free(msg);
     return ret;
 }
 
-errno_t sss_sec_update(struct sss_sec_req *req,
-                       const char *secret)
+errno_t sss_sec_put(struct sss_sec_req *req,
+                    const char *secret)
+{
+    int ret;
+
+    if (req == NULL || secret == NULL) {
+        return EINVAL;
+    }
+
+    ret = local_db_transaction_start(req->sctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = local_db_put(req, secret);
+    return local_db_transaction_done(req->sctx, ret);
+}
+
+static int local_db_update(struct sss_sec_req *req,
+                           const char *secret)
 {
     struct ldb_message *msg;
     const char *enctype = "masterkey";
@@ -1161,6 +1377,8 @@ errno_t sss_sec_update(struct sss_sec_req *req,
         goto done;
     }
 
+    local_db_counters_check(req->sctx);
+
     ret = local_db_check_number_of_secrets(msg, req);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
@@ -1222,17 +1440,37 @@ errno_t sss_sec_update(struct sss_sec_req *req,
         goto done;
     }
 
+    local_db_counters_update(req, 0);
     ret = EOK;
 done:
     talloc_free(msg);
     return ret;
 }
 
-errno_t sss_sec_delete(struct sss_sec_req *req)
+errno_t sss_sec_update(struct sss_sec_req *req,
+                       const char *secret)
+{
+    int ret;
+
+    if (req == NULL || secret == NULL) {
+        return EINVAL;
+    }
+
+    ret = local_db_transaction_start(req->sctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = local_db_update(req, secret);
+    return local_db_transaction_done(req->sctx, ret);
+}
+
+static int local_db_delete(struct sss_sec_req *req)
 {
     TALLOC_CTX *tmp_ctx;
     static const char *attrs[] = { NULL };
     struct ldb_result *res;
+    bool is_container;
     int ret;
 
     if (req == NULL) {
@@ -1244,6 +1482,8 @@ errno_t sss_sec_delete(struct sss_sec_req *req)
     tmp_ctx = talloc_new(req);
     if (!tmp_ctx) return ENOMEM;
 
+    local_db_counters_check(req->sctx);
+
     DEBUG(SSSDBG_TRACE_INTERNAL,
           "Searching for [%s] at [%s] with scope=base\n",
           LOCAL_CONTAINER_FILTER, ldb_dn_get_linearized(req->req_dn));
@@ -1256,7 +1496,8 @@ errno_t sss_sec_delete(struct sss_sec_req *req)
         goto done;
     }
 
-    if (res->count == 1) {
+    is_container = (res->count == 1);
+    if (is_container) {
         DEBUG(SSSDBG_TRACE_INTERNAL,
               "Searching for children of [%s]\n", ldb_dn_get_linearized(req->req_dn));
         ret = ldb_search(req->sctx->ldb, tmp_ctx, &res, req->req_dn, LDB_SCOPE_ONELEVEL,
@@ -1289,6 +1530,11 @@ errno_t sss_sec_delete(struct sss_sec_req *req)
               "LDB returned unexpected error: [%s]\n",
                ldb_strerror(ret));
     }
+
+    if (ret == LDB_SUCCESS) {
+        /* Anything that is not a container is a secret */
+        local_db_counters_update(req, is_container ? 0 : -1);
+    }
     ret = sss_ldb_error_to_errno (ret);
 
 done:
@@ -1296,9 +1542,27 @@ done:
     return ret;
 }
 
+errno_t sss_sec_delete(struct sss_sec_req *req)
+{
+    int ret;
+
+    if (req == NULL) {
+        return EINVAL;
+    }
+
+    ret = local_db_transaction_start(req->sctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = local_db_delete(req);
+    return local_db_transaction_done(req->sctx, ret);
+}
+
 errno_t sss_sec_create_container(struct sss_sec_req *req)
 {
     int plen;
+    int ret;
 
     if (req == NULL) {
         return EINVAL;
@@ -1311,7 +1575,14 @@ errno_t sss_sec_create_container(struct sss_sec_req *req)
     }
 
     req->path[plen - 1] = '\0';
-    return local_db_create(req);
+
+    ret = local_db_transaction_start(req->sctx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = local_db_create(req);
+    return local_db_transaction_done(req->sctx, ret);
 }
 
 bool sss_sec_req_is_list(struct sss_sec_req *req)
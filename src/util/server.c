@@ -33,6 +33,8 @@
 #include <ldb.h>
 #include "util/util.h"
 #include "confdb/confdb.h"
+#include "util/sss_trace.h"
+#include "util/sss_loop_stats.h"
 
 #ifdef HAVE_PRCTL
 #include <sys/prctl.h>
@@ -455,6 +457,10 @@ int server_setup(const char *name, int flags,
     int ret = EOK;
     bool dt;
     bool dl = false;
+    bool da = false;
+    bool dtr = false;
+    bool del = false;
+    char *trace_path;
     bool dm;
     struct tevent_signal *tes;
     struct logrotate_ctx *lctx;
@@ -584,6 +590,13 @@ int server_setup(const char *name, int flags,
         return ret;
     }
 
+    /* Each daemon reads dozens of options per domain, read them all at once */
+    ret = confdb_enable_snapshot(ctx->confdb_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Configuration snapshot is not used, "
+              "options are read one by one\n");
+    }
+
     if (debug_level == SSSDBG_UNRESOLVED) {
         /* set debug level if any in conf_entry */
         ret = confdb_get_int(ctx->confdb_ctx, conf_entry,
@@ -656,6 +669,65 @@ int server_setup(const char *name, int flags,
         sss_set_logger(sss_logger_str[FILES_LOGGER]);
     }
 
+    ret = confdb_get_bool(ctx->confdb_ctx, conf_entry,
+                          CONFDB_SERVICE_DEBUG_ASYNC,
+                          false, &da);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading from confdb (%d) [%s]\n",
+                                     ret, strerror(ret));
+        return ret;
+    }
+
+    ret = confdb_get_bool(ctx->confdb_ctx, conf_entry,
+                          CONFDB_SERVICE_DEBUG_BACKTRACE_ENABLED,
+                          true, &debug_backtrace_enabled);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading from confdb (%d) [%s]\n",
+                                     ret, strerror(ret));
+        return ret;
+    }
+
+    ret = confdb_get_bool(ctx->confdb_ctx, conf_entry,
+                          CONFDB_SERVICE_DEBUG_TRACE,
+                          false, &dtr);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading from confdb (%d) [%s]\n",
+                                     ret, strerror(ret));
+        return ret;
+    }
+
+    if (dtr) {
+        trace_path = talloc_asprintf(ctx, "%s/%s.trace",
+                                     LOG_PATH, debug_log_file);
+        if (trace_path == NULL) {
+            return ENOMEM;
+        }
+
+        ret = sss_trace_init(trace_path);
+        talloc_free(trace_path);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cannot write request traces (%d) "
+                  "[%s]\n", ret, strerror(ret));
+        }
+    }
+
+    ret = confdb_get_bool(ctx->confdb_ctx, conf_entry,
+                          CONFDB_SERVICE_DEBUG_EVENT_LOOP,
+                          false, &del);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading from confdb (%d) [%s]\n",
+                                     ret, strerror(ret));
+        return ret;
+    }
+
+    if (del) {
+        ret = sss_loop_stats_init(ctx->event_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cannot collect event loop "
+                  "statistics (%d) [%s]\n", ret, strerror(ret));
+        }
+    }
+
     /* before opening the log file set up log rotation */
     lctx = talloc_zero(ctx, struct logrotate_ctx);
     if (!lctx) return ENOMEM;
@@ -677,6 +749,15 @@ int server_setup(const char *name, int flags,
                                          "[%s]\n", ret, strerror(ret));
             return ret;
         }
+
+        if (da) {
+            ret = debug_start_async_writer();
+            if (ret != EOK) {
+                DEBUG(SSSDBG_MINOR_FAILURE, "Cannot start the debug writer "
+                      "thread, writing debug messages directly (%d) [%s]\n",
+                      ret, strerror(ret));
+            }
+        }
     }
 
     /* Setup the internal watchdog */
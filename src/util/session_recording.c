@@ -23,13 +23,80 @@
 */
 
 #include "util/session_recording.h"
-#include "util/debug.h"
+#include "util/util.h"
 #include <string.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+static errno_t session_recording_build_set(TALLOC_CTX *mem_ctx,
+                                          char **list,
+                                          hash_table_t **_set)
+{
+    hash_table_t *set;
+    hash_key_t key;
+    hash_value_t value;
+    size_t count;
+    int hret;
+    errno_t ret;
+
+    if (list == NULL || list[0] == NULL) {
+        *_set = NULL;
+        return EOK;
+    }
+
+    for (count = 0; list[count] != NULL; count++);
+
+    ret = sss_hash_create(mem_ctx, count, &set);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    key.type = HASH_KEY_STRING;
+    value.type = HASH_VALUE_UNDEF;
+    for (; *list != NULL; list++) {
+        key.str = *list;
+        hret = hash_enter(set, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed adding \"%s\" to the session recording set: %s\n",
+                  *list, hash_error_string(hret));
+            talloc_free(set);
+            return ENOMEM;
+        }
+    }
+
+    *_set = set;
+    return EOK;
+}
+
+static bool session_recording_set_has(hash_table_t *set, const char *name)
+{
+    hash_key_t key;
+
+    if (set == NULL || name == NULL) {
+        return false;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const_p(char, name);
+
+    return hash_has_key(set, &key);
+}
+
+bool session_recording_conf_has_user(const struct session_recording_conf *conf,
+                                     const char *name)
+{
+    return session_recording_set_has(conf->user_set, name);
+}
+
+bool session_recording_conf_has_group(const struct session_recording_conf *conf,
+                                      const char *name)
+{
+    return session_recording_set_has(conf->group_set, name);
+}
+
 errno_t session_recording_conf_load(TALLOC_CTX *mem_ctx,
                                     struct confdb_ctx *cdb,
                                     struct session_recording_conf *pconf)
@@ -107,6 +174,15 @@ errno_t session_recording_conf_load(TALLOC_CTX *mem_ctx,
                                     &pconf->groups);
     if (ret != EOK && ret != ENOENT) goto done;
 
+    /* Compile the lists into sets, so that lookups don't scan them */
+    ret = session_recording_build_set(mem_ctx, pconf->users,
+                                      &pconf->user_set);
+    if (ret != EOK) goto done;
+
+    ret = session_recording_build_set(mem_ctx, pconf->groups,
+                                      &pconf->group_set);
+    if (ret != EOK) goto done;
+
     ret = EOK;
 done:
     return ret;
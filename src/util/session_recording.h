@@ -25,6 +25,8 @@
 #ifndef __SESSION_RECORDING_H__
 #define __SESSION_RECORDING_H__
 
+#include <stdbool.h>
+#include <dhash.h>
 #include "confdb/confdb.h"
 #include "util/util_errors.h"
 
@@ -53,6 +55,16 @@ struct session_recording_conf {
      * scope is "some"
      */
     char                          **groups;
+    /**
+     * Hash set of the names in "users", built when the configuration is
+     * loaded. NULL if the list is empty.
+     */
+    hash_table_t                   *user_set;
+    /**
+     * Hash set of the names in "groups", built when the configuration is
+     * loaded. NULL if the list is empty.
+     */
+    hash_table_t                   *group_set;
 };
 
 /**
@@ -73,4 +85,28 @@ extern errno_t session_recording_conf_load(
                                     struct confdb_ctx *cdb,
                                     struct session_recording_conf *pconf);
 
+/**
+ * Check if a user is listed in the session recording configuration.
+ *
+ * @param conf  The loaded session recording configuration.
+ * @param name  The output (formatted) name of the user.
+ *
+ * @return True if the user is listed, false otherwise.
+ */
+extern bool session_recording_conf_has_user(
+                                    const struct session_recording_conf *conf,
+                                    const char *name);
+
+/**
+ * Check if a group is listed in the session recording configuration.
+ *
+ * @param conf  The loaded session recording configuration.
+ * @param name  The output (formatted) name of the group.
+ *
+ * @return True if the group is listed, false otherwise.
+ */
+extern bool session_recording_conf_has_group(
+                                    const struct session_recording_conf *conf,
+                                    const char *name);
+
 #endif /* __SESSION_RECORDING_H__ */
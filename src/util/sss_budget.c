@@ -0,0 +1,142 @@
+/*
+    SSSD
+
+    Time budget of long running loops in the event loop
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <time.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+#include "util/sss_budget.h"
+
+/* Immediate events and timers which are already due are run by tevent
+ * without polling the file descriptors, so the loop waits a little to let
+ * the pending requests in. */
+#define SSS_BUDGET_YIELD_USEC 1000
+
+struct sss_budget {
+    const char *task;
+    uint64_t budget_usec;
+    uint64_t slice_start;
+};
+
+static uint64_t sss_budget_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sss_budget_end_slice(struct sss_budget *budget)
+{
+    watchdog_report_stall(budget->task,
+                          sss_budget_now() - budget->slice_start);
+}
+
+static int sss_budget_destructor(struct sss_budget *budget)
+{
+    sss_budget_end_slice(budget);
+    return 0;
+}
+
+struct sss_budget *
+sss_budget_create(TALLOC_CTX *mem_ctx, const char *task, unsigned int msec)
+{
+    struct sss_budget *budget;
+
+    budget = talloc_zero(mem_ctx, struct sss_budget);
+    if (budget == NULL) {
+        return NULL;
+    }
+
+    budget->task = task;
+    budget->budget_usec = (uint64_t)msec * 1000;
+    budget->slice_start = sss_budget_now();
+
+    talloc_set_destructor(budget, sss_budget_destructor);
+
+    return budget;
+}
+
+bool sss_budget_exhausted(struct sss_budget *budget)
+{
+    return sss_budget_now() - budget->slice_start >= budget->budget_usec;
+}
+
+struct sss_budget_yield_state {
+    struct sss_budget *budget;
+};
+
+static void sss_budget_yield_done(struct tevent_context *ev,
+                                  struct tevent_timer *te,
+                                  struct timeval tv,
+                                  void *pvt);
+
+struct tevent_req *
+sss_budget_yield_send(TALLOC_CTX *mem_ctx,
+                      struct tevent_context *ev,
+                      struct sss_budget *budget)
+{
+    struct sss_budget_yield_state *state;
+    struct tevent_timer *te;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct sss_budget_yield_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->budget = budget;
+    sss_budget_end_slice(budget);
+
+    te = tevent_add_timer(ev, state,
+                          tevent_timeval_current_ofs(0, SSS_BUDGET_YIELD_USEC),
+                          sss_budget_yield_done, req);
+    if (te == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_add_timer() failed\n");
+        tevent_req_error(req, ENOMEM);
+        tevent_req_post(req, ev);
+        return req;
+    }
+
+    return req;
+}
+
+static void sss_budget_yield_done(struct tevent_context *ev,
+                                  struct tevent_timer *te,
+                                  struct timeval tv,
+                                  void *pvt)
+{
+    struct sss_budget_yield_state *state;
+    struct tevent_req *req;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct sss_budget_yield_state);
+
+    state->budget->slice_start = sss_budget_now();
+    tevent_req_done(req);
+}
+
+errno_t sss_budget_yield_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
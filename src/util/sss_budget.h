@@ -0,0 +1,65 @@
+/*
+    SSSD
+
+    Time budget of long running loops in the event loop
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_BUDGET_H_
+#define _SSS_BUDGET_H_
+
+#include <stdbool.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util_errors.h"
+
+/* How long a background loop may block the event loop by default. */
+#define SSS_BUDGET_DEFAULT_MSEC 50
+
+struct sss_budget;
+
+/**
+ * Create a new budget of @msec milliseconds for the task @task, which must
+ * be a string constant. The first time slice starts now.
+ *
+ * Every time slice is reported to the watchdog as a stall of the event
+ * loop caused by @task, the last one when the budget is freed. A budget
+ * can thus also be used only to measure a synchronous operation.
+ *
+ * Returns NULL if memory cannot be allocated.
+ */
+struct sss_budget *
+sss_budget_create(TALLOC_CTX *mem_ctx, const char *task, unsigned int msec);
+
+/**
+ * True if the current time slice of @budget is used up and the loop
+ * should yield with sss_budget_yield_send() before it continues.
+ */
+bool sss_budget_exhausted(struct sss_budget *budget);
+
+/**
+ * Yield to the event loop. The request finishes after pending file
+ * descriptor events, e.g. new requests of the responders, were handled
+ * and a new time slice of @budget starts.
+ */
+struct tevent_req *
+sss_budget_yield_send(TALLOC_CTX *mem_ctx,
+                      struct tevent_context *ev,
+                      struct sss_budget *budget);
+
+errno_t sss_budget_yield_recv(struct tevent_req *req);
+
+#endif /* _SSS_BUDGET_H_ */
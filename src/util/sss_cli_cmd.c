@@ -178,6 +178,8 @@ const char *sss_cmd2str(enum sss_cli_command cmd)
         return "SSS_SUDO_GET_SUDORULES";
     case SSS_SUDO_GET_DEFAULTS:
         return "SSS_SUDO_GET_DEFAULTS";
+    case SSS_SUDO_GET_SUDORULES_GEN:
+        return "SSS_SUDO_GET_SUDORULES_GEN";
 
     /* autofs */
     case SSS_AUTOFS_SETAUTOMNTENT:
@@ -44,9 +44,11 @@
 # if __BYTE_ORDER == __LITTLE_ENDIAN
 #  define le32toh(x) (x)
 #  define htole32(x) (x)
+#  define le64toh(x) (x)
 # else
 #  define le32toh(x) __bswap_32 (x)
 #  define htole32(x) __bswap_32 (x)
+#  define le64toh(x) __bswap_64 (x)
 # endif
 #endif /* __USE_BSD */
 
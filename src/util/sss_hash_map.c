@@ -0,0 +1,439 @@
+/*
+    SSSD
+
+    Open addressing hash map with string keys
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/sss_hash_map.h"
+
+#define SSS_HASH_MAP_MIN_SIZE 16
+#define SSS_HASH_MAP_BLOCK_SIZE 4096
+
+/* Key of a slot whose entry was deleted, the probe sequence must continue
+ * past such slots. */
+static const char sss_hash_map_deleted;
+#define SSS_HASH_MAP_DELETED (&sss_hash_map_deleted)
+
+struct sss_hash_map_slot {
+    const char *key;
+    void *value;
+    uint32_t hash;
+};
+
+/* Copies of the keys are appended to blocks that are only freed all
+ * together, either with the map or when the keys are compacted. */
+struct sss_hash_map_block {
+    struct sss_hash_map_block *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+/* Linear probing, the table is grown or rebuilt when more than three
+ * quarters of the slots are used or deleted. */
+struct sss_hash_map {
+    struct sss_hash_map_slot *slots;
+    size_t size;
+    size_t count;
+    size_t deleted;
+
+    struct sss_hash_map_block *blocks;
+    /* bytes of keys of current and of deleted entries */
+    size_t key_bytes;
+    size_t dead_bytes;
+};
+
+static uint32_t sss_hash_map_hash(const char *key, size_t *_len)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    const char *c;
+
+    for (c = key; *c != '\0'; c++) {
+        hash ^= (uint8_t)*c;
+        hash *= 16777619U;
+    }
+
+    *_len = c - key;
+
+    return hash;
+}
+
+static bool sss_hash_map_used(struct sss_hash_map_slot *slot)
+{
+    return slot->key != NULL && slot->key != SSS_HASH_MAP_DELETED;
+}
+
+/* Return the slot of @key or, if it is not present, the slot where it
+ * should be inserted. */
+static struct sss_hash_map_slot *
+sss_hash_map_find(struct sss_hash_map *map,
+                  const char *key,
+                  uint32_t hash,
+                  bool *_found)
+{
+    struct sss_hash_map_slot *slot;
+    struct sss_hash_map_slot *free_slot = NULL;
+    size_t mask = map->size - 1;
+    size_t i;
+
+    for (i = hash & mask; ; i = (i + 1) & mask) {
+        slot = &map->slots[i];
+
+        if (slot->key == NULL) {
+            *_found = false;
+            return free_slot != NULL ? free_slot : slot;
+        }
+
+        if (slot->key == SSS_HASH_MAP_DELETED) {
+            if (free_slot == NULL) {
+                free_slot = slot;
+            }
+            continue;
+        }
+
+        if (slot->hash == hash && strcmp(slot->key, key) == 0) {
+            *_found = true;
+            return slot;
+        }
+    }
+}
+
+static struct sss_hash_map_block *
+sss_hash_map_block_new(struct sss_hash_map *map, size_t size)
+{
+    struct sss_hash_map_block *block;
+
+    size = MAX(size, SSS_HASH_MAP_BLOCK_SIZE);
+
+    block = talloc_size(map, offsetof(struct sss_hash_map_block, data) + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    talloc_set_name_const(block, "struct sss_hash_map_block");
+
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+
+    return block;
+}
+
+static void
+sss_hash_map_blocks_free(struct sss_hash_map_block *blocks)
+{
+    struct sss_hash_map_block *next;
+
+    for (; blocks != NULL; blocks = next) {
+        next = blocks->next;
+        talloc_free(blocks);
+    }
+}
+
+static const char *
+sss_hash_map_copy_key(struct sss_hash_map *map,
+                      const char *key,
+                      size_t len)
+{
+    struct sss_hash_map_block *block;
+    char *copy;
+
+    block = map->blocks;
+    if (block == NULL || block->size - block->used < len + 1) {
+        block = sss_hash_map_block_new(map, len + 1);
+        if (block == NULL) {
+            return NULL;
+        }
+
+        block->next = map->blocks;
+        map->blocks = block;
+    }
+
+    copy = block->data + block->used;
+    memcpy(copy, key, len + 1);
+    block->used += len + 1;
+    map->key_bytes += len + 1;
+
+    return copy;
+}
+
+static errno_t
+sss_hash_map_rehash(struct sss_hash_map *map, size_t size)
+{
+    struct sss_hash_map_slot *slots;
+    struct sss_hash_map_slot *slot;
+    struct sss_hash_map_block *block = NULL;
+    size_t mask = size - 1;
+    size_t len;
+    size_t i;
+    size_t j;
+
+    slots = talloc_zero_array(map, struct sss_hash_map_slot, size);
+    if (slots == NULL) {
+        return ENOMEM;
+    }
+
+    /* Copy the keys into a single new block once more than half of the
+     * stored bytes belong to deleted entries. */
+    if (map->dead_bytes > map->key_bytes) {
+        block = sss_hash_map_block_new(map, map->key_bytes);
+        if (block == NULL) {
+            talloc_free(slots);
+            return ENOMEM;
+        }
+    }
+
+    for (i = 0; i < map->size; i++) {
+        slot = &map->slots[i];
+        if (!sss_hash_map_used(slot)) {
+            continue;
+        }
+
+        for (j = slot->hash & mask; slots[j].key != NULL; j = (j + 1) & mask);
+        slots[j] = *slot;
+
+        if (block != NULL) {
+            len = strlen(slot->key) + 1;
+            memcpy(block->data + block->used, slot->key, len);
+            slots[j].key = block->data + block->used;
+            block->used += len;
+        }
+    }
+
+    if (block != NULL) {
+        sss_hash_map_blocks_free(map->blocks);
+        map->blocks = block;
+        map->dead_bytes = 0;
+    }
+
+    talloc_free(map->slots);
+    map->slots = slots;
+    map->size = size;
+    map->deleted = 0;
+
+    return EOK;
+}
+
+struct sss_hash_map *
+sss_hash_map_create(TALLOC_CTX *mem_ctx, size_t size_hint)
+{
+    struct sss_hash_map *map;
+    size_t size = SSS_HASH_MAP_MIN_SIZE;
+
+    /* keep the map at most half full for the expected number of entries */
+    while (size < size_hint * 2) {
+        size *= 2;
+    }
+
+    map = talloc_zero(mem_ctx, struct sss_hash_map);
+    if (map == NULL) {
+        return NULL;
+    }
+
+    map->slots = talloc_zero_array(map, struct sss_hash_map_slot, size);
+    if (map->slots == NULL) {
+        talloc_free(map);
+        return NULL;
+    }
+    map->size = size;
+
+    return map;
+}
+
+errno_t
+_sss_hash_map_add(struct sss_hash_map *map,
+                  const char *key,
+                  void *value,
+                  bool override)
+{
+    struct sss_hash_map_slot *slot;
+    const char *copy;
+    uint32_t hash;
+    size_t size;
+    size_t len;
+    bool found;
+    errno_t ret;
+
+    if (map == NULL || key == NULL || value == NULL) {
+        return EINVAL;
+    }
+
+    hash = sss_hash_map_hash(key, &len);
+
+    slot = sss_hash_map_find(map, key, hash, &found);
+    if (found) {
+        if (!override) {
+            return EEXIST;
+        }
+
+        slot->value = value;
+        return EOK;
+    }
+
+    if ((map->count + map->deleted + 1) * 4 > map->size * 3) {
+        /* Only grow if the entries need it, otherwise just drop
+         * the deleted slots. */
+        size = map->size;
+        while ((map->count + 1) * 2 > size) {
+            size *= 2;
+        }
+
+        ret = sss_hash_map_rehash(map, size);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        slot = sss_hash_map_find(map, key, hash, &found);
+    }
+
+    copy = sss_hash_map_copy_key(map, key, len);
+    if (copy == NULL) {
+        return ENOMEM;
+    }
+
+    if (slot->key == SSS_HASH_MAP_DELETED) {
+        map->deleted--;
+    }
+
+    slot->key = copy;
+    slot->value = value;
+    slot->hash = hash;
+    map->count++;
+
+    return EOK;
+}
+
+void *
+_sss_hash_map_lookup(struct sss_hash_map *map,
+                     const char *key)
+{
+    struct sss_hash_map_slot *slot;
+    uint32_t hash;
+    size_t len;
+    bool found;
+
+    if (map == NULL || key == NULL) {
+        return NULL;
+    }
+
+    hash = sss_hash_map_hash(key, &len);
+    slot = sss_hash_map_find(map, key, hash, &found);
+
+    return found ? slot->value : NULL;
+}
+
+bool
+sss_hash_map_has_key(struct sss_hash_map *map,
+                     const char *key)
+{
+    return _sss_hash_map_lookup(map, key) != NULL;
+}
+
+void *
+_sss_hash_map_delete(struct sss_hash_map *map,
+                     const char *key)
+{
+    struct sss_hash_map_slot *slot;
+    void *value;
+    uint32_t hash;
+    size_t len;
+    bool found;
+
+    if (map == NULL || key == NULL) {
+        return NULL;
+    }
+
+    hash = sss_hash_map_hash(key, &len);
+    slot = sss_hash_map_find(map, key, hash, &found);
+    if (!found) {
+        return NULL;
+    }
+
+    value = slot->value;
+
+    slot->key = SSS_HASH_MAP_DELETED;
+    slot->value = NULL;
+    map->count--;
+    map->deleted++;
+    map->key_bytes -= len + 1;
+    map->dead_bytes += len + 1;
+
+    return value;
+}
+
+bool
+_sss_hash_map_next(struct sss_hash_map *map,
+                   size_t *_iter,
+                   const char **_key,
+                   void **_value)
+{
+    struct sss_hash_map_slot *slot;
+    size_t i;
+
+    if (map == NULL || _iter == NULL) {
+        return false;
+    }
+
+    for (i = *_iter; i < map->size; i++) {
+        slot = &map->slots[i];
+        if (!sss_hash_map_used(slot)) {
+            continue;
+        }
+
+        if (_key != NULL) {
+            *_key = slot->key;
+        }
+
+        if (_value != NULL) {
+            *_value = slot->value;
+        }
+
+        *_iter = i + 1;
+        return true;
+    }
+
+    *_iter = map->size;
+    return false;
+}
+
+size_t
+sss_hash_map_count(struct sss_hash_map *map)
+{
+    return map == NULL ? 0 : map->count;
+}
+
+void
+sss_hash_map_clear(struct sss_hash_map *map)
+{
+    if (map == NULL) {
+        return;
+    }
+
+    memset(map->slots, 0, sizeof(struct sss_hash_map_slot) * map->size);
+    sss_hash_map_blocks_free(map->blocks);
+
+    map->blocks = NULL;
+    map->count = 0;
+    map->deleted = 0;
+    map->key_bytes = 0;
+    map->dead_bytes = 0;
+}
@@ -0,0 +1,161 @@
+/*
+    SSSD
+
+    Open addressing hash map with string keys
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_HASH_MAP_H_
+#define _SSS_HASH_MAP_H_
+
+#include <stdbool.h>
+#include <talloc.h>
+
+#include "util/util.h"
+
+/**
+ * Hash map from string keys to plain pointers for tables that are built
+ * and searched a lot, e.g. tables that live for a single request.
+ *
+ * Compared to sss_ptr_hash and dhash there is no allocation per entry:
+ * the entries are stored in one array of slots and the copies of the keys
+ * are stored in larger blocks that are freed together with the map.
+ * Values are not owned by the map and are not removed when they are
+ * freed, use sss_ptr_hash if that is needed.
+ *
+ * The map must not be modified while it is iterated, except that
+ * the current entry may be deleted.
+ */
+struct sss_hash_map;
+
+/**
+ * Create a new map. @size_hint is the expected number of entries, 0 can
+ * be used if it is not known.
+ */
+struct sss_hash_map *
+sss_hash_map_create(TALLOC_CTX *mem_ctx, size_t size_hint);
+
+/**
+ * Add @value under @key, the key is copied. @value must not be NULL.
+ *
+ * @return EOK If the value was added.
+ * @return EEXIST If @key already exists and @override is false.
+ * @return Other errno code in case of an error.
+ */
+errno_t
+_sss_hash_map_add(struct sss_hash_map *map,
+                  const char *key,
+                  void *value,
+                  bool override);
+
+/**
+ * @return The value stored under @key or NULL if there is none.
+ */
+void *
+_sss_hash_map_lookup(struct sss_hash_map *map,
+                     const char *key);
+
+/**
+ * Remove @key from the map.
+ *
+ * @return The removed value or NULL if @key was not found.
+ */
+void *
+_sss_hash_map_delete(struct sss_hash_map *map,
+                     const char *key);
+
+/**
+ * Iterate over all entries. @_iter must be set to zero before the first
+ * call. Keys are valid until the entry is deleted.
+ *
+ * @return true If @_key and @_value were set to the next entry.
+ * @return false If there are no more entries.
+ */
+bool
+_sss_hash_map_next(struct sss_hash_map *map,
+                   size_t *_iter,
+                   const char **_key,
+                   void **_value);
+
+/**
+ * @return true If @key is present in the map.
+ */
+bool
+sss_hash_map_has_key(struct sss_hash_map *map,
+                     const char *key);
+
+/**
+ * @return The number of entries in the map.
+ */
+size_t
+sss_hash_map_count(struct sss_hash_map *map);
+
+/**
+ * Remove all entries, the values are left intact.
+ */
+void
+sss_hash_map_clear(struct sss_hash_map *map);
+
+/**
+ * Define type safe wrappers prefix_add(), prefix_override(),
+ * prefix_lookup(), prefix_delete() and prefix_next() for maps whose
+ * values are of @type, e.g.:
+ *
+ *     SSS_HASH_MAP_TYPED(attrs_map, struct sysdb_attrs)
+ *
+ *     ret = attrs_map_add(map, dn, attrs);
+ *     attrs = attrs_map_lookup(map, dn);
+ */
+#define SSS_HASH_MAP_TYPED(prefix, type)                                     \
+static inline errno_t                                                        \
+prefix##_add(struct sss_hash_map *map, const char *key, type *value)         \
+{                                                                            \
+    return _sss_hash_map_add(map, key, value, false);                        \
+}                                                                            \
+                                                                             \
+static inline errno_t                                                        \
+prefix##_override(struct sss_hash_map *map, const char *key, type *value)    \
+{                                                                            \
+    return _sss_hash_map_add(map, key, value, true);                         \
+}                                                                            \
+                                                                             \
+static inline type *                                                         \
+prefix##_lookup(struct sss_hash_map *map, const char *key)                   \
+{                                                                            \
+    return (type *)_sss_hash_map_lookup(map, key);                           \
+}                                                                            \
+                                                                             \
+static inline type *                                                         \
+prefix##_delete(struct sss_hash_map *map, const char *key)                   \
+{                                                                            \
+    return (type *)_sss_hash_map_delete(map, key);                           \
+}                                                                            \
+                                                                             \
+static inline bool                                                           \
+prefix##_next(struct sss_hash_map *map, size_t *_iter,                       \
+              const char **_key, type **_value)                              \
+{                                                                            \
+    void *value;                                                             \
+    bool found;                                                              \
+                                                                             \
+    found = _sss_hash_map_next(map, _iter, _key, &value);                    \
+    if (found && _value != NULL) {                                           \
+        *_value = (type *)value;                                             \
+    }                                                                        \
+                                                                             \
+    return found;                                                            \
+}
+
+#endif /* _SSS_HASH_MAP_H_ */
@@ -66,6 +66,29 @@ struct sss_iobuf *sss_iobuf_init_readonly(TALLOC_CTX *mem_ctx,
     return iobuf;
 }
 
+struct sss_iobuf *sss_iobuf_init_steal(TALLOC_CTX *mem_ctx,
+                                       uint8_t *data,
+                                       size_t size)
+{
+    struct sss_iobuf *iobuf;
+
+    if (data == NULL) {
+        return sss_iobuf_init_readonly(mem_ctx, NULL, 0);
+    }
+
+    iobuf = talloc_zero(mem_ctx, struct sss_iobuf);
+    if (iobuf == NULL) {
+        return NULL;
+    }
+
+    iobuf->data = talloc_steal(iobuf, data);
+    iobuf->size = size;
+    iobuf->capacity = size;
+    iobuf->dp = 0;
+
+    return iobuf;
+}
+
 size_t sss_iobuf_get_len(struct sss_iobuf *iobuf)
 {
     if (iobuf == NULL) {
@@ -50,6 +50,22 @@ struct sss_iobuf *sss_iobuf_init_readonly(TALLOC_CTX *mem_ctx,
                                           const uint8_t *data,
                                           size_t size);
 
+/*
+ * @brief Allocate an IO buffer on top of an existing talloc buffer
+ *
+ * Unlike sss_iobuf_init_readonly(), the data is not copied. The iobuf
+ * steals the data buffer and frees it together with itself.
+ *
+ * @param[in]  mem_ctx      The talloc context that owns the iobuf
+ * @param[in]  data         The talloc-allocated data buffer.
+ * @param[in]  size         The size of the data in the buffer
+ *
+ * @return The newly created buffer on success or NULL on an error.
+ */
+struct sss_iobuf *sss_iobuf_init_steal(TALLOC_CTX *mem_ctx,
+                                       uint8_t *data,
+                                       size_t size);
+
 /*
  * @brief Returns the number of bytes currently stored in the iobuf
  *
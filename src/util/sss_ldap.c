@@ -116,8 +116,36 @@ struct sss_ldap_init_state {
     LDAP *ldap;
     int sd;
     const char *uri;
+
+    sss_ldap_tls_connect_cb tls_connect_cb;
+    void *tls_connect_arg;
 };
 
+static void sss_ldap_init_set_tls_connect_cb(struct sss_ldap_init_state *state)
+{
+#if defined(LDAP_OPT_X_TLS_CONNECT_CB) && defined(LDAP_OPT_X_TLS_CONNECT_ARG)
+    int lret;
+
+    if (state->tls_connect_cb == NULL) {
+        return;
+    }
+
+    /* Must be set before the handshake, i.e. before ldap_install_tls() or
+     * ldap_start_tls() are called. */
+    lret = ldap_set_option(state->ldap, LDAP_OPT_X_TLS_CONNECT_CB,
+                           (void *)state->tls_connect_cb);
+    if (lret == LDAP_OPT_SUCCESS) {
+        lret = ldap_set_option(state->ldap, LDAP_OPT_X_TLS_CONNECT_ARG,
+                               state->tls_connect_arg);
+    }
+    if (lret != LDAP_OPT_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to set TLS connect callback: %s\n",
+              sss_ldap_err2string(lret));
+    }
+#endif
+}
+
 static int sss_ldap_init_state_destructor(void *data)
 {
     struct sss_ldap_init_state *state = (struct sss_ldap_init_state *)data;
@@ -142,7 +170,9 @@ struct tevent_req *sss_ldap_init_send(TALLOC_CTX *mem_ctx,
                                       struct tevent_context *ev,
                                       const char *uri,
                                       struct sockaddr_storage *addr,
-                                      int addr_len, int timeout)
+                                      int addr_len, int timeout,
+                                      sss_ldap_tls_connect_cb tls_connect_cb,
+                                      void *tls_connect_arg)
 {
     int ret = EOK;
     struct tevent_req *req;
@@ -159,6 +189,8 @@ struct tevent_req *sss_ldap_init_send(TALLOC_CTX *mem_ctx,
     state->ldap = NULL;
     state->sd = -1;
     state->uri = uri;
+    state->tls_connect_cb = tls_connect_cb;
+    state->tls_connect_arg = tls_connect_arg;
 
 #ifdef HAVE_LDAP_INIT_FD
     struct tevent_req *subreq;
@@ -180,6 +212,7 @@ fail:
               "will use ldap_initialize with uri [%s].\n", uri);
     ret = ldap_initialize(&state->ldap, uri);
     if (ret == LDAP_SUCCESS) {
+        sss_ldap_init_set_tls_connect_cb(state);
         tevent_req_done(req);
     } else {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -260,6 +293,8 @@ static void sss_ldap_init_sys_connect_done(struct tevent_req *subreq)
         goto fail;
     }
 
+    sss_ldap_init_set_tls_connect_cb(state);
+
     if (ldap_is_ldaps_url(state->uri)) {
         lret = ldap_install_tls(state->ldap);
         if (lret != LDAP_SUCCESS) {
@@ -73,11 +73,18 @@ int sss_ldap_control_create(const char *oid, int iscritical,
                             struct berval *value, int dupval,
                             LDAPControl **ctrlp);
 
+/* Called by libldap with the TLS library session handle before the TLS
+ * handshake starts, see LDAP_OPT_X_TLS_CONNECT_CB. */
+typedef int (*sss_ldap_tls_connect_cb)(LDAP *ld, void *ssl, void *ctx,
+                                       void *arg);
+
 struct tevent_req *sss_ldap_init_send(TALLOC_CTX *mem_ctx,
                                       struct tevent_context *ev,
                                       const char *uri,
                                       struct sockaddr_storage *addr,
-                                      int addr_len, int timeout);
+                                      int addr_len, int timeout,
+                                      sss_ldap_tls_connect_cb tls_connect_cb,
+                                      void *tls_connect_arg);
 
 int sss_ldap_init_recv(struct tevent_req *req, LDAP **ldap, int *sd);
 
@@ -0,0 +1,374 @@
+/*
+    SSSD
+
+    Event loop statistics
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <time.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+#include "util/sss_metrics.h"
+#include "util/sss_loop_stats.h"
+
+/* Locations that do not fit are accounted to "other". */
+#define SSS_LOOP_STATS_MAX_LOCATIONS 64
+/* Sections nested deeper are accounted to the enclosing one. */
+#define SSS_LOOP_STATS_MAX_DEPTH 8
+#define SSS_LOOP_STATS_PROBE_INTERVAL 1
+
+#define SSS_LOOP_STATS_OTHER "other"
+
+struct sss_loop_stats_location {
+    const char *name;
+    uint64_t calls;
+    uint64_t total;
+    uint64_t max;
+
+    /* already added to the metrics counters */
+    uint64_t exported_calls;
+    uint64_t exported_total;
+};
+
+/* The handler of the iteration is the first frame, entered sections
+ * follow it. @usec is the time spent in the frame itself. */
+struct sss_loop_stats_frame {
+    struct sss_loop_stats_location *location;
+    uint64_t usec;
+};
+
+static struct {
+    bool enabled;
+    tevent_trace_callback_t prev_cb;
+    void *prev_data;
+
+    struct sss_loop_stats_location locations[SSS_LOOP_STATS_MAX_LOCATIONS];
+    size_t num_locations;
+
+    struct sss_loop_stats_frame frames[SSS_LOOP_STATS_MAX_DEPTH];
+    size_t depth;
+    /* sections that were entered without a frame */
+    size_t skipped;
+
+    bool running;
+    bool waiting;
+    unsigned int nested;
+    uint64_t segment_start;
+
+    struct timeval probe_due;
+    uint64_t lag;
+    uint64_t lag_max;
+} sss_loop_stats;
+
+static uint64_t sss_loop_stats_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static struct sss_loop_stats_location *
+sss_loop_stats_location(const char *name)
+{
+    struct sss_loop_stats_location *location;
+    size_t i;
+
+    for (i = 0; i < sss_loop_stats.num_locations; i++) {
+        location = &sss_loop_stats.locations[i];
+        if (location->name == name || strcmp(location->name, name) == 0) {
+            return location;
+        }
+    }
+
+    if (sss_loop_stats.num_locations == SSS_LOOP_STATS_MAX_LOCATIONS) {
+        /* "other" is always the first one */
+        return &sss_loop_stats.locations[0];
+    }
+
+    location = &sss_loop_stats.locations[sss_loop_stats.num_locations];
+    location->name = name;
+    sss_loop_stats.num_locations++;
+
+    return location;
+}
+
+static void sss_loop_stats_account(struct sss_loop_stats_frame *frame)
+{
+    struct sss_loop_stats_location *location;
+
+    location = frame->location;
+    if (location == NULL) {
+        location = &sss_loop_stats.locations[0];
+    }
+
+    location->calls++;
+    location->total += frame->usec;
+    if (frame->usec > location->max) {
+        location->max = frame->usec;
+    }
+}
+
+/* Add the time since the last change to the current frame. */
+static void sss_loop_stats_charge(uint64_t now)
+{
+    if (!sss_loop_stats.running || sss_loop_stats.waiting) {
+        return;
+    }
+
+    if (now > sss_loop_stats.segment_start) {
+        sss_loop_stats.frames[sss_loop_stats.depth - 1].usec +=
+                                        now - sss_loop_stats.segment_start;
+    }
+    sss_loop_stats.segment_start = now;
+}
+
+static void sss_loop_stats_begin(uint64_t now)
+{
+    /* The time of nested loops counts to the handler that runs them. */
+    if (sss_loop_stats.running) {
+        sss_loop_stats.nested++;
+        return;
+    }
+
+    sss_loop_stats.running = true;
+    sss_loop_stats.waiting = false;
+    sss_loop_stats.segment_start = now;
+    sss_loop_stats.frames[0].location = NULL;
+    sss_loop_stats.frames[0].usec = 0;
+    sss_loop_stats.depth = 1;
+}
+
+static void sss_loop_stats_end(uint64_t now)
+{
+    if (sss_loop_stats.nested > 0) {
+        sss_loop_stats.nested--;
+        return;
+    }
+
+    if (!sss_loop_stats.running) {
+        return;
+    }
+
+    sss_loop_stats_charge(now);
+
+    /* Sections that were not left, e.g. because of an error path that
+     * misses sss_loop_stats_leave(), end with the iteration. */
+    while (sss_loop_stats.depth > 0) {
+        sss_loop_stats.depth--;
+        sss_loop_stats_account(&sss_loop_stats.frames[sss_loop_stats.depth]);
+    }
+
+    sss_loop_stats.skipped = 0;
+    sss_loop_stats.running = false;
+}
+
+static void sss_loop_stats_trace(enum tevent_trace_point point,
+                                 void *private_data)
+{
+    uint64_t now;
+
+    now = sss_loop_stats_now();
+
+    switch (point) {
+#if HAVE_DECL_TEVENT_TRACE_BEFORE_LOOP_ONCE
+    case TEVENT_TRACE_BEFORE_LOOP_ONCE:
+        sss_loop_stats_begin(now);
+        break;
+    case TEVENT_TRACE_AFTER_LOOP_ONCE:
+        sss_loop_stats_end(now);
+        break;
+    case TEVENT_TRACE_BEFORE_WAIT:
+        sss_loop_stats_charge(now);
+        sss_loop_stats.waiting = true;
+        break;
+    case TEVENT_TRACE_AFTER_WAIT:
+        sss_loop_stats.waiting = false;
+        sss_loop_stats.segment_start = now;
+        break;
+#else
+    /* Without the loop points everything between two waits is one
+     * iteration, immediate and timer handlers that run without waiting
+     * are accounted together. */
+    case TEVENT_TRACE_AFTER_WAIT:
+        sss_loop_stats_begin(now);
+        break;
+    case TEVENT_TRACE_BEFORE_WAIT:
+        sss_loop_stats_end(now);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    if (sss_loop_stats.prev_cb != NULL) {
+        sss_loop_stats.prev_cb(point, sss_loop_stats.prev_data);
+    }
+}
+
+void sss_loop_stats_mark(const char *location)
+{
+    if (!sss_loop_stats.running) {
+        return;
+    }
+
+    if (sss_loop_stats.frames[0].location == NULL) {
+        sss_loop_stats.frames[0].location = sss_loop_stats_location(location);
+    }
+}
+
+void sss_loop_stats_enter(const char *location)
+{
+    struct sss_loop_stats_frame *frame;
+
+    if (!sss_loop_stats.running
+            || sss_loop_stats.depth == SSS_LOOP_STATS_MAX_DEPTH) {
+        sss_loop_stats.skipped++;
+        return;
+    }
+
+    sss_loop_stats_charge(sss_loop_stats_now());
+
+    frame = &sss_loop_stats.frames[sss_loop_stats.depth];
+    frame->location = sss_loop_stats_location(location);
+    frame->usec = 0;
+    sss_loop_stats.depth++;
+}
+
+void sss_loop_stats_leave(void)
+{
+    if (sss_loop_stats.skipped > 0) {
+        sss_loop_stats.skipped--;
+        return;
+    }
+
+    if (!sss_loop_stats.running || sss_loop_stats.depth <= 1) {
+        return;
+    }
+
+    sss_loop_stats_charge(sss_loop_stats_now());
+
+    sss_loop_stats.depth--;
+    sss_loop_stats_account(&sss_loop_stats.frames[sss_loop_stats.depth]);
+}
+
+static void sss_loop_stats_probe(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval current_time,
+                                 void *pvt);
+
+static errno_t sss_loop_stats_schedule_probe(struct tevent_context *ev)
+{
+    struct tevent_timer *te;
+
+    sss_loop_stats.probe_due =
+                    tevent_timeval_current_ofs(SSS_LOOP_STATS_PROBE_INTERVAL, 0);
+
+    te = tevent_add_timer(ev, ev, sss_loop_stats.probe_due,
+                          sss_loop_stats_probe, NULL);
+    if (te == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static void sss_loop_stats_probe(struct tevent_context *ev,
+                                 struct tevent_timer *te,
+                                 struct timeval current_time,
+                                 void *pvt)
+{
+    struct timeval lag;
+    errno_t ret;
+
+    SSS_LOOP_STATS_MARK();
+
+    /* zero if the timer was run in time */
+    lag = tevent_timeval_until(&sss_loop_stats.probe_due, &current_time);
+
+    sss_loop_stats.lag = (uint64_t)lag.tv_sec * 1000000 + lag.tv_usec;
+    if (sss_loop_stats.lag > sss_loop_stats.lag_max) {
+        sss_loop_stats.lag_max = sss_loop_stats.lag;
+    }
+
+    ret = sss_loop_stats_schedule_probe(ev);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to schedule event loop lag "
+              "probe, lag is not measured anymore\n");
+    }
+}
+
+static void sss_loop_stats_collect(void *pvt)
+{
+    struct sss_loop_stats_location *location;
+    size_t i;
+
+    for (i = 0; i < sss_loop_stats.num_locations; i++) {
+        location = &sss_loop_stats.locations[i];
+        if (location->calls == 0) {
+            continue;
+        }
+
+        sss_metrics_inc(SSS_METRIC_EVENT_LOOP_HANDLER_CALLS,
+                        location->calls - location->exported_calls,
+                        location->name);
+        sss_metrics_inc(SSS_METRIC_EVENT_LOOP_HANDLER_TIME,
+                        location->total - location->exported_total,
+                        location->name);
+        sss_metrics_set(SSS_METRIC_EVENT_LOOP_HANDLER_MAX,
+                        location->max, location->name);
+
+        location->exported_calls = location->calls;
+        location->exported_total = location->total;
+    }
+
+    sss_metrics_set(SSS_METRIC_EVENT_LOOP_LAG, sss_loop_stats.lag);
+    sss_metrics_set(SSS_METRIC_EVENT_LOOP_LAG_MAX, sss_loop_stats.lag_max);
+}
+
+errno_t sss_loop_stats_init(struct tevent_context *ev)
+{
+    errno_t ret;
+
+    if (sss_loop_stats.enabled) {
+        return EOK;
+    }
+
+    sss_loop_stats.locations[0].name = SSS_LOOP_STATS_OTHER;
+    sss_loop_stats.num_locations = 1;
+
+    ret = sss_metrics_add_collector(ev, sss_loop_stats_collect, NULL);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_loop_stats_schedule_probe(ev);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    tevent_get_trace_callback(ev, &sss_loop_stats.prev_cb,
+                              &sss_loop_stats.prev_data);
+    tevent_set_trace_callback(ev, sss_loop_stats_trace, NULL);
+
+    sss_loop_stats.enabled = true;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Event loop statistics are enabled\n");
+
+    return EOK;
+}
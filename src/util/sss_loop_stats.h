@@ -0,0 +1,59 @@
+/*
+    SSSD
+
+    Event loop statistics
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_LOOP_STATS_H_
+#define _SSS_LOOP_STATS_H_
+
+#include <tevent.h>
+
+#include "util/util_errors.h"
+
+/*
+ * The trace callback of the event loop measures how long each loop
+ * iteration runs handlers, the time spent waiting for events is not
+ * counted. tevent runs one handler per iteration but does not tell which
+ * one, so handlers that are worth watching name the iteration with
+ * SSS_LOOP_STATS_MARK(). Iterations that are not marked are accounted
+ * to "other".
+ *
+ * Code that is called from many handlers, e.g. sysdb commits, is wrapped
+ * in SSS_LOOP_STATS_ENTER() and sss_loop_stats_leave(). Its time is
+ * accounted to its own location and is excluded from the handler.
+ *
+ * A timer measures the lag of the loop, how late it is run.
+ *
+ * The calls, the total and the longest time of each location and the lag
+ * are exported as metrics, see sss_metrics.h. All functions do nothing
+ * until sss_loop_stats_init() is called.
+ */
+
+errno_t sss_loop_stats_init(struct tevent_context *ev);
+
+/* Name the current loop iteration, the first mark is used. */
+void sss_loop_stats_mark(const char *location);
+
+#define SSS_LOOP_STATS_MARK() sss_loop_stats_mark(__FUNCTION__)
+
+/* @location must be a static string. */
+void sss_loop_stats_enter(const char *location);
+void sss_loop_stats_leave(void);
+
+#define SSS_LOOP_STATS_ENTER() sss_loop_stats_enter(__FUNCTION__)
+
+#endif /* _SSS_LOOP_STATS_H_ */
@@ -0,0 +1,173 @@
+/*
+    SSSD
+
+    Sealed memory files
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/sss_memfd.h"
+
+#if defined(HAVE_MEMFD_CREATE) && defined(MFD_ALLOW_SEALING) \
+    && defined(F_ADD_SEALS)
+#define SSS_HAVE_SEALED_MEMFD 1
+
+/* Seals that the receiver requires before it maps the file. */
+#define SSS_MEMFD_SEALS (F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW \
+                         | F_SEAL_WRITE)
+#endif
+
+#ifdef SSS_HAVE_SEALED_MEMFD
+errno_t sss_memfd_create(const char *name,
+                         const uint8_t *data,
+                         size_t length,
+                         int *_fd)
+{
+    size_t written = 0;
+    ssize_t len;
+    errno_t ret;
+    int fd;
+
+    fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "memfd_create() failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret == ENOSYS ? ENOTSUP : ret;
+    }
+
+    while (written < length) {
+        len = write(fd, data + written, length - written);
+        if (len == -1) {
+            ret = errno;
+            if (ret == EINTR) {
+                continue;
+            }
+
+            DEBUG(SSSDBG_OP_FAILURE, "Unable to write memory file [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            goto done;
+        }
+
+        written += len;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, SSS_MEMFD_SEALS) == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to seal memory file [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    *_fd = fd;
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        close(fd);
+    }
+
+    return ret;
+}
+
+static int sss_memfd_map_destructor(struct sss_memfd_map *map)
+{
+    if (map->length > 0) {
+        munmap(discard_const(map->data), map->length);
+    }
+
+    return 0;
+}
+
+errno_t sss_memfd_map(TALLOC_CTX *mem_ctx,
+                      int fd,
+                      struct sss_memfd_map **_map)
+{
+    struct sss_memfd_map *map;
+    struct stat st;
+    void *addr;
+    int seals;
+    errno_t ret;
+
+    seals = fcntl(fd, F_GET_SEALS);
+    if (seals == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to get seals of memory file "
+              "[%d]: %s\n", ret, sss_strerror(ret));
+        return ret == EINVAL ? EPERM : ret;
+    }
+
+    /* The sender must not be able to change the content under our hands. */
+    if ((seals & SSS_MEMFD_SEALS) != SSS_MEMFD_SEALS) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Memory file is not sealed\n");
+        return EPERM;
+    }
+
+    if (fstat(fd, &st) != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "fstat() failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    map = talloc_zero(mem_ctx, struct sss_memfd_map);
+    if (map == NULL) {
+        return ENOMEM;
+    }
+
+    if (st.st_size > 0) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ret = errno;
+            DEBUG(SSSDBG_OP_FAILURE, "mmap() failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            talloc_free(map);
+            return ret;
+        }
+
+        map->data = addr;
+        map->length = st.st_size;
+        talloc_set_destructor(map, sss_memfd_map_destructor);
+    }
+
+    *_map = map;
+
+    return EOK;
+}
+#else /* SSS_HAVE_SEALED_MEMFD */
+errno_t sss_memfd_create(const char *name,
+                         const uint8_t *data,
+                         size_t length,
+                         int *_fd)
+{
+    return ENOTSUP;
+}
+
+errno_t sss_memfd_map(TALLOC_CTX *mem_ctx,
+                      int fd,
+                      struct sss_memfd_map **_map)
+{
+    return ENOTSUP;
+}
+#endif /* SSS_HAVE_SEALED_MEMFD */
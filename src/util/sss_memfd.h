@@ -0,0 +1,64 @@
+/*
+    SSSD
+
+    Sealed memory files
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_MEMFD_H_
+#define _SSS_MEMFD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <talloc.h>
+
+#include "util/util_errors.h"
+
+/**
+ * Read-only mapping of a sealed memory file.
+ */
+struct sss_memfd_map {
+    const uint8_t *data;
+    size_t length;
+};
+
+/**
+ * Create an anonymous memory file named @name holding a copy of @data.
+ * The file is sealed so its content can not be changed anymore and it can
+ * be safely mapped by a process that receives the descriptor.
+ *
+ * @return EOK If @_fd was set, the caller must close it.
+ * @return ENOTSUP If memory files are not supported by the system.
+ * @return Other errno code in case of an error.
+ */
+errno_t sss_memfd_create(const char *name,
+                         const uint8_t *data,
+                         size_t length,
+                         int *_fd);
+
+/**
+ * Map the memory file @fd created by sss_memfd_create() read-only. The
+ * file is only accepted if it is sealed. The mapping is removed when
+ * @_map is freed, @fd may be closed right after the call.
+ *
+ * @return EOK If @_map was set.
+ * @return EPERM If the file is not sealed.
+ * @return Other errno code in case of an error.
+ */
+errno_t sss_memfd_map(TALLOC_CTX *mem_ctx,
+                      int fd,
+                      struct sss_memfd_map **_map);
+
+#endif /* _SSS_MEMFD_H_ */
@@ -0,0 +1,625 @@
+/*
+    SSSD
+
+    Runtime metrics
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_metrics.h"
+
+#define SSS_METRICS_MAX_LABELS 3
+
+/* Label values of new series are replaced with this one once a metric has
+ * this many series, e.g. with many subdomains. */
+#define SSS_METRICS_MAX_SERIES 256
+#define SSS_METRICS_OVERFLOW "other"
+
+enum sss_metric_type {
+    SSS_METRIC_TYPE_COUNTER,
+    SSS_METRIC_TYPE_GAUGE,
+    SSS_METRIC_TYPE_HISTOGRAM,
+};
+
+struct sss_metric_family {
+    const char *name;
+    enum sss_metric_type type;
+    const char *help;
+    const char *labels[SSS_METRICS_MAX_LABELS + 1];
+};
+
+static const struct sss_metric_family sss_metric_families[] = {
+    [SSS_METRIC_RESPONDER_COMMAND_DURATION] = {
+        "sssd_responder_command_duration_seconds", SSS_METRIC_TYPE_HISTOGRAM,
+        "Time until a client command was answered.",
+        {"command", NULL}
+    },
+    [SSS_METRIC_CACHE_REQ_LOOKUPS] = {
+        "sssd_cache_req_lookups", SSS_METRIC_TYPE_COUNTER,
+        "Lookups of the responders by the source of the answer.",
+        {"request", "source", NULL}
+    },
+    [SSS_METRIC_NCACHE_ENTRIES] = {
+        "sssd_negative_cache_entries", SSS_METRIC_TYPE_GAUGE,
+        "Entries in the negative cache.",
+        {NULL}
+    },
+    [SSS_METRIC_DP_REQUESTS] = {
+        "sssd_dp_requests", SSS_METRIC_TYPE_COUNTER,
+        "Data provider requests by their result.",
+        {"domain", "target", "result", NULL}
+    },
+    [SSS_METRIC_DP_REQUEST_DURATION] = {
+        "sssd_dp_request_duration_seconds", SSS_METRIC_TYPE_HISTOGRAM,
+        "Time until a data provider request was handled.",
+        {"domain", "target", NULL}
+    },
+    [SSS_METRIC_LDAP_OP_DURATION] = {
+        "sssd_ldap_operation_duration_seconds", SSS_METRIC_TYPE_HISTOGRAM,
+        "Time until an LDAP server answered an operation.",
+        {"outcome", NULL}
+    },
+    [SSS_METRIC_FAILOVER_SWITCHES] = {
+        "sssd_failover_server_switches", SSS_METRIC_TYPE_COUNTER,
+        "Changes of the active server of a service.",
+        {"service", NULL}
+    },
+    [SSS_METRIC_FAILOVER_FAILURES] = {
+        "sssd_failover_server_failures", SSS_METRIC_TYPE_COUNTER,
+        "Servers of a service that were marked as not working.",
+        {"service", NULL}
+    },
+    [SSS_METRIC_CHILD_FORKS] = {
+        "sssd_child_forks", SSS_METRIC_TYPE_COUNTER,
+        "Child processes that were started.",
+        {NULL}
+    },
+    [SSS_METRIC_CHILD_EXITS] = {
+        "sssd_child_exits", SSS_METRIC_TYPE_COUNTER,
+        "Child processes that finished by how they finished.",
+        {"status", NULL}
+    },
+    [SSS_METRIC_CHILD_POOL_REQUESTS] = {
+        "sssd_child_pool_requests", SSS_METRIC_TYPE_COUNTER,
+        "Requests served by the helpers of a child pool by their result.",
+        {"pool", "result", NULL}
+    },
+    [SSS_METRIC_CHILD_POOL_WAIT_DURATION] = {
+        "sssd_child_pool_wait_seconds", SSS_METRIC_TYPE_HISTOGRAM,
+        "Time a request waited for a free helper of a child pool.",
+        {"pool", NULL}
+    },
+    [SSS_METRIC_CHILD_POOL_HELPERS] = {
+        "sssd_child_pool_helpers", SSS_METRIC_TYPE_GAUGE,
+        "Started helpers of a child pool by their state.",
+        {"pool", "state", NULL}
+    },
+    [SSS_METRIC_CHILD_POOL_RECYCLES] = {
+        "sssd_child_pool_recycles", SSS_METRIC_TYPE_COUNTER,
+        "Helpers of a child pool that were stopped by the reason.",
+        {"pool", "reason", NULL}
+    },
+    [SSS_METRIC_EVENT_LOOP_HANDLER_CALLS] = {
+        "sssd_event_loop_handler_calls", SSS_METRIC_TYPE_COUNTER,
+        "Event loop iterations and sections by the location that ran them.",
+        {"location", NULL}
+    },
+    [SSS_METRIC_EVENT_LOOP_HANDLER_TIME] = {
+        "sssd_event_loop_handler_microseconds", SSS_METRIC_TYPE_COUNTER,
+        "Time the event loop spent running handlers by the location.",
+        {"location", NULL}
+    },
+    [SSS_METRIC_EVENT_LOOP_HANDLER_MAX] = {
+        "sssd_event_loop_handler_max_microseconds", SSS_METRIC_TYPE_GAUGE,
+        "Longest single run of a location in the event loop.",
+        {"location", NULL}
+    },
+    [SSS_METRIC_EVENT_LOOP_LAG] = {
+        "sssd_event_loop_lag_microseconds", SSS_METRIC_TYPE_GAUGE,
+        "How late the last event loop lag probe timer was run.",
+        {NULL}
+    },
+    [SSS_METRIC_EVENT_LOOP_LAG_MAX] = {
+        "sssd_event_loop_lag_max_microseconds", SSS_METRIC_TYPE_GAUGE,
+        "Largest measured event loop lag.",
+        {NULL}
+    },
+};
+
+/* Upper bounds of the histogram buckets in microseconds and seconds. */
+static const uint64_t sss_metrics_bucket_usec[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000
+};
+
+static const char *sss_metrics_bucket_le[] = {
+    "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05", "0.1", "0.25", "0.5",
+    "1", "2.5", "5", "10"
+};
+
+#define SSS_METRICS_BUCKETS \
+    (sizeof(sss_metrics_bucket_usec) / sizeof(sss_metrics_bucket_usec[0]))
+
+struct sss_metrics_series {
+    struct sss_metrics_series *prev;
+    struct sss_metrics_series *next;
+
+    char *values[SSS_METRICS_MAX_LABELS];
+
+    /* counter and gauge */
+    int64_t value;
+
+    /* histogram, the buckets are not cumulative */
+    uint64_t count;
+    uint64_t sum_usec;
+    uint64_t buckets[SSS_METRICS_BUCKETS];
+};
+
+struct sss_metrics_collector {
+    struct sss_metrics_collector *prev;
+    struct sss_metrics_collector *next;
+
+    sss_metrics_collect_fn fn;
+    void *pvt;
+};
+
+static struct {
+    TALLOC_CTX *mem_ctx;
+    /* most recently used first */
+    struct sss_metrics_series *series[SSS_METRIC_SENTINEL];
+    size_t num_series[SSS_METRIC_SENTINEL];
+    struct sss_metrics_collector *collectors;
+} sss_metrics;
+
+static struct sss_metrics_series *
+sss_metrics_find(enum sss_metric metric, const char **values, size_t num)
+{
+    struct sss_metrics_series *series;
+    size_t i;
+
+    DLIST_FOR_EACH(series, sss_metrics.series[metric]) {
+        for (i = 0; i < num; i++) {
+            if (strcmp(series->values[i], values[i]) != 0) {
+                break;
+            }
+        }
+
+        if (i == num) {
+            DLIST_PROMOTE(sss_metrics.series[metric], series);
+            return series;
+        }
+    }
+
+    return NULL;
+}
+
+static struct sss_metrics_series *
+sss_metrics_get_series(enum sss_metric metric, va_list ap)
+{
+    struct sss_metrics_series *series;
+    const char *values[SSS_METRICS_MAX_LABELS];
+    size_t num;
+    size_t i;
+
+    if (metric >= SSS_METRIC_SENTINEL) {
+        return NULL;
+    }
+
+    for (num = 0; sss_metric_families[metric].labels[num] != NULL; num++) {
+        values[num] = va_arg(ap, const char *);
+        if (values[num] == NULL) {
+            values[num] = "";
+        }
+    }
+
+    series = sss_metrics_find(metric, values, num);
+    if (series != NULL) {
+        return series;
+    }
+
+    if (sss_metrics.num_series[metric] >= SSS_METRICS_MAX_SERIES) {
+        for (i = 0; i < num; i++) {
+            values[i] = SSS_METRICS_OVERFLOW;
+        }
+
+        series = sss_metrics_find(metric, values, num);
+        if (series != NULL) {
+            return series;
+        }
+    }
+
+    if (sss_metrics.mem_ctx == NULL) {
+        sss_metrics.mem_ctx = talloc_named_const(NULL, 0, "sss_metrics");
+        if (sss_metrics.mem_ctx == NULL) {
+            return NULL;
+        }
+    }
+
+    series = talloc_zero(sss_metrics.mem_ctx, struct sss_metrics_series);
+    if (series == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < num; i++) {
+        series->values[i] = talloc_strdup(series, values[i]);
+        if (series->values[i] == NULL) {
+            talloc_free(series);
+            return NULL;
+        }
+    }
+
+    DLIST_ADD(sss_metrics.series[metric], series);
+    sss_metrics.num_series[metric]++;
+
+    return series;
+}
+
+void sss_metrics_inc(enum sss_metric metric, uint64_t value, ...)
+{
+    struct sss_metrics_series *series;
+    va_list ap;
+
+    va_start(ap, value);
+    series = sss_metrics_get_series(metric, ap);
+    va_end(ap);
+
+    if (series != NULL) {
+        series->value += value;
+    }
+}
+
+void sss_metrics_set(enum sss_metric metric, int64_t value, ...)
+{
+    struct sss_metrics_series *series;
+    va_list ap;
+
+    va_start(ap, value);
+    series = sss_metrics_get_series(metric, ap);
+    va_end(ap);
+
+    if (series != NULL) {
+        series->value = value;
+    }
+}
+
+void sss_metrics_observe(enum sss_metric metric, uint64_t usec, ...)
+{
+    struct sss_metrics_series *series;
+    va_list ap;
+    size_t i;
+
+    va_start(ap, usec);
+    series = sss_metrics_get_series(metric, ap);
+    va_end(ap);
+
+    if (series == NULL) {
+        return;
+    }
+
+    series->count++;
+    series->sum_usec += usec;
+
+    /* Slower observations are only accounted in the +Inf bucket. */
+    for (i = 0; i < SSS_METRICS_BUCKETS; i++) {
+        if (usec <= sss_metrics_bucket_usec[i]) {
+            series->buckets[i]++;
+            break;
+        }
+    }
+}
+
+static int sss_metrics_collector_destructor(struct sss_metrics_collector *c)
+{
+    DLIST_REMOVE(sss_metrics.collectors, c);
+    return 0;
+}
+
+errno_t sss_metrics_add_collector(TALLOC_CTX *owner,
+                                  sss_metrics_collect_fn fn,
+                                  void *pvt)
+{
+    struct sss_metrics_collector *collector;
+
+    collector = talloc_zero(owner, struct sss_metrics_collector);
+    if (collector == NULL) {
+        return ENOMEM;
+    }
+
+    collector->fn = fn;
+    collector->pvt = pvt;
+
+    DLIST_ADD(sss_metrics.collectors, collector);
+    talloc_set_destructor(collector, sss_metrics_collector_destructor);
+
+    return EOK;
+}
+
+static char *sss_metrics_escape(TALLOC_CTX *mem_ctx, const char *value)
+{
+    char *out;
+    size_t i;
+    size_t j;
+
+    out = talloc_array(mem_ctx, char, 2 * strlen(value) + 1);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    for (i = 0, j = 0; value[i] != '\0'; i++) {
+        switch (value[i]) {
+        case '\\':
+        case '"':
+            out[j++] = '\\';
+            out[j++] = value[i];
+            break;
+        case '\n':
+            out[j++] = '\\';
+            out[j++] = 'n';
+            break;
+        default:
+            out[j++] = value[i];
+            break;
+        }
+    }
+    out[j] = '\0';
+
+    return out;
+}
+
+static char *sss_metrics_labels(TALLOC_CTX *mem_ctx,
+                                enum sss_metric metric,
+                                struct sss_metrics_series *series)
+{
+    const char * const *names = sss_metric_families[metric].labels;
+    char *labels;
+    char *value;
+    size_t i;
+
+    labels = talloc_strdup(mem_ctx, "");
+
+    for (i = 0; names[i] != NULL && labels != NULL; i++) {
+        value = sss_metrics_escape(labels, series->values[i]);
+        if (value == NULL) {
+            talloc_free(labels);
+            return NULL;
+        }
+
+        labels = talloc_asprintf_append_buffer(labels, "%s%s=\"%s\"",
+                                               i == 0 ? "" : ",",
+                                               names[i], value);
+    }
+
+    return labels;
+}
+
+static errno_t sss_metrics_add_sample(struct sss_metrics_sample *samples,
+                                      size_t *_num,
+                                      enum sss_metric metric,
+                                      const char *suffix,
+                                      const char *labels,
+                                      char *value)
+{
+    if (labels == NULL || value == NULL) {
+        return ENOMEM;
+    }
+
+    samples[*_num].metric = metric;
+    samples[*_num].suffix = suffix;
+    samples[*_num].labels = labels;
+    samples[*_num].value = value;
+    (*_num)++;
+
+    return EOK;
+}
+
+static errno_t sss_metrics_export_histogram(struct sss_metrics_sample *samples,
+                                            size_t *_num,
+                                            enum sss_metric metric,
+                                            const char *labels,
+                                            struct sss_metrics_series *series)
+{
+    const char *sep = labels[0] == '\0' ? "" : ",";
+    uint64_t cumulative = 0;
+    errno_t ret;
+    size_t i;
+
+    for (i = 0; i < SSS_METRICS_BUCKETS; i++) {
+        cumulative += series->buckets[i];
+        ret = sss_metrics_add_sample(samples, _num, metric, "_bucket",
+                  talloc_asprintf(samples, "%s%sle=\"%s\"", labels, sep,
+                                  sss_metrics_bucket_le[i]),
+                  talloc_asprintf(samples, "%"PRIu64, cumulative));
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    ret = sss_metrics_add_sample(samples, _num, metric, "_bucket",
+              talloc_asprintf(samples, "%s%sle=\"+Inf\"", labels, sep),
+              talloc_asprintf(samples, "%"PRIu64, series->count));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = sss_metrics_add_sample(samples, _num, metric, "_count", labels,
+              talloc_asprintf(samples, "%"PRIu64, series->count));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return sss_metrics_add_sample(samples, _num, metric, "_sum", labels,
+              talloc_asprintf(samples, "%"PRIu64".%06"PRIu64,
+                              series->sum_usec / 1000000,
+                              series->sum_usec % 1000000));
+}
+
+errno_t sss_metrics_export(TALLOC_CTX *mem_ctx,
+                           struct sss_metrics_sample **_samples,
+                           size_t *_num_samples)
+{
+    struct sss_metrics_collector *collector;
+    struct sss_metrics_series *series;
+    struct sss_metrics_sample *samples;
+    enum sss_metric metric;
+    const char *labels;
+    size_t num = 0;
+    size_t max = 0;
+    errno_t ret;
+
+    DLIST_FOR_EACH(collector, sss_metrics.collectors) {
+        collector->fn(collector->pvt);
+    }
+
+    for (metric = 0; metric < SSS_METRIC_SENTINEL; metric++) {
+        if (sss_metric_families[metric].type == SSS_METRIC_TYPE_HISTOGRAM) {
+            /* buckets, +Inf, _count and _sum */
+            max += sss_metrics.num_series[metric] * (SSS_METRICS_BUCKETS + 3);
+        } else {
+            max += sss_metrics.num_series[metric];
+        }
+    }
+
+    samples = talloc_zero_array(mem_ctx, struct sss_metrics_sample, max + 1);
+    if (samples == NULL) {
+        return ENOMEM;
+    }
+
+    for (metric = 0; metric < SSS_METRIC_SENTINEL; metric++) {
+        DLIST_FOR_EACH(series, sss_metrics.series[metric]) {
+            labels = sss_metrics_labels(samples, metric, series);
+
+            switch (sss_metric_families[metric].type) {
+            case SSS_METRIC_TYPE_COUNTER:
+                ret = sss_metrics_add_sample(samples, &num, metric, "_total",
+                          labels,
+                          talloc_asprintf(samples, "%"PRIu64,
+                                          (uint64_t)series->value));
+                break;
+            case SSS_METRIC_TYPE_GAUGE:
+                ret = sss_metrics_add_sample(samples, &num, metric, "",
+                          labels,
+                          talloc_asprintf(samples, "%"PRId64, series->value));
+                break;
+            case SSS_METRIC_TYPE_HISTOGRAM:
+                ret = labels == NULL ? ENOMEM
+                      : sss_metrics_export_histogram(samples, &num, metric,
+                                                     labels, series);
+                break;
+            default:
+                ret = ERR_INTERNAL;
+                break;
+            }
+
+            if (ret != EOK) {
+                talloc_free(samples);
+                return ret;
+            }
+        }
+    }
+
+    *_samples = samples;
+    *_num_samples = num;
+
+    return EOK;
+}
+
+char *sss_metrics_format(TALLOC_CTX *mem_ctx,
+                         struct sss_metrics_source *sources,
+                         size_t num_sources)
+{
+    const struct sss_metric_family *family;
+    struct sss_metrics_sample *sample;
+    enum sss_metric metric;
+    char **components;
+    bool header;
+    char *out;
+    size_t i;
+    size_t j;
+
+    out = talloc_strdup(mem_ctx, "");
+    if (out == NULL) {
+        return NULL;
+    }
+
+    components = talloc_zero_array(out, char *, num_sources + 1);
+    if (components == NULL) {
+        talloc_free(out);
+        return NULL;
+    }
+
+    for (i = 0; i < num_sources; i++) {
+        components[i] = sss_metrics_escape(components, sources[i].component);
+        if (components[i] == NULL) {
+            talloc_free(out);
+            return NULL;
+        }
+    }
+
+    for (metric = 0; metric < SSS_METRIC_SENTINEL && out != NULL; metric++) {
+        family = &sss_metric_families[metric];
+        header = false;
+
+        for (i = 0; i < num_sources && out != NULL; i++) {
+            for (j = 0; j < sources[i].num_samples && out != NULL; j++) {
+                sample = &sources[i].samples[j];
+                if (sample->metric != metric) {
+                    continue;
+                }
+
+                if (!header) {
+                    out = talloc_asprintf_append_buffer(out,
+                              "# TYPE %s %s\n# HELP %s %s\n",
+                              family->name,
+                              family->type == SSS_METRIC_TYPE_COUNTER
+                                  ? "counter"
+                                  : family->type == SSS_METRIC_TYPE_GAUGE
+                                      ? "gauge" : "histogram",
+                              family->name, family->help);
+                    header = true;
+                    if (out == NULL) {
+                        break;
+                    }
+                }
+
+                out = talloc_asprintf_append_buffer(out,
+                          "%s%s{component=\"%s\"%s%s} %s\n",
+                          family->name, sample->suffix, components[i],
+                          sample->labels[0] == '\0' ? "" : ",",
+                          sample->labels, sample->value);
+            }
+        }
+    }
+
+    if (out == NULL) {
+        return NULL;
+    }
+
+    talloc_zfree(components);
+
+    return talloc_asprintf_append_buffer(out, "# EOF\n");
+}
+
+void sss_metrics_reset(void)
+{
+    talloc_zfree(sss_metrics.mem_ctx);
+    memset(sss_metrics.series, 0, sizeof(sss_metrics.series));
+    memset(sss_metrics.num_series, 0, sizeof(sss_metrics.num_series));
+}
@@ -0,0 +1,108 @@
+/*
+    SSSD
+
+    Runtime metrics
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_METRICS_H_
+#define _SSS_METRICS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <talloc.h>
+
+#include "util/util_errors.h"
+
+/*
+ * Every SSSD process keeps its own metrics. The monitor collects them from
+ * all services over sbus (sssd.Metrics) and serves them in the OpenMetrics
+ * text format on the metrics_socket, each sample labeled with the component
+ * it comes from.
+ *
+ * The name, type, help and label names of the metrics are listed in
+ * sss_metrics.c. Label values are passed to the functions below in the
+ * order of the label names, NULL is an empty value.
+ */
+enum sss_metric {
+    SSS_METRIC_RESPONDER_COMMAND_DURATION,
+    SSS_METRIC_CACHE_REQ_LOOKUPS,
+    SSS_METRIC_NCACHE_ENTRIES,
+    SSS_METRIC_DP_REQUESTS,
+    SSS_METRIC_DP_REQUEST_DURATION,
+    SSS_METRIC_LDAP_OP_DURATION,
+    SSS_METRIC_FAILOVER_SWITCHES,
+    SSS_METRIC_FAILOVER_FAILURES,
+    SSS_METRIC_CHILD_FORKS,
+    SSS_METRIC_CHILD_EXITS,
+    SSS_METRIC_CHILD_POOL_REQUESTS,
+    SSS_METRIC_CHILD_POOL_WAIT_DURATION,
+    SSS_METRIC_CHILD_POOL_HELPERS,
+    SSS_METRIC_CHILD_POOL_RECYCLES,
+    SSS_METRIC_EVENT_LOOP_HANDLER_CALLS,
+    SSS_METRIC_EVENT_LOOP_HANDLER_TIME,
+    SSS_METRIC_EVENT_LOOP_HANDLER_MAX,
+    SSS_METRIC_EVENT_LOOP_LAG,
+    SSS_METRIC_EVENT_LOOP_LAG_MAX,
+
+    SSS_METRIC_SENTINEL
+};
+
+/* Add @value to a counter. */
+void sss_metrics_inc(enum sss_metric metric, uint64_t value, ...);
+
+/* Set the value of a gauge. */
+void sss_metrics_set(enum sss_metric metric, int64_t value, ...);
+
+/* Add an observation to a histogram of durations. */
+void sss_metrics_observe(enum sss_metric metric, uint64_t usec, ...);
+
+/* Gauges that are expensive to keep up to date are set by a collector
+ * right before the metrics are exported. The collector is removed when
+ * @owner is freed. */
+typedef void (*sss_metrics_collect_fn)(void *pvt);
+
+errno_t sss_metrics_add_collector(TALLOC_CTX *owner,
+                                  sss_metrics_collect_fn fn,
+                                  void *pvt);
+
+/* One line of the OpenMetrics exposition without the component label. */
+struct sss_metrics_sample {
+    enum sss_metric metric;
+    const char *suffix;     /* e.g. "_total" or "_bucket" */
+    const char *labels;     /* escaped name="value" pairs, may be empty */
+    const char *value;
+};
+
+errno_t sss_metrics_export(TALLOC_CTX *mem_ctx,
+                           struct sss_metrics_sample **_samples,
+                           size_t *_num_samples);
+
+/* Samples exported by one component. */
+struct sss_metrics_source {
+    const char *component;
+    struct sss_metrics_sample *samples;
+    size_t num_samples;
+};
+
+/* Return the OpenMetrics text of the samples of all @sources. */
+char *sss_metrics_format(TALLOC_CTX *mem_ctx,
+                         struct sss_metrics_source *sources,
+                         size_t num_sources);
+
+/* Drop all series, used by tests. */
+void sss_metrics_reset(void);
+
+#endif /* _SSS_METRICS_H_ */
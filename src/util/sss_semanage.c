@@ -306,34 +306,15 @@ int sss_get_seuser(const char *linuxuser,
     return getseuserbyname(linuxuser, selinuxuser, level);
 }
 
-int sss_set_seuser(const char *login_name, const char *seuser_name,
-                   const char *mls)
+static int sss_semanage_set_one(semanage_handle_t *handle,
+                                const char *login_name,
+                                const char *seuser_name,
+                                const char *mls)
 {
-    semanage_handle_t *handle = NULL;
     semanage_seuser_key_t *key = NULL;
     int ret;
     int seuser_exists = 0;
 
-    if (seuser_name == NULL) {
-        /* don't care, just let system pick the defaults */
-        return EOK;
-    }
-
-    ret = sss_semanage_init(&handle);
-    if (ret == ERR_SELINUX_NOT_MANAGED) {
-        goto done;
-    } else if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create SELinux handle\n");
-        goto done;
-    }
-
-    ret = semanage_begin_transaction(handle);
-    if (ret != 0) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot begin SELinux transaction\n");
-        ret = EIO;
-        goto done;
-    }
-
     ret = semanage_seuser_key_create(handle, login_name, &key);
     if (ret != 0) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create SELinux user key\n");
@@ -366,44 +347,21 @@ int sss_set_seuser(const char *login_name, const char *seuser_name,
         }
     }
 
-    ret = semanage_commit(handle);
-    if (ret < 0) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot commit SELinux transaction\n");
-        ret = EIO;
-        goto done;
-    }
-
     ret = EOK;
 done:
     if (key != NULL) {
         semanage_seuser_key_free(key);
     }
-    sss_semanage_close(handle);
     return ret;
 }
 
-int sss_del_seuser(const char *login_name)
+static int sss_semanage_del_one(semanage_handle_t *handle,
+                                const char *login_name)
 {
-    semanage_handle_t *handle = NULL;
     semanage_seuser_key_t *key = NULL;
     int ret;
     int exists = 0;
 
-    ret = sss_semanage_init(&handle);
-    if (ret == ERR_SELINUX_NOT_MANAGED) {
-        goto done;
-    } else if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create SELinux handle\n");
-        goto done;
-    }
-
-    ret = semanage_begin_transaction(handle);
-    if (ret != 0) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot begin SELinux transaction\n");
-        ret = EIO;
-        goto done;
-    }
-
     ret = semanage_seuser_key_create(handle, login_name, &key);
     if (ret != 0) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create SELinux user key\n");
@@ -449,6 +407,63 @@ int sss_del_seuser(const char *login_name)
         goto done;
     }
 
+    ret = EOK;
+done:
+    if (key != NULL) {
+        semanage_seuser_key_free(key);
+    }
+    return ret;
+}
+
+int sss_set_seusers(struct sss_seuser_change *changes, size_t count)
+{
+    semanage_handle_t *handle = NULL;
+    size_t num_changed = 0;
+    size_t i;
+    int ret;
+
+    for (i = 0; i < count; i++) {
+        changes[i].ret = EOK;
+    }
+
+    ret = sss_semanage_init(&handle);
+    if (ret == ERR_SELINUX_NOT_MANAGED) {
+        goto done;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create SELinux handle\n");
+        goto done;
+    }
+
+    ret = semanage_begin_transaction(handle);
+    if (ret != 0) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot begin SELinux transaction\n");
+        ret = EIO;
+        goto done;
+    }
+
+    /* A failure of one change does not prevent the others from being
+     * committed, the transaction is not modified in that case. */
+    for (i = 0; i < count; i++) {
+        if (changes[i].seuser_name == NULL) {
+            changes[i].ret = sss_semanage_del_one(handle,
+                                                  changes[i].login_name);
+        } else {
+            changes[i].ret = sss_semanage_set_one(handle,
+                                                  changes[i].login_name,
+                                                  changes[i].seuser_name,
+                                                  changes[i].mls);
+        }
+
+        if (changes[i].ret == EOK) {
+            num_changed++;
+        }
+    }
+
+    if (num_changed == 0) {
+        ret = EOK;
+        goto done;
+    }
+
     ret = semanage_commit(handle);
     if (ret < 0) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Cannot commit SELinux transaction\n");
@@ -456,12 +471,63 @@ int sss_del_seuser(const char *login_name)
         goto done;
     }
 
+    DEBUG(SSSDBG_TRACE_FUNC, "Committed %zu SELinux login mappings\n",
+          num_changed);
+
     ret = EOK;
 done:
+    if (ret != EOK && ret != ERR_SELINUX_NOT_MANAGED) {
+        for (i = 0; i < count; i++) {
+            changes[i].ret = ret;
+        }
+    }
     sss_semanage_close(handle);
     return ret;
 }
+
+int sss_set_seuser(const char *login_name, const char *seuser_name,
+                   const char *mls)
+{
+    struct sss_seuser_change change;
+    int ret;
+
+    if (seuser_name == NULL) {
+        /* don't care, just let system pick the defaults */
+        return EOK;
+    }
+
+    change.login_name = login_name;
+    change.seuser_name = seuser_name;
+    change.mls = mls;
+
+    ret = sss_set_seusers(&change, 1);
+    return ret != EOK ? ret : change.ret;
+}
+
+int sss_del_seuser(const char *login_name)
+{
+    struct sss_seuser_change change;
+    int ret;
+
+    change.login_name = login_name;
+    change.seuser_name = NULL;
+    change.mls = NULL;
+
+    ret = sss_set_seusers(&change, 1);
+    return ret != EOK ? ret : change.ret;
+}
 #else /* HAVE_SEMANAGE && HAVE_SELINUX */
+int sss_set_seusers(struct sss_seuser_change *changes, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        changes[i].ret = EOK;
+    }
+
+    return EOK;
+}
+
 int sss_set_seuser(const char *login_name, const char *seuser_name,
                    const char *mls)
 {
@@ -0,0 +1,146 @@
+/*
+    SSSD
+
+    Pool of unique string copies
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <stdint.h>
+#include <talloc.h>
+
+#include "util/util.h"
+#include "util/sss_str_intern.h"
+
+#define SSS_STR_INTERN_INITIAL_SIZE 64
+
+/* Open addressing with linear probing, the slots only hold pointers to
+ * the strings so every string is stored once. The table is kept at most
+ * half full. */
+struct sss_str_intern_pool {
+    const char **slots;
+    size_t size;
+    size_t count;
+};
+
+static uint32_t sss_str_intern_hash(const char *str)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+
+    for (; *str != '\0'; str++) {
+        hash ^= (uint8_t)*str;
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static const char **
+sss_str_intern_find(const char **slots, size_t size, const char *str)
+{
+    size_t i;
+
+    i = sss_str_intern_hash(str) & (size - 1);
+    while (slots[i] != NULL && strcmp(slots[i], str) != 0) {
+        i = (i + 1) & (size - 1);
+    }
+
+    return &slots[i];
+}
+
+static errno_t sss_str_intern_grow(struct sss_str_intern_pool *pool)
+{
+    const char **slots;
+    size_t size;
+    size_t i;
+
+    size = pool->size * 2;
+    slots = talloc_zero_array(pool, const char *, size);
+    if (slots == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < pool->size; i++) {
+        if (pool->slots[i] != NULL) {
+            *sss_str_intern_find(slots, size, pool->slots[i]) = pool->slots[i];
+        }
+    }
+
+    talloc_free(pool->slots);
+    pool->slots = slots;
+    pool->size = size;
+
+    return EOK;
+}
+
+struct sss_str_intern_pool *
+sss_str_intern_pool_create(TALLOC_CTX *mem_ctx)
+{
+    struct sss_str_intern_pool *pool;
+
+    pool = talloc_zero(mem_ctx, struct sss_str_intern_pool);
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->slots = talloc_zero_array(pool, const char *,
+                                    SSS_STR_INTERN_INITIAL_SIZE);
+    if (pool->slots == NULL) {
+        talloc_free(pool);
+        return NULL;
+    }
+    pool->size = SSS_STR_INTERN_INITIAL_SIZE;
+
+    return pool;
+}
+
+const char *
+sss_str_intern(struct sss_str_intern_pool *pool, const char *str)
+{
+    const char **slot;
+    errno_t ret;
+
+    if (pool == NULL || str == NULL) {
+        return NULL;
+    }
+
+    slot = sss_str_intern_find(pool->slots, pool->size, str);
+    if (*slot != NULL) {
+        return *slot;
+    }
+
+    if ((pool->count + 1) * 2 > pool->size) {
+        ret = sss_str_intern_grow(pool);
+        if (ret != EOK) {
+            return NULL;
+        }
+        slot = sss_str_intern_find(pool->slots, pool->size, str);
+    }
+
+    *slot = talloc_strdup(pool, str);
+    if (*slot == NULL) {
+        return NULL;
+    }
+    pool->count++;
+
+    return *slot;
+}
+
+size_t
+sss_str_intern_count(struct sss_str_intern_pool *pool)
+{
+    return pool == NULL ? 0 : pool->count;
+}
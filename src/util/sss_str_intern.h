@@ -0,0 +1,52 @@
+/*
+    SSSD
+
+    Pool of unique string copies
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_STR_INTERN_H_
+#define _SSS_STR_INTERN_H_
+
+#include <talloc.h>
+
+struct sss_str_intern_pool;
+
+/**
+ * Create a new pool. All strings of the pool are freed together with it,
+ * so it should live only as long as one operation that would otherwise
+ * copy the same strings (e.g. DNs of group members) many times.
+ */
+struct sss_str_intern_pool *
+sss_str_intern_pool_create(TALLOC_CTX *mem_ctx);
+
+/**
+ * Return the copy of @str that is kept in @pool, the copy is created if
+ * @str is not in the pool yet. Strings returned for equal @str are the
+ * same pointer, they are valid until the pool is freed and must not be
+ * freed or modified.
+ *
+ * Returns NULL if memory cannot be allocated.
+ */
+const char *
+sss_str_intern(struct sss_str_intern_pool *pool, const char *str);
+
+/**
+ * Number of unique strings in @pool.
+ */
+size_t
+sss_str_intern_count(struct sss_str_intern_pool *pool);
+
+#endif /* _SSS_STR_INTERN_H_ */
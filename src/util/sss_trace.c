@@ -0,0 +1,340 @@
+/*
+    SSSD
+
+    Request trace records
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <talloc.h>
+#include <dhash.h>
+
+#include "util/util.h"
+#include "util/sss_trace.h"
+#include "shared/safealign.h"
+
+/* Names longer than this are truncated in the records. */
+#define SSS_TRACE_MAX_NAME 255
+/* Buffered records are written at most this late while busy. */
+#define SSS_TRACE_FLUSH_INTERVAL 1
+
+struct sss_trace_span {
+    const void *owner;
+    bool ended;
+
+    uint64_t trace_id;
+    uint64_t span_id;
+    uint64_t parent_id;
+    uint64_t start;
+
+    const char *name;
+    const char *domain;
+};
+
+static struct {
+    FILE *file;
+    /* running spans by owner */
+    hash_table_t *spans;
+    uint32_t pid;
+    uint32_t counter;
+    time_t last_flush;
+} sss_trace;
+
+static uint64_t sss_trace_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sss_trace_flush(void)
+{
+    if (sss_trace.file != NULL) {
+        fflush(sss_trace.file);
+    }
+}
+
+static void sss_trace_set_string(uint8_t *buf, const char *str, size_t *_p)
+{
+    uint16_t len;
+
+    len = str == NULL ? 0 : strnlen(str, SSS_TRACE_MAX_NAME);
+    SAFEALIGN_SET_UINT16(&buf[*_p], len, _p);
+    if (len > 0) {
+        SAFEALIGN_SET_STRING(&buf[*_p], str, len, _p);
+    }
+}
+
+static void sss_trace_write(uint8_t *buf, size_t len)
+{
+    size_t p = 0;
+    time_t now;
+
+    SAFEALIGN_SET_UINT32(&buf[p], len, &p);
+
+    if (fwrite(buf, len, 1, sss_trace.file) != 1) {
+        return;
+    }
+
+    now = time(NULL);
+    if (now - sss_trace.last_flush >= SSS_TRACE_FLUSH_INTERVAL) {
+        fflush(sss_trace.file);
+        sss_trace.last_flush = now;
+    }
+}
+
+static void sss_trace_write_process(void)
+{
+    uint8_t buf[4 * sizeof(uint32_t) + SSS_TRACE_MAX_NAME];
+    size_t p = sizeof(uint32_t);
+
+    SAFEALIGN_SET_UINT32(&buf[p], SSS_TRACE_RECORD_PROCESS, &p);
+    SAFEALIGN_SET_UINT32(&buf[p], sss_trace.pid, &p);
+    sss_trace_set_string(buf, debug_prg_name, &p);
+
+    sss_trace_write(buf, p);
+}
+
+errno_t sss_trace_init(const char *path)
+{
+    errno_t ret;
+
+    if (sss_trace.file != NULL) {
+        return EOK;
+    }
+
+    ret = sss_hash_create(NULL, 0, &sss_trace.spans);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    sss_trace.file = fopen(path, "ae");
+    if (sss_trace.file == NULL) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to open %s [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+        goto done;
+    }
+
+    if (ftell(sss_trace.file) == 0) {
+        fwrite(SSS_TRACE_MAGIC, strlen(SSS_TRACE_MAGIC), 1, sss_trace.file);
+    }
+
+    sss_trace.pid = getpid();
+    sss_trace.last_flush = time(NULL);
+    sss_trace_write_process();
+    atexit(sss_trace_flush);
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Writing request traces to %s\n", path);
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_zfree(sss_trace.spans);
+    }
+    return ret;
+}
+
+bool sss_trace_enabled(void)
+{
+    return sss_trace.file != NULL;
+}
+
+uint64_t sss_trace_new_id(void)
+{
+    if (sss_trace.file == NULL) {
+        return 0;
+    }
+
+    /* The pid keeps the ids of different processes apart. */
+    sss_trace.counter++;
+    if (sss_trace.counter == 0) {
+        sss_trace.counter++;
+    }
+
+    return ((uint64_t)sss_trace.pid << 32) | sss_trace.counter;
+}
+
+static void sss_trace_span_unregister(struct sss_trace_span *span)
+{
+    hash_key_t key;
+    hash_value_t value;
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = (unsigned long)span->owner;
+
+    /* Another span may have been started for the same owner since. */
+    if (hash_lookup(sss_trace.spans, &key, &value) == HASH_SUCCESS
+            && value.ptr == span) {
+        hash_delete(sss_trace.spans, &key);
+    }
+}
+
+static int sss_trace_span_destructor(struct sss_trace_span *span)
+{
+    sss_trace_span_end(span, ECANCELED);
+    return 0;
+}
+
+struct sss_trace_span *sss_trace_span_start(TALLOC_CTX *owner,
+                                            uint64_t trace_id,
+                                            uint64_t parent_id,
+                                            const char *name,
+                                            const char *domain)
+{
+    struct sss_trace_span *span;
+    hash_key_t key;
+    hash_value_t value;
+
+    if (sss_trace.file == NULL || owner == NULL) {
+        return NULL;
+    }
+
+    span = talloc_zero(owner, struct sss_trace_span);
+    if (span == NULL) {
+        return NULL;
+    }
+
+    /* The strings usually belong to the request, keep copies for the
+     * destructor. */
+    span->name = talloc_strndup(span, name, SSS_TRACE_MAX_NAME);
+    if (domain != NULL) {
+        span->domain = talloc_strndup(span, domain, SSS_TRACE_MAX_NAME);
+    }
+    if (span->name == NULL || (domain != NULL && span->domain == NULL)) {
+        talloc_free(span);
+        return NULL;
+    }
+
+    span->owner = owner;
+    span->trace_id = trace_id == 0 ? sss_trace_new_id() : trace_id;
+    span->span_id = sss_trace_new_id();
+    span->parent_id = parent_id;
+    span->start = sss_trace_now();
+
+    key.type = HASH_KEY_ULONG;
+    key.ul = (unsigned long)owner;
+    value.type = HASH_VALUE_PTR;
+    value.ptr = span;
+
+    if (hash_enter(sss_trace.spans, &key, &value) != HASH_SUCCESS) {
+        talloc_free(span);
+        return NULL;
+    }
+
+    talloc_set_destructor(span, sss_trace_span_destructor);
+
+    return span;
+}
+
+struct sss_trace_span *sss_trace_span_start_child(TALLOC_CTX *owner,
+                                                  const char *name,
+                                                  const char *domain)
+{
+    struct sss_trace_span *parent;
+
+    parent = sss_trace_span_find(owner);
+    if (parent == NULL) {
+        return NULL;
+    }
+
+    return sss_trace_span_start(owner, parent->trace_id, parent->span_id,
+                                name, domain);
+}
+
+void sss_trace_span_end(struct sss_trace_span *span, errno_t outcome)
+{
+    uint8_t buf[4 * sizeof(uint32_t) + 5 * sizeof(uint64_t)
+                + 2 * (sizeof(uint16_t) + SSS_TRACE_MAX_NAME)];
+    size_t p = sizeof(uint32_t);
+
+    if (span == NULL || span->ended) {
+        return;
+    }
+
+    span->ended = true;
+    sss_trace_span_unregister(span);
+
+    if (sss_trace.file == NULL) {
+        return;
+    }
+
+    SAFEALIGN_SET_UINT32(&buf[p], SSS_TRACE_RECORD_SPAN, &p);
+    SAFEALIGN_SET_UINT32(&buf[p], sss_trace.pid, &p);
+    SAFEALIGN_SET_VALUE(&buf[p], span->trace_id, uint64_t, &p);
+    SAFEALIGN_SET_VALUE(&buf[p], span->span_id, uint64_t, &p);
+    SAFEALIGN_SET_VALUE(&buf[p], span->parent_id, uint64_t, &p);
+    SAFEALIGN_SET_VALUE(&buf[p], span->start, uint64_t, &p);
+    SAFEALIGN_SET_VALUE(&buf[p], sss_trace_now(), uint64_t, &p);
+    SAFEALIGN_SET_INT32(&buf[p], outcome, &p);
+    sss_trace_set_string(buf, span->name, &p);
+    sss_trace_set_string(buf, span->domain, &p);
+
+    sss_trace_write(buf, p);
+}
+
+void sss_trace_span_end_req(struct sss_trace_span *span,
+                            struct tevent_req *req,
+                            errno_t outcome)
+{
+    enum tevent_req_state req_state;
+    uint64_t err;
+
+    if (span == NULL) {
+        return;
+    }
+
+    if (tevent_req_is_error(req, &req_state, &err)) {
+        outcome = req_state == TEVENT_REQ_USER_ERROR ? err : ERR_INTERNAL;
+    }
+
+    sss_trace_span_end(span, outcome);
+}
+
+struct sss_trace_span *sss_trace_span_find(const void *ptr)
+{
+    hash_key_t key;
+    hash_value_t value;
+
+    if (sss_trace.file == NULL) {
+        return NULL;
+    }
+
+    key.type = HASH_KEY_ULONG;
+    for (; ptr != NULL; ptr = talloc_parent(ptr)) {
+        key.ul = (unsigned long)ptr;
+        if (hash_lookup(sss_trace.spans, &key, &value) == HASH_SUCCESS) {
+            return talloc_get_type(value.ptr, struct sss_trace_span);
+        }
+    }
+
+    return NULL;
+}
+
+uint64_t sss_trace_span_trace_id(struct sss_trace_span *span)
+{
+    return span == NULL ? 0 : span->trace_id;
+}
+
+uint64_t sss_trace_span_id(struct sss_trace_span *span)
+{
+    return span == NULL ? 0 : span->span_id;
+}
@@ -0,0 +1,105 @@
+/*
+    SSSD
+
+    Request trace records
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSS_TRACE_H_
+#define _SSS_TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util_errors.h"
+
+/*
+ * A trace follows one request from the responder to the backend and to
+ * the LDAP server. Each step is a span with its start and end time, the
+ * domain and the outcome. Spans of one request share the trace id, a
+ * child span refers to its parent by the parent id. Ids are unique across
+ * the SSSD processes so the trace files of all processes can be merged.
+ *
+ * The trace file starts with SSS_TRACE_MAGIC followed by records:
+ *   uint32_t length of the record including this field
+ *   uint32_t record type
+ *
+ * SSS_TRACE_RECORD_PROCESS (written once per process):
+ *   uint32_t pid
+ *   uint16_t length, process name
+ *
+ * SSS_TRACE_RECORD_SPAN:
+ *   uint32_t pid
+ *   uint64_t trace id, span id, parent span id (0 for the root span)
+ *   uint64_t start and end in microseconds since the epoch
+ *   int32_t  outcome, errno value
+ *   uint16_t length, span name
+ *   uint16_t length, domain name
+ *
+ * Numbers are stored in host byte order. contrib/sssd_trace2json.py
+ * converts the files to the Chrome trace event format.
+ */
+
+#define SSS_TRACE_MAGIC "SSSTRACE"
+#define SSS_TRACE_RECORD_PROCESS 1
+#define SSS_TRACE_RECORD_SPAN 2
+
+struct sss_trace_span;
+
+/* Start appending trace records to @path. */
+errno_t sss_trace_init(const char *path);
+
+bool sss_trace_enabled(void);
+
+/* Return a new trace id, 0 if tracing is disabled. */
+uint64_t sss_trace_new_id(void);
+
+/*
+ * Start a span owned by @owner. The span is ended with ECANCELED if @owner
+ * is freed before sss_trace_span_end() is called. Returns NULL if tracing
+ * is disabled, all functions accept a NULL span.
+ * If @trace_id is 0 a new trace is started.
+ */
+struct sss_trace_span *sss_trace_span_start(TALLOC_CTX *owner,
+                                            uint64_t trace_id,
+                                            uint64_t parent_id,
+                                            const char *name,
+                                            const char *domain);
+
+/* Start a span that is a child of the span found by
+ * sss_trace_span_find(@owner). Nothing is traced if there is none. */
+struct sss_trace_span *sss_trace_span_start_child(TALLOC_CTX *owner,
+                                                  const char *name,
+                                                  const char *domain);
+
+/* Write the span record. The span memory is released with its owner. */
+void sss_trace_span_end(struct sss_trace_span *span, errno_t outcome);
+
+/* End the span with the error of the finished @req or with @outcome if
+ * the request succeeded. */
+void sss_trace_span_end_req(struct sss_trace_span *span,
+                            struct tevent_req *req,
+                            errno_t outcome);
+
+/* Return the running span owned by @ptr or by its closest talloc parent
+ * that owns one. */
+struct sss_trace_span *sss_trace_span_find(const void *ptr);
+
+uint64_t sss_trace_span_trace_id(struct sss_trace_span *span);
+uint64_t sss_trace_span_id(struct sss_trace_span *span);
+
+#endif /* _SSS_TRACE_H_ */
@@ -35,6 +35,95 @@
 
 #include "sss_utf8.h"
 
+/* Names are processed eight bytes at a time, each byte of the constants
+ * below applies to one byte of the name. */
+#define SSS_ASCII_WORD_HIGH   0x8080808080808080ULL
+#define SSS_ASCII_WORD_BELOW_A 0x3f3f3f3f3f3f3f3fULL /* 0x80 - 'A' */
+#define SSS_ASCII_WORD_ABOVE_Z 0x2525252525252525ULL /* 0x80 - 'Z' - 1 */
+
+static uint64_t sss_ascii_word_load(const uint8_t *s)
+{
+    uint64_t word;
+
+    /* Names are not aligned. */
+    memcpy(&word, s, sizeof(word));
+    return word;
+}
+
+/* The word must not contain any byte with the high bit set. */
+static uint64_t sss_ascii_word_tolower(uint64_t word)
+{
+    uint64_t upper;
+
+    /* The high bit of a byte is set after the first addition if the byte
+     * is at least 'A' and after the second one if it is above 'Z'. None of
+     * the additions carries over to the next byte. */
+    upper = (word + SSS_ASCII_WORD_BELOW_A)
+            & ~(word + SSS_ASCII_WORD_ABOVE_Z)
+            & SSS_ASCII_WORD_HIGH;
+
+    /* 0x80 >> 2 is the difference between upper and lower case letters. */
+    return word | (upper >> 2);
+}
+
+static uint8_t sss_ascii_tolower(uint8_t c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+bool sss_utf8_is_ascii(const uint8_t *s, size_t len)
+{
+    uint64_t acc = 0;
+    size_t i;
+
+    for (i = 0; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        acc |= sss_ascii_word_load(s + i);
+    }
+
+    for (; i < len; i++) {
+        acc |= s[i];
+    }
+
+    return (acc & SSS_ASCII_WORD_HIGH) == 0;
+}
+
+void sss_ascii_tolower_copy(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    uint64_t word;
+    size_t i;
+
+    for (i = 0; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        word = sss_ascii_word_tolower(sss_ascii_word_load(src + i));
+        memcpy(dst + i, &word, sizeof(word));
+    }
+
+    for (; i < len; i++) {
+        dst[i] = sss_ascii_tolower(src[i]);
+    }
+}
+
+/* Both strings must be ASCII only and of the same length. */
+static bool sss_ascii_case_eq(const uint8_t *s1, const uint8_t *s2,
+                              size_t len)
+{
+    size_t i;
+
+    for (i = 0; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        if (sss_ascii_word_tolower(sss_ascii_word_load(s1 + i))
+                != sss_ascii_word_tolower(sss_ascii_word_load(s2 + i))) {
+            return false;
+        }
+    }
+
+    for (; i < len; i++) {
+        if (sss_ascii_tolower(s1[i]) != sss_ascii_tolower(s2[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 #ifdef HAVE_LIBUNISTRING
 void sss_utf8_free(void *ptr)
 {
@@ -108,6 +197,29 @@ bool sss_utf8_check(const uint8_t *s, size_t n)
 #error No unicode library
 #endif
 
+/* Case folding of ASCII only strings does not need the unicode library,
+ * returns true and sets _ret if the comparison was done. */
+static bool sss_utf8_case_eq_ascii(const uint8_t *s1, const uint8_t *s2,
+                                   errno_t *_ret)
+{
+    size_t n1, n2;
+
+    n1 = strlen((const char *)s1);
+    n2 = strlen((const char *)s2);
+
+    if (!sss_utf8_is_ascii(s1, n1) || !sss_utf8_is_ascii(s2, n2)) {
+        return false;
+    }
+
+    if (n1 == n2 && sss_ascii_case_eq(s1, s2, n1)) {
+        *_ret = EOK;
+    } else {
+        *_ret = ENOMATCH;
+    }
+
+    return true;
+}
+
 /* Returns EOK on match, ENOTUNIQ if comparison succeeds but
  * does not match.
  * May return other errno error codes on failure
@@ -125,6 +237,12 @@ errno_t sss_utf8_case_eq(const uint8_t *s1, const uint8_t *s2)
     int ret;
     int resultp;
     size_t n1, n2;
+    errno_t eq;
+
+    if (sss_utf8_case_eq_ascii(s1, s2, &eq)) {
+        return eq;
+    }
+
     errno = 0;
 
     n1 = u8_strlen(s1);
@@ -154,6 +272,10 @@ errno_t sss_utf8_case_eq(const uint8_t *s1, const uint8_t *s2)
     gint gret;
     errno_t ret;
 
+    if (sss_utf8_case_eq_ascii(s1, s2, &ret)) {
+        return ret;
+    }
+
     n1 = g_utf8_strlen((const gchar *)s1, -1);
     n2 = g_utf8_strlen((const gchar *)s2, -1);
 
@@ -39,6 +39,13 @@ uint8_t *sss_utf8_tolower(const uint8_t *s, size_t len, size_t *nlen);
 
 bool sss_utf8_check(const uint8_t *s, size_t n);
 
+/* True if no byte of s has the high bit set. */
+bool sss_utf8_is_ascii(const uint8_t *s, size_t len);
+
+/* Lower case copy of an ASCII only string, dst must hold len bytes and
+ * may be the same as src. */
+void sss_ascii_tolower_copy(uint8_t *dst, const uint8_t *src, size_t len);
+
 errno_t sss_utf8_case_eq(const uint8_t *s1, const uint8_t *s2);
 
 
@@ -60,6 +60,12 @@ struct tcurl_ctx {
      * the transfer's private data
      */
     CURLM *multi_handle;
+
+    /* Finished transfers leave their connections in the connection cache
+     * of the multi handle, so that following requests to the same server
+     * reuse them. The share handle additionally lets new transfers reuse
+     * the resolved addresses and the TLS sessions of the previous ones. */
+    CURLSH *share_handle;
 };
 
 /**
@@ -464,9 +470,42 @@ static int tcurl_ctx_destroy(struct tcurl_ctx *ctx)
     }
 
     curl_multi_cleanup(ctx->multi_handle);
+    if (ctx->share_handle != NULL) {
+        curl_share_cleanup(ctx->share_handle);
+    }
     return 0;
 }
 
+static CURLSH *tcurl_share_init(void)
+{
+    CURLSH *share;
+    CURLSHcode shret;
+
+    share = curl_share_init();
+    if (share == NULL) {
+        return NULL;
+    }
+
+    shret = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    if (shret != CURLSHE_OK) {
+        goto fail;
+    }
+
+    shret = curl_share_setopt(share, CURLSHOPT_SHARE,
+                              CURL_LOCK_DATA_SSL_SESSION);
+    if (shret != CURLSHE_OK) {
+        goto fail;
+    }
+
+    return share;
+
+fail:
+    DEBUG(SSSDBG_MINOR_FAILURE, "Cannot set up the curl share handle "
+          "[%d]: %s\n", shret, curl_share_strerror(shret));
+    curl_share_cleanup(share);
+    return NULL;
+}
+
 struct tcurl_ctx *tcurl_init(TALLOC_CTX *mem_ctx,
                              struct tevent_context *ev)
 {
@@ -539,6 +578,9 @@ struct tcurl_ctx *tcurl_init(TALLOC_CTX *mem_ctx,
               cmret, curl_multi_strerror(cmret));
     }
 
+    /* Not fatal, requests just do not share the caches. */
+    tctx->share_handle = tcurl_share_init();
+
     return tctx;
 
 fail:
@@ -636,6 +678,18 @@ struct tcurl_request_state {
     int response_code;
 };
 
+static void tcurl_request_detach(struct tcurl_request *tcurl_req)
+{
+    curl_multi_remove_handle(tcurl_req->tcurl_ctx->multi_handle,
+                             tcurl_req->curl_easy_handle);
+
+    /* The share handle can be only freed when no easy handle uses it. */
+    curl_easy_setopt(tcurl_req->curl_easy_handle, CURLOPT_SHARE, NULL);
+
+    /* This request is no longer associated with tcurl context. */
+    tcurl_req->tcurl_ctx = NULL;
+}
+
 struct tevent_req *
 tcurl_request_send(TALLOC_CTX *mem_ctx,
                    struct tevent_context *ev,
@@ -686,6 +740,20 @@ tcurl_request_send(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    /* Keep the idle connections in the connection cache alive. */
+    ret = tcurl_set_option(tcurl_req, CURLOPT_TCP_KEEPALIVE, 1L);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (tcurl_ctx->share_handle != NULL) {
+        ret = tcurl_set_option(tcurl_req, CURLOPT_SHARE,
+                               tcurl_ctx->share_handle);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
     if (tcurl_req->body != NULL) {
         ret = tcurl_set_option(tcurl_req, CURLOPT_READFUNCTION, tcurl_read_data);
         if (ret != EOK) {
@@ -738,11 +806,7 @@ static void tcurl_request_done(struct tevent_req *req,
 
     state = tevent_req_data(req, struct tcurl_request_state);
 
-    curl_multi_remove_handle(state->tcurl_req->tcurl_ctx->multi_handle,
-                             state->tcurl_req->curl_easy_handle);
-
-    /* This request is no longer associated with tcurl context. */
-    state->tcurl_req->tcurl_ctx = NULL;
+    tcurl_request_detach(state->tcurl_req);
 
     if (process_error != EOK) {
         tevent_req_error(req, process_error);
@@ -832,8 +896,7 @@ tcurl_request_destructor(struct tcurl_request *tcurl_req)
 {
     if (tcurl_req->tcurl_ctx != NULL) {
         DEBUG(SSSDBG_MINOR_FAILURE, "Terminating TCURL request...\n");
-        curl_multi_remove_handle(tcurl_req->tcurl_ctx->multi_handle,
-                                 tcurl_req->curl_easy_handle);
+        tcurl_request_detach(tcurl_req);
     }
 
     if (tcurl_req->headers != NULL) {
@@ -680,6 +680,20 @@ errno_t restore_creds(struct sss_creds *saved_creds);
 int sss_set_seuser(const char *login_name, const char *seuser_name,
                    const char *mlsrange);
 int sss_del_seuser(const char *login_name);
+
+struct sss_seuser_change {
+    const char *login_name;
+    /* NULL removes the login mapping */
+    const char *seuser_name;
+    const char *mls;
+
+    /* Result of the change, set by sss_set_seusers() */
+    int ret;
+};
+
+/* Applies all changes in a single transaction and returns an error if the
+ * transaction could not be committed. */
+int sss_set_seusers(struct sss_seuser_change *changes, size_t count);
 int sss_get_seuser(const char *linuxuser,
                    char **selinuxuser,
                    char **level);
@@ -713,6 +727,10 @@ int sss_unique_filename(TALLOC_CTX *owner, char *path_tmpl);
 int setup_watchdog(struct tevent_context *ev, int interval);
 void teardown_watchdog(void);
 
+/* Record that @task, a string constant, blocked the event loop for @usec
+ * microseconds. The worst stalls are logged on the next watchdog tick. */
+void watchdog_report_stall(const char *task, uint64_t usec);
+
 /* from files.c */
 int sss_remove_tree(const char *root);
 int sss_remove_subtree(const char *root);
@@ -143,6 +143,8 @@ struct err_string error_to_str[] = {
     { "Error while parsing configuration file" }, /* ERR_INI_PARSE_FAILED */
     { "Failed to add configuration snippets" }, /* ERR_INI_ADD_SNIPPETS_FAILED */
 
+    { "Server is busy" }, /* ERR_SERVER_BUSY */
+
     { "ERR_LAST" } /* ERR_LAST */
 };
 
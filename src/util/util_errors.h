@@ -164,6 +164,8 @@ enum sssd_errors {
     ERR_INI_PARSE_FAILED,
     ERR_INI_ADD_SNIPPETS_FAILED,
 
+    ERR_SERVER_BUSY,
+
     ERR_LAST            /* ALWAYS LAST */
 };
 
@@ -27,6 +27,10 @@
 #define WATCHDOG_MAX_TICKS 3
 #define DEFAULT_BUFFER_SIZE 4096
 
+/* Stalls of the event loop longer than this are logged. */
+#define WATCHDOG_STALL_REPORT_USEC 500000
+#define WATCHDOG_MAX_STALL_TASKS 16
+
 /* this is intentionally a global variable */
 struct watchdog_ctx {
     timer_t timerid;
@@ -40,8 +44,68 @@ struct watchdog_ctx {
     time_t timestamp;
     struct tevent_fd *tfd;
     int pipefd[2];
+
+    /* To measure how late the watchdog event runs. */
+    struct timeval expected;
 } watchdog_ctx;
 
+/* The worst stall since the last watchdog tick and since the start, per
+ * task that reports them. */
+static struct watchdog_stall {
+    const char *task;
+    uint64_t recent_usec;
+    uint64_t worst_usec;
+} watchdog_stalls[WATCHDOG_MAX_STALL_TASKS];
+
+void watchdog_report_stall(const char *task, uint64_t usec)
+{
+    struct watchdog_stall *stall = NULL;
+    int i;
+
+    for (i = 0; i < WATCHDOG_MAX_STALL_TASKS; i++) {
+        if (watchdog_stalls[i].task == NULL
+                || strcmp(watchdog_stalls[i].task, task) == 0) {
+            stall = &watchdog_stalls[i];
+            break;
+        }
+    }
+
+    if (stall == NULL) {
+        /* Only the first tasks are tracked. */
+        return;
+    }
+
+    stall->task = task;
+    if (usec > stall->recent_usec) {
+        stall->recent_usec = usec;
+    }
+    if (usec > stall->worst_usec) {
+        stall->worst_usec = usec;
+    }
+}
+
+static void watchdog_log_stalls(void)
+{
+    int i;
+
+    for (i = 0; i < WATCHDOG_MAX_STALL_TASKS; i++) {
+        if (watchdog_stalls[i].task == NULL) {
+            break;
+        }
+
+        if (watchdog_stalls[i].recent_usec >= WATCHDOG_STALL_REPORT_USEC) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "[%s] blocked the event loop for %"PRIu64" ms, "
+                  "the worst stall so far is %"PRIu64" ms\n",
+                  watchdog_stalls[i].task,
+                  watchdog_stalls[i].recent_usec / 1000,
+                  watchdog_stalls[i].worst_usec / 1000);
+        }
+
+        watchdog_stalls[i].recent_usec = 0;
+    }
+}
+
 static void watchdog_detect_timeshift(void)
 {
     time_t prev_time;
@@ -89,13 +153,27 @@ static void watchdog_event_handler(struct tevent_context *ev,
                                    struct timeval current_time,
                                    void *private_data)
 {
+    struct timeval now;
+    struct timeval late;
+
     /* first thing reset the watchdog ticks */
     watchdog_reset();
 
+    /* an event that runs late means the loop was blocked meanwhile */
+    now = tevent_timeval_current();
+    if (!tevent_timeval_is_zero(&watchdog_ctx.expected)
+            && tevent_timeval_compare(&now, &watchdog_ctx.expected) > 0) {
+        late = tevent_timeval_until(&watchdog_ctx.expected, &now);
+        watchdog_report_stall("event loop",
+                              (uint64_t)late.tv_sec * 1000000 + late.tv_usec);
+    }
+    watchdog_log_stalls();
+
     /* then set a new watchodg event */
-    watchdog_ctx.te = tevent_add_timer(ev, ev,
-        tevent_timeval_current_ofs(watchdog_ctx.interval.tv_sec, 0),
-        watchdog_event_handler, NULL);
+    watchdog_ctx.expected = tevent_timeval_current_ofs(
+                                    watchdog_ctx.interval.tv_sec, 0);
+    watchdog_ctx.te = tevent_add_timer(ev, ev, watchdog_ctx.expected,
+                                       watchdog_event_handler, NULL);
     /* if the function fails the watchdog will kill the
      * process soon enough, so we just warn */
     if (!watchdog_ctx.te) {
@@ -258,4 +336,5 @@ void teardown_watchdog(void)
 
     /* and kill the watchdog event */
     talloc_free(watchdog_ctx.te);
+    watchdog_ctx.expected = tevent_timeval_zero();
 }
@@ -0,0 +1,135 @@
+/* This file is based on the public domain wyhash (final version 4) from
+ * Wang Yi: https://github.com/wangyi-fudan/wyhash
+ *
+ * Unlike murmurhash3() it reads eight bytes at a time, which makes it
+ * considerably faster on long keys such as user principal names.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "shared/wyhash.h"
+#include "util/sss_endian.h"
+
+static const uint64_t wyp[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+/* 64x64 -> 128 bit multiplication, the low half is stored in a and the
+ * high half in b. */
+__attribute__((always_inline))
+static inline void wymum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = *a;
+
+    r *= *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+__attribute__((always_inline))
+static inline uint64_t wymix(uint64_t a, uint64_t b)
+{
+    wymum(&a, &b);
+    return a ^ b;
+}
+
+/* slower than direct access but endian neutral and handles platforms that
+ * do only aligned reads */
+__attribute__((always_inline))
+static inline uint64_t wyr8(const uint8_t *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return le64toh(v);
+}
+
+__attribute__((always_inline))
+static inline uint64_t wyr4(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return le32toh(v);
+}
+
+__attribute__((always_inline))
+static inline uint64_t wyr3(const uint8_t *p, size_t k)
+{
+    return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+uint32_t wyhash(const char *key, int len, uint32_t seed)
+{
+    const uint8_t *p = (const uint8_t *)key;
+    uint64_t s = seed;
+    uint64_t see1;
+    uint64_t see2;
+    uint64_t a;
+    uint64_t b;
+    uint64_t h;
+    size_t i;
+
+    s ^= wymix(s ^ wyp[0], wyp[1]);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wyr4(p) << 32) | wyr4(p + ((len >> 3) << 2));
+            b = (wyr4(p + len - 4) << 32)
+                | wyr4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = wyr3(p, len);
+            b = 0;
+        } else {
+            a = 0;
+            b = 0;
+        }
+    } else {
+        i = len;
+        if (i > 48) {
+            see1 = s;
+            see2 = s;
+            do {
+                s = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ s);
+                see1 = wymix(wyr8(p + 16) ^ wyp[2], wyr8(p + 24) ^ see1);
+                see2 = wymix(wyr8(p + 32) ^ wyp[3], wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            s ^= see1 ^ see2;
+        }
+
+        while (i > 16) {
+            s = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ s);
+            i -= 16;
+            p += 16;
+        }
+
+        a = wyr8(p + i - 16);
+        b = wyr8(p + i - 8);
+    }
+
+    a ^= wyp[1];
+    b ^= s;
+    wymum(&a, &b);
+    h = wymix(a ^ wyp[0] ^ (uint64_t)len, b ^ wyp[1]);
+
+    return (uint32_t)(h ^ (h >> 32));
+}